@@ -0,0 +1,123 @@
+#include "benchmark/benchmark.h"
+
+#include "labels/curvedLayout.h"
+#include "labels/textLabel.h"
+#include "util/geom.h"
+#include "util/lineSampler.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace Tangram;
+
+// Street names as they are found along curved roads
+static const char* streetNames[] = {
+    "Avenue des Champs-Elysees",
+    "Martin Luther King Jr Boulevard",
+    "Karl-Marx-Allee",
+    "Via dei Fori Imperiali",
+    "Paseo de la Castellana",
+    "Nevsky Prospekt",
+    "Rua Augusta",
+    "Unter den Linden",
+    "Rambla de Catalunya",
+    "Old Kent Road",
+};
+
+struct CurvedLabelFixture : public benchmark::Fixture {
+    std::vector<std::vector<GlyphQuad>> labels;
+    std::vector<std::vector<glm::vec3>> lines;
+
+    void SetUp(const ::benchmark::State&) override {
+        for (size_t n = 0; n < sizeof(streetNames) / sizeof(streetNames[0]); n++) {
+            const char* name = streetNames[n];
+            size_t length = strlen(name);
+
+            // Glyphs of 14px text, narrower for lowercase and punctuation
+            std::vector<GlyphQuad> quads(length);
+            float advance = 0;
+            for (size_t i = 0; i < length; i++) {
+                char c = name[i];
+                float width = (c >= 'A' && c <= 'Z') ? 10.f : (c == ' ' || c == '-') ? 4.f : 7.f;
+                float x0 = advance * TextVertex::position_scale;
+                float x1 = (advance + width) * TextVertex::position_scale;
+                quads[i].atlas = 0;
+                quads[i].quad[0].pos = glm::i16vec2(x0, -11 * TextVertex::position_scale);
+                quads[i].quad[1].pos = glm::i16vec2(x0, 3 * TextVertex::position_scale);
+                quads[i].quad[2].pos = glm::i16vec2(x1, -11 * TextVertex::position_scale);
+                quads[i].quad[3].pos = glm::i16vec2(x1, 3 * TextVertex::position_scale);
+                advance += width + 1.f;
+            }
+            for (auto& quad : quads) {
+                for (auto& v : quad.quad) { v.pos.x -= advance * 0.5f * TextVertex::position_scale; }
+            }
+            labels.push_back(std::move(quads));
+
+            // Road bending along a few segments, as projected to the screen
+            LineSampler<std::vector<glm::vec3>> sampler;
+            for (int i = 0; i < 12; i++) {
+                float a = 0.1f * i + 0.05f * n;
+                sampler.add(glm::vec2(200.f + i * advance / 8.f, 300.f + 80.f * std::sin(a * 3.f)));
+            }
+            std::vector<glm::vec3> line;
+            for (size_t i = 0; i < sampler.numPoints(); i++) { line.push_back(sampler.point(i)); }
+            lines.push_back(std::move(line));
+        }
+    }
+
+    void TearDown(const ::benchmark::State&) override {
+        labels.clear();
+        lines.clear();
+    }
+};
+
+// Per glyph placement with a LineSampler, as CurvedLabel did before CurvedLayout
+BENCHMARK_DEFINE_F(CurvedLabelFixture, LineSampler)(benchmark::State& st) {
+    std::vector<glm::i16vec2> corners;
+    while (st.KeepRunning()) {
+        for (size_t l = 0; l < labels.size(); l++) {
+            LineSampler<std::vector<glm::vec3>> sampler(lines[l]);
+            float center = sampler.sumLength() * 0.5f;
+            corners.clear();
+
+            for (auto& quad : labels[l]) {
+                glm::vec2 origin = {(quad.quad[0].pos.x + quad.quad[2].pos.x) * 0.5f, 0 };
+                glm::vec2 point, rotation, p1, p2, r1, r2;
+
+                if (!sampler.sample(center + origin.x * TextVertex::position_inv_scale, point, rotation)) {
+                    continue;
+                }
+                bool ok1 = sampler.sample(center + quad.quad[0].pos.x * TextVertex::position_inv_scale, p1, r1);
+                bool ok2 = sampler.sample(center + quad.quad[2].pos.x * TextVertex::position_inv_scale, p2, r2);
+                if (ok1 && ok2) {
+                    rotation = (r1 == r2) ? r1 : glm::normalize(p2 - p1);
+                    point = point * 0.5f + (p1 + p2) * 0.25f;
+                }
+                glm::i16vec2 p(point * TextVertex::position_scale);
+                rotation = {rotation.x, -rotation.y};
+
+                for (int i = 0; i < 4; i++) {
+                    corners.push_back(p + glm::i16vec2{rotate2d(glm::vec2(quad.quad[i].pos) - origin, rotation)});
+                }
+            }
+            benchmark::DoNotOptimize(corners.data());
+        }
+    }
+}
+BENCHMARK_REGISTER_F(CurvedLabelFixture, LineSampler);
+
+BENCHMARK_DEFINE_F(CurvedLabelFixture, CurvedLayout)(benchmark::State& st) {
+    CurvedLayout layout;
+    while (st.KeepRunning()) {
+        for (size_t l = 0; l < labels.size(); l++) {
+            auto& line = lines[l];
+            layout.place(line.data(), line.size(), line.back().z * 0.5f,
+                         labels[l].data(), labels[l].size());
+            benchmark::DoNotOptimize(layout.size());
+        }
+    }
+}
+BENCHMARK_REGISTER_F(CurvedLabelFixture, CurvedLayout);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,373 @@
+#include "benchmark/benchmark.h"
+
+#include "log.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "tile/tileTask.h"
+#include "util/mappedFile.h"
+
+#ifdef TANGRAM_MBTILES_DATASOURCE
+#include "data/mbtilesDataSource.h"
+#include "sqlitepp.h"
+#endif
+#ifdef TANGRAM_PMTILES_DATASOURCE
+#include "data/pmtilesDataSource.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* Tile lookup throughput of MBTilesDataSource and PMTilesDataSource
+ *
+ * Usage: benchDataSource.out [--mbtiles=<a.mbtiles>,...] [--pmtiles=<a.pmtiles>,...]
+ *                            [--tiles=<file>] [--latency=<ms>] [benchmark flags]
+ *
+ * Each iteration looks up the same tiles in random order or sorted along a Z-order curve (so
+ * that neighbors follow each other, as when loading a view), either one at a time or with up
+ * to 64 lookups in flight - the sources spread these over their I/O threads. 'Cold' runs open
+ * a new source for each iteration, so that its directory and page caches are empty, and drop
+ * the archive from the OS page cache first (Linux only); 'warm' runs reuse a source which
+ * already looked up all tiles. Pass compressed and uncompressed archives to compare them.
+ *
+ * PMTiles archives are also served as 'http://bench/<archive>' by a simulated server which
+ * answers range requests after --latency milliseconds (default 20), reporting requests and
+ * bytes per lookup - i.e. the effect of directory caching and request merging.
+ *
+ * Tiles to look up are read from --tiles, one 'z/x/y' per line, or else taken from the first
+ * MBTiles archive.
+ */
+
+using namespace Tangram;
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<TileID> lookupTiles;
+static float httpLatency = 20.f;
+
+// Serves range requests for an archive after a fixed latency, from a thread of its own
+struct HttpArchivePlatform : MockPlatform {
+
+    struct Response {
+        Clock::time_point due;
+        UrlRequestHandle handle;
+        std::vector<char> content;
+        bool operator<(const Response& _other) const { return due > _other.due; }
+    };
+
+    MappedFile archive;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::priority_queue<Response> responses;
+    std::thread thread;
+    bool running = true;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> bytes{0};
+
+    explicit HttpArchivePlatform(const std::string& _path) {
+        archive.open(_path);
+        thread = std::thread([this] { respond(); });
+    }
+
+    ~HttpArchivePlatform() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        condition.notify_all();
+        thread.join();
+    }
+
+    bool startUrlRequestImpl(const Url& _url, const HttpOptions& _options,
+                             const UrlRequestHandle _handle, UrlRequestId& _id) override {
+        Response response{Clock::now() + std::chrono::microseconds(int64_t(httpLatency * 1000)), _handle, {}};
+
+        unsigned long long first = 0, last = archive.size() - 1;
+        size_t range = _options.headers.find("Range: bytes=");
+        if (range != std::string::npos) {
+            sscanf(_options.headers.c_str() + range, "Range: bytes=%llu-%llu", &first, &last);
+        }
+        last = std::min<unsigned long long>(last, archive.size() - 1);
+        if (archive.isOpen() && first <= last) {
+            response.content.assign(archive.data() + first, archive.data() + last + 1);
+        }
+        requests++;
+        bytes += response.content.size();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            responses.push(std::move(response));
+        }
+        condition.notify_all();
+        _id = _handle;
+        return true;
+    }
+
+    void cancelUrlRequestImpl(const UrlRequestId _id) override {}
+
+    void respond() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            if (responses.empty()) {
+                condition.wait(lock);
+                continue;
+            }
+            if (Clock::now() < responses.top().due) {
+                condition.wait_until(lock, responses.top().due);
+                continue;
+            }
+            Response response = std::move(const_cast<Response&>(responses.top()));
+            responses.pop();
+            lock.unlock();
+            UrlResponse urlResponse;
+            urlResponse.content = std::move(response.content);
+            onUrlResponse(response.handle, std::move(urlResponse));
+            lock.lock();
+        }
+    }
+};
+
+struct Archive {
+    std::string name;
+    std::string path;
+    std::function<std::unique_ptr<TileSource::DataSource>(Platform&)> create;
+    bool http = false;
+};
+
+static std::vector<Archive> archives;
+
+// Drop @_path from the OS page cache; only clean pages which are not mapped are dropped
+static void dropFileCache(const std::string& _path) {
+#if defined(__linux__)
+    int fd = open(_path.c_str(), O_RDONLY);
+    if (fd < 0) { return; }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+#endif
+}
+
+// Interleave the bits of x and y, for ordering tiles along a Z-order curve
+static uint64_t mortonCode(uint32_t _x, uint32_t _y) {
+    uint64_t code = 0;
+    for (int bit = 0; bit < 32; bit++) {
+        code |= uint64_t((_x >> bit) & 1) << (2 * bit);
+        code |= uint64_t((_y >> bit) & 1) << (2 * bit + 1);
+    }
+    return code;
+}
+
+static std::vector<TileID> orderedTiles(bool _locality) {
+    std::vector<TileID> tiles = lookupTiles;
+    if (_locality) {
+        std::sort(tiles.begin(), tiles.end(), [](const TileID& a, const TileID& b) {
+            if (a.z != b.z) { return a.z < b.z; }
+            return mortonCode(a.x, a.y) < mortonCode(b.x, b.y);
+        });
+    } else {
+        std::shuffle(tiles.begin(), tiles.end(), std::mt19937(1234));
+    }
+    return tiles;
+}
+
+// Look up @_tiles with up to @_inFlight lookups at once; returns the number of tiles found
+static size_t lookup(TileSource::DataSource& _source, const std::vector<TileID>& _tiles,
+                     int _inFlight, const std::shared_ptr<ScenePrana>& _prana) {
+    std::mutex mutex;
+    std::condition_variable condition;
+    int running = 0;
+    size_t found = 0;
+
+    TileTaskCb cb{[&](std::shared_ptr<TileTask> _task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (_task->hasData()) { found++; }
+        running--;
+        condition.notify_all();
+    }};
+
+    for (auto& id : _tiles) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&] { return running < _inFlight; });
+            running++;
+        }
+        auto task = std::make_shared<BinaryTileTask>(id, nullptr);
+        task->setScenePrana(_prana);
+        if (!_source.loadTileData(task, cb)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            running--;
+        }
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&] { return running == 0; });
+    return found;
+}
+
+static void runLookups(benchmark::State& _state, const Archive& _archive, bool _locality,
+                       bool _cold, int _inFlight) {
+    auto tiles = orderedTiles(_locality);
+    // Lookups call back while the ScenePrana is alive; there is no Scene here
+    auto prana = std::make_shared<ScenePrana>(nullptr);
+
+    std::unique_ptr<HttpArchivePlatform> httpPlatform;
+    std::unique_ptr<MockPlatform> filePlatform;
+    Platform* platform;
+    if (_archive.http) {
+        httpPlatform = std::make_unique<HttpArchivePlatform>(_archive.path);
+        platform = httpPlatform.get();
+    } else {
+        filePlatform = std::make_unique<MockPlatform>();
+        platform = filePlatform.get();
+    }
+
+    auto source = _archive.create(*platform);
+    if (!_cold) { lookup(*source, tiles, 64, prana); }
+    if (httpPlatform) { httpPlatform->requests = 0; httpPlatform->bytes = 0; }
+
+    size_t found = 0;
+    for (auto _ : _state) {
+        if (_cold) {
+            _state.PauseTiming();
+            source.reset();
+            if (!_archive.http) { dropFileCache(_archive.path); }
+            source = _archive.create(*platform);
+            _state.ResumeTiming();
+        }
+        found += lookup(*source, tiles, _inFlight, prana);
+    }
+    source.reset();
+
+    double lookups = double(_state.iterations()) * tiles.size();
+    _state.SetItemsProcessed(int64_t(lookups));
+    _state.counters["found"] = lookups > 0 ? found / lookups : 0;
+    if (httpPlatform && lookups > 0) {
+        _state.counters["requests_per_lookup"] = httpPlatform->requests / lookups;
+        _state.counters["bytes_per_lookup"] = httpPlatform->bytes / lookups;
+    }
+}
+
+static std::vector<std::string> splitList(const std::string& _list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= _list.size()) {
+        size_t end = _list.find(',', start);
+        if (end == std::string::npos) { end = _list.size(); }
+        if (end > start) { items.push_back(_list.substr(start, end - start)); }
+        start = end + 1;
+    }
+    return items;
+}
+
+static std::string baseName(const std::string& _path) {
+    return _path.substr(_path.find_last_of('/') + 1);
+}
+
+static void loadTileList(const std::string& _file) {
+    std::ifstream in(_file);
+    std::string line;
+    while (std::getline(in, line)) {
+        int z, x, y;
+        if (sscanf(line.c_str(), "%d/%d/%d", &z, &x, &y) == 3) { lookupTiles.emplace_back(x, y, z); }
+    }
+}
+
+#ifdef TANGRAM_MBTILES_DATASOURCE
+// Up to 4096 random tiles of an MBTiles archive
+static void loadMBTilesList(MBTilesDataSource& _source) {
+    if (!_source.getDB()) { return; }
+    _source.getDB()->stmt("SELECT zoom_level, tile_column, tile_row FROM tiles ORDER BY random() LIMIT 4096;")
+        .exec([](int z, int x, int y) { lookupTiles.emplace_back(x, (1 << z) - 1 - y, z); });
+}
+#endif
+
+int main(int argc, char** argv) {
+
+    std::vector<std::string> mbtiles, pmtiles;
+    std::string tileList;
+
+    // Take our options out of the arguments passed to the benchmark library
+    int count = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--mbtiles=", 10) == 0) {
+            mbtiles = splitList(argv[i] + 10);
+        } else if (strncmp(argv[i], "--pmtiles=", 10) == 0) {
+            pmtiles = splitList(argv[i] + 10);
+        } else if (strncmp(argv[i], "--tiles=", 8) == 0) {
+            tileList = argv[i] + 8;
+        } else if (strncmp(argv[i], "--latency=", 10) == 0) {
+            httpLatency = float(atof(argv[i] + 10));
+        } else {
+            argv[count++] = argv[i];
+        }
+    }
+    argc = count;
+
+    if (!tileList.empty()) { loadTileList(tileList); }
+
+#ifdef TANGRAM_MBTILES_DATASOURCE
+    for (auto& path : mbtiles) {
+        archives.push_back({"MBTiles/" + baseName(path), path, [path](Platform& _platform) {
+            return std::make_unique<MBTilesDataSource>(_platform, "bench", path, "");
+        }});
+    }
+    if (lookupTiles.empty() && !mbtiles.empty()) {
+        MockPlatform platform;
+        MBTilesDataSource source(platform, "bench", mbtiles.front(), "");
+        loadMBTilesList(source);
+    }
+#else
+    if (!mbtiles.empty()) { LOGW("Built without TANGRAM_MBTILES_DATASOURCE"); }
+#endif
+
+#ifdef TANGRAM_PMTILES_DATASOURCE
+    for (auto& path : pmtiles) {
+        archives.push_back({"PMTiles/" + baseName(path), path, [path](Platform& _platform) {
+            return std::make_unique<PMTilesDataSource>(_platform, path);
+        }});
+        archives.push_back({"PMTilesHttp/" + baseName(path), path, [path](Platform& _platform) {
+            return std::make_unique<PMTilesDataSource>(_platform, "http://bench/" + baseName(path));
+        }, true});
+    }
+#else
+    if (!pmtiles.empty()) { LOGW("Built without TANGRAM_PMTILES_DATASOURCE"); }
+#endif
+
+    if (archives.empty() || lookupTiles.empty()) {
+        LOGE("No archives or no tiles to look up, see usage in benchDataSource.cpp");
+        return 1;
+    }
+
+    for (auto& archive : archives) {
+        for (bool locality : {false, true}) {
+            for (bool cold : {true, false}) {
+                for (int inFlight : {1, 64}) {
+                    std::string name = archive.name + (locality ? "/locality" : "/random") +
+                        (cold ? "/cold" : "/warm") + (inFlight > 1 ? "/concurrent" : "/sequential");
+                    const Archive* a = &archive;
+                    benchmark::RegisterBenchmark(name.c_str(), [=](benchmark::State& st) {
+                        runLookups(st, *a, locality, cold, inFlight);
+                    })->UseRealTime()->Unit(benchmark::kMillisecond);
+                }
+            }
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
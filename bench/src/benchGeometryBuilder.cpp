@@ -28,15 +28,13 @@ struct PosNormEnormColVertex {
 static void BM_Tangram_BuildButtMiterLine(benchmark::State& state) {
     while(state.KeepRunning()) {
         std::vector<PosNormEnormColVertex> vertices;
-        PolyLineBuilder builder {
-            [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
-                vertices.push_back({ coord, uv, normal, 0.5f, 0xffffff, 0.f });
-            },
-            CapTypes::butt,
-            JoinTypes::miter
-        };
+        PolyLineBuilder builder { CapTypes::butt, JoinTypes::miter };
 
         Builders::buildPolyLine(line, builder);
+
+        for (const auto& v : builder.vertices) {
+            vertices.push_back({ v.coord, v.uv, v.enormal, 0.5f, 0xffffff, 0.f });
+        }
     }
 }
 BENCHMARK(BM_Tangram_BuildButtMiterLine);
@@ -44,15 +42,13 @@ BENCHMARK(BM_Tangram_BuildButtMiterLine);
 static void BM_Tangram_BuildRoundRoundLine(benchmark::State& state) {
     while(state.KeepRunning()) {
         std::vector<PosNormEnormColVertex> vertices;
-        PolyLineBuilder builder {
-            [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
-                vertices.push_back({ coord, uv, normal, 0.5f, 0xffffff, 0.f });
-            },
-            CapTypes::round,
-            JoinTypes::round
-        };
+        PolyLineBuilder builder { CapTypes::round, JoinTypes::round };
 
         Builders::buildPolyLine(line, builder);
+
+        for (const auto& v : builder.vertices) {
+            vertices.push_back({ v.coord, v.uv, v.enormal, 0.5f, 0xffffff, 0.f });
+        }
     }
 }
 BENCHMARK(BM_Tangram_BuildRoundRoundLine);
@@ -0,0 +1,83 @@
+#include "benchmark/benchmark.h"
+
+#include "labels/labelManager.h"
+#include "labels/textLabel.h"
+#include "labels/textLabels.h"
+#include "style/textStyle.h"
+#include "tile/tile.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+TextStyle textStyle("textStyle");
+TextLabels textLabels(textStyle);
+
+// Sorts the labels of tiles of three zoom levels, one of them proxies, and of markers
+class LabelSortFixture : public benchmark::Fixture, public LabelManager {
+public:
+    Tile tiles[3] = { Tile({0,0,10}), Tile({0,0,11}), Tile({0,0,12}) };
+    std::vector<std::unique_ptr<TextLabel>> labels;
+    std::vector<LabelEntry> entries;
+
+    void SetUp(const ::benchmark::State& _state) override {
+        tiles[0].setProxyDepth(1);
+
+        Label::Options options;
+        options.anchors.anchor[0] = LabelProperty::Anchor::center;
+        options.anchors.count = 1;
+
+        for (int i = 0; i < _state.range(0); i++) {
+            labels.emplace_back(new TextLabel({{glm::vec3(0.5f)}}, Label::Type::point, options,
+                                              {}, {10, 10}, textLabels, {},
+                                              TextLabelProperty::Align::none));
+            Tile* tile = (i % 11 == 0) ? nullptr : &tiles[i % 3];
+            entries.emplace_back(labels.back().get(), nullptr, tile, nullptr,
+                                 tile && tile->isProxy(), Tangram::Range{});
+            entries.back().priority = float((i * 7919) % 1000) / 8.f;
+        }
+    }
+
+    void TearDown(const ::benchmark::State&) override {
+        labels.clear();
+        entries.clear();
+        m_labels.clear();
+        m_lastLabelCount = 0;
+    }
+};
+
+BENCHMARK_DEFINE_F(LabelSortFixture, PriorityStdSort)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        m_labels = entries;
+        std::sort(m_labels.begin(), m_labels.end(), priorityComparator);
+    }
+}
+BENCHMARK_REGISTER_F(LabelSortFixture, PriorityStdSort)->Arg(1000)->Arg(10000)->Arg(50000);
+
+BENCHMARK_DEFINE_F(LabelSortFixture, PriorityRadixSort)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        m_labels = entries;
+        sortRange(m_labels.begin(), m_labels.end(), priorityComparator);
+    }
+}
+BENCHMARK_REGISTER_F(LabelSortFixture, PriorityRadixSort)->Arg(1000)->Arg(10000)->Arg(50000);
+
+// Labels of the last update, as when panning
+BENCHMARK_DEFINE_F(LabelSortFixture, PrioritySortFromLastUpdate)(benchmark::State& st) {
+    m_labels = entries;
+    sortLabels(&Label::m_priorityRank, 0, priorityComparator);
+
+    while (st.KeepRunning()) {
+        m_sortUpdate++;
+        for (auto& entry : m_labels) { entry.label->m_sortUpdate = m_sortUpdate; }
+        m_lastLabelCount = m_labels.size();
+
+        m_labels = entries;
+        sortLabels(&Label::m_priorityRank, m_lastLabelCount, priorityComparator);
+    }
+}
+BENCHMARK_REGISTER_F(LabelSortFixture, PrioritySortFromLastUpdate)->Arg(1000)->Arg(10000)->Arg(50000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,249 @@
+#include "benchmark/benchmark.h"
+
+#include "data/tileSource.h"
+#include "labels/labelManager.h"
+#include "log.h"
+#include "map.h"
+#include "marker/marker.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "tile/tile.h"
+#include "tile/tileBuilder.h"
+#include "tile/tileTask.h"
+#include "util/mapProjection.h"
+#include "view/view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* Per-frame label placement along camera paths
+ *
+ * Usage: benchLabelPlacement.out [--corpus=<dir>] [--scene=<scene.yaml>] [--path=<file>] [benchmark flags]
+ *
+ * The vector tiles of the corpus directory (named like the tiles of benchTilePipeline) are built
+ * once with the scene - which lays out their text - and each benchmark iteration then runs
+ * LabelManager::updateLabelSet() for the next frame of a camera path, as Scene::update() does.
+ * Built-in paths pan across, zoom into, tilt over and rotate around the first tile; --path
+ * replays a recorded path with one frame per line: 'longitude latitude zoom rotation tilt',
+ * angles in degrees. Label meshes only get vertices, the benchmarks link the mock GL.
+ *
+ * Besides the update time per frame each benchmark reports its percentiles, the time in the
+ * stages of the update and the collision tests per frame.
+ */
+
+using namespace Tangram;
+
+using Clock = std::chrono::steady_clock;
+
+struct CameraFrame {
+    glm::dvec2 position;
+    float zoom;
+    float yaw;   // radians
+    float pitch; // radians
+};
+
+static MockPlatform platform;
+static std::unique_ptr<Scene> scene;
+static std::vector<std::shared_ptr<Tile>> tiles;
+static std::vector<CameraFrame> recordedPath;
+static TileID firstTile{0, 0, 0};
+
+static const int pathFrames = 120;
+
+static std::vector<CameraFrame> builtinPath(int _path) {
+    glm::dvec2 center = MapProjection::tileCenter(firstTile);
+    double size = MapProjection::metersPerTileAtZoom(firstTile.z);
+    float zoom = firstTile.z;
+
+    std::vector<CameraFrame> frames;
+    for (int i = 0; i < pathFrames; i++) {
+        float t = float(i) / (pathFrames - 1);
+        CameraFrame frame{center, zoom, 0.f, 0.f};
+        switch (_path) {
+        case 0: frame.position.x += (t - 0.5) * size; break;               // pan
+        case 1: frame.zoom += 1.5f * std::sin(t * float(M_PI)); break;     // zoom in and out
+        case 2: frame.pitch = glm::radians(60.f) * t; break;               // tilt
+        case 3: frame.yaw = glm::radians(360.f) * t; break;                // rotate
+        }
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static std::vector<CameraFrame> loadPath(const std::string& _file) {
+    std::vector<CameraFrame> frames;
+    std::ifstream in(_file);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') { continue; }
+        std::istringstream fields(line);
+        double lng, lat;
+        float zoom, rotation, tilt;
+        if (!(fields >> lng >> lat >> zoom >> rotation >> tilt)) { continue; }
+        frames.push_back({MapProjection::lngLatToProjectedMeters({lng, lat}), zoom,
+                          glm::radians(rotation), glm::radians(tilt)});
+    }
+    return frames;
+}
+
+// Nearest-rank percentile @_p of @_samples
+static double percentile(std::vector<double> _samples, double _p) {
+    if (_samples.empty()) { return 0; }
+    std::sort(_samples.begin(), _samples.end());
+    size_t rank = size_t(std::ceil(_p / 100. * _samples.size()));
+    return _samples[std::min(std::max<size_t>(rank, 1), _samples.size()) - 1];
+}
+
+static void replayPath(benchmark::State& _state, const std::vector<CameraFrame>& _frames) {
+    const float dt = 1.f / 60.f;
+
+    View view(1920, 1080);
+    LabelManager labelManager;
+    LabelManager::UpdateStats stats;
+    labelManager.setUpdateStats(&stats);
+    std::vector<std::unique_ptr<Marker>> markers;
+
+    std::vector<double> frameTimes;
+    size_t collisionTests = 0;
+    size_t frame = 0;
+
+    for (auto _ : _state) {
+        auto& camera = _frames[frame++ % _frames.size()];
+        view.setPosition(camera.position);
+        view.setZoom(camera.zoom);
+        view.setYaw(camera.yaw);
+        view.setPitch(camera.pitch);
+        view.update();
+        for (auto& tile : tiles) { tile->update(view, dt); }
+
+        auto start = Clock::now();
+        labelManager.updateLabelSet(view, dt, *scene, tiles, markers, false);
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        _state.SetIterationTime(seconds);
+        frameTimes.push_back(seconds * 1000);
+        collisionTests += labelManager.collisionStats().tests;
+    }
+
+    double iterations = std::max<double>(_state.iterations(), 1);
+    _state.counters["frame_ms_p50"] = percentile(frameTimes, 50);
+    _state.counters["frame_ms_p90"] = percentile(frameTimes, 90);
+    _state.counters["frame_ms_p99"] = percentile(frameTimes, 99);
+    _state.counters["labels_ms"] = stats.labels / iterations;
+    _state.counters["sort_ms"] = stats.sort / iterations;
+    _state.counters["occlusions_ms"] = stats.occlusions / iterations;
+    _state.counters["meshes_ms"] = stats.meshes / iterations;
+    _state.counters["collision_tests"] = collisionTests / iterations;
+}
+
+static void BM_LabelPlacementPan(benchmark::State& _state) { replayPath(_state, builtinPath(0)); }
+static void BM_LabelPlacementZoom(benchmark::State& _state) { replayPath(_state, builtinPath(1)); }
+static void BM_LabelPlacementTilt(benchmark::State& _state) { replayPath(_state, builtinPath(2)); }
+static void BM_LabelPlacementRotate(benchmark::State& _state) { replayPath(_state, builtinPath(3)); }
+BENCHMARK(BM_LabelPlacementPan)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LabelPlacementZoom)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LabelPlacementTilt)->UseManualTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LabelPlacementRotate)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+// Build the vector tiles of @_dir with the first MVT source of the scene
+static bool buildTiles(const std::string& _dir) {
+    TileSource* source = nullptr;
+    for (auto& tileSource : scene->tileSources()) {
+        if (tileSource->generateGeometry() && tileSource->format() == TileSource::Format::Mvt) {
+            source = tileSource.get();
+            break;
+        }
+    }
+    if (!source) { return false; }
+
+    static const std::regex pattern(".*?_?(\\d+)_(\\d+)_(\\d+)\\.(mvt|pbf)$");
+    std::vector<std::string> names;
+    if (DIR* dir = opendir(_dir.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::regex_match(entry->d_name, pattern)) { names.push_back(entry->d_name); }
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+
+    TileBuilder builder(*scene);
+    builder.init();
+    for (auto& name : names) {
+        std::smatch match;
+        std::regex_match(name, match, pattern);
+        TileID id(std::stoi(match[2]), std::stoi(match[3]), std::stoi(match[1]));
+
+        auto task = source->createTask(id);
+        static_cast<BinaryTileTask&>(*task).rawTileData = std::make_shared<std::vector<char>>(
+            MockPlatform::getBytesFromFile((_dir + "/" + name).c_str()));
+        task->parse();
+        task->build(builder);
+        if (auto tile = task->getTile()) {
+            if (tiles.empty()) { firstTile = id; }
+            tiles.push_back(std::move(tile));
+        }
+    }
+    return !tiles.empty();
+}
+
+int main(int argc, char** argv) {
+
+    std::string corpusDir = "res/corpus";
+    std::string sceneFile = "res/scene.yaml";
+    std::string pathFile;
+
+    // Take our options out of the arguments passed to the benchmark library
+    int count = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--corpus=", 9) == 0) {
+            corpusDir = argv[i] + 9;
+        } else if (strncmp(argv[i], "--scene=", 8) == 0) {
+            sceneFile = argv[i] + 8;
+        } else if (strncmp(argv[i], "--path=", 7) == 0) {
+            pathFile = argv[i] + 7;
+        } else {
+            argv[count++] = argv[i];
+        }
+    }
+    argc = count;
+
+    SceneOptions options{platform.resolveUrl(Url(sceneFile))};
+    options.numTileWorkers = 0;
+    options.prefetchTiles = false;
+    scene = std::make_unique<Scene>(platform, std::move(options));
+    View view;
+    if (!scene->load() || !scene->completeScene(view)) {
+        LOGE("Cannot load scene '%s'", sceneFile.c_str());
+        return 1;
+    }
+    if (!buildTiles(corpusDir)) {
+        LOGE("No vector tiles built from corpus '%s'", corpusDir.c_str());
+        return 1;
+    }
+
+    if (!pathFile.empty()) {
+        recordedPath = loadPath(pathFile);
+        if (recordedPath.empty()) {
+            LOGE("No frames in camera path '%s'", pathFile.c_str());
+            return 1;
+        }
+        benchmark::RegisterBenchmark("BM_LabelPlacementRecorded", [](benchmark::State& st) {
+            replayPath(st, recordedPath);
+        })->UseManualTime()->Unit(benchmark::kMillisecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    tiles.clear();
+    scene.reset();
+    return 0;
+}
@@ -152,6 +152,54 @@ struct JSTileStyleFnFixture : public benchmark::Fixture {
 
 RUN(JSTileStyleFnFixture, TileStyleFnBench);
 
+// Match the features of the tile against the layers of the scene, like DrawRuleMergeSet::match
+template<bool compiled>
+struct FilterFixture : public benchmark::Fixture {
+    StyleContext ctx;
+    uint32_t matchCnt = 0;
+
+    void SetUp(const ::benchmark::State& state) override {
+        globalSetup();
+        ctx.initFunctions(*scene);
+        ctx.setZoom(10);
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        LOG(">>> %d", matchCnt);
+    }
+    bool eval(const SceneLayer& layer, const Feature& feat) {
+        return compiled
+            ? layer.filterProgram().eval(feat, ctx)
+            : layer.filter().eval(feat, ctx);
+    }
+    void match(const SceneLayer& layer, const Feature& feat) {
+        if (!layer.enabled() || !eval(layer, feat)) { return; }
+        matchCnt++;
+        for (const auto& sublayer : layer.sublayers()) {
+            match(sublayer, feat);
+        }
+    }
+    __attribute__ ((noinline)) void run() {
+        for (const auto& datalayer : scene->layers()) {
+            for (const auto& collection : tileData->layers) {
+                if (!collection.name.empty()) {
+                    const auto& dlc = datalayer.collections();
+                    if (std::find(dlc.begin(), dlc.end(), collection.name) == dlc.end()) { continue; }
+                }
+                for (const auto& feat : collection.features) {
+                    ctx.setFeature(feat);
+                    match(datalayer, feat);
+                }
+            }
+        }
+    }
+};
+
+using FilterTreeFixture = FilterFixture<false>;
+RUN(FilterTreeFixture, FilterTreeBench);
+
+using FilterProgramFixture = FilterFixture<true>;
+RUN(FilterProgramFixture, FilterProgramBench);
+
 class DirectGetPropertyFixture : public benchmark::Fixture {
 public:
     Feature feature;
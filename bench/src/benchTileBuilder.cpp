@@ -2,6 +2,7 @@
 
 #include "data/tileSource.h"
 #include "gl.h"
+#include "gl/mesh.h"
 #include "log.h"
 #include "map.h"
 #include "mockPlatform.h"
@@ -77,12 +78,30 @@ public:
     }
 
     __attribute__ ((noinline)) void run() {
-        result = tileBuilder->build({0,0,10,10}, *tileData, *source);
+        result = std::make_shared<Tile>(TileID{0,0,10,10}, source->id(), source->generation());
+        tileBuilder->build(*result, *tileData, *source);
+    }
+
+    // Vertex shader invocations to draw the built tile in one frame
+    size_t vertexInvocations() {
+        size_t invocations = 0;
+        for (auto& style : scene->styles()) {
+            if (auto& mesh = result->getMesh(*style)) { invocations += mesh->vertexInvocations(); }
+        }
+        return invocations;
     }
 };
 
 RUN(TileBuilderFixture, TileBuilderBench);
 
+BENCHMARK_DEFINE_F(TileBuilderFixture, TileBuilderVertexCacheBench)(benchmark::State& st) {
+    MeshBase::setOptimizeVertexCache(st.range(0));
+    while (st.KeepRunning()) { run(); }
+    st.counters["vs_invocations_per_frame"] = vertexInvocations();
+    MeshBase::setOptimizeVertexCache(true);
+}
+BENCHMARK_REGISTER_F(TileBuilderFixture, TileBuilderVertexCacheBench)->Arg(0)->Arg(1);
+
 
 
 BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+#include "benchmark/benchmark.h"
+
+#include "data/tileSource.h"
+#include "mockPlatform.h"
+#include "tile/tile.h"
+#include "tile/tileManager.h"
+#include "tile/tileTask.h"
+#include "util/mapProjection.h"
+#include "view/view.h"
+
+#include <deque>
+
+using namespace Tangram;
+
+// Number of TileSources, e.g. base, terrain, hillshade, contours and overlays
+const int numSources = 6;
+
+// Frames of the recorded pan sequence
+const int numFrames = 240;
+
+struct BenchTileWorker : TileTaskQueue {
+    std::deque<std::shared_ptr<TileTask>> tasks;
+
+    void enqueue(std::shared_ptr<TileTask> task) override {
+        tasks.push_back(std::move(task));
+    }
+
+    // Complete up to _count tasks per frame to keep a realistic number of tiles in progress
+    void processTasks(int _count) {
+        while (!tasks.empty() && _count-- > 0) {
+            auto task = tasks.front();
+            tasks.pop_front();
+            if (task->isCanceled()) { continue; }
+
+            task->setTile(std::make_unique<Tile>(task->tileId(), task->source()->id(),
+                                                 task->source()->generation()));
+        }
+    }
+};
+
+struct BenchTileSource : TileSource {
+    BenchTileSource(int _zoomBias) : TileSource("bench", nullptr) {
+        m_generateGeometry = true;
+        m_zoomOptions.zoomBias = _zoomBias;
+    }
+
+    void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        _task->startedLoading();
+        _cb.func(std::move(_task));
+    }
+
+    void cancelLoadingTile(TileTask& _task) override {}
+
+    std::shared_ptr<TileData> parse(const TileTask& _task) const override { return nullptr; }
+
+    void clearData() override {}
+
+    std::shared_ptr<TileTask> createTask(TileID _tileId) override {
+        return std::make_shared<TileTask>(_tileId, this);
+    }
+};
+
+struct TileManagerFixture : public benchmark::Fixture {
+    MockPlatform platform;
+    BenchTileWorker worker;
+    std::unique_ptr<TileManager> tileManager;
+    std::vector<std::shared_ptr<TileSource>> sources;
+    std::vector<glm::dvec3> frames;
+    View view{1080, 1920};
+
+    void SetUp(const ::benchmark::State& state) override {
+        tileManager = std::make_unique<TileManager>(platform, worker, std::weak_ptr<ScenePrana>());
+        sources.clear();
+        for (int i = 0; i < numSources; i++) {
+            sources.push_back(std::make_shared<BenchTileSource>(i % 2));
+        }
+        tileManager->setTileSources(sources);
+
+        // Recorded pan: fling across a city at z15 with a slow zoom out to z14
+        frames.clear();
+        glm::dvec2 start = MapProjection::lngLatToProjectedMeters({-74.00, 40.72});
+        for (int i = 0; i < numFrames; i++) {
+            double t = double(i) / numFrames;
+            frames.emplace_back(start.x + 6000.0 * t, start.y - 2500.0 * t * t, 15.0 - t);
+        }
+        view.setPixelScale(2.f);
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        tileManager.reset();
+        worker.tasks.clear();
+    }
+};
+
+BENCHMARK_DEFINE_F(TileManagerFixture, UpdateTileSetsPanBench)(benchmark::State& st) {
+    while (st.KeepRunning()) {
+        for (const auto& frame : frames) {
+            view.setPosition(frame.x, frame.y);
+            view.setZoom(float(frame.z));
+            view.update();
+            tileManager->updateTileSets(view);
+            worker.processTasks(8);
+        }
+        tileManager->clearTileSets();
+    }
+}
+BENCHMARK_REGISTER_F(TileManagerFixture, UpdateTileSetsPanBench);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,297 @@
+#include "benchmark/benchmark.h"
+
+#include "data/tileSource.h"
+#include "gl/renderState.h"
+#include "log.h"
+#include "map.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "tile/tileBuilder.h"
+#include "tile/tileTask.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <map>
+#include <new>
+#include <regex>
+#include <string>
+#include <vector>
+
+/* End-to-end tile pipeline benchmark over a corpus of tiles and scenes
+ *
+ * Usage: benchTilePipeline.out [--corpus=<dir>] [--scenes=<a.yaml>,<b.yaml>] [--upload] [benchmark flags]
+ *
+ * Each tile file of the corpus directory is decoded, styled and built - and with --upload also
+ * uploaded, to the mock GL of the benchmarks - with each scene, as one benchmark per scene and
+ * tile. File names end with the tile coordinates, like 'city_16_19300_24630.mvt'; .mvt and .pbf
+ * tiles go to the first MVT source of a scene, .json and .geojson to a GeoJSON source, .topojson
+ * to a TopoJSON source and images to its first raster source (e.g. terrain tiles).
+ *
+ * Besides the time per iteration each benchmark reports percentiles of the decode, build and
+ * upload stages, the time styling each scene layer, allocations per iteration and the vertices
+ * and buffer sizes of the built tile. Results are written as JSON with
+ * --benchmark_out=<file> --benchmark_out_format=json, to be compared across commits with
+ * benchmark/tools/compare.py.
+ */
+
+using namespace Tangram;
+
+using Clock = std::chrono::steady_clock;
+
+// Allocations counted by the replaced operator new while a stage runs
+static std::atomic<bool> s_countAllocations{false};
+static std::atomic<uint64_t> s_allocations{0};
+static std::atomic<uint64_t> s_allocatedBytes{0};
+
+void* operator new(size_t _size) {
+    if (s_countAllocations.load(std::memory_order_relaxed)) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        s_allocatedBytes.fetch_add(_size, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(_size ? _size : 1)) { return p; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* _p) noexcept { std::free(_p); }
+void operator delete(void* _p, size_t) noexcept { std::free(_p); }
+
+struct CorpusTile {
+    std::string name;
+    std::string extension;
+    TileID id{0, 0, 0};
+    std::vector<char> data;
+};
+
+struct BenchScene {
+    std::string name;
+    std::unique_ptr<Scene> scene;
+    std::unique_ptr<TileBuilder> builder;
+};
+
+static MockPlatform platform;
+static RenderState renderState;
+static bool uploadStage = false;
+
+// Tiles of @_dir with coordinates in their name, see above
+static std::vector<CorpusTile> loadCorpus(const std::string& _dir) {
+    std::vector<CorpusTile> tiles;
+    static const std::regex pattern("(.*?)_?(\\d+)_(\\d+)_(\\d+)\\.(\\w+)$");
+
+    DIR* dir = opendir(_dir.c_str());
+    if (!dir) {
+        LOGE("Cannot open corpus directory '%s'", _dir.c_str());
+        return tiles;
+    }
+    while (dirent* entry = readdir(dir)) {
+        std::cmatch match;
+        if (!std::regex_match(entry->d_name, match, pattern)) { continue; }
+
+        CorpusTile tile;
+        tile.name = entry->d_name;
+        tile.extension = match[5];
+        int z = std::stoi(match[2]), x = std::stoi(match[3]), y = std::stoi(match[4]);
+        tile.id = TileID(x, y, z);
+        tile.data = MockPlatform::getBytesFromFile((_dir + "/" + tile.name).c_str());
+        if (!tile.data.empty()) { tiles.push_back(std::move(tile)); }
+    }
+    closedir(dir);
+
+    std::sort(tiles.begin(), tiles.end(), [](auto& a, auto& b) { return a.name < b.name; });
+    return tiles;
+}
+
+// Source of @_scene for tiles in the format of @_extension
+static TileSource* findSource(const Scene& _scene, const std::string& _extension) {
+    bool raster = _extension == "png" || _extension == "webp" || _extension == "jpg";
+    TileSource::Format format = TileSource::Format::Mvt;
+    if (_extension == "json" || _extension == "geojson") { format = TileSource::Format::GeoJson; }
+    if (_extension == "topojson") { format = TileSource::Format::TopoJson; }
+    if (_extension == "mlt") { format = TileSource::Format::Mlt; }
+
+    for (auto& source : _scene.tileSources()) {
+        if (raster ? source->isRaster() :
+            (!source->isRaster() && source->generateGeometry() && source->format() == format)) {
+            return source.get();
+        }
+    }
+    return nullptr;
+}
+
+// Nearest-rank percentile @_p of @_samples
+static double percentile(std::vector<double> _samples, double _p) {
+    if (_samples.empty()) { return 0; }
+    std::sort(_samples.begin(), _samples.end());
+    size_t rank = size_t(std::ceil(_p / 100. * _samples.size()));
+    return _samples[std::min(std::max<size_t>(rank, 1), _samples.size()) - 1];
+}
+
+static double millisSince(Clock::time_point _start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - _start).count();
+}
+
+static void runPipeline(benchmark::State& _state, BenchScene& _scene, TileSource& _source,
+                        const CorpusTile& _tile) {
+
+    std::vector<double> decode, build, upload;
+    std::map<std::string, double> layerTimes;
+    uint64_t allocations = 0, allocatedBytes = 0;
+    size_t vertices = 0, bufferBytes = 0, invocations = 0;
+
+    TileBuilder::BuildStats stats;
+    _scene.builder->setBuildStats(&stats);
+
+    while (_state.KeepRunning()) {
+        _state.PauseTiming();
+        // rasters are taken from the texture cache after the first decode
+        if (_source.isRaster()) { _source.clearData(); }
+        auto task = _source.createTask(_tile.id);
+        static_cast<BinaryTileTask&>(*task).rawTileData = std::make_shared<std::vector<char>>(_tile.data);
+        stats = TileBuilder::BuildStats();
+        uint64_t allocationsBefore = s_allocations, bytesBefore = s_allocatedBytes;
+        s_countAllocations = true;
+        _state.ResumeTiming();
+
+        auto start = Clock::now();
+        task->parse();
+        decode.push_back(millisSince(start));
+
+        start = Clock::now();
+        task->build(*_scene.builder);
+        build.push_back(millisSince(start));
+
+        std::unique_ptr<Tile> tile = task->isCanceled() ? nullptr : task->getTile();
+        if (uploadStage && tile) {
+            start = Clock::now();
+            tile->upload(renderState);
+            upload.push_back(millisSince(start));
+        }
+
+        _state.PauseTiming();
+        s_countAllocations = false;
+        allocations += s_allocations - allocationsBefore;
+        allocatedBytes += s_allocatedBytes - bytesBefore;
+
+        for (auto& layer : stats.layers) { layerTimes[layer.first] += layer.second; }
+
+        if (tile) {
+            vertices = bufferBytes = invocations = 0;
+            for (auto& style : _scene.scene->styles()) {
+                if (auto& mesh = tile->getMesh(*style)) {
+                    vertices += mesh->vertexCount();
+                    bufferBytes += mesh->bufferSize();
+                    invocations += mesh->vertexInvocations();
+                }
+            }
+        }
+        tile.reset();
+        task.reset();
+        _state.ResumeTiming();
+    }
+    _scene.builder->setBuildStats(nullptr);
+
+    double iterations = std::max<double>(_state.iterations(), 1);
+    auto reportStage = [&](const char* _name, const std::vector<double>& _samples) {
+        if (_samples.empty()) { return; }
+        _state.counters[std::string(_name) + "_ms_p50"] = percentile(_samples, 50);
+        _state.counters[std::string(_name) + "_ms_p90"] = percentile(_samples, 90);
+        _state.counters[std::string(_name) + "_ms_p99"] = percentile(_samples, 99);
+    };
+    reportStage("decode", decode);
+    reportStage("build", build);
+    reportStage("upload", upload);
+    _state.counters["labels_ms"] = stats.labels;
+    _state.counters["meshes_ms"] = stats.meshes;
+    for (auto& layer : layerTimes) {
+        _state.counters["layer_" + layer.first + "_ms"] = layer.second / iterations;
+    }
+    _state.counters["allocations"] = allocations / iterations;
+    _state.counters["allocated_bytes"] = allocatedBytes / iterations;
+    _state.counters["vertices"] = vertices;
+    _state.counters["buffer_bytes"] = bufferBytes;
+    _state.counters["vs_invocations"] = invocations;
+}
+
+// Split "a,b" into its items
+static std::vector<std::string> splitList(const std::string& _list) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= _list.size()) {
+        size_t end = _list.find(',', start);
+        if (end == std::string::npos) { end = _list.size(); }
+        if (end > start) { items.push_back(_list.substr(start, end - start)); }
+        start = end + 1;
+    }
+    return items;
+}
+
+int main(int argc, char** argv) {
+
+    std::string corpus = "res/corpus";
+    std::vector<std::string> sceneFiles = { "res/scene.yaml" };
+
+    // Take our options out of the arguments passed to the benchmark library
+    int count = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--corpus=", 9) == 0) {
+            corpus = argv[i] + 9;
+        } else if (strncmp(argv[i], "--scenes=", 9) == 0) {
+            sceneFiles = splitList(argv[i] + 9);
+        } else if (strcmp(argv[i], "--upload") == 0) {
+            uploadStage = true;
+        } else {
+            argv[count++] = argv[i];
+        }
+    }
+    argc = count;
+
+    auto tiles = loadCorpus(corpus);
+    if (tiles.empty()) {
+        LOGE("No tiles in corpus '%s'", corpus.c_str());
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<BenchScene>> scenes;
+    for (auto& file : sceneFiles) {
+        SceneOptions options{platform.resolveUrl(Url(file))};
+        options.numTileWorkers = 0;
+        options.prefetchTiles = false;
+
+        auto benchScene = std::make_unique<BenchScene>();
+        benchScene->name = file.substr(file.find_last_of('/') + 1);
+        benchScene->scene = std::make_unique<Scene>(platform, std::move(options));
+        if (!benchScene->scene->load()) {
+            LOGE("Cannot load scene '%s'", file.c_str());
+            return 1;
+        }
+        benchScene->builder = std::make_unique<TileBuilder>(*benchScene->scene);
+        benchScene->builder->init();
+        scenes.push_back(std::move(benchScene));
+    }
+
+    for (auto& scene : scenes) {
+        for (auto& tile : tiles) {
+            TileSource* source = findSource(*scene->scene, tile.extension);
+            if (!source) {
+                LOGW("Scene '%s' has no source for '%s'", scene->name.c_str(), tile.name.c_str());
+                continue;
+            }
+            BenchScene* benchScene = scene.get();
+            const CorpusTile* corpusTile = &tile;
+            benchmark::RegisterBenchmark((scene->name + "/" + tile.name).c_str(),
+                                         [=](benchmark::State& st) {
+                                             runPipeline(st, *benchScene, *source, *corpusTile);
+                                         })->Unit(benchmark::kMillisecond);
+        }
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "benchmark/benchmark.h"
 
 #include "data/tileSource.h"
+#include "data/formats/mvt.h"
 #include "log.h"
 #include "map.h"
 #include "mockPlatform.h"
@@ -44,5 +45,58 @@ BENCHMARK_DEFINE_F(TileSourceFixture, TileSourceBench)(benchmark::State& st) {
 }
 BENCHMARK_REGISTER_F(TileSourceFixture, TileSourceBench);
 
+struct MvtGeometryFixture : public benchmark::Fixture {
+    std::vector<char> rawTileData;
+    // geometry messages of all features, with the extent of their layer
+    std::vector<std::pair<protobuf::message, int>> geometries;
+
+    void SetUp(const ::benchmark::State& state) override {
+        rawTileData = MockPlatform::getBytesFromFile(tile_file);
+
+        protobuf::message tile(rawTileData.data(), rawTileData.size());
+        while (tile.next()) {
+            if (tile.tag != 3) { tile.skip(); continue; }
+
+            protobuf::message layer = tile.getMessage();
+            size_t first = geometries.size();
+            int extent = 4096;
+            while (layer.next()) {
+                if (layer.tag == 2) {
+                    protobuf::message feature = layer.getMessage();
+                    while (feature.next()) {
+                        if (feature.tag == 4) {
+                            geometries.emplace_back(feature.getMessage(), 0);
+                        } else {
+                            feature.skip();
+                        }
+                    }
+                } else if (layer.tag == 5) {
+                    extent = static_cast<int>(layer.varint());
+                } else {
+                    layer.skip();
+                }
+            }
+            for (size_t i = first; i < geometries.size(); i++) { geometries[i].second = extent; }
+        }
+    }
+    void TearDown(const ::benchmark::State& state) override {
+        geometries.clear();
+    }
+};
+BENCHMARK_DEFINE_F(MvtGeometryFixture, MvtGeometryBench)(benchmark::State& st) {
+    Mvt::ParserContext ctx(0);
+    size_t points = 0;
+
+    while (st.KeepRunning()) {
+        for (auto& geometry : geometries) {
+            ctx.tileExtent = geometry.second;
+            Mvt::getGeometry(ctx, geometry.first);
+            points += ctx.geometry.coordinates.size();
+        }
+    }
+    st.SetItemsProcessed(points);
+}
+BENCHMARK_REGISTER_F(MvtGeometryFixture, MvtGeometryBench);
+
 
 BENCHMARK_MAIN();
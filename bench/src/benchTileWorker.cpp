@@ -0,0 +1,206 @@
+#include "benchmark/benchmark.h"
+
+#include "data/tileSource.h"
+#include "log.h"
+#include "map.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "text/fontContext.h"
+#include "tile/tileTask.h"
+#include "tile/tileWorker.h"
+#include "view/view.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <dirent.h>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <vector>
+
+/* Throughput of TileWorker with 1 to 16 worker threads
+ *
+ * Usage: benchTileWorker.out [--corpus=<dir>] [--scene=<scene.yaml>] [--copies=<n>] [benchmark flags]
+ *
+ * Each iteration feeds the vector tiles of the corpus directory (named like the tiles of
+ * benchTilePipeline, e.g. 'city_16_19300_24630.mvt') --copies times through a TileWorker and
+ * waits until all of them are built. Besides tiles per second and the speedup over one worker,
+ * each run reports the time workers waited for the TileWorker scheduler and queue locks and
+ * for the FontContext layout locks, per iteration. Contention elsewhere, e.g. in the allocator,
+ * shows as speedup lost without lock waits.
+ *
+ * Copies of a tile get other tile coordinates but share the triangulations and label
+ * collisions cached by the TileWorker, so the corpus should hold distinct tiles.
+ */
+
+using namespace Tangram;
+
+using Clock = std::chrono::steady_clock;
+
+// Counts the frames requested for built tiles, i.e. the tasks a TileWorker finished
+struct CountingPlatform : MockPlatform {
+    mutable std::mutex mutex;
+    mutable std::condition_variable condition;
+    mutable size_t finished = 0;
+
+    void requestRender() const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished++;
+        condition.notify_all();
+    }
+
+    void waitFor(size_t _count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return finished >= _count; });
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = 0;
+    }
+};
+
+struct CorpusTile {
+    TileID id{0, 0, 0};
+    std::shared_ptr<std::vector<char>> data;
+};
+
+static std::string sceneFile = "res/scene.yaml";
+static std::vector<CorpusTile> corpus;
+static int copies = 8;
+
+// Tiles per second with one worker, for the speedup of the other runs
+static double baseThroughput = 0;
+
+static std::vector<CorpusTile> loadCorpus(const std::string& _dir) {
+    std::vector<CorpusTile> tiles;
+    static const std::regex pattern(".*?_?(\\d+)_(\\d+)_(\\d+)\\.(mvt|pbf)$");
+
+    DIR* dir = opendir(_dir.c_str());
+    if (!dir) { return tiles; }
+    while (dirent* entry = readdir(dir)) {
+        std::cmatch match;
+        if (!std::regex_match(entry->d_name, match, pattern)) { continue; }
+
+        CorpusTile tile;
+        tile.id = TileID(std::stoi(match[2]), std::stoi(match[3]), std::stoi(match[1]));
+        tile.data = std::make_shared<std::vector<char>>(
+            MockPlatform::getBytesFromFile((_dir + "/" + entry->d_name).c_str()));
+        if (!tile.data->empty()) { tiles.push_back(std::move(tile)); }
+    }
+    closedir(dir);
+    return tiles;
+}
+
+static void BM_TileWorkerThroughput(benchmark::State& _state) {
+    int numWorkers = int(_state.range(0));
+
+    CountingPlatform platform;
+    auto tileWorker = std::make_shared<TileWorker>(numWorkers);
+
+    SceneOptions options{platform.resolveUrl(Url(sceneFile))};
+    options.numTileWorkers = numWorkers;
+    options.prefetchTiles = false;
+    auto scene = std::make_unique<Scene>(platform, std::move(options), nullptr, nullptr, tileWorker);
+    View view(1024, 1024);
+    if (!scene->load() || !scene->completeScene(view)) {
+        _state.SkipWithError("Cannot load scene");
+        return;
+    }
+
+    TileSource* source = nullptr;
+    for (auto& tileSource : scene->tileSources()) {
+        if (tileSource->generateGeometry() && tileSource->format() == TileSource::Format::Mvt) {
+            source = tileSource.get();
+            break;
+        }
+    }
+    if (!source) {
+        _state.SkipWithError("No MVT source in scene");
+        return;
+    }
+
+    std::vector<std::shared_ptr<TileTask>> tasks;
+    size_t numTiles = 0;
+    double seconds = 0;
+
+    for (auto _ : _state) {
+        _state.PauseTiming();
+        tasks.clear();
+        for (int copy = 0; copy < copies; copy++) {
+            for (auto& tile : corpus) {
+                // other coordinates for each copy, as for tiles of a larger view
+                TileID id((tile.id.x + copy) % (1 << tile.id.z), tile.id.y, tile.id.z);
+                auto task = source->createTask(id);
+                static_cast<BinaryTileTask&>(*task).rawTileData = tile.data;
+                task->setScenePrana(scene->prana());
+                task->setPriority(double(tasks.size()));
+                tasks.push_back(std::move(task));
+            }
+        }
+        platform.reset();
+        _state.ResumeTiming();
+
+        auto start = Clock::now();
+        for (auto& task : tasks) { tileWorker->enqueue(task); }
+        platform.waitFor(tasks.size());
+        seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        numTiles += tasks.size();
+    }
+
+    double iterations = std::max<double>(_state.iterations(), 1);
+    double throughput = seconds > 0 ? numTiles / seconds : 0;
+    if (numWorkers == 1) { baseThroughput = throughput; }
+
+    auto stats = tileWorker->stats();
+    auto& fontLocks = scene->fontContext()->layoutLockStats();
+
+    _state.counters["tiles_per_second"] = throughput;
+    _state.counters["speedup"] = baseThroughput > 0 ? throughput / baseThroughput : 0;
+    _state.counters["parse_ms"] = stats.parseTime / iterations;
+    _state.counters["build_ms"] = stats.buildTime / iterations;
+    _state.counters["scheduler_lock_ms"] = stats.schedulerLockTime / iterations;
+    _state.counters["scheduler_lock_waits"] = stats.schedulerLockWaits / iterations;
+    _state.counters["queue_lock_ms"] = stats.queueLockTime / iterations;
+    _state.counters["queue_lock_waits"] = stats.queueLockWaits / iterations;
+    _state.counters["font_lock_ms"] = fontLocks.waitTime() / iterations;
+    _state.counters["font_lock_waits"] = fontLocks.waits / iterations;
+
+    // the Scene releases its TileBuilders from the workers
+    tasks.clear();
+    scene.reset();
+}
+BENCHMARK(BM_TileWorkerThroughput)
+    ->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+
+    std::string corpusDir = "res/corpus";
+
+    // Take our options out of the arguments passed to the benchmark library
+    int count = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--corpus=", 9) == 0) {
+            corpusDir = argv[i] + 9;
+        } else if (strncmp(argv[i], "--scene=", 8) == 0) {
+            sceneFile = argv[i] + 8;
+        } else if (strncmp(argv[i], "--copies=", 9) == 0) {
+            copies = std::max(1, atoi(argv[i] + 9));
+        } else {
+            argv[count++] = argv[i];
+        }
+    }
+    argc = count;
+
+    corpus = loadCorpus(corpusDir);
+    if (corpus.empty()) {
+        LOGE("No vector tiles in corpus '%s'", corpusDir.c_str());
+        return 1;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
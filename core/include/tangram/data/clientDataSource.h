@@ -42,27 +42,88 @@ public:
         std::unique_ptr<PolygonBuilderData> data;
     };
 
+    /* Features of one geometry type in flat arrays, e.g. passed through from platform bindings
+     * without creating objects per feature. Offset arrays have one more entry than the items
+     * they delimit, the last being the end of the indexed array:
+     * - points: feature i is the point at coordinates[2 * i]
+     * - polylines: feature i has the lines featureOffsets[i] to featureOffsets[i + 1], line j
+     *   has the points partOffsets[j] to partOffsets[j + 1]
+     * - polygons: as polylines, with the rings of one polygon per feature
+     */
+    struct FeatureBatch {
+        enum class Type { points, polylines, polygons };
+
+        // Property values of all features for one key; NaN numbers and null strings are unset
+        struct Column {
+            const double* numbers = nullptr;
+            const char* const* strings = nullptr;
+        };
+
+        Type type = Type::points;
+        size_t featureCount = 0;
+
+        // longitude, latitude of pointCount points
+        const double* coordinates = nullptr;
+        size_t pointCount = 0;
+
+        const uint32_t* featureOffsets = nullptr;
+        const uint32_t* partOffsets = nullptr;
+        size_t partCount = 0;
+
+        // one column of featureCount values per key
+        std::vector<std::string> keys;
+        std::vector<Column> columns;
+    };
+
     // http://www.iana.org/assignments/media-types/application/geo+json
     const char* mimeType() const override { return "application/geo+json"; };
 
     // Add geometry from a GeoJSON string
     void addData(const std::string& _data);
 
+    // Add geometry from a GeoJSON document in chunks, e.g. while it is received; features are
+    //  added as soon as they are complete, without reading the whole document into memory
+    void appendData(const char* _data, size_t _size);
+
+    // End of the document passed to appendData(); returns false if it was invalid
+    bool finishData();
+
     uint64_t addPointFeature(Properties&& properties, LngLat coordinates, uint64_t id = -1);
 
     uint64_t addPolylineFeature(Properties&& properties, PolylineBuilder&& polyline, uint64_t id = -1);
 
     uint64_t addPolygonFeature(Properties&& properties, PolygonBuilder&& polygon, uint64_t id = -1);
 
+    // Add all features of @_batch; returns the id of the first, the others have consecutive
+    //  ids - or -1 if the batch is invalid
+    uint64_t addFeatures(const FeatureBatch& _batch);
+
     // set properties for existing feature
     void setProperties(uint64_t id, Properties&& properties);
 
+    // Remove feature; its id is not reused
+    void removeFeature(uint64_t id);
+
     // Remove all feature data.
     void clearFeatures();
 
-    // Transform added feature data into tiles.
+    // Apply added, updated and removed features to the tile index; only tiles covering
+    //  the bounds of changed features are rebuilt
     void generateTiles();
 
+    // Write the features and their tile index to @_path, to open them with openIndex() instead
+    //  of adding the data again, e.g. on the next start of the app. @_dataKey identifies the
+    //  data, e.g. a hash or version of the file it was read from. Updates that are not applied
+    //  by generateTiles() are not written. Returns false if the file cannot be written
+    bool saveIndex(const std::string& _path, uint64_t _dataKey) const;
+
+    // Replace all features with those saved at @_path with @_dataKey. The file is mapped and
+    //  the features are only read from it when the tiles covering them are parsed; they can be
+    //  changed as other features. Returns false when the file is missing or invalid or was
+    //  saved with another key or centroid option, leaving the features unchanged - then add
+    //  the data and save it again
+    bool openIndex(const std::string& _path, uint64_t _dataKey);
+
     void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
     std::shared_ptr<TileTask> createTask(TileID _tileId) override;
 
@@ -70,6 +131,8 @@ public:
 
     bool isClient() const override { return true; }
 
+    int64_t tileGeneration(const TileID& _tileId) const override;
+
 protected:
 
     std::shared_ptr<TileData> parse(const TileTask& _task) const override;
@@ -77,7 +140,13 @@ protected:
     struct Storage;
     std::unique_ptr<Storage> m_store;
 
+    struct DataStream;
+    std::unique_ptr<DataStream> m_stream;
+    std::mutex m_mutexStream;
+
     mutable std::mutex m_mutexStore;
+    // for generations of tiles, read on main thread while m_mutexStore may be held by parse()
+    mutable std::mutex m_mutexGeneration;
     bool m_hasPendingData = false;
     bool m_generateCentroids = false;
 
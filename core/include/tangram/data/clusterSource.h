@@ -0,0 +1,91 @@
+#pragma once
+
+#include "data/tileSource.h"
+#include "util/types.h"
+
+#include <mutex>
+
+namespace Tangram {
+
+struct Properties;
+
+/*
+ * ClusterSource - Point features clustered per zoom level, like supercluster
+ *
+ * Points are added on the main thread and published with generateClusters(). Tiles get the
+ * clusters of their zoom: points within `radius` pixels of each other are merged into one point
+ * feature at their centroid with the properties `point_count` and `cluster_id`; points not merged
+ * keep their own properties. Draw rules can tell them apart with `filter: { point_count: true }`.
+ *
+ * The clusters of a zoom are computed on the tile worker that first parses a tile of that zoom,
+ * from a spatial index of all points, and only the levels of the most recently parsed zooms are
+ * kept. Above `maxZoom` points are not clustered.
+ */
+class ClusterSource : public TileSource {
+
+public:
+
+    struct Options {
+
+        Options(float _radius, int32_t _maxZoom, uint32_t _minPoints)
+            : radius(_radius), maxZoom(_maxZoom), minPoints(_minPoints) {}
+
+        Options() {}
+
+        // Cluster radius in pixels
+        float radius = 40.f;
+        // Maximum zoom at which points are clustered
+        int32_t maxZoom = 16;
+        // Minimum number of points forming a cluster
+        uint32_t minPoints = 2;
+    };
+
+    ClusterSource(const std::string& _name, Options _options = {},
+                  TileSource::ZoomOptions _zoomOptions = {});
+
+    ~ClusterSource() override;
+
+    // Add a point; returns its id, ids are consecutive from 0 until clearPoints()
+    uint64_t addPoint(Properties&& _properties, LngLat _coordinates);
+
+    // Add @_count points without properties from longitude, latitude pairs; returns the id of the first
+    uint64_t addPoints(const double* _coordinates, size_t _count);
+
+    // Remove all points
+    void clearPoints();
+
+    // Apply added and removed points; the clusters of all zooms are computed again
+    void generateClusters();
+
+    // Number of points of the cluster with @_clusterId, from the `cluster_id` property; 0 if the
+    //  clusters of its zoom are no longer kept or were computed for a previous generation
+    uint32_t clusterPointCount(uint64_t _clusterId) const;
+
+    const Options& options() const { return m_options; }
+
+    void loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
+    std::shared_ptr<TileTask> createTask(TileID _tileId) override;
+
+    bool isClient() const override { return true; }
+
+protected:
+
+    std::shared_ptr<TileData> parse(const TileTask& _task) const override;
+
+    struct Point;
+    struct Level;
+    struct Storage;
+
+    // Storage of the points of the last generateClusters() and their cluster levels
+    std::unique_ptr<Storage> m_store;
+    mutable std::mutex m_mutexStore;
+
+    // Points added on the main thread, shared with m_store once published
+    std::shared_ptr<std::vector<Point>> m_points;
+    bool m_published = false;
+
+    Options m_options;
+
+};
+
+}
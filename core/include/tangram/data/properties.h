@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -7,6 +9,7 @@ namespace Tangram {
 
 class Value;
 struct PropertyItem;
+struct PropertyTable;
 
 // Helper to cleanup double string values from trailing 0s
 std::string doubleToString(double _doubleValue);
@@ -17,14 +20,21 @@ struct Properties {
     Properties();
     ~Properties();
 
-    Properties(const Properties& _other) = default;
+    // Copies of properties that refer to a PropertyTable have their own items
+    Properties(const Properties& _other);
     Properties(Properties&& _other) = default;
     Properties(std::vector<Item>&& _items);
-    Properties& operator=(const Properties& _other) = default;
+    Properties& operator=(const Properties& _other);
     Properties& operator=(Properties&& _other);
 
     const Value& get(const std::string& key) const;
 
+    /* Value of @key with its atom @keyAtom from InternTable::intern(); properties that refer to
+     * a PropertyTable compare the atoms instead of the strings. When @valueAtom is given, it is
+     * set to the atom of the value if the value is an interned string of a PropertyTable, else
+     * to InternTable::NONE. */
+    const Value& get(const std::string& key, uint32_t keyAtom, uint32_t* valueAtom = nullptr) const;
+
     void sort();
 
     void clear();
@@ -51,12 +61,25 @@ struct Properties {
 
     void setSorted(std::vector<Item>&& _items);
 
+    /* Refer to keys and values of @_table by (key id, value id) pairs in the order of keys
+     * as sorted by keyComparator(), instead of holding items. Items are only created when
+     * the properties are copied, changed or iterated. */
+    void setTable(std::shared_ptr<const PropertyTable> _table,
+                  std::vector<std::pair<uint32_t, uint32_t>>&& _tags);
+
     // template <typename... Args> void set(std::string key, Args&&... args) {
     //     props.emplace_back(std::move(key), Value{std::forward<Args>(args)...});
     //     sort();
     // }
 
-    const std::vector<Item>& items() const { return props; }
+    // Not thread-safe for properties that refer to a PropertyTable
+    const std::vector<Item>& items() const;
+
+    /* Estimated heap bytes of the items, not counting a PropertyTable they refer to */
+    size_t memoryUsage() const;
+
+    /* PropertyTable these properties refer to, or null */
+    const PropertyTable* table() const { return m_table.get(); }
 
     int32_t sourceId;
 
@@ -70,7 +93,13 @@ struct Properties {
         }
     }
 private:
-    std::vector<Item> props;
+    // Create items from the PropertyTable
+    void resolve() const;
+
+    mutable std::vector<Item> props;
+
+    mutable std::shared_ptr<const PropertyTable> m_table;
+    mutable std::vector<std::pair<uint32_t, uint32_t>> m_tags;
 };
 
 }
@@ -2,6 +2,9 @@
 
 #include "util/variant.h"
 
+#include <unordered_map>
+#include <vector>
+
 namespace Tangram {
 
 struct PropertyItem {
@@ -17,4 +20,26 @@ struct PropertyItem {
     }
 };
 
+// Keys and values shared by the Properties of many features, e.g. of a vector tile layer
+struct PropertyTable {
+    std::vector<std::string> keys;
+    std::vector<Value> values;
+    // id of each key in keys
+    std::unordered_map<std::string, uint32_t> keyIds;
+    // atoms of keys and of string values that are interned, see InternTable; set by findAtoms()
+    std::vector<uint32_t> keyAtoms;
+    std::vector<uint32_t> valueAtoms;
+
+    void addKey(std::string _key) {
+        keyIds.emplace(_key, uint32_t(keys.size()));
+        keys.push_back(std::move(_key));
+    }
+
+    // Look up the atoms of keys and values, once all are added
+    void findAtoms();
+
+    // Estimated heap bytes of keys and values
+    size_t memoryUsage() const;
+};
+
 }
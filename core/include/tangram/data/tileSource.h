@@ -2,6 +2,9 @@
 
 #include "tile/tileTask.h"
 
+#include <atomic>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -9,11 +12,15 @@
 
 namespace Tangram {
 
+class ObjectPool;
+struct PropertyKeys;
 struct TileData;
 struct TileID;
 struct Raster;
 class RasterSource;
 class Tile;
+class TileAvailability;
+class TileDataCache;
 class TileManager;
 struct RawCache;
 class Texture;
@@ -61,8 +68,29 @@ public:
             if (next) { next->cancelLoadingTile(_task); }
         }
 
+        /* Passes the priority of @_task, updated for the view, to its running I/O tasks */
+        virtual void updateTaskPriority(TileTask& _task) {
+            if (next) { next->updateTaskPriority(_task); }
+        }
+
         virtual void clear() { if (next) next->clear(); }
 
+        /* Drop data of @_tileId from in-memory caches of this and following DataSources */
+        virtual void clearTile(const TileID& _tileId) { if (next) next->clearTile(_tileId); }
+
+        /* Bytes held by in-memory caches of this and following DataSources */
+        virtual size_t cacheUsage() const { return next ? next->cacheUsage() : 0; }
+
+        /* Set size in bytes of the in-memory cache of the first caching DataSource from this one
+         * on; DataSources without a cache pass it on */
+        virtual void setCacheSize(size_t _cacheSize) { if (next) next->setCacheSize(_cacheSize); }
+
+        /* Size of the in-memory cache set by setCacheSize(), or 0 if there is none */
+        virtual size_t cacheSize() const { return next ? next->cacheSize() : 0; }
+
+        /* Evict from in-memory caches until each holds at most @_bytes; the cache size is kept */
+        virtual void trimCache(size_t _bytes) { if (next) next->trimCache(_bytes); }
+
         void setNext(std::unique_ptr<DataSource> _next) {
             next = std::move(_next);
             next->level = level + 1;
@@ -75,6 +103,7 @@ public:
         GeoJson,
         TopoJson,
         Mvt,
+        Mlt,
     };
 
     struct OfflineInfo {
@@ -110,22 +139,59 @@ public:
     /* Stops any running I/O tasks pertaining to @_task */
     virtual void cancelLoadingTile(TileTask& _task);
 
-    /* Parse a <TileTask> with data into a <TileData>, returning an empty TileData on failure */
+    /* Passes the priority of @_task, updated for the view, to its running I/O tasks */
+    void updateTaskPriority(TileTask& _task);
+
+    /* Parse a <TileTask> with data into a <TileData>, returning an empty TileData on failure
+     *
+     * Results for tiles at maxZoom, or with no data below them, are kept, so that the overzoomed
+     * tiles (s > z) of the same data tile share one TileData and need no loading and parsing;
+     * see loadTileData().
+     */
     virtual std::shared_ptr<TileData> parse(const TileTask& _task) const;
 
     /* Clears all data associated with this TileSource */
     virtual void clearData();
 
+    /* Drops the data kept for data tile @_tileId, e.g. when a DataSource received new data for
+     * a tile that was built from stale data, so that the tile is loaded and built again; other
+     * tiles are kept. May be called from any thread. */
+    void invalidateTile(const TileID& _tileId);
+
+    /* In-memory caches of raw tile data, see DataSource::cacheUsage() and following */
+    size_t dataCacheUsage() const { return m_sources ? m_sources->cacheUsage() : 0; }
+    void setDataCacheSize(size_t _cacheSize) { if (m_sources) { m_sources->setCacheSize(_cacheSize); } }
+    size_t dataCacheSize() const { return m_sources ? m_sources->cacheSize() : 0; }
+    void trimDataCache(size_t _bytes);
+
+    /* Calls @_fn with each TileData kept for overzoomed tiles; not to be used for parsing */
+    void forEachTileData(const std::function<void(const TileData&)>& _fn) const;
+
     const std::string& name() const { return m_name; }
 
+    /* Bytes of URL responses received for tiles of this source, see NetworkDataSource */
+    uint64_t bytesDownloaded() const { return m_bytesDownloaded; }
+    void addBytesDownloaded(size_t _bytes) { m_bytesDownloaded += _bytes; }
+
     virtual std::shared_ptr<TileTask> createTask(TileID _tile);
 
+    /* Pool recycling the memory of the tasks of this source, see createTask() and ObjectPool */
+    ObjectPool& taskPool() const { return *m_taskPool; }
+
     /* ID of this TileSource instance */
     int32_t id() const { return m_id; }
 
     /* Generation ID of TileSource state (incremented for each update, e.g. on clearData()) */
     int64_t generation() const { return m_generation; }
 
+    /* Generation of the last update affecting @_tileId; tiles built at this generation or later
+     *  are current. Sources with local updates, e.g. ClientDataSource, track this per tile */
+    virtual int64_t tileGeneration(const TileID& _tileId) const;
+
+    /* Tiles known to have no data, which are not requested; DataSources mark the tiles they
+     * find missing, see TileAvailability */
+    TileAvailability& availability() const { return *m_availability; }
+
     const ZoomOptions& zoomOptions() { return m_zoomOptions; }
     int32_t minDisplayZoom() const { return m_zoomOptions.minDisplayZoom; }
     int32_t maxDisplayZoom() const { return m_zoomOptions.maxDisplayZoom; }
@@ -150,11 +216,42 @@ public:
     bool isVisible() const { return m_isVisible; }
     void setVisible(bool visible) { m_isVisible = visible; }
 
+    /* Role of the source in tile loading: tiles of sources with higher load order (e.g. overlays
+     * or contours over a base map with 0) are loaded after tiles of lower order nearby */
+    int32_t loadOrder() const { return m_loadOrder; }
+    void setLoadOrder(int32_t _loadOrder) { m_loadOrder = _loadOrder; }
+
+    /* Tolerance in pixels for simplifying line and polygon geometry before it is built,
+     * 0 to build it as is; data layers can override it, see TileBuilder */
+    float simplify() const { return m_simplify; }
+    void setSimplify(float _simplify) { m_simplify = _simplify; }
+
+    /* Margin in pixels beyond the tile edges that polygons and lines are clipped to before they
+     * are built, so that the buffer of a tile is not drawn twice; negative to build all of it */
+    float clipMargin() const { return m_clipMargin; }
+    void setClipMargin(float _margin) { m_clipMargin = _margin; }
+
     /* Avoid RTTI by adding a boolean check on the data source object */
     virtual bool isRaster() const { return false; }
     virtual bool isClient() const { return false; }
 
     void setFormat(Format format) { m_format = format; }
+    Format format() const { return m_format; }
+
+    /* Add the name of a data layer that the scene uses; when any is set, the other layers
+     * of Mvt tiles are skipped when parsing. Must be set before tiles are loaded. */
+    void addDataLayer(const std::string& _layer);
+
+    /* Add property keys that the scene reads from features of data layer @_layer, or of unnamed
+     * layers for the empty name; all are kept if @_all is set. Other properties of layers with
+     * keys are dropped when parsing, see PropertyKeys. Must be set before tiles are parsed. */
+    void addPropertyKeys(const std::string& _layer, const std::vector<std::string>& _keys, bool _all);
+
+    /* Share parsed tiles with the sources of other Maps and of later Scenes through @_cache, see
+     * MapContext; tiles found there, e.g. when rebuilt, are neither loaded nor parsed again. Must
+     * be called after the data layers and property keys are set, as they are part of the key of
+     * the shared tiles. */
+    void setTileDataCache(std::shared_ptr<TileDataCache> _cache);
 
     const OfflineInfo& offlineInfo() const { return m_offlineInfo; }
     void setOfflineInfo(const OfflineInfo& info) { m_offlineInfo = info; }
@@ -163,12 +260,27 @@ protected:
 
     void addRasterTasks(TileTask& _task);
 
+    // Kept TileData of max-zoom data tile of @_tileId (any s), or nullptr
+    std::shared_ptr<TileData> overzoomTileData(const TileID& _tileId) const;
+    // Whether @_tileId is at maxZoom or its children have no data, so that it is overzoomed
+    bool isDeepestTile(const TileID& _tileId) const;
+    void clearOverzoomTileData();
+
+    // TileData of @_tileId parsed by a source with the same key, or nullptr
+    std::shared_ptr<TileData> sharedTileData(const TileID& _tileId) const;
+
     // This datasource is used to generate actual tile geometry
     // Is set true for any source assigned in a Scene Layer and when the layer is not disabled
     bool m_generateGeometry = false;
 
     bool m_isVisible = true;
 
+    int32_t m_loadOrder = 0;
+
+    float m_simplify = 0.f;
+
+    float m_clipMargin = -1.f;
+
     // Name used to identify this source in the style sheet
     std::string m_name;
 
@@ -182,14 +294,43 @@ protected:
     int32_t m_id;
 
     // Generation of dynamic TileSource state (incremented for each update)
-    int64_t m_generation = 1;
+    std::atomic<int64_t> m_generation{1};
 
     Format m_format = Format::GeoJson;
 
+    std::atomic<uint64_t> m_bytesDownloaded{0};
+
+    // Names of data layers used by the scene, all are parsed if empty
+    std::vector<std::string> m_dataLayers;
+
+    // Property keys read by the scene, all properties are kept if null
+    std::unique_ptr<PropertyKeys> m_propertyKeys;
+
     /* vector of raster sources (as raster samplers) referenced by this datasource */
     std::vector<RasterSource*> m_rasterSources;
 
     std::unique_ptr<DataSource> m_sources;
+
+    std::unique_ptr<TileAvailability> m_availability;
+
+    std::shared_ptr<ObjectPool> m_taskPool;
+
+    // Parsed TileData of max-zoom and other deepest tiles by data tile ID (s = z), most recently
+    // used last
+    mutable std::mutex m_overzoomMutex;
+    mutable std::vector<std::pair<TileID, std::shared_ptr<TileData>>> m_overzoomTileData;
+
+    // Parsed tiles shared with the sources of other Maps, and the key of this source in it;
+    // guarded by m_overzoomMutex
+    std::shared_ptr<TileDataCache> m_tileDataCache;
+    std::string m_tileDataKey;
+
+    // Generations of tiles dropped by invalidateTile() (s = z) since m_baseGeneration, the
+    // generation of the last other update; void once m_generation moved past
+    // m_invalidatedGeneration. Guarded by m_overzoomMutex
+    std::map<TileID, int64_t> m_tileGenerations;
+    int64_t m_baseGeneration = 0;
+    int64_t m_invalidatedGeneration = 0;
 };
 
 }
@@ -12,6 +12,7 @@
 
 namespace Tangram {
 
+class MapContext;
 class Platform;
 class TileSource;
 class View;
@@ -63,6 +64,10 @@ struct MarkerPickResult {
 // Returns a pointer to the selected marker pick result or null, only valid on the callback scope
 using MarkerPickCallback = std::function<void(const MarkerPickResult*)>;
 
+// Elevations in meters of the queried points and whether elevation data was loaded for each
+using ElevationCallback = std::function<void(const std::vector<double>& elevations,
+                                             const std::vector<bool>& valid)>;
+
 enum Error {
     none,
     scene_update_path_not_found,
@@ -83,6 +88,11 @@ using SceneReadyCallback = std::function<void(SceneID id, const SceneError*)>;
 
 using CameraAnimationCallback = std::function<void(bool finished)>;
 
+// Receives the RGBA pixels of an image rendered by renderToImage() or captured by
+// captureSnapshotAsync(), rows from bottom to top, or null if it could not be rendered; the pixels
+// are only valid in the callback scope
+using ImageReadyCallback = std::function<void(const unsigned int* _pixels, int _width, int _height)>;
+
 enum class EaseType : char {
     linear = 0,
     cubic,
@@ -90,6 +100,12 @@ enum class EaseType : char {
     sine,
 };
 
+enum class MemoryWarningLevel : char {
+    moderate = 0, // evict half of the cached tiles and tile data
+    critical,     // drop all cached tiles and tile data, keep visible tiles
+    complete,     // also drop visible tiles and font resources; tiles are reloaded
+};
+
 struct CameraPosition {
     double longitude = 0;
     double latitude = 0;
@@ -167,12 +183,95 @@ struct MapState {
     bool isAnimating() { return flags & is_animating; }
 };
 
+// Counters returned by Map::getPerformanceStats(). Totals count from the creation of the Map,
+// or of its Scene for tiles and labels; times are in milliseconds and memory in bytes.
+struct PerformanceStats {
+    // Tile cache of the scene
+    uint64_t tileCacheHits = 0;
+    uint64_t tileCacheMisses = 0;
+    uint64_t tileCacheEvictions = 0;
+
+    // Tiles in each stage of loading
+    uint32_t tilesLoading = 0;        // requested and not yet built
+    uint32_t tilesQueued = 0;         // waiting to be parsed
+    uint32_t tilesParsed = 0;         // parsed ahead, waiting to be built
+    uint32_t tilesUploadPending = 0;  // built, waiting for upload
+
+    // Tile workers
+    uint32_t tileWorkers = 0;
+    float workerUtilization = 0;  // share of worker time spent on tiles since the last call
+    uint32_t tilesBuilt = 0;
+    uint32_t tilesAborted = 0;    // builds of tiles canceled meanwhile
+    float parseTimeAverage = 0;
+    float buildTimeAverage = 0;
+    float buildTimeP95 = 0;       // upper bound of the histogram bucket holding it
+
+    // Heap allocations and requested bytes per parsed and per built tile; only counted in builds
+    // with TANGRAM_ALLOC_PROFILING, which sets allocProfiling
+    bool allocProfiling = false;
+    float parseAllocations = 0;
+    float parseAllocBytes = 0;
+    float buildAllocations = 0;
+    float buildAllocBytes = 0;
+
+    // ms from requesting a visible tile to adding it, for the tiles of the scene; percentiles are
+    // histogram bucket bounds, at most 250
+    uint32_t tilesCompleted = 0;
+    float tileLatencyAverage = 0;
+    float tileLatencyP50 = 0;
+    float tileLatencyP95 = 0;
+
+    // Bytes of all URL responses, and of those for the tiles of each tile source
+    uint64_t bytesDownloaded = 0;
+    std::vector<std::pair<std::string, uint64_t>> sourceBytesDownloaded;
+
+    // Labels of the last label update, and those of them visible
+    uint32_t labels = 0;
+    uint32_t visibleLabels = 0;
+
+    // Draw calls of the last frame
+    uint32_t drawCalls = 0;
+
+    // Memory of tiles in use, cached tiles, cached raw and parsed tile data, parsed tile data in
+    // use and selection properties, raster textures and their CPU pixel data, glyph textures,
+    // marker meshes, JS heaps and the scene configuration; and of the GPU buffers shared by tile
+    // meshes. Parsed data, properties and configuration are estimates.
+    size_t tileMemory = 0;
+    size_t tileCacheMemory = 0;
+    size_t dataCacheMemory = 0;
+    size_t tileDataCacheMemory = 0;
+    size_t tileDataMemory = 0;
+    size_t selectionMemory = 0;
+    size_t rasterMemory = 0;
+    size_t rasterBufferMemory = 0;
+    size_t glyphMemory = 0;
+    size_t markerMemory = 0;
+    size_t jsMemory = 0;
+    size_t sceneConfigMemory = 0;
+    size_t meshBufferMemory = 0;
+
+    // Histogram of render() times: frameTimeCounts[i] frames took up to frameTimeBounds[i], the
+    // last bucket counts the longer frames
+    std::vector<float> frameTimeBounds;
+    std::vector<uint32_t> frameTimeCounts;
+    float frameTimeAverage = 0;
+    float frameTimeP95 = 0;
+
+    // GPU ms per frame of each style and of the sky, selection and terrain depth passes, smoothed
+    // over frames; measured with Map::setGpuTiming() where the GL driver has timer queries
+    std::vector<std::pair<std::string, float>> gpuTimes;
+};
+
 class Map {
 
 public:
 
     // Create an empty map object. To display a map, call either loadScene() or loadSceneAsync().
     explicit Map(std::unique_ptr<Platform> _platform);
+
+    // Create an empty map object sharing tile workers and tile caches with the other Maps
+    // created with @_context, see MapContext
+    Map(std::unique_ptr<Platform> _platform, std::shared_ptr<MapContext> _context);
     ~Map();
 
     // Load the scene with the given SceneOptions
@@ -211,9 +310,21 @@ public:
     // get the View object
     View& getView();
 
-    // update global variables (only affects JS functions currently)
+    // update global variables (only affects JS functions currently); with _rebuildTiles
+    // only meshes of styles drawn by JS functions which read the changed globals are rebuilt
     void updateGlobals(const std::vector<SceneUpdate>& _sceneUpdates, bool _rebuildTiles = true);
 
+    // Set _key of the state of the feature with "id" property _featureId in the tile source
+    // with id _sourceId to _value, without rebuilding tiles: "color" replaces the color of the
+    // feature (a CSS color, empty to reset), "visible" hides it ("false") and "width" scales
+    // the width of lines. Applies to polygon and line styles of scenes loaded with
+    // SceneOptions::featureTables. Returns false for an unknown _key or invalid _value.
+    bool setFeatureState(int32_t _sourceId, const std::string& _featureId,
+                         const std::string& _key, const std::string& _value);
+
+    // Reset the state of all features
+    void clearFeatureStates();
+
     // Set listener for scene load events. The callback receives the SceneID
     // of the loaded scene and SceneError in case loading was not successful.
     // The callback may be be called from the main or worker thread.
@@ -224,6 +335,11 @@ public:
     // Initialize graphics resources; OpenGL context must be created prior to calling this
     void setupGL();
 
+    // Keep deflated copies of uploaded tile geometry and textures in memory, up to @_bytes shared
+    // by all maps, so that calling setupGL() again after the OpenGL context was lost uploads them
+    // again instead of loading the tiles; 0 disables (default)
+    void setRetainedDataBudget(size_t _bytes);
+
     // Resize the map view to a new width and height (in pixels)
     void resize(int _newWidth, int _newHeight);
 
@@ -237,6 +353,28 @@ public:
     // Render a new frame of the map view (if needed)
     void render();
 
+    // Render the scene into a target of lower resolution while the view moves and frames take
+    // longer than _frameTime seconds, down to _minScale of the view resolution, and scale it to
+    // the view; labels are drawn at full resolution over it. Once the view stops it is drawn at
+    // full resolution again. _frameTime 0 (the default) disables scaling.
+    void setDynamicResolution(float _frameTime, float _minScale = 0.5f);
+
+    // Request at most one frame per _seconds for tiles that finish loading (0.05 by default);
+    // tiles finishing within the interval are drawn together with the frame at its end. Tiles
+    // that are prefetched or no longer in view request no frame. 0 requests a frame per tile.
+    void setTileRenderInterval(float _seconds);
+
+    // Cap the frame rate at _fps frames per second, e.g. to save power: render() waits until
+    // 1 / _fps seconds have passed since the previous frame. 0 (the default) disables the cap.
+    void setMaxFrameRate(float _fps);
+
+    // Run updates on a thread of the Map instead of the caller of update() (false by default).
+    // update() then hands its time step to that thread and returns the state of the last
+    // complete update, while tile set updates, label placement and marker updates run off the
+    // GL thread, typically while it waits for the buffer swap. Updates and render() still
+    // exclude each other. The platform requests a render when an update changed the frame.
+    void setThreadedUpdate(bool _enabled);
+
     // Gets the viewport height in physical pixels (framebuffer size)
     int getViewportHeight();
 
@@ -257,6 +395,25 @@ public:
     // Each unsigned int corresponds to an RGBA pixel value
     void captureSnapshot(unsigned int* _data);
 
+    // Render the map for _camera into an offscreen image of _width x _height pixels and pass its
+    // pixels to _callback from render(). The image is rendered once the tiles of its view are
+    // loaded and labels have settled, i.e. when update() would return a complete view; without
+    // a display update() may be called with large steps to skip label fades. Requests are
+    // rendered in order, with the view moved to the camera of each meanwhile and restored after
+    // the last; pixels are read back asynchronously when the driver supports it, while the next
+    // image loads.
+    void renderToImage(const CameraPosition& _camera, int _width, int _height,
+                       ImageReadyCallback _callback);
+
+    // Capture the pixels of the next frame drawn by render() without waiting for the GPU and pass
+    // them to _callback from a later render(), typically one or two frames later. The rect of
+    // _width x _height pixels at _x, _y from the top left of the view is captured, or the whole
+    // view if _width or _height is 0; with a _scale below 1 it is downscaled on the GPU before
+    // it is read. Drivers without asynchronous readback read the pixels within the frame, at
+    // full scale.
+    void captureSnapshotAsync(ImageReadyCallback _callback, int _x = 0, int _y = 0,
+                              int _width = 0, int _height = 0, float _scale = 1.f);
+
     // Set the position of the map view in degrees longitude and latitude
     void setPosition(double _lon, double _lat);
 
@@ -389,12 +546,31 @@ public:
     // returns true if the marker ID was found and successfully updated, otherwise returns false.
     bool markerSetPointEased(MarkerID _marker, LngLat _lngLat, float _duration, EaseType _ease);
 
+    // Add _count point markers at _coordinates, all styled with _styling, a string of YAML for a draw
+    // rule or, if _isPath, a path to a draw rule in the current scene; _properties, if not null, points
+    // to the feature properties of each marker, which are moved from; the IDs of the new markers are
+    // written to _markers. Use this to add many markers at once, e.g. thousands of vehicle positions.
+    void markerAddPoints(const char* _styling, bool _isPath, const LngLat* _coordinates,
+                         Properties* _properties, int _count, MarkerID* _markers);
+
+    // Set the geometry of _count markers to points at _coordinates and set their feature properties if
+    // _properties is not null; moving a point marker keeps its mesh; returns the number of marker IDs
+    // that were found and updated.
+    int markerSetPoints(const MarkerID* _markers, const LngLat* _coordinates, Properties* _properties,
+                        int _count);
+
     // Set the geometry of a marker to a polyline along the given coordinates; _coordinates is a
     // pointer to a sequence of _count LngLats; markers can have their geometry set multiple times
     // with possibly different geometry types; returns true if the marker ID was found and
     // successfully updated, otherwise returns false.
     bool markerSetPolyline(MarkerID _marker, LngLat* _coordinates, int _count);
 
+    // Hide the start of a polyline marker up to _fraction of the way from the point at _index of its
+    // coordinates to the next, e.g. the part of a route already traveled, without rebuilding it; an
+    // _index < 0 shows the whole line; only applies to styles with texture coordinates (texcoords: true);
+    // returns true if the marker ID was found and is a polyline, otherwise returns false.
+    bool markerSetPolylineTrim(MarkerID _marker, int _index, float _fraction);
+
     // Set the geometry of a marker to a polygon with the given coordinates; _counts is a pointer
     // to a sequence of _rings integers and _coordinates is a pointer to a sequence of LngLats with
     // a total length equal to the sum of _counts; for each integer n in _counts, a polygon is created
@@ -487,9 +663,19 @@ public:
     // Set the radius in logical pixels to use when picking features on the map (default is 0.5).
     void setPickRadius(float _radius);
 
+    // Set how many seconds ahead of an ongoing fling or camera animation tiles are loaded, so
+    // that they are ready when they come into view (default is 0.5, 0 disables prefetching).
+    void setTilePrefetchTime(float _seconds);
+
+    // Set how coarse the tiles far from the camera of a tilted view may get: tiles are selected at
+    // the zoom where they cover at most this many tile sizes on screen (default is 2). Larger values
+    // load fewer, lower zoom tiles towards the horizon.
+    void setTileLodScale(float _scale);
+
     // Create a query to select a feature marked as 'interactive'. The query runs on the next frame.
     // Calls _onFeaturePickCallback once the query has completed, and returns the FeaturePickResult
-    // with its associated properties or null if no feature was found.
+    // with its associated properties or null if no feature was found. With SceneOptions::cpuPicking
+    // the feature is picked from the geometry of the tiles and the callback is called at once.
     void pickFeatureAt(float _x, float _y, FeaturePickCallback _onFeaturePickCallback);
 
     // Create a query to select a label created for a feature marked as 'interactive'. The query runs
@@ -500,19 +686,46 @@ public:
 
     // Create a query to select a marker that is 'interactive'. The query runs on the next frame.
     // Calls _onLMarkerPickCallback once the query has completed, and returns the MarkerPickResult
-    // with its associated properties or null if no marker was found.
+    // with its associated properties or null if no marker was found. Markers whose geometry is within
+    // the pick radius - lines, polygons or the anchor of points - are returned at once.
     void pickMarkerAt(float _x, float _y, MarkerPickCallback _onMarkerPickCallback);
 
+    // Query terrain elevation at _points, e.g. for the profile of a track or to place markers on the
+    // terrain. Elevation is sampled from loaded tiles of zoom _zoom or their ancestors, or of the highest
+    // loaded zoom if _zoom is negative. The points are grouped by tile when called and sampled on a worker
+    // thread, which then calls _callback.
+    void queryElevations(std::vector<LngLat> _points, int _zoom, ElevationCallback _callback);
+
     // Run this task asynchronously to Tangram's main update loop.
     void runAsyncTask(std::function<void()> _task);
 
     // Send a signal to Tangram that the platform received a memory warning
-    void onMemoryWarning();
+    void onMemoryWarning(MemoryWarningLevel _level = MemoryWarningLevel::complete);
+
+    // Set a budget in bytes for tiles, raw and parsed tile data caches, raster textures, glyph
+    // textures and markers; caches are limited to what remains after visible content (0, the
+    // default, disables the budget)
+    void setMemoryBudget(size_t _bytes);
 
     // Sets an opaque default background color used as default color when a scene is being loaded
     // r, g, b must be between 0.0 and 1.0
     void setDefaultBackgroundColor(float r, float g, float b);
 
+    // Get counters of tile loading, labels, drawing and memory; they are kept in release builds
+    PerformanceStats getPerformanceStats();
+
+    // Measure the GPU time of styles and render passes with GL timer queries, for
+    // PerformanceStats::gpuTimes (off by default, also on with DebugFlags::tangram_infos)
+    void setGpuTiming(bool _enabled);
+
+    // Record the time steps of update(), the following calls of the camera, gesture, marker and
+    // scene methods and the URL responses, to replay the session deterministically, e.g. with
+    // tangram-replay. The recording starts with the current viewport, scene and camera.
+    void startRecording();
+
+    // Stop recording; returns the recording, see SessionRecording::load()
+    std::string stopRecording();
+
     Platform& getPlatform();
 
 protected:
@@ -521,6 +734,18 @@ protected:
 
 private:
 
+    // Update the frame state, on the calling thread or the update thread
+    MapState updateFrame(float _dt);
+
+    // Loop of the update thread, see setThreadedUpdate()
+    void runUpdateThread();
+
+    // Render the next image requested by renderToImage() and start reading its pixels
+    void renderImage();
+
+    // Start reading the snapshots requested by captureSnapshotAsync() from the drawn frame
+    void captureSnapshots();
+
     class Impl;
     std::unique_ptr<Impl> impl;
 
@@ -548,4 +773,11 @@ bool getDebugFlag(DebugFlags _flag);
 // Toggle the boolean state of a debug feature (see debug.h)
 void toggleDebugFlag(DebugFlags _flag);
 
+// Start recording trace events of the map threads, keeping the last _eventsPerThread of each thread
+void startTracing(size_t _eventsPerThread = 1 << 16);
+
+// Stop recording trace events; returns them as Chrome trace JSON, which chrome://tracing and
+// ui.perfetto.dev open
+std::string stopTracing();
+
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Tangram {
+
+class TileDataCache;
+class TileWorker;
+struct RawCache;
+
+/*
+ * MapContext - Resources shared by several Maps, e.g. a main map, an overview map and a widget
+ *
+ * Maps created with the same MapContext share:
+ * - the tile worker threads, which take turns between the Scenes of all Maps;
+ * - the in-memory caches of raw tile data of sources loading the same url;
+ * - parsed tiles of sources loading the same url with the same layers and properties, which
+ *   are neither loaded nor parsed again by the other Maps, nor when tiles are rebuilt.
+ *
+ * A Map created without a MapContext has one of its own, so that these caches are kept when
+ * it loads another Scene with the same sources, e.g. to switch themes.
+ *
+ * Fonts and glyph atlases stay with each Map, as their textures belong to its GL context and
+ * pixel scale; network requests go through the Platform of each Map.
+ */
+class MapContext {
+
+public:
+
+    // @_numTileWorkers: threads building tiles for all Maps, overriding SceneOptions::numTileWorkers
+    // @_sharedTiles: number of parsed tiles kept for the other Maps
+    explicit MapContext(uint32_t _numTileWorkers = 2, uint32_t _sharedTiles = 64);
+    ~MapContext();
+
+    MapContext(const MapContext&) = delete;
+    MapContext& operator=(const MapContext&) = delete;
+
+    uint32_t numTileWorkers() const { return m_numTileWorkers; }
+
+    // Set the number of parsed tiles kept for the other Maps; 0 disables sharing them
+    void setSharedTiles(uint32_t _sharedTiles);
+
+    // Set the bytes of parsed tiles kept, as estimated; limited along with the number of tiles.
+    // Map::setMemoryBudget() overrides it with a share of the budget.
+    void setSharedTilesSize(size_t _bytes);
+
+    /* Used by Map and Scene */
+
+    std::shared_ptr<TileWorker> tileWorker();
+
+    // Raw tile cache for sources with the identity @_source, i.e. their url and request
+    // options; created on first use
+    std::shared_ptr<RawCache> rawCache(const std::string& _source, bool _compress);
+
+    // Drop the raw caches that no source uses any more; called when a Scene has created its
+    // sources, so that the caches of the previous Scene are found by the next one
+    void releaseUnusedCaches();
+
+    const std::shared_ptr<TileDataCache>& tileDataCache() const { return m_tileDataCache; }
+
+private:
+
+    uint32_t m_numTileWorkers;
+
+    std::mutex m_mutex;
+
+    // Started with the first Scene
+    std::shared_ptr<TileWorker> m_tileWorker;
+
+    // Kept until releaseUnusedCaches() after the last source using them is gone
+    std::unordered_map<std::string, std::shared_ptr<RawCache>> m_rawCaches;
+
+    std::shared_ptr<TileDataCache> m_tileDataCache;
+
+};
+
+}
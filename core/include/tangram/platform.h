@@ -4,6 +4,7 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -24,15 +25,31 @@ using UrlRequestHandle = uint64_t;
 struct UrlResponse {
     std::vector<char> content;
     const char* error = nullptr;
+    // HTTP status code, 0 if not known or not an HTTP request
+    int status = 0;
 };
 
 // Function type for receiving data from a URL request.
 using UrlCallback = std::function<void(UrlResponse&&)>;
 
 struct HttpOptions {
+    // Scheduling hint for platforms that order or weight concurrent requests
+    enum class Priority : uint8_t { low, normal, high };
+
     HttpOptions(const char* hdrs = "", const char* post = "") : headers(hdrs), payload(post) {}
     std::string headers;  // put all headers in single string separated by newlines for now
     std::string payload;  // implies POST if not empty
+    Priority priority = Priority::normal;
+    // Order among requests of the same priority in [0, 1], higher first
+    float weight = 0.5f;
+    // Inflate a gzip body sent without Content-Encoding, e.g. a pre-compressed tile, where the
+    // platform supports it; partial responses to range requests are never inflated
+    bool inflateGzip = false;
+
+    // Priority and weight combined in [0, 1], higher first; e.g. for NSURLSessionTask.priority
+    float relativePriority() const {
+        return (float(priority) + (weight < 0.f ? 0.f : weight > 1.f ? 1.f : weight)) / 3.f;
+    }
 
     void addHeader(const std::string& hdr, const std::string& val) {
         assert(hdr.size() && hdr.back() != ':' && hdr.back() != ' ' && val.size());
@@ -68,6 +85,19 @@ struct FontSourceHandle {
     bool isValid() const { return tag != None; }
 };
 
+// Read-only memory of a resource, valid while the object lives, see Platform::mapResource()
+class MappedResource {
+public:
+    virtual ~MappedResource() {}
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+protected:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
+
 // Platform-specific function for logging to console
 void logStr(const std::string& msg);
 
@@ -105,19 +135,37 @@ public:
     // finished, the callback _callback will be run with the data or error that
     // was retrieved from the URL _url. The callback may run on a different
     // thread than the original call to startUrlRequest.
+    // Requests without payload for the same URL and headers as a request that
+    // is still running share its transfer; each gets its own handle and copy of
+    // the response.
     UrlRequestHandle startUrlRequest(Url _url, UrlCallback&& _callback);
 
     UrlRequestHandle startUrlRequest(Url _url, const HttpOptions& _options, UrlCallback&& _callback);
 
     // Stop retrieving data from a URL that was previously requested. When a
     // request is canceled its callback will still be run, but the response
-    // will have an error string and the data may not be complete.
+    // will have an error string and the data may not be complete. A shared
+    // transfer is only stopped when all of its requests are canceled.
     void cancelUrlRequest(UrlRequestHandle _request);
 
+    // Change the priority and weight of a running request, e.g. when the view moved. A transfer
+    // shared by several requests takes the last update.
+    void updateUrlRequestPriority(UrlRequestHandle _request, const HttpOptions& _options);
+
+    // Map the local resource at _url, a file or a resource bundled with the app, read-only into
+    // memory without copying it; returns nullptr when it cannot be mapped. Files are mapped by
+    // default. May be called from any thread.
+    virtual std::shared_ptr<MappedResource> mapResource(const Url& _url) const;
+
     virtual FontSourceHandle systemFont(const std::string& _name, const std::string& _weight, const std::string& _face) const;
 
     virtual std::vector<FontSourceHandle> systemFontFallbacksHandle() const;
 
+    // Observe the URL and response of each completed transfer before its callbacks run, e.g. to
+    // record a session; pass an empty function to stop. Runs on the thread of the response.
+    using UrlResponseObserver = std::function<void(const std::string& _url, const UrlResponse& _response)>;
+    void setUrlResponseObserver(UrlResponseObserver _observer);
+
     size_t activeUrlRequests() const { return m_urlCallbacks.size(); }
     void notifyStorage(int64_t dtot, int64_t doffl) const { if(onNotifyStorage) onNotifyStorage(dtot, doffl); }
 
@@ -145,6 +193,9 @@ protected:
     // Return true when UrlRequestId has been set (i.e. when request is async and can be canceled)
     virtual bool startUrlRequestImpl(const Url& _url, const HttpOptions& _options, UrlRequestHandle _request, UrlRequestId& _id) = 0;
 
+    // Called with HttpOptions::relativePriority() when it changes; no-op by default
+    virtual void updateUrlRequestPriorityImpl(UrlRequestId _id, float _relativePriority) {}
+
     static bool bytesFromFileSystem(const char* _path, std::function<char*(size_t)> _allocator);
 
     std::atomic_bool m_shutdown{false};
@@ -152,12 +203,25 @@ protected:
     bool m_continuousRendering;
 
     std::mutex m_callbackMutex;
+    // Transfer started by startUrlRequestImpl, keyed by handle of the first request
     struct UrlRequestEntry {
-        UrlCallback callback;
+        // handles and callbacks of requests sharing the transfer
+        std::vector<std::pair<UrlRequestHandle, UrlCallback>> callbacks;
         UrlRequestId id;
         bool cancelable;
+        // URL and headers, empty when the transfer is not shared
+        std::string key;
+        // HttpOptions::relativePriority() last passed to the implementation
+        float relativePriority;
+        // URL, only kept while a response observer is set
+        std::string url;
     };
     std::unordered_map<UrlRequestHandle, UrlRequestEntry> m_urlCallbacks;
+    // Transfer of each request handle
+    std::unordered_map<UrlRequestHandle, UrlRequestHandle> m_urlRequests;
+    // Shareable transfers by key
+    std::unordered_map<std::string, UrlRequestHandle> m_urlTransfers;
+    UrlResponseObserver m_urlResponseObserver;
     std::atomic_uint_fast64_t m_urlRequestCount = {0};
     mutable std::atomic_bool m_renderRequested{false};
 };
@@ -19,6 +19,12 @@ struct SceneUpdate {
     SceneUpdate() {}
 };
 
+enum class TileCachePolicy {
+    lru,         // evict least recently used tiles
+    adaptive,    // keep tiles of frequently revisited areas while panning far away
+    rebuildCost, // prefer evicting tiles that are cheap to rebuild
+};
+
 
 class SceneOptions {
 public:
@@ -62,21 +68,88 @@ public:
     /// Number of threads fetching tiles
     uint32_t numTileWorkers = 2;
 
+    /// Choose the number of tile workers from the CPU cores of the device instead of
+    /// numTileWorkers: the performance cores on devices with cores of different speeds, less
+    /// one for the render thread, between two and four
+    bool autoTileWorkers = false;
+
+    /// Keep tile workers on the performance cores on devices with cores of different speeds.
+    /// Only supported on Linux and Android.
+    bool pinTileWorkers = false;
+
+    /// Number of threads projecting labels to the screen together with the render thread,
+    /// when there are many labels; 0 projects them on the render thread only
+    uint32_t numLabelWorkers = 0;
+
     /// 16MB default in-memory DataSource cache
     size_t memoryTileCacheSize = CACHE_SIZE;
 
+    /// keep tile data deflated in the in-memory DataSource cache
+    bool memoryTileCacheCompressed = false;
+
+    /// Eviction policy for the in-memory cache of built tiles
+    TileCachePolicy tileCachePolicy = TileCachePolicy::lru;
+
     /// persistent MBTiles DataSource cache
     size_t diskTileCacheSize = 0;
 
     /// default max-age (in seconds) for disk tile cache
     int64_t diskTileCacheMaxAge = 180*24*60*60;  // 180 days in seconds
 
+    /// show expired tiles of the disk tile cache while requesting them again in the background,
+    /// instead of waiting for the request; tiles are rebuilt only if their data changed
+    bool diskTileCacheRevalidate = false;
+
     /// cache directory for tiles, fonts, etc
     std::string diskCacheDir;
 
+    /// persist built meshes of vector tiles in diskCacheDir, expiring after diskTileCacheMaxAge
+    bool diskMeshCache = false;
+
+    /// keep the resolved scene config in diskCacheDir and use it instead of merging the scene
+    /// files again while they are unchanged
+    bool sceneSnapshot = false;
+
+    /// complete the scene before its fonts and sprite textures are loaded: tiles are built
+    /// without the text and point styles until these arrive and are then rebuilt for them
+    bool progressiveLoading = false;
+
+    /// keep binaries of linked shader programs in diskCacheDir, when supported by the GL driver
+    bool programCache = false;
+
+    /// milliseconds and bytes per frame for uploading newly built tiles; tiles beyond the budget
+    /// are uploaded in later frames and shown by their proxies until then (0 is unlimited)
+    float uploadBudgetTime = 0;
+    size_t uploadBudgetBytes = 0;
+
+    /// keep raster tiles in layers of shared texture arrays when supported by the GL driver
+    /// (GL 3), so that tiles of a raster source bind the same texture; shaders of the scene
+    /// must sample rasters with sampleRaster() and sampleRasterAtPixel()
+    bool rasterTextureArrays = false;
+
+    /// read the colors and selection colors of polygon and line features from a table per
+    /// tile mesh instead of storing them in each vertex, so that they can be changed without
+    /// building the tile again; needs texture sampling in vertex shaders
+    bool featureTables = false;
+
+    /// build an index of the geometry of interactive features with each tile, so that
+    /// Map::pickFeatureAt() is answered at once from it instead of by rendering the selection
+    /// buffer; point features are only hit within the pick radius of their position
+    bool cpuPicking = false;
+
+    /// draw distant tiles of tilted views, which cover few pixels, as quads textured with an
+    /// image of the tile rendered from above instead of by each style; text, points and animated
+    /// styles are still drawn by their styles. Not used with 3D terrain.
+    bool tileImpostors = false;
+
     /// global fallback fonts
     std::vector<FontSourceHandle> fallbackFonts;
 
+    /// prebuilt glyph packs, mapped at startup so that their glyphs are not rendered again;
+    /// built by tangram-glyphpack for the names fonts are loaded with (fallback fonts are
+    /// "default_400_regular", "default-1", ...)
+    std::vector<FontSourceHandle> glyphPacks;
+
 private:
     static constexpr size_t CACHE_SIZE = 16 * (1024 * 1024);
 
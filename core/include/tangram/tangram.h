@@ -21,4 +21,5 @@
 #include "util/variant.h"
 #include "log.h"
 #include "map.h"
+#include "mapContext.h"
 #include "platform.h"
@@ -7,10 +7,11 @@
 
 /* An immutable identifier for a map tile
  *
- * Contains the x, y, and z indices of a tile in a quad tree; TileIDs are ordered by:
- * 1. z, highest to lowest
- * 2. x, lowest to highest
- * 3. y, lowest to highest
+ * Contains the x, y, and z indices of a tile in a quad tree; TileIDs are ordered by key():
+ * 1. s, highest to lowest
+ * 2. z, highest to lowest
+ * 3. x, lowest to highest
+ * 4. y, lowest to highest
  */
 
 namespace Tangram {
@@ -28,9 +29,19 @@ struct TileID {
 
     TileID(const TileID& _rhs) = default;
 
-    bool operator< (const TileID& _rhs) const {
-        return s > _rhs.s || (s == _rhs.s && (z > _rhs.z || (z == _rhs.z && (x < _rhs.x || (x == _rhs.x && (y < _rhs.y))))));
+    // Highest data zoom whose x and y fit into key()
+    static constexpr int MAX_KEY_ZOOM = 25;
+
+    /* Canonical 64 bit key of a valid TileID with z up to MAX_KEY_ZOOM, in the order of TileIDs:
+     * 7 bits for 126 - s, 7 bits for 126 - z, then MAX_KEY_ZOOM bits each for x and y, so that
+     * NOT_A_TILE (s = -1) comes after all tiles */
+    uint64_t key() const {
+        assert(z <= MAX_KEY_ZOOM);
+        return (uint64_t((126 - s) & 0x7F) << 57) | (uint64_t((126 - z) & 0x7F) << 50) |
+               (uint64_t(uint32_t(x) & KEY_INDEX_MASK) << MAX_KEY_ZOOM) | (uint32_t(y) & KEY_INDEX_MASK);
     }
+
+    bool operator< (const TileID& _rhs) const { return key() < _rhs.key(); }
     bool operator> (const TileID& _rhs) const { return _rhs < const_cast<TileID&>(*this); }
     bool operator<=(const TileID& _rhs) const { return !(*this > _rhs); }
     bool operator>=(const TileID& _rhs) const { return !(*this < _rhs); }
@@ -96,6 +107,10 @@ struct TileID {
         return std::to_string(x) + "/" + std::to_string(y) + "/" + std::to_string(z) + "/" + std::to_string(s);
     }
 
+private:
+
+    static constexpr uint32_t KEY_INDEX_MASK = (1u << MAX_KEY_ZOOM) - 1;
+
 };
 
 static const TileID NOT_A_TILE(-1, -1, -1, -1);
@@ -4,6 +4,7 @@
 #include "platform.h" // UrlRequestHandle
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -63,10 +64,49 @@ public:
     void setProxyState(bool isProxy) { m_proxyState = isProxy; }
     bool isProxy() const { return m_proxyState; }
 
+    // Prefetch tasks load tiles that are not yet visible; they are built after all visible tiles
+    void setPrefetchState(bool isPrefetch) { m_prefetchState = isPrefetch; }
+    bool isPrefetch() const { return m_prefetchState; }
+
+    // Coarse tasks build extrusions with less detail, for tiles far from the camera in a tilted view
+    void setCoarse(bool _coarse) { m_coarse = _coarse; }
+    bool isCoarse() const { return m_coarse; }
+
     auto& subTasks() { return m_subTasks; }
 
-    // running on worker thread
-    virtual void process(TileBuilder& _tileBuilder);
+    // Rebuild only the meshes of @_styles (by Style ID) from the TileData kept by @_tile; complete()
+    // takes the other meshes from @_tile. The task needs no loading or parsing.
+    void setRebuild(std::shared_ptr<Tile> _tile, std::vector<bool> _styles);
+    bool isRebuild() const { return bool(m_rebuildTile); }
+
+    // running on worker thread - parse() then build()
+    void process(TileBuilder& _tileBuilder);
+
+    // running on worker thread: decode raw data, independent of Scene styles
+    virtual void parse();
+    bool isParsed() const { return m_parsed; }
+
+    // Set TileData parsed for another task, e.g. of the same data tile at another styling zoom
+    void setTileData(std::shared_ptr<TileData> _tileData);
+
+    // milliseconds spent in parse(), set by TileWorker
+    float parseTime() const { return m_parseTime; }
+    void setParseTime(float _ms) { m_parseTime = _ms; }
+
+    // id linking the trace events of the tile stages, 0 when created while not tracing
+    uint64_t traceId() const { return m_traceId; }
+
+    // milliseconds since the task was created
+    float age() const {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_created).count();
+    }
+
+    // running on worker thread after parse(): build tile geometry with TileBuilder
+    virtual void build(TileBuilder& _tileBuilder);
+
+    // running on worker thread before parse(): take tile from the TileDiskCache of the Scene;
+    // returns true when the tile is ready, otherwise build() only builds the styles not stored
+    bool restore(TileBuilder& _tileBuilder);
 
     // running on main thread when the tile is added to
     virtual void complete();
@@ -102,15 +142,30 @@ protected:
     const int64_t m_sourceId;
     const int64_t m_sourceGeneration;
 
+    // Result of parse(), released after build()
+    std::shared_ptr<TileData> m_tileData;
+
     // Tile result, set when tile is successfully created
     std::unique_ptr<Tile> m_tile;
 
+    // Tile of which styles are rebuilt and styles to rebuild, see setRebuild() and restore()
+    std::shared_ptr<Tile> m_rebuildTile;
+    std::vector<bool> m_rebuildStyles;
+
+    float m_parseTime = 0;
+
+    const uint64_t m_traceId;
+    const std::chrono::steady_clock::time_point m_created;
+
+    std::atomic<bool> m_parsed;
     std::atomic<bool> m_ready;
     std::atomic<bool> m_canceled;
     std::atomic<bool> m_needsLoading;
 
     std::atomic<float> m_priority;
     std::atomic<bool> m_proxyState;
+    std::atomic<bool> m_prefetchState;
+    std::atomic<bool> m_coarse;
 };
 
 class BinaryTileTask : public TileTask {
@@ -119,17 +174,22 @@ public:
         : TileTask(_tileId, _source) {}
 
     virtual bool hasData() const override {
-        return rawTileData && !rawTileData->empty();
+        return (rawTileData && !rawTileData->empty()) || isParsed();
     }
     // Raw tile data that will be processed by TileSource.
     std::shared_ptr<std::vector<char>> rawTileData;
+    // Compressed form of rawTileData as received from a DataSource, if it was inflated
+    std::shared_ptr<std::vector<char>> compressedTileData;
 
     bool dataFromCache = false;
-    UrlRequestHandle urlRequestHandle = 0;
+    // Set by the loading thread, read when the task is canceled or its priority changes
+    std::atomic<UrlRequestHandle> urlRequestHandle{0};
 };
 
 struct TileTaskQueue {
     virtual void enqueue(std::shared_ptr<TileTask> task) = 0;
+    // Called after the priorities of queued tasks were updated, see TileTask::setPriority()
+    virtual void updatePriorities() {}
 };
 
 struct TileTaskCb {
@@ -4,31 +4,54 @@ MODULE_BASE = $(MAKE_BASE)
 
 MODULE_SOURCES = \
   src/map.cpp                         \
+  src/mapContext.cpp                  \
   src/platform.cpp                    \
   src/data/clientDataSource.cpp       \
+  src/data/clusterSource.cpp          \
+  src/data/cogDataSource.cpp          \
   src/data/memoryCacheDataSource.cpp  \
   src/data/networkDataSource.cpp      \
   src/data/properties.cpp             \
+  src/data/rasterCache.cpp            \
   src/data/rasterSource.cpp           \
+  src/data/requestLimiter.cpp         \
+  src/data/tileData.cpp               \
+  src/data/tileDataCache.cpp          \
+  src/data/tileLoad.cpp               \
   src/data/tileSource.cpp             \
   src/data/formats/geoJson.cpp        \
+  src/data/formats/geoJsonStream.cpp  \
+  src/data/formats/mlt.cpp            \
   src/data/formats/mvt.cpp            \
   src/data/formats/topoJson.cpp       \
+  src/debug/allocCounter.cpp          \
   src/debug/frameInfo.cpp             \
+  src/debug/sessionRecording.cpp      \
   src/debug/textDisplay.cpp           \
+  src/debug/trace.cpp                 \
+  src/gl/bufferPool.cpp               \
   src/gl/framebuffer.cpp              \
+  src/gl/frameUniforms.cpp            \
   src/gl/glError.cpp                  \
   src/gl/glyphTexture.cpp             \
+  src/gl/gpuTimer.cpp                 \
   src/gl/hardware.cpp                 \
   src/gl/mesh.cpp                     \
+  src/gl/pixelReadback.cpp            \
   src/gl/primitives.cpp               \
+  src/gl/programCache.cpp             \
   src/gl/renderState.cpp              \
+  src/gl/retainedData.cpp             \
   src/gl/shaderProgram.cpp            \
   src/gl/shaderSource.cpp             \
   src/gl/texture.cpp                  \
+  src/gl/textureArrayPool.cpp         \
   src/gl/vao.cpp                      \
   src/gl/vertexLayout.cpp             \
+  src/labels/collisionCache.cpp       \
+  src/labels/collisionGrid.cpp        \
   src/labels/curvedLabel.cpp          \
+  src/labels/curvedLayout.cpp         \
   src/labels/label.cpp                \
   src/labels/labelCollider.cpp        \
   src/labels/labelProperty.cpp        \
@@ -37,28 +60,36 @@ MODULE_SOURCES = \
   src/labels/spriteLabel.cpp          \
   src/labels/textLabel.cpp            \
   src/marker/marker.cpp               \
+  src/marker/markerAtlas.cpp          \
   src/marker/markerManager.cpp        \
   src/scene/ambientLight.cpp          \
   src/scene/dataLayer.cpp             \
   src/scene/directionalLight.cpp      \
   src/scene/drawRule.cpp              \
+  src/scene/featureStates.cpp         \
   src/scene/filters.cpp               \
   src/scene/importer.cpp              \
   src/scene/light.cpp                 \
   src/scene/pointLight.cpp            \
+  src/scene/renderQueue.cpp           \
   src/scene/scene.cpp                 \
   src/scene/sceneLayer.cpp            \
   src/scene/sceneLoader.cpp           \
+  src/scene/sceneSnapshot.cpp         \
   src/scene/spotLight.cpp             \
   src/scene/spriteAtlas.cpp           \
   src/scene/stops.cpp                 \
   src/scene/styleContext.cpp          \
+  src/scene/styleExpression.cpp       \
   src/scene/styleMixer.cpp            \
   src/scene/styleParam.cpp            \
+  src/scene/tileImpostors.cpp         \
   src/selection/featureSelection.cpp  \
+  src/selection/pickIndex.cpp         \
   src/selection/selectionQuery.cpp    \
   src/style/debugStyle.cpp            \
   src/style/debugTextStyle.cpp        \
+  src/style/featureTable.cpp          \
   src/style/material.cpp              \
   src/style/pointStyle.cpp            \
   src/style/pointStyleBuilder.cpp     \
@@ -70,26 +101,54 @@ MODULE_SOURCES = \
   src/style/textStyleBuilder.cpp      \
   src/style/contourTextStyle.cpp      \
   src/text/fontContext.cpp            \
+  src/text/glyphPack.cpp              \
+  src/text/textLayoutCache.cpp        \
   src/text/textUtil.cpp               \
   src/tile/tile.cpp                   \
+  src/tile/tileAvailability.cpp       \
   src/tile/tileBuilder.cpp            \
+  src/tile/tileCache.cpp              \
+  src/tile/tileDiskCache.cpp          \
   src/tile/tileManager.cpp            \
   src/tile/tileTask.cpp               \
+  src/tile/tileUploader.cpp           \
   src/tile/tileWorker.cpp             \
+  src/util/arena.cpp                  \
   src/util/builders.cpp               \
+  src/util/clip.cpp                   \
+  src/util/contourLines.cpp           \
   src/util/dashArray.cpp              \
+  src/util/dashAtlas.cpp              \
   src/util/elevationManager.cpp       \
+  src/util/elevationPyramid.cpp       \
   src/util/extrude.cpp                \
   src/util/floatFormatter.cpp         \
   src/util/geom.cpp                   \
+  src/util/geoTiff.cpp                \
   src/util/inputHandler.cpp           \
+  src/util/internTable.cpp            \
+  src/util/ioExecutor.cpp             \
   src/util/jobQueue.cpp               \
   src/util/json.cpp                   \
+  src/util/lineMerger.cpp             \
   src/util/mapProjection.cpp          \
+  src/util/mappedFile.cpp             \
+  src/util/memoryGovernor.cpp         \
+  src/util/normalMap.cpp              \
+  src/util/objectPool.cpp             \
+  src/util/pixelBufferPool.cpp        \
+  src/util/renderScheduler.cpp        \
+  src/util/resolutionScaler.cpp       \
+  src/util/simplify.cpp               \
   src/util/skyManager.cpp             \
   src/util/stbImage.cpp               \
+  src/util/textureCompression.cpp     \
+  src/util/threadPlacement.cpp        \
+  src/util/triangulationCache.cpp     \
   src/util/url.cpp                    \
   src/util/util.cpp                   \
+  src/util/vertexCache.cpp            \
+  src/util/workerPool.cpp             \
   src/util/wuffs.c                    \
   src/util/yamlPath.cpp               \
   src/util/yamlUtil.cpp               \
@@ -101,6 +160,7 @@ MODULE_SOURCES = \
 
 MODULE_SOURCES += src/js/DuktapeContext.cpp
 MODULE_SOURCES += src/data/mbtilesDataSource.cpp
+MODULE_SOURCES += src/data/offlineDownloader.cpp
 
 MODULE_INC_PUBLIC = include/tangram src
 MODULE_INC_PRIVATE = generated
@@ -3,8 +3,10 @@ precision highp float;
 #endif
 
 uniform mat4 u_model;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform mat4 u_view;
 uniform mat4 u_proj;
+#endif
 
 attribute vec4 a_position;
 attribute vec4 a_color;
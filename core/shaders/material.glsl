@@ -53,7 +53,9 @@ struct Material {
 };
 
 // Note: uniform is copied to a global instance to allow modification
+#ifndef TANGRAM_MATERIAL_CONSTANT
 uniform Material u_material;
+#endif
 Material material;
 
 #ifdef TANGRAM_MATERIAL_EMISSION_TEXTURE
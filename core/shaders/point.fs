@@ -10,11 +10,13 @@ precision highp float;
 #pragma tangram: defines
 
 uniform vec4 u_tile_origin;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform vec3 u_map_position;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
+#endif
 
 #pragma tangram: uniforms
 
@@ -24,6 +26,7 @@ varying float v_alpha;
 varying float v_aa_factor;
 varying vec2 v_edge;
 varying vec4 v_outline_color;
+varying vec2 v_sdf_edges;
 
 
 uniform sampler2D u_tex;
@@ -58,6 +61,18 @@ void main(void) {
         }
 
         color.a = mix(color.a, 0., (smoothstep(max(1. - v_aa_factor, 0.), 1., point_dist)));
+    } else if (u_sprite_mode == 2) {
+        // Distance field tinted with the fill color, v_aa_factor is the distance of one pixel
+        float signed_distance = texture2D(u_tex, v_texcoords).r;
+        float fill = smoothstep(v_sdf_edges.x - v_aa_factor, v_sdf_edges.x + v_aa_factor, signed_distance);
+
+        if (v_outline_color.a > 0.0) {
+            float outline = smoothstep(v_sdf_edges.y - v_aa_factor, v_sdf_edges.y + v_aa_factor, signed_distance);
+            color = mix(v_outline_color, color, fill);
+            color.a *= outline;
+        } else {
+            color.a *= fill;
+        }
     } else {
         color *= texture2D(u_tex, v_texcoords);
     }
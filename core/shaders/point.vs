@@ -13,12 +13,21 @@ uniform LOWP int u_sprite_mode;
 
 #pragma tangram: uniforms
 
+#ifdef TANGRAM_INSTANCED_SPRITES
+attribute vec2 a_corner;
+attribute vec4 a_center;
+attribute vec4 a_axis_x;
+attribute vec4 a_axis_y;
+attribute vec4 a_uv_rect;
+#else
 attribute vec2 a_uv;
+attribute vec4 a_position;
+#endif
 attribute LOWP float a_alpha;
 attribute LOWP vec4 a_color;
-attribute vec4 a_position;
 attribute vec4 a_outline_color;
 attribute float a_aa_factor;
+attribute vec2 a_sdf_edges;
 
 #ifdef TANGRAM_FEATURE_SELECTION
 attribute vec4 a_selection_color;
@@ -31,6 +40,7 @@ varying float v_aa_factor;
 varying vec2 v_edge;
 varying vec4 v_outline_color;
 varying float v_alpha;
+varying vec2 v_sdf_edges;
 
 #pragma tangram: global
 
@@ -48,14 +58,23 @@ void main() {
     }
 #endif
 
+#ifdef TANGRAM_INSTANCED_SPRITES
+    vec2 uv = mix(a_uv_rect.xy, a_uv_rect.zw, a_corner * 0.5 + 0.5);
+    vec4 position = a_center + a_corner.x * a_axis_x + a_corner.y * a_axis_y;
+#else
+    vec2 uv = a_uv;
+    vec4 position = a_position;
+#endif
+
     if (u_sprite_mode == 0) {
-        v_texcoords = sign(a_uv);
-        v_edge = abs(a_uv);
+        v_texcoords = sign(uv);
+        v_edge = abs(uv);
     } else {
-        v_texcoords = a_uv;
+        v_texcoords = uv;
     }
     v_outline_color = a_outline_color;
     v_aa_factor = a_aa_factor;
+    v_sdf_edges = a_sdf_edges;
 
-    gl_Position = a_position;
+    gl_Position = position;
 }
@@ -7,16 +7,18 @@ precision highp float;
 #pragma tangram: defines
 
 uniform mat4 u_model;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform mat4 u_view;
 uniform mat4 u_proj;
 uniform mat3 u_normal_matrix;
-uniform vec4 u_tile_origin;
 uniform vec3 u_map_position;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
 uniform mat3 u_inverse_normal_matrix;
+#endif
+uniform vec4 u_tile_origin;
 
 #pragma tangram: uniforms
 
@@ -7,26 +7,36 @@ precision highp float;
 #pragma tangram: defines
 
 uniform mat4 u_model;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform mat4 u_view;
 uniform mat4 u_proj;
 uniform mat3 u_normal_matrix;
-uniform vec4 u_tile_origin;
 uniform vec3 u_map_position;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
+#endif
+uniform vec4 u_tile_origin;
 uniform float u_proxy_depth;
 
 #pragma tangram: uniforms
 
 #ifdef TANGRAM_RASTER_STYLE
     uniform float u_order;
-    attribute vec2 a_position;
+    // Depth in meters of terrain skirts, i.e. of vertices with a_position.z = 1
+    uniform float u_skirt;
+    attribute vec4 a_position;
 #else
     attribute vec4 a_position;
-    attribute vec4 a_color;
-    attribute vec3 a_normal;
+    #ifdef TANGRAM_FEATURE_TABLE
+        attribute vec2 a_feature;
+    #else
+        attribute vec4 a_color;
+    #endif
+    #ifndef TANGRAM_NO_NORMALS
+        attribute vec3 a_normal;
+    #endif
 
     varying vec4 v_color;
 #endif
@@ -40,10 +50,26 @@ uniform float u_proxy_depth;
     // Make sure lighting is a no-op for feature selection pass
     #undef TANGRAM_LIGHTING_VERTEX
 
-    attribute vec4 a_selection_color;
+    #ifndef TANGRAM_FEATURE_TABLE
+        attribute vec4 a_selection_color;
+    #endif
     varying vec4 v_selection_color;
 #endif
 
+#ifdef TANGRAM_FEATURE_TABLE
+    uniform sampler2D u_feature_table;
+    // Entries per row, rows of each kind and rows of the table
+    uniform vec3 u_feature_table_size;
+
+    // Entry of the feature in the colors (0), selection colors or states rows
+    vec4 featureTableEntry(float row_offset) {
+        float index = a_feature.x + a_feature.y * 65536.0;
+        float row = floor(index / u_feature_table_size.x);
+        vec2 uv = vec2(index - row * u_feature_table_size.x + 0.5, row + row_offset + 0.5);
+        return texture2D(u_feature_table, uv / u_feature_table_size.xz);
+    }
+#endif
+
 varying vec4 v_world_position;
 varying vec4 v_position;
 varying vec3 v_normal;
@@ -59,7 +85,7 @@ vec4 worldPosition() {
 }
 
 vec3 worldNormal() {
-    #ifdef TANGRAM_RASTER_STYLE
+    #if defined(TANGRAM_RASTER_STYLE) || defined(TANGRAM_NO_NORMALS)
         return vec3(0.0, 0.0, 1.0);
     #else
         return a_normal;
@@ -91,8 +117,22 @@ void main() {
 
     vec4 position = modelPositionBaseZoom();
 
+    #ifdef TANGRAM_FEATURE_TABLE
+        // Visibility in red, line width scale in green
+        vec4 feature_state = featureTableEntry(2.0 * u_feature_table_size.y);
+        // Skip hidden features
+        if (feature_state.r == 0.0) {
+            gl_Position = vec4(0.0);
+            return;
+        }
+    #endif
+
     #ifdef TANGRAM_FEATURE_SELECTION
-        v_selection_color = a_selection_color;
+        #ifdef TANGRAM_FEATURE_TABLE
+            v_selection_color = featureTableEntry(u_feature_table_size.y);
+        #else
+            v_selection_color = a_selection_color;
+        #endif
         // Skip non-selectable meshes
         if (v_selection_color == vec4(0.0)) {
             gl_Position = vec4(0.0);
@@ -111,7 +151,11 @@ void main() {
         float layer = u_order;
     #else
         float layer = a_position.w;
-        v_color = a_color;
+        #ifdef TANGRAM_FEATURE_TABLE
+            v_color = featureTableEntry(0.0);
+        #else
+            v_color = a_color;
+        #endif
     #endif
 
     #ifdef TANGRAM_USE_TEX_COORDS
@@ -137,6 +181,11 @@ void main() {
     // Modify position before lighting and camera projection
     #pragma tangram: position
 
+    #ifdef TANGRAM_RASTER_STYLE
+        // Skirts hang below the tile edges to hide cracks between terrain grids of different resolution
+        position.z -= a_position.z * u_skirt;
+    #endif
+
     // Set position varying to the camera-space vertex position
     v_position = u_view * position;
 
@@ -7,19 +7,28 @@ precision highp float;
 #pragma tangram: defines
 
 uniform mat4 u_model;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform mat4 u_view;
 uniform mat4 u_proj;
 uniform mat3 u_normal_matrix;
 uniform mat3 u_inverse_normal_matrix;
-uniform vec4 u_tile_origin;
 uniform vec3 u_map_position;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
+#endif
+uniform vec4 u_tile_origin;
 uniform float u_texture_ratio;
 uniform sampler2D u_texture;
 
+#ifdef TANGRAM_LINE_DASH
+// Row of the dash pattern in the dash atlas: (row center, pattern width, pattern length in pixels)
+uniform vec3 u_dash;
+uniform vec4 u_dash_background_color;
+#define TANGRAM_LINE_BACKGROUND_COLOR u_dash_background_color
+#endif
+
 #pragma tangram: uniforms
 
 varying vec4 v_world_position;
@@ -29,6 +38,9 @@ varying vec3 v_normal;
 
 #ifdef TANGRAM_USE_TEX_COORDS
     varying vec2 v_texcoord;
+    varying float v_line_distance;
+    // Distance along the line before which it is not drawn
+    uniform float u_line_trim;
 #endif
 
 #ifdef TANGRAM_LIGHTING_VERTEX
@@ -57,6 +69,10 @@ void main(void) {
     // Initialize globals
     #pragma tangram: setup
 
+    #ifdef TANGRAM_USE_TEX_COORDS
+        if (v_line_distance < u_line_trim) { discard; }
+    #endif
+
     vec4 color = v_color;
     vec3 normal = v_normal;
 
@@ -65,7 +81,11 @@ void main(void) {
     #endif
 
     #ifdef TANGRAM_LINE_TEXTURE
-        vec2 line_st = vec2(v_texcoord.x, fract(v_texcoord.y * TANGRAM_DASH_TEX_SCALE / u_texture_ratio));
+        #if defined(TANGRAM_LINE_DASH)
+            vec2 line_st = vec2(fract(v_texcoord.y * TANGRAM_DASH_TEX_SCALE / u_dash.z) * u_dash.y, u_dash.x);
+        #else
+            vec2 line_st = vec2(v_texcoord.x, fract(v_texcoord.y * TANGRAM_DASH_TEX_SCALE / u_texture_ratio));
+        #endif
         vec4 line_color = texture2D(u_texture, line_st);
 
         #if defined(TANGRAM_LINE_DASH)
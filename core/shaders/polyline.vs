@@ -7,36 +7,75 @@ precision highp float;
 #pragma tangram: defines
 
 uniform mat4 u_model;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform mat4 u_view;
 uniform mat4 u_proj;
 uniform mat3 u_normal_matrix;
-uniform vec4 u_tile_origin;
 uniform vec3 u_map_position;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
+#endif
+uniform vec4 u_tile_origin;
 uniform float u_proxy_depth;
 
 #pragma tangram: uniforms
 
-attribute vec4 a_position;
-attribute vec4 a_color;
-attribute vec4 a_extrude;
+#ifdef TANGRAM_INSTANCED_LINES
+    // Corner of the segment: end, side and fan point, see RenderState::getLineSegmentBuffer()
+    attribute vec3 a_corner;
+    // Start and end of the segment, and the points before and after it
+    attribute vec4 a_segment;
+    attribute vec4 a_neighbors;
+    // Width, width change per zoom, height and order
+    attribute vec4 a_line;
+    // Cap, join, miter limit and whether the segment is capped at its start (1) and end (2)
+    attribute vec4 a_shape;
+    // Set from the segment by extrudeSegment()
+    vec4 a_position;
+    vec4 a_extrude;
+#else
+    attribute vec4 a_position;
+    attribute vec4 a_extrude;
+#endif
+#ifdef TANGRAM_FEATURE_TABLE
+    attribute vec2 a_feature;
+#else
+    attribute vec4 a_color;
+#endif
 
 #ifdef TANGRAM_USE_TEX_COORDS
     attribute vec2 a_texcoord;
     varying vec2 v_texcoord;
+    // Distance along the line in tile units, for trimming marker lines
+    varying float v_line_distance;
 #endif
 
 #ifdef TANGRAM_FEATURE_SELECTION
     // Make sure lighting is a no-op for feature selection pass
     #undef TANGRAM_LIGHTING_VERTEX
 
-    attribute vec4 a_selection_color;
+    #ifndef TANGRAM_FEATURE_TABLE
+        attribute vec4 a_selection_color;
+    #endif
     varying vec4 v_selection_color;
 #endif
 
+#ifdef TANGRAM_FEATURE_TABLE
+    uniform sampler2D u_feature_table;
+    // Entries per row, rows of each kind and rows of the table
+    uniform vec3 u_feature_table_size;
+
+    // Entry of the feature in the colors (0), selection colors or states rows
+    vec4 featureTableEntry(float row_offset) {
+        float index = a_feature.x + a_feature.y * 65536.0;
+        float row = floor(index / u_feature_table_size.x);
+        vec2 uv = vec2(index - row * u_feature_table_size.x + 0.5, row + row_offset + 0.5);
+        return texture2D(u_feature_table, uv / u_feature_table_size.xz);
+    }
+#endif
+
 varying vec4 v_world_position;
 varying vec4 v_position;
 varying vec4 v_color;
@@ -51,6 +90,75 @@ varying vec3 v_normal;
 #define UNPACK_ORDER(x) (x / 2.0)
 #define UNPACK_TEXCOORD(x) (x / 2048.0)
 
+#ifdef TANGRAM_INSTANCED_LINES
+// Sets the position and extrusion of the corner like the vertices of CPU built lines, with
+// joins at the end of the segment, and caps at the ends of the line
+void extrudeSegment() {
+    float end = a_corner.x;
+    vec2 point = mix(a_segment.xy, a_segment.zw, end);
+    vec2 tangent = normalize(a_segment.zw - a_segment.xy);
+    vec2 normal = vec2(-tangent.y, tangent.x);
+    // Neighbor beyond this end, the end itself at the ends of runs
+    vec2 neighbor = end > 0.5 ? a_neighbors.zw : a_neighbors.xy;
+    float cap = a_shape.x;
+    float join = a_shape.y;
+    float miter_limit = a_shape.z / 16.0;
+    bool capped = mod(floor(a_shape.w / (end > 0.5 ? 2.0 : 1.0)), 2.0) == 1.0;
+
+    vec2 extrude = vec2(0.0);
+
+    if (neighbor == point) {
+        vec2 outward = tangent * (end * 2.0 - 1.0);
+        if (a_corner.y != 0.0) {
+            extrude = normal * a_corner.y;
+            // Square caps extend the body
+            if (capped && cap == 2.0) { extrude += outward; }
+        } else if (capped && cap == 6.0 && a_corner.z >= 0.0) {
+            // Half circle from one side to the other
+            float angle = a_corner.z * (3.14159265 / 4.0);
+            extrude = normal * cos(angle) + outward * sin(angle);
+        }
+    } else {
+        vec2 other = normalize(end > 0.5 ? neighbor - point : point - neighbor);
+        vec2 other_normal = vec2(-other.y, other.x);
+        vec2 normal_prev = end > 0.5 ? normal : other_normal;
+        vec2 normal_next = end > 0.5 ? other_normal : normal;
+
+        vec2 miter = normal_prev + normal_next;
+        float m2 = dot(miter, miter);
+        bool bevel = join != 0.0 || m2 < 1e-6;
+        miter = m2 < 1e-6 ? vec2(0.0) : miter * (2.0 / m2);
+        if (dot(miter, miter) > miter_limit * miter_limit) {
+            // Long miters fall back to bevels
+            bevel = true;
+            miter *= miter_limit / length(miter);
+        }
+        // The join is on the side away from the turn
+        float turn = normal_prev.x * normal_next.y - normal_prev.y * normal_next.x;
+        float outer = turn > 0.0 ? -1.0 : 1.0;
+
+        if (a_corner.y != 0.0) {
+            extrude = (bevel && a_corner.y == outer) ? normal * outer : miter * a_corner.y;
+        } else if (bevel && end > 0.5 && a_corner.z >= 0.0) {
+            // Fan from the outer corner of this segment to that of the next
+            vec2 from = normal * outer;
+            vec2 to = other_normal * outer;
+            float f = a_corner.z / 4.0;
+            if (join == 5.0) {
+                float angle = acos(clamp(dot(from, to), -1.0, 1.0)) * f;
+                float dir = from.x * to.y - from.y * to.x < 0.0 ? -1.0 : 1.0;
+                extrude = from * cos(angle) + vec2(-from.y, from.x) * (dir * sin(angle));
+            } else {
+                extrude = mix(from, to, f);
+            }
+        }
+    }
+
+    a_position = vec4(point, a_line.zw);
+    a_extrude = vec4(extrude * 4096.0, a_line.xy);
+}
+#endif
+
 vec4 modelPosition() {
     return vec4(UNPACK_POSITION(a_position.xyz) * exp2(u_tile_origin.z - u_tile_origin.w), 1.0);
 }
@@ -78,10 +186,28 @@ vec4 modelPositionBaseZoom() {
 
 void main() {
 
+    #ifdef TANGRAM_INSTANCED_LINES
+        extrudeSegment();
+    #endif
+
     vec4 position = vec4(UNPACK_POSITION(a_position.xyz), 1.0);
 
+    #ifdef TANGRAM_FEATURE_TABLE
+        // Visibility in red, line width scale in green
+        vec4 feature_state = featureTableEntry(2.0 * u_feature_table_size.y);
+        // Skip hidden features
+        if (feature_state.r == 0.0) {
+            gl_Position = vec4(0.0);
+            return;
+        }
+    #endif
+
     #ifdef TANGRAM_FEATURE_SELECTION
-        v_selection_color = a_selection_color;
+        #ifdef TANGRAM_FEATURE_TABLE
+            v_selection_color = featureTableEntry(u_feature_table_size.y);
+        #else
+            v_selection_color = a_selection_color;
+        #endif
         // Skip non-selectable meshes
         if (v_selection_color == vec4(0.0)) {
             gl_Position = vec4(0.0);
@@ -97,10 +223,15 @@ void main() {
     float depth_shift = 0.0;
     float layer = UNPACK_ORDER(a_position.w);
 
-    v_color = a_color;
+    #ifdef TANGRAM_FEATURE_TABLE
+        v_color = featureTableEntry(0.0);
+    #else
+        v_color = a_color;
+    #endif
 
     #ifdef TANGRAM_USE_TEX_COORDS
         v_texcoord = UNPACK_TEXCOORD(a_texcoord);
+        v_line_distance = v_texcoord.y;
     #endif
 
     #ifdef TANGRAM_MODEL_POSITION_BASE_ZOOM_VARYING
@@ -121,6 +252,10 @@ void main() {
         // and adjust scale for overzooming.
         width *= exp2(-dz + (u_tile_origin.w - u_tile_origin.z));
 
+        #ifdef TANGRAM_FEATURE_TABLE
+            width *= feature_state.g * (255.0 / 64.0);
+        #endif
+
         // Modify line width in model space before extrusion
         #pragma tangram: width
 
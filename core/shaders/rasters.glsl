@@ -5,7 +5,20 @@
 #define TANGRAM_RASTER_PRECISION
 #endif
 
+#if defined(TANGRAM_RASTER_ARRAYS) && defined(TANGRAM_TEXTURE_ARRAYS)
+#define TANGRAM_RASTER_LAYERS
+#endif
+
+#ifdef TANGRAM_RASTER_LAYERS
+#ifdef GL_ES
+precision mediump sampler2DArray;
+#endif
+// Rasters are layers of texture arrays
+uniform TANGRAM_RASTER_PRECISION sampler2DArray u_rasters[TANGRAM_NUM_RASTER_SOURCES];
+uniform float u_raster_layers[TANGRAM_NUM_RASTER_SOURCES];
+#else
 uniform TANGRAM_RASTER_PRECISION sampler2D u_rasters[TANGRAM_NUM_RASTER_SOURCES];
+#endif
 uniform vec2 u_raster_sizes[TANGRAM_NUM_RASTER_SOURCES];
 uniform vec3 u_raster_offsets[TANGRAM_NUM_RASTER_SOURCES];
 
@@ -15,9 +28,15 @@ uniform vec3 u_raster_offsets[TANGRAM_NUM_RASTER_SOURCES];
 
 #define currentRasterPixel(raster_index) (currentRasterUV(raster_index) * rasterPixelSize(raster_index))
 
+#ifdef TANGRAM_RASTER_LAYERS
+#define sampleRasterAtPixel(raster_index, pixel) (texture(u_rasters[raster_index], vec3((pixel) / rasterPixelSize(raster_index), u_raster_layers[raster_index])))
+
+#define sampleRaster(raster_index) (texture(u_rasters[raster_index], vec3(currentRasterUV(raster_index), u_raster_layers[raster_index])))
+#else
 #define sampleRasterAtPixel(raster_index, pixel) (texture2D(u_rasters[raster_index], (pixel) / rasterPixelSize(raster_index)))
 
 #define sampleRaster(raster_index) (texture2D(u_rasters[raster_index], currentRasterUV(raster_index)))
+#endif
 
 #define rasterPixelSize(raster_index) (u_raster_sizes[raster_index])
 
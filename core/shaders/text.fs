@@ -10,12 +10,14 @@ precision highp float;
 #pragma tangram: defines
 
 uniform sampler2D u_tex;
+#ifndef TANGRAM_FRAME_UNIFORM_BLOCK
 uniform vec3 u_map_position;
-uniform vec4 u_tile_origin;
 uniform vec2 u_resolution;
 uniform float u_time;
 uniform float u_meters_per_pixel;
 uniform float u_device_pixel_ratio;
+#endif
+uniform vec4 u_tile_origin;
 uniform vec2 u_uv_scale_factor;
 
 #pragma tangram: uniforms
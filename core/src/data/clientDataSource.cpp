@@ -1,22 +1,40 @@
 #include "data/clientDataSource.h"
 
+#include "data/formats/geoJsonStream.h"
 #include "log.h"
 #include "platform.h"
 #include "tile/tileTask.h"
 #include "util/geom.h"
+#include "util/mapProjection.h"
 #include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "tile/tile.h"
+#include "util/mappedFile.h"
+#include "util/objectPool.h"
 #include "view/view.h"
 
 #include "mapbox/geojsonvt.hpp"
 
-// RapidJson parser
-#include "mapbox/geojson.hpp"
-#include <mapbox/geojson_impl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <regex>
+#include <unordered_set>
 
+// features parsed before they are added to the store
+#define CLIENT_DATA_BATCH_FEATURES 1024
 
-#include <regex>
+// depth of the feature index; tiles at this zoom and above get features of one node per level
+#define CLIENT_INDEX_ZOOM 8
+#define CLIENT_INDEX_MAX_NODES 4
+
+#define CLIENT_INDEX_MAGIC 0x49434754 // "TGCI"
+#define CLIENT_INDEX_VERSION 1
+
+// Nesting depth up to which geometry collections of an index file are read
+#define CLIENT_INDEX_MAX_DEPTH 16
 
 namespace Tangram {
 
@@ -34,12 +52,415 @@ geojsonvt::Options options() {
     return opt;
 }
 
+using vt_features = geojsonvt::detail::vt_features;
+using vt_box = geometry::box<double>;
+
+/* Features are kept projected to [0, 1] in a quadtree down to CLIENT_INDEX_ZOOM, each in the
+ * finest level where its bounds cover at most CLIENT_INDEX_MAX_NODES nodes. Tiles are clipped
+ * from the features of the nodes they overlap when parsed, so that changing a feature only
+ * updates the nodes covering its bounds - and the generations of tiles covering them.
+ */
 struct ClientDataSource::Storage {
-    std::unique_ptr<geojsonvt::GeoJSONVT> tiles;
-    geometry::feature_collection<double> features;
+
+    Storage() : index(CLIENT_INDEX_ZOOM + 1), generations(CLIENT_INDEX_ZOOM + 1) {}
+
+    struct Entry {
+        // projected and wrapped, with centroid if generated
+        vt_features features;
+        vt_box bbox = { { 2, 1 }, { -1, 0 } };
+        // index level, -1 if not indexed
+        int level = -1;
+        // offsets of the properties and features in the mapped index file, 0 when they are
+        // held in memory; see openIndex()
+        uint64_t mappedProperties = 0;
+        uint64_t mappedFeatures = 0;
+    };
+
+    // applied by generateTiles(); no geometry and not removed: properties changed
+    struct Update {
+        uint64_t id;
+        bool remove;
+        std::unique_ptr<geometry::geometry<double>> geometry;
+    };
+
+    uint64_t set(uint64_t _id, Properties&& _properties, geometry::geometry<double>&& _geometry) {
+        if (_id < properties.size()) {
+            properties[_id] = std::move(_properties);
+            entries[_id].mappedProperties = 0;
+        } else {
+            _id = properties.size();
+            properties.push_back(std::move(_properties));
+            entries.emplace_back();
+        }
+        updates.push_back({ _id, false, std::make_unique<geometry::geometry<double>>(std::move(_geometry)) });
+        return _id;
+    }
+
+    // Properties of feature @_id, read from the index file if they are mapped
+    Properties getProperties(uint64_t _id) const;
+
+    // Features of @_entry, read into @_mapped if they are in the index file
+    const vt_features& getFeatures(const Entry& _entry, uint64_t _id, vt_features& _mapped) const;
+
+    // by feature id
+    std::vector<Entry> entries;
     std::vector<Properties> properties;
+
+    // index file of the features of entries with mapped offsets
+    std::unique_ptr<MappedFile> file;
+
+    std::vector<Update> updates;
+    bool cleared = false;
+    bool generated = false;
+
+    // feature ids by level and node
+    std::vector<std::unordered_map<uint32_t, std::vector<uint64_t>>> index;
+
+    struct NodeGeneration {
+        // last change of features in the node
+        int64_t node = 0;
+        // last change of features in the node or below
+        int64_t subtree = 0;
+    };
+    // guarded by m_mutexGeneration
+    std::vector<std::unordered_map<uint32_t, NodeGeneration>> generations;
+    // last change of all tiles
+    int64_t baseGeneration = 0;
+};
+
+/* Features of a GeoJSON document, added to the store in batches while it is parsed
+ */
+struct ClientDataSource::DataStream {
+
+    DataStream(ClientDataSource& _source) : source(_source),
+        parser([this](Properties&& _properties, GeoJsonStream::Geometry&& _geometry) {
+            features.emplace_back(std::move(_properties), std::move(_geometry));
+            if (features.size() >= CLIENT_DATA_BATCH_FEATURES) { flush(); }
+        }) {}
+
+    void flush() {
+        if (features.empty()) { return; }
+
+        std::lock_guard<std::mutex> lock(source.m_mutexStore);
+        for (auto& feature : features) {
+            source.m_store->set(-1, std::move(feature.first), std::move(feature.second));
+        }
+        features.clear();
+    }
+
+    bool finish() {
+        bool valid = parser.finish();
+        flush();
+        if (!valid) {
+            LOGE("Invalid GeoJSON data for '%s': %s", source.name().c_str(), parser.error().c_str());
+        }
+        return valid;
+    }
+
+    ClientDataSource& source;
+    GeoJsonStream parser;
+    std::vector<std::pair<Properties, GeoJsonStream::Geometry>> features;
+};
+
+struct NodeRange {
+    int level;
+    uint32_t x0, y0, x1, y1;
+
+    template<typename F>
+    void forEach(F _f) const {
+        for (uint32_t y = y0; y <= y1; y++) {
+            for (uint32_t x = x0; x <= x1; x++) { _f(x, y); }
+        }
+    }
 };
 
+static uint32_t nodeKey(uint32_t _x, uint32_t _y, int _level) {
+    return (_y << _level) | _x;
+}
+
+static NodeRange nodeRange(const vt_box& _bbox, int _level) {
+    const double n = 1u << _level;
+    auto node = [&](double _v) { return uint32_t(std::min(std::max(std::floor(_v * n), 0.0), n - 1)); };
+    return { _level, node(_bbox.min.x), node(_bbox.min.y), node(_bbox.max.x), node(_bbox.max.y) };
+}
+
+static NodeRange indexRange(const vt_box& _bbox) {
+    for (int level = CLIENT_INDEX_ZOOM; level > 0; level--) {
+        NodeRange range = nodeRange(_bbox, level);
+        if ((range.x1 - range.x0 + 1) * (range.y1 - range.y0 + 1) <= CLIENT_INDEX_MAX_NODES) {
+            return range;
+        }
+    }
+    return nodeRange(_bbox, 0);
+}
+
+static bool intersects(const vt_box& _a, const vt_box& _b) {
+    return _a.min.x <= _b.max.x && _a.max.x >= _b.min.x && _a.min.y <= _b.max.y && _a.max.y >= _b.min.y;
+}
+
+/* Index file: Header, an IndexEntry per feature id, then the properties and features of each
+ * feature that the entries point to. Features are stored as projected by convertFeature(), so
+ * that opening the file only reads the entries to fill the index.
+ */
+struct IndexHeader {
+    uint32_t magic = CLIENT_INDEX_MAGIC;
+    uint32_t version = CLIENT_INDEX_VERSION;
+    uint64_t key = 0;
+    uint64_t count = 0;
+    uint32_t centroids = 0;
+    uint32_t padding = 0;
+};
+
+struct IndexEntry {
+    double bbox[4];
+    int32_t level;
+    uint32_t padding;
+    uint64_t properties;
+    uint64_t features;
+};
+
+template<typename T>
+static void append(std::vector<char>& _out, const T& _value) {
+    auto bytes = reinterpret_cast<const char*>(&_value);
+    _out.insert(_out.end(), bytes, bytes + sizeof(T));
+}
+
+static void appendString(std::vector<char>& _out, const std::string& _string) {
+    append(_out, uint32_t(_string.size()));
+    _out.insert(_out.end(), _string.begin(), _string.end());
+}
+
+template<typename T>
+static bool read(const char*& _pos, const char* _end, T& _value) {
+    if (size_t(_end - _pos) < sizeof(T)) { return false; }
+    std::memcpy(&_value, _pos, sizeof(T));
+    _pos += sizeof(T);
+    return true;
+}
+
+static bool readString(const char*& _pos, const char* _end, std::string& _string) {
+    uint32_t length = 0;
+    if (!read(_pos, _end, length) || size_t(_end - _pos) < length) { return false; }
+    _string.assign(_pos, length);
+    _pos += length;
+    return true;
+}
+
+static void appendProperties(std::vector<char>& _out, const Properties& _properties) {
+    const auto& items = _properties.items();
+    append(_out, uint32_t(items.size()));
+    for (const auto& item : items) {
+        appendString(_out, item.key);
+        if (item.value.is<double>()) {
+            append(_out, uint8_t(1));
+            append(_out, item.value.get<double>());
+        } else if (item.value.is<std::string>()) {
+            append(_out, uint8_t(2));
+            appendString(_out, item.value.get<std::string>());
+        } else {
+            append(_out, uint8_t(0));
+        }
+    }
+}
+
+static bool readProperties(const char* _pos, const char* _end, Properties& _properties) {
+    uint32_t count = 0;
+    if (!read(_pos, _end, count)) { return false; }
+
+    std::vector<PropertyItem> items;
+    for (uint32_t i = 0; i < count; i++) {
+        std::string key;
+        uint8_t type = 0;
+        if (!readString(_pos, _end, key) || !read(_pos, _end, type)) { return false; }
+        if (type == 1) {
+            double value = 0;
+            if (!read(_pos, _end, value)) { return false; }
+            items.emplace_back(std::move(key), value);
+        } else if (type == 2) {
+            std::string value;
+            if (!readString(_pos, _end, value)) { return false; }
+            items.emplace_back(std::move(key), std::move(value));
+        } else {
+            items.emplace_back(std::move(key), Value{});
+        }
+    }
+    _properties.setSorted(std::move(items));
+    return true;
+}
+
+struct append_geometry {
+    std::vector<char>& out;
+
+    void points(const std::vector<geojsonvt::detail::vt_point>& _points) {
+        append(out, uint32_t(_points.size()));
+        for (const auto& p : _points) { (*this)(p); }
+    }
+
+    void operator()(const geojsonvt::detail::vt_point& _point) {
+        append(out, _point.x);
+        append(out, _point.y);
+        append(out, _point.z);
+    }
+    void operator()(const geojsonvt::detail::vt_line_string& _line) {
+        append(out, _line.dist);
+        points(_line);
+    }
+    void operator()(const geojsonvt::detail::vt_polygon& _polygon) {
+        append(out, uint32_t(_polygon.size()));
+        for (const auto& ring : _polygon) {
+            append(out, ring.area);
+            points(ring);
+        }
+    }
+    void operator()(const geojsonvt::detail::vt_multi_point& _points) { points(_points); }
+    void operator()(const geojsonvt::detail::vt_multi_line_string& _lines) {
+        append(out, uint32_t(_lines.size()));
+        for (const auto& line : _lines) { (*this)(line); }
+    }
+    void operator()(const geojsonvt::detail::vt_multi_polygon& _polygons) {
+        append(out, uint32_t(_polygons.size()));
+        for (const auto& polygon : _polygons) { (*this)(polygon); }
+    }
+    void operator()(const geojsonvt::detail::vt_geometry_collection& _collection) {
+        append(out, uint32_t(_collection.size()));
+        for (const auto& geometry : _collection) { write(geometry); }
+    }
+
+    void write(const geojsonvt::detail::vt_geometry& _geometry) {
+        append(out, uint8_t(_geometry.which()));
+        geojsonvt::detail::vt_geometry::visit(_geometry, *this);
+    }
+};
+
+/* Reads geometry written by append_geometry; ok is false once the data turns out invalid */
+struct read_geometry {
+    using vt_point = geojsonvt::detail::vt_point;
+    using vt_geometry = geojsonvt::detail::vt_geometry;
+
+    const char* pos;
+    const char* end;
+    bool ok = true;
+
+    template<typename T>
+    T get() {
+        T value{};
+        ok = ok && read(pos, end, value);
+        return value;
+    }
+
+    // Number of items of at least @_size bytes each that fit in the rest of the data
+    uint32_t count(size_t _size) {
+        auto n = get<uint32_t>();
+        if (n > size_t(end - pos) / _size) { ok = false; }
+        return ok ? n : 0;
+    }
+
+    vt_point point() {
+        double x = get<double>(), y = get<double>(), z = get<double>();
+        return { x, y, z };
+    }
+
+    template<typename Points>
+    void points(Points& _points) {
+        uint32_t n = count(3 * sizeof(double));
+        _points.reserve(n);
+        for (uint32_t i = 0; i < n; i++) { _points.push_back(point()); }
+    }
+
+    geojsonvt::detail::vt_line_string line() {
+        geojsonvt::detail::vt_line_string line;
+        line.dist = get<double>();
+        points(line);
+        return line;
+    }
+
+    geojsonvt::detail::vt_polygon polygon() {
+        geojsonvt::detail::vt_polygon polygon;
+        uint32_t n = count(sizeof(double) + sizeof(uint32_t));
+        for (uint32_t i = 0; i < n && ok; i++) {
+            polygon.emplace_back();
+            polygon.back().area = get<double>();
+            points(polygon.back());
+        }
+        return polygon;
+    }
+
+    vt_geometry geometry(int _depth) {
+        using namespace geojsonvt::detail;
+        switch (get<uint8_t>()) {
+        case vt_geometry::which<vt_point>():
+            return point();
+        case vt_geometry::which<vt_line_string>():
+            return line();
+        case vt_geometry::which<vt_polygon>():
+            return polygon();
+        case vt_geometry::which<vt_multi_point>(): {
+            vt_multi_point points;
+            this->points(points);
+            return points;
+        }
+        case vt_geometry::which<vt_multi_line_string>(): {
+            vt_multi_line_string lines;
+            uint32_t n = count(sizeof(double) + sizeof(uint32_t));
+            for (uint32_t i = 0; i < n && ok; i++) { lines.push_back(line()); }
+            return lines;
+        }
+        case vt_geometry::which<vt_multi_polygon>(): {
+            vt_multi_polygon polygons;
+            uint32_t n = count(sizeof(uint32_t));
+            for (uint32_t i = 0; i < n && ok; i++) { polygons.push_back(polygon()); }
+            return polygons;
+        }
+        case vt_geometry::which<vt_geometry_collection>(): {
+            vt_geometry_collection collection;
+            uint32_t n = count(sizeof(uint8_t));
+            if (_depth >= CLIENT_INDEX_MAX_DEPTH) { ok = false; }
+            for (uint32_t i = 0; i < n && ok; i++) { collection.push_back(geometry(_depth + 1)); }
+            return collection;
+        }
+        default:
+            ok = false;
+            return vt_point(0, 0);
+        }
+    }
+};
+
+Properties ClientDataSource::Storage::getProperties(uint64_t _id) const {
+    const auto& entry = entries[_id];
+    if (!entry.mappedProperties) { return properties[_id]; }
+
+    Properties result;
+    if (!readProperties(file->data() + entry.mappedProperties, file->data() + file->size(), result)) {
+        LOGE("Invalid properties of feature %llu in client data index", (unsigned long long)_id);
+    }
+    return result;
+}
+
+const vt_features& ClientDataSource::Storage::getFeatures(const Entry& _entry, uint64_t _id,
+                                                          vt_features& _mapped) const {
+    if (!_entry.mappedFeatures) { return _entry.features; }
+
+    _mapped.clear();
+    read_geometry reader{ file->data() + _entry.mappedFeatures, file->data() + file->size() };
+    uint32_t count = reader.count(2 * sizeof(uint8_t));
+    for (uint32_t i = 0; i < count && reader.ok; i++) {
+        // centroids have signed ids, see convertFeature()
+        bool centroid = reader.get<uint8_t>() != 0;
+        auto geometry = reader.geometry(0);
+        if (!reader.ok) { break; }
+        if (centroid) {
+            _mapped.emplace_back(geometry, geojsonvt::detail::property_map{}, int64_t(_id));
+        } else {
+            _mapped.emplace_back(geometry, geojsonvt::detail::property_map{}, uint64_t(_id));
+        }
+    }
+    if (!reader.ok) {
+        LOGE("Invalid geometry of feature %llu in client data index", (unsigned long long)_id);
+        _mapped.clear();
+    }
+    return _mapped;
+}
+
 struct ClientDataSource::PolylineBuilderData : mapbox::geometry::multi_line_string<double> {
     virtual ~PolylineBuilderData() = default;
 };
@@ -83,7 +504,7 @@ void ClientDataSource::PolygonBuilder::addPoint(LngLat point) {
 }
 
 std::shared_ptr<TileTask> ClientDataSource::createTask(TileID _tileId) {
-    auto task = std::make_shared<TileTask>(_tileId, this);
+    auto task = m_taskPool->make<TileTask>(_tileId, this);
     addRasterTasks(*task);
     return task;
 }
@@ -105,7 +526,8 @@ ClientDataSource::ClientDataSource(Platform& _platform, const std::string& _name
             if (response.error) {
                 LOGE("Unable to retrieve data from '%s': %s", _url.c_str(), response.error);
             } else {
-                addData(std::string(response.content.begin(), response.content.end()));
+                appendData(response.content.data(), response.content.size());
+                finishData();
                 generateTiles();
             }
             m_hasPendingData = false;
@@ -152,51 +574,322 @@ struct add_centroid {
     }
 };
 
-struct prop_visitor {
-    Properties& props;
-    std::string& key;
-    void operator()(std::string v) {
-        props.set(key, std::move(v));
+/* Projects geometries like geojsonvt::detail::project, the points of lines and rings in batches */
+struct project_points {
+    using result_type = geojsonvt::detail::vt_geometry;
+
+    const double tolerance;
+    std::vector<LngLat> lngLats;
+    std::vector<ProjectedMeters> meters;
+
+    geojsonvt::detail::vt_point operator()(const geometry::point<double>& _point) {
+        return geojsonvt::detail::project{ tolerance }(_point);
     }
-    void operator()(bool v) {
-        props.set(key, double(v));
+
+    template <typename R>
+    void projectAll(const std::vector<geometry::point<double>>& _points, R& _result) {
+        lngLats.clear();
+        for (const auto& p : _points) { lngLats.emplace_back(p.x, p.y); }
+        meters.resize(lngLats.size());
+        MapProjection::lngLatToProjectedMeters(lngLats.data(), meters.data(), lngLats.size());
+
+        const double circumference = MapProjection::EARTH_CIRCUMFERENCE_METERS;
+        _result.reserve(_points.size());
+        for (size_t i = 0; i < _points.size(); i++) {
+            if (std::abs(_points[i].y) > 90.0) {
+                _result.push_back((*this)(_points[i]));
+                continue;
+            }
+            double x = meters[i].x / circumference + 0.5;
+            double y = std::max(std::min(0.5 - meters[i].y / circumference, 1.0), 0.0);
+            _result.push_back({ x, y, 0.0 });
+        }
     }
-    void operator()(uint64_t v) {
-        props.set(key, double(v));
+
+    geojsonvt::detail::vt_line_string operator()(const geometry::line_string<double>& _line) {
+        geojsonvt::detail::vt_line_string result;
+        if (_line.empty()) { return result; }
+        projectAll(_line, result);
+
+        for (size_t i = 0; i < result.size() - 1; i++) {
+            result.dist += std::abs(result[i + 1].x - result[i].x) + std::abs(result[i + 1].y - result[i].y);
+        }
+        geojsonvt::detail::simplify(result, tolerance);
+        return result;
     }
-    void operator()(int64_t v) {
-        props.set(key, double(v));
+
+    geojsonvt::detail::vt_linear_ring operator()(const geometry::linear_ring<double>& _ring) {
+        geojsonvt::detail::vt_linear_ring result;
+        if (_ring.empty()) { return result; }
+        projectAll(_ring, result);
+
+        double area = 0.0;
+        for (size_t i = 0; i < result.size() - 1; i++) {
+            area += result[i].x * result[i + 1].y - result[i + 1].x * result[i].y;
+        }
+        result.area = std::abs(area / 2);
+        geojsonvt::detail::simplify(result, tolerance);
+        return result;
     }
-    void operator()(double v) {
-        props.set(key, v);
+
+    geojsonvt::detail::vt_geometry operator()(const geometry::geometry<double>& _geometry) {
+        return geometry::geometry<double>::visit(_geometry, project_points{ tolerance });
     }
 
+    // polygon, multi_* and geometry_collection
     template <typename T>
-    void operator()(T) {
-        // Ignore all other basic value types
+    auto operator()(const T& _vector) {
+        typename geojsonvt::detail::vt_geometry_type<T>::type result;
+        result.reserve(_vector.size());
+        for (const auto& e : _vector) { result.push_back((*this)(e)); }
+        return result;
     }
 };
 
+static vt_features convertFeature(const geometry::geometry<double>& _geometry, uint64_t _id,
+                                  bool _generateCentroid) {
+    using namespace geojsonvt::detail;
+
+    const auto opt = options();
+    const double tolerance = (opt.tolerance / opt.extent) / (1u << opt.maxZoom);
+
+    vt_features features;
+    features.emplace_back(geometry::geometry<double>::visit(_geometry, project_points{ tolerance }),
+                          property_map{}, uint64_t(_id));
+
+    geometry::point<double> centroid;
+    if (_generateCentroid && geometry::geometry<double>::visit(_geometry, add_centroid{ centroid })) {
+        // signed id to mark the centroid of feature _id
+        features.emplace_back(project{ tolerance }(centroid), property_map{}, int64_t(_id));
+    }
+
+    return wrap(features, double(opt.buffer) / opt.extent);
+}
+
 void ClientDataSource::generateTiles() {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
+    auto& store = *m_store;
+
+    if (store.generated && !store.cleared && store.updates.empty()) { return; }
+
+    int64_t generation = m_generation + 1;
+    std::vector<NodeRange> changed;
+
+    // only the last update of a feature needs to be applied
+    std::unordered_set<uint64_t> updated;
+    for (auto it = store.updates.rbegin(); it != store.updates.rend(); ++it) {
+        if (!updated.insert(it->id).second) { continue; }
+
+        auto& entry = store.entries[it->id];
+        if (entry.level >= 0) {
+            NodeRange range = nodeRange(entry.bbox, entry.level);
+            range.forEach([&](uint32_t x, uint32_t y) {
+                auto node = store.index[range.level].find(nodeKey(x, y, range.level));
+                auto& ids = node->second;
+                ids.erase(std::find(ids.begin(), ids.end(), it->id));
+                if (ids.empty()) { store.index[range.level].erase(node); }
+            });
+            changed.push_back(range);
+            entry.level = -1;
+        }
 
-    if (m_generateCentroids) {
-        for (const auto &feat : m_store->features) {
-            geometry::point<double> centroid;
-            const auto& properties = m_store->properties[feat.id.get<uint64_t>()];
-            if (geometry::geometry<double>::visit(feat.geometry, add_centroid{ centroid })) {
-                uint64_t id = m_store->features.size();
-                m_store->features.emplace_back(centroid, id);
-                m_store->properties.push_back(properties);
-                auto& props = m_store->properties.back();
-                props.set("label_placement", 1.0);
+        if (it->remove) {
+            entry = {};
+            store.properties[it->id] = {};
+            continue;
+        }
+
+        if (it->geometry) {
+            entry.features = convertFeature(*it->geometry, it->id, m_generateCentroids);
+            entry.mappedFeatures = 0;
+            entry.bbox = { { 2, 1 }, { -1, 0 } };
+            for (const auto& feature : entry.features) {
+                entry.bbox.min.x = std::min(entry.bbox.min.x, feature.bbox.min.x);
+                entry.bbox.min.y = std::min(entry.bbox.min.y, feature.bbox.min.y);
+                entry.bbox.max.x = std::max(entry.bbox.max.x, feature.bbox.max.x);
+                entry.bbox.max.y = std::max(entry.bbox.max.y, feature.bbox.max.y);
+            }
+        }
+        if (entry.features.empty() && !entry.mappedFeatures) { continue; }
+
+        NodeRange range = indexRange(entry.bbox);
+        range.forEach([&](uint32_t x, uint32_t y) {
+            store.index[range.level][nodeKey(x, y, range.level)].push_back(it->id);
+        });
+        changed.push_back(range);
+        entry.level = range.level;
+    }
+    store.updates.clear();
+
+    std::lock_guard<std::mutex> generationLock(m_mutexGeneration);
+
+    if (!store.generated || store.cleared) {
+        for (auto& level : store.generations) { level.clear(); }
+        store.baseGeneration = generation;
+        store.generated = true;
+        store.cleared = false;
+    }
+
+    for (auto& range : changed) {
+        range.forEach([&](uint32_t x, uint32_t y) {
+            auto& node = store.generations[range.level][nodeKey(x, y, range.level)];
+            node.node = node.subtree = generation;
+            for (int level = range.level - 1; level >= 0; level--) {
+                x >>= 1;
+                y >>= 1;
+                store.generations[level][nodeKey(x, y, level)].subtree = generation;
+            }
+        });
+    }
+    m_generation = generation;
+}
+
+bool ClientDataSource::saveIndex(const std::string& _path, uint64_t _dataKey) const {
+
+    std::vector<char> data;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+        const auto& store = *m_store;
+
+        IndexHeader header;
+        header.key = _dataKey;
+        header.count = store.entries.size();
+        header.centroids = m_generateCentroids;
+        append(data, header);
+
+        size_t table = data.size();
+        data.resize(table + store.entries.size() * sizeof(IndexEntry));
+
+        vt_features mapped;
+        for (uint64_t id = 0; id < store.entries.size(); id++) {
+            const auto& entry = store.entries[id];
+            const auto& features = store.getFeatures(entry, id, mapped);
+
+            IndexEntry indexEntry = { { entry.bbox.min.x, entry.bbox.min.y, entry.bbox.max.x, entry.bbox.max.y },
+                                      entry.level, 0, 0, 0 };
+            if (!features.empty()) {
+                indexEntry.properties = data.size();
+                appendProperties(data, store.getProperties(id));
+
+                indexEntry.features = data.size();
+                append(data, uint32_t(features.size()));
+                for (const auto& feature : features) {
+                    append(data, uint8_t(feature.id.is<int64_t>()));
+                    append_geometry{ data }.write(feature.geometry);
+                }
+            } else {
+                indexEntry.level = -1;
             }
+            std::memcpy(&data[table + id * sizeof(IndexEntry)], &indexEntry, sizeof(IndexEntry));
         }
     }
 
-    m_store->tiles = std::make_unique<geojsonvt::GeoJSONVT>(m_store->features, options());
-    m_generation++;
+    // Write to a temporary file so that incomplete indices are never opened
+    auto tmpPath = _path + ".tmp";
+    std::ofstream file(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    file.write(data.data(), data.size());
+    file.close();
+
+    if (!file) {
+        LOGW("Cannot write client data index: %s", tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // rename does not replace existing files on all platforms
+    std::remove(_path.c_str());
+    if (std::rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        LOGW("Cannot write client data index: %s", _path.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ClientDataSource::openIndex(const std::string& _path, uint64_t _dataKey) {
+
+    auto file = std::make_unique<MappedFile>();
+    IndexHeader header;
+    if (!file->open(_path) || file->size() < sizeof(IndexHeader)) { return false; }
+    std::memcpy(&header, file->data(), sizeof(IndexHeader));
+
+    IndexHeader expected;
+    if (header.magic != expected.magic || header.version != expected.version ||
+        header.key != _dataKey || header.centroids != uint32_t(m_generateCentroids) ||
+        header.count > (file->size() - sizeof(IndexHeader)) / sizeof(IndexEntry)) {
+        LOGD("Client data index does not match the data: %s", _path.c_str());
+        return false;
+    }
+
+    auto getEntry = [&](uint64_t _id) {
+        IndexEntry indexEntry;
+        std::memcpy(&indexEntry, file->data() + sizeof(IndexHeader) + _id * sizeof(IndexEntry), sizeof(IndexEntry));
+        return indexEntry;
+    };
+    for (uint64_t id = 0; id < header.count; id++) {
+        IndexEntry indexEntry = getEntry(id);
+        if (indexEntry.level < -1 || indexEntry.level > CLIENT_INDEX_ZOOM ||
+            indexEntry.properties >= file->size() || indexEntry.features >= file->size()) {
+            LOGE("Invalid client data index: %s", _path.c_str());
+            return false;
+        }
+    }
+    file->adviseRandom();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+        auto& store = *m_store;
+
+        store.entries.assign(header.count, {});
+        store.properties.assign(header.count, {});
+        store.updates.clear();
+        for (auto& level : store.index) { level.clear(); }
+
+        for (uint64_t id = 0; id < header.count; id++) {
+            IndexEntry indexEntry = getEntry(id);
+            auto& entry = store.entries[id];
+            if (indexEntry.level < 0 || !indexEntry.features) { continue; }
+
+            entry.bbox = { { indexEntry.bbox[0], indexEntry.bbox[1] }, { indexEntry.bbox[2], indexEntry.bbox[3] } };
+            entry.level = indexEntry.level;
+            entry.mappedProperties = indexEntry.properties;
+            entry.mappedFeatures = indexEntry.features;
+
+            NodeRange range = nodeRange(entry.bbox, entry.level);
+            range.forEach([&](uint32_t x, uint32_t y) {
+                store.index[range.level][nodeKey(x, y, range.level)].push_back(id);
+            });
+        }
+        store.file = std::move(file);
+        store.cleared = true;
+    }
+
+    // new generation of all tiles
+    generateTiles();
+    return true;
+}
+
+int64_t ClientDataSource::tileGeneration(const TileID& _tileId) const {
+
+    std::lock_guard<std::mutex> lock(m_mutexGeneration);
+    const auto& store = *m_store;
+
+    // changes in the node of the tile or below, or in a node above covering the tile
+    int64_t generation = store.baseGeneration;
+    int tileLevel = std::min(int(_tileId.z), CLIENT_INDEX_ZOOM);
+    uint32_t x = uint32_t(_tileId.x) >> (_tileId.z - tileLevel);
+    uint32_t y = uint32_t(_tileId.y) >> (_tileId.z - tileLevel);
+
+    for (int level = tileLevel; level >= 0; level--) {
+        auto it = store.generations[level].find(nodeKey(x, y, level));
+        if (it != store.generations[level].end()) {
+            generation = std::max(generation, level == tileLevel ? it->second.subtree : it->second.node);
+        }
+        x >>= 1;
+        y >>= 1;
+    }
+    return generation;
 }
 
 void ClientDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -219,34 +912,38 @@ void ClientDataSource::clearFeatures() {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
-    m_store->features.clear();
+    m_store->entries.clear();
     m_store->properties.clear();
+    m_store->updates.clear();
+    for (auto& level : m_store->index) { level.clear(); }
+    m_store->file.reset();
+    m_store->cleared = true;
 }
 
 void ClientDataSource::addData(const std::string& _data) {
 
-    std::lock_guard<std::mutex> lock(m_mutexStore);
+    DataStream stream(*this);
+    stream.parser.write(_data.data(), _data.size());
+    stream.finish();
+}
 
-    const auto json = geojson::parse(_data);
-    auto features = geojsonvt::geojson::visit(json, geojsonvt::ToFeatureCollection{});
+void ClientDataSource::appendData(const char* _data, size_t _size) {
 
-    for (auto& feature : features) {
+    std::lock_guard<std::mutex> lock(m_mutexStream);
 
-        feature.id = uint64_t(m_store->properties.size());
-        m_store->properties.emplace_back();
-        Properties& props = m_store->properties.back();
+    if (!m_stream) { m_stream = std::make_unique<DataStream>(*this); }
+    m_stream->parser.write(_data, _size);
+    m_stream->flush();
+}
 
-        for (const auto& prop : feature.properties) {
-            auto key = prop.first;
-            prop_visitor visitor = {props, key};
-            mapbox::util::apply_visitor(visitor, prop.second);
-        }
-        feature.properties.clear();
-    }
+bool ClientDataSource::finishData() {
 
-    m_store->features.insert(m_store->features.end(),
-                             std::make_move_iterator(features.begin()),
-                             std::make_move_iterator(features.end()));
+    std::lock_guard<std::mutex> lock(m_mutexStream);
+
+    if (!m_stream) { return true; }
+    bool valid = m_stream->finish();
+    m_stream.reset();
+    return valid;
 }
 
 uint64_t ClientDataSource::addPointFeature(Properties&& properties, LngLat coordinates, uint64_t id) {
@@ -254,15 +951,7 @@ uint64_t ClientDataSource::addPointFeature(Properties&& properties, LngLat coord
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
     geometry::point<double> geom {coordinates.longitude, coordinates.latitude};
-    if (id < m_store->features.size()) {
-      m_store->features[id] = {geom, id};
-      m_store->properties[id] = std::move(properties);
-    } else {
-      id = m_store->features.size();
-      m_store->features.emplace_back(geom, id);
-      m_store->properties.emplace_back(properties);
-    }
-    return id;
+    return m_store->set(id, std::move(properties), geom);
 }
 
 uint64_t ClientDataSource::addPolylineFeature(Properties&& properties, PolylineBuilder&& polyline, uint64_t id) {
@@ -270,15 +959,7 @@ uint64_t ClientDataSource::addPolylineFeature(Properties&& properties, PolylineB
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
     auto geom = std::move(polyline.data);
-    if (id < m_store->features.size()) {
-      m_store->features[id] = {*geom, id};
-      m_store->properties[id] = std::move(properties);
-    } else {
-      id = m_store->features.size();
-      m_store->features.emplace_back(*geom, id);
-      m_store->properties.emplace_back(properties);
-    }
-    return id;
+    return m_store->set(id, std::move(properties), std::move(*geom));
 }
 
 uint64_t ClientDataSource::addPolygonFeature(Properties&& properties, PolygonBuilder&& polygon, uint64_t id) {
@@ -286,20 +967,125 @@ uint64_t ClientDataSource::addPolygonFeature(Properties&& properties, PolygonBui
     std::lock_guard<std::mutex> lock(m_mutexStore);
 
     auto geom = std::move(polygon.data);
-    if (id < m_store->features.size()) {
-      m_store->features[id] = {*geom, id};
-      m_store->properties[id] = std::move(properties);
-    } else {
-      id = m_store->features.size();
-      m_store->features.emplace_back(*geom, id);
-      m_store->properties.emplace_back(properties);
+    return m_store->set(id, std::move(properties), std::move(*geom));
+}
+
+static bool validOffsets(const uint32_t* _offsets, size_t _count, size_t _end) {
+    if (!_offsets) { return false; }
+    for (size_t i = 0; i < _count; i++) {
+        if (_offsets[i] > _offsets[i + 1]) { return false; }
+    }
+    return _offsets[_count] <= _end;
+}
+
+static bool validBatch(const ClientDataSource::FeatureBatch& _batch) {
+    using Type = ClientDataSource::FeatureBatch::Type;
+
+    if (_batch.featureCount > 0 && !_batch.coordinates) { return false; }
+    if (_batch.keys.size() != _batch.columns.size()) { return false; }
+    for (const auto& column : _batch.columns) {
+        if (!column.numbers && !column.strings) { return false; }
+    }
+    if (_batch.type == Type::points) {
+        return _batch.featureCount <= _batch.pointCount;
+    }
+    return validOffsets(_batch.featureOffsets, _batch.featureCount, _batch.partCount) &&
+        validOffsets(_batch.partOffsets, _batch.partCount, _batch.pointCount);
+}
+
+uint64_t ClientDataSource::addFeatures(const FeatureBatch& _batch) {
+
+    if (!validBatch(_batch)) {
+        LOGE("Invalid feature batch for '%s'", name().c_str());
+        return -1;
+    }
+
+    // columns in the order of Properties items, see PropertyItem::operator<
+    std::vector<size_t> columns(_batch.columns.size());
+    for (size_t i = 0; i < columns.size(); i++) { columns[i] = i; }
+    std::sort(columns.begin(), columns.end(), [&](size_t a, size_t b) {
+        const auto& keyA = _batch.keys[a];
+        const auto& keyB = _batch.keys[b];
+        return keyA.size() == keyB.size() ? keyA < keyB : keyA.size() < keyB.size();
+    });
+
+    auto point = [&](size_t i) {
+        return geometry::point<double>(_batch.coordinates[2 * i], _batch.coordinates[2 * i + 1]);
+    };
+    auto part = [&](size_t j, auto& _line) {
+        _line.reserve(_batch.partOffsets[j + 1] - _batch.partOffsets[j]);
+        for (size_t i = _batch.partOffsets[j]; i < _batch.partOffsets[j + 1]; i++) {
+            _line.push_back(point(i));
+        }
+    };
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+    auto& store = *m_store;
+
+    const uint64_t first = store.properties.size();
+    store.properties.reserve(first + _batch.featureCount);
+    store.entries.reserve(first + _batch.featureCount);
+    store.updates.reserve(store.updates.size() + _batch.featureCount);
+
+    for (size_t feature = 0; feature < _batch.featureCount; feature++) {
+
+        std::vector<PropertyItem> items;
+        items.reserve(columns.size());
+        for (size_t c : columns) {
+            const auto& column = _batch.columns[c];
+            if (column.numbers) {
+                double value = column.numbers[feature];
+                if (!std::isnan(value)) { items.emplace_back(_batch.keys[c], value); }
+            } else if (const char* value = column.strings[feature]) {
+                items.emplace_back(_batch.keys[c], std::string(value));
+            }
+        }
+        Properties properties;
+        properties.setSorted(std::move(items));
+
+        switch (_batch.type) {
+        case FeatureBatch::Type::points:
+            store.set(-1, std::move(properties), point(feature));
+            break;
+        case FeatureBatch::Type::polylines: {
+            geometry::multi_line_string<double> lines;
+            for (size_t j = _batch.featureOffsets[feature]; j < _batch.featureOffsets[feature + 1]; j++) {
+                lines.emplace_back();
+                part(j, lines.back());
+            }
+            store.set(-1, std::move(properties), std::move(lines));
+            break;
+        }
+        case FeatureBatch::Type::polygons: {
+            geometry::polygon<double> polygon;
+            for (size_t j = _batch.featureOffsets[feature]; j < _batch.featureOffsets[feature + 1]; j++) {
+                polygon.emplace_back();
+                part(j, polygon.back());
+            }
+            store.set(-1, std::move(properties), std::move(polygon));
+            break;
+        }
+        }
     }
-    return id;
+    return first;
 }
 
 void ClientDataSource::setProperties(uint64_t id, Properties&& properties) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
     if (id >= m_store->properties.size()) return;
     m_store->properties[id] = std::move(properties);
+    m_store->entries[id].mappedProperties = 0;
+    m_store->updates.push_back({ id, false, nullptr });
+}
+
+void ClientDataSource::removeFeature(uint64_t id) {
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+
+    if (id >= m_store->properties.size()) return;
+    m_store->updates.push_back({ id, true, nullptr });
 }
 
 struct add_geometry {
@@ -313,33 +1099,34 @@ struct add_geometry {
 
     Feature& feature;
 
+    // Append the points of a line or ring, without repeated points
+    template<typename Points>
+    void addPoints(const Points& _points) {
+        size_t start = feature.coordinates.size();
+        for (const auto& p : _points) {
+            auto tp = transformPoint(p);
+            if (feature.coordinates.size() > start && tp == feature.coordinates.back()) { continue; }
+            feature.coordinates.push_back(tp);
+        }
+    }
+
     bool operator()(const geometry::point<int16_t>& p) {
         feature.geometryType = GeometryType::points;
-        feature.points.push_back(transformPoint(p));
+        feature.addPoint(transformPoint(p));
         return true;
     }
     bool operator()(const geometry::line_string<int16_t>& geom) {
         feature.geometryType = GeometryType::lines;
-        feature.lines.emplace_back();
-        Line& line = feature.lines.back();
-        for (const auto& p : geom) {
-            auto tp = transformPoint(p);
-            if (line.size() > 0 && tp == line.back()) { continue; }
-            line.push_back(tp);
-        }
+        addPoints(geom);
+        feature.endLine();
         return true;
     }
     bool operator()(const geometry::polygon<int16_t>& geom) {
         feature.geometryType = GeometryType::polygons;
-        feature.polygons.emplace_back();
+        feature.beginPolygon();
         for (const auto& ring : geom) {
-            feature.polygons.back().emplace_back();
-            Line& line = feature.polygons.back().back();
-            for (const auto& p : ring) {
-                auto tp = transformPoint(p);
-                if (line.size() > 0 && tp == line.back()) { continue; }
-                line.push_back(tp);
-            }
+            addPoints(ring);
+            feature.endRing();
         }
         return true;
     }
@@ -369,20 +1156,76 @@ struct add_geometry {
 std::shared_ptr<TileData> ClientDataSource::parse(const TileTask& _task) const {
 
     std::lock_guard<std::mutex> lock(m_mutexStore);
+    const auto& store = *m_store;
+
+    if (!store.generated) { return nullptr; }
+
+    const auto opt = options();
+    const uint8_t z = _task.tileId().z;
+    const uint32_t x = _task.tileId().x;
+    const uint32_t y = _task.tileId().y;
+    const double z2 = 1u << z;
+    const double p = double(opt.buffer) / opt.extent;
+    const vt_box tileBox = { { (x - p) / z2, (y - p) / z2 }, { (x + 1 + p) / z2, (y + 1 + p) / z2 } };
+
+    // features of nodes above and - for tiles below CLIENT_INDEX_ZOOM - within the tile
+    std::vector<uint64_t> ids;
+    int tileLevel = std::min(int(z), CLIENT_INDEX_ZOOM);
+    for (int level = 0; level <= tileLevel; level++) {
+        int shift = z - level;
+        auto it = store.index[level].find(nodeKey(x >> shift, y >> shift, level));
+        if (it != store.index[level].end()) { ids.insert(ids.end(), it->second.begin(), it->second.end()); }
+    }
+    for (int level = tileLevel + 1; level <= CLIENT_INDEX_ZOOM; level++) {
+        int shift = level - z;
+        uint32_t mask = (1u << level) - 1;
+        for (const auto& node : store.index[level]) {
+            if (((node.first & mask) >> shift) == x && ((node.first >> level) >> shift) == y) {
+                ids.insert(ids.end(), node.second.begin(), node.second.end());
+            }
+        }
+    }
+    // features spanning several nodes are listed in each
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    vt_features source;
+    vt_features mapped;
+    vt_box bounds = { { 2, 1 }, { -1, 0 } };
+    for (uint64_t id : ids) {
+        const auto& entry = store.entries[id];
+        if (!intersects(entry.bbox, tileBox)) { continue; }
+        for (const auto& feature : store.getFeatures(entry, id, mapped)) {
+            if (!intersects(feature.bbox, tileBox)) { continue; }
+            source.push_back(feature);
+            bounds.min.x = std::min(bounds.min.x, feature.bbox.min.x);
+            bounds.min.y = std::min(bounds.min.y, feature.bbox.min.y);
+            bounds.max.x = std::max(bounds.max.x, feature.bbox.max.x);
+            bounds.max.y = std::max(bounds.max.y, feature.bbox.max.y);
+        }
+    }
 
-    auto data = std::make_shared<TileData>();
+    auto clipped = geojsonvt::detail::clip<0>(source, tileBox.min.x, tileBox.max.x, bounds.min.x, bounds.max.x);
+    clipped = geojsonvt::detail::clip<1>(clipped, tileBox.min.y, tileBox.max.y, bounds.min.y, bounds.max.y);
+
+    const double tolerance = z >= opt.maxZoom ? 0 : opt.tolerance / (z2 * opt.extent);
+    geojsonvt::detail::InternalTile tile(clipped, z, x, y, opt.extent, opt.buffer, tolerance);
 
-    if (!m_store->tiles) { return nullptr; }
-    auto tile = m_store->tiles->getTile(_task.tileId().z, _task.tileId().x, _task.tileId().y);
+    auto data = std::make_shared<TileData>();
 
     data->layers.emplace_back("");  // empty name will skip filtering by 'collection'
     Layer& layer = data->layers.back();
 
-    for (auto& it : tile.features) {
+    for (auto& it : tile.tile.features) {
         Feature feature(m_id);
 
         if (geometry::geometry<int16_t>::visit(it.geometry, add_geometry{ feature })) {
-            feature.props = m_store->properties[it.id.get<uint64_t>()];
+            if (it.id.is<int64_t>()) {
+                feature.props = store.getProperties(it.id.get<int64_t>());
+                feature.props.set("label_placement", 1.0);
+            } else {
+                feature.props = store.getProperties(it.id.get<uint64_t>());
+            }
             layer.features.emplace_back(std::move(feature));
         }
     }
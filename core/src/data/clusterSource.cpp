@@ -0,0 +1,341 @@
+#include "data/clusterSource.h"
+
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "tile/tileTask.h"
+#include "util/objectPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+// zooms of which the clusters are kept, the zoom in view and e.g. the zoom of proxy tiles
+#define MAX_CLUSTER_LEVELS 2
+// points in the leaves of the spatial index
+#define CLUSTER_INDEX_NODE_SIZE 64
+// bits of the zoom in cluster ids
+#define CLUSTER_ID_ZOOM_BITS 5
+
+namespace Tangram {
+
+struct ClusterSource::Point {
+    // projected to [0, 1], y to the south
+    double x, y;
+    Properties props;
+};
+
+namespace {
+
+/* Static kd-tree over points, sorted once and queried by box */
+class ClusterIndex {
+
+public:
+
+    template<typename GetPoint>
+    ClusterIndex(size_t _count, GetPoint _getPoint) {
+        m_ids.resize(_count);
+        m_coords.resize(_count * 2);
+        for (size_t i = 0; i < _count; i++) {
+            m_ids[i] = uint32_t(i);
+            glm::dvec2 p = _getPoint(i);
+            m_coords[2 * i] = p.x;
+            m_coords[2 * i + 1] = p.y;
+        }
+        if (_count > 0) { sort(0, _count - 1, 0); }
+    }
+
+    // Call @_fn with the ids of the points within the box
+    template<typename Fn>
+    void range(double _minX, double _minY, double _maxX, double _maxY, Fn _fn) const {
+        if (m_ids.empty()) { return; }
+
+        struct Node { size_t left, right; int axis; };
+        std::vector<Node> stack = { { 0, m_ids.size() - 1, 0 } };
+
+        while (!stack.empty()) {
+            Node node = stack.back();
+            stack.pop_back();
+
+            if (node.right - node.left <= CLUSTER_INDEX_NODE_SIZE) {
+                for (size_t i = node.left; i <= node.right; i++) {
+                    if (inside(i, _minX, _minY, _maxX, _maxY)) { _fn(m_ids[i]); }
+                }
+                continue;
+            }
+
+            size_t m = (node.left + node.right) >> 1;
+            if (inside(m, _minX, _minY, _maxX, _maxY)) { _fn(m_ids[m]); }
+
+            double c = m_coords[2 * m + node.axis];
+            if ((node.axis == 0 ? _minX : _minY) <= c && m > node.left) {
+                stack.push_back({ node.left, m - 1, 1 - node.axis });
+            }
+            if ((node.axis == 0 ? _maxX : _maxY) >= c) {
+                stack.push_back({ m + 1, node.right, 1 - node.axis });
+            }
+        }
+    }
+
+private:
+
+    bool inside(size_t _i, double _minX, double _minY, double _maxX, double _maxY) const {
+        double x = m_coords[2 * _i], y = m_coords[2 * _i + 1];
+        return x >= _minX && x <= _maxX && y >= _minY && y <= _maxY;
+    }
+
+    // Median split of [_left, _right] on @_axis, alternating axes below
+    void sort(size_t _left, size_t _right, int _axis) {
+        if (_right - _left <= CLUSTER_INDEX_NODE_SIZE) { return; }
+
+        size_t m = (_left + _right) >> 1;
+        std::vector<uint32_t> order(_right - _left + 1);
+        for (size_t i = 0; i < order.size(); i++) { order[i] = uint32_t(_left + i); }
+        std::nth_element(order.begin(), order.begin() + (m - _left), order.end(),
+                         [&](uint32_t a, uint32_t b) { return m_coords[2 * a + _axis] < m_coords[2 * b + _axis]; });
+
+        std::vector<uint32_t> ids(order.size());
+        std::vector<double> coords(order.size() * 2);
+        for (size_t i = 0; i < order.size(); i++) {
+            ids[i] = m_ids[order[i]];
+            coords[2 * i] = m_coords[2 * order[i]];
+            coords[2 * i + 1] = m_coords[2 * order[i] + 1];
+        }
+        std::copy(ids.begin(), ids.end(), m_ids.begin() + _left);
+        std::copy(coords.begin(), coords.end(), m_coords.begin() + 2 * _left);
+
+        sort(_left, m - 1, 1 - _axis);
+        sort(m + 1, _right, 1 - _axis);
+    }
+
+    std::vector<uint32_t> m_ids;
+    std::vector<double> m_coords;
+};
+
+struct Cluster {
+    double x, y;
+    uint32_t count;
+    // first point of the cluster, the point of clusters of one point
+    uint32_t point;
+};
+
+}
+
+struct ClusterSource::Level {
+    int zoom = 0;
+    std::vector<Cluster> clusters;
+    std::unique_ptr<ClusterIndex> index;
+};
+
+struct ClusterSource::Storage {
+    std::shared_ptr<const std::vector<Point>> points;
+    // index of points, built with the first level
+    std::unique_ptr<ClusterIndex> pointIndex;
+    // most recently used last
+    std::vector<std::shared_ptr<const Level>> levels;
+};
+
+static glm::dvec2 project(LngLat _lngLat) {
+    double sine = std::sin(_lngLat.latitude * M_PI / 180.0);
+    double y = 0.5 - 0.25 * std::log((1 + sine) / (1 - sine)) / M_PI;
+    return { _lngLat.longitude / 360.0 + 0.5, std::min(std::max(y, 0.0), 1.0) };
+}
+
+ClusterSource::ClusterSource(const std::string& _name, Options _options,
+                             TileSource::ZoomOptions _zoomOptions)
+    : TileSource(_name, nullptr, _zoomOptions),
+      m_store(std::make_unique<Storage>()),
+      m_points(std::make_shared<std::vector<Point>>()),
+      m_options(_options) {
+
+    m_generateGeometry = true;
+    m_options.maxZoom = std::min(m_options.maxZoom, int32_t(1 << CLUSTER_ID_ZOOM_BITS) - 2);
+}
+
+ClusterSource::~ClusterSource() {}
+
+std::shared_ptr<TileTask> ClusterSource::createTask(TileID _tileId) {
+    auto task = m_taskPool->make<TileTask>(_tileId, this);
+    addRasterTasks(*task);
+    return task;
+}
+
+void ClusterSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+
+    if (_task->needsLoading()) {
+        _task->startedLoading();
+
+        _cb.func(_task);
+    }
+
+    // Load subsources
+    TileSource::loadTileData(_task, _cb);
+}
+
+uint64_t ClusterSource::addPoint(Properties&& _properties, LngLat _coordinates) {
+
+    if (m_published) {
+        m_points = std::make_shared<std::vector<Point>>(*m_points);
+        m_published = false;
+    }
+    glm::dvec2 p = project(_coordinates);
+    m_points->push_back({ p.x, p.y, std::move(_properties) });
+    return m_points->size() - 1;
+}
+
+uint64_t ClusterSource::addPoints(const double* _coordinates, size_t _count) {
+
+    if (m_published) {
+        m_points = std::make_shared<std::vector<Point>>(*m_points);
+        m_published = false;
+    }
+    uint64_t first = m_points->size();
+    m_points->reserve(m_points->size() + _count);
+    for (size_t i = 0; i < _count; i++) {
+        glm::dvec2 p = project({ _coordinates[2 * i], _coordinates[2 * i + 1] });
+        m_points->push_back({ p.x, p.y, Properties() });
+    }
+    return first;
+}
+
+void ClusterSource::clearPoints() {
+    m_points = std::make_shared<std::vector<Point>>();
+    m_published = false;
+}
+
+void ClusterSource::generateClusters() {
+
+    auto store = std::make_unique<Storage>();
+    store->points = m_points;
+    m_published = true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+        m_store = std::move(store);
+    }
+    m_generation++;
+}
+
+// Greedily merge points within the radius at @_zoom, in the order they were added
+static void clusterPoints(ClusterSource::Options _options, int _zoom, int _tileSize, size_t _count,
+                          const ClusterIndex& _index, const std::function<glm::dvec2(size_t)>& _getPoint,
+                          std::vector<Cluster>& _clusters) {
+
+    const double r = _options.radius / (_tileSize * std::pow(2.0, _zoom));
+    std::vector<bool> visited(_count, false);
+    std::vector<uint32_t> neighbors;
+
+    for (size_t i = 0; i < _count; i++) {
+        if (visited[i]) { continue; }
+        visited[i] = true;
+
+        glm::dvec2 p = _getPoint(i);
+        neighbors.clear();
+        _index.range(p.x - r, p.y - r, p.x + r, p.y + r, [&](uint32_t j) {
+            if (visited[j]) { return; }
+            glm::dvec2 q = _getPoint(j);
+            if ((q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y) <= r * r) { neighbors.push_back(j); }
+        });
+
+        if (neighbors.size() + 1 < _options.minPoints) {
+            _clusters.push_back({ p.x, p.y, 1, uint32_t(i) });
+            continue;
+        }
+        glm::dvec2 sum = p;
+        for (uint32_t j : neighbors) {
+            visited[j] = true;
+            sum += _getPoint(j);
+        }
+        uint32_t count = uint32_t(neighbors.size() + 1);
+        _clusters.push_back({ sum.x / count, sum.y / count, count, uint32_t(i) });
+    }
+}
+
+std::shared_ptr<TileData> ClusterSource::parse(const TileTask& _task) const {
+
+    const TileID& tileId = _task.tileId();
+    // all zooms above maxZoom share the level of unclustered points
+    const int zoom = std::min(int(tileId.z), m_options.maxZoom + 1);
+
+    std::shared_ptr<const std::vector<Point>> points;
+    std::shared_ptr<const Level> level;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexStore);
+        auto& store = *m_store;
+        if (!store.points) { return nullptr; }
+        points = store.points;
+
+        auto it = std::find_if(store.levels.begin(), store.levels.end(),
+                               [&](auto& l) { return l->zoom == zoom; });
+        if (it != store.levels.end()) {
+            level = *it;
+            store.levels.erase(it);
+        } else {
+            auto getPoint = [&](size_t i) { return glm::dvec2((*points)[i].x, (*points)[i].y); };
+            if (!store.pointIndex) {
+                store.pointIndex = std::make_unique<ClusterIndex>(points->size(), getPoint);
+            }
+
+            auto newLevel = std::make_shared<Level>();
+            newLevel->zoom = zoom;
+            if (zoom > m_options.maxZoom) {
+                for (size_t i = 0; i < points->size(); i++) {
+                    newLevel->clusters.push_back({ (*points)[i].x, (*points)[i].y, 1, uint32_t(i) });
+                }
+            } else {
+                clusterPoints(m_options, zoom, 256 << m_zoomOptions.zoomBias, points->size(),
+                              *store.pointIndex, getPoint, newLevel->clusters);
+            }
+            const auto& clusters = newLevel->clusters;
+            newLevel->index = std::make_unique<ClusterIndex>(clusters.size(), [&](size_t i) {
+                return glm::dvec2(clusters[i].x, clusters[i].y);
+            });
+            level = newLevel;
+
+            if (store.levels.size() >= MAX_CLUSTER_LEVELS) { store.levels.erase(store.levels.begin()); }
+        }
+        store.levels.push_back(level);
+    }
+
+    const double z2 = double(1u << tileId.z);
+    const double minX = tileId.x / z2, minY = tileId.y / z2;
+    const double maxX = (tileId.x + 1) / z2, maxY = (tileId.y + 1) / z2;
+
+    auto data = std::make_shared<TileData>();
+
+    data->layers.emplace_back("");  // empty name will skip filtering by 'collection'
+    Layer& layer = data->layers.back();
+
+    level->index->range(minX, minY, maxX, maxY, [&](uint32_t i) {
+        const auto& cluster = level->clusters[i];
+        // points on the edge belong to the tile east or south of it
+        if (cluster.x >= maxX || cluster.y >= maxY) { return; }
+
+        Feature feature(m_id);
+        feature.geometryType = GeometryType::points;
+        feature.addPoint({ cluster.x * z2 - tileId.x, 1. - (cluster.y * z2 - tileId.y) });
+        if (cluster.count == 1) {
+            feature.props = (*points)[cluster.point].props;
+        } else {
+            feature.props.set("point_count", double(cluster.count));
+            feature.props.set("cluster_id", double((uint64_t(i) << CLUSTER_ID_ZOOM_BITS) | uint64_t(level->zoom)));
+        }
+        layer.features.emplace_back(std::move(feature));
+    });
+
+    return data;
+}
+
+uint32_t ClusterSource::clusterPointCount(uint64_t _clusterId) const {
+
+    int zoom = int(_clusterId & ((1u << CLUSTER_ID_ZOOM_BITS) - 1));
+    uint64_t index = _clusterId >> CLUSTER_ID_ZOOM_BITS;
+
+    std::lock_guard<std::mutex> lock(m_mutexStore);
+    for (auto& level : m_store->levels) {
+        if (level->zoom == zoom && index < level->clusters.size()) { return level->clusters[index].count; }
+    }
+    return 0;
+}
+
+}
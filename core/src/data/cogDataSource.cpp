@@ -0,0 +1,662 @@
+#include "data/cogDataSource.h"
+
+#include "log.h"
+#include "platform.h"
+#include "tile/tileAvailability.h"
+#include "tile/tileTask.h"
+#include "util/geoTiff.h"
+#include "util/ioExecutor.h"
+#include "util/mapProjection.h"
+#include "util/mappedFile.h"
+#include "util/url.h"
+#include "util/zlibHelper.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace Tangram {
+
+// Bytes read on first access; COG writers place the directories of all images at the start
+static constexpr uint32_t HEADER_FETCH_BYTES = 65536;
+
+// Largest part of the file read for the directories, e.g. with the block offsets of huge images
+static constexpr uint64_t MAX_HEADER_BYTES = 32 * 1024 * 1024;
+
+// Default memory budget of decoded blocks
+static constexpr size_t BLOCK_CACHE_BYTES = 32 * 1024 * 1024;
+
+// Most blocks read for one tile, e.g. of an image with small blocks
+static constexpr size_t MAX_TILE_BLOCKS = 64;
+
+// Largest compressed block
+static constexpr uint64_t MAX_BLOCK_BYTES = 64 * 1024 * 1024;
+
+// Time to collect HTTP block reads before merging them into range requests
+static constexpr int BLOCK_READ_WINDOW_MS = 10;
+
+// Number of collected block reads that triggers merging without waiting
+static constexpr size_t MAX_QUEUED_BLOCK_READS = 64;
+
+// Largest gap between blocks that are read with one range request; reading the gap is cheaper
+// than the round trip of another request
+static constexpr uint64_t MAX_BLOCK_READ_GAP = 64 * 1024;
+
+// Largest merged range request
+static constexpr uint64_t MAX_BLOCK_READ_BYTES = 4 * 1024 * 1024;
+
+struct COGDataSource::Lookup {
+    std::shared_ptr<TileTask> task;
+    TileTaskCb cb;
+    std::shared_ptr<const GeoTiff> tiff;
+    // Index of the image the tile is rendered from
+    size_t image = 0;
+    // Pixel coordinates in the image of the centers of the columns and rows of the tile
+    std::vector<double> columns;
+    std::vector<double> rows;
+    // Blocks that cover the tile, in rows from @blockX, @blockY; null for blocks without data
+    uint32_t blockX = 0;
+    uint32_t blockY = 0;
+    uint32_t blocksAcross = 0;
+    uint32_t blocksDown = 0;
+    std::vector<std::shared_ptr<const GeoTiffBlock>> blocks;
+    // Blocks being read. Accessed on the worker queue.
+    size_t pending = 0;
+    bool failed = false;
+};
+
+// Cache key of block @_index of image @_image
+static uint64_t blockKey(size_t _image, size_t _index) { return (uint64_t(_image) << 40) | _index; }
+
+COGDataSource::COGDataSource(Platform& _platform, const std::string& _path)
+    : m_platform(_platform),
+      m_path(_path),
+      m_maxBlockBytes(BLOCK_CACHE_BYTES) {
+
+    m_isHttp = (_path.substr(0, 7) == "http://" || _path.substr(0, 8) == "https://");
+
+    // Map local files once; blocks are then read without syscalls
+    if (!m_isHttp) {
+        m_path = Url(_path).path();
+        m_file = std::make_unique<MappedFile>();
+        if (m_file->open(m_path)) {
+            m_file->adviseRandom();
+        } else {
+            LOGW("COG: Cannot map %s, using file reads", m_path.c_str());
+        }
+    }
+
+    m_worker = std::make_unique<IOQueue>();
+
+    LOGD("COGDataSource created for: %s (HTTP: %d)", _path.c_str(), m_isHttp);
+}
+
+COGDataSource::~COGDataSource() {
+    // Stop the worker before the state used by queued continuations goes away
+    m_worker.reset();
+}
+
+void COGDataSource::clear() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Keep blocks being read, their lookups are continued when done
+        evictBlocks(0);
+
+        // A pending load still resumes its waiting lookups
+        if (m_headerState != HeaderState::loading) {
+            m_tiff.reset();
+            m_headerState = HeaderState::none;
+        }
+    }
+    if (next) { next->clear(); }
+}
+
+size_t COGDataSource::cacheUsage() const {
+    size_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bytes = m_blockBytes;
+    }
+    return bytes + (next ? next->cacheUsage() : 0);
+}
+
+void COGDataSource::setCacheSize(size_t _cacheSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBlockBytes = _cacheSize;
+    evictBlocks(_cacheSize);
+}
+
+size_t COGDataSource::cacheSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_maxBlockBytes;
+}
+
+void COGDataSource::trimCache(size_t _bytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evictBlocks(_bytes);
+    }
+    if (next) { next->trimCache(_bytes); }
+}
+
+void COGDataSource::evictBlocks(size_t _bytes) {
+    while (m_blockBytes > _bytes && !m_blockLru.empty()) {
+        auto last = m_blocks.find(m_blockLru.back());
+        m_blockBytes -= last->second.bytes;
+        m_blocks.erase(last);
+        m_blockLru.pop_back();
+    }
+}
+
+void COGDataSource::readRange(uint64_t _offset, uint32_t _length, const std::shared_ptr<TileTask>& _task,
+                              ReadCallback _cb) {
+    if (m_isHttp) {
+        HttpOptions options;
+        options.addHeader("Range", "bytes=" + std::to_string(_offset) + "-" +
+                          std::to_string(_offset + _length - 1));
+
+        // Blocks are shared by tiles, so the read completes even when its task is canceled
+        auto callback = [this, task = _task, _offset, _length, _cb](UrlResponse&& response) {
+            auto prana = task->prana();  // lock Scene when running callback on thread
+            if (!prana) {
+                LOGW("COG: URL callback for deleted Scene");
+                return;
+            }
+
+            bool ok = false;
+            std::vector<char> data;
+            if (response.error) {
+                LOGE("COG: HTTP range request failed: %s", response.error);
+            } else if (!response.content.empty()) {
+                data = std::move(response.content);
+                ok = true;
+                if (data.size() > _length && data.size() >= _offset + _length) {
+                    // Server ignored the Range header and sent the whole file
+                    data.erase(data.begin() + _offset + _length, data.end());
+                    data.erase(data.begin(), data.begin() + _offset);
+                }
+            }
+
+            // Decoding runs on the worker, not on the network thread
+            m_worker->enqueue([task, ok, data = std::move(data), _cb]() {
+                auto prana = task->prana();
+                if (!prana) { return; }
+                _cb(ok, data.data(), data.size());
+            });
+        };
+
+        m_platform.startUrlRequest(Url(m_path), options, std::move(callback));
+        return;
+    }
+
+    // Read from the mapping on the worker: page faults should not block the calling thread
+    m_worker->enqueue([this, task = _task, _offset, _length, _cb]() {
+        auto prana = task->prana();
+        if (!prana) { return; }
+
+        if (m_file && m_file->isOpen()) {
+            if (_offset >= m_file->size()) {
+                LOGE("COG: Offset %" PRIu64 " beyond end of file: %s", _offset, m_path.c_str());
+                _cb(false, nullptr, 0);
+                return;
+            }
+            _cb(true, m_file->data() + _offset, size_t(std::min<uint64_t>(_length, m_file->size() - _offset)));
+            return;
+        }
+
+        // Fall back to file I/O when the file could not be mapped
+        std::ifstream file(m_path, std::ios::binary);
+        file.seekg(_offset);
+        if (!file.good()) {
+            LOGE("COG: Failed to read at offset %" PRIu64 " of file: %s", _offset, m_path.c_str());
+            _cb(false, nullptr, 0);
+            return;
+        }
+        std::vector<char> data(_length);
+        file.read(data.data(), _length);
+        _cb(true, data.data(), size_t(file.gcount()));
+    });
+}
+
+void COGDataSource::loadHeader(const std::shared_ptr<TileTask>& _task, uint32_t _length) {
+    readRange(0, _length, _task, [this, _task, _length](bool ok, const char* data, size_t size) {
+        auto tiff = std::make_shared<GeoTiff>();
+        uint64_t needed = 0;
+        GeoTiffResult result = ok ? parseGeoTiff(data, size, *tiff, needed) : GeoTiffResult::invalid;
+
+        if (result == GeoTiffResult::needMoreData && size == _length && needed <= MAX_HEADER_BYTES) {
+            // Directories reach beyond the first read
+            loadHeader(_task, uint32_t(std::min(std::max<uint64_t>(needed, 2 * uint64_t(_length)), MAX_HEADER_BYTES)));
+            return;
+        }
+        if (result != GeoTiffResult::ok) {
+            LOGE("COG: Failed to read directories of %s", m_path.c_str());
+            finishHeader(nullptr);
+            return;
+        }
+
+        const GeoTiffImage& full = tiff->images[0];
+        LOGD("COG header loaded: %ux%u pixels in blocks of %ux%u, %zu overviews, compression: %d",
+             full.width, full.height, full.blockWidth, full.blockHeight, tiff->images.size() - 1,
+             full.compression);
+
+        // Tiles outside of the image are not requested, unless the next source may have them; tiles
+        // beyond the resolution of the image are overzoomed from the deepest tile
+        auto source = _task->source();
+        if (!next && source) {
+            double west = tiff->originX, north = tiff->originY;
+            double east = west + tiff->pixelWidth * full.width;
+            double south = north - tiff->pixelHeight * full.height;
+            LngLat min, max;
+            double pixelMeters = tiff->pixelWidth;
+            if (tiff->crs == GeoTiffCRS::lngLat) {
+                min = LngLat(west, std::max(south, -MapProjection::MAX_LATITUDE_DEGREES));
+                max = LngLat(east, std::min(north, MapProjection::MAX_LATITUDE_DEGREES));
+                pixelMeters *= MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS / 180.0;
+            } else {
+                min = MapProjection::projectedMetersToLngLat({ west, south });
+                max = MapProjection::projectedMetersToLngLat({ east, north });
+            }
+            double zoom = std::log2(MapProjection::metersPerTileAtZoom(0) / (TILE_SIZE * pixelMeters));
+            auto& availability = source->availability();
+            availability.setZoomRange(0, std::max(0, std::min(int(std::ceil(zoom - 0.01)), 30)));
+            availability.setBounds(min, max);
+        }
+
+        finishHeader(tiff);
+    });
+}
+
+void COGDataSource::finishHeader(std::shared_ptr<const GeoTiff> _tiff) {
+    std::vector<std::shared_ptr<Lookup>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tiff = _tiff;
+        // Retry with the next lookup on failure
+        m_headerState = _tiff ? HeaderState::ready : HeaderState::none;
+        waiting.swap(m_waiting);
+    }
+
+    for (auto& lookup : waiting) {
+        if (_tiff) {
+            lookup->tiff = _tiff;
+            lookupTile(std::move(lookup));
+        } else {
+            finishLookup(std::move(lookup), false);
+        }
+    }
+}
+
+void COGDataSource::lookupTile(std::shared_ptr<Lookup> _lookup) {
+    if (_lookup->task->isCanceled()) { return; }
+
+    const GeoTiff& tiff = *_lookup->tiff;
+    const TileID& tileId = _lookup->task->tileId();
+
+    // Coordinates of the centers of the columns and rows of the tile in the CRS of the image
+    BoundingBox bounds = MapProjection::tileBounds(tileId);
+    double step = bounds.width() / TILE_SIZE;
+    std::vector<ProjectedMeters> meters(TILE_SIZE);
+    for (int i = 0; i < TILE_SIZE; i++) {
+        meters[i] = { bounds.min.x + (i + 0.5) * step, bounds.max.y - (i + 0.5) * step };
+    }
+    if (tiff.crs == GeoTiffCRS::lngLat) {
+        // Longitudes only depend on x and latitudes on y, so one point per column and row will do
+        std::vector<LngLat> lngLats(TILE_SIZE);
+        MapProjection::projectedMetersToLngLat(meters.data(), lngLats.data(), TILE_SIZE);
+        for (int i = 0; i < TILE_SIZE; i++) { meters[i] = { lngLats[i].longitude, lngLats[i].latitude }; }
+    }
+
+    // Coarsest image with pixels no larger than those of the tile
+    double tilePixel = (meters.back().x - meters.front().x) / (TILE_SIZE - 1);
+    size_t imageIndex = 0;
+    for (size_t i = tiff.images.size(); i-- > 1;) {
+        if (tiff.pixelWidthOf(tiff.images[i]) <= tilePixel * 1.01) {
+            imageIndex = i;
+            break;
+        }
+    }
+    const GeoTiffImage& image = tiff.images[imageIndex];
+    _lookup->image = imageIndex;
+
+    double pixelWidth = tiff.pixelWidthOf(image), pixelHeight = tiff.pixelHeightOf(image);
+    _lookup->columns.resize(TILE_SIZE);
+    _lookup->rows.resize(TILE_SIZE);
+    for (int i = 0; i < TILE_SIZE; i++) {
+        _lookup->columns[i] = (meters[i].x - tiff.originX) / pixelWidth - 0.5;
+        _lookup->rows[i] = (tiff.originY - meters[i].y) / pixelHeight - 0.5;
+    }
+
+    // Pixels sampled for the tile, with their neighbors for interpolation
+    double x0 = std::floor(_lookup->columns.front()), x1 = std::floor(_lookup->columns.back()) + 1;
+    double y0 = std::floor(_lookup->rows.front()), y1 = std::floor(_lookup->rows.back()) + 1;
+    if (x1 < 0 || y1 < 0 || x0 >= image.width || y0 >= image.height) {
+        auto source = _lookup->task->source();
+        if (!next && source) { source->availability().setMissing(tileId); }
+        finishLookup(std::move(_lookup), false);
+        return;
+    }
+    uint32_t px0 = uint32_t(std::max(x0, 0.0)), px1 = uint32_t(std::min(x1, image.width - 1.0));
+    uint32_t py0 = uint32_t(std::max(y0, 0.0)), py1 = uint32_t(std::min(y1, image.height - 1.0));
+
+    _lookup->blockX = px0 / image.blockWidth;
+    _lookup->blockY = py0 / image.blockHeight;
+    _lookup->blocksAcross = px1 / image.blockWidth - _lookup->blockX + 1;
+    _lookup->blocksDown = py1 / image.blockHeight - _lookup->blockY + 1;
+    size_t numBlocks = size_t(_lookup->blocksAcross) * _lookup->blocksDown;
+    if (numBlocks > MAX_TILE_BLOCKS) {
+        LOGW("COG: Tile %s needs %zu blocks", tileId.toString().c_str(), numBlocks);
+        finishLookup(std::move(_lookup), false);
+        return;
+    }
+    _lookup->blocks.assign(numBlocks, nullptr);
+
+    std::vector<BlockRead> reads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t by = 0; by < _lookup->blocksDown; by++) {
+            for (uint32_t bx = 0; bx < _lookup->blocksAcross; bx++) {
+                size_t index = size_t(_lookup->blockY + by) * image.blocksAcross() + _lookup->blockX + bx;
+                uint64_t size = image.blockSizes[index];
+                // Sparse files leave out blocks without data
+                if (size == 0) { continue; }
+
+                uint64_t key = blockKey(imageIndex, index);
+                auto it = m_blocks.find(key);
+                if (it != m_blocks.end() && it->second.block) {
+                    m_blockLru.splice(m_blockLru.begin(), m_blockLru, it->second.lru);
+                    _lookup->blocks[by * _lookup->blocksAcross + bx] = it->second.block;
+                    continue;
+                }
+                if (it == m_blocks.end()) {
+                    if (size > MAX_BLOCK_BYTES) {
+                        _lookup->failed = true;
+                        continue;
+                    }
+                    reads.push_back({ _lookup->task, _lookup->tiff, key, image.blockOffsets[index], uint32_t(size) });
+                }
+                // Already being read for another lookup, or read for this one
+                m_blocks[key].waiting.push_back(_lookup);
+                _lookup->pending++;
+            }
+        }
+    }
+
+    if (_lookup->pending == 0) {
+        renderTile(_lookup);
+        return;
+    }
+
+    for (auto& read : reads) {
+        if (m_isHttp) {
+            // Group with reads of neighboring blocks
+            queueBlockRead(std::move(read));
+        } else {
+            readRange(read.offset, read.length, read.task,
+                      [this, tiff = read.tiff, key = read.key](bool ok, const char* data, size_t size) {
+                decodeBlock(*tiff, key, ok, data, size);
+            });
+        }
+    }
+}
+
+void COGDataSource::queueBlockRead(BlockRead _read) {
+    bool schedule = false;
+    bool flush = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_blockReads.push_back(std::move(_read));
+        flush = m_blockReads.size() >= MAX_QUEUED_BLOCK_READS;
+        schedule = !flush && !m_blockReadsScheduled;
+        if (schedule) { m_blockReadsScheduled = true; }
+    }
+
+    if (flush) {
+        flushBlockReads();
+    } else if (schedule) {
+        // Delayed tasks run when the worker is idle, i.e. after the lookups queued with this one
+        // had a chance to add their reads
+        m_worker->enqueueDelayed([this]() { flushBlockReads(); },
+                                 std::chrono::milliseconds(BLOCK_READ_WINDOW_MS));
+    }
+}
+
+void COGDataSource::flushBlockReads() {
+    std::vector<BlockRead> reads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        reads.swap(m_blockReads);
+        m_blockReadsScheduled = false;
+
+        // Drop reads of blocks which no tile needs anymore
+        reads.erase(std::remove_if(reads.begin(), reads.end(), [this](const BlockRead& read) {
+            auto it = m_blocks.find(read.key);
+            if (it == m_blocks.end()) { return true; }
+            auto& waiting = it->second.waiting;
+            bool needed = std::any_of(waiting.begin(), waiting.end(),
+                                      [](auto& lookup) { return !lookup->task->isCanceled(); });
+            if (!needed) { m_blocks.erase(it); }
+            return !needed;
+        }), reads.end());
+    }
+    if (reads.empty()) { return; }
+
+    std::sort(reads.begin(), reads.end(), [](const BlockRead& a, const BlockRead& b) {
+        return a.offset < b.offset;
+    });
+
+    // Merge blocks into one range while gaps are small, then read each range once and hand every
+    // block its part of the response
+    size_t first = 0;
+    while (first < reads.size()) {
+        uint64_t start = reads[first].offset;
+        uint64_t end = start + reads[first].length;
+        size_t last = first + 1;
+        while (last < reads.size()) {
+            const auto& read = reads[last];
+            uint64_t readEnd = std::max(end, read.offset + read.length);
+            if (read.offset > end + MAX_BLOCK_READ_GAP || readEnd - start > MAX_BLOCK_READ_BYTES) { break; }
+            end = readEnd;
+            last++;
+        }
+
+        auto group = std::make_shared<std::vector<BlockRead>>(reads.begin() + first, reads.begin() + last);
+        readRange(start, uint32_t(end - start), group->front().task,
+                  [this, group, start](bool ok, const char* data, size_t size) {
+            for (const auto& read : *group) {
+                uint64_t begin = read.offset - start;
+                bool inRange = ok && begin + read.length <= size;
+                decodeBlock(*read.tiff, read.key, inRange, inRange ? data + begin : nullptr,
+                            inRange ? read.length : 0);
+            }
+        });
+        first = last;
+    }
+}
+
+void COGDataSource::decodeBlock(const GeoTiff& _tiff, uint64_t _key, bool _ok, const char* _data, size_t _size) {
+    std::shared_ptr<GeoTiffBlock> block;
+    if (_ok) {
+        block = std::make_shared<GeoTiffBlock>();
+        const GeoTiffImage& image = _tiff.images[_key >> 40];
+        if (!decodeGeoTiffBlock(_tiff, image, _data, _size, *block)) {
+            LOGE("COG: Failed to decode block %" PRIu64 " of image %" PRIu64, _key & ((uint64_t(1) << 40) - 1),
+                 _key >> 40);
+            block.reset();
+        }
+    } else {
+        LOGE("COG: Failed to read block of %s", m_path.c_str());
+    }
+    finishBlock(_key, std::move(block));
+}
+
+void COGDataSource::finishBlock(uint64_t _key, std::shared_ptr<const GeoTiffBlock> _block) {
+    std::vector<std::shared_ptr<Lookup>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_blocks.find(_key);
+        if (it == m_blocks.end()) { return; }
+
+        BlockEntry& entry = it->second;
+        waiting.swap(entry.waiting);
+
+        if (!_block) {
+            // Read again for the next lookup
+            m_blocks.erase(it);
+        } else {
+            entry.block = _block;
+            entry.bytes = sizeof(BlockEntry) + sizeof(GeoTiffBlock) + _block->memoryUsage();
+            m_blockLru.push_front(_key);
+            entry.lru = m_blockLru.begin();
+            m_blockBytes += entry.bytes;
+
+            // Evict least recently used blocks, keeping at least this one
+            while (m_blockBytes > m_maxBlockBytes && m_blockLru.size() > 1) {
+                auto last = m_blocks.find(m_blockLru.back());
+                m_blockBytes -= last->second.bytes;
+                m_blocks.erase(last);
+                m_blockLru.pop_back();
+            }
+        }
+    }
+
+    for (auto& lookup : waiting) {
+        const GeoTiffImage& image = lookup->tiff->images[lookup->image];
+        size_t index = _key & ((uint64_t(1) << 40) - 1);
+        uint32_t bx = index % image.blocksAcross() - lookup->blockX;
+        uint32_t by = index / image.blocksAcross() - lookup->blockY;
+        if (_block) {
+            lookup->blocks[by * lookup->blocksAcross + bx] = _block;
+        } else {
+            lookup->failed = true;
+        }
+        if (--lookup->pending == 0) { renderTile(lookup); }
+    }
+}
+
+void COGDataSource::renderTile(const std::shared_ptr<Lookup>& _lookup) {
+    auto& task = static_cast<BinaryTileTask&>(*_lookup->task);
+    if (task.isCanceled()) { return; }
+    if (_lookup->failed) {
+        finishLookup(_lookup, false);
+        return;
+    }
+
+    const Lookup& lookup = *_lookup;
+    const GeoTiffImage& image = lookup.tiff->images[lookup.image];
+    int width = int(image.width), height = int(image.height);
+
+    // Block of pixel @x, @y of the image, null if there is none
+    auto blockAt = [&](int x, int y) -> const GeoTiffBlock* {
+        if (x < 0 || y < 0 || x >= width || y >= height) { return nullptr; }
+        uint32_t bx = x / image.blockWidth - lookup.blockX, by = y / image.blockHeight - lookup.blockY;
+        return lookup.blocks[by * lookup.blocksAcross + bx].get();
+    };
+
+    bool hasData = false;
+    auto data = pooledBuffer();
+
+    if (image.isFloat()) {
+        // Interpolate elevation between the pixels that have data
+        std::vector<float> pixels(TILE_SIZE * TILE_SIZE);
+        for (int j = 0; j < TILE_SIZE; j++) {
+            double row = lookup.rows[j];
+            int y = int(std::floor(row));
+            double fy = row - y;
+            for (int i = 0; i < TILE_SIZE; i++) {
+                double column = lookup.columns[i];
+                int x = int(std::floor(column));
+                double fx = column - x;
+                double sum = 0, weight = 0;
+                for (int dy = 0; dy < 2; dy++) {
+                    for (int dx = 0; dx < 2; dx++) {
+                        double w = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy);
+                        const GeoTiffBlock* block = w > 0 ? blockAt(x + dx, y + dy) : nullptr;
+                        if (!block) { continue; }
+                        int bx = (x + dx) % image.blockWidth, by = (y + dy) % image.blockHeight;
+                        float value = block->floats[size_t(by) * block->width + bx];
+                        if (std::isnan(value)) { continue; }
+                        sum += w * value;
+                        weight += w;
+                    }
+                }
+                pixels[j * TILE_SIZE + i] = weight > 0 ? float(sum / weight) : 0.f;
+                hasData |= weight > 0;
+            }
+        }
+        if (hasData) { encodeTiff(TILE_SIZE, TILE_SIZE, 1, true, pixels.data(), *data); }
+    } else {
+        // Nearest pixels of imagery; pixels without data are transparent
+        int samples = image.samples == 1 ? 1 : 4;
+        std::vector<uint8_t> pixels(TILE_SIZE * TILE_SIZE * samples, 0);
+        for (int j = 0; j < TILE_SIZE; j++) {
+            int y = int(std::floor(lookup.rows[j] + 0.5));
+            for (int i = 0; i < TILE_SIZE; i++) {
+                int x = int(std::floor(lookup.columns[i] + 0.5));
+                const GeoTiffBlock* block = blockAt(x, y);
+                if (!block) { continue; }
+                size_t offset = (size_t(y % image.blockHeight) * block->width + x % image.blockWidth) * image.samples;
+                const uint8_t* src = &block->bytes[offset];
+                uint8_t* dst = &pixels[(j * TILE_SIZE + i) * samples];
+                std::memcpy(dst, src, image.samples);
+                if (image.samples == 3) { dst[3] = 255; }
+                hasData = true;
+            }
+        }
+        if (hasData) { encodeTiff(TILE_SIZE, TILE_SIZE, samples, false, pixels.data(), *data); }
+    }
+
+    if (!hasData) {
+        finishLookup(_lookup, false);
+        return;
+    }
+    task.rawTileData = std::move(data);
+    finishLookup(_lookup, true);
+}
+
+void COGDataSource::finishLookup(std::shared_ptr<Lookup> _lookup, bool _found) {
+    if (!_found && next) {
+        // Try the next source in the chain, e.g. a tiled fallback
+        next->loadTileData(_lookup->task, _lookup->cb);
+        return;
+    }
+    if (_lookup->cb.func) { _lookup->cb.func(_lookup->task); }
+}
+
+bool COGDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+    auto lookup = std::make_shared<Lookup>();
+    lookup->task = _task;
+    lookup->cb = _cb;
+
+    std::shared_ptr<const GeoTiff> tiff;
+    bool startLoading = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_headerState == HeaderState::ready) {
+            tiff = m_tiff;
+        } else {
+            // Wait for the directories, read once for all lookups
+            m_waiting.push_back(lookup);
+            startLoading = (m_headerState == HeaderState::none);
+            m_headerState = HeaderState::loading;
+        }
+    }
+
+    if (tiff) {
+        lookup->tiff = tiff;
+        // Continue on the worker to avoid blocking the calling thread
+        m_worker->enqueue(_task, [this, lookup]() {
+            auto prana = lookup->task->prana();
+            if (!prana) { return; }
+            lookupTile(lookup);
+        });
+    } else if (startLoading) {
+        loadHeader(_task, HEADER_FETCH_BYTES);
+    }
+
+    return true;
+}
+
+}
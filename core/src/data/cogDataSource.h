@@ -0,0 +1,161 @@
+#pragma once
+
+#include "data/tileSource.h"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class Platform;
+class IOQueue;
+class MappedFile;
+struct GeoTiff;
+struct GeoTiffBlock;
+
+/**
+ * COGDataSource provides raster tiles from a Cloud-Optimized GeoTIFF (COG).
+ *
+ * COGs store an image and its overviews in blocks, with the directories of all
+ * images at the start of the file, so that any part of the image can be read
+ * with a few HTTP range requests - without a tile server in between.
+ *
+ * - The directories are read once; each tile is then rendered from the blocks
+ *   of the overview closest to its resolution, see util/geoTiff.h for the
+ *   supported images and compressions (deflate, LZW, JPEG and LERC)
+ * - Images in EPSG:4326 are reprojected to the Web Mercator tiles
+ * - Tiles are handed to RasterSource as uncompressed TIFF, so that imagery
+ *   and elevation decode like other raster tiles
+ * - Decoded blocks are kept in an LRU cache, as neighboring tiles and zoom
+ *   levels share blocks; concurrent tiles waiting for a block share one read
+ * - HTTP reads of blocks requested together are merged into few range requests
+ *   when the blocks are close in the file, local files are memory-mapped
+ * - Reading and decoding run on an I/O worker queue, not on the network thread
+ *
+ * Usage in scene YAML:
+ *   sources:
+ *     elevation:
+ *       type: Raster
+ *       url: https://example.com/dem.tif      # or file:///path/to/dem.tif
+ */
+class COGDataSource : public TileSource::DataSource {
+public:
+
+    COGDataSource(Platform& _platform, const std::string& _path);
+
+    ~COGDataSource() override;
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
+
+    void clear() override;
+
+    size_t cacheUsage() const override;
+    void setCacheSize(size_t _cacheSize) override;
+    size_t cacheSize() const override;
+    void trimCache(size_t _bytes) override;
+
+    /* Size of the tiles rendered from the image */
+    static constexpr int TILE_SIZE = 256;
+
+private:
+
+    /* State of a tile while its blocks are read */
+    struct Lookup;
+
+    /* Read of a block for the tile of @task */
+    struct BlockRead {
+        std::shared_ptr<TileTask> task;
+        std::shared_ptr<const GeoTiff> tiff;
+        uint64_t key;
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    /* Completion callback of readRange(), see PMTilesDataSource::ReadCallback */
+    using ReadCallback = std::function<void(bool _ok, const char* _data, size_t _size)>;
+
+    /* Read @_length bytes at @_offset of the file, calling @_cb on the worker queue; @_task
+     * keeps its Scene alive until then */
+    void readRange(uint64_t _offset, uint32_t _length, const std::shared_ptr<TileTask>& _task,
+                   ReadCallback _cb);
+
+    /* Read the first @_length bytes of the file and parse its directories, reading more if
+     * they reach further */
+    void loadHeader(const std::shared_ptr<TileTask>& _task, uint32_t _length);
+
+    /* Set the result of loadHeader(), nullptr on failure, and resume the waiting lookups */
+    void finishHeader(std::shared_ptr<const GeoTiff> _tiff);
+
+    /* Map the tile of @_lookup to the pixels of the best image and request their blocks */
+    void lookupTile(std::shared_ptr<Lookup> _lookup);
+
+    /* Collect an HTTP block read for a short time, so that it is merged with the reads of
+     * neighboring blocks by flushBlockReads() */
+    void queueBlockRead(BlockRead _read);
+
+    /* Start range requests for the collected block reads */
+    void flushBlockReads();
+
+    /* Decode block @_key of @_tiff read from the file and finish it */
+    void decodeBlock(const GeoTiff& _tiff, uint64_t _key, bool _ok, const char* _data, size_t _size);
+
+    /* Cache block @_key, nullptr on failure, and continue the lookups waiting for it */
+    void finishBlock(uint64_t _key, std::shared_ptr<const GeoTiffBlock> _block);
+
+    /* Render the tile of @_lookup from its blocks once all are read */
+    void renderTile(const std::shared_ptr<Lookup>& _lookup);
+
+    /* Invoke the task callback when tile data was set, otherwise try the next source */
+    void finishLookup(std::shared_ptr<Lookup> _lookup, bool _found);
+
+    /* Drop least recently used blocks until at most @_bytes are kept. Requires m_mutex */
+    void evictBlocks(size_t _bytes);
+
+    enum class HeaderState { none, loading, ready };
+
+    Platform& m_platform;
+    std::string m_path;
+    bool m_isHttp = false;
+
+    // Mapping of a local file, not open if mapping failed
+    std::unique_ptr<MappedFile> m_file;
+
+    mutable std::mutex m_mutex;
+
+    // Directories of the file, immutable once read. Protected by m_mutex.
+    std::shared_ptr<const GeoTiff> m_tiff;
+    HeaderState m_headerState = HeaderState::none;
+
+    // Lookups waiting for the directories. Protected by m_mutex.
+    std::vector<std::shared_ptr<Lookup>> m_waiting;
+
+    // Decoded block cache entry; @block is null while the block is read
+    struct BlockEntry {
+        std::shared_ptr<const GeoTiffBlock> block;
+        std::vector<std::shared_ptr<Lookup>> waiting;  // lookups waiting for the read
+        std::list<uint64_t>::iterator lru;             // position in m_blockLru once read
+        size_t bytes = 0;
+    };
+
+    // Blocks by image and block index, with least recently used last in m_blockLru.
+    // Protected by m_mutex.
+    std::unordered_map<uint64_t, BlockEntry> m_blocks;
+    std::list<uint64_t> m_blockLru;
+    size_t m_blockBytes = 0;
+    size_t m_maxBlockBytes;
+
+    // HTTP block reads collected for merging. Protected by m_mutex.
+    std::vector<BlockRead> m_blockReads;
+    bool m_blockReadsScheduled = false;
+
+    // Serial queue on the shared I/O threads for file reads, decoding and rendering. Declared
+    // last so that it is stopped before other members are destroyed.
+    std::unique_ptr<IOQueue> m_worker;
+};
+
+}
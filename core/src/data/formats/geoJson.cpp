@@ -6,56 +6,17 @@
 #include "util/geom.h"
 #include "util/mapProjection.h"
 
+#include "rapidjson/encodedstream.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+
 #include "glm/glm.hpp"
 
 namespace Tangram {
 
-bool GeoJson::isFeatureCollection(const JsonValue& _in) {
-
-    // A FeatureCollection must have a "type" of "FeatureCollection"
-    // and a member named "features" that is an array.
-    // http://geojson.org/geojson-spec.html#feature-collection-objects
-
-    auto type = _in.FindMember("type");
-    if (type == _in.MemberEnd() || !type->value.IsString() ||
-        std::strcmp(type->value.GetString(), "FeatureCollection") != 0) {
-        return false;
-    }
-
-    auto features = _in.FindMember("features");
-    if (features == _in.MemberEnd() || !features->value.IsArray()) {
-        return false;
-    }
-
-    return true;
-
-}
-
-Point GeoJson::getPoint(const JsonValue& _in, const Transform& _proj) {
-    return _proj(LngLat(_in[0].GetDouble(), _in[1].GetDouble()));
-}
-
-Line GeoJson::getLine(const JsonValue& _in, const Transform& _proj) {
-
-    Line line;
-    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        line.push_back(getPoint(*itr, _proj));
-    }
-    return line;
-
-}
-
-Polygon GeoJson::getPolygon(const JsonValue& _in, const Transform& _proj) {
-
-    Polygon polygon;
-    for (auto itr = _in.Begin(); itr != _in.End(); ++itr) {
-        polygon.push_back(getLine(*itr, _proj));
-    }
-    return polygon;
-
-}
-
-Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId) {
+Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId,
+                                  const PropertyKeys::Keys* _keys) {
 
     std::vector<PropertyItem> items;
     items.reserve(_in.MemberCount());
@@ -64,6 +25,8 @@ Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId) {
 
         const auto& name = it->name.GetString();
         const auto& value = it->value;
+        if (_keys && !_keys->contains(name)) { continue; }
+
         if (value.IsNumber()) {
             items.emplace_back(name, value.GetDouble());
         } else if (it->value.IsString()) {
@@ -82,103 +45,333 @@ Properties GeoJson::getProperties(const JsonValue& _in, int32_t _sourceId) {
 
 }
 
-Feature GeoJson::getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId) {
+namespace {
 
-    Feature feature;
+// A member object of the root, or the root itself, that may be a FeatureCollection
+struct LayerCandidate {
+    LayerCandidate(std::string _name, TileArena* _arena, const PropertyKeys::Keys* _keys)
+        : layer(std::move(_name), _arena), keys(_keys) {}
 
-    // Copy properties into tile data
-    auto properties = _in.FindMember("properties");
-    if (properties != _in.MemberEnd()) {
-        feature.props = getProperties(properties->value, _sourceId);
-    }
+    Layer layer;
+    const PropertyKeys::Keys* keys;
+    bool isFeatureCollection = false;
+    bool hasFeatures = false;
+};
 
-    // Copy geometry into tile data
-    const JsonValue& geometry = _in["geometry"];
-    const JsonValue& coords = geometry["coordinates"];
-    const std::string& geometryType = geometry["type"].GetString();
+// SAX handler for the FeatureCollections of a GeoJSON tile
+struct TileHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, TileHandler> {
 
-    if (geometryType.compare("Point") == 0) {
+    enum class Kind { root, layer, features, feature, properties, geometry, coordinates, skip };
 
-        feature.geometryType = GeometryType::points;
-        feature.points.push_back(getPoint(coords, _proj));
+    struct Frame {
+        Kind kind;
+        // index of the LayerCandidate of the frame
+        size_t layer;
+        // nesting of arrays in coordinates, or of skipped values
+        int depth = 0;
+    };
 
-    } else if (geometryType.compare("MultiPoint") == 0) {
+    TileHandler(const GeoJson::Transform& _proj, int32_t _sourceId,
+                const PropertyKeys* _propertyKeys, TileArena* _arena)
+        : proj(_proj), sourceId(_sourceId), propertyKeys(_propertyKeys), arena(_arena),
+          feature(_sourceId, _arena) {}
 
-        feature.geometryType = GeometryType::points;
-        for (auto pointCoords = coords.Begin(); pointCoords != coords.End(); ++pointCoords) {
-            feature.points.push_back(getPoint(*pointCoords, _proj));
-        }
+    const GeoJson::Transform& proj;
+    int32_t sourceId;
+    const PropertyKeys* propertyKeys;
+    TileArena* arena;
 
-    } else if (geometryType.compare("LineString") == 0) {
+    std::vector<LayerCandidate> layers;
+    std::vector<Frame> stack;
+    std::string key;
 
-        feature.geometryType = GeometryType::lines;
-        feature.lines.push_back(getLine(coords, _proj));
+    // current feature, its properties and geometry type
+    Feature feature;
+    std::vector<PropertyItem> items;
+    std::string geometryType;
+
+    // coordinates of the current geometry: points at the innermost arrays, which are at depth
+    // pointDepth; for each closed outer array its depth and the number of points before
+    std::vector<Point> points;
+    std::vector<std::pair<int, size_t>> ends;
+    int pointDepth = 0;
 
-    } else if (geometryType.compare("MultiLineString") == 0) {
+    // current position
+    double coordinates[2] = { 0, 0 };
+    int coordinateCount = 0;
+
+    const PropertyKeys::Keys* layerKeys(const std::string& _layer) const {
+        return propertyKeys ? propertyKeys->find(_layer) : nullptr;
+    }
 
-        feature.geometryType = GeometryType::lines;
-        for (auto lineCoords = coords.Begin(); lineCoords != coords.End(); ++lineCoords) {
-            feature.lines.push_back(getLine(*lineCoords, _proj));
+    // A value that is not read: skip it if it is an object or array
+    bool skip() {
+        stack.push_back({ Kind::skip, 0, 1 });
+        return true;
+    }
+
+    void beginFeature() {
+        feature = Feature(sourceId, arena);
+        items.clear();
+        geometryType.clear();
+        points.clear();
+        ends.clear();
+        pointDepth = 0;
+    }
+
+    void endFeature(LayerCandidate& _layer) {
+        feature.props.setSorted(std::move(items));
+        feature.props.sort();
+        items = {};
+        _layer.layer.features.push_back(std::move(feature));
+    }
+
+    // Call @_ring with the point range of each array closed at depth pointDepth - 1, and
+    // @_group after each array closed at depth pointDepth - 2
+    template<typename R, typename G>
+    void forEachRing(R _ring, G _group) {
+        size_t start = 0;
+        for (const auto& end : ends) {
+            if (end.first == pointDepth - 1) {
+                _ring(points.data() + start, points.data() + end.second);
+                start = end.second;
+            } else if (end.first == pointDepth - 2) {
+                _group();
+            }
         }
+    }
+
+    void endGeometry() {
+        auto none = []() {};
+
+        if (geometryType == "Point") {
+            feature.geometryType = GeometryType::points;
+            if (pointDepth == 1 && !points.empty()) { feature.addPoint(points.front()); }
 
-    } else if (geometryType.compare("Polygon") == 0) {
+        } else if (geometryType == "MultiPoint") {
+            feature.geometryType = GeometryType::points;
+            if (pointDepth == 2) { feature.coordinates.assign(points.begin(), points.end()); }
 
-        feature.geometryType = GeometryType::polygons;
-        feature.polygons.push_back(getPolygon(coords, _proj));
+        } else if (geometryType == "LineString") {
+            feature.geometryType = GeometryType::lines;
+            if (pointDepth == 2) { feature.addLine(points.begin(), points.end()); }
 
-    } else if (geometryType.compare("MultiPolygon") == 0) {
+        } else if (geometryType == "MultiLineString") {
+            feature.geometryType = GeometryType::lines;
+            if (pointDepth == 3) {
+                feature.coordinates.reserve(points.size());
+                forEachRing([&](const Point* _begin, const Point* _end) { feature.addLine(_begin, _end); },
+                            none);
+            }
+
+        } else if (geometryType == "Polygon") {
+            feature.geometryType = GeometryType::polygons;
+            if (pointDepth == 3) {
+                feature.coordinates.reserve(points.size());
+                feature.beginPolygon();
+                forEachRing([&](const Point* _begin, const Point* _end) { feature.addRing(_begin, _end); },
+                            none);
+            }
 
-        feature.geometryType = GeometryType::polygons;
-        for (auto polyCoords = coords.Begin(); polyCoords != coords.End(); ++polyCoords) {
-            feature.polygons.push_back(getPolygon(*polyCoords, _proj));
+        } else if (geometryType == "MultiPolygon") {
+            feature.geometryType = GeometryType::polygons;
+            if (pointDepth == 4) {
+                feature.coordinates.reserve(points.size());
+                bool open = false;
+                forEachRing([&](const Point* _begin, const Point* _end) {
+                                if (!open) { feature.beginPolygon(); }
+                                open = true;
+                                feature.addRing(_begin, _end);
+                            },
+                            [&]() { open = false; });
+            }
         }
+        // other geometry types, e.g. GeometryCollection, are not handled
+    }
 
+    bool number(double _value) {
+        if (stack.empty()) { return true; }
+        Frame& frame = stack.back();
+        if (frame.kind == Kind::properties) {
+            if (!layers[frame.layer].keys || layers[frame.layer].keys->contains(key)) {
+                items.emplace_back(key, _value);
+            }
+        } else if (frame.kind == Kind::coordinates) {
+            if (pointDepth == 0) { pointDepth = frame.depth; }
+            if (pointDepth == frame.depth) {
+                if (coordinateCount < 2) { coordinates[coordinateCount] = _value; }
+                coordinateCount++;
+            }
+        }
+        return true;
     }
 
-    return feature;
+    bool Null() { return true; }
+    bool Bool(bool _value) {
+        if (!stack.empty() && stack.back().kind == Kind::coordinates) { return true; }
+        return number(_value);
+    }
+    bool Int(int _value) { return number(_value); }
+    bool Uint(unsigned _value) { return number(_value); }
+    bool Int64(int64_t _value) { return number(double(_value)); }
+    bool Uint64(uint64_t _value) { return number(double(_value)); }
+    bool Double(double _value) { return number(_value); }
+
+    bool String(const char* _str, rapidjson::SizeType _length, bool) {
+        if (stack.empty()) { return true; }
+        Frame& frame = stack.back();
+        switch (frame.kind) {
+        case Kind::root:
+        case Kind::layer:
+            if (key == "type") {
+                layers[frame.layer].isFeatureCollection =
+                    std::string(_str, _length) == "FeatureCollection";
+            }
+            break;
+        case Kind::properties:
+            if (!layers[frame.layer].keys || layers[frame.layer].keys->contains(key)) {
+                items.emplace_back(key, std::string(_str, _length));
+            }
+            break;
+        case Kind::geometry:
+            if (key == "type") { geometryType.assign(_str, _length); }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
 
-}
+    bool Key(const char* _str, rapidjson::SizeType _length, bool) {
+        key.assign(_str, _length);
+        return true;
+    }
 
-Layer GeoJson::getLayer(const JsonValue& _in, const Transform& _proj, int32_t _sourceId) {
+    bool StartObject() {
+        if (stack.empty()) {
+            layers.emplace_back("", arena, layerKeys(""));
+            stack.push_back({ Kind::root, 0 });
+            return true;
+        }
+        Frame& frame = stack.back();
+        switch (frame.kind) {
+        case Kind::root:
+            layers.emplace_back(key, arena, layerKeys(key));
+            stack.push_back({ Kind::layer, layers.size() - 1 });
+            return true;
+        case Kind::features:
+            beginFeature();
+            stack.push_back({ Kind::feature, frame.layer });
+            return true;
+        case Kind::feature:
+            if (key == "properties") {
+                stack.push_back({ Kind::properties, frame.layer });
+                return true;
+            }
+            if (key == "geometry") {
+                stack.push_back({ Kind::geometry, frame.layer });
+                return true;
+            }
+            return skip();
+        case Kind::skip:
+            frame.depth++;
+            return true;
+        default:
+            // nested property values are not supported
+            return skip();
+        }
+    }
 
-    Layer layer("");
+    bool EndObject(rapidjson::SizeType) {
+        Frame frame = stack.back();
+        if (frame.kind == Kind::skip && --stack.back().depth > 0) { return true; }
+        stack.pop_back();
 
-    auto features = _in.FindMember("features");
+        if (frame.kind == Kind::feature) {
+            endFeature(layers[frame.layer]);
+        } else if (frame.kind == Kind::geometry) {
+            endGeometry();
+        }
+        return true;
+    }
 
-    if (features == _in.MemberEnd()) {
-        LOGE("GeoJSON missing 'features' member");
-        return layer;
+    bool StartArray() {
+        if (stack.empty()) { return false; }
+        Frame& frame = stack.back();
+        switch (frame.kind) {
+        case Kind::root:
+        case Kind::layer:
+            if (key == "features") {
+                layers[frame.layer].hasFeatures = true;
+                stack.push_back({ Kind::features, frame.layer });
+                return true;
+            }
+            return skip();
+        case Kind::geometry:
+            if (key == "coordinates") {
+                stack.push_back({ Kind::coordinates, frame.layer, 1 });
+                return true;
+            }
+            return skip();
+        case Kind::coordinates:
+        case Kind::skip:
+            frame.depth++;
+            return true;
+        default:
+            return skip();
+        }
     }
 
-    for (auto featureIt = features->value.Begin(); featureIt != features->value.End(); ++featureIt) {
-        layer.features.push_back(getFeature(*featureIt, _proj, _sourceId));
+    bool EndArray(rapidjson::SizeType) {
+        Frame& frame = stack.back();
+        if (frame.kind == Kind::coordinates) {
+            if (frame.depth == pointDepth) {
+                if (coordinateCount >= 2) {
+                    points.push_back(proj(LngLat(coordinates[0], coordinates[1])));
+                }
+                coordinateCount = 0;
+            } else {
+                ends.emplace_back(frame.depth, points.size());
+            }
+            if (--frame.depth > 0) { return true; }
+        } else if (frame.kind == Kind::skip && --frame.depth > 0) {
+            return true;
+        }
+        stack.pop_back();
+        return true;
     }
 
-    return layer;
+    // FeatureCollection of the root, or else those of its members
+    void getLayers(std::vector<Layer>& _layers) {
+        if (layers.empty()) { return; }
+
+        if (layers[0].isFeatureCollection && layers[0].hasFeatures) {
+            _layers.push_back(std::move(layers[0].layer));
+            return;
+        }
+        for (size_t i = 1; i < layers.size(); i++) {
+            if (layers[i].isFeatureCollection && layers[i].hasFeatures) {
+                _layers.push_back(std::move(layers[i].layer));
+            }
+        }
+    }
+};
 
 }
 
-std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sourceId) {
+std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sourceId,
+                                             const PropertyKeys* _propertyKeys) {
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
-    std::shared_ptr<TileData> tileData = std::make_shared<TileData>();
-
-    // Parse data into a JSON document
-    const char* error;
-    size_t offset;
-    auto document = JsonParseBytes(task.rawTileData->data(), task.rawTileData->size(), &error, &offset);
-
-    if (error) {
-        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(), error, offset);
-        return tileData;
-    }
+    // features, their points, lines and polygons are allocated from the arena of the tile
+    std::shared_ptr<TileData> tileData = std::make_shared<TileData>(TileArena::acquire());
 
     BoundingBox tileBounds(MapProjection::tileBounds(task.tileId()));
     glm::dvec2 tileOrigin = tileBounds.min;
     double tileInverseScale = 1.0 / tileBounds.width();
 
-    const auto projFn = [&](LngLat _lngLat){
+    const Transform projFn = [&](LngLat _lngLat){
         ProjectedMeters tmp = MapProjection::lngLatToProjectedMeters(_lngLat);
         return Point {
             (tmp.x - tileOrigin.x) * tileInverseScale,
@@ -186,20 +379,19 @@ std::shared_ptr<TileData> GeoJson::parseTile(const TileTask& _task, int32_t _sou
         };
     };
 
-    // Transform JSON data into TileData using GeoJson functions
-    if (GeoJson::isFeatureCollection(document)) {
-        tileData->layers.push_back(GeoJson::getLayer(document, projFn, _sourceId));
-    } else {
-        for (auto layer = document.MemberBegin(); layer != document.MemberEnd(); ++layer) {
-            if (GeoJson::isFeatureCollection(layer->value)) {
-                tileData->layers.push_back(GeoJson::getLayer(layer->value, projFn, _sourceId));
-                tileData->layers.back().name = layer->name.GetString();
-            }
-        }
-    }
+    TileHandler handler(projFn, _sourceId, _propertyKeys, tileData->arena.get());
+
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream mstream(task.rawTileData->data(), task.rawTileData->size());
+    rapidjson::EncodedInputStream<rapidjson::UTF8<char>, rapidjson::MemoryStream> istream(mstream);
 
+    if (!reader.Parse(istream, handler)) {
+        LOGE("Json parsing failed on tile [%s]: %s (%u)", task.tileId().toString().c_str(),
+             rapidjson::GetParseError_En(reader.GetParseErrorCode()), reader.GetErrorOffset());
+        return tileData;
+    }
 
-    // Discard original JSON object and return TileData
+    handler.getLayers(tileData->layers);
 
     return tileData;
 
@@ -14,21 +14,17 @@ namespace GeoJson {
 
 using Transform = std::function<Point(LngLat _lngLat)>;
 
-bool isFeatureCollection(const JsonValue& _in);
-
-Point getPoint(const JsonValue& _in, const Transform& _proj);
-
-Line getLine(const JsonValue& _in, const Transform& _proj);
-
-Polygon getPolygon(const JsonValue& _in, const Transform& _proj);
-
-Properties getProperties(const JsonValue& _in, int32_t _sourceId);
-
-Feature getFeature(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
-
-Layer getLayer(const JsonValue& _in, const Transform& _proj, int32_t _sourceId);
-
-std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId);
+// Properties with keys not in @_keys are dropped, unless it is nullptr
+Properties getProperties(const JsonValue& _in, int32_t _sourceId,
+                         const PropertyKeys::Keys* _keys = nullptr);
+
+/* Read a FeatureCollection, or an object with a FeatureCollection for each named layer
+ *
+ * The tile is read with a SAX parser that writes features and their properties directly to
+ * the TileData, without building a JSON document. Members of objects may come in any order.
+ */
+std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId,
+                                    const PropertyKeys* _propertyKeys = nullptr);
 
 } // namespace GeoJson
 
@@ -0,0 +1,390 @@
+#include "data/formats/geoJsonStream.h"
+
+#include "data/propertyItem.h"
+
+#include "rapidjson/error/en.h"
+#include "rapidjson/memorystream.h"
+#include "rapidjson/reader.h"
+
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+using namespace mapbox;
+
+namespace {
+
+using Points = std::vector<geometry::point<double>>;
+
+// Feature or geometry object as read, before its type is known
+struct GeoObject {
+    std::string type;
+    std::vector<PropertyItem> properties;
+
+    // coordinates: points at the innermost arrays, which are at depth pointDepth;
+    // for each closed outer array its depth and the number of points before
+    Points points;
+    std::vector<std::pair<int, size_t>> ends;
+    int pointDepth = 0;
+
+    std::unique_ptr<GeoObject> geometry;
+    std::vector<std::unique_ptr<GeoObject>> geometries;
+
+    // Point ranges of arrays closed at depth pointDepth - 1, and the number of ranges at each
+    // close of depth pointDepth - 2
+    void rings(std::vector<std::pair<size_t, size_t>>& _rings, std::vector<size_t>& _groups) const {
+        size_t start = 0;
+        for (const auto& end : ends) {
+            if (end.first == pointDepth - 1) {
+                _rings.emplace_back(start, end.second);
+                start = end.second;
+            } else if (end.first == pointDepth - 2) {
+                _groups.push_back(_rings.size());
+            }
+        }
+    }
+
+    template<typename T>
+    T range(std::pair<size_t, size_t> _range) const {
+        return T(points.begin() + _range.first, points.begin() + _range.second);
+    }
+};
+
+// Append geometry of @_object to @_out; returns false if it has no valid geometry
+template<typename Container>
+static bool buildGeometry(const GeoObject& _object, Container& _out) {
+
+    const std::string& type = _object.type;
+
+    if (type == "GeometryCollection") {
+        geometry::geometry_collection<double> collection;
+        for (const auto& child : _object.geometries) { buildGeometry(*child, collection); }
+        if (collection.empty()) { return false; }
+        _out.emplace_back(std::move(collection));
+        return true;
+    }
+
+    if (_object.points.empty()) { return false; }
+
+    const std::pair<size_t, size_t> all(0, _object.points.size());
+
+    if (type == "Point" && _object.pointDepth == 1) {
+        _out.emplace_back(_object.points.front());
+        return true;
+    }
+    if (type == "LineString" && _object.pointDepth == 2) {
+        _out.emplace_back(_object.range<geometry::line_string<double>>(all));
+        return true;
+    }
+    if (type == "MultiPoint" && _object.pointDepth == 2) {
+        _out.emplace_back(_object.range<geometry::multi_point<double>>(all));
+        return true;
+    }
+
+    std::vector<std::pair<size_t, size_t>> rings;
+    std::vector<size_t> groups;
+    _object.rings(rings, groups);
+
+    if (type == "MultiLineString" && _object.pointDepth == 3) {
+        geometry::multi_line_string<double> lines;
+        for (auto& ring : rings) { lines.push_back(_object.range<geometry::line_string<double>>(ring)); }
+        _out.emplace_back(std::move(lines));
+        return true;
+    }
+    if (type == "Polygon" && _object.pointDepth == 3) {
+        geometry::polygon<double> polygon;
+        for (auto& ring : rings) { polygon.push_back(_object.range<geometry::linear_ring<double>>(ring)); }
+        _out.emplace_back(std::move(polygon));
+        return true;
+    }
+    if (type == "MultiPolygon" && _object.pointDepth == 4) {
+        geometry::multi_polygon<double> polygons(groups.size());
+        size_t ring = 0;
+        for (size_t i = 0; i < groups.size(); i++) {
+            for (; ring < groups[i]; ring++) {
+                polygons[i].push_back(_object.range<geometry::linear_ring<double>>(rings[ring]));
+            }
+        }
+        _out.emplace_back(std::move(polygons));
+        return true;
+    }
+    return false;
+}
+
+// SAX handler for one Feature or geometry object
+struct Handler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler> {
+
+    enum class Kind { object, properties, coordinates, geometries, skip };
+
+    struct Frame {
+        Kind kind;
+        GeoObject* object;
+        // nesting of arrays in coordinates, or of skipped values
+        int depth = 0;
+    };
+
+    GeoObject root;
+    std::vector<Frame> stack;
+    std::string key;
+
+    // coordinates of the current point
+    double coordinates[2] = { 0, 0 };
+    int coordinateCount = 0;
+
+    // A value that is not read: skip it if it is an object or array
+    bool skip() {
+        stack.push_back({ Kind::skip, nullptr, 1 });
+        return true;
+    }
+
+    bool number(double _value) {
+        if (stack.empty()) { return false; }
+        Frame& frame = stack.back();
+        if (frame.kind == Kind::properties) {
+            frame.object->properties.emplace_back(key, _value);
+        } else if (frame.kind == Kind::coordinates) {
+            auto& object = *frame.object;
+            if (object.pointDepth == 0) { object.pointDepth = frame.depth; }
+            if (object.pointDepth != frame.depth) { return false; }
+            if (coordinateCount < 2) { coordinates[coordinateCount] = _value; }
+            coordinateCount++;
+        }
+        return true;
+    }
+
+    bool Null() { return stack.empty() || stack.back().kind != Kind::coordinates; }
+    bool Bool(bool _value) {
+        if (!stack.empty() && stack.back().kind == Kind::coordinates) { return false; }
+        return number(_value);
+    }
+    bool Int(int _value) { return number(_value); }
+    bool Uint(unsigned _value) { return number(_value); }
+    bool Int64(int64_t _value) { return number(double(_value)); }
+    bool Uint64(uint64_t _value) { return number(double(_value)); }
+    bool Double(double _value) { return number(_value); }
+
+    bool String(const char* _str, rapidjson::SizeType _length, bool) {
+        if (stack.empty()) { return false; }
+        Frame& frame = stack.back();
+        if (frame.kind == Kind::object && key == "type") {
+            frame.object->type.assign(_str, _length);
+        } else if (frame.kind == Kind::properties) {
+            frame.object->properties.emplace_back(key, std::string(_str, _length));
+        } else if (frame.kind == Kind::coordinates) {
+            return false;
+        }
+        return true;
+    }
+
+    bool Key(const char* _str, rapidjson::SizeType _length, bool) {
+        key.assign(_str, _length);
+        return true;
+    }
+
+    bool StartObject() {
+        if (stack.empty()) {
+            stack.push_back({ Kind::object, &root });
+            return true;
+        }
+        Frame& frame = stack.back();
+        switch (frame.kind) {
+        case Kind::object:
+            if (key == "geometry") {
+                frame.object->geometry = std::make_unique<GeoObject>();
+                stack.push_back({ Kind::object, frame.object->geometry.get() });
+                return true;
+            }
+            if (key == "properties") {
+                stack.push_back({ Kind::properties, frame.object });
+                return true;
+            }
+            return skip();
+        case Kind::geometries:
+            frame.object->geometries.push_back(std::make_unique<GeoObject>());
+            stack.push_back({ Kind::object, frame.object->geometries.back().get() });
+            return true;
+        case Kind::properties:
+            // nested property values are not supported
+            return skip();
+        case Kind::coordinates:
+            return false;
+        case Kind::skip:
+            frame.depth++;
+            return true;
+        }
+        return false;
+    }
+
+    bool EndObject(rapidjson::SizeType) {
+        Frame& frame = stack.back();
+        if (frame.kind == Kind::skip && --frame.depth > 0) { return true; }
+        stack.pop_back();
+        return true;
+    }
+
+    bool StartArray() {
+        if (stack.empty()) { return false; }
+        Frame& frame = stack.back();
+        switch (frame.kind) {
+        case Kind::object:
+            if (key == "coordinates") {
+                stack.push_back({ Kind::coordinates, frame.object, 1 });
+                return true;
+            }
+            if (key == "geometries") {
+                stack.push_back({ Kind::geometries, frame.object });
+                return true;
+            }
+            return skip();
+        case Kind::coordinates:
+        case Kind::skip:
+            frame.depth++;
+            return true;
+        default:
+            return skip();
+        }
+    }
+
+    bool EndArray(rapidjson::SizeType) {
+        Frame& frame = stack.back();
+        if (frame.kind == Kind::coordinates) {
+            auto& object = *frame.object;
+            if (frame.depth == object.pointDepth) {
+                if (coordinateCount >= 2) {
+                    object.points.emplace_back(coordinates[0], coordinates[1]);
+                }
+                coordinateCount = 0;
+            } else {
+                object.ends.emplace_back(frame.depth, object.points.size());
+            }
+            if (--frame.depth > 0) { return true; }
+        } else if (frame.kind == Kind::skip && --frame.depth > 0) {
+            return true;
+        }
+        stack.pop_back();
+        return true;
+    }
+};
+
+}
+
+GeoJsonStream::GeoJsonStream(FeatureCallback _callback) : m_callback(std::move(_callback)) {}
+
+void GeoJsonStream::parseObject(const char* _data, size_t _size) {
+
+    Handler handler;
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream stream(_data, _size);
+
+    if (!reader.Parse(stream, handler)) {
+        m_error = std::string(rapidjson::GetParseError_En(reader.GetParseErrorCode())) +
+            " in GeoJSON object at offset " + std::to_string(reader.GetErrorOffset());
+        return;
+    }
+
+    GeoObject& root = handler.root;
+    if (root.type == "FeatureCollection") { return; }
+
+    const GeoObject* geometry = &root;
+    if (root.type == "Feature") {
+        // features without geometry are valid, but there is nothing to draw
+        if (!root.geometry) { return; }
+        geometry = root.geometry.get();
+    }
+
+    std::vector<Geometry> result;
+    if (!buildGeometry(*geometry, result)) {
+        if (geometry->type != "GeometryCollection" && !geometry->points.empty()) {
+            m_error = "Invalid coordinates for GeoJSON geometry type '" + geometry->type + "'";
+        }
+        return;
+    }
+
+    Properties properties(std::move(root.properties));
+    properties.sort();
+
+    m_featureCount++;
+    m_callback(std::move(properties), std::move(result.front()));
+}
+
+void GeoJsonStream::write(const char* _data, size_t _size) {
+
+    // start of the current feature in this chunk
+    size_t featureStart = 0;
+
+    for (size_t i = 0; i < _size; i++) {
+        const char c = _data[i];
+
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+                if (m_depth == 1) { m_keyIsFeatures = (m_key == "features"); }
+            } else if (m_depth == 1 && m_key.size() <= 8) {
+                m_key += c;
+            }
+            if (!(m_inFeatures && m_depth >= 2)) { m_document += c; }
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            m_inString = true;
+            if (m_depth == 1) { m_key.clear(); }
+            break;
+        case '{':
+        case '[':
+            if (m_inFeatures && m_depth == 2) {
+                m_inFeature = true;
+                featureStart = i;
+            } else if (c == '[' && m_depth == 1 && m_keyIsFeatures) {
+                m_inFeatures = true;
+                m_document += c;
+                m_depth++;
+                continue;
+            }
+            m_depth++;
+            break;
+        case '}':
+        case ']':
+            m_depth--;
+            if (m_inFeature && m_depth == 2) {
+                m_inFeature = false;
+                if (m_feature.empty()) {
+                    // complete in this chunk: parse in place
+                    parseObject(_data + featureStart, i + 1 - featureStart);
+                } else {
+                    m_feature.append(_data + featureStart, i + 1 - featureStart);
+                    parseObject(m_feature.data(), m_feature.size());
+                    m_feature.clear();
+                }
+                continue;
+            }
+            if (m_inFeatures && m_depth == 1) { m_inFeatures = false; }
+            break;
+        }
+
+        if (!(m_inFeatures && m_depth >= 2)) { m_document += c; }
+    }
+
+    if (m_inFeature) {
+        m_feature.append(_data + featureStart, _size - featureStart);
+    }
+}
+
+bool GeoJsonStream::finish() {
+
+    if (m_depth != 0 || m_inString) {
+        m_error = "Incomplete GeoJSON document";
+    } else if (m_document.find_first_not_of(" \t\r\n") != std::string::npos) {
+        parseObject(m_document.data(), m_document.size());
+    }
+
+    return m_error.empty();
+}
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "data/properties.h"
+
+#include "mapbox/geometry.hpp"
+
+#include <functional>
+#include <string>
+
+namespace Tangram {
+
+/* Incremental GeoJSON parser
+ *
+ * The document can be passed in chunks of any size, e.g. as they are received. Features of a
+ * FeatureCollection are cut from the byte stream and read with a rapidjson SAX reader as soon as
+ * they are complete, so that memory is bounded by the largest feature rather than by the
+ * document. A single Feature or geometry at the top level is read when the document is finished.
+ * Invalid features are skipped; the error of the last one is kept.
+ */
+class GeoJsonStream {
+
+public:
+
+    using Geometry = mapbox::geometry::geometry<double>;
+
+    // Called for each feature with a geometry, in document order
+    using FeatureCallback = std::function<void(Properties&& _properties, Geometry&& _geometry)>;
+
+    explicit GeoJsonStream(FeatureCallback _callback);
+
+    // Parse the next chunk of the document
+    void write(const char* _data, size_t _size);
+
+    // End of the document; returns false if the document or one of its features was invalid
+    bool finish();
+
+    const std::string& error() const { return m_error; }
+
+    size_t featureCount() const { return m_featureCount; }
+
+private:
+
+    void parseObject(const char* _data, size_t _size);
+
+    FeatureCallback m_callback;
+
+    // structure of the document outside of the features array, which is left empty
+    std::string m_document;
+    // feature of the features array that continues in the next chunk
+    std::string m_feature;
+
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    // top-level key, to find the features array
+    std::string m_key;
+    bool m_keyIsFeatures = false;
+    bool m_inFeatures = false;
+    bool m_inFeature = false;
+
+    size_t m_featureCount = 0;
+    std::string m_error;
+};
+
+}
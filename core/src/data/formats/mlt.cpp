@@ -0,0 +1,695 @@
+#include "data/formats/mlt.h"
+#include "data/propertyItem.h"
+#include "tile/tileTask.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+#define LAYER 1
+
+namespace Tangram {
+
+namespace {
+
+// Column types; the nullable variant of each type follows it and starts with a present stream
+enum ColumnType : uint32_t {
+    ID = 0,
+    ID_64 = 2,
+    GEOMETRY = 4,
+    STRUCT = 5,
+    BOOLEAN = 10,
+    INT_8 = 12,
+    UINT_8 = 14,
+    INT_32 = 16,
+    UINT_32 = 18,
+    INT_64 = 20,
+    UINT_64 = 22,
+    FLOAT = 24,
+    DOUBLE = 26,
+    STRING = 28,
+};
+
+enum class StreamType : uint8_t { present = 0, data = 1, offset = 2, length = 3 };
+
+// Logical level techniques
+enum class Technique : uint8_t { none = 0, delta = 1, componentwiseDelta = 2, rle = 3, morton = 4, pde = 5 };
+
+// Physical level techniques
+enum class Encoding : uint8_t { none = 0, fastPfor = 1, varint = 2, alp = 3 };
+
+// Subtypes of data streams (dictionary types), offset streams and length streams
+enum DictionaryType : uint8_t { DICT_NONE = 0, DICT_SINGLE = 1, DICT_SHARED = 2, DICT_VERTEX = 3, DICT_MORTON = 4, DICT_FSST = 5 };
+enum OffsetType : uint8_t { OFFSET_VERTEX = 0, OFFSET_INDEX = 1, OFFSET_STRING = 2, OFFSET_KEY = 3 };
+enum LengthType : uint8_t { LENGTH_VAR_BINARY = 0, LENGTH_GEOMETRIES = 1, LENGTH_PARTS = 2, LENGTH_RINGS = 3,
+                            LENGTH_TRIANGLES = 4, LENGTH_SYMBOL = 5, LENGTH_DICTIONARY = 6 };
+
+enum GeometryKind : uint32_t { POINT = 0, LINESTRING, POLYGON, MULTIPOINT, MULTILINESTRING, MULTIPOLYGON };
+
+const uint32_t NO_VALUE = UINT32_MAX;
+
+// Valid data in a part of MLT that this parser does not decode; the layer is skipped
+struct Unsupported : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+struct Reader {
+    const uint8_t* pos = nullptr;
+    const uint8_t* end = nullptr;
+
+    bool empty() const { return pos >= end; }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (pos >= end) { throw std::runtime_error("unterminated varint, unexpected end of buffer"); }
+            if (shift >= 64) { throw std::runtime_error("unterminated varint (too long)"); }
+            uint8_t byte = *pos++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) { return value; }
+        }
+    }
+
+    Reader bytes(size_t _count) {
+        if (size_t(end - pos) < _count) { throw std::runtime_error("unexpected end of buffer"); }
+        Reader part{ pos, pos + _count };
+        pos += _count;
+        return part;
+    }
+
+    std::string string() {
+        Reader part = bytes(varint());
+        return std::string(reinterpret_cast<const char*>(part.pos), part.end - part.pos);
+    }
+};
+
+struct Stream {
+    StreamType type = StreamType::data;
+    uint8_t subtype = 0;
+    Technique technique1 = Technique::none;
+    Technique technique2 = Technique::none;
+    Encoding encoding = Encoding::none;
+    // Number of encoded values, and for RLE the number of runs and of decoded values
+    uint32_t numValues = 0;
+    uint32_t runs = 0;
+    uint32_t numRleValues = 0;
+    Reader data;
+
+    bool rle() const { return technique1 == Technique::rle || technique2 == Technique::rle; }
+};
+
+struct Column {
+    uint32_t type = 0;
+    std::string name;
+    // Range of the streams of the column in ParserContext::streams
+    size_t firstStream = 0;
+    size_t numStreams = 0;
+
+    uint32_t baseType() const { return type & ~1u; }
+};
+
+struct ParserContext {
+    ParserContext(int32_t _sourceId) : sourceId(_sourceId) {}
+
+    int32_t sourceId;
+    // arena of the TileData for features and their geometry
+    TileArena* arena = nullptr;
+    // keys read by the scene, or nullptr to keep all properties
+    const PropertyKeys* propertyKeys = nullptr;
+
+    // Columns of the current layer and their streams
+    std::vector<Column> columns;
+    std::vector<Stream> streams;
+
+    // Buffers reused for each stream and layer
+    std::vector<uint64_t> raw;
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> present;
+    std::vector<uint8_t> bits;
+    std::vector<int64_t> ints;
+    std::vector<int64_t> lengths;
+
+    // Geometry column: type of each feature and its topology
+    std::vector<int64_t> types;
+    std::vector<int64_t> numGeometries;
+    std::vector<int64_t> numParts;
+    std::vector<int64_t> numRings;
+    std::vector<int64_t> numTriangles;
+    std::vector<int64_t> indices;
+    std::vector<int64_t> vertexOffsets;
+    std::vector<int64_t> vertices;
+    std::vector<uint32_t> ringStarts;
+    std::vector<uint32_t> polygonRings;
+
+    // Property columns: value ids of each column for each feature
+    std::vector<std::vector<uint32_t>> valueIds;
+    std::vector<uint32_t> columnValues;
+    std::vector<uint32_t> entryIds;
+    // Ids of the values added to the table of the layer
+    std::unordered_map<double, uint32_t> numberIds;
+    std::unordered_map<std::string_view, uint32_t> stringIds;
+};
+
+Stream readStream(Reader& _in) {
+    Stream stream;
+    Reader header = _in.bytes(2);
+    stream.type = StreamType(header.pos[0] >> 4);
+    stream.subtype = header.pos[0] & 0xf;
+    stream.technique1 = Technique(header.pos[1] >> 5);
+    stream.technique2 = Technique((header.pos[1] >> 2) & 0x7);
+    stream.encoding = Encoding(header.pos[1] & 0x3);
+    stream.numValues = uint32_t(_in.varint());
+    size_t byteLength = _in.varint();
+    if (stream.rle()) {
+        stream.runs = uint32_t(_in.varint());
+        stream.numRleValues = uint32_t(_in.varint());
+    }
+    if (stream.technique1 == Technique::morton) {
+        // number of bits and coordinate shift
+        _in.varint();
+        _in.varint();
+    }
+    stream.data = _in.bytes(byteLength);
+    return stream;
+}
+
+int64_t zigzag(uint64_t _value) {
+    return int64_t(_value >> 1) ^ -int64_t(_value & 1);
+}
+
+// Decode the integers of @_stream into @_out; @_signed values are zigzag encoded, as are deltas
+void decodeInts(ParserContext& _ctx, const Stream& _stream, bool _signed, std::vector<int64_t>& _out) {
+    if (_stream.encoding != Encoding::varint) {
+        throw Unsupported(_stream.encoding == Encoding::fastPfor ? "FastPFOR streams" : "plain integer streams");
+    }
+
+    auto t1 = _stream.technique1;
+    auto t2 = _stream.technique2;
+    bool delta = t1 == Technique::delta && (t2 == Technique::none || t2 == Technique::rle);
+    bool componentwise = t1 == Technique::componentwiseDelta && t2 == Technique::none;
+    bool rle = t1 == Technique::rle ? t2 == Technique::none : t2 == Technique::rle && delta;
+    if (!delta && !componentwise && !rle && (t1 != Technique::none || t2 != Technique::none)) {
+        throw Unsupported("Morton and PDE encodings");
+    }
+
+    // each varint takes at least a byte
+    if (_stream.numValues > size_t(_stream.data.end - _stream.data.pos)) {
+        throw std::runtime_error("unexpected end of buffer");
+    }
+    auto& raw = _ctx.raw;
+    raw.resize(_stream.numValues);
+    Reader in = _stream.data;
+    for (auto& value : raw) { value = in.varint(); }
+
+    _out.clear();
+    if (rle) {
+        // run lengths, then the value of each run
+        if (size_t(_stream.runs) * 2 != raw.size()) { throw std::runtime_error("invalid RLE stream"); }
+        _out.reserve(_stream.numRleValues);
+        for (size_t i = 0; i < _stream.runs; i++) {
+            uint64_t length = raw[i];
+            if (length > _stream.numRleValues - _out.size()) { throw std::runtime_error("invalid RLE stream"); }
+            _out.insert(_out.end(), length, int64_t(raw[_stream.runs + i]));
+        }
+    } else {
+        _out.assign(raw.begin(), raw.end());
+    }
+
+    if (_signed || delta || componentwise) {
+        for (auto& value : _out) { value = zigzag(uint64_t(value)); }
+    }
+    if (delta) {
+        for (size_t i = 1; i < _out.size(); i++) { _out[i] += _out[i - 1]; }
+    } else if (componentwise) {
+        for (size_t i = 2; i < _out.size(); i++) { _out[i] += _out[i - 2]; }
+    }
+}
+
+// Decode the byte RLE encoded bits of @_stream into @_out, one per value
+void decodeBits(ParserContext& _ctx, const Stream& _stream, std::vector<uint8_t>& _out) {
+    auto& bytes = _ctx.bytes;
+    bytes.clear();
+    size_t numBytes = (size_t(_stream.numValues) + 7) / 8;
+
+    Reader in = _stream.data;
+    while (bytes.size() < numBytes) {
+        uint8_t header = *in.bytes(1).pos;
+        if (header < 0x80) {
+            // run of a repeated byte
+            bytes.insert(bytes.end(), header + 3, *in.bytes(1).pos);
+        } else {
+            // literal bytes
+            Reader literals = in.bytes(0x100 - header);
+            bytes.insert(bytes.end(), literals.pos, literals.end);
+        }
+    }
+
+    _out.resize(_stream.numValues);
+    for (size_t i = 0; i < _out.size(); i++) {
+        _out[i] = (bytes[i >> 3] >> (i & 7)) & 1;
+    }
+}
+
+size_t next(const std::vector<int64_t>& _values, size_t& _index) {
+    if (_index >= _values.size() || _values[_index] < 0) {
+        throw std::runtime_error("invalid geometry topology");
+    }
+    return size_t(_values[_index++]);
+}
+
+/* Add the triangles of a polygon feature, as @_count indices relative to its first vertex, to
+ * its polygons. The rings of MLT polygons are not closed: @_ringStarts holds the first vertex
+ * of each ring and the end of the last, @_polygonRings the first ring of each polygon and the
+ * end of the last. False if the triangles do not follow the polygons. */
+bool addTriangles(Feature& _feature, const int64_t* _indices, size_t _count,
+                  const std::vector<uint32_t>& _ringStarts, const std::vector<uint32_t>& _polygonRings) {
+
+    size_t numPolygons = _polygonRings.size() - 1;
+    size_t polygon = 0;
+    _feature.triangles.reserve(_count);
+    _feature.triangleEnds.reserve(numPolygons);
+
+    for (size_t i = 0; i + 3 <= _count; i += 3) {
+        // triangles of each polygon follow those of the previous one
+        while (polygon < numPolygons && _indices[i] >= _ringStarts[_polygonRings[polygon + 1]]) {
+            _feature.triangleEnds.push_back(uint32_t(_feature.triangles.size()));
+            polygon++;
+        }
+        if (polygon == numPolygons) { return false; }
+
+        auto firstRing = _ringStarts.begin() + _polygonRings[polygon];
+        auto endRing = _ringStarts.begin() + _polygonRings[polygon + 1];
+        for (size_t k = i; k < i + 3; k++) {
+            int64_t index = _indices[k];
+            if (index < *firstRing || index >= *endRing) { return false; }
+            // count the closing point of each ring before the index
+            int64_t ring = std::upper_bound(firstRing, endRing, uint32_t(index)) - firstRing - 1;
+            int64_t point = index - *firstRing + ring;
+            if (point > UINT16_MAX) { return false; }
+            _feature.triangles.push_back(uint16_t(point));
+        }
+    }
+    while (_feature.triangleEnds.size() < numPolygons) {
+        _feature.triangleEnds.push_back(uint32_t(_feature.triangles.size()));
+    }
+    return true;
+}
+
+void decodeGeometry(ParserContext& _ctx, const Column& _column, int _extent, Layer& _layer) {
+
+    if (_column.numStreams == 0) { throw std::runtime_error("geometry column without streams"); }
+    const Stream* streams = &_ctx.streams[_column.firstStream];
+
+    decodeInts(_ctx, streams[0], false, _ctx.types);
+    _ctx.numGeometries.clear();
+    _ctx.numParts.clear();
+    _ctx.numRings.clear();
+    _ctx.numTriangles.clear();
+    _ctx.indices.clear();
+    _ctx.vertexOffsets.clear();
+    _ctx.vertices.clear();
+
+    for (size_t i = 1; i < _column.numStreams; i++) {
+        const Stream& stream = streams[i];
+        switch (stream.type) {
+        case StreamType::length:
+            switch (stream.subtype) {
+            case LENGTH_GEOMETRIES: decodeInts(_ctx, stream, false, _ctx.numGeometries); break;
+            case LENGTH_PARTS: decodeInts(_ctx, stream, false, _ctx.numParts); break;
+            case LENGTH_RINGS: decodeInts(_ctx, stream, false, _ctx.numRings); break;
+            case LENGTH_TRIANGLES: decodeInts(_ctx, stream, false, _ctx.numTriangles); break;
+            default: break;
+            }
+            break;
+        case StreamType::offset:
+            if (stream.subtype == OFFSET_VERTEX) { decodeInts(_ctx, stream, false, _ctx.vertexOffsets); }
+            if (stream.subtype == OFFSET_INDEX) { decodeInts(_ctx, stream, false, _ctx.indices); }
+            break;
+        case StreamType::data:
+            if (stream.subtype == DICT_MORTON || stream.technique1 == Technique::morton) {
+                throw Unsupported("Morton encoded vertices");
+            }
+            decodeInts(_ctx, stream, true, _ctx.vertices);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // bring the points in 0 to 1 space, as Mvt::getGeometry()
+    double invTileExtent = (1.0/(_extent-1.0));
+    size_t numVertices = _ctx.vertexOffsets.empty() ? _ctx.vertices.size() / 2 : _ctx.vertexOffsets.size();
+    size_t vertex = 0;
+    auto nextPoint = [&]() {
+        if (vertex >= numVertices) { throw std::runtime_error("invalid geometry topology"); }
+        size_t index = vertex++;
+        if (!_ctx.vertexOffsets.empty()) {
+            int64_t offset = _ctx.vertexOffsets[index];
+            if (offset < 0 || size_t(offset) >= _ctx.vertices.size() / 2) {
+                throw std::runtime_error("vertex offset out of range");
+            }
+            index = size_t(offset);
+        }
+        return Point(invTileExtent * double(_ctx.vertices[2 * index]),
+                     invTileExtent * double(_extent - _ctx.vertices[2 * index + 1]));
+    };
+
+    // the vertices of lines are counted in the ring lengths when there are polygons
+    bool rings = !_ctx.numRings.empty();
+    size_t geometry = 0, part = 0, ring = 0, triangles = 0, index = 0;
+
+    _layer.features.reserve(_ctx.types.size());
+    for (int64_t type : _ctx.types) {
+        Feature feature(_ctx.sourceId, _ctx.arena);
+
+        size_t count = 1;
+        if (type == MULTIPOINT || type == MULTILINESTRING || type == MULTIPOLYGON) {
+            count = next(_ctx.numGeometries, geometry);
+        }
+        uint32_t firstVertex = uint32_t(vertex);
+
+        switch (type) {
+        case POINT:
+        case MULTIPOINT:
+            feature.geometryType = GeometryType::points;
+            feature.coordinates.reserve(count);
+            for (size_t i = 0; i < count; i++) { feature.addPoint(nextPoint()); }
+            break;
+
+        case LINESTRING:
+        case MULTILINESTRING:
+            feature.geometryType = GeometryType::lines;
+            for (size_t i = 0; i < count; i++) {
+                size_t points = rings ? next(_ctx.numRings, ring) : next(_ctx.numParts, part);
+                for (size_t j = 0; j < points; j++) { feature.addPoint(nextPoint()); }
+                feature.endLine();
+            }
+            break;
+
+        case POLYGON:
+        case MULTIPOLYGON:
+            feature.geometryType = GeometryType::polygons;
+            _ctx.ringStarts.clear();
+            _ctx.polygonRings.clear();
+            for (size_t i = 0; i < count; i++) {
+                _ctx.polygonRings.push_back(uint32_t(_ctx.ringStarts.size()));
+                feature.beginPolygon();
+                size_t numRings = next(_ctx.numParts, part);
+                for (size_t j = 0; j < numRings; j++) {
+                    size_t points = next(_ctx.numRings, ring);
+                    if (points == 0) { continue; }
+                    _ctx.ringStarts.push_back(uint32_t(vertex) - firstVertex);
+                    size_t first = feature.coordinates.size();
+                    for (size_t k = 0; k < points; k++) { feature.addPoint(nextPoint()); }
+                    // close the ring
+                    feature.addPoint(Point(feature.coordinates[first]));
+                    feature.endRing();
+                }
+            }
+            _ctx.ringStarts.push_back(uint32_t(vertex) - firstVertex);
+            _ctx.polygonRings.push_back(uint32_t(_ctx.ringStarts.size() - 1));
+
+            if (!_ctx.numTriangles.empty()) {
+                size_t numIndices = 3 * next(_ctx.numTriangles, triangles);
+                if (numIndices > _ctx.indices.size() - index) {
+                    throw std::runtime_error("invalid triangle indices");
+                }
+                if (!addTriangles(feature, _ctx.indices.data() + index, numIndices,
+                                  _ctx.ringStarts, _ctx.polygonRings)) {
+                    // triangulate the polygons when they are built
+                    feature.triangles.clear();
+                    feature.triangleEnds.clear();
+                }
+                index += numIndices;
+            }
+            break;
+
+        default:
+            throw std::runtime_error("unknown geometry type");
+        }
+
+        _layer.features.push_back(std::move(feature));
+    }
+}
+
+// Set @_ids to the id in @_table of the value of each feature in a property column
+void decodeProperty(ParserContext& _ctx, const Column& _column, PropertyTable& _table,
+                    std::vector<uint32_t>& _ids) {
+
+    size_t numFeatures = _ids.size();
+    const Stream* present = nullptr;
+    const Stream* data = nullptr;
+    const Stream* lengths = nullptr;
+    const Stream* offsets = nullptr;
+    const Stream* dictionaryLengths = nullptr;
+
+    for (size_t i = 0; i < _column.numStreams; i++) {
+        const Stream& stream = _ctx.streams[_column.firstStream + i];
+        switch (stream.type) {
+        case StreamType::present: present = &stream; break;
+        case StreamType::data: data = &stream; break;
+        case StreamType::offset: offsets = &stream; break;
+        case StreamType::length:
+            if (stream.subtype == LENGTH_SYMBOL) { throw Unsupported("FSST strings"); }
+            if (stream.subtype == LENGTH_DICTIONARY) { dictionaryLengths = &stream; }
+            if (stream.subtype == LENGTH_VAR_BINARY) { lengths = &stream; }
+            break;
+        }
+    }
+    if (!data) { throw std::runtime_error("property column without data"); }
+    if (data->subtype == DICT_FSST) { throw Unsupported("FSST strings"); }
+
+    auto& hasValue = _ctx.present;
+    if (present) {
+        decodeBits(_ctx, *present, hasValue);
+        if (hasValue.size() < numFeatures) { throw std::runtime_error("short present stream"); }
+    } else {
+        hasValue.assign(numFeatures, 1);
+    }
+    size_t numValues = std::count(hasValue.begin(), hasValue.begin() + numFeatures, 1);
+
+    auto addNumber = [&](double _value) {
+        auto result = _ctx.numberIds.emplace(_value, uint32_t(_table.values.size()));
+        if (result.second) { _table.values.push_back(_value); }
+        return result.first->second;
+    };
+    auto addString = [&](std::string_view _value) {
+        auto result = _ctx.stringIds.emplace(_value, uint32_t(_table.values.size()));
+        if (result.second) { _table.values.push_back(std::string(_value)); }
+        return result.first->second;
+    };
+    auto checkCount = [&](size_t _count) {
+        if (_count < numValues) { throw std::runtime_error("short property stream"); }
+    };
+
+    auto& values = _ctx.columnValues;
+    values.clear();
+    values.reserve(numValues);
+
+    uint32_t type = _column.baseType();
+    switch (type) {
+    case BOOLEAN:
+        decodeBits(_ctx, *data, _ctx.bits);
+        checkCount(_ctx.bits.size());
+        for (size_t i = 0; i < numValues; i++) { values.push_back(addNumber(_ctx.bits[i])); }
+        break;
+
+    case INT_8:
+    case UINT_8:
+    case INT_32:
+    case UINT_32:
+    case INT_64:
+    case UINT_64: {
+        bool isSigned = type == INT_8 || type == INT_32 || type == INT_64;
+        decodeInts(_ctx, *data, isSigned, _ctx.ints);
+        checkCount(_ctx.ints.size());
+        for (size_t i = 0; i < numValues; i++) {
+            int64_t value = _ctx.ints[i];
+            values.push_back(addNumber(type == UINT_64 ? double(uint64_t(value)) : double(value)));
+        }
+        break;
+    }
+    case FLOAT:
+    case DOUBLE: {
+        if (data->encoding != Encoding::none) { throw Unsupported("encoded floating point streams"); }
+        size_t size = type == FLOAT ? sizeof(float) : sizeof(double);
+        checkCount((data->data.end - data->data.pos) / size);
+        // little-endian
+        const uint8_t* pos = data->data.pos;
+        for (size_t i = 0; i < numValues; i++, pos += size) {
+            double value;
+            if (type == FLOAT) {
+                float f;
+                std::memcpy(&f, pos, sizeof(f));
+                value = f;
+            } else {
+                std::memcpy(&value, pos, sizeof(value));
+            }
+            values.push_back(addNumber(value));
+        }
+        break;
+    }
+    case STRING: {
+        Reader bytes = data->data;
+        auto stringAt = [&](size_t _length) {
+            Reader string = bytes.bytes(_length);
+            return std::string_view(reinterpret_cast<const char*>(string.pos), _length);
+        };
+        if (offsets) {
+            // dictionary: index of each value into the entries
+            if (!dictionaryLengths) { throw std::runtime_error("string dictionary without lengths"); }
+            decodeInts(_ctx, *dictionaryLengths, false, _ctx.lengths);
+            _ctx.entryIds.clear();
+            for (int64_t length : _ctx.lengths) {
+                _ctx.entryIds.push_back(addString(stringAt(size_t(length))));
+            }
+            decodeInts(_ctx, *offsets, false, _ctx.ints);
+            checkCount(_ctx.ints.size());
+            for (size_t i = 0; i < numValues; i++) {
+                int64_t entry = _ctx.ints[i];
+                if (entry < 0 || size_t(entry) >= _ctx.entryIds.size()) {
+                    throw std::runtime_error("string dictionary offset out of range");
+                }
+                values.push_back(_ctx.entryIds[entry]);
+            }
+        } else {
+            if (!lengths) { throw std::runtime_error("string column without lengths"); }
+            decodeInts(_ctx, *lengths, false, _ctx.lengths);
+            checkCount(_ctx.lengths.size());
+            for (size_t i = 0; i < numValues; i++) {
+                values.push_back(addString(stringAt(size_t(_ctx.lengths[i]))));
+            }
+        }
+        break;
+    }
+    default:
+        throw Unsupported("unknown column types");
+    }
+
+    for (size_t i = 0, j = 0; i < numFeatures; i++) {
+        _ids[i] = hasValue[i] ? values[j++] : NO_VALUE;
+    }
+}
+
+Layer getLayer(ParserContext& _ctx, const std::string& _name, Reader& _in) {
+
+    Layer layer(_name, _ctx.arena);
+
+    int extent = int(_in.varint());
+    if (extent <= 1) { throw std::runtime_error("invalid tile extent"); }
+
+    size_t numColumns = _in.varint();
+    _ctx.columns.clear();
+    _ctx.streams.clear();
+    for (size_t i = 0; i < numColumns; i++) {
+        Column column;
+        column.type = uint32_t(_in.varint());
+        if (column.baseType() == STRUCT) { throw Unsupported("struct columns"); }
+        if (column.type >= BOOLEAN) { column.name = _in.string(); }
+        _ctx.columns.push_back(std::move(column));
+    }
+
+    // Read the stream metadata of all columns; their data is decoded as needed
+    const Column* geometry = nullptr;
+    for (auto& column : _ctx.columns) {
+        uint32_t type = column.baseType();
+        column.firstStream = _ctx.streams.size();
+        if (type == GEOMETRY || type == STRING) {
+            column.numStreams = _in.varint();
+        } else {
+            column.numStreams = (column.type & 1) ? 2 : 1;
+        }
+        for (size_t i = 0; i < column.numStreams; i++) {
+            _ctx.streams.push_back(readStream(_in));
+        }
+        if (type == GEOMETRY) { geometry = &column; }
+    }
+    if (!geometry) { throw std::runtime_error("layer without geometry column"); }
+
+    decodeGeometry(_ctx, *geometry, extent, layer);
+    size_t numFeatures = layer.features.size();
+
+    auto table = std::make_shared<PropertyTable>();
+    _ctx.numberIds.clear();
+    _ctx.stringIds.clear();
+
+    // property columns that the scene reads, sorted by Property key ordering
+    std::vector<const Column*> properties;
+    const auto* layerKeys = _ctx.propertyKeys ? _ctx.propertyKeys->find(layer.name) : nullptr;
+    for (auto& column : _ctx.columns) {
+        if (column.type < BOOLEAN) { continue; }
+        if (layerKeys && !layerKeys->contains(column.name)) { continue; }
+        properties.push_back(&column);
+    }
+    std::sort(properties.begin(), properties.end(), [](auto* a, auto* b) {
+        return Properties::keyComparator(a->name, b->name);
+    });
+
+    if (_ctx.valueIds.size() < properties.size()) { _ctx.valueIds.resize(properties.size()); }
+    for (size_t i = 0; i < properties.size(); i++) {
+        table->addKey(properties[i]->name);
+        _ctx.valueIds[i].assign(numFeatures, NO_VALUE);
+        decodeProperty(_ctx, *properties[i], *table, _ctx.valueIds[i]);
+    }
+
+    // atoms of the keys and values that filters compare
+    table->findAtoms();
+
+    for (size_t i = 0; i < numFeatures; i++) {
+        std::vector<std::pair<uint32_t, uint32_t>> tags;
+        for (size_t key = 0; key < properties.size(); key++) {
+            uint32_t value = _ctx.valueIds[key][i];
+            if (value != NO_VALUE) { tags.emplace_back(uint32_t(key), value); }
+        }
+        layer.features[i].props.setTable(table, std::move(tags));
+    }
+
+    return layer;
+}
+
+} // namespace
+
+std::shared_ptr<TileData> Mlt::parseTile(const TileTask& _task, int32_t _sourceId,
+                                         const std::vector<std::string>& _layers,
+                                         const PropertyKeys* _propertyKeys) {
+
+    // features, their points, lines and polygons are allocated from the arena of the tile
+    auto tileData = std::make_shared<TileData>(TileArena::acquire());
+
+    auto& task = static_cast<const BinaryTileTask&>(_task);
+    auto data = reinterpret_cast<const uint8_t*>(task.rawTileData->data());
+    Reader tile{ data, data + task.rawTileData->size() };
+
+    ParserContext ctx(_sourceId);
+    ctx.arena = tileData->arena.get();
+    ctx.propertyKeys = _propertyKeys;
+
+    try {
+        while (!tile.empty()) {
+            Reader layer = tile.bytes(tile.varint());
+            if (layer.varint() != LAYER) { continue; }
+
+            std::string name = layer.string();
+            if (!_layers.empty() && std::find(_layers.begin(), _layers.end(), name) == _layers.end()) {
+                continue;
+            }
+            try {
+                tileData->layers.push_back(getLayer(ctx, name, layer));
+            } catch (const Unsupported& e) {
+                LOGW("Skipping layer %s of tile %s: %s are not supported", name.c_str(),
+                     _task.tileId().toString().c_str(), e.what());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        LOGE("Cannot parse tile %s: %s", _task.tileId().toString().c_str(), e.what());
+        return {};
+    } catch (...) {
+        return {};
+    }
+    return tileData;
+}
+
+}
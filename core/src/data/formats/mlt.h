@@ -0,0 +1,36 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class TileTask;
+
+/* MapLibre Tile (MLT) - columnar vector tiles
+ *
+ * A tile is a sequence of layers, each framed as varint(size) varint(tag) with tag 1. A layer
+ * holds its name, extent and the type (and name) of each column, followed by the streams of
+ * the columns. Columns are decoded whole: the geometry column into the flat geometry of the
+ * features, and the property columns into a PropertyTable per layer that the features refer
+ * to, as for Mvt. Pre-tessellated polygons keep their triangles, see Feature::triangles.
+ *
+ * Supported are integer streams with varint encoding, with delta, RLE, delta-RLE and
+ * componentwise delta logical encodings; present and boolean streams (byte RLE); floats and
+ * doubles; plain and dictionary strings; vertex dictionaries. Layers that use FastPFOR, ALP,
+ * FSST, Morton vertices or struct columns are skipped.
+ */
+namespace Mlt {
+
+    // Layers not named in @_layers are skipped without decoding; all layers are read if it is empty.
+    // Properties with keys not in @_propertyKeys are dropped, see PropertyKeys.
+    std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId,
+                                        const std::vector<std::string>& _layers = {},
+                                        const PropertyKeys* _propertyKeys = nullptr);
+
+} // namespace Mlt
+
+} // namespace Tangram
@@ -9,6 +9,13 @@
 #include <algorithm>
 #include <iterator>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_MVT_NEON
+#endif
+
 #define LAYER 3
 
 #define FEATURE_ID 1
@@ -24,6 +31,84 @@
 
 namespace Tangram {
 
+// Widen the bytes at @_p to @_out if the first of them are single-byte varints; returns how many are
+static inline int getSingleByteVarints(const uint8_t* _p, uint32_t* _out) {
+#if defined(__SSE2__)
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_p));
+    const int mask = _mm_movemask_epi8(bytes);
+    if (mask == 0xffff) { return 0; }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(_out), _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(_out + 4), _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(_out + 8), _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(_out + 12), _mm_unpackhi_epi16(hi, zero));
+    return mask == 0 ? 16 : __builtin_ctz(mask);
+#elif defined(TANGRAM_MVT_NEON)
+    const uint8x16_t bytes = vld1q_u8(_p);
+    const uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+    const uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+    vst1q_u32(_out, vmovl_u16(vget_low_u16(lo)));
+    vst1q_u32(_out + 4, vmovl_u16(vget_high_u16(lo)));
+    vst1q_u32(_out + 8, vmovl_u16(vget_low_u16(hi)));
+    vst1q_u32(_out + 12, vmovl_u16(vget_high_u16(hi)));
+    if (vmaxvq_u8(bytes) < 0x80) { return 16; }
+    int count = 0;
+    while (_p[count] < 0x80) { count++; }
+    return count;
+#else
+    int count = 0;
+    while (count < 16 && _p[count] < 0x80) {
+        _out[count] = _p[count];
+        count++;
+    }
+    return count;
+#endif
+}
+
+size_t Mvt::getVarints(protobuf::message& _msg, uint32_t* _out, size_t _count) {
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(_msg.getData());
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(_msg.getEnd());
+
+    size_t i = 0;
+    while (i < _count && p < end) {
+
+        // geometry deltas mostly fit in one byte: decode those 16 at a time
+        if (end - p >= 16) {
+            int n = getSingleByteVarints(p, _out + i);
+            if (n > 0) {
+                n = std::min(size_t(n), _count - i);
+                p += n;
+                i += n;
+                continue;
+            }
+        }
+
+        uint32_t value = 0;
+        int shift = 0;
+        uint8_t byte;
+        do {
+            if (p >= end) {
+                throw std::runtime_error("unterminated varint, unexpected end of buffer");
+            }
+            if (shift >= 70) {
+                throw std::runtime_error("unterminated varint (too long)");
+            }
+            byte = *p++;
+            if (shift < 32) { value |= uint32_t(byte & 0x7f) << shift; }
+            shift += 7;
+        } while (byte & 0x80);
+
+        _out[i++] = value;
+    }
+
+    _msg.skipBytes(p - reinterpret_cast<const uint8_t*>(_msg.getData()));
+    return i;
+}
+
 void Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
 
     // previously, this fn was creating new Geometry instance every time, but vector realloc was showing
@@ -57,18 +142,41 @@ void Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
                 numCoordinates = 0;
             }
 
-            x += _geomIn.svarint();
-            y += _geomIn.svarint();
-
-            // bring the points in 0 to 1 space
-            Point p;
-            p.x = invTileExtent * (double)x;
-            p.y = invTileExtent * (double)(_ctx.tileExtent - y);
-
-            if (numCoordinates == 0 || geometry.coordinates.back() != p) {
-                geometry.coordinates.push_back(p);
-                numCoordinates++;
+            // decode the parameters of all points of a lineTo at once; each takes at least two bytes
+            size_t count = 1;
+            if (cmd == GeomCmd::lineTo) {
+                count = std::min(size_t(cmdRepeat), size_t(_geomIn.getEnd() - _geomIn.getData()) / 2 + 1);
+            }
+            auto& parameters = _ctx.parameters;
+            parameters.resize(2 * count + 16);
+            size_t decoded = getVarints(_geomIn, parameters.data(), 2 * count);
+            if (decoded % 2 != 0) {
+                throw std::runtime_error("unterminated varint, unexpected end of buffer");
             }
+            count = decoded / 2;
+
+            geometry.coordinates.reserve(geometry.coordinates.size() + count + 1);
+            for (size_t i = 0; i < count; i++) {
+                // zigzag decoded deltas
+                uint32_t dx = parameters[2 * i];
+                uint32_t dy = parameters[2 * i + 1];
+                x += int32_t(dx >> 1) ^ -int32_t(dx & 1);
+                y += int32_t(dy >> 1) ^ -int32_t(dy & 1);
+
+                // bring the points in 0 to 1 space
+                Point p;
+                p.x = invTileExtent * (double)x;
+                p.y = invTileExtent * (double)(_ctx.tileExtent - y);
+
+                if (numCoordinates == 0 || geometry.coordinates.back() != p) {
+                    geometry.coordinates.push_back(p);
+                    numCoordinates++;
+                }
+            }
+            if (count == 0) { break; }
+            cmdRepeat -= count;
+            continue;
+
         } else if(cmd == GeomCmd::closePath) {
             // end of a polygon, push first point in this line as last and push line to poly
             geometry.coordinates.push_back(geometry.coordinates[geometry.coordinates.size() - numCoordinates]);
@@ -88,11 +196,11 @@ void Mvt::getGeometry(ParserContext& _ctx, protobuf::message _geomIn) {
 
 Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
 
-    Feature feature(_ctx.sourceId);
+    Feature feature(_ctx.sourceId, _ctx.arena);
 
     size_t numTags = 0;
     _ctx.featureTags.clear();
-    _ctx.featureTags.assign(_ctx.keys.size(), -1);
+    _ctx.featureTags.assign(_ctx.table->keys.size(), -1);
 
     while(_featureIn.next()) {
         switch(_featureIn.tag) {
@@ -107,7 +215,7 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                 while(tagsMsg) {
                     auto tagKey = tagsMsg.varint();
 
-                    if(_ctx.keys.size() <= tagKey) {
+                    if(_ctx.table->keys.size() <= tagKey) {
                         LOGE("accessing out of bound key");
                         return feature;
                     }
@@ -119,7 +227,7 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
 
                     auto valueKey = tagsMsg.varint();
 
-                    if( _ctx.values.size() <= valueKey ) {
+                    if( _ctx.table->values.size() <= valueKey ) {
                         LOGE("accessing out of bound values");
                         return feature;
                     }
@@ -143,35 +251,33 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
         }
     }
 
-    std::vector<Properties::Item> properties;
-    properties.reserve(numTags);
+    // values are looked up in the layer table, items are only created for copies
+    std::vector<std::pair<uint32_t, uint32_t>> tags;
+    tags.reserve(numTags);
 
     for (int tagKey : _ctx.orderedKeys) {
         int tagValue = _ctx.featureTags[tagKey];
         if (tagValue >= 0) {
-            properties.emplace_back(_ctx.keys[tagKey], _ctx.values[tagValue]);
+            tags.emplace_back(tagKey, tagValue);
         }
     }
-    feature.props.setSorted(std::move(properties));
+    feature.props.setTable(_ctx.table, std::move(tags));
 
     switch(feature.geometryType) {
         case GeometryType::points:
-            feature.points.insert(feature.points.begin(),
-                                  _ctx.geometry.coordinates.begin(),
-                                  _ctx.geometry.coordinates.end());
+            feature.coordinates.assign(_ctx.geometry.coordinates.begin(),
+                                       _ctx.geometry.coordinates.end());
             break;
 
         case GeometryType::lines:
         {
             auto pos = _ctx.geometry.coordinates.begin();
-            feature.lines.reserve(_ctx.geometry.sizes.size());
+            feature.coordinates.reserve(_ctx.geometry.coordinates.size());
+            feature.ringEnds.reserve(_ctx.geometry.sizes.size());
             for (int length : _ctx.geometry.sizes) {
                 //if (length == 0) { continue; }  -- no longer possible for 0 to be added to sizes
-                Line line;
-                line.reserve(length);
-                line.insert(line.begin(), pos, pos + length);
+                feature.addLine(pos, pos + length);
                 pos += length;
-                feature.lines.emplace_back(std::move(line));
             }
             break;
         }
@@ -179,6 +285,8 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
         {
             auto pos = _ctx.geometry.coordinates.begin();
             auto rpos = _ctx.geometry.coordinates.rend();
+            feature.coordinates.reserve(_ctx.geometry.coordinates.size());
+            feature.ringEnds.reserve(_ctx.geometry.sizes.size());
             for (int length : _ctx.geometry.sizes) {
                 //if (length == 0) { continue; }
                 float area = signedArea(pos, pos + length);
@@ -192,20 +300,17 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
                 if (_ctx.winding == 0) {
                     _ctx.winding = winding;
                 }
-                Line line;
-                line.reserve(length);
+                if (winding == _ctx.winding || feature.polygonEnds.empty()) {
+                    // This is an exterior polygon.
+                    feature.beginPolygon();
+                }
                 if (_ctx.winding > 0) {
-                    line.insert(line.end(), pos, pos + length);
+                    feature.addRing(pos, pos + length);
                 } else {
-                    line.insert(line.end(), rpos - length, rpos);
+                    feature.addRing(rpos - length, rpos);
                 }
                 pos += length;
                 rpos -= length;
-                if (winding == _ctx.winding || feature.polygons.empty()) {
-                    // This is an exterior polygon.
-                    feature.polygons.emplace_back();
-                }
-                feature.polygons.back().push_back(std::move(line));
             }
             break;
         }
@@ -222,12 +327,14 @@ Feature Mvt::getFeature(ParserContext& _ctx, protobuf::message _featureIn) {
 
 Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
 
-    Layer layer("");
+    Layer layer("", _ctx.arena);
 
-    _ctx.keys.clear();
-    _ctx.values.clear();
+    _ctx.table = std::make_shared<PropertyTable>();
     _ctx.featureMsgs.clear();
 
+    auto& keys = _ctx.table->keys;
+    auto& values = _ctx.table->values;
+
     bool lastWasFeature = false;
     size_t numFeatures = 0;
     protobuf::message featureItr;
@@ -253,7 +360,7 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                 continue;
             }
             case LAYER_KEY: {
-                _ctx.keys.push_back(_layerIn.string());
+                _ctx.table->addKey(_layerIn.string());
                 break;
             }
             case LAYER_VALUE: {
@@ -262,28 +369,28 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
                 while (valueItr.next()) {
                     switch (valueItr.tag) {
                         case 1: // string value
-                            _ctx.values.push_back(valueItr.string());
+                            values.push_back(valueItr.string());
                             break;
                         case 2: // float value
-                            _ctx.values.push_back(valueItr.float32());
+                            values.push_back(valueItr.float32());
                             break;
                         case 3: // double value
-                            _ctx.values.push_back(valueItr.float64());
+                            values.push_back(valueItr.float64());
                             break;
                         case 4: // int value
-                            _ctx.values.push_back(valueItr.int64());
+                            values.push_back(valueItr.int64());
                             break;
                         case 5: // uint value
-                            _ctx.values.push_back(valueItr.varint());
+                            values.push_back(valueItr.varint());
                             break;
                         case 6: // sint value
-                            _ctx.values.push_back(valueItr.svarint());  //int64());
+                            values.push_back(valueItr.svarint());  //int64());
                             break;
                         case 7: // bool value
-                            _ctx.values.push_back(valueItr.boolean());
+                            values.push_back(valueItr.boolean());
                             break;
                         default:
-                            _ctx.values.push_back(none_type{});
+                            values.push_back(none_type{});
                             valueItr.skip();
                             break;
                     }
@@ -307,17 +414,22 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
 
     if (_ctx.featureMsgs.empty()) { return layer; }
 
+    // atoms of the keys and values that filters compare
+    _ctx.table->findAtoms();
+
     //// Assign ordering to keys for faster sorting
     _ctx.orderedKeys.clear();
-    _ctx.orderedKeys.reserve(_ctx.keys.size());
-    // assign key ids
-    for (int i = 0, n = _ctx.keys.size(); i < n; i++) {
+    _ctx.orderedKeys.reserve(keys.size());
+    const auto* layerKeys = _ctx.propertyKeys ? _ctx.propertyKeys->find(layer.name) : nullptr;
+    // assign key ids, skipping keys that the scene does not read
+    for (int i = 0, n = keys.size(); i < n; i++) {
+        if (layerKeys && !layerKeys->contains(keys[i])) { continue; }
         _ctx.orderedKeys.push_back(i);
     }
     // sort by Property key ordering
     std::sort(_ctx.orderedKeys.begin(), _ctx.orderedKeys.end(),
               [&](int a, int b) {
-                  return Properties::keyComparator(_ctx.keys[a], _ctx.keys[b]);
+                  return Properties::keyComparator(keys[a], keys[b]);
               });
 
     layer.features.reserve(numFeatures);
@@ -333,14 +445,28 @@ Layer Mvt::getLayer(ParserContext& _ctx, protobuf::message _layerIn) {
     return layer;
 }
 
-std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceId) {
+// Name of the layer, read without decoding the rest of it
+static std::string getLayerName(protobuf::message _layerIn) {
+    while (_layerIn.next()) {
+        if (_layerIn.tag == LAYER_NAME) { return _layerIn.string(); }
+        _layerIn.skip();
+    }
+    return "";
+}
+
+std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceId,
+                                         const std::vector<std::string>& _layers,
+                                         const PropertyKeys* _propertyKeys) {
 
-    auto tileData = std::make_shared<TileData>();
+    // features, their points, lines and polygons are allocated from the arena of the tile
+    auto tileData = std::make_shared<TileData>(TileArena::acquire());
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
     protobuf::message item(task.rawTileData->data(), task.rawTileData->size());
     ParserContext ctx(_sourceId);
+    ctx.arena = tileData->arena.get();
+    ctx.propertyKeys = _propertyKeys;
 
 #ifdef TANGRAM_DUMP_MVT_STATS
     LOGW("Stats for vector tile %s (%d bytes):", _task.tileId().toString().c_str(), task.rawTileData->size());
@@ -349,7 +475,12 @@ std::shared_ptr<TileData> Mvt::parseTile(const TileTask& _task, int32_t _sourceI
     try {
         while(item.next()) {
             if(item.tag == LAYER) {
-                tileData->layers.push_back(getLayer(ctx, item.getMessage()));
+                auto layer = item.getMessage();
+                if (!_layers.empty() &&
+                    std::find(_layers.begin(), _layers.end(), getLayerName(layer)) == _layers.end()) {
+                    continue;
+                }
+                tileData->layers.push_back(getLayer(ctx, layer));
             } else {
                 item.skip();
             }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "pbf/pbf.hpp"
 #include "util/variant.h"
@@ -25,13 +26,19 @@ namespace Mvt {
         ParserContext(int32_t _sourceId) : sourceId(_sourceId){}
 
         int32_t sourceId;
-        std::vector<std::string> keys;
-        std::vector<Value> values;
+        // arena of the TileData for features and their geometry
+        TileArena* arena = nullptr;
+        // keys read by the scene, or nullptr to keep all properties
+        const PropertyKeys* propertyKeys = nullptr;
+        // keys and values of the current layer, referred to by its features
+        std::shared_ptr<PropertyTable> table;
         std::vector<protobuf::message> featureMsgs;
         Geometry geometry;
+        // decoded geometry parameters of one command
+        std::vector<uint32_t> parameters;
         // Map Key ID -> Tag values
         std::vector<int> featureTags;
-        // Key IDs sorted by Property key ordering
+        // Key IDs sorted by Property key ordering, without keys dropped by propertyKeys
         std::vector<int> orderedKeys;
 
         int tileExtent = 0;
@@ -44,13 +51,22 @@ namespace Mvt {
         closePath = 7
     };
 
+    /* Decode up to @_count varints of at most 32 bits from @_msg into @_out, which must have
+     * room for @_count + 16 values; stops early at the end of @_msg. Returns the number of
+     * decoded values. */
+    size_t getVarints(protobuf::message& _msg, uint32_t* _out, size_t _count);
+
     void getGeometry(ParserContext& _ctx, protobuf::message _geomIn);
 
     Feature getFeature(ParserContext& _ctx, protobuf::message _featureIn);
 
     Layer getLayer(ParserContext& _ctx, protobuf::message _layerIn);
 
-    std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId);
+    // Layers not named in @_layers are skipped without decoding; all layers are read if it is empty.
+    // Properties with keys not in @_propertyKeys are dropped, see PropertyKeys.
+    std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId,
+                                        const std::vector<std::string>& _layers = {},
+                                        const PropertyKeys* _propertyKeys = nullptr);
 
 } // namespace Mvt
 
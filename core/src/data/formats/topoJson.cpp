@@ -26,47 +26,44 @@ TopoJson::Topology TopoJson::getTopology(const JsonDocument& _document, const Tr
         }
     }
 
-    // Quantized, delta-encoded 'arcs' in Json
+    // Quantized, delta-encoded 'arcs' in Json, decoded when used
     auto jsonArcList = _document.FindMember("arcs");
 
-    if (jsonArcList == _document.MemberEnd()) {
-        return topo;
+    if (jsonArcList != _document.MemberEnd() && jsonArcList->value.IsArray()) {
+        topo.jsonArcs = &jsonArcList->value;
     }
 
-    const auto& jsonArcs = jsonArcList->value;
-
-    if (!jsonArcs.IsArray()) {
-        return topo;
-    }
-
-    topo.arcs.reserve(jsonArcs.Size());
-
-    // Decode and transform the points that make up 'arcs'
-    for (auto jsonArcsIt = jsonArcs.Begin(); jsonArcsIt != jsonArcs.End(); ++jsonArcsIt) {
+    return topo;
+}
 
-        const auto& jsonArc = *jsonArcsIt;
+const Line& TopoJson::Topology::arc(size_t _index) {
 
-        if (!jsonArc.IsArray()) { // According to spec, jsonArc.Size() >= 2 should also hold
-            continue;
-        }
+    if (m_arcs.empty()) {
+        m_arcs.resize(arcCount());
+        m_decoded.resize(arcCount());
+    }
 
-        Line arc;
-        arc.reserve(jsonArc.Size());
+    Line& arc = m_arcs[_index];
+    if (m_decoded[_index]) { return arc; }
+    m_decoded[_index] = true;
 
-        // Quantized position
-        glm::ivec2 q;
+    const auto& jsonArc = (*jsonArcs)[_index];
 
-        for (auto jsonCoordsIt = jsonArc.Begin(); jsonCoordsIt != jsonArc.End(); ++jsonCoordsIt) {
+    if (!jsonArc.IsArray()) { // According to spec, jsonArc.Size() >= 2 should also hold
+        return arc;
+    }
 
-            const auto& jsonCoords = *jsonCoordsIt;
+    arc.reserve(jsonArc.Size());
 
-            arc.push_back(getPoint(jsonCoords, topo, q));
-        }
+    // Quantized position
+    glm::ivec2 q(0);
 
-        topo.arcs.push_back(arc);
+    // Decode and transform the points that make up the arc
+    for (auto jsonCoordsIt = jsonArc.Begin(); jsonCoordsIt != jsonArc.End(); ++jsonCoordsIt) {
+        arc.push_back(getPoint(*jsonCoordsIt, *this, q));
     }
 
-    return topo;
+    return arc;
 }
 
 Point TopoJson::getPoint(const JsonValue& _coordinates, const Topology& _topology, glm::ivec2& _cursor) {
@@ -83,7 +80,7 @@ Point TopoJson::getPoint(const JsonValue& _coordinates, const Topology& _topolog
 
 }
 
-Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
+Line TopoJson::getLine(const JsonValue& _arcs, Topology& _topology) {
 
     Line line;
 
@@ -100,11 +97,12 @@ Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
             index = -1 - index;
         }
 
-        if (index < 0 || (std::vector<Line>::size_type)index >= _topology.arcs.size()) {
+        if (index < 0 || size_t(index) >= _topology.arcCount()) {
             continue;
         }
 
-        const auto& arc = _topology.arcs[index];
+        const auto& arc = _topology.arc(index);
+        if (arc.empty()) { continue; }
 
         auto begin = arc.begin();
         auto end = arc.end();
@@ -132,7 +130,7 @@ Line TopoJson::getLine(const JsonValue& _arcs, const Topology& _topology) {
 
 }
 
-Polygon TopoJson::getPolygon(const JsonValue& _arcSets, const Topology& _topology) {
+Polygon TopoJson::getPolygon(const JsonValue& _arcSets, Topology& _topology) {
 
     Polygon polygon;
 
@@ -151,7 +149,8 @@ Polygon TopoJson::getPolygon(const JsonValue& _arcSets, const Topology& _topolog
 
 }
 
-Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _source) {
+Feature TopoJson::getFeature(const JsonValue& _geometry, Topology& _topology, int32_t _source,
+                             const PropertyKeys::Keys* _keys) {
 
     static const JsonValue keyProperties("properties");
     static const JsonValue keyType("type");
@@ -162,7 +161,7 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
 
     auto propertiesIt = _geometry.FindMember(keyProperties);
     if (propertiesIt != _geometry.MemberEnd() && propertiesIt->value.IsObject()) {
-        feature.props = GeoJson::getProperties(propertiesIt->value, _source);
+        feature.props = GeoJson::getProperties(propertiesIt->value, _source, _keys);
     }
 
     std::string type;
@@ -176,7 +175,7 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
         auto coordinatesIt = _geometry.FindMember(keyCoordinates);
         if (coordinatesIt != _geometry.MemberEnd()) {
             glm::ivec2 cursor;
-            feature.points.push_back(getPoint(coordinatesIt->value, _topology, cursor));
+            feature.addPoint(getPoint(coordinatesIt->value, _topology, cursor));
         }
     } else if (type == "MultiPoint") {
         feature.geometryType = GeometryType::points;
@@ -185,14 +184,14 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
             auto& coordinates = coordinatesIt->value;
             for (auto point = coordinates.Begin(); point != coordinates.End(); ++point) {
                 glm::ivec2 cursor;
-                feature.points.push_back(getPoint(*point, _topology, cursor));
+                feature.addPoint(getPoint(*point, _topology, cursor));
             }
         }
     } else if (type == "LineString") {
         feature.geometryType = GeometryType::lines;
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd()) {
-            feature.lines.push_back(getLine(arcsIt->value, _topology));
+            feature.addLine(getLine(arcsIt->value, _topology));
         }
     } else if (type == "MultiLineString") {
         feature.geometryType = GeometryType::lines;
@@ -200,14 +199,14 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
         if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
             auto& arcs = arcsIt->value;
             for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.lines.push_back(getLine(*arcList, _topology));
+                feature.addLine(getLine(*arcList, _topology));
             }
         }
     } else if (type == "Polygon") {
         feature.geometryType = GeometryType::polygons;
         auto arcsIt = _geometry.FindMember(keyArcs);
         if (arcsIt != _geometry.MemberEnd()) {
-            feature.polygons.push_back(getPolygon(arcsIt->value, _topology));
+            feature.addPolygon(getPolygon(arcsIt->value, _topology));
         }
     } else if (type == "MultiPolygon") {
         feature.geometryType = GeometryType::polygons;
@@ -215,7 +214,7 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
         if (arcsIt != _geometry.MemberEnd() && arcsIt->value.IsArray()) {
             auto& arcs = arcsIt->value;
             for (auto arcList = arcs.Begin(); arcList != arcs.End(); ++arcList) {
-                feature.polygons.push_back(getPolygon(*arcList, _topology));
+                feature.addPolygon(getPolygon(*arcList, _topology));
             }
         }
     } else if (type == "GeometryCollection") {
@@ -226,9 +225,11 @@ Feature TopoJson::getFeature(const JsonValue& _geometry, const Topology& _topolo
 
 }
 
-Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, const Topology& _topology, int32_t _source) {
+Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, Topology& _topology, int32_t _source,
+                         const PropertyKeys* _propertyKeys) {
 
     Layer layer(_objectIt->name.GetString());
+    const auto* keys = _propertyKeys ? _propertyKeys->find(layer.name) : nullptr;
 
     JsonValue& object = _objectIt->value;
     auto type = object.FindMember("type");
@@ -236,7 +237,7 @@ Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, const Topology& _
         auto geometries = object.FindMember("geometries");
         if (geometries != object.MemberEnd() && geometries->value.IsArray()) {
             for (auto it = geometries->value.Begin(); it != geometries->value.End(); ++it) {
-                layer.features.push_back(getFeature(*it, _topology, _source));
+                layer.features.push_back(getFeature(*it, _topology, _source, keys));
             }
         }
     }
@@ -245,7 +246,8 @@ Layer TopoJson::getLayer(JsonValue::MemberIterator& _objectIt, const Topology& _
 
 }
 
-std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _source) {
+std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _source,
+                                              const PropertyKeys* _propertyKeys) {
 
     auto& task = static_cast<const BinaryTileTask&>(_task);
 
@@ -282,7 +284,7 @@ std::shared_ptr<TileData> TopoJson::parseTile(const TileTask& _task, int32_t _so
     if (objectsIt == document.MemberEnd()) { return tileData; }
     auto& objects = objectsIt->value;
     for (auto layer = objects.MemberBegin(); layer != objects.MemberEnd(); ++layer) {
-        tileData->layers.push_back(TopoJson::getLayer(layer, topology, _source));
+        tileData->layers.push_back(TopoJson::getLayer(layer, topology, _source, _propertyKeys));
     }
 
     // Discard JSON object and return TileData
@@ -19,23 +19,40 @@ using Transform = std::function<Point(LngLat _lngLat)>;
 struct Topology {
     glm::dvec2 scale = { 1., 1. };
     glm::dvec2 translate = { 0., 0. };
-    std::vector<Line> arcs;
     Transform proj;
+
+    // Quantized, delta-encoded 'arcs' of the document, or nullptr
+    const JsonValue* jsonArcs = nullptr;
+
+    size_t arcCount() const { return jsonArcs ? jsonArcs->Size() : 0; }
+
+    // Decoded and transformed arc @_index < arcCount(); each arc is decoded once, when it is
+    // first used, as arcs are shared between the features of a topology
+    const Line& arc(size_t _index);
+
+private:
+    std::vector<Line> m_arcs;
+    std::vector<bool> m_decoded;
 };
 
+// Topology of @_document, which must outlive it
 Topology getTopology(const JsonDocument& _document, const Transform& _proj);
 
 Point getPoint(const JsonValue& _coordinates, const Topology& _topology, glm::ivec2& _cursor);
 
-Line getLine(const JsonValue& _arcs, const Topology& _topology);
+Line getLine(const JsonValue& _arcs, Topology& _topology);
 
-Polygon getPolygon(const JsonValue& _arcs, const Topology& _topology);
+Polygon getPolygon(const JsonValue& _arcs, Topology& _topology);
 
-Feature getFeature(const JsonValue& _geometry, const Topology& _topology, int32_t _sourceId);
+// Properties with keys not in @_keys are dropped, unless it is nullptr
+Feature getFeature(const JsonValue& _geometry, Topology& _topology, int32_t _sourceId,
+                   const PropertyKeys::Keys* _keys = nullptr);
 
-Layer getLayer(JsonValue::MemberIterator& _object, const Topology& _topology, int32_t _sourceId);
+Layer getLayer(JsonValue::MemberIterator& _object, Topology& _topology, int32_t _sourceId,
+               const PropertyKeys* _propertyKeys = nullptr);
 
-std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId);
+std::shared_ptr<TileData> parseTile(const TileTask& _task, int32_t _sourceId,
+                                    const PropertyKeys* _propertyKeys = nullptr);
 
 } // namespace TopoJson
 
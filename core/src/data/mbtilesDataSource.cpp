@@ -1,7 +1,9 @@
 #include "data/mbtilesDataSource.h"
 
-#include "util/asyncWorker.h"
+#include "data/tileLoad.h"
+#include "util/ioExecutor.h"
 #include "util/zlibHelper.h"
+#include "tile/tileAvailability.h"
 #include "log.h"
 #include "platform.h"
 #include "util/url.h"
@@ -11,6 +13,36 @@
 #define SQLITEPP_LOGE LOGE
 #include "sqlitepp.h"
 #include "hash-library/md5.cpp"
+#include "pmtiles/pmtiles.hpp"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+// Maximum number of read-only connections, each read by its own IOQueue
+#define MBTILES_MAX_READERS 4
+// Maximum bytes of the database file memory mapped by each read connection
+#define MBTILES_MMAP_SIZE (256 * 1024 * 1024)
+// Stored tiles are committed in one transaction when one of these limits is reached
+#define MBTILES_BATCH_TILES 64
+#define MBTILES_BATCH_BYTES (4 * 1024 * 1024)
+#define MBTILES_BATCH_DELAY_MS 1000
+// Tiles are dropped instead of added to the pending tiles beyond this size, i.e. when commits fail
+#define MBTILES_MAX_PENDING_BYTES (8 * MBTILES_BATCH_BYTES)
+// Failed commits of the pending tiles in a row after which they are dropped
+#define MBTILES_MAX_COMMIT_FAILURES 10
+// Seconds after which an unanswered revalidation of a stale tile is started again
+#define MBTILES_REVALIDATE_TIMEOUT_SEC 60
 
 
 namespace Tangram {
@@ -82,33 +114,62 @@ PRAGMA user_version = 3;
 COMMIT;)SQL_ESC";
 
 
+static const char* GET_TILE_DATA =
+    "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;";
+static const char* GET_CACHED_TILE_DATA =
+    "SELECT tile_data, images.tile_id, images.created_at FROM images JOIN map ON"
+    " images.tile_id = map.tile_id WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;";
+
 struct MBTilesQueries {
     SQLiteStmt getTileData;  // SELECT statement from tiles view
     SQLiteStmt putMap = nullptr;  // REPLACE INTO statement in map table
     SQLiteStmt putImage = nullptr;  // REPLACE INTO statement in images table
+    SQLiteStmt touchImage = nullptr;  // UPDATE of created_at of stored data in images table
     // caching and offline maps
     SQLiteStmt getOffline = nullptr;
     SQLiteStmt putOffline = nullptr;
     SQLiteStmt putLastAccess = nullptr;
 
     struct tag_cache {};
+    struct tag_cache_read {};
     MBTilesQueries(sqlite3* db);
     MBTilesQueries(sqlite3* db, tag_cache);
+    // only getTileData, for read connections to a cache
+    MBTilesQueries(sqlite3* db, tag_cache_read);
 };
 
 MBTilesQueries::MBTilesQueries(sqlite3* db) :
-    getTileData(db, "SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;") {}
+    getTileData(db, GET_TILE_DATA) {}
+
+MBTilesQueries::MBTilesQueries(sqlite3* db, tag_cache_read) :
+    getTileData(db, GET_CACHED_TILE_DATA) {}
 
 MBTilesQueries::MBTilesQueries(sqlite3* db, tag_cache) :
-    getTileData(db, "SELECT tile_data, images.tile_id, images.created_at FROM images JOIN map ON"
-        " images.tile_id = map.tile_id WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;"),
+    getTileData(db, GET_CACHED_TILE_DATA),
     putMap(db, "REPLACE INTO map (zoom_level, tile_column, tile_row, tile_id) VALUES (?, ?, ?, ?);"),
     putImage(db, "REPLACE INTO images (tile_id, tile_data, created_at) VALUES (?, ?, CAST(strftime('%s') AS INTEGER));"),
+    touchImage(db, "UPDATE images SET created_at = CAST(strftime('%s') AS INTEGER) WHERE tile_id = ?;"),
     getOffline(db, "SELECT 1,tile_id FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?;"),
     putOffline(db, "REPLACE INTO offline_tiles (tile_id, offline_id) VALUES (?, ?);"),
     putLastAccess(db, "REPLACE INTO tile_last_access (tile_id, last_access) VALUES"
         " (?, CAST(strftime('%s') AS INTEGER));") {}
 
+// Read-only connection with its own queue
+struct MBTilesDataSource::Reader {
+    SQLiteDB db;
+    std::unique_ptr<MBTilesQueries> queries;
+    std::atomic<int> pending{0};
+    // declared last so that queued reads are finished before the connection is closed
+    std::unique_ptr<IOQueue> worker;
+
+    // counts a read as pending until it has run or was dropped for a canceled task
+    struct Pending {
+        explicit Pending(Reader& _reader) : reader(_reader) { reader.pending++; }
+        ~Pending() { reader.pending--; }
+        Reader& reader;
+    };
+};
+
 MBTilesDataSource::MBTilesDataSource(Platform& _platform, std::string _name, std::string _path,
                                      std::string _mime, int64_t _maxCacheAge, bool _offlineFallback)
     : m_name(_name),
@@ -119,7 +180,7 @@ MBTilesDataSource::MBTilesDataSource(Platform& _platform, std::string _name, std
       m_offlineMode(_offlineFallback),
       m_platform(_platform) {
 
-    m_worker = std::make_unique<AsyncWorker>(("MBTilesDataSource worker: " + _name).c_str());
+    m_worker = std::make_unique<IOQueue>();
     // max_age > 2**30 is interpreted as minimum creation time (clamped to current time)
     if (m_maxCacheAge > (1<<30)) { m_maxCacheAge = std::min(m_maxCacheAge, int64_t(secSinceEpoch())); }
 
@@ -127,7 +188,13 @@ MBTilesDataSource::MBTilesDataSource(Platform& _platform, std::string _name, std
 }
 
 // need explicit destructor since MBTilesQueries is incomplete in header
-MBTilesDataSource::~MBTilesDataSource() {}
+MBTilesDataSource::~MBTilesDataSource() {
+    if (m_db && m_cacheMode) { commitTiles(); }
+    // tiles that could not be committed are lost
+    for (auto& tile : m_pending) {
+        for (auto& onStored : tile.onStored) { onStored(false); }
+    }
+}
 
 bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 
@@ -145,7 +212,7 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
 
     if (_task->rawSource == this->level) {
 
-        m_worker->enqueue([this, _task, _cb](){
+        enqueueRead(_task, [this, _task, _cb](MBTilesQueries& _queries){
             if (_task->isCanceled()) {  // task may have been canceled while in queue
               LOGV("%s - canceled tile: %s", m_name.c_str(), _task->tileId().toString().c_str());
               return;
@@ -156,25 +223,32 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
                 return;
             }
             TileID tileId = _task->tileId();
+            if (!next && !m_cacheMode && _task->source() && !m_availabilityRead.exchange(true)) {
+                readAvailability(_task->source()->availability());
+            }
             LOGTO(">>> DB query for %s %s",
                   _task->source() ? _task->source()->name().c_str() : "?", tileId.toString().c_str());
 
             auto& task = static_cast<BinaryTileTask&>(*_task);
-            auto tileData = std::make_unique<std::vector<char>>();
+            auto tileData = pooledBuffer();
             // RasterTileTask::hasData() doesn't check if rawTileData is empty - it probably should, but
             //  let's not set rawTileData to empty vector, to match NetworkDataSource behavior
             int64_t createdAt = 0;
-            getTileData(tileId, *tileData, createdAt, task.offlineId);
+            auto compressed = pooledBuffer();
+            getTileData(_queries, tileId, *tileData, createdAt, task.offlineId, compressed.get());
             LOGTO("<<< DB query for %s %s%s", _task->source() ? _task->source()->name().c_str() : "?",
                   tileId.toString().c_str(), tileData->empty() ? " (not found)" : "");
 
             // if tile is expired, request from network, falling back to stale tile on failure
             int64_t minCreatedAt = m_maxCacheAge > (1<<30) ? m_maxCacheAge
                                                            : int64_t(secSinceEpoch()) - m_maxCacheAge;
+            bool expired = next && m_cacheMode && createdAt < minCreatedAt;
+            // or serve stale tile now and request it in the background
+            bool revalidate = expired && m_staleWhileRevalidate && !tileData->empty();
             TileTaskCb stalecb;
-            if (next && m_cacheMode && createdAt < minCreatedAt) {
+            if (expired && !revalidate) {
                 LOGV("%s - stale tile: %s", m_name.c_str(), tileId.toString().c_str());
-                // can't capture unique_ptr, and callback not guaranteed to be called so can't use bare ptr
+                // callback not guaranteed to be called so can't use bare ptr
                 // ... and we don't want to put stale data in rawTileData or we'd need a flag to skip writing
                 //  back to DB (erroneously updating creation time) should network request fail
                 std::shared_ptr<std::vector<char>> staleData(std::move(tileData));
@@ -191,8 +265,11 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
 
             if (tileData && !tileData->empty()) {
                 task.rawTileData = std::move(tileData);  // known data race w/ TileTask::hasData() on main thread
+                if (!compressed->empty()) { task.compressedTileData = std::move(compressed); }
                 LOGV("%s - loaded tile: %s, %d bytes", m_name.c_str(), tileId.toString().c_str(), task.rawTileData->size());
 
+                if (revalidate) { revalidateTile(_task, task.rawTileData); }
+
                 _cb.func(_task);
 
             } else if (next) {
@@ -209,6 +286,7 @@ bool MBTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb
                 }
             } else {
                 LOGD("%s - missing tile: %s", m_name.c_str(), _task->tileId().toString().c_str());
+                if (_task->source()) { _task->source()->availability().setMissing(tileId); }
                 _cb.func(_task);  // added 2022-09-27 ... were doing this in loadNextSource, why not here?
             }
         });
@@ -225,71 +303,114 @@ bool MBTilesDataSource::loadNextSource(std::shared_ptr<TileTask> _task, TileTask
         return next->loadTileData(_task, _cb);
     }
 
-    // Intercept TileTaskCb to store result from next source.
-    TileTaskCb cb{[this, _cb](std::shared_ptr<TileTask> _task) {
-        // it is expected that the DataSource `next` has called _task->prana() to lock the Scene
-        //  if this callback is not run on the main thread
-        if (_task->hasData()) {
-
-            auto& task = static_cast<BinaryTileTask&>(*_task);
-            std::shared_ptr<std::vector<char>> tileData = task.rawTileData;
-            auto& zin = *task.rawTileData;
-            if (zin.size() > 10 && zin[0] == 0x1F && (unsigned char)zin[1] == 0x8B) {
-                auto pzout = std::make_shared<std::vector<char>>();
-                if (zlib_inflate(zin.data(), zin.size(), *pzout) == 0) {
-                    task.rawTileData = pzout;
-                    // rawTileData now points to uncompressed data for building tile, while tileData points
-                    //  to compressed data received from server to be stored in DB
-                    if (m_cacheMode && m_schemaOptions.compression != Compression::undefined) {
-                        m_db->exec("REPLACE INTO metadata (name, value) VALUES ('compression', 'undefined');");
-                        m_schemaOptions.compression = Compression::undefined;
-                    }
-                }
-            }
+    return loadFromNext(std::move(_task), std::move(_cb)).started();
+}
 
-            if (m_cacheMode) {
-                if (_task->offlineId) {
-                    // for offline map download, we must force retry if storing tile fails (due to locked DB)
-                    if (!storeTileData(task.tileId(), *tileData, task.offlineId)) {
-                        task.rawTileData->clear();
-                    }
-                } else {
-                    m_worker->enqueue([this, _task, tileData](){
-                        storeTileData(_task->tileId(), *tileData);
-                    });
-                }
+TileLoad MBTilesDataSource::loadFromNext(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+
+    if (!co_await loadFrom(*next, _task)) { co_return false; }
+
+    // Store result from next source; it is expected that the DataSource `next` has called
+    //  _task->prana() to lock the Scene if this is not run on the main thread
+    if (_task->hasData()) {
+
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        std::shared_ptr<std::vector<char>> tileData = task.rawTileData;
+        auto& zin = *task.rawTileData;
+        if (zin.size() > 10 && zin[0] == 0x1F && (unsigned char)zin[1] == 0x8B) {
+            auto pzout = pooledBuffer();
+            if (zlib_inflate(zin.data(), zin.size(), *pzout) == 0) {
+                task.rawTileData = pzout;
+                task.compressedTileData = tileData;
+                // rawTileData now points to uncompressed data for building tile, while tileData points
+                //  to compressed data received from server to be stored in DB
+                allowGzipTiles();
             }
+        }
 
-            _cb.func(_task);
+        if (m_cacheMode) {
+            // offline tiles are not lost if the commit fails (e.g. due to locked DB), since pending
+            //  tiles are kept until stored
+            storeTileData(task.tileId(), tileData, task.offlineId);
+        }
 
-        } else if (m_offlineMode) {
-            LOGD("try fallback tile: %s, %d", _task->tileId().toString().c_str());
+        _cb.func(_task);
 
-            m_worker->enqueue([this, _task, _cb](){
+    } else if (m_offlineMode) {
+        LOGD("try fallback tile: %s, %d", _task->tileId().toString().c_str());
 
-                if (_task->isCanceled()) { return; }
+        enqueueRead(_task, [this, _task, _cb](MBTilesQueries& _queries){
 
-                auto prana = _task->prana();  // lock Scene when running callback on thread
-                if (!prana) { return; }
+            if (_task->isCanceled()) { return; }
 
-                auto& task = static_cast<BinaryTileTask&>(*_task);
-                task.rawTileData = std::make_shared<std::vector<char>>();
+            auto prana = _task->prana();  // lock Scene when running callback on thread
+            if (!prana) { return; }
 
-                int64_t tileAge = 0;
-                getTileData(_task->tileId(), *task.rawTileData, tileAge, task.offlineId);
+            auto& task = static_cast<BinaryTileTask&>(*_task);
+            task.rawTileData = pooledBuffer();
 
-                LOGV("loaded tile: %s, %d", _task->tileId().toString().c_str(), task.rawTileData->size());
+            int64_t tileAge = 0;
+            getTileData(_queries, _task->tileId(), *task.rawTileData, tileAge, task.offlineId);
 
-                _cb.func(_task);
+            LOGV("loaded tile: %s, %d", _task->tileId().toString().c_str(), task.rawTileData->size());
 
-            });
-        } else {
-            LOGD("%s - missing tile: %s", m_name.c_str(), _task->tileId().toString().c_str());
             _cb.func(_task);
+
+        });
+    } else {
+        LOGD("%s - missing tile: %s", m_name.c_str(), _task->tileId().toString().c_str());
+        _cb.func(_task);
+    }
+    co_return true;
+}
+
+void MBTilesDataSource::revalidateTile(std::shared_ptr<TileTask> _task,
+                                       std::shared_ptr<std::vector<char>> _staleData) {
+
+    TileID tileId = _task->tileId();
+    TileID id(tileId.x, tileId.y, tileId.z);
+    double now = secSinceEpoch();
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        auto it = std::find_if(m_revalidating.begin(), m_revalidating.end(),
+                               [&](auto& entry) { return entry.first == id; });
+        if (it != m_revalidating.end() && now - it->second < MBTILES_REVALIDATE_TIMEOUT_SEC) { return; }
+        if (it != m_revalidating.end()) { m_revalidating.erase(it); }
+        m_revalidating.emplace_back(id, now);
+    }
+    LOGV("%s - revalidating tile: %s", m_name.c_str(), tileId.toString().c_str());
+
+    auto done = [this, id]() {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        auto it = std::find_if(m_revalidating.begin(), m_revalidating.end(),
+                               [&](auto& entry) { return entry.first == id; });
+        if (it != m_revalidating.end()) { m_revalidating.erase(it); }
+    };
+
+    // the stale tile is built from _task; this one is loaded after visible tiles
+    auto task = std::make_shared<BinaryTileTask>(tileId, _task->source());
+    task->setScenePrana(_task->prana());
+    task->setPrefetchState(true);
+    task->setPriority(_task->getPriority());
+    task->rawSource = next->level;
+
+    // received data is stored by loadNextSource(), renewing the tile's creation time
+    TileTaskCb cb{[this, _staleData, done](std::shared_ptr<TileTask> _task) {
+        done();
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        if (!task.hasData() || *task.rawTileData == *_staleData) {
+            LOGV("%s - unchanged tile: %s", m_name.c_str(), task.tileId().toString().c_str());
+            return;
         }
+        auto prana = _task->prana();  // TileSource is owned by the Scene
+        if (!prana || !_task->source()) { return; }
+
+        LOGV("%s - changed tile: %s", m_name.c_str(), task.tileId().toString().c_str());
+        _task->source()->invalidateTile(task.tileId());
+        m_platform.requestRender();
     }};
 
-    return next->loadTileData(_task, cb);
+    if (!loadNextSource(task, cb)) { done(); }
 }
 
 // when schema is modified, user_version should be incremented here and in SCHEMA block
@@ -356,11 +477,48 @@ void MBTilesDataSource::openMBTiles() {
     // schema updates
     if (m_cacheMode) {
         runMigrations(db);
+        // readers do not block the writer and see committed tiles; NORMAL syncs only on checkpoints,
+        //  so an app killed without clean exit keeps all committed tiles
+        db.exec("PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;");
     }
 
     m_queries = m_cacheMode ? std::make_unique<MBTilesQueries>(db.db, MBTilesQueries::tag_cache{})
         : std::make_unique<MBTilesQueries>(db.db);
     m_db = std::make_unique<SQLiteDB>(std::move(db));
+
+    // read connections: each one is only used by its serial queue, so no SQLite mutex is needed
+    int numReaders = std::min(MBTILES_MAX_READERS, std::max(1, int(std::thread::hardware_concurrency())));
+    for (int i = 0; i < numReaders; i++) {
+        auto reader = std::make_unique<Reader>();
+        if (sqlite3_open_v2(path.c_str(), &reader->db.db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, vfs) != SQLITE_OK) {
+            LOGW("Unable to open read connection to SQLite database: %s - %s", m_path.c_str(), reader->db.errMsg());
+            break;
+        }
+        // WAL checkpoints may briefly lock the database
+        sqlite3_busy_timeout(reader->db.db, 100);
+        reader->db.exec("PRAGMA mmap_size=" + std::to_string(MBTILES_MMAP_SIZE) + ";");
+        reader->queries = m_cacheMode ? std::make_unique<MBTilesQueries>(reader->db.db, MBTilesQueries::tag_cache_read{})
+            : std::make_unique<MBTilesQueries>(reader->db.db);
+        reader->worker = std::make_unique<IOQueue>();
+        m_readers.push_back(std::move(reader));
+    }
+}
+
+void MBTilesDataSource::enqueueRead(std::shared_ptr<TileTask> _task, std::function<void(MBTilesQueries&)> _read) {
+
+    if (m_readers.empty()) {
+        m_worker->enqueue(std::move(_task), [this, _read](){ _read(*m_queries); });
+        return;
+    }
+
+    auto it = std::min_element(m_readers.begin(), m_readers.end(), [](auto& a, auto& b) {
+        return a->pending < b->pending;
+    });
+    Reader* reader = it->get();
+    auto pending = std::make_shared<Reader::Pending>(*reader);
+    reader->worker->enqueue(std::move(_task), [reader, pending, _read](){
+        _read(*reader->queries);
+    });
 }
 
 /**
@@ -402,6 +560,10 @@ bool MBTilesDataSource::testSchema(SQLiteDB& db) {
             m_schemaOptions.compression = Compression::identity;
         } else if (cmpr == "deflate" || cmpr == "gzip") {
             m_schemaOptions.compression = Compression::deflate;
+        } else if (cmpr == "zstd" && hasDecompressor(Codec::zstd)) {
+            m_schemaOptions.compression = Compression::zstd;
+        } else if ((cmpr == "br" || cmpr == "brotli") && hasDecompressor(Codec::brotli)) {
+            m_schemaOptions.compression = Compression::brotli;
         } else {
             LOGE("Unsupported MBTiles tile compression: %s", cmpr.c_str());
             m_schemaOptions.compression = Compression::unsupported;
@@ -436,8 +598,38 @@ void MBTilesDataSource::initSchema(SQLiteDB& db, std::string _name, std::string
     stmt.bind("compression", "identity").exec();
 }
 
-bool MBTilesDataSource::getTileData(const TileID& _tileId,
-                                    std::vector<char>& _data, int64_t& _tileAge, int offlineId) {
+void MBTilesDataSource::decodeTileData(const char* _blob, size_t _length, std::vector<char>& _data,
+                                       std::vector<char>* _compressed) const {
+
+    if ((m_schemaOptions.compression == Compression::undefined) ||
+        (m_schemaOptions.compression == Compression::deflate)) {
+
+        if (zlib_inflate(_blob, _length, _data) != 0) {
+            if (m_schemaOptions.compression == Compression::undefined) {
+                _data.resize(_length);
+                memcpy(_data.data(), _blob, _length);
+            } else {
+                LOGW("Invalid deflate compression");
+            }
+        } else if (_compressed) {
+            _compressed->assign(_blob, _blob + _length);
+        }
+    } else if ((m_schemaOptions.compression == Compression::zstd) ||
+               (m_schemaOptions.compression == Compression::brotli)) {
+
+        // not kept in _compressed, which holds zlib data only
+        Codec codec = m_schemaOptions.compression == Compression::zstd ? Codec::zstd : Codec::brotli;
+        if (decompress(codec, _blob, _length, _data) != 0) {
+            LOGW("Invalid %s compression", codec == Codec::zstd ? "zstd" : "brotli");
+        }
+    } else {
+        _data.resize(_length);
+        memcpy(_data.data(), _blob, _length);
+    }
+}
+
+bool MBTilesDataSource::getTileData(MBTilesQueries& _queries, const TileID& _tileId, std::vector<char>& _data,
+                                    int64_t& _tileAge, int offlineId, std::vector<char>* _compressed) {
 
     if (offlineId && !m_cacheMode) {
         LOGE("Offline tiles cannot be created: database is read-only!");
@@ -447,8 +639,31 @@ bool MBTilesDataSource::getTileData(const TileID& _tileId,
     int z = _tileId.z;
     int y = (1 << z) - 1 - _tileId.y;
 
+    // tiles not committed yet
+    std::shared_ptr<std::vector<char>> pending;
+    if (m_cacheMode) {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        auto it = std::find_if(m_pending.begin(), m_pending.end(), [&](auto& tile) {
+            return tile.tileId.x == _tileId.x && tile.tileId.y == _tileId.y && tile.tileId.z == _tileId.z;
+        });
+        if (it != m_pending.end()) {
+            if (offlineId) { it->offlineId = offlineId; }  // written with the tile
+            pending = it->data;
+        }
+    }
+    if (pending) {
+        if (offlineId > 0) {
+            _data.push_back('\0');
+        } else {
+            decodeTileData(pending->data(), pending->size(), _data, _compressed);
+        }
+        _tileAge = int64_t(secSinceEpoch());
+        return true;
+    }
+
     // offlineId > 0 indicates request to set offline_id; not necessary to read data
     if (offlineId > 0) {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
         return m_queries->getOffline.bind(z, _tileId.x, y).exec([&](int, const char* tileid){
             if (m_queries->putOffline.bind(tileid, std::abs(offlineId)).exec()) {
                 _data.push_back('\0');  // make TileTask::hasData() true if offline id written successfully
@@ -456,75 +671,456 @@ bool MBTilesDataSource::getTileData(const TileID& _tileId,
         });
     }
 
-    return m_queries->getTileData.bind(z, _tileId.x, y).exec([&](sqlite3_stmt* stmt){
+    return _queries.getTileData.bind(z, _tileId.x, y).exec([&](sqlite3_stmt* stmt){
         const char* blob = (const char*) sqlite3_column_blob(stmt, 0);
         const int length = sqlite3_column_bytes(stmt, 0);
         std::string tileid = m_cacheMode ? (const char*)sqlite3_column_text(stmt, 1) : "";
         _tileAge = m_cacheMode ? sqlite3_column_int64(stmt, 2) : 0;
 
-        if ((m_schemaOptions.compression == Compression::undefined) ||
-            (m_schemaOptions.compression == Compression::deflate)) {
+        decodeTileData(blob, length, _data, _compressed);
 
-            if (zlib_inflate(blob, length, _data) != 0) {
-                if (m_schemaOptions.compression == Compression::undefined) {
-                    _data.resize(length);
-                    memcpy(_data.data(), blob, length);
-                } else {
-                    LOGW("Invalid deflate compression");
-                }
-            }
-        } else {
-            _data.resize(length);
-            memcpy(_data.data(), blob, length);
-        }
         if (offlineId) {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
             if (!m_queries->putOffline.bind(tileid, std::abs(offlineId)).exec()) {
                 _data.clear();  // force retry if writing offline id fails
             }
         }
         if (m_cacheMode) {
-            m_queries->putLastAccess.bind(tileid).exec();
+            m_worker->enqueue([this, tileid](){
+                std::lock_guard<std::mutex> lock(m_writeMutex);
+                m_queries->putLastAccess.bind(tileid).exec();
+            });
         }
     });
 }
 
-bool MBTilesDataSource::storeTileData(const TileID& _tileId, const std::vector<char>& _data, int offlineId) {
-    int z = _tileId.z;
-    int y = (1 << z) - 1 - _tileId.y;
+void MBTilesDataSource::storeTileData(const TileID& _tileId, std::shared_ptr<std::vector<char>> _data,
+                                      int offlineId, StoredCallback _onStored) {
+    TileID id(_tileId.x, _tileId.y, _tileId.z);
+    bool commitNow = false, scheduleCommit = false, dropped = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        auto it = std::find_if(m_pending.begin(), m_pending.end(), [&](auto& tile) { return tile.tileId == id; });
+        if (it != m_pending.end()) {
+            m_pendingBytes -= it->data->size();
+            it->data = _data;
+            if (offlineId) { it->offlineId = offlineId; }
+            if (_onStored) { it->onStored.push_back(std::move(_onStored)); }
+        } else if (m_pendingBytes + _data->size() > MBTILES_MAX_PENDING_BYTES) {
+            dropped = true;
+        } else {
+            m_pending.push_back({id, _data, offlineId, {}});
+            if (_onStored) { m_pending.back().onStored.push_back(std::move(_onStored)); }
+        }
+        if (!dropped) { m_pendingBytes += _data->size(); }
+
+        if (m_pending.size() >= MBTILES_BATCH_TILES || m_pendingBytes >= MBTILES_BATCH_BYTES) {
+            commitNow = true;
+        } else if (!m_commitScheduled) {
+            scheduleCommit = m_commitScheduled = true;
+        }
+    }
+    if (dropped) {
+        LOGW("%s - dropped tile %s: too many tiles waiting to be stored", m_name.c_str(), id.toString().c_str());
+        if (_onStored) { _onStored(false); }
+    } else if (commitNow) {
+        m_worker->enqueue([this](){ commitTiles(); });
+    } else if (scheduleCommit) {
+        m_worker->enqueueDelayed([this](){ commitTiles(); }, std::chrono::milliseconds(MBTILES_BATCH_DELAY_MS));
+    }
+}
+
+void MBTilesDataSource::allowGzipTiles() {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (m_cacheMode && m_schemaOptions.compression != Compression::undefined) {
+        m_db->exec("REPLACE INTO metadata (name, value) VALUES ('compression', 'undefined');");
+        m_schemaOptions.compression = Compression::undefined;
+    }
+}
+
+bool MBTilesDataSource::markOfflineTile(const TileID& _tileId, int _offlineId) {
+    if (!isCache() || _offlineId <= 0) { return false; }
+    {
+        // a pending tile may still be dropped, so it is stored again with storeOfflineTile()
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        TileID id(_tileId.x, _tileId.y, _tileId.z);
+        if (std::any_of(m_pending.begin(), m_pending.end(), [&](auto& tile) { return tile.tileId == id; })) {
+            return false;
+        }
+    }
+    std::vector<char> data;
+    int64_t tileAge = 0;
+    return getTileData(*m_queries, _tileId, data, tileAge, _offlineId) && !data.empty();
+}
+
+void MBTilesDataSource::storeOfflineTile(const TileID& _tileId, std::shared_ptr<std::vector<char>> _data,
+                                         int _offlineId, StoredCallback _onStored) {
+    if (!isCache() || _offlineId <= 0) {
+        if (_onStored) { _onStored(false); }
+        return;
+    }
+    auto& data = *_data;
+    if (data.size() > 10 && data[0] == 0x1F && (unsigned char)data[1] == 0x8B) { allowGzipTiles(); }
+    storeTileData(_tileId, std::move(_data), _offlineId, std::move(_onStored));
+}
 
-    const char* data = _data.data();
-    size_t size = _data.size();
+bool MBTilesDataSource::flushTiles() {
+    return isCache() && commitTiles();
+}
 
-    /**
-     * We create an MD5 of the raw tile data. The MD5 functions as a hash
-     * between the map and images tables. With this, tiles with duplicate
-     * data will join to a single entry in the images table.
-     */
-    MD5 md5;
-    std::string md5id = md5(data, size);
+bool MBTilesDataSource::exportPMTiles(const std::string& _path, int _offlineId) {
 
-    do {
-        if (!m_db->exec("BEGIN;")) { break; }
-        if (!m_queries->putMap.bind(z, _tileId.x, y, md5id).exec()) { break; }
-        sqlite3_bind_text(m_queries->putImage.stmt, 1, md5id.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_blob(m_queries->putImage.stmt, 2, data, size, SQLITE_STATIC);
-        if (!m_queries->putImage.exec()) { break; }
+    if (!isCache() || !flushTiles()) { return false; }
 
-        if (offlineId) {
-            if (!m_queries->putOffline.bind(md5id, std::abs(offlineId)).exec()) { break; }
+    // separate connection, so that tiles can be stored meanwhile
+    SQLiteDB db;
+    if (sqlite3_open_v2(Url(m_path).path().c_str(), &db.db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                        NULL) != SQLITE_OK) {
+        LOGE("%s - cannot open database for export: %s", m_name.c_str(), db.errMsg());
+        return false;
+    }
+    sqlite3_busy_timeout(db.db, 1000);
+
+    struct Entry {
+        uint64_t tileId;
+        std::string hash;
+        int z;
+        uint32_t x, y;
+    };
+    std::vector<Entry> entries;
+
+    auto addEntry = [&](int z, int x, int row, std::string hash) {
+        if (z < 0 || z > 31 || x < 0 || row < 0 || x >= (1 << z) || row >= (1 << z)) { return; }
+        uint32_t y = (1u << z) - 1 - uint32_t(row);
+        entries.push_back({ pmtiles::zxy_to_tileid(uint8_t(z), uint32_t(x), y), std::move(hash), z, uint32_t(x), y });
+    };
+
+    // zoom range and bounds at max zoom of the tiles written
+    int minZoom = 32, maxZoom = -1;
+    uint32_t minX = UINT32_MAX, minY = UINT32_MAX, maxX = 0, maxY = 0;
+    uint64_t numTiles = 0;
+
+    auto addBounds = [&](int z, uint32_t x, uint32_t y) {
+        minZoom = std::min(minZoom, z);
+        if (z > maxZoom) {
+            maxZoom = z;
+            minX = minY = UINT32_MAX;
+            maxX = maxY = 0;
+        }
+        if (z == maxZoom) {
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+        }
+    };
+    // map rows sharing data with a tile of the region are included too
+    SQLiteStmt query = db.stmt(_offlineId > 0 ?
+        "SELECT map.zoom_level, map.tile_column, map.tile_row, map.tile_id FROM map JOIN offline_tiles"
+        " ON offline_tiles.tile_id = map.tile_id WHERE offline_tiles.offline_id = ?;" :
+        "SELECT zoom_level, tile_column, tile_row, tile_id FROM map;");
+    if (_offlineId > 0) { query.bind(_offlineId); }
+    bool read = query.exec([&](int z, int x, int row, std::string hash) { addEntry(z, x, row, std::move(hash)); });
+    if (!read || entries.empty()) {
+        LOGE("%s - no tiles to export: %s", m_name.c_str(), db.errMsg());
+        return false;
+    }
+    std::sort(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.tileId < b.tileId; });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](auto& a, auto& b) { return a.tileId == b.tileId; }),
+                  entries.end());
+
+    std::string format = getMetadata("format");
+    if (format.empty()) { format = m_mime; }
+    uint8_t tileType = pmtiles::TILETYPE_UNKNOWN;
+    if (format == "pbf" || format == "mvt") { tileType = pmtiles::TILETYPE_MVT; }
+    else if (format == "mlt") { tileType = pmtiles::TILETYPE_MLT; }
+    else if (format == "png") { tileType = pmtiles::TILETYPE_PNG; }
+    else if (format == "jpg" || format == "jpeg") { tileType = pmtiles::TILETYPE_JPEG; }
+    else if (format == "webp") { tileType = pmtiles::TILETYPE_WEBP; }
+    // images are stored as they are, other tiles gzipped
+    bool image = tileType == pmtiles::TILETYPE_PNG || tileType == pmtiles::TILETYPE_JPEG ||
+        tileType == pmtiles::TILETYPE_WEBP;
+
+    std::string tmpPath = _path + ".tmp";
+    std::ofstream file(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+
+    // header and root directory are written last into the first 16 KiB, where readers expect them
+    const uint64_t rootSize = 16384;
+    file.write(std::string(rootSize, '\0').data(), rootSize);
+
+    // tile data in order of tile IDs; tiles with the same data, as identified by its MD5, share
+    //  the first copy, and consecutive ones a single directory entry
+    std::vector<pmtiles::entryv3> directory;
+    std::unordered_map<std::string, std::pair<uint64_t, uint32_t>> stored;
+    uint64_t dataSize = 0;
+    std::vector<char> raw, compressed, encoded;
+    auto getImage = db.stmt("SELECT tile_data FROM images WHERE tile_id = ?;");
+
+    for (const auto& entry : entries) {
+        auto it = stored.find(entry.hash);
+        if (it == stored.end()) {
+            const char* blob = nullptr;
+            size_t length = 0;
+            raw.clear();
+            compressed.clear();
+            getImage.bind(entry.hash).exec([&](sqlite3_stmt* stmt) {
+                blob = (const char*)sqlite3_column_blob(stmt, 0);
+                length = sqlite3_column_bytes(stmt, 0);
+                decodeTileData(blob, length, raw, &compressed);
+            });
+            if (!blob) { continue; }
+
+            const std::vector<char>* data = &raw;
+            if (!image) {
+                if (compressed.size() > 10 && compressed[0] == 0x1F && (unsigned char)compressed[1] == 0x8B) {
+                    data = &compressed;
+                } else {
+                    gzip_deflate(raw.data(), raw.size(), encoded);
+                    data = &encoded;
+                }
+            }
+            file.write(data->data(), data->size());
+            it = stored.emplace(entry.hash, std::make_pair(dataSize, uint32_t(data->size()))).first;
+            dataSize += data->size();
+        }
+
+        if (!directory.empty() && directory.back().offset == it->second.first &&
+            directory.back().tile_id + directory.back().run_length == entry.tileId) {
+            directory.back().run_length++;
         } else {
-            if (!m_queries->putLastAccess.bind(md5id).exec()) { break; }
+            directory.emplace_back(entry.tileId, it->second.first, it->second.second, 1);
         }
+        addBounds(entry.z, entry.x, entry.y);
+        numTiles++;
+    }
+    if (numTiles == 0) {
+        LOGE("%s - no tile data to export: %s", m_name.c_str(), db.errMsg());
+        file.close();
+        std::remove(tmpPath.c_str());
+        return false;
+    }
 
-        if (!m_db->exec("COMMIT;")) { break; }
-        m_platform.notifyStorage(size, 0);
-        LOGD("%s - store tile: %s (%d bytes)", m_name.c_str(), _tileId.toString().c_str(), int(size));
-        return true;
-    } while (0);
+    // metadata of the cache as strings, e.g. name and format, without the ones describing the
+    //  database, like compression and the progress of offline downloads; members of the MBTiles
+    //  'json' row, like vector_layers, go into the root object as PMTiles readers expect
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    writer.StartObject();
+    db.stmt("SELECT name, value FROM metadata;").exec([&](std::string _name, std::string _value) {
+        if (_name == "compression" || _name.compare(0, 8, "offline_") == 0) { return; }
+        if (_name == "json") {
+            rapidjson::Document json;
+            json.Parse(_value.c_str());
+            if (!json.HasParseError() && json.IsObject()) {
+                for (auto& member : json.GetObject()) {
+                    writer.Key(member.name.GetString(), member.name.GetStringLength());
+                    member.value.Accept(writer);
+                }
+                return;
+            }
+            LOGW("%s - exporting invalid json metadata as string", m_name.c_str());
+        }
+        writer.Key(_name.c_str());
+        writer.String(_value.c_str());
+    });
+    writer.EndObject();
+    file.write(sb.GetString(), sb.GetSize());
+
+    auto identity = [](const std::string& _data, uint8_t) { return _data; };
+    std::string root, leaves;
+    int numLeaves;
+    std::tie(root, leaves, numLeaves) = pmtiles::make_root_leaves(identity, pmtiles::COMPRESSION_NONE, directory);
+    file.write(leaves.data(), leaves.size());
+
+    auto lon = [](uint32_t x, int z) { return x / double(1u << z) * 360.0 - 180.0; };
+    auto lat = [](uint32_t y, int z) {
+        return std::atan(std::sinh(M_PI * (1.0 - 2.0 * y / double(1u << z)))) * 180.0 / M_PI;
+    };
+
+    pmtiles::headerv3 header{};
+    header.root_dir_offset = 127;
+    header.root_dir_bytes = root.size();
+    header.tile_data_offset = rootSize;
+    header.tile_data_bytes = dataSize;
+    header.json_metadata_offset = rootSize + dataSize;
+    header.json_metadata_bytes = sb.GetSize();
+    header.leaf_dirs_offset = header.json_metadata_offset + header.json_metadata_bytes;
+    header.leaf_dirs_bytes = leaves.size();
+    header.addressed_tiles_count = numTiles;
+    header.tile_entries_count = directory.size();
+    header.tile_contents_count = stored.size();
+    header.clustered = true;
+    header.internal_compression = pmtiles::COMPRESSION_NONE;
+    header.tile_compression = image ? pmtiles::COMPRESSION_NONE : pmtiles::COMPRESSION_GZIP;
+    header.tile_type = tileType;
+    header.min_zoom = uint8_t(minZoom);
+    header.max_zoom = uint8_t(maxZoom);
+    header.min_lon_e7 = int32_t(lon(minX, maxZoom) * 1e7);
+    header.max_lon_e7 = int32_t(lon(maxX + 1, maxZoom) * 1e7);
+    header.min_lat_e7 = int32_t(lat(maxY + 1, maxZoom) * 1e7);
+    header.max_lat_e7 = int32_t(lat(minY, maxZoom) * 1e7);
+    header.center_zoom = uint8_t(minZoom);
+    header.center_lon_e7 = int32_t((int64_t(header.min_lon_e7) + header.max_lon_e7) / 2);
+    header.center_lat_e7 = int32_t((int64_t(header.min_lat_e7) + header.max_lat_e7) / 2);
+
+    file.seekp(0);
+    file.write(header.serialize().data(), 127);
+    file.write(root.data(), root.size());
+    file.close();
+
+    if (!file || root.size() > rootSize - 127) {
+        LOGE("%s - cannot write PMTiles archive: %s", m_name.c_str(), tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // rename does not replace existing files on all platforms
+    std::remove(_path.c_str());
+    if (std::rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    LOGD("%s - exported %d tiles (%d stored, %llu bytes) to %s", m_name.c_str(), int(numTiles),
+         int(stored.size()), (unsigned long long)dataSize, _path.c_str());
+    return true;
+}
+
+void MBTilesDataSource::readAvailability(TileAvailability& _availability) {
+
+    std::string minZoom = getMetadata("minzoom"), maxZoom = getMetadata("maxzoom");
+    if (!minZoom.empty() && !maxZoom.empty()) {
+        _availability.setZoomRange(std::atoi(minZoom.c_str()), std::atoi(maxZoom.c_str()));
+    }
+
+    // left, bottom, right, top
+    double w, s, e, n;
+    std::string bounds = getMetadata("bounds");
+    if (std::sscanf(bounds.c_str(), "%lf,%lf,%lf,%lf", &w, &s, &e, &n) == 4 && w < e && s < n) {
+        _availability.setBounds({ w, s }, { e, n });
+    }
+}
+
+std::string MBTilesDataSource::getMetadata(const std::string& _name) {
+    std::string value;
+    if (!m_db) { return value; }
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_db->stmt("SELECT value FROM metadata WHERE name = ?;").bind(_name).exec([&](std::string _value) {
+        value = std::move(_value);
+    });
+    return value;
+}
 
-    LOGE("%s - SQL error storing tile %s: %s", m_name.c_str(), _tileId.toString().c_str(), m_db->errMsg());
-    m_db->exec("ROLLBACK;");
-    return false;
+bool MBTilesDataSource::setMetadata(const std::string& _name, const std::string& _value) {
+    if (!isCache()) { return false; }
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return m_db->stmt("REPLACE INTO metadata (name, value) VALUES (?, ?);").bind(_name, _value).exec();
+}
+
+bool MBTilesDataSource::commitTiles() {
+
+    std::vector<PendingTile> batch;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        batch = m_pending;
+        m_commitScheduled = false;
+    }
+    if (batch.empty()) { return true; }
+
+    size_t bytes = 0, offlineBytes = 0;
+    auto write = [&]() {
+        if (!m_db->exec("BEGIN;")) { return false; }
+
+        // images written in this batch
+        std::unordered_set<std::string> written;
+
+        for (auto& tile : batch) {
+            int z = tile.tileId.z;
+            int y = (1 << z) - 1 - tile.tileId.y;
+
+            const char* data = tile.data->data();
+            size_t size = tile.data->size();
+
+            /**
+             * We create an MD5 of the raw tile data. The MD5 functions as a hash
+             * between the map and images tables. With this, tiles with duplicate
+             * data will join to a single entry in the images table.
+             */
+            MD5 md5;
+            std::string md5id = md5(data, size);
+
+            if (!m_queries->putMap.bind(z, tile.tileId.x, y, md5id).exec()) { return false; }
+
+            // data already stored, e.g. of sea or empty land tiles, is only renewed, not written again
+            if (written.insert(md5id).second) {
+                int changes = m_db->totalChanges();
+                if (!m_queries->touchImage.bind(md5id).exec()) { return false; }
+                if (m_db->totalChanges() == changes) {
+                    sqlite3_bind_text(m_queries->putImage.stmt, 1, md5id.c_str(), -1, SQLITE_STATIC);
+                    sqlite3_bind_blob(m_queries->putImage.stmt, 2, data, size, SQLITE_STATIC);
+                    if (!m_queries->putImage.exec()) { return false; }
+                    bytes += size;
+                }
+            }
+
+            if (tile.offlineId) {
+                if (!m_queries->putOffline.bind(md5id, std::abs(tile.offlineId)).exec()) { return false; }
+                offlineBytes += size;
+            } else {
+                if (!m_queries->putLastAccess.bind(md5id).exec()) { return false; }
+            }
+        }
+
+        return m_db->exec("COMMIT;");
+    };
+
+    bool stored;
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        stored = write();
+        if (!stored) {
+            LOGE("%s - SQL error storing %d tiles: %s", m_name.c_str(), int(batch.size()), m_db->errMsg());
+            m_db->exec("ROLLBACK;");
+        }
+    }
+
+    // acknowledged after the lock is released, as callbacks may store tiles again
+    std::vector<StoredCallback> acknowledged;
+    bool dropped = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        if (!stored && ++m_commitFailures < MBTILES_MAX_COMMIT_FAILURES) {
+            // e.g. database locked: keep tiles pending, so that they stay readable, and retry later
+            if (!m_commitScheduled) {
+                m_commitScheduled = true;
+                m_worker->enqueueDelayed([this](){ commitTiles(); }, std::chrono::milliseconds(MBTILES_BATCH_DELAY_MS));
+            }
+            return false;
+        }
+        // the batch is dropped when commits keep failing, so that pending tiles do not grow without bound
+        dropped = !stored;
+        m_commitFailures = 0;
+
+        // tiles replaced or assigned an offline id meanwhile stay pending
+        for (auto& tile : batch) {
+            auto it = std::find_if(m_pending.begin(), m_pending.end(), [&](auto& pending) {
+                return pending.tileId == tile.tileId && pending.data == tile.data && pending.offlineId == tile.offlineId;
+            });
+            if (it == m_pending.end()) { continue; }
+            m_pendingBytes -= it->data->size();
+            std::move(it->onStored.begin(), it->onStored.end(), std::back_inserter(acknowledged));
+            m_pending.erase(it);
+        }
+    }
+    for (auto& onStored : acknowledged) { onStored(stored); }
+
+    if (dropped) {
+        LOGE("%s - dropped %d tiles after %d failed commits", m_name.c_str(), int(batch.size()),
+             MBTILES_MAX_COMMIT_FAILURES);
+        return false;
+    }
+    m_platform.notifyStorage(bytes, offlineBytes);
+    LOGD("%s - stored %d tiles (%d bytes)", m_name.c_str(), int(batch.size()), int(bytes));
+    return true;
 }
 
 }
@@ -2,6 +2,9 @@
 
 #include "data/tileSource.h"
 
+#include <functional>
+#include <mutex>
+
 struct sqlite3;
 class SQLiteDB;
 
@@ -10,7 +13,9 @@ namespace Tangram {
 class Platform;
 
 struct MBTilesQueries;
-class AsyncWorker;
+class IOQueue;
+class TileLoad;
+class TileAvailability;
 
 class MBTilesDataSource : public TileSource::DataSource {
 public:
@@ -26,10 +31,67 @@ public:
 
     SQLiteDB* getDB() { return m_db.get(); }
 
+    /* Offline downloads, for cache databases only (see OfflineDownloader) */
+
+    bool isCache() const { return m_db && m_cacheMode; }
+
+    /* Serve expired tiles of the cache at once and revalidate them with the next source in the
+     * background; tiles are only built again if the data received differs from the stale data */
+    void setStaleWhileRevalidate(bool _revalidate) { m_staleWhileRevalidate = _revalidate; }
+
+    // Called with true once a stored tile is committed, or with false if it was dropped
+    using StoredCallback = std::function<void(bool _stored)>;
+
+    // Returns true if the tile is committed, assigning it to offline region @_offlineId
+    bool markOfflineTile(const TileID& _tileId, int _offlineId);
+
+    // Store tile of offline region @_offlineId; tiles are committed in batches
+    void storeOfflineTile(const TileID& _tileId, std::shared_ptr<std::vector<char>> _data, int _offlineId,
+                          StoredCallback _onStored = {});
+
+    // Commit pending tiles now; returns false if they could not be stored
+    bool flushTiles();
+
+    // Write the tiles of offline region @_offlineId, or all tiles if 0, to a clustered PMTiles
+    //  archive at @_path, which PMTilesDataSource can read in place; tiles are ordered along
+    //  the Hilbert curve of PMTiles tile IDs and identical tiles are stored once. Runs on the
+    //  calling thread; returns false if the archive could not be written
+    bool exportPMTiles(const std::string& _path, int _offlineId = 0);
+
+    // Value from metadata table, empty if not set
+    std::string getMetadata(const std::string& _name);
+    bool setMetadata(const std::string& _name, const std::string& _value);
+
 private:
-    bool getTileData(const TileID& _tileId, std::vector<char>& _data, int64_t& _tileAge, int offlineId);
-    bool storeTileData(const TileID& _tileId, const std::vector<char>& _data, int offlineId = 0);
+    struct Reader;
+
+    // @_queries: of read connection; @_compressed: set to the stored data if it had to be inflated
+    bool getTileData(MBTilesQueries& _queries, const TileID& _tileId, std::vector<char>& _data,
+                     int64_t& _tileAge, int offlineId, std::vector<char>* _compressed = nullptr);
+    // inflate tile data as stored according to compression of the database
+    void decodeTileData(const char* _blob, size_t _length, std::vector<char>& _data,
+                        std::vector<char>* _compressed) const;
+
+    // add tile to pending tiles, committed in batches by commitTiles()
+    void storeTileData(const TileID& _tileId, std::shared_ptr<std::vector<char>> _data, int offlineId = 0,
+                       StoredCallback _onStored = {});
+    // returns false if the pending tiles could not be stored
+    bool commitTiles();
+    // tiles stored as received may be gzipped, so compression has to be detected per tile
+    void allowGzipTiles();
     bool loadNextSource(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
+    // load from the next source and store its data on the way back
+    TileLoad loadFromNext(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
+    // request tile of @_task, served from @_staleData, from next source with low priority and
+    //  invalidate the tile of its TileSource if the data changed
+    void revalidateTile(std::shared_ptr<TileTask> _task, std::shared_ptr<std::vector<char>> _staleData);
+
+    // run @_read for @_task on the least busy read connection, or on m_worker if there is none;
+    //  dropped if @_task is canceled before it runs
+    void enqueueRead(std::shared_ptr<TileTask> _task, std::function<void(MBTilesQueries&)> _read);
+
+    // Set the zoom range and bounds of the metadata of a tile set that is not a cache
+    void readAvailability(TileAvailability& _availability);
 
     void openMBTiles();
     bool testSchema(SQLiteDB& db);
@@ -44,14 +106,42 @@ private:
     // Store tiles from next source
     bool m_cacheMode;
     int64_t m_maxCacheAge;
+    bool m_staleWhileRevalidate = false;
 
     // Offline fallback: Try next source (download) first, then fall back to mbtiles
     bool m_offlineMode;
 
-    // Pointer to SQLite DB of MBTiles store
+    // Metadata was passed to the availability of the TileSource, see readAvailability()
+    std::atomic<bool> m_availabilityRead{false};
+
+    // Pointer to SQLite DB of MBTiles store, used for writes
     std::unique_ptr<SQLiteDB> m_db;
     std::unique_ptr<MBTilesQueries> m_queries;
-    std::unique_ptr<AsyncWorker> m_worker;
+    std::unique_ptr<IOQueue> m_worker;
+
+    // Serializes use of m_db and m_queries, e.g. to keep transactions of storeTileData() atomic
+    std::mutex m_writeMutex;
+
+    // Tiles from next source not yet committed to m_db; read by getTileData() like stored tiles
+    struct PendingTile {
+        TileID tileId;  // s = z
+        std::shared_ptr<std::vector<char>> data;
+        int offlineId;
+        // of every store of the tile since its last commit
+        std::vector<StoredCallback> onStored;
+    };
+    std::mutex m_pendingMutex;
+    std::vector<PendingTile> m_pending;
+    size_t m_pendingBytes = 0;
+    bool m_commitScheduled = false;
+    // commits that failed in a row, e.g. while the database is locked
+    int m_commitFailures = 0;
+    // Tiles being revalidated (s = z) and the time the request was started, guarded by
+    //  m_pendingMutex; the next source may drop a request without calling back, so entries expire
+    std::vector<std::pair<TileID, double>> m_revalidating;
+
+    // Read-only connections for parallel tile reads; destroyed before m_worker, which their reads may use
+    std::vector<std::unique_ptr<Reader>> m_readers;
 
     // Platform reference
     Platform& m_platform;
@@ -60,6 +150,8 @@ private:
         undefined,
         identity,
         deflate,
+        zstd,
+        brotli,
         unsupported
     };
 
@@ -1,104 +1,273 @@
 #include "data/memoryCacheDataSource.h"
 
+#include "data/tileLoad.h"
+
 #include "tile/tileHash.h"
 #include "tile/tileID.h"
+#include "util/zlibHelper.h"
 #include "log.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <list>
 #include <mutex>
+#include <string_view>
 #include <unordered_map>
 
+// Number of independently locked parts of RawCache
+#define RAW_CACHE_SHARDS 8
+// Number of content hashes of shared tile data kept before the ones of evicted tiles are dropped
+#define RAW_CACHE_SHARED_ENTRIES 4096
+
 namespace Tangram {
 
 struct RawCache {
 
-    // Used to ensure safe access from async loading threads
-    std::mutex m_mutex;
+    // LRU in-memory cache for raw tile data; each shard holds the tiles hashing to it, so that
+    // loading threads rarely wait for each other, while the cache size limits all shards together
+    struct Shard {
+
+        // Used to ensure safe access from async loading threads
+        std::mutex m_mutex;
+
+        // Entry data is deflated when 'compressed' is set
+        struct Entry {
+            TileID id;
+            std::shared_ptr<std::vector<char>> data;
+            bool compressed;
+        };
+        using CacheList = std::list<Entry>;
+        using CacheMap = std::unordered_map<TileID, typename CacheList::iterator>;
+
+        CacheMap m_cacheMap;
+        CacheList m_cacheList;
+        size_t m_usage = 0;
+
+        // evict least recently used entries while @_total exceeds _bytes, keeping the
+        // @_keep most recently used ones; m_mutex must be locked
+        void evict(std::atomic<size_t>& _total, size_t _bytes, size_t _keep = 0) {
+            while (_total > _bytes && m_cacheList.size() > _keep) {
+                _total -= erase(std::prev(m_cacheList.end()));
+            }
+        }
+
+        // returns the bytes freed
+        size_t erase(typename CacheList::iterator _it) {
+            size_t size = _it->data->size();
+            m_usage -= size;
+            m_cacheMap.erase(_it->id);
+            m_cacheList.erase(_it);
+            return size;
+        }
+    };
+
+    std::array<Shard, RAW_CACHE_SHARDS> m_shards;
+
+    // Data of cached tiles by content hash, so that identical tiles (e.g. of sea or empty land)
+    // share one buffer; entries are counted in full by each shard holding them
+    std::mutex m_sharedMutex;
+    std::unordered_map<size_t, std::weak_ptr<std::vector<char>>> m_shared;
 
-    // LRU in-memory cache for raw tile data
-    using CacheEntry = std::pair<TileID, std::shared_ptr<std::vector<char>>>;
-    using CacheList = std::list<CacheEntry>;
-    using CacheMap = std::unordered_map<TileID, typename CacheList::iterator>;
+    // size of the cache and bytes used by all shards
+    std::atomic<size_t> m_maxUsage{0};
+    std::atomic<size_t> m_usage{0};
 
-    CacheMap m_cacheMap;
-    CacheList m_cacheList;
-    int m_usage = 0;
-    int m_maxUsage = 0;
+    bool m_compress = false;
+
+    Shard& shard(const TileID& _id) {
+        return m_shards[std::hash<TileID>()(_id) % RAW_CACHE_SHARDS];
+    }
 
     bool get(BinaryTileTask& _task) {
 
-        if (m_maxUsage <= 0) { return false; }
+        if (m_maxUsage == 0) { return false; }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
         const auto& taskTileID = _task.tileId();
         TileID id(taskTileID.x, taskTileID.y, taskTileID.z);
+        auto& s = shard(id);
 
-        auto it = m_cacheMap.find(id);
-        if (it != m_cacheMap.end()) {
-            // Move cached entry to start of list
-            m_cacheList.splice(m_cacheList.begin(), m_cacheList, it->second);
-            _task.rawTileData = m_cacheList.front().second;
+        std::shared_ptr<std::vector<char>> data;
+        bool compressed = false;
+        {
+            std::lock_guard<std::mutex> lock(s.m_mutex);
+            auto it = s.m_cacheMap.find(id);
+            if (it == s.m_cacheMap.end()) { return false; }
 
-            return true;
+            // Move cached entry to start of list
+            s.m_cacheList.splice(s.m_cacheList.begin(), s.m_cacheList, it->second);
+            data = s.m_cacheList.front().data;
+            compressed = s.m_cacheList.front().compressed;
         }
 
-        return false;
+        if (compressed) {
+            // inflate without holding the lock; entries are immutable
+            auto inflated = pooledBuffer();
+            if (zlib_inflate(data->data(), data->size(), *inflated) != 0) {
+                LOGE("Invalid compressed cache entry for tile %s", id.toString().c_str());
+                return false;
+            }
+            data = std::move(inflated);
+        }
+        _task.rawTileData = std::move(data);
+        return true;
     }
-    void put(const TileID& tileID, std::shared_ptr<std::vector<char>> rawDataRef) {
 
-        if (m_maxUsage <= 0) { return; }
+    // @wireDataRef: compressed form of rawDataRef as received, if any
+    void put(const TileID& tileID, std::shared_ptr<std::vector<char>> rawDataRef,
+             std::shared_ptr<std::vector<char>> wireDataRef) {
+
+        size_t maxUsage = m_maxUsage;
+        if (maxUsage == 0) { return; }
 
-        std::lock_guard<std::mutex> lock(m_mutex);
         TileID id(tileID.x, tileID.y, tileID.z);
+        bool compressed = false;
+
+        if (m_compress && wireDataRef && !wireDataRef->empty()) {
+            rawDataRef = std::move(wireDataRef);
+            compressed = true;
+        } else if (m_compress) {
+            auto deflated = std::make_shared<std::vector<char>>();
+            if (zlib_deflate(rawDataRef->data(), rawDataRef->size(), *deflated) == 0 &&
+                deflated->size() < rawDataRef->size()) {
+                deflated->shrink_to_fit();
+                rawDataRef = std::move(deflated);
+                compressed = true;
+            }
+        }
 
-        m_cacheList.push_front({id, rawDataRef});
-        m_cacheMap[id] = m_cacheList.begin();
+        // a tile larger than the whole cache would only evict everything else
+        if (rawDataRef->size() > maxUsage) { return; }
 
-        m_usage += rawDataRef->size();
+        rawDataRef = share(std::move(rawDataRef));
 
-        while (m_usage > m_maxUsage) {
-            if (m_cacheList.empty()) {
-                LOGE("Error: invalid cache state!");
-                m_usage = 0;
-                break;
-            }
+        auto& s = shard(id);
+        {
+            std::lock_guard<std::mutex> lock(s.m_mutex);
+
+            auto it = s.m_cacheMap.find(id);
+            if (it != s.m_cacheMap.end()) { m_usage -= s.erase(it->second); }
+
+            s.m_cacheList.push_front({id, rawDataRef, compressed});
+            s.m_cacheMap[id] = s.m_cacheList.begin();
+
+            s.m_usage += rawDataRef->size();
+            m_usage += rawDataRef->size();
+
+            s.evict(m_usage, maxUsage, 1);
+        }
+
+        // make room in the other shards, locking one at a time
+        size_t first = size_t(&s - m_shards.data());
+        for (size_t i = 1; i < RAW_CACHE_SHARDS && m_usage > maxUsage; i++) {
+            auto& other = m_shards[(first + i) % RAW_CACHE_SHARDS];
+            std::lock_guard<std::mutex> lock(other.m_mutex);
+            other.evict(m_usage, maxUsage);
+        }
+    }
+
+    // cached buffer with the same content as @_data, or @_data
+    std::shared_ptr<std::vector<char>> share(std::shared_ptr<std::vector<char>> _data) {
+        size_t hash = std::hash<std::string_view>()(std::string_view(_data->data(), _data->size()));
+
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        auto& entry = m_shared[hash];
+        if (auto shared = entry.lock()) {
+            if (*shared == *_data) { return shared; }
+        }
+        entry = _data;
 
-            // LOGE("Limit raw cache tiles:%d, %fMB ", m_cacheList.size(),
-            //        double(m_cacheUsage) / (1024*1024));
+        // drop entries of evicted tiles
+        if (m_shared.size() > RAW_CACHE_SHARED_ENTRIES) {
+            for (auto it = m_shared.begin(); it != m_shared.end();) {
+                if (it->second.expired()) { it = m_shared.erase(it); } else { ++it; }
+            }
+        }
+        return _data;
+    }
 
-            auto& entry = m_cacheList.back();
-            m_usage -= entry.second->size();
+    void setMaxUsage(size_t _bytes) {
+        m_maxUsage = _bytes;
+        trim(_bytes);
+    }
 
-            m_cacheMap.erase(entry.first);
-            m_cacheList.pop_back();
+    // evict until the cache uses at most _bytes, taking from each shard in proportion to its usage
+    void trim(size_t _bytes) {
+        size_t total = m_usage;
+        if (total <= _bytes) { return; }
+        double keep = double(_bytes) / total;
+        for (auto& s : m_shards) {
+            std::lock_guard<std::mutex> lock(s.m_mutex);
+            size_t target = size_t(s.m_usage * keep);
+            while (s.m_usage > target) {
+                m_usage -= s.erase(std::prev(s.m_cacheList.end()));
+            }
         }
     }
 
+    size_t usage() { return m_usage; }
+
+    void erase(const TileID& _id) {
+        TileID id(_id.x, _id.y, _id.z);
+        auto& s = shard(id);
+        std::lock_guard<std::mutex> lock(s.m_mutex);
+
+        auto it = s.m_cacheMap.find(id);
+        if (it != s.m_cacheMap.end()) { m_usage -= s.erase(it->second); }
+    }
+
     void clear() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_cacheMap.clear();
-        m_cacheList.clear();
-        m_usage = 0;
+        for (auto& s : m_shards) {
+            std::lock_guard<std::mutex> lock(s.m_mutex);
+            s.m_cacheMap.clear();
+            s.m_cacheList.clear();
+            m_usage -= s.m_usage;
+            s.m_usage = 0;
+        }
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        m_shared.clear();
     }
 };
 
 
-MemoryCacheDataSource::MemoryCacheDataSource() :
-    m_cache(std::make_unique<RawCache>()) {
+MemoryCacheDataSource::MemoryCacheDataSource(bool _compress) :
+    m_cache(createCache(_compress)) {}
+
+MemoryCacheDataSource::MemoryCacheDataSource(std::shared_ptr<RawCache> _cache) :
+    m_cache(std::move(_cache)) {}
+
+std::shared_ptr<RawCache> MemoryCacheDataSource::createCache(bool _compress) {
+    auto cache = std::make_shared<RawCache>();
+    cache->m_compress = _compress;
+    return cache;
 }
 
 MemoryCacheDataSource::~MemoryCacheDataSource() {}
 
 void MemoryCacheDataSource::setCacheSize(size_t _cacheSize) {
-    m_cache->m_maxUsage = _cacheSize;
+    m_cache->setMaxUsage(_cacheSize);
+}
+
+size_t MemoryCacheDataSource::cacheSize() const {
+    return m_cache->m_maxUsage;
+}
+
+size_t MemoryCacheDataSource::cacheUsage() const {
+    return m_cache->usage() + (next ? next->cacheUsage() : 0);
+}
+
+void MemoryCacheDataSource::trimCache(size_t _bytes) {
+    m_cache->trim(_bytes);
+
+    if (next) { next->trimCache(_bytes); }
 }
 
 bool MemoryCacheDataSource::cacheGet(BinaryTileTask& _task) {
     return m_cache->get(_task);
 }
 
-void MemoryCacheDataSource::cachePut(const TileID& _tileID, std::shared_ptr<std::vector<char>> _rawDataRef) {
-    m_cache->put(_tileID, _rawDataRef);
+void MemoryCacheDataSource::cachePut(const BinaryTileTask& _task) {
+    m_cache->put(_task.tileId(), _task.rawTileData, _task.compressedTileData);
 }
 
 bool MemoryCacheDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
@@ -118,19 +287,23 @@ bool MemoryCacheDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTa
         if (next) { _task->rawSource = next->level; }
     }
 
-    if (next) {
+    if (next) { return loadFromNext(std::move(_task), std::move(_cb)).started(); }
+
+    return false;
+}
 
-        return next->loadTileData(_task, {[this, _cb](std::shared_ptr<TileTask> _task) {
+TileLoad MemoryCacheDataSource::loadFromNext(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 
-            auto& task = static_cast<BinaryTileTask&>(*_task);
+    if (!co_await loadFrom(*next, _task)) { co_return false; }
 
-            if (task.hasData()) { cachePut(task.tileId(), task.rawTileData); }
+    auto& task = static_cast<BinaryTileTask&>(*_task);
 
-            _cb.func(_task);
-        }});
+    if (task.rawTileData && !task.rawTileData->empty()) {
+        cachePut(task);
     }
 
-    return false;
+    _cb.func(_task);
+    co_return true;
 }
 
 void MemoryCacheDataSource::clear() {
@@ -139,4 +312,10 @@ void MemoryCacheDataSource::clear() {
     if (next) { next->clear(); }
 }
 
+void MemoryCacheDataSource::clearTile(const TileID& _tileId) {
+    m_cache->erase(_tileId);
+
+    if (next) { next->clearTile(_tileId); }
+}
+
 }
@@ -4,27 +4,49 @@
 
 namespace Tangram {
 
+class TileLoad;
+
 class MemoryCacheDataSource : public TileSource::DataSource {
 public:
 
-    MemoryCacheDataSource();
+    /* @_compress: keep tile data deflated, so that the cache size holds more tiles at the cost
+     * of compressing on store and inflating on each cache hit */
+    explicit MemoryCacheDataSource(bool _compress = false);
+
+    /* Use @_cache, e.g. shared with the sources of other Maps loading the same url; see
+     * MapContext. The cache size is then set by all sources using it. */
+    explicit MemoryCacheDataSource(std::shared_ptr<RawCache> _cache);
+
     ~MemoryCacheDataSource();
 
+    static std::shared_ptr<RawCache> createCache(bool _compress);
+
     bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
 
     void clear() override;
 
+    void clearTile(const TileID& _tileId) override;
+
     /* @_cacheSize: Set size of in-memory cache for tile data in bytes.
      * This cache holds unprocessed tile data for fast recreation of recently used tiles.
      */
-    void setCacheSize(size_t _cacheSize);
+    void setCacheSize(size_t _cacheSize) override;
+
+    size_t cacheSize() const override;
+
+    size_t cacheUsage() const override;
+
+    void trimCache(size_t _bytes) override;
 
 private:
+    // Load from the next source and cache its data on the way back
+    TileLoad loadFromNext(std::shared_ptr<TileTask> _task, TileTaskCb _cb);
+
     bool cacheGet(BinaryTileTask& _task);
 
-    void cachePut(const TileID& _tileID, std::shared_ptr<std::vector<char>> _rawDataRef);
+    void cachePut(const BinaryTileTask& _task);
 
-    std::unique_ptr<RawCache> m_cache;
+    std::shared_ptr<RawCache> m_cache;
 
 };
 
@@ -1,14 +1,30 @@
 #include "data/networkDataSource.h"
 
+#include "data/requestLimiter.h"
 #include "log.h"
 #include "platform.h"
 #include "util/mapProjection.h"
 #include "util/util.h"
+#include "util/zlibHelper.h"
 #include "scene/scene.h"
+#include "tile/tileAvailability.h"
 #include "js/JavaScript.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Tangram {
 
+// Visible tiles first, then proxies, then prefetched tiles; each ordered by distance to the view
+// center (TileTask::getPriority()). Weights are rounded so that small moves of the view do not
+// update running requests.
+static void setRequestPriority(const TileTask& _task, HttpOptions& _options) {
+    _options.priority = _task.isPrefetch() ? HttpOptions::Priority::low :
+        _task.isProxy() ? HttpOptions::Priority::normal : HttpOptions::Priority::high;
+    float weight = 1.f / (1.f + float(std::max(_task.getPriority(), 0.)));
+    _options.weight = std::round(weight * 32.f) / 32.f;
+}
+
 NetworkDataSource::NetworkDataSource(DataSourceContext& _context, std::string url, UrlOptions options) :
     m_context(_context),
     m_urlTemplate(std::move(url)),
@@ -21,6 +37,16 @@ NetworkDataSource::NetworkDataSource(DataSourceContext& _context, std::string ur
     m_options.httpOptions.addHeader("User-Agent", _context.getPlatform().defaultUserAgent);
 }
 
+NetworkDataSource::~NetworkDataSource() {
+    std::vector<std::shared_ptr<RequestLimiter>> limiters;
+    {
+        std::lock_guard<std::mutex> lock(m_limitersMutex);
+        limiters = m_limiters;
+    }
+    // waits for queued requests being started, which use this source
+    for (auto& limiter : limiters) { limiter->cancel(this); }
+}
+
 std::string NetworkDataSource::tileCoordinatesToQuadKey(const TileID &tile) {
     std::string quadKey;
     for (int i = tile.z; i > 0; i--) {
@@ -120,12 +146,38 @@ bool NetworkDataSource::loadTileData(std::shared_ptr<TileTask> task, TileTaskCb
         m_urlSubdomainIndex = (m_urlSubdomainIndex + 1) % m_options.subdomains.size();
     }
 
+    if (!url.hasHttpScheme()) { return startRequest(std::move(task), std::move(callback), url, nullptr); }
+
+    auto limiter = RequestLimiter::forHost(url.netLocation());
+    {
+        std::lock_guard<std::mutex> lock(m_limitersMutex);
+        if (std::find(m_limiters.begin(), m_limiters.end(), limiter) == m_limiters.end()) {
+            m_limiters.push_back(limiter);
+        }
+    }
+
+    limiter->request(this, task, [this, task, callback, url, limiter]() mutable {
+        if (task->isCanceled()) { return false; }
+        // keep Scene alive while starting a queued request
+        auto prana = task->prana();
+        if (!prana) { return false; }
+        return startRequest(std::move(task), std::move(callback), url, std::move(limiter));
+    });
+    return true;
+}
+
+bool NetworkDataSource::startRequest(std::shared_ptr<TileTask> task, TileTaskCb callback, const Url& url,
+                                     std::shared_ptr<RequestLimiter> limiter) {
+
     LOGTO(">>> Url request for %s %s",
           task->source() ? task->source()->name().c_str() : "?", task->tileId().toString().c_str());
-    UrlCallback onRequestFinish = [task, callback, url](UrlResponse&& response) mutable {
+    auto started = RequestLimiter::Clock::now();
+    UrlCallback onRequestFinish = [task, callback, url, limiter, started](UrlResponse&& response) mutable {
         LOGTO("<<< Url request for %s %s%s", task->source() ? task->source()->name().c_str() : "?",
               task->tileId().toString().c_str(), task->isCanceled() ? " (canceled)" : "");
 
+        if (limiter) { limiter->finish(started, response.content.size(), !response.error); }
+
         if (task->isCanceled()) { return; }
 
         auto prana = task->prana();  // lock Scene when running callback on thread
@@ -134,28 +186,59 @@ bool NetworkDataSource::loadTileData(std::shared_ptr<TileTask> task, TileTaskCb
             return;
         }
 
+        if (auto source = task->source()) { source->addBytesDownloaded(response.content.size()); }
+
         auto& dlTask = static_cast<BinaryTileTask&>(*task);
         dlTask.urlRequestHandle = 0;
 
+        // no data for the tile, nor for its descendants
+        if (response.status == 404 || response.status == 410 || response.status == 204) {
+            if (auto source = task->source()) { source->availability().setMissing(task->tileId()); }
+        }
+
         if (response.error) {
             LOGW("Error '%s' for URL %s", response.error, url.string().c_str());
         } else if (!response.content.empty()) {
-            dlTask.rawTileData = std::make_shared<std::vector<char>>(std::move(response.content));
+            dlTask.rawTileData = pooledBuffer(std::move(response.content));
         }
         callback.func(std::move(task));
     };
 
+    HttpOptions httpOptions = m_options.httpOptions;
+    setRequestPriority(*task, httpOptions);
+    // tiles may be served pre-compressed without Content-Encoding
+    httpOptions.inflateGzip = true;
+
     auto& dlTask = static_cast<BinaryTileTask&>(*task);
-    dlTask.urlRequestHandle = m_context.getPlatform().startUrlRequest(url, m_options.httpOptions,
-                                                                      std::move(onRequestFinish));
+    auto& platform = m_context.getPlatform();
+    dlTask.urlRequestHandle = platform.startUrlRequest(url, httpOptions, std::move(onRequestFinish));
+
+    // cancelLoadingTile() may have missed the request while it was being started
+    if (dlTask.isCanceled()) {
+        if (auto handle = dlTask.urlRequestHandle.exchange(0)) { platform.cancelUrlRequest(handle); }
+    }
     return true;
 }
 
+void NetworkDataSource::updateTaskPriority(TileTask& task) {
+    auto& dlTask = static_cast<BinaryTileTask&>(task);
+    if (!dlTask.urlRequestHandle) { return; }
+
+    HttpOptions httpOptions;
+    setRequestPriority(task, httpOptions);
+    m_context.getPlatform().updateUrlRequestPriority(dlTask.urlRequestHandle, httpOptions);
+}
+
 void NetworkDataSource::cancelLoadingTile(TileTask& task) {
     auto& dlTask = static_cast<BinaryTileTask&>(task);
-    if (dlTask.urlRequestHandle) {
-        // we expect callback to clear urlRequestHandle
-        m_context.getPlatform().cancelUrlRequest(dlTask.urlRequestHandle);
+    if (auto handle = dlTask.urlRequestHandle.exchange(0)) {
+        m_context.getPlatform().cancelUrlRequest(handle);
+        return;
+    }
+    // not started yet, or being started and then canceled by startRequest()
+    std::lock_guard<std::mutex> lock(m_limitersMutex);
+    for (auto& limiter : m_limiters) {
+        if (limiter->cancel(task)) { break; }
     }
 }
 
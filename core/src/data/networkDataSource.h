@@ -2,19 +2,27 @@
 
 #include "data/tileSource.h"
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace Tangram {
 
 class DataSourceContext;  //class Platform;
+class RequestLimiter;
 
 class NetworkDataSource : public TileSource::DataSource {
 public:
 
     NetworkDataSource(DataSourceContext& _context, std::string url, UrlOptions options);
+    ~NetworkDataSource() override;
 
     bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
 
     void cancelLoadingTile(TileTask& _task) override;
 
+    void updateTaskPriority(TileTask& _task) override;
+
     static std::string tileCoordinatesToQuadKey(const TileID& tile);
 
     /// Returns true if the URL either contains 'x', 'y', and 'z' placeholders or contains a 'q' placeholder.
@@ -24,6 +32,10 @@ public:
 
 private:
 
+    // @limiter is nullptr for requests that are not limited
+    bool startRequest(std::shared_ptr<TileTask> task, TileTaskCb callback, const Url& url,
+                      std::shared_ptr<RequestLimiter> limiter);
+
     DataSourceContext& m_context;  //Platform& m_platform;
 
     std::string m_urlTemplate;
@@ -33,6 +45,10 @@ private:
     UrlOptions m_options;
 
     int m_urlSubdomainIndex = 0;
+
+    // Limiters of requested hosts, to cancel requests waiting for a limiter
+    std::vector<std::shared_ptr<RequestLimiter>> m_limiters;
+    std::mutex m_limitersMutex;
 };
 
 }
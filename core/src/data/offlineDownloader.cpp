@@ -0,0 +1,395 @@
+#include "data/offlineDownloader.h"
+
+#include "data/mbtilesDataSource.h"
+#include "data/networkDataSource.h"
+#include "log.h"
+#include "platform.h"
+#include "tile/tileDiskCache.h"
+#include "util/geom.h"
+#include "util/ioExecutor.h"
+#include "util/mapProjection.h"
+#include "util/zlibHelper.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#define OFFLINE_PROGRESS_KEY "offline_progress_"
+
+namespace Tangram {
+
+OfflineRegion::OfflineRegion(std::vector<LngLat> _polygon, int _minZoom, int _maxZoom) :
+    m_minZoom(std::max(_minZoom, 0)),
+    m_maxZoom(_maxZoom) {
+
+    if (_polygon.size() > 1 && _polygon.front() == _polygon.back()) { _polygon.pop_back(); }
+
+    if (_polygon.size() >= 3) {
+        double maxLat = MapProjection::MAX_LATITUDE_DEGREES;
+        for (const auto& lngLat : _polygon) {
+            auto meters = MapProjection::lngLatToProjectedMeters({ lngLat.longitude,
+                                                                   glm::clamp(lngLat.latitude, -maxLat, maxLat) });
+            m_polygon.emplace_back(meters.x, meters.y);
+        }
+    }
+    reset();
+}
+
+std::vector<LngLat> OfflineRegion::boundsPolygon(LngLat _min, LngLat _max) {
+    return { _min, { _max.longitude, _min.latitude }, _max, { _min.longitude, _max.latitude } };
+}
+
+void OfflineRegion::reset() {
+    startZoom(m_minZoom);
+}
+
+void OfflineRegion::startZoom(int _z) {
+    m_z = _z;
+    m_minX = m_minY = 0;
+    m_maxX = m_maxY = -1;
+
+    if (m_z > m_maxZoom || m_polygon.empty()) { return; }
+
+    BoundingBox bounds{ { m_polygon[0].first, m_polygon[0].second },
+                        { m_polygon[0].first, m_polygon[0].second } };
+    for (const auto& p : m_polygon) { bounds.expand(p.first, p.second); }
+
+    int maxIndex = (1 << m_z) - 1;
+    TileID min = MapProjection::projectedMetersTile({ bounds.min.x, bounds.max.y }, m_z);
+    TileID max = MapProjection::projectedMetersTile({ bounds.max.x, bounds.min.y }, m_z);
+    m_minX = std::max(min.x, 0);
+    m_minY = std::max(min.y, 0);
+    m_maxX = std::min(max.x, maxIndex);
+    m_maxY = std::min(max.y, maxIndex);
+    m_x = m_minX;
+    m_y = m_minY;
+}
+
+bool OfflineRegion::next(TileID& _tile) {
+    while (m_z <= m_maxZoom) {
+        if (m_y > m_maxY || m_x > m_maxX) {
+            startZoom(m_z + 1);
+            continue;
+        }
+        TileID tile(m_x, m_y, m_z);
+        if (++m_x > m_maxX) {
+            m_x = m_minX;
+            m_y++;
+        }
+        if (intersects(tile)) {
+            _tile = tile;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t OfflineRegion::count() const {
+    OfflineRegion region = *this;
+    region.reset();
+    size_t count = 0;
+    TileID tile(0, 0, 0);
+    while (region.next(tile)) { count++; }
+    return count;
+}
+
+bool OfflineRegion::intersects(const TileID& _tile) const {
+    if (m_polygon.empty()) { return false; }
+
+    // polygon edges in tile units relative to the tile
+    double size = MapProjection::metersPerTileAtZoom(_tile.z);
+    ProjectedMeters origin = MapProjection::tileSouthWestCorner(_tile);
+    auto local = [&](const std::pair<double, double>& p) {
+        return glm::vec2((p.first - origin.x) / size, (p.second - origin.y) / size);
+    };
+
+    for (size_t i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++) {
+        glm::vec2 a = local(m_polygon[j]);
+        glm::vec2 b = local(m_polygon[i]);
+        if (clipLine(a, b, { 0, 0 }, { 1, 1 })) { return true; }
+    }
+
+    // no edge crosses the tile: it is either inside or outside the polygon
+    ProjectedMeters center = MapProjection::tileCenter(_tile);
+    bool inside = false;
+    for (size_t i = 0, j = m_polygon.size() - 1; i < m_polygon.size(); j = i++) {
+        const auto& a = m_polygon[j];
+        const auto& b = m_polygon[i];
+        if ((a.second > center.y) != (b.second > center.y) &&
+            center.x < a.first + (center.y - a.second) * (b.first - a.first) / (b.second - a.second)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+uint64_t OfflineRegion::hash() const {
+    int zooms[] = { m_minZoom, m_maxZoom };
+    uint64_t h = TileDiskCache::hash(zooms, sizeof(zooms));
+    for (const auto& p : m_polygon) {
+        double coordinates[] = { p.first, p.second };
+        h = TileDiskCache::hash(coordinates, sizeof(coordinates), h);
+    }
+    return h;
+}
+
+OfflineDownloader::OfflineDownloader(Platform& _platform, const TileSource::OfflineInfo& _info,
+                                     std::vector<LngLat> _polygon, int _minZoom, int _maxZoom, Options _options) :
+    m_platform(_platform),
+    m_info(_info),
+    m_options(_options),
+    m_region(std::move(_polygon), _minZoom, _maxZoom) {
+
+    m_options.maxParallel = std::max(m_options.maxParallel, 1);
+    m_options.checkpointTiles = std::max(m_options.checkpointTiles, 1);
+
+    m_httpOptions = m_info.urlOptions.httpOptions;
+    m_httpOptions.addHeader("User-Agent", m_platform.defaultUserAgent);
+    // do not hold back tiles of the map view
+    m_httpOptions.priority = HttpOptions::Priority::low;
+}
+
+OfflineDownloader::~OfflineDownloader() {
+    cancel();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_requestsDone.wait(lock, [&]() { return m_requests.empty(); });
+    }
+    if (m_worker) {
+        // waits for a running task; callbacks do not enqueue once canceled
+        m_worker.reset();
+        checkpoint();
+    }
+    // acknowledges tiles still pending while the members they update are alive
+    m_cache.reset();
+}
+
+bool OfflineDownloader::start(ProgressCallback _callback) {
+    if (m_info.cacheFile.empty()) {
+        LOGE("Offline download needs a cache for the TileSource");
+        return false;
+    }
+    if (m_info.url.compare(0, 8, "function") == 0) {
+        LOGE("Offline download is not supported for URL functions");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_started) { return false; }
+    m_started = true;
+    m_callback = std::move(_callback);
+
+    const char* mime = m_info.format == TileSource::Format::Mvt ? "pbf" :
+        m_info.format == TileSource::Format::Mlt ? "mlt" : "";
+    m_cache = std::make_unique<MBTilesDataSource>(m_platform, "offline", m_info.cacheFile, mime, 1 << 30);
+    if (!m_cache->isCache()) {
+        LOGE("Cannot open cache for offline download: %s", m_info.cacheFile.c_str());
+        m_cache.reset();
+        m_started = false;
+        return false;
+    }
+
+    m_worker = std::make_unique<IOQueue>();
+    m_worker->setQoS(ThreadQoS::background);
+    m_worker->enqueue([this]() { resume(); });
+    return true;
+}
+
+void OfflineDownloader::cancel() {
+    std::vector<UrlRequestHandle> handles;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_canceled || !m_started) { return; }
+        m_canceled = true;
+        for (const auto& request : m_requests) {
+            if (request.second) { handles.push_back(request.second); }
+        }
+    }
+    // callbacks run before cancelUrlRequest() returns
+    for (auto handle : handles) { m_platform.cancelUrlRequest(handle); }
+
+    m_worker->enqueue([this]() { fill(); });
+}
+
+OfflineDownloader::Progress OfflineDownloader::progress() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_progress;
+}
+
+std::string OfflineDownloader::progressKey() const {
+    return OFFLINE_PROGRESS_KEY + std::to_string(m_options.offlineId);
+}
+
+void OfflineDownloader::resume() {
+    size_t total = m_region.count();
+    uint64_t regionHash = TileDiskCache::hash(m_info.url, m_region.hash());
+
+    // "<region hash>,<index of first tile not stored>"
+    uint64_t skip = 0;
+    std::string value = m_cache->getMetadata(progressKey());
+    size_t comma = value.find(',');
+    if (comma != std::string::npos &&
+        std::strtoull(value.substr(0, comma).c_str(), nullptr, 16) == regionHash) {
+        skip = std::strtoull(value.c_str() + comma + 1, nullptr, 10);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_progress.total = total;
+        TileID tile(0, 0, 0);
+        while (m_index < skip && m_region.next(tile)) { m_index++; }
+        m_progress.completed = m_index;
+    }
+    if (skip > 0) {
+        LOGD("Resuming offline download %d after %d of %d tiles", m_options.offlineId, int(skip), int(total));
+    }
+    fill();
+}
+
+void OfflineDownloader::fill() {
+    while (true) {
+        TileID tile(0, 0, 0);
+        uint64_t index;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_canceled || m_exhausted) { break; }
+            if (m_requests.size() >= size_t(m_options.maxParallel)) { return; }
+            if (!m_region.next(tile)) {
+                m_exhausted = true;
+                break;
+            }
+            index = m_index++;
+            m_unfinished.insert(index);
+        }
+
+        if (m_cache->markOfflineTile(tile, m_options.offlineId)) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_unfinished.erase(index);
+                m_progress.completed++;
+                m_sinceCheckpoint++;
+            }
+            report();
+            continue;
+        }
+
+        Url url(NetworkDataSource::buildUrlForTile(tile, m_info.url, m_info.urlOptions, m_subdomainIndex));
+        if (!m_info.urlOptions.subdomains.empty()) {
+            m_subdomainIndex = (m_subdomainIndex + 1) % m_info.urlOptions.subdomains.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests[index] = 0;
+        }
+
+        UrlCallback onResponse = [this, index, tile, url](UrlResponse&& response) {
+            std::shared_ptr<std::vector<char>> data;
+            if (response.error) {
+                if (response.error != Platform::cancel_message) {
+                    LOGW("Error '%s' for offline tile %s", response.error, url.string().c_str());
+                }
+            } else if (!response.content.empty()) {
+                data = pooledBuffer(std::move(response.content));
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_requests.erase(index);
+            if (!m_canceled) {
+                m_worker->enqueue([this, index, tile, data]() { finishTile(index, tile, data); });
+            }
+            if (m_requests.empty()) { m_requestsDone.notify_all(); }
+        };
+
+        UrlRequestHandle handle = m_platform.startUrlRequest(url, m_httpOptions, std::move(onResponse));
+
+        bool canceled = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_requests.find(index);
+            if (it != m_requests.end()) {
+                it->second = handle;
+                canceled = m_canceled;
+            }
+        }
+        // canceled while starting
+        if (canceled) { m_platform.cancelUrlRequest(handle); }
+    }
+
+    bool finished = false, complete = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_requests.empty() && !m_progress.finished) {
+            m_progress.finished = finished = true;
+        }
+    }
+    if (finished) {
+        // commits the pending tiles, which completes them
+        checkpoint();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            complete = !m_canceled && m_progress.completed == m_progress.total;
+        }
+        if (complete && !m_options.pmtilesFile.empty() &&
+            m_cache->exportPMTiles(m_options.pmtilesFile, m_options.offlineId)) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_progress.archive = m_options.pmtilesFile;
+        }
+        report();
+    }
+}
+
+void OfflineDownloader::finishTile(uint64_t _index, const TileID& _tile, std::shared_ptr<std::vector<char>> _data) {
+    size_t size = _data ? _data->size() : 0;
+    if (size > 0) {
+        // the tile is completed once it is committed, which may be on the thread of the cache
+        m_cache->storeOfflineTile(_tile, std::move(_data), m_options.offlineId, [this, _index, size](bool _stored) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (_stored) {
+                    // failed tiles stay unfinished, so that they are requested again on resume
+                    m_unfinished.erase(_index);
+                    m_progress.completed++;
+                    m_progress.downloaded++;
+                    m_progress.bytes += size;
+                } else {
+                    m_progress.failed++;
+                }
+            }
+            report();
+        });
+    }
+
+    bool checkpointDue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (size == 0) { m_progress.failed++; }
+        checkpointDue = ++m_sinceCheckpoint >= size_t(m_options.checkpointTiles);
+    }
+    if (checkpointDue) { checkpoint(); }
+    if (size == 0) { report(); }
+    fill();
+}
+
+void OfflineDownloader::checkpoint() {
+    uint64_t stored;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stored = m_unfinished.empty() ? m_index : *m_unfinished.begin();
+        m_sinceCheckpoint = 0;
+    }
+    // tiles before @stored are in the database once the pending tiles are committed
+    if (!m_cache->flushTiles()) { return; }
+
+    char value[64];
+    snprintf(value, sizeof(value), "%016llx,%llu",
+             (unsigned long long)TileDiskCache::hash(m_info.url, m_region.hash()), (unsigned long long)stored);
+    m_cache->setMetadata(progressKey(), value);
+}
+
+void OfflineDownloader::report() {
+    if (!m_callback) { return; }
+    m_callback(progress());
+}
+
+}
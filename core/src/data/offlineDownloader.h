@@ -0,0 +1,169 @@
+#pragma once
+
+#include "data/tileSource.h"
+#include "platform.h"
+#include "tile/tileID.h"
+#include "util/types.h"
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class IOQueue;
+class MBTilesDataSource;
+
+/* Tiles of a polygon over a range of zoom levels
+ *
+ * Tiles are enumerated lazily by zoom, then row, then column, so that the position of a
+ * tile in the sequence is stable across sessions and can be used to resume a download.
+ */
+class OfflineRegion {
+
+public:
+
+    // @_polygon: outer ring, closed or not; with less than three points the region is empty
+    OfflineRegion(std::vector<LngLat> _polygon, int _minZoom, int _maxZoom);
+
+    // Rectangle from @_min (south-west) to @_max (north-east)
+    static std::vector<LngLat> boundsPolygon(LngLat _min, LngLat _max);
+
+    // Set @_tile to the next tile of the region; returns false when all tiles were enumerated
+    bool next(TileID& _tile);
+
+    // Enumerate from the first tile again
+    void reset();
+
+    // Number of tiles in the region; enumerates all tiles
+    size_t count() const;
+
+    bool intersects(const TileID& _tile) const;
+
+    // Stable across sessions, to match stored progress to the region
+    uint64_t hash() const;
+
+    int minZoom() const { return m_minZoom; }
+    int maxZoom() const { return m_maxZoom; }
+
+private:
+
+    void startZoom(int _z);
+
+    // polygon in projected meters
+    std::vector<std::pair<double, double>> m_polygon;
+    int m_minZoom;
+    int m_maxZoom;
+
+    // current zoom, tile range of polygon bounds and next tile
+    int m_z = 0;
+    int m_minX = 0, m_maxX = -1, m_minY = 0, m_maxY = -1;
+    int m_x = 0, m_y = 0;
+};
+
+/* Download of a region into the MBTiles cache of a TileSource, for use without network
+ *
+ * Tiles already in the cache are only assigned to the offline region; the others are
+ * requested with up to Options::maxParallel requests at a time and stored in batched
+ * transactions. Progress is persisted in the metadata of the cache every
+ * Options::checkpointTiles tiles and when the download stops, so that a download of the
+ * same region continues after tiles that were already completed - tiles that failed are
+ * requested again.
+ *
+ * With Options::pmtilesFile set, a completed download is also written to a clustered PMTiles
+ * archive, see MBTilesDataSource::exportPMTiles(); once Progress::archive is set, the source can
+ * be switched to it, e.g. by a SceneUpdate of its url to "file://" + archive, so that tiles are
+ * read from the memory mapped archive instead of being queried from the cache.
+ *
+ * The download runs until it finished or the OfflineDownloader is destroyed, e.g.
+ *   auto download = std::make_unique<OfflineDownloader>(map.getPlatform(), source->offlineInfo(),
+ *                                                        polygon, 10, 16);
+ *   download->start([](const OfflineDownloader::Progress& progress) { ... });
+ */
+class OfflineDownloader {
+
+public:
+
+    struct Options {
+        Options() {}
+        // offline_id of downloaded tiles in the cache
+        int offlineId = 1;
+        int maxParallel = 8;
+        int checkpointTiles = 256;
+        // path of PMTiles archive written when all tiles of the region are stored, if not empty
+        std::string pmtilesFile;
+    };
+
+    struct Progress {
+        size_t total = 0;
+        // tiles that are stored, whether downloaded or already cached
+        size_t completed = 0;
+        size_t downloaded = 0;
+        size_t failed = 0;
+        size_t bytes = 0;
+        bool finished = false;
+        // path of the PMTiles archive of the region, once it is written
+        std::string archive;
+    };
+
+    // Called after each tile and when the download finished or was canceled; may be called on any thread
+    using ProgressCallback = std::function<void(const Progress&)>;
+
+    OfflineDownloader(Platform& _platform, const TileSource::OfflineInfo& _info,
+                      std::vector<LngLat> _polygon, int _minZoom, int _maxZoom, Options _options = {});
+
+    // Cancels the download and waits for running requests
+    ~OfflineDownloader();
+
+    // Returns false if the TileSource has no cache or its URL is a function
+    bool start(ProgressCallback _callback);
+
+    void cancel();
+
+    Progress progress() const;
+
+private:
+
+    // on m_worker
+    void resume();
+    void fill();
+    void finishTile(uint64_t _index, const TileID& _tile, std::shared_ptr<std::vector<char>> _data);
+    void checkpoint();
+    void report();
+
+    std::string progressKey() const;
+
+    Platform& m_platform;
+    TileSource::OfflineInfo m_info;
+    Options m_options;
+    OfflineRegion m_region;
+    HttpOptions m_httpOptions;
+    int m_subdomainIndex = 0;
+
+    std::unique_ptr<MBTilesDataSource> m_cache;
+    ProgressCallback m_callback;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_requestsDone;
+    Progress m_progress;
+    bool m_started = false;
+    bool m_canceled = false;
+    bool m_exhausted = false;
+
+    // index of next tile from m_region
+    uint64_t m_index = 0;
+    // running requests by tile index, handle is 0 until the request is started
+    std::map<uint64_t, UrlRequestHandle> m_requests;
+    // tiles before this index, except those in m_unfinished, are stored
+    std::set<uint64_t> m_unfinished;
+    size_t m_sinceCheckpoint = 0;
+
+    std::unique_ptr<IOQueue> m_worker;
+};
+
+}
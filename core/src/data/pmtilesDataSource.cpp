@@ -2,8 +2,10 @@
 
 #include "platform.h"
 #include "log.h"
-#include "util/asyncWorker.h"
+#include "util/ioExecutor.h"
+#include "util/mappedFile.h"
 #include "util/zlibHelper.h"
+#include "tile/tileAvailability.h"
 #include "tile/tileTask.h"
 #include "util/url.h"
 
@@ -11,7 +13,6 @@
 
 #include <algorithm>
 #include <cinttypes>
-#include <condition_variable>
 #include <cstring>
 #include <fstream>
 
@@ -20,42 +21,88 @@ namespace Tangram {
 // Maximum depth of PMTiles directory tree
 static constexpr int MAX_DIRECTORY_DEPTH = 3;
 
-// Heuristic multiplier for initial decompression buffer size
-static constexpr int DECOMPRESSION_SIZE_MULTIPLIER = 4;
+// Size of the PMTiles header
+static constexpr uint32_t HEADER_BYTES = 127;
 
-// Timeout for HTTP range requests (in seconds)
-static constexpr int HTTP_REQUEST_TIMEOUT_SEC = 30;
+// Bytes read on first access; the spec recommends that header and root
+// directory fit into the first 16 KiB of the archive
+static constexpr uint32_t ROOT_FETCH_BYTES = 16384;
+
+// Memory budget of parsed leaf directories
+static constexpr size_t LEAF_CACHE_BYTES = 8 * 1024 * 1024;
+
+// Time to collect HTTP tile reads before merging them into range requests
+static constexpr int TILE_READ_WINDOW_MS = 10;
+
+// Number of collected tile reads that triggers merging without waiting
+static constexpr size_t MAX_QUEUED_TILE_READS = 64;
+
+// Largest gap between tiles that are read with one range request; reading
+// the gap is cheaper than the round trip of another request
+static constexpr uint64_t MAX_TILE_READ_GAP = 64 * 1024;
+
+// Largest merged range request
+static constexpr uint64_t MAX_TILE_READ_BYTES = 2 * 1024 * 1024;
+
+struct PMTilesDataSource::Lookup {
+    std::shared_ptr<TileTask> task;
+    TileTaskCb cb;
+    std::shared_ptr<const pmtiles::headerv3> header;
+    uint64_t tileId = 0;
+    int depth = 0;
+};
 
 PMTilesDataSource::PMTilesDataSource(Platform& _platform, const std::string& _path)
     : m_platform(_platform),
       m_path(_path),
       m_isHttp(false),
-      m_rootDirCached(false) {
+      m_rootState(RootState::none),
+      m_leafBytes(0),
+      m_tileReadsScheduled(false) {
     
     // Determine if this is an HTTP or local file source
     m_isHttp = (_path.substr(0, 7) == "http://" || _path.substr(0, 8) == "https://");
     
+    // Map local archives once; lookups then read without syscalls
+    if (!m_isHttp) {
+        m_path = Url(_path).path();
+        m_file = std::make_unique<MappedFile>();
+        if (m_file->open(m_path)) {
+            m_file->adviseRandom();
+        } else {
+            LOGW("PMTiles: Cannot map %s, using file reads", m_path.c_str());
+        }
+    }
+    
     // Create async worker for I/O operations
-    m_worker = std::make_unique<AsyncWorker>("PMTiles");
+    m_worker = std::make_unique<IOQueue>();
     
     LOGD("PMTilesDataSource created for: %s (HTTP: %d)", _path.c_str(), m_isHttp);
 }
 
 PMTilesDataSource::~PMTilesDataSource() {
+    // Stop the worker before the state used by queued continuations goes away
+    m_worker.reset();
     clear();
 }
 
 void PMTilesDataSource::clear() {
     std::lock_guard<std::mutex> lock(m_mutex);
+    // Keep leaf directories being read, their lookups are resumed when done
+    for (uint64_t offset : m_leafLru) { m_leafDirs.erase(offset); }
+    m_leafLru.clear();
+    m_leafBytes = 0;
+
+    // A pending load still resumes its waiting lookups
+    if (m_rootState == RootState::loading) { return; }
     m_header.reset();
-    m_rootDirCache.clear();
-    m_rootDirCached = false;
+    m_rootDir.reset();
+    m_rootState = RootState::none;
 }
 
-bool PMTilesDataSource::readRangeSync(uint64_t offset, uint32_t length, std::vector<char>& data) {
-    data.clear();
-    data.reserve(length);
-    
+UrlRequestHandle PMTilesDataSource::readRange(uint64_t offset, uint32_t length,
+                                              const std::shared_ptr<TileTask>& _task,
+                                              ReadCallback _cb, bool _forTask) {
     if (m_isHttp) {
         // For HTTP sources, use HTTP range requests
         // Create Range header: "bytes=start-end"
@@ -63,281 +110,545 @@ bool PMTilesDataSource::readRangeSync(uint64_t offset, uint32_t length, std::vec
         std::string rangeHeader = "bytes=" + std::to_string(offset) + "-" + 
                                   std::to_string(offset + length - 1);
         options.addHeader("Range", rangeHeader);
-        
-        // Use condition variable to wait for async response
-        std::mutex cvMutex;
-        std::condition_variable cv;
-        bool completed = false;
-        bool success = false;
-        
-        auto callback = [&](UrlResponse&& response) {
-            std::lock_guard<std::mutex> lock(cvMutex);
-            
+
+        std::weak_ptr<TileTask> weakTask = _task;
+        auto callback = [this, weakTask, offset, length, _cb](UrlResponse&& response) {
+            auto task = weakTask.lock();
+            if (!task) { return; }
+
+            auto prana = task->prana();  // lock Scene when running callback on thread
+            if (!prana) {
+                LOGW("PMTiles: URL callback for deleted Scene");
+                return;
+            }
+
+            bool ok = false;
+            std::vector<char> data;
             if (response.error) {
                 LOGE("PMTiles: HTTP range request failed: %s", response.error);
             } else if (!response.content.empty()) {
                 data = std::move(response.content);
-                success = true;
+                ok = true;
+
+                if (data.size() > length && data.size() >= offset + length) {
+                    // Server ignored the Range header and sent the whole archive
+                    data.erase(data.begin() + offset + length, data.end());
+                    data.erase(data.begin(), data.begin() + offset);
+                } else if (data.size() != length) {
+                    LOGW("PMTiles: Expected %u bytes, got %zu bytes from HTTP range request",
+                         length, data.size());
+                }
+            } else {
+                LOGE("PMTiles: Failed to read range [%" PRIu64 ", %" PRIu64 ") from HTTP: %s",
+                     offset, offset + length, m_path.c_str());
             }
-            
-            completed = true;
-            cv.notify_one();
+
+            // Decompression and parsing run on the worker, not on the network thread
+            m_worker->enqueue([task, ok, data = std::move(data), _cb]() {
+                auto prana = task->prana();
+                if (!prana) { return; }
+                _cb(ok, data.data(), data.size());
+            });
         };
-        
+
         // Start the HTTP range request
-        m_platform.startUrlRequest(Url(m_path), options, std::move(callback));
-        
-        // Wait for the request to complete (with timeout)
-        std::unique_lock<std::mutex> lock(cvMutex);
-        if (!cv.wait_for(lock, std::chrono::seconds(HTTP_REQUEST_TIMEOUT_SEC), 
-                        [&completed] { return completed; })) {
-            LOGE("PMTiles: HTTP range request timed out after %d seconds", HTTP_REQUEST_TIMEOUT_SEC);
-            return false;
-        }
-        
-        if (!success) {
-            LOGE("PMTiles: Failed to read range [%" PRIu64 ", %" PRIu64 ") from HTTP: %s",
-                 offset, offset + length, m_path.c_str());
-            return false;
-        }
-        
-        // Verify we got the expected amount of data
-        if (data.size() != length) {
-            LOGW("PMTiles: Expected %u bytes, got %zu bytes from HTTP range request",
-                 length, data.size());
+        return m_platform.startUrlRequest(Url(m_path), options, std::move(callback));
+    }
+
+    // For local files, read from the mapping on the worker: page faults on large
+    // archives should not block the calling thread
+    std::function<void()> read = [this, task = _task, offset, length, _cb]() {
+        auto prana = task->prana();
+        if (!prana) { return; }
+
+        if (m_file && m_file->isOpen()) {
+            if (offset >= m_file->size()) {
+                LOGE("PMTiles: Offset %" PRIu64 " beyond end of file: %s", offset, m_path.c_str());
+                _cb(false, nullptr, 0);
+                return;
+            }
+            _cb(true, m_file->data() + offset, size_t(std::min<uint64_t>(length, m_file->size() - offset)));
+            return;
         }
-        
-        return true;
-        
-    } else {
-        // For local files, use standard file I/O with seeking
+
+        // Fall back to file I/O when the archive could not be mapped
         std::ifstream file(m_path, std::ios::binary);
         if (!file.is_open()) {
             LOGE("PMTiles: Failed to open file: %s", m_path.c_str());
-            return false;
+            _cb(false, nullptr, 0);
+            return;
         }
         
         file.seekg(offset);
         if (!file.good()) {
             LOGE("PMTiles: Failed to seek to offset %" PRIu64 " in file: %s", offset, m_path.c_str());
-            return false;
+            _cb(false, nullptr, 0);
+            return;
         }
         
-        data.resize(length);
+        std::vector<char> data(length);
         file.read(data.data(), length);
         if (!file.good() && !file.eof()) {
             LOGE("PMTiles: Failed to read %u bytes at offset %" PRIu64 " from file: %s", 
                  length, offset, m_path.c_str());
-            return false;
+            _cb(false, nullptr, 0);
+            return;
         }
         
-        return true;
+        _cb(true, data.data(), size_t(file.gcount()));
+    };
+    
+    if (_forTask) {
+        m_worker->enqueue(_task, std::move(read));
+    } else {
+        m_worker->enqueue(std::move(read));
     }
+    return 0;
 }
 
-bool PMTilesDataSource::loadHeader() {
-    if (m_header) {
-        return true; // Already loaded
-    }
-    
-    std::vector<char> headerData;
-    if (!readRangeSync(0, 127, headerData)) {
-        LOGE("PMTiles: Failed to read header from %s", m_path.c_str());
-        return false;
-    }
-    
-    try {
-        std::string headerStr(headerData.begin(), headerData.end());
-        auto header = pmtiles::deserialize_header(headerStr);
-        m_header = std::make_unique<pmtiles::headerv3>(std::move(header));
-        
+void PMTilesDataSource::loadRoot(const std::shared_ptr<TileTask>& _task) {
+    readRange(0, ROOT_FETCH_BYTES, _task, [this, _task](bool ok, const char* data, size_t size) {
+        if (!ok || size < HEADER_BYTES) {
+            LOGE("PMTiles: Failed to read header from %s", m_path.c_str());
+            finishRoot(nullptr, nullptr);
+            return;
+        }
+
+        std::shared_ptr<pmtiles::headerv3> header;
+        try {
+            std::string headerStr(data, HEADER_BYTES);
+            header = std::make_shared<pmtiles::headerv3>(pmtiles::deserialize_header(headerStr));
+        } catch (const std::exception& e) {
+            LOGE("PMTiles: Failed to parse header: %s", e.what());
+            finishRoot(nullptr, nullptr);
+            return;
+        }
+
         LOGD("PMTiles header loaded: zoom %d-%d, tiles: %llu, compression: %d, tile_type: %d",
-             m_header->min_zoom, m_header->max_zoom, m_header->tile_entries_count,
-             m_header->tile_compression, m_header->tile_type);
-        
-        return true;
-    } catch (const std::exception& e) {
-        LOGE("PMTiles: Failed to parse header: %s", e.what());
-        return false;
-    }
+             header->min_zoom, header->max_zoom, header->tile_entries_count,
+             header->tile_compression, header->tile_type);
+
+        // Tiles outside of the archive are not requested, unless the next source may have them
+        auto source = _task->source();
+        if (!next && source) {
+            auto& availability = source->availability();
+            availability.setZoomRange(header->min_zoom, header->max_zoom);
+            if (header->min_lon_e7 < header->max_lon_e7 && header->min_lat_e7 < header->max_lat_e7) {
+                availability.setBounds({ header->min_lon_e7 / 1e7, header->min_lat_e7 / 1e7 },
+                                       { header->max_lon_e7 / 1e7, header->max_lat_e7 / 1e7 });
+            }
+        }
+
+        // the range of the root directory is read with a 32 bit length
+        if (header->root_dir_bytes > UINT32_MAX) {
+            LOGE("PMTiles: Invalid root directory size");
+            finishRoot(nullptr, nullptr);
+            return;
+        }
+
+        auto onRootDir = [this, header](bool ok, const char* dirData, size_t dirSize) {
+            auto rootDir = std::make_shared<std::vector<pmtiles::entryv3>>();
+            if (!ok || !parseDirectory(dirData, dirSize, header->internal_compression, *rootDir)) {
+                LOGE("PMTiles: Failed to load root directory");
+                finishRoot(nullptr, nullptr);
+                return;
+            }
+            finishRoot(header, rootDir);
+        };
+
+        if (header->root_dir_offset <= size && header->root_dir_bytes <= size - header->root_dir_offset) {
+            // Root directory is part of the first read
+            onRootDir(true, data + header->root_dir_offset, size_t(header->root_dir_bytes));
+        } else {
+            readRange(header->root_dir_offset, uint32_t(header->root_dir_bytes), _task, onRootDir);
+        }
+    });
 }
 
-bool PMTilesDataSource::decompress(const std::vector<char>& compressed, 
+bool PMTilesDataSource::decompress(const char* compressed, size_t size,
                                    std::vector<char>& decompressed, 
                                    uint8_t compression) {
+    Codec codec;
+    const char* name;
     switch (compression) {
         case pmtiles::COMPRESSION_NONE:
-            decompressed = compressed;
+            decompressed.assign(compressed, compressed + size);
             return true;
-            
-        case pmtiles::COMPRESSION_GZIP: {
-            // Use existing zlib helper
-            decompressed.clear();
-            // Initial capacity estimate (heuristic: decompressed is ~4x compressed size)
-            decompressed.reserve(compressed.size() * DECOMPRESSION_SIZE_MULTIPLIER);
-            
-            if (zlib_inflate(compressed.data(), compressed.size(), decompressed) == 0) {
-                return true;
-            }
-            
-            LOGE("PMTiles: Failed to decompress gzip data");
-            return false;
-        }
-        
+        case pmtiles::COMPRESSION_GZIP:
+            codec = Codec::gzip;
+            name = "gzip";
+            break;
         case pmtiles::COMPRESSION_BROTLI:
-            LOGE("PMTiles: Brotli compression not supported");
-            return false;
-            
+            codec = Codec::brotli;
+            name = "brotli";
+            break;
         case pmtiles::COMPRESSION_ZSTD:
-            LOGE("PMTiles: Zstd compression not supported");
-            return false;
-            
+            codec = Codec::zstd;
+            name = "zstd";
+            break;
         default:
             LOGE("PMTiles: Unknown compression type: %d", compression);
             return false;
     }
-}
-
-bool PMTilesDataSource::loadDirectory(uint64_t offset, uint32_t length, 
-                                     std::vector<char>& data) {
-    // Read compressed directory
-    std::vector<char> compressed;
-    if (!readRangeSync(offset, length, compressed)) {
+    
+    if (!hasDecompressor(codec)) {
+        LOGE("PMTiles: %s compression not supported", name);
         return false;
     }
     
-    // Decompress if needed
-    if (!m_header) {
-        LOGE("PMTiles: Header not loaded before directory");
-        return false;
+    // Decoders size the output from the input (for gzip from its trailer), and reuse
+    // the capacity of pooled buffers
+    if (Tangram::decompress(codec, compressed, size, decompressed) == 0) {
+        return true;
     }
     
-    return decompress(compressed, data, m_header->internal_compression);
+    LOGE("PMTiles: Failed to decompress %s data", name);
+    return false;
 }
 
-bool PMTilesDataSource::getTileData(const TileID& _tileId, std::vector<char>& _data) {
-    // Ensure header is loaded (lazy initialization)
-    if (!loadHeader()) {
-        return false;
+bool PMTilesDataSource::parseDirectory(const char* compressed, size_t size, uint8_t compression,
+                                       std::vector<pmtiles::entryv3>& entries) {
+    // pmtiles::deserialize_directory() takes a string
+    std::string directory;
+    if (compression == pmtiles::COMPRESSION_NONE) {
+        directory.assign(compressed, size);
+    } else {
+        std::vector<char> data;
+        if (!decompress(compressed, size, data, compression)) {
+            return false;
+        }
+        directory.assign(data.data(), data.size());
     }
     
-    // Convert tangram TileID (z, x, y) to PMTiles tile ID
-    // PMTiles uses a Hilbert curve encoding for efficient spatial indexing
-    uint64_t tileId;
     try {
-        tileId = pmtiles::zxy_to_tileid(_tileId.z, _tileId.x, _tileId.y);
+        entries = pmtiles::deserialize_directory(directory);
     } catch (const std::exception& e) {
-        LOGE("PMTiles: Invalid tile coordinates: z=%d, x=%d, y=%d: %s",
-             _tileId.z, _tileId.x, _tileId.y, e.what());
+        LOGE("PMTiles: Failed to deserialize directory: %s", e.what());
         return false;
     }
-    
-    // Load root directory if not cached
-    // The root directory is cached to avoid repeated reads for common operations
-    if (!m_rootDirCached) {
+    return true;
+}
+
+void PMTilesDataSource::finishRoot(std::shared_ptr<const pmtiles::headerv3> _header,
+                                   std::shared_ptr<const std::vector<pmtiles::entryv3>> _rootDir) {
+    std::vector<std::shared_ptr<Lookup>> waiting;
+    {
         std::lock_guard<std::mutex> lock(m_mutex);
-        if (!m_rootDirCached) {
-            if (!loadDirectory(m_header->root_dir_offset, 
-                             static_cast<uint32_t>(m_header->root_dir_bytes), 
-                             m_rootDirCache)) {
-                LOGE("PMTiles: Failed to load root directory");
-                return false;
-            }
-            m_rootDirCached = true;
+        m_header = _header;
+        m_rootDir = _rootDir;
+        // Retry with the next lookup on failure
+        m_rootState = _rootDir ? RootState::ready : RootState::none;
+        waiting.swap(m_waiting);
+    }
+    
+    for (auto& lookup : waiting) {
+        if (_rootDir) {
+            lookup->header = _header;
+            lookupTile(std::move(lookup), *_rootDir);
+        } else {
+            finishLookup(std::move(lookup), false);
         }
     }
+}
+
+void PMTilesDataSource::lookupTile(std::shared_ptr<Lookup> _lookup,
+                                   const std::vector<pmtiles::entryv3>& _entries) {
+    if (_lookup->task->isCanceled()) { return; }
     
-    // Search for tile in directory hierarchy
-    // PMTiles uses a tree structure with up to 3 levels for large tile sets
-    std::string currentDir(m_rootDirCache.begin(), m_rootDirCache.end());
-    uint64_t dirOffset = m_header->root_dir_offset;
-    uint32_t dirLength = static_cast<uint32_t>(m_header->root_dir_bytes);
+    // Binary search for the tile ID in the directory
+    auto entry = pmtiles::find_tile(_entries, _lookup->tileId);
     
-    // Traverse directory tree (max depth defined by PMTiles spec)
-    for (int depth = 0; depth <= MAX_DIRECTORY_DEPTH; depth++) {
-        std::vector<pmtiles::entryv3> entries;
-        try {
-            entries = pmtiles::deserialize_directory(currentDir);
-        } catch (const std::exception& e) {
-            LOGE("PMTiles: Failed to deserialize directory at depth %d: %s", depth, e.what());
-            return false;
-        }
+    if (entry.length == 0) {
+        // Tile not found in this archive
+        auto source = _lookup->task->source();
+        if (!next && source) { source->availability().setMissing(_lookup->task->tileId()); }
+        finishLookup(std::move(_lookup), false);
+        return;
+    }
+    
+    const auto& header = *_lookup->header;
+    
+    if (entry.run_length > 0) {
+        // This is a leaf entry - read the actual tile data
+        uint64_t tileOffset = header.tile_data_offset + entry.offset;
         
-        // Binary search for the tile ID in the directory
-        auto entry = pmtiles::find_tile(entries, tileId);
+        if (m_isHttp) {
+            // Group with reads of neighboring tiles
+            queueTileRead(std::move(_lookup), tileOffset, entry.length);
+            return;
+        }
         
-        if (entry.length == 0) {
-            // Tile not found in this archive
-            return false;
+        readRange(tileOffset, entry.length, _lookup->task,
+                  [this, _lookup, tileOffset](bool ok, const char* compressed, size_t size) {
+            finishTile(_lookup, tileOffset, ok, compressed, size);
+        }, true);
+        return;
+    }
+    
+    // This is a directory entry - load the next level directory
+    // PMTiles uses a tree structure with up to 3 levels for large tile sets
+    if (++_lookup->depth > MAX_DIRECTORY_DEPTH) {
+        LOGE("PMTiles: Directory tree depth exceeded");
+        finishLookup(std::move(_lookup), false);
+        return;
+    }
+    
+    lookupLeaf(std::move(_lookup), header.leaf_dirs_offset + entry.offset, entry.length);
+}
+
+void PMTilesDataSource::finishTile(const std::shared_ptr<Lookup>& _lookup, uint64_t _offset,
+                                   bool _ok, const char* _compressed, size_t _size) {
+    auto& task = static_cast<BinaryTileTask&>(*_lookup->task);
+    task.urlRequestHandle = 0;
+    if (task.isCanceled()) { return; }
+    
+    if (!_ok) {
+        LOGE("PMTiles: Failed to read tile data at offset %" PRIu64 ", length %zu",
+             _offset, _size);
+        finishLookup(_lookup, false);
+        return;
+    }
+    
+    // Decompress tile data (gzip, brotli, or uncompressed); for mapped files
+    // compressed tiles are inflated straight from the mapping
+    auto data = pooledBuffer();
+    if (!decompress(_compressed, _size, *data, _lookup->header->tile_compression)) {
+        finishLookup(_lookup, false);
+        return;
+    }
+    
+    task.rawTileData = std::move(data);
+    finishLookup(_lookup, true);
+}
+
+void PMTilesDataSource::queueTileRead(std::shared_ptr<Lookup> _lookup, uint64_t _offset, uint32_t _length) {
+    bool schedule = false;
+    bool flush = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tileReads.push_back({ std::move(_lookup), _offset, _length });
+        flush = m_tileReads.size() >= MAX_QUEUED_TILE_READS;
+        schedule = !flush && !m_tileReadsScheduled;
+        if (schedule) { m_tileReadsScheduled = true; }
+    }
+    
+    if (flush) {
+        flushTileReads();
+    } else if (schedule) {
+        // Delayed tasks run when the worker is idle, i.e. after the lookups queued
+        // with this one had a chance to add their reads
+        m_worker->enqueueDelayed([this]() { flushTileReads(); },
+                                 std::chrono::milliseconds(TILE_READ_WINDOW_MS));
+    }
+}
+
+void PMTilesDataSource::flushTileReads() {
+    std::vector<TileRead> reads;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        reads.swap(m_tileReads);
+        m_tileReadsScheduled = false;
+    }
+    
+    // Drop reads of tiles which are not needed anymore
+    reads.erase(std::remove_if(reads.begin(), reads.end(), [](const TileRead& read) {
+        return read.lookup->task->isCanceled();
+    }), reads.end());
+    if (reads.empty()) { return; }
+    
+    std::sort(reads.begin(), reads.end(), [](const TileRead& a, const TileRead& b) {
+        return a.offset < b.offset;
+    });
+    
+    // Merge tiles into one range while gaps are small, then read each range once
+    // and hand every tile its part of the response
+    size_t first = 0;
+    while (first < reads.size()) {
+        uint64_t start = reads[first].offset;
+        uint64_t end = start + reads[first].length;
+        size_t last = first + 1;
+        while (last < reads.size()) {
+            const auto& read = reads[last];
+            uint64_t readEnd = std::max(end, read.offset + read.length);
+            if (read.offset > end + MAX_TILE_READ_GAP || readEnd - start > MAX_TILE_READ_BYTES) { break; }
+            end = readEnd;
+            last++;
         }
         
-        if (entry.run_length > 0) {
-            // This is a leaf entry - read the actual tile data
-            std::vector<char> compressed;
-            uint64_t tileOffset = m_header->tile_data_offset + entry.offset;
-            
-            if (!readRangeSync(tileOffset, entry.length, compressed)) {
-                LOGE("PMTiles: Failed to read tile data at offset %" PRIu64 ", length %u",
-                     tileOffset, entry.length);
-                return false;
+        auto group = std::make_shared<std::vector<TileRead>>(reads.begin() + first, reads.begin() + last);
+        auto handle = readRange(start, uint32_t(end - start), group->front().lookup->task,
+                                [this, group, start](bool ok, const char* data, size_t size) {
+            for (const auto& read : *group) {
+                uint64_t begin = read.offset - start;
+                bool inRange = ok && begin + read.length <= size;
+                finishTile(read.lookup, read.offset, inRange,
+                           inRange ? data + begin : nullptr, inRange ? read.length : 0);
             }
-            
-            // Decompress tile data (gzip, brotli, or uncompressed)
-            if (!decompress(compressed, _data, m_header->tile_compression)) {
-                return false;
+        });
+        
+        // A merged request is shared, so only single tile requests are canceled with their task
+        if (handle && group->size() == 1) {
+            static_cast<BinaryTileTask&>(*group->front().lookup->task).urlRequestHandle = handle;
+        }
+        first = last;
+    }
+}
+
+void PMTilesDataSource::lookupLeaf(std::shared_ptr<Lookup> _lookup, uint64_t _offset, uint32_t _length) {
+    std::shared_ptr<const std::vector<pmtiles::entryv3>> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_leafDirs.find(_offset);
+        if (it != m_leafDirs.end()) {
+            if (!it->second.entries) {
+                // Already being read for another lookup
+                it->second.waiting.push_back(std::move(_lookup));
+                return;
             }
-            
-            return true;
+            m_leafLru.splice(m_leafLru.begin(), m_leafLru, it->second.lru);
+            entries = it->second.entries;
         } else {
-            // This is a directory entry - load the next level directory
-            std::vector<char> nextDirData;
-            uint64_t nextDirOffset = m_header->leaf_dirs_offset + entry.offset;
-            
-            if (!loadDirectory(nextDirOffset, entry.length, nextDirData)) {
-                LOGE("PMTiles: Failed to load directory at depth %d", depth + 1);
-                return false;
-            }
-            
-            currentDir = std::string(nextDirData.begin(), nextDirData.end());
+            m_leafDirs[_offset].waiting.push_back(_lookup);
         }
     }
     
-    LOGE("PMTiles: Directory tree depth exceeded");
-    return false;
+    if (entries) {
+        lookupTile(std::move(_lookup), *entries);
+        return;
+    }
+    
+    uint8_t compression = _lookup->header->internal_compression;
+    int depth = _lookup->depth;
+    
+    // Continue even when the task of this lookup is canceled, others may wait for the directory
+    readRange(_offset, _length, _lookup->task,
+              [this, _offset, compression, depth](bool ok, const char* compressed, size_t size) {
+        auto dir = std::make_shared<std::vector<pmtiles::entryv3>>();
+        if (!ok || !parseDirectory(compressed, size, compression, *dir)) {
+            LOGE("PMTiles: Failed to load directory at depth %d", depth);
+            dir.reset();
+        }
+        finishLeaf(_offset, std::move(dir));
+    });
 }
 
-bool PMTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
-    // Queue async work to avoid blocking the main thread
-    m_worker->enqueue([this, _task, _cb]() {
-        auto& task = static_cast<BinaryTileTask&>(*_task);
+void PMTilesDataSource::finishLeaf(uint64_t _offset,
+                                   std::shared_ptr<const std::vector<pmtiles::entryv3>> _entries) {
+    std::vector<std::shared_ptr<Lookup>> waiting;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_leafDirs.find(_offset);
+        if (it == m_leafDirs.end()) { return; }
         
-        std::vector<char> data;
-        if (getTileData(_task->tileId(), data)) {
-            // Successfully loaded tile from PMTiles archive
-            task.rawTileData = std::make_shared<std::vector<char>>(std::move(data));
+        LeafDir& leaf = it->second;
+        waiting.swap(leaf.waiting);
+        
+        if (!_entries) {
+            // Read again for the next lookup
+            m_leafDirs.erase(it);
+        } else {
+            leaf.entries = _entries;
+            leaf.bytes = sizeof(LeafDir) + _entries->size() * sizeof(pmtiles::entryv3);
+            m_leafLru.push_front(_offset);
+            leaf.lru = m_leafLru.begin();
+            m_leafBytes += leaf.bytes;
             
-            // Invoke callback to notify that data is ready
-            if (_cb.func) {
-                _cb.func(_task);
+            // Evict least recently used leaf directories, keeping at least this one
+            while (m_leafBytes > LEAF_CACHE_BYTES && m_leafLru.size() > 1) {
+                auto last = m_leafDirs.find(m_leafLru.back());
+                m_leafBytes -= last->second.bytes;
+                m_leafDirs.erase(last);
+                m_leafLru.pop_back();
             }
-            return true;
         }
-        
-        // Tile not found in PMTiles archive
-        // Try next source in chain (e.g., network source for fallback)
-        if (next) {
-            return next->loadTileData(_task, _cb);
+    }
+    
+    for (auto& lookup : waiting) {
+        if (_entries) {
+            lookupTile(std::move(lookup), *_entries);
+        } else {
+            finishLookup(std::move(lookup), false);
         }
-        
-        // No tile data available from any source
-        // Note: Not calling task.cancel() here to allow for proper error handling upstream
-        if (_cb.func) {
-            _cb.func(_task);
+    }
+}
+
+void PMTilesDataSource::finishLookup(std::shared_ptr<Lookup> _lookup, bool _found) {
+    if (_found) {
+        // Successfully loaded tile from PMTiles archive
+        if (_lookup->cb.func) {
+            _lookup->cb.func(_lookup->task);
         }
+        return;
+    }
+    
+    // Tile not found in PMTiles archive
+    // Try next source in chain (e.g., network source for fallback)
+    if (next) {
+        next->loadTileData(_lookup->task, _lookup->cb);
+        return;
+    }
+    
+    // No tile data available from any source
+    // Note: Not calling task.cancel() here to allow for proper error handling upstream
+    if (_lookup->cb.func) {
+        _lookup->cb.func(_lookup->task);
+    }
+}
+
+bool PMTilesDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+    auto lookup = std::make_shared<Lookup>();
+    lookup->task = _task;
+    lookup->cb = _cb;
+    
+    // Convert tangram TileID (z, x, y) to PMTiles tile ID
+    // PMTiles uses a Hilbert curve encoding for efficient spatial indexing
+    const auto& tileId = _task->tileId();
+    try {
+        lookup->tileId = pmtiles::zxy_to_tileid(tileId.z, tileId.x, tileId.y);
+    } catch (const std::exception& e) {
+        LOGE("PMTiles: Invalid tile coordinates: z=%d, x=%d, y=%d: %s",
+             tileId.z, tileId.x, tileId.y, e.what());
+        if (next) { return next->loadTileData(_task, _cb); }
         return false;
-    });
+    }
+    
+    std::shared_ptr<const std::vector<pmtiles::entryv3>> rootDir;
+    bool startLoading = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_rootState == RootState::ready) {
+            lookup->header = m_header;
+            rootDir = m_rootDir;
+        } else {
+            // Wait for header and root directory, loaded once for all lookups
+            m_waiting.push_back(lookup);
+            startLoading = (m_rootState == RootState::none);
+            m_rootState = RootState::loading;
+        }
+    }
+    
+    if (rootDir) {
+        // Continue on the worker to avoid blocking the calling thread
+        m_worker->enqueue(_task, [this, lookup, rootDir]() {
+            auto prana = lookup->task->prana();
+            if (!prana) { return; }
+            lookupTile(lookup, *rootDir);
+        });
+    } else if (startLoading) {
+        loadRoot(_task);
+    }
     
     return true;
 }
 
+void PMTilesDataSource::cancelLoadingTile(TileTask& _task) {
+    auto& task = static_cast<BinaryTileTask&>(_task);
+    if (task.urlRequestHandle) {
+        // we expect callback to clear urlRequestHandle
+        m_platform.cancelUrlRequest(task.urlRequestHandle);
+    } else if (next) {
+        next->cancelLoadingTile(_task);
+    }
+}
+
 }
@@ -2,19 +2,23 @@
 
 #include "data/tileSource.h"
 #include <string>
+#include <functional>
+#include <list>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <mutex>
-#include <condition_variable>
 
 namespace pmtiles {
     struct headerv3;
+    struct entryv3;
 }
 
 namespace Tangram {
 
 class Platform;
-class AsyncWorker;
+class IOQueue;
+class MappedFile;
 
 /**
  * PMTilesDataSource provides tile data from PMTiles archives.
@@ -25,9 +29,16 @@ class AsyncWorker;
  * Features:
  * - Supports both local files and HTTP sources
  * - Uses HTTP range requests for efficient cloud storage access
+ * - Local files are memory-mapped once and read in place
  * - No SQLite dependency - simple binary format with hierarchical directory
- * - Automatic decompression (gzip supported)
- * - Thread-safe async I/O operations
+ * - Automatic decompression (gzip; zstd and brotli when built with
+ *   TANGRAM_USE_ZSTD / TANGRAM_USE_BROTLI)
+ * - Non-blocking lookups: header, directory and tile reads are chained through
+ *   completion callbacks, so that many tile lookups can be in flight at once
+ * - Parsed leaf directories are kept in an LRU cache; concurrent lookups of the
+ *   same leaf directory share a single read
+ * - HTTP reads of tiles requested together are merged into few range requests
+ *   when the tiles are close in the archive
  * 
  * Usage in scene YAML:
  *   sources:
@@ -56,6 +67,12 @@ public:
      */
     bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override;
 
+    /**
+     * Cancel the pending tile data request of a task (directory requests
+     * are shared between tasks and not canceled).
+     */
+    void cancelLoadingTile(TileTask& _task) override;
+
     /**
      * Clear cached data (header, directories)
      */
@@ -63,68 +80,179 @@ public:
 
 private:
     /**
-     * Read a range of bytes from the PMTiles file synchronously.
-     * For local files, uses standard file I/O.
-     * For HTTP sources, uses HTTP range requests (blocks until complete).
+     * State of a single tile lookup while it walks the directory tree.
+     */
+    struct Lookup;
+
+    /**
+     * Completion callback of readRange().
+     * @param _ok false if the range could not be read
+     * @param _data Bytes read, only valid during the callback; points into the
+     *        mapping for mapped local files
+     * @param _size Number of bytes, may be less than requested at end of file
+     */
+    using ReadCallback = std::function<void(bool _ok, const char* _data, size_t _size)>;
+
+    /**
+     * Read a range of bytes from the PMTiles file asynchronously.
+     * For local files, the read runs on the worker queue and returns a view
+     * into the mapped archive (or a buffer when it could not be mapped).
+     * For HTTP sources, a range request is started and its response is
+     * handed to the worker queue, so that no thread waits for the network.
      * @param offset Byte offset to start reading from
      * @param length Number of bytes to read
-     * @param data Output buffer for the read data
-     * @return true on success, false on failure
+     * @param _task Task whose Scene must be alive when @_cb runs
+     * @param _cb Invoked on the worker queue with the result
+     * @param _forTask true if only @_task needs the result: a local read is
+     *        then ordered by the task priority and dropped when it is canceled
+     * @return Handle of the URL request, 0 for local files
      */
-    bool readRangeSync(uint64_t offset, uint32_t length, std::vector<char>& data);
+    UrlRequestHandle readRange(uint64_t offset, uint32_t length,
+                               const std::shared_ptr<TileTask>& _task, ReadCallback _cb,
+                               bool _forTask = false);
     
     /**
-     * Get tile data for a specific tile ID.
-     * Traverses the PMTiles directory hierarchy to locate the tile.
-     * @param _tileId Tile identifier (z, x, y)
-     * @param _data Output buffer for tile data (decompressed)
-     * @return true if tile found and loaded, false otherwise
+     * Load header and root directory, then resume lookups waiting for them.
+     * The first request covers the start of the archive where writers place
+     * the root directory, so that usually one read is enough for both.
+     * @param _task Task which triggered loading
+     */
+    void loadRoot(const std::shared_ptr<TileTask>& _task);
+
+    /**
+     * Set result of loadRoot() and resume waiting lookups.
+     * @param _header Archive header, nullptr on failure
+     * @param _rootDir Root directory entries, nullptr on failure
+     */
+    void finishRoot(std::shared_ptr<const pmtiles::headerv3> _header,
+                    std::shared_ptr<const std::vector<pmtiles::entryv3>> _rootDir);
+
+    /**
+     * Continue a lookup in a directory: read the tile data or the leaf
+     * directory for the tile.
+     * @param _lookup Tile lookup
+     * @param _entries Deserialized directory
+     */
+    void lookupTile(std::shared_ptr<Lookup> _lookup, const std::vector<pmtiles::entryv3>& _entries);
+
+    /**
+     * Decompress tile data read for a lookup and complete it.
+     * @param _lookup Tile lookup
+     * @param _offset Offset of the tile data, for logging
+     * @param _ok false if the tile data could not be read
+     * @param _compressed Tile data as stored in the archive
+     * @param _size Size of tile data
+     */
+    void finishTile(const std::shared_ptr<Lookup>& _lookup, uint64_t _offset,
+                    bool _ok, const char* _compressed, size_t _size);
+
+    /**
+     * Collect an HTTP tile read for a short time, so that it can be merged
+     * with reads of neighboring tiles by flushTileReads().
+     * @param _lookup Tile lookup
+     * @param _offset Offset of the tile data in the archive
+     * @param _length Length of the tile data
+     */
+    void queueTileRead(std::shared_ptr<Lookup> _lookup, uint64_t _offset, uint32_t _length);
+
+    /**
+     * Start range requests for collected tile reads; tiles separated by small
+     * gaps share one request and each gets its slice of the response.
      */
-    bool getTileData(const TileID& _tileId, std::vector<char>& _data);
+    void flushTileReads();
+
+    /**
+     * Continue a lookup in the leaf directory at @_offset, reading it unless it
+     * is cached or already being read by another lookup.
+     * @param _lookup Tile lookup
+     * @param _offset Offset of the leaf directory in the archive
+     * @param _length Length of the compressed leaf directory
+     */
+    void lookupLeaf(std::shared_ptr<Lookup> _lookup, uint64_t _offset, uint32_t _length);
+
+    /**
+     * Cache a leaf directory read by lookupLeaf() and resume the lookups waiting for it.
+     * @param _offset Offset of the leaf directory in the archive
+     * @param _entries Leaf directory entries, nullptr on failure
+     */
+    void finishLeaf(uint64_t _offset, std::shared_ptr<const std::vector<pmtiles::entryv3>> _entries);
+
+    /**
+     * Complete a lookup: invoke the task callback when tile data was found,
+     * otherwise try the next source in chain.
+     * @param _lookup Tile lookup
+     * @param _found true if tile data was set on the task
+     */
+    void finishLookup(std::shared_ptr<Lookup> _lookup, bool _found);
     
     /**
      * Decompress data based on compression type.
      * @param compressed Input compressed data
+     * @param size Size of input data
      * @param decompressed Output decompressed data
      * @param compression Compression type (COMPRESSION_NONE, COMPRESSION_GZIP, etc.)
      * @return true on success, false on failure
      */
-    bool decompress(const std::vector<char>& compressed, std::vector<char>& decompressed, uint8_t compression);
-    
-    /**
-     * Load and parse the PMTiles header (first 127 bytes).
-     * Caches the header for subsequent calls.
-     * @return true on success, false on failure
-     */
-    bool loadHeader();
-    
+    bool decompress(const char* compressed, size_t size, std::vector<char>& decompressed, uint8_t compression);
+
     /**
-     * Load and decompress a directory from the PMTiles file.
-     * @param offset Byte offset of the directory
-     * @param length Length of the compressed directory data
-     * @param data Output buffer for decompressed directory data
+     * Decompress and deserialize a directory.
+     * @param compressed Directory data as stored in the archive
+     * @param size Size of directory data
+     * @param compression Internal compression type of the archive
+     * @param entries Output directory entries
      * @return true on success, false on failure
      */
-    bool loadDirectory(uint64_t offset, uint32_t length, std::vector<char>& data);
+    bool parseDirectory(const char* compressed, size_t size, uint8_t compression,
+                        std::vector<pmtiles::entryv3>& entries);
+
+    enum class RootState { none, loading, ready };
 
     Platform& m_platform;
     std::string m_path;
     bool m_isHttp;  // true if path is HTTP/HTTPS URL
-    
-    // Cached header (loaded on first access, access should be serialized via loadHeader())
-    // Note: Access to m_header should be done carefully in multi-threaded context
-    std::unique_ptr<pmtiles::headerv3> m_header;
-    
-    // Worker thread for async I/O operations
-    std::unique_ptr<AsyncWorker> m_worker;
+
+    // Mapping of a local archive, not open if mapping failed
+    std::unique_ptr<MappedFile> m_file;
     
     // Mutex for thread-safe access to cached data
     std::mutex m_mutex;
     
-    // Cache for root directory (speeds up tile lookups)
-    // Protected by m_mutex
-    std::vector<char> m_rootDirCache;
-    bool m_rootDirCached;
+    // Header and root directory, immutable once loaded so that lookups can
+    // use them without holding m_mutex. Protected by m_mutex.
+    std::shared_ptr<const pmtiles::headerv3> m_header;
+    std::shared_ptr<const std::vector<pmtiles::entryv3>> m_rootDir;
+    RootState m_rootState;
+
+    // Lookups waiting for header and root directory. Protected by m_mutex.
+    std::vector<std::shared_ptr<Lookup>> m_waiting;
+
+    // Leaf directory cache entry; @entries is null while the directory is read
+    struct LeafDir {
+        std::shared_ptr<const std::vector<pmtiles::entryv3>> entries;
+        std::vector<std::shared_ptr<Lookup>> waiting;  // lookups waiting for the read
+        std::list<uint64_t>::iterator lru;             // position in m_leafLru once read
+        size_t bytes = 0;
+    };
+
+    // Leaf directories by offset, with least recently used last in m_leafLru.
+    // Protected by m_mutex.
+    std::unordered_map<uint64_t, LeafDir> m_leafDirs;
+    std::list<uint64_t> m_leafLru;
+    size_t m_leafBytes;
+
+    // HTTP tile reads collected for merging. Protected by m_mutex.
+    struct TileRead {
+        std::shared_ptr<Lookup> lookup;
+        uint64_t offset;
+        uint32_t length;
+    };
+    std::vector<TileRead> m_tileReads;
+    bool m_tileReadsScheduled;  // flushTileReads() is queued
+
+    // Serial queue on the shared I/O threads for file reads and processing of
+    // responses. Declared last so that it is stopped before other members are destroyed.
+    std::unique_ptr<IOQueue> m_worker;
 };
 
 }
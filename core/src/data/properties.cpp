@@ -1,5 +1,6 @@
 #include "data/propertyItem.h"
 #include "data/properties.h"
+#include "util/internTable.h"
 #include "rapidjson/writer.h"
 #include <algorithm>
 #include <cmath>
@@ -17,24 +18,124 @@ std::string doubleToString(double _doubleValue) {
     return value;
 }
 
+void PropertyTable::findAtoms() {
+    std::vector<const std::string*> strings;
+    strings.reserve(keys.size() + values.size());
+    for (const auto& key : keys) { strings.push_back(&key); }
+    for (const auto& value : values) {
+        strings.push_back(value.is<std::string>() ? &value.get<std::string>() : nullptr);
+    }
+
+    std::vector<uint32_t> atoms;
+    InternTable::find(strings, atoms);
+
+    keyAtoms.assign(atoms.begin(), atoms.begin() + keys.size());
+    valueAtoms.assign(atoms.begin() + keys.size(), atoms.end());
+}
+
+// Heap bytes of a string beyond the short string buffer
+static size_t stringBytes(const std::string& _string) {
+    return _string.capacity() > 15 ? _string.capacity() + 1 : 0;
+}
+
+static size_t valueBytes(const Value& _value) {
+    return _value.is<std::string>() ? stringBytes(_value.get<std::string>()) : 0;
+}
+
+size_t PropertyTable::memoryUsage() const {
+    size_t bytes = keys.capacity() * sizeof(std::string) + values.capacity() * sizeof(Value);
+    for (const auto& key : keys) { bytes += stringBytes(key); }
+    for (const auto& value : values) { bytes += valueBytes(value); }
+
+    // hash nodes of keyIds hold a copy of each key
+    bytes += keyIds.bucket_count() * sizeof(void*);
+    for (const auto& entry : keyIds) {
+        bytes += sizeof(entry) + 2 * sizeof(void*) + stringBytes(entry.first);
+    }
+    bytes += (keyAtoms.capacity() + valueAtoms.capacity()) * sizeof(uint32_t);
+    return bytes;
+}
+
 Properties::Properties() : sourceId(0) {}
 
 Properties::Properties(std::vector<Item>&& _items) : sourceId(0), props(_items) {}
 
 Properties::~Properties() {}
 
+// Items of properties with @_items or with @_tags of @_table; leaves the source as it is, so
+// that properties can be copied concurrently
+static std::vector<PropertyItem> copyItems(const std::vector<PropertyItem>& _items, const PropertyTable* _table,
+                                           const std::vector<std::pair<uint32_t, uint32_t>>& _tags) {
+    if (!_table) { return _items; }
+
+    std::vector<PropertyItem> items;
+    items.reserve(_tags.size());
+    for (const auto& tag : _tags) {
+        items.emplace_back(_table->keys[tag.first], _table->values[tag.second]);
+    }
+    return items;
+}
+
+Properties::Properties(const Properties& _other) :
+    sourceId(_other.sourceId),
+    props(copyItems(_other.props, _other.m_table.get(), _other.m_tags)) {}
+
+Properties& Properties::operator=(const Properties& _other) {
+    if (this != &_other) {
+        props = copyItems(_other.props, _other.m_table.get(), _other.m_tags);
+        m_table.reset();
+        m_tags.clear();
+        sourceId = _other.sourceId;
+    }
+    return *this;
+}
+
 Properties& Properties::operator=(Properties&& _other) {
     props = std::move(_other.props);
+    m_table = std::move(_other.m_table);
+    m_tags = std::move(_other.m_tags);
     sourceId = _other.sourceId;
     return *this;
 }
 
 void Properties::setSorted(std::vector<Item>&& _items) {
     props = std::move(_items);
+    m_table.reset();
+    m_tags.clear();
+}
+
+void Properties::setTable(std::shared_ptr<const PropertyTable> _table,
+                          std::vector<std::pair<uint32_t, uint32_t>>&& _tags) {
+    props.clear();
+    m_table = std::move(_table);
+    m_tags = std::move(_tags);
+}
+
+void Properties::resolve() const {
+    if (!m_table) { return; }
+
+    props = copyItems(props, m_table.get(), m_tags);
+    m_table.reset();
+    m_tags.clear();
+}
+
+const std::vector<Properties::Item>& Properties::items() const {
+    resolve();
+    return props;
 }
 
 const Value& Properties::get(const std::string& key) const {
 
+    if (m_table) {
+        auto id = m_table->keyIds.find(key);
+        if (id == m_table->keyIds.end()) { return NOT_A_VALUE; }
+
+        for (const auto& tag : m_tags) {
+            if (tag.first == id->second) { return m_table->values[tag.second]; }
+        }
+        return NOT_A_VALUE;
+    }
+
     const auto it = std::find_if(props.begin(), props.end(),
                                  [&](const auto& item) {
                                      return item.key == key;
@@ -54,7 +155,36 @@ const Value& Properties::get(const std::string& key) const {
     return it->value;
 }
 
-void Properties::clear() { props.clear(); }
+const Value& Properties::get(const std::string& key, uint32_t keyAtom, uint32_t* valueAtom) const {
+
+    if (valueAtom) { *valueAtom = InternTable::NONE; }
+
+    if (m_table && keyAtom != InternTable::NONE && m_table->keyAtoms.size() == m_table->keys.size()) {
+        for (const auto& tag : m_tags) {
+            if (m_table->keyAtoms[tag.first] == keyAtom) {
+                if (valueAtom) { *valueAtom = m_table->valueAtoms[tag.second]; }
+                return m_table->values[tag.second];
+            }
+        }
+        return NOT_A_VALUE;
+    }
+
+    return get(key);
+}
+
+size_t Properties::memoryUsage() const {
+    size_t bytes = props.capacity() * sizeof(Item) + m_tags.capacity() * sizeof(m_tags[0]);
+    for (const auto& item : props) {
+        bytes += stringBytes(item.key) + valueBytes(item.value);
+    }
+    return bytes;
+}
+
+void Properties::clear() {
+    props.clear();
+    m_table.reset();
+    m_tags.clear();
+}
 
 bool Properties::contains(const std::string& key) const {
     return !get(key).is<none_type>();
@@ -124,11 +254,14 @@ std::string Properties::getAsString(const std::string& key) const {
 }
 
 void Properties::sort() {
+    resolve();
     std::sort(props.begin(), props.end());
 }
 
 void Properties::setValue(std::string key, Value value) {
 
+    resolve();
+
     auto it = std::lower_bound(props.begin(), props.end(), key,
         [](auto& item, auto& key) { return keyComparator(item.key, key); });
 
@@ -152,7 +285,7 @@ std::string Properties::toJson() const {
     rapidjson::StringBuffer sb;
     rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
     writer.StartObject();
-    for (const auto& item : props) {
+    for (const auto& item : items()) {
         writer.String(item.key.c_str());
         if (item.value.is<std::string>()) {
             writer.String(item.value.get<std::string>().c_str());
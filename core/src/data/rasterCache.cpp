@@ -0,0 +1,138 @@
+#include "data/rasterCache.h"
+
+#include "gl/texture.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace Tangram {
+
+std::shared_ptr<Texture> RasterCache::get(TileID _tileId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key(_tileId));
+    if (it == m_entries.end() || !it->second.texture) { return nullptr; }
+    it->second.lastUse = ++m_useCounter;
+    return it->second.texture;
+}
+
+std::shared_ptr<Texture> RasterCache::acquire(TileID _tileId, bool& _claimed) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    TileID id = key(_tileId);
+    _claimed = false;
+
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) {
+        // Null texture marks the tile as being decoded
+        m_entries.emplace(id, Entry{});
+        _claimed = true;
+        return nullptr;
+    }
+
+    m_decoded.wait(lock, [&]() {
+        it = m_entries.find(id);
+        return it == m_entries.end() || it->second.texture;
+    });
+    if (it == m_entries.end()) { return nullptr; }
+    it->second.lastUse = ++m_useCounter;
+    return it->second.texture;
+}
+
+std::shared_ptr<Texture> RasterCache::put(TileID _tileId, std::unique_ptr<Texture> _texture, bool* _added) {
+    std::shared_ptr<Texture> texture;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& entry = m_entries[key(_tileId)];
+        if (_added) { *_added = !entry.texture; }
+        entry.lastUse = ++m_useCounter;
+        if (!entry.texture) {
+            entry.texture = std::move(_texture);
+            entry.bytes = entry.texture->bufferSize();
+            m_bytes += entry.bytes;
+        }
+        texture = entry.texture;
+        evict(m_maxUnusedBytes);
+    }
+    m_decoded.notify_all();
+    return texture;
+}
+
+void RasterCache::cancel(TileID _tileId) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key(_tileId));
+        if (it != m_entries.end() && !it->second.texture) { m_entries.erase(it); }
+    }
+    m_decoded.notify_all();
+}
+
+void RasterCache::evict(size_t _maxUnusedBytes) {
+    // Textures referenced only by the cache are not in use by any tile
+    std::vector<std::map<TileID, Entry>::iterator> unused;
+    size_t unusedBytes = 0;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->second.texture && it->second.texture.use_count() == 1) {
+            unused.push_back(it);
+            unusedBytes += it->second.bytes;
+        }
+    }
+    if (unusedBytes <= _maxUnusedBytes) { return; }
+
+    std::sort(unused.begin(), unused.end(),
+              [](const auto& a, const auto& b) { return a->second.lastUse < b->second.lastUse; });
+    for (auto it : unused) {
+        if (unusedBytes <= _maxUnusedBytes) { break; }
+        unusedBytes -= it->second.bytes;
+        m_bytes -= it->second.bytes;
+        m_entries.erase(it);
+    }
+}
+
+void RasterCache::trim(size_t _bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evict(_bytes);
+}
+
+void RasterCache::setMaxUnusedBytes(size_t _bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxUnusedBytes = _bytes;
+    evict(m_maxUnusedBytes);
+}
+
+size_t RasterCache::bytes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+size_t RasterCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+bool RasterCache::zoomRange(int& _minZoom, int& _maxZoom) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto first = std::find_if(m_entries.begin(), m_entries.end(), [](auto& e) { return bool(e.second.texture); });
+    if (first == m_entries.end()) { return false; }
+    auto last = std::find_if(m_entries.rbegin(), m_entries.rend(), [](auto& e) { return bool(e.second.texture); });
+    _maxZoom = first->first.z;
+    _minZoom = last->first.z;
+    return true;
+}
+
+void RasterCache::forEach(const std::function<void(const TileID&, const Texture&)>& _fn) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_entries) {
+        if (entry.second.texture) { _fn(entry.first, *entry.second.texture); }
+    }
+}
+
+void RasterCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Keep the claims of decoding threads
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.texture) { it = m_entries.erase(it); }
+        else { ++it; }
+    }
+    m_bytes = 0;
+}
+
+}
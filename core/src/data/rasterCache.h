@@ -0,0 +1,84 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Tangram {
+
+class Texture;
+
+/*
+ * RasterCache - Decoded raster textures by tile, shared by the tile workers and the main thread
+ *
+ * Textures stay cached while tiles use them and after their last use, in least recently used
+ * order, until the bytes of the unused ones exceed the budget. A texture being decoded is claimed
+ * by one worker: others asking for the same tile wait for it instead of decoding it again.
+ *
+ * Thread-safe. Tile IDs are keyed without their styling zoom.
+ */
+class RasterCache {
+
+public:
+
+    explicit RasterCache(size_t _maxUnusedBytes = 8 << 20) : m_maxUnusedBytes(_maxUnusedBytes) {}
+
+    /* Cached texture of @_tileId, or null */
+    std::shared_ptr<Texture> get(TileID _tileId);
+
+    /* Cached texture of @_tileId, waiting while another thread decodes it. Returns null with
+     * @_claimed set when the caller is to decode it and then call put() or cancel() */
+    std::shared_ptr<Texture> acquire(TileID _tileId, bool& _claimed);
+
+    /* Add the texture of @_tileId and return the cached one, which is the texture of another thread
+     * if it was first. @_added is set when the texture was added */
+    std::shared_ptr<Texture> put(TileID _tileId, std::unique_ptr<Texture> _texture, bool* _added = nullptr);
+
+    /* Give up the claim on @_tileId from acquire(); waiting threads get null */
+    void cancel(TileID _tileId);
+
+    /* Drop unused textures, least recently used first, until at most @_bytes of them are left */
+    void trim(size_t _bytes);
+
+    void setMaxUnusedBytes(size_t _bytes);
+    size_t maxUnusedBytes() const { return m_maxUnusedBytes; }
+
+    /* Bytes of all cached textures, used or not */
+    size_t bytes() const;
+    size_t size() const;
+
+    /* Range of zooms of the cached textures; false if there are none */
+    bool zoomRange(int& _minZoom, int& _maxZoom) const;
+
+    void forEach(const std::function<void(const TileID&, const Texture&)>& _fn) const;
+
+    void clear();
+
+private:
+
+    struct Entry {
+        std::shared_ptr<Texture> texture;  // null while being decoded
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+
+    static TileID key(TileID _tileId) { return TileID(_tileId.x, _tileId.y, _tileId.z); }
+
+    // With m_mutex locked
+    void evict(size_t _maxUnusedBytes);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_decoded;
+    // Ordered by zoom, highest first
+    std::map<TileID, Entry> m_entries;
+    size_t m_bytes = 0;
+    uint64_t m_useCounter = 0;
+    size_t m_maxUnusedBytes;
+};
+
+}
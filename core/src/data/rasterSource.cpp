@@ -4,7 +4,9 @@
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
 #include "tile/tileTask.h"
+#include "util/elevationManager.h"
 #include "util/mapProjection.h"
+#include "util/objectPool.h"
 #include "log.h"
 
 namespace Tangram {
@@ -14,8 +16,9 @@ public:
 
     const bool subTask = false;
 
-    std::unique_ptr<Texture> texture;
     std::unique_ptr<Raster> raster;
+    // Whether the texture was decoded by this task rather than taken from the cache
+    bool decoded = false;
 
     RasterTileTask(const TileID& _tileId, TileSource* _source, bool _subTask)
         : BinaryTileTask(_tileId, _source),
@@ -28,46 +31,65 @@ public:
 
     bool hasData() const override {
         // probably should be "return BinaryTileTask::hasData() || ..."
-        return bool(rawTileData) || bool(texture) || bool(raster);
+        return bool(rawTileData) || bool(raster);
     }
 
-    void process(TileBuilder& _tileBuilder) override {
+    void parse() override {
         auto source = rasterSource();
         assert(!m_ready);  // shared task previously could be erroneously added to tile worker queue twice
 
-        if (!texture && !raster) {
-            // Decode texture data
-            texture = source->createTexture(m_tileId, *rawTileData);
-            if (!texture) {
+        if (!raster) {
+            // Take the texture from the cache, waiting if another worker is decoding it for another tile
+            bool claimed = false;
+            auto texture = source->m_textures.acquire(m_tileId, claimed);
+            if (claimed) {
+                auto decodedTexture = source->createTexture(m_tileId, *rawTileData);
+                if (decodedTexture) {
+                    texture = source->m_textures.put(m_tileId, std::move(decodedTexture), &decoded);
+                } else {
+                    source->m_textures.cancel(m_tileId);
+                }
+            }
+            if (texture) {
+                raster = std::make_unique<Raster>(m_tileId, texture);
+            } else {
                 // cancel on decode failure to match behavior of TileTask (and behavior for download failure)
                 //  empty texture will be set in addRaster() if no proxy available
-                //raster = std::make_unique<Raster>(m_tileId, source->emptyTexture());
                 cancel();
-                return;
             }
         }
+        m_parsed = true;
+    }
+
+    void build(TileBuilder& _tileBuilder) override {
+        auto source = rasterSource();
 
         // Create tile geometries
         if (!subTask) {
-          // make raster available for tile builder; RasterSource texture cache is not thread-safe currently
-          //  so we can't add raster for good until complete() on main thread; note the empty deleter since
-          //  shared_ptr doesn't have a release() method
-          auto ptex = raster ? raster->texture : std::shared_ptr<Texture>(texture.get(), [](auto* t){});
+          // make raster available for tile builder; it is added for good in complete() on main thread
           m_tile = std::make_unique<Tile>(m_tileId, source->id(), source->generation());
-          m_tile->rasters().emplace_back(m_tileId, ptex);
-          _tileBuilder.build(*m_tile, *(source->m_tileData), *source);
+          m_tile->rasters().emplace_back(m_tileId, raster->texture);
+          bool done = _tileBuilder.build(*m_tile, *(source->m_tileData), *source, this);
           m_tile->rasters().pop_back();
+          if (!done) {
+              m_tile.reset();
+              return;
+          }
         }
         m_ready = true;
     }
 
-    void addRaster(Tile& _tile) {
+    Raster completeRaster() {
         auto source = rasterSource();
-        if (!raster) {
-          auto tex = source->cacheTexture(m_tileId, std::move(texture));
-          raster = std::make_unique<Raster>(m_tileId, tex);
+        if (decoded && source->m_onTextureCached) {
+            source->m_onTextureCached(TileID(m_tileId.x, m_tileId.y, m_tileId.z), *raster->texture);
+            decoded = false;
         }
-        _tile.rasters().emplace_back(raster->tileID, raster->texture);
+        return Raster(raster->tileID, raster->texture);
+    }
+
+    void addRaster(Tile& _tile) {
+        _tile.rasters().push_back(completeRaster());
     }
 
     void complete() override {
@@ -97,7 +119,6 @@ RasterSource::RasterSource(const std::string& _name, std::unique_ptr<DataSource>
     : TileSource(_name, std::move(_sources), _zoomOptions),
       m_texOptions(_options) {
 
-    m_textures = std::make_shared<Cache>();
     m_emptyTexture = std::make_shared<Texture>(m_texOptions);
 
     GLubyte pixel[4] = { 0, 0, 0, 0 };
@@ -111,13 +132,13 @@ void RasterSource::generateGeometry(bool _generateGeometry) {
     if (m_generateGeometry) {
         Feature rasterFeature;
         rasterFeature.geometryType = GeometryType::polygons;
-        rasterFeature.polygons = { { {
+        rasterFeature.addPolygon({ {
                     {0.0f, 0.0f},
                     {1.0f, 0.0f},
                     {1.0f, 1.0f},
                     {0.0f, 1.0f},
                     {0.0f, 0.0f}
-                } } };
+                } });
         rasterFeature.props = Properties();
 
         m_tileData = std::make_shared<TileData>();
@@ -132,10 +153,58 @@ std::unique_ptr<Texture> RasterSource::createTexture(TileID _tile, const std::ve
     auto data = reinterpret_cast<const uint8_t*>(_rawTileData.data());
     auto length = _rawTileData.size();
     auto tex = std::make_unique<Texture>(m_texOptions, !m_keepTextureData);
-    if (!tex->loadImageFromMemory(data, length)) { tex.reset(); }
+    if (!tex->loadImageFromMemory(data, length)) { return nullptr; }
+    if (m_normalMap) { return createNormalMap(_tile, *tex); }
+    // Texture data kept for sampling on the CPU must stay uncompressed
+    if (m_compressTextures && !m_keepTextureData) { tex->compress(); }
+    // Decode elevation once here on the worker instead of per sample
+    if (m_keepTextureData) { ElevationManager::decodeElevation(*tex); }
+    // Deflate the copy for GL context loss here rather than on upload
+    else { tex->retainData(); }
     return tex;
 }
 
+std::unique_ptr<Texture> RasterSource::createNormalMap(TileID _tile, Texture& _elevation) {
+    ElevationManager::decodeElevation(_elevation);
+    std::vector<float> buffer;
+    const float* grid = ElevationManager::elevationGrid(_elevation, buffer);
+    if (!grid) {
+        LOGW("Unsupported elevation format for normal map of %s", _tile.toString().c_str());
+        return nullptr;
+    }
+
+    int width = _elevation.width(), height = _elevation.height();
+    auto edges = std::make_shared<const ElevationEdges>(grid, width, height);
+    auto neighbors = m_normalEdges.add(_tile, edges);
+
+    std::vector<uint8_t> pixels(size_t(width) * height * 4);
+    computeNormalMap(grid, width, height, _tile, neighbors, pixels.data());
+
+    TextureOptions options = m_texOptions;
+    options.pixelFormat = PixelFormat::RGBA;
+    auto normals = std::make_unique<Texture>(options, !m_keepTextureData);
+    if (!normals->setPixelData(width, height, 4, pixels.data(), pixels.size())) { return nullptr; }
+    if (m_compressTextures && !m_keepTextureData) { normals->compress(); }
+    if (!m_keepTextureData) { normals->retainData(); }
+    // Neighbors loaded later find the edges while the tile is in use
+    normals->userData = std::const_pointer_cast<ElevationEdges>(edges);
+    return normals;
+}
+
+void RasterSource::setNormalMap(bool _normalMap) {
+    m_normalMap = _normalMap;
+    m_normalEdges.clear();
+
+    // Missing tiles are flat
+    TextureOptions options = m_texOptions;
+    if (m_normalMap) { options.pixelFormat = PixelFormat::RGBA; }
+    m_emptyTexture = std::make_shared<Texture>(options);
+    GLubyte pixel[4] = { 0, 0, 0, 0 };
+    if (m_normalMap) { pixel[0] = 128; pixel[1] = 128; pixel[2] = 255; pixel[3] = 255; }
+    auto bpp = options.bytesPerPixel();
+    m_emptyTexture->setPixelData(1, 1, bpp, pixel, bpp);
+}
+
 std::shared_ptr<TileData> RasterSource::parse(const TileTask& _task) const {
     assert(false);
     return nullptr;
@@ -161,23 +230,16 @@ void RasterSource::addRasterTask(TileTask& _task) {
 }
 
 std::shared_ptr<RasterTileTask> RasterSource::createRasterTask(TileID _tileId, bool subTask) {
-    auto task = std::make_shared<RasterTileTask>(_tileId, this, subTask);
+    auto task = m_taskPool->make<RasterTileTask>(_tileId, this, subTask);
 
     // First try existing textures cache
-    TileID id(_tileId.x, _tileId.y, _tileId.z);
-
-    auto texIt = m_textures->find(id);
-    if (texIt != m_textures->end()) {
-        auto texture = texIt->second.lock();
-
-        if (texture) {
-            LOGV("%d - reuse %s", m_textures->size(), id.toString().c_str());
+    if (auto texture = m_textures.get(_tileId)) {
+        LOGV("%d - reuse %s", m_textures.size(), _tileId.toString().c_str());
 
-            task->raster = std::make_unique<Raster>(id, texture);
-            // No more loading needed.
-            task->startedLoading();
-            if (subTask) { task->setReady(); }
-        }
+        task->raster = std::make_unique<Raster>(TileID(_tileId.x, _tileId.y, _tileId.z), texture);
+        // No more loading needed.
+        task->startedLoading();
+        if (subTask) { task->setReady(); }
     }
     return task;
 }
@@ -190,43 +252,27 @@ std::shared_ptr<TileTask> RasterSource::createTask(TileID _tileId) {
     return task;
 }
 
-std::shared_ptr<Texture> RasterSource::cacheTexture(const TileID& _tileId, std::unique_ptr<Texture> _texture) {
-    assert(_texture && _texture->bufferSize() > 0 && _texture.get() != m_emptyTexture.get());
-    TileID id(_tileId.x, _tileId.y, _tileId.z);
-
-    auto& textureEntry = (*m_textures)[id];
-    auto texture = textureEntry.lock();
-    if (texture) {
-        LOGV("%d - drop duplicate %s", m_textures->size(), id.toString().c_str());
-        // The same texture has been loaded in the meantime: Reuse it and drop _texture..
-        return texture;
-    }
-
-    texture = std::shared_ptr<Texture>(_texture.release(),
-                                       [c = std::weak_ptr<Cache>(m_textures), id](auto* t) {
-                                           if (auto cache = c.lock()) {
-                                               cache->erase(id);
-                                               LOGV("%d - remove %s", cache->size(), id.toString().c_str());
-                                           }
-                                           delete t;
-                                       });
-    // Add to cache
-    textureEntry = texture;
-    LOGV("%d - added %s", m_textures->size(), id.toString().c_str());
+std::shared_ptr<Texture> RasterSource::getTexture(TileID _tile) {
+    return m_textures.get(_tile);
+}
 
-    return texture;
+size_t RasterSource::textureBufferUsage() const {
+    size_t bytes = 0;
+    m_textures.forEach([&](const TileID&, const Texture& _texture) { bytes += _texture.cpuBufferSize(); });
+    return bytes;
 }
 
-std::shared_ptr<Texture> RasterSource::getTexture(TileID _tile) {
-    auto texIt = m_textures->find(_tile);
-    return texIt != m_textures->end() ? texIt->second.lock() : nullptr;
+int RasterSource::maxCachedZoom() const {
+    int minZoom = 0, maxZoom = -1;
+    m_textures.zoomRange(minZoom, maxZoom);
+    return maxZoom;
 }
 
 Raster RasterSource::getRaster(ProjectedMeters _meters) {
-    if (m_textures->empty()) { return Raster(NOT_A_TILE, nullptr); }
+    int minz = 0, maxz = 0;
+    if (!m_textures.zoomRange(minz, maxz)) { return Raster(NOT_A_TILE, nullptr); }
 
-    TileID tileId = MapProjection::projectedMetersTile(_meters, m_textures->begin()->first.z);
-    auto minz = m_textures->rbegin()->first.z;
+    TileID tileId = MapProjection::projectedMetersTile(_meters, maxz);
     do {
         auto tex = getTexture(tileId);
         if(tex) { return Raster(tileId, tex); }
@@ -236,4 +282,19 @@ Raster RasterSource::getRaster(ProjectedMeters _meters) {
     return Raster(NOT_A_TILE, nullptr);
 }
 
+Raster RasterSource::getAncestorRaster(TileID _tile, int _maxDepth) {
+    TileID tileId(_tile.x, _tile.y, _tile.z);
+    for (int depth = 0; depth < _maxDepth && tileId.z > 0; depth++) {
+        tileId = tileId.getParent();
+        if (auto tex = getTexture(tileId)) { return Raster(tileId, tex); }
+    }
+    return Raster(NOT_A_TILE, nullptr);
+}
+
+Raster RasterSource::takeRaster(TileTask& _task) {
+    auto& task = static_cast<RasterTileTask&>(_task);
+    if (!task.isReady() || !task.raster) { return Raster(NOT_A_TILE, nullptr); }
+    return task.completeRaster();
+}
+
 }
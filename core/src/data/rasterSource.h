@@ -1,14 +1,14 @@
 #pragma once
 
+#include "data/rasterCache.h"
 #include "data/tileSource.h"
 #include "gl/texture.h"
 #include "tile/tileTask.h"
 #include "tile/tileHash.h"
 #include "util/mapProjection.h"
+#include "util/normalMap.h"
 
 #include <functional>
-#include <map>
-#include <mutex>
 
 namespace Tangram {
 
@@ -16,13 +16,16 @@ class RasterTileTask;
 
 class RasterSource : public TileSource {
 
-    using Cache = std::map<TileID, std::weak_ptr<Texture>>;
-    std::shared_ptr<Cache> m_textures;
+    // Decoded textures, shared by the tiles that use them and looked up by the workers
+    RasterCache m_textures;
 
     TextureOptions m_texOptions;
 
     std::shared_ptr<Texture> m_emptyTexture;
 
+    bool m_normalMap = false;
+    ElevationEdgeCache m_normalEdges;
+
     friend class RasterTileTask;
     friend class TileSource;
     friend class FrameInfo;
@@ -37,12 +40,19 @@ protected:
 
     std::unique_ptr<Texture> createTexture(TileID _tile, const std::vector<char>& _rawTileData);
 
-    std::shared_ptr<Texture> cacheTexture(const TileID& _tileId, std::unique_ptr<Texture> _texture);
+    std::unique_ptr<Texture> createNormalMap(TileID _tile, Texture& _elevation);
+
 
 public:
 
     bool m_keepTextureData = false;
 
+    // Encode decoded tiles to a compressed texture format on the worker, see Texture::compress()
+    bool m_compressTextures = false;
+
+    // Called on the main thread when a tile is completed with a texture that was decoded for it
+    std::function<void(const TileID&, const Texture&)> m_onTextureCached;
+
     RasterSource(const std::string& _name, std::unique_ptr<DataSource> _sources,
                  TextureOptions _options, TileSource::ZoomOptions _zoomOptions = {});
 
@@ -53,6 +63,17 @@ public:
 
     Raster getRaster(ProjectedMeters _meters);
 
+    /* Nearest cached ancestor of @_tile, at most @_maxDepth zooms up, to show in place of @_tile while
+     * it is loading; texture is null if there is none */
+    Raster getAncestorRaster(TileID _tile, int _maxDepth);
+
+    /* Raster of the ready sub-task @_task of this source, for a tile that was completed before it;
+     * texture is null if the task is not ready */
+    Raster takeRaster(TileTask& _task);
+
+    /* Highest zoom of the cached textures, -1 if there are none */
+    int maxCachedZoom() const;
+
     std::shared_ptr<TileTask> createTask(TileID _tile) override;
 
     bool isRaster() const override { return true; }
@@ -61,6 +82,25 @@ public:
 
     std::shared_ptr<Texture> emptyTexture() { return m_emptyTexture; }
 
+    /* Replace the elevation tiles of this source by their normal maps (see computeNormalMap()), built
+     * on the workers so that hillshading needs a single texture fetch instead of sampling neighbors */
+    void setNormalMap(bool _normalMap);
+    bool normalMap() const { return m_normalMap; }
+
+    /* Bytes of GPU memory held by the cached textures of this source, in use or not */
+    size_t textureMemoryUsage() const { return m_textures.bytes(); }
+
+    /* Bytes of pixel data kept on the CPU by the cached textures, see Texture::cpuBufferSize() */
+    size_t textureBufferUsage() const;
+
+    /* Keep at most @_bytes of textures that no tile uses, for tiles that are loaded again */
+    void setTextureCacheSize(size_t _bytes) { m_textures.setMaxUnusedBytes(_bytes); }
+
+    /* Drop unused textures down to @_bytes, e.g. on memory warnings */
+    void trimTextureCache(size_t _bytes) { m_textures.trim(_bytes); }
+
+    const RasterCache& textureCache() const { return m_textures; }
+
 };
 
 }
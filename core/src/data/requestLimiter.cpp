@@ -0,0 +1,190 @@
+#include "data/requestLimiter.h"
+
+#include "tile/tileTask.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#define INITIAL_LIMIT 6
+#define MIN_LIMIT 2
+#define MAX_LIMIT 32
+// multiplicative decrease on congestion
+#define DECREASE_FACTOR 0.75f
+// response times up to this factor above the lowest seen count as not congested
+#define RTT_TOLERANCE 2.0
+// throughput gain needed to accept higher response times
+#define THROUGHPUT_GAIN 1.1
+#define MIN_WINDOW_SECONDS 0.25
+#define MIN_WINDOW_SAMPLES 2
+// growth of the lowest response time per window
+#define MIN_RTT_DECAY 1.02
+
+namespace Tangram {
+
+static std::mutex s_limitersMutex;
+static std::unordered_map<std::string, std::shared_ptr<RequestLimiter>> s_limiters;
+
+std::shared_ptr<RequestLimiter> RequestLimiter::forHost(const std::string& _host) {
+    std::lock_guard<std::mutex> lock(s_limitersMutex);
+    auto& limiter = s_limiters[_host];
+    if (!limiter) { limiter = std::make_shared<RequestLimiter>(_host); }
+    return limiter;
+}
+
+std::vector<RequestLimiter::Stats> RequestLimiter::allStats() {
+    std::vector<Stats> stats;
+    std::lock_guard<std::mutex> lock(s_limitersMutex);
+    for (const auto& entry : s_limiters) { stats.push_back(entry.second->stats()); }
+    std::sort(stats.begin(), stats.end(), [](const Stats& a, const Stats& b) { return a.host < b.host; });
+    return stats;
+}
+
+static bool compareTasks(const TileTask& _a, const TileTask& _b) {
+    if (_a.isPrefetch() != _b.isPrefetch()) {
+        return !_a.isPrefetch();
+    }
+    if (_a.isProxy() != _b.isProxy()) {
+        return !_a.isProxy();
+    }
+    return _a.getPriority() < _b.getPriority();
+}
+
+RequestLimiter::RequestLimiter(std::string _host) :
+    m_host(std::move(_host)),
+    m_limit(INITIAL_LIMIT) {}
+
+static int limitCount(float _limit) {
+    return std::max(MIN_LIMIT, int(_limit));
+}
+
+void RequestLimiter::request(const void* _owner, std::shared_ptr<TileTask> _task, Start _start) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_active == 0 && m_queue.empty()) {
+        // idle time does not count for throughput
+        m_windowStart = Clock::now();
+        m_windowRtt = 0;
+        m_windowBytes = 0;
+        m_windowSamples = 0;
+        m_windowLimited = false;
+    }
+
+    if (m_active >= limitCount(m_limit)) {
+        m_queue.push_back({ _owner, std::move(_task), std::move(_start) });
+        m_windowLimited = true;
+        return;
+    }
+
+    m_active++;
+    if (m_active >= limitCount(m_limit)) { m_windowLimited = true; }
+    lock.unlock();
+
+    if (!_start()) {
+        lock.lock();
+        m_active--;
+        startPending(lock);
+    }
+}
+
+void RequestLimiter::finish(Clock::time_point _started, size_t _bytes, bool _success, Clock::time_point _now) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_active--;
+    // errors and cancellations say nothing about the link
+    if (_success) { sample(_now - _started, _bytes, _now); }
+    startPending(lock);
+}
+
+void RequestLimiter::sample(Clock::duration _rtt, size_t _bytes, Clock::time_point _now) {
+    double rtt = std::chrono::duration<double>(_rtt).count();
+    if (m_minRtt == 0 || rtt < m_minRtt) { m_minRtt = rtt; }
+
+    m_windowRtt += rtt;
+    m_windowBytes += _bytes;
+    m_windowSamples++;
+
+    double elapsed = std::chrono::duration<double>(_now - m_windowStart).count();
+    double meanRtt = m_windowRtt / m_windowSamples;
+    if (m_windowSamples < MIN_WINDOW_SAMPLES || elapsed < std::max(MIN_WINDOW_SECONDS, meanRtt)) {
+        return;
+    }
+
+    double throughput = m_windowBytes / elapsed;
+    bool delayed = meanRtt > m_minRtt * RTT_TOLERANCE;
+
+    if (delayed && throughput < m_throughput * THROUGHPUT_GAIN) {
+        m_limit = std::max<float>(MIN_LIMIT, m_limit * DECREASE_FACTOR);
+    } else if (!delayed && m_windowLimited) {
+        m_limit = std::min<float>(MAX_LIMIT, m_limit + 1);
+    }
+
+    m_throughput = throughput;
+    m_minRtt *= MIN_RTT_DECAY;
+
+    m_windowStart = _now;
+    m_windowRtt = 0;
+    m_windowBytes = 0;
+    m_windowSamples = 0;
+    m_windowLimited = m_active >= limitCount(m_limit) || !m_queue.empty();
+}
+
+void RequestLimiter::startPending(std::unique_lock<std::mutex>& _lock) {
+    while (m_active < limitCount(m_limit) && !m_queue.empty()) {
+
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                      [](auto& p) { return p.task->isCanceled(); }),
+                      m_queue.end());
+        if (m_queue.empty()) { break; }
+
+        auto best = m_queue.begin();
+        for (auto it = best + 1; it != m_queue.end(); ++it) {
+            if (compareTasks(*it->task, *best->task)) { best = it; }
+        }
+
+        Start start = std::move(best->start);
+        const void* owner = best->owner;
+        m_starting.push_back(owner);
+        m_queue.erase(best);
+        m_active++;
+
+        _lock.unlock();
+        bool started = start();
+        start = nullptr;
+        _lock.lock();
+
+        m_starting.erase(std::find(m_starting.begin(), m_starting.end(), owner));
+        m_startDone.notify_all();
+
+        if (!started) { m_active--; }
+    }
+}
+
+bool RequestLimiter::cancel(const TileTask& _task) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_queue.begin(), m_queue.end(),
+                           [&](auto& p) { return p.task.get() == &_task; });
+    if (it == m_queue.end()) { return false; }
+    m_queue.erase(it);
+    return true;
+}
+
+void RequestLimiter::cancel(const void* _owner) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                 [&](auto& p) { return p.owner == _owner; }),
+                  m_queue.end());
+    m_startDone.wait(lock, [&]() {
+        return std::find(m_starting.begin(), m_starting.end(), _owner) == m_starting.end();
+    });
+}
+
+RequestLimiter::Stats RequestLimiter::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.host = m_host;
+    stats.limit = m_limit;
+    stats.active = m_active;
+    stats.queued = int(m_queue.size());
+    return stats;
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class TileTask;
+
+/* Adaptive limit for concurrent tile requests to one host
+ *
+ * The limit is adjusted once per window, i.e. about one response time: when the limit was
+ * reached and response times stayed close to the lowest seen, it grows by one request; when
+ * response times rise well above that without a gain in throughput, the link is congested
+ * and the limit shrinks by a quarter (AIMD). Requests over the limit wait in a queue and are
+ * started in the order TileWorker builds tasks: visible before prefetch, non-proxy before
+ * proxy, then by TileTask::getPriority().
+ */
+class RequestLimiter {
+
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    // Starts the request, returns false if it was not started
+    using Start = std::function<bool()>;
+
+    struct Stats {
+        std::string host;
+        float limit = 0;
+        int active = 0;
+        int queued = 0;
+    };
+
+    // Limiter shared by all requests to @_host
+    static std::shared_ptr<RequestLimiter> forHost(const std::string& _host);
+
+    // Stats of all hosts that have been requested
+    static std::vector<Stats> allStats();
+
+    explicit RequestLimiter(std::string _host);
+
+    /* Run @_start now if the limit allows, otherwise when another request finished;
+     * @_owner identifies queued requests for cancel() */
+    void request(const void* _owner, std::shared_ptr<TileTask> _task, Start _start);
+
+    /* Report the response of a started request; only successful responses are
+     * sampled for response time and throughput */
+    void finish(Clock::time_point _started, size_t _bytes, bool _success,
+                Clock::time_point _now = Clock::now());
+
+    // Remove queued request of @_task; returns false if it is not queued, e.g. when it is
+    //  being started
+    bool cancel(const TileTask& _task);
+
+    // Remove all queued requests of @_owner and wait for those being started, so that no
+    //  start function of @_owner runs after this returns
+    void cancel(const void* _owner);
+
+    Stats stats() const;
+
+private:
+
+    struct Pending {
+        const void* owner;
+        std::shared_ptr<TileTask> task;
+        Start start;
+    };
+
+    // Start queued requests while below the limit
+    void startPending(std::unique_lock<std::mutex>& _lock);
+
+    void sample(Clock::duration _rtt, size_t _bytes, Clock::time_point _now);
+
+    const std::string m_host;
+
+    float m_limit;
+    int m_active = 0;
+    std::vector<Pending> m_queue;
+    // owners of queued requests being started outside the lock
+    std::vector<const void*> m_starting;
+    std::condition_variable m_startDone;
+
+    // lowest response time, slowly forgotten to follow changes of the link
+    double m_minRtt = 0;
+
+    // current window
+    Clock::time_point m_windowStart;
+    double m_windowRtt = 0;
+    size_t m_windowBytes = 0;
+    int m_windowSamples = 0;
+    bool m_windowLimited = false;
+
+    // throughput of the last window in bytes per second
+    double m_throughput = 0;
+
+    mutable std::mutex m_mutex;
+};
+
+}
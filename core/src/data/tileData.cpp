@@ -0,0 +1,43 @@
+#include "data/tileData.h"
+
+#include "data/propertyItem.h"
+
+namespace Tangram {
+
+size_t TileData::memoryUsage() const {
+    if (size_t bytes = m_memoryUsage) { return bytes; }
+
+    size_t bytes = sizeof(TileData) + layers.capacity() * sizeof(Layer);
+    if (arena) { bytes += arena->capacity(); }
+
+    // Features of a layer usually share one PropertyTable
+    std::vector<const PropertyTable*> tables;
+
+    for (const auto& layer : layers) {
+        bytes += layer.name.capacity();
+        if (!layer.features.get_allocator().arena) {
+            bytes += layer.features.capacity() * sizeof(Feature);
+        }
+        for (const auto& feature : layer.features) {
+            // geometry in the arena is counted by its capacity
+            if (!feature.coordinates.get_allocator().arena) {
+                bytes += feature.coordinates.capacity() * sizeof(Point) +
+                    (feature.ringEnds.capacity() + feature.polygonEnds.capacity() +
+                     feature.triangleEnds.capacity()) * sizeof(uint32_t) +
+                    feature.triangles.capacity() * sizeof(uint16_t);
+            }
+            bytes += feature.props.memoryUsage();
+
+            auto table = feature.props.table();
+            if (table && std::find(tables.begin(), tables.end(), table) == tables.end()) {
+                tables.push_back(table);
+                bytes += table->memoryUsage();
+            }
+        }
+    }
+
+    m_memoryUsage = bytes;
+    return bytes;
+}
+
+}
@@ -2,7 +2,13 @@
 
 #include "glm/vec2.hpp"
 #include "data/properties.h"
+#include "util/arena.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -36,8 +42,10 @@ Data heirarchy:
 
   A <Feature> contains a <GeometryType> denoting what variety of geometry is
   contained in the feature, a <Properties> struct describing the feature, and
-  one collection each of <Point>s, <Line>s, and <Polygon>s. Only the geometry
-  collection corresponding to the feature's geometryType should contain data.
+  its geometry: <Point>s, <Line>s or <Polygon>s according to the geometryType.
+  The geometry is stored flat, as one array of coordinates with the end offsets
+  of each line or ring and of each polygon, and read through views: points(),
+  lines() and polygons().
 
   A <Properties> contains a sorted vector of key-value pairs storing the
   properties of a <Feature>
@@ -46,10 +54,16 @@ Data heirarchy:
   Contour winding rules follow the conventions of the OpenGL red book described
   here: http://www.glprogramming.com/red/chapter11.html
 
-  A <Line> is a collection of <Point>s.
+  A <Line> is a collection of <Point>s. <Line>s and <Polygon>s are used to
+  build geometry; features are read through <LineView>s and <PolygonView>s.
 
   A <Point> is 2 32-bit floating point coordinates representing x and y.
 
+Memory:
+
+  The geometry of the features of a <TileData> can be allocated from a <TileArena>
+  that it owns, see Mvt::parseTile(). Features copied from it use the heap.
+
 */
 namespace Tangram {
 
@@ -66,33 +80,271 @@ using Line = std::vector<Point>;
 
 using Polygon = std::vector<Line>;
 
+/* Read-only view of contiguous elements, e.g. the points of a line */
+template<typename T>
+class Span {
+
+public:
+
+    using value_type = T;
+
+    Span() {}
+    Span(const T* _begin, const T* _end) : m_begin(_begin), m_end(_end) {}
+
+    // View of a vector, e.g. a <Line>
+    template<typename Allocator>
+    Span(const std::vector<T, Allocator>& _vector)
+        : m_begin(_vector.data()), m_end(_vector.data() + _vector.size()) {}
+
+    const T* begin() const { return m_begin; }
+    const T* end() const { return m_end; }
+    const T* data() const { return m_begin; }
+
+    size_t size() const { return m_end - m_begin; }
+    bool empty() const { return m_begin == m_end; }
+
+    const T& operator[](size_t _index) const { return m_begin[_index]; }
+    const T& front() const { return *m_begin; }
+    const T& back() const { return *(m_end - 1); }
+
+private:
+
+    const T* m_begin = nullptr;
+    const T* m_end = nullptr;
+};
+
+using LineView = Span<Point>;
+
+/* Iterator over the parts of a view of flat geometry, which are created on access */
+template<typename View>
+class PartIterator {
+
+public:
+
+    PartIterator(const View& _view, size_t _index) : m_view(&_view), m_index(_index) {}
+
+    auto operator*() const { return (*m_view)[m_index]; }
+    PartIterator& operator++() { m_index++; return *this; }
+    bool operator==(const PartIterator& _other) const { return m_index == _other.m_index; }
+    bool operator!=(const PartIterator& _other) const { return m_index != _other.m_index; }
+
+private:
+
+    const View* m_view;
+    size_t m_index;
+};
+
+/* Lines of flat geometry: a line ends at its offset in @_ends into the points and starts at
+ * the end of the previous line, the first at @_start */
+class LinesView {
+
+public:
+
+    using value_type = LineView;
+
+    LinesView() {}
+    LinesView(const Point* _points, const uint32_t* _ends, size_t _count, uint32_t _start)
+        : m_points(_points), m_ends(_ends), m_count(_count), m_start(_start) {}
+
+    LineView operator[](size_t _index) const {
+        uint32_t start = _index == 0 ? m_start : m_ends[_index - 1];
+        return { m_points + start, m_points + m_ends[_index] };
+    }
+
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+
+    LineView front() const { return (*this)[0]; }
+    LineView back() const { return (*this)[m_count - 1]; }
+
+    PartIterator<LinesView> begin() const { return { *this, 0 }; }
+    PartIterator<LinesView> end() const { return { *this, m_count }; }
+
+private:
+
+    const Point* m_points = nullptr;
+    const uint32_t* m_ends = nullptr;
+    size_t m_count = 0;
+    uint32_t m_start = 0;
+};
+
+/* Rings of a polygon; the first is the exterior */
+using PolygonView = LinesView;
+
+/* Polygons of flat geometry: a polygon ends at its offset in @_ends into the rings */
+class PolygonsView {
+
+public:
+
+    using value_type = PolygonView;
+
+    PolygonsView() {}
+    PolygonsView(const Point* _points, const uint32_t* _rings, const uint32_t* _ends, size_t _count)
+        : m_points(_points), m_rings(_rings), m_ends(_ends), m_count(_count) {}
+
+    PolygonView operator[](size_t _index) const {
+        uint32_t first = _index == 0 ? 0 : m_ends[_index - 1];
+        return { m_points, m_rings + first, m_ends[_index] - first, first == 0 ? 0 : m_rings[first - 1] };
+    }
+
+    size_t size() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+
+    PartIterator<PolygonsView> begin() const { return { *this, 0 }; }
+    PartIterator<PolygonsView> end() const { return { *this, m_count }; }
+
+private:
+
+    const Point* m_points = nullptr;
+    const uint32_t* m_rings = nullptr;
+    const uint32_t* m_ends = nullptr;
+    size_t m_count = 0;
+};
+
 struct Feature {
     Feature() {}
     Feature(int32_t _sourceId) { props.sourceId = _sourceId; }
+    Feature(int32_t _sourceId, TileArena* _arena)
+        : coordinates(_arena), ringEnds(_arena), polygonEnds(_arena),
+          triangles(_arena), triangleEnds(_arena) { props.sourceId = _sourceId; }
 
     GeometryType geometryType = GeometryType::polygons;
 
-    std::vector<Point> points;
-    std::vector<Line> lines;
-    std::vector<Polygon> polygons;
+    // Points, or the points of all lines or of all polygon rings
+    std::vector<Point, TileAllocator<Point>> coordinates;
+    // End of each line or ring in coordinates
+    std::vector<uint32_t, TileAllocator<uint32_t>> ringEnds;
+    // End of each polygon in ringEnds
+    std::vector<uint32_t, TileAllocator<uint32_t>> polygonEnds;
+    // Triangles of each polygon as indices into its points, for formats that provide them,
+    // e.g. Mlt; empty when the polygons are triangulated as they are built
+    std::vector<uint16_t, TileAllocator<uint16_t>> triangles;
+    // End of the triangles of each polygon in triangles
+    std::vector<uint32_t, TileAllocator<uint32_t>> triangleEnds;
 
     Properties props;
+
+    LineView points() const { return coordinates; }
+
+    LinesView lines() const {
+        return { coordinates.data(), ringEnds.data(), ringEnds.size(), 0 };
+    }
+
+    PolygonsView polygons() const {
+        return { coordinates.data(), ringEnds.data(), polygonEnds.data(), polygonEnds.size() };
+    }
+
+    // Triangles of polygon @_index, or none when it is to be triangulated
+    Span<uint16_t> polygonTriangles(size_t _index) const {
+        if (_index >= triangleEnds.size()) { return {}; }
+        uint32_t start = _index == 0 ? 0 : triangleEnds[_index - 1];
+        return { triangles.data() + start, triangles.data() + triangleEnds[_index] };
+    }
+
+    void addPoint(Point _point) { coordinates.push_back(_point); }
+
+    // End a line at the last of coordinates
+    void endLine() { ringEnds.push_back(uint32_t(coordinates.size())); }
+
+    template<typename InputIt>
+    void addLine(InputIt _begin, InputIt _end) {
+        coordinates.insert(coordinates.end(), _begin, _end);
+        endLine();
+    }
+    void addLine(LineView _line) { addLine(_line.begin(), _line.end()); }
+
+    // Start a polygon; its rings are added with addRing() or endRing()
+    void beginPolygon() { polygonEnds.push_back(uint32_t(ringEnds.size())); }
+
+    // End a ring of the last polygon at the last of coordinates
+    void endRing() {
+        endLine();
+        polygonEnds.back() = uint32_t(ringEnds.size());
+    }
+
+    template<typename InputIt>
+    void addRing(InputIt _begin, InputIt _end) {
+        coordinates.insert(coordinates.end(), _begin, _end);
+        endRing();
+    }
+
+    void addPolygon(const Polygon& _polygon) {
+        beginPolygon();
+        for (auto& ring : _polygon) { addRing(ring.begin(), ring.end()); }
+    }
 };
 
 struct Layer {
 
-    Layer(const std::string& _name) : name(_name) {}
+    Layer(const std::string& _name, TileArena* _arena = nullptr) : name(_name), features(_arena) {}
 
     std::string name;
 
-    std::vector<Feature> features;
+    std::vector<Feature, TileAllocator<Feature>> features;
+
+};
 
+/* Property keys that a scene reads from the features of each data layer
+ *
+ * Parsers drop the other properties of features in layers that have keys. Layers without keys,
+ * or marked to keep all properties (e.g. for JS functions or feature selection), are read in full.
+ */
+struct PropertyKeys {
+
+    struct Keys {
+        // sorted
+        std::vector<std::string> keys;
+        bool all = false;
+
+        bool contains(const std::string& _key) const {
+            return all || std::binary_search(keys.begin(), keys.end(), _key);
+        }
+    };
+
+    // Add @_keys, or all keys if @_all, to those read from data layer @_layer
+    void add(const std::string& _layer, const std::vector<std::string>& _keys, bool _all) {
+        auto& entry = layers[_layer];
+        entry.all |= _all;
+        if (entry.all) {
+            entry.keys.clear();
+            return;
+        }
+        entry.keys.insert(entry.keys.end(), _keys.begin(), _keys.end());
+        std::sort(entry.keys.begin(), entry.keys.end());
+        entry.keys.erase(std::unique(entry.keys.begin(), entry.keys.end()), entry.keys.end());
+    }
+
+    // Keys read from @_layer, or nullptr when all its properties are kept
+    const Keys* find(const std::string& _layer) const {
+        auto it = layers.find(_layer);
+        if (it == layers.end() || it->second.all) { return nullptr; }
+        return &it->second;
+    }
+
+    bool empty() const { return layers.empty(); }
+
+    std::unordered_map<std::string, Keys> layers;
 };
 
 struct TileData {
 
+    TileData() {}
+    explicit TileData(std::shared_ptr<TileArena> _arena) : arena(std::move(_arena)) {}
+
+    // declared first to be released after the layers
+    std::shared_ptr<TileArena> arena;
+
     std::vector<Layer> layers;
 
+    /* Estimated bytes of the arena, layers, features and their properties. Measured once: call
+     * it before the TileData is shared, as reading properties is not thread-safe (see
+     * Properties::items()) */
+    size_t memoryUsage() const;
+
+private:
+
+    mutable std::atomic<size_t> m_memoryUsage{0};
+
 };
 
 }
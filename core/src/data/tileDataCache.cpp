@@ -0,0 +1,144 @@
+#include "data/tileDataCache.h"
+
+#include "data/tileData.h"
+#include "tile/tileHash.h"
+
+namespace Tangram {
+
+size_t TileDataCache::KeyHash::operator()(const Key& _key) const {
+    size_t seed = std::hash<TileID>()(_key.tileId);
+    hash_combine(seed, _key.source);
+    return seed;
+}
+
+TileDataCache::TileDataCache(size_t _maxEntries, size_t _maxBytes) :
+    m_maxEntries(_maxEntries), m_maxBytes(_maxBytes), m_configuredMaxBytes(_maxBytes) {}
+
+TileDataCache::~TileDataCache() {}
+
+std::shared_ptr<TileData> TileDataCache::get(const std::string& _key, const TileID& _tileId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(Key{ _key, _tileId });
+    if (it == m_index.end()) { return nullptr; }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->tileData;
+}
+
+void TileDataCache::put(const std::string& _key, const TileID& _tileId,
+                        std::shared_ptr<TileData> _tileData) {
+    if (!_tileData) { return; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_maxEntries == 0) { return; }
+
+    // measured by TileSource::parse() before it is shared
+    size_t bytes = _tileData->memoryUsage();
+
+    Key key{ _key, _tileId };
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_bytes = m_bytes - it->second->bytes + bytes;
+        it->second->tileData = std::move(_tileData);
+        it->second->bytes = bytes;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+    } else {
+        m_entries.push_front({ key, std::move(_tileData), bytes });
+        m_index.emplace(std::move(key), m_entries.begin());
+        m_bytes += bytes;
+    }
+    evict(m_maxEntries, m_maxBytes);
+}
+
+void TileDataCache::clear(const std::string& _key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->key.source == _key) {
+            m_bytes -= it->bytes;
+            m_index.erase(it->key);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TileDataCache::erase(const std::string& _key, const TileID& _tileId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const auto& id = it->key.tileId;
+        if (id.x == _tileId.x && id.y == _tileId.y && id.z == _tileId.z && it->key.source == _key) {
+            m_bytes -= it->bytes;
+            m_index.erase(it->key);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TileDataCache::setMaxEntries(size_t _maxEntries) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxEntries = _maxEntries;
+    evict(m_maxEntries, m_maxBytes);
+}
+
+void TileDataCache::setMaxBytes(size_t _maxBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_configuredMaxBytes = _maxBytes;
+    applyMaxBytes();
+}
+
+void TileDataCache::setShare(const void* _owner, size_t _bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shares[_owner] = _bytes;
+    applyMaxBytes();
+}
+
+void TileDataCache::removeShare(const void* _owner) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_shares.erase(_owner)) { applyMaxBytes(); }
+}
+
+void TileDataCache::applyMaxBytes() {
+    if (m_shares.empty()) {
+        m_maxBytes = m_configuredMaxBytes;
+    } else {
+        m_maxBytes = 0;
+        for (const auto& share : m_shares) { m_maxBytes += share.second; }
+    }
+    evict(m_maxEntries, m_maxBytes);
+}
+
+void TileDataCache::trim(size_t _bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evict(m_maxEntries, _bytes);
+}
+
+size_t TileDataCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+size_t TileDataCache::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+void TileDataCache::forEach(const std::function<void(const TileData&)>& _fn) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry : m_entries) { _fn(*entry.tileData); }
+}
+
+void TileDataCache::evict(size_t _maxEntries, size_t _maxBytes) {
+    while (!m_entries.empty() && (m_entries.size() > _maxEntries || m_bytes > _maxBytes)) {
+        m_bytes -= m_entries.back().bytes;
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+}
+
+}
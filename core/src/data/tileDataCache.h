@@ -0,0 +1,107 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Tangram {
+
+struct TileData;
+
+/*
+ * TileDataCache - Parsed TileData shared by the TileSources of Maps attached to one MapContext
+ *
+ * Entries are keyed by the parse key of a source, which covers its url, format and the data
+ * layers and properties kept when parsing (see TileSource::setTileDataCache()), so that sources
+ * of different Scenes only share tiles they would have parsed the same way. TileData is not
+ * modified after parsing and is read by tile builders of all Maps at once.
+ *
+ * Holds the most recently used tiles up to a number of entries and of bytes, as estimated by
+ * TileData::memoryUsage(). As the cache is kept across Scene updates, tiles rebuilt after a scene
+ * update, a pixel scale change or the eviction of their built tile are styled and meshed again
+ * without parsing their data.
+ */
+class TileDataCache {
+
+public:
+
+    static constexpr size_t DEFAULT_MAX_BYTES = 32 * 1024 * 1024;
+
+    explicit TileDataCache(size_t _maxEntries, size_t _maxBytes = DEFAULT_MAX_BYTES);
+    ~TileDataCache();
+
+    std::shared_ptr<TileData> get(const std::string& _key, const TileID& _tileId);
+
+    void put(const std::string& _key, const TileID& _tileId, std::shared_ptr<TileData> _tileData);
+
+    // Drop the entries of @_key, e.g. when its source was cleared
+    void clear(const std::string& _key);
+
+    // Drop the entries of @_key for data tile @_tileId (any s), e.g. when it was invalidated
+    void erase(const std::string& _key, const TileID& _tileId);
+
+    void setMaxEntries(size_t _maxEntries);
+
+    // Set the bytes kept while no share is set
+    void setMaxBytes(size_t _maxBytes);
+
+    // Set the share of @_owner, e.g. the memory budget of one Map, in the bytes kept, which are
+    // the sum of all shares while any is set
+    void setShare(const void* _owner, size_t _bytes);
+
+    // Withdraw the share of @_owner
+    void removeShare(const void* _owner);
+
+    // Drop least recently used entries until at most @_bytes are kept, keeping the limits
+    void trim(size_t _bytes);
+
+    size_t size() const;
+
+    size_t memoryUsage() const;
+
+    void forEach(const std::function<void(const TileData&)>& _fn) const;
+
+private:
+
+    struct Key {
+        std::string source;
+        TileID tileId;
+        bool operator==(const Key& _other) const {
+            return tileId == _other.tileId && source == _other.source;
+        }
+    };
+    struct KeyHash { size_t operator()(const Key& _key) const; };
+
+    struct Entry {
+        Key key;
+        std::shared_ptr<TileData> tileData;
+        size_t bytes;
+    };
+
+    // evict least recently used entries beyond @_maxEntries or @_maxBytes; m_mutex must be locked
+    void evict(size_t _maxEntries, size_t _maxBytes);
+
+    // set m_maxBytes from the shares or the configured size and evict; m_mutex must be locked
+    void applyMaxBytes();
+
+    mutable std::mutex m_mutex;
+
+    // Most recently used first
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+    size_t m_maxEntries;
+    size_t m_maxBytes;
+    size_t m_bytes = 0;
+
+    // set by setMaxBytes(), applies while there are no shares
+    size_t m_configuredMaxBytes;
+    std::unordered_map<const void*, size_t> m_shares;
+
+};
+
+}
@@ -0,0 +1,117 @@
+#include "data/tileLoad.h"
+
+#include <new>
+
+// Frames are recycled in size classes of this many bytes ...
+#define TILE_LOAD_FRAME_GRANULARITY 64
+// ... up to this size
+#define TILE_LOAD_MAX_FRAME_SIZE 1024
+// Frames kept per size class and thread
+#define TILE_LOAD_MAX_FREE_FRAMES 16
+
+namespace Tangram {
+
+namespace {
+
+struct FramePool {
+    static constexpr size_t numClasses = TILE_LOAD_MAX_FRAME_SIZE / TILE_LOAD_FRAME_GRANULARITY;
+
+    struct SizeClass {
+        void* frames[TILE_LOAD_MAX_FREE_FRAMES];
+        size_t count = 0;
+    };
+    SizeClass classes[numClasses];
+
+    ~FramePool() {
+        for (auto& sizeClass : classes) {
+            for (size_t i = 0; i < sizeClass.count; i++) { ::operator delete(sizeClass.frames[i]); }
+            sizeClass.count = 0;
+        }
+    }
+};
+
+thread_local FramePool t_framePool;
+
+}
+
+void* TileLoad::promise_type::operator new(size_t _size) {
+    size_t index = (_size - 1) / TILE_LOAD_FRAME_GRANULARITY;
+    if (index >= FramePool::numClasses) { return ::operator new(_size); }
+
+    auto& sizeClass = t_framePool.classes[index];
+    if (sizeClass.count > 0) { return sizeClass.frames[--sizeClass.count]; }
+
+    return ::operator new((index + 1) * TILE_LOAD_FRAME_GRANULARITY);
+}
+
+void TileLoad::promise_type::operator delete(void* _frame, size_t _size) {
+    // frames may be released on another thread than the one allocating them
+    size_t index = (_size - 1) / TILE_LOAD_FRAME_GRANULARITY;
+    if (index < FramePool::numClasses) {
+        auto& sizeClass = t_framePool.classes[index];
+        if (sizeClass.count < TILE_LOAD_MAX_FREE_FRAMES) {
+            sizeClass.frames[sizeClass.count++] = _frame;
+            return;
+        }
+    }
+    ::operator delete(_frame);
+}
+
+DataSourceAwaiter::Resume::Resume(TileLoad::Handle _handle) : handle(_handle) {
+    auto& promise = handle.promise();
+    promise.callbacks.fetch_add(1, std::memory_order_relaxed);
+    promise.retain();
+}
+
+DataSourceAwaiter::Resume::Resume(const Resume& _other) : Resume(_other.handle) {}
+
+DataSourceAwaiter::Resume::~Resume() {
+    using State = TileLoad::promise_type::State;
+    auto& promise = handle.promise();
+
+    if (promise.callbacks.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // No callback is left to resume the coroutine
+        State state = promise.state;
+        while ((state == State::pending || state == State::suspended) &&
+               !promise.state.compare_exchange_weak(state, State::dropped)) {}
+
+        // A suspended coroutine is destroyed where it waits, once its TileLoad is gone;
+        //  a pending one is left to await_suspend()
+        if (state == State::suspended) { promise.release(handle); }
+    }
+    promise.release(handle);
+}
+
+void DataSourceAwaiter::Resume::operator()(std::shared_ptr<TileTask> _task) const {
+    using State = TileLoad::promise_type::State;
+    // Called while the DataSource was started continues in await_suspend()
+    if (handle.promise().state.exchange(State::called) == State::suspended) {
+        handle.resume();
+    }
+}
+
+bool DataSourceAwaiter::await_suspend(TileLoad::Handle _handle) {
+    using State = TileLoad::promise_type::State;
+    auto& promise = _handle.promise();
+
+    // Callbacks of a previous DataSource may still be around: count this one before
+    //  the state is reset, so that their release does not take it as dropped
+    TileTaskCb callback{Resume(_handle)};
+    promise.state = State::pending;
+
+    m_started = m_source.loadTileData(m_task, std::move(callback));
+    if (!m_started) {
+        promise.state = State::called;
+        return false;
+    }
+
+    State state = State::pending;
+    if (promise.state.compare_exchange_strong(state, State::suspended)) { return true; }
+    if (state == State::called) { return false; }
+
+    // Dropped without being called: stay suspended until the last reference is released
+    promise.release(_handle);
+    return true;
+}
+
+}
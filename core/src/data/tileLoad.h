@@ -0,0 +1,131 @@
+#pragma once
+
+#include "data/tileSource.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+
+namespace Tangram {
+
+/* TileLoad - Coroutine loading a TileTask through the following DataSources of a chain
+ *
+ * A DataSource implements steps like 'cache miss -> load from next -> store' as one coroutine
+ * returning TileLoad, which awaits the next source with co_await loadFrom(*next, _task):
+ *
+ *   TileLoad MyDataSource::loadFromNext(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+ *       if (!co_await loadFrom(*next, _task)) { co_return false; }
+ *       store(*_task);
+ *       _cb.func(_task);
+ *       co_return true;
+ *   }
+ *
+ *   bool MyDataSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
+ *       return loadFromNext(std::move(_task), std::move(_cb)).started();
+ *   }
+ *
+ * The coroutine starts right away and continues on the thread calling back the next source, as
+ * a callback passed to it would. It returns true once it will call, or has called, its callback
+ * and false otherwise, like DataSource::loadTileData(). When the next source drops its callback
+ * without calling it, e.g. for a canceled TileTask, the coroutine is destroyed where it waits.
+ *
+ * Coroutine frames are recycled by each thread, so that a hop costs about as much as the
+ * callback passed to the next source.
+ */
+class TileLoad {
+
+public:
+
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type {
+        enum State : uint8_t { pending, suspended, called, dropped };
+
+        // this TileLoad, the running coroutine and callbacks resuming it
+        std::atomic<uint32_t> refs{2};
+        // callbacks passed to DataSources
+        std::atomic<uint32_t> callbacks{0};
+        // of the callback awaited last
+        std::atomic<State> state{called};
+        // -1 while running
+        std::atomic<int8_t> result{-1};
+
+        TileLoad get_return_object() { return TileLoad(Handle::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(Handle _handle) noexcept { _handle.promise().release(_handle); }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(bool _started) { result = _started ? 1 : 0; }
+        void unhandled_exception() { std::terminate(); }
+
+        void retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+        void release(Handle _handle) {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) { _handle.destroy(); }
+        }
+
+        static void* operator new(size_t _size);
+        static void operator delete(void* _frame, size_t _size);
+    };
+
+    TileLoad(TileLoad&& _other) noexcept : m_handle(_other.m_handle) { _other.m_handle = nullptr; }
+    TileLoad(const TileLoad&) = delete;
+    TileLoad& operator=(const TileLoad&) = delete;
+
+    ~TileLoad() { if (m_handle) { m_handle.promise().release(m_handle); } }
+
+    /* Whether the coroutine calls its callback: true while it waits or when it returned true */
+    bool started() const { return m_handle.promise().result != 0; }
+
+private:
+
+    explicit TileLoad(Handle _handle) : m_handle(_handle) {}
+
+    Handle m_handle;
+};
+
+/* Awaits @_task loaded by @_source, resuming with true once its callback was called and with
+ * false when @_source did not start loading */
+class DataSourceAwaiter {
+
+public:
+
+    DataSourceAwaiter(TileSource::DataSource& _source, std::shared_ptr<TileTask> _task)
+        : m_source(_source), m_task(std::move(_task)) {}
+
+    DataSourceAwaiter(const DataSourceAwaiter&) = delete;
+    DataSourceAwaiter& operator=(const DataSourceAwaiter&) = delete;
+
+    bool await_ready() const { return false; }
+    bool await_suspend(TileLoad::Handle _handle);
+    bool await_resume() const { return m_started; }
+
+private:
+
+    // Callback passed to the DataSource; copies keep the coroutine frame alive
+    struct Resume {
+        TileLoad::Handle handle;
+        explicit Resume(TileLoad::Handle _handle);
+        Resume(const Resume& _other);
+        ~Resume();
+        Resume& operator=(const Resume&) = delete;
+        void operator()(std::shared_ptr<TileTask> _task) const;
+    };
+
+    TileSource::DataSource& m_source;
+    std::shared_ptr<TileTask> m_task;
+    bool m_started = false;
+};
+
+inline DataSourceAwaiter loadFrom(TileSource::DataSource& _source, std::shared_ptr<TileTask> _task) {
+    return DataSourceAwaiter(_source, std::move(_task));
+}
+
+}
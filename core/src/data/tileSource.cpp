@@ -1,27 +1,37 @@
 #include "data/tileSource.h"
 
 #include "data/formats/geoJson.h"
+#include "data/formats/mlt.h"
 #include "data/formats/mvt.h"
 #include "data/formats/topoJson.h"
 #include "data/tileData.h"
+#include "data/tileDataCache.h"
 #include "data/rasterSource.h"
 #include "platform.h"
+#include "tile/tileAvailability.h"
 #include "tile/tileID.h"
 #include "tile/tile.h"
 #include "tile/tileTask.h"
 #include "log.h"
 #include "util/geom.h"
+#include "util/objectPool.h"
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 
+// Number of parsed max-zoom tiles kept for overzoomed tiles
+#define MAX_OVERZOOM_TILE_DATA 8
+
 namespace Tangram {
 
 TileSource::TileSource(const std::string& _name, std::unique_ptr<DataSource> _sources,
                        ZoomOptions _zoomOptions) :
     m_name(_name),
     m_zoomOptions(_zoomOptions),
-    m_sources(std::move(_sources)) {
+    m_sources(std::move(_sources)),
+    m_availability(std::make_unique<TileAvailability>()),
+    m_taskPool(std::make_shared<ObjectPool>()) {
 
     static std::atomic<int32_t> s_serial;
 
@@ -51,13 +61,14 @@ const char* TileSource::mimeType() const {
     case Format::GeoJson: return "application/geo+json";
     case Format::TopoJson: return "application/topo+json";
     case Format::Mvt: return "application/vnd.mapbox-vector-tile";
+    case Format::Mlt: return "application/vnd.maplibre-vector-tile";
     }
     assert(false);
     return "";
 }
 
 std::shared_ptr<TileTask> TileSource::createTask(TileID _tileId) {
-    auto task = std::make_shared<BinaryTileTask>(_tileId, this);
+    auto task = m_taskPool->make<BinaryTileTask>(_tileId, this);
 
     addRasterTasks(*task);
 
@@ -75,14 +86,68 @@ void TileSource::clearData() {
 
     if (m_sources) { m_sources->clear(); }
 
+    m_availability->clear();
+
+    clearOverzoomTileData();
+    {
+        std::lock_guard<std::mutex> lock(m_overzoomMutex);
+        if (m_tileDataCache) { m_tileDataCache->clear(m_tileDataKey); }
+    }
+
     m_generation++;
 }
 
+void TileSource::invalidateTile(const TileID& _tileId) {
+
+    TileID dataId(_tileId.x, _tileId.y, _tileId.z);
+
+    if (m_sources) { m_sources->clearTile(dataId); }
+
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+
+    auto it = std::find_if(m_overzoomTileData.begin(), m_overzoomTileData.end(),
+                           [&](auto& entry) { return entry.first == dataId; });
+    if (it != m_overzoomTileData.end()) { m_overzoomTileData.erase(it); }
+
+    if (m_tileDataCache) { m_tileDataCache->erase(m_tileDataKey, dataId); }
+
+    // tiles invalidated before another update are current once built after it
+    if (m_invalidatedGeneration != m_generation) {
+        m_baseGeneration = m_generation;
+        m_tileGenerations.clear();
+    }
+    m_invalidatedGeneration = ++m_generation;
+    m_tileGenerations[dataId] = m_invalidatedGeneration;
+}
+
+int64_t TileSource::tileGeneration(const TileID& _tileId) const {
+
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    int64_t generation = m_generation;
+    if (generation != m_invalidatedGeneration) { return generation; }
+
+    auto it = m_tileGenerations.find(TileID(_tileId.x, _tileId.y, _tileId.z));
+    return it != m_tileGenerations.end() ? it->second : m_baseGeneration;
+}
+
+void TileSource::trimDataCache(size_t _bytes) {
+    if (m_sources) { m_sources->trimCache(_bytes); }
+
+    // not accounted in dataCacheUsage(), so always released
+    clearOverzoomTileData();
+}
+
 void TileSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 
     assert(_task->tileId().z <= m_zoomOptions.maxZoom);
     if (m_sources) {
-        if (_task->needsLoading()) {
+        std::shared_ptr<TileData> tileData;
+        if (_task->needsLoading() && ((tileData = overzoomTileData(_task->tileId())) ||
+                                      (tileData = sharedTileData(_task->tileId())))) {
+            _task->setTileData(std::move(tileData));
+            _task->startedLoading();
+            _cb.func(_task);
+        } else if (_task->needsLoading()) {
             if (m_sources->loadTileData(_task, _cb)) {
                 _task->startedLoading();
             }
@@ -97,13 +162,119 @@ void TileSource::loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) {
 }
 
 std::shared_ptr<TileData> TileSource::parse(const TileTask& _task) const {
+    TileID tileId = _task.tileId();
+
+    if (auto tileData = overzoomTileData(tileId)) { return tileData; }
+
+    // parsed since the task was loaded, e.g. by the task of another Map
+    if (_task.sourceGeneration() == m_generation) {
+        if (auto tileData = sharedTileData(tileId)) { return tileData; }
+    }
+
+    std::shared_ptr<TileData> tileData;
     switch (m_format) {
-    case Format::TopoJson: return TopoJson::parseTile(_task, m_id);
-    case Format::GeoJson: return GeoJson::parseTile(_task, m_id);
-    case Format::Mvt: return Mvt::parseTile(_task, m_id);
+    case Format::TopoJson: tileData = TopoJson::parseTile(_task, m_id, m_propertyKeys.get()); break;
+    case Format::GeoJson: tileData = GeoJson::parseTile(_task, m_id, m_propertyKeys.get()); break;
+    case Format::Mvt: tileData = Mvt::parseTile(_task, m_id, m_dataLayers, m_propertyKeys.get()); break;
+    case Format::Mlt: tileData = Mlt::parseTile(_task, m_id, m_dataLayers, m_propertyKeys.get()); break;
     }
-    assert(false);
-    return nullptr;
+
+    // measure while only this thread reads it
+    if (tileData) { tileData->memoryUsage(); }
+
+    if (tileData && isDeepestTile(tileId) && _task.sourceGeneration() == m_generation) {
+        std::lock_guard<std::mutex> lock(m_overzoomMutex);
+        TileID dataId(tileId.x, tileId.y, tileId.z);
+        auto it = std::find_if(m_overzoomTileData.begin(), m_overzoomTileData.end(),
+                               [&](auto& entry) { return entry.first == dataId; });
+        if (it != m_overzoomTileData.end()) {
+            m_overzoomTileData.erase(it);
+        } else if (m_overzoomTileData.size() >= MAX_OVERZOOM_TILE_DATA) {
+            m_overzoomTileData.erase(m_overzoomTileData.begin());
+        }
+        m_overzoomTileData.emplace_back(dataId, tileData);
+    }
+    if (tileData && _task.sourceGeneration() == m_generation) {
+        std::shared_ptr<TileDataCache> cache;
+        std::string key;
+        {
+            std::lock_guard<std::mutex> lock(m_overzoomMutex);
+            cache = m_tileDataCache;
+            key = m_tileDataKey;
+        }
+        if (cache) { cache->put(key, tileId, tileData); }
+    }
+    return tileData;
+}
+
+std::shared_ptr<TileData> TileSource::overzoomTileData(const TileID& _tileId) const {
+    if (!isDeepestTile(_tileId)) { return nullptr; }
+
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    TileID dataId(_tileId.x, _tileId.y, _tileId.z);
+    auto it = std::find_if(m_overzoomTileData.begin(), m_overzoomTileData.end(),
+                           [&](auto& entry) { return entry.first == dataId; });
+    if (it == m_overzoomTileData.end()) { return nullptr; }
+
+    // move to most recently used end
+    std::rotate(it, it + 1, m_overzoomTileData.end());
+    return m_overzoomTileData.back().second;
+}
+
+bool TileSource::isDeepestTile(const TileID& _tileId) const {
+    return _tileId.z == m_zoomOptions.maxZoom || m_availability->childrenMissing(_tileId);
+}
+
+void TileSource::clearOverzoomTileData() {
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    m_overzoomTileData.clear();
+}
+
+void TileSource::forEachTileData(const std::function<void(const TileData&)>& _fn) const {
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    for (const auto& entry : m_overzoomTileData) { _fn(*entry.second); }
+}
+
+std::shared_ptr<TileData> TileSource::sharedTileData(const TileID& _tileId) const {
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    if (!m_tileDataCache) { return nullptr; }
+    return m_tileDataCache->get(m_tileDataKey, _tileId);
+}
+
+void TileSource::setTileDataCache(std::shared_ptr<TileDataCache> _cache) {
+    std::lock_guard<std::mutex> lock(m_overzoomMutex);
+    m_tileDataCache = std::move(_cache);
+    if (!m_tileDataCache) { return; }
+
+    // Sources share tiles when they load the same url in the same format and keep the same
+    // layers and properties of them
+    std::string key = m_offlineInfo.url + "|" + std::to_string(int(m_format));
+
+    auto dataLayers = m_dataLayers;
+    std::sort(dataLayers.begin(), dataLayers.end());
+    for (auto& layer : dataLayers) { key += "|" + layer; }
+
+    if (m_propertyKeys) {
+        std::vector<const std::pair<const std::string, PropertyKeys::Keys>*> layers;
+        for (auto& entry : m_propertyKeys->layers) { layers.push_back(&entry); }
+        std::sort(layers.begin(), layers.end(), [](auto* a, auto* b) { return a->first < b->first; });
+        for (auto* entry : layers) {
+            key += "|" + entry->first + (entry->second.all ? "=*" : "=");
+            for (auto& name : entry->second.keys) { key += name + ","; }
+        }
+    }
+    m_tileDataKey = std::move(key);
+}
+
+void TileSource::addDataLayer(const std::string& _layer) {
+    if (std::find(m_dataLayers.begin(), m_dataLayers.end(), _layer) == m_dataLayers.end()) {
+        m_dataLayers.push_back(_layer);
+    }
+}
+
+void TileSource::addPropertyKeys(const std::string& _layer, const std::vector<std::string>& _keys, bool _all) {
+    if (!m_propertyKeys) { m_propertyKeys = std::make_unique<PropertyKeys>(); }
+    m_propertyKeys->add(_layer, _keys, _all);
 }
 
 void TileSource::cancelLoadingTile(TileTask& _task) {
@@ -111,6 +282,10 @@ void TileSource::cancelLoadingTile(TileTask& _task) {
     if (m_sources) { m_sources->cancelLoadingTile(_task); }
 }
 
+void TileSource::updateTaskPriority(TileTask& _task) {
+    if (m_sources) { m_sources->updateTaskPriority(_task); }
+}
+
 void TileSource::addRasterSource(std::shared_ptr<TileSource> _rasterSource) {
     if (!_rasterSource) {
         LOGE("No raster source");
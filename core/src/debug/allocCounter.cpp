@@ -0,0 +1,98 @@
+#include "debug/allocCounter.h"
+
+#if TANGRAM_ALLOC_PROFILING
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h> // _aligned_malloc
+#else
+#include <stdlib.h> // posix_memalign
+#endif
+#endif
+
+namespace Tangram {
+
+#if TANGRAM_ALLOC_PROFILING
+
+// Trivially constructed, so operator new can use it on any thread at any time
+static thread_local AllocCounter::Counts t_counts;
+
+static void* allocate(std::size_t _size) {
+    t_counts.allocations++;
+    t_counts.bytes += _size;
+    return std::malloc(_size ? _size : 1);
+}
+
+static void* allocateAligned(std::size_t _size, std::align_val_t _align) {
+    t_counts.allocations++;
+    t_counts.bytes += _size;
+    auto align = std::max(static_cast<std::size_t>(_align), sizeof(void*));
+#ifdef _WIN32
+    return _aligned_malloc(_size ? _size : 1, align);
+#else
+    // unlike aligned_alloc(), any size
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, align, _size ? _size : 1) == 0 ? ptr : nullptr;
+#endif
+}
+
+static void freeAligned(void* _ptr) {
+#ifdef _WIN32
+    _aligned_free(_ptr);
+#else
+    std::free(_ptr);
+#endif
+}
+
+bool AllocCounter::enabled() { return true; }
+
+AllocCounter::Counts AllocCounter::thread() { return t_counts; }
+
+#else
+
+bool AllocCounter::enabled() { return false; }
+
+AllocCounter::Counts AllocCounter::thread() { return {}; }
+
+#endif
+
+}
+
+#if TANGRAM_ALLOC_PROFILING
+
+void* operator new(std::size_t _size) {
+    if (void* ptr = Tangram::allocate(_size)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t _size) {
+    if (void* ptr = Tangram::allocate(_size)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t _size, const std::nothrow_t&) noexcept { return Tangram::allocate(_size); }
+void* operator new[](std::size_t _size, const std::nothrow_t&) noexcept { return Tangram::allocate(_size); }
+
+void* operator new(std::size_t _size, std::align_val_t _align) {
+    if (void* ptr = Tangram::allocateAligned(_size, _align)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t _size, std::align_val_t _align) {
+    if (void* ptr = Tangram::allocateAligned(_size, _align)) { return ptr; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* _ptr) noexcept { std::free(_ptr); }
+void operator delete[](void* _ptr) noexcept { std::free(_ptr); }
+void operator delete(void* _ptr, std::size_t) noexcept { std::free(_ptr); }
+void operator delete[](void* _ptr, std::size_t) noexcept { std::free(_ptr); }
+void operator delete(void* _ptr, const std::nothrow_t&) noexcept { std::free(_ptr); }
+void operator delete[](void* _ptr, const std::nothrow_t&) noexcept { std::free(_ptr); }
+void operator delete(void* _ptr, std::align_val_t) noexcept { Tangram::freeAligned(_ptr); }
+void operator delete[](void* _ptr, std::align_val_t) noexcept { Tangram::freeAligned(_ptr); }
+void operator delete(void* _ptr, std::size_t, std::align_val_t) noexcept { Tangram::freeAligned(_ptr); }
+void operator delete[](void* _ptr, std::size_t, std::align_val_t) noexcept { Tangram::freeAligned(_ptr); }
+
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Tangram {
+
+/* Heap allocations of the calling thread
+ *
+ * Builds with TANGRAM_ALLOC_PROFILING replace the global operator new and delete to count the
+ * allocations and requested bytes of each thread; otherwise the counts stay 0 and enabled() is
+ * false. Counting adds a thread-local increment to each allocation, so the profiling build can
+ * run in the field, but it is not meant for release builds.
+ */
+class AllocCounter {
+public:
+    struct Counts {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    static bool enabled();
+
+    /* Allocations of the calling thread since it started */
+    static Counts thread();
+
+    /* Allocations of the calling thread from construction to counts() */
+    struct Scope {
+        Counts start = thread();
+        Counts counts() const {
+            Counts now = thread();
+            return { now.allocations - start.allocations, now.bytes - start.bytes };
+        }
+    };
+};
+
+}
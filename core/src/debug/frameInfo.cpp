@@ -3,13 +3,17 @@
 #include "debug/textDisplay.h"
 #include "gl.h"
 #include "gl/glError.h"
+#include "gl/hardware.h"
 #include "gl/primitives.h"
+#include "gl/renderState.h"
 #include "map.h"
 #include "scene/scene.h"
 #include "marker/markerManager.h"
 #include "labels/labelManager.h"
 #include "tile/tileCache.h"
+#include "tile/tileWorker.h"
 #include "data/rasterSource.h"
+#include "data/requestLimiter.h"
 
 #include <deque>
 #include <ctime>
@@ -164,15 +168,11 @@ void FrameInfo::draw(RenderState& rs, const View& _view, Map& _map) {
         for (const auto& source : scene.tileSources()) {
             if (!source->isRaster()) { continue; }
             size_t ntex = 0, srcbytes = 0;
-            RasterSource::Cache* srctexs = static_cast<RasterSource*>(source.get())->m_textures.get();
-            for(auto& kv : *srctexs) {
-                auto tex = kv.second.lock();
-                if(tex) {
-                    ++ntex;
-                    srcbytes += tex->bufferSize();  // GL memory
-                    if(tex->bufferData()) { srcbytes += tex->bufferSize(); }  // heap memory
-                }
-            }
+            static_cast<RasterSource*>(source.get())->textureCache().forEach([&](const TileID&, const Texture& tex) {
+                ++ntex;
+                srcbytes += tex.bufferSize();  // GL memory
+                if(tex.bufferData()) { srcbytes += tex.bufferSize(); }  // heap memory
+            });
             rasterSizeStr += source->name() + fstring(":%d (%dKB) ", int(ntex), int(srcbytes/1024));
         }
 
@@ -181,9 +181,36 @@ void FrameInfo::draw(RenderState& rs, const View& _view, Map& _map) {
         debuginfos.push_back(fstring("tiles:%d (proxy:%d);", tiles.size(), nproxy) + countsStr);
         debuginfos.push_back(fstring("selectable features:%d; markers:%d", features, scene.markerManager()->markers().size()));
         debuginfos.push_back(fstring("tile size:%dKB", memused / 1024));
-        debuginfos.push_back(fstring("tile cache:%d (%dKB) (max:%dKB)", tileCache.getNumEntries(),
-            tileCache.getMemoryUsage()/1024, tileCache.cacheSizeLimit()/1024));
+        debuginfos.push_back(fstring("tile cache:%d (%dKB) (max:%dKB) hits:%d misses:%d evicted:%d",
+            tileCache.getNumEntries(), tileCache.getMemoryUsage()/1024, tileCache.cacheSizeLimit()/1024,
+            int(tileCache.stats().hits), int(tileCache.stats().misses), int(tileCache.stats().evictions)));
         debuginfos.push_back(rasterSizeStr);
+        auto& uploadStats = scene.tileUploader().stats();
+        debuginfos.push_back(fstring("tile uploads:%d (%dKB, %.2fms) pending:%d",
+            int(uploadStats.tiles), int(uploadStats.bytes/1024), uploadStats.time, int(uploadStats.pending)));
+        auto& queueStats = scene.renderQueue().stats();
+        debuginfos.push_back(fstring("render queue items:%d styles:%d state changes:%d (unsorted:%d)",
+            int(queueStats.items), int(queueStats.styles), int(queueStats.changesSorted),
+            int(queueStats.changesUnsorted)));
+        auto& poolStats = rs.bufferPool.stats();
+        debuginfos.push_back(fstring("buffer pool pages:%d ranges:%d (%dKB used)",
+            int(poolStats.pages), int(poolStats.ranges), int(poolStats.bytesUsed/1024)));
+        auto& programStats = rs.programCache.stats();
+        debuginfos.push_back(fstring("program cache hits:%d misses:%d (rejected:%d)",
+            int(programStats.hits), int(programStats.misses), int(programStats.rejected)));
+        auto workerStats = scene.tileWorker()->stats();
+        debuginfos.push_back(fstring("tile workers - parse:%d (%.1fms avg, %d queued) build:%d (%.1fms avg, %d parsed ahead)",
+            workerStats.parsed, workerStats.parsed ? workerStats.parseTime/workerStats.parsed : 0.f, workerStats.queued,
+            workerStats.built, workerStats.built ? workerStats.buildTime/workerStats.built : 0.f, workerStats.parsedQueued));
+        debuginfos.push_back(fstring("aborted tile builds:%d (%.1fms wasted)",
+            workerStats.aborted, workerStats.abortedTime));
+        if (Hardware::supportsTimerQuery) {
+            std::string gpuTimes = "GPU ms:";
+            for (const auto& section : rs.gpuTimer.sections()) {
+                gpuTimes += fstring(" %s:%.2f", section.name.c_str(), section.time);
+            }
+            debuginfos.push_back(gpuTimes);
+        }
 #ifdef DEBUG
 #ifdef TANGRAM_LINUX // || defined(TANGRAM_ANDROID) -- also supported on Android
         struct mallinfo2 mi;
@@ -203,6 +230,10 @@ void FrameInfo::draw(RenderState& rs, const View& _view, Map& _map) {
 #endif
         debuginfos.push_back(fstring("pending downloads:%d (%dKB downloaded)",
             _map.getPlatform().activeUrlRequests(), _map.getPlatform().bytesDownloaded/1024));
+        for (const auto& limiter : RequestLimiter::allStats()) {
+            debuginfos.push_back(fstring("tile requests %s - limit:%.1f active:%d queued:%d",
+                limiter.host.c_str(), limiter.limit, limiter.active, limiter.queued));
+        }
 
         if (!profInfos.empty()) {
             end("_Frame");
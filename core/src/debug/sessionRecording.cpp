@@ -0,0 +1,315 @@
+#include "debug/sessionRecording.h"
+
+#include "log.h"
+#include "platform.h"
+#include "sceneOptions.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace Tangram {
+
+static const char HEADER[] = "tangram-session 1\n";
+
+void SessionRecording::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    frames.clear();
+    calls.clear();
+    responses.clear();
+    m_recording = true;
+}
+
+void SessionRecording::addFrame(float _dt) {
+    if (!recording()) { return; }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_recording) { frames.push_back(_dt); }
+}
+
+void SessionRecording::addCall(const char* _name, std::vector<double> _numbers,
+                               std::vector<std::string> _strings) {
+    if (!recording()) { return; }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording) { return; }
+    calls.push_back({ uint32_t(frames.size()), _name, std::move(_numbers), std::move(_strings) });
+}
+
+void SessionRecording::addResponse(const std::string& _url, const UrlResponse& _response) {
+    if (!recording()) { return; }
+    // Requests canceled while recording may not be canceled in a replay
+    if (_response.error == Platform::cancel_message) { return; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_recording) { return; }
+    responses.push_back({ _url, _response.content, _response.error ? _response.error : "" });
+}
+
+/* Format: a header line, then for each
+ * - frame:    "f <dt>\n"
+ * - call:     "c <frame> <name> <number count> <numbers> <string count> <string lengths>\n",
+ *             the strings and "\n"
+ * - response: "r <url length> <content length> <error length>\n", url, content, error and "\n"
+ */
+std::string SessionRecording::stop() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_recording = false;
+
+    std::string out = HEADER;
+    char buffer[64];
+
+    for (float dt : frames) {
+        snprintf(buffer, sizeof(buffer), "f %.9g\n", dt);
+        out += buffer;
+    }
+    for (const auto& call : calls) {
+        snprintf(buffer, sizeof(buffer), "c %u ", call.frame);
+        out += buffer;
+        out += call.name;
+        out += ' ' + std::to_string(call.numbers.size());
+        for (double number : call.numbers) {
+            snprintf(buffer, sizeof(buffer), " %.17g", number);
+            out += buffer;
+        }
+        out += ' ' + std::to_string(call.strings.size());
+        for (const auto& string : call.strings) { out += ' ' + std::to_string(string.size()); }
+        out += '\n';
+        for (const auto& string : call.strings) { out += string; }
+        out += '\n';
+    }
+    for (const auto& response : responses) {
+        snprintf(buffer, sizeof(buffer), "r %zu %zu %zu\n", response.url.size(),
+                 response.content.size(), response.error.size());
+        out += buffer;
+        out += response.url;
+        out.append(response.content.data(), response.content.size());
+        out += response.error;
+        out += '\n';
+    }
+    return out;
+}
+
+bool SessionRecording::load(const std::string& _data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    frames.clear();
+    calls.clear();
+    responses.clear();
+
+    size_t headerLength = strlen(HEADER);
+    if (_data.compare(0, headerLength, HEADER) != 0) { return false; }
+    size_t pos = headerLength;
+
+    // Take @_length bytes at pos
+    auto take = [&](size_t _length, std::string& _out) {
+        if (_length > _data.size() - pos) { return false; }
+        _out.assign(_data, pos, _length);
+        pos += _length;
+        return true;
+    };
+    auto takeNewline = [&]() {
+        if (pos >= _data.size() || _data[pos] != '\n') { return false; }
+        pos++;
+        return true;
+    };
+
+    while (pos < _data.size()) {
+        size_t end = _data.find('\n', pos);
+        if (end == std::string::npos) { return false; }
+        std::istringstream line(_data.substr(pos, end - pos));
+        pos = end + 1;
+
+        char type = 0;
+        line >> type;
+        if (type == 'f') {
+            float dt = 0;
+            if (!(line >> dt)) { return false; }
+            frames.push_back(dt);
+
+        } else if (type == 'c') {
+            Call call;
+            size_t count = 0;
+            if (!(line >> call.frame >> call.name >> count)) { return false; }
+            call.numbers.resize(count);
+            for (auto& number : call.numbers) {
+                if (!(line >> number)) { return false; }
+            }
+            if (!(line >> count)) { return false; }
+            std::vector<size_t> lengths(count);
+            for (auto& length : lengths) {
+                if (!(line >> length)) { return false; }
+            }
+            call.strings.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                if (!take(lengths[i], call.strings[i])) { return false; }
+            }
+            if (!takeNewline()) { return false; }
+            calls.push_back(std::move(call));
+
+        } else if (type == 'r') {
+            Response response;
+            size_t urlLength = 0, contentLength = 0, errorLength = 0;
+            if (!(line >> urlLength >> contentLength >> errorLength)) { return false; }
+            std::string content;
+            if (!take(urlLength, response.url) || !take(contentLength, content) ||
+                !take(errorLength, response.error) || !takeNewline()) {
+                return false;
+            }
+            response.content.assign(content.begin(), content.end());
+            responses.push_back(std::move(response));
+
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+MarkerID SessionPlayer::marker(double _recorded) const {
+    auto it = m_markers.find(MarkerID(_recorded));
+    return it != m_markers.end() ? it->second : 0;
+}
+
+void SessionPlayer::applyCalls(Map& _map, uint32_t _frame) {
+    const auto& calls = m_recording.calls;
+
+    for (; m_nextCall < calls.size() && calls[m_nextCall].frame <= _frame; m_nextCall++) {
+        const auto& call = calls[m_nextCall];
+        const auto& name = call.name;
+        const auto& n = call.numbers;
+        const auto& s = call.strings;
+
+        auto has = [&](size_t _numbers, size_t _strings) {
+            return n.size() >= _numbers && s.size() >= _strings;
+        };
+        auto camera = [&]() {
+            CameraPosition position;
+            position.longitude = n[0];
+            position.latitude = n[1];
+            position.zoom = float(n[2]);
+            position.rotation = float(n[3]);
+            position.tilt = float(n[4]);
+            return position;
+        };
+        auto updates = [&](size_t _first) {
+            std::vector<SceneUpdate> result;
+            for (size_t i = _first; i + 1 < s.size(); i += 2) { result.push_back({ s[i], s[i + 1] }); }
+            return result;
+        };
+        auto coordinates = [&](size_t _first, size_t _count) {
+            std::vector<LngLat> result;
+            for (size_t i = _first; i + 1 < n.size() && result.size() < _count; i += 2) {
+                result.emplace_back(n[i], n[i + 1]);
+            }
+            return result;
+        };
+
+        if (name == "handleTapGesture" && has(2, 0)) {
+            _map.handleTapGesture(float(n[0]), float(n[1]));
+        } else if (name == "handleDoubleTapGesture" && has(3, 0)) {
+            _map.handleDoubleTapGesture(float(n[0]), float(n[1]), n[2] != 0);
+        } else if (name == "handlePanGesture" && has(4, 0)) {
+            _map.handlePanGesture(float(n[0]), float(n[1]), float(n[2]), float(n[3]));
+        } else if (name == "handleFlingGesture" && has(4, 0)) {
+            _map.handleFlingGesture(float(n[0]), float(n[1]), float(n[2]), float(n[3]));
+        } else if (name == "handlePinchGesture" && has(4, 0)) {
+            _map.handlePinchGesture(float(n[0]), float(n[1]), float(n[2]), float(n[3]));
+        } else if (name == "handleRotateGesture" && has(3, 0)) {
+            _map.handleRotateGesture(float(n[0]), float(n[1]), float(n[2]));
+        } else if (name == "handleShoveGesture" && has(1, 0)) {
+            _map.handleShoveGesture(float(n[0]));
+        } else if (name == "handleTouchEvent" && has(5, 0)) {
+            _map.handleTouchEvent(int(n[0]), float(n[1]), float(n[2]), float(n[3]), float(n[4]));
+
+        } else if (name == "setCameraPosition" && has(5, 0)) {
+            _map.setCameraPosition(camera());
+        } else if (name == "setCameraPositionEased" && has(7, 0)) {
+            _map.setCameraPositionEased(camera(), float(n[5]), EaseType(int(n[6])));
+        } else if (name == "flyTo" && has(7, 0)) {
+            _map.flyTo(camera(), float(n[5]), float(n[6]));
+        } else if (name == "setPosition" && has(2, 0)) {
+            _map.setPosition(n[0], n[1]);
+        } else if (name == "setZoom" && has(1, 0)) {
+            _map.setZoom(float(n[0]));
+        } else if (name == "setRotation" && has(1, 0)) {
+            _map.setRotation(float(n[0]));
+        } else if (name == "setTilt" && has(1, 0)) {
+            _map.setTilt(float(n[0]));
+        } else if (name == "setCameraType" && has(1, 0)) {
+            _map.setCameraType(int(n[0]));
+        } else if (name == "setViewport" && has(4, 0)) {
+            _map.setViewport(int(n[0]), int(n[1]), int(n[2]), int(n[3]));
+        } else if (name == "setPixelScale" && has(1, 0)) {
+            _map.setPixelScale(float(n[0]));
+
+        } else if (name == "loadScene" && has(2, 2)) {
+            bool useScenePosition = n[1] != 0;
+            if (s[1].empty()) {
+                _map.loadScene(SceneOptions{ Url(s[0]), useScenePosition, updates(2) }, n[0] != 0);
+            } else {
+                _map.loadScene(SceneOptions{ s[1], Url(s[0]), useScenePosition, updates(2) }, n[0] != 0);
+            }
+        } else if (name == "updateGlobals" && has(1, 0)) {
+            _map.updateGlobals(updates(0), n[0] != 0);
+
+        } else if (name == "markerAdd" && has(1, 0)) {
+            m_markers[MarkerID(n[0])] = _map.markerAdd();
+        } else if (name == "markerRemove" && has(1, 0)) {
+            _map.markerRemove(marker(n[0]));
+            m_markers.erase(MarkerID(n[0]));
+        } else if (name == "markerRemoveAll") {
+            _map.markerRemoveAll();
+            m_markers.clear();
+        } else if (name == "markerSetStylingFromString" && has(1, 1)) {
+            _map.markerSetStylingFromString(marker(n[0]), s[0].c_str());
+        } else if (name == "markerSetStylingFromPath" && has(1, 1)) {
+            _map.markerSetStylingFromPath(marker(n[0]), s[0].c_str());
+        } else if (name == "markerSetPoint" && has(3, 0)) {
+            _map.markerSetPoint(marker(n[0]), LngLat(n[1], n[2]));
+        } else if (name == "markerSetPointEased" && has(5, 0)) {
+            _map.markerSetPointEased(marker(n[0]), LngLat(n[1], n[2]), float(n[3]), EaseType(int(n[4])));
+        } else if (name == "markerSetPolyline" && has(1, 0)) {
+            auto points = coordinates(1, n.size());
+            _map.markerSetPolyline(marker(n[0]), points.data(), int(points.size()));
+        } else if (name == "markerSetPolylineTrim" && has(3, 0)) {
+            _map.markerSetPolylineTrim(marker(n[0]), int(n[1]), float(n[2]));
+        } else if (name == "markerSetPolygon" && has(2, 0) && n.size() >= 2 + size_t(n[1])) {
+            // rings, the point count of each ring and the points
+            std::vector<int> counts(n.begin() + 2, n.begin() + 2 + size_t(n[1]));
+            auto points = coordinates(2 + counts.size(), n.size());
+            _map.markerSetPolygon(marker(n[0]), points.data(), counts.data(), int(counts.size()));
+        } else if (name == "markerSetVisible" && has(2, 0)) {
+            _map.markerSetVisible(marker(n[0]), n[1] != 0);
+        } else if (name == "markerSetDrawOrder" && has(2, 0)) {
+            _map.markerSetDrawOrder(marker(n[0]), int(n[1]));
+        } else if (name == "markerSetAlternate" && has(2, 0)) {
+            _map.markerSetAlternate(marker(n[0]), marker(n[1]));
+
+        } else {
+            LOGW("Skipping unknown or incomplete call '%s' of the recording", name.c_str());
+        }
+    }
+}
+
+bool SessionPlayer::response(const std::string& _url, UrlResponse& _response) {
+    std::lock_guard<std::mutex> lock(m_responseMutex);
+
+    if (!m_responsesIndexed) {
+        for (size_t i = 0; i < m_recording.responses.size(); i++) {
+            m_responses[m_recording.responses[i].url].first.push_back(i);
+        }
+        m_responsesIndexed = true;
+    }
+
+    auto it = m_responses.find(_url);
+    if (it == m_responses.end()) { return false; }
+
+    auto& entry = it->second;
+    const auto& recorded = m_recording.responses[entry.first[std::min(entry.second, entry.first.size() - 1)]];
+    entry.second++;
+
+    _response.content = recorded.content;
+    _response.error = recorded.error.empty() ? nullptr : recorded.error.c_str();
+    return true;
+}
+
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "map.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+struct UrlResponse;
+
+/* Timed Map API calls and URL responses of a session, to replay it, e.g. with tangram-replay
+ *
+ * Calls are stamped with their frame - the number of Map::update() calls before them - and the
+ * time step of each update is kept, so that a replay makes the same calls between the same
+ * updates with the same time steps. Responses are kept by URL in the order they arrived; a
+ * replay serves them instead of loading the URLs.
+ *
+ * Adding to a recording is thread-safe and does nothing while it is not started.
+ */
+class SessionRecording {
+
+public:
+
+    struct Call {
+        uint32_t frame = 0;
+        std::string name;
+        std::vector<double> numbers;
+        std::vector<std::string> strings;
+    };
+
+    struct Response {
+        std::string url;
+        std::vector<char> content;
+        std::string error;
+    };
+
+    void start();
+
+    /* Stop recording; returns the recording in the format read by load() */
+    std::string stop();
+
+    bool recording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    void addFrame(float _dt);
+    void addCall(const char* _name, std::vector<double> _numbers, std::vector<std::string> _strings = {});
+    void addResponse(const std::string& _url, const UrlResponse& _response);
+
+    /* Read a recording returned by stop(); false if @_data is not one */
+    bool load(const std::string& _data);
+
+    // Time step of each update
+    std::vector<float> frames;
+    // Ordered by frame
+    std::vector<Call> calls;
+    // Ordered by arrival
+    std::vector<Response> responses;
+
+private:
+
+    std::mutex m_mutex;
+    std::atomic<bool> m_recording{false};
+};
+
+/* Makes the calls of a SessionRecording on a Map, frame by frame, and serves its responses
+ *
+ * Markers get the IDs of the replaying Map; calls for recorded marker IDs are passed on to
+ * the markers added in their place.
+ */
+class SessionPlayer {
+
+public:
+
+    explicit SessionPlayer(const SessionRecording& _recording) : m_recording(_recording) {}
+
+    /* Make the calls recorded before update @_frame and not made yet */
+    void applyCalls(Map& _map, uint32_t _frame);
+
+    /* Set @_response to the next recorded response for @_url, repeating the last one when
+     * the URL is loaded more often than recorded; false if it was not recorded. Thread-safe. */
+    bool response(const std::string& _url, UrlResponse& _response);
+
+private:
+
+    MarkerID marker(double _recorded) const;
+
+    const SessionRecording& m_recording;
+    size_t m_nextCall = 0;
+    std::unordered_map<MarkerID, MarkerID> m_markers;
+
+    std::mutex m_responseMutex;
+    // Recorded responses of each URL and the index of the next one to serve
+    std::unordered_map<std::string, std::pair<std::vector<size_t>, size_t>> m_responses;
+    bool m_responsesIndexed = false;
+};
+
+}
@@ -106,7 +106,7 @@ void TextDisplay::draw(RenderState& rs, const View& _view, const std::vector<std
             m_vaos.initialize(rs, {{0,0}}, vertexLayout, m_VBO, 0);
             m_rs = &rs;
         }
-        m_vaos.bind(0);
+        m_vaos.bind(rs, 0);
     }
     rs.vertexBuffer(m_VBO);
 
@@ -147,7 +147,6 @@ void TextDisplay::draw(RenderState& rs, const View& _view, const std::vector<std
 
     rs.culling(GL_TRUE);
     rs.vertexBuffer(0);  //boundbuffer);
-    if (m_VBO) { m_vaos.unbind(); }
 }
 
 }
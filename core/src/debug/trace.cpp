@@ -0,0 +1,182 @@
+#include "debug/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+    uint64_t id;
+    char phase;
+    Trace::Args args;
+};
+
+struct ThreadBuffer {
+    // Only contended while exporting
+    std::mutex mutex;
+    std::vector<Event> events;
+    size_t next = 0;
+    bool wrapped = false;
+    // Recording session of the events
+    uint64_t session = 0;
+    uint32_t tid = 0;
+    const char* name = nullptr;
+};
+
+}
+
+static const auto s_epoch = std::chrono::steady_clock::now();
+
+static std::mutex s_registryMutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+static uint32_t s_nextTid = 1;
+
+static std::atomic<uint64_t> s_session{0};
+static std::atomic<size_t> s_capacity{0};
+static std::atomic<uint64_t> s_nextFlowId{1};
+
+static thread_local std::shared_ptr<ThreadBuffer> t_buffer;
+
+static ThreadBuffer& threadBuffer() {
+    if (!t_buffer) {
+        t_buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        t_buffer->tid = s_nextTid++;
+        s_buffers.push_back(t_buffer);
+    }
+    return *t_buffer;
+}
+
+static void record(const Event& _event) {
+    auto& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+
+    uint64_t session = s_session;
+    if (buffer.session != session) {
+        buffer.events.assign(s_capacity, Event{});
+        buffer.next = 0;
+        buffer.wrapped = false;
+        buffer.session = session;
+    }
+    if (buffer.events.empty()) { return; }
+
+    buffer.events[buffer.next] = _event;
+    if (++buffer.next == buffer.events.size()) {
+        buffer.next = 0;
+        buffer.wrapped = true;
+    }
+}
+
+void Trace::start(size_t _eventsPerThread) {
+    s_capacity = std::max<size_t>(_eventsPerThread, 1);
+    s_session++;
+    s_enabled = true;
+}
+
+std::string Trace::stop() {
+    s_enabled = false;
+    uint64_t session = s_session;
+
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+    char event[256];
+    auto append = [&]() {
+        if (!first) { json += ",\n"; }
+        json += event;
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> registryLock(s_registryMutex);
+    for (auto& buffer : s_buffers) {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+
+        if (buffer->name) {
+            snprintf(event, sizeof(event),
+                     R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":"%s"}})",
+                     buffer->tid, buffer->name);
+            append();
+        }
+        if (buffer->session != session) { continue; }
+
+        size_t count = buffer->wrapped ? buffer->events.size() : buffer->next;
+        size_t begin = buffer->wrapped ? buffer->next : 0;
+        for (size_t i = 0; i < count; i++) {
+            const Event& e = buffer->events[(begin + i) % buffer->events.size()];
+            if (e.phase == 'X') {
+                int length = snprintf(event, sizeof(event),
+                                      R"({"name":"%s","ph":"X","ts":%.3f,"dur":%.3f,"pid":1,"tid":%u)",
+                                      e.name, e.start / 1000., e.duration / 1000., buffer->tid);
+                bool hasArgs = false;
+                for (int arg = 0; arg < 2; arg++) {
+                    if (!e.args.names[arg] || length >= int(sizeof(event))) { continue; }
+                    length += snprintf(event + length, sizeof(event) - length, R"(%s"%s":%)" PRIu64,
+                                       hasArgs ? "," : R"(,"args":{)", e.args.names[arg], e.args.values[arg]);
+                    hasArgs = true;
+                }
+                if (length < int(sizeof(event))) {
+                    snprintf(event + length, sizeof(event) - length, "%s", hasArgs ? "}}" : "}");
+                }
+            } else {
+                snprintf(event, sizeof(event),
+                         R"({"name":"tile","cat":"tile","ph":"%c","id":%)" PRIu64
+                         R"(,"ts":%.3f,"pid":1,"tid":%u,"bp":"e"})",
+                         e.phase, e.id, e.start / 1000., buffer->tid);
+            }
+            append();
+        }
+        buffer->events = std::vector<Event>();
+        buffer->session = 0;
+    }
+
+    // Drop buffers of threads which exited
+    s_buffers.erase(std::remove_if(s_buffers.begin(), s_buffers.end(),
+                                   [](auto& buffer) { return buffer.use_count() == 1; }),
+                    s_buffers.end());
+
+    json += "]}\n";
+    return json;
+}
+
+void Trace::setThreadName(const char* _name) {
+    auto& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.name = _name;
+}
+
+uint64_t Trace::newFlowId() {
+    return enabled() ? s_nextFlowId++ : 0;
+}
+
+uint64_t Trace::now() {
+    auto elapsed = std::chrono::steady_clock::now() - s_epoch;
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Trace::complete(const char* _name, uint64_t _start, uint64_t _end) {
+    if (!enabled()) { return; }
+    record(Event{_name, _start, _end - _start, 0, 'X', {}});
+}
+
+void Trace::complete(const char* _name, uint64_t _start, uint64_t _end, const Args& _args) {
+    if (!enabled()) { return; }
+    record(Event{_name, _start, _end - _start, 0, 'X', _args});
+}
+
+void Trace::flow(uint64_t _id, Flow _phase) {
+    if (!enabled() || _id == 0) { return; }
+    record(Event{nullptr, now(), 0, _id, char(_phase), {}});
+}
+
+}
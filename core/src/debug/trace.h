@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Tangram {
+
+/* Scoped trace events of the render, update, tile worker, network and I/O threads
+ *
+ * Nothing is recorded unless tracing was started. Events go to a ring buffer of the calling
+ * thread, which only the export locks, and keep pointers to their names: names must be string
+ * literals. stop() returns the events in the Chrome trace event format, which chrome://tracing
+ * and ui.perfetto.dev open.
+ *
+ * The stages of a tile - request, data, parse, build, upload and first draw - are linked by flow
+ * events with the trace id of its TileTask, so the timeline shows where each tile waited.
+ */
+class Trace {
+public:
+    enum class Flow : char { start = 's', step = 't', end = 'f' };
+
+    /* Start recording, keeping the last @_eventsPerThread events of each thread */
+    static void start(size_t _eventsPerThread = 1 << 16);
+
+    /* Stop recording; returns the recorded events as Chrome trace JSON */
+    static std::string stop();
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /* Name of the calling thread in the exported trace; @_name must be a string literal */
+    static void setThreadName(const char* _name);
+
+    /* New id for the flow events of a tile, 0 when not recording */
+    static uint64_t newFlowId();
+
+    /* Nanoseconds on the trace clock */
+    static uint64_t now();
+
+    /* Add an event @_name from @_start to @_end on the calling thread */
+    static void complete(const char* _name, uint64_t _start, uint64_t _end);
+
+    /* Numbers shown with a complete event; names must be string literals, unset args are null */
+    struct Args {
+        const char* names[2] = { nullptr, nullptr };
+        uint64_t values[2] = { 0, 0 };
+    };
+    static void complete(const char* _name, uint64_t _start, uint64_t _end, const Args& _args);
+
+    /* Add a flow event of tile @_id, bound to the enclosing event of the calling thread */
+    static void flow(uint64_t _id, Flow _phase);
+
+    struct Scope {
+        const char* name;
+        uint64_t start;
+        Args args;
+        explicit Scope(const char* _name) : name(_name), start(enabled() ? now() : 0) {}
+        ~Scope() { if (start) { complete(name, start, now(), args); } }
+    };
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ::Tangram::Trace::Scope TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+}
@@ -53,6 +53,7 @@ typedef float           GLclampf;   /*single precision float in [0,1] */
 typedef double          GLdouble;   /* double precision float */
 typedef double          GLclampd;   /* double precision float in [0,1] */
 typedef char            GLchar;
+typedef struct __GLsync *GLsync;
 
 /* Utility */
 #define GL_VENDOR                       0x1F00
@@ -88,6 +89,7 @@ typedef char            GLchar;
 #define GL_3_BYTES                      0x1408
 #define GL_4_BYTES                      0x1409
 #define GL_DOUBLE                       0x140A
+#define GL_HALF_FLOAT                   0x140B
 
 /* Primitives */
 #define GL_POINTS                       0x0000
@@ -143,9 +145,11 @@ typedef char            GLchar;
 #define GL_R8                           0x8229
 #define GL_RGB8                         0x8051
 #define GL_RGBA8                        0x8058
+#define GL_R16F                         0x822D
 #define GL_R32F                         0x822E
 #define GL_R32UI                        0x8236
 #define GL_RED_INTEGER                  0x8D94
+#define GL_UNPACK_ALIGNMENT             0x0CF5
 
 #define GL_NEAREST                      0x2600
 #define GL_LINEAR                       0x2601
@@ -229,6 +233,8 @@ typedef char            GLchar;
 #define GL_NEAREST                      0x2600
 #define GL_TEXTURE0                     0x84C0
 #define GL_TEXTURE_2D                   0x0DE1
+#define GL_TEXTURE_BINDING_2D           0x8069
+#define GL_TEXTURE_2D_ARRAY             0x8C1A
 #define GL_TEXTURE_WRAP_S               0x2802
 #define GL_TEXTURE_WRAP_T               0x2803
 #define GL_TEXTURE_MAG_FILTER           0x2800
@@ -256,6 +262,8 @@ typedef char            GLchar;
 #define GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS 0x8CD9
 #define GL_FRAMEBUFFER_UNSUPPORTED      0x8CDD
 #define GL_FRAMEBUFFER_BINDING          0x8CA6
+#define GL_READ_FRAMEBUFFER             0x8CA8
+#define GL_DRAW_FRAMEBUFFER             0x8CA9
 #define GL_RENDERBUFFER_BINDING         0x8CA7
 #define GL_MAX_RENDERBUFFER_SIZE        0x84E8
 #define GL_INVALID_FRAMEBUFFER_OPERATION 0x0506
@@ -280,11 +288,43 @@ typedef char            GLchar;
 #define GL_LINK_STATUS                  0x8B82
 #define GL_INFO_LOG_LENGTH              0x8B84
 
+// get_program_binary
+#define GL_PROGRAM_BINARY_LENGTH        0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS   0x87FE
+#define GL_PROGRAM_BINARY_FORMATS       0x87FF
+
+// compressed textures
+#define GL_ETC1_RGB8_OES                    0x8D64
+#define GL_COMPRESSED_RGB8_ETC2             0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC        0x9278
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT     0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR     0x93B0
+
 // mapbuffer
 #define GL_READ_ONLY                    0x88B8
 #define GL_WRITE_ONLY                   0x88B9
 #define GL_READ_WRITE                   0x88BA
 
+// uniform buffer objects
+#define GL_UNIFORM_BUFFER               0x8A11
+#define GL_INVALID_INDEX                0xFFFFFFFFu
+
+// map_buffer_range, sync objects
+#define GL_MAP_READ_BIT                 0x0001
+#define GL_SYNC_GPU_COMMANDS_COMPLETE   0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT      0x00000001
+#define GL_ALREADY_SIGNALED             0x911A
+#define GL_TIMEOUT_EXPIRED              0x911B
+#define GL_CONDITION_SATISFIED          0x911C
+#define GL_WAIT_FAILED                  0x911D
+
+// timer queries
+#define GL_TIME_ELAPSED                 0x88BF
+#define GL_QUERY_RESULT                 0x8866
+#define GL_QUERY_RESULT_AVAILABLE       0x8867
+#define GL_GPU_DISJOINT                 0x8FBB
+
 #define GL_MAX_TEXTURE_SIZE             0x0D33
 #define GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS 0x8B4D
 
@@ -331,6 +371,9 @@ struct GL {
     static void bindAttribLocation(GLuint program, GLuint index, const GLchar *name);
     static void getProgramiv(GLuint program, GLenum pname, GLint *params);
     static void getShaderiv(GLuint shader, GLenum pname, GLint *params);
+    static void getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                                 GLenum *binaryFormat, void *binary);
+    static void programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
 
     // Buffers
     static void bindBuffer(GLenum target, GLuint buffer);
@@ -339,6 +382,11 @@ struct GL {
     static void bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
     static void bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 
+    // GL 3 uniform buffers
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    static GLuint getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName);
+    static void uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+
     // Framebuffers
     static void bindFramebuffer(GLenum target, GLuint framebuffer);
     static void genFramebuffers(GLsizei n, GLuint *framebuffers);
@@ -370,12 +418,19 @@ struct GL {
     static void genTextures(GLsizei n, GLuint *textures );
     static void deleteTextures(GLsizei n, const GLuint *textures);
     static void texParameteri(GLenum target, GLenum pname, GLint param );
+    static void pixelStorei(GLenum pname, GLint param);
     static void texImage2D(GLenum target, GLint level,
                            GLint internalFormat,
                            GLsizei width, GLsizei height,
                            GLint border, GLenum format, GLenum type,
                            const GLvoid *pixels);
 
+    static void compressedTexImage2D(GLenum target, GLint level,
+                                     GLenum internalFormat,
+                                     GLsizei width, GLsizei height,
+                                     GLint border, GLsizei imageSize,
+                                     const GLvoid *data);
+
     static void texSubImage2D(GLenum target, GLint level,
                               GLint xoffset, GLint yoffset,
                               GLsizei width, GLsizei height,
@@ -384,6 +439,29 @@ struct GL {
 
     static void generateMipmap(GLenum target);
 
+    // GL 3 texture arrays
+    static void texImage3D(GLenum target, GLint level, GLint internalFormat,
+                           GLsizei width, GLsizei height, GLsizei depth,
+                           GLint border, GLenum format, GLenum type,
+                           const GLvoid *pixels);
+
+    static void texSubImage3D(GLenum target, GLint level,
+                              GLint xoffset, GLint yoffset, GLint zoffset,
+                              GLsizei width, GLsizei height, GLsizei depth,
+                              GLenum format, GLenum type,
+                              const GLvoid *pixels);
+
+    static void compressedTexImage3D(GLenum target, GLint level, GLenum internalFormat,
+                                     GLsizei width, GLsizei height, GLsizei depth,
+                                     GLint border, GLsizei imageSize,
+                                     const GLvoid *data);
+
+    static void compressedTexSubImage3D(GLenum target, GLint level,
+                                        GLint xoffset, GLint yoffset, GLint zoffset,
+                                        GLsizei width, GLsizei height, GLsizei depth,
+                                        GLenum format, GLsizei imageSize,
+                                        const GLvoid *data);
+
 
     static void enableVertexAttribArray(GLuint index);
     static void disableVertexAttribArray(GLuint index);
@@ -394,6 +472,11 @@ struct GL {
     static void drawElements(GLenum mode, GLsizei count,
                              GLenum type, const GLvoid *indices );
 
+    // GL 3 instanced drawing
+    static void vertexAttribDivisor(GLuint index, GLuint divisor);
+    static void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                      const GLvoid *indices, GLsizei instancecount);
+
     static void uniform1f(GLint location, GLfloat v0);
     static void uniform2f(GLint location, GLfloat v0, GLfloat v1);
     static void uniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2);
@@ -421,6 +504,23 @@ struct GL {
     static void *mapBuffer(GLenum target, GLenum access);
     static GLboolean unmapBuffer(GLenum target);
 
+    // GL 3 buffer ranges, sync objects and blits, for reading pixels asynchronously
+    static void *mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    static GLsync fenceSync(GLenum condition, GLbitfield flags);
+    static GLenum clientWaitSync(GLsync sync, GLbitfield flags, unsigned long long timeout);
+    static void deleteSync(GLsync sync);
+    static void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                                GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                                GLbitfield mask, GLenum filter);
+
+    // GL 3.3 / ARB_timer_query and EXT_disjoint_timer_query, for GpuTimer
+    static void genQueries(GLsizei n, GLuint *ids);
+    static void deleteQueries(GLsizei n, const GLuint *ids);
+    static void beginQuery(GLenum target, GLuint id);
+    static void endQuery(GLenum target);
+    static void getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params);
+    static void getQueryObjectui64v(GLuint id, GLenum pname, unsigned long long *params);
+
     static void finish(void);
 
     static void readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
@@ -0,0 +1,173 @@
+#include "gl/bufferPool.h"
+
+#include "gl/renderState.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+BufferPool::~BufferPool() {
+    for (auto& entry : m_pages) {
+        GL::deleteBuffers(1, &entry.second.buffer);
+    }
+}
+
+static void bindBuffer(RenderState& rs, GLenum _target, GLuint _buffer) {
+    if (_target == GL_ELEMENT_ARRAY_BUFFER) {
+        rs.indexBuffer(_buffer);
+    } else {
+        rs.vertexBuffer(_buffer);
+    }
+}
+
+BufferPool::Range BufferPool::allocate(RenderState& rs, GLenum _target, GLsizeiptr _size,
+                                       const void* _data) {
+    Range range;
+
+    if (_size <= 0 || _size > MAX_RANGE_SIZE) { return range; }
+
+    // Ranges released since the last frame can be reused right away
+    collect(rs);
+
+    GLsizeiptr size = (_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    uint32_t pageId = 0;
+    GLintptr offset = 0;
+    for (auto& entry : m_pages) {
+        if (entry.second.target == _target && take(entry.second, size, offset)) {
+            pageId = entry.first;
+            break;
+        }
+    }
+
+    if (pageId == 0) {
+        Page page;
+        page.target = _target;
+        page.buffer = 0;
+        GL::genBuffers(1, &page.buffer);
+        bindBuffer(rs, _target, page.buffer);
+        GL::bufferData(_target, PAGE_SIZE, nullptr, GL_STATIC_DRAW);
+        page.free.push_back({ 0, PAGE_SIZE });
+        take(page, size, offset);
+
+        pageId = m_nextPage++;
+        m_pages.emplace(pageId, std::move(page));
+        m_stats.pages++;
+    }
+
+    auto& page = m_pages[pageId];
+    page.ranges++;
+
+    bindBuffer(rs, _target, page.buffer);
+    GL::bufferSubData(_target, offset, _size, _data);
+
+    range.buffer = page.buffer;
+    range.page = pageId;
+    range.generation = m_generation;
+    range.offset = offset;
+    range.size = size;
+
+    m_stats.ranges++;
+    m_stats.bytesUsed += size;
+
+    return range;
+}
+
+void BufferPool::release(const Range& _range) {
+    if (!_range) { return; }
+
+    std::lock_guard<std::mutex> lock(m_releaseMutex);
+    m_released.push_back(_range);
+}
+
+void BufferPool::collect(RenderState& rs) {
+
+    std::vector<Range> released;
+    {
+        std::lock_guard<std::mutex> lock(m_releaseMutex);
+        if (m_released.empty()) { return; }
+        released.swap(m_released);
+    }
+
+    for (const auto& range : released) {
+        if (range.generation != m_generation) { continue; }
+
+        auto it = m_pages.find(range.page);
+        if (it == m_pages.end()) { continue; }
+
+        give(it->second, range.offset, range.size);
+        it->second.ranges--;
+
+        m_stats.ranges--;
+        m_stats.bytesUsed -= range.size;
+    }
+
+    // Delete empty pages except the first one of each target
+    bool spareVertexPage = false;
+    bool spareIndexPage = false;
+    for (auto it = m_pages.begin(); it != m_pages.end();) {
+        auto& page = it->second;
+        if (page.ranges == 0) {
+            bool& spare = page.target == GL_ELEMENT_ARRAY_BUFFER ? spareIndexPage : spareVertexPage;
+            if (spare) {
+                // Unbind first so that RenderState does not skip binding a reused handle
+                bindBuffer(rs, page.target, 0);
+                GL::deleteBuffers(1, &page.buffer);
+                it = m_pages.erase(it);
+                m_stats.pages--;
+                continue;
+            }
+            spare = true;
+        }
+        ++it;
+    }
+}
+
+void BufferPool::invalidate() {
+    {
+        std::lock_guard<std::mutex> lock(m_releaseMutex);
+        m_released.clear();
+    }
+    m_pages.clear();
+    m_generation++;
+    m_stats = Stats();
+}
+
+bool BufferPool::take(Page& _page, GLsizeiptr _size, GLintptr& _offset) {
+    // First fit
+    for (auto it = _page.free.begin(); it != _page.free.end(); ++it) {
+        if (it->size < _size) { continue; }
+
+        _offset = it->offset;
+        it->offset += _size;
+        it->size -= _size;
+        if (it->size == 0) { _page.free.erase(it); }
+        return true;
+    }
+    return false;
+}
+
+void BufferPool::give(Page& _page, GLintptr _offset, GLsizeiptr _size) {
+    auto& free = _page.free;
+
+    auto next = std::lower_bound(free.begin(), free.end(), _offset,
+                                 [](const Block& b, GLintptr offset) { return b.offset < offset; });
+
+    // Merge with the previous and the next free block when adjacent
+    bool mergePrev = next != free.begin() && (next - 1)->offset + (next - 1)->size == _offset;
+    bool mergeNext = next != free.end() && _offset + _size == next->offset;
+
+    if (mergePrev && mergeNext) {
+        (next - 1)->size += _size + next->size;
+        free.erase(next);
+    } else if (mergePrev) {
+        (next - 1)->size += _size;
+    } else if (mergeNext) {
+        next->offset = _offset;
+        next->size += _size;
+    } else {
+        free.insert(next, { _offset, _size });
+    }
+}
+
+}
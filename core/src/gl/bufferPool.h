@@ -0,0 +1,107 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+
+/*
+ * BufferPool - Large GL buffers shared by static meshes
+ *
+ * Instead of creating a vertex and an index buffer object for each mesh, static meshes take
+ * ranges of pages, i.e. buffers of PAGE_SIZE bytes that are created once per target and
+ * kept while any of their ranges is in use. Free space of a page is tracked in a list of
+ * blocks sorted by offset which are merged with their neighbours when ranges are released.
+ *
+ * Meshes draw from their range by offsetting attribute pointers and index offsets by the
+ * range offset, which works without base vertex support of the driver (GLES 2).
+ *
+ * allocate() and collect() must be called on the GL thread; release() can be called from
+ * any thread, released ranges become available on the next collect().
+ */
+class BufferPool {
+
+public:
+
+    // Bytes per page; larger ranges are not pooled
+    static constexpr GLsizeiptr PAGE_SIZE = 4 * 1024 * 1024;
+    static constexpr GLsizeiptr MAX_RANGE_SIZE = PAGE_SIZE / 4;
+
+    // Ranges start at multiples of ALIGNMENT bytes, which suits all attribute types
+    static constexpr GLsizeiptr ALIGNMENT = 16;
+
+    struct Range {
+        GLuint buffer = 0;
+        uint32_t page = 0;
+        uint32_t generation = 0;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+
+        explicit operator bool() const { return size > 0; }
+    };
+
+    struct Stats {
+        size_t pages = 0;
+        size_t ranges = 0;
+        size_t bytesUsed = 0;
+    };
+
+    BufferPool() = default;
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /* Take a range of @_size bytes of a page for @_target (GL_ARRAY_BUFFER or
+     * GL_ELEMENT_ARRAY_BUFFER) and upload @_data to it; returns an empty range when
+     * @_size is 0 or larger than MAX_RANGE_SIZE */
+    Range allocate(RenderState& rs, GLenum _target, GLsizeiptr _size, const void* _data);
+
+    /* Return @_range to the pool */
+    void release(const Range& _range);
+
+    /* Free the released ranges and delete pages that became empty, keeping one spare
+     * page per target */
+    void collect(RenderState& rs);
+
+    /* Forget all pages without deleting them, e.g. after GL context loss; ranges taken
+     * before are ignored when released */
+    void invalidate();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+
+    struct Block {
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    struct Page {
+        GLenum target;
+        GLuint buffer;
+        size_t ranges = 0;
+        // Free blocks ordered by offset
+        std::vector<Block> free;
+    };
+
+    bool take(Page& _page, GLsizeiptr _size, GLintptr& _offset);
+    void give(Page& _page, GLintptr _offset, GLsizeiptr _size);
+
+    std::unordered_map<uint32_t, Page> m_pages;
+    uint32_t m_nextPage = 1;
+    uint32_t m_generation = 0;
+
+    std::mutex m_releaseMutex;
+    std::vector<Range> m_released;
+
+    Stats m_stats;
+};
+
+}
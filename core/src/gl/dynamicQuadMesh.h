@@ -92,7 +92,7 @@ bool DynamicQuadMesh<T>::draw(RenderState& rs, ShaderProgram& shader, bool useVa
         if (!m_vaos.isInitialized()) {
             m_vaos.initialize(rs, {{0,0}}, *m_vertexLayout, m_glVertexBuffer, rs.getQuadIndexBuffer());
         }
-        m_vaos.bind(0);
+        m_vaos.bind(rs, 0);
     } else {
         rs.indexBuffer(rs.getQuadIndexBuffer());
     }
@@ -112,17 +112,13 @@ bool DynamicQuadMesh<T>::draw(RenderState& rs, ShaderProgram& shader, bool useVa
         m_vertexLayout->enable(rs, shader, byteOffset);  //if(!useVao || byteOffset > 0)
 
         size_t elementsInBatch = verticesInBatch * 6 / 4;
+        ++rs.drawCalls;
         GL::drawElements(m_drawMode, elementsInBatch, GL_UNSIGNED_SHORT, 0);
 
         // Update counters.
         vertexPos += verticesInBatch;
     }
 
-    if (useVao) {
-        //if(m_nVertices > verticesIndexed) m_vertexLayout->enable(rs, shader, 0);
-        m_vaos.unbind();
-    }
-
     return true;
 }
 
@@ -142,7 +138,7 @@ bool DynamicQuadMesh<T>::drawRange(RenderState& rs, ShaderProgram& shader,
         if (!m_vaos.isInitialized()) {
             m_vaos.initialize(rs, {{0,0}}, *m_vertexLayout, m_glVertexBuffer, rs.getQuadIndexBuffer());
         }
-        m_vaos.bind(0);
+        m_vaos.bind(rs, 0);
     } else {
         rs.indexBuffer(rs.getQuadIndexBuffer());
     }
@@ -163,16 +159,13 @@ bool DynamicQuadMesh<T>::drawRange(RenderState& rs, ShaderProgram& shader,
         m_vertexLayout->enable(rs, shader, byteOffset);
 
         size_t elementsInBatch = verticesInBatch * 6 / 4;
+        ++rs.drawCalls;
         GL::drawElements(m_drawMode, elementsInBatch, GL_UNSIGNED_SHORT, 0);
 
         // Update counters.
         vertexPos += verticesInBatch;
     }
 
-    if (useVao) {
-        m_vaos.unbind();
-    }
-
     return true;
 }
 
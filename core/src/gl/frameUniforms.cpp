@@ -0,0 +1,57 @@
+#include "gl/frameUniforms.h"
+
+#include "view/view.h"
+
+#include <cstring>
+
+namespace Tangram {
+
+void FrameUniforms::setNormalMatrix(const glm::mat3& _normal, const glm::mat3& _inverseNormal) {
+    for (int i = 0; i < 3; i++) {
+        normalMatrix[i] = glm::vec4(_normal[i], 0.f);
+        inverseNormalMatrix[i] = glm::vec4(_inverseNormal[i], 0.f);
+    }
+}
+
+void FrameUniforms::setView(const View& _view) {
+    view = _view.getViewMatrix();
+    proj = _view.getProjectionMatrix();
+    setNormalMatrix(_view.getNormalMatrix(), _view.getInverseNormalMatrix());
+    const auto& mapPos = _view.getPosition();
+    mapPosition = glm::vec3(mapPos.x, mapPos.y, _view.getZoom());
+    resolution = glm::vec2(_view.getWidth(), _view.getHeight());
+    metersPerPixel = 1.0 / _view.pixelsPerMeter();
+}
+
+bool FrameUniforms::operator==(const FrameUniforms& _other) const {
+    // Plain floats without padding, see the static_assert
+    return std::memcmp(this, &_other, sizeof(FrameUniforms)) == 0;
+}
+
+FrameUniformBuffer::~FrameUniformBuffer() {
+    if (m_glBuffer) {
+        GL::deleteBuffers(1, &m_glBuffer);
+    }
+}
+
+void FrameUniformBuffer::update(const FrameUniforms& _uniforms) {
+
+    if (m_glBuffer == 0) {
+        GL::genBuffers(1, &m_glBuffer);
+        GL::bindBuffer(GL_UNIFORM_BUFFER, m_glBuffer);
+        GL::bufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &_uniforms, GL_DYNAMIC_DRAW);
+        GL::bindBufferBase(GL_UNIFORM_BUFFER, BINDING, m_glBuffer);
+
+    } else if (!(m_uniforms == _uniforms)) {
+        GL::bindBuffer(GL_UNIFORM_BUFFER, m_glBuffer);
+        GL::bufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &_uniforms);
+    }
+
+    m_uniforms = _uniforms;
+}
+
+void FrameUniformBuffer::invalidate() {
+    m_glBuffer = 0;
+}
+
+}
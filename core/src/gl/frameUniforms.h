@@ -0,0 +1,70 @@
+#pragma once
+
+#include "gl.h"
+
+#include "glm/glm.hpp"
+
+namespace Tangram {
+
+class RenderState;
+class View;
+
+/*
+ * FrameUniforms - Values of the TangramFrame uniform block in std140 layout
+ *
+ * The block is declared in the header of shaders built by ShaderSource when
+ * Hardware::supportsUniformBuffers; shaders without it keep the plain uniforms of the
+ * same names, which Style sets per program.
+ */
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 proj;
+    // mat3 columns are padded to vec4 in std140
+    glm::vec4 normalMatrix[3];
+    glm::vec4 inverseNormalMatrix[3];
+    glm::vec3 mapPosition;
+    float time = 0.f;
+    glm::vec2 resolution;
+    float metersPerPixel = 0.f;
+    float devicePixelRatio = 1.f;
+
+    void setNormalMatrix(const glm::mat3& _normal, const glm::mat3& _inverseNormal);
+
+    /* Set the matrices, map position, resolution and meters per pixel of @_view */
+    void setView(const View& _view);
+
+    bool operator==(const FrameUniforms& _other) const;
+};
+
+static_assert(sizeof(FrameUniforms) == 256, "FrameUniforms must match the std140 layout");
+
+/*
+ * FrameUniformBuffer - Uniform buffer of FrameUniforms, bound to a fixed binding point
+ * which ShaderProgram assigns to the TangramFrame block of each program it builds
+ */
+class FrameUniformBuffer {
+
+public:
+
+    static constexpr GLuint BINDING = 0;
+    static constexpr const char* BLOCK_NAME = "TangramFrame";
+
+    FrameUniformBuffer() = default;
+    ~FrameUniformBuffer();
+
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    /* Upload @_uniforms when they changed since the last frame and bind the buffer */
+    void update(const FrameUniforms& _uniforms);
+
+    /* Forget the buffer without deleting it, e.g. after GL context loss */
+    void invalidate();
+
+private:
+
+    FrameUniforms m_uniforms;
+    GLuint m_glBuffer = 0;
+};
+
+}
@@ -13,28 +13,30 @@
 namespace Tangram {
 
 class RenderTexture : public Texture {
-    static constexpr TextureOptions textureOptions(GLenum _pixelFormat) {
+    static constexpr TextureOptions textureOptions(GLenum _pixelFormat, bool _linearFilter) {
         TextureOptions options;
         options.pixelFormat = PixelFormat(_pixelFormat);
-        options.minFilter = TextureMinFilter::NEAREST;
-        options.magFilter = TextureMagFilter::NEAREST;
+        options.minFilter = _linearFilter ? TextureMinFilter::LINEAR : TextureMinFilter::NEAREST;
+        options.magFilter = _linearFilter ? TextureMagFilter::LINEAR : TextureMagFilter::NEAREST;
         return options;
     }
 public:
-    RenderTexture(int width, int height, GLenum _pixelFormat)
-        : Texture(textureOptions(_pixelFormat)) {
+    RenderTexture(int width, int height, GLenum _pixelFormat, bool _linearFilter)
+        : Texture(textureOptions(_pixelFormat, _linearFilter)) {
         resize(width, height);
     }
     GLuint glHandle() const { return m_glHandle; }
 };
 
-FrameBuffer::FrameBuffer(int _width, int _height, bool _colorRenderBuffer, GLenum _pixelFormat) :
+FrameBuffer::FrameBuffer(int _width, int _height, bool _colorRenderBuffer, GLenum _pixelFormat,
+                         bool _linearFilter) :
     m_glFrameBufferHandle(0),
     m_glDepthRenderBufferHandle(0),
     m_glColorRenderBufferHandle(0),
     m_pixelFormat(_pixelFormat),
     m_valid(false),
     m_colorRenderBuffer(_colorRenderBuffer),
+    m_linearFilter(_linearFilter),
     m_width(_width), m_height(_height) {
 
 }
@@ -93,7 +95,7 @@ GLuint FrameBuffer::readAt(float _normalizedX, float _normalizedY) const {
     return pixel;
 }
 
-FrameBuffer::PixelRect FrameBuffer::readRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const {
+FrameBuffer::PixelRect FrameBuffer::pixelRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const {
 
     PixelRect rect;
     rect.left = fminf(fmaxf(floorf(_normalizedX * m_width), 0.f), m_width);
@@ -101,13 +103,25 @@ FrameBuffer::PixelRect FrameBuffer::readRect(float _normalizedX, float _normaliz
     rect.width = fminf(fmaxf(ceilf(_normalizedW * m_width), 0.f), m_width - rect.left);
     rect.height = fminf(fmaxf(ceilf(_normalizedH * m_height), 0.f), m_height - rect.bottom);
 
-    rect.pixels.resize(rect.width * rect.height);
+    return rect;
+}
 
-    GL::readPixels(rect.left, rect.bottom, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE, rect.pixels.data());
+FrameBuffer::PixelRect FrameBuffer::readRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const {
 
+    PixelRect rect = pixelRect(_normalizedX, _normalizedY, _normalizedW, _normalizedH);
+    readRect(rect);
     return rect;
 }
 
+void FrameBuffer::readRect(PixelRect& _rect) const {
+
+    _rect.pixels.resize(_rect.width * _rect.height);
+
+    if (_rect.pixels.empty()) { return; }
+
+    GL::readPixels(_rect.left, _rect.bottom, _rect.width, _rect.height, GL_RGBA, GL_UNSIGNED_BYTE, _rect.pixels.data());
+}
+
 void FrameBuffer::init(RenderState& _rs) {
 
     if (m_colorRenderBuffer && !Hardware::supportsGLRGBA8OES) {
@@ -132,7 +146,7 @@ void FrameBuffer::init(RenderState& _rs) {
         GL::framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
                                     GL_RENDERBUFFER, m_glColorRenderBufferHandle);
     } else {
-        m_texture = std::make_unique<RenderTexture>(m_width, m_height, m_pixelFormat);
+        m_texture = std::make_unique<RenderTexture>(m_width, m_height, m_pixelFormat, m_linearFilter);
         m_texture->bind(_rs, 0);
         GL::framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
                                  GL_TEXTURE_2D, m_texture->glHandle(), 0);
@@ -163,6 +177,10 @@ FrameBuffer::~FrameBuffer() {
 }
 
 void FrameBuffer::drawDebug(RenderState& _rs, glm::vec2 _dim) {
+    drawTexture(_rs, _dim);
+}
+
+void FrameBuffer::drawTexture(RenderState& _rs, glm::vec2 _dim) {
     if (m_texture) {
         Primitives::drawTexture(_rs, *m_texture, glm::vec2{}, _dim);
     }
@@ -170,4 +188,6 @@ void FrameBuffer::drawDebug(RenderState& _rs, glm::vec2 _dim) {
 
 GLuint FrameBuffer::getTextureHandle() const { return m_texture ? m_texture->glHandle() : 0; }
 
+Texture* FrameBuffer::getTexture() const { return m_texture.get(); }
+
 }
@@ -12,12 +12,15 @@ namespace Tangram {
 
 class RenderState;
 class RenderTexture;
+class Texture;
 
 class FrameBuffer {
 
 public:
 
-    FrameBuffer(int _width, int _height, bool _colorRenderBuffer = true, GLenum _pixelFormat = GL_RGBA8);
+    // With @_linearFilter the color texture is sampled with linear filtering, e.g. to scale it
+    FrameBuffer(int _width, int _height, bool _colorRenderBuffer = true, GLenum _pixelFormat = GL_RGBA8,
+                bool _linearFilter = false);
 
     ~FrameBuffer();
 
@@ -40,12 +43,24 @@ public:
         int32_t left = 0, bottom = 0, width = 0, height = 0;
     };
 
+    // Bounds of the normalized rect in pixels, clamped to the framebuffer; pixels are left empty
+    PixelRect pixelRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const;
+
     PixelRect readRect(float _normalizedX, float _normalizedY, float _normalizedW, float _normalizedH) const;
 
+    // Read the pixels of @_rect, as returned by pixelRect()
+    void readRect(PixelRect& _rect) const;
+
     void drawDebug(RenderState& _rs, glm::vec2 _dim);
 
+    // Draw the color texture into the bound framebuffer at @_dim pixels; only framebuffers
+    // without color render buffer have a texture
+    void drawTexture(RenderState& _rs, glm::vec2 _dim);
+
     GLuint getHandle() const { return m_glFrameBufferHandle; }
     GLuint getTextureHandle() const;
+    // The color texture, null for framebuffers with color render buffer
+    Texture* getTexture() const;
 
 private:
 
@@ -67,6 +82,8 @@ private:
 
     bool m_colorRenderBuffer;
 
+    bool m_linearFilter;
+
     int m_width;
 
     int m_height;
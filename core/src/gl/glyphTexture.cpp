@@ -14,6 +14,9 @@ GlyphTexture::GlyphTexture() : Texture(textureOptions()) {
 
 bool GlyphTexture::bind(RenderState& _rs, GLuint _textureUnit) {
 
+    // The atlas keeps its pixel data
+    restoreLostContext(_rs);
+
     if (!m_shouldResize && m_dirtyRows.empty()) {
         if (m_glHandle == 0) { return false; }
 
@@ -0,0 +1,93 @@
+#include "gl/gpuTimer.h"
+
+#include "gl/hardware.h"
+
+namespace Tangram {
+
+// Weight of the last frame in the smoothed section times
+static constexpr float SMOOTHING = 0.1f;
+
+GpuTimer::~GpuTimer() {
+    for (auto& frame : m_frames) {
+        for (auto& query : frame.queries) { GL::deleteQueries(1, &query.id); }
+    }
+}
+
+void GpuTimer::beginFrame() {
+    end();
+    m_timing = false;
+    if (!m_enabled || !Hardware::supportsTimerQuery) { return; }
+
+    m_frame = (m_frame + 1) % FRAMES;
+    auto& frame = m_frames[m_frame];
+    if (frame.used > 0 && !collect(frame)) { return; }
+
+    frame.used = 0;
+    m_timing = true;
+}
+
+bool GpuTimer::collect(Frame& _frame) {
+    // Queries complete in order
+    GLuint available = 0;
+    GL::getQueryObjectuiv(_frame.queries[_frame.used - 1].id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) { return false; }
+
+    if (Hardware::timerQueryDisjoint) {
+        GLint disjoint = 0;
+        GL::getIntegerv(GL_GPU_DISJOINT, &disjoint);
+        if (disjoint) { return true; }
+    }
+
+    m_frameTimes.assign(m_sections.size(), 0.f);
+    for (size_t i = 0; i < _frame.used; i++) {
+        auto& query = _frame.queries[i];
+        unsigned long long nanos = 0;
+        GL::getQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanos);
+        m_frameTimes[query.section] += nanos / 1e6f;
+    }
+    for (size_t i = 0; i < m_sections.size(); i++) {
+        m_sections[i].time += (m_frameTimes[i] - m_sections[i].time) * SMOOTHING;
+    }
+    return true;
+}
+
+uint32_t GpuTimer::sectionIndex(const std::string& _name) {
+    for (size_t i = 0; i < m_sections.size(); i++) {
+        if (m_sections[i].name == _name) { return uint32_t(i); }
+    }
+    m_sections.push_back({ _name, 0.f });
+    return uint32_t(m_sections.size() - 1);
+}
+
+void GpuTimer::begin(const std::string& _section) {
+    if (!m_timing || m_active) { return; }
+
+    auto& frame = m_frames[m_frame];
+    if (frame.used == frame.queries.size()) {
+        GLuint id = 0;
+        GL::genQueries(1, &id);
+        frame.queries.push_back({ id, 0 });
+    }
+    auto& query = frame.queries[frame.used++];
+    query.section = sectionIndex(_section);
+
+    GL::beginQuery(GL_TIME_ELAPSED, query.id);
+    m_active = true;
+}
+
+void GpuTimer::end() {
+    if (!m_active) { return; }
+    GL::endQuery(GL_TIME_ELAPSED);
+    m_active = false;
+}
+
+void GpuTimer::invalidate() {
+    for (auto& frame : m_frames) {
+        frame.queries.clear();
+        frame.used = 0;
+    }
+    m_timing = false;
+    m_active = false;
+}
+
+}
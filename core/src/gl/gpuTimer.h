@@ -0,0 +1,89 @@
+#pragma once
+
+#include "gl.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * GpuTimer - GPU time of the styles and render passes of each frame, measured with timer
+ * queries when enabled and Hardware::supportsTimerQuery
+ *
+ * Only one time elapsed query can be active, so sections do not nest: begin() is ignored while
+ * another section is timed. The queries of a frame are read when their slot comes round again
+ * FRAMES frames later; frames which the GPU has not finished by then are not timed, so timing
+ * never waits for the GPU. Frames in which the GPU was disjoint, e.g. changed its clock, are
+ * dropped.
+ */
+class GpuTimer {
+
+public:
+
+    static constexpr size_t FRAMES = 4;
+
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    /* Time the following frames; the times measured so far are kept when timing stops */
+    void setEnabled(bool _enabled) { m_enabled = _enabled; }
+    bool enabled() const { return m_enabled; }
+
+    /* Start a frame, reading the results of the frame timed in the same slot */
+    void beginFrame();
+
+    /* Time the GPU commands until end() as @_section, e.g. a style name */
+    void begin(const std::string& _section);
+    void end();
+
+    struct Section {
+        std::string name;
+        float time = 0.f; // ms per frame, smoothed over frames
+    };
+    const std::vector<Section>& sections() const { return m_sections; }
+
+    /* Forget the queries without deleting them, e.g. after GL context loss */
+    void invalidate();
+
+    struct Scope {
+        GpuTimer& timer;
+        Scope(GpuTimer& _timer, const std::string& _section) : timer(_timer) { timer.begin(_section); }
+        ~Scope() { timer.end(); }
+    };
+
+private:
+
+    struct Query {
+        GLuint id;
+        uint32_t section;
+    };
+
+    struct Frame {
+        // Query objects are kept for the following frames of the slot
+        std::vector<Query> queries;
+        size_t used = 0;
+    };
+
+    /* Add the times of @_frame to the sections; false when the GPU has not finished it */
+    bool collect(Frame& _frame);
+
+    uint32_t sectionIndex(const std::string& _name);
+
+    std::array<Frame, FRAMES> m_frames;
+    size_t m_frame = 0;
+
+    bool m_enabled = false;
+    // Whether the current frame is timed, and whether a section is
+    bool m_timing = false;
+    bool m_active = false;
+
+    std::vector<Section> m_sections;
+    std::vector<float> m_frameTimes;
+};
+
+}
@@ -16,11 +16,23 @@ bool supportsMapBuffer = false;
 bool supportsVAOs = false;
 bool supportsTextureNPOT = false;
 bool supportsGLRGBA8OES = false;
+bool supportsProgramBinary = false;
+bool supportsETC1 = false;
+bool supportsETC2 = false;
+bool supportsS3TC = false;
+bool supportsASTC = false;
+bool supportsTextureArrays = false;
+bool supportsInstancing = false;
+bool supportsUniformBuffers = false;
+bool supportsAsyncReadback = false;
+bool supportsTimerQuery = false;
+bool timerQueryDisjoint = false;
 
 int32_t maxTextureSize = 2048;
 int32_t maxCombinedTextureUnits = 16;
 int32_t depthBits = 24;
 int32_t glVersion = 200;
+static bool s_isGLES = false;
 static char* s_glExtensions;
 
 bool isAvailable(std::string _extension) {
@@ -59,11 +71,54 @@ void loadExtensions() {
     supportsTextureNPOT = glVersion >= 300 || isAvailable("texture_non_power_of_two");
     supportsGLRGBA8OES = glVersion >= 300 || isAvailable("rgb8_rgba8");
 
+    // Program binaries can only be used when the driver offers a binary format
+    if (glVersion >= 300 || isAvailable("get_program_binary")) {
+        GLint numFormats = 0;
+        GL::getIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        supportsProgramBinary = numFormats > 0;
+    }
+
+    // ETC2 is core in GLES 3; desktop GL has it with ES3 compatibility (GL 4.3)
+    supportsETC2 = (s_isGLES && glVersion >= 300) || isAvailable("ES3_compatibility");
+    // ETC1 data is also valid ETC2 data
+    supportsETC1 = supportsETC2 || isAvailable("compressed_ETC1_RGB8_texture");
+    supportsS3TC = isAvailable("texture_compression_s3tc") || isAvailable("texture_compression_dxt");
+    supportsASTC = isAvailable("texture_compression_astc");
+
+#if defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+    // GL 3 functions are not available with the GLES 2 headers of these platforms
+    supportsTextureArrays = false;
+    supportsInstancing = false;
+    supportsUniformBuffers = false;
+    supportsAsyncReadback = false;
+    supportsTimerQuery = false;
+#else
+    supportsTextureArrays = glVersion >= 300;
+    // Attribute divisors are core in GLES 3 but only in GL 3.3 on desktop
+    supportsInstancing = s_isGLES ? glVersion >= 300 : glVersion >= 330;
+    // Uniform blocks need GLSL ES 3.00 shaders, see ShaderSource
+    supportsUniformBuffers = s_isGLES ? glVersion >= 300 : glVersion >= 310;
+    // Pixel buffer objects with fences, sync objects are core in GL 3.2
+    supportsAsyncReadback = s_isGLES ? glVersion >= 300 : glVersion >= 320;
+#if defined(TANGRAM_TIZEN)
+    supportsTimerQuery = false;
+#else
+    // Timer queries are core in GL 3.3; GLES only has them with EXT_disjoint_timer_query
+    supportsTimerQuery = s_isGLES ? isAvailable("disjoint_timer_query")
+                                  : glVersion >= 330 || isAvailable("timer_query");
+    timerQueryDisjoint = s_isGLES;
+#endif
+#endif
+
+    LOG("Driver supports compressed textures: ETC1 %d, ETC2 %d, S3TC %d, ASTC %d",
+        supportsETC1, supportsETC2, supportsS3TC, supportsASTC);
+
     if (glVersion < 300) {
         LOG("Driver supports map buffer: %d", supportsMapBuffer);
         LOG("Driver supports vaos: %d", supportsVAOs);
         LOG("Driver supports rgb8_rgba8: %d", supportsGLRGBA8OES);
         LOG("Driver supports NPOT texture: %d", supportsTextureNPOT);
+        LOG("Driver supports program binary: %d", supportsProgramBinary);
     }
 
     // find extension symbols if needed
@@ -80,6 +135,7 @@ void loadCapabilities() {
         if (*s > '0' && *s < '9') { ver = strtof(s, NULL); break; }
     }
     glVersion = ver*100 + 0.5f;
+    s_isGLES = verstr && strstr(verstr, "OpenGL ES");
 
     if (glVersion < 300) { GL::getIntegerv(GL_DEPTH_BITS, &depthBits); }  // assume 24 bits for GL 3+
 
@@ -10,6 +10,18 @@ extern bool supportsMapBuffer;
 extern bool supportsVAOs;
 extern bool supportsTextureNPOT;
 extern bool supportsGLRGBA8OES;
+extern bool supportsProgramBinary;
+extern bool supportsETC1;
+extern bool supportsETC2;
+extern bool supportsS3TC;
+extern bool supportsASTC;
+extern bool supportsTextureArrays;
+extern bool supportsInstancing;
+extern bool supportsUniformBuffers;
+extern bool supportsAsyncReadback;
+extern bool supportsTimerQuery;
+// Whether GL_GPU_DISJOINT tells when timer query results are invalid (EXT_disjoint_timer_query)
+extern bool timerQueryDisjoint;
 extern int32_t maxTextureSize;
 extern int32_t maxCombinedTextureUnits;
 extern int32_t depthBits;
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "gl/glError.h"
+#include "gl/mesh.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * InstancedLineMesh - Line segments drawn as instances of the segment of RenderState
+ *
+ * Each segment is one T in the vertex buffer of the mesh, which is described by
+ * @_instanceLayout and bound to the attribute locations from 1 on; location 0 gets the
+ * corners of RenderState::getLineSegmentBuffer(), from which the vertex shader extrudes the
+ * segment with its joins and caps. Programs for this mesh must bind their attributes
+ * accordingly. Requires Hardware::supportsInstancing.
+ *
+ * Instances are drawn in one call in the order of the compiled batches, so the mesh can't be
+ * split into chunks; it can't be serialized either, as a CompiledMesh draws vertices.
+ */
+template<class T>
+class InstancedLineMesh : public Mesh<T> {
+
+public:
+
+    InstancedLineMesh(std::shared_ptr<VertexLayout> _instanceLayout)
+        : Mesh<T>(_instanceLayout, GL_TRIANGLES) {}
+
+    void compile(const std::vector<std::vector<T>>& _batches);
+
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) override;
+
+    bool serialize(std::vector<char>& _out) const override { return false; }
+
+    void setSelectable(bool _selectable) { this->m_selectable = _selectable; }
+
+    static constexpr size_t TEMPLATE_VERTICES = RenderState::LINE_SEGMENT_QUADS * 4;
+    static constexpr size_t TEMPLATE_INDICES = RenderState::LINE_SEGMENT_QUADS * 6;
+};
+
+template<class T>
+void InstancedLineMesh<T>::compile(const std::vector<std::vector<T>>& _batches) {
+
+    size_t nInstances = 0;
+    for (auto& batch : _batches) { nInstances += batch.size(); }
+
+    this->m_nVertices = nInstances;
+    this->m_nIndices = 0;
+
+    size_t stride = this->m_vertexLayout->getStride();
+    assert(sizeof(T) == stride);
+
+    this->m_glVertexData = new GLbyte[nInstances * stride];
+
+    size_t offset = 0;
+    for (auto& batch : _batches) {
+        std::memcpy(this->m_glVertexData + offset, (const GLbyte*)batch.data(), batch.size() * stride);
+        offset += batch.size() * stride;
+    }
+
+    this->m_vertexOffsets.assign(1, { 0, uint32_t(nInstances) });
+    this->m_vertexInvocations = nInstances * TEMPLATE_VERTICES;
+
+    this->retainData();
+    this->m_isCompiled = true;
+}
+
+template<class T>
+bool InstancedLineMesh<T>::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
+
+    if (this->m_isUploaded && this->m_contextGeneration != rs.contextGeneration() &&
+        !this->restore()) {
+        return false;
+    }
+
+    if (!this->m_isCompiled || this->m_nVertices == 0) { return false; }
+
+    if (!_shader.use(rs)) { return false; }
+
+    if (!this->m_isUploaded) { this->upload(rs); }
+
+    // Instancing implies vertex arrays, which keep the template and instance bindings
+    if (!this->m_vaos.isInitialized()) {
+        this->m_vaos.initializeInstanced(rs, *this->m_vertexLayout, this->m_glVertexBuffer,
+                                         this->m_vertexRange.offset, rs.getLineSegmentBuffer(), 3,
+                                         rs.getQuadIndexBuffer());
+    }
+    this->m_vaos.bind(rs, 0);
+
+    ++rs.drawCalls;
+
+    GL::drawElementsInstanced(GL_TRIANGLES, TEMPLATE_INDICES, GL_UNSIGNED_SHORT, 0, this->m_nVertices);
+
+    return true;
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "gl/glError.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+#include "gl/vertexLayout.h"
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * InstancedQuadMesh - Quads drawn as instances of the unit quad of RenderState
+ *
+ * Each quad is one T in the instance buffer, which is described by @_instanceLayout and bound
+ * to the attribute locations from 1 on; location 0 gets the corner of the unit quad. Programs
+ * for this mesh must bind their attributes accordingly. Requires Hardware::supportsInstancing.
+ */
+template<class T>
+class InstancedQuadMesh {
+
+public:
+
+    InstancedQuadMesh(std::shared_ptr<VertexLayout> _instanceLayout)
+        : m_instanceLayout(_instanceLayout) {}
+
+    ~InstancedQuadMesh() {
+        if (m_rs) {
+            m_rs->queueBufferDeletion(1, &m_glInstanceBuffer);
+            if (m_glVao) { m_rs->queueVAODeletion(1, &m_glVao); }
+        }
+    }
+
+    void clear() {
+        m_instances.clear();
+        m_isUploaded = false;
+    }
+
+    size_t numberOfInstances() const { return m_instances.size(); }
+
+    size_t bufferSize() const { return m_bufferSize; }
+
+    // Reserves space for one instance and returns pointer to it
+    T* pushInstance() {
+        m_instances.emplace_back();
+        return &m_instances.back();
+    }
+
+    void upload(RenderState& rs);
+
+    bool drawRange(RenderState& rs, ShaderProgram& _shader, size_t _first, size_t _count);
+
+    bool draw(RenderState& rs, ShaderProgram& _shader) {
+        return drawRange(rs, _shader, 0, m_instances.size());
+    }
+
+private:
+
+    std::shared_ptr<VertexLayout> m_instanceLayout;
+    std::vector<T> m_instances;
+
+    GLuint m_glInstanceBuffer = 0;
+    GLuint m_glVao = 0;
+    size_t m_bufferSize = 0;
+    bool m_isUploaded = false;
+
+    RenderState* m_rs = nullptr;
+};
+
+template<class T>
+void InstancedQuadMesh<T>::upload(RenderState& rs) {
+
+    if (m_instances.empty() || m_isUploaded) { return; }
+
+    assert(sizeof(T) == size_t(m_instanceLayout->getStride()));
+
+    if (m_glInstanceBuffer == 0) {
+        GL::genBuffers(1, &m_glInstanceBuffer);
+        m_rs = &rs;
+    }
+
+    rs.vertexBuffer(m_glInstanceBuffer);
+
+    // Orphan the data store used by the last frame, then upload
+    m_bufferSize = m_instances.size() * sizeof(T);
+    GL::bufferData(GL_ARRAY_BUFFER, m_bufferSize, nullptr, GL_DYNAMIC_DRAW);
+    GL::bufferData(GL_ARRAY_BUFFER, m_bufferSize, m_instances.data(), GL_DYNAMIC_DRAW);
+
+    m_isUploaded = true;
+}
+
+template<class T>
+bool InstancedQuadMesh<T>::drawRange(RenderState& rs, ShaderProgram& _shader,
+                                     size_t _first, size_t _count) {
+
+    if (_count == 0 || !m_isUploaded) { return false; }
+
+    if (!_shader.use(rs)) { return false; }
+
+    if (m_glVao == 0) {
+        GLuint quadBuffer = rs.getUnitQuadBuffer();
+        GLuint indexBuffer = rs.getQuadIndexBuffer();
+
+        GL::genVertexArrays(1, &m_glVao);
+        rs.vertexArray(m_glVao);
+
+        // ELEMENT_ARRAY_BUFFER must be bound after bindVertexArray to be used by VAO; the binding
+        // of the default vertex array in RenderState is kept
+        GL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+        rs.vertexBuffer(quadBuffer);
+        GL::enableVertexAttribArray(0);
+        GL::vertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    } else {
+        rs.vertexArray(m_glVao);
+    }
+
+    // GLES 3 has no base instance, so the instance attributes are set for each range
+    rs.vertexBuffer(m_glInstanceBuffer);
+    m_instanceLayout->enableInstanced(_first * sizeof(T), 1);
+
+    ++rs.drawCalls;
+
+    GL::drawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0, _count);
+
+    return true;
+}
+
+}
@@ -5,6 +5,13 @@
 #include "gl/glError.h"
 #include "platform.h"
 #include "log.h"
+#include "util/vertexCache.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
 
 namespace Tangram {
 
@@ -34,11 +41,17 @@ MeshBase::MeshBase(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode
 }
 
 MeshBase::~MeshBase() {
-    if (m_rs) {
-        if (m_glVertexBuffer || m_glIndexBuffer) {
-            GLuint buffers[] = { m_glVertexBuffer, m_glIndexBuffer };
+    // Handles of a lost context may name objects of the current one
+    if (m_rs && m_contextGeneration == m_rs->contextGeneration()) {
+        // Pooled buffers are shared, only their ranges are returned
+        GLuint vertexBuffer = m_vertexRange ? 0 : m_glVertexBuffer;
+        GLuint indexBuffer = m_indexRange ? 0 : m_glIndexBuffer;
+        if (vertexBuffer || indexBuffer) {
+            GLuint buffers[] = { vertexBuffer, indexBuffer };
             m_rs->queueBufferDeletion(2, buffers);
         }
+        m_rs->bufferPool.release(m_vertexRange);
+        m_rs->bufferPool.release(m_indexRange);
         m_vaos.dispose(*m_rs);
     }
 
@@ -110,43 +123,107 @@ void MeshBase::subDataUpload(RenderState& rs, GLbyte* _data) {
 
 void MeshBase::upload(RenderState& rs) {
 
-    // Generate vertex buffer, if needed
-    if (m_glVertexBuffer == 0) {
-        GL::genBuffers(1, &m_glVertexBuffer);
-    }
+    // Static meshes take ranges of the shared buffers of the pool when they fit
+    bool pooled = m_hint == GL_STATIC_DRAW && !m_isUploaded;
 
     // Buffer vertex data
     int vertexBytes = m_nVertices * m_vertexLayout->getStride();
 
-    rs.vertexBuffer(m_glVertexBuffer);
-    GL::bufferData(GL_ARRAY_BUFFER, vertexBytes, m_glVertexData, m_hint);
+    if (pooled) {
+        m_vertexRange = rs.bufferPool.allocate(rs, GL_ARRAY_BUFFER, vertexBytes, m_glVertexData);
+    }
+
+    if (m_vertexRange) {
+        m_glVertexBuffer = m_vertexRange.buffer;
+    } else {
+        // Generate vertex buffer, if needed
+        if (m_glVertexBuffer == 0) {
+            GL::genBuffers(1, &m_glVertexBuffer);
+        }
+
+        rs.vertexBuffer(m_glVertexBuffer);
+        GL::bufferData(GL_ARRAY_BUFFER, vertexBytes, m_glVertexData, m_hint);
+    }
 
     delete[] m_glVertexData;
     m_glVertexData = nullptr;
 
     if (m_glIndexData) {
 
-        if (m_glIndexBuffer == 0) {
-            GL::genBuffers(1, &m_glIndexBuffer);
+        int indexBytes = m_nIndices * sizeof(GLushort);
+
+        if (pooled) {
+            m_indexRange = rs.bufferPool.allocate(rs, GL_ELEMENT_ARRAY_BUFFER, indexBytes, m_glIndexData);
         }
 
-        // Buffer element index data
-        rs.indexBuffer(m_glIndexBuffer);
+        if (m_indexRange) {
+            m_glIndexBuffer = m_indexRange.buffer;
+        } else {
+            if (m_glIndexBuffer == 0) {
+                GL::genBuffers(1, &m_glIndexBuffer);
+            }
 
-        GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, m_nIndices * sizeof(GLushort), m_glIndexData, m_hint);
+            // Buffer element index data
+            rs.indexBuffer(m_glIndexBuffer);
+
+            GL::bufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, m_glIndexData, m_hint);
+        }
 
         delete[] m_glIndexData;
         m_glIndexData = nullptr;
     }
 
     m_rs = &rs;
+    m_contextGeneration = rs.contextGeneration();
 
     m_isUploaded = true;
 }
 
+void MeshBase::retainData() {
+    if (m_hint != GL_STATIC_DRAW || !RetainedData::enabled()) { return; }
+
+    if (!m_retainedVertices.store(m_glVertexData, m_nVertices * m_vertexLayout->getStride())) { return; }
+    if (m_nIndices > 0 && !m_retainedIndices.store(m_glIndexData, m_nIndices * sizeof(GLushort))) {
+        // Of no use without the indices
+        m_retainedVertices.clear();
+    }
+}
+
+bool MeshBase::restorable() const {
+    return !m_isUploaded || (m_retainedVertices && (m_nIndices == 0 || m_retainedIndices));
+}
+
+bool MeshBase::restore() {
+    bool retained = restorable();
+
+    m_glVertexBuffer = 0;
+    m_glIndexBuffer = 0;
+    m_vertexRange = {};
+    m_indexRange = {};
+    m_vaos.reset();
+    m_rs = nullptr;
+    m_isUploaded = false;
+    m_dirty = false;
+
+    if (!retained) {
+        m_isCompiled = false;
+        return false;
+    }
+
+    m_glVertexData = new GLbyte[m_retainedVertices.size()];
+    m_retainedVertices.restore(m_glVertexData);
+    if (m_nIndices > 0) {
+        m_glIndexData = new GLushort[m_nIndices];
+        m_retainedIndices.restore(m_glIndexData);
+    }
+    return true;
+}
+
 bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
     bool useVao = _useVao && Hardware::supportsVAOs;
 
+    if (m_isUploaded && m_contextGeneration != rs.contextGeneration() && !restore()) { return false; }
+
     if (!m_isCompiled) { return false; }
     if (m_nVertices == 0) { return false; }
 
@@ -165,9 +242,13 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
     if (useVao) {
         if (!m_vaos.isInitialized()) {
             // Capture vao state
-            m_vaos.initialize(rs, m_vertexOffsets, *m_vertexLayout, m_glVertexBuffer, m_glIndexBuffer);
+            m_vaos.initialize(rs, m_vertexOffsets, *m_vertexLayout, m_glVertexBuffer, m_glIndexBuffer,
+                              m_vertexRange.offset);
         }
     } else {
+        // Attributes are set on the default vertex array
+        rs.bindDefaultVertexArray();
+
         // Bind buffers for drawing
         rs.vertexBuffer(m_glVertexBuffer);
 
@@ -176,7 +257,8 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
         }
     }
 
-    size_t indiceOffset = 0;
+    // Offsets of the ranges in pooled buffers, otherwise 0
+    size_t indiceOffset = m_indexRange.offset / sizeof(GLushort);
     size_t vertexOffset = 0;
 
     for (size_t i = 0; i < m_vertexOffsets.size(); ++i) {
@@ -184,20 +266,54 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
         uint32_t nIndices = o.first;
         uint32_t nVertices = o.second;
 
+        uint16_t chunkMask = m_chunkMasks.empty() ? 0xffff : m_chunkMasks[i];
+        if (chunkMask == 0) {
+            vertexOffset += nVertices;
+            indiceOffset += nIndices;
+            continue;
+        }
+
         if (!useVao) {
             // Enable vertex attribs via vertex layout object
-            size_t byteOffset = vertexOffset * m_vertexLayout->getStride();
+            size_t byteOffset = m_vertexRange.offset + vertexOffset * m_vertexLayout->getStride();
             m_vertexLayout->enable(rs,  _shader, byteOffset);
         } else {
             // Bind the corresponding vao relative to the current offset
-            m_vaos.bind(i);
+            m_vaos.bind(rs, i);
         }
 
         // Draw as elements or arrays
-        if (nIndices > 0) {
+        if (nIndices > 0 && chunkMask != 0xffff) {
+            // Draw the visible chunks, joining consecutive ranges
+            size_t start = 0, count = 0;
+            size_t rangeOffset = m_indexRange.offset / sizeof(GLushort);
+
+            for (int c = 0; c < CHUNKS; c++) {
+                const auto& chunk = m_chunks[i * CHUNKS + c];
+                if (!(chunkMask & (1 << c)) || chunk.nIndices == 0) { continue; }
+
+                size_t first = rangeOffset + chunk.firstIndex;
+                if (count > 0 && start + count == first) {
+                    count += chunk.nIndices;
+                    continue;
+                }
+                if (count > 0) {
+                    ++rs.drawCalls;
+                    GL::drawElements(m_drawMode, count, GL_UNSIGNED_SHORT, (void*)(start * sizeof(GLushort)));
+                }
+                start = first;
+                count = chunk.nIndices;
+            }
+            if (count > 0) {
+                ++rs.drawCalls;
+                GL::drawElements(m_drawMode, count, GL_UNSIGNED_SHORT, (void*)(start * sizeof(GLushort)));
+            }
+        } else if (nIndices > 0) {
+            ++rs.drawCalls;
             GL::drawElements(m_drawMode, nIndices, GL_UNSIGNED_SHORT,
                              (void*)(indiceOffset * sizeof(GLushort)));
         } else if (nVertices > 0) {
+            ++rs.drawCalls;
             GL::drawArrays(m_drawMode, 0, nVertices);
         }
 
@@ -205,17 +321,94 @@ bool MeshBase::draw(RenderState& rs, ShaderProgram& _shader, bool _useVao) {
         indiceOffset += nIndices;
     }
 
-    if (useVao) {
-        m_vaos.unbind();
-    }
-
     return true;
 }
 
+size_t MeshBase::uploadPending(RenderState& rs) {
+    if (m_isUploaded && m_contextGeneration != rs.contextGeneration()) { restore(); }
+    if (m_isUploaded || !m_isCompiled || m_nVertices == 0) { return 0; }
+
+    upload(rs);
+    return bufferSize();
+}
+
 size_t MeshBase::bufferSize() const {
     return m_nVertices * m_vertexLayout->getStride() + m_nIndices * sizeof(GLushort);
 }
 
+bool MeshBase::serialize(std::vector<char>& _out) const {
+    if (!m_isCompiled || !m_glVertexData) { return false; }
+
+    uint32_t header[] = { uint32_t(m_vertexLayout->getStride()), uint32_t(m_nVertices),
+                          uint32_t(m_nIndices), uint32_t(m_vertexOffsets.size()),
+                          uint32_t(m_chunks.size()) };
+
+    auto append = [&](const void* _src, size_t _bytes) {
+        auto src = static_cast<const char*>(_src);
+        _out.insert(_out.end(), src, src + _bytes);
+    };
+    append(header, sizeof(header));
+    for (const auto& offset : m_vertexOffsets) {
+        uint32_t counts[] = { offset.first, offset.second };
+        append(counts, sizeof(counts));
+    }
+    if (!m_chunks.empty()) { append(m_chunks.data(), m_chunks.size() * sizeof(Chunk)); }
+    append(m_glVertexData, m_nVertices * header[0]);
+    if (m_nIndices > 0) { append(m_glIndexData, m_nIndices * sizeof(GLushort)); }
+
+    return true;
+}
+
+bool MeshBase::deserialize(const char*& _data, const char* _end) {
+    if (m_isCompiled) { return false; }
+
+    auto read = [&](void* _dst, size_t _bytes) {
+        if (size_t(_end - _data) < _bytes) { return false; }
+        std::memcpy(_dst, _data, _bytes);
+        _data += _bytes;
+        return true;
+    };
+
+    uint32_t header[5];
+    if (!read(header, sizeof(header))) { return false; }
+    if (header[0] != uint32_t(m_vertexLayout->getStride())) { return false; }
+
+    // check the counts against the data before allocating for them
+    if (size_t(header[3]) * 2 * sizeof(uint32_t) > size_t(_end - _data)) { return false; }
+    m_vertexOffsets.resize(header[3]);
+    for (auto& offset : m_vertexOffsets) {
+        uint32_t counts[2];
+        if (!read(counts, sizeof(counts))) { return false; }
+        offset = { counts[0], counts[1] };
+    }
+
+    if (header[4] != 0 && size_t(header[4]) != size_t(header[3]) * CHUNKS) { return false; }
+    if (size_t(header[4]) * sizeof(Chunk) > size_t(_end - _data)) { return false; }
+    m_chunks.resize(header[4]);
+    if (!m_chunks.empty() && !read(m_chunks.data(), m_chunks.size() * sizeof(Chunk))) { return false; }
+
+    size_t vertexBytes = size_t(header[1]) * header[0];
+    size_t indexBytes = size_t(header[2]) * sizeof(GLushort);
+    if (size_t(_end - _data) < vertexBytes + indexBytes) { return false; }
+
+    m_nVertices = header[1];
+    m_glVertexData = new GLbyte[vertexBytes];
+    read(m_glVertexData, vertexBytes);
+
+    m_nIndices = header[2];
+    if (m_nIndices > 0) {
+        m_glIndexData = new GLushort[m_nIndices];
+        read(m_glIndexData, indexBytes);
+    }
+
+    // Serialized meshes are optimized already
+    countVertexInvocations();
+    m_selectable = m_vertexLayout->hasAttrib("a_selection_color");
+    retainData();
+    m_isCompiled = true;
+    return true;
+}
+
 // Add indices by collecting them into batches to draw as much as
 // possible in one draw call.  The indices must be shifted by the
 // number of vertices that are present in the current batch.
@@ -255,6 +448,277 @@ size_t MeshBase::compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>
     return _offset + src;
 }
 
+static std::atomic<bool> s_optimizeVertexCache{true};
+
+void MeshBase::setOptimizeVertexCache(bool _enabled) {
+    s_optimizeVertexCache = _enabled;
+}
+
+bool MeshBase::optimizeVertexCache() {
+    return s_optimizeVertexCache;
+}
+
+void MeshBase::packVertices() {
+    if (!m_compiledLayout || m_compiledLayout == m_vertexLayout) { return; }
+
+    m_selectable = m_compiledLayout->hasAttrib("a_selection_color") ||
+        !m_vertexLayout->hasAttrib("a_selection_color");
+
+    // Byte ranges (source offset, size) of a vertex to keep, merged when adjacent
+    std::vector<std::pair<size_t, size_t>> ranges;
+    auto attribs = m_compiledLayout->getAttribs();
+    size_t stride = m_compiledLayout->getStride();
+
+    for (size_t i = 0; i < attribs.size(); i++) {
+        size_t size = (i + 1 < attribs.size() ? attribs[i + 1].offset : stride) - attribs[i].offset;
+        size_t offset = m_vertexLayout->getOffset(attribs[i].name);
+
+        if (!ranges.empty() && ranges.back().first + ranges.back().second == offset) {
+            ranges.back().second += size;
+        } else {
+            ranges.emplace_back(offset, size);
+        }
+    }
+
+    // Packed in place, vertices only move towards the start of the data
+    size_t sourceStride = m_vertexLayout->getStride();
+    GLbyte* dst = m_glVertexData;
+    for (size_t v = 0; v < m_nVertices; v++) {
+        const GLbyte* src = m_glVertexData + v * sourceStride;
+        for (const auto& range : ranges) {
+            std::memmove(dst, src + range.first, range.second);
+            dst += range.second;
+        }
+    }
+
+    m_vertexLayout = m_compiledLayout;
+}
+
+void MeshBase::optimizeIndices(size_t _stride) {
+
+    // Dynamic meshes update vertices by their position
+    bool staticTriangles = m_nIndices > 0 && m_drawMode == GL_TRIANGLES && m_hint == GL_STATIC_DRAW &&
+        m_reorderTriangles;
+
+    if (staticTriangles && m_chunkScale > 0.f) { buildChunks(_stride); }
+
+    if (!staticTriangles || !s_optimizeVertexCache) {
+        countVertexInvocations();
+        return;
+    }
+
+    static thread_local VertexCacheOptimizer optimizer;
+
+    size_t indexOffset = 0;
+    size_t vertexOffset = 0;
+    m_vertexInvocations = 0;
+
+    for (size_t i = 0; i < m_vertexOffsets.size(); i++) {
+        auto& batch = m_vertexOffsets[i];
+        uint16_t* indices = m_glIndexData + indexOffset;
+        GLbyte* vertices = m_glVertexData + vertexOffset * _stride;
+
+        bool valid = vertexOffset + batch.second <= m_nVertices;
+        if (valid && !m_chunks.empty()) {
+            // Keep the triangles of each chunk together
+            for (int c = 0; c < CHUNKS; c++) {
+                const auto& chunk = m_chunks[i * CHUNKS + c];
+                valid &= optimizer.optimizeTriangles(m_glIndexData + chunk.firstIndex, chunk.nIndices,
+                                                     batch.second);
+            }
+        } else if (valid) {
+            valid = optimizer.optimizeTriangles(indices, batch.first, batch.second);
+        }
+        if (valid) {
+            optimizer.optimizeFetch(indices, batch.first, vertices, batch.second, _stride);
+        }
+
+        m_vertexInvocations += VertexCacheOptimizer::vertexInvocations(indices, batch.first, batch.second);
+
+        indexOffset += batch.first;
+        vertexOffset += batch.second;
+    }
+}
+
+void MeshBase::setChunking(float _positionScale, float _padding) {
+    m_chunkScale = _positionScale;
+    m_chunkPadding = _padding;
+}
+
+void MeshBase::buildChunks(size_t _stride) {
+
+    m_chunks.clear();
+    m_chunkMasks.clear();
+
+    auto attribs = m_vertexLayout->getAttribs();
+    auto position = std::find_if(attribs.begin(), attribs.end(),
+                                 [](const auto& attrib) { return attrib.name == "a_position"; });
+    if (position == attribs.end() || position->type != GL_SHORT || position->size < 2) { return; }
+
+    size_t components = std::min(3, int(position->size));
+
+    std::vector<Chunk> chunks(m_vertexOffsets.size() * CHUNKS);
+    std::vector<uint8_t> triangleChunks;
+    std::vector<GLushort> sorted;
+
+    size_t indexOffset = 0;
+    size_t vertexOffset = 0;
+
+    for (size_t i = 0; i < m_vertexOffsets.size(); i++) {
+        size_t nIndices = m_vertexOffsets[i].first;
+        size_t nVertices = m_vertexOffsets[i].second;
+
+        if (nIndices % 3 != 0 || vertexOffset + nVertices > m_nVertices) { return; }
+
+        GLushort* indices = m_glIndexData + indexOffset;
+        const GLbyte* vertices = m_glVertexData + vertexOffset * _stride + position->offset;
+
+        auto vertexPosition = [&](GLushort _index) {
+            int16_t p[3] = { 0, 0, 0 };
+            std::memcpy(p, vertices + _index * _stride, components * sizeof(int16_t));
+            return glm::vec3(p[0], p[1], p[2]) / m_chunkScale;
+        };
+
+        Chunk* batchChunks = &chunks[i * CHUNKS];
+        for (int c = 0; c < CHUNKS; c++) {
+            batchChunks[c].min = glm::vec3(std::numeric_limits<float>::max());
+            batchChunks[c].max = glm::vec3(std::numeric_limits<float>::lowest());
+        }
+
+        // Assign each triangle to the cell of its centroid
+        triangleChunks.resize(nIndices / 3);
+        for (size_t t = 0; t < nIndices / 3; t++) {
+            const GLushort* tri = &indices[t * 3];
+            if (tri[0] >= nVertices || tri[1] >= nVertices || tri[2] >= nVertices) { return; }
+
+            glm::vec3 a = vertexPosition(tri[0]);
+            glm::vec3 b = vertexPosition(tri[1]);
+            glm::vec3 c = vertexPosition(tri[2]);
+            glm::vec3 centroid = (a + b + c) / 3.f;
+
+            int x = glm::clamp(int(centroid.x * CHUNK_GRID), 0, CHUNK_GRID - 1);
+            int y = glm::clamp(int(centroid.y * CHUNK_GRID), 0, CHUNK_GRID - 1);
+            int cell = y * CHUNK_GRID + x;
+            triangleChunks[t] = uint8_t(cell);
+
+            Chunk& chunk = batchChunks[cell];
+            chunk.nIndices += 3;
+            chunk.min = glm::min(chunk.min, glm::min(a, glm::min(b, c)));
+            chunk.max = glm::max(chunk.max, glm::max(a, glm::max(b, c)));
+        }
+
+        // Sort the triangles by chunk, keeping their order within a chunk
+        uint32_t first = uint32_t(indexOffset);
+        for (int c = 0; c < CHUNKS; c++) {
+            batchChunks[c].firstIndex = first;
+            first += batchChunks[c].nIndices;
+
+            glm::vec3 padding(m_chunkPadding, m_chunkPadding, 0.f);
+            batchChunks[c].min -= padding;
+            batchChunks[c].max += padding;
+        }
+
+        sorted.resize(nIndices);
+        uint32_t cursor[CHUNKS];
+        for (int c = 0; c < CHUNKS; c++) { cursor[c] = batchChunks[c].firstIndex - uint32_t(indexOffset); }
+        for (size_t t = 0; t < nIndices / 3; t++) {
+            uint32_t& dst = cursor[triangleChunks[t]];
+            std::memcpy(&sorted[dst], &indices[t * 3], 3 * sizeof(GLushort));
+            dst += 3;
+        }
+        std::memcpy(indices, sorted.data(), nIndices * sizeof(GLushort));
+
+        indexOffset += nIndices;
+        vertexOffset += nVertices;
+    }
+
+    m_chunks = std::move(chunks);
+}
+
+// Whether the box from @_min to @_max may intersect the view frustum of @_mvp, i.e. its
+// corners are not all outside of one clip plane
+static bool boxInFrustum(const glm::mat4& _mvp, const glm::vec3& _min, const glm::vec3& _max) {
+    int outside[6] = { 0, 0, 0, 0, 0, 0 };
+
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 p = _mvp * glm::vec4((i & 1) ? _max.x : _min.x,
+                                       (i & 2) ? _max.y : _min.y,
+                                       (i & 4) ? _max.z : _min.z, 1.f);
+        outside[0] += p.x < -p.w;
+        outside[1] += p.x > p.w;
+        outside[2] += p.y < -p.w;
+        outside[3] += p.y > p.w;
+        outside[4] += p.z < -p.w;
+        outside[5] += p.z > p.w;
+    }
+    for (int count : outside) {
+        if (count == 8) { return false; }
+    }
+    return true;
+}
+
+void MeshBase::cullChunks(const glm::mat4& _mvp, glm::vec2 _elevation) {
+    if (m_chunks.empty()) { return; }
+
+    size_t batches = m_chunks.size() / CHUNKS;
+    m_chunkMasks.assign(batches, 0);
+
+    for (size_t i = 0; i < batches; i++) {
+        for (int c = 0; c < CHUNKS; c++) {
+            const auto& chunk = m_chunks[i * CHUNKS + c];
+            if (chunk.nIndices == 0) { continue; }
+
+            glm::vec3 min(chunk.min.x, chunk.min.y, chunk.min.z + _elevation.x);
+            glm::vec3 max(chunk.max.x, chunk.max.y, chunk.max.z + _elevation.y);
+            if (boxInFrustum(_mvp, min, max)) { m_chunkMasks[i] |= 1 << c; }
+        }
+    }
+}
+
+void MeshBase::hideCoveredChunks(uint16_t _cells) {
+    if (m_chunks.empty() || _cells == 0) { return; }
+
+    size_t batches = m_chunks.size() / CHUNKS;
+    if (m_chunkMasks.empty()) { m_chunkMasks.assign(batches, 0xffff); }
+
+    for (size_t i = 0; i < batches; i++) {
+        for (int c = 0; c < CHUNKS; c++) {
+            if (!(m_chunkMasks[i] & (1 << c))) { continue; }
+            const auto& chunk = m_chunks[i * CHUNKS + c];
+            if (chunk.nIndices == 0) { continue; }
+
+            // Triangles are assigned to chunks by their centroid, so a chunk may reach into
+            // neighbouring cells; it is only skipped when all cells under its bounds are covered
+            if (chunk.min.x < 0.f || chunk.min.y < 0.f || chunk.max.x > 1.f || chunk.max.y > 1.f) {
+                continue;
+            }
+            int x0 = int(chunk.min.x * CHUNK_GRID), x1 = std::min(int(chunk.max.x * CHUNK_GRID), CHUNK_GRID - 1);
+            int y0 = int(chunk.min.y * CHUNK_GRID), y1 = std::min(int(chunk.max.y * CHUNK_GRID), CHUNK_GRID - 1);
+            bool covered = true;
+            for (int y = y0; y <= y1 && covered; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    if (!(_cells & (1 << (y * CHUNK_GRID + x)))) { covered = false; break; }
+                }
+            }
+            if (covered) { m_chunkMasks[i] &= ~(1 << c); }
+        }
+    }
+}
+
+void MeshBase::countVertexInvocations() {
+
+    size_t indexOffset = 0;
+    m_vertexInvocations = 0;
+
+    if (m_nIndices == 0) { return; }
+
+    for (auto& batch : m_vertexOffsets) {
+        m_vertexInvocations += VertexCacheOptimizer::vertexInvocations(m_glIndexData + indexOffset,
+                                                                       batch.first, batch.second);
+        indexOffset += batch.first;
+    }
+}
+
 void MeshBase::setDirty(GLintptr _byteOffset, GLsizei _byteSize) {
 
     if (!m_dirty) {
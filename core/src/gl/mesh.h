@@ -1,12 +1,17 @@
 #pragma once
 
 #include "gl.h"
+#include "gl/bufferPool.h"
+#include "gl/retainedData.h"
 #include "gl/vertexLayout.h"
 #include "gl/vao.h"
 #include "style/style.h"
 #include "util/types.h"
 #include "platform.h"
 
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+
 #include <string>
 #include <vector>
 #include <memory>
@@ -71,10 +76,106 @@ public:
      */
     bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true);
 
+    /*
+     * Uploads the geometry unless it is uploaded already, e.g. to upload it ahead of
+     * the first draw; returns the number of bytes uploaded
+     */
+    size_t uploadPending(RenderState& rs);
+
     size_t bufferSize() const;
 
+    /*
+     * Whether the mesh can be drawn again after the GL context is lost: it is not uploaded
+     * yet or its data is retained, see RetainedData
+     */
+    bool restorable() const;
+
+    /*
+     * Append compiled vertices and indices to _out; fails when the mesh is not
+     * compiled or when its data was released by upload()
+     */
+    bool serialize(std::vector<char>& _out) const;
+
+    /*
+     * Set compiled vertices and indices from data written by serialize(), advancing
+     * _data; fails on truncated data or data for another vertex layout
+     */
+    bool deserialize(const char*& _data, const char* _end);
+
+    /*
+     * Estimated number of vertex shader invocations to draw the mesh once, counted when
+     * it is compiled; 0 for meshes without indices
+     */
+    size_t vertexInvocations() const { return m_vertexInvocations; }
+
+    /*
+     * Whether compile() reorders the triangles and vertices of static triangle meshes for
+     * the post-transform vertex cache of the GPU, see VertexCacheOptimizer; on by default
+     */
+    static void setOptimizeVertexCache(bool _enabled);
+    static bool optimizeVertexCache();
+
+    /*
+     * Whether compile() may reorder the triangles of this mesh, off by default: only meshes of
+     * opaque, depth-tested styles opt in, as meshes drawn in painter's order, i.e. without
+     * depth test or with blending, need to keep their order
+     */
+    void setReorderTriangles(bool _reorder) { m_reorderTriangles = _reorder; }
+
+    /*
+     * Pack the vertices into @_layout when compiled and draw them with it, leaving out the
+     * attributes of the vertex layout of the mesh which are not in @_layout; @_layout must
+     * keep their locations, see VertexLayout::without()
+     */
+    void setCompiledLayout(std::shared_ptr<VertexLayout> _layout) { m_compiledLayout = _layout; }
+
+    /*
+     * False when the vertices have no selection colors, i.e. a_selection_color was
+     * left out by the compiled layout
+     */
+    bool selectable() const { return m_selectable; }
+
+    /*
+     * Split the triangles of each batch into a grid of CHUNK_GRID x CHUNK_GRID chunks over the
+     * tile when compiled, so that chunks outside of the view can be skipped, see cullChunks().
+     * Positions are read from the GL_SHORT attribute a_position, in tile units times
+     * @_positionScale; the bounds of the chunks are widened by @_padding tile units, e.g. for
+     * the extrusion of lines. Only applies to static triangle meshes which may be reordered.
+     */
+    void setChunking(float _positionScale, float _padding);
+
+    /*
+     * Draw only the chunks whose bounds, raised by @_elevation (min, max) in tile units, may
+     * intersect the view frustum of @_mvp, which transforms tile units to clip space
+     */
+    void cullChunks(const glm::mat4& _mvp, glm::vec2 _elevation);
+
+    /*
+     * Also skip the chunks whose bounds lie within the cells of the CHUNK_GRID x CHUNK_GRID grid
+     * over the tile set in @_cells (bit y * CHUNK_GRID + x, in tile units), e.g. where a proxy
+     * tile is covered by loaded tiles of higher zoom
+     */
+    void hideCoveredChunks(uint16_t _cells);
+
+    /*
+     * Draw all chunks again
+     */
+    void showAllChunks() { m_chunkMasks.clear(); }
+
+    static constexpr int CHUNK_GRID = 4;
+    static constexpr int CHUNKS = CHUNK_GRID * CHUNK_GRID;
+
 protected:
 
+    struct Chunk {
+        // Range in the indices of the mesh
+        uint32_t firstIndex = 0;
+        uint32_t nIndices = 0;
+        // Bounds of the vertices in tile units
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
     // Used in draw for legth and offsets: sumIndices, sumVertices
     // needs to be set by compile()
     std::vector<std::pair<uint32_t, uint32_t>> m_vertexOffsets;
@@ -83,6 +184,8 @@ protected:
 
     size_t m_nVertices;
     GLuint m_glVertexBuffer;
+    // Range of a pooled buffer holding the vertices, when not in an own buffer
+    BufferPool::Range m_vertexRange;
 
     Vao m_vaos;
 
@@ -91,6 +194,7 @@ protected:
 
     size_t m_nIndices;
     GLuint m_glIndexBuffer;
+    BufferPool::Range m_indexRange;
     // Compiled  indices for upload
     GLushort* m_glIndexData = nullptr;
 
@@ -106,10 +210,46 @@ protected:
     GLsizei m_dirtySize;
     GLintptr m_dirtyOffset;
 
+    size_t m_vertexInvocations = 0;
+    bool m_reorderTriangles = false;
+
+    std::shared_ptr<VertexLayout> m_compiledLayout;
+    bool m_selectable = true;
+
+    // CHUNKS chunks per vertex batch, empty when not chunked
+    std::vector<Chunk> m_chunks;
+    // Visible chunks of each batch after cullChunks(), all chunks when empty
+    std::vector<uint16_t> m_chunkMasks;
+    float m_chunkScale = 0.f;
+    float m_chunkPadding = 0.f;
+
+    // Sort the triangles of each batch by chunk and set m_chunks
+    void buildChunks(size_t _stride);
+
+    // Pack the compiled vertices into m_compiledLayout, which becomes the vertex layout
+    void packVertices();
+
+    // Reorder the compiled indices and vertices of each batch for the vertex cache when
+    // enabled for this mesh and count m_vertexInvocations
+    void optimizeIndices(size_t _stride);
+    void countVertexInvocations();
+
     size_t compileIndices(const std::vector<std::pair<uint32_t, uint32_t>>& _offsets,
                           const std::vector<uint16_t>& _indices, size_t _offset);
 
     void setDirty(GLintptr _byteOffset, GLsizei _byteSize);
+
+    // Keep deflated copies of the compiled data of static meshes, when enabled
+    void retainData();
+
+    // Forget the buffers of a lost GL context, taking the retained data for the next upload;
+    // returns false when there is nothing to upload
+    bool restore();
+
+    RetainedData m_retainedVertices;
+    RetainedData m_retainedIndices;
+    // RenderState::contextGeneration() of the upload
+    uint32_t m_contextGeneration = 0;
 };
 
 template<class T>
@@ -151,6 +291,44 @@ public:
         return MeshBase::draw(rs, shader, useVao);
     }
 
+    size_t uploadPending(RenderState& rs) override {
+        return MeshBase::uploadPending(rs);
+    }
+
+    bool serialize(std::vector<char>& _out) const override {
+        return MeshBase::serialize(_out);
+    }
+
+    size_t vertexInvocations() const override {
+        return MeshBase::vertexInvocations();
+    }
+
+    size_t vertexCount() const override { return m_nVertices; }
+
+    void cullChunks(const glm::mat4& _mvp, glm::vec2 _elevation) override {
+        MeshBase::cullChunks(_mvp, _elevation);
+    }
+
+    void showAllChunks() override {
+        MeshBase::showAllChunks();
+    }
+
+    void hideCoveredChunks(uint16_t _cells) override {
+        MeshBase::hideCoveredChunks(_cells);
+    }
+
+    bool selectable() const override {
+        return MeshBase::selectable();
+    }
+
+    bool restorable() const override {
+        return MeshBase::restorable();
+    }
+
+    using MeshBase::setChunking;
+    using MeshBase::setCompiledLayout;
+    using MeshBase::setReorderTriangles;
+
     void compile(const std::vector<MeshData<T>>& _meshes);
 
     void compile(const MeshData<T>& _mesh);
@@ -171,6 +349,57 @@ public:
                          size_t _attribOffset = 0);
 };
 
+/*
+ * CompiledMesh - Static mesh restored from the serialized data of a Mesh
+ */
+class CompiledMesh : public StyledMesh, protected MeshBase {
+public:
+
+    CompiledMesh(std::shared_ptr<VertexLayout> _vertexLayout, GLenum _drawMode)
+        : MeshBase(_vertexLayout, _drawMode) {}
+
+    size_t bufferSize() const override {
+        return MeshBase::bufferSize();
+    }
+
+    bool draw(RenderState& rs, ShaderProgram& shader, bool useVao = true) override {
+        return MeshBase::draw(rs, shader, useVao);
+    }
+
+    size_t uploadPending(RenderState& rs) override {
+        return MeshBase::uploadPending(rs);
+    }
+
+    bool serialize(std::vector<char>& _out) const override {
+        return MeshBase::serialize(_out);
+    }
+
+    size_t vertexInvocations() const override {
+        return MeshBase::vertexInvocations();
+    }
+
+    size_t vertexCount() const override { return m_nVertices; }
+
+    void cullChunks(const glm::mat4& _mvp, glm::vec2 _elevation) override {
+        MeshBase::cullChunks(_mvp, _elevation);
+    }
+
+    void showAllChunks() override {
+        MeshBase::showAllChunks();
+    }
+
+    bool selectable() const override {
+        return MeshBase::selectable();
+    }
+
+    bool restorable() const override {
+        return MeshBase::restorable();
+    }
+
+    bool deserialize(const char*& _data, const char* _end) {
+        return MeshBase::deserialize(_data, _end);
+    }
+};
 
 template<class T>
 void Mesh<T>::compile(const std::vector<MeshData<T>>& _meshes) {
@@ -208,6 +437,9 @@ void Mesh<T>::compile(const std::vector<MeshData<T>>& _meshes) {
         assert(offset == m_nIndices);
     }
 
+    packVertices();
+    optimizeIndices(m_vertexLayout->getStride());
+    retainData();
     m_isCompiled = true;
 }
 
@@ -229,6 +461,9 @@ void Mesh<T>::compile(const MeshData<T>& _mesh) {
         compileIndices(_mesh.offsets, _mesh.indices, 0);
     }
 
+    packVertices();
+    optimizeIndices(m_vertexLayout->getStride());
+    retainData();
     m_isCompiled = true;
 }
 
@@ -0,0 +1,97 @@
+#include "gl/pixelReadback.h"
+
+#include "log.h"
+
+#include <cstring>
+
+namespace Tangram {
+
+PixelReadback::~PixelReadback() {
+    for (auto& slot : m_slots) {
+        if (slot.fence) { GL::deleteSync(slot.fence); }
+        if (slot.buffer) { GL::deleteBuffers(1, &slot.buffer); }
+    }
+}
+
+int PixelReadback::start(const FrameBuffer::PixelRect& _rect, GLenum _format, GLenum _type) {
+
+    for (int i = 0; i < SLOTS; i++) {
+        auto& slot = m_slots[i];
+        if (slot.pending) { continue; }
+
+        slot.rect = _rect;
+        slot.rect.pixels.clear();
+        slot.pending = true;
+
+        GLsizeiptr size = GLsizeiptr(_rect.width) * _rect.height * sizeof(GLuint);
+        if (size == 0) { return i; }
+
+        if (slot.buffer == 0) { GL::genBuffers(1, &slot.buffer); }
+
+        GL::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        if (slot.capacity < size) {
+            GL::bufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+            slot.capacity = size;
+        }
+        // With a pack buffer bound the pointer is an offset into it
+        GL::readPixels(_rect.left, _rect.bottom, _rect.width, _rect.height,
+                       _format, _type, nullptr);
+        GL::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        slot.fence = GL::fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        return i;
+    }
+    return -1;
+}
+
+bool PixelReadback::poll(int _slot, FrameBuffer::PixelRect& _rect) {
+
+    if (_slot < 0 || _slot >= SLOTS || !m_slots[_slot].pending) { return false; }
+
+    auto& slot = m_slots[_slot];
+
+    if (slot.fence) {
+        // Flush so that the fence is signaled without waiting for the next swap
+        GLenum status = GL::clientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) { return false; }
+
+        GL::deleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        if (status == GL_WAIT_FAILED) {
+            LOGW("Waiting for pixel readback failed");
+        } else {
+            size_t count = size_t(slot.rect.width) * slot.rect.height;
+            GL::bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            auto* data = GL::mapBufferRange(GL_PIXEL_PACK_BUFFER, 0, count * sizeof(GLuint), GL_MAP_READ_BIT);
+            if (data) {
+                slot.rect.pixels.resize(count);
+                std::memcpy(slot.rect.pixels.data(), data, count * sizeof(GLuint));
+                GL::unmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            GL::bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+    }
+
+    // Reads that failed return an empty rect
+    if (slot.rect.pixels.empty()) { slot.rect.width = slot.rect.height = 0; }
+
+    _rect = std::move(slot.rect);
+    slot.rect = FrameBuffer::PixelRect();
+    slot.pending = false;
+    return true;
+}
+
+int PixelReadback::inFlight() const {
+    int count = 0;
+    for (const auto& slot : m_slots) {
+        if (slot.pending) { count++; }
+    }
+    return count;
+}
+
+void PixelReadback::invalidate() {
+    m_slots = {};
+}
+
+}
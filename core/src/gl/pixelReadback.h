@@ -0,0 +1,59 @@
+#pragma once
+
+#include "gl.h"
+#include "gl/framebuffer.h"
+
+#include <array>
+
+namespace Tangram {
+
+/*
+ * PixelReadback - Reads pixels of the bound framebuffer without waiting for the GPU
+ *
+ * start() copies a rect into one of two pixel buffer objects and inserts a fence after the
+ * copy; poll() maps the buffer once the fence is signaled, typically one or two frames later.
+ * Requires Hardware::supportsAsyncReadback; all calls must be made on the GL thread.
+ */
+class PixelReadback {
+
+public:
+
+    static constexpr int SLOTS = 2;
+
+    PixelReadback() = default;
+    ~PixelReadback();
+
+    PixelReadback(const PixelReadback&) = delete;
+    PixelReadback& operator=(const PixelReadback&) = delete;
+
+    /* Start reading the pixels of @_rect from the bound framebuffer in @_format and @_type,
+     * which must have 4 bytes per pixel; returns the slot of the read, or -1 when all slots
+     * are in use */
+    int start(const FrameBuffer::PixelRect& _rect, GLenum _format = GL_RGBA,
+              GLenum _type = GL_UNSIGNED_BYTE);
+
+    /* Returns true and the pixels of the read in slot @_slot in @_rect once they are
+     * available, which frees the slot */
+    bool poll(int _slot, FrameBuffer::PixelRect& _rect);
+
+    /* Number of started reads which were not returned by poll() yet */
+    int inFlight() const;
+
+    /* Forget buffers and fences without deleting them, e.g. after GL context loss;
+     * started reads are dropped */
+    void invalidate();
+
+private:
+
+    struct Slot {
+        GLuint buffer = 0;
+        GLsizeiptr capacity = 0;
+        GLsync fence = nullptr;
+        FrameBuffer::PixelRect rect;
+        bool pending = false;
+    };
+
+    std::array<Slot, SLOTS> m_slots;
+};
+
+}
@@ -83,7 +83,7 @@ void drawPoly(RenderState& rs, const glm::vec2* _polygon, size_t _n) {
     rs.depthTest(GL_FALSE);
     rs.vertexBuffer(s_VBO);
     if (s_VAO) {
-        GL::bindVertexArray(s_VAO);
+        rs.vertexArray(s_VAO);
         s_layout->enable(0);
         GL::bufferData(GL_ARRAY_BUFFER, _n*s_layout->getStride(), _polygon, GL_STREAM_DRAW);
     } else {
@@ -92,7 +92,6 @@ void drawPoly(RenderState& rs, const glm::vec2* _polygon, size_t _n) {
 
     GL::drawArrays(_n > 2 ? GL_LINE_LOOP : GL_LINES, 0, _n);
 
-    if (s_VAO) { GL::bindVertexArray(0); }
     rs.vertexBuffer(0);
 }
 
@@ -136,7 +135,7 @@ void drawTexture(RenderState& rs, Texture& _tex, glm::vec2 _pos, glm::vec2 _dim,
     rs.depthTest(GL_FALSE);
     rs.vertexBuffer(s_VBO);
     if (s_VAO) {
-        GL::bindVertexArray(s_VAO);
+        rs.vertexArray(s_VAO);
         s_textureLayout->enable(0);
         GL::bufferData(GL_ARRAY_BUFFER, 6*s_textureLayout->getStride(), vertices, GL_STREAM_DRAW);
     } else {
@@ -145,7 +144,6 @@ void drawTexture(RenderState& rs, Texture& _tex, glm::vec2 _pos, glm::vec2 _dim,
 
     GL::drawArrays(GL_TRIANGLES, 0, 6);
 
-    if (s_VAO) { GL::bindVertexArray(0); }
     rs.vertexBuffer(0);
 }
 
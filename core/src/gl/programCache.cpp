@@ -0,0 +1,145 @@
+#include "gl/programCache.h"
+
+#include "gl/hardware.h"
+#include "gl/vertexLayout.h"
+#include "log.h"
+#include "tile/tileDiskCache.h"
+#include "util/mappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#define PROGRAM_CACHE_MAGIC 0x42504754 // "TGPB"
+#define PROGRAM_CACHE_VERSION 1
+
+namespace Tangram {
+
+struct ProgramCache::Header {
+    uint32_t magic = PROGRAM_CACHE_MAGIC;
+    uint32_t version = PROGRAM_CACHE_VERSION;
+    uint64_t key = 0;
+    uint32_t format = 0;
+    uint32_t length = 0;
+};
+
+void ProgramCache::setDirectory(const std::string& _dir) {
+    m_dir = _dir;
+}
+
+bool ProgramCache::enabled() const {
+    return !m_dir.empty() && Hardware::supportsProgramBinary;
+}
+
+uint64_t ProgramCache::driverKey() {
+    if (m_driverKey == 0) {
+        uint64_t key = TileDiskCache::hash(&Hardware::glVersion, sizeof(Hardware::glVersion));
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+            auto value = reinterpret_cast<const char*>(GL::getString(name));
+            key = TileDiskCache::hash(std::string(value ? value : "") + '\0', key);
+        }
+        m_driverKey = key;
+    }
+    return m_driverKey;
+}
+
+uint64_t ProgramCache::key(const std::string& _vertSrc, const std::string& _fragSrc,
+                           const VertexLayout& _layout) {
+    // Separators keep e.g. sources "a" and "b" apart from "ab" and ""
+    uint64_t key = TileDiskCache::hash(_vertSrc + '\0', driverKey());
+    key = TileDiskCache::hash(_fragSrc + '\0', key);
+    // Attribute locations are bound before linking and part of the binary
+    for (const auto& attrib : _layout.getAttribs()) {
+        key = TileDiskCache::hash(attrib.name + '\0', key);
+    }
+    return key;
+}
+
+std::string ProgramCache::filename(uint64_t _key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "program_%016llx.bin", (unsigned long long)_key);
+    return m_dir + name;
+}
+
+GLuint ProgramCache::load(uint64_t _key) {
+
+    auto path = filename(_key);
+
+    MappedFile file;
+    Header header;
+    if (!file.open(path) || file.size() < sizeof(Header)) {
+        m_stats.misses++;
+        return 0;
+    }
+    std::memcpy(&header, file.data(), sizeof(Header));
+
+    Header expected;
+    if (header.magic != expected.magic || header.version != expected.version ||
+        header.key != _key || header.length != file.size() - sizeof(Header)) {
+        m_stats.misses++;
+        return 0;
+    }
+
+    GLuint program = GL::createProgram();
+    GL::programBinary(program, header.format, file.data() + sizeof(Header), header.length);
+
+    // Drivers reject binaries e.g. after an update that did not change their version string
+    GLint isLinked = GL_FALSE;
+    GL::getProgramiv(program, GL_LINK_STATUS, &isLinked);
+    if (isLinked == GL_FALSE) {
+        LOGD("Program binary rejected: %s", path.c_str());
+        GL::deleteProgram(program);
+        file.close();
+        std::remove(path.c_str());
+        m_stats.misses++;
+        m_stats.rejected++;
+        return 0;
+    }
+
+    m_stats.hits++;
+    return program;
+}
+
+void ProgramCache::store(uint64_t _key, GLuint _program) {
+
+    GLint length = 0;
+    GL::getProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) { return; }
+
+    std::vector<char> data(sizeof(Header) + length);
+
+    GLsizei written = 0;
+    GLenum format = 0;
+    GL::getProgramBinary(_program, length, &written, &format, data.data() + sizeof(Header));
+    if (written <= 0 || written > length) { return; }
+
+    Header header;
+    header.key = _key;
+    header.format = format;
+    header.length = uint32_t(written);
+    std::memcpy(data.data(), &header, sizeof(Header));
+    data.resize(sizeof(Header) + written);
+
+    // Write to a temporary file so that incomplete binaries are never loaded
+    auto path = filename(_key);
+    auto tmpPath = path + ".tmp";
+
+    std::ofstream out(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    out.write(data.data(), data.size());
+    out.close();
+
+    if (!out) {
+        LOGW("Cannot write program binary: %s", tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return;
+    }
+
+    // rename does not replace existing files on all platforms
+    std::remove(path.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+    }
+}
+
+}
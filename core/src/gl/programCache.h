@@ -0,0 +1,64 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Tangram {
+
+class VertexLayout;
+
+/* Disk cache of linked program binaries
+ *
+ * Programs are stored with glGetProgramBinary after they were first linked and restored with
+ * glProgramBinary in later sessions, which skips compiling and linking their shaders. Entries
+ * are keyed by the shader sources and attribute bindings of a program and by the GL vendor,
+ * renderer and version strings, so that binaries are not offered to another driver. When the
+ * driver still rejects a binary it is removed and the program is compiled from source.
+ *
+ * The cache is used on the GL thread only; it is disabled while it has no directory or the
+ * driver does not support program binaries, see Hardware::supportsProgramBinary.
+ */
+class ProgramCache {
+
+public:
+
+    struct Stats {
+        uint32_t hits = 0;
+        uint32_t misses = 0;
+        // Binaries that were rejected by the driver, also counted as misses
+        uint32_t rejected = 0;
+    };
+
+    /* Keep binaries in directory @_dir; an empty path disables the cache */
+    void setDirectory(const std::string& _dir);
+
+    bool enabled() const;
+
+    /* Key of a program linked from @_vertSrc and @_fragSrc with the attributes of @_layout */
+    uint64_t key(const std::string& _vertSrc, const std::string& _fragSrc, const VertexLayout& _layout);
+
+    /* Create a program from the binary for @_key; returns 0 when there is none or the
+     * driver rejects it */
+    GLuint load(uint64_t _key);
+
+    /* Store the binary of linked @_program for @_key */
+    void store(uint64_t _key, GLuint _program);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+
+    struct Header;
+
+    uint64_t driverKey();
+
+    std::string filename(uint64_t _key) const;
+
+    std::string m_dir;
+    uint64_t m_driverKey = 0;
+    Stats m_stats;
+};
+
+}
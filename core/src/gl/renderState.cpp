@@ -27,10 +27,11 @@ RenderState::RenderState() {
     m_cullFace = { 0, false };
     m_vertexBuffer = { 0, false };
     m_indexBuffer = { 0, false };
+    m_vertexArray = { 0, false };
     m_program = { 0, false };
     m_clearColor = { 0., 0., 0., 0., false };
     m_defaultOpaqueClearColor = { 0., 0., 0., false };
-    m_texture = { 0, 0, false };
+    m_textures.fill({ 0, 0, false });
     m_textureUnit = { 0, false };
     m_framebuffer = { 0, false };
     m_viewport = { 0, 0, 0, 0, false };
@@ -38,13 +39,21 @@ RenderState::RenderState() {
 }
 
 void RenderState::flushResourceDeletion() {
+    bufferPool.collect(*this);
+    textureArrayPool.collect(*this);
+
     std::lock_guard<std::mutex> guard(m_deletionListMutex);
 
     if (m_VAODeletionList.size()) {
+        // Deleting the bound VAO binds the one of the context
+        for (GLuint vao : m_VAODeletionList) {
+            if (m_vertexArray.handle == vao) { m_vertexArray.handle = 0; }
+        }
         GL::deleteVertexArrays(m_VAODeletionList.size(), m_VAODeletionList.data());
         m_VAODeletionList.clear();
     }
     if (m_textureDeletionList.size()) {
+        for (GLuint texture : m_textureDeletionList) { textureUnset(texture); }
         GL::deleteTextures(m_textureDeletionList.size(), m_textureDeletionList.data());
         m_textureDeletionList.clear();
     }
@@ -96,6 +105,8 @@ GLuint RenderState::getTextureUnit(GLuint _unit) {
 RenderState::~RenderState() {
 
     deleteQuadIndexBuffer();
+    GL::deleteBuffers(1, &m_unitQuadBuffer);
+    GL::deleteBuffers(1, &m_lineSegmentBuffer);
     flushResourceDeletion();
 
     for (auto& s : vertexShaders) {
@@ -129,7 +140,8 @@ void RenderState::invalidateStates() {
     m_program.set = false;
     m_indexBuffer.set = false;
     m_vertexBuffer.set = false;
-    m_texture.set = false;
+    m_vertexArray.set = false;
+    m_textures.fill({ 0, 0, false });
     m_textureUnit.set = false;
     m_viewport.set = false;
     m_framebuffer.set = false;
@@ -142,11 +154,22 @@ void RenderState::invalidateStates() {
 }
 
 void RenderState::invalidateHandles() {
+    m_contextGeneration++;
+
     // The shader handles in our caches are no longer valid,
     // so clear them without deleting.
     vertexShaders.clear();
     fragmentShaders.clear();
 
+    m_quadIndexBuffer = 0;
+    m_unitQuadBuffer = 0;
+    m_lineSegmentBuffer = 0;
+
+    bufferPool.invalidate();
+    textureArrayPool.invalidate();
+    frameUniforms.invalidate();
+    gpuTimer.invalidate();
+
     // The handles queued for deletion are no longer valid,
     // so clear them without deleting.
     {
@@ -334,18 +357,28 @@ bool RenderState::shaderProgram(GLuint program) {
 }
 
 void RenderState::texture(GLuint handle, GLuint unit, GLenum target) {
+    // The unit is activated also when the texture is bound, for texture calls that follow
     if (!m_textureUnit.set || m_textureUnit.unit != unit) {
         m_textureUnit = { unit, true };
-        // Our cached texture handle is irrelevant on the new unit, so unset it.
-        m_texture.set = false;
         GL::activeTexture(getTextureUnit(unit));
     }
-    if (!m_texture.set || m_texture.target != target || m_texture.handle != handle) {
-        m_texture = { target, handle, true };
+    if (unit >= MAX_CACHED_TEXTURE_UNITS) {
+        GL::bindTexture(target, handle);
+        return;
+    }
+    auto& bound = m_textures[unit];
+    if (!bound.set || bound.target != target || bound.handle != handle) {
+        bound = { target, handle, true };
         GL::bindTexture(target, handle);
     }
 }
 
+void RenderState::textureUnset(GLuint handle) {
+    for (auto& bound : m_textures) {
+        if (bound.handle == handle) { bound.set = false; }
+    }
+}
+
 bool RenderState::vertexBuffer(GLuint handle) {
     if (!m_vertexBuffer.set || m_vertexBuffer.handle != handle) {
         m_vertexBuffer = { handle, true };
@@ -356,6 +389,7 @@ bool RenderState::vertexBuffer(GLuint handle) {
 }
 
 bool RenderState::indexBuffer(GLuint handle) {
+    bindDefaultVertexArray();
     if (!m_indexBuffer.set || m_indexBuffer.handle != handle) {
         m_indexBuffer = { handle, true };
         GL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
@@ -364,6 +398,28 @@ bool RenderState::indexBuffer(GLuint handle) {
     return true;
 }
 
+bool RenderState::vertexArray(GLuint handle) {
+    if (!m_vertexArray.set || m_vertexArray.handle != handle) {
+        m_vertexArray = { handle, true };
+        GL::bindVertexArray(handle);
+        return false;
+    }
+    return true;
+}
+
+void RenderState::bindDefaultVertexArray() {
+    if (Hardware::supportsVAOs) { vertexArray(m_defaultVertexArray); }
+}
+
+void RenderState::setDefaultVertexArray(GLuint handle) {
+    if (m_defaultVertexArray == handle) { return; }
+    m_defaultVertexArray = handle;
+    // Index buffer and attributes are state of the vertex array
+    m_indexBuffer.set = false;
+    attributeBindings.fill(0);
+    bindDefaultVertexArray();
+}
+
 void RenderState::indexBufferUnset(GLuint handle) {
     if (m_indexBuffer.handle == handle) {
         m_indexBuffer.set = false;
@@ -404,6 +460,39 @@ void RenderState::generateQuadIndexBuffer() {
 
 }
 
+GLuint RenderState::getUnitQuadBuffer() {
+    if (m_unitQuadBuffer == 0) {
+        // Corners in the order of SpriteQuad vertices: top-left, top-right, bottom-left, bottom-right
+        const GLfloat corners[] = { -1.f, 1.f,  1.f, 1.f,  -1.f, -1.f,  1.f, -1.f };
+
+        GL::genBuffers(1, &m_unitQuadBuffer);
+        vertexBuffer(m_unitQuadBuffer);
+        GL::bufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    }
+    return m_unitQuadBuffer;
+}
+
+GLuint RenderState::getLineSegmentBuffer() {
+    if (m_lineSegmentBuffer == 0) {
+        // Corners (end, side, fan point): the body from side -1 to 1 between the start (0) and
+        // end (1) of the segment, then at each end a fan of four triangles around the point (-1)
+        // through the fan points 0 to 4, as two quads
+        const GLfloat corners[] = {
+            0.f, -1.f, -1.f,  1.f, -1.f, -1.f,  0.f, 1.f, -1.f,  1.f, 1.f, -1.f,
+            0.f, 0.f, 0.f,  0.f, 0.f, -1.f,  0.f, 0.f, 1.f,  0.f, 0.f, 2.f,
+            0.f, 0.f, 2.f,  0.f, 0.f, -1.f,  0.f, 0.f, 3.f,  0.f, 0.f, 4.f,
+            1.f, 0.f, 0.f,  1.f, 0.f, -1.f,  1.f, 0.f, 1.f,  1.f, 0.f, 2.f,
+            1.f, 0.f, 2.f,  1.f, 0.f, -1.f,  1.f, 0.f, 3.f,  1.f, 0.f, 4.f,
+        };
+        static_assert(sizeof(corners) == LINE_SEGMENT_QUADS * 4 * 3 * sizeof(GLfloat));
+
+        GL::genBuffers(1, &m_lineSegmentBuffer);
+        vertexBuffer(m_lineSegmentBuffer);
+        GL::bufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    }
+    return m_lineSegmentBuffer;
+}
+
 bool RenderState::framebuffer(GLuint handle) {
     if (!m_framebuffer.set || m_framebuffer.handle != handle) {
         m_framebuffer = { handle, true };
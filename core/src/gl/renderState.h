@@ -1,6 +1,11 @@
 #pragma once
 
 #include "gl.h"
+#include "gl/bufferPool.h"
+#include "gl/frameUniforms.h"
+#include "gl/gpuTimer.h"
+#include "gl/programCache.h"
+#include "gl/textureArrayPool.h"
 #include <array>
 #include <string>
 #include <mutex>
@@ -21,6 +26,12 @@ public:
 
     static constexpr size_t MAX_QUAD_VERTICES = 16384;
 
+    // Body and two fans of a line segment, see getLineSegmentBuffer()
+    static constexpr size_t LINE_SEGMENT_QUADS = 5;
+
+    // Texture units of which RenderState keeps the bound texture
+    static constexpr size_t MAX_CACHED_TEXTURE_UNITS = 32;
+
     RenderState();
     ~RenderState();
 
@@ -40,6 +51,10 @@ public:
     // Reset the resource handle cache.
     void invalidateHandles();
 
+    // Incremented by invalidateHandles(): objects uploaded with another generation hold
+    // handles of a lost context, which must not be used or deleted
+    uint32_t contextGeneration() const { return m_contextGeneration; }
+
     // Get the texture slot from a texture unit from 0 to TANGRAM_MAX_TEXTURE_UNIT-1.
     static GLuint getTextureUnit(GLuint _unit);
 
@@ -93,20 +108,43 @@ public:
 
     bool vertexBuffer(GLuint handle);
 
+    // Binds the index buffer of the default vertex array, binding that first
     bool indexBuffer(GLuint handle);
 
+    // Meshes drawn with VAOs leave theirs bound, so that the next mesh only switches to its own;
+    // the default vertex array is bound again when its index buffer or attributes are set
+    bool vertexArray(GLuint handle);
+
+    // Bind the default vertex array when VAOs are supported, e.g. before the platform draws
+    void bindDefaultVertexArray();
+
+    // Use VAO @handle as the default vertex array, e.g. where drawing without VAOs still needs
+    // one bound (GL 3 core profile); 0 for the one of the context
+    void setDefaultVertexArray(GLuint handle);
+
     bool framebuffer(GLuint handle);
 
     bool viewport(GLint x, GLint y, GLsizei width, GLsizei height);
 
     void indexBufferUnset(GLuint handle);
 
+    // Forget bindings of texture @handle, e.g. before deleting it
+    void textureUnset(GLuint handle);
+
     void cacheDefaultFramebuffer();
 
     GLuint defaultFrameBuffer() const;
 
     GLuint getQuadIndexBuffer();
 
+    // Vertex buffer of the four corners of a unit quad, in the vertex order of the quad
+    // index buffer; see InstancedQuadMesh
+    GLuint getUnitQuadBuffer();
+
+    // Vertex buffer of the corners of the segment drawn for each instance of InstancedLineMesh,
+    // LINE_SEGMENT_QUADS quads in the vertex order of the quad index buffer
+    GLuint getLineSegmentBuffer();
+
     void flushResourceDeletion();
 
     void queueTextureDeletion(GLuint texture);
@@ -124,6 +162,24 @@ public:
     std::unordered_map<std::string, GLuint> fragmentShaders;
     std::unordered_map<std::string, GLuint> vertexShaders;
 
+    // Binaries of linked programs, see ShaderProgram::build()
+    ProgramCache programCache;
+
+    // Shared buffers of static meshes, see MeshBase::upload()
+    BufferPool bufferPool;
+
+    // Shared texture arrays of raster textures, see Texture::bind()
+    TextureArrayPool textureArrayPool;
+
+    // Uniform buffer of the per frame uniforms, see Scene::render()
+    FrameUniformBuffer frameUniforms;
+
+    // Draw calls of meshes, counted from the start of the frame by Map::render()
+    uint32_t drawCalls = 0;
+
+    // GPU time of styles and render passes, see Map::setGpuTiming()
+    GpuTimer gpuTimer;
+
     float frameTime() { return m_frameTime; }
 
     friend class Scene;
@@ -151,6 +207,9 @@ private:
     void deleteQuadIndexBuffer();
     void generateQuadIndexBuffer();
 
+    GLuint m_unitQuadBuffer = 0;
+    GLuint m_lineSegmentBuffer = 0;
+
     struct {
         GLboolean enabled;
         bool set;
@@ -191,7 +250,11 @@ private:
     struct {
         GLuint handle;
         bool set;
-    } m_vertexBuffer, m_indexBuffer;
+    } m_vertexBuffer, m_indexBuffer, m_vertexArray;
+
+    GLuint m_defaultVertexArray = 0;
+
+    uint32_t m_contextGeneration = 0;
 
     struct {
         GLuint program;
@@ -208,11 +271,14 @@ private:
         bool set;
     } m_defaultOpaqueClearColor;
 
-    struct {
+    struct TextureBinding {
         GLenum target;
         GLuint handle;
         bool set;
-    } m_texture;
+    };
+    // Bound texture per unit, so that textures shared by consecutive draws, e.g. texture
+    // arrays, are bound once
+    std::array<TextureBinding, MAX_CACHED_TEXTURE_UNITS> m_textures;
 
     struct {
         GLuint unit;
@@ -0,0 +1,51 @@
+#include "gl/retainedData.h"
+
+#include "util/zlibHelper.h"
+
+#include "miniz.h"
+
+namespace Tangram {
+
+std::atomic<size_t> RetainedData::s_budget{0};
+std::atomic<size_t> RetainedData::s_usage{0};
+
+void RetainedData::setBudget(size_t _bytes) {
+    // Copies kept already stay until they are cleared
+    s_budget = _bytes;
+}
+
+bool RetainedData::store(const void* _data, size_t _size) {
+    clear();
+    if (!enabled() || !_data || _size == 0) { return false; }
+
+    std::vector<char> compressed;
+    if (zlib_deflate(static_cast<const char*>(_data), _size, compressed) != MZ_OK) { return false; }
+
+    // Reserve the bytes of the copy, also when other threads retain data meanwhile
+    size_t usage = s_usage;
+    do {
+        if (usage + compressed.size() > s_budget) { return false; }
+    } while (!s_usage.compare_exchange_weak(usage, usage + compressed.size()));
+
+    compressed.shrink_to_fit();
+    m_data = std::move(compressed);
+    m_size = _size;
+    return true;
+}
+
+bool RetainedData::restore(void* _dst) const {
+    if (m_data.empty()) { return false; }
+
+    mz_ulong length = m_size;
+    int ret = mz_uncompress(static_cast<unsigned char*>(_dst), &length,
+                            reinterpret_cast<const unsigned char*>(m_data.data()), m_data.size());
+    return ret == MZ_OK && length == m_size;
+}
+
+void RetainedData::clear() {
+    if (!m_data.empty()) { s_usage -= m_data.size(); }
+    m_data = {};
+    m_size = 0;
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * RetainedData - Deflated copy of data uploaded to a GL buffer or texture, to upload it again
+ * after the GL context was lost instead of building it again.
+ *
+ * Copies are only kept while their compressed bytes fit into a budget shared by all copies,
+ * see setBudget(); without a budget nothing is retained.
+ */
+class RetainedData {
+
+public:
+
+    RetainedData() = default;
+    ~RetainedData() { clear(); }
+
+    RetainedData(const RetainedData&) = delete;
+    RetainedData& operator=(const RetainedData&) = delete;
+
+    /* Compressed bytes all copies may take, 0 disables retaining data */
+    static void setBudget(size_t _bytes);
+    static size_t budget() { return s_budget; }
+    static size_t usage() { return s_usage; }
+    static bool enabled() { return s_budget > 0; }
+
+    /* Keep a copy of @_size bytes of @_data, replacing the current one; returns false when
+     * retaining is disabled or the copy does not fit into the budget */
+    bool store(const void* _data, size_t _size);
+
+    /* Write the retained data to @_dst, which takes size() bytes */
+    bool restore(void* _dst) const;
+
+    /* Size of the retained data before compression */
+    size_t size() const { return m_size; }
+
+    explicit operator bool() const { return !m_data.empty(); }
+
+    void clear();
+
+private:
+
+    std::vector<char> m_data;
+    size_t m_size = 0;
+
+    static std::atomic<size_t> s_budget;
+    static std::atomic<size_t> s_usage;
+};
+
+}
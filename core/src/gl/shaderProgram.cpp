@@ -1,6 +1,7 @@
 #include "gl/shaderProgram.h"
 
 #include "gl/glError.h"
+#include "gl/hardware.h"
 #include "gl/renderState.h"
 #include "gl/vertexLayout.h"
 #include "glm/gtc/type_ptr.hpp"
@@ -18,7 +19,7 @@ ShaderProgram::ShaderProgram(const std::string& _vertSrc,
     : m_vertexLayout(_layout), m_fragmentShaderSource(_fragSrc), m_vertexShaderSource(_vertSrc) { }
 
 ShaderProgram::~ShaderProgram() {
-    if (m_rs) {
+    if (m_rs && m_contextGeneration == m_rs->contextGeneration()) {
         if (m_glProgram) {
             // Delete only the program, separate shaders are cached and eventually deleted by RenderState.
             // TODO: This approach leaves shaders in memory even if they aren't used by any programs until
@@ -39,6 +40,15 @@ GLint ShaderProgram::getUniformLocation(const UniformLocation& _uniform) {
 
 bool ShaderProgram::use(RenderState& rs) {
 
+    // Programs of a lost GL context are built again
+    if (m_glProgram != 0 && m_contextGeneration != rs.contextGeneration()) {
+        m_glProgram = 0;
+        m_glFragmentShader = 0;
+        m_glVertexShader = 0;
+        m_uniformCache.clear();
+        m_needsBuild = true;
+    }
+
     if (m_needsBuild) {
         m_needsBuild = false;
         build(rs);
@@ -57,6 +67,19 @@ bool ShaderProgram::build(RenderState& rs) {
     auto& vertSrc = m_vertexShaderSource;
     auto& fragSrc = m_fragmentShaderSource;
 
+    // Restore the program from its binary when one was stored in an earlier session
+    uint64_t binaryKey = 0;
+    if (rs.programCache.enabled()) {
+        binaryKey = rs.programCache.key(vertSrc, fragSrc, *m_vertexLayout);
+        if (GLuint program = rs.programCache.load(binaryKey)) {
+            m_glProgram = program;
+            m_rs = &rs;
+            m_contextGeneration = rs.contextGeneration();
+            bindUniformBlocks();
+            return true;
+        }
+    }
+
     // Compile vertex and fragment shaders
     GLuint vertexShader = makeCompiledShader(rs, vertSrc, GL_VERTEX_SHADER);
     if (vertexShader == 0) {
@@ -84,14 +107,29 @@ bool ShaderProgram::build(RenderState& rs) {
         return false;
     }
 
+    if (binaryKey) { rs.programCache.store(binaryKey, program); }
+
     m_glProgram = program;
     m_glFragmentShader = fragmentShader;
     m_glVertexShader = vertexShader;
     m_rs = &rs;
+    m_contextGeneration = rs.contextGeneration();
+
+    bindUniformBlocks();
 
     return true;
 }
 
+void ShaderProgram::bindUniformBlocks() {
+    if (!Hardware::supportsUniformBuffers) { return; }
+
+    // Not found when the program does not use any of the frame uniforms
+    GLuint frameBlock = GL::getUniformBlockIndex(m_glProgram, FrameUniformBuffer::BLOCK_NAME);
+    if (frameBlock != GL_INVALID_INDEX) {
+        GL::uniformBlockBinding(m_glProgram, frameBlock, FrameUniformBuffer::BINDING);
+    }
+}
+
 GLuint ShaderProgram::makeLinkedShaderProgram(GLuint program, GLuint _fragShader, GLuint _vertShader) {
 
     GL::attachShader(program, _fragShader);
@@ -87,6 +87,9 @@ private:
     // successful it returns true.
     bool build(RenderState& rs);
 
+    // Assign the uniform blocks of the program to their binding points, see FrameUniformBuffer
+    void bindUniformBlocks();
+
     // Get a uniform value from the cache, and returns false when it's a cache miss
     template <class T>
     inline bool getFromCache(GLint _location, T _value) {
@@ -117,6 +120,8 @@ private:
     bool m_needsBuild = true;
 
     RenderState* m_rs = nullptr;
+    // RenderState::contextGeneration() of m_glProgram
+    uint32_t m_contextGeneration = 0;
 
 };
 
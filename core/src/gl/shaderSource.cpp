@@ -23,6 +23,23 @@ static const char* gl3FragHeader = R"RAW_GLSL(
 layout (location = 0) out highp vec4 TANGRAM_FragColor;
 )RAW_GLSL";
 
+// Uniforms set once per frame, see FrameUniforms; members are highp since the
+// fragment shaders have no default float precision at this point
+static const char* frameUniformBlock = R"RAW_GLSL(
+#define TANGRAM_FRAME_UNIFORM_BLOCK
+layout (std140) uniform TangramFrame {
+    highp mat4 u_view;
+    highp mat4 u_proj;
+    highp mat3 u_normal_matrix;
+    highp mat3 u_inverse_normal_matrix;
+    highp vec3 u_map_position;
+    highp float u_time;
+    highp vec2 u_resolution;
+    highp float u_meters_per_pixel;
+    highp float u_device_pixel_ratio;
+};
+)RAW_GLSL";
+
 void ShaderSource::setSourceStrings(const std::string& _fragSrc, const std::string& _vertSrc){
     m_fragmentShaderSource = std::string(_fragSrc);
     m_vertexShaderSource = std::string(_vertSrc);
@@ -63,6 +80,12 @@ std::string ShaderSource::applySourceBlocks(const std::string& _source, bool _fr
     if (Hardware::glVersion >= 300) {
         out.append("#version 300 es\n");
         out.append(_fragShader ? gl3FragHeader : gl3VertHeader);
+        if (Hardware::supportsUniformBuffers) {
+            out.append(frameUniformBlock);
+        }
+    }
+    if (Hardware::supportsTextureArrays) {
+        out.append("#define TANGRAM_TEXTURE_ARRAYS\n");
     }
 
     out.append("#define TANGRAM_EPSILON 0.00001\n");
@@ -157,6 +180,21 @@ void ShaderSource::addExtensionDeclaration(const std::string& _extension) {
     addSourceBlock("extensions", oss.str());
 }
 
+static const char* depthFragSource = R"RAW_GLSL(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+void main(void) {
+    gl_FragColor = vec4(0.0);
+}
+)RAW_GLSL";
+
+std::string ShaderSource::buildDepthFragmentSource() const {
+    if (Hardware::glVersion < 300) return depthFragSource;
+    return (std::string("#version 300 es\n") + gl3FragHeader) + depthFragSource;
+}
+
 std::string ShaderSource::buildSelectionFragmentSource() const {
     if (Hardware::glVersion < 300) return selection_fs;
     return (std::string("#version 300 es\n") + gl3FragHeader) + selection_fs;
@@ -39,6 +39,9 @@ public:
     // Build selection fragment shader source
     std::string buildSelectionFragmentSource() const;
 
+    // Build fragment shader source writing no color, for drawing only the depth of meshes
+    std::string buildDepthFragmentSource() const;
+
 private:
 
     std::string applySourceBlocks(const std::string& _source, bool _fragShader,
@@ -6,14 +6,38 @@
 #include "log.h"
 #include "map.h"
 #include "platform.h"
+#include "util/asyncWorker.h"
 #include "util/geom.h"
 #include "util/imageLoader.h"
+#include "util/textureCompression.h"
 
+// Defines sdfBuildDistanceField() for FontContext as well
+#define SDF_IMPLEMENTATION
+#include "sdf/sdf.h"
+
+#include <atomic>
 #include <cassert>
 #include <cstring> // for memset
 
 namespace Tangram {
 
+std::unique_ptr<AsyncWorker> Texture::uploadWorker;
+
+struct Texture::AsyncUpload {
+    enum State { pending, done, canceled };
+    std::atomic<int> state{pending};
+    // Set by the upload worker before the state becomes done
+    GLuint handle = 0;
+};
+
+// Rows of pixel data are tightly packed, while GL expects them padded to 4 bytes by default,
+// e.g. for HALF_FLOAT elevation of 257 pixels width. Returns whether the alignment must be restored.
+static bool unpackRowsTightly(const TextureOptions& _options, int _width) {
+    if ((_width * _options.bytesPerPixel()) % 4 == 0) { return false; }
+    GL::pixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    return true;
+}
+
 Texture::Texture(TextureOptions _options, bool _disposeBuffer)
     : m_options(_options), m_disposeBuffer(_disposeBuffer) {}
 
@@ -23,8 +47,17 @@ Texture::Texture(const uint8_t* data, size_t length, TextureOptions options, boo
 }
 
 Texture::~Texture() {
-    if (m_rs) {
+    if (m_asyncUpload) {
+        // The upload worker deletes the texture if the upload is not done yet
+        int expected = AsyncUpload::pending;
+        if (!m_asyncUpload->state.compare_exchange_strong(expected, AsyncUpload::canceled)) {
+            m_glHandle = m_asyncUpload->handle;
+        }
+    }
+    // Handles of a lost context may name objects of the current one
+    if (m_rs && m_contextGeneration == m_rs->contextGeneration()) {
         m_rs->queueTextureDeletion(m_glHandle);
+        m_rs->textureArrayPool.release(m_layer);
     }
 }
 
@@ -34,6 +67,21 @@ bool Texture::loadImageFromMemory(const uint8_t* data, size_t length) {
     GLint internalfmt = 0;
     LOGTInit();
 
+    if (isKTX(data, length)) {
+        CompressedImage image;
+        if (!loadKTX(data, length, image)) { return false; }
+        if (!isCompressedFormatSupported(image.format)) {
+            LOGW("Compressed texture format 0x%x is not supported", image.format);
+            return false;
+        }
+        auto* buffer = reinterpret_cast<GLubyte*>(std::malloc(image.size));
+        if (!buffer) { return false; }
+        std::memcpy(buffer, image.data, image.size);
+        setCompressedData(buffer, image.size, image.format, image.width, image.height);
+        return true;
+    }
+
+    m_retained.clear();
     m_buffer.reset(loadImage(data, length, &width, &height, &internalfmt, int(bpp())));
 
     if (!m_buffer) {
@@ -48,8 +96,11 @@ bool Texture::loadImageFromMemory(const uint8_t* data, size_t length) {
 
     m_options.pixelFormat = static_cast<PixelFormat>(internalfmt);
     m_bufferSize = width * height * bpp();
+    m_compressedFormat = 0;
     resize(width, height);
 
+    if (isSdf() && !buildDistanceField()) { return false; }
+
     LOGT("Decoded image data: %dx%d bpp:%d", width, height, bpp());
     return true;
 }
@@ -61,12 +112,13 @@ bool Texture::setPixelData(int _width, int _height, int _bytesPerPixel,
         return false;
     }
 
+    m_retained.clear();
     if (m_bufferSize != _length) {
         m_buffer.reset();
     }
 
     if (!m_buffer) {
-        m_buffer.reset(reinterpret_cast<GLubyte*>(std::malloc(_length)));
+        m_buffer.reset(PixelBufferPool::allocate(_length));
     }
 
     if (!m_buffer) {
@@ -77,12 +129,92 @@ bool Texture::setPixelData(int _width, int _height, int _bytesPerPixel,
     std::memcpy(m_buffer.get(), _data, _length);
 
     m_bufferSize = _length;
+    m_compressedFormat = 0;
 
     resize(_width, _height);
 
+    if (isSdf()) { return buildDistanceField(); }
+
+    return true;
+}
+
+bool Texture::buildDistanceField() {
+    size_t bytesPerPixel = bpp();
+    if (bytesPerPixel == 1) { return true; }
+    if (!m_buffer || m_compressedFormat != 0 || m_options.glType() != GL_UNSIGNED_BYTE) { return false; }
+
+    size_t count = size_t(m_width) * m_height;
+    const GLubyte* pixels = m_buffer.get();
+
+    bool transparent = false;
+    if (bytesPerPixel == 4) {
+        for (size_t i = 0; i < count && !transparent; i++) { transparent = pixels[i * 4 + 3] != 255; }
+    }
+
+    GLubyte* field = PixelBufferPool::allocate(count);
+    if (!field) {
+        LOGE("Could not allocate texture: Out of memory!");
+        return false;
+    }
+
+    if (transparent) {
+        std::vector<GLubyte> coverage(count);
+        for (size_t i = 0; i < count; i++) { coverage[i] = pixels[i * 4 + 3]; }
+        if (!sdfBuildDistanceField(field, m_width, m_options.sdfRadius, coverage.data(),
+                                   m_width, m_height, m_width)) {
+            PixelBufferPool::release(field);
+            return false;
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) { field[i] = pixels[i * bytesPerPixel]; }
+    }
+
+    setBufferData(field, count);
+    m_bufferSize = count;
+    m_options.pixelFormat = PixelFormat::ALPHA;
     return true;
 }
 
+bool Texture::compress() {
+    if (!m_buffer || m_compressedFormat != 0 || m_options.glType() != GL_UNSIGNED_BYTE) { return false; }
+
+    GLenum format = etc1Format();
+    int bytesPerPixel = int(bpp());
+    if (format == 0 || (bytesPerPixel != 3 && bytesPerPixel != 4)) { return false; }
+
+    // ETC1 has no alpha channel
+    if (bytesPerPixel == 4) {
+        const GLubyte* pixels = m_buffer.get();
+        for (size_t i = 3; i < m_bufferSize; i += 4) {
+            if (pixels[i] != 255) { return false; }
+        }
+    }
+
+    auto* data = encodeETC1(m_buffer.get(), m_width, m_height, bytesPerPixel);
+    if (!data) { return false; }
+
+    setCompressedData(data, compressedImageSize(format, m_width, m_height), format, m_width, m_height);
+    return true;
+}
+
+void Texture::setCompressedData(GLubyte* _data, size_t _size, GLenum _format, int _width, int _height) {
+    m_retained.clear();
+    m_buffer.reset(_data);
+    m_bufferSize = _size;
+    m_compressedFormat = _format;
+
+    // Only the base level is uploaded
+    m_options.generateMipmaps = false;
+    if (m_options.minFilter == TextureMinFilter::NEAREST_MIPMAP_NEAREST ||
+        m_options.minFilter == TextureMinFilter::NEAREST_MIPMAP_LINEAR) {
+        m_options.minFilter = TextureMinFilter::NEAREST;
+    } else if (m_options.minFilter != TextureMinFilter::NEAREST) {
+        m_options.minFilter = TextureMinFilter::LINEAR;
+    }
+
+    resize(_width, _height);
+}
+
 void Texture::setSpriteAtlas(std::unique_ptr<Tangram::SpriteAtlas> sprites) {
     m_spriteAtlas = std::move(sprites);
 }
@@ -103,6 +235,7 @@ void Texture::generate(RenderState& _rs, GLuint _textureUnit) {
                       static_cast<GLint>(m_options.wrapT));
 
     m_rs = &_rs;
+    m_contextGeneration = _rs.contextGeneration();
 }
 
 bool Texture::upload(RenderState& _rs, GLuint _textureUnit) {
@@ -114,16 +247,26 @@ bool Texture::upload(RenderState& _rs, GLuint _textureUnit) {
         if (m_disposeBuffer) { m_buffer.reset(); }
         return false;
     }
+
+    if (usesTextureArray()) { return uploadLayer(_rs, _textureUnit); }
     if (m_glHandle == 0) {
         generate(_rs, _textureUnit);
     } else {
         _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
     }
 
+    if (m_compressedFormat != 0) {
+        GL::compressedTexImage2D(GL_TEXTURE_2D, 0, m_compressedFormat, m_width, m_height, 0,
+                                 m_bufferSize, m_buffer.get());
+        return true;
+    }
+
     auto internalfmt = static_cast<GLint>(m_options.pixelFormat);
+    bool unpacked = unpackRowsTightly(m_options, m_width);
     // desktop GL doesn't support GL_ALPHA, GLES doesn't support GL_RED, so have to use GL_R8
     GL::texImage2D(GL_TEXTURE_2D, 0, internalfmt, m_width, m_height, 0, m_options.glFormat(),
                    m_options.glType(), m_buffer.get());
+    if (unpacked) { GL::pixelStorei(GL_UNPACK_ALIGNMENT, 4); }
 
     if (m_buffer && m_options.generateMipmaps) {
         GL::generateMipmap(GL_TEXTURE_2D);
@@ -131,9 +274,141 @@ bool Texture::upload(RenderState& _rs, GLuint _textureUnit) {
     return true;
 }
 
+bool Texture::uploadLayer(RenderState& _rs, GLuint _textureUnit) {
+    if (!m_buffer) { return false; }
+
+    // New data may be of another size or format, i.e. for another page
+    _rs.textureArrayPool.release(m_layer);
+
+    m_layer = _rs.textureArrayPool.allocate(_rs, _textureUnit, m_options, m_compressedFormat,
+                                            m_width, m_height, m_bufferSize);
+    m_rs = &_rs;
+    m_contextGeneration = _rs.contextGeneration();
+
+    if (!m_layer) { return false; }
+
+    if (m_compressedFormat != 0) {
+        GL::compressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_layer.layer, m_width, m_height, 1,
+                                    m_compressedFormat, m_bufferSize, m_buffer.get());
+        return true;
+    }
+
+    bool unpacked = unpackRowsTightly(m_options, m_width);
+    GL::texSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, m_layer.layer, m_width, m_height, 1,
+                      m_options.glFormat(), m_options.glType(), m_buffer.get());
+    if (unpacked) { GL::pixelStorei(GL_UNPACK_ALIGNMENT, 4); }
+
+    // Mipmaps of all layers are generated again
+    if (m_options.generateMipmaps) {
+        GL::generateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    return true;
+}
+
+bool Texture::usesTextureArray() const {
+    return m_options.arrayLayer && Hardware::supportsTextureArrays;
+}
+
+bool Texture::uploadAsync(RenderState& _rs) {
+
+    // Layers of shared texture arrays are uploaded on bind()
+    if (!uploadWorker || !m_shouldResize || m_glHandle != 0 || !m_disposeBuffer || !m_buffer ||
+        usesTextureArray() || Hardware::maxTextureSize < m_width || Hardware::maxTextureSize < m_height) {
+        return false;
+    }
+
+    m_shouldResize = false;
+    m_asyncUpload = std::make_shared<AsyncUpload>();
+    m_rs = &_rs;
+    m_contextGeneration = _rs.contextGeneration();
+    retainData();
+
+    // The worker owns the pixel data until it is uploaded
+    auto buffer = std::shared_ptr<GLubyte>(m_buffer.release(), malloc_deleter());
+
+    uploadWorker->enqueue([upload = m_asyncUpload, buffer, size = m_bufferSize, options = m_options,
+                           compressedFormat = m_compressedFormat, width = m_width, height = m_height]() {
+        // Restore the binding for the RenderState of other work on this context
+        GLint boundTexture = 0;
+        GL::getIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
+
+        GLuint handle = 0;
+        GL::genTextures(1, &handle);
+        GL::bindTexture(GL_TEXTURE_2D, handle);
+        GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(options.minFilter));
+        GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(options.magFilter));
+        GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(options.wrapS));
+        GL::texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(options.wrapT));
+        if (compressedFormat != 0) {
+            GL::compressedTexImage2D(GL_TEXTURE_2D, 0, compressedFormat, width, height, 0, size,
+                                     buffer.get());
+        } else {
+            bool unpacked = unpackRowsTightly(options, width);
+            GL::texImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(options.pixelFormat), width, height, 0,
+                           options.glFormat(), options.glType(), buffer.get());
+            if (unpacked) { GL::pixelStorei(GL_UNPACK_ALIGNMENT, 4); }
+        }
+        if (options.generateMipmaps) {
+            GL::generateMipmap(GL_TEXTURE_2D);
+        }
+        GL::bindTexture(GL_TEXTURE_2D, boundTexture);
+
+        // The texture must be complete before the render context uses it
+        GL::finish();
+
+        upload->handle = handle;
+        int expected = AsyncUpload::pending;
+        if (!upload->state.compare_exchange_strong(expected, AsyncUpload::done)) {
+            GL::deleteTextures(1, &handle);
+        }
+    });
+    return true;
+}
+
+bool Texture::isUploading() {
+    if (!m_asyncUpload) { return false; }
+
+    if (m_asyncUpload->state != AsyncUpload::done) { return true; }
+
+    m_glHandle = m_asyncUpload->handle;
+    m_asyncUpload.reset();
+    return false;
+}
+
+void Texture::retainData() {
+    if (m_retained || !m_buffer || !RetainedData::enabled()) { return; }
+    m_retained.store(m_buffer.get(), m_bufferSize);
+}
+
+bool Texture::restorable() const {
+    return m_buffer || m_retained || (m_glHandle == 0 && !m_layer);
+}
+
+void Texture::restoreLostContext(RenderState& _rs) {
+    if ((m_glHandle == 0 && !m_layer) || m_contextGeneration == _rs.contextGeneration()) { return; }
+
+    m_glHandle = 0;
+    m_layer = {};
+    m_rs = nullptr;
+
+    if (!m_buffer && m_retained) {
+        m_buffer.reset(PixelBufferPool::allocate(m_retained.size()));
+        if (m_buffer && !m_retained.restore(m_buffer.get())) { m_buffer.reset(); }
+    }
+    m_shouldResize = bool(m_buffer);
+}
+
 bool Texture::bind(RenderState& _rs, GLuint _textureUnit) {
 
+    if (isUploading()) { return false; }
+
+    restoreLostContext(_rs);
+
     if (!m_shouldResize) {
+        if (m_layer) {
+            _rs.texture(m_layer.texture, _textureUnit, GL_TEXTURE_2D_ARRAY);
+            return true;
+        }
         if (m_glHandle == 0) { return false; }
 
         _rs.texture(m_glHandle, _textureUnit, GL_TEXTURE_2D);
@@ -142,7 +417,10 @@ bool Texture::bind(RenderState& _rs, GLuint _textureUnit) {
 
     bool ok = upload(_rs, _textureUnit);
 
-    if (m_disposeBuffer) { m_buffer.reset(); }
+    if (m_disposeBuffer) {
+        retainData();
+        m_buffer.reset();
+    }
 
     return ok;
 }
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "gl.h"
+#include "gl/retainedData.h"
+#include "gl/textureArrayPool.h"
 #include "scene/spriteAtlas.h"
+#include "util/pixelBufferPool.h"
 
 #include <cstdlib>
 #include <vector>
@@ -10,6 +13,7 @@
 
 namespace Tangram {
 
+class AsyncWorker;
 class RenderState;
 
 enum class TextureMinFilter : GLenum {
@@ -36,6 +40,8 @@ enum class PixelFormat : GLint {
     RGB = GL_RGB8,
     RGBA = GL_RGBA8,
     FLOAT = GL_R32F,
+    // Half the size of FLOAT, e.g. for elevation; filterable on GLES 3 without extensions
+    HALF_FLOAT = GL_R16F,
     R32UI = GL_R32UI
 };
 
@@ -47,9 +53,15 @@ struct TextureOptions {
     PixelFormat pixelFormat = PixelFormat::RGBA;
     float displayScale = 1.f; // 0.5 for a "@2x" image.
     bool generateMipmaps = false;
+    // Store in a layer of a shared texture array when supported, see TextureArrayPool
+    bool arrayLayer = false;
+    // Radius in pixels of the signed distance field that decoded images are turned into, e.g.
+    // for tintable icons; 0 to keep the image, see Texture::isSdf()
+    float sdfRadius = 0.f;
 
     GLenum glFormat() const {
-        if (pixelFormat == PixelFormat::ALPHA || pixelFormat == PixelFormat::FLOAT) return GL_RED;
+        if (pixelFormat == PixelFormat::ALPHA || pixelFormat == PixelFormat::FLOAT ||
+            pixelFormat == PixelFormat::HALF_FLOAT) return GL_RED;
         if (pixelFormat == PixelFormat::RGB) return GL_RGB;
         if (pixelFormat == PixelFormat::R32UI) return GL_RED_INTEGER;
         return GL_RGBA;
@@ -58,11 +70,13 @@ struct TextureOptions {
     int bytesPerPixel() const {
         if (pixelFormat == PixelFormat::ALPHA) return 1;
         if (pixelFormat == PixelFormat::RGB) return 3;
+        if (pixelFormat == PixelFormat::HALF_FLOAT) return 2;
         return 4;  // FLOAT, RGBA, R32UI
     }
 
     GLenum glType() const {
         if (pixelFormat == PixelFormat::FLOAT) return GL_FLOAT;
+        if (pixelFormat == PixelFormat::HALF_FLOAT) return GL_HALF_FLOAT;
         if (pixelFormat == PixelFormat::R32UI) return GL_UNSIGNED_INT;
         return GL_UNSIGNED_BYTE;
     }
@@ -78,8 +92,23 @@ public:
 
     virtual ~Texture();
 
+    // Decodes an image or reads a KTX file with a compressed format supported by the driver
     bool loadImageFromMemory(const uint8_t* data, size_t length);
 
+    // Encode opaque pixel data to ETC1 if the driver supports it; returns false if the data
+    // is not changed
+    bool compress();
+
+    // GL format of compressed texture data, 0 if the data is not compressed
+    GLenum compressedFormat() const { return m_compressedFormat; }
+
+    // Layer in the GL_TEXTURE_2D_ARRAY which bind() binds instead of a GL_TEXTURE_2D,
+    // -1 if the texture is not stored in a texture array
+    GLint arrayLayer() const { return m_layer.layer; }
+
+    // Texture object which bind() binds, the texture array of a layer or the own texture
+    GLuint glHandle() const { return m_layer ? m_layer.texture : m_glHandle; }
+
     // Sets texture pixel data
     bool setPixelData(int _width, int _height, int _bytesPerPixel, const GLubyte* _data, size_t _length);
 
@@ -88,6 +117,32 @@ public:
     // supported by the driver.
     virtual bool bind(RenderState& rs, GLuint _unit);
 
+    // Whether the pixel data is released after upload; textures with data needed on the CPU keep it
+    void setDisposeBuffer(bool _dispose) { m_disposeBuffer = _dispose; }
+
+    // Whether new texture data is uploaded on the next bind()
+    bool needsUpload() const { return m_shouldResize; }
+
+    // Keep a deflated copy of the pixel data, when enabled, to upload it again after the GL
+    // context is lost although the buffer is disposed; done on the next bind() otherwise,
+    // call it ahead on the thread decoding the texture to spare the render thread
+    void retainData();
+
+    // Whether the texture can be bound again after the GL context is lost: it keeps its
+    // pixel data or a retained copy, or is not uploaded yet
+    bool restorable() const;
+
+    // Start uploading the texture data on uploadWorker instead of on the next bind(); returns
+    // false if there is no upload worker or the texture is not uploaded for the first time
+    bool uploadAsync(RenderState& rs);
+
+    // Whether an upload started by uploadAsync() is still running; bind() fails until it is done
+    bool isUploading();
+
+    // Worker thread with a GL context sharing objects with the render context, set by platforms
+    // which support shared contexts
+    static std::unique_ptr<AsyncWorker> uploadWorker;
+
     // Width and Height texture getters
     int width() const { return m_width; }
     int height() const { return m_height; }
@@ -96,9 +151,15 @@ public:
     // Size of texture data in bytes
     size_t bufferSize() const { return m_bufferSize; }
     GLubyte* bufferData() const { return m_buffer.get(); }
+    // Size of the texture data kept on the CPU, e.g. before upload or when not disposed
+    size_t cpuBufferSize() const { return m_buffer ? m_bufferSize : 0; }
 
     float displayScale() const { return m_options.displayScale; }
 
+    // Whether the texture is a one channel signed distance field of TextureOptions::sdfRadius,
+    // 0.5 on the edges of shapes and 1 / (2 * sdfRadius) more per pixel inside
+    bool isSdf() const { return m_options.sdfRadius > 0.f; }
+
     const auto& spriteAtlas() const { return m_spriteAtlas; }
     void setSpriteAtlas(std::unique_ptr<SpriteAtlas> sprites);
 
@@ -117,23 +178,44 @@ protected:
 
     bool upload(RenderState& rs, GLuint _textureUnit);
 
+    bool uploadLayer(RenderState& rs, GLuint _textureUnit);
+
+    bool usesTextureArray() const;
+
     bool sanityCheck(size_t _width, size_t _height, size_t _bytesPerPixel, size_t _length) const;
 
+    // Forget the texture objects of a lost GL context and take the pixel data for upload again
+    void restoreLostContext(RenderState& rs);
+
+    // Replace the pixel data with the distance field of the alpha channel, see isSdf(); images
+    // without alpha channel or transparent pixels are taken as distance fields in their red channel
+    bool buildDistanceField();
+
+    // Take compressed data of @_format, which has no mipmaps
+    void setCompressedData(GLubyte* _data, size_t _size, GLenum _format, int _width, int _height);
+
     void setBufferData(GLubyte* buffer, size_t size) {
         if (m_buffer.get() == buffer) { return; }
+        m_retained.clear();
         m_buffer.reset(buffer);
     }
 
     TextureOptions m_options;
 
-    struct malloc_deleter { void operator()(GLubyte* x) { std::free(x); } };
+    // Pixel data is malloc'ed; pooled buffers are kept for reuse, see PixelBufferPool
+    struct malloc_deleter { void operator()(GLubyte* x) { PixelBufferPool::release(x); } };
     using TextureData = std::unique_ptr<GLubyte, malloc_deleter>;
     TextureData m_buffer = nullptr;
 
     size_t m_bufferSize = 0;
 
+    GLenum m_compressedFormat = 0;
+
     GLuint m_glHandle = 0;
 
+    // Set instead of m_glHandle for textures in a texture array
+    TextureArrayPool::Layer m_layer;
+
     bool m_shouldResize = false;
     // Dipose buffer after texture upload
     bool m_disposeBuffer = true;
@@ -142,11 +224,20 @@ protected:
     int m_height = 0;
 
     RenderState* m_rs = nullptr;
+    // RenderState::contextGeneration() of the texture objects
+    uint32_t m_contextGeneration = 0;
+
+    RetainedData m_retained;
 
 private:
 
+    struct AsyncUpload;
+
     std::unique_ptr<SpriteAtlas> m_spriteAtlas;
 
+    // Set while uploading on uploadWorker
+    std::shared_ptr<AsyncUpload> m_asyncUpload;
+
 };
 
 } // namespace Tangram
@@ -0,0 +1,169 @@
+#include "gl/textureArrayPool.h"
+
+#include "gl/renderState.h"
+#include "gl/texture.h"
+#include "util/textureCompression.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace Tangram {
+
+bool TextureArrayPool::Key::operator==(const Key& _other) const {
+    return width == _other.width && height == _other.height && format == _other.format &&
+        minFilter == _other.minFilter && magFilter == _other.magFilter &&
+        wrapS == _other.wrapS && wrapT == _other.wrapT && mipmaps == _other.mipmaps;
+}
+
+TextureArrayPool::~TextureArrayPool() {
+    for (auto& entry : m_pages) {
+        GL::deleteTextures(1, &entry.second.texture);
+    }
+}
+
+TextureArrayPool::Layer TextureArrayPool::allocate(RenderState& rs, GLuint _unit,
+                                                   const TextureOptions& _options,
+                                                   GLenum _compressedFormat, int _width,
+                                                   int _height, size_t _layerSize) {
+    Layer layer;
+
+    if (_width <= 0 || _height <= 0) { return layer; }
+
+    // Layers released since the last frame can be reused right away
+    collect(rs);
+
+    Key key;
+    key.width = _width;
+    key.height = _height;
+    key.format = _compressedFormat ? _compressedFormat : GLenum(_options.pixelFormat);
+    key.minFilter = GLenum(_options.minFilter);
+    key.magFilter = GLenum(_options.magFilter);
+    key.wrapS = GLenum(_options.wrapS);
+    key.wrapT = GLenum(_options.wrapT);
+    key.mipmaps = _options.generateMipmaps && !_compressedFormat;
+
+    // Fill the fullest page first, so that others can become empty
+    uint32_t pageId = 0;
+    size_t minFree = PAGE_LAYERS + 1;
+    for (auto& entry : m_pages) {
+        auto& page = entry.second;
+        if (page.key == key && !page.free.empty() && page.free.size() < minFree) {
+            pageId = entry.first;
+            minFree = page.free.size();
+        }
+    }
+
+    if (pageId == 0) {
+        Page page;
+        page.key = key;
+        page.layerSize = _layerSize;
+        GL::genTextures(1, &page.texture);
+        rs.texture(page.texture, _unit, GL_TEXTURE_2D_ARRAY);
+
+        GL::texParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GLint(key.minFilter));
+        GL::texParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GLint(key.magFilter));
+        GL::texParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GLint(key.wrapS));
+        GL::texParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GLint(key.wrapT));
+
+        if (_compressedFormat) {
+            // Compressed storage is specified with data, which is uploaded per layer later
+            size_t size = compressedImageSize(_compressedFormat, _width, _height) * PAGE_LAYERS;
+            void* zeros = std::calloc(size, 1);
+            GL::compressedTexImage3D(GL_TEXTURE_2D_ARRAY, 0, _compressedFormat, _width, _height,
+                                     PAGE_LAYERS, 0, GLsizei(size), zeros);
+            std::free(zeros);
+        } else {
+            int width = _width, height = _height;
+            for (GLint level = 0; ; level++) {
+                GL::texImage3D(GL_TEXTURE_2D_ARRAY, level, GLint(_options.pixelFormat), width, height,
+                               PAGE_LAYERS, 0, _options.glFormat(), _options.glType(), nullptr);
+                if (!key.mipmaps || (width == 1 && height == 1)) { break; }
+                width = std::max(width / 2, 1);
+                height = std::max(height / 2, 1);
+            }
+        }
+
+        // Layers are taken from the back
+        for (GLint i = PAGE_LAYERS - 1; i >= 0; i--) { page.free.push_back(i); }
+
+        pageId = m_nextPage++;
+        m_pages.emplace(pageId, std::move(page));
+        m_stats.pages++;
+    }
+
+    auto& page = m_pages[pageId];
+
+    rs.texture(page.texture, _unit, GL_TEXTURE_2D_ARRAY);
+
+    layer.texture = page.texture;
+    layer.page = pageId;
+    layer.generation = m_generation;
+    layer.layer = page.free.back();
+    page.free.pop_back();
+
+    m_stats.layers++;
+    m_stats.bytesUsed += page.layerSize;
+
+    return layer;
+}
+
+void TextureArrayPool::release(const Layer& _layer) {
+    if (!_layer) { return; }
+
+    std::lock_guard<std::mutex> lock(m_releaseMutex);
+    m_released.push_back(_layer);
+}
+
+void TextureArrayPool::collect(RenderState& rs) {
+
+    std::vector<Layer> released;
+    {
+        std::lock_guard<std::mutex> lock(m_releaseMutex);
+        if (m_released.empty()) { return; }
+        released.swap(m_released);
+    }
+
+    for (const auto& layer : released) {
+        if (layer.generation != m_generation) { continue; }
+
+        auto it = m_pages.find(layer.page);
+        if (it == m_pages.end()) { continue; }
+
+        it->second.free.push_back(layer.layer);
+
+        m_stats.layers--;
+        m_stats.bytesUsed -= it->second.layerSize;
+    }
+
+    // Delete empty pages except the first one of each kind
+    std::vector<const Key*> spares;
+    for (auto it = m_pages.begin(); it != m_pages.end();) {
+        auto& page = it->second;
+        if (page.free.size() == size_t(PAGE_LAYERS)) {
+            bool spare = std::any_of(spares.begin(), spares.end(),
+                                     [&](const Key* key) { return *key == page.key; });
+            if (spare) {
+                // Unset first so that RenderState does not skip binding a reused handle
+                rs.textureUnset(page.texture);
+                GL::deleteTextures(1, &page.texture);
+                it = m_pages.erase(it);
+                m_stats.pages--;
+                continue;
+            }
+            spares.push_back(&page.key);
+        }
+        ++it;
+    }
+}
+
+void TextureArrayPool::invalidate() {
+    {
+        std::lock_guard<std::mutex> lock(m_releaseMutex);
+        m_released.clear();
+    }
+    m_pages.clear();
+    m_generation++;
+    m_stats = Stats();
+}
+
+}
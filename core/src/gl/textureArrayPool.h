@@ -0,0 +1,104 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+struct TextureOptions;
+
+/*
+ * TextureArrayPool - GL 3 texture arrays shared by textures of the same kind
+ *
+ * Textures with TextureOptions::arrayLayer take a layer of a page, i.e. a GL_TEXTURE_2D_ARRAY
+ * of PAGE_LAYERS layers, instead of creating a texture object each. Pages are created per
+ * size, format and sampling options; raster tiles of a source all match and bind the same
+ * texture object, which RenderState does not bind again for subsequent tiles.
+ *
+ * allocate() and collect() must be called on the GL thread; release() can be called from
+ * any thread, released layers become available on the next collect().
+ */
+class TextureArrayPool {
+
+public:
+
+    static constexpr GLsizei PAGE_LAYERS = 16;
+
+    struct Layer {
+        GLuint texture = 0;
+        uint32_t page = 0;
+        uint32_t generation = 0;
+        GLint layer = -1;
+
+        explicit operator bool() const { return layer >= 0; }
+    };
+
+    struct Stats {
+        size_t pages = 0;
+        size_t layers = 0;
+        size_t bytesUsed = 0;
+    };
+
+    TextureArrayPool() = default;
+    ~TextureArrayPool();
+
+    TextureArrayPool(const TextureArrayPool&) = delete;
+    TextureArrayPool& operator=(const TextureArrayPool&) = delete;
+
+    /* Take a layer of a page for textures of @_width x @_height with @_options and bind the page
+     * on texture unit @_unit; @_compressedFormat is the format of compressed data or 0.
+     * @_layerSize is the size of one layer in bytes. */
+    Layer allocate(RenderState& rs, GLuint _unit, const TextureOptions& _options,
+                   GLenum _compressedFormat, int _width, int _height, size_t _layerSize);
+
+    /* Return @_layer to the pool */
+    void release(const Layer& _layer);
+
+    /* Free the released layers and delete pages that became empty, keeping one spare page
+     * per kind of texture */
+    void collect(RenderState& rs);
+
+    /* Forget all pages without deleting them, e.g. after GL context loss; layers taken before
+     * are ignored when released */
+    void invalidate();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+
+    struct Key {
+        int width;
+        int height;
+        GLenum format;
+        GLenum minFilter;
+        GLenum magFilter;
+        GLenum wrapS;
+        GLenum wrapT;
+        bool mipmaps;
+
+        bool operator==(const Key& _other) const;
+    };
+
+    struct Page {
+        Key key;
+        GLuint texture = 0;
+        size_t layerSize = 0;
+        std::vector<GLint> free;
+    };
+
+    std::unordered_map<uint32_t, Page> m_pages;
+    uint32_t m_nextPage = 1;
+    uint32_t m_generation = 0;
+
+    std::mutex m_releaseMutex;
+    std::vector<Layer> m_released;
+
+    Stats m_stats;
+};
+
+}
@@ -8,7 +8,8 @@
 namespace Tangram {
 
 void Vao::initialize(RenderState& rs, const VertexOffsets& _vertexOffsets,
-                     VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer) {
+                     VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer,
+                     GLintptr _vertexByteOffset) {
 
     m_glVAOs.resize(_vertexOffsets.size());
 
@@ -20,40 +21,54 @@ void Vao::initialize(RenderState& rs, const VertexOffsets& _vertexOffsets,
     for (size_t i = 0; i < _vertexOffsets.size(); ++i) {
         auto vertexIndexOffset = _vertexOffsets[i];
         int nVerts = vertexIndexOffset.second;
-        GL::bindVertexArray(m_glVAOs[i]);
+        rs.vertexArray(m_glVAOs[i]);
 
-        // ELEMENT_ARRAY_BUFFER must be bound after bindVertexArray to be used by VAO
+        // ELEMENT_ARRAY_BUFFER must be bound after bindVertexArray to be used by VAO; it is
+        // state of the VAO, so the binding of the default vertex array in RenderState is kept
         if (_indexBuffer != 0) {
-            rs.indexBufferUnset(_indexBuffer);
-            rs.indexBuffer(_indexBuffer);
+            GL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
         }
 
         // Enable vertex layout on the specified locations
-        _layout.enable(vertexOffset * _layout.getStride());
+        _layout.enable(_vertexByteOffset + vertexOffset * _layout.getStride());
 
         vertexOffset += nVerts;
     }
 
-    GL::bindVertexArray(0);
+    rs.vertexBuffer(0);
+}
+
+void Vao::initializeInstanced(RenderState& rs, VertexLayout& _instanceLayout, GLuint _instanceBuffer,
+                              GLintptr _instanceByteOffset, GLuint _templateBuffer,
+                              GLint _templateSize, GLuint _indexBuffer) {
+
+    m_glVAOs.resize(1);
+
+    GL::genVertexArrays(1, m_glVAOs.data());
+    rs.vertexArray(m_glVAOs[0]);
+
+    GL::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer);
+
+    rs.vertexBuffer(_templateBuffer);
+    GL::enableVertexAttribArray(0);
+    GL::vertexAttribPointer(0, _templateSize, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    rs.vertexBuffer(_instanceBuffer);
+    _instanceLayout.enableInstanced(_instanceByteOffset, 1);
 
     rs.vertexBuffer(0);
-    rs.indexBuffer(0);
 }
 
 bool Vao::isInitialized() {
     return !m_glVAOs.empty();
 }
 
-void Vao::bind(unsigned int _index) {
+void Vao::bind(RenderState& rs, unsigned int _index) {
     if (_index < m_glVAOs.size()) {
-        GL::bindVertexArray(m_glVAOs[_index]);
+        rs.vertexArray(m_glVAOs[_index]);
     }
 }
 
-void Vao::unbind() {
-    GL::bindVertexArray(0);
-}
-
 void Vao::dispose(RenderState& rs) {
     if (!m_glVAOs.empty()) {
         rs.queueVAODeletion(m_glVAOs.size(), m_glVAOs.data());
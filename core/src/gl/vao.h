@@ -17,12 +17,22 @@ class Vao {
 
 public:
 
+    // @_vertexByteOffset is the start of the vertices in @_vertexBuffer
     void initialize(RenderState& rs, const VertexOffsets& _vertexOffsets,
-                    VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer);
+                    VertexLayout& _layout, GLuint _vertexBuffer, GLuint _indexBuffer,
+                    GLintptr _vertexByteOffset = 0);
+    // One vertex array reading the instances of @_instanceLayout in @_instanceBuffer from
+    // @_instanceByteOffset at the locations from 1 on, and vertices of @_templateSize floats
+    // in @_templateBuffer at location 0; see InstancedLineMesh
+    void initializeInstanced(RenderState& rs, VertexLayout& _instanceLayout, GLuint _instanceBuffer,
+                             GLintptr _instanceByteOffset, GLuint _templateBuffer,
+                             GLint _templateSize, GLuint _indexBuffer);
     bool isInitialized();
-    void bind(unsigned int _index);
-    void unbind();
+    // Left bound for the next draw, see RenderState::vertexArray()
+    void bind(RenderState& rs, unsigned int _index);
     void dispose(RenderState& rs);
+    // Forget the VAOs of a lost GL context without deleting them
+    void reset() { m_glVAOs.clear(); }
 
 private:
     std::vector<GLuint> m_glVAOs;
@@ -4,6 +4,8 @@
 #include "gl/glError.h"
 #include "log.h"
 
+#include <algorithm>
+
 namespace Tangram {
 
 VertexLayout::VertexLayout(std::vector<VertexAttrib> _attribs) : m_attribs(_attribs) {
@@ -36,6 +38,28 @@ VertexLayout::VertexLayout(std::vector<VertexAttrib> _attribs) : m_attribs(_attr
         // TODO: Automatically add padding or warn if attributes are not byte-aligned
 
     }
+
+    for (size_t i = 0; i < m_attribs.size(); i++) { m_locations.push_back(GLuint(i)); }
+}
+
+std::shared_ptr<VertexLayout> VertexLayout::without(const std::shared_ptr<VertexLayout>& _layout,
+                                                    const std::vector<std::string>& _names) {
+
+    std::vector<VertexAttrib> attribs;
+    std::vector<GLuint> locations;
+
+    for (size_t i = 0; i < _layout->m_attribs.size(); i++) {
+        const auto& attrib = _layout->m_attribs[i];
+        if (std::find(_names.begin(), _names.end(), attrib.name) != _names.end()) { continue; }
+        attribs.push_back(attrib);
+        locations.push_back(_layout->m_locations[i]);
+    }
+
+    if (attribs.size() == _layout->m_attribs.size()) { return _layout; }
+
+    auto layout = std::make_shared<VertexLayout>(attribs);
+    layout->m_locations = locations;
+    return layout;
 }
 
 size_t VertexLayout::getOffset(std::string _attribName) {
@@ -50,23 +74,46 @@ size_t VertexLayout::getOffset(std::string _attribName) {
     return 0;
 }
 
+bool VertexLayout::hasAttrib(const std::string& _attribName) const {
+    return std::any_of(m_attribs.begin(), m_attribs.end(),
+                       [&](const auto& attrib) { return attrib.name == _attribName; });
+}
+
 void VertexLayout::enable(size_t _byteOffset) {
 
-    for (size_t location = 0; location < m_attribs.size(); ++location) {
-        auto& attrib = m_attribs[location];
+    for (size_t i = 0; i < m_attribs.size(); ++i) {
+        auto& attrib = m_attribs[i];
+        GLuint location = m_locations[i];
         void* offset = ((unsigned char*) attrib.offset) + _byteOffset;
         GL::enableVertexAttribArray(location);
         GL::vertexAttribPointer(location, attrib.size, attrib.type, attrib.normalized, m_stride, offset);
     }
 }
 
+void VertexLayout::enableInstanced(size_t _byteOffset, GLuint _firstLocation) {
+
+    for (size_t i = 0; i < m_attribs.size(); ++i) {
+        auto& attrib = m_attribs[i];
+        GLuint location = _firstLocation + i;
+        void* offset = ((unsigned char*) attrib.offset) + _byteOffset;
+        GL::enableVertexAttribArray(location);
+        GL::vertexAttribPointer(location, attrib.size, attrib.type, attrib.normalized, m_stride, offset);
+        GL::vertexAttribDivisor(location, 1);
+    }
+}
+
 void VertexLayout::enable(RenderState& rs, ShaderProgram& _program, size_t _byteOffset, void* _ptr) {
 
     GLuint glProgram = _program.getGlProgram();
 
+    // Locations of the attributes of this layout
+    uint32_t enabled = 0;
+
     // Enable all attributes for this layout
-    for (size_t location = 0; location < m_attribs.size(); ++location) {
-        auto& attrib = m_attribs[location];
+    for (size_t i = 0; i < m_attribs.size(); ++i) {
+        auto& attrib = m_attribs[i];
+        GLuint location = m_locations[i];
+        enabled |= 1u << location;
 
         auto& loc = rs.attributeBindings[location];
         // Track currently enabled attribs by the program to which they are bound
@@ -84,7 +131,7 @@ void VertexLayout::enable(RenderState& rs, ShaderProgram& _program, size_t _byte
 
         GLuint& boundProgram = rs.attributeBindings[i];
 
-        if (boundProgram != glProgram && boundProgram != 0) {
+        if (boundProgram != 0 && !(enabled & (1u << i))) {
             GL::disableVertexAttribArray(i);
             boundProgram = 0;
         }
@@ -27,19 +27,32 @@ public:
 
     VertexLayout(std::vector<VertexAttrib> _attribs);
 
+    // Layout of @_layout without the attributes @_names, which keep their locations so that
+    // programs linked for @_layout can draw vertices of both; @_layout when none is dropped
+    static std::shared_ptr<VertexLayout> without(const std::shared_ptr<VertexLayout>& _layout,
+                                                 const std::vector<std::string>& _names);
+
     void enable(RenderState& rs, ShaderProgram& _program, size_t _byteOffset, void* _ptr = nullptr);
 
     void enable(size_t _byteOffset);
 
+    // Point the attributes, from location @_firstLocation on, to per-instance data at
+    // @_byteOffset of the bound buffer; the state is kept by the bound VAO
+    void enableInstanced(size_t _byteOffset, GLuint _firstLocation);
+
     GLint getStride() const { return m_stride; };
 
     const std::vector<VertexAttrib> getAttribs() const { return m_attribs; }
 
     size_t getOffset(std::string _attribName);
 
+    bool hasAttrib(const std::string& _attribName) const;
+
 private:
 
     std::vector<VertexAttrib> m_attribs;
+    // Attribute locations, the attribute indices unless created by without()
+    std::vector<GLuint> m_locations;
     GLint m_stride;
 
 };
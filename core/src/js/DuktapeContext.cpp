@@ -10,14 +10,116 @@
 #include "duktape/duktape.h"
 #include "glm/vec2.hpp"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
 namespace Tangram {
 
 const static char INSTANCE_ID[] = "\xff""\xff""obj";
 const static char FUNC_ID[] = "\xff""\xff""fns";
+const static char BATCH_ID[] = "\xff""\xff""batch";
+
+// Calls 'fn' for each feature of a batch and returns the results in an array, so that the
+// batch enters the JS context once instead of once per feature
+const static char BATCH_FUNCTION[] = R"(function(fn, count, setFeature, error) {
+    var results = new Array(count);
+    for (var i = 0; i < count; i++) {
+        setFeature(i);
+        try {
+            results[i] = fn();
+        } catch (e) {
+            error(i, String(e));
+        }
+    }
+    return results;
+})";
+
+// Each allocation of the heaps keeps its size in a header, to count the bytes of all heaps
+static constexpr size_t ALLOC_HEADER = alignof(std::max_align_t);
+static std::atomic<size_t> s_heapBytes{0};
+
+void* DuktapeContext::jsAlloc(void*, duk_size_t _size) {
+    if (_size == 0) { return nullptr; }
+    auto* block = static_cast<char*>(std::malloc(_size + ALLOC_HEADER));
+    if (!block) { return nullptr; }
+    *reinterpret_cast<size_t*>(block) = _size;
+    s_heapBytes.fetch_add(_size, std::memory_order_relaxed);
+    return block + ALLOC_HEADER;
+}
+
+void* DuktapeContext::jsRealloc(void* _userData, void* _ptr, duk_size_t _size) {
+    if (!_ptr) { return jsAlloc(_userData, _size); }
+    if (_size == 0) {
+        jsFree(_userData, _ptr);
+        return nullptr;
+    }
+    auto* block = static_cast<char*>(_ptr) - ALLOC_HEADER;
+    size_t oldSize = *reinterpret_cast<size_t*>(block);
+    block = static_cast<char*>(std::realloc(block, _size + ALLOC_HEADER));
+    if (!block) { return nullptr; }
+    *reinterpret_cast<size_t*>(block) = _size;
+    s_heapBytes.fetch_add(_size, std::memory_order_relaxed);
+    s_heapBytes.fetch_sub(oldSize, std::memory_order_relaxed);
+    return block + ALLOC_HEADER;
+}
+
+void DuktapeContext::jsFree(void*, void* _ptr) {
+    if (!_ptr) { return; }
+    auto* block = static_cast<char*>(_ptr) - ALLOC_HEADER;
+    s_heapBytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+}
+
+size_t DuktapeContext::heapBytes() {
+    return s_heapBytes.load(std::memory_order_relaxed);
+}
+
+// Bytecode of the functions compiled by any context, by source, so that each function of a
+// Scene is compiled once instead of once per worker; duk_load_function() is much cheaper
+static std::mutex s_bytecodeMutex;
+static std::unordered_map<std::string, std::string> s_bytecode;
+static size_t s_bytecodeBytes = 0;
+
+// Limit for s_bytecode, which is dropped when full: functions of old scenes are not used again
+static constexpr size_t MAX_BYTECODE_BYTES = 4 * 1024 * 1024;
+
+static bool loadBytecode(duk_context* _ctx, const std::string& _source) {
+    std::lock_guard<std::mutex> lock(s_bytecodeMutex);
+    auto it = s_bytecode.find(_source);
+    if (it == s_bytecode.end()) { return false; }
+
+    void* buffer = duk_push_fixed_buffer(_ctx, it->second.size());
+    std::memcpy(buffer, it->second.data(), it->second.size());
+    duk_load_function(_ctx);
+    return true;
+}
+
+// Keep the bytecode of the function at the stack top
+static void storeBytecode(duk_context* _ctx, const std::string& _source) {
+    duk_dup_top(_ctx);
+    duk_dump_function(_ctx);
+    duk_size_t size = 0;
+    auto* data = static_cast<const char*>(duk_get_buffer(_ctx, -1, &size));
+    {
+        std::lock_guard<std::mutex> lock(s_bytecodeMutex);
+        if (s_bytecodeBytes + size > MAX_BYTECODE_BYTES) {
+            s_bytecode.clear();
+            s_bytecodeBytes = 0;
+        }
+        if (s_bytecode.emplace(_source, std::string(data, size)).second) {
+            s_bytecodeBytes += _source.size() + size;
+        }
+    }
+    duk_pop(_ctx);
+}
 
 DuktapeContext::DuktapeContext() {
-    // Create duktape heap with default allocation functions and custom fatal error handler.
-    _ctx = duk_create_heap(nullptr, nullptr, nullptr, this, fatalErrorHandler);
+    // Create duktape heap with counting allocation functions and custom fatal error handler.
+    _ctx = duk_create_heap(jsAlloc, jsRealloc, jsFree, this, fatalErrorHandler);
 
     //// Create global geometry constants
     // TODO make immutable
@@ -75,6 +177,16 @@ DuktapeContext::DuktapeContext() {
     if (!duk_put_global_string(_ctx, FUNC_ID)) {
         LOGE("'fns' object not set");
     }
+
+    // Set up batch function
+    duk_push_string(_ctx, BATCH_FUNCTION);
+    duk_push_string(_ctx, "");
+    if (duk_pcompile(_ctx, DUK_COMPILE_FUNCTION) == 0) {
+        duk_put_global_string(_ctx, BATCH_ID);
+    } else {
+        LOGE("Batch function not set: %s", duk_safe_to_string(_ctx, -1));
+        duk_pop(_ctx);
+    }
 }
 
 DuktapeContext::~DuktapeContext() {
@@ -98,10 +210,17 @@ bool DuktapeContext::setFunction(JSFunctionIndex index, const std::string& sourc
         return false;
     }
 
+    if (loadBytecode(_ctx, source)) {
+        duk_put_prop_index(_ctx, -2, index);
+        duk_pop(_ctx);
+        return true;
+    }
+
     duk_push_string(_ctx, source.c_str());
     duk_push_string(_ctx, "");
 
     if (duk_pcompile(_ctx, DUK_COMPILE_FUNCTION) == 0) {
+        storeBytecode(_ctx, source);
         duk_put_prop_index(_ctx, -2, index);
     } else {
         LOGW("Compile failed: %s\n%s\n---",
@@ -138,6 +257,48 @@ DuktapeValue DuktapeContext::getFunctionResult(uint32_t index, ArgumentList args
     return getStackTopValue();
 }
 
+DuktapeValue DuktapeContext::getBatchResult(uint32_t index, const std::vector<const Feature*>& features,
+                                            std::vector<uint32_t>& failed) {
+    // -> [batch]
+    if (!duk_get_global_string(_ctx, BATCH_ID)) {
+        LOGE("EvalBatch - batch function not initialized");
+        duk_pop(_ctx);
+        return DuktapeValue();
+    }
+
+    // -> [batch, fns, fn] -> [batch, fn]
+    duk_get_global_string(_ctx, FUNC_ID);
+    if (!duk_get_prop_index(_ctx, -1, index)) {
+        LOGE("EvalBatch - function %d not set", index);
+        duk_pop_3(_ctx);
+        return DuktapeValue();
+    }
+    duk_remove(_ctx, -2);
+
+    // -> [batch, fn, count, setFeature, error]
+    duk_push_uint(_ctx, static_cast<duk_uint_t>(features.size()));
+    duk_push_c_function(_ctx, jsSetBatchFeature, 1 /*nargs*/);
+    duk_push_c_function(_ctx, jsBatchError, 2 /*nargs*/);
+
+    const Feature* feature = _feature;
+    _batchFeatures = &features;
+    _batchFailed = &failed;
+
+    // -> [results|error]
+    bool ok = duk_pcall(_ctx, 4) == 0;
+
+    _batchFeatures = nullptr;
+    _batchFailed = nullptr;
+    _feature = feature;
+
+    if (!ok) {
+        LOGE("EvalBatch: %s", duk_safe_to_string(_ctx, -1));
+        duk_pop(_ctx);
+        return DuktapeValue();
+    }
+    return getStackTopValue();
+}
+
 DuktapeValue DuktapeContext::newNull() {
     duk_push_null(_ctx);
     return getStackTopValue();
@@ -192,6 +353,30 @@ int DuktapeContext::jsConsoleLog(duk_context *_ctx) {
   return 0;
 }
 
+int DuktapeContext::jsSetBatchFeature(duk_context *_ctx) {
+    duk_memory_functions mem_fns;
+    duk_get_memory_functions(_ctx, &mem_fns);
+    auto context = static_cast<DuktapeContext*>(mem_fns.udata);
+
+    auto index = static_cast<size_t>(duk_require_uint(_ctx, 0));
+    if (context->_batchFeatures && index < context->_batchFeatures->size()) {
+        context->_feature = (*context->_batchFeatures)[index];
+    }
+    return 0;
+}
+
+int DuktapeContext::jsBatchError(duk_context *_ctx) {
+    duk_memory_functions mem_fns;
+    duk_get_memory_functions(_ctx, &mem_fns);
+    auto context = static_cast<DuktapeContext*>(mem_fns.udata);
+
+    LOGE("EvalFilterFn: %s", duk_require_string(_ctx, 1));
+    if (context->_batchFailed) {
+        context->_batchFailed->push_back(duk_require_uint(_ctx, 0));
+    }
+    return 0;
+}
+
 // Implements Proxy handler.has(target_object, key)
 int DuktapeContext::jsHasProperty(duk_context *_ctx) {
 
@@ -8,6 +8,7 @@
 #include "duktape/duktape.h"
 
 #include <string>
+#include <vector>
 
 namespace Tangram {
 
@@ -139,10 +140,14 @@ public:
 
     void setCurrentFeature(const Feature* feature);
 
+    // Compiles @source, or loads its bytecode if any context compiled it before
     bool setFunction(JSFunctionIndex index, const std::string& source);
 
     bool evaluateBooleanFunction(JSFunctionIndex index);
 
+    // Bytes allocated by the heaps of all contexts
+    static size_t heapBytes();
+
 protected:
     DuktapeValue newNull();
 
@@ -153,6 +158,8 @@ protected:
     DuktapeValue newObject();
     DuktapeValue newFunction(const std::string& value);
     DuktapeValue getFunctionResult(JSFunctionIndex index, ArgumentList args = {});
+    DuktapeValue getBatchResult(JSFunctionIndex index, const std::vector<const Feature*>& features,
+                                std::vector<uint32_t>& failed);
 
     JSScopeMarker getScopeMarker();
     void resetToScopeMarker(JSScopeMarker marker);
@@ -164,9 +171,17 @@ private:
     static int jsHasProperty(duk_context *_ctx);
     // console.log
     static int jsConsoleLog(duk_context *_ctx);
+    // Batch loop: set the feature at an index, report an error at an index
+    static int jsSetBatchFeature(duk_context *_ctx);
+    static int jsBatchError(duk_context *_ctx);
 
     static void fatalErrorHandler(void* userData, const char* message);
 
+    // Counting allocation functions of the heap
+    static void* jsAlloc(void* _userData, duk_size_t _size);
+    static void* jsRealloc(void* _userData, void* _ptr, duk_size_t _size);
+    static void jsFree(void* _userData, void* _ptr);
+
     bool evaluateFunction(uint32_t index, ArgumentList args = {});
 
     DuktapeValue getStackTopValue() {
@@ -177,6 +192,10 @@ private:
 
     const Feature* _feature = nullptr;
 
+    // Features and failed indices of the running getBatchResult()
+    const std::vector<const Feature*>* _batchFeatures = nullptr;
+    std::vector<uint32_t>* _batchFailed = nullptr;
+
     friend JavaScriptScope<DuktapeContext>;
 };
 
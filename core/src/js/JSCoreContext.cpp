@@ -139,6 +139,34 @@ JSCoreValue JSCoreContext::getFunctionResult(JSFunctionIndex index) {
     return JSCoreValue(_context, jsResultValue);
 }
 
+JSCoreValue JSCoreContext::getBatchResult(JSFunctionIndex index, const std::vector<const Feature*>& features,
+                                          std::vector<uint32_t>& failed) {
+    if (index >= _functions.size()) {
+        return JSCoreValue();
+    }
+    // Calls into JavaScriptCore are cheap, only the results are collected into one array
+    JSObjectRef jsFunctionObject = _functions[index];
+    const Feature* feature = _feature;
+    std::vector<JSValueRef> jsResultValues(features.size());
+    for (size_t i = 0; i < features.size(); i++) {
+        _feature = features[i];
+        JSValueRef jsException = nullptr;
+        jsResultValues[i] = JSObjectCallAsFunction(_context, jsFunctionObject, nullptr, 0, nullptr, &jsException);
+        if (jsException != nullptr) {
+            char buffer[128];
+            JSStringRef jsExceptionString = JSValueToStringCopy(_context, jsException, nullptr);
+            JSStringGetUTF8CString(jsExceptionString, buffer, sizeof(buffer));
+            LOGE("Error evaluating JavaScript function - %s", buffer);
+            JSStringRelease(jsExceptionString);
+            jsResultValues[i] = JSValueMakeUndefined(_context);
+            failed.push_back(i);
+        }
+    }
+    _feature = feature;
+    JSObjectRef jsArray = JSObjectMakeArray(_context, jsResultValues.size(), jsResultValues.data(), nullptr);
+    return JSCoreValue(_context, jsArray);
+}
+
 JSScopeMarker JSCoreContext::getScopeMarker() {
     // Not needed for JSCore implementation.
     return 0;
@@ -205,6 +205,9 @@ public:
 
     bool evaluateBooleanFunction(JSFunctionIndex index);
 
+    // JavaScriptCore does not report the size of its heaps
+    static size_t heapBytes() { return 0; }
+
 protected:
 
     JSCoreValue newNull();
@@ -215,6 +218,8 @@ protected:
     JSCoreValue newObject();
     JSCoreValue newFunction(const std::string& value);
     JSCoreValue getFunctionResult(JSFunctionIndex index);
+    JSCoreValue getBatchResult(JSFunctionIndex index, const std::vector<const Feature*>& features,
+                               std::vector<uint32_t>& failed);
 
     JSScopeMarker getScopeMarker();
     void resetToScopeMarker(JSScopeMarker marker);
@@ -4,6 +4,7 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <vector>
 #include "js/JavaScriptFwd.h"
 
 #if TANGRAM_USE_JSCORE
@@ -40,6 +41,10 @@ public:
     auto getFunctionResult(JSFunctionIndex index, typename Context::ArgumentList args = {}) {
         return _context.getFunctionResult(index, args);
     }
+    auto getBatchResult(JSFunctionIndex index, const std::vector<const Feature*>& features,
+                        std::vector<uint32_t>& failed) {
+        return _context.getBatchResult(index, features, failed);
+    }
 
 private:
 
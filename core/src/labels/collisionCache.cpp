@@ -0,0 +1,47 @@
+#include "labels/collisionCache.h"
+
+namespace Tangram {
+
+bool CollisionCache::get(uint64_t _key, size_t _count, std::vector<bool>& _occluded) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(_key);
+    // A label set of another size has the same hash
+    if (it == m_index.end() || it->second->second.size() != _count) { return false; }
+
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    _occluded = it->second->second;
+    return true;
+}
+
+void CollisionCache::put(uint64_t _key, std::vector<bool> _occluded) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_index.find(_key);
+    if (it != m_index.end()) {
+        it->second->second = std::move(_occluded);
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    m_entries.emplace_front(_key, std::move(_occluded));
+    m_index.emplace(_key, m_entries.begin());
+
+    while (m_entries.size() > m_maxEntries) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+size_t CollisionCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void CollisionCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_index.clear();
+}
+
+}
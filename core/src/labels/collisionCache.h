@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * CollisionCache - Results of LabelCollider::process(), kept across tile builds
+ *
+ * Entries are keyed by a hash of the projected label boxes and the options which take part in
+ * the collision of a tile, so that tiles rebuilt with new TileBuilders, e.g. after an update of
+ * scene globals which did not change the labels, skip the collision tests. An entry holds
+ * whether each label of the sorted label set was occluded. The least recently used entries
+ * are dropped above MAX_ENTRIES.
+ *
+ * Shared by the TileBuilders of a TileWorker; all functions are thread-safe.
+ */
+class CollisionCache {
+
+public:
+
+    explicit CollisionCache(size_t _maxEntries = 512) : m_maxEntries(_maxEntries) {}
+
+    /* Occlusion of the @_count labels of label set @_key; false when not cached */
+    bool get(uint64_t _key, size_t _count, std::vector<bool>& _occluded);
+
+    void put(uint64_t _key, std::vector<bool> _occluded);
+
+    size_t size() const;
+
+    void clear();
+
+private:
+
+    using EntryList = std::list<std::pair<uint64_t, std::vector<bool>>>;
+
+    size_t m_maxEntries;
+
+    mutable std::mutex m_mutex;
+
+    // Most recently used first
+    EntryList m_entries;
+    std::unordered_map<uint64_t, EntryList::iterator> m_index;
+};
+
+}
@@ -0,0 +1,83 @@
+#include "labels/collisionGrid.h"
+
+#include "glm/common.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+void CollisionGrid::reset(glm::vec2 _min, glm::vec2 _max, float _cellSize) {
+
+    _cellSize = std::max(_cellSize, 1.f);
+    int32_t columns = std::max(int32_t(std::ceil((_max.x - _min.x) / _cellSize)), 1);
+    int32_t rows = std::max(int32_t(std::ceil((_max.y - _min.y) / _cellSize)), 1);
+
+    if (columns != m_columns || rows != m_rows) {
+        m_columns = columns;
+        m_rows = rows;
+        m_cells.resize(size_t(columns) * rows);
+    }
+    // Keep the capacity of the cells for the next frame
+    for (auto& cell : m_cells) { cell.clear(); }
+
+    m_min = _min;
+    m_cellSize = _cellSize;
+
+    m_aabbs.clear();
+    m_visited.clear();
+    m_query = 0;
+    m_size = 0;
+    m_extentSum = 0.f;
+    m_stats = {};
+}
+
+void CollisionGrid::cellRange(const AABB& _aabb, glm::ivec2& _min, glm::ivec2& _max) const {
+    glm::ivec2 last(m_columns - 1, m_rows - 1);
+    _min = glm::clamp(glm::ivec2(glm::floor((_aabb.min - m_min) / m_cellSize)), glm::ivec2(0), last);
+    _max = glm::clamp(glm::ivec2(glm::floor((_aabb.max - m_min) / m_cellSize)), glm::ivec2(0), last);
+}
+
+uint32_t CollisionGrid::insert(const AABB& _aabb) {
+    m_stats.inserts++;
+
+    uint32_t index = uint32_t(m_aabbs.size());
+    m_aabbs.push_back(_aabb);
+    m_visited.push_back(0);
+    m_size++;
+    m_extentSum += std::max(_aabb.max.x - _aabb.min.x, _aabb.max.y - _aabb.min.y);
+
+    glm::ivec2 min, max;
+    cellRange(_aabb, min, max);
+    for (int32_t y = min.y; y <= max.y; y++) {
+        for (int32_t x = min.x; x <= max.x; x++) {
+            m_cells[y * m_columns + x].push_back(index);
+        }
+    }
+    return index;
+}
+
+void CollisionGrid::remove(uint32_t _handle) {
+    if (_handle >= m_aabbs.size()) { return; }
+
+    glm::ivec2 min, max;
+    cellRange(m_aabbs[_handle], min, max);
+
+    bool removed = false;
+    for (int32_t y = min.y; y <= max.y; y++) {
+        for (int32_t x = min.x; x <= max.x; x++) {
+            auto& cell = m_cells[y * m_columns + x];
+            auto it = std::find(cell.begin(), cell.end(), _handle);
+            if (it == cell.end()) { continue; }
+            *it = cell.back();
+            cell.pop_back();
+            removed = true;
+        }
+    }
+    if (removed) {
+        m_stats.removals++;
+        m_size--;
+    }
+}
+
+}
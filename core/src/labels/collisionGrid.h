@@ -0,0 +1,100 @@
+#pragma once
+
+#include "aabb.h"
+
+#include "glm/vec2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * CollisionGrid - Uniform grid of screen boxes for the occlusion tests of LabelManager
+ *
+ * The cells are kept between frames and only resized when the cell size or the covered area
+ * change; LabelManager picks the cell size from the number and size of the boxes of the last
+ * frame. Boxes can be removed again, e.g. to retract the placement of a label. Boxes beyond
+ * the covered area are kept in the border cells.
+ */
+class CollisionGrid {
+
+public:
+
+    using AABB = isect2d::AABB<glm::vec2>;
+
+    // Counts since the last reset(), for tuning the cell size
+    struct Stats {
+        size_t inserts = 0;
+        size_t removals = 0;
+        size_t queries = 0;
+        // Boxes tested for intersection by queries
+        size_t tests = 0;
+    };
+
+    /* Remove all boxes and cover @_min to @_max with cells of @_cellSize */
+    void reset(glm::vec2 _min, glm::vec2 _max, float _cellSize);
+
+    /* Add @_aabb, after a reset(); returns its handle for remove() */
+    uint32_t insert(const AABB& _aabb);
+
+    void remove(uint32_t _handle);
+
+    /* Call @_callback with each box intersecting @_aabb, once, until it returns false */
+    template<typename F>
+    void query(const AABB& _aabb, F&& _callback) {
+        if (m_cells.empty()) { return; }
+        m_stats.queries++;
+        m_query++;
+
+        glm::ivec2 min, max;
+        cellRange(_aabb, min, max);
+
+        for (int32_t y = min.y; y <= max.y; y++) {
+            for (int32_t x = min.x; x <= max.x; x++) {
+                for (uint32_t index : m_cells[y * m_columns + x]) {
+                    if (m_visited[index] == m_query) { continue; }
+                    m_visited[index] = m_query;
+                    m_stats.tests++;
+
+                    if (_aabb.intersect(m_aabbs[index]) && !_callback(m_aabbs[index])) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+
+    /* Number of boxes in the grid */
+    size_t size() const { return m_size; }
+
+    /* Mean of the larger side of the inserted boxes */
+    float meanExtent() const { return m_stats.inserts ? m_extentSum / m_stats.inserts : 0.f; }
+
+    float cellSize() const { return m_cellSize; }
+    glm::ivec2 cells() const { return { m_columns, m_rows }; }
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+
+    void cellRange(const AABB& _aabb, glm::ivec2& _min, glm::ivec2& _max) const;
+
+    glm::vec2 m_min;
+    float m_cellSize = 0.f;
+    int32_t m_columns = 0;
+    int32_t m_rows = 0;
+
+    // Indices into m_aabbs of the boxes overlapping each cell
+    std::vector<std::vector<uint32_t>> m_cells;
+    std::vector<AABB> m_aabbs;
+    // Last query which visited each box
+    std::vector<uint32_t> m_visited;
+    uint32_t m_query = 0;
+
+    size_t m_size = 0;
+    float m_extentSum = 0.f;
+    Stats m_stats;
+};
+
+}
@@ -1,6 +1,7 @@
 #include "labels/curvedLabel.h"
 
 #include "gl/dynamicQuadMesh.h"
+#include "labels/curvedLayout.h"
 #include "labels/obbBuffer.h"
 #include "labels/screenTransform.h"
 #include "log.h"
@@ -215,13 +216,12 @@ void CurvedLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
         uint16_t(m_fontAttrib.fontScale),
     };
 
-    auto it = m_textLabels.quads.begin() + m_textRanges[m_textRangeIndex].start;
-    auto end = it + m_textRanges[m_textRangeIndex].length;
+    const GlyphQuad* quads = m_textLabels.quads.data() + m_textRanges[m_textRangeIndex].start;
+    size_t count = m_textRanges[m_textRangeIndex].length;
     auto& style = m_textLabels.style;
 
     auto& meshes = style.getMeshes();
 
-    glm::vec2 rotation;
     LineSampler<ScreenTransform> sampler { _transform };
 
     float width = m_dim.x;
@@ -230,59 +230,31 @@ void CurvedLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
 
     float center = sampler.point(m_screenAnchorPoint).z;
 
-    std::array<glm::i16vec2, 4> vertexPosition;
+    // Kept across labels for its buffers; meshes are built on the render thread
+    static CurvedLayout layout;
+    layout.place(&*_transform.begin(), _transform.size(), center, quads, count);
 
     glm::i16vec2 min(-m_dim.y * TextVertex::position_scale);
     glm::i16vec2 max((_screenSize + m_dim.y) * TextVertex::position_scale);
 
-    for (; it != end; ++it) {
-        auto quad = *it;
-
-        glm::vec2 origin = {(quad.quad[0].pos.x + quad.quad[2].pos.x) * 0.5f, 0 };
-        glm::vec2 point, p1, p2, r1, r2;
-
-        auto xStart = quad.quad[0].pos.x * TextVertex::position_inv_scale;
-        auto xEnd = quad.quad[2].pos.x * TextVertex::position_inv_scale;
-
-        float px = origin.x * TextVertex::position_inv_scale;
-        if (!sampler.sample(center + px, point, rotation)) {
-            continue;
-        }
-
-        bool ok1 = sampler.sample(center + xStart, p1, r1);
-        bool ok2 = sampler.sample(center + xEnd, p2, r2);
-        if (ok1 && ok2) {
-            if (r1 == r2) {
-                rotation = r1;
-            } else {
-                rotation = glm::normalize(p2 - p1);
-            }
-            //point = (p1 + p2) * 0.5f;
-            point = point * 0.5f + (p1 + p2) * 0.25f;
-        }
-
-        glm::i16vec2 p(point * TextVertex::position_scale);
-
-        rotation = {rotation.x, -rotation.y};
+    for (size_t g = 0; g < layout.size(); g++) {
+        const glm::i16vec2* vertexPosition = layout.corners(g);
 
         bool visible = false;
-
         for (int i = 0; i < 4; i++) {
-
-            vertexPosition[i] = p + glm::i16vec2{rotate2d(glm::vec2(quad.quad[i].pos) - origin, rotation)};
-
-            if (!visible &&
-                vertexPosition[i].x > min.x &&
+            if (vertexPosition[i].x > min.x &&
                 vertexPosition[i].x < max.x &&
                 vertexPosition[i].y > min.y &&
                 vertexPosition[i].y < max.y) {
                 visible = true;
+                break;
             }
         }
 
         if (!visible) { continue; }
 
-        auto* quadVertices = meshes[it->atlas]->pushQuad();
+        const auto& quad = quads[layout.glyph(g)];
+        auto* quadVertices = meshes[quad.atlas]->pushQuad();
 
         for (int i = 0; i < 4; i++) {
             TextVertex& v = quadVertices[i];
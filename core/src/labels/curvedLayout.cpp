@@ -0,0 +1,138 @@
+#include "labels/curvedLayout.h"
+
+#include "labels/textLabel.h"
+
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_CURVED_NEON
+#endif
+
+namespace Tangram {
+
+size_t CurvedLayout::place(const glm::vec3* _line, size_t _lineSize, float _center,
+                           const GlyphQuad* _quads, size_t _count) {
+
+    m_glyphs.clear();
+    m_positions.clear();
+    m_rotations.clear();
+    m_corners.clear();
+
+    if (_lineSize < 2) { return 0; }
+
+    // Center, start and end of each glyph along the line
+    m_offsets.resize(_count * 3);
+    for (size_t i = 0; i < _count; i++) {
+        const auto& quad = _quads[i].quad;
+        float origin = (quad[0].pos.x + quad[2].pos.x) * 0.5f;
+        m_offsets[i * 3 + 0] = _center + origin * TextVertex::position_inv_scale;
+        m_offsets[i * 3 + 1] = _center + quad[0].pos.x * TextVertex::position_inv_scale;
+        m_offsets[i * 3 + 2] = _center + quad[2].pos.x * TextVertex::position_inv_scale;
+    }
+
+    // Sample all offsets; the segment of an offset is the last one starting at or before it
+    m_samples.resize(m_offsets.size());
+    m_directions.resize(m_offsets.size());
+    m_valid.resize(m_offsets.size());
+
+    const float sumLength = _line[_lineSize - 1].z;
+    const glm::vec3* lastSegment = _line + _lineSize - 2;
+
+    for (size_t i = 0; i < m_offsets.size(); i++) {
+        float offset = m_offsets[i];
+        m_valid[i] = offset >= 0.f && offset <= sumLength;
+
+        auto* segment = std::upper_bound(_line, _line + _lineSize, offset,
+                                         [](float o, const glm::vec3& p) { return o < p.z; }) - 1;
+        segment = std::min(std::max(segment, _line), lastSegment);
+
+        glm::vec2 curr(segment[0]), next(segment[1]);
+        float length = segment[1].z - segment[0].z;
+
+        m_directions[i] = (next - curr) / length;
+        m_samples[i] = curr + m_directions[i] * (offset - segment[0].z);
+    }
+
+    for (size_t i = 0; i < _count; i++) {
+        size_t s = i * 3;
+        if (!m_valid[s]) { continue; }
+
+        glm::vec2 point = m_samples[s];
+        glm::vec2 rotation = m_directions[s];
+
+        if (m_valid[s + 1] && m_valid[s + 2]) {
+            glm::vec2 p1 = m_samples[s + 1], p2 = m_samples[s + 2];
+            if (m_directions[s + 1] == m_directions[s + 2]) {
+                rotation = m_directions[s + 1];
+            } else {
+                rotation = glm::normalize(p2 - p1);
+            }
+            point = point * 0.5f + (p1 + p2) * 0.25f;
+        }
+
+        m_glyphs.push_back(uint32_t(i));
+        m_positions.push_back(point);
+        m_rotations.push_back({ rotation.x, -rotation.y });
+    }
+
+    rotateCorners(_quads);
+
+    return m_glyphs.size();
+}
+
+void CurvedLayout::rotateCorners(const GlyphQuad* _quads) {
+
+    m_corners.resize(m_glyphs.size() * 4);
+
+    for (size_t g = 0; g < m_glyphs.size(); g++) {
+        const auto& quad = _quads[m_glyphs[g]].quad;
+        float origin = (quad[0].pos.x + quad[2].pos.x) * 0.5f;
+        glm::vec2 rotation = m_rotations[g];
+        glm::i16vec2 p(m_positions[g] * TextVertex::position_scale);
+
+        // rotate2d() of the corners relative to the glyph origin, truncated like the positions
+#if defined(__SSE2__)
+        __m128 x = _mm_sub_ps(_mm_setr_ps(quad[0].pos.x, quad[1].pos.x, quad[2].pos.x, quad[3].pos.x),
+                              _mm_set1_ps(origin));
+        __m128 y = _mm_setr_ps(quad[0].pos.y, quad[1].pos.y, quad[2].pos.y, quad[3].pos.y);
+        __m128 rx = _mm_set1_ps(rotation.x);
+        __m128 ry = _mm_set1_ps(rotation.y);
+
+        __m128i ix = _mm_add_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, rx), _mm_mul_ps(y, ry))),
+                                   _mm_set1_epi32(p.x));
+        __m128i iy = _mm_add_epi32(_mm_cvttps_epi32(_mm_sub_ps(_mm_mul_ps(y, rx), _mm_mul_ps(x, ry))),
+                                   _mm_set1_epi32(p.y));
+
+        __m128i xy = _mm_packs_epi32(_mm_unpacklo_epi32(ix, iy), _mm_unpackhi_epi32(ix, iy));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&m_corners[g * 4]), xy);
+#elif defined(TANGRAM_CURVED_NEON)
+        float32x4_t x = vsubq_f32((float32x4_t){ float(quad[0].pos.x), float(quad[1].pos.x),
+                                                 float(quad[2].pos.x), float(quad[3].pos.x) },
+                                  vdupq_n_f32(origin));
+        float32x4_t y = (float32x4_t){ float(quad[0].pos.y), float(quad[1].pos.y),
+                                       float(quad[2].pos.y), float(quad[3].pos.y) };
+        float32x4_t rx = vdupq_n_f32(rotation.x);
+        float32x4_t ry = vdupq_n_f32(rotation.y);
+
+        int32x4_t ix = vaddq_s32(vcvtq_s32_f32(vmlaq_f32(vmulq_f32(x, rx), y, ry)), vdupq_n_s32(p.x));
+        int32x4_t iy = vaddq_s32(vcvtq_s32_f32(vmlsq_f32(vmulq_f32(y, rx), x, ry)), vdupq_n_s32(p.y));
+
+        int32x4x2_t xy = vzipq_s32(ix, iy);
+        vst1q_s16(reinterpret_cast<int16_t*>(&m_corners[g * 4]),
+                  vcombine_s16(vqmovn_s32(xy.val[0]), vqmovn_s32(xy.val[1])));
+#else
+        for (int i = 0; i < 4; i++) {
+            glm::vec2 in(quad[i].pos.x - origin, quad[i].pos.y);
+            glm::vec2 out(in.x * rotation.x + in.y * rotation.y, -in.x * rotation.y + in.y * rotation.x);
+            m_corners[g * 4 + i] = p + glm::i16vec2(out);
+        }
+#endif
+    }
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/gtc/type_precision.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+struct GlyphQuad;
+
+/*
+ * CurvedLayout - Places the glyphs of a curved label along its line in screen space
+ *
+ * The line is given as points with their cumulative length in z, as in the ScreenTransform of
+ * the label. Each glyph is sampled at its center and ends; the segments of all samples are
+ * found by binary search over the cumulative lengths, instead of walking a LineSampler back
+ * and forth per glyph. The corners of all placed glyphs are then rotated in one pass, four at
+ * a time with SSE2 or NEON when available.
+ *
+ * Reused across labels to keep its buffers.
+ */
+class CurvedLayout {
+
+public:
+
+    /* Place the glyphs of @_quads, centered at length @_center of @_line; returns the number of
+     * glyphs placed, i.e. those whose center lies on the line */
+    size_t place(const glm::vec3* _line, size_t _lineSize, float _center,
+                 const GlyphQuad* _quads, size_t _count);
+
+    size_t size() const { return m_glyphs.size(); }
+
+    /* Index into the quads of placed glyph @_i */
+    uint32_t glyph(size_t _i) const { return m_glyphs[_i]; }
+
+    /* Four corners of placed glyph @_i, in TextVertex position units */
+    const glm::i16vec2* corners(size_t _i) const { return &m_corners[_i * 4]; }
+
+private:
+
+    void rotateCorners(const GlyphQuad* _quads);
+
+    std::vector<float> m_offsets;
+    std::vector<glm::vec2> m_samples;
+    std::vector<glm::vec2> m_directions;
+    std::vector<uint8_t> m_valid;
+
+    std::vector<uint32_t> m_glyphs;
+    std::vector<glm::vec2> m_positions;
+    std::vector<glm::vec2> m_rotations;
+    std::vector<glm::i16vec2> m_corners;
+};
+
+}
@@ -161,6 +161,11 @@ public:
     void setAlpha(float _alpha);
 
     bool m_elevationSet = false;
+
+    // Position in the priority and draw order of the LabelManager update m_sortUpdate
+    uint32_t m_priorityRank = 0;
+    uint32_t m_drawRank = 0;
+    uint32_t m_sortUpdate = 0;
 #ifdef DEBUG
     std::string debugTag;
 #endif
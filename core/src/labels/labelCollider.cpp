@@ -1,9 +1,11 @@
 #include "labels/labelCollider.h"
 
+#include "labels/collisionCache.h"
 #include "labels/curvedLabel.h"
 #include "labels/labelSet.h"
 #include "labels/obbBuffer.h"
 #include "util/geom.h"
+#include "util/hash.h"
 #include "view/view.h" // ViewState
 #include "log.h"
 
@@ -105,6 +107,56 @@ static bool priorityComparator(const Label* l1, const Label* l2, bool dflt = fal
     return dflt;
 }
 
+uint64_t LabelCollider::hashLabels(glm::vec2 _screenSize) const {
+
+    size_t seed = m_labels.size();
+    hash_combine(seed, _screenSize.x);
+    hash_combine(seed, _screenSize.y);
+
+    for (auto& entry : m_labels) {
+        auto* label = entry.label;
+        const auto& options = label->options();
+
+        hash_combine(seed, label->hash());
+        hash_combine(seed, int(label->type()));
+        hash_combine(seed, options.priority);
+        hash_combine(seed, options.repeatGroup);
+        hash_combine(seed, options.repeatDistance);
+        hash_combine(seed, options.optional);
+        hash_combine(seed, label->candidatePriority());
+        hash_combine(seed, label->screenCenter().x);
+        hash_combine(seed, label->screenCenter().y);
+
+        // Relatives are linked within the label set of a tile
+        hash_combine(seed, label->isChild());
+        if (label->isChild()) {
+            hash_combine(seed, label->relative()->hash());
+            hash_combine(seed, label->relative()->screenCenter().x);
+            hash_combine(seed, label->relative()->screenCenter().y);
+        }
+
+        for (int i = entry.obbs.start; i < entry.obbs.end(); i++) {
+            for (const auto& p : m_obbs[i].getQuad()) {
+                hash_combine(seed, p.x);
+                hash_combine(seed, p.y);
+            }
+        }
+    }
+    return seed;
+}
+
+void LabelCollider::applyCachedResult(const std::vector<bool>& _occluded) {
+
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        if (_occluded[i]) { m_labels[i].label->occlude(); }
+    }
+    // Occludes the relatives as in the first run
+    killOccludedLabels();
+
+    m_labels.clear();
+    m_aabbs.clear();
+}
+
 void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tileSize) {
 
     // Sort labels so that all labels of one repeat group are next to each other
@@ -121,7 +173,8 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
 
     // try to avoid too many collisions error from isect2d - large number of labels typically means many in
     //  each repeat group, as the number of unique features per tile is limited
-    if (m_labels.size() > 4096) {
+    bool prefiltered = m_labels.size() > 4096;
+    if (prefiltered) {
         size_t nlabels = m_labels.size();
         filterRepeatGroups(0, m_labels.size()-1, _tileSize * tileScale);
         killOccludedLabels();
@@ -175,6 +228,18 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
 
     if (m_labels.empty()) { return; }
 
+    // Prefiltered label sets depend on the labels before projection, which are not hashed
+    uint64_t key = 0;
+    if (m_cache && !prefiltered) {
+        key = hashLabels(screenSize);
+
+        std::vector<bool> occluded;
+        if (m_cache->get(key, m_labels.size(), occluded)) {
+            applyCachedResult(occluded);
+            return;
+        }
+    }
+
     // Limit isect2d splits to a maximum of 64 in each dimension to keep allocations reasonable.
     glm::vec2 split{ min(screenSize.x / 128.f, 64.f), min(screenSize.y / 128.f, 64.f) };
 
@@ -279,6 +344,14 @@ void LabelCollider::process(TileID _tileID, float _tileInverseScale, float _tile
 
     filterRepeatGroups(lastFilteredLabelIndex, m_labels.size()-1);
 
+    if (m_cache && !prefiltered) {
+        std::vector<bool> occluded(m_labels.size());
+        for (size_t i = 0; i < m_labels.size(); i++) {
+            occluded[i] = m_labels[i].label->isOccluded();
+        }
+        m_cache->put(key, std::move(occluded));
+    }
+
     killOccludedLabels();
 
     m_labels.clear();
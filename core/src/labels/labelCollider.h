@@ -12,6 +12,7 @@
 
 namespace Tangram {
 
+class CollisionCache;
 class Label;
 struct ViewState;
 
@@ -19,6 +20,8 @@ class LabelCollider {
 
 public:
 
+    /// @_cache keeps the results of process() across builds, may be null
+    explicit LabelCollider(CollisionCache* _cache = nullptr) : m_cache(_cache) {}
 
     void addLabels(std::vector<std::unique_ptr<Label>>& _labels);
 
@@ -26,6 +29,12 @@ public:
 
 private:
 
+    // Hash of the projected boxes and collision options of the sorted labels
+    uint64_t hashLabels(glm::vec2 _screenSize) const;
+
+    // Occlude the labels in @_occluded, as the result of a previous process()
+    void applyCachedResult(const std::vector<bool>& _occluded);
+
     size_t filterRepeatGroups(size_t startPos, size_t curPos, float _tileSize = 0);
 
     void killOccludedLabels();
@@ -57,6 +66,8 @@ private:
     isect2d::ISect2D<glm::vec2> m_isect2d;
 
     ScreenTransform::Buffer m_transforms;
+
+    CollisionCache* m_cache = nullptr;
 };
 
 }
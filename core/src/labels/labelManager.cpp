@@ -19,19 +19,27 @@
 #include "tile/tileManager.h"
 #include "view/view.h"
 #include "util/elevationManager.h"
+#include "util/workerPool.h"
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/rotate_vector.hpp"
 #include "glm/gtx/norm.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 namespace Tangram {
 
-LabelManager::LabelManager()
+LabelManager::LabelManager(size_t _numWorkers)
     : m_needUpdate(false),
-      m_lastZoom(0.0f) {}
+      m_lastZoom(0.0f) {
+
+    if (_numWorkers > 0) { m_workers = std::make_unique<WorkerPool>(_numWorkers); }
+}
 
 LabelManager::~LabelManager() {}
 
@@ -131,26 +139,68 @@ void LabelManager::processLabelUpdate(const ViewState& _viewState, const LabelSe
             //LOGW("'%s' - Camera: label %f, terrain %f; delta: %f", label->debugTag.c_str(), labelz, terrainz, labelz - terrainz);
         }
 
-        bool isProxy = _tile && _tile->isProxy();
-        if (_onlyRender) {
-            if (label->occludedLastFrame()) { label->occlude(); }
+        addLabel(_viewState, label.get(), _style, _tile, _marker, transformRange, _dt, _onlyRender);
+    }
 
-            if (label->visibleState() || !label->canOcclude()) {
-                m_needUpdate |= label->evalState(_dt);
-                label->addVerticesToMesh(transform, _viewState.viewportSize);
-            }
-        } else if (label->canOcclude()) {
-            m_labels.emplace_back(label.get(), _style, _tile, _marker, isProxy, transformRange);
-        } else {
-            m_needUpdate |= label->evalState(_dt);
-            label->addVerticesToMesh(transform, _viewState.viewportSize);
-        }
-        if (label->selectionColor()) {
-            m_selectionLabels.emplace_back(label.get(), _style, _tile, _marker, isProxy, transformRange);
+    if (useElev && _tile) { _elevManager->setMinZoom(0); }
+}
+
+void LabelManager::addLabel(const ViewState& _viewState, Label* _label, Style* _style,
+                            const Tile* _tile, const Marker* _marker, Range _transformRange,
+                            float _dt, bool _onlyRender) {
+
+    ScreenTransform transform { m_transforms, _transformRange };
+
+    bool isProxy = _tile && _tile->isProxy();
+    if (_onlyRender) {
+        if (_label->occludedLastFrame()) { _label->occlude(); }
+
+        if (_label->visibleState() || !_label->canOcclude()) {
+            m_needUpdate |= _label->evalState(_dt);
+            _label->addVerticesToMesh(transform, _viewState.viewportSize);
         }
+    } else if (_label->canOcclude()) {
+        m_labels.emplace_back(_label, _style, _tile, _marker, isProxy, _transformRange);
+    } else {
+        m_needUpdate |= _label->evalState(_dt);
+        _label->addVerticesToMesh(transform, _viewState.viewportSize);
+    }
+    if (_label->selectionColor()) {
+        m_selectionLabels.emplace_back(_label, _style, _tile, _marker, isProxy, _transformRange);
     }
+}
 
-    if (useElev && _tile) { _elevManager->setMinZoom(0); }
+void LabelManager::projectLabels(const ViewState& _viewState, ProjectionJob& _job, bool _onlyRender) {
+
+    _job.transforms.clear();
+    _job.projected.clear();
+
+    float border = 256.0f;
+    AABB extendedBounds(-border, -border,
+                        _viewState.viewportSize.x + border,
+                        _viewState.viewportSize.y + border);
+
+    AABB screenBounds(0, 0,
+                      _viewState.viewportSize.x,
+                      _viewState.viewportSize.y);
+
+    bool drawAllLabels = Tangram::getDebugFlag(DebugFlags::draw_all_labels);
+    const glm::mat4& mvp = _job.tile ? _job.tile->mvp() : _job.marker->modelViewProjectionMatrix();
+
+    for (auto& label : _job.labels->getLabels()) {
+        if (!drawAllLabels && (label->state() == Label::State::dead) ) {
+            continue;
+        }
+
+        Range transformRange;
+        ScreenTransform transform { _job.transforms, transformRange };
+
+        auto bounds = (_onlyRender || !label->canOcclude()) ? screenBounds : extendedBounds;
+
+        if (label->update(mvp, _viewState, &bounds, transform)) {
+            _job.projected.emplace_back(label.get(), transformRange);
+        }
+    }
 }
 
 std::pair<Label*, const Tile*> LabelManager::getLabel(uint32_t _selectionColor) const {
@@ -173,6 +223,23 @@ static Style* getStyleById(const Scene& _scene, uint32_t id) {
     return nullptr;
 }
 
+std::pair<const LabelSet*, Style*> LabelManager::markerLabels(const Scene& _scene, Marker& _marker,
+                                                             bool _onlyRender) const {
+
+    if (!_marker.isVisible() || !_marker.isInView() || !_marker.mesh()) { return {}; }
+
+    if (_marker.isAltMarker) {
+        if (!_onlyRender) { _marker.altMeshAdded = false; }
+        if (!_marker.altMeshAdded) { return {}; }
+    }
+
+    Style* style = getStyleById(_scene, _marker.styleId());
+    auto labels = dynamic_cast<const LabelSet*>(_marker.mesh());
+    if (!style || !labels) { return {}; }
+
+    return { labels, style };
+}
+
 void LabelManager::updateLabels(const ViewState& _viewState, float _dt, const Scene& _scene,
                           const std::vector<std::shared_ptr<Tile>>& _tiles,
                           const std::vector<std::unique_ptr<Marker>>& _markers,
@@ -185,6 +252,64 @@ void LabelManager::updateLabels(const ViewState& _viewState, float _dt, const Sc
     m_needUpdate = false;
 
     auto* elevManager = _scene.elevationManager();
+
+    // Project labels in parallel when there are many; labels on terrain depend on the depth
+    // data of the ElevationManager
+    if (m_workers && !elevManager) {
+        size_t numJobs = 0;
+        size_t numLabels = 0;
+        auto addJob = [&](const LabelSet* _labels, Style* _style, const Tile* _tile,
+                          const Marker* _marker) {
+            if (numJobs == m_projectionJobs.size()) { m_projectionJobs.emplace_back(); }
+            auto& job = m_projectionJobs[numJobs++];
+            job.labels = _labels;
+            job.style = _style;
+            job.tile = _tile;
+            job.marker = _marker;
+            numLabels += _labels->getLabels().size();
+        };
+
+        for (const auto& tile : _tiles) {
+            for (const auto& style : _scene.styles()) {
+                auto labels = dynamic_cast<const LabelSet*>(tile->getMesh(*style).get());
+                if (labels) { addJob(labels, style.get(), tile.get(), nullptr); }
+            }
+        }
+        for (const auto& marker : _markers) {
+            auto labels = markerLabels(_scene, *marker, _onlyRender);
+            if (labels.first) { addJob(labels.first, labels.second, nullptr, marker.get()); }
+        }
+
+        if (numLabels >= MIN_PARALLEL_LABELS) {
+            m_workers->parallelFor(numJobs, [&](size_t i) {
+                projectLabels(_viewState, m_projectionJobs[i], _onlyRender);
+            });
+
+            // Add the labels in the order of the jobs, as if projected on this thread
+            for (size_t i = 0; i < numJobs; i++) {
+                auto& job = m_projectionJobs[i];
+                int offset = int(m_transforms.points.size());
+                m_transforms.points.insert(m_transforms.points.end(),
+                                           job.transforms.points.begin(), job.transforms.points.end());
+
+                for (auto& projected : job.projected) {
+                    Range range = projected.second;
+                    range.start += offset;
+                    addLabel(_viewState, projected.first, job.style, job.tile, job.marker,
+                             range, _dt, _onlyRender);
+                }
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < numJobs; i++) {
+            auto& job = m_projectionJobs[i];
+            processLabelUpdate(_viewState, job.labels, job.style, job.tile, job.marker,
+                               nullptr, _dt, _onlyRender);
+        }
+        return;
+    }
+
     const auto& _styles = _scene.styles();
     for (const auto& tile : _tiles) {
         for (const auto& style : _styles) {
@@ -204,20 +329,10 @@ void LabelManager::updateLabels(const ViewState& _viewState, float _dt, const Sc
     }
 
     for (const auto& marker : _markers) {
+        auto labels = markerLabels(_scene, *marker, _onlyRender);
+        if (!labels.first) { continue; }
 
-        if (!marker->isVisible() || !marker->mesh()) { continue; }
-
-        if (marker->isAltMarker) {
-            if (!_onlyRender) { marker->altMeshAdded = false; }
-            if (!marker->altMeshAdded) { continue; }
-        }
-
-        Style* style = getStyleById(_scene, marker->styleId());
-        const auto& mesh = marker->mesh();
-        auto labels = dynamic_cast<const LabelSet*>(mesh);
-        if (!style || !labels) { continue; }
-
-        processLabelUpdate(_viewState, labels, style, nullptr, marker.get(),
+        processLabelUpdate(_viewState, labels.first, labels.second, nullptr, marker.get(),
                            elevManager, _dt, _onlyRender);
     }
 
@@ -242,25 +357,58 @@ void LabelManager::skipTransitions(const std::vector<const Style*>& _styles, Til
         auto* mesh1 = dynamic_cast<const LabelSet*>(_proxy.getMesh(*style).get());
         if (!mesh1) { continue; }
 
+        // A proxy label matches a new label within the circle defined by the bbox of the new
+        // label, so with cells as large as the largest of these circles each new label only
+        // needs to look at the cells around it
+        float cellSize = 0.f;
         for (auto& l0 : mesh0->getLabels()) {
-            if (!l0->canOcclude()) { continue; }
-            if (l0->state() != Label::State::none) { continue; }
+            if (!l0->canOcclude() || l0->state() != Label::State::none) { continue; }
+            cellSize = std::max({ cellSize, l0->dimension().x, l0->dimension().y });
+        }
+        if (!(cellSize > 0.f)) { continue; }
 
-            for (auto& l1 : mesh1->getLabels()) {
-                if (!l1->visibleState()) { continue; }
-                if (!l1->canOcclude()) { continue;}
+        auto cell = [cellSize](float _coord) {
+            return int32_t(glm::clamp(std::floor(_coord / cellSize), -1e9f, 1e9f));
+        };
 
-                // Using repeat group to also handle labels with dynamic style properties
-                if (l0->options().repeatGroup != l1->options().repeatGroup) { continue; }
-                // if (l0->hash() != l1->hash()) { continue; }
+        m_proxyLabels.clear();
+        for (auto& l1 : mesh1->getLabels()) {
+            if (!l1->visibleState()) { continue; }
+            if (!l1->canOcclude()) { continue;}
 
-                float d2 = glm::distance2(l0->screenCenter(), l1->screenCenter());
+            glm::vec2 center = l1->screenCenter();
+            if (!std::isfinite(center.x) || !std::isfinite(center.y)) { continue; }
+            // Using repeat group to also handle labels with dynamic style properties
+            m_proxyLabels.push_back({ l1->options().repeatGroup, cell(center.x), cell(center.y), l1.get() });
+        }
+        if (m_proxyLabels.empty()) { continue; }
+        std::sort(m_proxyLabels.begin(), m_proxyLabels.end());
 
-                // The new label lies within the circle defined by the bbox of l0
-                if (sqrt(d2) < std::max(l0->dimension().x, l0->dimension().y)) {
-                    l0->skipTransitions();
+        for (auto& l0 : mesh0->getLabels()) {
+            if (!l0->canOcclude()) { continue; }
+            if (l0->state() != Label::State::none) { continue; }
+
+            glm::vec2 center = l0->screenCenter();
+            float radius = std::max(l0->dimension().x, l0->dimension().y);
+            if (!std::isfinite(center.x) || !std::isfinite(center.y)) { continue; }
+
+            bool skip = false;
+            for (int32_t x = cell(center.x - radius); x <= cell(center.x + radius) && !skip; x++) {
+                for (int32_t y = cell(center.y - radius); y <= cell(center.y + radius) && !skip; y++) {
+                    auto range = std::equal_range(m_proxyLabels.begin(), m_proxyLabels.end(),
+                                                  ProxyLabel{ l0->options().repeatGroup, x, y, nullptr });
+                    for (auto it = range.first; it != range.second; ++it) {
+                        float d2 = glm::distance2(center, it->label->screenCenter());
+
+                        // The new label lies within the circle defined by the bbox of l0
+                        if (sqrt(d2) < radius) {
+                            skip = true;
+                            break;
+                        }
+                    }
                 }
             }
+            if (skip) { l0->skipTransitions(); }
         }
     }
 }
@@ -413,9 +561,163 @@ bool LabelManager::zOrderComparator(const LabelEntry& _a, const LabelEntry& _b)
     return bool(_a.tile);
 }
 
+// Unsigned bits of @_value in the order of the floats, with -0 equal to +0
+static uint32_t orderedBits(float _value) {
+    _value += 0.f;
+    uint32_t bits;
+    std::memcpy(&bits, &_value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+uint64_t LabelManager::priorityKey(const LabelEntry& _entry) {
+
+    // The leading fields of priorityComparator: proxy, integer priority, tile zoom (tile labels
+    // before marker labels) and the top 24 bits of the screen depth
+    uint64_t key = uint64_t(_entry.proxy) << 63;
+    key |= uint64_t(orderedBits(std::nearbyint(_entry.priority))) << 31;
+
+    if (_entry.tile) {
+        int z = glm::clamp(int(_entry.tile->getID().z), 0, 63);
+        key |= uint64_t(63 - z) << 24;
+    } else {
+        key |= uint64_t(1) << 30;
+    }
+    key |= orderedBits(_entry.label->screenCoord().z) >> 8;
+
+    return key;
+}
+
+void LabelManager::sortRange(std::vector<LabelEntry>::iterator _begin,
+                             std::vector<LabelEntry>::iterator _end,
+                             bool (*_comparator)(const LabelEntry&, const LabelEntry&)) {
+
+    size_t count = _end - _begin;
+    if (_comparator != priorityComparator || count < MIN_RADIX_SORT_LABELS) {
+        std::sort(_begin, _end, _comparator);
+        return;
+    }
+
+    m_sortKeys.resize(count);
+    m_sortKeysScratch.resize(count);
+
+    uint64_t differentBits = 0;
+    for (size_t i = 0; i < count; i++) {
+        m_sortKeys[i] = { priorityKey(_begin[i]), uint32_t(i) };
+        differentBits |= m_sortKeys[i].first ^ m_sortKeys[0].first;
+    }
+
+    // LSD radix sort by bytes, skipping bytes which are the same in all keys
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((differentBits >> shift) & 0xff) == 0) { continue; }
+
+        size_t offsets[256] = {};
+        for (auto& key : m_sortKeys) { offsets[(key.first >> shift) & 0xff]++; }
+
+        size_t offset = 0;
+        for (auto& bucket : offsets) {
+            size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (auto& key : m_sortKeys) {
+            m_sortKeysScratch[offsets[(key.first >> shift) & 0xff]++] = key;
+        }
+        std::swap(m_sortKeys, m_sortKeysScratch);
+    }
+
+    m_radixLabels.clear();
+    for (auto& key : m_sortKeys) { m_radixLabels.push_back(_begin[key.second]); }
+    std::copy(m_radixLabels.begin(), m_radixLabels.end(), _begin);
+
+    // Labels with the same key are ordered by the remaining fields
+    for (size_t start = 0; start < count;) {
+        size_t end = start + 1;
+        while (end < count && m_sortKeys[end].first == m_sortKeys[start].first) { end++; }
+        if (end - start > 1) { std::sort(_begin + start, _begin + end, _comparator); }
+        start = end;
+    }
+}
+
+// Insertion sort which gives up after @_maxMoves moves, leaving a permutation of the range
+template<typename It, typename Compare>
+static bool insertionSort(It _begin, It _end, Compare _comparator, size_t _maxMoves) {
+    if (_begin == _end) { return true; }
+
+    size_t moves = 0;
+    for (auto it = _begin + 1; it != _end; ++it) {
+        if (!_comparator(*it, *(it - 1))) { continue; }
+
+        auto value = std::move(*it);
+        auto hole = it;
+        do {
+            *hole = std::move(*(hole - 1));
+            --hole;
+            if (++moves > _maxMoves) {
+                *hole = std::move(value);
+                return false;
+            }
+        } while (hole != _begin && _comparator(value, *(hole - 1)));
+        *hole = std::move(value);
+    }
+    return true;
+}
+
+void LabelManager::sortLabels(uint32_t Label::*_rank, size_t _lastCount,
+                              bool (*_comparator)(const LabelEntry&, const LabelEntry&)) {
+
+    // Put the labels of the last update at their last position
+    m_rankSlots.assign(_lastCount, -1);
+    m_sortedLabels.clear();
+    m_sortedLabels.reserve(m_labels.size());
+
+    size_t newLabels = 0;
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        auto* label = m_labels[i].label;
+        uint32_t rank = label->*_rank;
+        if (label->m_sortUpdate == m_sortUpdate && rank < _lastCount && m_rankSlots[rank] < 0) {
+            m_rankSlots[rank] = int32_t(i);
+        } else {
+            newLabels++;
+        }
+    }
+    for (int32_t slot : m_rankSlots) {
+        if (slot >= 0) { m_sortedLabels.push_back(m_labels[slot]); }
+    }
+    auto kept = m_sortedLabels.size();
+
+    if (newLabels > 0) {
+        for (size_t i = 0; i < m_labels.size(); i++) {
+            auto* label = m_labels[i].label;
+            uint32_t rank = label->*_rank;
+            if (label->m_sortUpdate != m_sortUpdate || rank >= _lastCount ||
+                m_rankSlots[rank] != int32_t(i)) {
+                m_sortedLabels.push_back(m_labels[i]);
+            }
+        }
+    }
+
+    auto begin = m_sortedLabels.begin();
+    // Labels change their order a little between updates; sort them all when they do not
+    if (!insertionSort(begin, begin + kept, _comparator, 4 * kept)) {
+        sortRange(begin, begin + kept, _comparator);
+    }
+    if (newLabels > 0) {
+        sortRange(begin + kept, m_sortedLabels.end(), _comparator);
+        std::inplace_merge(begin, begin + kept, m_sortedLabels.end(), _comparator);
+    }
+
+    std::swap(m_labels, m_sortedLabels);
+
+    for (size_t i = 0; i < m_labels.size(); i++) {
+        m_labels[i].label->*_rank = uint32_t(i);
+    }
+}
+
 void LabelManager::handleOcclusions(const ViewState& _viewState, bool _hideExtraLabels) {
 
-    m_isect2d.clear();
+    // Cover the bounds of labels taking part in occlusion, see processLabelUpdate()
+    float border = 256.0f;
+    m_collisionGrid.reset(glm::vec2(-border), _viewState.viewportSize + border, m_collisionCellSize);
     m_repeatGroups.clear();
 
     using iterator = decltype(m_labels)::const_iterator;
@@ -494,7 +796,7 @@ void LabelManager::handleOcclusions(const ViewState& _viewState, bool _hideExtra
 
             // Occlude label when its obbs intersect with a previous label.
             for (auto& obb : obbs) {
-                m_isect2d.intersect(obb.getExtent(), [&](auto& a, auto& b) {
+                m_collisionGrid.query(obb.getExtent(), [&](auto& b) {
                         size_t other = reinterpret_cast<size_t>(b.m_userData);
 
                         if (!intersect(obb, m_obbs[other])) {
@@ -513,8 +815,7 @@ void LabelManager::handleOcclusions(const ViewState& _viewState, bool _hideExtra
                             l->skipTransitions();
                         }
                         return false;
-
-                    }, false);
+                    });
 
                 if (l->isOccluded()) { break; }
             }
@@ -530,36 +831,96 @@ void LabelManager::handleOcclusions(const ViewState& _viewState, bool _hideExtra
                 }
             }
         } else {
-            // Insert into ISect2D grid
-            int obbPos = entry.obbsRange.start;
+            // Insert into the collision grid
+            size_t obbPos = entry.obbsRange.start;
             for (auto& obb : obbs) {
                 auto aabb = obb.getExtent();
                 aabb.m_userData = reinterpret_cast<void*>(obbPos++);
-                m_isect2d.insert(aabb);
+                m_collisionGrid.insert(aabb);
             }
 
             if (l->options().repeatDistance > 0.f) {
-                m_repeatGroups[l->options().repeatGroup].push_back(l);
+                addToRepeatGroup(l);
             }
         }
     }
 }
 
+static uint64_t repeatGroupCell(int32_t _x, int32_t _y) {
+    return (uint64_t(uint32_t(_x)) << 32) | uint32_t(_y);
+}
+
+void LabelManager::addToRepeatGroup(Label* _label) {
+
+    auto& group = m_repeatGroups[_label->options().repeatGroup];
+    // Cells as large as the repeat distance of the first label, usually the same for the group
+    if (group.cellSize == 0.f) { group.cellSize = _label->options().repeatDistance; }
+
+    glm::ivec2 cell(glm::floor(_label->screenCenter() / group.cellSize));
+    group.cells[repeatGroupCell(cell.x, cell.y)].push_back(_label);
+}
+
+void LabelManager::tuneCollisionGrid() {
+
+    size_t count = m_collisionGrid.size();
+    if (count == 0) { return; }
+
+    // Cells for about COLLISION_CELL_BOXES of the boxes of this update, no smaller than the
+    // boxes so that each box is in a few cells only
+    glm::vec2 size = glm::vec2(m_collisionGrid.cells()) * m_collisionGrid.cellSize();
+    float cellSize = std::sqrt(size.x * size.y * COLLISION_CELL_BOXES / count);
+    cellSize = std::max(cellSize, m_collisionGrid.meanExtent());
+    cellSize = glm::clamp(cellSize, MIN_COLLISION_CELL_SIZE, MAX_COLLISION_CELL_SIZE);
+
+    // Keep the cells while the density changes little
+    if (std::abs(cellSize - m_collisionCellSize) > 0.25f * m_collisionCellSize) {
+        m_collisionCellSize = cellSize;
+    }
+}
+
 bool LabelManager::withinRepeatDistance(Label *_label) {
-    float threshold2 = pow(_label->options().repeatDistance, 2);
+    float threshold = _label->options().repeatDistance;
+    float threshold2 = threshold * threshold;
 
     auto it = m_repeatGroups.find(_label->options().repeatGroup);
-    if (it != m_repeatGroups.end()) {
-        for (auto* ll : it->second) {
+    if (it == m_repeatGroups.end()) { return false; }
+
+    auto& group = it->second;
+    auto within = [&](const std::vector<Label*>& _labels) {
+        for (auto* ll : _labels) {
             float d2 = glm::distance2(_label->screenCenter(), ll->screenCenter());
             if (d2 < threshold2) {
                 return true;
             }
         }
+        return false;
+    };
+
+    // Cells within the repeat distance of the label
+    int32_t range = int32_t(std::ceil(threshold / group.cellSize));
+    size_t numCells = size_t(2 * range + 1) * size_t(2 * range + 1);
+
+    if (numCells > group.cells.size()) {
+        for (auto& cell : group.cells) {
+            if (within(cell.second)) { return true; }
+        }
+        return false;
+    }
+
+    glm::ivec2 center(glm::floor(_label->screenCenter() / group.cellSize));
+    for (int32_t y = center.y - range; y <= center.y + range; y++) {
+        for (int32_t x = center.x - range; x <= center.x + range; x++) {
+            auto cell = group.cells.find(repeatGroupCell(x, y));
+            if (cell != group.cells.end() && within(cell->second)) { return true; }
+        }
     }
     return false;
 }
 
+bool LabelManager::meshesCurrent() const {
+    return m_meshesCurrent && m_drawAllLabels == Tangram::getDebugFlag(DebugFlags::draw_all_labels);
+}
+
 void LabelManager::updateLabelSet(const View& _view, float _dt, const Scene& _scene,
                             const std::vector<std::shared_ptr<Tile>>& _tiles,
                             const std::vector<std::unique_ptr<Marker>>& _markers,
@@ -569,11 +930,28 @@ void LabelManager::updateLabelSet(const View& _view, float _dt, const Scene& _sc
     m_obbs.clear();
 
     auto _viewState = _view.state();
+    m_drawAllLabels = Tangram::getDebugFlag(DebugFlags::draw_all_labels);
+    m_meshesCurrent = false;
+
+    // Add the milliseconds since the last lap to @_stage of m_stats
+    auto lapStart = std::chrono::steady_clock::now();
+    auto lap = [&](double UpdateStats::*_stage) {
+        if (!m_stats) { return; }
+        auto now = std::chrono::steady_clock::now();
+        m_stats->*_stage += std::chrono::duration<double, std::milli>(now - lapStart).count();
+        lapStart = now;
+    };
+
     /// Collect and update labels from visible tiles
     updateLabels(_viewState, _dt, _scene, _tiles, _markers, _onlyRender);
-    if (_onlyRender) { return; }
+    lap(&UpdateStats::labels);
+    if (_onlyRender) {
+        m_meshesCurrent = !m_needUpdate && !_scene.elevationManager();
+        return;
+    }
 
-    std::sort(m_labels.begin(), m_labels.end(), LabelManager::priorityComparator);
+    sortLabels(&Label::m_priorityRank, m_lastLabelCount, LabelManager::priorityComparator);
+    lap(&UpdateStats::sort);
 
     /// Mark labels to skip transitions
 
@@ -581,10 +959,8 @@ void LabelManager::updateLabelSet(const View& _view, float _dt, const Scene& _sc
         skipTransitions(_scene, _tiles, *_scene.tileManager(), _viewState.zoom);
     }
 
-    m_isect2d.resize({_viewState.viewportSize.x / 256, _viewState.viewportSize.y / 256},
-                     {_viewState.viewportSize.x, _viewState.viewportSize.y});
-
     handleOcclusions(_viewState, _scene.hideExtraLabels);
+    tuneCollisionGrid();
 
     // Update label state
     for (auto& entry : m_labels) {
@@ -593,8 +969,14 @@ void LabelManager::updateLabelSet(const View& _view, float _dt, const Scene& _sc
         //}
         m_needUpdate |= entry.label->evalState(_dt);
     }
+    lap(&UpdateStats::occlusions);
+
+    sortLabels(&Label::m_drawRank, m_lastLabelCount, LabelManager::zOrderComparator);
+    lap(&UpdateStats::sort);
 
-    std::sort(m_labels.begin(), m_labels.end(), LabelManager::zOrderComparator);
+    m_sortUpdate++;
+    for (auto& entry : m_labels) { entry.label->m_sortUpdate = m_sortUpdate; }
+    m_lastLabelCount = m_labels.size();
 
     Label::AABB screenBounds{0, 0, _viewState.viewportSize.x, _viewState.viewportSize.y};
 
@@ -637,11 +1019,20 @@ void LabelManager::updateLabelSet(const View& _view, float _dt, const Scene& _sc
             }
         }
     }
+    lap(&UpdateStats::meshes);
+    m_meshesCurrent = !m_needUpdate && !elevManager;
     m_lastZoom = _viewState.zoom;
     m_lastViewPos = _view.getPosition();
     m_lastViewProj = _view.getViewProjectionMatrix();
 }
 
+size_t LabelManager::visibleLabelCount() const {
+    return std::count_if(m_labels.begin(), m_labels.end(), [](const LabelEntry& _entry) {
+        auto state = _entry.label->state();
+        return state == Label::State::visible || state == Label::State::fading_in;
+    });
+}
+
 void LabelManager::drawDebug(RenderState& rs, const View& _view) {
 
     if (!Tangram::getDebugFlag(Tangram::DebugFlags::labels)) {
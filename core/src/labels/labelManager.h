@@ -1,6 +1,7 @@
 #pragma once
 
 #include "data/properties.h"
+#include "labels/collisionGrid.h"
 #include "labels/label.h"
 #include "labels/screenTransform.h"
 #include "labels/spriteLabel.h"
@@ -13,6 +14,7 @@
 #include <memory>
 #include <mutex>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -25,11 +27,13 @@ class Tile;
 class Style;
 class Scene;
 class TileManager;
+class WorkerPool;
 
 class LabelManager {
 
 public:
-    LabelManager();
+    /* With @_numWorkers threads, labels are projected in parallel when there are many */
+    explicit LabelManager(size_t _numWorkers = 0);
 
     virtual ~LabelManager();
 
@@ -44,6 +48,32 @@ public:
 
     bool needUpdate() const { return m_needUpdate; }
 
+    /* Whether the label meshes of the last update can be drawn again instead of updating the
+     * labels, when the view, tiles and markers did not change: no label was in transition and
+     * label positions do not depend on terrain depth */
+    bool meshesCurrent() const;
+
+    /* Build the label meshes on the next update, e.g. for a new GL context */
+    void invalidateMeshes() { m_meshesCurrent = false; }
+
+    /* Labels of the last label update, and those of them visible or fading in */
+    size_t labelCount() const { return m_labels.size(); }
+    size_t visibleLabelCount() const;
+
+    /* Counts of the collision grid in the last label update */
+    const CollisionGrid::Stats& collisionStats() const { return m_collisionGrid.stats(); }
+    float collisionCellSize() const { return m_collisionCellSize; }
+
+    /* Milliseconds spent in the stages of updateLabelSet(), e.g. for benchmarks */
+    struct UpdateStats {
+        double labels = 0;     // collecting and projecting the labels of tiles and markers
+        double sort = 0;       // sorting by priority and draw order
+        double occlusions = 0; // collision tests and label states
+        double meshes = 0;     // adding the vertices of visible labels
+    };
+    /* Add the times of following updates to @_stats, if not null */
+    void setUpdateStats(UpdateStats* _stats) { m_stats = _stats; }
+
     std::pair<Label*, const Tile*> getLabel(uint32_t _selectionColor) const;
 
 protected:
@@ -58,10 +88,26 @@ protected:
 
     void skipTransitions(const std::vector<const Style*>& _styles, Tile& _tile, Tile& _proxy) const;
 
+    // Visible labels of a proxy tile by repeat group and screen grid cell, see skipTransitions()
+    struct ProxyLabel {
+        size_t repeatGroup;
+        int32_t x, y;
+        const Label* label;
+        bool operator<(const ProxyLabel& _other) const {
+            return std::tie(repeatGroup, x, y) < std::tie(_other.repeatGroup, _other.x, _other.y);
+        }
+    };
+    mutable std::vector<ProxyLabel> m_proxyLabels;
+
     void handleOcclusions(const ViewState& _viewState, bool _hideExtraLabels = false);
 
     bool withinRepeatDistance(Label *_label);
 
+    /* Pick the cell size of the collision grid for the next update */
+    void tuneCollisionGrid();
+
+    void addToRepeatGroup(Label* _label);
+
     void updateLabels(const ViewState& _viewState, float _dt, const Scene& _scene,
                       const std::vector<std::shared_ptr<Tile>>& _tiles,
                       const std::vector<std::unique_ptr<Marker>>& _markers,
@@ -71,9 +117,39 @@ protected:
                             const Tile* _tile, const Marker* _marker, ElevationManager* _elevManager,
                             float _dt, bool _onlyRender);
 
+    // Labels of a LabelSet projected on a WorkerPool thread
+    struct ProjectionJob {
+        const LabelSet* labels;
+        Style* style;
+        const Tile* tile;
+        const Marker* marker;
+
+        ScreenTransform::Buffer transforms;
+        // Labels in the screen bounds with their range in transforms
+        std::vector<std::pair<Label*, Range>> projected;
+    };
+
+    static constexpr size_t MIN_PARALLEL_LABELS = 512;
+
+    /* Screen transforms of the labels of @_job, see processLabelUpdate() */
+    void projectLabels(const ViewState& _viewState, ProjectionJob& _job, bool _onlyRender);
+
+    /* Add @_label with its screen transform for occlusion, or to its mesh */
+    void addLabel(const ViewState& _viewState, Label* _label, Style* _style, const Tile* _tile,
+                  const Marker* _marker, Range _transformRange, float _dt, bool _onlyRender);
+
+    /* Labels and style of @_marker when they are updated */
+    std::pair<const LabelSet*, Style*> markerLabels(const Scene& _scene, Marker& _marker,
+                                                    bool _onlyRender) const;
+
     bool m_needUpdate;
 
-    isect2d::ISect2D<glm::vec2> m_isect2d;
+    static constexpr float COLLISION_CELL_BOXES = 4.f;
+    static constexpr float MIN_COLLISION_CELL_SIZE = 32.f;
+    static constexpr float MAX_COLLISION_CELL_SIZE = 512.f;
+
+    CollisionGrid m_collisionGrid;
+    float m_collisionCellSize = 256.f;
 
     struct LabelEntry {
 
@@ -102,15 +178,53 @@ protected:
 
     static bool zOrderComparator(const LabelEntry& _a, const LabelEntry& _b);
 
+    /* Sort m_labels with @_comparator, starting from the order of the last update given by
+     * @_rank of the labels: labels kept from the last update are usually in order already,
+     * new labels are sorted on their own and merged */
+    void sortLabels(uint32_t Label::*_rank, size_t _lastCount,
+                    bool (*_comparator)(const LabelEntry&, const LabelEntry&));
+
+    /* Sort a range of labels with @_comparator; many labels are sorted by priority with a
+     * radix sort of their priorityKey(), then by @_comparator among those with equal keys */
+    void sortRange(std::vector<LabelEntry>::iterator _begin, std::vector<LabelEntry>::iterator _end,
+                   bool (*_comparator)(const LabelEntry&, const LabelEntry&));
+
+    /* Key in the order of priorityComparator, which orders labels with equal keys */
+    static uint64_t priorityKey(const LabelEntry& _entry);
+
+    static constexpr size_t MIN_RADIX_SORT_LABELS = 256;
+
     std::vector<OBB> m_obbs;
     ScreenTransform::Buffer m_transforms;
 
     std::vector<LabelEntry> m_labels;
     std::vector<LabelEntry> m_selectionLabels;
 
-    std::unordered_map<size_t, std::vector<Label*>> m_repeatGroups;
+    // Scratch space of sortLabels()
+    std::vector<LabelEntry> m_sortedLabels;
+    std::vector<int32_t> m_rankSlots;
+    std::vector<std::pair<uint64_t, uint32_t>> m_sortKeys;
+    std::vector<std::pair<uint64_t, uint32_t>> m_sortKeysScratch;
+    std::vector<LabelEntry> m_radixLabels;
+    // Number of the last update which sorted m_labels and their count in it
+    uint32_t m_sortUpdate = 0;
+    size_t m_lastLabelCount = 0;
+
+    // Visible labels of a repeat group in a grid of screen cells
+    struct RepeatGroup {
+        float cellSize = 0.f;
+        std::unordered_map<uint64_t, std::vector<Label*>> cells;
+    };
+    std::unordered_map<size_t, RepeatGroup> m_repeatGroups;
+
+    std::unique_ptr<WorkerPool> m_workers;
+    std::vector<ProjectionJob> m_projectionJobs;
+
+    UpdateStats* m_stats = nullptr;
 
     float m_lastZoom;
+    bool m_meshesCurrent = false;
+    bool m_drawAllLabels = false;
     // view state for last label update;
     glm::mat4 m_lastViewProj;
     glm::dvec2 m_lastViewPos;
@@ -202,8 +202,15 @@ void SpriteLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
         m_vertexAttrib.outlineColor,
         m_vertexAttrib.antialiasFactor,
         uint16_t(m_alpha * SpriteVertex::alpha_scale),
+        m_vertexAttrib.sdfFillEdge,
+        m_vertexAttrib.sdfOutlineEdge,
     };
 
+    if (m_labels.m_style.isInstanced()) {
+        addInstanceToMesh(_transform, quad, state);
+        return;
+    }
+
     auto* quadVertices = m_labels.m_style.pushQuad(m_texture);
 
     if (m_options.flat) {
@@ -241,4 +248,36 @@ void SpriteLabel::addVerticesToMesh(ScreenTransform& _transform, const glm::vec2
     }
 }
 
+void SpriteLabel::addInstanceToMesh(ScreenTransform& _transform, const SpriteQuad& _quad,
+                                    const SpriteVertex::State& _state) {
+
+    auto* instance = m_labels.m_style.pushInstance(m_texture);
+
+    // Quad vertices are top-left, top-right, bottom-left and bottom-right
+    if (m_options.flat) {
+        FlatTransform transform(_transform);
+
+        instance->setCorners(transform.projected(0), transform.projected(1), transform.projected(2));
+
+    } else {
+        BillboardTransform transform(_transform);
+
+        glm::vec2 pos = glm::vec2(transform.projected());
+        glm::vec2 scale = 2.0f / transform.screenSize();
+        scale.y *= -1;
+
+        pos += m_options.offset * scale;
+        pos += m_anchor * scale;
+
+        glm::vec4 corners[3];
+        for (int i = 0; i < 3; i++) {
+            corners[i] = glm::vec4(pos + _quad.quad[i].pos * scale, 0.f, 1.f);
+        }
+        instance->setCorners(corners[0], corners[1], corners[2]);
+    }
+
+    instance->uv = glm::i16vec4(_quad.quad[2].uv, _quad.quad[1].uv);
+    instance->state = _state;
+}
+
 }
@@ -10,6 +10,7 @@ namespace Tangram {
 class SpriteLabels;
 class PointStyle;
 class Texture;
+struct SpriteQuad;
 
 struct SpriteVertex {
     glm::vec4 pos;
@@ -20,12 +21,39 @@ struct SpriteVertex {
         uint32_t outline_color;
         uint16_t antialias_factor;
         uint16_t alpha;
+        // Distances at the edges of fill and outline of distance field sprites, see Texture::isSdf()
+        uint16_t sdf_fill_edge;
+        uint16_t sdf_outline_edge;
     } state;
 
     static const float alpha_scale;
     static const float texture_scale;
 };
 
+// One sprite quad of the instanced point path, see PointStyle::isInstanced()
+struct SpriteInstance {
+    // Clip space position of the quad center and half extents along the quad axes; a planar
+    // quad stays a parallelogram in clip space, so billboards and flat sprites both fit
+    glm::vec4 center;
+    glm::vec4 axisX;
+    glm::vec4 axisY;
+    // Texture coordinates of the bottom-left and the top-right corner
+    glm::i16vec4 uv;
+    SpriteVertex::State state;
+
+    // Set from the clip space positions of the top-left, top-right and bottom-left corners
+    void setCorners(const glm::vec4& _topLeft, const glm::vec4& _topRight, const glm::vec4& _bottomLeft) {
+        center = (_topRight + _bottomLeft) * 0.5f;
+        axisX = (_topRight - _topLeft) * 0.5f;
+        axisY = (_topLeft - _bottomLeft) * 0.5f;
+    }
+
+    // Clip space position of unit quad @_corner, as computed by the point shader
+    glm::vec4 corner(glm::vec2 _corner) const {
+        return center + _corner.x * axisX + _corner.y * axisY;
+    }
+};
+
 class SpriteLabel : public Label {
 public:
 
@@ -35,6 +63,8 @@ public:
         uint32_t outlineColor;
         uint16_t antialiasFactor;
         float extrudeScale;
+        uint16_t sdfFillEdge = 0;
+        uint16_t sdfOutlineEdge = 0;
     };
 
     using Coordinates = glm::vec3;
@@ -68,6 +98,9 @@ public:
 
 private:
 
+    void addInstanceToMesh(ScreenTransform& _transform, const SpriteQuad& _quad,
+                           const SpriteVertex::State& _state);
+
     Coordinates m_coordinates;
     float m_zoom;
 
@@ -1,18 +1,26 @@
 #include "map.h"
+#include "mapContext.h"
 
+#include "data/tileSource.h"
+#include "debug/allocCounter.h"
 #include "debug/textDisplay.h"
 #include "debug/frameInfo.h"
+#include "debug/sessionRecording.h"
+#include "debug/trace.h"
 #include "gl.h"
 #include "gl/glError.h"
 #include "gl/framebuffer.h"
 #include "gl/hardware.h"
+#include "gl/pixelReadback.h"
 #include "gl/primitives.h"
 #include "gl/renderState.h"
+#include "gl/retainedData.h"
 #include "gl/shaderProgram.h"
 #include "labels/labelManager.h"
 #include "marker/marker.h"
 #include "marker/markerManager.h"
 #include "platform.h"
+#include "scene/featureStates.h"
 #include "scene/scene.h"
 #include "scene/sceneLoader.h"
 #include "selection/selectionQuery.h"
@@ -21,6 +29,9 @@
 #include "text/fontContext.h"
 #include "tile/tile.h"
 #include "tile/tileCache.h"
+#include "tile/tileDiskCache.h"
+#include "tile/tileManager.h"
+#include "tile/tileWorker.h"
 #include "util/asyncWorker.h"
 #include "util/elevationManager.h"
 #include "util/fastmap.h"
@@ -29,11 +40,23 @@
 #include "util/touchListener.h"
 #include "util/ease.h"
 #include "util/jobQueue.h"
+#include "util/memoryGovernor.h"
+#include "util/renderScheduler.h"
+#include "util/resolutionScaler.h"
+#include "util/threadPlacement.h"
+#include "util/timeHistogram.h"
 #include "view/flyTo.h"
 #include "view/view.h"
 
+#include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 namespace Tangram {
 
@@ -54,6 +77,19 @@ struct CameraEase {
 
 using CameraAnimator = std::function<uint32_t(float dt)>;
 
+static std::vector<double> cameraNumbers(const CameraPosition& _camera) {
+    return { _camera.longitude, _camera.latitude, _camera.zoom, _camera.rotation, _camera.tilt };
+}
+
+static std::vector<std::string> updateStrings(std::vector<std::string> _strings,
+                                              const std::vector<SceneUpdate>& _updates) {
+    for (const auto& update : _updates) {
+        _strings.push_back(update.path);
+        _strings.push_back(update.value);
+    }
+    return _strings;
+}
+
 struct ClientTileSource {
     std::shared_ptr<TileSource> tileSource;
     bool added = false;
@@ -68,17 +104,29 @@ public:
         platform(_platform),
         inputHandler(view),
         touchHandler(std::make_shared<TouchHandler>(view)),
-        scene(std::make_unique<Scene>(_platform)) {}
+        scene(std::make_unique<Scene>(_platform)) {
+        updateRenderInterval();
+        scene->setRenderScheduler(&renderScheduler);
+    }
 
     void setPixelScale(float _pixelsPerPoint);
     SceneID loadScene(SceneOptions&& _sceneOptions);
     SceneID loadSceneAsync(SceneOptions&& _sceneOptions);
+    std::shared_ptr<TileWorker> getTileWorker(SceneOptions& _sceneOptions);
     void syncClientTileSources(bool _firstUpdate);
     bool updateCameraEase(float _dt);
+    void updatePrefetchViews();
     LngLat getLngLat();
     CameraEase getCameraEase(const CameraPosition& _camera);
+    void updateRenderInterval();
 
     Platform& platform;
+    // Merges the frames requested for loaded tiles, see setTileRenderInterval(); declared before
+    // Scene, which requests frames through it
+    RenderScheduler renderScheduler{platform};
+    float tileRenderInterval = 0.05f;
+    // Frame cap in frames per second, see setMaxFrameRate()
+    float maxFrameRate = 0.f;
     RenderState renderState;
     JobQueue jobQueue;
     View view;
@@ -89,16 +137,137 @@ public:
 
     std::unique_ptr<Ease> ease;
 
+    // Applies the current camera ease at time t to a View; used to predict upcoming views
+    std::function<void(View&, float)> easeView;
+    // Also prefetch tiles for the final camera position (set for flyTo)
+    bool prefetchEaseEnd = false;
+    // Seconds of camera motion to look ahead when prefetching tiles; 0 disables prefetching
+    float prefetchTime = 0.5f;
+    // Largest on-screen edge of a tile in tile sizes, see TileManager::setLodScale()
+    float tileLodScale = 2.f;
+
     std::unique_ptr<Scene> scene;
 
+    MemoryGovernor memoryGovernor;
+    // Frames since the memory budget was last applied
+    uint32_t memoryFrames = 0;
+
+    // Durations of render(), and tile worker time and clock at the last call of
+    // getPerformanceStats(), for the worker utilization since then
+    TimeHistogram renderTimes;
+    // Whether the GPU time of styles and passes is measured, see setGpuTiming()
+    bool gpuTiming = false;
+    float workerTime = 0.f;
+    std::chrono::steady_clock::time_point statsTime = std::chrono::steady_clock::now();
+
+    // Session being recorded, see startRecording(), and the number of recorded Map calls in
+    // progress: only the outermost call is recorded, not e.g. the gestures of handleTouchEvent()
+    SessionRecording recording;
+    int recordedCalls = 0;
+
+    struct RecordScope {
+        Impl& impl;
+        explicit RecordScope(Impl& _impl) : impl(_impl) { impl.recordedCalls++; }
+        ~RecordScope() { impl.recordedCalls--; }
+        // Whether to record the call
+        bool operator()() const { return impl.recordedCalls == 1 && impl.recording.recording(); }
+    };
+
+    // Tile worker threads are kept across Scene reloads
+    std::shared_ptr<TileWorker> tileWorker;
+
+    // Shares tile workers and caches with other Maps when set
+    std::shared_ptr<MapContext> mapContext;
+
+    // Raw and parsed tile caches kept across Scene reloads: those of mapContext if set, else
+    // of this Map only
+    std::shared_ptr<MapContext> sourceCaches;
+
     std::unique_ptr<FrameBuffer> selectionBuffer = std::make_unique<FrameBuffer>(0, 0);
 
+    // Update thread, see Map::setThreadedUpdate()
+    std::thread updateThread;
+    std::atomic<bool> threadedUpdate{false};
+    // Held by the update thread while it updates the frame state and by render() while it draws
+    // it; recursive for Map calls from callbacks
+    std::recursive_mutex frameMutex;
+    // Guard the fields below, which pass time steps to the update thread and its state back
+    std::mutex updateMutex;
+    std::condition_variable updateCondition;
+    bool updateThreadRunning = false;
+    bool updatePending = false;
+    float updateTime = 0.f;
+    MapState updateState;
+    // Whether the last update changed what is drawn, e.g. moved the view or added tiles
+    bool frameChanged = false;
+
+    // Frame lock, only taken while the update runs on its own thread
+    std::unique_lock<std::recursive_mutex> frameLock() {
+        if (!threadedUpdate) { return {}; }
+        return std::unique_lock<std::recursive_mutex>(frameMutex);
+    }
+
+    // Target of lower resolution for the scene while the view moves, see setDynamicResolution()
+    ResolutionScaler resolutionScaler;
+    std::unique_ptr<FrameBuffer> scaledBuffer;
+    std::chrono::steady_clock::time_point lastFrameTime;
+    // Whether the last update moved the view
+    bool viewMoving = false;
+
     bool cacheGlState = false;
     float pickRadius = .5f;
     bool isAnimating = false;
 
     std::vector<SelectionQuery> selectionQueries;
 
+    // Selection queries waiting for the pixels of their frame, see PixelReadback
+    struct PendingSelection {
+        int slot;
+        std::vector<SelectionQuery> queries;
+    };
+    std::vector<PendingSelection> pendingSelections;
+    PixelReadback selectionReadback;
+
+    // Images requested by renderToImage(), rendered in order with the view at their camera
+    struct ImageRequest {
+        CameraPosition camera;
+        int width, height;
+        ImageReadyCallback callback;
+    };
+    std::deque<ImageRequest> imageRequests;
+    // Set once the view is moved to the camera of the first request, and when that view is complete
+    bool imageViewSet = false;
+    bool imageViewComplete = false;
+    // Camera and viewport to restore after the last image, set while images are rendered
+    bool renderingImages = false;
+    CameraPosition imageRestoreCamera;
+    glm::vec4 imageRestoreViewport;
+    std::unique_ptr<FrameBuffer> imageBuffer;
+
+    // Images waiting for their pixels, see PixelReadback
+    struct PendingImage {
+        int slot;
+        ImageRequest request;
+    };
+    std::vector<PendingImage> pendingImages;
+    PixelReadback imageReadback;
+
+    // Snapshots requested by captureSnapshotAsync(), captured from the next frame
+    struct SnapshotRequest {
+        int x, y, width, height;
+        float scale;
+        ImageReadyCallback callback;
+    };
+    std::vector<SnapshotRequest> snapshotRequests;
+    // Downscaled snapshots are blitted into this framebuffer and read from it
+    std::unique_ptr<FrameBuffer> snapshotBuffer;
+    struct PendingSnapshot {
+        int slot;
+        SnapshotRequest request;
+    };
+    std::vector<PendingSnapshot> pendingSnapshots;
+    PixelReadback snapshotReadback;
+
     SceneReadyCallback onSceneReady = nullptr;
     CameraAnimationCallback cameraAnimationListener = nullptr;
 
@@ -113,16 +282,23 @@ public:
 
 static std::bitset<9> g_flags = 0;
 
-Map::Map(std::unique_ptr<Platform> _platform) : platform(std::move(_platform)) {
+Map::Map(std::unique_ptr<Platform> _platform) : Map(std::move(_platform), nullptr) {}
+
+Map::Map(std::unique_ptr<Platform> _platform, std::shared_ptr<MapContext> _context) :
+    platform(std::move(_platform)) {
     LOGTOInit();
     impl = std::make_unique<Impl>(*platform);
-    
+    impl->mapContext = std::move(_context);
+    impl->sourceCaches = impl->mapContext ? impl->mapContext : std::make_shared<MapContext>();
+
     // Set the Map reference for the touch handler
     impl->touchHandler->setMap(this);
     impl->touchHandler->init();
 }
 
 Map::~Map() {
+    setThreadedUpdate(false);
+
     // Let the platform stop all outstanding tasks:
     // Send cancel to UrlRequests so any thread blocking on a response can join,
     // and discard incoming UrlRequest directly.
@@ -134,6 +310,7 @@ Map::~Map() {
     // Scene need to be destroyed before JobQueue stops.
     impl->asyncWorker.reset();
     impl->scene.reset();
+    impl->tileWorker.reset();
 
     // Make sure other threads are stopped before calling stop()!
     // All jobs will be executed immediately on add() afterwards.
@@ -146,6 +323,12 @@ Map::~Map() {
 
 
 SceneID Map::loadScene(SceneOptions&& _sceneOptions, bool _async) {
+    Impl::RecordScope record(*impl);
+    if (record()) {
+        impl->recording.addCall("loadScene", { double(_async), double(_sceneOptions.useScenePosition) },
+                                updateStrings({ _sceneOptions.url.string(), _sceneOptions.yaml },
+                                              _sceneOptions.updates));
+    }
     if (_async) {
         return impl->loadSceneAsync(std::move(_sceneOptions));
     } else {
@@ -153,13 +336,37 @@ SceneID Map::loadScene(SceneOptions&& _sceneOptions, bool _async) {
     }
 }
 
+std::shared_ptr<TileWorker> Map::Impl::getTileWorker(SceneOptions& _sceneOptions) {
+    if (mapContext) { return mapContext->tileWorker(); }
+
+    if (_sceneOptions.autoTileWorkers) {
+        _sceneOptions.numTileWorkers = CpuTopology::get().numTileWorkers();
+    }
+    uint32_t numWorkers = _sceneOptions.numTileWorkers;
+    bool pinWorkers = _sceneOptions.pinTileWorkers;
+
+    // Only start new worker threads when the requested pool changes; a Scene still using
+    // the previous pool keeps it alive until the Scene is disposed.
+    if (!tileWorker || tileWorker->numWorkers() != numWorkers || tileWorker->pinsWorkers() != pinWorkers) {
+        tileWorker = std::make_shared<TileWorker>(numWorkers, pinWorkers);
+    }
+    return tileWorker;
+}
+
 SceneID Map::Impl::loadScene(SceneOptions&& _sceneOptions) {
 
-    Scene* oldScene = scene.release();
-    oldScene->cancelTasks();
-    scene = std::make_unique<Scene>(platform, std::move(_sceneOptions), nullptr, oldScene);
+    Scene* oldScene;
+    {
+        auto lock = frameLock();
+        oldScene = scene.release();
+        oldScene->cancelTasks();
+        auto workers = getTileWorker(_sceneOptions);
+        scene = std::make_unique<Scene>(platform, std::move(_sceneOptions), nullptr, oldScene, workers,
+                                        sourceCaches);
+        scene->setRenderScheduler(&renderScheduler);
+        view.m_elevationManager = nullptr;
+    }
     // oldScene may have been loaded async, so dispose on worker thread (after loading complete)
-    view.m_elevationManager = nullptr;
     asyncWorker->enqueue([oldScene](){ delete oldScene; });
     scene->load();
 
@@ -172,6 +379,8 @@ SceneID Map::Impl::loadScene(SceneOptions&& _sceneOptions) {
 
 SceneID Map::Impl::loadSceneAsync(SceneOptions&& _sceneOptions) {
 
+    auto lock = frameLock();
+
     Scene* oldScene = scene.release();
     oldScene->cancelTasks();
     view.m_elevationManager = nullptr;
@@ -186,7 +395,10 @@ SceneID Map::Impl::loadSceneAsync(SceneOptions&& _sceneOptions) {
         platform.requestRender();
     };
 
-    scene = std::make_unique<Scene>(platform, std::move(_sceneOptions), prefetchCallback, oldScene);
+    auto workers = getTileWorker(_sceneOptions);
+    scene = std::make_unique<Scene>(platform, std::move(_sceneOptions), prefetchCallback, oldScene, workers,
+                                    sourceCaches);
+    scene->setRenderScheduler(&renderScheduler);
 
     // This async task gets a raw pointer to the new scene and the following task takes ownership of the shared_ptr to
     // the old scene. Tasks in the async queue are executed one at a time in FIFO order, so even if another scene starts
@@ -216,13 +428,45 @@ View& Map::getView() {
 
 void Map::updateGlobals(const std::vector<SceneUpdate>& _sceneUpdates, bool _rebuildTiles)
 {
-  auto& config = const_cast<YAML::Node&>(impl->scene->config());
+  Impl::RecordScope record(*impl);
+  if (record()) {
+      impl->recording.addCall("updateGlobals", { double(_rebuildTiles) }, updateStrings({}, _sceneUpdates));
+  }
+  auto& scene = *impl->scene;
+  auto& config = const_cast<YAML::Node&>(scene.config());
   SceneLoader::applyUpdates(config, _sceneUpdates);
-  impl->scene->globalsGeneration++;
-  if (_rebuildTiles) { impl->scene->tileManager()->clearTileSets(); }
+  scene.globalsGeneration++;
+  if (auto* diskCache = scene.tileDiskCache()) {
+    uint64_t key = diskCache->sceneKey();
+    for (const auto& update : _sceneUpdates) {
+      key = TileDiskCache::hash(update.path + '=' + update.value, key);
+    }
+    diskCache->setSceneKey(key);
+  }
+  if (_rebuildTiles) {
+    // rebuild only styles depending on the changed globals if known
+    std::vector<bool> styles;
+    if (scene.stylesForGlobalUpdates(_sceneUpdates, styles)) {
+      scene.tileManager()->rebuildStyles(styles);
+    } else {
+      scene.tileManager()->clearTileSets();
+    }
+  }
   impl->platform.requestRender();
 }
 
+bool Map::setFeatureState(int32_t _sourceId, const std::string& _featureId,
+                          const std::string& _key, const std::string& _value) {
+    bool success = impl->scene->featureStates().set(_sourceId, _featureId, _key, _value);
+    if (success) { platform->requestRender(); }
+    return success;
+}
+
+void Map::clearFeatureStates() {
+    impl->scene->featureStates().clear();
+    platform->requestRender();
+}
+
 void Map::setSceneReadyListener(SceneReadyCallback _onSceneReady) {
     impl->onSceneReady = _onSceneReady;
 }
@@ -235,15 +479,137 @@ Platform& Map::getPlatform() {
     return *platform;
 }
 
+void Map::setGpuTiming(bool _enabled) {
+    auto frameLock = impl->frameLock();
+    impl->gpuTiming = _enabled;
+}
+
+void Map::startRecording() {
+    auto& recording = impl->recording;
+    recording.start();
+
+    auto& view = impl->view;
+    auto viewport = view.getViewport();
+    recording.addCall("setViewport", { viewport.x, viewport.y, viewport.z, viewport.w });
+    recording.addCall("setPixelScale", { view.pixelScale() });
+    const auto& options = impl->scene->options();
+    recording.addCall("loadScene", { 0, 0 }, updateStrings({ options.url.string(), options.yaml }, options.updates));
+    recording.addCall("setCameraPosition", cameraNumbers(getCameraPosition()));
+
+    platform->setUrlResponseObserver([this](const std::string& _url, const UrlResponse& _response) {
+        impl->recording.addResponse(_url, _response);
+    });
+}
+
+std::string Map::stopRecording() {
+    platform->setUrlResponseObserver(nullptr);
+    return impl->recording.stop();
+}
+
+PerformanceStats Map::getPerformanceStats() {
+    auto frameLock = impl->frameLock();
+
+    auto& scene = *impl->scene;
+    auto& tileManager = *scene.tileManager();
+    PerformanceStats stats;
+
+    auto& cacheStats = tileManager.getTileCache()->stats();
+    stats.tileCacheHits = cacheStats.hits;
+    stats.tileCacheMisses = cacheStats.misses;
+    stats.tileCacheEvictions = cacheStats.evictions;
+
+    auto workerStats = scene.tileWorker()->stats();
+    stats.tilesLoading = uint32_t(tileManager.numLoadingTiles());
+    stats.tilesQueued = workerStats.queued;
+    stats.tilesParsed = workerStats.parsedQueued;
+    stats.tilesUploadPending = uint32_t(scene.tileUploader().stats().pending);
+
+    stats.tileWorkers = uint32_t(scene.tileWorker()->numWorkers());
+    float workerTime = workerStats.parseTime + workerStats.buildTime + workerStats.abortedTime;
+    auto now = std::chrono::steady_clock::now();
+    float elapsed = std::chrono::duration<float, std::milli>(now - impl->statsTime).count();
+    if (elapsed > 0.f && stats.tileWorkers > 0) {
+        // the TileWorker may have been replaced since the last call, e.g. by a MapContext
+        float busy = std::max(0.f, workerTime - impl->workerTime);
+        stats.workerUtilization = std::min(1.f, busy / (elapsed * stats.tileWorkers));
+    }
+    impl->workerTime = workerTime;
+    impl->statsTime = now;
+
+    stats.tilesBuilt = workerStats.built;
+    stats.tilesAborted = workerStats.aborted;
+    stats.parseTimeAverage = workerStats.parsed ? workerStats.parseTime / workerStats.parsed : 0.f;
+    stats.buildTimeAverage = workerStats.built ? workerStats.buildTime / workerStats.built : 0.f;
+    stats.buildTimeP95 = workerStats.buildTimeP95;
+
+    stats.allocProfiling = AllocCounter::enabled();
+    if (workerStats.parsed) {
+        stats.parseAllocations = float(workerStats.parseAllocations) / workerStats.parsed;
+        stats.parseAllocBytes = float(workerStats.parseAllocBytes) / workerStats.parsed;
+    }
+    if (workerStats.built) {
+        stats.buildAllocations = float(workerStats.buildAllocations) / workerStats.built;
+        stats.buildAllocBytes = float(workerStats.buildAllocBytes) / workerStats.built;
+    }
+
+    stats.bytesDownloaded = platform->bytesDownloaded;
+    for (const auto& source : scene.tileSources()) {
+        stats.sourceBytesDownloaded.emplace_back(source->name(), source->bytesDownloaded());
+    }
+
+    stats.labels = uint32_t(scene.labelManager()->labelCount());
+    stats.visibleLabels = uint32_t(scene.labelManager()->visibleLabelCount());
+
+    stats.drawCalls = impl->renderState.drawCalls;
+
+    auto& usage = impl->memoryGovernor.update(scene);
+    stats.tileMemory = usage.bytes[MemoryGovernor::tiles];
+    stats.tileCacheMemory = usage.bytes[MemoryGovernor::tileCache];
+    stats.dataCacheMemory = usage.bytes[MemoryGovernor::dataCache];
+    stats.tileDataCacheMemory = usage.bytes[MemoryGovernor::tileDataCache];
+    stats.tileDataMemory = usage.bytes[MemoryGovernor::tileData];
+    stats.selectionMemory = usage.bytes[MemoryGovernor::selection];
+    stats.rasterMemory = usage.bytes[MemoryGovernor::rasters];
+    stats.rasterBufferMemory = usage.bytes[MemoryGovernor::rasterBuffers];
+    stats.glyphMemory = usage.bytes[MemoryGovernor::glyphs];
+    stats.markerMemory = usage.bytes[MemoryGovernor::markers];
+    stats.jsMemory = usage.bytes[MemoryGovernor::js];
+    stats.sceneConfigMemory = usage.bytes[MemoryGovernor::sceneConfig];
+    stats.meshBufferMemory = impl->renderState.bufferPool.stats().bytesUsed;
+
+    auto& renderTimes = impl->renderTimes;
+    for (size_t bucket = 0; bucket < TimeHistogram::numBuckets; bucket++) {
+        stats.frameTimeBounds.push_back(TimeHistogram::bound(bucket));
+        stats.frameTimeCounts.push_back(renderTimes.count(bucket));
+    }
+    stats.frameTimeAverage = renderTimes.average();
+    stats.frameTimeP95 = renderTimes.percentile(95);
+
+    auto& tileLatency = tileManager.tileLatency();
+    stats.tilesCompleted = tileLatency.total();
+    stats.tileLatencyAverage = tileLatency.average();
+    stats.tileLatencyP50 = tileLatency.percentile(50);
+    stats.tileLatencyP95 = tileLatency.percentile(95);
+
+    for (const auto& section : impl->renderState.gpuTimer.sections()) {
+        stats.gpuTimes.emplace_back(section.name, section.time);
+    }
+
+    return stats;
+}
+
 void Map::resize(int _newWidth, int _newHeight) {
   setViewport(0, 0, _newWidth, _newHeight);
 }
 
 void Map::setViewport(int _newX, int _newY, int _newWidth, int _newHeight) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setViewport", { double(_newX), double(_newY), double(_newWidth), double(_newHeight) }); }
 
     //LOGS("resize: %d x %d", _newWidth, _newHeight);
     LOGV("resize: %d x %d", _newWidth, _newHeight);
 
+    auto lock = impl->frameLock();
     impl->view.setViewport(_newX, _newY, _newWidth, _newHeight);
     // force texture (instead of render buffer) so drawDebug() works
     impl->selectionBuffer = std::make_unique<FrameBuffer>(_newWidth/2, _newHeight/2, false);
@@ -251,11 +617,117 @@ void Map::setViewport(int _newX, int _newY, int _newWidth, int _newHeight) {
 
 MapState Map::update(float _dt) {
 
+    impl->recording.addFrame(_dt);
+
+    if (!impl->threadedUpdate) {
+        return updateFrame(_dt);
+    }
+
+    // Let the update thread catch up with the time steps; the returned state is that of the last
+    // complete update
+    std::lock_guard<std::mutex> lock(impl->updateMutex);
+    impl->updateTime += _dt;
+    impl->updatePending = true;
+    impl->updateCondition.notify_one();
+    return impl->updateState;
+}
+
+void Map::setDynamicResolution(float _frameTime, float _minScale) {
+    impl->resolutionScaler.setBudget(_frameTime, _minScale);
+    platform->requestRender();
+}
+
+void Map::setTileRenderInterval(float _seconds) {
+    impl->tileRenderInterval = std::max(_seconds, 0.f);
+    impl->updateRenderInterval();
+}
+
+void Map::setMaxFrameRate(float _fps) {
+    impl->maxFrameRate = std::max(_fps, 0.f);
+    impl->updateRenderInterval();
+}
+
+void Map::Impl::updateRenderInterval() {
+    // Tiles do not request frames the cap would delay anyway
+    float interval = tileRenderInterval;
+    if (maxFrameRate > 0.f) { interval = std::max(interval, 1.f / maxFrameRate); }
+    renderScheduler.setInterval(interval);
+}
+
+void Map::setThreadedUpdate(bool _enabled) {
+    if (_enabled == impl->threadedUpdate) { return; }
+
+    if (_enabled) {
+        impl->updateThreadRunning = true;
+        impl->updateThread = std::thread(&Map::runUpdateThread, this);
+        impl->threadedUpdate = true;
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(impl->updateMutex);
+            impl->updateThreadRunning = false;
+        }
+        impl->updateCondition.notify_one();
+        impl->updateThread.join();
+        impl->threadedUpdate = false;
+    }
+}
+
+void Map::runUpdateThread() {
+    Trace::setThreadName("Update");
+    std::unique_lock<std::mutex> lock(impl->updateMutex);
+
+    while (true) {
+        impl->updateCondition.wait(lock, [&] {
+            return impl->updatePending || !impl->updateThreadRunning;
+        });
+        if (!impl->updateThreadRunning) { break; }
+
+        float dt = impl->updateTime;
+        impl->updateTime = 0.f;
+        impl->updatePending = false;
+        lock.unlock();
+
+        MapState state;
+        bool drawFrame;
+        {
+            std::lock_guard<std::recursive_mutex> frameLock(impl->frameMutex);
+            state = updateFrame(dt);
+            drawFrame = impl->frameChanged || impl->imageViewComplete;
+        }
+
+        // The platform decided on the next frame with the state of the previous update
+        if (drawFrame || (state.flags & (MapState::view_changing | MapState::is_animating))) {
+            platform->requestRender();
+        }
+
+        lock.lock();
+        impl->updateState = state;
+    }
+}
+
+MapState Map::updateFrame(float _dt) {
+
+    TRACE_SCOPE("update");
     FrameInfo::beginUpdate();
     FrameInfo::begin("Update");
 
     impl->jobQueue.runJobs();
 
+    // Move the view to the camera of the next image to render
+    if (!impl->imageRequests.empty() && !impl->imageViewSet) {
+        if (!impl->renderingImages) {
+            impl->renderingImages = true;
+            impl->imageRestoreCamera = getCameraPosition();
+            impl->imageRestoreViewport = impl->view.getViewport();
+        }
+        auto& request = impl->imageRequests.front();
+        if (impl->view.getWidth() != request.width || impl->view.getHeight() != request.height) {
+            setViewport(0, 0, request.width, request.height);
+        }
+        setCameraPosition(request.camera);
+        impl->imageViewSet = true;
+    }
+
     bool isEasing = impl->updateCameraEase(_dt);
     bool isFlinging = impl->inputHandler.update(_dt);
 
@@ -268,6 +740,9 @@ MapState Map::update(float _dt) {
     auto& scene = *impl->scene;
     bool wasReady = scene.isReady();
 
+    impl->frameChanged = true;
+    impl->viewMoving = false;
+
     if (!scene.completeScene(impl->view)) {
         state |= MapState::scene_loading;
 
@@ -277,7 +752,13 @@ MapState Map::update(float _dt) {
         bool firstUpdate = !wasReady;
         impl->syncClientTileSources(firstUpdate);
 
-        auto sceneState = scene.update(impl->renderState, impl->view, _dt);
+        scene.tileManager()->setLodScale(impl->tileLodScale);
+        impl->updatePrefetchViews();
+
+        // Terrain depth is rendered by render() on the GL thread while the update runs on its own
+        auto sceneState = scene.update(impl->renderState, impl->view, _dt, !impl->threadedUpdate);
+        impl->frameChanged = sceneState.changed;
+        impl->viewMoving = isEasing || isFlinging || sceneState.viewChanged;
 
         if (sceneState.animateLabels || sceneState.animateMarkers) {
             state |= MapState::labels_changing;
@@ -286,8 +767,16 @@ MapState Map::update(float _dt) {
         if (sceneState.tilesLoading) {
             state |= MapState::tiles_loading;
         }
+
+        // Measuring walks all tiles and markers, so the budget is applied only every few frames
+        if (impl->memoryGovernor.budget() > 0 && ++impl->memoryFrames >= 16) {
+            impl->memoryFrames = 0;
+            impl->memoryGovernor.update(scene);
+        }
     }
 
+    impl->imageViewComplete = impl->imageViewSet && state == MapState::view_complete;
+
     FrameInfo::endUpdate();
     FrameInfo::end("Update");
 
@@ -296,12 +785,34 @@ MapState Map::update(float _dt) {
 
 void Map::render() {
 
+    // Hold frames back to the frame cap, outside of the frame lock so that updates go on
+    auto now = std::chrono::steady_clock::now();
+    float waitTime = 0.f;
+    if (impl->maxFrameRate > 0.f) {
+        auto next = impl->lastFrameTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(1.f / impl->maxFrameRate));
+        if (now < next) {
+            std::this_thread::sleep_until(next);
+            waitTime = std::chrono::duration<float>(next - now).count();
+            now = std::chrono::steady_clock::now();
+        }
+    }
+
+    auto frameLock = impl->frameLock();
+
+    Trace::setThreadName("Render");
+    TRACE_SCOPE("render");
+
     auto& scene = *impl->scene;
     auto& view = impl->view;
     auto& renderState = impl->renderState;
 
     glm::vec4 viewport = view.getViewport();
 
+    // Time spent waiting for the frame cap is not taken by the frame
+    float frameTime = std::chrono::duration<float>(now - impl->lastFrameTime).count() - waitTime;
+    impl->lastFrameTime = now;
+
     // Delete batch of gl resources
     renderState.flushResourceDeletion();
 
@@ -320,26 +831,116 @@ void Map::render() {
         return;
     }
 
+    // Times every frame drawing the scene, whichever way it returns
+    struct RenderTimer {
+        TimeHistogram& times;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        ~RenderTimer() {
+            times.add(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    } renderTimer{impl->renderTimes};
+    renderState.drawCalls = 0;
+    renderState.gpuTimer.setEnabled(impl->gpuTiming || getDebugFlag(DebugFlags::tangram_infos));
+    renderState.gpuTimer.beginFrame();
+
     Primitives::setResolution(renderState, view.getWidth(), view.getHeight());
     FrameInfo::beginFrame();
 
+    if (impl->threadedUpdate) {
+        scene.renderTerrainDepth(renderState, view);
+    }
+
     scene.renderBeginFrame(renderState);
 
+    // Resolve selection queries of previous frames whose pixels have arrived
+    auto& pending = impl->pendingSelections;
+    for (auto it = pending.begin(); it != pending.end();) {
+        FrameBuffer::PixelRect pixels;
+        if (impl->selectionReadback.poll(it->slot, pixels)) {
+            scene.resolveSelection(view, *impl->selectionBuffer, pixels, it->queries);
+            it = pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     // Render feature selection pass to offscreen framebuffer
+    bool asyncSelection = Hardware::supportsAsyncReadback;
     bool drawSelectionDebug = getDebugFlag(DebugFlags::selection_buffer);
     bool drawDepthDebug = scene.elevationManager() && getDebugFlag(DebugFlags::depth_buffer);
-    bool drawSelectionBuffer = !impl->selectionQueries.empty();
+    // Queries wait for the next frame while all reads are in flight
+    bool drawSelectionBuffer = !impl->selectionQueries.empty() &&
+        (!asyncSelection || impl->selectionReadback.inFlight() < PixelReadback::SLOTS);
 
     if (drawSelectionBuffer || drawSelectionDebug) {
         impl->selectionBuffer->applyAsRenderTarget(impl->renderState);
 
-        scene.renderSelection(renderState, view,
-                              *impl->selectionBuffer,
-                              impl->selectionQueries);
+        scene.renderSelection(renderState, view);
+    }
+
+    if (drawSelectionBuffer) {
+        // Read the rect containing all queries of the frame at once
+        FrameBuffer::PixelRect rect;
+        for (const auto& query : impl->selectionQueries) {
+            rect = SelectionQuery::unite(rect, query.rect(view, *impl->selectionBuffer));
+        }
 
+        if (asyncSelection) {
+            int slot = impl->selectionReadback.start(rect);
+            pending.push_back({ slot, std::move(impl->selectionQueries) });
+        } else {
+            impl->selectionBuffer->readRect(rect);
+            scene.resolveSelection(view, *impl->selectionBuffer, rect, impl->selectionQueries);
+        }
         impl->selectionQueries.clear();
     }
 
+    if (!pending.empty() || !impl->selectionQueries.empty()) {
+        platform->requestRender();
+    }
+
+    // Pass images of previous frames whose pixels have arrived
+    auto& pendingImages = impl->pendingImages;
+    for (auto it = pendingImages.begin(); it != pendingImages.end();) {
+        FrameBuffer::PixelRect pixels;
+        if (impl->imageReadback.poll(it->slot, pixels)) {
+            auto& request = it->request;
+            request.callback(pixels.pixels.data(), request.width, request.height);
+            it = pendingImages.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Pass snapshots of previous frames whose pixels have arrived
+    auto& pendingSnapshots = impl->pendingSnapshots;
+    for (auto it = pendingSnapshots.begin(); it != pendingSnapshots.end();) {
+        FrameBuffer::PixelRect pixels;
+        if (impl->snapshotReadback.poll(it->slot, pixels)) {
+            it->request.callback(pixels.pixels.empty() ? nullptr : pixels.pixels.data(),
+                                 pixels.width, pixels.height);
+            it = pendingSnapshots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Render the next image instead of the frame once its view is complete; it waits for the
+    // next frame while all reads are in flight
+    if (impl->imageViewComplete &&
+        (!Hardware::supportsAsyncReadback || impl->imageReadback.inFlight() < PixelReadback::SLOTS)) {
+        renderImage();
+        renderState.bindDefaultVertexArray();
+        platform->requestRender();
+        return;
+    }
+    if (!pendingImages.empty()) {
+        platform->requestRender();
+    }
+
+    // Render impostors of distant tiles into their textures before the frame target is bound
+    scene.renderImpostors(renderState, view);
+
     // Get background color for frame based on zoom level, if there are stops
     impl->background = (drawSelectionDebug || drawDepthDebug) ?
             Color(0, 0, 0, 255) : scene.backgroundColor(view.getIntegerZoom());
@@ -353,8 +954,36 @@ void Map::render() {
     } else if (drawDepthDebug) {
         scene.elevationManager()->drawDepthDebug(renderState, view);
     } else {
-        // Render scene
-        bool drawnAnimatedStyle = scene.render(renderState, view);
+        // Render scene, while the view moves and frames take too long into a target of lower
+        // resolution which is scaled to the view; labels are drawn over it at full resolution
+        bool drawnAnimatedStyle;
+        float scale = impl->resolutionScaler.update(frameTime, impl->viewMoving);
+        auto& scaledBuffer = impl->scaledBuffer;
+        if (scale < 1.f) {
+            int width = std::max(1, int(viewport.z * scale));
+            int height = std::max(1, int(viewport.w * scale));
+            if (!scaledBuffer || scaledBuffer->getWidth() != width || scaledBuffer->getHeight() != height) {
+                scaledBuffer = std::make_unique<FrameBuffer>(width, height, false, GL_RGBA8, true);
+            }
+        } else {
+            scaledBuffer.reset();
+        }
+
+        if (scaledBuffer && scaledBuffer->applyAsRenderTarget(renderState, impl->background.toColorF())) {
+            drawnAnimatedStyle = scene.render(renderState, view, Scene::RenderPass::scene);
+
+            renderState.framebuffer(renderState.defaultFrameBuffer());
+            renderState.viewport(viewport.x, viewport.y, viewport.z, viewport.w);
+            renderState.blending(GL_FALSE);
+            scaledBuffer->drawTexture(renderState, {viewport.z, viewport.w});
+
+            drawnAnimatedStyle |= scene.render(renderState, view, Scene::RenderPass::labels);
+
+            // Draw the view at full resolution once it stops
+            platform->requestRender();
+        } else {
+            drawnAnimatedStyle = scene.render(renderState, view);
+        }
 
         if (scene.animated() != Scene::animate::no &&
             drawnAnimatedStyle != platform->isContinuousRendering()) {
@@ -366,8 +995,32 @@ void Map::render() {
 
     FrameInfo::draw(renderState, view, *this);
 
-    // if almost out of font atlas textures, reset
-    if (scene.fontContext()->glyphTextureCount() > FontContext::max_textures - 2) {
+    // The VAO of the last mesh is left bound, see RenderState::vertexArray()
+    renderState.bindDefaultVertexArray();
+
+    if (!impl->snapshotRequests.empty()) {
+        captureSnapshots();
+    }
+    if (!pendingSnapshots.empty() || !impl->snapshotRequests.empty()) {
+        platform->requestRender();
+    }
+
+    auto& fontContext = *scene.fontContext();
+    if (fontContext.takeRetiredAtlas()) {
+        // Glyphs moved on to a new atlas: rebuild labels, showing the current tiles until their
+        // replacement is ready; the old atlas pages are released with the last labels using them
+        std::vector<bool> labelStyles(scene.styles().size());
+        for (auto& style : scene.styles()) {
+            if (style->type() == StyleType::text || style->type() == StyleType::point) {
+                labelStyles[style->getID()] = true;
+            }
+        }
+        scene.tileManager()->rebuildStyles(labelStyles);
+        scene.markerManager()->clearMeshes();
+        platform->requestRender();
+
+    } else if (fontContext.atlasExhausted()) {
+        // if out of font atlas textures, reset
         LOGW("Rebuilding tiles due to font atlas exhaustion!");
         scene.tileManager()->clearTileSets();
         scene.markerManager()->clearMeshes();
@@ -393,6 +1046,139 @@ void Map::captureSnapshot(unsigned int* _data) {
                    GL_UNSIGNED_BYTE, (GLvoid*)_data);
 }
 
+void Map::captureSnapshotAsync(ImageReadyCallback _callback, int _x, int _y, int _width,
+                               int _height, float _scale) {
+    impl->snapshotRequests.push_back({ _x, _y, _width, _height, _scale, std::move(_callback) });
+    platform->requestRender();
+}
+
+void Map::captureSnapshots() {
+    auto& view = impl->view;
+    auto& renderState = impl->renderState;
+    auto& requests = impl->snapshotRequests;
+    bool async = Hardware::supportsAsyncReadback;
+    glm::vec4 viewport = view.getViewport();
+    int viewWidth = view.getWidth();
+    int viewHeight = view.getHeight();
+
+    // Requests wait for the next frame while all reads are in flight
+    size_t count = 0;
+    for (; count < requests.size(); count++) {
+        if (async && impl->snapshotReadback.inFlight() >= PixelReadback::SLOTS) { break; }
+        auto& request = requests[count];
+
+        // Rect in framebuffer pixels from the bottom left, clamped to the view
+        int x = std::clamp(request.x, 0, viewWidth);
+        int y = std::clamp(request.y, 0, viewHeight);
+        int width = viewWidth - x;
+        int height = viewHeight - y;
+        if (request.width > 0 && request.height > 0) {
+            width = std::min(width, request.width);
+            height = std::min(height, request.height);
+        }
+        if (width <= 0 || height <= 0) {
+            request.callback(nullptr, 0, 0);
+            continue;
+        }
+
+        FrameBuffer::PixelRect rect;
+        rect.left = int(viewport.x) + x;
+        rect.bottom = int(viewport.y) + viewHeight - y - height;
+        rect.width = width;
+        rect.height = height;
+
+        renderState.framebuffer(renderState.defaultFrameBuffer());
+
+        // Blits are available with asynchronous readback, both require GL 3
+        float scale = std::clamp(request.scale, 0.f, 1.f);
+        int scaledWidth = std::max(1, int(std::round(width * scale)));
+        int scaledHeight = std::max(1, int(std::round(height * scale)));
+        if (async && (scaledWidth < width || scaledHeight < height)) {
+            auto& buffer = impl->snapshotBuffer;
+            if (!buffer || buffer->getWidth() != scaledWidth || buffer->getHeight() != scaledHeight) {
+                buffer = std::make_unique<FrameBuffer>(scaledWidth, scaledHeight);
+            }
+            if (buffer->applyAsRenderTarget(renderState)) {
+                GL::bindFramebuffer(GL_READ_FRAMEBUFFER, renderState.defaultFrameBuffer());
+                GL::blitFramebuffer(rect.left, rect.bottom, rect.left + width, rect.bottom + height,
+                                    0, 0, scaledWidth, scaledHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+                GL::bindFramebuffer(GL_READ_FRAMEBUFFER, buffer->getHandle());
+                rect.left = rect.bottom = 0;
+                rect.width = scaledWidth;
+                rect.height = scaledHeight;
+            } else {
+                LOGW("Could not create framebuffer of %dx%d pixels for snapshot, reading at full scale",
+                     scaledWidth, scaledHeight);
+                renderState.framebuffer(renderState.defaultFrameBuffer());
+            }
+        }
+
+        if (async) {
+            int slot = impl->snapshotReadback.start(rect);
+            impl->pendingSnapshots.push_back({ slot, std::move(request) });
+        } else {
+            rect.pixels.resize(size_t(rect.width) * rect.height);
+            GL::readPixels(rect.left, rect.bottom, rect.width, rect.height, GL_RGBA,
+                           GL_UNSIGNED_BYTE, rect.pixels.data());
+            request.callback(rect.pixels.data(), rect.width, rect.height);
+        }
+    }
+    requests.erase(requests.begin(), requests.begin() + count);
+}
+
+void Map::renderToImage(const CameraPosition& _camera, int _width, int _height,
+                        ImageReadyCallback _callback) {
+    if (_width <= 0 || _height <= 0) {
+        _callback(nullptr, _width, _height);
+        return;
+    }
+    impl->imageRequests.push_back({ _camera, _width, _height, std::move(_callback) });
+    platform->requestRender();
+}
+
+void Map::renderImage() {
+    auto& scene = *impl->scene;
+    auto& view = impl->view;
+    auto& renderState = impl->renderState;
+
+    auto request = std::move(impl->imageRequests.front());
+    impl->imageRequests.pop_front();
+    impl->imageViewSet = false;
+    impl->imageViewComplete = false;
+
+    auto& buffer = impl->imageBuffer;
+    if (!buffer || buffer->getWidth() != request.width || buffer->getHeight() != request.height) {
+        buffer = std::make_unique<FrameBuffer>(request.width, request.height);
+    }
+
+    Color background = scene.backgroundColor(view.getIntegerZoom());
+    if (!buffer->applyAsRenderTarget(renderState, background.toColorF())) {
+        LOGE("Could not create framebuffer of %dx%d pixels for image", request.width, request.height);
+        request.callback(nullptr, request.width, request.height);
+    } else {
+        scene.render(renderState, view);
+
+        FrameBuffer::PixelRect rect;
+        rect.width = request.width;
+        rect.height = request.height;
+        if (Hardware::supportsAsyncReadback) {
+            int slot = impl->imageReadback.start(rect);
+            impl->pendingImages.push_back({ slot, std::move(request) });
+        } else {
+            buffer->readRect(rect);
+            request.callback(rect.pixels.data(), request.width, request.height);
+        }
+    }
+
+    if (impl->imageRequests.empty() && impl->renderingImages) {
+        // Back to the view before the first image
+        impl->renderingImages = false;
+        auto& viewport = impl->imageRestoreViewport;
+        setViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+        setCameraPosition(impl->imageRestoreCamera);
+    }
+}
+
 CameraPosition Map::getCameraPosition(bool force2D) {
     CameraPosition camera;
 
@@ -414,6 +1200,8 @@ void Map::cancelCameraAnimation() {
     impl->inputHandler.cancelFling();
 
     impl->ease.reset();
+    impl->easeView = nullptr;
+    impl->prefetchEaseEnd = false;
 
     if (impl->cameraAnimationListener) {
         impl->cameraAnimationListener(false);
@@ -421,6 +1209,9 @@ void Map::cancelCameraAnimation() {
 }
 
 void Map::setCameraPosition(const CameraPosition& _camera) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setCameraPosition", cameraNumbers(_camera)); }
+
     cancelCameraAnimation();
 
     impl->view.setZoom(_camera.zoom);
@@ -496,23 +1287,40 @@ CameraEase Map::Impl::getCameraEase(const CameraPosition& _camera) {
 }
 
 void Map::setCameraPositionEased(const CameraPosition& _camera, float _duration, EaseType _e) {
+    Impl::RecordScope record(*impl);
+    if (record()) {
+        auto numbers = cameraNumbers(_camera);
+        numbers.insert(numbers.end(), { _duration, double(_e) });
+        impl->recording.addCall("setCameraPositionEased", std::move(numbers));
+    }
+
     cancelCameraAnimation();
 
     CameraEase e = impl->getCameraEase(_camera);
 
-    impl->ease = std::make_unique<Ease>(_duration,
-        [=](float t) {
-            impl->view.setPosition(ease(e.start.pos.x, e.end.pos.x, t, _e),
-                                   ease(e.start.pos.y, e.end.pos.y, t, _e));
-            impl->view.setBaseZoom(ease(e.start.zoom, e.end.zoom, t, _e));
-            impl->view.setYaw(ease(e.start.rotation, e.end.rotation, t, _e));
-            impl->view.setPitch(ease(e.start.tilt, e.end.tilt, t, _e));
-        });
+    auto apply =
+        [=](View& view, float t) {
+            view.setPosition(ease(e.start.pos.x, e.end.pos.x, t, _e),
+                             ease(e.start.pos.y, e.end.pos.y, t, _e));
+            view.setBaseZoom(ease(e.start.zoom, e.end.zoom, t, _e));
+            view.setYaw(ease(e.start.rotation, e.end.rotation, t, _e));
+            view.setPitch(ease(e.start.tilt, e.end.tilt, t, _e));
+        };
+
+    impl->easeView = apply;
+    impl->ease = std::make_unique<Ease>(_duration, [=](float t) { apply(impl->view, t); });
 
     platform->requestRender();
 }
 
 void Map::flyTo(const CameraPosition& _camera, float _duration, float _speed) {
+    Impl::RecordScope record(*impl);
+    if (record()) {
+        auto numbers = cameraNumbers(_camera);
+        numbers.insert(numbers.end(), { _duration, _speed });
+        impl->recording.addCall("flyTo", std::move(numbers));
+    }
+
     cancelCameraAnimation();
 
     CameraEase e = impl->getCameraEase(_camera);
@@ -521,19 +1329,24 @@ void Map::flyTo(const CameraPosition& _camera, float _duration, float _speed) {
     glm::dvec3 xyz0(e.start.pos, e.start.zoom), xyz1(e.end.pos, e.end.zoom);
     auto fn = getFlyToFunction(impl->view, xyz0, xyz1, distance);
 
-    auto cb =
-        [=](float t) {
+    auto apply =
+        [=](View& view, float t) {
             glm::dvec3 pos = fn(t);
-            impl->view.setPosition(pos.x, pos.y);
-            impl->view.setBaseZoom(pos.z);
-            impl->view.setYaw(ease(e.start.rotation, e.end.rotation, t, EaseType::cubic));
-            impl->view.setPitch(ease(e.start.tilt, e.end.tilt, t, EaseType::cubic));
-            impl->platform.requestRender();
+            view.setPosition(pos.x, pos.y);
+            view.setBaseZoom(pos.z);
+            view.setYaw(ease(e.start.rotation, e.end.rotation, t, EaseType::cubic));
+            view.setPitch(ease(e.start.tilt, e.end.tilt, t, EaseType::cubic));
         };
 
     float duration = _duration >= 0 ? _duration : (distance / (_speed > 0 ? _speed : 1.f));
 
-    impl->ease = std::make_unique<Ease>(duration, cb);
+    impl->easeView = apply;
+    // load destination tiles while flying so that they are ready on arrival
+    impl->prefetchEaseEnd = true;
+    impl->ease = std::make_unique<Ease>(duration, [=](float t) {
+        apply(impl->view, t);
+        impl->platform.requestRender();
+    });
 
     platform->requestRender();
 }
@@ -548,11 +1361,41 @@ bool Map::Impl::updateCameraEase(float _dt) {
             cameraAnimationListener(true);
         }
         ease.reset();
+        easeView = nullptr;
+        prefetchEaseEnd = false;
         return false;
     }
     return true;
 }
 
+void Map::Impl::updatePrefetchViews() {
+
+    std::vector<View> views;
+
+    if (prefetchTime > 0.f) {
+        if (ease && easeView && ease->d > 0.f) {
+            float t = std::fmax(ease->t, 0.f);
+            View next = view;
+            easeView(next, std::fmin(1.f, (t + prefetchTime) / ease->d));
+            views.push_back(next);
+            if (prefetchEaseEnd) {
+                View end = view;
+                easeView(end, 1.f);
+                views.push_back(end);
+            }
+        } else {
+            View next = view;
+            if (inputHandler.predictView(next, prefetchTime)) {
+                views.push_back(next);
+            }
+        }
+    }
+
+    for (auto& v : views) { v.update(); }
+
+    scene->tileManager()->setPrefetchViews(std::move(views));
+}
+
 void Map::updateCameraPosition(const CameraUpdate& _update, float _duration, EaseType _e) {
 
     CameraPosition camera{};
@@ -597,6 +1440,8 @@ void Map::updateCameraPosition(const CameraUpdate& _update, float _duration, Eas
 }
 
 void Map::setPosition(double _lon, double _lat) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setPosition", { _lon, _lat }); }
     cancelCameraAnimation();
 
     bool elevOk;
@@ -612,6 +1457,8 @@ void Map::getPosition(double& _lon, double& _lat) {
 }
 
 void Map::setZoom(float _z) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setZoom", { _z }); }
     cancelCameraAnimation();
 
     impl->view.setZoom(_z);
@@ -639,6 +1486,8 @@ float Map::getMaxZoom() const {
 }
 
 void Map::setRotation(float _radians) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setRotation", { _radians }); }
     cancelCameraAnimation();
 
     impl->view.setYaw(_radians);
@@ -650,6 +1499,8 @@ float Map::getRotation() {
 }
 
 void Map::setTilt(float _radians) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setTilt", { _radians }); }
     cancelCameraAnimation();
 
     impl->view.setPitch(_radians);
@@ -730,6 +1581,8 @@ bool Map::lngLatToScreenPosition(double _lng, double _lat, double* _x, double* _
 }
 
 void Map::setPixelScale(float _pixelsPerPoint) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setPixelScale", { _pixelsPerPoint }); }
     impl->setPixelScale(_pixelsPerPoint);
 }
 
@@ -746,6 +1599,8 @@ void Map::Impl::setPixelScale(float _pixelsPerPoint) {
 }
 
 void Map::setCameraType(int _type) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("setCameraType", { double(_type) }); }
     impl->view.setCameraType(static_cast<CameraType>(_type));
     platform->requestRender();
 }
@@ -816,34 +1671,87 @@ void Map::Impl::syncClientTileSources(bool _firstUpdate) {
 }
 
 MarkerID Map::markerAdd() {
-    return impl->scene->markerManager()->add();
+    MarkerID marker = impl->scene->markerManager()->add();
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerAdd", { double(marker) }); }
+    return marker;
 }
 
 bool Map::markerRemove(MarkerID _marker) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerRemove", { double(_marker) }); }
     bool success = impl->scene->markerManager()->remove(_marker);
     platform->requestRender();
     return success;
 }
 
 bool Map::markerSetPoint(MarkerID _marker, LngLat _lngLat) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetPoint", { double(_marker), _lngLat.longitude, _lngLat.latitude }); }
     bool success = impl->scene->markerManager()->setPoint(_marker, _lngLat);
     platform->requestRender();
     return success;
 }
 
 bool Map::markerSetPointEased(MarkerID _marker, LngLat _lngLat, float _duration, EaseType ease) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetPointEased", { double(_marker), _lngLat.longitude, _lngLat.latitude, _duration, double(ease) }); }
     bool success = impl->scene->markerManager()->setPointEased(_marker, _lngLat, _duration, ease);
     platform->requestRender();
     return success;
 }
 
+void Map::markerAddPoints(const char* _styling, bool _isPath, const LngLat* _coordinates,
+                          Properties* _properties, int _count, MarkerID* _markers) {
+    impl->scene->markerManager()->addPoints(_styling, _isPath, _coordinates, _properties, _count, _markers);
+    platform->requestRender();
+}
+
+int Map::markerSetPoints(const MarkerID* _markers, const LngLat* _coordinates, Properties* _properties,
+                         int _count) {
+    int updated = impl->scene->markerManager()->setPoints(_markers, _coordinates, _properties, _count);
+    platform->requestRender();
+    return updated;
+}
+
 bool Map::markerSetPolyline(MarkerID _marker, LngLat* _coordinates, int _count) {
+    Impl::RecordScope record(*impl);
+    if (record()) {
+        std::vector<double> numbers{ double(_marker) };
+        for (int i = 0; i < _count; i++) {
+            numbers.insert(numbers.end(), { _coordinates[i].longitude, _coordinates[i].latitude });
+        }
+        impl->recording.addCall("markerSetPolyline", std::move(numbers));
+    }
     bool success = impl->scene->markerManager()->setPolyline(_marker, _coordinates, _count);
     platform->requestRender();
     return success;
 }
 
+bool Map::markerSetPolylineTrim(MarkerID _marker, int _index, float _fraction) {
+    Impl::RecordScope record(*impl);
+    if (record()) {
+        impl->recording.addCall("markerSetPolylineTrim", { double(_marker), double(_index), double(_fraction) });
+    }
+    bool success = impl->scene->markerManager()->setPolylineTrim(_marker, _index, _fraction);
+    platform->requestRender();
+    return success;
+}
+
 bool Map::markerSetPolygon(MarkerID _marker, LngLat* _coordinates, int* _counts, int _rings) {
+    Impl::RecordScope record(*impl);
+    if (record()) {
+        std::vector<double> numbers{ double(_marker), double(_rings) };
+        int points = 0;
+        for (int i = 0; i < _rings; i++) {
+            numbers.push_back(_counts[i]);
+            points += _counts[i];
+        }
+        for (int i = 0; i < points; i++) {
+            numbers.insert(numbers.end(), { _coordinates[i].longitude, _coordinates[i].latitude });
+        }
+        impl->recording.addCall("markerSetPolygon", std::move(numbers));
+    }
     bool success = impl->scene->markerManager()->setPolygon(_marker, _coordinates, _counts, _rings);
     platform->requestRender();
     return success;
@@ -856,18 +1764,24 @@ bool Map::markerSetProperties(MarkerID _marker, Properties&& _properties) {
 }
 
 bool Map::markerSetAlternate(MarkerID _marker, MarkerID _alt) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetAlternate", { double(_marker), double(_alt) }); }
     bool success = impl->scene->markerManager()->setAlternate(_marker, _alt);
     platform->requestRender();
     return success;
 }
 
 bool Map::markerSetStylingFromString(MarkerID _marker, const char* _styling) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetStylingFromString", { double(_marker) }, { _styling }); }
     bool success = impl->scene->markerManager()->setStylingFromString(_marker, _styling);
     platform->requestRender();
     return success;
 }
 
 bool Map::markerSetStylingFromPath(MarkerID _marker, const char* _path) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetStylingFromPath", { double(_marker) }, { _path }); }
     bool success = impl->scene->markerManager()->setStylingFromPath(_marker, _path);
     platform->requestRender();
     return success;
@@ -880,18 +1794,24 @@ bool Map::markerSetBitmap(MarkerID _marker, int _width, int _height, const unsig
 }
 
 bool Map::markerSetVisible(MarkerID _marker, bool _visible) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetVisible", { double(_marker), double(_visible) }); }
     bool success = impl->scene->markerManager()->setVisible(_marker, _visible);
     platform->requestRender();
     return success;
 }
 
 bool Map::markerSetDrawOrder(MarkerID _marker, int _drawOrder) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerSetDrawOrder", { double(_marker), double(_drawOrder) }); }
     bool success = impl->scene->markerManager()->setDrawOrder(_marker, _drawOrder);
     platform->requestRender();
     return success;
 }
 
 void Map::markerRemoveAll() {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("markerRemoveAll", {}); }
     impl->scene->markerManager()->removeAll();
     platform->requestRender();
 }
@@ -900,7 +1820,27 @@ void Map::setPickRadius(float _radius) {
     impl->pickRadius = _radius;
 }
 
+void Map::setTilePrefetchTime(float _seconds) {
+    impl->prefetchTime = std::max(_seconds, 0.f);
+}
+
+void Map::setTileLodScale(float _scale) {
+    // Tiles covering less than one tile size on screen would be too blurry
+    impl->tileLodScale = std::max(_scale, 1.f);
+}
+
 void Map::pickFeatureAt(float _x, float _y, FeaturePickCallback _onFeaturePickCallback) {
+    // With a pick index for each tile the feature is found without rendering the selection buffer
+    if (impl->scene->options().cpuPicking && impl->scene->isReady()) {
+        auto props = impl->scene->tileManager()->pickFeature(impl->view, {_x, _y}, impl->pickRadius);
+        if (props) {
+            FeaturePickResult result(props, {{_x, _y}});
+            _onFeaturePickCallback(&result);
+        } else {
+            _onFeaturePickCallback(nullptr);
+        }
+        return;
+    }
     impl->selectionQueries.push_back({{_x, _y}, impl->pickRadius, _onFeaturePickCallback});
     platform->requestRender();
 }
@@ -911,11 +1851,21 @@ void Map::pickLabelAt(float _x, float _y, LabelPickCallback _onLabelPickCallback
 }
 
 void Map::pickMarkerAt(float _x, float _y, MarkerPickCallback _onMarkerPickCallback) {
+    // Markers hit by their geometry are found without reading back the selection buffer
+    if (auto* marker = impl->scene->markerManager()->pickMarker(impl->view, {_x, _y},
+                                                                 impl->pickRadius * impl->view.pixelScale())) {
+        LngLat lngLat = MapProjection::projectedMetersToLngLat(marker->bounds().center()).wrapped();
+        MarkerPickResult result(marker->id(), lngLat, {{_x, _y}});
+        _onMarkerPickCallback(&result);
+        return;
+    }
     impl->selectionQueries.push_back({{_x, _y}, impl->pickRadius, _onMarkerPickCallback});
     platform->requestRender();
 }
 
 void Map::handleTapGesture(float _posX, float _posY) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handleTapGesture", { _posX, _posY }); }
     cancelCameraAnimation();
     impl->inputHandler.handleTapGesture(_posX, _posY);
     impl->platform.requestRender();
@@ -925,6 +1875,8 @@ void Map::handleDoubleTapGesture(float _posX, float _posY) {
     handleDoubleTapGesture(_posX, _posY, false);
 }
 void Map::handleDoubleTapGesture(float _posX, float _posY, bool _zoomOut) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handleDoubleTapGesture", { _posX, _posY, double(_zoomOut) }); }
     cancelCameraAnimation();
     // We want tapped map position to remain at same screen position throughout zoom; using a camera ease
     //  gives correct final state but causes tapped position to wobble during zoom.
@@ -939,36 +1891,48 @@ void Map::handleDoubleTapGesture(float _posX, float _posY, bool _zoomOut) {
 }
 
 void Map::handlePanGesture(float _startX, float _startY, float _endX, float _endY) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handlePanGesture", { _startX, _startY, _endX, _endY }); }
     cancelCameraAnimation();
     impl->inputHandler.handlePanGesture(_startX, _startY, _endX, _endY);
     impl->platform.requestRender();
 }
 
 void Map::handleFlingGesture(float _posX, float _posY, float _velocityX, float _velocityY) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handleFlingGesture", { _posX, _posY, _velocityX, _velocityY }); }
     cancelCameraAnimation();
     impl->inputHandler.handleFlingGesture(_posX, _posY, _velocityX, _velocityY);
     impl->platform.requestRender();
 }
 
 void Map::handlePinchGesture(float _posX, float _posY, float _scale, float _velocity) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handlePinchGesture", { _posX, _posY, _scale, _velocity }); }
     cancelCameraAnimation();
     impl->inputHandler.handlePinchGesture(_posX, _posY, _scale, _velocity);
     impl->platform.requestRender();
 }
 
 void Map::handleRotateGesture(float _posX, float _posY, float _radians) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handleRotateGesture", { _posX, _posY, _radians }); }
     cancelCameraAnimation();
     impl->inputHandler.handleRotateGesture(_posX, _posY, _radians);
     impl->platform.requestRender();
 }
 
 void Map::handleShoveGesture(float _distance) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handleShoveGesture", { _distance }); }
     cancelCameraAnimation();
     impl->inputHandler.handleShoveGesture(_distance);
     impl->platform.requestRender();
 }
 
 void Map::handleTouchEvent(int action, float x1, float y1, float x2, float y2) {
+    Impl::RecordScope record(*impl);
+    if (record()) { impl->recording.addCall("handleTouchEvent", { double(action), x1, y1, x2, y2 }); }
     cancelCameraAnimation();
     ScreenPos pos1(x1, y1);
     ScreenPos pos2(x2, y2);
@@ -1038,10 +2002,42 @@ void Map::setupGL() {
 
     LOG("setup GL");
 
+    auto lock = impl->frameLock();
+
     impl->renderState.invalidate();
 
-    //impl->scene->tileManager()->clearTileSets();
+    // Reads in flight are lost with the context, run their queries again
+    impl->selectionReadback.invalidate();
+    for (auto& selection : impl->pendingSelections) {
+        impl->selectionQueries.insert(impl->selectionQueries.end(), selection.queries.begin(),
+                                      selection.queries.end());
+    }
+    impl->pendingSelections.clear();
+    impl->imageReadback.invalidate();
+    for (auto it = impl->pendingImages.rbegin(); it != impl->pendingImages.rend(); ++it) {
+        impl->imageRequests.push_front(std::move(it->request));
+    }
+    impl->pendingImages.clear();
+    impl->imageBuffer.reset();
+    impl->snapshotReadback.invalidate();
+    for (auto& snapshot : impl->pendingSnapshots) {
+        impl->snapshotRequests.push_back(std::move(snapshot.request));
+    }
+    impl->pendingSnapshots.clear();
+    impl->snapshotBuffer.reset();
+    impl->scaledBuffer.reset();
+    impl->imageViewSet = false;
+    impl->imageViewComplete = false;
+    if (auto* elevationManager = impl->scene->elevationManager()) {
+        elevationManager->invalidateDepthReadback();
+    }
+
+    // After context loss, meshes and textures with retained data are uploaded again on draw
+    if (impl->renderState.contextGeneration() > 1) {
+        impl->scene->tileManager()->reloadLostTiles();
+    }
     impl->scene->markerManager()->rebuildAll();
+    impl->scene->labelManager()->invalidateMeshes();
 
     if (impl->selectionBuffer->valid()) {
         impl->selectionBuffer = std::make_unique<FrameBuffer>(impl->selectionBuffer->getWidth(),
@@ -1054,22 +2050,51 @@ void Map::setupGL() {
     // Hardware::printAvailableExtensions();
 }
 
+void Map::setRetainedDataBudget(size_t _bytes) {
+    RetainedData::setBudget(_bytes);
+}
+
 void Map::useCachedGlState(bool _useCache) {
     impl->cacheGlState = _useCache;
 }
 
+void Map::queryElevations(std::vector<LngLat> _points, int _zoom, ElevationCallback _callback) {
+    std::vector<ProjectedMeters> meters(_points.size());
+    MapProjection::lngLatToProjectedMeters(_points.data(), meters.data(), _points.size());
+
+    auto* elevationManager = impl->scene ? impl->scene->elevationManager() : nullptr;
+    ElevationManager::ElevationBatch batch;
+    if (elevationManager) {
+        batch = elevationManager->prepareElevations(std::move(meters), _zoom);
+    } else {
+        batch.positions = std::move(meters);
+    }
+
+    if (!impl->asyncWorker) { return; }
+    impl->asyncWorker->enqueue([this, batch = std::move(batch), _callback]() mutable {
+        std::vector<double> elevations(batch.positions.size(), 0);
+        std::vector<uint8_t> ok(batch.positions.size(), 0);
+        batch.sample(elevations.data(), ok.data());
+        _callback(elevations, std::vector<bool>(ok.begin(), ok.end()));
+        // Textures must be released on the main thread, which owns the texture cache
+        impl->jobQueue.add([_batch = std::make_shared<ElevationManager::ElevationBatch>(std::move(batch))]() {});
+    });
+}
+
 void Map::runAsyncTask(std::function<void()> _task) {
     if (impl->asyncWorker) {
         impl->asyncWorker->enqueue(std::move(_task));
     }
 }
 
-void Map::onMemoryWarning() {
+void Map::onMemoryWarning(MemoryWarningLevel _level) {
     if(!impl->scene) return;
-    impl->scene->tileManager()->clearTileSets(true);
-    if (impl->scene->fontContext()) {
-        impl->scene->fontContext()->releaseFonts();
-    }
+    impl->memoryGovernor.trim(*impl->scene, _level);
+}
+
+void Map::setMemoryBudget(size_t _bytes) {
+    impl->memoryGovernor.setBudget(_bytes);
+    impl->memoryFrames = 16;
 }
 
 void Map::setDefaultBackgroundColor(float r, float g, float b) {
@@ -1105,4 +2130,12 @@ void toggleDebugFlag(DebugFlags _flag) {
     // }
 }
 
+void startTracing(size_t _eventsPerThread) {
+    Trace::start(_eventsPerThread);
+}
+
+std::string stopTracing() {
+    return Trace::stop();
+}
+
 }
@@ -0,0 +1,51 @@
+#include "mapContext.h"
+
+#include "data/memoryCacheDataSource.h"
+#include "data/tileDataCache.h"
+#include "tile/tileWorker.h"
+
+namespace Tangram {
+
+MapContext::MapContext(uint32_t _numTileWorkers, uint32_t _sharedTiles) :
+    m_numTileWorkers(_numTileWorkers),
+    m_tileDataCache(std::make_shared<TileDataCache>(_sharedTiles)) {}
+
+MapContext::~MapContext() {}
+
+void MapContext::setSharedTiles(uint32_t _sharedTiles) {
+    m_tileDataCache->setMaxEntries(_sharedTiles);
+}
+
+void MapContext::setSharedTilesSize(size_t _bytes) {
+    m_tileDataCache->setMaxBytes(_bytes);
+}
+
+std::shared_ptr<TileWorker> MapContext::tileWorker() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_tileWorker) {
+        m_tileWorker = std::make_shared<TileWorker>(m_numTileWorkers);
+    }
+    return m_tileWorker;
+}
+
+std::shared_ptr<RawCache> MapContext::rawCache(const std::string& _source, bool _compress) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Sources asking for compressed and uncompressed caches each get what they asked for
+    std::string key = (_compress ? "z|" : "|") + _source;
+    auto& cache = m_rawCaches[key];
+    if (!cache) {
+        cache = MemoryCacheDataSource::createCache(_compress);
+    }
+    return cache;
+}
+
+void MapContext::releaseUnusedCaches() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto it = m_rawCaches.begin(); it != m_rawCaches.end();) {
+        if (it->second.use_count() == 1) { it = m_rawCaches.erase(it); } else { ++it; }
+    }
+}
+
+}
@@ -26,25 +26,56 @@ void Marker::reset() {
     m_drawRule.reset();
     m_drawRuleSet.reset(new DrawRuleMergeSet());
     m_builtZoomLevel = -1;
+    m_revision++;
+}
+
+std::unique_ptr<Marker> Marker::copyForBuild() const {
+    if (!m_feature || !m_drawRule || m_texture) { return nullptr; }
+
+    auto copy = std::make_unique<Marker>(m_id);
+    copy->setBounds(m_bounds);
+    copy->m_feature = std::make_unique<Feature>(*m_feature);
+
+    // Params of the rule may point to values evaluated for this marker, so the copy gets its own
+    std::vector<StyleParam> params;
+    for (size_t i = 0; i < StyleParamKeySize; i++) {
+        if (m_drawRule->active[i]) { params.push_back(*m_drawRule->params[i].param); }
+    }
+    copy->setDrawRuleData(std::make_unique<DrawRuleData>(*m_drawRule->name, m_drawRule->id, std::move(params)));
+    return copy;
 }
 
 void Marker::setBounds(BoundingBox bounds) {
     m_bounds = bounds;
     m_origin = bounds.min; // South-West corner
+    m_ease.active = false;
+    m_transformChanged = true;
 }
 
 void Marker::setStyling(std::string styling, bool isPath) {
     m_styling.string = styling;
     m_styling.isPath = isPath;
     m_builtZoomLevel = -1;
+    m_revision++;
 }
 
 void Marker::setFeature(std::unique_ptr<Feature> feature) {
     m_feature = std::move(feature);
+    m_lineTrim = {};
+    m_revision++;
 }
 
 void Marker::setTexture(std::unique_ptr<Texture> texture) {
     m_texture = std::move(texture);
+    m_atlasRegion = 0;
+    m_revision++;
+}
+
+void Marker::setAtlasTexture(std::shared_ptr<Texture> texture, uint32_t regionId, const SpriteNode& sprite) {
+    m_texture = std::move(texture);
+    m_atlasRegion = regionId;
+    m_sprite = sprite;
+    m_revision++;
 }
 
 bool Marker::evaluateRuleForContext(StyleContext& ctx) {
@@ -89,21 +120,37 @@ void Marker::setMesh(uint32_t styleId, uint32_t zoom, std::unique_ptr<StyledMesh
         scale = extent();
     }
     m_modelMatrix = glm::scale(glm::vec3(scale));
+    m_transformChanged = true;
 }
 
 void Marker::clearMesh() {
     m_mesh.reset();
+    m_revision++;
 }
 
-void Marker::setEase(const glm::dvec2& dest, float duration, EaseType e) {
-    auto origin = m_origin;
-    auto cb = [=](float t) { m_origin = { ease(origin.x, dest.x, t, e), ease(origin.y, dest.y, t, e) }; };
-    m_ease = { duration, cb };
+std::unique_ptr<StyledMesh> Marker::takeMesh() {
+    return std::move(m_mesh);
 }
 
-void Marker::update(float dt, const View& view) {
+void Marker::setEase(const glm::dvec2& dest, float duration, EaseType e, float time) {
+    m_ease.start = m_origin;
+    m_ease.end = dest;
+    m_ease.startTime = time;
+    m_ease.duration = duration;
+    m_ease.type = e;
+    m_ease.active = true;
+}
+
+void Marker::update(float time, const View& view) {
     // Update easing
-    if (!m_ease.finished()) { m_ease.update(dt); }
+    if (m_ease.active) {
+        float t = m_ease.duration > 0.f ? (time - m_ease.startTime) / m_ease.duration : 1.f;
+        t = glm::clamp(t, 0.f, 1.f);
+        m_origin = { ease(m_ease.start.x, m_ease.end.x, t, m_ease.type),
+                     ease(m_ease.start.y, m_ease.end.y, t, m_ease.type) };
+        m_ease.active = t < 1.f;
+    }
+    m_transformChanged = false;
     // Apply marker-view translation to the model matrix
     auto relativeMeters = view.getRelativeMeters(m_origin);
     m_modelMatrix[3][0] = float(relativeMeters.x);
@@ -114,6 +161,8 @@ void Marker::update(float dt, const View& view) {
 
 void Marker::setVisible(bool visible) {
     m_visible = visible;
+    // not updated while hidden
+    m_transformChanged = true;
 }
 
 void Marker::setDrawOrder(int drawOrder) {
@@ -177,7 +226,7 @@ const glm::mat4& Marker::modelViewProjectionMatrix() const {
 }
 
 bool Marker::isEasing() const {
-    return !m_ease.finished();
+    return m_ease.active;
 }
 
 bool Marker::isVisible() const {
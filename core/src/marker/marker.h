@@ -1,5 +1,6 @@
 #pragma once
 
+#include "scene/spriteAtlas.h"
 #include "util/ease.h"
 #include "util/geom.h"
 #include "util/types.h"
@@ -39,6 +40,10 @@ public:
 
     void reset();
 
+    // Copy of the geometry and draw rule of this marker, to build its mesh on another thread while
+    // this marker is modified; null for markers with a bitmap or without geometry or styling.
+    std::unique_ptr<Marker> copyForBuild() const;
+
     // Set the axis-aligned bounding box for the feature geometry in Mercator meters;
     // The points in the feature for this Marker should be made relative to a coordinate system
     // whose origin is the South-West corner of the bounds and whose unit length is the
@@ -67,15 +72,26 @@ public:
 
     void clearMesh();
 
+    // Take the mesh, e.g. of a copy built on another thread
+    std::unique_ptr<StyledMesh> takeMesh();
+
     void setTexture(std::unique_ptr<Texture> texture);
 
-    // Set an ease for the origin of this marker in Mercator meters.
-    void setEase(const glm::dvec2& destination, float duration, EaseType ease);
+    // Set the bitmap to the region @regionId of the marker atlas @texture, drawn as @sprite
+    void setAtlasTexture(std::shared_ptr<Texture> texture, uint32_t regionId, const SpriteNode& sprite);
+
+    // Set an ease for the origin of this marker in Mercator meters, starting at @time from the
+    // current origin.
+    void setEase(const glm::dvec2& destination, float duration, EaseType ease, float time);
 
     void setSelectionColor(uint32_t selectionColor);
 
-    // Set the model matrix for the marker using the current view and update any eases.
-    void update(float dt, const View& view);
+    // Set the model matrix for the marker using the current view and update any ease to @time.
+    void update(float time, const View& view);
+
+    // Whether the model matrix changes without a change of the view, i.e. while easing or
+    // after the bounds or mesh changed.
+    bool needsUpdate() const { return m_transformChanged || isEasing(); }
 
     // Set whether this marker should be visible.
     void setVisible(bool visible);
@@ -108,6 +124,12 @@ public:
 
     Texture* texture() const;
 
+    // Region of the bitmap in the marker atlas, 0 for a bitmap with its own texture
+    uint32_t atlasRegion() const { return m_atlasRegion; }
+
+    // Part of the texture() of the bitmap and its size in display pixels, null for the whole texture
+    const SpriteNode* sprite() const { return m_atlasRegion ? &m_sprite : nullptr; }
+
     const BoundingBox& bounds() const;
 
     // Get the origin of the geometry for this marker, i.e. the South-West corner of the bounds.
@@ -120,12 +142,32 @@ public:
 
     const Styling& styling() const { return m_styling; }
 
+    // Incremented when the geometry, styling or bitmap of the marker changes
+    uint32_t revision() const { return m_revision; }
+
+    // Start of a polyline that is not drawn, see MarkerManager::setPolylineTrim()
+    struct LineTrim {
+        // Point and fraction of the segment after it where the line starts; an index < 0 trims nothing
+        int index = -1;
+        float fraction = 0.f;
+        // Distance along the line as built for @zoom, in marker units
+        float distance = 0.f;
+        int zoom = -1;
+    };
+    void setLineTrim(const LineTrim& trim) { m_lineTrim = trim; }
+    const LineTrim& lineTrim() const { return m_lineTrim; }
+
     bool evaluateRuleForContext(StyleContext& ctx);
 
     bool isEasing() const;
 
     bool isVisible() const;
 
+    // Whether the marker is near the view, as of the last MarkerManager::update(); markers out of
+    // view are not updated, drawn or labeled
+    bool isInView() const { return m_inView; }
+    void setInView(bool inView) { m_inView = inView; }
+
     uint32_t selectionColor() const;
 
     // alternate marker state
@@ -139,7 +181,7 @@ protected:
 
     std::unique_ptr<Feature> m_feature;
     std::unique_ptr<StyledMesh> m_mesh;
-    std::unique_ptr<Texture> m_texture;
+    std::shared_ptr<Texture> m_texture;
     std::unique_ptr<DrawRuleMergeSet> m_drawRuleSet;
     std::unique_ptr<DrawRuleData> m_drawRuleData;
     std::unique_ptr<DrawRule> m_drawRule;
@@ -156,6 +198,11 @@ protected:
 
     int m_drawOrder = 0;
 
+    uint32_t m_revision = 0;
+
+    uint32_t m_atlasRegion = 0;
+    SpriteNode m_sprite;
+
     // Origin of marker geometry relative to global projection space.
     glm::dvec2 m_origin;
 
@@ -170,10 +217,25 @@ protected:
 
     glm::mat4 m_modelViewProjectionMatrix;
 
-    Ease m_ease;
+    // Ease of the origin, evaluated for the time of each update() instead of advanced by frame.
+    struct OriginEase {
+        glm::dvec2 start;
+        glm::dvec2 end;
+        float startTime = 0.f;
+        float duration = 0.f;
+        EaseType type = EaseType::linear;
+        bool active = false;
+    };
+    OriginEase m_ease;
+
+    LineTrim m_lineTrim;
+
+    bool m_transformChanged = true;
 
     bool m_visible = true;
 
+    bool m_inView = true;
+
 };
 
 } // namespace Tangram
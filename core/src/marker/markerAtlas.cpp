@@ -0,0 +1,274 @@
+#include "marker/markerAtlas.h"
+
+#include "gl/hardware.h"
+#include "gl/texture.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace Tangram {
+
+// Size of the atlas for the first bitmap
+static const int INITIAL_ATLAS_SIZE = 256;
+// Upper bound of the atlas size, below the maximum texture size of most devices
+static const int MAX_ATLAS_SIZE = 4096;
+// Transparent pixels between regions, so that linear filtering does not blend in their neighbours
+static const int REGION_PADDING = 1;
+
+MarkerAtlas::MarkerAtlas() {
+    m_texture = std::make_shared<Texture>(TextureOptions());
+}
+
+MarkerAtlas::~MarkerAtlas() {}
+
+uint32_t MarkerAtlas::add(int _width, int _height, float _density, const unsigned int* _pixels) {
+    if (_width <= 0 || _height <= 0 || !_pixels) { return 0; }
+
+    size_t rowBytes = size_t(_width) * 4;
+    std::string_view bytes(reinterpret_cast<const char*>(_pixels), rowBytes * _height);
+    size_t hash = std::hash<std::string_view>()(bytes);
+
+    auto range = m_regionsByHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto& region = m_regions[it->second - 1];
+        if (matches(region, _width, _height, _density, _pixels)) {
+            region.refs++;
+            return it->second;
+        }
+    }
+
+    int x = 0, y = 0, shelf = 0;
+    while (!allocate(_width + REGION_PADDING, _height + REGION_PADDING, x, y, shelf)) {
+        if (evict()) { continue; }
+        if (!grow()) {
+            LOGW("Marker bitmap of %dx%d pixels does not fit into the marker atlas", _width, _height);
+            return 0;
+        }
+    }
+
+    auto* src = reinterpret_cast<const uint8_t*>(_pixels);
+    for (int row = 0; row < _height; row++) {
+        std::memcpy(&m_pixels[(size_t(y + row) * m_width + x) * 4], src + row * rowBytes, rowBytes);
+    }
+
+    uint32_t id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        m_regions.emplace_back();
+        id = uint32_t(m_regions.size());
+    }
+
+    auto& region = m_regions[id - 1];
+    region.x = x;
+    region.y = y;
+    region.width = _width;
+    region.height = _height;
+    region.density = _density;
+    region.hash = hash;
+    region.refs = 1;
+    region.shelf = shelf;
+
+    m_regionsByHash.emplace(hash, id);
+    m_regionCount++;
+    m_dirty = true;
+
+    return id;
+}
+
+void MarkerAtlas::release(uint32_t _regionId) {
+    if (_regionId == 0 || _regionId > m_regions.size()) { return; }
+
+    auto& region = m_regions[_regionId - 1];
+    if (region.refs > 0) { region.refs--; }
+}
+
+bool MarkerAtlas::getSprite(uint32_t _regionId, SpriteNode& _sprite) const {
+    if (_regionId == 0 || _regionId > m_regions.size()) { return false; }
+
+    auto& region = m_regions[_regionId - 1];
+    if (region.shelf < 0) { return false; }
+
+    float width = m_width;
+    float height = m_height;
+
+    // Rows of the bitmap are in the order of the rows of the texture, as for a texture of one bitmap
+    _sprite.m_uvBL = { region.x / width, (region.y + region.height) / height };
+    _sprite.m_uvTR = { (region.x + region.width) / width, region.y / height };
+    _sprite.m_size = glm::vec2(region.width, region.height) / region.density;
+    _sprite.m_origin = { region.x, region.y };
+
+    return true;
+}
+
+bool MarkerAtlas::flush() {
+    if (!m_dirty) { return false; }
+
+    m_texture->setPixelData(m_width, m_height, 4, m_pixels.data(), m_pixels.size());
+    m_dirty = false;
+
+    bool grown = m_grown;
+    m_grown = false;
+    return grown;
+}
+
+bool MarkerAtlas::allocate(int _width, int _height, int& _x, int& _y, int& _shelf) {
+
+    // x of a free span of @_shelf fitting the region, or of its end, -1 if it is full
+    auto fit = [&](const Shelf& shelf) {
+        for (auto& span : shelf.free) {
+            if (span.width >= _width) { return span.x; }
+        }
+        return shelf.end + _width <= m_width ? shelf.end : -1;
+    };
+
+    // Lowest shelf fitting the region
+    int best = -1, bestX = 0;
+    for (int i = 0; i < int(m_shelves.size()); i++) {
+        auto& shelf = m_shelves[i];
+        if (shelf.height < _height) { continue; }
+        if (best >= 0 && shelf.height >= m_shelves[best].height) { continue; }
+        int x = fit(shelf);
+        if (x >= 0) {
+            best = i;
+            bestX = x;
+        }
+    }
+
+    // Start a new shelf rather than waste much of a higher one, while there is space for it
+    bool wasteful = best < 0 || m_shelves[best].height > _height + _height / 2;
+    if (wasteful && _width <= m_width && m_shelfTop + _height <= m_height) {
+        m_shelves.push_back({ m_shelfTop, _height });
+        m_shelfTop += _height;
+        best = int(m_shelves.size()) - 1;
+        bestX = 0;
+    }
+
+    if (best < 0) { return false; }
+
+    auto& shelf = m_shelves[best];
+    if (bestX == shelf.end) {
+        shelf.end += _width;
+    } else {
+        auto span = std::find_if(shelf.free.begin(), shelf.free.end(),
+                                 [&](auto& s) { return s.x == bestX; });
+        span->x += _width;
+        span->width -= _width;
+        if (span->width == 0) { shelf.free.erase(span); }
+    }
+
+    _x = bestX;
+    _y = shelf.y;
+    _shelf = best;
+    return true;
+}
+
+void MarkerAtlas::deallocate(const Region& _region) {
+    auto& shelf = m_shelves[_region.shelf];
+    Span span{ _region.x, _region.width + REGION_PADDING };
+
+    // Free spans are sorted by x and merged with their neighbours; spans reaching the end shorten the shelf
+    auto next = std::lower_bound(shelf.free.begin(), shelf.free.end(), span.x,
+                                 [](const Span& s, int x) { return s.x < x; });
+    if (next != shelf.free.begin()) {
+        auto prev = std::prev(next);
+        if (prev->x + prev->width == span.x) {
+            span.x = prev->x;
+            span.width += prev->width;
+            next = shelf.free.erase(prev);
+        }
+    }
+    if (next != shelf.free.end() && span.x + span.width == next->x) {
+        span.width += next->width;
+        next = shelf.free.erase(next);
+    }
+    if (span.x + span.width == shelf.end) {
+        shelf.end = span.x;
+    } else {
+        shelf.free.insert(next, span);
+    }
+
+    // Empty shelves at the top are released for bitmaps of any height
+    while (!m_shelves.empty() && m_shelves.back().end == 0) {
+        m_shelfTop = m_shelves.back().y;
+        m_shelves.pop_back();
+    }
+
+    // Clear the pixels for smaller bitmaps placed there later
+    for (int row = 0; row < _region.height; row++) {
+        std::memset(&m_pixels[(size_t(_region.y + row) * m_width + _region.x) * 4], 0,
+                    size_t(_region.width) * 4);
+    }
+}
+
+bool MarkerAtlas::evict() {
+    bool evicted = false;
+
+    for (size_t i = 0; i < m_regions.size(); i++) {
+        auto& region = m_regions[i];
+        if (region.refs > 0 || region.shelf < 0) { continue; }
+
+        uint32_t id = uint32_t(i + 1);
+        auto range = m_regionsByHash.equal_range(region.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                m_regionsByHash.erase(it);
+                break;
+            }
+        }
+
+        deallocate(region);
+        region = Region();
+        m_freeIds.push_back(id);
+        m_regionCount--;
+        evicted = true;
+    }
+
+    if (evicted) { m_dirty = true; }
+    return evicted;
+}
+
+bool MarkerAtlas::grow() {
+    int maxSize = std::min(MAX_ATLAS_SIZE, Hardware::maxTextureSize);
+    if (m_width >= maxSize && m_height >= maxSize) { return false; }
+
+    int width = m_width == 0 ? INITIAL_ATLAS_SIZE : std::min(m_width * 2, maxSize);
+    int height = m_height == 0 ? INITIAL_ATLAS_SIZE : std::min(m_height * 2, maxSize);
+
+    std::vector<uint8_t> pixels(size_t(width) * height * 4, 0);
+    for (int row = 0; row < m_height; row++) {
+        std::memcpy(&pixels[size_t(row) * width * 4], &m_pixels[size_t(row) * m_width * 4],
+                    size_t(m_width) * 4);
+    }
+
+    // uvs only change for existing regions
+    m_grown |= m_width > 0;
+    m_pixels = std::move(pixels);
+    m_width = width;
+    m_height = height;
+    m_dirty = true;
+
+    return true;
+}
+
+bool MarkerAtlas::matches(const Region& _region, int _width, int _height, float _density,
+                          const unsigned int* _pixels) const {
+    if (_region.width != _width || _region.height != _height || _region.density != _density) {
+        return false;
+    }
+
+    size_t rowBytes = size_t(_width) * 4;
+    auto* src = reinterpret_cast<const uint8_t*>(_pixels);
+    for (int row = 0; row < _height; row++) {
+        if (std::memcmp(&m_pixels[(size_t(_region.y + row) * m_width + _region.x) * 4],
+                        src + row * rowBytes, rowBytes) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "scene/spriteAtlas.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class Texture;
+
+/*
+ * MarkerAtlas - Packs the bitmaps of markers into one texture, so that they are drawn together
+ *
+ * Bitmaps are placed on shelves, rows of the height of the first bitmap placed on them, and
+ * the same bitmap added again shares its region. Regions are refcounted; unreferenced regions
+ * are kept for bitmaps set again until their space is needed. When a bitmap does not fit, the
+ * unreferenced regions are evicted and then the atlas doubles in size, up to the maximum
+ * texture size, which changes the uvs of all regions.
+ *
+ * Pixels are kept on the CPU and copied to the texture once by flush(), however many
+ * bitmaps were added since the last one.
+ */
+class MarkerAtlas {
+
+public:
+
+    MarkerAtlas();
+    ~MarkerAtlas();
+
+    // Add a bitmap of @_width x @_height RGBA pixels for @_density pixels per display pixel,
+    // or take another reference to the same bitmap added before; returns the id of its
+    // region, 0 if it does not fit into the atlas of the maximum size.
+    uint32_t add(int _width, int _height, float _density, const unsigned int* _pixels);
+
+    // Release a reference to the region with @_regionId
+    void release(uint32_t _regionId);
+
+    // Sprite of the region with @_regionId, with the uvs for the current size of the atlas
+    // and the size in display pixels
+    bool getSprite(uint32_t _regionId, SpriteNode& _sprite) const;
+
+    // Copy the pixels to the texture when regions were added, to be uploaded on its next
+    // bind; returns true if the atlas grew since the last flush
+    bool flush();
+
+    const std::shared_ptr<Texture>& texture() const { return m_texture; }
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    // Regions of the atlas, including unreferenced ones which are not evicted yet
+    size_t regionCount() const { return m_regionCount; }
+
+private:
+
+    struct Region {
+        int x = 0, y = 0, width = 0, height = 0;
+        float density = 1.f;
+        size_t hash = 0;
+        uint32_t refs = 0;
+        int shelf = -1;
+    };
+
+    // Free span of a shelf
+    struct Span { int x, width; };
+
+    struct Shelf {
+        int y, height;
+        // End of the spans in use and free spans before it
+        int end = 0;
+        std::vector<Span> free;
+    };
+
+    // Position of a region of @_width x @_height pixels including padding; false if there is
+    // no space for it in the current size
+    bool allocate(int _width, int _height, int& _x, int& _y, int& _shelf);
+
+    // Return the space of @_region to its shelf
+    void deallocate(const Region& _region);
+
+    // Release the space of all unreferenced regions; returns true if any were evicted
+    bool evict();
+
+    // Double the size of the atlas; false at the maximum size
+    bool grow();
+
+    bool matches(const Region& _region, int _width, int _height, float _density,
+                 const unsigned int* _pixels) const;
+
+    std::shared_ptr<Texture> m_texture;
+
+    // RGBA pixels of the atlas, rows of m_width
+    std::vector<uint8_t> m_pixels;
+    int m_width = 0;
+    int m_height = 0;
+
+    std::vector<Shelf> m_shelves;
+    // Top of the next shelf
+    int m_shelfTop = 0;
+
+    // Regions by id - 1; ids of evicted regions are reused
+    std::vector<Region> m_regions;
+    std::vector<uint32_t> m_freeIds;
+    size_t m_regionCount = 0;
+
+    // Ids of regions by hash of their bitmap
+    std::unordered_multimap<size_t, uint32_t> m_regionsByHash;
+
+    bool m_dirty = false;
+    bool m_grown = false;
+
+};
+
+}
@@ -3,10 +3,15 @@
 #include "data/tileData.h"
 #include "gl/texture.h"
 #include "marker/marker.h"
+#include "marker/markerAtlas.h"
 #include "scene/sceneLoader.h"
 #include "scene/dataLayer.h"
 #include "scene/styleContext.h"
 #include "style/style.h"
+#include "tile/tileBuilder.h"
+#include "tile/tileTask.h"
+#include "tile/tileWorker.h"
+#include "util/simplify.h"
 #include "view/view.h"
 #include "labels/labelSet.h"
 #include "log.h"
@@ -19,18 +24,142 @@ namespace Tangram {
 // ':' Delimiter for style params and layer-sublayer naming
 static const char DELIMITER = ':';
 
+// Markers to rebuild at once for which the meshes are built on the tile workers
+static const size_t MIN_WORKER_BUILDS = 64;
+// Markers built by one task on a tile worker
+static const size_t WORKER_BUILD_CHUNK = 256;
+// Markers are indexed by cells of this many zooms below the view, i.e. of at least 4 tiles square
+static const int MARKER_GRID_ZOOM_OFFSET = 2;
+// Markers covering more cells are not indexed
+static const int MAX_MARKER_CELLS = 16;
+// Pixels around the view in which markers are updated, for their labels reaching into it
+static const float MARKER_VIEW_MARGIN = 256.f;
+// Pixels within which the lines and polygons of markers are simplified for the zoom they are built for
+static const float MARKER_SIMPLIFY_PIXELS = 0.5f;
+
+// Tolerance in marker units for simplifying the geometry of @marker built for @zoom
+static float markerSimplifyTolerance(const Marker& marker, int zoom) {
+    if (marker.extent() <= 0.f) { return 0.f; }
+    return MARKER_SIMPLIFY_PIXELS * MapProjection::metersPerTileAtZoom(zoom) / (256.f * marker.extent());
+}
+
+// Distance along @built, the simplified @line, to the point at @fraction of the segment after
+// point @index of @line; the part of a segment of @built that is removed is measured along the
+// points of @line it replaces
+static float lineTrimDistance(LineView line, LineView built, size_t index, float fraction) {
+    if (built.empty()) { return 0.f; }
+    index = std::min(index, line.size() - 1);
+
+    // Kept point of @built at or before @index, its index in @line and distance along @built
+    size_t kept = 0;
+    size_t start = 0;
+    float distance = 0.f;
+    for (size_t i = 1; i <= index; i++) {
+        if (kept + 1 < built.size() && line[i] == built[kept + 1]) {
+            distance += glm::distance(built[kept], built[kept + 1]);
+            kept++;
+            start = i;
+        }
+    }
+    if (kept + 1 >= built.size()) { return distance; }
+
+    float part = 0.f;
+    float total = 0.f;
+    for (size_t i = start; i + 1 < line.size(); i++) {
+        float length = glm::distance(line[i], line[i + 1]);
+        if (i < index) { part += length; }
+        else if (i == index) { part += length * fraction; }
+        total += length;
+        if (line[i + 1] == built[kept + 1]) { break; }
+    }
+    if (total > 0.f) {
+        distance += glm::distance(built[kept], built[kept + 1]) * part / total;
+    }
+    return distance;
+}
+
+// Build the mesh of @marker for @zoom with @styler, evaluating its draw rule with @styleContext
+static bool buildMarkerMesh(Marker& marker, int zoom, StyleBuilder& styler, StyleContext& styleContext,
+                            FeatureSelection& featureSelection) {
+    auto feature = marker.feature();
+    auto rule = marker.drawRule();
+
+    // Apply default draw rules defined for this style
+    styler.style().applyDefaultDrawRules(*rule);
+
+    styleContext.setTileID(TileID(0, 0, zoom));
+    styleContext.setFeature(*feature);
+    bool valid = marker.evaluateRuleForContext(styleContext);
+
+    if (!valid) { return false; }
+
+    styler.setup(marker, zoom);
+    // Builders of tile workers keep the settings of the last tile
+    styler.setSimplifyTolerance(markerSimplifyTolerance(marker, zoom));
+    styler.setClipMargin(-1.f);
+    styler.setCoarse(false);
+
+    uint32_t selectionColor = 0;
+    bool interactive = false;
+    if (rule->get(StyleParamKey::interactive, interactive) && interactive) {
+        selectionColor = featureSelection.nextColorIdentifier();
+        rule->selectionColor = selectionColor;
+    } else {
+        rule->selectionColor = 0;
+    }
+
+    if (!styler.addFeature(*feature, *rule)) { return false; }
+
+    marker.setSelectionColor(selectionColor);
+    marker.setMesh(styler.style().getID(), zoom, styler.build());
+
+    return true;
+}
+
+// Builds the meshes of copies of markers (see Marker::copyForBuild()) on a tile worker, with the
+// StyleBuilders and StyleContext of its TileBuilder
+class MarkerBuildTask : public TileTask {
+public:
+
+    const int zoom;
+    std::vector<std::unique_ptr<Marker>> markers;
+
+    MarkerBuildTask(int _zoom) : TileTask(TileID(0, 0, _zoom), nullptr), zoom(_zoom) {
+        // Nothing to load or parse
+        m_parsed = true;
+        startedLoading();
+    }
+
+    void parse() override {}
+
+    void build(TileBuilder& _builder) override {
+        auto& featureSelection = *_builder.scene().featureSelection();
+        for (auto& marker : markers) {
+            if (isCanceled()) { return; }
+            auto styler = _builder.getStyleBuilder(marker->drawRule()->getStyleName());
+            if (!styler || _builder.scene().isStylePending(styler->style().getID())) { continue; }
+            buildMarkerMesh(*marker, zoom, *styler, _builder.styleContext(), featureSelection);
+        }
+        m_ready = true;
+    }
+};
+
 MarkerManager::MarkerManager(const Scene& _scene, MarkerManager* _oldInst) : m_scene(_scene) {
     if(_oldInst && !_oldInst->m_markers.empty()) {
         m_dirty = true;
+        m_atlas = std::move(_oldInst->m_atlas);
         m_markers = std::move(_oldInst->m_markers);
         m_idCounter = _oldInst->m_idCounter;
         for(auto& marker : m_markers) {
             marker->reset();
+            m_markerIndex.emplace(marker->id(), marker.get());
         }
     }
+    if (!m_atlas) { m_atlas = std::make_unique<MarkerAtlas>(); }
 }
 
 MarkerManager::~MarkerManager() {
+    cancelWorkerBuilds();
     if(!m_markers.empty())
         LOGD("Destroying MarkerManager with %d markers.", int(m_markers.size()));
 }
@@ -42,6 +171,7 @@ MarkerID MarkerManager::add() {
     // Add a new empty marker object to the list of markers.
     auto id = ++m_idCounter;
     m_markers.push_back(std::make_unique<Marker>(id));
+    m_markerIndex.emplace(id, m_markers.back().get());
 
     // Return a handle for the marker.
     return id;
@@ -50,13 +180,16 @@ MarkerID MarkerManager::add() {
 bool MarkerManager::remove(MarkerID markerID) {
     m_dirty = true;
 
-    for (auto it = m_markers.begin(), end = m_markers.end(); it != end; ++it) {
-        if (it->get()->id() == markerID) {
-            m_markers.erase(it);
-            return true;
-        }
-    }
-    return false;
+    Marker* marker = getMarkerOrNull(markerID);
+    if (!marker) { return false; }
+
+    // the grid is built again in update()
+    clearGrid();
+    m_atlas->release(marker->atlasRegion());
+    m_markerIndex.erase(markerID);
+    m_markers.erase(std::find_if(m_markers.begin(), m_markers.end(),
+                                 [&](auto& entry) { return entry.get() == marker; }));
+    return true;
 }
 
 bool MarkerManager::setStyling(MarkerID markerID, const char* styling, bool isPath) {
@@ -75,13 +208,23 @@ bool MarkerManager::setBitmap(MarkerID markerID, int width, int height, float de
 
     marker->clearMesh();
 
-    TextureOptions options;
-    options.displayScale = 1.f / density;
-    auto texture = std::make_unique<Texture>(options);
-    texture->setPixelData(width, height, sizeof(GLuint),
-                          reinterpret_cast<const GLubyte*>(bitmapData),
-                          width * height * sizeof(GLuint));
-    marker->setTexture(std::move(texture));
+    // The same bitmap is added before the previous one is released to keep its region
+    uint32_t regionId = m_atlas->add(width, height, density, bitmapData);
+    m_atlas->release(marker->atlasRegion());
+
+    SpriteNode sprite;
+    if (regionId != 0 && m_atlas->getSprite(regionId, sprite)) {
+        marker->setAtlasTexture(m_atlas->texture(), regionId, sprite);
+    } else {
+        // Too large for the atlas
+        TextureOptions options;
+        options.displayScale = 1.f / density;
+        auto texture = std::make_unique<Texture>(options);
+        texture->setPixelData(width, height, sizeof(GLuint),
+                              reinterpret_cast<const GLubyte*>(bitmapData),
+                              width * height * sizeof(GLuint));
+        marker->setTexture(std::move(texture));
+    }
     m_dirty = true;
 
     return true;
@@ -126,29 +269,70 @@ bool MarkerManager::setAlternate(MarkerID markerID, MarkerID altID) {
     return true;
 }
 
-bool MarkerManager::setPoint(MarkerID markerID, LngLat lngLat) {
-    Marker* marker = getMarkerOrNull(markerID);
-    if (!marker) { return false; }
-
-    marker->clearMesh();
-
-    // If the marker does not have a 'point' feature mesh built, build it.
-    if (!marker->feature() || marker->feature()->geometryType != GeometryType::points) {
+void MarkerManager::setPointFeature(Marker& marker, LngLat lngLat) {
+    // If the marker does not have a 'point' feature, add it. The mesh of a point does not depend on its
+    // position (see Marker::setMesh()), so moving a point keeps it.
+    if (!marker.feature() || marker.feature()->geometryType != GeometryType::points) {
+        marker.clearMesh();
         auto feature = std::make_unique<Feature>();
         feature->geometryType = GeometryType::points;
-        feature->points.emplace_back();
-        marker->setFeature(std::move(feature));
+        feature->addPoint({});
+        marker.setFeature(std::move(feature));
     }
 
     // Update the marker's bounds to the given coordinates.
     auto origin = MapProjection::lngLatToProjectedMeters(lngLat);
-    marker->setBounds({ origin, origin });
+    marker.setBounds({ origin, origin });
+}
+
+bool MarkerManager::setPoint(MarkerID markerID, LngLat lngLat) {
+    Marker* marker = getMarkerOrNull(markerID);
+    if (!marker) { return false; }
 
+    setPointFeature(*marker, lngLat);
     m_dirty = true;
 
     return true;
 }
 
+void MarkerManager::addPoints(const char* styling, bool isPath, const LngLat* coordinates,
+                              Properties* properties, int count, MarkerID* markerIDs) {
+    if (count <= 0) { return; }
+    m_dirty = true;
+
+    std::string markerStyling(styling);
+    m_markers.reserve(m_markers.size() + count);
+    for (int i = 0; i < count; ++i) {
+        auto id = ++m_idCounter;
+        auto marker = std::make_unique<Marker>(id);
+        marker->setStyling(markerStyling, isPath);
+        setPointFeature(*marker, coordinates[i]);
+        if (properties) { marker->feature()->props = std::move(properties[i]); }
+        m_markerIndex.emplace(id, marker.get());
+        m_markers.push_back(std::move(marker));
+        if (markerIDs) { markerIDs[i] = id; }
+    }
+}
+
+int MarkerManager::setPoints(const MarkerID* markerIDs, const LngLat* coordinates, Properties* properties,
+                             int count) {
+    int updated = 0;
+    for (int i = 0; i < count; ++i) {
+        Marker* found = getMarkerOrNull(markerIDs[i]);
+        if (!found) { continue; }
+        Marker& marker = *found;
+        setPointFeature(marker, coordinates[i]);
+        if (properties) {
+            marker.clearMesh();
+            marker.feature()->props = std::move(properties[i]);
+        }
+        ++updated;
+    }
+    if (updated > 0) { m_dirty = true; }
+
+    return updated;
+}
+
 bool MarkerManager::setPointEased(MarkerID markerID, LngLat lngLat, float duration, EaseType ease) {
     Marker* marker = getMarkerOrNull(markerID);
     if (!marker) { return false; }
@@ -161,7 +345,7 @@ bool MarkerManager::setPointEased(MarkerID markerID, LngLat lngLat, float durati
     }
 
     auto dest = MapProjection::lngLatToProjectedMeters({lngLat.longitude, lngLat.latitude});
-    marker->setEase(dest, duration, ease);
+    marker->setEase(dest, duration, ease, m_time);
 
     return true;
 }
@@ -178,8 +362,7 @@ bool MarkerManager::setPolyline(MarkerID markerID, LngLat* coordinates, int coun
     // Build a feature for the new set of polyline points.
     auto feature = std::make_unique<Feature>();
     feature->geometryType = GeometryType::lines;
-    feature->lines.emplace_back();
-    auto& line = feature->lines.back();
+    auto& line = feature->coordinates;
 
     // Determine the bounds of the polyline.
     BoundingBox bounds;
@@ -198,11 +381,12 @@ bool MarkerManager::setPolyline(MarkerID markerID, LngLat* coordinates, int coun
 
     // Project and offset the coordinates into the marker-local coordinate system.
     auto origin = marker->origin(); // SW corner.
-    for (int i = 0; i < count; ++i) {
-        auto degrees = LngLat(coordinates[i].longitude, coordinates[i].latitude);
-        auto meters = MapProjection::lngLatToProjectedMeters(degrees);
-        line.emplace_back((meters.x - origin.x) * scale, (meters.y - origin.y) * scale);
+    std::vector<ProjectedMeters> meters(count);
+    MapProjection::lngLatToProjectedMeters(coordinates, meters.data(), count);
+    for (const auto& m : meters) {
+        line.emplace_back((m.x - origin.x) * scale, (m.y - origin.y) * scale);
     }
+    feature->endLine();
 
     // Update the feature data for the marker.
     marker->setFeature(std::move(feature));
@@ -210,6 +394,39 @@ bool MarkerManager::setPolyline(MarkerID markerID, LngLat* coordinates, int coun
     return true;
 }
 
+bool MarkerManager::setPolylineTrim(MarkerID markerID, int index, float fraction) {
+    Marker* marker = getMarkerOrNull(markerID);
+    if (!marker || !marker->feature() || marker->feature()->geometryType != GeometryType::lines) {
+        return false;
+    }
+
+    Marker::LineTrim trim;
+    trim.index = index;
+    trim.fraction = glm::clamp(fraction, 0.f, 1.f);
+    marker->setLineTrim(trim);
+    updateLineTrim(*marker);
+
+    return true;
+}
+
+void MarkerManager::updateLineTrim(Marker& marker) {
+    auto trim = marker.lineTrim();
+    int zoom = marker.builtZoomLevel();
+    if (trim.index < 0 || zoom < 0 || trim.zoom == zoom) { return; }
+
+    auto* feature = marker.feature();
+    if (!feature || feature->geometryType != GeometryType::lines || feature->lines().empty()) { return; }
+
+    // Simplify the line like buildMarkerMesh() did for the mesh
+    LineView line = feature->lines()[0];
+    GeometrySimplifier simplifier;
+    simplifier.setTolerance(markerSimplifyTolerance(marker, zoom));
+
+    trim.distance = lineTrimDistance(line, simplifier.simplify(line), size_t(trim.index), trim.fraction);
+    trim.zoom = zoom;
+    marker.setLineTrim(trim);
+}
+
 bool MarkerManager::setPolygon(MarkerID markerID, LngLat* coordinates, int* counts, int rings) {
     if (!m_scene.isReady()) { return false; }
 
@@ -224,8 +441,7 @@ bool MarkerManager::setPolygon(MarkerID markerID, LngLat* coordinates, int* coun
     // Build a feature for the new set of polygon points.
     auto feature = std::make_unique<Feature>();
     feature->geometryType = GeometryType::polygons;
-    feature->polygons.emplace_back();
-    auto& polygon = feature->polygons.back();
+    feature->beginPolygon();
 
     // Determine the bounds of the polygon.
     BoundingBox bounds;
@@ -251,17 +467,15 @@ bool MarkerManager::setPolygon(MarkerID markerID, LngLat* coordinates, int* coun
 
     // Project and offset the coordinates into the marker-local coordinate system.
     auto origin = marker->origin(); // SW corner.
-    ring = coordinates;
+    std::vector<ProjectedMeters> meters(ring - coordinates);
+    MapProjection::lngLatToProjectedMeters(coordinates, meters.data(), meters.size());
+    auto m = meters.begin();
     for (int i = 0; i < rings; ++i) {
         int count = counts[i];
-        polygon.emplace_back();
-        auto& line = polygon.back();
-        for (int j = 0; j < count; ++j) {
-            auto degrees = LngLat(ring[j].longitude, ring[j].latitude);
-            auto meters = MapProjection::lngLatToProjectedMeters(degrees);
-            line.emplace_back((meters.x - origin.x) * scale, (meters.y - origin.y) * scale);
+        for (int j = 0; j < count; ++j, ++m) {
+            feature->coordinates.emplace_back((m->x - origin.x) * scale, (m->y - origin.y) * scale);
         }
-        ring += count;
+        feature->endRing();
     }
 
     // Update the feature data for the marker.
@@ -286,34 +500,89 @@ MarkerManager::UpdateState MarkerManager::update(const View& _view, float _dt) {
         }
     }
 
+    bool zoomChanged = m_zoom != _view.getIntegerZoom();
     m_zoom = _view.getIntegerZoom();
+    m_time += _dt;
+
+    bool viewChanged = _view.getViewProjectionMatrix() != m_viewProjection ||
+                       _view.getPosition() != m_viewPosition;
+    m_viewProjection = _view.getViewProjectionMatrix();
+    m_viewPosition = _view.getPosition();
 
     bool rebuilt = false;
     bool easing = false;
     bool dirty = m_dirty;
     m_dirty = false;
 
+    // Bitmaps set since the last update are uploaded at once; when the atlas grew, the uvs of all changed
+    if (m_atlas->flush()) {
+        for (auto& marker : m_markers) {
+            SpriteNode sprite;
+            if (!m_atlas->getSprite(marker->atlasRegion(), sprite)) { continue; }
+            marker->setAtlasTexture(m_atlas->texture(), marker->atlasRegion(), sprite);
+            marker->clearMesh();
+        }
+        dirty = true;
+    }
+
+    if (!m_workerBuilds.empty()) {
+        // Meshes for another zoom are of no use anymore
+        if (m_workerZoom != m_zoom) { cancelWorkerBuilds(); }
+        else if (takeWorkerMeshes()) { rebuilt = true; }
+    }
+
     // Sort the marker list by draw order - now done here instead of in add() and setDrawOrder()
     if (dirty) {
         std::stable_sort(m_markers.begin(), m_markers.end(), Marker::compareByDrawOrder);
     }
 
-    for (auto& marker : m_markers) {
-        // skip hidden markers (else we'll end up rendering continuously since buildStyling() doesn't finish)
-        if (!marker->isVisible()) { continue; }
+    // Markers only need building after changes or for a new zoom
+    std::vector<Marker*> toBuild;
+    if (dirty || rebuilt || zoomChanged) {
+        for (auto& marker : m_markers) {
+            // skip hidden markers (else we'll end up rendering continuously since buildStyling() doesn't finish)
+            if (!marker->isVisible()) { continue; }
+
+            int builtZoom = marker->builtZoomLevel();
+            if (m_zoom != builtZoom || !marker->mesh()) {
+                // keep the previous mesh while the marker is built on the workers
+                auto pending = m_workerMarkers.find(marker->id());
+                if (pending != m_workerMarkers.end() && pending->second == marker->revision()) { continue; }
+
+                if (builtZoom < 0) { buildStyling(*marker); }
+                toBuild.push_back(marker.get());
+            }
+        }
+    }
 
-        int builtZoom = marker->builtZoomLevel();
-        if (m_zoom != builtZoom || !marker->mesh()) {
-            if (builtZoom < 0) { buildStyling(*marker); }
+    if (toBuild.size() >= MIN_WORKER_BUILDS) { buildOnWorkers(toBuild); }
 
-            // prevent continuous rendering if marker styling fails
-            if (buildMesh(*marker, m_zoom))
-                rebuilt = true;
-            else
-                LOGE("Error building marker mesh.");
-        }
+    for (auto* marker : toBuild) {
+        // prevent continuous rendering if marker styling fails
+        if (buildMesh(*marker, m_zoom))
+            rebuilt = true;
+        else
+            LOGE("Error building marker mesh.");
+    }
+
+    // Trims are measured along the lines as simplified for the zoom of their meshes
+    if (rebuilt) {
+        for (auto& marker : m_markers) { updateLineTrim(*marker); }
+    }
+
+    // Only markers near the view are updated
+    bool force = dirty || rebuilt;
+    int gridZoom = std::max(m_zoom - MARKER_GRID_ZOOM_OFFSET, 0);
+    if (force || gridZoom != m_gridZoom) {
+        buildGrid(gridZoom);
+        force = true;
+    }
+    if (viewChanged || force) { updateGrid(_view, force); }
 
-        marker->update(_dt, _view);
+    for (auto* marker : m_easingMarkers) {
+        if (!viewChanged && !force && !marker->needsUpdate()) { continue; }
+        marker->update(m_time, _view);
+        marker->setInView(boxInView(_view, { marker->origin(), marker->origin() }));
         easing |= marker->isEasing();
     }
     LOGT("<<< update");
@@ -321,8 +590,145 @@ MarkerManager::UpdateState MarkerManager::update(const View& _view, float _dt) {
     return {rebuilt || easing || dirty, easing};
 }
 
+void MarkerManager::buildGrid(int zoom) {
+    clearGrid();
+    m_gridZoom = zoom;
+
+    const double cellSize = MapProjection::metersPerTileAtZoom(zoom);
+    const double origin = MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS;
+    const int maxCell = (1 << zoom) - 1;
+    auto cell = [&](double meters) { return glm::clamp(int(std::floor((meters + origin) / cellSize)), 0, maxCell); };
+
+    for (auto& entry : m_markers) {
+        Marker* marker = entry.get();
+        if (!marker->isVisible() || !marker->feature()) { continue; }
+
+        if (marker->selectionColor() != 0) { m_selectionIndex.emplace(marker->selectionColor(), marker); }
+
+        // easing markers leave their cells
+        if (marker->isEasing()) {
+            m_easingMarkers.push_back(marker);
+            continue;
+        }
+
+        const auto& bounds = marker->bounds();
+        int x0 = cell(bounds.min.x), x1 = cell(bounds.max.x);
+        int y0 = cell(bounds.min.y), y1 = cell(bounds.max.y);
+        if ((x1 - x0 + 1) * (y1 - y0 + 1) > MAX_MARKER_CELLS) {
+            m_largeMarkers.push_back(marker);
+            continue;
+        }
+        for (int x = x0; x <= x1; ++x) {
+            for (int y = y0; y <= y1; ++y) {
+                m_grid[(uint64_t(x) << 32) | uint32_t(y)].markers.push_back(marker);
+            }
+        }
+    }
+}
+
+void MarkerManager::updateGrid(const View& view, bool force) {
+    const double cellSize = MapProjection::metersPerTileAtZoom(m_gridZoom);
+    const double origin = MapProjection::EARTH_HALF_CIRCUMFERENCE_METERS;
+
+    // markers in several cells are in view if any of them is
+    for (auto& entry : m_grid) {
+        auto& cell = entry.second;
+        double x = double(entry.first >> 32) * cellSize - origin;
+        double y = double(entry.first & 0xffffffff) * cellSize - origin;
+        bool inView = boxInView(view, { glm::dvec2(x, y), glm::dvec2(x + cellSize, y + cellSize) });
+        if (!inView && (cell.inView || force)) {
+            for (auto* marker : cell.markers) { marker->setInView(false); }
+        }
+        cell.inView = inView;
+    }
+    for (auto& entry : m_grid) {
+        if (!entry.second.inView) { continue; }
+        for (auto* marker : entry.second.markers) {
+            marker->setInView(true);
+            marker->update(m_time, view);
+        }
+    }
+    for (auto* marker : m_largeMarkers) {
+        bool inView = boxInView(view, marker->bounds());
+        marker->setInView(inView);
+        if (inView) { marker->update(m_time, view); }
+    }
+}
+
+bool MarkerManager::boxInView(const View& view, const BoundingBox& box) const {
+    // Corners of the box projected without elevation; the margin is added in clip space to keep it in pixels
+    // when the view is tilted
+    glm::dvec2 center = view.getRelativeMeters(box.center());
+    glm::dvec2 half = (box.max - box.min) * 0.5;
+    float margin = MARKER_VIEW_MARGIN * view.pixelScale();
+    glm::vec2 scale(1.f + 2.f * margin / view.getWidth(), 1.f + 2.f * margin / view.getHeight());
+
+    glm::vec4 corners[4];
+    for (int i = 0; i < 4; ++i) {
+        glm::dvec2 corner = center + half * glm::dvec2(i & 1 ? 1 : -1, i & 2 ? 1 : -1);
+        corners[i] = worldToClipSpace(view.getViewProjectionMatrix(), glm::vec4(corner, 0.f, 1.f));
+    }
+    for (int axis = 0; axis < 2; ++axis) {
+        bool below = true, above = true;
+        for (auto& c : corners) {
+            float w = std::abs(c.w) * scale[axis];
+            below &= c[axis] < -w;
+            above &= c[axis] > w;
+        }
+        if (below || above) { return false; }
+    }
+    return true;
+}
+
+const Marker* MarkerManager::pickMarker(const View& view, glm::vec2 position, float radius) const {
+    glm::vec2 screenSize(view.getWidth(), view.getHeight());
+    auto toScreen = [&](const Marker& marker, Point p, bool& behind) {
+        glm::vec4 s = worldToScreenSpace(marker.modelViewProjectionMatrix(), glm::vec4(p, 0.f, 1.f), screenSize, behind);
+        return glm::vec2(s);
+    };
+
+    // markers are sorted by draw order, the topmost last
+    for (auto it = m_markers.rbegin(); it != m_markers.rend(); ++it) {
+        const Marker& marker = **it;
+        if (!marker.isVisible() || !marker.isInView() || !marker.mesh() || !marker.selectionColor()) { continue; }
+        const Feature* feature = marker.feature();
+        if (!feature || feature->coordinates.empty()) { continue; }
+
+        bool behind = false, hit = false, inside = false;
+        if (feature->geometryType == GeometryType::points) {
+            for (auto& p : feature->coordinates) {
+                hit |= glm::distance(toScreen(marker, p, behind), position) <= radius && !behind;
+            }
+        } else {
+            // lines, or the rings of polygons, which contain the position for an odd number of crossings
+            size_t start = 0;
+            for (uint32_t end : feature->ringEnds) {
+                for (size_t i = start; i + 1 < end; ++i) {
+                    bool behindA = false, behindB = false;
+                    glm::vec2 a = toScreen(marker, feature->coordinates[i], behindA);
+                    glm::vec2 b = toScreen(marker, feature->coordinates[i + 1], behindB);
+                    if (behindA || behindB) { continue; }
+                    hit |= pointSegmentDistance(position, a, b) <= radius;
+                    if ((a.y > position.y) != (b.y > position.y) &&
+                        position.x < a.x + (b.x - a.x) * (position.y - a.y) / (b.y - a.y)) {
+                        inside = !inside;
+                    }
+                }
+                start = end;
+            }
+            hit |= inside && feature->geometryType == GeometryType::polygons;
+        }
+        if (hit) { return &marker; }
+    }
+    return nullptr;
+}
+
 void MarkerManager::removeAll() {
     m_dirty = true;
+    cancelWorkerBuilds();
+    clearGrid();
+    for (auto& marker : m_markers) { m_atlas->release(marker->atlasRegion()); }
+    m_markerIndex.clear();
     m_markers.clear();
 }
 
@@ -330,6 +736,7 @@ void MarkerManager::rebuildAll() {
     if (m_markers.empty()) { return; }
 
     m_dirty = true;
+    cancelWorkerBuilds();
 
     for (auto& entry : m_markers) {
         buildStyling(*entry);
@@ -338,6 +745,8 @@ void MarkerManager::rebuildAll() {
 }
 
 void MarkerManager::clearMeshes() {
+    m_dirty = true;
+    cancelWorkerBuilds();
     for (auto& entry : m_markers) {
         entry->clearMesh();
     }
@@ -401,7 +810,14 @@ bool MarkerManager::buildStyling(Marker& marker) {
     }
 
 
-    // If the styling is not a path, try to load it as a string of YAML.
+    // If the styling is not a path, try to load it as a string of YAML; markers with the same styling
+    // share the parsed draw rule.
+    auto& parsed = m_stylingCache[markerStyling.string];
+    if (parsed) {
+        marker.setDrawRuleData(std::make_unique<DrawRuleData>(*parsed));
+        return true;
+    }
+
     size_t prevFunctionCount = m_functions.size();
 
     std::vector<StyleParam> params;
@@ -427,7 +843,8 @@ bool MarkerManager::buildStyling(Marker& marker) {
         m_styleContext->addFunction(m_functions[i]);
     }
 
-    marker.setDrawRuleData(std::make_unique<DrawRuleData>("", 0, std::move(params)));
+    parsed = std::make_unique<DrawRuleData>("", 0, std::move(params));
+    marker.setDrawRuleData(std::make_unique<DrawRuleData>(*parsed));
 
     return true;
 }
@@ -452,54 +869,102 @@ bool MarkerManager::buildMesh(Marker& marker, int zoom) {
         }
     }
 
-    // Apply default draw rules defined for this style
-    styler->style().applyDefaultDrawRules(*rule);
-
-    m_styleContext->setTileID(TileID(0, 0, zoom));
-    m_styleContext->setFeature(*feature);
-    bool valid = marker.evaluateRuleForContext(*m_styleContext);
+    // Built by rebuildAll() once the resources of the style are loaded
+    if (m_scene.isStylePending(styler->style().getID())) { return true; }
 
-    if (!valid) { return false; }
+    return buildMarkerMesh(marker, zoom, *styler, *m_styleContext, *m_scene.featureSelection());
+}
 
-    styler->setup(marker, zoom);
+void MarkerManager::buildOnWorkers(std::vector<Marker*>& markers) {
+    auto* workers = m_scene.tileWorker();
+    if (!workers || !workers->isRunning() || workers->numWorkers() == 0) { return; }
 
-    uint32_t selectionColor = 0;
-    bool interactive = false;
-    if (rule->get(StyleParamKey::interactive, interactive) && interactive) {
-        if (selectionColor == 0) {
-            selectionColor = m_scene.featureSelection()->nextColorIdentifier();
+    // Functions of marker stylings are only known to the StyleContext of this thread
+    auto sceneFunctions = int(m_scene.functions().size());
+    auto usesMarkerFunctions = [&](const DrawRule& rule) {
+        for (size_t i = 0; i < StyleParamKeySize; ++i) {
+            if (rule.active[i] && rule.params[i].param->function >= sceneFunctions) { return true; }
         }
-        rule->selectionColor = selectionColor;
-    } else {
-        rule->selectionColor = 0;
+        return false;
+    };
+
+    size_t firstTask = m_workerBuilds.size();
+    std::shared_ptr<MarkerBuildTask> task;
+    // markers left to build on this thread
+    auto remaining = markers.begin();
+    for (auto* marker : markers) {
+        auto copy = marker->copyForBuild();
+        if (!copy || usesMarkerFunctions(*copy->drawRule())) {
+            *remaining++ = marker;
+            continue;
+        }
+        if (!task || task->markers.size() == WORKER_BUILD_CHUNK) {
+            task = std::make_shared<MarkerBuildTask>(m_zoom);
+            task->setScenePrana(m_scene.prana());
+            m_workerBuilds.push_back(task);
+        }
+        task->markers.push_back(std::move(copy));
+        m_workerMarkers[marker->id()] = marker->revision();
     }
+    markers.erase(remaining, markers.end());
 
-    if (!styler->addFeature(*feature, *rule)) { return false; }
+    m_workerZoom = m_zoom;
+    for (size_t i = firstTask; i < m_workerBuilds.size(); ++i) {
+        workers->enqueue(m_workerBuilds[i]);
+    }
+}
 
-    marker.setSelectionColor(selectionColor);
-    marker.setMesh(styler->style().getID(), zoom, styler->build());
+bool MarkerManager::takeWorkerMeshes() {
+    for (auto& task : m_workerBuilds) {
+        if (!task->isReady()) { return false; }
+    }
+
+    for (auto& task : m_workerBuilds) {
+        for (auto& copy : task->markers) {
+            Marker* found = getMarkerOrNull(copy->id());
+            if (!found) { continue; }
+            // skip markers changed since they were copied, they are built again
+            Marker& marker = *found;
+            if (m_workerMarkers[marker.id()] != marker.revision()) { continue; }
+
+            if (copy->mesh()) {
+                marker.setSelectionColor(copy->selectionColor());
+                marker.setMesh(copy->styleId(), copy->builtZoomLevel(), copy->takeMesh());
+            } else {
+                LOGE("Error building marker mesh.");
+                marker.clearMesh();
+            }
+        }
+    }
+    m_workerBuilds.clear();
+    m_workerMarkers.clear();
 
     return true;
 }
 
-const Marker* MarkerManager::getMarkerOrNullBySelectionColor(uint32_t selectionColor) const {
-    for (const auto& marker : m_markers) {
-        if (marker->isVisible() && marker->selectionColor() == selectionColor) {
-            return marker.get();
-        }
-    }
+void MarkerManager::cancelWorkerBuilds() {
+    for (auto& task : m_workerBuilds) { task->cancel(); }
+    m_workerBuilds.clear();
+    m_workerMarkers.clear();
+}
 
-    return nullptr;
+const Marker* MarkerManager::getMarkerOrNullBySelectionColor(uint32_t selectionColor) const {
+    auto it = m_selectionIndex.find(selectionColor);
+    if (it == m_selectionIndex.end() || !it->second->isVisible()) { return nullptr; }
+    return it->second;
 }
 
 Marker* MarkerManager::getMarkerOrNull(MarkerID markerID) {
-    if (!markerID) { return nullptr; }
-    // typical use case is to add marker, then call fns to configure it, so caller is most likely to want
-    //  marker at end of list, so we search from end
-    for (size_t ii = m_markers.size(); ii--;) {
-        if (m_markers[ii]->id() == markerID) { return m_markers[ii].get(); }
-    }
-    return nullptr;
+    auto it = m_markerIndex.find(markerID);
+    return it == m_markerIndex.end() ? nullptr : it->second;
+}
+
+void MarkerManager::clearGrid() {
+    m_grid.clear();
+    m_largeMarkers.clear();
+    m_easingMarkers.clear();
+    m_selectionIndex.clear();
+    m_gridZoom = -1;
 }
 
 } // namespace Tangram
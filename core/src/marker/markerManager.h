@@ -4,15 +4,20 @@
 #include "scene/scene.h"
 #include "util/ease.h"
 #include "util/fastmap.h"
+#include "util/geom.h"
 #include "util/types.h"
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace Tangram {
 
+class FeatureSelection;
 class MapProjection;
 class Marker;
+class MarkerAtlas;
+class MarkerBuildTask;
 class StyleBuilder;
 class StyleContext;
 class View;
@@ -40,6 +45,8 @@ public:
         return setStyling(markerID, path, true);
     }
 
+    // Set a bitmap for a point marker; bitmaps are packed into a shared atlas texture, so that markers with
+    // bitmaps are drawn together. Returns true if the marker was found and updated.
     bool setBitmap(MarkerID markerID, int width, int height, float density, const unsigned int* bitmapData);
 
     // Set whether a marker should be visible; returns true if the marker was found and updated.
@@ -62,15 +69,32 @@ public:
     // the marker was found and updated.
     bool setPointEased(MarkerID markerID, LngLat lngLat, float duration, EaseType ease);
 
+    // Add count point markers at the given positions, all with the same styling (a YAML string or, if isPath, a
+    // path to a draw rule) and with the properties of each if properties is not null, which are moved from; the
+    // IDs of the new markers are written to markerIDs.
+    void addPoints(const char* styling, bool isPath, const LngLat* coordinates, Properties* properties,
+                   int count, MarkerID* markerIDs);
+
+    // Set count markers to point features at the given positions, and set their properties if properties is not
+    // null; returns the number of markers found and updated.
+    int setPoints(const MarkerID* markerIDs, const LngLat* coordinates, Properties* properties, int count);
+
     // Set a marker to a polyline feature at the given position; returns true if the marker was found and updated.
     bool setPolyline(MarkerID markerID, LngLat* coordinates, int count);
 
+    // Hide the start of a polyline marker up to the point at fraction of the segment after the point at index,
+    // e.g. the part of a route already traveled, without rebuilding its mesh; an index < 0 shows all of it.
+    // Returns true if the marker was found and is a polyline.
+    bool setPolylineTrim(MarkerID markerID, int index, float fraction);
+
     // Set a marker to a polygon feature at the given position; returns true if the marker was found and updated.
     bool setPolygon(MarkerID markerID, LngLat* coordinates, int* counts, int rings);
 
     // Update the zoom level for all markers; markers are built for one zoom
     // level at a time so when the current zoom changes, all marker meshes are
     // rebuilt. Returns true when any Markers changed since last call to update.
+    // Many meshes are built on the tile workers, meanwhile the markers keep their
+    // previous meshes; the new ones are swapped in together once all are built.
     struct UpdateState { bool dirty, easing; };
     UpdateState update(const View& _view, float _dt);
 
@@ -87,23 +111,86 @@ public:
 
     const Marker* getMarkerOrNullBySelectionColor(uint32_t selectionColor) const;
 
+    // Topmost interactive marker in view whose geometry is within radius pixels of the screen position, from the
+    // positions of the last update; null if there is none. Only the anchor of point markers is tested, so taps on
+    // their sprites away from it still need a selection query.
+    const Marker* pickMarker(const View& view, glm::vec2 position, float radius) const;
+
 private:
 
+    // Markers in one cell of the grid, and whether the cell was in view at the last update
+    struct GridCell {
+        std::vector<Marker*> markers;
+        bool inView = false;
+    };
+
+    // Whether the box in projected meters, expanded by a margin in pixels for labels, is in view
+    bool boxInView(const View& view, const BoundingBox& box) const;
+
+    // Index visible markers by grid cell, and by selection color
+    void buildGrid(int zoom);
+    void clearGrid();
+
+    // Update the markers of cells in view and mark the others out of view
+    void updateGrid(const View& view, bool force);
+
     Marker* getMarkerOrNull(MarkerID markerID);
 
     bool setStyling(MarkerID markerID, const char* styling, bool isPath);
     bool buildStyling(Marker& marker);
     bool buildMesh(Marker& marker, int zoom);
 
+    // Measure the trim of a polyline marker along its line as built for its mesh
+    void updateLineTrim(Marker& marker);
+
+    // Point feature for a marker at lngLat
+    void setPointFeature(Marker& marker, LngLat lngLat);
+
+    // Start building the meshes of markers on the tile workers and remove those from markers; markers
+    // with a bitmap or with functions of marker stylings are left to build on this thread
+    void buildOnWorkers(std::vector<Marker*>& markers);
+    // Swap in the meshes built on the tile workers once all are done; returns true if they were
+    bool takeWorkerMeshes();
+    void cancelWorkerBuilds();
+
     const Scene& m_scene;
     // Custom functions and stops from styling strings
     SceneStops m_stops;
     SceneFunctions m_functions;
 
     std::unique_ptr<StyleContext> m_styleContext;
+    // Bitmaps of markers, kept with the markers for a new scene
+    std::unique_ptr<MarkerAtlas> m_atlas;
     std::vector<std::unique_ptr<Marker>> m_markers;
     fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilders;
 
+    // Parsed styling strings, shared by the markers using them
+    fastmap<std::string, std::unique_ptr<DrawRuleData>> m_stylingCache;
+
+    // Meshes being built on the tile workers for m_workerZoom, and the revision of the markers they are for
+    std::vector<std::shared_ptr<MarkerBuildTask>> m_workerBuilds;
+    std::unordered_map<MarkerID, uint32_t> m_workerMarkers;
+    int m_workerZoom = -1;
+
+    // Time of the last update, the start time of new eases
+    float m_time = 0.f;
+    // View of the last update; markers are only updated for a new view, while easing or after changes
+    glm::mat4 m_viewProjection{0.f};
+    glm::dvec3 m_viewPosition{0.};
+
+    // Markers by ID
+    std::unordered_map<MarkerID, Marker*> m_markerIndex;
+
+    // Visible markers by grid cell at m_gridZoom, a few zooms below the view; markers covering many cells and
+    // easing markers are updated on their own. The grid is built again when markers change.
+    std::unordered_map<uint64_t, GridCell> m_grid;
+    std::vector<Marker*> m_largeMarkers;
+    std::vector<Marker*> m_easingMarkers;
+    int m_gridZoom = -1;
+
+    // Visible markers by selection color, built with the grid
+    std::unordered_map<uint32_t, const Marker*> m_selectionIndex;
+
     uint32_t m_idCounter = 0;
     int m_zoom = 0;
     bool m_dirty = false;
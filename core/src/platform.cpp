@@ -1,7 +1,9 @@
 #include "platform.h"
 #include "log.h"
 #include "debug/textDisplay.h"
+#include "util/mappedFile.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <cassert>
@@ -60,6 +62,30 @@ bool Platform::bytesFromFileSystem(const char* _path, std::function<char*(size_t
     return true;
 }
 
+namespace {
+
+class MappedFileResource : public MappedResource {
+public:
+    bool open(const std::string& _path) {
+        if (!m_file.open(_path)) { return false; }
+        m_data = m_file.data();
+        m_size = m_file.size();
+        return true;
+    }
+private:
+    MappedFile m_file;
+};
+
+}
+
+std::shared_ptr<MappedResource> Platform::mapResource(const Url& _url) const {
+    if (!_url.hasFileScheme()) { return nullptr; }
+
+    auto resource = std::make_shared<MappedFileResource>();
+    if (!resource->open(_url.path())) { return nullptr; }
+    return resource;
+}
+
 FontSourceHandle Platform::systemFont(const std::string& _name, const std::string& _weight, const std::string& _face) const {
     // No-op by default
     return FontSourceHandle();
@@ -78,10 +104,12 @@ void Platform::shutdown() {
 
         for (auto& entry : m_urlCallbacks) {
             auto& request = entry.second;
-            if (request.callback) {
-                UrlResponse response;
-                response.error = shutdown_message;
-                request.callback(std::move(response));
+            for (auto& callback : request.callbacks) {
+                if (callback.second) {
+                    UrlResponse response;
+                    response.error = shutdown_message;
+                    callback.second(std::move(response));
+                }
             }
 
             if (request.cancelable) {
@@ -89,6 +117,8 @@ void Platform::shutdown() {
             }
         }
         m_urlCallbacks.clear();
+        m_urlRequests.clear();
+        m_urlTransfers.clear();
     }
 }
 
@@ -111,17 +141,40 @@ UrlRequestHandle Platform::startUrlRequest(Url _url, const HttpOptions& _options
 
     UrlRequestHandle handle = ++m_urlRequestCount;
 
-    // Need to do this in advance in case startUrlRequest calls back synchronously.
-    UrlRequestEntry* entry = nullptr;
+    std::string key;
+    if (_options.payload.empty()) { key = _url.string() + '\n' + _options.headers; }
+
     {
         std::lock_guard<std::mutex> lock(m_callbackMutex);
-        auto it = m_urlCallbacks.emplace(handle, UrlRequestEntry{std::move(_callback), 0, false});
-        entry = &it.first->second;
+
+        if (!key.empty()) {
+            auto transfer = m_urlTransfers.find(key);
+            if (transfer != m_urlTransfers.end()) {
+                // join running transfer
+                m_urlCallbacks[transfer->second].callbacks.emplace_back(handle, std::move(_callback));
+                m_urlRequests.emplace(handle, transfer->second);
+                return handle;
+            }
+            m_urlTransfers.emplace(key, handle);
+        }
+
+        // Need to do this in advance in case startUrlRequest calls back synchronously.
+        UrlRequestEntry entry{{}, 0, false, std::move(key), _options.relativePriority(),
+                              m_urlResponseObserver ? _url.string() : std::string()};
+        entry.callbacks.emplace_back(handle, std::move(_callback));
+        m_urlCallbacks.emplace(handle, std::move(entry));
+        m_urlRequests.emplace(handle, handle);
     }
 
     // Start Platform specific url request
-    if (startUrlRequestImpl(_url, _options, handle, entry->id)) {
-        entry->cancelable = true;
+    UrlRequestId id = 0;
+    if (startUrlRequestImpl(_url, _options, handle, id)) {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        auto it = m_urlCallbacks.find(handle);
+        if (it != m_urlCallbacks.end()) {
+            it->second.id = id;
+            it->second.cancelable = true;
+        }
     }
 
     return handle;
@@ -136,6 +189,8 @@ void Platform::cancelUrlRequest(const UrlRequestHandle _request) {
         {
             std::lock_guard<std::mutex> lock(m_callbackMutex);
             m_urlCallbacks.clear();
+            m_urlRequests.clear();
+            m_urlTransfers.clear();
         }
         return;
     }
@@ -146,13 +201,27 @@ void Platform::cancelUrlRequest(const UrlRequestHandle _request) {
 
     {
         std::lock_guard<std::mutex> lock(m_callbackMutex);
-        auto it = m_urlCallbacks.find(_request);
-        if (it != m_urlCallbacks.end()) {
-            id = it->second.id;
-            cancelable = it->second.cancelable;
-            //if (!cancelable) {
-            callback = std::move(it->second.callback);
-            m_urlCallbacks.erase(it);
+        auto request = m_urlRequests.find(_request);
+        if (request != m_urlRequests.end()) {
+            auto it = m_urlCallbacks.find(request->second);
+            m_urlRequests.erase(request);
+
+            if (it != m_urlCallbacks.end()) {
+                auto& entry = it->second;
+                auto cb = std::find_if(entry.callbacks.begin(), entry.callbacks.end(),
+                                       [&](auto& c) { return c.first == _request; });
+                if (cb != entry.callbacks.end()) {
+                    callback = std::move(cb->second);
+                    entry.callbacks.erase(cb);
+                }
+                // stop the transfer when no other request is waiting for it
+                if (entry.callbacks.empty()) {
+                    id = entry.id;
+                    cancelable = entry.cancelable;
+                    if (!entry.key.empty()) { m_urlTransfers.erase(entry.key); }
+                    m_urlCallbacks.erase(it);
+                }
+            }
         }
     }
 
@@ -167,23 +236,63 @@ void Platform::cancelUrlRequest(const UrlRequestHandle _request) {
     }
 }
 
+void Platform::updateUrlRequestPriority(const UrlRequestHandle _request, const HttpOptions& _options) {
+    float relativePriority = _options.relativePriority();
+    UrlRequestId id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        auto request = m_urlRequests.find(_request);
+        if (request == m_urlRequests.end()) { return; }
+        auto it = m_urlCallbacks.find(request->second);
+        if (it == m_urlCallbacks.end() || !it->second.cancelable ||
+            it->second.relativePriority == relativePriority) { return; }
+        it->second.relativePriority = relativePriority;
+        id = it->second.id;
+    }
+    updateUrlRequestPriorityImpl(id, relativePriority);
+}
+
+void Platform::setUrlResponseObserver(UrlResponseObserver _observer) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    m_urlResponseObserver = std::move(_observer);
+}
+
 void Platform::onUrlResponse(const UrlRequestHandle _request, UrlResponse&& _response) {
     if (m_shutdown) {
         LOGW("onUrlResponse after shutdown");
         return;
     }
     bytesDownloaded += _response.content.size();
-    // Find the callback associated with the request.
-    UrlCallback callback;
+    // Find the callbacks associated with the request.
+    std::vector<std::pair<UrlRequestHandle, UrlCallback>> callbacks;
+    UrlResponseObserver observer;
+    std::string url;
     {
         std::lock_guard<std::mutex> lock(m_callbackMutex);
         auto it = m_urlCallbacks.find(_request);
         if (it != m_urlCallbacks.end()) {
-            callback = std::move(it->second.callback);
+            callbacks = std::move(it->second.callbacks);
+            if (m_urlResponseObserver && !it->second.url.empty()) {
+                observer = m_urlResponseObserver;
+                url = std::move(it->second.url);
+            }
+            if (!it->second.key.empty()) { m_urlTransfers.erase(it->second.key); }
             m_urlCallbacks.erase(it);
+            for (auto& callback : callbacks) { m_urlRequests.erase(callback.first); }
+        }
+    }
+    if (observer) { observer(url, _response); }
+    for (size_t i = 0; i < callbacks.size(); i++) {
+        auto& callback = callbacks[i].second;
+        if (!callback) { continue; }
+        if (i + 1 < callbacks.size()) {
+            // each joined request gets the full response, e.g. the status for 404 handling
+            UrlResponse response = _response;
+            callback(std::move(response));
+        } else {
+            callback(std::move(_response));
         }
     }
-    if (callback) { callback(std::move(_response)); }
 }
 
 void logAll(const std::string& msg) {
@@ -2,9 +2,12 @@
 
 namespace Tangram {
 
-DataLayer::DataLayer(SceneLayer layer, std::string source, std::vector<std::string> collections) :
+DataLayer::DataLayer(SceneLayer layer, std::string source, std::vector<std::string> collections,
+                     float simplify, std::vector<std::string> mergeLineKeys) :
     SceneLayer(std::move(layer)),
     m_source(std::move(source)),
-    m_collections(std::move(collections)) {}
+    m_collections(std::move(collections)),
+    m_simplify(simplify),
+    m_mergeLineKeys(std::move(mergeLineKeys)) {}
 
 }
@@ -12,14 +12,24 @@ class DataLayer : public SceneLayer {
 
     std::string m_source;
     std::vector<std::string> m_collections;
+    float m_simplify = -1.f;
+    std::vector<std::string> m_mergeLineKeys;
 
 public:
 
-    DataLayer(SceneLayer layer, std::string source, std::vector<std::string> collections);
+    DataLayer(SceneLayer layer, std::string source, std::vector<std::string> collections,
+              float simplify = -1.f, std::vector<std::string> mergeLineKeys = {});
 
     const auto& source() const { return m_source; }
     const auto& collections() const { return m_collections; }
 
+    // Simplification tolerance in pixels, or < 0 to use the one of the source
+    float simplify() const { return m_simplify; }
+
+    // Keys of the properties that line features must share to be merged for labels, see
+    // LineMerger; empty to label each line feature
+    const auto& mergeLineKeys() const { return m_mergeLineKeys; }
+
 };
 
 }
@@ -106,7 +106,7 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
 
     _ctx.setFeature(_feature);
     m_matchedRules.clear();
-    m_queuedLayers.clear();
+    m_matchedRuleSetId = NO_RULE_SET;
 
     // If uber layer is marked not visible return immediately
     if (!_layer.enabled()) {
@@ -114,30 +114,36 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
     }
 
     // If the first filter doesn't match, return immediately
-    if (!_layer.filter().eval(_feature, _ctx)) { return false; }
+    if (!_layer.filterProgram().eval(_feature, _ctx)) { return false; }
 
-    m_queuedLayers.push_back({ &_layer, 1 });
+    const auto& plan = _layer.matchPlan();
+    if (m_queuedNodes.size() < plan.size()) {
+        m_queuedNodes.resize(plan.size());
+        m_matchedNodes.resize(plan.size());
+    }
+
+    uint32_t planId = _layer.matchPlanId();
+    m_matchKey.assign(reinterpret_cast<const char*>(&planId), sizeof(planId));
+
+    size_t queued = 0, matched = 0;
+    m_queuedNodes[queued++] = 0;
 
-    // Iterate depth-first over the layer hierarchy
-    while (!m_queuedLayers.empty()) {
+    // Iterate depth-first over the layer hierarchy; each node is queued at most once
+    while (queued > 0) {
 
         // Pop a layer off the top of the stack
-        const auto& layer = *m_queuedLayers.back().layer;
-        const auto depth = m_queuedLayers.back().depth;
-        m_queuedLayers.pop_back();
+        uint32_t index = m_queuedNodes[--queued];
+        const auto& node = plan[index];
 
-        // Merge rules from layer into accumulated set
-        mergeRules(layer, depth);
+        m_matchedNodes[matched++] = index;
+        m_matchKey.append(reinterpret_cast<const char*>(&index), sizeof(index));
 
         // Push each of the layer's matching sublayers onto the stack
-        for (const auto& sublayer : layer.sublayers()) {
-            // Skip matching this sublayer if marked not visible
-            if (!sublayer.enabled()) {
-                continue;
-            }
+        for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; child++) {
+            const auto& sublayer = *plan[child].layer;
 
-            if (sublayer.filter().eval(_feature, _ctx)) {
-                m_queuedLayers.push_back({ &sublayer, depth + 1 });
+            if (sublayer.filterProgram().eval(_feature, _ctx)) {
+                m_queuedNodes[queued++] = child;
                 if (sublayer.exclusive()) {
                     break;
                 }
@@ -145,6 +151,26 @@ bool DrawRuleMergeSet::match(const Feature& _feature, const SceneLayer& _layer,
         }
     }
 
+    // Reuse the merged rules of the same matched layers
+    auto it = m_ruleSetIds.find(m_matchKey);
+    if (it != m_ruleSetIds.end()) {
+        m_matchedRules = m_ruleSets[it->second];
+        m_matchedRuleSetId = it->second;
+        return true;
+    }
+
+    // Merge rules from matched layers into accumulated set
+    for (size_t i = 0; i < matched; i++) {
+        const auto& node = plan[m_matchedNodes[i]];
+        mergeRules(node.layer ? *node.layer : _layer, node.depth);
+    }
+
+    if (m_ruleSets.size() < MAX_RULE_SETS) {
+        m_matchedRuleSetId = static_cast<uint32_t>(m_ruleSets.size());
+        m_ruleSetIds.emplace(m_matchKey, m_matchedRuleSetId);
+        m_ruleSets.push_back(m_matchedRules);
+    }
+
     return true;
 }
 
@@ -155,6 +181,8 @@ bool DrawRuleMergeSet::evaluateRuleForContext(DrawRule& rule, StyleContext& cont
         return false;
     }
 
+    m_stopsValues.setZoom(context.getZoom());
+
     bool valid = true;
     for (size_t i = 0; i < StyleParamKeySize; ++i) {
 
@@ -184,7 +212,12 @@ bool DrawRuleMergeSet::evaluateRuleForContext(DrawRule& rule, StyleContext& cont
             m_evaluated[i] = *param;
             param = &m_evaluated[i];
 
-            Stops::eval(*param->stops, param->key, context.getZoom(), m_evaluated[i].value);
+            if (const auto* value = m_stopsValues.find(*param->stops)) {
+                m_evaluated[i].value = *value;
+            } else {
+                Stops::eval(*param->stops, param->key, context.getZoom(), m_evaluated[i].value);
+                m_stopsValues.insert(*param->stops, m_evaluated[i].value);
+            }
         }
     }
 
@@ -196,6 +229,15 @@ bool DrawRuleMergeSet::evaluateRuleForContext(DrawRule& rule, StyleContext& cont
     return valid;
 }
 
+void DrawRuleMergeSet::queueRuleForContext(const DrawRule& rule, StyleContext& context) {
+
+    for (size_t i = 0; i < StyleParamKeySize; ++i) {
+        if (rule.active[i] && rule.params[i].param->function >= 0) {
+            context.queueBatch(rule.params[i].param->function, rule.params[i].param->key);
+        }
+    }
+}
+
 void DrawRuleMergeSet::mergeRules(const SceneLayer& layer, int depth) {
 
     size_t pos, end = m_matchedRules.size();
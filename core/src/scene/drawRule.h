@@ -1,10 +1,13 @@
 #pragma once
 
+#include "scene/stops.h"
 #include "scene/styleParam.h"
 
 #include <bitset>
-#include <vector>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace Tangram {
 
@@ -118,6 +121,9 @@ class DrawRuleMergeSet {
 public:
     bool evaluateRuleForContext(DrawRule& rule, StyleContext& context);
 
+    // Queue the JS functions of @rule for batch evaluation, see StyleContext::queueBatch()
+    void queueRuleForContext(const DrawRule& rule, StyleContext& context);
+
     // internal
     bool match(const Feature& feature, const SceneLayer& layer, StyleContext& context);
 
@@ -126,19 +132,34 @@ public:
 
     auto& matchedRules() { return m_matchedRules; }
 
+    // Id of the set of matchedRules() of the last match(). Features that match the same
+    // sublayers get the same id; NO_RULE_SET when there was no match or too many sets
+    static constexpr uint32_t NO_RULE_SET = uint32_t(-1);
+    uint32_t matchedRuleSetId() const { return m_matchedRuleSetId; }
+
 private:
-    struct LayerMatch {
-        const SceneLayer* layer;
-        int depth;
-    };
 
-    // Reusable containers 'matchedRules' and 'queuedLayers'
+    // Limit of merged rule sets kept for reuse
+    static constexpr size_t MAX_RULE_SETS = 4096;
+
+    // Reusable containers 'matchedRules', 'queuedNodes' and 'matchedNodes', the latter
+    // grow to the size of the largest match plan
     std::vector<DrawRule> m_matchedRules;
-    std::vector<LayerMatch> m_queuedLayers;
+    std::vector<uint32_t> m_queuedNodes;
+    std::vector<uint32_t> m_matchedNodes;
+
+    // Merged rules by the match plan id and matched nodes of a match
+    std::string m_matchKey;
+    std::unordered_map<std::string, uint32_t> m_ruleSetIds;
+    std::vector<std::vector<DrawRule>> m_ruleSets;
+    uint32_t m_matchedRuleSetId = NO_RULE_SET;
 
     // Container for dynamically-evaluated parameters
     StyleParam m_evaluated[StyleParamKeySize];
 
+    // Stops evaluated at the zoom of the current tile
+    StopsCache<StyleParam::Value> m_stopsValues;
+
 };
 
 }
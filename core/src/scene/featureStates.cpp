@@ -0,0 +1,73 @@
+#include "scene/featureStates.h"
+
+#include "scene/styleParam.h"
+#include "util/color.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace Tangram {
+
+bool FeatureStates::set(int32_t _sourceId, const std::string& _featureId, const std::string& _key,
+                        const std::string& _value) {
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    FeatureState state;
+    auto key = std::make_pair(_sourceId, _featureId);
+    auto it = m_states.find(key);
+    if (it != m_states.end()) { state = it->second; }
+
+    if (_key == "color") {
+        Color color;
+        if (_value.empty()) {
+            state.color = 0;
+        } else if (StyleParam::parseColor(_value, color)) {
+            state.color = color.abgr;
+        } else {
+            return false;
+        }
+    } else if (_key == "visible") {
+        if (_value == "true") {
+            state.visible = true;
+        } else if (_value == "false") {
+            state.visible = false;
+        } else {
+            return false;
+        }
+    } else if (_key == "width") {
+        char* end = nullptr;
+        float scale = std::strtof(_value.c_str(), &end);
+        if (_value.empty() || *end != '\0' || !(scale >= 0.f)) { return false; }
+        state.widthScale = std::min(scale, FeatureState::MAX_WIDTH_SCALE);
+    } else {
+        return false;
+    }
+
+    if (state == FeatureState{}) {
+        if (it != m_states.end()) { m_states.erase(it); }
+    } else {
+        m_states[key] = state;
+    }
+    m_generation++;
+
+    return true;
+}
+
+FeatureState FeatureStates::get(int32_t _sourceId, const std::string& _featureId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_states.find(std::make_pair(_sourceId, _featureId));
+    if (it == m_states.end()) { return {}; }
+    return it->second;
+}
+
+void FeatureStates::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_states.empty()) { return; }
+
+    m_states.clear();
+    m_generation++;
+}
+
+}
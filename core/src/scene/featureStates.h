@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace Tangram {
+
+struct FeatureState {
+    // Color drawn instead of the color of the feature, 0 for none
+    uint32_t color = 0;
+    bool visible = true;
+    // Multiplier of the width of lines, up to MAX_WIDTH_SCALE
+    float widthScale = 1.f;
+
+    static constexpr float MAX_WIDTH_SCALE = 255.f / 64.f;
+
+    bool operator==(const FeatureState& _other) const {
+        return color == _other.color && visible == _other.visible && widthScale == _other.widthScale;
+    }
+};
+
+/*
+ * FeatureStates - Runtime state of features, which is applied to the feature tables of the
+ * tile meshes when they are drawn, see FeatureTable::syncStates()
+ *
+ * Features are identified by the id of their tile source and their "id" property. State
+ * keys are "color" (a CSS color, empty to reset), "visible" ("true" or "false") and "width"
+ * (a multiplier of the line width). All functions are thread-safe.
+ */
+class FeatureStates {
+
+public:
+
+    /* Set @_key of the state of feature @_featureId of source @_sourceId to @_value;
+     * false when @_key is unknown or @_value is not valid for it */
+    bool set(int32_t _sourceId, const std::string& _featureId, const std::string& _key,
+             const std::string& _value);
+
+    /* State of feature @_featureId of source @_sourceId, the default state when not set */
+    FeatureState get(int32_t _sourceId, const std::string& _featureId) const;
+
+    void clear();
+
+    /* Incremented by each change of a state */
+    uint32_t generation() const { return m_generation; }
+
+private:
+
+    mutable std::mutex m_mutex;
+    std::map<std::pair<int32_t, std::string>, FeatureState> m_states;
+    std::atomic<uint32_t> m_generation{0};
+};
+
+}
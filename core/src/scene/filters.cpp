@@ -4,6 +4,7 @@
 #include "log.h"
 #include "scene/styleContext.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace Tangram {
@@ -34,6 +35,11 @@ std::string filterKeywordToString(FilterKeyword keyword) {
     }
 }
 
+uint32_t Filter::internValue(const Value& _value) {
+    if (_value.is<std::string>()) { return InternTable::intern(_value.get<std::string>()); }
+    return InternTable::NONE;
+}
+
 void Filter::print(int _indent) const {
 
     switch (data.which()) {
@@ -382,26 +388,39 @@ struct matcher {
         return true;
     }
     bool operator() (const Filter::Existence& f) const {
-        return f.exists == props.contains(f.key);
+        return f.exists == !props.get(f.key, f.keyAtom).is<none_type>();
     }
     bool operator() (const Filter::EqualitySet& f) const {
-        auto& value = (f.keyword == FilterKeyword::undefined)
-            ? props.get(f.key)
-            : ctx.getKeyword(f.keyword);
+        if (f.keyword != FilterKeyword::undefined) {
+            return Value::visit(ctx.getKeyword(f.keyword), match_equal_set{f.values});
+        }
+
+        uint32_t valueAtom;
+        auto& value = props.get(f.key, f.keyAtom, &valueAtom);
 
+        // interned strings are equal when their atoms are
+        if (valueAtom != InternTable::NONE) {
+            return std::find(f.valueAtoms.begin(), f.valueAtoms.end(), valueAtom) != f.valueAtoms.end();
+        }
         return Value::visit(value, match_equal_set{f.values});
     }
     bool operator() (const Filter::Equality& f) const {
-        auto& value = (f.keyword == FilterKeyword::undefined)
-            ? props.get(f.key)
-            : ctx.getKeyword(f.keyword);
+        if (f.keyword != FilterKeyword::undefined) {
+            return Value::visit(ctx.getKeyword(f.keyword), match_equal{f.value});
+        }
+
+        uint32_t valueAtom;
+        auto& value = props.get(f.key, f.keyAtom, &valueAtom);
 
+        if (valueAtom != InternTable::NONE && f.valueAtom != InternTable::NONE) {
+            return valueAtom == f.valueAtom;
+        }
         return Value::visit(value, match_equal{f.value});
     }
     bool operator() (const Filter::Range& f) const {
         auto scale = (f.hasPixelArea) ? ctx.getPixelAreaScale() : 1.f;
         auto& value = (f.keyword == FilterKeyword::undefined)
-            ? props.get(f.key)
+            ? props.get(f.key, f.keyAtom)
             : ctx.getKeyword(f.keyword);
         return Value::visit(value, match_range{f, scale});
     }
@@ -420,4 +439,119 @@ bool Filter::eval(const Feature& feat, StyleContext& ctx) const {
     return Data::visit(data, matcher(feat, ctx));
 }
 
+FilterProgram::FilterProgram(const Filter& _filter) {
+    compile(_filter);
+}
+
+void FilterProgram::emit(Op _op, uint32_t _arg, bool _value) {
+    m_code.push_back({ _op, _value, _arg });
+}
+
+void FilterProgram::compile(const Filter& _filter) {
+
+    const auto& data = _filter.data;
+
+    switch (data.which()) {
+
+    case Filter::Data::type<Filter::OperatorAll>::value:
+    case Filter::Data::type<Filter::OperatorAny>::value:
+    case Filter::Data::type<Filter::OperatorNone>::value: {
+        const auto& operands = _filter.operands();
+        bool all = data.is<Filter::OperatorAll>();
+
+        if (operands.empty()) {
+            // 'none' negates the result of an empty 'any'
+            emit(Op::constant, 0, all);
+        } else {
+            // Operands are already sorted by cost; the result of the last one is the result
+            // of the operator, the others jump to its end when they decide it
+            std::vector<size_t> jumps;
+            for (size_t i = 0; i < operands.size(); i++) {
+                compile(operands[i]);
+                if (i + 1 < operands.size()) {
+                    jumps.push_back(m_code.size());
+                    emit(all ? Op::jump_if_false : Op::jump_if_true);
+                }
+            }
+            for (auto jump : jumps) { m_code[jump].arg = uint32_t(m_code.size()); }
+        }
+        if (data.is<Filter::OperatorNone>()) { emit(Op::negate); }
+        break;
+    }
+    case Filter::Data::type<Filter::Boolean>::value:
+        emit(Op::constant, 0, data.get<Filter::Boolean>().value);
+        break;
+
+    case Filter::Data::type<none_type>::value:
+        emit(Op::constant, 0, true);
+        break;
+
+    case Filter::Data::type<Filter::EqualitySet>::value: {
+        const auto& f = data.get<Filter::EqualitySet>();
+        bool strings = std::all_of(f.values.begin(), f.values.end(),
+                                   [](const Value& v) { return v.is<std::string>(); });
+
+        if (f.keyword == FilterKeyword::undefined && strings &&
+            f.values.size() >= MIN_HASHED_SET_SIZE) {
+            StringSet set{ f.key, f.keyAtom, {}, {} };
+            for (size_t i = 0; i < f.values.size(); i++) {
+                set.strings.insert(f.values[i].get<std::string>());
+                if (i < f.valueAtoms.size()) { set.atoms.insert(f.valueAtoms[i]); }
+            }
+            emit(Op::test_set, uint32_t(m_sets.size()));
+            m_sets.push_back(std::move(set));
+            break;
+        }
+        emit(Op::test, uint32_t(m_tests.size()));
+        m_tests.push_back(data);
+        break;
+    }
+    default:
+        emit(Op::test, uint32_t(m_tests.size()));
+        m_tests.push_back(data);
+        break;
+    }
+}
+
+bool FilterProgram::eval(const Feature& _feature, StyleContext& _ctx) const {
+
+    matcher match(_feature, _ctx);
+    bool result = true;
+
+    size_t pc = 0;
+    while (pc < m_code.size()) {
+        const auto& in = m_code[pc++];
+
+        switch (in.op) {
+        case Op::constant:
+            result = in.value;
+            break;
+        case Op::test:
+            result = match.eval(m_tests[in.arg]);
+            break;
+        case Op::test_set: {
+            const auto& set = m_sets[in.arg];
+            uint32_t valueAtom;
+            auto& value = _feature.props.get(set.key, set.keyAtom, &valueAtom);
+            if (valueAtom != InternTable::NONE) {
+                result = set.atoms.count(valueAtom) != 0;
+            } else {
+                result = value.is<std::string>() && set.strings.count(value.get<std::string>()) != 0;
+            }
+            break;
+        }
+        case Op::negate:
+            result = !result;
+            break;
+        case Op::jump_if_true:
+            if (result) { pc = in.arg; }
+            break;
+        case Op::jump_if_false:
+            if (!result) { pc = in.arg; }
+            break;
+        }
+    }
+    return result;
+}
+
 }
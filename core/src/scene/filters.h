@@ -1,9 +1,11 @@
 #pragma once
 
+#include "util/internTable.h"
 #include "util/variant.h"
 
 #include <cstdint>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 namespace Tangram {
@@ -35,15 +37,20 @@ struct Filter {
         std::vector<Filter> operands;
     };
 
+    // keyAtom and valueAtoms are the InternTable atoms of key and of string values
     struct EqualitySet {
         std::string key;
         std::vector<Value> values;
         FilterKeyword keyword;
+        uint32_t keyAtom = InternTable::NONE;
+        std::vector<uint32_t> valueAtoms;
     };
     struct Equality {
         std::string key;
         Value value;
         FilterKeyword keyword;
+        uint32_t keyAtom = InternTable::NONE;
+        uint32_t valueAtom = InternTable::NONE;
     };
     struct Range {
         std::string key;
@@ -51,10 +58,12 @@ struct Filter {
         float max;
         FilterKeyword keyword;
         bool hasPixelArea;
+        uint32_t keyAtom = InternTable::NONE;
     };
     struct Existence {
         std::string key;
         bool exists;
+        uint32_t keyAtom = InternTable::NONE;
     };
     struct Function {
         uint32_t id;
@@ -95,18 +104,20 @@ struct Filter {
     // Create an 'equality' filter
     inline static Filter MatchEquality(const std::string& k, const std::vector<Value>& vals) {
         if (vals.size() == 1) {
-            return { Equality{k, vals[0], stringToFilterKeyword(k) }};
+            return { Equality{k, vals[0], stringToFilterKeyword(k), InternTable::intern(k), internValue(vals[0]) }};
         } else {
-            return { EqualitySet{k, vals, stringToFilterKeyword(k) }};
+            std::vector<uint32_t> atoms;
+            for (const auto& val : vals) { atoms.push_back(internValue(val)); }
+            return { EqualitySet{k, vals, stringToFilterKeyword(k), InternTable::intern(k), std::move(atoms) }};
         }
     }
     // Create a 'range' filter
     inline static Filter MatchRange(const std::string& k, float min, float max, bool sqA) {
-        return { Range{k, min, max, stringToFilterKeyword(k), sqA }};
+        return { Range{k, min, max, stringToFilterKeyword(k), sqA, InternTable::intern(k) }};
     }
     // Create an 'existence' filter
     inline static Filter MatchExistence(const std::string& k, bool ex) {
-        return { Existence{ k, ex }};
+        return { Existence{ k, ex, InternTable::intern(k) }};
     }
     // Create an 'function' filter with reference to Scene function id
     inline static Filter MatchFunction(uint32_t id) {
@@ -117,6 +128,9 @@ struct Filter {
         return { Boolean{ val }};
     }
 
+    // Atom of a string value, interning it, or InternTable::NONE for other values
+    static uint32_t internValue(const Value& _value);
+
     /* Public for testing */
     static void sort(std::vector<Filter>& filters);
     void print(int _indent = 0) const;
@@ -128,4 +142,57 @@ struct Filter {
     bool isValid() const { return !data.is<none_type>(); }
     operator bool() const { return isValid(); }
 };
+
+/* Filter compiled to a flat list of instructions
+ *
+ * Operators become jumps past their remaining operands once the result is known, so that a
+ * filter is evaluated in one loop instead of visiting the tree recursively. Equality sets of
+ * many strings are looked up in hash sets of the atoms and strings of their values.
+ */
+class FilterProgram {
+
+public:
+
+    // Equality sets with at least this many string values use a hash lookup
+    static constexpr size_t MIN_HASHED_SET_SIZE = 8;
+
+    FilterProgram() {}
+    explicit FilterProgram(const Filter& _filter);
+
+    bool eval(const Feature& _feature, StyleContext& _ctx) const;
+
+    size_t size() const { return m_code.size(); }
+
+private:
+
+    enum class Op : uint8_t {
+        constant,      // result = value
+        test,          // result = m_tests[arg]
+        test_set,      // result = value of m_sets[arg].key in the set
+        negate,        // result = !result
+        jump_if_true,  // continue at arg if result
+        jump_if_false, // continue at arg if !result
+    };
+
+    struct Instruction {
+        Op op;
+        bool value;
+        uint32_t arg;
+    };
+
+    struct StringSet {
+        std::string key;
+        uint32_t keyAtom;
+        std::unordered_set<uint32_t> atoms;
+        std::unordered_set<std::string> strings;
+    };
+
+    void compile(const Filter& _filter);
+    void emit(Op _op, uint32_t _arg = 0, bool _value = false);
+
+    std::vector<Instruction> m_code;
+    std::vector<Filter::Data> m_tests;
+    std::vector<StringSet> m_sets;
+};
+
 }
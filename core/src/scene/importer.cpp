@@ -2,7 +2,7 @@
 
 #include "log.h"
 #include "platform.h"
-#include "util/asyncWorker.h"
+#include "util/ioExecutor.h"
 #include "util/yamlUtil.h"
 #include "util/zipArchive.h"
 
@@ -16,7 +16,21 @@ using YAML::NodeType;
 namespace Tangram {
 
 Importer::Importer() {}
-Importer::~Importer() {}
+
+Importer::~Importer() {
+    // Prefetch callbacks refer to this Importer: cancel the requests that are still pending,
+    // which runs their callbacks right away.
+    std::vector<UrlRequestHandle> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_resourceMutex);
+        for (auto& entry : m_resources) {
+            if (!entry.second.done && entry.second.handle) {
+                pending.push_back(entry.second.handle);
+            }
+        }
+    }
+    for (auto handle : pending) { m_platform->cancelUrlRequest(handle); }
+}
 
 YAML::Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, const std::string& _sceneYaml) {
 
@@ -24,14 +38,37 @@ YAML::Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, co
     std::vector<UrlRequestHandle> urlRequests;
     unsigned int activeDownloads = 0;  // protected by m_sceneMutex
 
+    m_platform = &_platform;
+
     if (!_sceneYaml.empty()) {
         // Load scene from yaml string.
-        addSceneYaml(_sceneUrl, _sceneYaml.data(), _sceneYaml.length());
+        auto sceneNode = parseSceneYaml(_sceneUrl, _sceneYaml.data(), _sceneYaml.length());
+        prefetchResources(sceneNode.resourceUrls);
+        addSceneNode(_sceneUrl, std::move(sceneNode));
     } else {
         // Load scene from yaml file.
         m_sceneQueue.push_back(_sceneUrl);
     }
 
+    // Store a scene file that was read (or failed to be read) and queue its imports
+    auto addScene = [&](const Url& url, SceneNode&& sceneNode, std::shared_ptr<ZipArchive>&& zipArchive,
+                        uint64_t hash, bool loaded) {
+        std::unique_lock<std::mutex> lock(m_sceneMutex);
+        if (loaded) {
+            m_sceneSources.push_back({ url, hash });
+        } else {
+            m_sceneSourceError = true;
+        }
+        if (zipArchive) {
+            m_zipArchives.emplace(url, std::move(zipArchive));
+        }
+        addSceneNode(url, std::move(sceneNode));
+        activeDownloads--;
+        m_sceneCond.notify_one();
+    };
+
+    // Requests for all imports known so far are started at once; each file is parsed on the
+    // thread that receives it, so only storing the result and queueing its imports is serialized.
     // we no longer wait for every callback to run (so activeDownloads == 0) when canceled - we only expect
     //  all callbacks to be called or removed by Platform before Importer is destroyed
     while (true) {
@@ -46,6 +83,9 @@ YAML::Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, co
             nextUrlToImport = m_sceneQueue.back();
             m_sceneQueue.pop_back();
 
+            // Skip URLs that were queued by more than one scene
+            if (m_sceneNodes.find(nextUrlToImport) != m_sceneNodes.end()) { continue; }
+
             // Mark Url as going-to-be-imported to prevent duplicate work.
             m_sceneNodes.emplace(nextUrlToImport, SceneNode{});
             activeDownloads++;
@@ -54,19 +94,35 @@ YAML::Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, co
         // unlock m_sceneMutex before starting request because callback could be sync or async
         auto cb = [&, nextUrlToImport](UrlResponse&& response) {
             if (m_canceled) { return; }
-            std::unique_lock<std::mutex> _lock(m_sceneMutex);
+            SceneNode sceneNode;
+            std::shared_ptr<ZipArchive> zipArchive;
+            uint64_t hash = 0;
             if (response.error) {
                 LOGE("Unable to retrieve '%s': %s", nextUrlToImport.string().c_str(),
                      response.error);
             } else {
-                addSceneData(nextUrlToImport, std::move(response.content));
+                hash = SceneSnapshot::hash(response.content);
+                sceneNode = parseSceneData(nextUrlToImport, std::move(response.content), zipArchive);
+                if (!m_canceled) { prefetchResources(sceneNode.resourceUrls); }
             }
-            activeDownloads--;
-            m_sceneCond.notify_one();
+            addScene(nextUrlToImport, std::move(sceneNode), std::move(zipArchive), hash, !response.error);
         };
 
         if (nextUrlToImport.scheme() == "zip") {
             readFromZip(nextUrlToImport, cb);
+        } else if (isMappedZipArchiveUrl(nextUrlToImport)) {
+            mapZipArchive(nextUrlToImport, [&, nextUrlToImport](std::shared_ptr<ZipArchive> zipArchive, uint64_t hash) {
+                if (m_canceled) { return; }
+                SceneNode sceneNode;
+                if (!zipArchive) {
+                    LOGE("Unable to load zip archive '%s'", nextUrlToImport.string().c_str());
+                } else {
+                    sceneNode = parseSceneArchive(nextUrlToImport, *zipArchive);
+                    if (!m_canceled) { prefetchResources(sceneNode.resourceUrls); }
+                }
+                bool loaded = bool(zipArchive);
+                addScene(nextUrlToImport, std::move(sceneNode), std::move(zipArchive), hash, loaded);
+            });
         } else {
             urlRequests.push_back(_platform.startUrlRequest(nextUrlToImport, cb));
         }
@@ -105,64 +161,185 @@ YAML::Node Importer::loadSceneData(Platform& _platform, const Url& _sceneUrl, co
     return root;
 }
 
+bool Importer::getSceneSources(std::vector<SceneSnapshot::Source>& _sources) const {
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+    _sources = m_sceneSources;
+    return !m_sceneSourceError;
+}
+
+bool Importer::checkSceneSources(Platform& _platform, const std::vector<SceneSnapshot::Source>& _sources) {
+
+    std::vector<UrlRequestHandle> urlRequests;
+    unsigned int activeDownloads = 0;  // protected by m_sceneMutex
+    bool valid = true;  // protected by m_sceneMutex
+
+    m_platform = &_platform;
+
+    // Entries of zip archives are read once the archives are loaded
+    for (bool zipEntries : { false, true }) {
+        for (const auto& source : _sources) {
+            if ((source.url.scheme() == "zip") != zipEntries) { continue; }
+            {
+                std::lock_guard<std::mutex> lock(m_sceneMutex);
+                if (!valid || m_canceled) { break; }
+                activeDownloads++;
+            }
+
+            auto checked = [&, source](std::shared_ptr<ZipArchive>&& zipArchive, bool unchanged) {
+                std::unique_lock<std::mutex> lock(m_sceneMutex);
+                if (zipArchive && unchanged) {
+                    m_zipArchives.emplace(source.url, std::move(zipArchive));
+                }
+                if (!unchanged) { valid = false; }
+                activeDownloads--;
+                m_sceneCond.notify_one();
+            };
+
+            // unlock m_sceneMutex before starting request because callback could be sync or async
+            auto cb = [&, source, checked](UrlResponse&& response) {
+                if (m_canceled) { return; }
+                bool unchanged = !response.error && SceneSnapshot::hash(response.content) == source.hash;
+                std::shared_ptr<ZipArchive> zipArchive;
+                if (unchanged && isZipArchiveUrl(source.url)) {
+                    zipArchive = std::make_shared<ZipArchive>();
+                    zipArchive->loadFromMemory(std::move(response.content));
+                }
+                checked(std::move(zipArchive), unchanged);
+            };
+
+            if (zipEntries) {
+                readFromZip(source.url, cb);
+            } else if (isMappedZipArchiveUrl(source.url)) {
+                mapZipArchive(source.url, [&, source, checked](std::shared_ptr<ZipArchive> zipArchive, uint64_t hash) {
+                    if (m_canceled) { return; }
+                    bool unchanged = zipArchive && hash == source.hash;
+                    checked(std::move(zipArchive), unchanged);
+                });
+            } else {
+                urlRequests.push_back(_platform.startUrlRequest(source.url, cb));
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(m_sceneMutex);
+        m_sceneCond.wait(lock, [&](){ return activeDownloads == 0 || m_canceled; });
+        if (!valid || m_canceled) { break; }
+    }
+
+    if (m_canceled) {
+        // clear all callbacks before captures go out of scope!
+        for (auto& req : urlRequests) { _platform.cancelUrlRequest(req); }
+        m_zipWorker.reset();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+    return valid;
+}
+
 void Importer::cancelLoading() {  //Platform& _platform) {
     std::unique_lock<std::mutex> lock(m_sceneMutex);
     m_canceled = true;
     m_sceneCond.notify_all();
 }
 
-void Importer::addSceneData(const Url& sceneUrl, std::vector<char>&& sceneData) {
+Importer::SceneNode Importer::parseSceneData(const Url& sceneUrl, std::vector<char>&& sceneData,
+                                             std::shared_ptr<ZipArchive>& zipArchive) {
     LOGD("Process: '%s'", sceneUrl.string().c_str());
 
     if (!isZipArchiveUrl(sceneUrl)) {
-        addSceneYaml(sceneUrl, sceneData.data(), sceneData.size());
-        return;
+        return parseSceneYaml(sceneUrl, sceneData.data(), sceneData.size());
     }
 
     // We're loading a scene from a zip archive
     // First, create an archive from the data.
-    auto zipArchive = std::make_shared<ZipArchive>();
+    zipArchive = std::make_shared<ZipArchive>();
     zipArchive->loadFromMemory(std::move(sceneData));
 
+    return parseSceneArchive(sceneUrl, *zipArchive);
+}
+
+Importer::SceneNode Importer::parseSceneArchive(const Url& sceneUrl, ZipArchive& zipArchive) {
+
     // Find the "base" scene file in the archive entries.
-    for (const auto& entry : zipArchive->entries()) {
+    for (const auto& entry : zipArchive.entries()) {
         auto ext = Url::getPathExtension(entry.path);
         // The "base" scene file must have extension "yaml" or "yml" and be
         // at the root directory of the archive (i.e. no '/' in path).
         if ((ext == "yaml" || ext == "yml") && entry.path.find('/') == std::string::npos) {
-            // Found the base, now extract the contents to the scene string.
+            // Found the base, parse it in place if it is stored, else extract the contents
+            // to the scene string.
+            if (const char* yaml = zipArchive.entryData(&entry)) {
+                return parseSceneYaml(sceneUrl, yaml, entry.uncompressedSize);
+            }
             std::vector<char> yaml;
             yaml.resize(entry.uncompressedSize);
 
-            zipArchive->decompressEntry(&entry, &yaml[0]);
+            zipArchive.decompressEntry(&entry, &yaml[0]);
 
-            addSceneYaml(sceneUrl, yaml.data(), yaml.size());
-            break;
+            return parseSceneYaml(sceneUrl, yaml.data(), yaml.size());
         }
     }
 
-    m_zipArchives.emplace(sceneUrl, zipArchive);
+    return SceneNode{};
+}
+
+bool Importer::isMappedZipArchiveUrl(const Url& url) {
+    // Assets are bundled with the app, see Platform::mapResource()
+    return isZipArchiveUrl(url) && (url.hasFileScheme() || url.scheme() == "asset");
+}
+
+void Importer::mapZipArchive(const Url& url, ZipArchiveCallback callback) {
+
+    if (!m_zipWorker) {
+        m_zipWorker = std::make_unique<IOQueue>();
+    }
+
+    m_zipWorker->enqueue([this, url, callback](){
+        auto zipArchive = std::make_shared<ZipArchive>();
+        if (!zipArchive->loadFromMapping(m_platform->mapResource(url))) {
+            callback(nullptr, 0);
+            return;
+        }
+        // The central directory records the size and CRC of each entry: hash these instead
+        // of reading the whole archive.
+        std::vector<char> directory;
+        for (const auto& entry : zipArchive->entries()) {
+            auto size = reinterpret_cast<const char*>(&entry.uncompressedSize);
+            auto crc = reinterpret_cast<const char*>(&entry.crc32);
+            directory.insert(directory.end(), entry.path.begin(), entry.path.end());
+            directory.insert(directory.end(), size, size + sizeof(entry.uncompressedSize));
+            directory.insert(directory.end(), crc, crc + sizeof(entry.crc32));
+        }
+        callback(std::move(zipArchive), SceneSnapshot::hash(directory));
+    });
+}
+
+std::shared_ptr<ZipArchive> Importer::findZipArchive(const Url& zipEntryUrl) {
+    // URL for a file in a zip archive, get the encoded source URL.
+    auto source = Importer::getArchiveUrlForZipEntry(zipEntryUrl);
+    // Search for the source URL in our archive map.
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+    auto it = m_zipArchives.find(source);
+    if (it != m_zipArchives.end()) { return it->second; }
+    return nullptr;
 }
 
 UrlRequestHandle Importer::readFromZip(const Url& url, UrlCallback callback) {
 
     if (!m_zipWorker) {
-        m_zipWorker = std::make_unique<AsyncWorker>("Importer zip worker");
+        m_zipWorker = std::make_unique<IOQueue>();
         //m_zipWorker->waitForCompletion();
     }
 
     m_zipWorker->enqueue([=](){
         UrlResponse response;
-        // URL for a file in a zip archive, get the encoded source URL.
-        auto source = Importer::getArchiveUrlForZipEntry(url);
-        // Search for the source URL in our archive map.
-        auto it = m_zipArchives.find(source);
-        if (it != m_zipArchives.end()) {
-            auto& archive = it->second;
+        auto archive = findZipArchive(url);
+        if (archive) {
             // Found the archive! Now create a response for the request.
             auto zipEntryPath = url.path().substr(1);
             auto entry = archive->findEntry(zipEntryPath);
             if (entry) {
+                // Deflated entries are inflated directly into the response.
                 response.content.resize(entry->uncompressedSize);
                 bool success = archive->decompressEntry(entry, response.content.data());
                 if (!success) {
@@ -179,30 +356,140 @@ UrlRequestHandle Importer::readFromZip(const Url& url, UrlCallback callback) {
     return 0;
 }
 
-void Importer::addSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length) {
+void Importer::readZipEntry(const Url& url, ZipEntryCallback callback) {
 
-    auto& sceneNode = m_sceneNodes[sceneUrl];
+    if (!m_zipWorker) {
+        m_zipWorker = std::make_unique<IOQueue>();
+        //m_zipWorker->waitForCompletion();
+    }
+
+    m_zipWorker->enqueue([this, url, callback](){
+        auto archive = findZipArchive(url);
+        if (!archive) {
+            callback(nullptr, 0, "Could not find zip archive.");
+            return;
+        }
+        // Found the archive! Now read the entry.
+        auto zipEntryPath = url.path().substr(1);
+        auto entry = archive->findEntry(zipEntryPath);
+        if (!entry) {
+            callback(nullptr, 0, "Did not find zip archive entry.");
+            return;
+        }
+        if (const char* data = archive->entryData(entry)) {
+            callback(data, entry->uncompressedSize, nullptr);
+            return;
+        }
+        std::vector<char> data(entry->uncompressedSize);
+        if (!archive->decompressEntry(entry, data.data())) {
+            callback(nullptr, 0, "Unable to decompress zip archive file.");
+            return;
+        }
+        callback(data.data(), data.size(), nullptr);
+    });
+}
+
+UrlRequestHandle Importer::readResource(const Url& url, UrlCallback callback) {
+
+    if (url.scheme() == "zip") {
+        return readFromZip(url, std::move(callback));
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_resourceMutex);
+        auto it = m_resources.find(url);
+        if (it != m_resources.end() && !it->second.claimed) {
+            auto& resource = it->second;
+            resource.claimed = true;
+            if (!resource.done) {
+                // Response is handed over when it arrives
+                resource.callback = std::move(callback);
+                return resource.handle;
+            }
+            UrlResponse response;
+            response.content = std::move(resource.content);
+            if (resource.failed) { response.error = resource.error.c_str(); }
+            lock.unlock();
+            callback(std::move(response));
+            return 0;
+        }
+    }
+
+    return m_platform->startUrlRequest(url, std::move(callback));
+}
+
+void Importer::prefetchResources(const std::vector<Url>& urls) {
+
+    for (const auto& url : urls) {
+        // Zip entries are read once the archive is available, see readFromZip()
+        if (url.scheme() == "zip") { continue; }
+
+        {
+            std::lock_guard<std::mutex> lock(m_resourceMutex);
+            if (!m_resources.emplace(url, Resource{}).second) { continue; }
+        }
+
+        LOGD("Prefetch: '%s'", url.string().c_str());
+
+        // unlock m_resourceMutex before starting request because callback could be sync or async
+        auto handle = m_platform->startUrlRequest(url, [this, url](UrlResponse&& response) {
+            UrlCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(m_resourceMutex);
+                auto& resource = m_resources[url];
+                resource.done = true;
+                if (!resource.callback) {
+                    resource.content = std::move(response.content);
+                    if (response.error) {
+                        resource.error = response.error;
+                        resource.failed = true;
+                    }
+                    return;
+                }
+                callback = std::move(resource.callback);
+            }
+            callback(std::move(response));
+        });
+
+        std::lock_guard<std::mutex> lock(m_resourceMutex);
+        auto& resource = m_resources[url];
+        if (!resource.done) { resource.handle = handle; }
+    }
+}
+
+Importer::SceneNode Importer::parseSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length) {
+
+    SceneNode sceneNode;
 
     sceneNode.yaml = YAML::Load(sceneYaml, length);
 
     if (!sceneNode.yaml.IsMap()) {
         LOGE("Scene is not a valid YAML map: %s", sceneUrl.string().c_str());
-        return;
+        return sceneNode;
     }
 
     sceneNode.imports = getResolvedImportUrls(sceneNode.yaml, sceneUrl);
 
     sceneNode.pendingUrlNodes = getTextureUrlNodes(sceneNode.yaml);
 
+    sceneNode.resourceUrls = getResourceUrls(sceneNode.yaml, sceneUrl);
+
     // Remove 'import' values so they don't get merged.
     sceneNode.yaml.remove("import");
 
+    return sceneNode;
+}
+
+void Importer::addSceneNode(const Url& sceneUrl, SceneNode&& sceneNode) {
+
     for (const auto& url : sceneNode.imports) {
         // Check if this scene URL has been (or is going to be) imported already
         if (m_sceneNodes.find(url) == m_sceneNodes.end()) {
             m_sceneQueue.push_back(url);
         }
     }
+
+    m_sceneNodes[sceneUrl] = std::move(sceneNode);
 }
 
 std::vector<Url> Importer::getResolvedImportUrls(const Node& sceneNode, const Url& baseUrl) {
@@ -367,6 +654,51 @@ std::vector<const YAML::Node*> Importer::getTextureUrlNodes(const Node& root) {
     return nodes;
 }
 
+std::vector<Url> Importer::getResourceUrls(const Node& sceneNode, const Url& baseUrl) {
+
+    std::vector<Url> urls;
+
+    auto base = baseUrl;
+    if (isZipArchiveUrl(baseUrl)) {
+        base = getBaseUrlForZipArchive(baseUrl);
+    }
+
+    auto addUrl = [&](const Node& urlNode) {
+        if (nodeIsPotentialUrl(urlNode)) {
+            urls.push_back(base.resolve(Url(urlNode.Scalar())));
+        }
+    };
+
+    // Global textures; textures given inline in styles may instead name a texture of another
+    // scene file, these are only known after merging.
+
+    if (const Node& textures = sceneNode["textures"]) {
+        if (textures.IsMap()) {
+            for (const auto& texture : textures.pairs()) {
+                if (texture.second.IsMap()) { addUrl(texture.second["url"]); }
+            }
+        }
+    }
+
+    // Fonts
+
+    if (const Node& fonts = sceneNode["fonts"]) {
+        if (fonts.IsMap()) {
+            for (const auto& font : fonts.pairs()) {
+                if (font.second.IsMap()) {
+                    addUrl(font.second["url"]);
+                } else if (font.second.IsSequence()) {
+                    for (const auto& fontNode : font.second) {
+                        if (fontNode.IsMap()) { addUrl(fontNode["url"]); }
+                    }
+                }
+            }
+        }
+    }
+
+    return urls;
+}
+
 void Importer::resolveSceneUrls(Node& root, const Url& baseUrl) {
 
     auto base = baseUrl;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "platform.h"
+#include "scene/sceneSnapshot.h"
 
 #include "gaml/src/yaml.h"
 
@@ -8,6 +9,7 @@
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -15,7 +17,7 @@
 
 namespace Tangram {
 
-class AsyncWorker;
+class IOQueue;
 class SceneOptions;
 class ZipArchive;
 class Url;
@@ -33,6 +35,14 @@ public:
 
     void cancelLoading();
 
+    // Get the URLs and content hashes of the scene files read by loadSceneData(); returns
+    // false if any of them could not be read.
+    bool getSceneSources(std::vector<SceneSnapshot::Source>& sources) const;
+
+    // Read the scene files of a SceneSnapshot instead of loadSceneData(); returns true if all
+    // of them are unchanged. Zip archives among them are kept for readFromZip().
+    bool checkSceneSources(Platform& platform, const std::vector<SceneSnapshot::Source>& sources);
+
     static bool isZipArchiveUrl(const Url& url);
 
     static Url getBaseUrlForZipArchive(const Url& archiveUrl);
@@ -58,20 +68,19 @@ public:
     // requested.
     UrlRequestHandle readFromZip(const Url& url, UrlCallback callback);
 
-protected:
-
-    // Process and store data for an imported scene from a vector of bytes.
-    void addSceneData(const Url& sceneUrl, std::vector<char>&& sceneContent);
+    // Read a file from a zip archive like readFromZip(), but without copying it into a
+    // UrlResponse: @callback gets a view of entries that are stored without compression, or
+    // a buffer that deflated entries are inflated into. @data is only valid during the call,
+    // @error is set if the entry could not be read.
+    using ZipEntryCallback = std::function<void(const char* data, size_t size, const char* error)>;
+    void readZipEntry(const Url& url, ZipEntryCallback callback);
 
-    // Process and store data for an imported scene from a string of YAML.
-    void addSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length);
-
-    // Get the sequence of scene names that are designated to be imported into the
-    // input scene node by its 'import' fields.
-    std::vector<Url> getResolvedImportUrls(const Node& sceneNode, const Url& base);
+    // Start an asynchronous request for a font or texture of the scene. Takes over the
+    // response of the prefetch started for @url during import if there is one, otherwise
+    // reads from a zip archive or starts a new request on the platform.
+    UrlRequestHandle readResource(const Url& url, UrlCallback callback);
 
-    // loads all the imported scenes and the master scene and returns a unified YAML root node.
-    void importScenesRecursive(Node& root, const Url& sceneUrl, std::unordered_set<Url>& imported);
+protected:
 
     // Scene files must be parsed into YAML nodes to find further imports.
     // The parsed scenes are stored in a map with their URLs to be merged once
@@ -80,20 +89,80 @@ protected:
         YAML::Node yaml{};
         std::vector<Url> imports;
         std::vector<const YAML::Node*> pendingUrlNodes;
+        std::vector<Url> resourceUrls;
     };
+
+    // Parse data for an imported scene from a vector of bytes. This does not touch shared
+    // state other than the zip archive it may return, so that it can run on any thread.
+    SceneNode parseSceneData(const Url& sceneUrl, std::vector<char>&& sceneContent,
+                             std::shared_ptr<ZipArchive>& zipArchive);
+
+    // Parse the base scene file of a zip archive.
+    SceneNode parseSceneArchive(const Url& sceneUrl, ZipArchive& zipArchive);
+
+    // Zip archives from local files are memory mapped instead of read by the platform.
+    static bool isMappedZipArchiveUrl(const Url& url);
+
+    // Map the zip archive at @url on the zip worker; @callback gets the archive, or null if
+    // it could not be loaded, and a hash of its entries for SceneSnapshot.
+    using ZipArchiveCallback = std::function<void(std::shared_ptr<ZipArchive> zipArchive, uint64_t hash)>;
+    void mapZipArchive(const Url& url, ZipArchiveCallback callback);
+
+    // Get the loaded zip archive with the entry at @zipEntryUrl.
+    std::shared_ptr<ZipArchive> findZipArchive(const Url& zipEntryUrl);
+
+    // Parse data for an imported scene from a string of YAML.
+    SceneNode parseSceneYaml(const Url& sceneUrl, const char* sceneYaml, size_t length);
+
+    // Store a parsed scene and queue its imports, m_sceneMutex must be held.
+    void addSceneNode(const Url& sceneUrl, SceneNode&& sceneNode);
+
+    // Get the font and texture URLs of a scene file, resolved like resolveSceneUrls() would.
+    static std::vector<Url> getResourceUrls(const Node& sceneNode, const Url& base);
+
+    // Start requests for @urls, to be taken over by readResource().
+    void prefetchResources(const std::vector<Url>& urls);
+
+    // Get the sequence of scene names that are designated to be imported into the
+    // input scene node by its 'import' fields.
+    std::vector<Url> getResolvedImportUrls(const Node& sceneNode, const Url& base);
+
+    // loads all the imported scenes and the master scene and returns a unified YAML root node.
+    void importScenesRecursive(Node& root, const Url& sceneUrl, std::unordered_set<Url>& imported);
+
     std::unordered_map<Url, SceneNode> m_sceneNodes = {};
 
     std::vector<Url> m_sceneQueue = {};
 
+    // Scene files read by loadSceneData(), for SceneSnapshot
+    std::vector<SceneSnapshot::Source> m_sceneSources;
+    bool m_sceneSourceError = false;
+
     std::atomic<bool> m_canceled{false};
-    std::mutex m_sceneMutex;
+    mutable std::mutex m_sceneMutex;
     std::condition_variable m_sceneCond;
 
     // Container for any zip archives needed for the scene. For each entry, the
     // key is the original URL from which the zip archive was retrieved and the
     // value is a ZipArchive initialized with the compressed archive data.
     std::unordered_map<Url, std::shared_ptr<ZipArchive>> m_zipArchives;
-    std::unique_ptr<AsyncWorker> m_zipWorker;
+    std::unique_ptr<IOQueue> m_zipWorker;
+
+    // Fonts and textures requested while imports are still loading. The response is kept
+    // until readResource() takes it, or handed to its callback when it arrives later.
+    struct Resource {
+        UrlRequestHandle handle = 0;
+        bool done = false;
+        bool claimed = false;
+        std::vector<char> content;
+        std::string error;
+        bool failed = false;
+        UrlCallback callback;
+    };
+    std::unordered_map<Url, Resource> m_resources;
+    std::mutex m_resourceMutex;
+
+    Platform* m_platform = nullptr;
 };
 
 }
@@ -0,0 +1,206 @@
+#include "scene/renderQueue.h"
+
+#include "gl/renderState.h"
+#include "gl/texture.h"
+#include "marker/marker.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "util/hash.h"
+#include "view/view.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+
+namespace Tangram {
+
+// Bit offsets of the key fields, see RenderQueue
+static constexpr int BLENDED_SHIFT = 63;
+static constexpr int PROGRAM_SHIFT = 50;   // 13 bits
+static constexpr int STYLE_SHIFT = 38;     // 12 bits
+// Opaque styles: 16 bits texture set, 10 bits depth band
+static constexpr int OPAQUE_TEXTURES_SHIFT = 22;
+static constexpr int OPAQUE_DEPTH_SHIFT = 12;
+// Blended styles: 10 bits depth band, 16 bits texture set
+static constexpr int BLENDED_DEPTH_SHIFT = 28;
+static constexpr int BLENDED_TEXTURES_SHIFT = 12;
+// 12 bits tile index
+static constexpr uint64_t TILE_MASK = (uint64_t(1) << STYLE_SHIFT) - 1;
+
+static constexpr uint64_t MAX_PROGRAMS = 1 << 13;
+static constexpr uint64_t MAX_STYLES = 1 << 12;
+static constexpr uint64_t MAX_DEPTH_BAND = (1 << 10) - 1;
+static constexpr uint64_t MAX_TILES = 1 << 12;
+
+// Depth band of @_tile by the distance of its center to the camera, in camera heights / 64
+static uint64_t depthBand(const Tile& _tile, const View& _view) {
+    double scale = _tile.getScale();
+    glm::dvec2 center = _tile.getOrigin() + glm::dvec2(scale * 0.5);
+    const auto& pos = _view.getPosition();
+
+    glm::dvec3 eyeToTile = glm::dvec3(center.x - pos.x, center.y - pos.y, 0.0) - glm::dvec3(_view.getEye());
+    double band = glm::length(eyeToTile) / std::max(pos.z, 1.0) * 64.0;
+
+    return uint64_t(std::min(band, double(MAX_DEPTH_BAND)));
+}
+
+void RenderQueue::clear() {
+    m_items.clear();
+    m_programs.clear();
+    m_textureSets.clear();
+    m_nextProgram = 0;
+}
+
+uint16_t RenderQueue::programRank(const ShaderProgram* _program) {
+    // Programs are built on the first draw; styles without one yet are not grouped
+    if (!_program) { return m_nextProgram++; }
+
+    auto it = m_programs.find(_program);
+    if (it == m_programs.end()) {
+        it = m_programs.emplace(_program, m_nextProgram++).first;
+    }
+    return it->second;
+}
+
+uint16_t RenderQueue::textureRank(size_t _hash) {
+    if (_hash == 0) { return 0; }
+
+    auto it = m_textureSets.find(_hash);
+    if (it == m_textureSets.end()) {
+        it = m_textureSets.emplace(_hash, uint16_t(m_textureSets.size() + 1)).first;
+    }
+    return it->second;
+}
+
+void RenderQueue::push(Style& _style, uint32_t _styleIndex, const View& _view,
+                       const std::vector<std::shared_ptr<Tile>>& _tiles,
+                       const std::vector<std::unique_ptr<Marker>>& _markers) {
+
+    Blending blend = _style.blendMode();
+    bool blended = blend != Blending::opaque;
+    // Overlay styles draw without depth test, in the order of their items
+    bool depthTested = blend != Blending::overlay;
+
+    Item item;
+    item.style = &_style;
+    item.blend = uint8_t(blend);
+    item.program = programRank(_style.shaderProgram());
+
+    uint64_t styleKey = (uint64_t(blended) << BLENDED_SHIFT) |
+        (uint64_t(std::min<uint32_t>(_styleIndex, MAX_STYLES - 1)) << STYLE_SHIFT);
+    if (!blended) {
+        styleKey |= uint64_t(std::min<uint64_t>(item.program, MAX_PROGRAMS - 1)) << PROGRAM_SHIFT;
+    }
+
+    uint64_t tileIndex = 0;
+    for (const auto& tile : _tiles) {
+        if (!tile->isUploaded() || !tile->getMesh(_style)) { continue; }
+
+        size_t textureHash = 0;
+        if (_style.hasRasters()) {
+            for (const auto& raster : tile->rasters()) {
+                if (raster.isValid()) { hash_combine(textureHash, raster.texture->glHandle()); }
+            }
+        }
+
+        item.tile = tile.get();
+        item.textures = textureRank(textureHash);
+
+        uint64_t textures = item.textures;
+        uint64_t tileKey = 0;
+        if (!blended) {
+            tileKey = (textures << OPAQUE_TEXTURES_SHIFT) |
+                (depthBand(*tile, _view) << OPAQUE_DEPTH_SHIFT);
+        } else if (depthTested) {
+            uint64_t band = MAX_DEPTH_BAND - depthBand(*tile, _view);
+            tileKey = (band << BLENDED_DEPTH_SHIFT) | (textures << BLENDED_TEXTURES_SHIFT);
+        }
+        tileKey |= std::min(tileIndex++, MAX_TILES - 1);
+
+        item.key = styleKey | tileKey;
+        m_items.push_back(item);
+    }
+
+    bool hasMarker = std::any_of(_markers.begin(), _markers.end(), [&](const auto& m) {
+        return m->styleId() == _style.getID() && m->mesh();
+    });
+    if (hasMarker) {
+        item.tile = nullptr;
+        item.textures = 0;
+        item.key = styleKey | TILE_MASK;
+        m_items.push_back(item);
+    }
+}
+
+void RenderQueue::sort() {
+    m_stats.items = m_items.size();
+    m_stats.changesUnsorted = countStateChanges(m_items);
+
+    radixSort(m_items, m_scratch);
+
+    m_stats.changesSorted = countStateChanges(m_items);
+}
+
+bool RenderQueue::submit(RenderState& rs, const View& _view,
+                         const std::vector<std::unique_ptr<Marker>>& _markers) {
+
+    bool drawnAnimatedStyle = false;
+    m_stats.styles = 0;
+
+    // Items of a style are consecutive
+    for (size_t i = 0; i < m_items.size();) {
+        Style* style = m_items[i].style;
+
+        m_drawTiles.clear();
+        for (; i < m_items.size() && m_items[i].style == style; i++) {
+            if (m_items[i].tile) { m_drawTiles.push_back(m_items[i].tile); }
+        }
+
+        rs.gpuTimer.begin(style->getName());
+        bool styleDrawn = style->draw(rs, _view, m_drawTiles, _markers);
+        rs.gpuTimer.end();
+
+        drawnAnimatedStyle |= (styleDrawn && style->isAnimated());
+        m_stats.styles++;
+    }
+
+    return drawnAnimatedStyle;
+}
+
+void RenderQueue::radixSort(std::vector<Item>& _items, std::vector<Item>& _scratch) {
+
+    if (_items.size() < 2) { return; }
+
+    _scratch.resize(_items.size());
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t offsets[256] = { 0 };
+        for (const auto& item : _items) { offsets[(item.key >> shift) & 0xff]++; }
+
+        // Skip digits which are the same for all items
+        if (offsets[(_items[0].key >> shift) & 0xff] == _items.size()) { continue; }
+
+        size_t offset = 0;
+        for (auto& count : offsets) {
+            size_t n = count;
+            count = offset;
+            offset += n;
+        }
+        for (const auto& item : _items) {
+            _scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+        }
+        _items.swap(_scratch);
+    }
+}
+
+size_t RenderQueue::countStateChanges(const std::vector<Item>& _items) {
+    size_t changes = 0;
+    for (size_t i = 1; i < _items.size(); i++) {
+        const auto& a = _items[i - 1];
+        const auto& b = _items[i];
+        changes += (a.program != b.program) + (a.textures != b.textures) + (a.blend != b.blend);
+    }
+    return changes;
+}
+
+}
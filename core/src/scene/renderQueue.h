@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class Marker;
+class RenderState;
+class ShaderProgram;
+class Style;
+class Tile;
+class View;
+
+/* Per frame queue of the tile meshes and markers to draw, sorted by render state
+ *
+ * Each item has a sort key made of, from the most significant bits on:
+ *  - the blend class: opaque styles are drawn before all others
+ *  - the shader program of the style, for opaque styles only; blended styles keep the order
+ *    of the scene (blend_order, blend mode and name, see Style::compare)
+ *  - the style, since styles set up their uniforms once for all their items
+ *  - for opaque styles the raster texture set of the tile, then its depth band front to back
+ *    to reject occluded fragments early; for blended styles with depth test the depth band
+ *    back to front, for correct blending, then the texture set
+ *  - the order of the tile in the visible tiles
+ * Markers of a style follow its tiles. Keys are sorted with a radix sort, which keeps the
+ * order of items with equal keys.
+ */
+class RenderQueue {
+
+public:
+
+    struct Item {
+        uint64_t key = 0;
+        Style* style = nullptr;
+        // Null for the markers of the style
+        const Tile* tile = nullptr;
+        // State of the item, to count state changes
+        uint16_t program = 0;
+        uint16_t textures = 0;
+        uint8_t blend = 0;
+    };
+
+    struct Stats {
+        size_t items = 0;             // tile meshes and marker groups in the last frame
+        size_t styles = 0;            // styles drawn in the last frame
+        size_t changesUnsorted = 0;   // program, texture set and blending changes in scene order
+        size_t changesSorted = 0;     // the same changes in the order of the queue
+    };
+
+    void clear();
+
+    /* Add the tiles of @_tiles that have an uploaded mesh of @_style, which is style
+     * @_styleIndex of the scene, and its markers of @_markers */
+    void push(Style& _style, uint32_t _styleIndex, const View& _view,
+              const std::vector<std::shared_ptr<Tile>>& _tiles,
+              const std::vector<std::unique_ptr<Marker>>& _markers);
+
+    void sort();
+
+    /* Draw the items in queue order; returns whether an animated style was drawn */
+    bool submit(RenderState& rs, const View& _view,
+                const std::vector<std::unique_ptr<Marker>>& _markers);
+
+    const std::vector<Item>& items() const { return m_items; }
+
+    const Stats& stats() const { return m_stats; }
+
+    /* Stable sort of @_items by key; @_scratch is used as buffer */
+    static void radixSort(std::vector<Item>& _items, std::vector<Item>& _scratch);
+
+    /* Program, texture set and blending changes between consecutive @_items */
+    static size_t countStateChanges(const std::vector<Item>& _items);
+
+private:
+
+    uint16_t programRank(const ShaderProgram* _program);
+    uint16_t textureRank(size_t _hash);
+
+    std::vector<Item> m_items;
+    std::vector<Item> m_scratch;
+    std::vector<const Tile*> m_drawTiles;
+
+    // Ranks in order of first use in the frame, which keep the keys short
+    std::unordered_map<const ShaderProgram*, uint16_t> m_programs;
+    std::unordered_map<size_t, uint16_t> m_textureSets;
+    uint16_t m_nextProgram = 0;
+
+    Stats m_stats;
+};
+
+}
@@ -2,16 +2,22 @@
 
 #include "data/tileSource.h"
 #include "data/rasterSource.h"
+#include "debug/frameInfo.h"
+#include "debug/trace.h"
 #include "gl/framebuffer.h"
+#include "gl/hardware.h"
 #include "gl/shaderProgram.h"
 #include "labels/labelManager.h"
 #include "marker/markerManager.h"
 #include "scene/dataLayer.h"
+#include "scene/featureStates.h"
 #include "scene/importer.h"
 #include "scene/light.h"
 #include "scene/sceneLoader.h"
+#include "scene/sceneSnapshot.h"
 #include "scene/spriteAtlas.h"
 #include "scene/stops.h"
+#include "scene/tileImpostors.h"
 #include "selection/featureSelection.h"
 #include "selection/selectionQuery.h"
 #include "style/material.h"
@@ -22,16 +28,22 @@
 #include "style/rasterStyle.h"
 #include "style/style.h"
 #include "text/fontContext.h"
+#include "tile/tileCache.h"
+#include "tile/tileDiskCache.h"
 #include "util/base64.h"
+#include "util/dashAtlas.h"
 #include "util/util.h"
 #include "util/elevationManager.h"
+#include "util/renderScheduler.h"
 #include "util/skyManager.h"
 #include "util/yamlUtil.h"
 #include "js/JavaScript.h"
 #include "log.h"
+#include "mapContext.h"
 #include "scene.h"
 
 #include <algorithm>
+#include <cctype>
 
 namespace Tangram {
 
@@ -41,16 +53,30 @@ int64_t Scene::frameCount = 0;
 Scene::Scene(Platform& _platform,
              SceneOptions&& _options,
              std::function<void(Scene*)> _prefetchCallback,
-             Scene* _oldScene) :
+             Scene* _oldScene,
+             std::shared_ptr<TileWorker> _tileWorker,
+             std::shared_ptr<MapContext> _mapContext) :
     id(s_serial++),
     m_platform(_platform),
+    m_mapContext(std::move(_mapContext)),
     m_options(std::move(_options)),
     m_tilePrefetchCallback(_prefetchCallback),
     m_sourceContext(_platform, this) {
 
     m_prana = std::make_shared<ScenePrana>(this);
-    m_tileWorker = std::make_unique<TileWorker>(_platform, m_options.numTileWorkers);
+    m_tileWorker = _tileWorker ? _tileWorker : std::make_shared<TileWorker>(m_options.numTileWorkers);
     m_tileManager = std::make_unique<TileManager>(_platform, *m_tileWorker, m_prana);
+    switch (m_options.tileCachePolicy) {
+    case TileCachePolicy::lru: break;
+    case TileCachePolicy::adaptive:
+        m_tileManager->getTileCache()->setPolicy(TileCache::Policy::arc);
+        break;
+    case TileCachePolicy::rebuildCost:
+        m_tileManager->getTileCache()->setPolicy(TileCache::Policy::cost);
+        break;
+    }
+    m_tileUploader.setBudget(m_options.uploadBudgetTime, m_options.uploadBudgetBytes);
+    m_featureStates = std::make_unique<FeatureStates>();
     m_markerManager = std::make_unique<MarkerManager>(*this,
         _oldScene && _options.preserveMarkers ? _oldScene->m_markerManager.get() : NULL);
 }
@@ -74,7 +100,7 @@ Scene::~Scene() {
     m_prana.reset();
 
     cancelTasks();  // normally no-op since this is called on main thread in Map before ~Scene()
-    m_tileWorker->stop();  // this waits for worker threads
+    m_tileWorker->releaseScene(*this);  // this waits for workers building tiles of this Scene
 
     {
         std::unique_lock<std::mutex> lock(m_pranaMutex);
@@ -100,6 +126,10 @@ void Scene::cancelTasks() {
         /// NB: Called from main thread - notify async loader thread.
         std::unique_lock<std::mutex> lock(m_taskMutex);
         m_taskCondition.notify_one();
+    } else if (m_resourcesPending) {
+        /// Resources still loading for a progressively completed scene
+        std::unique_lock<std::mutex> lock(m_taskMutex);
+        cancelResourceTasks();
     }
 
     // tried canceling all URL requests at the Platform level, but this interferes w/ offline map download,
@@ -121,6 +151,8 @@ void Scene::cancelTasks() {
 }
 
 // draw rule name in sublayer with parent that sets explicit style is incorrectly counted as used
+static const std::string GLOBAL_PREFIX = "global.";
+
 static void getActiveStyles(const SceneLayer& layer, std::set<std::string>& activeStyles)
 {
     if (!layer.enabled()) { return; }
@@ -140,6 +172,65 @@ static void getActiveStyles(const SceneLayer& layer, std::set<std::string>& acti
     }
 }
 
+static void getFilterFunctions(const Filter& _filter, std::set<uint32_t>& _functions)
+{
+    if (_filter.data.is<Filter::Function>()) {
+        _functions.insert(_filter.data.get<Filter::Function>().id);
+    }
+    for (const Filter& operand : _filter.operands()) {
+        getFilterFunctions(operand, _functions);
+    }
+}
+
+static void getRuleFunctions(const DrawRuleData& _rule, std::set<uint32_t>& _functions)
+{
+    for (const StyleParam& param : _rule.parameters) {
+        if (param.function >= 0) { _functions.insert(param.function); }
+    }
+}
+
+static void getLayerFunctions(const SceneLayer& _layer, std::set<uint32_t>& _functions)
+{
+    if (!_layer.enabled()) { return; }
+    getFilterFunctions(_layer.filter(), _functions);
+    for (const DrawRuleData& rule : _layer.rules()) {
+        getRuleFunctions(rule, _functions);
+    }
+    for (const SceneLayer& sublayer : _layer.sublayers()) {
+        getLayerFunctions(sublayer, _functions);
+    }
+}
+
+// Collect names of the globals read by JS function @_source as 'global.name'; returns false
+// if 'global' is used in another way, e.g. 'global[key]', so that it may read any global
+static bool getFunctionGlobals(const std::string& _source, std::set<std::string>& _globals)
+{
+    static const std::string token = "global";
+    auto isIdentifier = [](char c) { return std::isalnum(uint8_t(c)) || c == '_' || c == '$'; };
+    auto skipSpace = [&](size_t pos) {
+        while (pos < _source.size() && std::isspace(uint8_t(_source[pos]))) { pos++; }
+        return pos;
+    };
+
+    for (size_t pos = _source.find(token); pos != std::string::npos; pos = _source.find(token, pos + 1)) {
+        size_t end = pos + token.size();
+        // not the 'global' object, e.g. 'isglobal' or 'feature.global'
+        if (pos > 0 && (isIdentifier(_source[pos-1]) || _source[pos-1] == '.')) { continue; }
+        if (end < _source.size() && isIdentifier(_source[end])) { continue; }
+
+        end = skipSpace(end);
+        if (end == _source.size() || _source[end] != '.') { return false; }
+
+        size_t begin = skipSpace(end + 1);
+        end = begin;
+        while (end < _source.size() && isIdentifier(_source[end])) { end++; }
+        if (end == begin) { return false; }
+
+        _globals.insert(_source.substr(begin, end - begin));
+    }
+    return true;
+}
+
 bool Scene::load() {
 
     LOGTOInit();
@@ -163,8 +254,25 @@ bool Scene::load() {
     ///
     /// Importer is blocking until all imports are loaded
     m_importer = std::make_unique<Importer>();
-    m_config = m_importer->loadSceneData(m_platform, m_options.url, m_options.yaml);
-    LOGTO("<<< applyImports");
+
+    /// Use the snapshot of the resolved config when none of its scene files changed
+    bool useSnapshot = m_options.sceneSnapshot && !m_options.diskCacheDir.empty();
+    uint64_t snapshotKey = useSnapshot ? SceneSnapshot::key(m_options) : 0;
+    bool fromSnapshot = false;
+    if (useSnapshot) {
+        std::vector<SceneSnapshot::Source> sources;
+        auto path = SceneSnapshot::filename(m_options.diskCacheDir, snapshotKey);
+        if (SceneSnapshot::load(path, snapshotKey, sources, m_config)) {
+            fromSnapshot = m_importer->checkSceneSources(m_platform, sources);
+            if (!fromSnapshot) { m_config = YAML::Node(); }
+        }
+        LOGTO("<<< sceneSnapshot");
+    }
+
+    if (!fromSnapshot) {
+        m_config = m_importer->loadSceneData(m_platform, m_options.url, m_options.yaml);
+        LOGTO("<<< applyImports");
+    }
 
     if (isCanceled(State::loading)) { return false; }
 
@@ -174,24 +282,45 @@ bool Scene::load() {
         return false;
     }
 
-    auto result = SceneLoader::applyUpdates(m_config, m_options.updates);
-    if (result.error != Error::none) {
-        m_errors.push_back(result);
-        LOGE("Applying SceneUpdates failed (error %d)", int(result.error));
-        return false;
-    }
-    LOGTO("<<< applyUpdates");
+    if (!fromSnapshot) {
+        auto result = SceneLoader::applyUpdates(m_config, m_options.updates);
+        if (result.error != Error::none) {
+            m_errors.push_back(result);
+            LOGE("Applying SceneUpdates failed (error %d)", int(result.error));
+            return false;
+        }
+        LOGTO("<<< applyUpdates");
 
 #ifdef TANGRAM_DUMP_MERGED_SCENE
-    logMsg(YAML::Dump(m_config).c_str());
+        logMsg(YAML::Dump(m_config).c_str());
 #endif
 
-    Importer::resolveSceneUrls(m_config, m_options.url);
+        Importer::resolveSceneUrls(m_config, m_options.url);
+
+        SceneLoader::applyGlobals(m_config, m_config);
+        LOGTO("<<< applyGlobals");
+
+        std::vector<SceneSnapshot::Source> sources;
+        if (useSnapshot && m_importer->getSceneSources(sources)) {
+            auto path = SceneSnapshot::filename(m_options.diskCacheDir, snapshotKey);
+            SceneSnapshot::store(path, snapshotKey, sources, m_config);
+            LOGTO("<<< storeSceneSnapshot");
+        }
+    }
+
+    if (m_options.diskMeshCache && !m_options.diskCacheDir.empty()) {
+        // entries of other Scene content are not used
+        uint64_t sceneKey = TileDiskCache::hash(YAML::Dump(m_config));
+        m_tileDiskCache = std::make_unique<TileDiskCache>(m_options.diskCacheDir, sceneKey,
+                                                          m_options.diskTileCacheMaxAge);
+        LOGTO("<<< tileDiskCache");
+    }
 
-    SceneLoader::applyGlobals(m_config, m_config);
-    LOGTO("<<< applyGlobals");
+    m_configMemoryUsage = YamlUtil::memoryUsage(m_config);
 
     m_tileSources = SceneLoader::applySources(m_config, m_options, m_sourceContext);
+    // caches of the sources of the previous Scene are kept until now
+    if (m_mapContext) { m_mapContext->releaseUnusedCaches(); }
     LOGTO("<<< applySources");
 
     SceneLoader::applyCameras(m_config, m_camera);
@@ -214,9 +343,10 @@ bool Scene::load() {
         m_tilePrefetchCallback(this);
     }
 
-    m_fontContext = std::make_unique<FontContext>(m_platform);
+    m_fontContext = std::make_unique<FontContext>(m_platform, m_tileWorker->numWorkers());
     m_fontContext->loadFonts(m_options.fallbackFonts.empty() ?
                              m_platform.systemFontFallbacksHandle() : m_options.fallbackFonts);
+    m_fontContext->loadGlyphPacks(m_options.glyphPacks);
     LOGTO("<<< initFonts");
 
     SceneLoader::applyFonts(m_config["fonts"], m_fonts);
@@ -248,6 +378,20 @@ bool Scene::load() {
         }
     }
 
+    findGlobalDependencies();
+
+    // before TileWorkers start to parse tiles
+    SceneLoader::applyPropertyKeys(m_layers, m_styles, m_tileSources);
+
+    if (m_mapContext) {
+        // the key of shared tiles includes the property keys
+        for (auto& source : m_tileSources) {
+            if (!source->isRaster() && !source->isClient() && !source->offlineInfo().url.empty()) {
+                source->setTileDataCache(m_mapContext->tileDataCache());
+            }
+        }
+    }
+
     if (m_options.debugStyles) {
         m_styles.emplace_back(new DebugTextStyle("debugtext", true));
         m_styles.emplace_back(new DebugStyle("debug"));
@@ -258,6 +402,7 @@ bool Scene::load() {
 
     /// Post style sorting set their respective IDs=>vector indices
     /// These indices are used for style geometry lookup in tiles
+    m_pendingStyles = std::vector<std::atomic<bool>>(m_styles.size());
     for(uint32_t i = 0; i < m_styles.size(); i++) {
         m_styles[i]->setID(i);
         if (auto pointStyle = dynamic_cast<PointStyle*>(m_styles[i].get())) {
@@ -282,6 +427,9 @@ bool Scene::load() {
               [](auto& style){ return style->type() == StyleType::raster; });
         if (terrainSrc && terrainStyle != m_styles.end()) {
             m_elevationManager = std::make_unique<ElevationManager>(terrainSrc, **terrainStyle);
+            // read terrain depth only around labels and other points it is needed for
+            m_elevationManager->setReadQueriedDepthOnly(
+                YamlUtil::getBoolOrDefault(sceneNode["terrain_depth_regions"], false));
         } else {
             LOGE("Unable to find elevation source or raster style needed for 3D terrain!");
         }
@@ -295,6 +443,32 @@ bool Scene::load() {
     // won't be initialized until sky is visible
     m_skyManager = std::make_unique<SkyManager>();
 
+    // impostors would not be draped over 3D terrain
+    if (m_options.tileImpostors && !m_elevationManager) {
+        m_tileImpostors = std::make_unique<TileImpostors>();
+    }
+
+    m_dashAtlas = std::make_unique<DashAtlas>();
+
+    // Rasters that tiles of each style can have, so that its programs declare no more samplers
+    std::map<std::string, int> usedRasters;
+    for (auto& layer : m_layers) {
+        auto source = std::find_if(m_tileSources.begin(), m_tileSources.end(),
+                                   [&](auto& s) { return s->name() == layer.source(); });
+        if (source == m_tileSources.end()) { continue; }
+        int rasters = ((*source)->isRaster() ? 1 : 0) + int((*source)->rasterSources().size());
+        std::set<std::string> styles;
+        getActiveStyles(layer, styles);
+        for (auto& name : styles) {
+            auto& count = usedRasters[name];
+            count = std::max(count, rasters);
+        }
+    }
+    for (auto& style : m_styles) {
+        auto it = usedRasters.find(style->getName());
+        if (it != usedRasters.end()) { style->setUsedRasters(it->second); }
+    }
+
     for (auto& style : m_styles) { style->build(*this); }
     if (m_elevationManager) { m_elevationManager->m_style->build(*this); }
     LOGTO("<<< buildStyles");
@@ -314,7 +488,7 @@ bool Scene::load() {
     m_tileWorker->setScene(*this);
 
     m_featureSelection = std::make_unique<FeatureSelection>();
-    m_labelManager = std::make_unique<LabelManager>();
+    m_labelManager = std::make_unique<LabelManager>(m_options.numLabelWorkers);
 
     m_state = State::pending_resources;
 
@@ -332,29 +506,9 @@ bool Scene::load() {
         if (m_state != State::pending_resources) { break; }
 
         /// Don't need to wait for textures when their size is known
-        bool canBuildTiles = true;
-
-        m_textures.tasks.remove_if([&](auto& task) {
-           if (!task.done && task.texture->width() == 0) {
-               canBuildTiles = false;
-           }
-           return task.done;
-        });
-
-        m_fonts.tasks.remove_if([&](auto& task) {
-            if (!task.done) {
-                canBuildTiles = false;
-                return false;
-            }
-            if (task.response.error) {
-                LOGE("Error retrieving font '%s' at %s: ",
-                     task.ft.uri.c_str(), task.response.error);
-                return true;
-            }
-            auto&& data = task.response.content;
-            m_fontContext->addFont(task.ft, std::move(data));  //alfons::InputSource(std::move(data)));
-            return true;
-        });
+        bool fontsPending = false, spritesPending = false;
+        collectResourceTasks(fontsPending, spritesPending);
+        bool canBuildTiles = !fontsPending && !spritesPending;
 
         /// Ready to build tiles?
         if (startTileWorker && canBuildTiles && m_tilePrefetchCallback) {
@@ -369,6 +523,14 @@ bool Scene::load() {
             break;
         }
 
+        /// Or complete without the styles that wait for them, see updatePendingResources()
+        if (m_options.progressiveLoading) {
+            updatePendingStyles(fontsPending, spritesPending);
+            m_resourcesPending = true;
+            m_readyToBuildTiles = true;
+            break;
+        }
+
         if (m_tasksActive != tasksActive) {
             continue;
         }
@@ -377,27 +539,10 @@ bool Scene::load() {
     }
 
     /// We got everything needed from Importer
-    m_importer.reset();
+    if (!m_resourcesPending) { m_importer.reset(); }
 
     if (isCanceled(State::pending_resources)) {
-        /// Cancel pending texture resources
-        if (!m_textures.tasks.empty()) {
-            LOG("Cancel texture resource tasks");
-            for (auto& task : m_textures.tasks) {
-                if (task.requestHandle) {
-                    m_platform.cancelUrlRequest(task.requestHandle);
-                }
-            }
-        }
-        /// Cancel pending font resources
-        if (!m_fonts.tasks.empty()) {
-            LOG("Cancel font resource tasks");
-            for (auto& task : m_fonts.tasks) {
-                if (task.requestHandle) {
-                    m_platform.cancelUrlRequest(task.requestHandle);
-                }
-            }
-        }
+        cancelResourceTasks();
         return false;
     }
 
@@ -409,6 +554,93 @@ bool Scene::load() {
     return true;
 }
 
+void Scene::collectResourceTasks(bool& _fontsPending, bool& _spritesPending) {
+
+    m_textures.tasks.remove_if([&](auto& task) {
+       if (!task.done && task.texture->width() == 0) {
+           _spritesPending = true;
+       }
+       return task.done;
+    });
+
+    m_fonts.tasks.remove_if([&](auto& task) {
+        if (!task.done) {
+            _fontsPending = true;
+            return false;
+        }
+        if (task.response.error) {
+            LOGE("Error retrieving font '%s' at %s: ",
+                 task.ft.uri.c_str(), task.response.error);
+            return true;
+        }
+        auto&& data = task.response.content;
+        m_fontContext->addFont(task.ft, std::move(data));  //alfons::InputSource(std::move(data)));
+        return true;
+    });
+}
+
+void Scene::cancelResourceTasks() {
+    /// Cancel pending texture resources
+    if (!m_textures.tasks.empty()) {
+        LOG("Cancel texture resource tasks");
+        for (auto& task : m_textures.tasks) {
+            if (task.requestHandle) {
+                m_platform.cancelUrlRequest(task.requestHandle);
+            }
+        }
+    }
+    /// Cancel pending font resources
+    if (!m_fonts.tasks.empty()) {
+        LOG("Cancel font resource tasks");
+        for (auto& task : m_fonts.tasks) {
+            if (task.requestHandle) {
+                m_platform.cancelUrlRequest(task.requestHandle);
+            }
+        }
+    }
+}
+
+std::vector<bool> Scene::updatePendingStyles(bool _fontsPending, bool _spritesPending) {
+    std::vector<bool> joined(m_styles.size(), false);
+
+    // Text and points wait for all fonts, as the fonts their rules select are not known in
+    // advance; points also wait for textures whose sprites are not known without their size
+    for (auto& style : m_styles) {
+        bool pending = false;
+        if (dynamic_cast<PointStyle*>(style.get())) {
+            pending = _fontsPending || _spritesPending;
+        } else if (dynamic_cast<TextStyle*>(style.get())) {
+            pending = _fontsPending;
+        }
+        uint32_t id = style->getID();
+        if (m_pendingStyles[id] && !pending) { joined[id] = true; }
+        m_pendingStyles[id] = pending;
+    }
+    return joined;
+}
+
+void Scene::updatePendingResources() {
+    bool fontsPending = false, spritesPending = false;
+    bool done = false;
+    {
+        std::unique_lock<std::mutex> lock(m_taskMutex);
+        collectResourceTasks(fontsPending, spritesPending);
+        done = m_textures.tasks.empty() && m_fonts.tasks.empty();
+    }
+
+    auto joined = updatePendingStyles(fontsPending, spritesPending);
+    if (std::find(joined.begin(), joined.end(), true) != joined.end()) {
+        LOG("Rebuild tiles for styles with loaded resources");
+        m_tileManager->rebuildStyles(joined, true);
+        m_markerManager->rebuildAll();
+    }
+
+    if (done) {
+        m_resourcesPending = false;
+        m_importer.reset();
+    }
+}
+
 void Scene::prefetchTiles(const View& _view) {
     View view = _view;
 
@@ -434,7 +666,7 @@ void Scene::prefetchTiles(const View& _view) {
         }
         m_fontContext->setPixelScale(m_pixelScale);
 
-        m_tileWorker->startJobs();
+        m_tileWorker->startJobs(*this);
     }
     LOGTO("<<< loadTiles");
 }
@@ -466,7 +698,7 @@ bool Scene::completeScene(View& _view) {
     m_state = State::ready;
 
     /// Tell TileWorker that Scene is ready, so it can check its work-queue
-    m_tileWorker->startJobs();
+    m_tileWorker->startJobs(*this);
 
     return true;
 }
@@ -559,26 +791,25 @@ void Scene::runTextureTasks() {
 
         LOG("Fetch texture %s", task.url.string().c_str());
 
-        auto cb = [this, wprana, &task](UrlResponse&& response) {
+        auto onData = [this, wprana, &task](const char* data, size_t size, const char* error) {
             auto sprana = wprana.lock();  // protect against running callback after scene destruction
             if(!sprana || m_state == State::canceled) { return; }
             LOG("Received texture %s", task.url.string().c_str());
-            if (response.error) {
-                LOGE("Error retrieving URL '%s': %s", task.url.string().c_str(), response.error);
+            if (error) {
+                LOGE("Error retrieving URL '%s': %s", task.url.string().c_str(), error);
             } else {
                 /// Decode texture on download thread.
                 auto& texture = task.texture;
                 if (Url::getPathExtension(task.url.string()) == "svg") {
 #ifdef TANGRAM_SVG_LOADER
-                    if (!userLoadSvg(response.content.data(), response.content.size(), texture.get())) {
+                    if (!userLoadSvg(data, size, texture.get())) {
                         LOGE("Error loading texture data from URL '%s'", task.url.string().c_str());
                     }
 #else
                     LOGE("SVG support not enabled - cannot load '%s'", task.url.string().c_str());
 #endif
                 } else {
-                    auto data = reinterpret_cast<const uint8_t*>(response.content.data());
-                    if (!texture->loadImageFromMemory(data, response.content.size())) {
+                    if (!texture->loadImageFromMemory(reinterpret_cast<const uint8_t*>(data), size)) {
                         LOGE("Invalid texture data from URL '%s'", task.url.string().c_str());
                     }
                 }
@@ -591,13 +822,17 @@ void Scene::runTextureTasks() {
             task.done = true;
             m_tasksActive--;
             m_taskCondition.notify_one();
+            if (m_resourcesPending) { m_platform.requestRender(); }
         };
 
         m_tasksActive++;
         if (task.url.scheme() == "zip") {
-            m_importer->readFromZip(task.url, std::move(cb));
+            /// Decode from the archive without copying stored entries
+            m_importer->readZipEntry(task.url, std::move(onData));
         } else {
-            task.requestHandle = m_platform.startUrlRequest(task.url, std::move(cb));
+            task.requestHandle = m_importer->readResource(task.url, [onData](UrlResponse&& response) {
+                onData(response.content.data(), response.content.size(), response.error);
+            });
         }
     }
 }
@@ -636,35 +871,41 @@ void Scene::runFontTasks() {
 
             m_tasksActive--;
             m_taskCondition.notify_one();
+            if (m_resourcesPending) { m_platform.requestRender(); }
         };
 
         m_tasksActive++;
-        if (task.url.scheme() == "zip") {
-            m_importer->readFromZip(task.url, std::move(cb));
-        } else {
-            task.requestHandle = m_platform.startUrlRequest(task.url, std::move(cb));
-        }
+        task.requestHandle = m_importer->readResource(task.url, std::move(cb));
     }
 }
 
-Scene::UpdateState Scene::update(RenderState& _rs, View& _view, float _dt) {
+Scene::UpdateState Scene::update(RenderState& _rs, View& _view, float _dt, bool _renderTerrainDepth) {
 
     m_time += _dt;
 
+    if (m_resourcesPending) { updatePendingResources(); }
+
     bool viewChanged = _view.update();
 
     auto markersState = m_markerManager->update(_view, _dt);
 
     bool tilesChanged = m_tileManager->updateTileSets(_view);
 
-    for (const auto& style : m_styles) {
-        style->onBeginUpdate();
-    }
-
     auto& tiles = m_tileManager->getVisibleTiles();
     auto& markers = m_markerManager->markers();
 
-    bool changed = viewChanged || tilesChanged || markersState.dirty;
+    // tiles uploaded in the last frame replace their proxies
+    bool changed = viewChanged || tilesChanged || markersState.dirty || m_tilesUploaded;
+    m_tilesUploaded = false;
+
+    // Draw the label meshes of the last frame again, without projecting labels and uploading
+    // their vertices, while nothing moves
+    bool keepLabels = !changed && m_labelManager->meshesCurrent();
+    if (!keepLabels) {
+        for (const auto& style : m_styles) {
+            style->onBeginUpdate();
+        }
+    }
     if (changed) {
         for (const auto& tile : tiles) {
             tile->update(_view, _dt);
@@ -673,17 +914,28 @@ Scene::UpdateState Scene::update(RenderState& _rs, View& _view, float _dt) {
 
     // because of 1 frame lag for terrain depth, we must always render even if onlyRender = true for
     //  updateLabelSet() since label coordinates will still be updated
-    if (m_elevationManager) {
-        m_elevationManager->renderTerrainDepth(_rs, _view, tiles);
+    if (_renderTerrainDepth) {
+        renderTerrainDepth(_rs, _view);
+    }
+
+    if (!keepLabels) {
+        m_labelManager->updateLabelSet(_view, _dt, *this, tiles, markers, !changed);
     }
 
-    m_labelManager->updateLabelSet(_view, _dt, *this, tiles, markers, !changed);
+    bool tilesLoading = m_tileManager->numLoadingTiles() > 0 || m_tileUploader.stats().pending > 0;
 
-    return { m_tileManager->numLoadingTiles() > 0, m_labelManager->needUpdate(), markersState.easing };
+    return { tilesLoading, m_labelManager->needUpdate(), markersState.easing, changed, viewChanged };
+}
+
+void Scene::renderTerrainDepth(RenderState& _rs, View& _view) {
+    if (m_elevationManager) {
+        m_elevationManager->renderTerrainDepth(_rs, _view, m_tileManager->getVisibleTiles());
+    }
 }
 
 void Scene::renderBeginFrame(RenderState& _rs) {
     _rs.setFrameTime(m_time);
+    _rs.programCache.setDirectory(m_options.programCache ? m_options.diskCacheDir : "");
     ++frameCount;
 
     for (const auto& style : m_styles) {
@@ -691,31 +943,85 @@ void Scene::renderBeginFrame(RenderState& _rs) {
     }
 }
 
-bool Scene::render(RenderState& _rs, View& _view) {
+bool Scene::render(RenderState& _rs, View& _view, RenderPass _pass) {
 
-    bool drawnAnimatedStyle = false;
+    // Tiles, sky and frame uniforms are set up by the first pass of the frame
+    if (_pass != RenderPass::labels) {
+        {
+            FrameInfo::scope _trace("uploadTiles");
+            m_tilesUploaded = m_tileUploader.upload(_rs, _view, m_tileManager->getVisibleTiles());
+        }
+        if (m_tileUploader.stats().pending > 0) { m_platform.requestRender(); }
 
-    // draw the sky (if horizon if visible)
-    m_skyManager->draw(_rs, _view);
+        // draw the sky (if horizon if visible)
+        m_skyManager->draw(_rs, _view);
+    }
 
-    for (const auto& style : m_styles) {
+    // Impostors of this frame replace the tiles of the styles they were rendered with
+    bool impostors = m_tileImpostors && m_tileImpostors->frame() == frameCount &&
+                     m_tileImpostors->count() > 0;
+    if (impostors && _pass != RenderPass::labels) {
+        GpuTimer::Scope gpuTime(_rs.gpuTimer, "impostors");
+        m_tileImpostors->draw(_rs);
+    }
+
+    if (Hardware::supportsUniformBuffers && _pass != RenderPass::labels) {
+        // Set once for all programs instead of by each style, see Style::setupShaderUniforms()
+        FrameUniforms frame;
+        frame.setView(_view);
+        frame.time = _rs.frameTime();
+        frame.devicePixelRatio = m_pixelScale;
+        _rs.frameUniforms.update(frame);
+    }
 
-        bool styleDrawn = style->draw(_rs, _view,
-                                      m_tileManager->getVisibleTiles(),
-                                      m_markerManager->markers());
+    TRACE_SCOPE("draw");
+    const auto& tiles = m_tileManager->getVisibleTiles();
+    const auto& markers = m_markerManager->markers();
 
-        drawnAnimatedStyle |= (styleDrawn && style->isAnimated());
+    m_renderQueue.clear();
+    for (size_t i = 0; i < m_styles.size(); i++) {
+        if (_pass != RenderPass::all) {
+            auto type = m_styles[i]->type();
+            bool label = type == StyleType::text || type == StyleType::point;
+            if (label != (_pass == RenderPass::labels)) { continue; }
+        }
+        bool baked = impostors && TileImpostors::bakes(*m_styles[i]);
+        m_renderQueue.push(*m_styles[i], i, _view, baked ? m_tileImpostors->remainingTiles() : tiles,
+                           markers);
+    }
+    m_renderQueue.sort();
+
+    // returns whether an animated style was drawn
+    bool animated = m_renderQueue.submit(_rs, _view, markers);
+
+    // Tiles drawn for the first time end the trace flow of their task
+    if (_pass != RenderPass::labels) {
+        for (auto& tile : tiles) {
+            if (tile->traceId() && tile->isUploaded()) {
+                Trace::flow(tile->traceId(), Trace::Flow::end);
+                tile->setTraceId(0);
+            }
+        }
     }
-    return drawnAnimatedStyle;
+    return animated;
+}
+
+void Scene::renderImpostors(RenderState& _rs, View& _view) {
+
+    if (!m_tileImpostors) { return; }
+
+    bool pending = m_tileImpostors->update(_rs, _view, m_tileManager->getVisibleTiles(), m_styles,
+                                           *m_featureStates, frameCount);
+    if (pending) { m_platform.requestRender(); }
 }
 
-void Scene::renderSelection(RenderState& _rs, View& _view, FrameBuffer& _selectionBuffer,
-                            std::vector<SelectionQuery>& _selectionQueries) {
+void Scene::renderSelection(RenderState& _rs, View& _view) {
 
+    GpuTimer::Scope gpuTime(_rs.gpuTimer, "selection");
     GLuint selectionVAO = 0;
     if(Hardware::supportsVAOs) {  // bind VAO in case hardware requires it (GL 3)
         GL::genVertexArrays(1, &selectionVAO);
-        GL::bindVertexArray(selectionVAO);
+        _rs.setDefaultVertexArray(selectionVAO);
     }
 
     for (const auto& style : m_styles) {
@@ -725,12 +1031,20 @@ void Scene::renderSelection(RenderState& _rs, View& _view, FrameBuffer& _selecti
                                   m_markerManager->markers());
     }
 
-    if(selectionVAO) { GL::deleteVertexArrays(1, &selectionVAO); }
+    if(selectionVAO) {
+        _rs.setDefaultVertexArray(0);
+        GL::deleteVertexArrays(1, &selectionVAO);
+    }
+}
+
+void Scene::resolveSelection(const View& _view, const FrameBuffer& _selectionBuffer,
+                             const FrameBuffer::PixelRect& _pixels,
+                             const std::vector<SelectionQuery>& _selectionQueries) {
 
     std::vector<SelectionColorRead> colorCache;
     /// Resolve feature selection queries
     for (const auto& selectionQuery : _selectionQueries) {
-        selectionQuery.process(_view, _selectionBuffer,
+        selectionQuery.process(_view, _selectionBuffer, _pixels,
                                *m_markerManager, *m_tileManager,
                                *m_labelManager, colorCache);
     }
@@ -744,6 +1058,18 @@ std::shared_ptr<Texture> Scene::getTexture(const std::string& textureName) const
     return texIt->second;
 }
 
+void Scene::requestTileRender(const TileTask& _task) {
+    // Canceled tiles are no longer in view, prefetched tiles not yet; both are picked up by
+    // the update of a frame drawn for other reasons
+    if (_task.isCanceled() || _task.isPrefetch()) { return; }
+
+    if (m_renderScheduler) {
+        m_renderScheduler->requestRender();
+    } else {
+        m_platform.requestRender();
+    }
+}
+
 std::shared_ptr<TileSource> Scene::getTileSource(int32_t id) const {
     auto it = std::find_if(m_tileSources.begin(), m_tileSources.end(),
                            [&](auto& s){ return s->id() == id; });
@@ -760,6 +1086,80 @@ Color Scene::backgroundColor(int _zoom) const {
     return m_background;
 }
 
+void Scene::findGlobalDependencies() {
+
+    std::vector<std::set<std::string>> functionGlobals(m_jsFunctions.size());
+    std::vector<bool> untracked(m_jsFunctions.size());
+    for (size_t i = 0; i < m_jsFunctions.size(); i++) {
+        untracked[i] = !getFunctionGlobals(m_jsFunctions[i], functionGlobals[i]);
+    }
+
+    auto addDependencies = [&](const std::set<uint32_t>& _functions, std::set<std::string>& _styles) {
+        if (_functions.empty()) { return; }
+
+        // outline styles can be set by default draw rules of a style
+        for (const auto& style : m_styles) {
+            if (!_styles.count(style->getName()) || !style->defaultDrawRule()) { continue; }
+            for (const StyleParam& param : style->defaultDrawRule()->parameters) {
+                if (param.key == StyleParamKey::outline_style) {
+                    _styles.emplace(param.value.get<std::string>());
+                }
+            }
+        }
+        for (uint32_t id : _functions) {
+            if (id >= m_jsFunctions.size()) { continue; }
+            if (untracked[id]) { m_untrackedGlobals = true; }
+            for (const auto& global : functionGlobals[id]) {
+                m_globalStyles[global].insert(_styles.begin(), _styles.end());
+            }
+        }
+    };
+
+    // Feature matching in any layer of a data layer tree affects all styles it draws with
+    for (const auto& layer : m_layers) {
+        std::set<uint32_t> functions;
+        getLayerFunctions(layer, functions);
+        std::set<std::string> styles;
+        getActiveStyles(layer, styles);
+        addDependencies(functions, styles);
+    }
+
+    for (const auto& style : m_styles) {
+        if (!style->defaultDrawRule()) { continue; }
+        std::set<uint32_t> functions;
+        getRuleFunctions(*style->defaultDrawRule(), functions);
+        std::set<std::string> styles = { style->getName() };
+        addDependencies(functions, styles);
+    }
+}
+
+bool Scene::stylesForGlobalUpdates(const std::vector<SceneUpdate>& _updates, std::vector<bool>& _styles) const {
+
+    if (m_untrackedGlobals || m_sourceContext.hasFunctions()) { return false; }
+
+    _styles.assign(m_styles.size(), false);
+
+    for (const auto& update : _updates) {
+        // skip '+' for created paths
+        size_t begin = update.path.compare(0, 1, "+") == 0 ? 1 : 0;
+        if (update.path.compare(begin, GLOBAL_PREFIX.size(), GLOBAL_PREFIX) != 0) { return false; }
+
+        begin += GLOBAL_PREFIX.size();
+        size_t end = update.path.find_first_of(".#", begin);
+        auto it = m_globalStyles.find(update.path.substr(begin, end == std::string::npos ? end : end - begin));
+        if (it == m_globalStyles.end()) { continue; }
+
+        for (const auto& style : m_styles) {
+            if (it->second.count(style->getName())) { _styles[style->getID()] = true; }
+        }
+    }
+    return true;
+}
+
+bool Scene::keepTileData() const {
+    return !m_globalStyles.empty() && !m_untrackedGlobals && !m_sourceContext.hasFunctions();
+}
+
 JSFunctionIndex DataSourceContext::createFunction(const std::string& source) {
     std::unique_lock<std::mutex> lock(m_jsMutex);
     if(!m_jsContext) { m_jsContext = std::make_unique<JSContext>(); }
@@ -794,4 +1194,8 @@ DataSourceContext::DataSourceContext(Platform& _platform, const YAML::Node& _glo
 
 DataSourceContext::~DataSourceContext() {}
 
+MapContext* DataSourceContext::getMapContext() const {
+    return m_scene ? m_scene->mapContext() : nullptr;
+}
+
 }
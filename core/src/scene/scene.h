@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gl/framebuffer.h"
 #include "map.h"
 #include "platform.h"
 #include "stops.h"
@@ -7,6 +8,8 @@
 #include "styleContext.h"
 #include "util/fontDescription.h"
 #include "tile/tileManager.h"
+#include "scene/renderQueue.h"
+#include "tile/tileUploader.h"
 #include "util/color.h"
 #include "util/url.h"
 #include "util/yamlPath.h"
@@ -15,9 +18,11 @@
 #include <atomic>
 #include <forward_list>
 #include <functional>
+#include <map>
 #include <memory>
 #include <condition_variable>
 #include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 #include <tuple>
@@ -29,20 +34,25 @@
 
 namespace Tangram {
 
+class DashAtlas;
 class DataLayer;
 class FeatureSelection;
+class FeatureStates;
 class FontContext;
-class FrameBuffer;
 class Importer;
 class LabelManager;
 class Light;
+class MapContext;
 class MapProjection;
 class MarkerManager;
 class Platform;
+class RenderScheduler;
 class SceneLayer;
 class SelectionQuery;
 class Style;
 class Texture;
+class TileDiskCache;
+class TileImpostors;
 class TileSource;
 class ElevationManager;
 class SkyManager;
@@ -117,6 +127,9 @@ public:
     std::unique_lock<std::mutex> getJSLock() { return std::unique_lock<std::mutex>(m_jsMutex); }
     JSLockedContext getJSContext();
     Platform& getPlatform() const { return m_platform; }
+    MapContext* getMapContext() const;
+    // Functions of TileSources, e.g. for tile URLs, may read any global
+    bool hasFunctions() const { return m_functionIndex > 0; }
 };
 
 class ScenePrana {
@@ -137,8 +150,12 @@ class Scene {
 public:
     enum animate { yes, no, none };
 
+    /// @_tileWorker: worker pool shared across Scenes; if null the Scene creates its own
+    /// @_mapContext: resources shared with the Scenes of other Maps, see MapContext
     Scene(Platform& _platform, SceneOptions&& = {},
-          std::function<void(Scene*)> _prefetchCallback = nullptr, Scene* _oldScene = nullptr);
+          std::function<void(Scene*)> _prefetchCallback = nullptr, Scene* _oldScene = nullptr,
+          std::shared_ptr<TileWorker> _tileWorker = nullptr,
+          std::shared_ptr<MapContext> _mapContext = nullptr);
 
     ~Scene();
 
@@ -151,10 +168,14 @@ public:
     auto& tileSources() const { return m_tileSources; }
     auto& featureSelection() const { return m_featureSelection; }
     auto& fontContext() const { return m_fontContext; }
+    DashAtlas& dashAtlas() const { return *m_dashAtlas; }
+    FeatureStates& featureStates() const { return *m_featureStates; }
     // so we can call SceneTextures::add() ... should we use a Scene::addTexture() instead?
     auto& sceneTextures() { return m_textures; }
 
     const auto& config() const { return m_config; }
+    /// Estimated bytes of the scene configuration, measured once it is loaded
+    size_t configMemoryUsage() const { return m_configMemoryUsage; }
     const auto& functions() const { return m_jsFunctions; }
     const auto& layers() const { return m_layers; }
     const auto& lightBlocks() const { return m_lightShaderBlocks; }
@@ -169,7 +190,16 @@ public:
     std::shared_ptr<TileSource> getTileSource(int32_t id) const;
     std::shared_ptr<Texture> getTexture(const std::string& name) const;
 
-    std::shared_ptr<ScenePrana> prana() { return m_prana; }
+    std::shared_ptr<ScenePrana> prana() const { return m_prana; }
+
+    Platform& platform() const { return m_platform; }
+    MapContext* mapContext() const { return m_mapContext.get(); }
+
+    /// Frames for tiles are requested through @_scheduler when set, see requestTileRender()
+    void setRenderScheduler(RenderScheduler* _scheduler) { m_renderScheduler = _scheduler; }
+
+    /// Request a frame for the tile of @_task that finished loading, unless it is not shown
+    void requestTileRender(const TileTask& _task);
 
     animate animated() const { return m_animated; }
 
@@ -179,22 +209,53 @@ public:
     /// Update TileManager, Labels and Markers for current View
     struct UpdateState {
         bool tilesLoading, animateLabels, animateMarkers;
+        // Whether the view, tiles or markers changed since the last update
+        bool changed;
+        bool viewChanged;
     };
-    UpdateState update(RenderState& _rs, View& _view, float _dt);
+    // Update tiles, markers and labels for @_view; terrain depth is rendered for label placement
+    // only with @_renderTerrainDepth, otherwise renderTerrainDepth() is called on the GL thread
+    UpdateState update(RenderState& _rs, View& _view, float _dt, bool _renderTerrainDepth = true);
+
+    void renderTerrainDepth(RenderState& _rs, View& _view);
 
     void renderBeginFrame(RenderState& _rs);
-    bool render(RenderState& _rs, View& _view);
-    void renderSelection(RenderState& _rs, View& _view,
-                         FrameBuffer& _selectionBuffer,
-                         std::vector<SelectionQuery>& _selectionQueries);
+
+    enum class RenderPass : uint8_t {
+        all,
+        // Styles other than text and points, e.g. into a target of lower resolution
+        scene,
+        // Text and point styles, drawn over the scene pass
+        labels,
+    };
+    // Draw the styles of @_pass; returns whether an animated style was drawn
+    bool render(RenderState& _rs, View& _view, RenderPass _pass = RenderPass::all);
+    // Draw the selection frame into the bound selection buffer
+    void renderSelection(RenderState& _rs, View& _view);
+    // Render the impostors of distant tiles in tilted @_view with SceneOptions::tileImpostors,
+    // binding their framebuffers; call before the target of the frame is bound
+    void renderImpostors(RenderState& _rs, View& _view);
+
+    // Resolve @_selectionQueries with @_pixels read from @_selectionBuffer, which contain
+    // the rects of all queries
+    void resolveSelection(const View& _view, const FrameBuffer& _selectionBuffer,
+                          const FrameBuffer::PixelRect& _pixels,
+                          const std::vector<SelectionQuery>& _selectionQueries);
 
     Color backgroundColor(int _zoom) const;
 
+    /// Persistent cache of tile meshes, null unless SceneOptions::diskMeshCache is set
+    TileDiskCache* tileDiskCache() const { return m_tileDiskCache.get(); }
+
     /// Used for FrameInfo debug
     TileManager* tileManager() const { return m_tileManager.get(); }
+    TileWorker* tileWorker() const { return m_tileWorker.get(); }
+    const TileUploader& tileUploader() const { return m_tileUploader; }
+    const RenderQueue& renderQueue() const { return m_renderQueue; }
     LabelManager* labelManager() const { return m_labelManager.get(); }
     MarkerManager* markerManager() const { return m_markerManager.get(); }
     ElevationManager* elevationManager() const { return m_elevationManager.get(); }
+    TileImpostors* tileImpostors() const { return m_tileImpostors.get(); }
 
     const SceneError* errors() const {
         return (m_errors.empty() ? nullptr : &m_errors.front());
@@ -219,6 +280,12 @@ public:
     /// Cancel scene loading and all TileManager tasks
     void cancelTasks();
 
+    /// With SceneOptions::progressiveLoading, whether the style @_id is left out of tiles
+    /// and markers while the fonts or sprite textures it needs are loading
+    bool isStylePending(uint32_t _id) const {
+        return _id < m_pendingStyles.size() && m_pendingStyles[_id];
+    }
+
     /// Returns true when scene finished loading and completeScene() suceeded.
     bool isReady() const { return m_state == State::ready; }
     bool isPendingCompletion() const { return m_state == State::pending_completion; }
@@ -229,6 +296,14 @@ public:
     /// incremented whenever globals are updated
     int64_t globalsGeneration = 0;
 
+    /// Set @_styles (by Style ID) whose tile geometry depends on the globals changed by
+    /// @_updates; returns false if tiles must be rebuilt entirely, e.g. for updates
+    /// outside of 'global' or when JS functions read globals in an untracked way
+    bool stylesForGlobalUpdates(const std::vector<SceneUpdate>& _updates, std::vector<bool>& _styles) const;
+
+    /// Tiles keep their TileData if styles can be rebuilt for global updates
+    bool keepTileData() const;
+
     /// set to hide labels with transition.selected < 0
     bool hideExtraLabels = false;
 
@@ -244,6 +319,8 @@ public:
 protected:
 
     Platform& m_platform;
+    std::shared_ptr<MapContext> m_mapContext;
+    RenderScheduler* m_renderScheduler = nullptr;
 
     SceneOptions m_options;
     std::function<void(Scene*)> m_tilePrefetchCallback;
@@ -268,6 +345,7 @@ protected:
     /// Loaded Scene Data
     /// The root node of the YAML scene configuration
     YAML::Node m_config;
+    size_t m_configMemoryUsage = 0;
 
     /// syncronization for TileTasks
     friend class ScenePrana;
@@ -294,6 +372,16 @@ protected:
     void runFontTasks();
     SceneFonts m_fonts;
 
+    /// Remove finished texture and font tasks, adding the fonts to the FontContext; sets
+    /// whether fonts and textures of unknown size are still loading. Call with m_taskMutex locked
+    void collectResourceTasks(bool& _fontsPending, bool& _spritesPending);
+    void cancelResourceTasks();
+
+    /// Mark the styles that wait for pending fonts or sprites, returns those that stopped waiting
+    std::vector<bool> updatePendingStyles(bool _fontsPending, bool _spritesPending);
+    /// Rebuild tiles and markers for styles whose resources arrived after completeScene()
+    void updatePendingResources();
+
     /// Container of all strings used in styling rules; these need to be
     /// copied and compared frequently when applying styling, so rules use
     /// integer indices into this container to represent strings
@@ -302,6 +390,13 @@ protected:
     SceneFunctions m_jsFunctions;
     SceneStops m_stops;
 
+    /// Names of the styles whose geometry depends on JS functions reading a global,
+    /// by name of the (top-level) global
+    void findGlobalDependencies();
+    std::map<std::string, std::set<std::string>> m_globalStyles;
+    /// Set if a JS function reads 'global' other than by property name
+    bool m_untrackedGlobals = false;
+
     Color m_background;
     Stops m_backgroundStops;
     animate m_animated = none;
@@ -319,14 +414,28 @@ protected:
     /// Set true when all resources for TileBuilder are available
     bool m_readyToBuildTiles = false;
 
+    /// Set when the scene was completed with fonts or textures still loading
+    std::atomic<bool> m_resourcesPending{false};
+    /// By Style ID, see isStylePending()
+    std::vector<std::atomic<bool>> m_pendingStyles;
+
     std::unique_ptr<FontContext> m_fontContext;
+    std::unique_ptr<DashAtlas> m_dashAtlas;
     std::unique_ptr<FeatureSelection> m_featureSelection;
-    std::unique_ptr<TileWorker> m_tileWorker;
+    // States of features set through the Map, for meshes with feature tables
+    std::unique_ptr<FeatureStates> m_featureStates;
+    std::shared_ptr<TileWorker> m_tileWorker;
     std::unique_ptr<TileManager> m_tileManager;
+    TileUploader m_tileUploader;
+    RenderQueue m_renderQueue;
+    // set when tiles were uploaded in the last frame
+    bool m_tilesUploaded = false;
+    std::unique_ptr<TileDiskCache> m_tileDiskCache;
     std::unique_ptr<MarkerManager> m_markerManager;
     std::unique_ptr<LabelManager> m_labelManager;
     std::unique_ptr<ElevationManager> m_elevationManager;
     std::unique_ptr<SkyManager> m_skyManager;
+    std::unique_ptr<TileImpostors> m_tileImpostors;
 
     std::mutex m_taskMutex;
     std::atomic_uint m_tasksActive{0};
@@ -1,5 +1,6 @@
 #include "scene/sceneLayer.h"
 
+#include <atomic>
 #include <type_traits>
 
 namespace Tangram {
@@ -11,6 +12,7 @@ SceneLayer::SceneLayer(std::string name, Filter filter,
                        std::vector<SceneLayer> sublayers,
                        Options options) :
     m_filter(std::move(filter)),
+    m_filterProgram(m_filter),
     m_name(std::move(name)),
     m_rules(std::move(rules)),
     m_sublayers(std::move(sublayers)),
@@ -33,6 +35,55 @@ SceneLayer::SceneLayer(std::string name, Filter filter,
                   // first.
                   return a.name() > b.name();
               });
+
+    buildMatchPlan();
+}
+
+SceneLayer::SceneLayer(const SceneLayer& other) :
+    m_filter(other.m_filter),
+    m_filterProgram(other.m_filterProgram),
+    m_name(other.m_name),
+    m_rules(other.m_rules),
+    m_sublayers(other.m_sublayers),
+    m_options(other.m_options) {
+
+    buildMatchPlan();
+}
+
+SceneLayer& SceneLayer::operator=(const SceneLayer& other) {
+    if (this != &other) {
+        m_filter = other.m_filter;
+        m_filterProgram = other.m_filterProgram;
+        m_name = other.m_name;
+        m_rules = other.m_rules;
+        m_sublayers = other.m_sublayers;
+        m_options = other.m_options;
+        buildMatchPlan();
+    }
+    return *this;
+}
+
+void SceneLayer::buildMatchPlan() {
+    static std::atomic<uint32_t> s_matchPlanIds{0};
+    m_matchPlanId = ++s_matchPlanIds;
+
+    m_matchPlan.clear();
+    m_matchPlan.push_back({ nullptr, 0, 0, 1 });
+
+    // Breadth-first, so that the children of each node are contiguous
+    for (size_t index = 0; index < m_matchPlan.size(); index++) {
+        const SceneLayer& layer = index == 0 ? *this : *m_matchPlan[index].layer;
+        int depth = m_matchPlan[index].depth;
+
+        auto firstChild = static_cast<uint32_t>(m_matchPlan.size());
+        for (const auto& sublayer : layer.sublayers()) {
+            if (sublayer.enabled()) {
+                m_matchPlan.push_back({ &sublayer, 0, 0, depth + 1 });
+            }
+        }
+        m_matchPlan[index].firstChild = firstChild;
+        m_matchPlan[index].childCount = static_cast<uint32_t>(m_matchPlan.size()) - firstChild;
+    }
 }
 
 }
@@ -19,26 +19,51 @@ public:
         bool exclusive = false;
     };
 
+    // The layer hierarchy flattened for matching, see DrawRuleMergeSet::match(). Node 0 is
+    // this layer, the children of a node are the enabled sublayers of its layer in order.
+    struct MatchNode {
+        const SceneLayer* layer; // nullptr for this layer
+        uint32_t firstChild;
+        uint32_t childCount;
+        int depth;
+    };
+
     SceneLayer(std::string name, Filter filter,
                std::vector<DrawRuleData> rules,
                std::vector<SceneLayer> sublayers,
                Options options);
 
+    // Copies get their own match plan, moves keep it as sublayers stay in place
+    SceneLayer(const SceneLayer& other);
+    SceneLayer(SceneLayer&& other) = default;
+    SceneLayer& operator=(const SceneLayer& other);
+    SceneLayer& operator=(SceneLayer&& other) = default;
+
     const auto& name() const { return m_name; }
     const auto& filter() const { return m_filter; }
+    // The filter compiled for matching features
+    const auto& filterProgram() const { return m_filterProgram; }
     const auto& rules() const { return m_rules; }
     const auto& sublayers() const { return m_sublayers; }
     auto priority() const { return m_options.priority; }
     auto enabled() const { return m_options.enabled; }
     auto exclusive() const { return m_options.exclusive; }
+    const auto& matchPlan() const { return m_matchPlan; }
+    // Unique for each match plan, e.g. to key cached matches
+    uint32_t matchPlanId() const { return m_matchPlanId; }
 
 private:
 
+    void buildMatchPlan();
+
     Filter m_filter;
+    FilterProgram m_filterProgram;
     std::string m_name;
     std::vector<DrawRuleData> m_rules;
     std::vector<SceneLayer> m_sublayers;
     Options m_options;
+    std::vector<MatchNode> m_matchPlan;
+    uint32_t m_matchPlanId = 0;
 };
 
 }
@@ -1,6 +1,7 @@
 #include "scene/sceneLoader.h"
 
 #include "data/clientDataSource.h"
+#include "data/cogDataSource.h"
 #include "data/memoryCacheDataSource.h"
 #include "data/mbtilesDataSource.h"
 #include "data/networkDataSource.h"
@@ -12,6 +13,7 @@
 #include "gl/shaderSource.h"
 #include "gl/texture.h"
 #include "log.h"
+#include "mapContext.h"
 #include "platform.h"
 #include "style/material.h"
 #include "style/polygonStyle.h"
@@ -20,6 +22,7 @@
 #include "style/pointStyle.h"
 #include "style/rasterStyle.h"
 #include "style/contourTextStyle.h"
+#include "tile/tileAvailability.h"
 #include "scene/dataLayer.h"
 #include "scene/filters.h"
 #include "scene/scene.h"
@@ -58,6 +61,9 @@ static const char DELIMITER = ':';
 
 static const std::string GLOBAL_PREFIX = "global.";
 
+// Radius in pixels of texture distance fields with 'sdf: true'
+static const float DEFAULT_SDF_RADIUS = 4.f;
+
 SceneError SceneLoader::applyUpdates(Node& _config, const std::vector<SceneUpdate>& _updates) {
 
     for (const auto& update : _updates) {
@@ -466,6 +472,20 @@ void SceneLoader::loadTexture(std::pair<const Node&, const Node&> _node, SceneTe
         options.displayScale = 1.f / YamlUtil::getFloatOrDefault(density, 1.f);
     }
 
+    // Monochrome icons as distance fields, tinted and outlined by point styles: 'sdf: true' or the
+    // radius of the field in pixels; sprites need as much space around them in the image
+    if (const Node& sdf = textureConfig["sdf"]) {
+        bool enabled = false;
+        float radius = 0.f;
+        if (YamlUtil::getFloat(sdf, radius) && radius >= 0.f) {
+            options.sdfRadius = radius;
+        } else if (YamlUtil::getBool(sdf, enabled)) {
+            options.sdfRadius = enabled ? DEFAULT_SDF_RADIUS : 0.f;
+        } else {
+            LOGW("Invalid texture sdf: %s", Dump(sdf).c_str());
+        }
+    }
+
     auto texture = _textures.add(name, Url(url), options);
 
     if (const Node& sprites = textureConfig["sprites"]) {
@@ -571,6 +591,29 @@ void SceneLoader::loadFontDescription(const Node& _node, const std::string& _fam
     _fonts.add(uri, _family, style, weight);
 }
 
+// Names of the source layers that a top-level layer @_name with @_data block draws
+static std::vector<std::string> getDataLayerCollections(const Node& _data, const std::string& _name) {
+    std::vector<std::string> collections;
+
+    if (const Node& data_layer = _data["layer"]) {
+        if (data_layer.IsScalar()) {
+            collections.push_back(data_layer.Scalar());
+
+        } else if (data_layer.IsSequence()) {
+            collections.reserve(data_layer.size());
+            for (const auto& entry : data_layer) {
+                if (entry.IsScalar()) {
+                    collections.push_back(entry.Scalar());
+                }
+            }
+        }
+    }
+    if (collections.empty()) {
+        collections.push_back(_name);
+    }
+    return collections;
+}
+
 Scene::TileSources SceneLoader::applySources(const Node& _config, const SceneOptions& _options,
                                              DataSourceContext& _context) {
 
@@ -651,6 +694,9 @@ Scene::TileSources SceneLoader::applySources(const Node& _config, const SceneOpt
             auto source = data_source.Scalar();
             if (auto dataSource = getTileSource(source)) {
                 dataSource->generateGeometry(true);
+                for (const auto& collection : getDataLayerCollections(data, member.first.Scalar())) {
+                    dataSource->addDataLayer(collection);
+                }
             } else {
                 LOGW("Can't find data source %s for layer %s",
                      source.c_str(), member.first.Scalar().c_str());
@@ -773,6 +819,9 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
     bool isTiled = url.empty() || NetworkDataSource::urlHasTilePattern(url);
     bool isMBTilesFile = Url::getPathExtension(url) == "mbtiles";
     bool isPMTilesFile = Url::getPathExtension(url) == "pmtiles";
+    // Untiled GeoTIFFs of raster sources are read in parts, as Cloud-Optimized GeoTIFFs
+    std::string extension = Url::getPathExtension(url);
+    bool isCOGFile = !isTiled && type == "Raster" && (extension == "tif" || extension == "tiff");
     if (isMBTilesFile) {
 #ifdef TANGRAM_MBTILES_DATASOURCE
         // If we have MBTiles, we know the source is tiled.
@@ -794,6 +843,10 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
         LOGE("PMTiles support is disabled. This source will be ignored: %s", _name.c_str());
         return nullptr;
 #endif
+    } else if (isCOGFile) {
+        // Tiles are rendered from the blocks of the image
+        isTiled = true;
+        rawSources = std::make_unique<COGDataSource>(_context.getPlatform(), url);
     } else if (isTiled) {
         if (!url.empty())
             rawSources = std::make_unique<NetworkDataSource>(_context, url, urlOptions);
@@ -804,10 +857,12 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
                 LOGW("no cache file specified for source %s", _name.c_str());
             } else if (cachename != "false") {
                 int64_t maxAge = _source["max_age"].as<int64_t>(0);
-                const char* mimetype = type == "MVT" ? "pbf" : type == "Raster" ? "png" : "";
+                const char* mimetype = type == "MVT" ? "pbf" : type == "MLT" ? "mlt" :
+                    type == "Raster" ? "png" : "";
                 cachefile = _options.diskCacheDir + cachename + ".mbtiles";
                 auto s = std::make_unique<MBTilesDataSource>(_context.getPlatform(),
                         _name, cachefile, mimetype, maxAge > 0 ? maxAge : _options.diskTileCacheMaxAge);
+                s->setStaleWhileRevalidate(_source["stale_while_revalidate"].as<bool>(_options.diskTileCacheRevalidate));
                 s->next = std::move(rawSources);
                 rawSources = std::move(s);
                 LOGD("using %s as cache for source %s", cachefile.c_str(), _name.c_str());
@@ -820,7 +875,13 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
         }
         auto cacheSize = _options.memoryTileCacheSize;
         if (cacheSize > 0) {
-            auto s = std::make_unique<MemoryCacheDataSource>();
+            bool compressed = _options.memoryTileCacheCompressed;
+            // Scenes of one MapContext share the raw tiles of a url requested the same way
+            auto* mapContext = _context.getMapContext();
+            std::string identity = url + "|" + urlOptions.httpOptions.headers + (urlOptions.isTms ? "|tms" : "");
+            auto s = mapContext && !url.empty() ?
+                std::make_unique<MemoryCacheDataSource>(mapContext->rawCache(identity, compressed)) :
+                std::make_unique<MemoryCacheDataSource>(compressed);
             s->setCacheSize(cacheSize);
             s->next = std::move(rawSources);
             rawSources = std::move(s);
@@ -836,12 +897,22 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
                                                        _name, url, generateCentroids, zoomOptions);
     } else if (type == "Raster") {
         TextureOptions options;
+        options.arrayLayer = _options.rasterTextureArrays;
         if (const Node& filtering = _source["filtering"]) {
             if (!parseTexFiltering(filtering, options)) {
                 LOGW("Invalid texture filtering: %s", Dump(filtering).c_str());
             }
         }
-        sourcePtr = std::make_shared<RasterSource>(_name, std::move(rawSources), options, zoomOptions);
+        // Float elevation (TIFF or LERC) is kept as half floats, at half the size of textures and buffers
+        if (YamlUtil::getBoolOrDefault(_source["half_float"], false)) {
+            options.pixelFormat = PixelFormat::HALF_FLOAT;
+        }
+        auto rasterSource = std::make_shared<RasterSource>(_name, std::move(rawSources), options, zoomOptions);
+        rasterSource->m_compressTextures = YamlUtil::getBoolOrDefault(_source["compress"], false);
+        if (YamlUtil::getBoolOrDefault(_source["normal_map"], false)) {
+            rasterSource->setNormalMap(true);
+        }
+        sourcePtr = rasterSource;
     } else {
         sourcePtr = std::make_shared<TileSource>(_name, std::move(rawSources), zoomOptions);
 
@@ -851,16 +922,33 @@ std::shared_ptr<TileSource> SceneLoader::loadSource(const Node& _source, const s
             vectorFmt = TileSource::Format::TopoJson;
         } else if (type == "MVT") {
             vectorFmt = TileSource::Format::Mvt;
+        } else if (type == "MLT") {
+            vectorFmt = TileSource::Format::Mlt;
         } else {
             LOGE("Source '%s' does not have a valid type. " \
-                 "Valid types are 'GeoJSON', 'TopoJSON', and 'MVT'. " \
+                 "Valid types are 'GeoJSON', 'TopoJSON', 'MVT' and 'MLT'. " \
                  "This source will be ignored.", _name.c_str());
             return nullptr;
         }
         sourcePtr->setFormat(vectorFmt);
     }
 
+    // west, south, east, north as in TileJSON; tiles outside are not requested
+    if (const Node& boundsNode = _source["bounds"]) {
+        double b[4];
+        bool valid = boundsNode.IsSequence() && boundsNode.size() == 4;
+        for (size_t i = 0; valid && i < 4; i++) { valid = YamlUtil::getDouble(boundsNode[i], b[i]); }
+        if (valid) {
+            sourcePtr->availability().setBounds({ b[0], b[1] }, { b[2], b[3] });
+        } else {
+            LOGW("Invalid bounds of source '%s', expected [west, south, east, north]", _name.c_str());
+        }
+    }
+
     sourcePtr->setOfflineInfo({cachefile, url, urlOptions, vectorFmt});
+    sourcePtr->setLoadOrder(_source["load_order"].as<int32_t>(0));
+    sourcePtr->setSimplify(YamlUtil::getFloatOrDefault(_source["simplify"], 0.f));
+    sourcePtr->setClipMargin(YamlUtil::getFloatOrDefault(_source["clip_margin"], -1.f));
 
     return sourcePtr;
 }
@@ -978,6 +1066,13 @@ void SceneLoader::loadStyleProps(const Node& _styleNode, Style& _style, SceneTex
         }
     }
 
+    if (const Node& eagerNode = _styleNode["eager"]) {
+        bool boolValue;
+        if (YamlUtil::getBool(eagerNode, boolValue)) {
+            _style.setEager(boolValue);
+        }
+    }
+
     if (const Node& blendNode = _styleNode["blend"]) {
         const std::string& blendMode = blendNode.Scalar();
         if      (blendMode == "opaque")      { _style.setBlendMode(Blending::opaque); }
@@ -1006,6 +1101,13 @@ void SceneLoader::loadStyleProps(const Node& _styleNode, Style& _style, SceneTex
         }
     }
 
+    if (const Node& depthPrepassNode = _styleNode["depth_prepass"]) {
+        bool boolValue;
+        if (YamlUtil::getBool(depthPrepassNode, boolValue)) {
+            _style.setDepthPrepass(boolValue);
+        }
+    }
+
     if (const Node& dashNode = _styleNode["dash"]) {
         if (auto polylineStyle = dynamic_cast<PolylineStyle*>(&_style)) {
             if (dashNode.IsSequence()) {
@@ -1119,6 +1221,8 @@ void SceneLoader::parseStyleParams(const Node& _params, const std::string& _pref
                 auto styleKey = StyleParam::getKey(key);
                 if (styleKey != StyleParamKey::none) {
 
+                    size_t stopsCount = _stops.size();
+
                     if (StyleParam::isColor(styleKey)) {
                         _stops.push_back(Stops::Colors(value));
                         _out.push_back(StyleParam{ styleKey, &_stops.back() });
@@ -1138,6 +1242,10 @@ void SceneLoader::parseStyleParams(const Node& _params, const std::string& _pref
                         _stops.push_back(Stops::Numbers(value));
                         _out.push_back(StyleParam{ styleKey, &_stops.back() });
                     }
+
+                    if (_stops.size() > stopsCount) {
+                        _stops.back().index = static_cast<uint32_t>(stopsCount);
+                    }
                 } else {
                     LOGW("Unknown style parameter %s", key.c_str());
                 }
@@ -1515,6 +1623,8 @@ std::vector<DataLayer> SceneLoader::applyLayers(const Node& _node,  SceneFunctio
         const std::string& name = layer.first.Scalar();
         std::string source;
         std::vector<std::string> collections;
+        float simplify = -1.f;
+        std::vector<std::string> mergeLineKeys;
 
         auto sublayer = loadSublayer(layer.second, name, _functions, _stops, _ruleNames);
 
@@ -1524,29 +1634,87 @@ std::vector<DataLayer> SceneLoader::applyLayers(const Node& _node,  SceneFunctio
             if (data_source && data_source.IsScalar()) {
                 source = data_source.Scalar();
             }
-
-            if (const Node& data_layer = data["layer"]) {
-                if (data_layer.IsScalar()) {
-                    collections.push_back(data_layer.Scalar());
-
-                } else if (data_layer.IsSequence()) {
-                    collections.reserve(data_layer.size());
-                    for (const auto& entry : data_layer) {
-                        if (entry.IsScalar()) {
-                            collections.push_back(entry.Scalar());
-                        }
-                    }
+            collections = getDataLayerCollections(data, name);
+            simplify = YamlUtil::getFloatOrDefault(data["simplify"], -1.f);
+
+            // Keys that the fragments of a line share, e.g. of the roads that a label follows
+            const Node& mergeLines = data["merge_lines"];
+            if (mergeLines.IsSequence()) {
+                for (const auto& key : mergeLines) {
+                    if (key.IsScalar()) { mergeLineKeys.push_back(key.Scalar()); }
                 }
+            } else if (YamlUtil::getBoolOrDefault(mergeLines, false)) {
+                mergeLineKeys = { "name", "kind" };
             }
-        }
-        if (collections.empty()) {
+        } else {
             collections.push_back(name);
         }
-        dataLayers.emplace_back(std::move(sublayer), source, collections);
+        dataLayers.emplace_back(std::move(sublayer), source, collections, simplify, std::move(mergeLineKeys));
     }
     return dataLayers;
 }
 
+// Add property keys read by @_filter to @_keys; sets @_all if it may read any property
+static void getPropertyKeys(const Filter& _filter, std::vector<std::string>& _keys, bool& _all) {
+    if (_filter.data.is<Filter::Function>()) {
+        _all = true;
+    } else if (_filter.isOperator()) {
+        for (const auto& operand : _filter.operands()) { getPropertyKeys(operand, _keys, _all); }
+    } else if (!_filter.key().empty() && stringToFilterKeyword(_filter.key()) == FilterKeyword::undefined) {
+        _keys.push_back(_filter.key());
+    }
+}
+
+// Add property keys read by the parameters of @_rule to @_keys; sets @_all if it may read any
+// property (JS functions) or the features are selectable
+static void getPropertyKeys(const DrawRuleData& _rule, std::vector<std::string>& _keys, bool& _all) {
+    for (const auto& param : _rule.parameters) {
+        if (param.function >= 0) {
+            _all = true;
+        } else if (param.key == StyleParamKey::interactive || param.key == StyleParamKey::text_interactive) {
+            _all |= !param.value.is<bool>() || param.value.get<bool>();
+        } else if (param.value.is<StyleParam::TextSource>()) {
+            // text_source and extrude
+            auto& keys = param.value.get<StyleParam::TextSource>().keys;
+            _keys.insert(_keys.end(), keys.begin(), keys.end());
+        }
+    }
+}
+
+static void getPropertyKeys(const SceneLayer& _layer, std::vector<std::string>& _keys, bool& _all) {
+    getPropertyKeys(_layer.filter(), _keys, _all);
+    for (const auto& rule : _layer.rules()) { getPropertyKeys(rule, _keys, _all); }
+    for (const auto& sublayer : _layer.sublayers()) { getPropertyKeys(sublayer, _keys, _all); }
+}
+
+void SceneLoader::applyPropertyKeys(const Scene::Layers& _layers, const Scene::Styles& _styles,
+                                    const Scene::TileSources& _sources) {
+
+    // default text of labels
+    std::vector<std::string> styleKeys = { "name" };
+    bool styleAll = false;
+    for (const auto& style : _styles) {
+        if (auto* rule = style->defaultDrawRule()) { getPropertyKeys(*rule, styleKeys, styleAll); }
+    }
+
+    for (const auto& layer : _layers) {
+        auto it = std::find_if(_sources.begin(), _sources.end(),
+                               [&](auto& source) { return source->name() == layer.source(); });
+        if (it == _sources.end() || (*it)->isRaster()) { continue; }
+
+        std::vector<std::string> keys = styleKeys;
+        bool all = styleAll;
+        getPropertyKeys(layer, keys, all);
+        keys.insert(keys.end(), layer.mergeLineKeys().begin(), layer.mergeLineKeys().end());
+
+        for (const auto& collection : layer.collections()) {
+            (*it)->addPropertyKeys(collection, keys, all);
+        }
+        // unnamed layers (e.g. GeoJSON) are drawn by all layers of the source
+        (*it)->addPropertyKeys("", keys, all);
+    }
+}
+
 SceneLayer SceneLoader::loadSublayer(const Node& _layer, const std::string& _layerName,
                                      SceneFunctions& _functions, SceneStops& _stops,
                                      DrawRuleNames& _ruleNames) {
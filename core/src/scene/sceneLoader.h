@@ -94,6 +94,11 @@ struct SceneLoader {
 
     static SceneLayer loadSublayer(const Node& layer, const std::string& name, SceneFunctions& functions,
                                    SceneStops& stops, DrawRuleNames& ruleNames);
+
+    /// Set the property keys that @layers and the default draw rules of @styles read on the
+    /// TileSources of the layers, see TileSource::addPropertyKeys()
+    static void applyPropertyKeys(const Scene::Layers& layers, const Scene::Styles& styles,
+                                  const Scene::TileSources& sources);
     /// - Filter
     static Filter generateFilter(SceneFunctions& functions, const Node& filter);
     static Filter generateAnyFilter(SceneFunctions& functions, const Node& filter);
@@ -0,0 +1,239 @@
+#include "scene/sceneSnapshot.h"
+
+#include "log.h"
+#include "sceneOptions.h"
+#include "tile/tileDiskCache.h"
+#include "util/mappedFile.h"
+
+#include "gaml/src/yaml.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#define SCENE_SNAPSHOT_MAGIC 0x53534754 // "TGSS"
+#define SCENE_SNAPSHOT_VERSION 1
+
+// Nesting depth up to which snapshots are decoded
+#define SCENE_SNAPSHOT_MAX_DEPTH 256
+
+namespace Tangram {
+
+struct SceneSnapshot::Header {
+    uint32_t magic = SCENE_SNAPSHOT_MAGIC;
+    uint32_t version = SCENE_SNAPSHOT_VERSION;
+    uint64_t key = 0;
+    uint32_t numSources = 0;
+    uint32_t padding = 0;
+};
+
+template<typename T>
+static void append(std::vector<char>& _out, const T& _value) {
+    auto bytes = reinterpret_cast<const char*>(&_value);
+    _out.insert(_out.end(), bytes, bytes + sizeof(T));
+}
+
+static void appendString(std::vector<char>& _out, const std::string& _string) {
+    append(_out, uint32_t(_string.size()));
+    _out.insert(_out.end(), _string.begin(), _string.end());
+}
+
+template<typename T>
+static bool read(const char*& _pos, const char* _end, T& _value) {
+    if (size_t(_end - _pos) < sizeof(T)) { return false; }
+    std::memcpy(&_value, _pos, sizeof(T));
+    _pos += sizeof(T);
+    return true;
+}
+
+static bool readString(const char*& _pos, const char* _end, std::string& _string) {
+    uint32_t length = 0;
+    if (!read(_pos, _end, length) || size_t(_end - _pos) < length) { return false; }
+    _string.assign(_pos, length);
+    _pos += length;
+    return true;
+}
+
+uint64_t SceneSnapshot::key(const SceneOptions& _options) {
+    uint32_t version = SCENE_SNAPSHOT_VERSION;
+    uint64_t key = TileDiskCache::hash(&version, sizeof(version));
+    // Separators keep e.g. url "a" with yaml "b" apart from url "ab"
+    key = TileDiskCache::hash(_options.url.string() + '\0', key);
+    key = TileDiskCache::hash(_options.yaml + '\0', key);
+    for (const auto& update : _options.updates) {
+        key = TileDiskCache::hash(update.path + '\0', key);
+        key = TileDiskCache::hash(update.value + '\0', key);
+    }
+    return key;
+}
+
+std::string SceneSnapshot::filename(const std::string& _dir, uint64_t _key) {
+    char name[32];
+    snprintf(name, sizeof(name), "scene_%016llx.bin", (unsigned long long)_key);
+    return _dir + name;
+}
+
+uint64_t SceneSnapshot::hash(const std::vector<char>& _content) {
+    return TileDiskCache::hash(_content.data(), _content.size());
+}
+
+void SceneSnapshot::encode(const YAML::Node& _node, std::vector<char>& _out) {
+    using YAML::Tag;
+
+    append(_out, uint16_t(_node.getFlags()));
+
+    switch (_node.getTag()) {
+    case Tag::NUMBER:
+    case Tag::JSON_BOOL:
+        append(_out, _node.as<double>());
+        break;
+    case Tag::ARRAY:
+    case Tag::OBJECT: {
+        bool isMap = _node.getTag() == Tag::OBJECT;
+        append(_out, uint32_t(_node.size()));
+        for (auto item : _node.items()) {
+            if (isMap) { appendString(_out, item->key.getString()); }
+            encode(item->value, _out);
+        }
+        break;
+    }
+    case Tag::UNDEFINED:
+    case Tag::JSON_NULL:
+    case Tag::INVALID:
+        break;
+    default:
+        appendString(_out, _node.getString());
+    }
+}
+
+static bool decodeNode(const char*& _pos, const char* _end, YAML::Node& _node, int _depth) {
+    using YAML::Tag;
+
+    uint16_t flags = 0;
+    if (_depth > SCENE_SNAPSHOT_MAX_DEPTH || !read(_pos, _end, flags)) { return false; }
+    Tag tag = Tag(flags);
+
+    switch (tag & Tag::TYPE_MASK) {
+    case Tag::NUMBER:
+    case Tag::JSON_BOOL: {
+        double value = 0;
+        if (!read(_pos, _end, value)) { return false; }
+        _node = YAML::Node(value, tag);
+        return true;
+    }
+    case Tag::ARRAY:
+    case Tag::OBJECT: {
+        bool isMap = (tag & Tag::TYPE_MASK) == Tag::OBJECT;
+        uint32_t count = 0;
+        if (!read(_pos, _end, count)) { return false; }
+        // Link items in order instead of appending each with add() or push_back(), which walk
+        // the list
+        YAML::ListNode* head = nullptr;
+        YAML::ListNode* tail = nullptr;
+        bool ok = true;
+        for (uint32_t i = 0; i < count && ok; i++) {
+            auto* item = new YAML::ListNode{};
+            if (tail) { tail->next = item; } else { head = item; }
+            tail = item;
+            std::string key;
+            if (isMap) {
+                ok = readString(_pos, _end, key);
+                item->key = YAML::Node(std::move(key));
+            }
+            ok = ok && decodeNode(_pos, _end, item->value, _depth + 1);
+        }
+        // Node takes ownership of the items, also for cleanup on error
+        _node = YAML::Node(tag, head);
+        return ok;
+    }
+    case Tag::UNDEFINED:
+    case Tag::JSON_NULL:
+    case Tag::INVALID:
+        _node = YAML::Node(tag);
+        return true;
+    default: {
+        std::string value;
+        if (!readString(_pos, _end, value)) { return false; }
+        _node = YAML::Node(std::move(value), tag);
+        return true;
+    }
+    }
+}
+
+bool SceneSnapshot::decode(const char*& _pos, const char* _end, YAML::Node& _node) {
+    return decodeNode(_pos, _end, _node, 0);
+}
+
+bool SceneSnapshot::load(const std::string& _path, uint64_t _key, std::vector<Source>& _sources,
+                         YAML::Node& _config) {
+
+    MappedFile file;
+    if (!file.open(_path)) { return false; }
+
+    const char* pos = file.data();
+    const char* end = pos + file.size();
+
+    Header stored;
+    if (!read(pos, end, stored)) { return false; }
+
+    Header expected;
+    if (stored.magic != expected.magic || stored.version != expected.version ||
+        stored.key != _key) {
+        return false;
+    }
+
+    _sources.clear();
+    for (uint32_t i = 0; i < stored.numSources; i++) {
+        std::string url;
+        uint64_t hash = 0;
+        if (!readString(pos, end, url) || !read(pos, end, hash)) { return false; }
+        _sources.push_back({ Url(url), hash });
+    }
+
+    if (!decode(pos, end, _config) || pos != end) {
+        LOGW("Invalid scene snapshot: %s", _path.c_str());
+        _config = YAML::Node();
+        return false;
+    }
+    return true;
+}
+
+bool SceneSnapshot::store(const std::string& _path, uint64_t _key, const std::vector<Source>& _sources,
+                          const YAML::Node& _config) {
+
+    Header h;
+    h.key = _key;
+    h.numSources = uint32_t(_sources.size());
+
+    std::vector<char> data;
+    append(data, h);
+    for (const auto& source : _sources) {
+        appendString(data, source.url.string());
+        append(data, source.hash);
+    }
+    encode(_config, data);
+
+    std::string tmpPath = _path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    std::ofstream file(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    file.write(data.data(), data.size());
+    file.close();
+
+    if (!file) {
+        LOGW("Cannot write scene snapshot: %s", tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // rename does not replace existing files on all platforms
+    std::remove(_path.c_str());
+    if (std::rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
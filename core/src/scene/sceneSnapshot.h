@@ -0,0 +1,66 @@
+#pragma once
+
+#include "util/url.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace YAML {
+    class Node;
+}
+
+namespace Tangram {
+
+class SceneOptions;
+
+/* Compiled snapshot of a resolved scene config
+ *
+ * A snapshot holds the scene config as it is after imports are merged, SceneUpdates and
+ * globals are applied and URLs are resolved, in a compact binary encoding of the YAML tree
+ * that is decoded straight from a memory mapped file. It is keyed by the SceneOptions that
+ * determine the config (see key()) and records the content hash of each scene file it was
+ * built from: Scene::load() uses it only when all of these files are unchanged, see
+ * Importer::checkSceneSources().
+ *
+ * Snapshots are files in SceneOptions::diskCacheDir; store() writes to a temporary file which
+ * is renamed when complete.
+ */
+class SceneSnapshot {
+
+public:
+
+    // A scene file read while importing, by URL and content hash
+    struct Source {
+        Url url;
+        uint64_t hash;
+    };
+
+    /* Key of the scene URL, YAML string and SceneUpdates of @_options */
+    static uint64_t key(const SceneOptions& _options);
+
+    /* Path of the snapshot for @_key in cache directory @_dir */
+    static std::string filename(const std::string& _dir, uint64_t _key);
+
+    /* Load snapshot at @_path; returns false if there is no valid snapshot for @_key */
+    static bool load(const std::string& _path, uint64_t _key, std::vector<Source>& _sources,
+                     YAML::Node& _config);
+
+    /* Store @_config built from @_sources as snapshot for @_key */
+    static bool store(const std::string& _path, uint64_t _key, const std::vector<Source>& _sources,
+                      const YAML::Node& _config);
+
+    /* Content hash of a scene file */
+    static uint64_t hash(const std::vector<char>& _content);
+
+    /* Binary encoding of a YAML tree */
+    static void encode(const YAML::Node& _node, std::vector<char>& _out);
+    static bool decode(const char*& _pos, const char* _end, YAML::Node& _node);
+
+private:
+
+    struct Header;
+
+};
+
+}
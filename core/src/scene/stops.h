@@ -29,6 +29,10 @@ struct Stops {
     };
 
     std::vector<Frame> frames;
+
+    // Position in the list of scene stops, the slot of these stops in a StopsCache
+    uint32_t index = 0;
+
     static Stops Colors(const YAML::Node& _node);
     static Stops Widths(const YAML::Node& _node, UnitSet _units);
     static Stops FontSize(const YAML::Node& _node);
@@ -51,4 +55,44 @@ struct Stops {
     static void eval(const Stops& _stops, StyleParamKey _key, float _zoom, StyleParam::Value& _result);
 };
 
+/* Values of Stops at the zoom of a tile build, so that stops are evaluated once per tile and
+ * not for each feature. Each Stops has the slot of its Stops::index; stops of another list that
+ * share a slot only replace the value.
+ */
+template<typename T>
+class StopsCache {
+
+public:
+
+    // Drop the values when @_zoom differs from the previous one
+    void setZoom(float _zoom) {
+        if (_zoom == m_zoom) { return; }
+        m_zoom = _zoom;
+        for (auto& entry : m_entries) { entry.stops = nullptr; }
+    }
+
+    // Value of @_stops, nullptr if it is not evaluated yet
+    const T* find(const Stops& _stops) const {
+        if (_stops.index < m_entries.size() && m_entries[_stops.index].stops == &_stops) {
+            return &m_entries[_stops.index].value;
+        }
+        return nullptr;
+    }
+
+    void insert(const Stops& _stops, const T& _value) {
+        if (_stops.index >= m_entries.size()) { m_entries.resize(_stops.index + 1); }
+        m_entries[_stops.index] = { &_stops, _value };
+    }
+
+private:
+
+    struct Entry {
+        const Stops* stops = nullptr;
+        T value;
+    };
+
+    std::vector<Entry> m_entries;
+    float m_zoom = -1;
+};
+
 }
@@ -7,10 +7,14 @@
 #include "platform.h"
 #include "scene/filters.h"
 #include "scene/scene.h"
+#include "scene/styleExpression.h"
 #include "util/mapProjection.h"
 #include "util/builders.h"
 #include "util/yamlUtil.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace Tangram {
 
 #ifdef TANGRAM_JS_TRACING
@@ -26,6 +30,26 @@ struct JSTracer {
 };
 #endif
 
+struct StyleContext::FunctionMemo {
+    StyleExpression::Inputs inputs;
+    std::unordered_map<std::string, StyleParam::Value> results;
+};
+
+struct StyleContext::FunctionBatch {
+    enum class State : uint8_t { none, queued, evaluated };
+
+    StyleParamKey key{};
+    std::vector<uint32_t> queued;           // feature indices
+    std::vector<State> states;              // by feature index
+    std::vector<StyleParam::Value> results; // by feature index, none_type when evaluation failed
+};
+
+// Functions of inputs with many distinct values, e.g. a name, stop filling their memo
+static constexpr size_t MAX_MEMO_RESULTS = 1024;
+
+// m_memoKey tag for filter results, other tags are the StyleParamKey
+static constexpr uint8_t FILTER_MEMO_TAG = 0xff;
+
 static const std::vector<std::string> s_geometryStrings = {
     "", // unknown
     "point",
@@ -58,25 +82,55 @@ void StyleContext::initFunctions(const Scene& _scene) {
     m_sceneId = _scene.id;
 
     setSceneGlobals(_scene.config()["global"]);
-    setFunctions(_scene.functions());
+
+    // A context reused for a reloaded Scene keeps its functions if they are the same
+    if (_scene.functions() != m_functionSources) {
+        setFunctions(_scene.functions());
+    } else {
+        for (auto& memo : m_memos) {
+            if (memo) { memo->results.clear(); }
+        }
+    }
 #ifdef TANGRAM_NATIVE_STYLE_FNS
     m_nativeFns = &_scene.nativeFns();
 #endif
 }
 
 bool StyleContext::setFunctions(const std::vector<std::string>& _functions) {
-    uint32_t id = 0;
     bool success = true;
+    m_functionCount = 0;
+    m_functionSources.clear();
+    m_expressions.clear();
+    m_memos.clear();
+    m_batches.clear();
+    m_hasBatchFunctions = false;
     for (auto& function : _functions) {
-        success &= m_jsContext->setFunction(id++, function);
+        success &= addFunction(function);
     }
-
-    m_functionCount = id;
     return success;
 }
 
 bool StyleContext::addFunction(const std::string& _function) {
-    bool success = m_jsContext->setFunction(m_functionCount++, _function);
+    bool success = m_jsContext->setFunction(m_functionCount, _function);
+    m_functionSources.push_back(_function);
+    m_expressions.resize(m_functionCount);
+    m_expressions.push_back(StyleExpression::compile(_function));
+
+    m_memos.resize(m_functionCount);
+    m_batches.resize(m_functionCount);
+    auto memo = std::make_unique<FunctionMemo>();
+    if (m_expressions.back()) {
+        m_memos.push_back(nullptr);
+        m_batches.push_back(nullptr);
+    } else if (StyleExpression::scanInputs(_function, memo->inputs)) {
+        m_memos.push_back(std::move(memo));
+        m_batches.push_back(nullptr);
+    } else {
+        m_memos.push_back(nullptr);
+        m_batches.push_back(std::make_unique<FunctionBatch>());
+        m_hasBatchFunctions = true;
+    }
+    m_functionCount++;
     return success;
 }
 
@@ -90,6 +144,9 @@ void StyleContext::setFeature(const Feature& _feature) {
     }
 
     m_jsContext->setCurrentFeature(&_feature);
+
+    uintptr_t offset = reinterpret_cast<uintptr_t>(&_feature) - reinterpret_cast<uintptr_t>(m_batchFeatures);
+    m_batchIndex = m_batchFeatures ? std::min(offset / sizeof(Feature), m_batchSize) : m_batchSize;
 }
 
 void StyleContext::setTileID(TileID _tileId) {
@@ -102,6 +159,10 @@ void StyleContext::setTileID(TileID _tileId) {
     double meters_per_pixel = MapProjection::metersPerPixelAtZoom(_tileId.s);
     setKeyword(FilterKeyword::meters_per_pixel, meters_per_pixel);
     m_tileID = _tileId;
+
+    for (auto& memo : m_memos) {
+        if (memo) { memo->results.clear(); }
+    }
 }
 
 void StyleContext::setKeyword(FilterKeyword keyword, Value value) {
@@ -142,88 +203,189 @@ bool StyleContext::evalFilter(FunctionID _id) {
 #ifdef TANGRAM_JS_TRACING
     JSTracer _jsTracer(_id);
 #endif
-    bool result = m_jsContext->evaluateBooleanFunction(_id);
-    return result;
-}
+    if (_id < m_expressions.size() && m_expressions[_id]) {
+        StyleExpression::Result result;
+        m_expressions[_id]->eval(*this, m_feature, result);
+        return result.toBoolean();
+    }
 
-bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Value& _val) {
-    _val = none_type{};
+    FunctionBatch* batch = getBatch(_id);
+    if (batch && batch->states[m_batchIndex] == FunctionBatch::State::evaluated) {
+        return batch->results[m_batchIndex].get<bool>();
+    }
 
-#ifdef TANGRAM_JS_TRACING
-    JSTracer _jsTracer(_id);
-#endif
+    FunctionMemo* memo = (m_feature && _id < m_memos.size()) ? m_memos[_id].get() : nullptr;
+    if (memo) {
+        setMemoKey(*memo, FILTER_MEMO_TAG);
+        auto it = memo->results.find(m_memoKey);
+        if (it != memo->results.end()) {
+            return it->second.get<bool>();
+        }
+    }
 
-#ifdef TANGRAM_NATIVE_STYLE_FNS
-    if (m_nativeFns && _id < m_nativeFns->size() && m_nativeFns->at(_id)) {
-        return m_nativeFns->at(_id)(*m_feature, _val);
+    bool result = m_jsContext->evaluateBooleanFunction(_id);
+
+    if (batch) {
+        batch->results[m_batchIndex] = result;
+        batch->states[m_batchIndex] = FunctionBatch::State::evaluated;
     }
-#endif
 
-    JSScope jsScope(*m_jsContext);
-    auto jsValue = jsScope.getFunctionResult(_id);
-    if (!jsValue) {
-        return false;
+    if (memo && memo->results.size() < MAX_MEMO_RESULTS) {
+        memo->results.emplace(m_memoKey, result);
     }
+    return result;
+}
 
-    if (jsValue.isString()) {
-        std::string value = jsValue.toString();
+static void appendMemoValue(const Value& _value, std::string& _key) {
+    if (_value.is<double>()) {
+        double number = _value.get<double>();
+        _key += 'd';
+        _key.append(reinterpret_cast<const char*>(&number), sizeof(number));
+    } else if (_value.is<std::string>()) {
+        const auto& string = _value.get<std::string>();
+        uint32_t length = string.size();
+        _key += 's';
+        _key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        _key += string;
+    } else {
+        _key += 'n';
+    }
+}
 
-        switch (_key) {
-            case StyleParamKey::outline_style:
-            case StyleParamKey::repeat_group:
-            case StyleParamKey::sprite:
-            case StyleParamKey::sprite_default:
-            case StyleParamKey::style:
-            case StyleParamKey::text_align:
-            case StyleParamKey::text_repeat_group:
-            case StyleParamKey::text_source:
-            case StyleParamKey::text_source_left:
-            case StyleParamKey::text_source_right:
-            case StyleParamKey::text_transform:
-            case StyleParamKey::texture:
-                _val = value;
-                break;
-            case StyleParamKey::color:
-            case StyleParamKey::outline_color:
-            case StyleParamKey::text_font_fill:
-            case StyleParamKey::text_font_stroke_color: {
-                Color result;
-                if (StyleParam::parseColor(value, result)) {
-                    _val = result.abgr;
-                } else {
-                    LOGW("Invalid color value: %s", value.c_str());
-                }
-                break;
+void StyleContext::setMemoKey(const FunctionMemo& _memo, uint8_t _tag) {
+    m_memoKey.clear();
+    m_memoKey += char(_tag);
+    for (const auto& key : _memo.inputs.keys) {
+        appendMemoValue(m_feature->props.get(key), m_memoKey);
+    }
+    for (uint8_t keyword = 0; keyword < m_keywordValues.size(); keyword++) {
+        if (_memo.inputs.keywords & (1u << keyword)) {
+            appendMemoValue(m_keywordValues[keyword], m_memoKey);
+        }
+    }
+}
+
+// Style parameter value for @_key from a string returned by a style function
+static void setStringResult(StyleParamKey _key, std::string value, StyleParam::Value& _val) {
+    switch (_key) {
+        case StyleParamKey::outline_style:
+        case StyleParamKey::repeat_group:
+        case StyleParamKey::sprite:
+        case StyleParamKey::sprite_default:
+        case StyleParamKey::style:
+        case StyleParamKey::text_align:
+        case StyleParamKey::text_repeat_group:
+        case StyleParamKey::text_source:
+        case StyleParamKey::text_source_left:
+        case StyleParamKey::text_source_right:
+        case StyleParamKey::text_transform:
+        case StyleParamKey::texture:
+            _val = value;
+            break;
+        case StyleParamKey::color:
+        case StyleParamKey::outline_color:
+        case StyleParamKey::text_font_fill:
+        case StyleParamKey::text_font_stroke_color: {
+            Color result;
+            if (StyleParam::parseColor(value, result)) {
+                _val = result.abgr;
+            } else {
+                LOGW("Invalid color value: %s", value.c_str());
             }
-            default:
-                _val = StyleParam::parseString(_key, value);
-                break;
+            break;
         }
+        default:
+            _val = StyleParam::parseString(_key, value);
+            break;
+    }
+}
 
-    } else if (jsValue.isBoolean()) {
-        bool value = jsValue.toBool();
+static void setBooleanResult(StyleParamKey _key, bool value, StyleParam::Value& _val) {
+    switch (_key) {
+        case StyleParamKey::interactive:
+        case StyleParamKey::text_interactive:
+        case StyleParamKey::visible:
+        case StyleParamKey::outline_visible:
+        case StyleParamKey::text_visible:
+        case StyleParamKey::text_optional:
+            _val = value;
+            break;
+        case StyleParamKey::extrude:
+            if (value) {
+                _val = StyleParam::TextSource({"min_height", "height"});
+            } else {
+                _val = glm::vec2(0.0f, 0.0f);
+            }
+            break;
+        default:
+            LOGW("Unused bool return type from Javascript style function for %d.", _key);
+            break;
+    }
+}
 
-        switch (_key) {
-            case StyleParamKey::interactive:
-            case StyleParamKey::text_interactive:
-            case StyleParamKey::visible:
-            case StyleParamKey::outline_visible:
-            case StyleParamKey::text_visible:
-            case StyleParamKey::text_optional:
-                _val = value;
-                break;
-            case StyleParamKey::extrude:
-                if (value) {
-                    _val = StyleParam::TextSource({"min_height", "height"});
-                } else {
-                    _val = glm::vec2(0.0f, 0.0f);
-                }
-                break;
-            default:
-                LOGW("Unused bool return type from Javascript style function for %d.", _key);
-                break;
+static void setNumberResult(StyleParamKey _key, double number, StyleParam::Value& _val) {
+    if (std::isnan(number)) {
+        LOGD("duk evaluates JS method to NAN.\n");
+    }
+    switch (_key) {
+        case StyleParamKey::text_source:
+        case StyleParamKey::text_source_left:
+        case StyleParamKey::text_source_right:
+            _val = doubleToString(number);
+            break;
+        case StyleParamKey::extrude:
+            _val = glm::vec2(0.f, number);
+            break;
+        case StyleParamKey::placement_spacing: {
+            _val = StyleParam::Width{static_cast<float>(number), Unit::pixel};
+            break;
+        }
+        case StyleParamKey::width:
+        case StyleParamKey::outline_width: {
+            // TODO more efficient way to return pixels.
+            // atm this only works by return value as string
+            _val = StyleParam::Width{static_cast<float>(number)};
+            break;
+        }
+        case StyleParamKey::alpha:
+        case StyleParamKey::angle:
+        case StyleParamKey::outline_alpha:
+        case StyleParamKey::priority:
+        case StyleParamKey::text_font_alpha:
+        case StyleParamKey::text_font_stroke_alpha:
+        case StyleParamKey::text_priority:
+        case StyleParamKey::text_font_stroke_width:
+        case StyleParamKey::placement_min_length_ratio: {
+            _val = static_cast<float>(number);
+            break;
+        }
+        case StyleParamKey::size: {
+            StyleParam::SizeValue vec;
+            vec.x.value = static_cast<float>(number);
+            _val = vec;
+            break;
+        }
+        case StyleParamKey::order:
+        case StyleParamKey::outline_order:
+        case StyleParamKey::color:
+        case StyleParamKey::outline_color:
+        case StyleParamKey::text_font_fill:
+        case StyleParamKey::text_font_stroke_color: {
+            _val = static_cast<uint32_t>(number);
+            break;
         }
+        default:
+            LOGW("Unused numeric return type from Javascript style function for %d.", _key);
+            break;
+    }
+}
 
+// Style parameter value for @_key from the result of a JS style function
+static void setJSResult(StyleParamKey _key, JSValue& jsValue, StyleParam::Value& _val) {
+    if (jsValue.isString()) {
+        setStringResult(_key, jsValue.toString(), _val);
+    } else if (jsValue.isBoolean()) {
+        setBooleanResult(_key, jsValue.toBool(), _val);
     } else if (jsValue.isArray()) {
         auto len = jsValue.getLength();
 
@@ -274,68 +436,179 @@ bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Val
                 break;
         }
     } else if (jsValue.isNumber()) {
-        double number = jsValue.toDouble();
-        if (std::isnan(number)) {
-            LOGD("duk evaluates JS method to NAN.\n");
-        }
-        switch (_key) {
-            case StyleParamKey::text_source:
-            case StyleParamKey::text_source_left:
-            case StyleParamKey::text_source_right:
-                _val = doubleToString(number);
-                break;
-            case StyleParamKey::extrude:
-                _val = glm::vec2(0.f, number);
-                break;
-            case StyleParamKey::placement_spacing: {
-                _val = StyleParam::Width{static_cast<float>(number), Unit::pixel};
-                break;
-            }
-            case StyleParamKey::width:
-            case StyleParamKey::outline_width: {
-                // TODO more efficient way to return pixels.
-                // atm this only works by return value as string
-                _val = StyleParam::Width{static_cast<float>(number)};
-                break;
-            }
-            case StyleParamKey::alpha:
-            case StyleParamKey::angle:
-            case StyleParamKey::outline_alpha:
-            case StyleParamKey::priority:
-            case StyleParamKey::text_font_alpha:
-            case StyleParamKey::text_font_stroke_alpha:
-            case StyleParamKey::text_priority:
-            case StyleParamKey::text_font_stroke_width:
-            case StyleParamKey::placement_min_length_ratio: {
-                _val = static_cast<float>(number);
-                break;
-            }
-            case StyleParamKey::size: {
-                StyleParam::SizeValue vec;
-                vec.x.value = static_cast<float>(number);
-                _val = vec;
-                break;
-            }
-            case StyleParamKey::order:
-            case StyleParamKey::outline_order:
-            case StyleParamKey::color:
-            case StyleParamKey::outline_color:
-            case StyleParamKey::text_font_fill:
-            case StyleParamKey::text_font_stroke_color: {
-                _val = static_cast<uint32_t>(number);
-                break;
-            }
-            default:
-                LOGW("Unused numeric return type from Javascript style function for %d.", _key);
-                break;
-        }
+        setNumberResult(_key, jsValue.toDouble(), _val);
     } else if (jsValue.isUndefined()) {
         // Explicitly set value as 'undefined'. This is important for some styling rules.
         _val = Undefined();
     } else {
         LOGW("Unhandled return type from Javascript style function for %d.", _key);
     }
+}
+
+bool StyleContext::evalStyle(FunctionID _id, StyleParamKey _key, StyleParam::Value& _val) {
+    _val = none_type{};
+
+#ifdef TANGRAM_JS_TRACING
+    JSTracer _jsTracer(_id);
+#endif
+
+#ifdef TANGRAM_NATIVE_STYLE_FNS
+    if (m_nativeFns && _id < m_nativeFns->size() && m_nativeFns->at(_id)) {
+        return m_nativeFns->at(_id)(*m_feature, _val);
+    }
+#endif
+
+    if (_id < m_expressions.size() && m_expressions[_id]) {
+        StyleExpression::Result result;
+        m_expressions[_id]->eval(*this, m_feature, result);
+
+        switch (result.type) {
+        case StyleExpression::Result::string:
+            setStringResult(_key, *result.str, _val);
+            break;
+        case StyleExpression::Result::boolean:
+            setBooleanResult(_key, result.booleanValue, _val);
+            break;
+        case StyleExpression::Result::number:
+            setNumberResult(_key, result.numberValue, _val);
+            break;
+        case StyleExpression::Result::undefined:
+            _val = Undefined();
+            break;
+        default:
+            LOGW("Unhandled return type from Javascript style function for %d.", _key);
+            break;
+        }
+        return !_val.is<none_type>();
+    }
+
+    if (FunctionBatch* batch = getBatch(_id)) {
+        if (batch->states[m_batchIndex] == FunctionBatch::State::evaluated && batch->key == _key) {
+            _val = batch->results[m_batchIndex];
+            return !_val.is<none_type>();
+        }
+    }
+
+    FunctionMemo* memo = (m_feature && _id < m_memos.size()) ? m_memos[_id].get() : nullptr;
+    if (memo) {
+        setMemoKey(*memo, static_cast<uint8_t>(_key));
+        auto it = memo->results.find(m_memoKey);
+        if (it != memo->results.end()) {
+            _val = it->second;
+            return !_val.is<none_type>();
+        }
+    }
+
+    bool result = evalJSStyle(_id, _key, _val);
+
+    if (memo && memo->results.size() < MAX_MEMO_RESULTS) {
+        memo->results.emplace(m_memoKey, _val);
+    }
+    return result;
+}
+
+bool StyleContext::evalJSStyle(FunctionID _id, StyleParamKey _key, StyleParam::Value& _val) {
+
+    JSScope jsScope(*m_jsContext);
+    auto jsValue = jsScope.getFunctionResult(_id);
+    if (!jsValue) {
+        return false;
+    }
+
+    setJSResult(_key, jsValue, _val);
     return !_val.is<none_type>();
 }
 
+void StyleContext::beginBatch(Span<Feature> _features) {
+    endBatch();
+    m_batchFeatures = _features.data();
+    m_batchSize = _features.size();
+    m_batchIndex = m_batchSize;
+}
+
+void StyleContext::endBatch() {
+    for (auto& batch : m_batches) {
+        if (!batch) { continue; }
+        batch->queued.clear();
+        batch->states.clear();
+        batch->results.clear();
+    }
+    m_batchFeatures = nullptr;
+    m_batchSize = 0;
+    m_batchIndex = 0;
+}
+
+StyleContext::FunctionBatch* StyleContext::getBatch(FunctionID _id) {
+    if (m_batchIndex >= m_batchSize || _id >= m_batches.size()) { return nullptr; }
+
+    FunctionBatch* batch = m_batches[_id].get();
+    if (batch && batch->states.empty()) {
+        batch->states.assign(m_batchSize, FunctionBatch::State::none);
+        batch->results.resize(m_batchSize);
+    }
+    return batch;
+}
+
+void StyleContext::queueBatch(FunctionID _id, StyleParamKey _key) {
+#ifdef TANGRAM_NATIVE_STYLE_FNS
+    if (m_nativeFns && _id < m_nativeFns->size() && m_nativeFns->at(_id)) { return; }
+#endif
+    FunctionBatch* batch = getBatch(_id);
+    if (!batch || batch->states[m_batchIndex] != FunctionBatch::State::none) { return; }
+
+    batch->key = _key;
+    batch->states[m_batchIndex] = FunctionBatch::State::queued;
+    batch->queued.push_back(m_batchIndex);
+}
+
+void StyleContext::evalBatch() {
+    std::vector<const Feature*> features;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> failed;
+
+    for (FunctionID id = 0; id < m_batches.size(); id++) {
+        FunctionBatch* batch = m_batches[id].get();
+        if (!batch || batch->queued.empty()) { continue; }
+
+        // $geometry is a global of the JS context: one call for the features of each geometry type
+        for (int type = GeometryType::unknown; type <= GeometryType::polygons; type++) {
+            features.clear();
+            indices.clear();
+            failed.clear();
+            for (uint32_t index : batch->queued) {
+                if (m_batchFeatures[index].geometryType == type) {
+                    features.push_back(&m_batchFeatures[index]);
+                    indices.push_back(index);
+                }
+            }
+            if (features.empty()) { continue; }
+
+            if (m_keywordGeometry != type) {
+                setKeyword(FilterKeyword::geometry, s_geometryStrings[type]);
+                m_keywordGeometry = type;
+            }
+
+            JSScope jsScope(*m_jsContext);
+            auto jsResults = jsScope.getBatchResult(id, features, failed);
+            // features stay queued and are evaluated one by one if the batch failed
+            if (!jsResults) { continue; }
+
+            size_t nextFailed = 0;
+            for (size_t i = 0; i < indices.size(); i++) {
+                auto& value = batch->results[indices[i]];
+                value = none_type{};
+                if (nextFailed < failed.size() && failed[nextFailed] == i) {
+                    nextFailed++;
+                } else {
+                    JSScope jsValueScope(*m_jsContext);
+                    auto jsValue = jsResults.getValueAtIndex(i);
+                    setJSResult(batch->key, jsValue, value);
+                }
+                batch->states[indices[i]] = FunctionBatch::State::evaluated;
+            }
+        }
+        batch->queued.clear();
+    }
+}
+
 } // namespace Tangram
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "data/tileData.h"
 #include "js/JavaScriptFwd.h"
 #include "scene/styleParam.h"
 #include "tile/tileID.h"
@@ -7,6 +8,7 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace YAML {
     class Node;
@@ -15,6 +17,7 @@ namespace YAML {
 namespace Tangram {
 
 class Scene;
+class StyleExpression;
 struct Feature;
 
 enum class StyleParamKey : uint8_t;
@@ -61,7 +64,8 @@ public:
     /// Called from DrawRule::eval
     bool evalStyle(FunctionID id, StyleParamKey key, StyleParam::Value& value);
 
-    /// Setup filter and style functions from a Scene.
+    /// Setup filter and style functions from a Scene. Functions are kept when the context
+    /// is reused for a Scene with the same functions, e.g. a reloaded one.
     void initFunctions(const Scene& scene);
 
     /// Unset the current Feature.
@@ -71,10 +75,38 @@ public:
     bool addFunction(const std::string& function);
     void setSceneGlobals(const YAML::Node& sceneGlobals);
 
+    /* Batch evaluation of JS functions for the features of a collection: after beginBatch(),
+     * queueBatch() the functions that each feature needs while it is set. evalBatch() then
+     * evaluates each queued function in one call into the JS context, and evalFilter() and
+     * evalStyle() return those results until endBatch(). Filter results of JS functions are
+     * kept for the batch too.
+     */
+    void beginBatch(Span<Feature> features);
+    void queueBatch(FunctionID id, StyleParamKey key);
+    void evalBatch();
+    void endBatch();
+
+    /// Whether there are JS functions that are neither evaluated natively nor memoized
+    bool hasBatchFunctions() const { return m_hasBatchFunctions; }
+
 private:
 
+    // Results of a JS function by the values of the inputs it reads, for the current tile
+    struct FunctionMemo;
+
+    // Results of a JS function by feature index, for the current batch
+    struct FunctionBatch;
+
+    // Batch of function @id if the current feature is in the batch, else nullptr
+    FunctionBatch* getBatch(FunctionID id);
+
     void setKeyword(FilterKeyword keyword, Value value);
 
+    // Set m_memoKey to the values of the inputs of @memo with @tag for the result type
+    void setMemoKey(const FunctionMemo& memo, uint8_t tag);
+
+    bool evalJSStyle(FunctionID id, StyleParamKey key, StyleParam::Value& value);
+
     std::array<Value, 6> m_keywordValues;
 
     // Cache zoom separately from keywords for easier access.
@@ -85,11 +117,29 @@ private:
 
     int m_functionCount = 0;
 
+    // Sources of the functions, to reuse them for the next Scene
+    std::vector<std::string> m_functionSources;
+
     int32_t m_sceneId = -1;
 
     const Feature* m_feature = nullptr;
 
     std::unique_ptr<JSContext> m_jsContext;
+
+    // Functions that are evaluated natively, by function id; nullptr for those left to JS
+    std::vector<std::unique_ptr<StyleExpression>> m_expressions;
+
+    // Memos of JS functions, by function id; nullptr for those that may read other state
+    std::vector<std::unique_ptr<FunctionMemo>> m_memos;
+    std::string m_memoKey;
+
+    // Batches of JS functions, by function id; nullptr for those evaluated otherwise
+    std::vector<std::unique_ptr<FunctionBatch>> m_batches;
+    bool m_hasBatchFunctions = false;
+    const Feature* m_batchFeatures = nullptr;
+    size_t m_batchSize = 0;
+    // Index of the current feature in the batch, m_batchSize when it is not in the batch
+    size_t m_batchIndex = 0;
 #ifdef TANGRAM_NATIVE_STYLE_FNS
     const NativeStyleFns* m_nativeFns = nullptr;
 #endif
@@ -0,0 +1,871 @@
+#include "scene/styleExpression.h"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "scene/filters.h"
+#include "scene/styleContext.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace Tangram {
+
+bool StyleExpression::Result::toBoolean() const {
+    switch (type) {
+    case boolean: return booleanValue;
+    case number: return numberValue != 0 && !std::isnan(numberValue);
+    case string: return !str->empty();
+    default: return false;
+    }
+}
+
+double StyleExpression::Result::toNumber() const {
+    switch (type) {
+    case null: return 0;
+    case boolean: return booleanValue ? 1 : 0;
+    case number: return numberValue;
+    case string: {
+        const char* begin = str->c_str();
+        const char* end = begin + str->size();
+        while (begin < end && std::isspace(uint8_t(*begin))) { begin++; }
+        while (end > begin && std::isspace(uint8_t(end[-1]))) { end--; }
+        if (begin == end) { return 0; }
+        // strtod also reads hex floats and 'inf' or 'nan', JS only 'Infinity'
+        std::string s(begin, end);
+        if (s == "Infinity" || s == "+Infinity") { return INFINITY; }
+        if (s == "-Infinity") { return -INFINITY; }
+        for (char c : s) {
+            if (!(std::isdigit(uint8_t(c)) || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')) {
+                return NAN;
+            }
+        }
+        char* parsed = nullptr;
+        double value = std::strtod(s.c_str(), &parsed);
+        return parsed == s.c_str() + s.size() ? value : NAN;
+    }
+    default: return NAN;
+    }
+}
+
+std::string StyleExpression::Result::toString() const {
+    switch (type) {
+    case boolean: return booleanValue ? "true" : "false";
+    case number: return numberToString(numberValue);
+    case string: return *str;
+    case null: return "null";
+    default: return "undefined";
+    }
+}
+
+std::string StyleExpression::numberToString(double _number) {
+
+    if (std::isnan(_number)) { return "NaN"; }
+    if (std::isinf(_number)) { return _number > 0 ? "Infinity" : "-Infinity"; }
+    if (_number == 0) { return "0"; }
+
+    // shortest digits that read back as the same number
+    char buf[32];
+    for (int precision = 0; precision < 17; precision++) {
+        snprintf(buf, sizeof(buf), "%.*e", precision, _number);
+        if (std::strtod(buf, nullptr) == _number) { break; }
+    }
+
+    std::string mantissa(buf, std::strchr(buf, 'e'));
+    int exponent = std::atoi(std::strchr(buf, 'e') + 1);
+
+    std::string sign;
+    if (mantissa[0] == '-') {
+        sign = "-";
+        mantissa.erase(0, 1);
+    }
+    std::string digits;
+    for (char c : mantissa) { if (c != '.') { digits += c; } }
+
+    // 'n' and 'k' as in ECMAScript Number::toString
+    int k = int(digits.size());
+    int n = exponent + 1;
+
+    if (k <= n && n <= 21) {
+        return sign + digits + std::string(n - k, '0');
+    }
+    if (0 < n && n <= 21) {
+        return sign + digits.substr(0, n) + "." + digits.substr(n);
+    }
+    if (-6 < n && n <= 0) {
+        return sign + "0." + std::string(-n, '0') + digits;
+    }
+    std::string result = sign + digits.substr(0, 1);
+    if (k > 1) { result += "." + digits.substr(1); }
+    result += (n - 1 < 0) ? "e-" : "e+";
+    result += std::to_string(std::abs(n - 1));
+    return result;
+}
+
+// Recursive descent parser for the supported subset of JS
+class StyleExpression::Parser {
+
+public:
+
+    Parser(const std::string& _source, std::vector<Node>& _nodes) :
+        m_source(_source), m_nodes(_nodes) {}
+
+    // Parse 'function() { ... }', returns the block node of its body
+    uint32_t parseFunction() {
+        if (!read("function") || !read("(") || !read(")") || !peek("{")) { return NONE; }
+        uint32_t body = parseStatement();
+        skipSpace();
+        if (body == NONE || m_pos != m_source.size()) { return NONE; }
+        return body;
+    }
+
+private:
+
+    void skipSpace() {
+        while (m_pos < m_source.size()) {
+            char c = m_source[m_pos];
+            if (std::isspace(uint8_t(c))) {
+                m_pos++;
+            } else if (c == '/' && m_pos + 1 < m_source.size() && m_source[m_pos + 1] == '/') {
+                while (m_pos < m_source.size() && m_source[m_pos] != '\n') { m_pos++; }
+            } else if (c == '/' && m_pos + 1 < m_source.size() && m_source[m_pos + 1] == '*') {
+                size_t end = m_source.find("*/", m_pos + 2);
+                m_pos = (end == std::string::npos) ? m_source.size() : end + 2;
+            } else {
+                break;
+            }
+        }
+    }
+
+    static bool isIdentifierChar(char c) {
+        return std::isalnum(uint8_t(c)) || c == '_' || c == '$';
+    }
+
+    bool peek(const char* _token) {
+        skipSpace();
+        size_t len = std::strlen(_token);
+        if (m_source.compare(m_pos, len, _token) != 0) { return false; }
+        // '=' must not be the start of '==' or '===', nor '<' of '<=' etc.
+        if (m_pos + len < m_source.size()) {
+            char next = m_source[m_pos + len];
+            if (isIdentifierChar(_token[len - 1]) && isIdentifierChar(next)) { return false; }
+            if (std::strchr("=<>!", _token[len - 1]) && next == '=') { return false; }
+            if ((_token[0] == '&' || _token[0] == '|') && len == 1 && next == _token[0]) { return false; }
+        }
+        return true;
+    }
+
+    bool read(const char* _token) {
+        if (!peek(_token)) { return false; }
+        m_pos += std::strlen(_token);
+        return true;
+    }
+
+    bool identifier(std::string& _name) {
+        skipSpace();
+        size_t begin = m_pos;
+        if (m_pos < m_source.size() && std::isdigit(uint8_t(m_source[m_pos]))) { return false; }
+        while (m_pos < m_source.size() && isIdentifierChar(m_source[m_pos])) { m_pos++; }
+        _name = m_source.substr(begin, m_pos - begin);
+        return !_name.empty();
+    }
+
+    bool stringLiteral(std::string& _value) {
+        skipSpace();
+        if (m_pos >= m_source.size()) { return false; }
+        char quote = m_source[m_pos];
+        if (quote != '\'' && quote != '"') { return false; }
+
+        _value.clear();
+        for (m_pos++; m_pos < m_source.size(); m_pos++) {
+            char c = m_source[m_pos];
+            if (c == quote) {
+                m_pos++;
+                return true;
+            }
+            if (c == '\\') {
+                if (++m_pos >= m_source.size()) { return false; }
+                c = m_source[m_pos];
+                switch (c) {
+                case 'n': _value += '\n'; break;
+                case 't': _value += '\t'; break;
+                case '\\': case '\'': case '"': _value += c; break;
+                // other escapes, e.g. unicode, are left to the JS engine
+                default: return false;
+                }
+            } else if (c == '\n') {
+                return false;
+            } else {
+                _value += c;
+            }
+        }
+        return false;
+    }
+
+    bool numberLiteral(double& _value) {
+        skipSpace();
+        const char* begin = m_source.c_str() + m_pos;
+        if (!(std::isdigit(uint8_t(*begin)) || (*begin == '.' && std::isdigit(uint8_t(begin[1]))))) {
+            return false;
+        }
+        // no hex, octal or binary literals
+        if (begin[0] == '0' && std::isalnum(uint8_t(begin[1])) && begin[1] != 'e' && begin[1] != 'E') {
+            return false;
+        }
+        char* end = nullptr;
+        _value = std::strtod(begin, &end);
+        m_pos += end - begin;
+        return m_pos >= m_source.size() || !isIdentifierChar(m_source[m_pos]);
+    }
+
+    uint32_t add(Node&& _node) {
+        m_nodes.push_back(std::move(_node));
+        return uint32_t(m_nodes.size() - 1);
+    }
+
+    uint32_t binary(Op _op, uint32_t _a, uint32_t _b) {
+        if (_a == NONE || _b == NONE) { return NONE; }
+        Node node{_op};
+        node.a = _a;
+        node.b = _b;
+        return add(std::move(node));
+    }
+
+    uint32_t parseStatement() {
+        if (++m_depth > MAX_DEPTH) { return NONE; }
+        uint32_t result = statement();
+        m_depth--;
+        return result;
+    }
+
+    uint32_t statement() {
+        if (read("{")) {
+            Node block{Op::block};
+            while (!read("}")) {
+                if (m_pos >= m_source.size()) { return NONE; }
+                uint32_t stmt = parseStatement();
+                if (stmt == NONE) { return NONE; }
+                block.nodes.push_back(stmt);
+            }
+            return add(std::move(block));
+        }
+        if (read(";")) {
+            return add(Node{Op::block});
+        }
+        if (read("if")) {
+            if (!read("(")) { return NONE; }
+            Node node{Op::if_else};
+            node.a = parseExpression();
+            if (node.a == NONE || !read(")")) { return NONE; }
+            node.b = parseStatement();
+            if (node.b == NONE) { return NONE; }
+            if (read("else")) {
+                node.c = parseStatement();
+                if (node.c == NONE) { return NONE; }
+            }
+            return add(std::move(node));
+        }
+        if (read("return")) {
+            Node node{Op::return_value};
+            if (!peek(";") && !peek("}")) {
+                node.a = parseExpression();
+                if (node.a == NONE) { return NONE; }
+            }
+            read(";");
+            return add(std::move(node));
+        }
+        return NONE;
+    }
+
+    uint32_t parseExpression() {
+        if (++m_depth > MAX_DEPTH) { return NONE; }
+        uint32_t result = conditional();
+        m_depth--;
+        return result;
+    }
+
+    uint32_t conditional() {
+        uint32_t cond = logicalOr();
+        if (cond == NONE || !read("?")) { return cond; }
+
+        Node node{Op::conditional};
+        node.a = cond;
+        node.b = parseExpression();
+        if (node.b == NONE || !read(":")) { return NONE; }
+        node.c = parseExpression();
+        if (node.c == NONE) { return NONE; }
+        return add(std::move(node));
+    }
+
+    uint32_t logicalOr() {
+        uint32_t left = logicalAnd();
+        while (left != NONE && read("||")) { left = binary(Op::logical_or, left, logicalAnd()); }
+        return left;
+    }
+
+    uint32_t logicalAnd() {
+        uint32_t left = equality();
+        while (left != NONE && read("&&")) { left = binary(Op::logical_and, left, equality()); }
+        return left;
+    }
+
+    uint32_t equality() {
+        uint32_t left = relational();
+        while (left != NONE) {
+            if (read("===")) { left = binary(Op::strict_equal, left, relational()); }
+            else if (read("!==")) { left = binary(Op::strict_not_equal, left, relational()); }
+            else if (read("==")) { left = binary(Op::equal, left, relational()); }
+            else if (read("!=")) { left = binary(Op::not_equal, left, relational()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    uint32_t relational() {
+        uint32_t left = additive();
+        while (left != NONE) {
+            if (read("<=")) { left = binary(Op::less_equal, left, additive()); }
+            else if (read(">=")) { left = binary(Op::greater_equal, left, additive()); }
+            else if (read("<")) { left = binary(Op::less, left, additive()); }
+            else if (read(">")) { left = binary(Op::greater, left, additive()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    uint32_t additive() {
+        uint32_t left = multiplicative();
+        while (left != NONE) {
+            if (peek("++") || peek("--")) { return NONE; }
+            if (read("+")) { left = binary(Op::add, left, multiplicative()); }
+            else if (read("-")) { left = binary(Op::subtract, left, multiplicative()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    uint32_t multiplicative() {
+        uint32_t left = unary();
+        while (left != NONE) {
+            if (peek("*=") || peek("/=") || peek("%=") || peek("**")) { return NONE; }
+            if (read("*")) { left = binary(Op::multiply, left, unary()); }
+            else if (read("/")) { left = binary(Op::divide, left, unary()); }
+            else if (read("%")) { left = binary(Op::modulo, left, unary()); }
+            else { break; }
+        }
+        return left;
+    }
+
+    uint32_t unary() {
+        if (peek("++") || peek("--")) { return NONE; }
+        Op op;
+        if (read("!")) { op = Op::logical_not; }
+        else if (read("-")) { op = Op::negate; }
+        else if (read("+")) {
+            // '+x' converts x to a number, like 'x * 1'
+            uint32_t operand = unary();
+            Node one{Op::literal, uint8_t(Result::number)};
+            one.number = 1;
+            return binary(Op::multiply, operand, add(std::move(one)));
+        }
+        else { return primary(); }
+
+        if (++m_depth > MAX_DEPTH) { return NONE; }
+        Node node{op};
+        node.a = unary();
+        m_depth--;
+        if (node.a == NONE) { return NONE; }
+        return add(std::move(node));
+    }
+
+    uint32_t primary() {
+        if (read("(")) {
+            uint32_t expr = parseExpression();
+            if (expr == NONE || !read(")")) { return NONE; }
+            return expr;
+        }
+
+        Node node{Op::literal};
+        if (numberLiteral(node.number)) {
+            node.arg = Result::number;
+            return add(std::move(node));
+        }
+        if (stringLiteral(node.str)) {
+            node.arg = Result::string;
+            return add(std::move(node));
+        }
+
+        std::string name;
+        if (!identifier(name)) { return NONE; }
+
+        if (name == "true" || name == "false") {
+            node.arg = Result::boolean;
+            node.number = (name == "true");
+            return add(std::move(node));
+        }
+        if (name == "undefined" || name == "null") {
+            node.arg = (name == "null") ? Result::null : Result::undefined;
+            return add(std::move(node));
+        }
+        if (name == "NaN" || name == "Infinity") {
+            node.arg = Result::number;
+            node.number = (name == "NaN") ? NAN : INFINITY;
+            return add(std::move(node));
+        }
+        if (name == "feature") {
+            Node property{Op::property};
+            if (read(".")) {
+                if (!identifier(property.str)) { return NONE; }
+            } else if (read("[")) {
+                if (!stringLiteral(property.str) || !read("]")) { return NONE; }
+            } else {
+                return NONE;
+            }
+            // methods of the value, e.g. feature.name.length, are left to the JS engine
+            if (peek(".") || peek("[") || peek("(")) { return NONE; }
+            return add(std::move(property));
+        }
+        if (name[0] == '$') {
+            auto keyword = stringToFilterKeyword(name);
+            if (keyword == FilterKeyword::undefined) { return NONE; }
+            Node key{Op::keyword, uint8_t(keyword)};
+            return add(std::move(key));
+        }
+        if (name == "Math") {
+            return math();
+        }
+        return NONE;
+    }
+
+    uint32_t math() {
+        static const std::pair<const char*, MathFn> functions[] = {
+            { "min", MathFn::min }, { "max", MathFn::max }, { "floor", MathFn::floor },
+            { "ceil", MathFn::ceil }, { "round", MathFn::round }, { "abs", MathFn::abs },
+            { "sqrt", MathFn::sqrt }, { "pow", MathFn::pow },
+        };
+
+        std::string name;
+        if (!read(".") || !identifier(name)) { return NONE; }
+
+        Node node{Op::math};
+        bool found = false;
+        for (const auto& fn : functions) {
+            if (name == fn.first) {
+                node.arg = uint8_t(fn.second);
+                found = true;
+            }
+        }
+        if (!found || !read("(")) { return NONE; }
+
+        if (!read(")")) {
+            do {
+                uint32_t arg = parseExpression();
+                if (arg == NONE) { return NONE; }
+                node.nodes.push_back(arg);
+            } while (read(","));
+            if (!read(")")) { return NONE; }
+        }
+        return add(std::move(node));
+    }
+
+    static constexpr int MAX_DEPTH = 64;
+
+    const std::string& m_source;
+    std::vector<Node>& m_nodes;
+    size_t m_pos = 0;
+    int m_depth = 0;
+};
+
+std::unique_ptr<StyleExpression> StyleExpression::compile(const std::string& _source) {
+
+    auto expression = std::make_unique<StyleExpression>();
+
+    Parser parser(_source, expression->m_nodes);
+    expression->m_body = parser.parseFunction();
+
+    if (expression->m_body == NONE) { return nullptr; }
+    return expression;
+}
+
+void StyleExpression::eval(const StyleContext& _ctx, const Feature* _feature, Result& _result) const {
+    _result.setUndefined();
+    if (!execNode(m_body, _ctx, _feature, _result)) { _result.setUndefined(); }
+}
+
+bool StyleExpression::execNode(uint32_t _id, const StyleContext& _ctx, const Feature* _feature,
+                               Result& _result) const {
+    const Node& node = m_nodes[_id];
+
+    switch (node.op) {
+    case Op::block:
+        for (uint32_t stmt : node.nodes) {
+            if (execNode(stmt, _ctx, _feature, _result)) { return true; }
+        }
+        return false;
+
+    case Op::if_else: {
+        Result cond;
+        evalNode(node.a, _ctx, _feature, cond);
+        if (cond.toBoolean()) { return execNode(node.b, _ctx, _feature, _result); }
+        if (node.c != NONE) { return execNode(node.c, _ctx, _feature, _result); }
+        return false;
+    }
+    case Op::return_value:
+        if (node.a == NONE) {
+            _result.setUndefined();
+        } else {
+            evalNode(node.a, _ctx, _feature, _result);
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// JS abstract equality
+static bool looseEquals(const StyleExpression::Result& _a, const StyleExpression::Result& _b) {
+    using Result = StyleExpression::Result;
+
+    if (_a.type == _b.type) {
+        switch (_a.type) {
+        case Result::boolean: return _a.booleanValue == _b.booleanValue;
+        case Result::number: return _a.numberValue == _b.numberValue;
+        case Result::string: return *_a.str == *_b.str;
+        default: return true;
+        }
+    }
+    auto isNullish = [](const Result& r) { return r.type == Result::undefined || r.type == Result::null; };
+    if (isNullish(_a) || isNullish(_b)) { return isNullish(_a) && isNullish(_b); }
+
+    // booleans and strings compare as numbers with numbers and with each other
+    return _a.toNumber() == _b.toNumber();
+}
+
+static bool strictEquals(const StyleExpression::Result& _a, const StyleExpression::Result& _b) {
+    return _a.type == _b.type && looseEquals(_a, _b);
+}
+
+void StyleExpression::evalNode(uint32_t _id, const StyleContext& _ctx, const Feature* _feature,
+                               Result& _result) const {
+    const Node& node = m_nodes[_id];
+
+    switch (node.op) {
+    case Op::literal:
+        switch (node.arg) {
+        case Result::boolean: _result.setBoolean(node.number != 0); break;
+        case Result::number: _result.setNumber(node.number); break;
+        case Result::string: _result.setString(&node.str); break;
+        case Result::null: _result.setNull(); break;
+        default: _result.setUndefined(); break;
+        }
+        return;
+
+    case Op::property: {
+        if (!_feature) { return _result.setUndefined(); }
+        const auto& value = _feature->props.get(node.str);
+        if (value.is<std::string>()) { _result.setString(&value.get<std::string>()); }
+        else if (value.is<double>()) { _result.setNumber(value.get<double>()); }
+        else { _result.setUndefined(); }
+        return;
+    }
+    case Op::keyword: {
+        const auto& value = _ctx.getKeyword(FilterKeyword(node.arg));
+        if (value.is<std::string>()) { _result.setString(&value.get<std::string>()); }
+        else if (value.is<double>()) { _result.setNumber(value.get<double>()); }
+        else { _result.setUndefined(); }
+        return;
+    }
+    case Op::negate:
+        evalNode(node.a, _ctx, _feature, _result);
+        return _result.setNumber(-_result.toNumber());
+
+    case Op::logical_not:
+        evalNode(node.a, _ctx, _feature, _result);
+        return _result.setBoolean(!_result.toBoolean());
+
+    case Op::logical_and:
+    case Op::logical_or:
+        // result is the operand that decides, as in JS
+        evalNode(node.a, _ctx, _feature, _result);
+        if (_result.toBoolean() == (node.op == Op::logical_or)) { return; }
+        return evalNode(node.b, _ctx, _feature, _result);
+
+    case Op::conditional: {
+        Result cond;
+        evalNode(node.a, _ctx, _feature, cond);
+        return evalNode(cond.toBoolean() ? node.b : node.c, _ctx, _feature, _result);
+    }
+    case Op::math: {
+        auto fn = MathFn(node.arg);
+        std::vector<double> args;
+        args.reserve(node.nodes.size());
+        for (uint32_t arg : node.nodes) {
+            Result value;
+            evalNode(arg, _ctx, _feature, value);
+            args.push_back(value.toNumber());
+        }
+        double x = args.empty() ? NAN : args[0];
+        switch (fn) {
+        case MathFn::min:
+        case MathFn::max: {
+            bool min = fn == MathFn::min;
+            double result = min ? INFINITY : -INFINITY;
+            for (double v : args) {
+                if (std::isnan(v)) { result = NAN; break; }
+                result = min ? std::min(result, v) : std::max(result, v);
+            }
+            return _result.setNumber(result);
+        }
+        case MathFn::floor: return _result.setNumber(std::floor(x));
+        case MathFn::ceil: return _result.setNumber(std::ceil(x));
+        case MathFn::round: return _result.setNumber(std::floor(x + 0.5));
+        case MathFn::abs: return _result.setNumber(std::fabs(x));
+        case MathFn::sqrt: return _result.setNumber(std::sqrt(x));
+        case MathFn::pow: return _result.setNumber(std::pow(x, args.size() > 1 ? args[1] : NAN));
+        }
+        return _result.setNumber(NAN);
+    }
+    default:
+        break;
+    }
+
+    // binary operators
+    Result left, right;
+    evalNode(node.a, _ctx, _feature, left);
+    evalNode(node.b, _ctx, _feature, right);
+
+    switch (node.op) {
+    case Op::add:
+        if (left.type == Result::string || right.type == Result::string) {
+            return _result.setString(left.toString() + right.toString());
+        }
+        return _result.setNumber(left.toNumber() + right.toNumber());
+    case Op::subtract: return _result.setNumber(left.toNumber() - right.toNumber());
+    case Op::multiply: return _result.setNumber(left.toNumber() * right.toNumber());
+    case Op::divide: return _result.setNumber(left.toNumber() / right.toNumber());
+    case Op::modulo: return _result.setNumber(std::fmod(left.toNumber(), right.toNumber()));
+
+    case Op::less:
+    case Op::less_equal:
+    case Op::greater:
+    case Op::greater_equal: {
+        int cmp;
+        if (left.type == Result::string && right.type == Result::string) {
+            cmp = left.str->compare(*right.str);
+        } else {
+            double a = left.toNumber(), b = right.toNumber();
+            if (std::isnan(a) || std::isnan(b)) { return _result.setBoolean(false); }
+            cmp = (a < b) ? -1 : (a > b) ? 1 : 0;
+        }
+        switch (node.op) {
+        case Op::less: return _result.setBoolean(cmp < 0);
+        case Op::less_equal: return _result.setBoolean(cmp <= 0);
+        case Op::greater: return _result.setBoolean(cmp > 0);
+        default: return _result.setBoolean(cmp >= 0);
+        }
+    }
+    case Op::equal: return _result.setBoolean(looseEquals(left, right));
+    case Op::not_equal: return _result.setBoolean(!looseEquals(left, right));
+    case Op::strict_equal: return _result.setBoolean(strictEquals(left, right));
+    case Op::strict_not_equal: return _result.setBoolean(!strictEquals(left, right));
+
+    default:
+        return _result.setUndefined();
+    }
+}
+
+namespace {
+
+struct Token {
+    enum Type : uint8_t { identifier, number, string, punctuator };
+    Type type;
+    std::string text;
+
+    bool is(Type _type, const char* _text) const { return type == _type && text == _text; }
+    bool isPunctuator(const char* _text) const { return is(punctuator, _text); }
+};
+
+template<size_t N>
+bool contains(const char* const (&_names)[N], const std::string& _name) {
+    for (const char* name : _names) {
+        if (_name == name) { return true; }
+    }
+    return false;
+}
+
+// Splits JS source into tokens; returns false for template strings and regular expressions
+bool tokenize(const std::string& _source, std::vector<Token>& _tokens) {
+
+    // longest first
+    static const char* const punctuators[] = {
+        ">>>=", "===", "!==", "**=", "<<=", ">>=", ">>>", "...",
+        "==", "!=", "<=", ">=", "&&", "||", "??", "++", "--", "+=", "-=", "*=", "/=", "%=",
+        "&=", "|=", "^=", "=>", "**", "<<", ">>", "?.",
+    };
+    // names after which '/' starts a regular expression
+    static const char* const operatorNames[] = {
+        "return", "typeof", "case", "in", "of", "instanceof", "new", "delete", "void",
+    };
+
+    size_t pos = 0;
+    size_t size = _source.size();
+
+    while (pos < size) {
+        char c = _source[pos];
+
+        if (std::isspace(uint8_t(c))) {
+            pos++;
+        } else if (c == '/' && pos + 1 < size && _source[pos + 1] == '/') {
+            while (pos < size && _source[pos] != '\n') { pos++; }
+        } else if (c == '/' && pos + 1 < size && _source[pos + 1] == '*') {
+            size_t end = _source.find("*/", pos + 2);
+            if (end == std::string::npos) { return false; }
+            pos = end + 2;
+        } else if (c == '\'' || c == '"') {
+            Token token{Token::string, ""};
+            for (pos++; pos < size && _source[pos] != c; pos++) {
+                if (_source[pos] == '\\') {
+                    if (++pos >= size) { return false; }
+                    // only the escapes that property names are likely to use
+                    switch (_source[pos]) {
+                    case 'n': token.text += '\n'; break;
+                    case 't': token.text += '\t'; break;
+                    default: token.text += _source[pos]; break;
+                    }
+                } else {
+                    token.text += _source[pos];
+                }
+            }
+            if (pos++ >= size) { return false; }
+            _tokens.push_back(std::move(token));
+        } else if (c == '`') {
+            return false;
+        } else if (std::isalnum(uint8_t(c)) || c == '_' || c == '$' ||
+                   (c == '.' && pos + 1 < size && std::isdigit(uint8_t(_source[pos + 1])))) {
+            // a number reads on through its letters and dots, e.g. 1.5e3 or 0xff
+            bool number = !(std::isalpha(uint8_t(c)) || c == '_' || c == '$');
+            size_t begin = pos;
+            while (pos < size && (std::isalnum(uint8_t(_source[pos])) || _source[pos] == '_' ||
+                                  _source[pos] == '$' || (number && _source[pos] == '.'))) {
+                pos++;
+            }
+            _tokens.push_back({number ? Token::number : Token::identifier,
+                               _source.substr(begin, pos - begin)});
+        } else {
+            if (c == '/') {
+                bool division = !_tokens.empty() &&
+                    ((_tokens.back().type == Token::identifier &&
+                      !contains(operatorNames, _tokens.back().text)) ||
+                     _tokens.back().type == Token::number || _tokens.back().type == Token::string ||
+                     _tokens.back().isPunctuator(")") || _tokens.back().isPunctuator("]"));
+                if (!division) { return false; }
+            }
+            std::string text(1, c);
+            for (const char* punctuator : punctuators) {
+                if (_source.compare(pos, std::strlen(punctuator), punctuator) == 0) {
+                    text = punctuator;
+                    break;
+                }
+            }
+            pos += text.size();
+            _tokens.push_back({Token::punctuator, std::move(text)});
+        }
+    }
+    return true;
+}
+
+}
+
+bool StyleExpression::scanInputs(const std::string& _source, Inputs& _inputs) {
+
+    // names that neither read state nor change it
+    static const char* const pureNames[] = {
+        "function", "return", "if", "else", "var", "let", "const", "for", "while", "do",
+        "break", "continue", "switch", "case", "default", "typeof", "in", "of", "instanceof",
+        "new", "true", "false", "null", "undefined", "NaN", "Infinity",
+        "Math", "Number", "String", "Boolean", "Array", "Object", "JSON",
+        "parseInt", "parseFloat", "isNaN", "isFinite",
+    };
+    // members of builtins that are not deterministic
+    static const char* const impureMembers[] = { "random", "now" };
+
+    static const char* const assignments[] = {
+        "=", "+=", "-=", "*=", "/=", "%=", "**=", "<<=", ">>=", ">>>=", "&=", "|=", "^=", "++", "--",
+    };
+
+    std::vector<Token> tokens;
+    if (!tokenize(_source, tokens)) { return false; }
+    if (tokens.empty() || !tokens[0].is(Token::identifier, "function")) { return false; }
+
+    std::vector<std::string> locals;
+    bool parameters = false;
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const Token& token = tokens[i];
+        const Token* prev = i > 0 ? &tokens[i - 1] : nullptr;
+
+        if (token.isPunctuator(")")) { parameters = false; }
+        if (token.type != Token::identifier) { continue; }
+
+        const std::string& name = token.text;
+
+        if (prev && (prev->isPunctuator(".") || prev->isPunctuator("?."))) {
+            if (contains(impureMembers, name)) { return false; }
+            continue;
+        }
+        if (name == "feature") {
+            // feature.key or feature['key'], not assigned to
+            size_t next;
+            std::string key;
+            if (i + 2 < tokens.size() && tokens[i + 1].isPunctuator(".") &&
+                tokens[i + 2].type == Token::identifier) {
+                key = tokens[i + 2].text;
+                next = i + 3;
+            } else if (i + 3 < tokens.size() && tokens[i + 1].isPunctuator("[") &&
+                       tokens[i + 2].type == Token::string && tokens[i + 3].isPunctuator("]")) {
+                key = tokens[i + 2].text;
+                next = i + 4;
+            } else {
+                return false;
+            }
+            if (prev && (prev->isPunctuator("++") || prev->isPunctuator("--"))) { return false; }
+            if (next < tokens.size() && tokens[next].type == Token::punctuator &&
+                contains(assignments, tokens[next].text)) {
+                return false;
+            }
+            if (std::find(_inputs.keys.begin(), _inputs.keys.end(), key) == _inputs.keys.end()) {
+                _inputs.keys.push_back(std::move(key));
+            }
+            i = next - 1;
+            continue;
+        }
+        if (name[0] == '$') {
+            auto keyword = stringToFilterKeyword(name);
+            if (keyword == FilterKeyword::undefined) { return false; }
+            _inputs.keywords |= 1u << uint8_t(keyword);
+            continue;
+        }
+        if (name == "function") {
+            parameters = true;
+            continue;
+        }
+        if (parameters || (prev && (prev->is(Token::identifier, "var") || prev->is(Token::identifier, "let") ||
+                                    prev->is(Token::identifier, "const") || prev->is(Token::identifier, "function")))) {
+            locals.push_back(name);
+            continue;
+        }
+        if (contains(pureNames, name)) { continue; }
+        if (std::find(locals.begin(), locals.end(), name) != locals.end()) { continue; }
+
+        // a global or an undeclared variable
+        return false;
+    }
+    return true;
+}
+
+}
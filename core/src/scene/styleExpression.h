@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class StyleContext;
+struct Feature;
+
+/* Native evaluation of scene JS functions of common forms
+ *
+ * A function like 'function() { return feature.height * 2 || 10; }' is compiled to a tree of
+ * nodes that is evaluated without the JS engine. Supported are number, string and boolean
+ * literals, feature properties (feature.key or feature['key']), the filter keywords ($zoom,
+ * $geometry, ...), the operators ! - + * / % < <= > >= == != === !== && || ?: with JS
+ * semantics, Math.min, max, floor, ceil, round, abs, sqrt and pow, and bodies of 'return'
+ * and 'if (...) ... else ...' statements. Functions using anything else, e.g. globals or
+ * variables, are not compiled and are left to the JS engine.
+ */
+class StyleExpression {
+
+public:
+
+    // Value of an expression: JS undefined, null, boolean, number or string
+    struct Result {
+        enum Type : uint8_t { undefined, null, boolean, number, string };
+
+        Type type = undefined;
+        bool booleanValue = false;
+        double numberValue = 0;
+        // the string value, a property or literal, or 'owned' for computed strings
+        const std::string* str = nullptr;
+        std::string owned;
+
+        Result() {}
+        Result(const Result&) = delete;
+        Result& operator=(const Result&) = delete;
+
+        void setUndefined() { type = undefined; }
+        void setNull() { type = null; }
+        void setBoolean(bool _value) { type = boolean; booleanValue = _value; }
+        void setNumber(double _value) { type = number; numberValue = _value; }
+        void setString(const std::string* _value) { type = string; str = _value; }
+        void setString(std::string&& _value) { type = string; owned = std::move(_value); str = &owned; }
+
+        bool toBoolean() const;
+        double toNumber() const;
+        std::string toString() const;
+    };
+
+    // Returns nullptr if @_source is not a function of a supported form
+    static std::unique_ptr<StyleExpression> compile(const std::string& _source);
+
+    void eval(const StyleContext& _ctx, const Feature* _feature, Result& _result) const;
+
+    // Number as converted to a string by JS, e.g. 1.5 or 1e-7
+    static std::string numberToString(double _number);
+
+    // Feature properties and keywords that a function reads
+    struct Inputs {
+        std::vector<std::string> keys;
+        uint32_t keywords = 0; // bit per FilterKeyword
+    };
+
+    /* Collects the Inputs of JS function @_source. Returns false when its result may depend
+     * on anything else, e.g. on scene globals, Math.random() or a property given by a variable.
+     * The check is lexical and conservative: any name that is not a local variable, feature,
+     * a keyword or a pure builtin rejects the function.
+     */
+    static bool scanInputs(const std::string& _source, Inputs& _inputs);
+
+private:
+
+    enum class Op : uint8_t {
+        literal,
+        property,
+        keyword,
+        negate,
+        logical_not,
+        add, subtract, multiply, divide, modulo,
+        less, less_equal, greater, greater_equal,
+        equal, not_equal, strict_equal, strict_not_equal,
+        logical_and, logical_or,
+        conditional,
+        math,
+        // statements
+        block,
+        if_else,
+        return_value,
+    };
+
+    enum class MathFn : uint8_t { min, max, floor, ceil, round, abs, sqrt, pow };
+
+    static constexpr uint32_t NONE = uint32_t(-1);
+
+    struct Node {
+        Node(Op _op, uint8_t _arg = 0) : op(_op), arg(_arg) {}
+
+        Op op;
+        uint8_t arg = 0;    // FilterKeyword, MathFn or literal Result::Type
+        uint32_t a = NONE;  // operands; the condition of conditional and if_else
+        uint32_t b = NONE;
+        uint32_t c = NONE;
+        double number = 0;
+        std::string str;    // literal string or property key
+        std::vector<uint32_t> nodes; // statements of a block, arguments of math
+    };
+
+    class Parser;
+
+    void evalNode(uint32_t _id, const StyleContext& _ctx, const Feature* _feature, Result& _result) const;
+
+    // Returns true when a return statement was executed
+    bool execNode(uint32_t _id, const StyleContext& _ctx, const Feature* _feature, Result& _result) const;
+
+    std::vector<Node> m_nodes;
+    uint32_t m_body = NONE;
+};
+
+}
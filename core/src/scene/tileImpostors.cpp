@@ -0,0 +1,284 @@
+#include "scene/tileImpostors.h"
+
+#include "gl/framebuffer.h"
+#include "gl/hardware.h"
+#include "gl/mesh.h"
+#include "gl/renderState.h"
+#include "gl/shaderProgram.h"
+#include "gl/texture.h"
+#include "marker/marker.h"
+#include "scene/featureStates.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "util/hash.h"
+#include "util/mapProjection.h"
+#include "view/view.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static const char* impostor_vs = R"RAW_GLSL(
+#ifdef GL_ES
+precision highp float;
+#endif
+
+uniform mat4 u_model_view_proj;
+
+attribute vec2 a_position;
+
+varying vec2 v_texcoord;
+
+void main() {
+    v_texcoord = a_position;
+    gl_Position = u_model_view_proj * vec4(a_position, 0.0, 1.0);
+}
+)RAW_GLSL";
+
+static const char* impostor_fs = R"RAW_GLSL(
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+uniform sampler2D u_texture;
+
+varying vec2 v_texcoord;
+
+void main() {
+    gl_FragColor = texture2D(u_texture, v_texcoord);
+}
+)RAW_GLSL";
+
+namespace Tangram {
+
+struct ImpostorVertex {
+    ImpostorVertex(float x, float y) : position(x, y) {}
+    glm::vec2 position;
+};
+
+TileImpostors::TileImpostors() {}
+
+TileImpostors::~TileImpostors() {}
+
+bool TileImpostors::bakes(const Style& _style) {
+    auto type = _style.type();
+    return type != StyleType::text && type != StyleType::point && !_style.isAnimated();
+}
+
+int TileImpostors::impostorSize(const Tile& _tile, const View& _view) {
+
+    if (_tile.isProxy() || !_tile.isUploaded()) { return 0; }
+
+    float area = _view.getTileScreenArea(_tile.getID());
+    if (area <= 0 || area >= FLT_MAX) { return 0; }
+
+    double flatSize = _view.pixelScale() * MapProjection::tileSize() * exp2(_view.getZoom() - _tile.getID().z);
+    if (area >= MAX_AREA_RATIO * flatSize * flatSize) { return 0; }
+
+    // Foreshortened tiles are wider than high: twice the mean side keeps texels about as large as pixels
+    double side = 2.0 * std::sqrt(area);
+    int size = MIN_SIZE;
+    while (size < side && size < MAX_SIZE) { size *= 2; }
+
+    // The tile must fill the texture at a valid zoom, see render()
+    double tileSize = MapProjection::tileSize() * _view.pixelScale();
+    if (_tile.getID().z + std::log2(size / tileSize) < 0) { return 0; }
+
+    return size;
+}
+
+size_t TileImpostors::signature(const Tile& _tile, const std::vector<std::unique_ptr<Style>>& _styles,
+                                const FeatureStates& _featureStates, float _pixelScale) {
+    size_t seed = 0;
+    for (const auto& style : _styles) {
+        if (bakes(*style)) { hash_combine(seed, static_cast<const void*>(_tile.getMesh(*style).get())); }
+    }
+    for (const auto& raster : _tile.rasters()) {
+        hash_combine(seed, static_cast<const void*>(raster.texture.get()));
+    }
+    hash_combine(seed, _featureStates.generation());
+    hash_combine(seed, _pixelScale);
+    return seed;
+}
+
+TileImpostors::Impostor* TileImpostors::find(const Tile& _tile) {
+    auto it = std::find_if(m_impostors.begin(), m_impostors.end(),
+                           [&](auto& impostor) { return impostor.tile.lock().get() == &_tile; });
+    return it != m_impostors.end() ? &*it : nullptr;
+}
+
+std::unique_ptr<FrameBuffer> TileImpostors::takeTarget(int _size) {
+    auto it = std::find_if(m_freeTargets.begin(), m_freeTargets.end(),
+                           [&](auto& target) { return target->getWidth() == _size; });
+    if (it == m_freeTargets.end()) {
+        return std::make_unique<FrameBuffer>(_size, _size, false, GL_RGBA8, true);
+    }
+    auto target = std::move(*it);
+    m_freeTargets.erase(it);
+    return target;
+}
+
+void TileImpostors::releaseTarget(std::unique_ptr<FrameBuffer> _target) {
+    // Keep a few for the next impostors
+    if (m_freeTargets.size() < MAX_RENDERS_PER_FRAME) { m_freeTargets.push_back(std::move(_target)); }
+}
+
+bool TileImpostors::update(RenderState& _rs, const View& _view,
+                           const std::vector<std::shared_ptr<Tile>>& _tiles,
+                           const std::vector<std::unique_ptr<Style>>& _styles,
+                           const FeatureStates& _featureStates, int64_t _frame) {
+
+    // Free the impostors of tiles that were not drawn in the last frame
+    for (auto it = m_impostors.begin(); it != m_impostors.end();) {
+        if (it->lastFrame < _frame - 1 || it->tile.expired()) {
+            releaseTarget(std::move(it->target));
+            it = m_impostors.erase(it);
+        } else {
+            it->drawn = false;
+            ++it;
+        }
+    }
+
+    m_frame = _frame;
+    m_drawn = 0;
+    m_remainingTiles.clear();
+
+    size_t renders = 0;
+    bool pending = false;
+
+    for (const auto& tile : _tiles) {
+        int size = impostorSize(*tile, _view);
+        Impostor* impostor = size > 0 ? find(*tile) : nullptr;
+
+        if (size > 0 && !impostor && m_impostors.size() < MAX_IMPOSTORS) {
+            m_impostors.push_back({ tile, takeTarget(size) });
+            impostor = &m_impostors.back();
+        }
+        if (!impostor) {
+            m_remainingTiles.push_back(tile);
+            continue;
+        }
+        impostor->lastFrame = _frame;
+
+        size_t sig = signature(*tile, _styles, _featureStates, _view.pixelScale());
+        if (!impostor->ready || impostor->signature != sig || impostor->target->getWidth() < size) {
+            // Outdated impostors are not drawn until they are rendered again
+            impostor->ready = false;
+            if (renders == MAX_RENDERS_PER_FRAME) {
+                pending = true;
+                m_remainingTiles.push_back(tile);
+                continue;
+            }
+            if (impostor->target->getWidth() < size) {
+                releaseTarget(std::move(impostor->target));
+                impostor->target = takeTarget(size);
+            }
+            renders++;
+            impostor->ready = render(_rs, _view, *impostor, tile, _styles);
+            impostor->signature = sig;
+        }
+
+        if (impostor->ready) {
+            impostor->drawn = true;
+            m_drawn++;
+        } else {
+            m_remainingTiles.push_back(tile);
+        }
+    }
+
+    return pending;
+}
+
+bool TileImpostors::render(RenderState& _rs, const View& _view, Impostor& _impostor,
+                           const std::shared_ptr<Tile>& _tile,
+                           const std::vector<std::unique_ptr<Style>>& _styles) {
+
+    auto& tile = *_tile;
+    int size = _impostor.target->getWidth();
+    float zoom = tile.getID().z + std::log2(size / (MapProjection::tileSize() * _view.pixelScale()));
+
+    // Top-down view in which the tile fills the texture
+    View view(size, size);
+    view.setConstrainToWorldBounds(false);
+    view.setPixelScale(_view.pixelScale());
+    view.setCameraType(CameraType::flat);
+    view.setZoom(zoom);
+    view.setPosition(tile.getOrigin() + glm::dvec2(tile.getScale() * 0.5));
+    view.update();
+
+    if (!_impostor.target->applyAsRenderTarget(_rs)) { return false; }
+
+    // Areas without meshes show what is drawn below the impostor
+    if (_rs.defaultOpaqueClearColor()) {
+        _rs.clearColor(0.f, 0.f, 0.f, 0.f);
+        GL::clear(GL_COLOR_BUFFER_BIT);
+    }
+
+    if (Hardware::supportsUniformBuffers) {
+        FrameUniforms frame;
+        frame.setView(view);
+        frame.time = _rs.frameTime();
+        frame.devicePixelRatio = _view.pixelScale();
+        _rs.frameUniforms.update(frame);
+    }
+
+    static const std::vector<std::unique_ptr<Marker>> noMarkers;
+    m_renderTiles.assign(1, _tile);
+
+    // The model matrix of the tile is relative to the position of the view
+    tile.update(view, 0);
+
+    m_renderQueue.clear();
+    for (size_t i = 0; i < _styles.size(); i++) {
+        if (bakes(*_styles[i])) { m_renderQueue.push(*_styles[i], i, view, m_renderTiles, noMarkers); }
+    }
+    m_renderQueue.sort();
+    m_renderQueue.submit(_rs, view, noMarkers);
+
+    tile.update(_view, 0);
+    m_renderTiles.clear();
+
+    return true;
+}
+
+void TileImpostors::buildProgram() {
+
+    m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"a_position", 2, GL_FLOAT, false, 0},
+    }));
+
+    m_shaderProgram = std::make_unique<ShaderProgram>(impostor_vs, impostor_fs, m_vertexLayout.get());
+    m_shaderProgram->setDescription("TileImpostors");
+
+    // Tile coordinates of the quad, with y to the north as in the texture
+    MeshData<ImpostorVertex> meshData({ 0, 1, 2, 3 }, {{0, 0}, {1, 0}, {0, 1}, {1, 1}});
+    auto mesh = std::make_unique<Mesh<ImpostorVertex>>(m_vertexLayout, GL_TRIANGLE_STRIP);
+    mesh->compile(meshData);
+    m_mesh = std::move(mesh);
+}
+
+void TileImpostors::draw(RenderState& _rs) {
+
+    if (m_drawn == 0) { return; }
+
+    if (!m_shaderProgram) { buildProgram(); }
+
+    // Colors were blended into the transparent texture, i.e. are premultiplied by alpha
+    _rs.blending(GL_TRUE);
+    _rs.blendingFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    _rs.depthTest(GL_TRUE);
+    _rs.depthMask(GL_FALSE);
+
+    m_shaderProgram->setUniformi(_rs, m_uniforms.uTexture, 0);
+
+    for (auto& impostor : m_impostors) {
+        if (!impostor.drawn) { continue; }
+        auto tile = impostor.tile.lock();
+        if (!tile || !impostor.target->getTexture()->bind(_rs, 0)) { continue; }
+
+        m_shaderProgram->setUniformMatrix4f(_rs, m_uniforms.uModelViewProj, tile->mvp());
+        m_mesh->draw(_rs, *m_shaderProgram);
+    }
+}
+
+}
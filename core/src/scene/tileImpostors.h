@@ -0,0 +1,130 @@
+#pragma once
+
+#include "gl/uniform.h"
+#include "scene/renderQueue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+class FeatureStates;
+class FrameBuffer;
+class RenderState;
+class ShaderProgram;
+class Style;
+class Tile;
+class VertexLayout;
+class View;
+struct StyledMesh;
+
+/* TileImpostors - Draw distant tiles of tilted views as textured quads
+ *
+ * Tiles near the horizon of a tilted view cover few pixels but still cost a draw call per style.
+ * Tiles whose screen area is a small part of their area in an untilted view are rendered once from
+ * above into a texture of about their size on screen, the impostor of the tile, which is drawn as
+ * one quad on the ground instead of their meshes until the meshes, rasters or feature states of the
+ * tile change.
+ *
+ * Only the styles which are neither labels nor animated are rendered into impostors, see bakes();
+ * labels are placed and drawn with the other labels, animated styles with the other tiles.
+ * Extrusions are seen from above in impostors. Proxy tiles, whose meshes are partly hidden, keep
+ * being drawn by their styles.
+ */
+class TileImpostors {
+
+public:
+
+    TileImpostors();
+    ~TileImpostors();
+
+    /* Select the impostors for @_tiles in @_view and render those that are missing or outdated into
+     * their textures, binding other framebuffers; returns whether impostors are left to render in
+     * the next frames */
+    bool update(RenderState& _rs, const View& _view, const std::vector<std::shared_ptr<Tile>>& _tiles,
+                const std::vector<std::unique_ptr<Style>>& _styles, const FeatureStates& _featureStates,
+                int64_t _frame);
+
+    /* Whether the tiles of @_style are rendered into impostors */
+    static bool bakes(const Style& _style);
+
+    /* Tiles of the last update() that are not drawn as impostors, for the styles that bakes() */
+    const std::vector<std::shared_ptr<Tile>>& remainingTiles() const { return m_remainingTiles; }
+
+    /* Number of tiles drawn as impostors */
+    size_t count() const { return m_drawn; }
+
+    /* Frame of the last update() */
+    int64_t frame() const { return m_frame; }
+
+    /* Draw the impostors of the last update() into the bound framebuffer */
+    void draw(RenderState& _rs);
+
+    /* Impostors are rendered for tiles whose screen area is less than this part of their area in an
+     * untilted view at the view zoom */
+    static constexpr float MAX_AREA_RATIO = 0.25f;
+
+    /* Most impostors kept at once and rendered in one frame */
+    static constexpr size_t MAX_IMPOSTORS = 48;
+    static constexpr size_t MAX_RENDERS_PER_FRAME = 4;
+
+    /* Sizes of impostor textures in pixels */
+    static constexpr int MIN_SIZE = 64;
+    static constexpr int MAX_SIZE = 256;
+
+private:
+
+    struct Impostor {
+        std::weak_ptr<Tile> tile;
+        std::unique_ptr<FrameBuffer> target;
+        // of the meshes, rasters and feature states the texture was rendered with
+        size_t signature = 0;
+        int64_t lastFrame = 0;
+        bool ready = false;
+        // drawn in the frame of the last update()
+        bool drawn = false;
+    };
+
+    // Size of the texture for @_tile in @_view, 0 unless it is drawn as impostor
+    static int impostorSize(const Tile& _tile, const View& _view);
+
+    static size_t signature(const Tile& _tile, const std::vector<std::unique_ptr<Style>>& _styles,
+                            const FeatureStates& _featureStates, float _pixelScale);
+
+    Impostor* find(const Tile& _tile);
+
+    // A free framebuffer of @_size or a new one
+    std::unique_ptr<FrameBuffer> takeTarget(int _size);
+    void releaseTarget(std::unique_ptr<FrameBuffer> _target);
+
+    bool render(RenderState& _rs, const View& _view, Impostor& _impostor,
+                const std::shared_ptr<Tile>& _tile,
+                const std::vector<std::unique_ptr<Style>>& _styles);
+
+    void buildProgram();
+
+    std::vector<Impostor> m_impostors;
+    // Framebuffers of impostors that are no longer used
+    std::vector<std::unique_ptr<FrameBuffer>> m_freeTargets;
+
+    std::vector<std::shared_ptr<Tile>> m_remainingTiles;
+    // The tile rendered by render()
+    std::vector<std::shared_ptr<Tile>> m_renderTiles;
+    size_t m_drawn = 0;
+    int64_t m_frame = -1;
+
+    RenderQueue m_renderQueue;
+
+    std::unique_ptr<ShaderProgram> m_shaderProgram;
+    std::shared_ptr<VertexLayout> m_vertexLayout;
+    std::unique_ptr<StyledMesh> m_mesh;
+
+    struct UniformBlock {
+        UniformLocation uModelViewProj{"u_model_view_proj"};
+        UniformLocation uTexture{"u_texture"};
+    } m_uniforms;
+};
+
+}
@@ -0,0 +1,119 @@
+#include "selection/pickIndex.h"
+
+#include "data/tileData.h"
+#include "util/geom.h"
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+
+namespace Tangram {
+
+bool PickIndex::Hit::isAbove(const Hit& _other) const {
+    if (area != _other.area) { return !area; }
+    if (area) { return order > _other.order; }
+    return distance < _other.distance;
+}
+
+void PickIndex::add(const Feature& _feature, uint32_t _selectionColor, uint32_t _order) {
+    if (_feature.coordinates.empty()) { return; }
+
+    Item item;
+    item.selectionColor = _selectionColor;
+    item.order = _order;
+    item.kind = _feature.geometryType == GeometryType::points ? Kind::points :
+                _feature.geometryType == GeometryType::lines ? Kind::lines : Kind::polygons;
+    item.min = item.max = _feature.coordinates[0];
+
+    uint32_t offset = uint32_t(m_points.size());
+    for (auto& p : _feature.coordinates) {
+        m_points.push_back(p);
+        item.min = glm::min(item.min, p);
+        item.max = glm::max(item.max, p);
+    }
+
+    if (item.kind == Kind::points) {
+        item.begin = offset;
+        item.end = uint32_t(m_points.size());
+    } else {
+        item.begin = uint32_t(m_lineEnds.size());
+        for (uint32_t end : _feature.ringEnds) { m_lineEnds.push_back(offset + end); }
+        item.end = uint32_t(m_lineEnds.size());
+    }
+
+    m_items.push_back(item);
+}
+
+void PickIndex::merge(const PickIndex& _other) {
+    uint32_t points = uint32_t(m_points.size());
+    uint32_t lineEnds = uint32_t(m_lineEnds.size());
+
+    m_points.insert(m_points.end(), _other.m_points.begin(), _other.m_points.end());
+    for (uint32_t end : _other.m_lineEnds) { m_lineEnds.push_back(points + end); }
+
+    for (auto item : _other.m_items) {
+        uint32_t shift = item.kind == Kind::points ? points : lineEnds;
+        item.begin += shift;
+        item.end += shift;
+        m_items.push_back(item);
+    }
+}
+
+bool PickIndex::pick(glm::vec2 _position, float _radius, Hit& _hit) const {
+    bool found = false;
+
+    for (auto& item : m_items) {
+        if (_position.x < item.min.x - _radius || _position.x > item.max.x + _radius ||
+            _position.y < item.min.y - _radius || _position.y > item.max.y + _radius) {
+            continue;
+        }
+
+        Hit hit;
+        hit.selectionColor = item.selectionColor;
+        hit.order = item.order;
+        hit.distance = _radius;
+
+        if (item.kind == Kind::points) {
+            for (uint32_t i = item.begin; i < item.end; i++) {
+                hit.distance = std::min(hit.distance, glm::distance(_position, m_points[i]));
+            }
+        } else {
+            // Rings contain the position for an odd number of crossings
+            bool inside = false;
+            uint32_t start = item.begin > 0 ? m_lineEnds[item.begin - 1] : 0;
+            for (uint32_t line = item.begin; line < item.end; line++) {
+                uint32_t end = m_lineEnds[line];
+                for (uint32_t i = start; i + 1 < end; i++) {
+                    const glm::vec2& a = m_points[i];
+                    const glm::vec2& b = m_points[i + 1];
+                    hit.distance = std::min(hit.distance, pointSegmentDistance(_position, a, b));
+                    if ((a.y > _position.y) != (b.y > _position.y) &&
+                        _position.x < a.x + (b.x - a.x) * (_position.y - a.y) / (b.y - a.y)) {
+                        inside = !inside;
+                    }
+                }
+                start = end;
+            }
+            if (inside && item.kind == Kind::polygons) {
+                hit.distance = 0.f;
+                hit.area = true;
+            }
+        }
+
+        if (!hit.area && hit.distance >= _radius) { continue; }
+
+        // Later features of the same order are drawn above
+        if (!found || !_hit.isAbove(hit)) {
+            _hit = hit;
+            found = true;
+        }
+    }
+    return found;
+}
+
+size_t PickIndex::memoryUsage() const {
+    return m_items.capacity() * sizeof(Item) + m_points.capacity() * sizeof(glm::vec2) +
+           m_lineEnds.capacity() * sizeof(uint32_t);
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "glm/vec2.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+struct Feature;
+
+/*
+ * PickIndex - Geometry of the interactive features of a tile, to pick them without rendering
+ * the selection buffer
+ *
+ * Built with the tile on its worker when SceneOptions::cpuPicking is set: points, lines and
+ * polygon rings in tile units, tagged with the selection color of their feature and the
+ * highest order of its draw rules. Points and lines are hit within a radius of their
+ * geometry, polygons when they contain the position.
+ */
+class PickIndex {
+
+public:
+
+    struct Hit {
+        uint32_t selectionColor = 0;
+        // Distance to the geometry in tile units, 0 inside polygons
+        float distance = 0.f;
+        uint32_t order = 0;
+        bool area = false;
+
+        // Whether this hit is picked over @_other: points and lines before polygons, the nearer
+        // one first, and polygons of higher order before those below them
+        bool isAbove(const Hit& _other) const;
+    };
+
+    // Add the geometry of @_feature for @_selectionColor
+    void add(const Feature& _feature, uint32_t _selectionColor, uint32_t _order);
+
+    // Add the geometry of @_other, e.g. of styles which were not rebuilt
+    void merge(const PickIndex& _other);
+
+    // Topmost feature within @_radius of @_position, in tile units; returns false if there is none
+    bool pick(glm::vec2 _position, float _radius, Hit& _hit) const;
+
+    bool empty() const { return m_items.empty(); }
+
+    size_t memoryUsage() const;
+
+private:
+
+    enum class Kind : uint8_t { points, lines, polygons };
+
+    struct Item {
+        uint32_t selectionColor;
+        uint32_t order;
+        Kind kind;
+        // Range of m_lineEnds of the lines or rings; for points the range of m_points
+        uint32_t begin, end;
+        glm::vec2 min, max;
+    };
+
+    std::vector<Item> m_items;
+    std::vector<glm::vec2> m_points;
+    // End of each line or ring in m_points
+    std::vector<uint32_t> m_lineEnds;
+
+};
+
+}
@@ -8,6 +8,7 @@
 #include "tile/tileManager.h"
 #include "view/view.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace Tangram {
@@ -20,13 +21,32 @@ QueryType SelectionQuery::type() const {
           (m_queryCallback.is<LabelPickCallback>() ? QueryType::label : QueryType::marker);
 }
 
-void SelectionQuery::process(const View& _view, const FrameBuffer& _framebuffer, const MarkerManager& _markerManager,
-                             const TileManager& _tileManager, const LabelManager& _labels, std::vector<SelectionColorRead>& _colorCache) const {
+FrameBuffer::PixelRect SelectionQuery::rect(const View& _view, const FrameBuffer& _framebuffer) const {
 
     float radius = m_radius * _view.pixelScale();
     glm::vec2 windowCoordinates = _view.normalizedWindowCoordinates(m_position.x - radius, m_position.y + radius);
     glm::vec2 windowSize = _view.normalizedWindowCoordinates(m_position.x + radius, m_position.y - radius) - windowCoordinates;
 
+    return _framebuffer.pixelRect(windowCoordinates.x, windowCoordinates.y, windowSize.x, windowSize.y);
+}
+
+FrameBuffer::PixelRect SelectionQuery::unite(const FrameBuffer::PixelRect& _a, const FrameBuffer::PixelRect& _b) {
+
+    if (_a.width <= 0 || _a.height <= 0) { return _b; }
+    if (_b.width <= 0 || _b.height <= 0) { return _a; }
+
+    FrameBuffer::PixelRect rect;
+    rect.left = std::min(_a.left, _b.left);
+    rect.bottom = std::min(_a.bottom, _b.bottom);
+    rect.width = std::max(_a.left + _a.width, _b.left + _b.width) - rect.left;
+    rect.height = std::max(_a.bottom + _a.height, _b.bottom + _b.height) - rect.bottom;
+    return rect;
+}
+
+void SelectionQuery::process(const View& _view, const FrameBuffer& _framebuffer, const FrameBuffer::PixelRect& _pixels,
+                             const MarkerManager& _markerManager, const TileManager& _tileManager,
+                             const LabelManager& _labels, std::vector<SelectionColorRead>& _colorCache) const {
+
     GLuint color = 0;
 
     auto it = std::find_if(_colorCache.begin(), _colorCache.end(), [=](const auto& _colorRead) {
@@ -35,12 +55,19 @@ void SelectionQuery::process(const View& _view, const FrameBuffer& _framebuffer,
 
     if (it == _colorCache.end()) {
         // Find the first non-zero color nearest to the position and within the selection radius.
-        auto rect = _framebuffer.readRect(windowCoordinates.x, windowCoordinates.y, windowSize.x, windowSize.y);
+        auto rect = this->rect(_view, _framebuffer);
+        // The pixels of the query, when the framebuffer was not resized since they were read
+        bool inside = rect.left >= _pixels.left && rect.bottom >= _pixels.bottom &&
+            rect.left + rect.width <= _pixels.left + _pixels.width &&
+            rect.bottom + rect.height <= _pixels.bottom + _pixels.height;
+        if (!inside) { rect.width = rect.height = 0; }
+
         float minDistance = std::fmin(rect.width, rect.height);
         float hw = static_cast<float>(rect.width) / 2.f, hh = static_cast<float>(rect.height) / 2.f;
         for (int32_t row = 0; row < rect.height; row++) {
             for (int32_t col = 0; col < rect.width; col++) {
-                uint32_t sample = rect.pixels[row * rect.width + col];
+                uint32_t sample = _pixels.pixels[(rect.bottom - _pixels.bottom + row) * _pixels.width +
+                                                 (rect.left - _pixels.left + col)];
                 float distance = std::hypot(row - hw, col - hh);
                 if (sample != 0 && distance < minDistance) {
                     color = sample;
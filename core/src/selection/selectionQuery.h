@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gl/framebuffer.h"
 #include "glm/vec2.hpp"
 #include "map.h"
 #include "util/variant.h"
@@ -7,7 +8,6 @@
 namespace Tangram {
 
 class MarkerManager;
-class FrameBuffer;
 class TileManager;
 class LabelManager;
 class View;
@@ -31,9 +31,17 @@ class SelectionQuery {
 public:
     SelectionQuery(glm::vec2 _position, float _radius, QueryCallback _queryCallback);
 
-    void process(const View& _view, const FrameBuffer& _framebuffer, const MarkerManager& _markerManager,
-                 const TileManager& _tileManager, const LabelManager& _labelManager,
-                 std::vector<SelectionColorRead>& _cache) const;
+    // Rect of @_framebuffer covered by the query
+    FrameBuffer::PixelRect rect(const View& _view, const FrameBuffer& _framebuffer) const;
+
+    // Resolve the query with @_pixels, which were read from a rect of the selection
+    // buffer containing rect() of the query, and call its callback
+    void process(const View& _view, const FrameBuffer& _framebuffer, const FrameBuffer::PixelRect& _pixels,
+                 const MarkerManager& _markerManager, const TileManager& _tileManager,
+                 const LabelManager& _labelManager, std::vector<SelectionColorRead>& _cache) const;
+
+    // Smallest rect containing @_a and @_b; empty rects are ignored
+    static FrameBuffer::PixelRect unite(const FrameBuffer::PixelRect& _a, const FrameBuffer::PixelRect& _b);
 
     QueryType type() const;
 
@@ -45,64 +45,34 @@ void ContourTextStyleBuilder::setup(const Tile& _tile) {
     TextStyleBuilder::setup(_tile);
 }
 
-static float getContourLine(Texture& tex, TileID& tileId, glm::vec2 pos, float elevStep, Line& line) {
+// Pieces of @_line of @_length, every @_spacing along it and centered on it
+static void linePieces(const std::vector<Point>& _line, float _length, float _spacing, std::vector<Line>& _pieces) {
 
-    const float tileSize = 256.0f * std::exp2(tileId.s - tileId.z);
-    const float maxPosErr = 0.25f/tileSize;
-    const float labelLen = 32/tileSize;
-    const float stepSize = 2/tileSize;
-    const size_t numLinePts = int(1.25f*labelLen/stepSize);
+    _pieces.clear();
+    if (_line.size() < 2) { return; }
 
-    float level = NAN;
-    while (1) {
-        float step, prevElev = 0, lowerElev = NAN, upperElev = NAN;
-        glm::vec2 grad, prevPos, lowerPos, upperPos;
-        int niter = 0;
-        do {
-            float elev = ElevationManager::elevationLerp(tex, pos, &grad);
-            if (std::isnan(level)) {
-                level = std::round(elev/elevStep)*elevStep;
-                if (level <= 0) { return NAN; }
-            }
-
-            if (elev < level && !(elev < lowerElev)) {  // use false compare to handle NAN
-                lowerElev = elev;
-                lowerPos = pos;
-            } else if (elev > level && !(elev > upperElev)) {
-                upperElev = elev;
-                upperPos = pos;
-            }
-
-            // handle zero gradient case ... I think this could be fairly common so don't just abort
-            if (grad.x == 0 && grad.y == 0) {
-                if (niter == 0 || prevElev == elev || pos == prevPos) { return NAN; }
-                float dr = glm::length(pos - prevPos);
-                grad = (pos - prevPos)*(elev - prevElev)/(dr*dr);
-            }
-            prevElev = elev;
-            prevPos = pos;
-
-            float gradlen = glm::length(grad);
-            step = std::abs(level - elev)/gradlen;
-            if (level < elev) { gradlen = -gradlen; }
-
-            if (std::isnan(lowerElev) || std::isnan(upperElev)) {
-                float toedge = std::min({pos.x, pos.y, 1 - pos.x, 1 - pos.y});  // distance to nearest edge
-                pos += std::min(step, std::max(0.025f, toedge))*(grad/gradlen);  // limit step size
-            } else {
-                pos = (upperPos*(level - lowerElev) + lowerPos*(upperElev - level))/(upperElev - lowerElev);
-            }
-
-            // abort if outside tile or too many iterations; exit on false compare to handle NAN in pos
-            if(++niter > 12 || !(pos.x >= 0 && pos.y >= 0 && pos.x <= 1 && pos.y <= 1)) { return NAN; }
-
-        } while (step > maxPosErr);
-
-        line.push_back(pos);
-        if(line.size() >= numLinePts) { return level; }
-        glm::vec2 tangent = glm::normalize(glm::vec2(grad.y, -grad.x));
-        //if(glm::dot(tangent, prevTangent ... check for excess angle
-        pos = glm::clamp(pos + tangent*stepSize, glm::vec2(0.f), glm::vec2(1.f));
+    std::vector<float> dist(_line.size(), 0.f);
+    for (size_t i = 1; i < _line.size(); i++) {
+        dist[i] = dist[i-1] + glm::distance(_line[i-1], _line[i]);
+    }
+    float total = dist.back();
+    if (total < _length) { return; }
+
+    size_t seg = 0;
+    for (float start = std::fmod(0.5f*(total - _length), _spacing); start + _length <= total; start += _spacing) {
+        float end = start + _length;
+        while (dist[seg+1] < start) { seg++; }
+
+        Line piece;
+        auto pointAt = [&](size_t i, float d) {
+            float len = dist[i+1] - dist[i];
+            return len > 0 ? glm::mix(_line[i], _line[i+1], (d - dist[i])/len) : _line[i];
+        };
+        piece.push_back(pointAt(seg, start));
+        size_t i = seg + 1;
+        for (; i < _line.size() - 1 && dist[i] < end; i++) { piece.push_back(_line[i]); }
+        piece.push_back(pointAt(i - 1, end));
+        _pieces.push_back(std::move(piece));
     }
 }
 
@@ -129,33 +99,34 @@ bool ContourTextStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _
     // Keep start position of new quads
     size_t quadsStart = m_quads.size(), numLabels = m_labels.size();
 
-    // idea here is to align grid points between zoom levels to keep labels in same position
-    //  when zooming ... mostly defeated unfortunately by curved label placement, repeat distance
+    auto contours = ElevationManager::contourLines(*m_texture, elevStep);
+    if (!contours) { return false; }
+
+    // about as many label candidates as one per cell of a grid of gridSize per tile at zoom 15, each on a
+    //  piece of the contour line a bit longer than the label
     int gridmult = std::max(0, std::min(int(m_tileId.s), 15) - m_tileId.z);
-    int ngrid = gridSize << gridmult;
-    float gridstart = 0.5f/(1 << std::max(0, 15 - m_tileId.z));
-    glm::vec2 pos;
-    for (int col = 0; col < ngrid; col++) {
-        pos.y = (col + gridstart)/ngrid;
-        for (int row = 0; row < ngrid; row++) {
-            pos.x = (row + gridstart)/ngrid;
-
-            Line line;
-            float level = getContourLine(*m_texture, m_tileId, pos, elevStep, line);
-            if (std::isnan(level)) { continue; }
-
-            LabelAttributes attrib;
+    float spacing = 1.f/(gridSize << gridmult);
+
+    LabelAttributes attrib;
+    float level = NAN;
+    std::vector<Line> pieces;
+    for (auto& contour : *contours) {
+        // lines are ordered by level, so the text is shaped once per level
+        if (contour.level != level) {
+            level = contour.level;
             params.text = std::to_string(int(metricUnits ? level : std::round(level*3.28084f))) + suffix;
             // make sure different levels are in different repeat groups (which is the behavior in the normal
             //  case where applyRule() is called for every label)
             params.labelOptions.repeatGroup = repeatGroupHash;
             hash_combine(params.labelOptions.repeatGroup, params.text);
 
+            attrib = LabelAttributes();
             if (!prepareLabel(params, Label::Type::line, attrib)) { return false; }
+        }
 
-            //size_t prevlabels = m_labels.size();
-            addCurvedTextLabels(line, params, attrib, _rule);
-            //LOGD("Placed %d contour label(s) for %s", int(m_labels.size() - prevlabels), m_tileId.toString().c_str());
+        linePieces(contour.points, 1.25f*attrib.width/m_tileSize, spacing, pieces);
+        for (auto& piece : pieces) {
+            addCurvedTextLabels(piece, params, attrib, _rule);
         }
     }
 
@@ -217,31 +188,19 @@ bool ContourDebugStyleBuilder::addFeature(const Feature& _feat, const DrawRule&
     float elevStep = m_style.m_metricUnits ? (m_tileId.z >= 14 ? 100 : m_tileId.z >= 12 ? 200 : 500)
             : (m_tileId.z >= 14 ? 500 : m_tileId.z >= 12 ? 1000 : 2000)/3.28084f;
 
-    //int ngrid = ContourTextStyleBuilder::gridSize + (m_tileId.s - m_tileId.z);
-    int gridmult = std::max(0, std::min(int(m_tileId.s), 15) - m_tileId.z);
-    int ngrid = (ContourTextStyleBuilder::gridSize << gridmult);
-    float gridstart = 0.5f/(1 << std::max(0, 15 - m_tileId.z));
-    glm::vec2 pos;
-    for (int col = 0; col < ngrid; col++) {
-        pos.y = (col + gridstart)/ngrid;
-        for (int row = 0; row < ngrid; row++) {
-            pos.x = (row + gridstart)/ngrid;
-
-            Line line;
-            float level = getContourLine(*m_texture, m_tileId, pos, elevStep, line);
-            if(line.empty()) { continue; }
-
-            GLuint abgr = std::isnan(level) ? 0xFF00FF00 : 0xFF0000FF;
-            for (size_t ii = 0; ii < line.size(); ++ii) {
-                auto& pt = line[ii];
-                float elev = m_style.m_terrain3d ? ElevationManager::elevationLerp(*m_texture, pt)/m_tileScale : 0;
-                m_meshData.vertices.push_back({glm::vec3(pt, elev), abgr});
-                if (ii == 0) continue;
-                m_meshData.indices.push_back(ii-1);
-                m_meshData.indices.push_back(ii);
-            }
-            m_meshData.offsets.emplace_back(2*line.size()-2, line.size());
+    auto contours = ElevationManager::contourLines(*m_texture, elevStep);
+    if (!contours) { return false; }
+
+    for (auto& contour : *contours) {
+        auto& line = contour.points;
+        float z = m_style.m_terrain3d ? contour.level/m_tileScale : 0.f;
+        for (size_t ii = 0; ii < line.size(); ++ii) {
+            m_meshData.vertices.push_back({glm::vec3(line[ii], z), 0xFF0000FF});
+            if (ii == 0) continue;
+            m_meshData.indices.push_back(ii-1);
+            m_meshData.indices.push_back(ii);
         }
+        m_meshData.offsets.emplace_back(2*line.size()-2, line.size());
     }
     return true;
 }
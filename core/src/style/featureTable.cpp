@@ -0,0 +1,146 @@
+#include "style/featureTable.h"
+
+#include "gl/texture.h"
+#include "scene/featureStates.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+static uint32_t packState(const FeatureState& _state) {
+    uint32_t visible = _state.visible ? 0xff : 0;
+    uint32_t width = uint32_t(std::round(_state.widthScale * 64.f));
+    return visible | (std::min(width, 255u) << 8);
+}
+
+// Visible, with a line width scale of 1
+static const uint32_t defaultState = packState(FeatureState{});
+
+FeatureTable::FeatureTable() {}
+
+FeatureTable::~FeatureTable() {}
+
+uint32_t FeatureTable::add(uint32_t _color, uint32_t _selectionColor, const std::string& _featureId) {
+
+    std::vector<uint32_t>* featureEntries = nullptr;
+    uint64_t key = (uint64_t(_selectionColor) << 32) | _color;
+
+    if (_featureId.empty()) {
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) { return it->second; }
+    } else {
+        featureEntries = &m_features[_featureId];
+        for (uint32_t index : *featureEntries) {
+            if (m_colors[index] == _color && m_selectionColors[index] == _selectionColor) {
+                return index;
+            }
+        }
+    }
+
+    if (m_colors.size() == WIDTH * MAX_ROWS) { return uint32_t(m_colors.size() - 1); }
+
+    uint32_t index = uint32_t(m_colors.size());
+    m_colors.push_back(_color);
+    m_selectionColors.push_back(_selectionColor);
+    m_states.push_back(defaultState);
+    m_stateColors.push_back(0);
+
+    if (featureEntries) {
+        featureEntries->push_back(index);
+        // Apply the states on the next sync
+        m_statesGeneration = 0;
+    } else {
+        m_entries.emplace(key, index);
+    }
+    m_dirty = true;
+
+    return index;
+}
+
+bool FeatureTable::setColor(uint32_t _selectionColor, uint32_t _color) {
+    if (_selectionColor == 0) { return false; }
+
+    bool found = false;
+    for (size_t i = 0; i < m_colors.size(); i++) {
+        if (m_selectionColors[i] == _selectionColor) {
+            m_colors[i] = _color;
+            found = true;
+        }
+    }
+    m_dirty |= found;
+    return found;
+}
+
+bool FeatureTable::selectable() const {
+    return std::any_of(m_selectionColors.begin(), m_selectionColors.end(),
+                       [](uint32_t color) { return color != 0; });
+}
+
+bool FeatureTable::syncStates(const FeatureStates& _states, int32_t _sourceId) {
+
+    uint32_t generation = _states.generation();
+    if (m_features.empty() || generation == m_statesGeneration) { return false; }
+    m_statesGeneration = generation;
+
+    bool changed = false;
+    for (const auto& feature : m_features) {
+        auto state = _states.get(_sourceId, feature.first);
+        uint32_t packed = packState(state);
+
+        for (uint32_t index : feature.second) {
+            if (m_states[index] == packed && m_stateColors[index] == state.color) { continue; }
+            m_states[index] = packed;
+            m_stateColors[index] = state.color;
+            changed = true;
+        }
+    }
+    m_dirty |= changed;
+    return changed;
+}
+
+glm::vec3 FeatureTable::textureSize() const {
+    uint32_t width = std::min(std::max(uint32_t(m_colors.size()), 1u), WIDTH);
+    uint32_t rows = (uint32_t(m_colors.size()) + WIDTH - 1) / WIDTH;
+    rows = std::max(rows, 1u);
+    return { float(width), float(rows), float(3 * rows) };
+}
+
+size_t FeatureTable::bufferSize() const {
+    auto size = textureSize();
+    return size_t(size.x * size.z) * sizeof(uint32_t);
+}
+
+bool FeatureTable::bind(RenderState& rs, GLuint _unit) {
+
+    if (m_dirty) {
+        m_dirty = false;
+
+        auto size = textureSize();
+        uint32_t width = uint32_t(size.x);
+        uint32_t rows = uint32_t(size.y);
+
+        // Colors, selection colors and states; the state texel holds the visibility in red
+        // and the line width scale times 64 in green
+        std::vector<uint32_t> pixels(width * rows * 3, 0);
+        for (size_t i = 0; i < m_colors.size(); i++) {
+            pixels[i] = m_stateColors[i] ? m_stateColors[i] : m_colors[i];
+        }
+        std::copy(m_selectionColors.begin(), m_selectionColors.end(), pixels.begin() + width * rows);
+        std::copy(m_states.begin(), m_states.end(), pixels.begin() + 2 * width * rows);
+
+        if (!m_texture) {
+            TextureOptions options;
+            options.minFilter = TextureMinFilter::NEAREST;
+            options.magFilter = TextureMagFilter::NEAREST;
+            m_texture = std::make_unique<Texture>(options);
+        }
+        m_texture->setPixelData(width, rows * 3, sizeof(uint32_t),
+                                reinterpret_cast<GLubyte*>(pixels.data()),
+                                pixels.size() * sizeof(uint32_t));
+    }
+
+    return m_texture->bind(rs, _unit);
+}
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "gl.h"
+#include "style/style.h"
+
+#include "glm/vec3.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+class FeatureStates;
+class RenderState;
+class Texture;
+
+/*
+ * FeatureTable - Colors and selection colors of the features of a mesh, which the vertex
+ * shader reads from a texture at the index stored in the vertices of each feature
+ *
+ * Features with the same colors share an entry, unless they have a feature id. Entries can be
+ * changed after the mesh was built, e.g. to highlight a feature, without building the mesh
+ * again; the texture is uploaded again on the next draw. The texture has WIDTH entries per
+ * row, the rows of colors followed by as many rows of selection colors and of FeatureState
+ * texels (visibility, line width scale).
+ */
+class FeatureTable {
+
+public:
+
+    static constexpr uint32_t WIDTH = 256;
+    // Entries beyond MAX_ROWS rows share the last entry
+    static constexpr uint32_t MAX_ROWS = 1024;
+
+    FeatureTable();
+    ~FeatureTable();
+
+    /* Index of the entry with @_color and @_selectionColor of feature @_featureId, added
+     * unless it exists */
+    uint32_t add(uint32_t _color, uint32_t _selectionColor, const std::string& _featureId = "");
+
+    /* Set the color of the entries with @_selectionColor; false if there is none */
+    bool setColor(uint32_t _selectionColor, uint32_t _color);
+
+    uint32_t color(uint32_t _index) const { return m_colors[_index]; }
+    uint32_t selectionColor(uint32_t _index) const { return m_selectionColors[_index]; }
+
+    size_t size() const { return m_colors.size(); }
+
+    /* Whether an entry has a selection color */
+    bool selectable() const;
+
+    /* Apply the states of the features of source @_sourceId, when they changed since the last
+     * call; false when no entry changed */
+    bool syncStates(const FeatureStates& _states, int32_t _sourceId);
+
+    /* Bind the texture to @_unit, uploading the entries when they changed */
+    bool bind(RenderState& rs, GLuint _unit);
+
+    /* Entries per row, rows of each kind and rows of the texture */
+    glm::vec3 textureSize() const;
+
+    size_t bufferSize() const;
+
+private:
+
+    std::vector<uint32_t> m_colors;
+    std::vector<uint32_t> m_selectionColors;
+
+    // State texel of each entry, see FeatureTable::bind()
+    std::vector<uint32_t> m_states;
+    // Colors replacing those of the entries, 0 for none
+    std::vector<uint32_t> m_stateColors;
+
+    // Entry of each pair of colors of features without id
+    std::unordered_map<uint64_t, uint32_t> m_entries;
+    // Entries of each feature id
+    std::unordered_map<std::string, std::vector<uint32_t>> m_features;
+    uint32_t m_statesGeneration = 0;
+
+    std::unique_ptr<Texture> m_texture;
+    bool m_dirty = true;
+};
+
+/*
+ * FeatureTableMesh - Mesh of a style drawn with the colors of a FeatureTable, see
+ * Style::setupFeatureTable()
+ */
+class FeatureTableMesh : public StyledMesh {
+
+public:
+
+    FeatureTableMesh(std::unique_ptr<StyledMesh> _mesh, std::unique_ptr<FeatureTable> _table)
+        : m_mesh(std::move(_mesh)), m_table(std::move(_table)) {}
+
+    bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) override {
+        return m_mesh->draw(rs, _shader, _useVao);
+    }
+
+    size_t bufferSize() const override { return m_mesh->bufferSize() + m_table->bufferSize(); }
+
+    size_t uploadPending(RenderState& rs) override { return m_mesh->uploadPending(rs); }
+
+    size_t vertexInvocations() const override { return m_mesh->vertexInvocations(); }
+
+    size_t vertexCount() const override { return m_mesh->vertexCount(); }
+
+    void cullChunks(const glm::mat4& _mvp, glm::vec2 _elevation) override {
+        m_mesh->cullChunks(_mvp, _elevation);
+    }
+
+    void showAllChunks() override { m_mesh->showAllChunks(); }
+
+    void hideCoveredChunks(uint16_t _cells) override { m_mesh->hideCoveredChunks(_cells); }
+
+    bool selectable() const override { return m_table->selectable(); }
+
+    bool restorable() const override { return m_mesh->restorable(); }
+
+    FeatureTable* featureTable() const override { return m_table.get(); }
+
+private:
+
+    std::unique_ptr<StyledMesh> m_mesh;
+    std::unique_ptr<FeatureTable> m_table;
+};
+
+}
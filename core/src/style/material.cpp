@@ -5,6 +5,7 @@
 #include "gl/shaderSource.h"
 #include "gl/texture.h"
 #include "platform.h"
+#include "util/floatFormatter.h"
 
 #include "material_glsl.h"
 
@@ -153,9 +154,42 @@ std::string Material::getClassBlock() {
     return material_glsl;
 }
 
+std::string Material::getConstantBlock() {
+    std::string values;
+    auto add = [&](const std::string& _value) {
+        if (!values.empty()) { values += ", "; }
+        values += _value;
+    };
+
+    if (m_bEmission) { add(ff::to_string(m_emission)); }
+    if (m_bAmbient) { add(ff::to_string(m_ambient)); }
+    if (m_bDiffuse) { add(ff::to_string(m_diffuse)); }
+    if (m_bSpecular) {
+        add(ff::to_string(m_specular));
+        add(ff::to_string(m_shininess));
+    }
+    return "Material(" + values + ")";
+}
+
+bool Material::hasTextures() const {
+    return m_emission_texture.tex || m_ambient_texture.tex || m_diffuse_texture.tex ||
+        m_specular_texture.tex || m_normal_texture.tex;
+}
+
 std::unique_ptr<MaterialUniforms> Material::injectOnProgram(ShaderSource& _source ) {
     _source.addSourceBlock("defines", getDefinesBlock(), false);
     _source.addSourceBlock("material", getClassBlock(), false);
+
+    // Materials are only set by the scene, so that without textures their values are folded
+    //  into the program instead of being set as uniforms on each draw
+    if (!hasTextures()) {
+        _source.addSourceBlock("defines", "#define TANGRAM_MATERIAL_CONSTANT\n", false);
+        if (m_bEmission || m_bAmbient || m_bDiffuse || m_bSpecular) {
+            _source.addSourceBlock("setup", "material = " + getConstantBlock() + ";", false);
+        }
+        return nullptr;
+    }
+
     _source.addSourceBlock("setup", "material = u_material;", false);
 
     if (m_bEmission || m_bAmbient || m_bDiffuse || m_bSpecular || m_normal_texture.tex) {
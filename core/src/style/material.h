@@ -122,6 +122,11 @@ private:
     /* Get the GLSL struct and classes need to be injected */
     std::string getClassBlock();
 
+    /* Get the GLSL constructor of the material struct with the values of this material */
+    std::string getConstantBlock();
+
+    bool hasTextures() const;
+
     bool m_bEmission = false;
     glm::vec4 m_emission = glm::vec4(1.f);
     MaterialTexture m_emission_texture;
@@ -1,6 +1,7 @@
 #include "style/pointStyle.h"
 
 #include "gl/dynamicQuadMesh.h"
+#include "gl/hardware.h"
 #include "gl/shaderProgram.h"
 #include "gl/texture.h"
 #include "gl/vertexLayout.h"
@@ -30,9 +31,19 @@ PointStyle::~PointStyle() {}
 void PointStyle::build(const Scene& _scene) {
     Style::build(_scene);
 
+    m_textStyle->setEager(m_eager);
     m_textStyle->build(_scene);
 
     m_mesh = std::make_unique<DynamicQuadMesh<SpriteVertex>>(m_vertexLayout, m_drawMode);
+    m_instanceMesh = std::make_unique<InstancedQuadMesh<SpriteInstance>>(m_instanceLayout);
+}
+
+void PointStyle::buildProgram() {
+    if (m_shaderSource && m_instanced) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_INSTANCED_SPRITES\n", false);
+        m_vertexLayout = m_instancedProgramLayout;
+    }
+    Style::buildProgram();
 }
 
 void PointStyle::constructVertexLayout() {
@@ -45,7 +56,26 @@ void PointStyle::constructVertexLayout() {
         {"a_outline_color", 4, GL_UNSIGNED_BYTE, true, 0},
         {"a_aa_factor", 1, GL_SHORT, true, 0},
         {"a_alpha", 1, GL_UNSIGNED_SHORT, true, 0},
+        {"a_sdf_edges", 2, GL_UNSIGNED_SHORT, true, 0},
     }));
+
+    std::vector<VertexLayout::VertexAttrib> instanceAttribs = {
+        {"a_center", 4, GL_FLOAT, false, 0},
+        {"a_axis_x", 4, GL_FLOAT, false, 0},
+        {"a_axis_y", 4, GL_FLOAT, false, 0},
+        {"a_uv_rect", 4, GL_SHORT, true, 0},
+        {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_outline_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_aa_factor", 1, GL_SHORT, true, 0},
+        {"a_alpha", 1, GL_UNSIGNED_SHORT, true, 0},
+        {"a_sdf_edges", 2, GL_UNSIGNED_SHORT, true, 0},
+    };
+    m_instanceLayout = std::make_shared<VertexLayout>(instanceAttribs);
+
+    // InstancedQuadMesh binds the unit quad corner to location 0
+    instanceAttribs.insert(instanceAttribs.begin(), {"a_corner", 2, GL_FLOAT, false, 0});
+    m_instancedProgramLayout = std::make_shared<VertexLayout>(instanceAttribs);
 }
 
 void PointStyle::constructShaderProgram() {
@@ -53,7 +83,11 @@ void PointStyle::constructShaderProgram() {
 }
 
 void PointStyle::onBeginUpdate() {
+    // Until the programs are built, follow the driver; labels are only added after this
+    if (m_shaderSource) { m_instanced = Hardware::supportsInstancing; }
+
     m_mesh->clear();
+    m_instanceMesh->clear();
     m_batches.clear();
     m_textStyle->onBeginUpdate();
 }
@@ -61,6 +95,7 @@ void PointStyle::onBeginUpdate() {
 void PointStyle::onBeginFrame(RenderState& rs) {
     // Upload meshes for next frame
     m_mesh->upload(rs);
+    m_instanceMesh->upload(rs);
     m_textStyle->onBeginFrame(rs);
 }
 
@@ -77,18 +112,24 @@ void PointStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
     //auto texUnit2 = rs.nextAvailableTextureUnit();
     //rs.texture(rs.m_terrainDepthTexture, texUnit2, GL_TEXTURE_2D);
 
-    size_t vertexPos = 0;
+    size_t pos = 0;
     for (auto& batch : m_batches) {
 
         auto tex = batch.texture;
 
-        m_shaderProgram->setUniformi(rs, m_mainUniforms.uSpriteMode, bool(tex) ? 1 : 0);
+        // 0: circles, 1: sprites, 2: distance field sprites
+        int spriteMode = tex ? (tex->isSdf() ? 2 : 1) : 0;
+        m_shaderProgram->setUniformi(rs, m_mainUniforms.uSpriteMode, spriteMode);
 
         if (tex) { tex->bind(rs, texUnit); }
 
-        m_mesh->drawRange(rs, *m_shaderProgram, vertexPos, batch.vertexCount);
+        if (m_instanced) {
+            m_instanceMesh->drawRange(rs, *m_shaderProgram, pos, batch.count);
+        } else {
+            m_mesh->drawRange(rs, *m_shaderProgram, pos, batch.count);
+        }
 
-        vertexPos += batch.vertexCount;
+        pos += batch.count;
     }
 
     m_textStyle->onBeginDrawFrame(rs, _view);
@@ -98,13 +139,18 @@ void PointStyle::onBeginDrawSelectionFrame(RenderState& rs, const View& _view) {
     if (!m_selection) { return; }
 
     m_mesh->upload(rs);
+    m_instanceMesh->upload(rs);
 
     Style::onBeginDrawSelectionFrame(rs, _view);
 
     m_selectionProgram->setUniformMatrix4f(rs, m_selectionUniforms.uOrtho,
                                            _view.getOrthoViewportMatrix());
 
-    m_mesh->draw(rs, *m_selectionProgram, false);
+    if (m_instanced) {
+        m_instanceMesh->draw(rs, *m_selectionProgram);
+    } else {
+        m_mesh->draw(rs, *m_selectionProgram, false);
+    }
 
     m_textStyle->onBeginDrawSelectionFrame(rs, _view);
 }
@@ -124,9 +170,20 @@ SpriteVertex* PointStyle::pushQuad(Texture* texture) const {
         m_batches.push_back({ texture });
     }
 
-    m_batches.back().vertexCount += 4;
+    m_batches.back().count += 4;
 
     return m_mesh->pushQuad();
 }
 
+SpriteInstance* PointStyle::pushInstance(Texture* texture) const {
+
+    if (m_batches.empty() || m_batches.back().texture != texture) {
+        m_batches.push_back({ texture });
+    }
+
+    m_batches.back().count += 1;
+
+    return m_instanceMesh->pushInstance();
+}
+
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gl/dynamicQuadMesh.h"
+#include "gl/instancedQuadMesh.h"
 #include "labels/spriteLabel.h"
 #include "labels/labelProperty.h"
 #include "labels/textLabels.h"
@@ -48,12 +49,16 @@ public:
     const auto& defaultTexture() const { return m_defaultTexture; }
 
     auto& mesh() const { return m_mesh; }
-    virtual size_t dynamicMeshSize() const override { return m_mesh->bufferSize(); }
+    virtual size_t dynamicMeshSize() const override {
+        return m_mesh->bufferSize() + m_instanceMesh->bufferSize();
+    }
 
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
 
     virtual void build(const Scene& _scene) override;
 
+    virtual void buildProgram() override;
+
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
 
@@ -62,6 +67,12 @@ public:
 
     SpriteVertex* pushQuad(Texture* texture) const;
 
+    SpriteInstance* pushInstance(Texture* texture) const;
+
+    /* Whether sprites are drawn as instances of a unit quad (GL 3) rather than as four
+     * vertices each; decided on the first update after build() */
+    bool isInstanced() const { return m_instanced; }
+
 protected:
 
     //void drawMesh(RenderState& rs, ShaderProgram& shaderProgram, UniformLocation& uSpriteMode);
@@ -78,12 +89,20 @@ protected:
     struct TextureBatch {
         TextureBatch(Texture* t) : texture(t) {}
         Texture* texture = nullptr;
-        size_t vertexCount = 0;
+        // Vertices, or instances when instanced
+        size_t count = 0;
     };
 
     mutable std::unique_ptr<DynamicQuadMesh<SpriteVertex>> m_mesh;
+    mutable std::unique_ptr<InstancedQuadMesh<SpriteInstance>> m_instanceMesh;
     mutable std::vector<TextureBatch> m_batches;
 
+    // Per-instance attributes, and the attributes of instanced programs with the unit quad
+    // corner in front
+    std::shared_ptr<VertexLayout> m_instanceLayout;
+    std::shared_ptr<VertexLayout> m_instancedProgramLayout;
+    bool m_instanced = false;
+
     std::unique_ptr<TextStyle> m_textStyle;
 };
 
@@ -102,6 +102,7 @@ void PointStyleBuilder::setup(const Marker& _marker, int zoom) {
     m_iconMesh = std::make_unique<IconMesh>();
 
     m_texture = _marker.texture();
+    m_sprite = _marker.sprite();
     m_randGen.seed(_marker.id()*zoom);
 }
 
@@ -238,7 +239,9 @@ void PointStyleBuilder::addLabel(const Point& _point, const glm::vec4& _quad, Te
                                                              selectionColor,
                                                              _params.outlineColor,
                                                              _params.antialiasFactor,
-                                                             _params.extrudeScale },
+                                                             _params.extrudeScale,
+                                                             _params.sdfFillEdge,
+                                                             _params.sdfOutlineEdge },
                                                      _texture,
                                                      *m_spriteLabels,
                                                      m_quads.size()));
@@ -317,7 +320,9 @@ bool PointStyleBuilder::evalSizeParam(const DrawRule& _rule, Parameters& _params
     SpriteNode spriteNode;
     glm::vec2 spriteSize(NAN);
 
-    if (_texture) {
+    if (_texture && m_sprite) {
+        spriteSize = m_sprite->m_size;
+    } else if (_texture) {
         spriteSize = glm::vec2{_texture->width(), _texture->height()} * _texture->displayScale();
 
         const auto &atlas = _texture->spriteAtlas();
@@ -365,7 +370,11 @@ bool PointStyleBuilder::getUVQuad(Parameters& _params, glm::vec4& _quad, const T
 
     _quad = glm::vec4(0.0, 1.0, 1.0, 0.0);
 
-    if (_texture) {
+    if (_texture && m_sprite) {
+        _quad = glm::vec4(m_sprite->m_uvBL, m_sprite->m_uvTR);
+        if (_texture->isSdf()) { setDistanceField(_params, _quad, m_sprite->m_size, *_texture); }
+    } else if (_texture) {
+        glm::vec2 texels(_texture->width(), _texture->height());
         const auto& atlas = _texture->spriteAtlas();
         if (atlas) {
             SpriteNode spriteNode;
@@ -377,7 +386,9 @@ bool PointStyleBuilder::getUVQuad(Parameters& _params, glm::vec4& _quad, const T
             _quad.y = spriteNode.m_uvBL.y;
             _quad.z = spriteNode.m_uvTR.x;
             _quad.w = spriteNode.m_uvTR.y;
+            texels = spriteNode.m_size;
         }
+        if (_texture->isSdf()) { setDistanceField(_params, _quad, texels, *_texture); }
     } else {
 
         float fillEdge = _params.size.x;
@@ -406,7 +417,35 @@ bool PointStyleBuilder::getUVQuad(Parameters& _params, glm::vec4& _quad, const T
     return true;
 }
 
-void PointStyleBuilder::labelPointsPlacing(const Line& _line, const glm::vec4& _uvsQuad, Texture* _texture,
+void PointStyleBuilder::setDistanceField(Parameters& _params, glm::vec4& _quad, glm::vec2 _texels,
+                                         const Texture& _texture) const {
+
+    float radius = _texture.getOptions().sdfRadius;
+    float texelsPerPixel = _texels.x / std::max(_params.size.x, 1.f);
+
+    // Distance of one pixel, for 0.5 on the edge and 1 / (2 * radius) per texel
+    float pixelDistance = std::min(0.5f * texelsPerPixel / radius, 1.f);
+    // Smooth the edges within about 1.5 pixels, as text does
+    _params.antialiasFactor = uint16_t(0.75f * pixelDistance * std::numeric_limits<int16_t>::max());
+
+    float fillEdge = 0.5f;
+    float outlineEdge = fillEdge;
+
+    if (_params.outlineWidth > 0.f) {
+        // The halo can reach as far as the distance field
+        float halo = std::min(_params.outlineWidth * texelsPerPixel, radius);
+        outlineEdge = fillEdge - 0.5f * halo / radius;
+
+        glm::vec2 uvHalo = halo / glm::vec2(_texture.width(), _texture.height());
+        _quad += glm::vec4(-uvHalo.x, uvHalo.y, uvHalo.x, -uvHalo.y);
+        _params.size += 2.f * halo / texelsPerPixel;
+    }
+
+    _params.sdfFillEdge = uint16_t(fillEdge * std::numeric_limits<uint16_t>::max());
+    _params.sdfOutlineEdge = uint16_t(outlineEdge * std::numeric_limits<uint16_t>::max());
+}
+
+void PointStyleBuilder::labelPointsPlacing(LineView _line, const glm::vec4& _uvsQuad, Texture* _texture,
                                            Parameters& params, const DrawRule& _rule) {
 
     if (_line.size() < 2) { return; }
@@ -524,7 +563,7 @@ bool PointStyleBuilder::addPoint(const Point& _point, const Properties& _props,
     return true;
 }
 
-bool PointStyleBuilder::addLine(const Line& _line, const Properties& _props,
+bool PointStyleBuilder::addLine(LineView _line, const Properties& _props,
                                 const DrawRule& _rule) {
 
     Parameters p = applyRule(_rule);
@@ -546,7 +585,7 @@ bool PointStyleBuilder::addLine(const Line& _line, const Properties& _props,
     return true;
 }
 
-bool PointStyleBuilder::addPolygon(const Polygon& _polygon, const Properties& _props,
+bool PointStyleBuilder::addPolygon(PolygonView _polygon, const Properties& _props,
                                    const DrawRule& _rule) {
 
     Parameters p = applyRule(_rule);
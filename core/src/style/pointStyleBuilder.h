@@ -33,6 +33,8 @@ struct PointStyleBuilder : public StyleBuilder {
         float outlineWidth = 0.f;
         uint32_t outlineColor = 0x00000000;
         uint16_t antialiasFactor = 0;
+        uint16_t sdfFillEdge = 0;
+        uint16_t sdfOutlineEdge = 0;
         Label::Options labelOptions;
         LabelProperty::Placement placement = LabelProperty::Placement::vertex;
         float extrudeScale = 1.f;
@@ -48,8 +50,8 @@ struct PointStyleBuilder : public StyleBuilder {
 
     bool checkRule(const DrawRule& _rule) const override;
 
-    bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) override;
-    bool addLine(const Line& _line, const Properties& _props, const DrawRule& _rule) override;
+    bool addPolygon(PolygonView _polygon, const Properties& _props, const DrawRule& _rule) override;
+    bool addLine(LineView _line, const Properties& _props, const DrawRule& _rule) override;
     bool addPoint(const Point& _line, const Properties& _props, const DrawRule& _rule) override;
 
     std::unique_ptr<StyledMesh> build() override;
@@ -63,7 +65,7 @@ struct PointStyleBuilder : public StyleBuilder {
     Parameters applyRule(const DrawRule& _rule) const;
 
     // Gets points for label placement and appropriate angle for each label (if `auto` angle is set)
-    void labelPointsPlacing(const Line& _line, const glm::vec4& _quad, Texture* _texture,
+    void labelPointsPlacing(LineView _line, const glm::vec4& _quad, Texture* _texture,
                             Parameters& _params, const DrawRule& _rule);
 
     void addLabel(const Point& _point, const glm::vec4& _quad, Texture* _texture,
@@ -96,6 +98,13 @@ private:
     bool evalSizeParam(const DrawRule& _rule, Parameters& _params, const Texture* _texture) const;
     bool getUVQuad(Parameters& _params, glm::vec4& _quad, const Texture* _texture) const;
 
+    /*
+     * Sets the edges and antialiasing of a sprite of @_texels in the distance field @_texture and
+     * grows @_quad and the size by the outline, which is drawn as halo around the shape
+     */
+    void setDistanceField(Parameters& _params, glm::vec4& _quad, glm::vec2 _texels,
+                          const Texture& _texture) const;
+
     std::vector<std::unique_ptr<Label>> m_labels;
     std::vector<SpriteQuad> m_quads;
 
@@ -109,6 +118,8 @@ private:
 
     // Non-owning reference to a texture to use for the current feature.
     Texture* m_texture = nullptr;
+    // Part of m_texture to use, e.g. of a marker bitmap in the marker atlas
+    const SpriteNode* m_sprite = nullptr;
 
     std::mt19937 m_randGen;
 };
@@ -2,15 +2,19 @@
 
 #include "gl/mesh.h"
 #include "gl/shaderProgram.h"
+#include "gl/shaderSource.h"
 #include "map.h"
 #include "marker/marker.h"
 #include "material.h"
 #include "platform.h"
 #include "scene/drawRule.h"
+#include "scene/scene.h"
+#include "style/featureTable.h"
 #include "tile/tile.h"
 #include "util/builders.h"
 #include "util/color.h"
 #include "util/extrude.h"
+#include "util/mapProjection.h"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
@@ -24,6 +28,11 @@ constexpr float position_scale = 8192.0f;
 constexpr float texture_scale = 65535.0f;
 constexpr float normal_scale = 127.0f;
 
+// Pixels at the styling zoom by which footprints of extrusions are simplified for coarse tiles
+constexpr float coarse_simplify_pixels = 2.0f;
+// Extrusions of coarse tiles smaller than this get only their roof
+constexpr float coarse_roof_only_pixels = 4.0f;
+
 namespace Tangram {
 
 
@@ -50,19 +59,44 @@ struct PolygonVertex : PolygonVertexNoUVs {
     glm::u16vec2 texcoord;
 };
 
+// Whether the shader blocks of the scene may read normals
+static bool readsNormals(const ShaderSource& _source) {
+    for (const auto& block : _source.getSourceBlocks()) {
+        if (block.first == "normal") { return true; }
+        for (const auto& source : block.second) {
+            if (source.find("normal") != std::string::npos ||
+                source.find("Normal") != std::string::npos) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 PolygonStyle::PolygonStyle(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection)
     : Style(_name, _blendMode, _drawMode, _selection) {
     m_type = StyleType::polygon;
     m_material.material = std::make_shared<Material>();
 }
 
+void PolygonStyle::build(const Scene& _scene) {
+    m_useFeatureTable = _scene.options().featureTables;
+
+    Style::build(_scene);
+}
+
 void PolygonStyle::constructVertexLayout() {
 
+    // With a feature table the color holds the index of the feature in the table
+    auto color = m_useFeatureTable ?
+        VertexLayout::VertexAttrib{"a_feature", 2, GL_UNSIGNED_SHORT, false, 0} :
+        VertexLayout::VertexAttrib{"a_color", 4, GL_UNSIGNED_BYTE, true, 0};
+
     if (m_texCoordsGeneration) {
         m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
             {"a_position", 4, GL_SHORT, false, 0},
             {"a_normal", 4, GL_BYTE, true, 0}, // The 4th byte is for padding
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+            color,
             {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
             {"a_texcoord", 2, GL_UNSIGNED_SHORT, true, 0},
         }));
@@ -70,11 +104,21 @@ void PolygonStyle::constructVertexLayout() {
         m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
             {"a_position", 4, GL_SHORT, false, 0},
             {"a_normal", 4, GL_BYTE, true, 0},
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+            color,
             {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
         }));
     }
 
+    m_useNormals = m_lightingType != LightingType::none || readsNormals(*m_shaderSource);
+
+    std::vector<std::string> unused;
+    if (!m_useNormals) { unused.push_back("a_normal"); }
+    // Selection colors are in the feature table
+    if (m_useFeatureTable) { unused.push_back("a_selection_color"); }
+    m_selectableMeshLayout = VertexLayout::without(m_vertexLayout, unused);
+
+    unused.push_back("a_selection_color");
+    m_meshLayout = VertexLayout::without(m_vertexLayout, unused);
 }
 
 void PolygonStyle::constructShaderProgram() {
@@ -84,6 +128,12 @@ void PolygonStyle::constructShaderProgram() {
     if (m_texCoordsGeneration) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_USE_TEX_COORDS\n");
     }
+    if (!m_useNormals) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_NO_NORMALS\n");
+    }
+    if (m_useFeatureTable) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_FEATURE_TABLE\n");
+    }
 }
 
 template <class V>
@@ -104,15 +154,32 @@ public:
         m_tileUnitsPerMeter = _tile.getInverseScale();
         m_zoom = _tile.getID().z;
         m_meshData.clear();
+        m_selectable = false;
+        m_featureTable = m_style.useFeatureTable() ? std::make_unique<FeatureTable>() : nullptr;
+        // Hidden walls can be skipped when no wall is seen through another
+        m_cullWalls = m_style.blendMode() == Blending::opaque;
+        clearWalls();
+
+        auto& id = _tile.getID();
+        float tileUnitsPerPixel = 1.f / (MapProjection::tileSize() * std::exp2(float(id.s - id.z)));
+        m_coarseSimplifier.setTolerance(coarse_simplify_pixels * tileUnitsPerPixel);
+        m_coarseRoofOnlySize = coarse_roof_only_pixels * tileUnitsPerPixel;
     }
 
     void setup(const Marker& _marker, int zoom) override {
         m_zoom = zoom;
         m_tileUnitsPerMeter = 1.f / _marker.extent();
         m_meshData.clear();
+        m_selectable = false;
+        m_featureTable = m_style.useFeatureTable() ? std::make_unique<FeatureTable>() : nullptr;
+        m_cullWalls = false;
+        clearWalls();
+        m_coarse = false;
     }
 
-    bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) override;
+    bool addFeature(const Feature& _feat, const DrawRule& _rule) override;
+
+    bool addPolygon(PolygonView _polygon, const Properties& _props, const DrawRule& _rule) override;
 
     const Style& style() const override { return m_style; }
 
@@ -126,6 +193,15 @@ public:
 
 private:
 
+    // Cull the collected walls and add the remaining ones to m_meshData
+    void buildWalls();
+    // Add the walls in m_builder to m_meshData
+    void addWalls();
+    void clearWalls();
+
+    // Reduce the detail of extrusion @_polygon with parameters @_p for a coarse tile
+    PolygonView coarsen(PolygonView _polygon, Parameters& _p);
+
     const PolygonStyle& m_style;
 
     PolygonBuilder m_builder;
@@ -135,20 +211,119 @@ private:
     float m_tileUnitsPerMeter = 0;
     int m_zoom = 0;
 
+    // Triangles of the polygon being added, when its feature has them
+    Span<uint16_t> m_triangles;
+
+    // Whether a feature has a selection color
+    bool m_selectable = false;
+
+    // Colors of the features when the style uses feature tables
+    std::unique_ptr<FeatureTable> m_featureTable;
+
+    // Extrusion walls of the tile, built in build()
+    bool m_cullWalls = false;
+    ExtrusionWalls m_walls;
+    std::vector<Parameters> m_wallParams;
+    // Index into m_wallParams of each wall in m_builder
+    std::vector<uint32_t> m_wallPolygons;
+
+    // Level of detail of extrusions in coarse tiles, see StyleBuilder::setCoarse()
+    GeometrySimplifier m_coarseSimplifier;
+    float m_coarseRoofOnlySize = 0;
+
 };
 
 template <class V>
 std::unique_ptr<StyledMesh> PolygonStyleBuilder<V>::build() {
+    buildWalls();
+
     if (m_meshData.vertices.empty()) { return nullptr; }
 
     auto mesh = std::make_unique<Mesh<V>>(m_style.vertexLayout(),
                                                       m_style.drawMode());
+    // Only opaque polygons may be reordered, blended ones are drawn in the order they were added
+    mesh->setReorderTriangles(m_style.blendMode() == Blending::opaque);
+    mesh->setChunking(position_scale, 0.f);
+    mesh->setCompiledLayout(m_style.meshLayout(m_selectable));
     mesh->compile(m_meshData);
     m_meshData.clear();
 
+    if (m_featureTable) {
+        return std::make_unique<FeatureTableMesh>(std::move(mesh), std::move(m_featureTable));
+    }
     return std::move(mesh);
 }
 
+template <class V>
+void PolygonStyleBuilder<V>::buildWalls() {
+    if (m_walls.walls.empty()) { return; }
+
+    Builders::cullExtrusionWalls(m_walls);
+
+    for (const auto& wall : m_walls.walls) {
+        if (wall.hidden) { continue; }
+
+        if (m_builder.numVertices + 4 > MAX_INDEX_VALUE) { addWalls(); }
+
+        // Consecutive walls of a polygon can be merged unless texture coordinates are stretched
+        bool extend = !m_builder.useTexCoords &&
+            !m_wallPolygons.empty() && m_wallPolygons.back() == wall.polygon;
+
+        if (Builders::buildExtrusionWall(wall, extend, m_builder)) {
+            m_wallPolygons.push_back(wall.polygon);
+        }
+    }
+    addWalls();
+    clearWalls();
+}
+
+template <class V>
+void PolygonStyleBuilder<V>::addWalls() {
+    if (m_builder.vertices.empty()) { return; }
+
+    for (size_t i = 0; i < m_builder.vertices.size(); i++) {
+        const auto& v = m_builder.vertices[i];
+        const auto& p = m_wallParams[m_wallPolygons[i / 4]];
+        m_meshData.vertices.push_back({ v.coord, p.order, v.normal, v.uv, p.color, p.selectionColor });
+    }
+
+    m_meshData.indices.insert(m_meshData.indices.end(),
+                              m_builder.indices.begin(),
+                              m_builder.indices.end());
+
+    m_meshData.offsets.emplace_back(m_builder.indices.size(),
+                                    m_builder.numVertices);
+    m_builder.clear();
+    m_wallPolygons.clear();
+}
+
+template <class V>
+void PolygonStyleBuilder<V>::clearWalls() {
+    m_walls.clear();
+    m_wallParams.clear();
+    m_wallPolygons.clear();
+}
+
+template <class V>
+PolygonView PolygonStyleBuilder<V>::coarsen(PolygonView _polygon, Parameters& _p) {
+
+    glm::vec2 min(_polygon[0].front()), max(_polygon[0].front());
+    for (const auto& point : _polygon[0]) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    // Walls of small buildings far away cover few pixels, their roof is enough
+    glm::vec2 size = max - min;
+    if (std::max(size.x, size.y) < m_coarseRoofOnlySize) {
+        _p.minHeight = _p.height;
+        m_coarseBuilt = true;
+    }
+
+    auto simplified = m_coarseSimplifier.simplify(_polygon);
+    if (simplified.front().data() != _polygon.front().data()) { m_coarseBuilt = true; }
+    return simplified;
+}
+
 template <class V>
 auto PolygonStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties& _props) -> Parameters {
     Parameters p;
@@ -174,24 +349,75 @@ auto PolygonStyleBuilder<V>::parseRule(const DrawRule& _rule, const Properties&
 }
 
 template <class V>
-bool PolygonStyleBuilder<V>::addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) {
+bool PolygonStyleBuilder<V>::addFeature(const Feature& _feat, const DrawRule& _rule) {
+    if (_feat.geometryType != GeometryType::polygons || _feat.triangleEnds.empty()) {
+        return StyleBuilder::addFeature(_feat, _rule);
+    }
+    if (!checkRule(_rule)) { return false; }
+
+    // Pass the triangles of each polygon on to addPolygon()
+    bool added = false;
+    auto polygons = _feat.polygons();
+    for (size_t i = 0; i < polygons.size(); i++) {
+        m_triangles = _feat.polygonTriangles(i);
+        added |= addPolygon(polygons[i], _feat.props, _rule);
+    }
+    m_triangles = {};
+    return added;
+}
+
+template <class V>
+bool PolygonStyleBuilder<V>::addPolygon(PolygonView _polygon, const Properties& _props, const DrawRule& _rule) {
 
     auto p = parseRule(_rule, _props);
 
+    // The triangles refer to the points of the polygon as it is
+    auto simplified = m_simplifier.simplify(_polygon);
+
+    if (m_coarse && p.minHeight != p.height && !simplified.empty() && !simplified[0].empty()) {
+        simplified = coarsen(simplified, p);
+    }
+
+    // Only flat polygons are clipped: extrusions would get walls along the clip edges, and
+    // texture coordinates span the bounding box of the whole polygon
+    if (p.minHeight == p.height && !m_builder.useTexCoords) {
+        simplified = m_clipper.clip(simplified);
+        if (simplified.empty()) { return false; }
+    }
+
+    m_selectable |= p.selectionColor != 0;
+
+    // Vertices hold the index of the colors in the feature table
+    if (m_featureTable) {
+        p.color = m_featureTable->add(p.color, p.selectionColor, _props.getAsString("id"));
+        p.selectionColor = 0;
+    }
+
     m_builder.keepTileEdges = p.keepTileEdges;
+    m_builder.triangulationCache = m_triangulationCache;
 
-    m_builder.addVertex = [this, p](const glm::vec3& coord,
-                                 const glm::vec3& normal,
-                                 const glm::vec2& uv) {
-        m_meshData.vertices.push_back({ coord, p.order, normal, uv, p.color, p.selectionColor });
-    };
+    Span<uint16_t> triangles;
+    if (!_polygon.empty() && simplified.front().data() == _polygon.front().data()) {
+        triangles = m_triangles;
+    }
+    _polygon = simplified;
 
     if (p.minHeight != p.height) {
-        Builders::buildPolygonExtrusion(_polygon, p.minHeight,
-                                        p.height, m_builder);
+        if (m_cullWalls) {
+            Builders::addExtrusionWalls(_polygon, p.minHeight, p.height, uint32_t(m_wallParams.size()),
+                                        p.keepTileEdges, m_walls);
+            m_wallParams.push_back(p);
+        } else {
+            Builders::buildPolygonExtrusion(_polygon, p.minHeight,
+                                            p.height, m_builder);
+        }
     }
 
-    Builders::buildPolygon(_polygon, p.height, m_builder);
+    Builders::buildPolygon(_polygon, p.height, m_builder, triangles);
+
+    for (const auto& v : m_builder.vertices) {
+        m_meshData.vertices.push_back({ v.coord, p.order, v.normal, v.uv, p.color, p.selectionColor });
+    }
 
     m_meshData.indices.insert(m_meshData.indices.end(),
                               m_builder.indices.begin(),
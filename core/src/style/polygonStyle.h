@@ -10,11 +10,23 @@ public:
 
     PolygonStyle(std::string _name, Blending _blendMode = Blending::opaque, GLenum _drawMode = GL_TRIANGLES, bool _selection = true);
 
+    virtual void build(const Scene& _scene) override;
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
     virtual ~PolygonStyle() {}
 
+    // Whether colors of features are read from a FeatureTable, see SceneOptions::featureTables
+    bool useFeatureTable() const { return m_useFeatureTable; }
+
+protected:
+
+    // Whether normals are read, by lighting or shader blocks; otherwise meshes are compiled
+    // without them and all normals point up
+    bool m_useNormals = true;
+
+    bool m_useFeatureTable = false;
+
 };
 
 }
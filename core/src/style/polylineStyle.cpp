@@ -1,5 +1,7 @@
 #include "style/polylineStyle.h"
 
+#include "gl/hardware.h"
+#include "gl/instancedLineMesh.h"
 #include "gl/shaderProgram.h"
 #include "gl/mesh.h"
 #include "gl/texture.h"
@@ -9,11 +11,12 @@
 #include "marker/marker.h"
 #include "material.h"
 #include "platform.h"
+#include "scene/scene.h"
 #include "scene/stops.h"
 #include "scene/drawRule.h"
+#include "style/featureTable.h"
 #include "tile/tile.h"
 #include "util/builders.h"
-#include "util/dashArray.h"
 #include "util/extrude.h"
 #include "util/floatFormatter.h"
 #include "util/mapProjection.h"
@@ -21,6 +24,8 @@
 #include "glm/vec3.hpp"
 #include "glm/gtc/type_precision.hpp"
 
+#include <algorithm>
+
 #include "polyline_vs.h"
 #include "polyline_fs.h"
 
@@ -28,7 +33,7 @@ constexpr float extrusion_scale = 4096.0f;
 constexpr float position_scale = 8192.0f;
 constexpr float texture_scale = 2048.0f;
 constexpr float order_scale = 2.0f;
-constexpr float dash_scale = 20.f;
+constexpr float miter_scale = 16.0f;
 
 namespace Tangram {
 
@@ -65,6 +70,26 @@ struct PolylineVertex : PolylineVertexNoUVs {
     glm::u16vec2 texcoord;
 };
 
+struct PolylineInstance {
+    PolylineInstance(const PolyLineBuilderSegment& segment, glm::i16vec4 line, GLuint abgr,
+                     GLuint selection, glm::u8vec4 shape)
+        : segment(glm::i16vec2{ nearbyint(segment.start * position_scale) },
+                  glm::i16vec2{ nearbyint(segment.end * position_scale) }),
+          neighbors(glm::i16vec2{ nearbyint(segment.prev * position_scale) },
+                    glm::i16vec2{ nearbyint(segment.next * position_scale) }),
+          line(line),
+          abgr(abgr),
+          selection(selection),
+          shape(shape) {}
+
+    glm::i16vec4 segment;
+    glm::i16vec4 neighbors;
+    glm::i16vec4 line;
+    GLuint abgr;
+    GLuint selection;
+    glm::u8vec4 shape;
+};
+
 PolylineStyle::PolylineStyle(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection)
     : Style(_name, _blendMode, _drawMode, _selection) {
     m_type = StyleType::polyline;
@@ -73,12 +98,37 @@ PolylineStyle::PolylineStyle(std::string _name, Blending _blendMode, GLenum _dra
 
 void PolylineStyle::constructVertexLayout() {
 
+    // With a feature table the color holds the index of the feature in the table
+    auto color = m_useFeatureTable ?
+        VertexLayout::VertexAttrib{"a_feature", 2, GL_UNSIGNED_SHORT, false, 0} :
+        VertexLayout::VertexAttrib{"a_color", 4, GL_UNSIGNED_BYTE, true, 0};
+
+    if (m_instanced) {
+        // Attributes of PolylineInstance
+        std::vector<VertexLayout::VertexAttrib> instanceAttribs = {
+            {"a_segment", 4, GL_SHORT, false, 0},
+            {"a_neighbors", 4, GL_SHORT, false, 0},
+            {"a_line", 4, GL_SHORT, false, 0},
+            color,
+            {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+            {"a_shape", 4, GL_UNSIGNED_BYTE, false, 0},
+        };
+        m_instanceLayout = std::make_shared<VertexLayout>(instanceAttribs);
+        m_meshLayout = m_instanceLayout;
+        m_selectableMeshLayout = m_instanceLayout;
+
+        // InstancedLineMesh binds the segment corner to location 0
+        instanceAttribs.insert(instanceAttribs.begin(), {"a_corner", 3, GL_FLOAT, false, 0});
+        m_vertexLayout = std::make_shared<VertexLayout>(instanceAttribs);
+        return;
+    }
+
     // TODO: Ideally this would be in the same location as the struct that it basically describes
     if (m_texCoordsGeneration) {
         m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
             {"a_position", 4, GL_SHORT, false, 0},
             {"a_extrude", 4, GL_SHORT, false, 0},
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+            color,
             {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
             {"a_texcoord", 2, GL_UNSIGNED_SHORT, false, 0},
         }));
@@ -86,16 +136,51 @@ void PolylineStyle::constructVertexLayout() {
         m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
             {"a_position", 4, GL_SHORT, false, 0},
             {"a_extrude", 4, GL_SHORT, false, 0},
-            {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+            color,
             {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
         }));
     }
+
+    m_meshLayout = VertexLayout::without(m_vertexLayout, { "a_selection_color" });
+    // Selection colors are in the feature table
+    if (m_useFeatureTable) { m_selectableMeshLayout = m_meshLayout; }
+}
+
+void PolylineStyle::build(const Scene& _scene) {
+
+    m_useFeatureTable = _scene.options().featureTables;
+
+    // Dash patterns of all styles share one texture, and styles with the same other
+    // parameters share one shader program
+    m_dashAtlas = nullptr;
+    if (!m_dashArray.empty()) {
+        m_dashRow = _scene.dashAtlas().add(m_dashArray);
+        if (m_dashRow.length > 0) { m_dashAtlas = &_scene.dashAtlas(); }
+    }
+
+    // Lines without texture coordinates are extruded by the vertex shader when the driver
+    // supports instancing; scenes loaded before the GL context is set up build them on the CPU
+    m_instanced = Hardware::supportsInstancing && !m_texCoordsGeneration && !m_dashAtlas && !m_texture;
+
+    Style::build(_scene);
 }
 
 void PolylineStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
     Style::onBeginDrawFrame(rs, _view);
 
-    if (m_texture && m_texture->width() > 0) {
+    if (m_dashAtlas) {
+        auto texture = m_dashAtlas->texture();
+        GLuint textureUnit = rs.nextAvailableTextureUnit();
+
+        texture->bind(rs, textureUnit);
+
+        m_shaderProgram->setUniformi(rs, m_uTexture, textureUnit);
+        m_shaderProgram->setUniformf(rs, m_uDash,
+                                     (m_dashRow.index + 0.5f) / texture->height(),
+                                     float(m_dashRow.length) / texture->width(),
+                                     float(m_dashRow.length));
+        m_shaderProgram->setUniformf(rs, m_uDashBackgroundColor, m_dashBackgroundColor);
+    } else if (m_texture && m_texture->width() > 0) {
         GLuint textureUnit = rs.nextAvailableTextureUnit();
 
         m_texture->bind(rs, textureUnit);
@@ -113,32 +198,13 @@ void PolylineStyle::constructShaderProgram() {
 
     m_shaderSource->setSourceStrings(polyline_fs, polyline_vs);
 
-    if (m_dashArray.size() > 0) {
-        TextureOptions options;
-        options.minFilter = TextureMinFilter::NEAREST;
-        options.magFilter = TextureMagFilter::NEAREST;
-        // provides precision for dash patterns that are a fraction of line width
-        auto pixels = DashArray::render(m_dashArray, dash_scale);
-
-        m_texture = std::make_shared<Texture>(options);
-        m_texture->setPixelData(1, pixels.size(), sizeof(GLuint),
-                                reinterpret_cast<GLubyte*>(pixels.data()),
-                                pixels.size() * sizeof(GLuint));
-
-        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_LINE_BACKGROUND_COLOR vec4(" +
-                                                  ff::to_string(m_dashBackgroundColor.r) + ", " +
-                                                  ff::to_string(m_dashBackgroundColor.g) + ", " +
-                                                  ff::to_string(m_dashBackgroundColor.b) + ", " +
-                                                  ff::to_string(m_dashBackgroundColor.a) + ")\n");
-    }
-
-    if (m_dashArray.size() > 0 || m_texture) {
+    if (m_dashAtlas || m_texture) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_LINE_TEXTURE\n", false);
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_ALPHA_TEST 0.25\n", false);
-        if (m_dashArray.size() > 0) {
+        if (m_dashAtlas) {
             m_shaderSource->addSourceBlock("defines", "#define TANGRAM_LINE_DASH");
             m_shaderSource->addSourceBlock("defines", "#define TANGRAM_DASH_TEX_SCALE " +
-                                            ff::to_string(dash_scale) + "\n", false);
+                                            ff::to_string(m_dashAtlas->dashScale()) + "\n", false);
         } else {
             m_shaderSource->addSourceBlock("defines", "#define TANGRAM_DASH_TEX_SCALE 1.0\n", false);
         }
@@ -147,6 +213,12 @@ void PolylineStyle::constructShaderProgram() {
     if (m_texCoordsGeneration) {
         m_shaderSource->addSourceBlock("defines", "#define TANGRAM_USE_TEX_COORDS\n");
     }
+    if (m_instanced) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_INSTANCED_LINES\n");
+    }
+    if (m_useFeatureTable) {
+        m_shaderSource->addSourceBlock("defines", "#define TANGRAM_FEATURE_TABLE\n");
+    }
 }
 
 template <class V>
@@ -189,13 +261,18 @@ public:
 
     PolylineStyleBuilder(const PolylineStyle& _style)
         : m_style(_style),
-          m_meshData(2) {}
+          m_meshData(2),
+          m_instances(_style.isInstanced() ? 2 : 0) {}
 
-    void addMesh(const Line& _line, const Parameters& _params);
+    void addMesh(LineView _line, const Parameters& _params);
 
-    void buildLine(const Line& _line, const typename Parameters::Attributes& _att,
+    void buildLine(LineView _line, const typename Parameters::Attributes& _att,
                    MeshData<V>& _mesh, GLuint _selection);
 
+    // Add the segments of the polyline builder as instances, see PolylineStyle::isInstanced()
+    void addInstances(const typename Parameters::Attributes& _att,
+                      std::vector<PolylineInstance>& _instances, GLuint _selection);
+
     Parameters parseRule(const DrawRule& _rule, const Properties& _props);
 
     bool evalWidth(const StyleParam& _styleParam, float& width, float& slope);
@@ -208,11 +285,22 @@ private:
     PolyLineBuilder m_builder;
 
     std::vector<MeshData<V>> m_meshData;
+    // Fill and stroke segments of instanced lines
+    std::vector<std::vector<PolylineInstance>> m_instances;
 
     float m_tileUnitsPerMeter = 0;
     float m_tileUnitsPerPixel = 0;
     int m_zoom = 0;
     float m_overzoom2 = 1;
+
+    // Width stops evaluated at the next zoom, for the slope
+    StopsCache<float> m_slopes;
+
+    // Whether a feature has a selection color
+    bool m_selectable = false;
+
+    // Colors of the features when the style uses feature tables
+    std::unique_ptr<FeatureTable> m_featureTable;
 };
 
 template <class V>
@@ -222,9 +310,11 @@ void PolylineStyleBuilder<V>::setup(const Tile& tile) {
 
     // Use the 'style zoom' to evaluate style parameters.
     m_zoom = id.s;
+    m_slopes.setZoom(m_zoom);
     m_overzoom2 = exp2(id.s - id.z);
     m_tileUnitsPerMeter = tile.getInverseScale();
     m_tileUnitsPerPixel = 1.f / MapProjection::tileSize();
+    m_featureTable = m_style.useFeatureTable() ? std::make_unique<FeatureTable>() : nullptr;
 
     // When a tile is overzoomed, we are actually styling the area of its
     // 'source' tile, which will have a larger effective pixel size at the
@@ -236,6 +326,7 @@ template <class V>
 void PolylineStyleBuilder<V>::setup(const Marker& marker, int zoom) {
 
     m_zoom = zoom;
+    m_slopes.setZoom(m_zoom);
     m_overzoom2 = 1.f;
     m_tileUnitsPerMeter = 1.f / marker.extent();
     float metersPerTile = MapProjection::metersPerTileAtZoom(zoom);
@@ -244,11 +335,38 @@ void PolylineStyleBuilder<V>::setup(const Marker& marker, int zoom) {
     // "tile size" for building a Marker is the size of a tile in pixels multiplied
     // by the ratio of the Marker's extent to the length of a tile side at this zoom.
     m_tileUnitsPerPixel = metersPerTile / (marker.extent() * 256.f);
+    m_featureTable = m_style.useFeatureTable() ? std::make_unique<FeatureTable>() : nullptr;
 
 }
 
 template <class V>
 std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
+
+    bool painterMode = (m_style.blendMode() == Blending::overlay ||
+                        m_style.blendMode() == Blending::inlay);
+
+    if (m_style.isInstanced()) {
+        if (m_instances[0].empty() && m_instances[1].empty()) { return nullptr; }
+
+        auto mesh = std::make_unique<InstancedLineMesh<PolylineInstance>>(m_style.instanceLayout());
+
+        // Instances are drawn in order, outlines first when not using depth testing
+        if (painterMode) { std::swap(m_instances[0], m_instances[1]); }
+        mesh->compile(m_instances);
+        if (painterMode) { std::swap(m_instances[0], m_instances[1]); }
+
+        mesh->setSelectable(m_selectable);
+
+        m_instances[0].clear();
+        m_instances[1].clear();
+        m_selectable = false;
+
+        if (m_featureTable) {
+            return std::make_unique<FeatureTableMesh>(std::move(mesh), std::move(m_featureTable));
+        }
+        return std::move(mesh);
+    }
+
     if (m_meshData[0].vertices.empty() &&
         m_meshData[1].vertices.empty()) {
         return nullptr;
@@ -256,12 +374,15 @@ std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
 
     auto mesh = std::make_unique<Mesh<V>>(m_style.vertexLayout(), m_style.drawMode());
 
-    bool painterMode = (m_style.blendMode() == Blending::overlay ||
-                        m_style.blendMode() == Blending::inlay);
-
     // Swap draw order to draw outline first when not using depth testing
     if (painterMode) { std::swap(m_meshData[0], m_meshData[1]); }
 
+    // Only opaque lines may be reordered, blended ones are drawn in the order they were added
+    mesh->setReorderTriangles(m_style.blendMode() == Blending::opaque);
+    // Positions are the centers of the lines, widened by their extrusion in the shader;
+    // chunks are padded for lines up to a quarter of a tile wide
+    mesh->setChunking(position_scale, 0.125f);
+    mesh->setCompiledLayout(m_style.meshLayout(m_selectable));
     mesh->compile(m_meshData);
 
     // Swapping back since fill mesh may have more vertices than outline
@@ -269,6 +390,11 @@ std::unique_ptr<StyledMesh> PolylineStyleBuilder<V>::build() {
 
     m_meshData[0].clear();
     m_meshData[1].clear();
+    m_selectable = false;
+
+    if (m_featureTable) {
+        return std::make_unique<FeatureTableMesh>(std::move(mesh), std::move(m_featureTable));
+    }
     return std::move(mesh);
 }
 
@@ -384,7 +510,12 @@ bool PolylineStyleBuilder<V>::evalWidth(const StyleParam& _styleParam, float& wi
         width = _styleParam.value.get<float>();
         width *= pixelWidthScale;
 
-        slope = _styleParam.stops->evalExpFloat(std::nextafter(m_zoom + 1.f, 0.f));
+        if (const float* value = m_slopes.find(*_styleParam.stops)) {
+            slope = *value;
+        } else {
+            slope = _styleParam.stops->evalExpFloat(std::nextafter(m_zoom + 1.f, 0.f));
+            m_slopes.insert(*_styleParam.stops, slope);
+        }
         slope *= pixelWidthScale;
         return true;
     }
@@ -418,20 +549,50 @@ bool PolylineStyleBuilder<V>::addFeature(const Feature& _feat, const DrawRule& _
 
     if (params.fill.width[0] <= 0.0f && params.fill.width[1] <= 0.0f ) { return false; }
 
+    // Vertices hold the index of the colors in the feature table
+    if (m_featureTable) {
+        auto featureId = _feat.props.getAsString("id");
+        params.fill.color = m_featureTable->add(params.fill.color, params.selectionColor, featureId);
+        if (params.outlineOn) {
+            params.stroke.color = m_featureTable->add(params.stroke.color, params.selectionColor,
+                                                      featureId);
+        }
+        params.selectionColor = 0;
+    }
+
     if (_feat.geometryType == GeometryType::lines) {
         // Line geometries are never clipped to tiles, so keep all segments
         params.keepTileEdges = true;
         // allow override (for 3D terrain)
         _rule.get(StyleParamKey::tile_edges, params.keepTileEdges);
 
-        for (auto& line : _feat.lines) {
-            addMesh(line, params);
+        // Lines are clipped unless their texture coordinates run along them, e.g. for dashes;
+        //  the margin covers the widest line and its joins at the next zoom
+        float clipMargin = 0.f;
+        bool clip = m_clipper.enabled() && !m_builder.useTexCoords;
+        if (clip) {
+            for (const auto* att : { &params.fill, &params.stroke }) {
+                if (att == &params.stroke && !params.outlineOn) { continue; }
+                float halfWidth = (att->width.x + std::max(0, int(att->width.y))) / extrusion_scale;
+                clipMargin = std::max(clipMargin, halfWidth * std::max(att->miterLimit, 1.f));
+            }
+        }
+
+        for (auto line : _feat.lines()) {
+            line = m_simplifier.simplify(line);
+            if (!clip) {
+                addMesh(line, params);
+                continue;
+            }
+            for (auto piece : m_clipper.clip(line, clipMargin)) {
+                addMesh(piece, params);
+            }
         }
     } else {
         params.closedPolygon = true;
 
-        for (auto& polygon : _feat.polygons) {
-            for (const auto& line : polygon) {
+        for (auto polygon : _feat.polygons()) {
+            for (auto line : m_simplifier.simplify(polygon)) {
                 addMesh(line, params);
             }
         }
@@ -441,16 +602,16 @@ bool PolylineStyleBuilder<V>::addFeature(const Feature& _feat, const DrawRule& _
 }
 
 template <class V>
-void PolylineStyleBuilder<V>::buildLine(const Line& _line, const typename Parameters::Attributes& _att,
+void PolylineStyleBuilder<V>::buildLine(LineView _line, const typename Parameters::Attributes& _att,
                                         MeshData<V>& _mesh, GLuint selection) {
 
+    Builders::buildPolyLine(_line, m_builder);
+
     float zoom = m_overzoom2;
-    m_builder.addVertex = [&](const glm::vec2& coord, const glm::vec2& normal, const glm::vec2& uv) {
-        _mesh.vertices.push_back({{ coord.x,coord.y }, normal, { uv.x, uv.y * zoom },
+    for (const auto& v : m_builder.vertices) {
+        _mesh.vertices.push_back({{ v.coord.x, v.coord.y }, v.enormal, { v.uv.x, v.uv.y * zoom },
                                   _att.width, _att.height, _att.color, selection});
-    };
-
-    Builders::buildPolyLine(_line, m_builder);
+    }
 
     _mesh.indices.insert(_mesh.indices.end(),
                          m_builder.indices.begin(),
@@ -463,13 +624,42 @@ void PolylineStyleBuilder<V>::buildLine(const Line& _line, const typename Parame
 }
 
 template <class V>
-void PolylineStyleBuilder<V>::addMesh(const Line& _line, const Parameters& _params) {
+void PolylineStyleBuilder<V>::addInstances(const typename Parameters::Attributes& _att,
+                                           std::vector<PolylineInstance>& _instances,
+                                           GLuint _selection) {
+
+    glm::i16vec4 line(_att.width, _att.height);
+    auto miterLimit = uint8_t(std::clamp(_att.miterLimit * miter_scale, 0.f, 255.f));
+
+    for (const auto& segment : m_builder.segments) {
+        uint8_t caps = (segment.startCap ? 1 : 0) | (segment.endCap ? 2 : 0);
+        _instances.emplace_back(segment, line, _att.color, _selection,
+                                glm::u8vec4(uint8_t(_att.cap), uint8_t(_att.join), miterLimit, caps));
+    }
+}
+
+template <class V>
+void PolylineStyleBuilder<V>::addMesh(LineView _line, const Parameters& _params) {
 
     m_builder.cap = _params.fill.cap;
     m_builder.join = _params.fill.join;
     m_builder.miterLimit = _params.fill.miterLimit;
     m_builder.keepTileEdges = _params.keepTileEdges;
     m_builder.closedPolygon = _params.closedPolygon;
+    m_selectable |= _params.selectionColor != 0;
+
+    if (m_style.isInstanced()) {
+        // Segments don't depend on caps and joins, which the vertex shader adds
+        Builders::buildPolyLine(_line, m_builder);
+        if (_params.lineOn) {
+            addInstances(_params.fill, m_instances[0], _params.selectionColor);
+        }
+        if (_params.outlineOn) {
+            addInstances(_params.stroke, m_instances[1], _params.selectionColor);
+        }
+        m_builder.clear();
+        return;
+    }
 
     if (_params.lineOn) { buildLine(_line, _params.fill, m_meshData[0], _params.selectionColor); }
 
@@ -520,6 +710,7 @@ std::unique_ptr<StyleBuilder> PolylineStyle::createBuilder() const {
     } else {
         auto builder = std::make_unique<PolylineStyleBuilder<PolylineVertexNoUVs>>(*this);
         builder->polylineBuilder().useTexCoords = false;
+        builder->polylineBuilder().segmentsOnly = m_instanced;
         return std::move(builder);
     }
 }
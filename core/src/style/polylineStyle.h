@@ -1,6 +1,7 @@
 #pragma once
 
 #include "style/style.h"
+#include "util/dashAtlas.h"
 
 namespace Tangram {
 
@@ -12,6 +13,7 @@ public:
 
     PolylineStyle(std::string _name, Blending _blendMode = Blending::opaque, GLenum _drawMode = GL_TRIANGLES, bool _selection = true);
 
+    virtual void build(const Scene& _scene) override;
     virtual void constructVertexLayout() override;
     virtual void constructShaderProgram() override;
     virtual std::unique_ptr<StyleBuilder> createBuilder() const override;
@@ -23,14 +25,33 @@ public:
 
     void setDashBackgroundColor(const glm::vec4 _dashBackgroundColor);
 
+    bool useFeatureTable() const { return m_useFeatureTable; }
+
+    // Whether lines are drawn as InstancedLineMesh, see build()
+    bool isInstanced() const { return m_instanced; }
+
+    const std::shared_ptr<VertexLayout>& instanceLayout() const { return m_instanceLayout; }
+
 private:
 
     std::vector<float> m_dashArray;
     std::shared_ptr<Texture> m_texture;
     glm::vec4 m_dashBackgroundColor = {};
 
+    bool m_useFeatureTable = false;
+
+    // Segments of instanced lines, whose programs read the segment corner before them
+    bool m_instanced = false;
+    std::shared_ptr<VertexLayout> m_instanceLayout;
+
+    // Row of the dash pattern in the dash atlas of the scene, when dashed
+    DashAtlas* m_dashAtlas = nullptr;
+    DashAtlas::Row m_dashRow;
+
     UniformLocation m_uTexture{"u_texture"};
     UniformLocation m_uTextureRatio{"u_texture_ratio"};
+    UniformLocation m_uDash{"u_dash"};
+    UniformLocation m_uDashBackgroundColor{"u_dash_background_color"};
 };
 
 }
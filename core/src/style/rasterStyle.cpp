@@ -3,10 +3,21 @@
 #include "scene/scene.h"
 #include "gl/mesh.h"
 #include "gl/shaderProgram.h"
+#include "tile/tile.h"
+#include "util/elevationManager.h"
+#include "view/view.h"
 #include "log.h"
 
 constexpr float position_scale = 8192.0f;
 
+// Terrain grid resolutions, each twice the previous one
+constexpr uint32_t TERRAIN_MIN_RESOLUTION = 4;
+constexpr uint32_t TERRAIN_MAX_RESOLUTION = 64;
+
+// Largest screen-space error of terrain grids in logical pixels, for an error estimated as the
+// relief of the tile divided by the grid resolution
+constexpr float TERRAIN_MAX_ERROR_PX = 2.f;
+
 namespace Tangram {
 
 struct SharedMesh : public StyledMesh
@@ -22,7 +33,8 @@ struct SharedMesh : public StyledMesh
     bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) override {
         _shader.setUniformf(rs, m_style->m_uColor, m_color);
         _shader.setUniformf(rs, m_style->m_uOrder, m_order);
-        return m_mesh->draw(rs, _shader, _useVao);
+        StyledMesh* mesh = m_style->m_drawMesh ? m_style->m_drawMesh : m_mesh;
+        return mesh->draw(rs, _shader, _useVao);
     }
 
     size_t bufferSize() const override { return 0; }
@@ -30,12 +42,74 @@ struct SharedMesh : public StyledMesh
 
 
 struct RasterVertex {
-    RasterVertex(glm::vec2 position)
-        : pos(glm::i16vec2{ nearbyint(position * position_scale) }) {}
+    RasterVertex(glm::vec2 position, bool skirt = false)
+        : pos(glm::i16vec2{ nearbyint(position * position_scale) }), skirt(skirt) {}
 
     glm::i16vec2 pos;
+    // 1 for vertices of skirts, moved down by u_skirt in the vertex shader
+    int16_t skirt;
+    int16_t padding = 0;
 };
 
+// Grid of _resolution x _resolution cells over the tile; with skirts, the edges of the tile are
+// repeated as skirt vertices joined to the edges by triangles facing outwards
+static std::unique_ptr<StyledMesh> gridMesh(const RasterStyle& _style, uint32_t _resolution, bool _skirts) {
+    float elementSize = 1.f / _resolution;
+    uint32_t rowSize = _resolution + 1;
+    uint16_t index = 0;
+    MeshData<RasterVertex> meshData;
+    meshData.vertices.reserve(rowSize * rowSize + (_skirts ? 4 * rowSize : 0));
+    meshData.indices.reserve(6*_resolution*_resolution + (_skirts ? 24 * _resolution : 0));
+    for (uint32_t col = 0; col <= _resolution; col++) {
+        float y = col * elementSize;
+        for (uint32_t row = 0; row <= _resolution; row++) {
+            float x = row * elementSize;
+            meshData.vertices.push_back({{x, y}});
+
+            if (row < _resolution && col < _resolution) {
+                meshData.indices.push_back(index);
+                meshData.indices.push_back(index + 1);
+                meshData.indices.push_back(index + _resolution + 1);
+
+                meshData.indices.push_back(index + 1);
+                meshData.indices.push_back(index + _resolution + 2);
+                meshData.indices.push_back(index + _resolution + 1);
+            }
+            index++;
+        }
+    }
+
+    if (_skirts) {
+        // Edges counter-clockwise, i.e. with the tile on the left, so that skirts face outwards
+        for (int edge = 0; edge < 4; edge++) {
+            uint16_t prevEdge = 0;
+            for (uint32_t i = 0; i <= _resolution; i++) {
+                uint32_t x = edge == 0 ? i : edge == 1 ? _resolution : edge == 2 ? _resolution - i : 0;
+                uint32_t y = edge == 0 ? 0 : edge == 1 ? i : edge == 2 ? _resolution : _resolution - i;
+                uint16_t edgeIndex = y * rowSize + x;
+                meshData.vertices.push_back({{x * elementSize, y * elementSize}, true});
+
+                if (i > 0) {
+                    meshData.indices.push_back(prevEdge);
+                    meshData.indices.push_back(index - 1);
+                    meshData.indices.push_back(edgeIndex);
+
+                    meshData.indices.push_back(edgeIndex);
+                    meshData.indices.push_back(index - 1);
+                    meshData.indices.push_back(index);
+                }
+                prevEdge = edgeIndex;
+                index++;
+            }
+        }
+    }
+
+    meshData.offsets.emplace_back(meshData.indices.size(), meshData.vertices.size());
+    auto mesh = std::make_unique<Mesh<RasterVertex>>(_style.vertexLayout(), _style.drawMode());
+    mesh->compile(meshData);
+    return std::move(mesh);
+}
+
 RasterStyle::RasterStyle(std::string _name, Blending _blendMode)
     : PolygonStyle(_name, _blendMode, GL_TRIANGLES, false) {
     m_type = StyleType::raster;
@@ -44,7 +118,7 @@ RasterStyle::RasterStyle(std::string _name, Blending _blendMode)
 
 void RasterStyle::constructVertexLayout() {
     m_vertexLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
-        {"a_position", 2, GL_SHORT, false, 0},
+        {"a_position", 4, GL_SHORT, false, 0},
     }));
 }
 
@@ -58,35 +132,61 @@ void RasterStyle::constructShaderProgram() {
 void RasterStyle::build(const Scene& _scene) {
     Style::build(_scene);
 
-    uint32_t resolution = _scene.elevationManager() ? 64 : 1;
-    float elementSize = 1.f / resolution;
-    uint16_t index = 0;
-    MeshData<RasterVertex> meshData;
-    meshData.vertices.reserve((resolution+1) * (resolution+1));
-    meshData.indices.reserve(6*resolution*resolution);
-    for (uint32_t col = 0; col <= resolution; col++) {
-        float y = col * elementSize;
-        for (uint32_t row = 0; row <= resolution; row++) {
-            float x = row * elementSize;
-            meshData.vertices.push_back({{x, y}});
+    m_terrainMeshes.clear();
+    m_rasterMesh.reset();
+    if (_scene.elevationManager()) {
+        for (uint32_t res = TERRAIN_MIN_RESOLUTION; res <= TERRAIN_MAX_RESOLUTION; res *= 2) {
+            m_terrainMeshes.push_back(gridMesh(*this, res, true));
+        }
+    } else {
+        m_rasterMesh = gridMesh(*this, 1, false);
+    }
+}
 
-            if (row < resolution && col < resolution) {
-                meshData.indices.push_back(index);
-                meshData.indices.push_back(index + 1);
-                meshData.indices.push_back(index + resolution + 1);
+void RasterStyle::onBeginDrawFrame(RenderState& rs, const View& _view) {
+    Style::onBeginDrawFrame(rs, _view);
 
-                meshData.indices.push_back(index + 1);
-                meshData.indices.push_back(index + resolution + 2);
-                meshData.indices.push_back(index + resolution + 1);
-            }
-            index++;
-        }
+    // Pixels per meter at a depth of one meter, for perspective and orthographic projections
+    const glm::mat4& proj = _view.getProjectionMatrix();
+    m_pixelsPerUnitDepth = 0.5f * _view.getHeight() * proj[1][1];
+    m_perspective = proj[2][3] != 0;
+    m_maxErrorPx = TERRAIN_MAX_ERROR_PX * _view.pixelScale();
+    m_elevationManager = _view.elevationManager();
+}
+
+StyledMesh* RasterStyle::terrainMesh(RenderState& rs, const Tile& _tile) {
+    if (m_terrainMeshes.empty() || !m_elevationManager) { return rasterMesh(); }
+
+    glm::vec2 elev = m_elevationManager->getMinMaxElev(_tile.getID()) * m_elevationManager->m_terrainScale;
+    float relief = elev.y - elev.x;
+    float scale = _tile.getScale();
+
+    // Depth of the nearest part of the tile, from its center less half its diagonal
+    glm::vec4 center = _tile.mvp() * glm::vec4(0.5f, 0.5f, 0.5f * (elev.x + elev.y) / scale, 1.f);
+    float depth = m_perspective ? std::max(center.w - 0.71f * scale, 1.f) : center.w;
+    float pixelsPerMeter = m_pixelsPerUnitDepth / depth;
+
+    size_t level = 0;
+    uint32_t resolution = TERRAIN_MIN_RESOLUTION;
+    while (level + 1 < m_terrainMeshes.size() && relief / resolution * pixelsPerMeter > m_maxErrorPx) {
+        level++;
+        resolution *= 2;
     }
-    meshData.offsets.emplace_back(meshData.indices.size(), meshData.vertices.size());
-    // Create mesh from vertices.
-    auto rasterMesh = std::make_unique<Mesh<RasterVertex>>(vertexLayout(), drawMode());
-    rasterMesh->compile(meshData);
-    m_rasterMesh = std::move(rasterMesh);
+
+    // Neighbours of other resolutions are within twice the error allowed for both tiles
+    float skirt = std::min(relief, std::max(4.f * m_maxErrorPx / pixelsPerMeter, 2.f * relief / resolution));
+    m_shaderProgram->setUniformf(rs, m_uSkirt, skirt);
+
+    return m_terrainMeshes[level].get();
+}
+
+bool RasterStyle::draw(RenderState& rs, const Tile& _tile) {
+    if (!_tile.getMesh(*this)) { return false; }
+
+    m_drawMesh = terrainMesh(rs, _tile);
+    bool drawn = Style::draw(rs, _tile);
+    m_drawMesh = nullptr;
+    return drawn;
 }
 
 
@@ -142,7 +242,7 @@ bool RasterStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule)
 
     if (!checkRule(_rule)) { return false; }
 
-    if (_feat.geometryType != GeometryType::polygons || _feat.polygons.size() != 1) {
+    if (_feat.geometryType != GeometryType::polygons || _feat.polygons().size() != 1) {
         LOGE("Invalid geometry passed to RasterStyle");
         return false;
     }
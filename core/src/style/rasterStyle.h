@@ -4,6 +4,8 @@
 
 namespace Tangram {
 
+class ElevationManager;
+
 // derive from PolygonStyle just to avoid duplicating polygon shader source
 class RasterStyle : public PolygonStyle {
 
@@ -15,13 +17,39 @@ public:
     void constructShaderProgram() override;
     std::unique_ptr<StyleBuilder> createBuilder() const override;
 
-    StyledMesh* rasterMesh() const { return m_rasterMesh.get(); }
+    // Grid mesh over the tile, the finest terrain grid with terrain
+    StyledMesh* rasterMesh() const {
+        return m_terrainMeshes.empty() ? m_rasterMesh.get() : m_terrainMeshes.back().get();
+    }
+
+    void onBeginDrawFrame(RenderState& rs, const View& _view) override;
+    bool draw(RenderState& rs, const Tile& _tile) override;
+    using Style::draw;
 
 protected:
+    // Grid mesh to draw for _tile: with terrain, the resolution with a screen-space error below
+    // TERRAIN_MAX_ERROR_PX estimated from the relief of the tile; also sets u_skirt
+    StyledMesh* terrainMesh(RenderState& rs, const Tile& _tile);
+
+    // Single quad over the tile without terrain
     std::unique_ptr<StyledMesh> m_rasterMesh;
 
+    // Terrain grids with skirts of increasing resolution, empty without terrain; the meshes
+    // are static and share the pages of the BufferPool
+    std::vector<std::unique_ptr<StyledMesh>> m_terrainMeshes;
+
+    // Set for the frame in onBeginDrawFrame()
+    ElevationManager* m_elevationManager = nullptr;
+    float m_pixelsPerUnitDepth = 0;
+    bool m_perspective = true;
+    float m_maxErrorPx = 0;
+
+    // Mesh chosen for the tile being drawn, see SharedMesh
+    StyledMesh* m_drawMesh = nullptr;
+
     UniformLocation m_uColor{"u_color"};
     UniformLocation m_uOrder{"u_order"};
+    UniformLocation m_uSkirt{"u_skirt"};
     friend struct SharedMesh;
 
 };
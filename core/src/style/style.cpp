@@ -1,22 +1,28 @@
 #include "style/style.h"
 
 #include "data/tileSource.h"
+#include "gl/hardware.h"
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
 #include "gl/mesh.h"
 #include "log.h"
 #include "map.h"
 #include "marker/marker.h"
+#include "scene/featureStates.h"
 #include "scene/light.h"
 #include "scene/scene.h"
 #include "scene/spriteAtlas.h"
 #include "scene/styleParam.h"
+#include "style/featureTable.h"
 #include "style/material.h"
 #include "tile/tile.h"
+#include "util/elevationManager.h"
 #include "view/view.h"
 
 #include "rasters_glsl.h"
 
+#include <algorithm>
+
 namespace Tangram {
 
 Style::Style(std::string _name, Blending _blendMode, GLenum _drawMode, bool _selection) :
@@ -86,11 +92,17 @@ void Style::build(const Scene& _scene) {
         }
     }
 
+    m_numRasters = 0;
     if (m_rasterType != RasterType::none) {
         int numRasterSource = 0;
         for (const auto& source : _scene.tileSources()) {
             if (source->isRaster()) { numRasterSource++; }
         }
+        // custom shader blocks may sample any raster of the scene
+        if (m_rasterType != RasterType::custom && m_usedRasters >= 0) {
+            numRasterSource = std::min(numRasterSource, m_usedRasters);
+        }
+        m_numRasters = numRasterSource;
         if (numRasterSource > 0) {
             // Inject shader defines for raster sampling and uniforms
             if (m_rasterType == RasterType::normal) {
@@ -101,6 +113,9 @@ void Style::build(const Scene& _scene) {
 
             m_shaderSource->addSourceBlock("defines", "#define TANGRAM_NUM_RASTER_SOURCES "
                                            + std::to_string(numRasterSource) + "\n", false);
+            if (_scene.options().rasterTextureArrays) {
+                m_shaderSource->addSourceBlock("defines", "#define TANGRAM_RASTER_ARRAYS\n", false);
+            }
             m_shaderSource->addSourceBlock("defines", "#define TANGRAM_MODEL_POSITION_BASE_ZOOM_VARYING\n", false);
 
             m_shaderSource->addSourceBlock("raster", rasters_glsl);
@@ -114,12 +129,22 @@ void Style::build(const Scene& _scene) {
         m_hasColorShaderBlock = true;
     }
 
+    m_scene = &_scene;
+
+    if (m_eager) { buildProgram(); }
+}
+
+void Style::buildProgram() {
+
+    if (!m_shaderSource) { return; }
+
     std::string vertSrc = m_shaderSource->buildVertexSource();
     std::string fragSrc = m_shaderSource->buildFragmentSource();
 
-    for (auto& s : _scene.styles()) {
+    // Share programs with styles that were already drawn and have the same sources
+    for (auto& s : m_scene->styles()) {
         auto& prg = s->m_shaderProgram;
-        if (!prg) { break; }
+        if (!prg) { continue; }
         if (prg->vertexShaderSource() == vertSrc &&
             prg->fragmentShaderSource() == fragSrc) {
             m_shaderProgram = prg;
@@ -135,11 +160,11 @@ void Style::build(const Scene& _scene) {
         std::string vertSrc = m_shaderSource->buildSelectionVertexSource();
         std::string fragSrc = m_shaderSource->buildSelectionFragmentSource();
 
-        for (auto& s : _scene.styles()) {
+        for (auto& s : m_scene->styles()) {
             if (!s->m_selection) { continue; }
 
             auto& prg = s->m_selectionProgram;
-            if (!prg) { break; }
+            if (!prg) { continue; }
             if (prg->vertexShaderSource() == vertSrc &&
                 prg->fragmentShaderSource() == fragSrc) {
                 m_selectionProgram = prg;
@@ -152,6 +177,30 @@ void Style::build(const Scene& _scene) {
         }
     }
 
+    if (m_depthPrepass && m_blend == Blending::opaque && !m_hasColorShaderBlock) {
+        std::string depthFragSrc = m_shaderSource->buildDepthFragmentSource();
+
+        // Same vertex shader as the main program, so that both passes produce the same depth
+        for (auto& s : m_scene->styles()) {
+            auto& prg = s->m_depthProgram;
+            if (!prg) { continue; }
+            if (prg->vertexShaderSource() == vertSrc &&
+                prg->fragmentShaderSource() == depthFragSrc) {
+                m_depthProgram = prg;
+                break;
+            }
+        }
+        if (!m_depthProgram) {
+            m_depthProgram = std::make_shared<ShaderProgram>(vertSrc, depthFragSrc, m_vertexLayout.get());
+            m_depthProgram->setDescription("depth_program {style:" + m_name + "}");
+        }
+        // Style uniforms may be used by the vertex shader
+        m_depthUniforms.styleUniforms.clear();
+        for (auto& uniform : m_mainUniforms.styleUniforms) {
+            m_depthUniforms.styleUniforms.emplace_back(uniform.first.name, uniform.second);
+        }
+    }
+
     // Clear ShaderSource builder
     m_shaderSource.reset();
 }
@@ -207,11 +256,6 @@ void Style::setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const
     // Reset the currently used texture unit to 0
     rs.resetTextureUnit();
 
-    // Set time uniforms style's shader programs
-    _program.setUniformf(rs, _uniforms.uTime, rs.frameTime());
-
-    _program.setUniformf(rs, _uniforms.uDevicePixelRatio, m_pixelScale);
-
     if (m_material.uniforms) {
         m_material.material->setupProgram(rs, *m_shaderProgram, *m_material.uniforms);
     }
@@ -221,16 +265,24 @@ void Style::setupShaderUniforms(RenderState& rs, ShaderProgram& _program, const
         light.light->setupProgram(rs, _view, *m_shaderProgram, *light.uniforms);
     }
 
-    // Set Map Position
-    _program.setUniformf(rs, _uniforms.uResolution, _view.getWidth(), _view.getHeight());
+    // The frame uniforms are in the uniform block set by Scene::render() when supported
+    if (!Hardware::supportsUniformBuffers) {
+        // Set time uniforms style's shader programs
+        _program.setUniformf(rs, _uniforms.uTime, rs.frameTime());
+
+        _program.setUniformf(rs, _uniforms.uDevicePixelRatio, m_pixelScale);
+
+        // Set Map Position
+        _program.setUniformf(rs, _uniforms.uResolution, _view.getWidth(), _view.getHeight());
 
-    const auto& mapPos = _view.getPosition();
-    _program.setUniformf(rs, _uniforms.uMapPosition, mapPos.x, mapPos.y, _view.getZoom());
-    _program.setUniformMatrix3f(rs, _uniforms.uNormalMatrix, _view.getNormalMatrix());
-    _program.setUniformMatrix3f(rs, _uniforms.uInverseNormalMatrix, _view.getInverseNormalMatrix());
-    _program.setUniformf(rs, _uniforms.uMetersPerPixel, 1.0 / _view.pixelsPerMeter());
-    _program.setUniformMatrix4f(rs, _uniforms.uView, _view.getViewMatrix());
-    _program.setUniformMatrix4f(rs, _uniforms.uProj, _view.getProjectionMatrix());
+        const auto& mapPos = _view.getPosition();
+        _program.setUniformf(rs, _uniforms.uMapPosition, mapPos.x, mapPos.y, _view.getZoom());
+        _program.setUniformMatrix3f(rs, _uniforms.uNormalMatrix, _view.getNormalMatrix());
+        _program.setUniformMatrix3f(rs, _uniforms.uInverseNormalMatrix, _view.getInverseNormalMatrix());
+        _program.setUniformf(rs, _uniforms.uMetersPerPixel, 1.0 / _view.pixelsPerMeter());
+        _program.setUniformMatrix4f(rs, _uniforms.uView, _view.getViewMatrix());
+        _program.setUniformMatrix4f(rs, _uniforms.uProj, _view.getProjectionMatrix());
+    }
 
     setupSceneShaderUniforms(rs, _uniforms);
 
@@ -244,12 +296,19 @@ void Style::setupTileShaderUniforms(RenderState& rs, const Tile& _tile,
     // if vertex shader uses rasters for 3D terrain, selection program will include raster uniforms; if not,
     //  glGetUniformLocation() will fail to find the raster (the -1 returned will be cached and subsequent
     //  setUniform calls will be no-ops)
-    if (hasRasters()) {
-        UniformTextureArray textureIndexUniform;
-        UniformArray2f rasterSizeUniform;
-        UniformArray3f rasterOffsetsUniform;
+    if (hasRasters() && m_numRasters > 0) {
+        // Reuse the arrays of the previous tile
+        auto& textureIndexUniform = m_rasterUniforms.textureIndex;
+        auto& rasterSizeUniform = m_rasterUniforms.sizes;
+        auto& rasterOffsetsUniform = m_rasterUniforms.offsets;
+        auto& rasterLayersUniform = m_rasterUniforms.layers;
+        textureIndexUniform.slots.clear();
+        rasterSizeUniform.clear();
+        rasterOffsetsUniform.clear();
+        rasterLayersUniform.clear();
 
         for (auto& raster : _tile.rasters()) {
+            if (int(textureIndexUniform.slots.size()) == m_numRasters) { break; }
 
             auto& texture = raster.texture;
             auto texUnit = rs.nextAvailableTextureUnit();
@@ -257,6 +316,7 @@ void Style::setupTileShaderUniforms(RenderState& rs, const Tile& _tile,
 
             textureIndexUniform.slots.push_back(texUnit);
             rasterSizeUniform.push_back({texture->width(), texture->height()});
+            rasterLayersUniform.push_back(float(texture->arrayLayer()));
 
             float x = 0.f, y = 0.f, z = 1.f;
             if (tileID.z > raster.tileID.z) {
@@ -272,16 +332,21 @@ void Style::setupTileShaderUniforms(RenderState& rs, const Tile& _tile,
         _program.setUniformi(rs, _uniformBlock.uRasters, textureIndexUniform);
         _program.setUniformf(rs, _uniformBlock.uRasterSizes, rasterSizeUniform);
         _program.setUniformf(rs, _uniformBlock.uRasterOffsets, rasterOffsetsUniform);
+        _program.setUniformf(rs, _uniformBlock.uRasterLayers, rasterLayersUniform);
     }
 
     _program.setUniformMatrix4f(rs, _uniformBlock.uModel, _tile.getModelMatrix());
     _program.setUniformf(rs, _uniformBlock.uProxyDepth, float(_tile.proxyDepth()));
+    // Trims of marker lines, see Style::draw(RenderState&, const Marker&)
+    _program.setUniformf(rs, _uniformBlock.uLineTrim, 0.f);
     _program.setUniformf(rs, _uniformBlock.uTileOrigin,
                           _tile.getOrigin().x, _tile.getOrigin().y, tileID.s, tileID.z);
 }
 
 void Style::onBeginDrawFrame(RenderState& rs, const View& _view) {
 
+    if (m_shaderSource) { buildProgram(); }
+
     setupShaderUniforms(rs, *m_shaderProgram, _view, m_mainUniforms);
 
     // Configure render state
@@ -343,6 +408,8 @@ void Style::drawSelectionFrame(RenderState& rs, const View& _view,
 
 void Style::onBeginDrawSelectionFrame(RenderState& rs, const View& _view) {
 
+    if (m_shaderSource) { buildProgram(); }
+
     setupShaderUniforms(rs, *m_selectionProgram, _view, m_selectionUniforms);
 
     // Configure render state
@@ -371,32 +438,37 @@ void Style::onBeginDrawSelectionFrame(RenderState& rs, const View& _view) {
 }
 
 void Style::drawSelectionFrame(RenderState& _rs, const Marker& _marker) {
-    if (_marker.styleId() != m_id || !_marker.isVisible()) {
+    if (_marker.styleId() != m_id || !_marker.isVisible() || !_marker.isInView()) {
         return;
     }
 
     auto* mesh = _marker.mesh();
 
-    if (!mesh) { return; }
+    if (!mesh || !mesh->selectable()) { return; }
 
+    int prevTexUnit = _rs.currentTextureUnit();
     m_selectionProgram->setUniformMatrix4f(_rs, m_selectionUniforms.uModel, _marker.modelMatrix());
     m_selectionProgram->setUniformf(_rs, m_selectionUniforms.uTileOrigin,
                                     _marker.origin().x, _marker.origin().y,
                                     _marker.builtZoomLevel(), _marker.builtZoomLevel());
+    setupFeatureTable(_rs, *mesh, -1, *m_selectionProgram, m_selectionUniforms);
 
     if (!mesh->draw(_rs, *m_selectionProgram, false)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
     }
+
+    _rs.resetTextureUnit(prevTexUnit);
 }
 
 void Style::drawSelectionFrame(Tangram::RenderState& rs, const Tangram::Tile& _tile) {
 
     auto& styleMesh = _tile.getMesh(*this);
 
-    if (!styleMesh) { return; }
+    if (!styleMesh || !styleMesh->selectable() || !_tile.isUploaded()) { return; }
 
     int prevTexUnit = rs.currentTextureUnit();
     setupTileShaderUniforms(rs, _tile, *m_selectionProgram, m_selectionUniforms);
+    setupFeatureTable(rs, *styleMesh, _tile.sourceID(), *m_selectionProgram, m_selectionUniforms);
 
     if (!styleMesh->draw(rs, *m_selectionProgram, false)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
@@ -409,8 +481,30 @@ bool Style::draw(RenderState& rs, const View& _view,
                  const std::vector<std::shared_ptr<Tile>>& _tiles,
                  const std::vector<std::unique_ptr<Marker>>& _markers) {
 
-    auto tileIt = std::find_if(std::begin(_tiles), std::end(_tiles),
-                               [this](const auto& t){ return bool(t->getMesh(*this)); });
+    // Collect the tiles with a mesh of this style once for all passes; tiles that are not
+    // uploaded yet are left to their proxies, see TileUploader
+    m_drawTiles.clear();
+    for (const auto& tile : _tiles) {
+        if (tile->isUploaded() && tile->getMesh(*this)) { m_drawTiles.push_back(tile.get()); }
+    }
+
+    if (m_blend == Blending::opaque && m_drawTiles.size() > 1) {
+        // Draw front to back, so that the depth test rejects hidden fragments before they are shaded
+        m_tileDepths.clear();
+        for (const auto* tile : m_drawTiles) {
+            glm::vec4 center = tile->mvp() * glm::vec4(0.5f, 0.5f, 0.f, 1.f);
+            m_tileDepths.emplace_back(center.z, tile);
+        }
+        std::sort(m_tileDepths.begin(), m_tileDepths.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (size_t i = 0; i < m_tileDepths.size(); i++) { m_drawTiles[i] = m_tileDepths[i].second; }
+    }
+
+    return draw(rs, _view, m_drawTiles, _markers);
+}
+
+bool Style::draw(RenderState& rs, const View& _view, const std::vector<const Tile*>& _tiles,
+                 const std::vector<std::unique_ptr<Marker>>& _markers) {
 
     auto markerIt = std::find_if(std::begin(_markers), std::end(_markers),
                                [this](const auto& m){ return m->styleId() == this->m_id && m->mesh(); });
@@ -419,7 +513,7 @@ bool Style::draw(RenderState& rs, const View& _view,
 
     // Skip when no mesh is to be rendered.
     // This also compiles shaders when they are first used.
-    if (tileIt == std::end(_tiles) && markerIt == std::end(_markers)) {
+    if (_tiles.empty() && markerIt == std::end(_markers)) {
         return false;
     }
 
@@ -429,13 +523,30 @@ bool Style::draw(RenderState& rs, const View& _view,
         rs.colorMask(false, false, false, false);
     }
 
-    for (const auto& tile : _tiles) {
+    bool depthPrepass = m_depthProgram && !_tiles.empty();
+    if (depthPrepass) {
+        setupShaderUniforms(rs, *m_depthProgram, _view, m_depthUniforms);
+        rs.colorMask(false, false, false, false);
+        for (const auto* tile : _tiles) {
+            cullTileChunks(_view, *tile);
+            drawDepth(rs, *tile);
+        }
+        rs.colorMask(true, true, true, true);
+        // Shade only the fragments which are in front
+        GL::depthFunc(GL_LEQUAL);
+    }
+
+    for (const auto* tile : _tiles) {
+        if (!depthPrepass) { cullTileChunks(_view, *tile); }
         meshDrawn |= draw(rs, *tile);
     }
     for (const auto& marker : _markers) {
+        cullMarkerChunks(_view, *marker);
         meshDrawn |= draw(rs, *marker);
     }
 
+    if (depthPrepass) { GL::depthFunc(GL_LESS); }
+
     if (m_blend == Blending::translucent) {
         rs.colorMask(true, true, true, true);
         if (meshDrawn) {
@@ -446,7 +557,7 @@ bool Style::draw(RenderState& rs, const View& _view,
             GL::stencilFunc(GL_EQUAL, GL_ZERO, 0xFF);
             GL::stencilOp(GL_KEEP, GL_KEEP, GL_INCR);
 
-            for (const auto &tile : _tiles) { draw(rs, *tile); }
+            for (const auto* tile : _tiles) { draw(rs, *tile); }
             for (const auto &marker : _markers) { draw(rs, *marker); }
 
             GL::disable(GL_STENCIL_TEST);
@@ -459,6 +570,50 @@ bool Style::draw(RenderState& rs, const View& _view,
     return meshDrawn;
 }
 
+// Pitch above which parts of tiles are culled; whole tiles are culled when the tiles to draw are
+// selected, which is enough for views looking down
+static constexpr float CHUNK_CULLING_MIN_PITCH = 0.35f;
+
+void Style::cullTileChunks(const View& _view, const Tile& _tile) {
+
+    auto& styleMesh = _tile.getMesh(*this);
+    if (!styleMesh) { return; }
+
+    auto* elevationManager = _view.elevationManager();
+
+    // Vertices moved by other shader blocks than terrain could leave their bounds
+    bool movesVertices = !elevationManager &&
+        m_shaderSource->getSourceBlocks().count("position") > 0;
+
+    if (_view.getPitch() < CHUNK_CULLING_MIN_PITCH || movesVertices) {
+        styleMesh->showAllChunks();
+    } else {
+        glm::vec2 elevation(0.f);
+        if (elevationManager) {
+            elevation = elevationManager->getMinMaxElev(_tile.getID()) * float(_tile.getInverseScale());
+        }
+        styleMesh->cullChunks(_tile.mvp(), elevation);
+    }
+
+    // Parts of proxies which tiles of higher zoom are drawn over
+    if (!movesVertices) { styleMesh->hideCoveredChunks(_tile.coveredCells()); }
+}
+
+void Style::cullMarkerChunks(const View& _view, const Marker& _marker) {
+
+    if (_marker.styleId() != m_id || !_marker.isVisible() || !_marker.isInView()) { return; }
+
+    auto* mesh = _marker.mesh();
+    if (!mesh) { return; }
+
+    // Markers are not raised by terrain, but their vertices could be moved by shader blocks
+    if (_view.elevationManager() || m_shaderSource->getSourceBlocks().count("position") > 0) {
+        mesh->showAllChunks();
+    } else {
+        mesh->cullChunks(_marker.modelViewProjectionMatrix(), glm::vec2(0.f));
+    }
+}
+
 bool Style::draw(RenderState& rs, const Tile& _tile) {
 
     auto& styleMesh = _tile.getMesh(*this);
@@ -469,6 +624,7 @@ bool Style::draw(RenderState& rs, const Tile& _tile) {
 
     int prevTexUnit = rs.currentTextureUnit();
     setupTileShaderUniforms(rs, _tile, *m_shaderProgram, m_mainUniforms);
+    setupFeatureTable(rs, *styleMesh, _tile.sourceID(), *m_shaderProgram, m_mainUniforms);
 
     if (!styleMesh->draw(rs, *m_shaderProgram)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
@@ -480,28 +636,64 @@ bool Style::draw(RenderState& rs, const Tile& _tile) {
     return styleMeshDrawn;
 }
 
+void Style::drawDepth(RenderState& rs, const Tile& _tile) {
+
+    auto& styleMesh = _tile.getMesh(*this);
+
+    if (!styleMesh) { return; }
+
+    int prevTexUnit = rs.currentTextureUnit();
+    setupTileShaderUniforms(rs, _tile, *m_depthProgram, m_depthUniforms);
+    setupFeatureTable(rs, *styleMesh, _tile.sourceID(), *m_depthProgram, m_depthUniforms);
+
+    styleMesh->draw(rs, *m_depthProgram);
+
+    rs.resetTextureUnit(prevTexUnit);
+}
+
 bool Style::draw(RenderState& rs, const Marker& marker) {
 
-    if (marker.styleId() != m_id || !marker.isVisible()) { return false; }
+    if (marker.styleId() != m_id || !marker.isVisible() || !marker.isInView()) { return false; }
 
     auto* mesh = marker.mesh();
 
     if (!mesh) { return false; }
     bool styleMeshDrawn = true;
 
+    int prevTexUnit = rs.currentTextureUnit();
     m_shaderProgram->setUniformMatrix4f(rs, m_mainUniforms.uModel, marker.modelMatrix());
     m_shaderProgram->setUniformf(rs, m_mainUniforms.uTileOrigin,
                                  marker.origin().x, marker.origin().y,
                                  marker.builtZoomLevel(), marker.builtZoomLevel());
+    m_shaderProgram->setUniformf(rs, m_mainUniforms.uLineTrim, marker.lineTrim().distance);
+    setupFeatureTable(rs, *mesh, -1, *m_shaderProgram, m_mainUniforms);
 
     if (!mesh->draw(rs, *m_shaderProgram)) {
         LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
         styleMeshDrawn = false;
     }
 
+    rs.resetTextureUnit(prevTexUnit);
     return styleMeshDrawn;
 }
 
+void Style::setupFeatureTable(RenderState& rs, const StyledMesh& _mesh, int32_t _sourceId,
+                              ShaderProgram& _program, UniformBlock& _uniformBlock) {
+
+    auto* table = _mesh.featureTable();
+    if (!table) { return; }
+
+    if (_sourceId >= 0 && m_scene) {
+        table->syncStates(m_scene->featureStates(), _sourceId);
+    }
+
+    GLuint textureUnit = rs.nextAvailableTextureUnit();
+    table->bind(rs, textureUnit);
+
+    _program.setUniformi(rs, _uniformBlock.uFeatureTable, textureUnit);
+    _program.setUniformf(rs, _uniformBlock.uFeatureTableSize, table->textureSize());
+}
+
 void Style::setDefaultDrawRule(std::unique_ptr<DrawRuleData>&& _rule) {
     m_defaultDrawRule = std::move(_rule);
 }
@@ -546,17 +738,17 @@ bool StyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
     bool added = false;
     switch (_feat.geometryType) {
         case GeometryType::points:
-            for (auto& point : _feat.points) {
+            for (auto& point : _feat.points()) {
                 added |= addPoint(point, _feat.props, _rule);
             }
             break;
         case GeometryType::lines:
-            for (auto& line : _feat.lines) {
+            for (auto line : _feat.lines()) {
                 added |= addLine(line, _feat.props, _rule);
             }
             break;
         case GeometryType::polygons:
-            for (auto& polygon : _feat.polygons) {
+            for (auto polygon : _feat.polygons()) {
                 added |= addPolygon(polygon, _feat.props, _rule);
             }
             break;
@@ -572,12 +764,12 @@ bool StyleBuilder::addPoint(const Point& _point, const Properties& _props, const
     return false;
 }
 
-bool StyleBuilder::addLine(const Line& _line, const Properties& _props, const DrawRule& _rule) {
+bool StyleBuilder::addLine(LineView _line, const Properties& _props, const DrawRule& _rule) {
     // No-op by default
     return false;
 }
 
-bool StyleBuilder::addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule) {
+bool StyleBuilder::addPolygon(PolygonView _polygon, const Properties& _props, const DrawRule& _rule) {
     // No-op by default
     return false;
 }
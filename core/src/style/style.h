@@ -4,7 +4,11 @@
 #include "gl.h"
 #include "gl/uniform.h"
 #include "scene/drawRule.h"
+#include "util/clip.h"
 #include "util/fastmap.h"
+#include "util/simplify.h"
+
+#include "glm/mat4x4.hpp"
 
 #include <memory>
 #include <string>
@@ -12,6 +16,7 @@
 
 namespace Tangram {
 
+class FeatureTable;
 class Label;
 class LabelCollider;
 class Light;
@@ -25,6 +30,7 @@ class ShaderSource;
 class Style;
 class Tile;
 class TileSource;
+class TriangulationCache;
 class VertexLayout;
 class View;
 struct DrawRule;
@@ -68,6 +74,36 @@ struct StyledMesh {
     virtual bool draw(RenderState& rs, ShaderProgram& _shader, bool _useVao = true) = 0;
     virtual size_t bufferSize() const = 0;
 
+    // Upload the mesh unless it is uploaded already; returns the number of bytes uploaded
+    virtual size_t uploadPending(RenderState& rs) { return 0; }
+
+    // Append data to restore this mesh from to @_out, see CompiledMesh; returns false
+    // if the mesh cannot be stored, e.g. for labels or meshes uploaded already
+    virtual bool serialize(std::vector<char>& _out) const { return false; }
+
+    // Estimated vertex shader invocations to draw this mesh once, e.g. for benchmarks
+    virtual size_t vertexInvocations() const { return 0; }
+
+    // Number of vertices of the mesh, e.g. for benchmarks
+    virtual size_t vertexCount() const { return 0; }
+
+    // Skip parts of the mesh outside of the view frustum of @_mvp in the next draws, for
+    // meshes split into chunks; @_elevation raises their bounds by terrain (min, max)
+    virtual void cullChunks(const glm::mat4& _mvp, glm::vec2 _elevation) {}
+    virtual void showAllChunks() {}
+    // Also skip chunks within @_cells of the chunk grid, see MeshBase::hideCoveredChunks()
+    virtual void hideCoveredChunks(uint16_t _cells) {}
+
+    // Whether the feature selection pass draws this mesh; false for meshes compiled
+    // without selection colors
+    virtual bool selectable() const { return true; }
+
+    // Table of the colors of the features, for meshes drawn with a FeatureTable
+    virtual FeatureTable* featureTable() const { return nullptr; }
+
+    // Whether the mesh can be drawn again after the GL context is lost, see MeshBase::restorable()
+    virtual bool restorable() const { return true; }
+
     virtual ~StyledMesh() {}
 };
 
@@ -86,10 +122,10 @@ public:
     virtual bool addPoint(const Point& _point, const Properties& _props, const DrawRule& _rule);
 
     /* Build styled vertex data for line geometry */
-    virtual bool addLine(const Line& _line, const Properties& _props, const DrawRule& _rule);
+    virtual bool addLine(LineView _line, const Properties& _props, const DrawRule& _rule);
 
     /* Build styled vertex data for polygon geometry */
-    virtual bool addPolygon(const Polygon& _polygon, const Properties& _props, const DrawRule& _rule);
+    virtual bool addPolygon(PolygonView _polygon, const Properties& _props, const DrawRule& _rule);
 
     /* Create a new mesh object using the vertex layout corresponding to this style */
     virtual std::unique_ptr<StyledMesh> build() = 0;
@@ -101,6 +137,37 @@ public:
     virtual void addSelectionItems(LabelCollider& _layout) {}
 
     virtual const Style& style() const = 0;
+
+    /* Tolerance in tile units for simplifying line and polygon geometry before it is built,
+     * 0 to build it as is; set for each data layer by TileBuilder */
+    void setSimplifyTolerance(float _tolerance) { m_simplifier.setTolerance(_tolerance); }
+
+    /* Margin in tile units beyond the tile edges that geometry is clipped to before it is
+     * built, negative to build it as is; set for each tile by TileBuilder */
+    void setClipMargin(float _margin) { m_clipper.setMargin(_margin); }
+
+    /* Build less detail of costly geometry, e.g. of extrusions, for a tile far from the camera;
+     * set for each tile by TileBuilder. coarseBuilt() tells whether any detail was left out. */
+    void setCoarse(bool _coarse) {
+        m_coarse = _coarse;
+        m_coarseBuilt = false;
+    }
+    bool coarseBuilt() const { return m_coarseBuilt; }
+
+    /* Triangulations of polygons kept across builds, shared by the TileBuilders of a TileWorker;
+     * may be null */
+    void setTriangulationCache(TriangulationCache* _cache) { m_triangulationCache = _cache; }
+
+protected:
+
+    GeometrySimplifier m_simplifier;
+
+    GeometryClipper m_clipper;
+
+    bool m_coarse = false;
+    bool m_coarseBuilt = false;
+
+    TriangulationCache* m_triangulationCache = nullptr;
 };
 
 /* Means of constructing and rendering map geometry
@@ -133,9 +200,17 @@ protected:
 
     std::shared_ptr<ShaderProgram> m_selectionProgram;
 
+    /* Program writing only the depth of the meshes, for the depth pre-pass, see setDepthPrepass() */
+    std::shared_ptr<ShaderProgram> m_depthProgram;
+
     /* <VertexLayout> shared between meshes using this style */
     std::shared_ptr<VertexLayout> m_vertexLayout;
 
+    /* Layouts of compiled meshes, when they leave out attributes of m_vertexLayout which are
+     * not read; see meshLayout() */
+    std::shared_ptr<VertexLayout> m_meshLayout;
+    std::shared_ptr<VertexLayout> m_selectableMeshLayout;
+
     /* Stores default style draw rules*/
     std::unique_ptr<DrawRuleData> m_defaultDrawRule = nullptr;
 
@@ -156,8 +231,23 @@ protected:
 
     bool m_hasColorShaderBlock = false;
 
+    /* Whether shader programs are created in build() rather than on first draw */
+    bool m_eager = false;
+
+    bool m_depthPrepass = false;
+
+    /* Scene of the last build(), for sharing shader programs with its styles */
+    const Scene* m_scene = nullptr;
+
     RasterType m_rasterType = RasterType::none;
 
+    /* Most rasters of the tiles drawn by this style, from the sources of the layers using it;
+     * -1 when not known. See setUsedRasters() */
+    int m_usedRasters = -1;
+
+    /* Size of the raster arrays of the shader programs, set by build() */
+    int m_numRasters = 0;
+
     bool m_selection;
 
     StyleType m_type = StyleType::none;
@@ -177,12 +267,17 @@ protected:
         UniformLocation uModel{"u_model"};
         UniformLocation uTileOrigin{"u_tile_origin"};
         UniformLocation uProxyDepth{"u_proxy_depth"};
+        UniformLocation uLineTrim{"u_line_trim"};
+        // Feature table uniforms
+        UniformLocation uFeatureTable{"u_feature_table"};
+        UniformLocation uFeatureTableSize{"u_feature_table_size"};
         UniformLocation uRasters{"u_rasters"};
         UniformLocation uRasterSizes{"u_raster_sizes"};
         UniformLocation uRasterOffsets{"u_raster_offsets"};
+        UniformLocation uRasterLayers{"u_raster_layers"};
 
         std::vector<StyleUniform> styleUniforms;
-    } m_mainUniforms, m_selectionUniforms;
+    } m_mainUniforms, m_selectionUniforms, m_depthUniforms;
 
     /* Set uniform values when @_updateUniforms is true,
      */
@@ -194,6 +289,24 @@ protected:
     void setupTileShaderUniforms(RenderState& rs, const Tile& _tile,
                                  ShaderProgram& _program, UniformBlock& _uniformBlock);
 
+    /* Skip the chunks of the mesh of @_tile outside of the view when it is tilted, see
+     * MeshBase::cullChunks()
+     */
+    void cullTileChunks(const View& _view, const Tile& _tile);
+
+    /* Likewise for the mesh of a marker, at any pitch as markers like routes may reach far
+     * beyond the view
+     */
+    void cullMarkerChunks(const View& _view, const Marker& _marker);
+
+    /* Draw the depth of the mesh of @_tile with m_depthProgram */
+    void drawDepth(RenderState& rs, const Tile& _tile);
+
+    /* Bind the feature table of @_mesh, if any, for drawing it with @_program, after applying
+     * the feature states of source @_sourceId (none for markers, -1) */
+    void setupFeatureTable(RenderState& rs, const StyledMesh& _mesh, int32_t _sourceId,
+                           ShaderProgram& _program, UniformBlock& _uniformBlock);
+
     struct LightHandle {
         LightHandle(Light* _light, std::unique_ptr<LightUniforms> _uniforms);
         Light *light;
@@ -208,6 +321,19 @@ protected:
     };
 
     std::vector<LightHandle> m_lights;
+
+    // Tiles drawn in the current frame, see draw()
+    std::vector<const Tile*> m_drawTiles;
+    // Clip space depth of the center of each tile to draw, for drawing opaque styles front to back
+    std::vector<std::pair<float, const Tile*>> m_tileDepths;
+
+    // Raster uniforms of the current tile, see setupTileShaderUniforms()
+    struct {
+        UniformTextureArray textureIndex;
+        UniformArray2f sizes;
+        UniformArray3f offsets;
+        UniformArray1f layers;
+    } m_rasterUniforms;
     MaterialHandle m_material;
 
 public:
@@ -216,7 +342,7 @@ public:
 
     virtual ~Style();
 
-    StyleType type() { return m_type; }
+    StyleType type() const { return m_type; }
 
     static bool compare(std::unique_ptr<Style>& a, std::unique_ptr<Style>& b) {
 
@@ -245,11 +371,25 @@ public:
     void setBlendOrder(int _blendOrder) { m_blendOrder = _blendOrder; }
 
     /* Whether or not the style is animated */
-    bool isAnimated() { return m_animated; }
+    bool isAnimated() const { return m_animated; }
 
-    /* Make this style ready to be used (call after all needed properties are set) */
+    /* Draw the depth of the tiles of an opaque style with a trivial fragment shader before drawing
+     * them, so that the lighting and material of the fragment shader is only evaluated for visible
+     * fragments. Ignored for styles with color, filter or raster shader blocks, which may discard
+     * fragments. Set before build(). */
+    void setDepthPrepass(bool _prepass) { m_depthPrepass = _prepass; }
+    bool depthPrepass() const { return m_depthPrepass; }
+
+    /* Make this style ready to be used (call after all needed properties are set). Shader
+     * programs are only created when the style is first drawn, unless it is eager.
+     */
     virtual void build(const Scene& _scene);
 
+    /* Create the shader programs from the shader source of build(); does nothing when
+     * they already exist
+     */
+    virtual void buildProgram();
+
     virtual void onBeginUpdate() {}
 
     virtual void onBeginFrame(RenderState& rs) {}
@@ -286,6 +426,12 @@ public:
                       const std::vector<std::shared_ptr<Tile>>& _tiles,
                       const std::vector<std::unique_ptr<Marker>>& _markers);
 
+    /* Draws @_tiles, which all have an uploaded mesh of this style, in the given order and
+     * then the markers of this style; see RenderQueue
+     */
+    bool draw(RenderState& rs, const View& _view, const std::vector<const Tile*>& _tiles,
+              const std::vector<std::unique_ptr<Marker>>& _markers);
+
     void drawSelectionFrame(RenderState& rs, const View& _view,
                             const std::vector<std::shared_ptr<Tile>>& _tiles,
                             const std::vector<std::unique_ptr<Marker>>& _markers);
@@ -298,10 +444,16 @@ public:
 
     void setAnimated(bool _animated) { m_animated = _animated; }
 
+    void setEager(bool _eager) { m_eager = _eager; }
+
     virtual void setPixelScale(float _pixelScale) { m_pixelScale = _pixelScale; }
 
     void setRasterType(RasterType _rasterType) { m_rasterType = _rasterType; }
 
+    /* Set by the Scene before build(), so that programs of built-in raster types only declare
+     * the samplers the tiles of this style can have */
+    void setUsedRasters(int _count) { m_usedRasters = _count; }
+
     void setTexCoordsGeneration(bool _texCoordsGeneration) { m_texCoordsGeneration = _texCoordsGeneration; }
 
     bool genTexCoords() const { return m_texCoordsGeneration; }
@@ -315,6 +467,9 @@ public:
     const std::string& getName() const { return m_name; }
     const uint32_t& getID() const { return m_id; }
 
+    // Null until the programs are built, see buildProgram()
+    const ShaderProgram* shaderProgram() const { return m_shaderProgram.get(); }
+
     virtual size_t dynamicMeshSize() const { return 0; }
 
     virtual bool hasRasters() const { return m_rasterType != RasterType::none; }
@@ -322,6 +477,7 @@ public:
     std::vector<StyleUniform>& styleUniforms() { return m_mainUniforms.styleUniforms; }
 
     void setDefaultDrawRule(std::unique_ptr<DrawRuleData>&& _rule);
+    const DrawRuleData* defaultDrawRule() const { return m_defaultDrawRule.get(); }
     void applyDefaultDrawRules(DrawRule& _rule) const;
 
     virtual std::unique_ptr<StyleBuilder> createBuilder() const = 0;
@@ -330,6 +486,14 @@ public:
     float pixelScale() const { return m_pixelScale; }
     const auto& vertexLayout() const { return m_vertexLayout; }
 
+    /* Layout of the vertices of compiled meshes, the vertex layout without the attributes which
+     * the style does not read; without selection colors unless @_selectable, i.e. when the
+     * mesh has selectable features. The shader programs are linked with the vertex layout. */
+    const std::shared_ptr<VertexLayout>& meshLayout(bool _selectable) const {
+        const auto& layout = _selectable ? m_selectableMeshLayout : m_meshLayout;
+        return layout ? layout : m_vertexLayout;
+    }
+
     bool hasColorShaderBlock() const { return m_hasColorShaderBlock; }
 
 };
@@ -249,7 +249,7 @@ bool TextStyleBuilder::handleBoundaryLabel(const Feature& _feat, const DrawRule&
     };
 
     bool added = false;
-    for (auto& line : _feat.lines) {
+    for (auto line : _feat.lines()) {
         added |= addStraightTextLabels(line, labelWidth, onAddLabel);
     }
 
@@ -282,14 +282,13 @@ bool TextStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
         if (!prepareLabel(params, labelType, attrib)) { return false; }
 
         if (_feat.geometryType == GeometryType::points) {
-            for (auto& point : _feat.points) {
+            for (auto& point : _feat.points()) {
                 auto p = glm::vec2(point);
                 addLabel(Label::Type::point, {{ p }}, params, attrib, _rule);
             }
 
         } else if (_feat.geometryType == GeometryType::polygons) {
-            const auto& polygons = _feat.polygons;
-            for (const auto& polygon : polygons) {
+            for (auto polygon : _feat.polygons()) {
                 if (!polygon.empty()) {
                     glm::vec2 c;
                     c = centroid(polygon.front().begin(), polygon.front().end());
@@ -311,7 +310,7 @@ bool TextStyleBuilder::addFeature(const Feature& _feat, const DrawRule& _rule) {
 
 #define TANGRAM_NEW_STRAIGHT_LABELS
 
-bool TextStyleBuilder::addStraightTextLabels(const Line& _line, float _labelWidth,
+bool TextStyleBuilder::addStraightTextLabels(LineView _line, float _labelWidth,
                                              const std::function<void(glm::vec2,glm::vec2)>& _onAddLabel) {
 
     // Size of pixel in tile coordinates
@@ -399,7 +398,7 @@ bool TextStyleBuilder::addStraightTextLabels(const Line& _line, float _labelWidt
 
 //#define TANGRAM_NEW_CURVED_LABELS
 
-void TextStyleBuilder::addCurvedTextLabels(const Line& _line, const TextStyle::Parameters& _params,
+void TextStyleBuilder::addCurvedTextLabels(LineView _line, const TextStyle::Parameters& _params,
                                            const LabelAttributes& _attributes, const DrawRule& _rule) {
 
     // Size of pixel in tile coordinates
@@ -589,7 +588,7 @@ void TextStyleBuilder::addLineTextLabels(const Feature& _feat, const TextStyle::
         addLabel(Label::Type::line, {{ a, b }}, _params, _attributes, _rule);
     };
 
-    for (auto& line : _feat.lines) {
+    for (auto line : _feat.lines()) {
 
         if (!addStraightTextLabels(line, _attributes.width, straightLabelCb) &&
             line.size() > 2 && !_params.hasComplexShaping &&
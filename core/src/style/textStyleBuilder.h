@@ -48,10 +48,10 @@ public:
     void addLineTextLabels(const Feature& _feature, const TextStyle::Parameters& _params,
                            const LabelAttributes& _attributes, const DrawRule& _rule);
 
-    bool addStraightTextLabels(const Line& _feature, float _labelWidth,
+    bool addStraightTextLabels(LineView _feature, float _labelWidth,
                                const std::function<void(glm::vec2,glm::vec2)>& _onAddLabel);
 
-    void addCurvedTextLabels(const Line& _feature, const TextStyle::Parameters& _params,
+    void addCurvedTextLabels(LineView _feature, const TextStyle::Parameters& _params,
                              const LabelAttributes& _attributes, const DrawRule& _rule);
 
     bool handleBoundaryLabel(const Feature& _feat, const DrawRule& _rule,
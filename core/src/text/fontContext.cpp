@@ -7,7 +7,7 @@
 #include "log.h"
 #include "platform.h"
 
-#define SDF_IMPLEMENTATION
+// sdfBuildDistanceField() is compiled with gl/texture.cpp
 #include "sdf.h"
 
 #include <memory>
@@ -21,7 +21,7 @@ namespace Tangram {
 
 const std::vector<float> FontContext::s_fontRasterSizes = { 16, 28, 40 };
 
-FontContext::FontContext(Platform& _platform) :
+FontContext::FontContext(Platform& _platform, uint32_t) :
     m_sdfRadius(SDF_WIDTH),
     m_atlas(*this, GlyphTexture::size, m_sdfRadius),
     m_batch(m_atlas, m_scratch),
@@ -141,11 +141,61 @@ void FontContext::bindTexture(RenderState& rs, AtlasID _id, GLuint _unit) {
     m_textures[_id]->bind(rs, _unit);
 }
 
+bool FontContext::addCachedLayout(const TextLayoutCache::Key& _key, std::vector<GlyphQuad>& _quads,
+                                  std::bitset<max_textures>& _refs, glm::vec2& _size, TextRange& _textRanges) {
+
+    auto layout = m_layoutCache.get(_key);
+    if (!layout) { return false; }
+
+    std::lock_guard<std::mutex> lock(m_textureMutex);
+
+    for (auto& atlas : layout->atlases) {
+        if (m_atlasGeneration[atlas.first] != atlas.second) { return false; }
+    }
+    for (auto& atlas : layout->atlases) {
+        if (!_refs[atlas.first]) {
+            _refs[atlas.first] = true;
+            m_atlasRefCount[atlas.first] += 1;
+        }
+    }
+    TextLayoutCache::appendLayout(*layout, _quads, _textRanges, _size);
+    return true;
+}
+
 bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
                              std::vector<GlyphQuad>& _quads, std::bitset<max_textures>& _refs,
                              glm::vec2& _size, TextRange& _textRanges) {
 
-    std::lock_guard<std::mutex> lock(m_fontMutex);
+    std::array<bool, 3> alignments = {};
+    if (_params.align != TextLabelProperty::Align::none) {
+        alignments[int(_params.align)] = true;
+    }
+
+    // Collect possible alignment from anchor fallbacks
+    for (int i = 0; i < _params.labelOptions.anchors.count; i++) {
+        auto anchor = _params.labelOptions.anchors[i];
+        TextLabelProperty::Align alignment = TextLabelProperty::alignFromAnchor(anchor);
+        if (alignment != TextLabelProperty::Align::none) {
+            alignments[int(alignment)] = true;
+        }
+    }
+
+    TextLayoutCache::Key key;
+    _text.toUTF8String(key.text);
+    key.font = uintptr_t(_params.font.get());
+    key.fontScale = _params.fontScale;
+    key.lineSpacing = _params.lineSpacing;
+    key.maxLines = _params.maxLines;
+    key.maxLineWidth = _params.maxLineWidth;
+    key.wordWrap = _params.wordWrap;
+    if (_params.wordWrap) {
+        key.alignments = alignments[0] | alignments[1] << 1 | alignments[2] << 2;
+    }
+
+    // Repeated texts skip shaping and line breaking, without waiting for m_fontMutex
+    if (addCachedLayout(key, _quads, _refs, _size, _textRanges)) { return true; }
+
+    auto lock = lockTimed(m_fontMutex, m_layoutLocks);
 
     alfons::LineLayout line = m_shaper.shapeICU(_params.font, _text, MIN_LINE_WIDTH,
                                                 _params.wordWrap ? _params.maxLineWidth : 0);
@@ -165,20 +215,6 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
     size_t quadsStart = _quads.size();
     alfons::LineMetrics metrics;
 
-    std::array<bool, 3> alignments = {};
-    if (_params.align != TextLabelProperty::Align::none) {
-        alignments[int(_params.align)] = true;
-    }
-
-    // Collect possible alignment from anchor fallbacks
-    for (int i = 0; i < _params.labelOptions.anchors.count; i++) {
-        auto anchor = _params.labelOptions.anchors[i];
-        TextLabelProperty::Align alignment = TextLabelProperty::alignFromAnchor(anchor);
-        if (alignment != TextLabelProperty::Align::none) {
-            alignments[int(alignment)] = true;
-        }
-    }
-
     if (_params.wordWrap) {
         m_textWrapper.clearWraps();
 
@@ -253,7 +289,7 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
                      (metrics.aabb.y + height * 0.5) * TextVertex::position_scale);
 
     {
-        std::lock_guard<std::mutex> lock(m_textureMutex);
+        auto lock = lockTimed(m_textureMutex, m_layoutLocks);
         for (; it != _quads.end(); ++it) {
 
             if (!_refs[it->atlas]) {
@@ -267,9 +303,14 @@ bool FontContext::layoutText(TextStyle::Parameters& _params, const icu::UnicodeS
             it->quad[3].pos -= offset;
         }
 
+        auto layout = TextLayoutCache::makeLayout(_quads, quadsStart, _textRanges, _size);
+        for (auto& atlas : layout->atlases) { atlas.second = m_atlasGeneration[atlas.first]; }
+        m_layoutCache.put(key, std::move(layout));
+
         // Clear unused textures
         for (size_t i = 0; i < m_textures.size(); i++) {
             if (m_atlasRefCount[i] == 0) {
+                m_atlasGeneration[i]++;
                 m_atlas.clear(i);
                 std::memset(m_textures[i]->buffer(), 0, GlyphTexture::size * GlyphTexture::size);
             }
@@ -301,6 +342,7 @@ void FontContext::releaseFonts() {
     std::lock_guard<std::mutex> lock(m_fontMutex);
     // Unload Freetype and Harfbuzz resources for all font faces
     m_alfons.unload();
+    m_layoutCache.clear();
 }
 
 void FontContext::ScratchBuffer::drawGlyph(const alfons::Rect& q, const alfons::AtlasGlyph& atlasGlyph) {
@@ -349,10 +391,10 @@ std::shared_ptr<alfons::Font> FontContext::getFont(const std::string& _family, c
             break;
         case FontSourceHandle::FontLoader:
         {
-            auto& loader = systemFontHandle.fontLoader;
-            auto fontData = loader();
+            // Keep the data read here instead of having the loader read the font a second time
+            auto fontData = systemFontHandle.fontLoader();
             if (fontData.size() > 0) {
-                source = alfons::InputSource(loader);
+                source = alfons::InputSource(std::move(fontData));
             } else {
                 useFallbackFont = true;
             }
@@ -7,8 +7,10 @@
 #include "gl/glyphTexture.h"
 #include "labels/textLabel.h"
 #include "style/textStyle.h"
+#include "text/textLayoutCache.h"
 #include "text/textUtil.h"
 #include "util/fontDescription.h"
+#include "util/lockStats.h"
 
 #include "alfons/alfons.h"
 #include "alfons/atlas.h"
@@ -32,11 +34,15 @@ public:
     using AtlasID = alfons::AtlasID;
     static constexpr int max_textures = 64;
 
-    FontContext(Platform& _platform);
+    // Layout contexts are specific to the fontstash backend
+    FontContext(Platform& _platform, uint32_t _numLayoutContexts = 1);
     virtual ~FontContext() {}
 
     void loadFonts(const std::vector<FontSourceHandle>& fallbacks);
 
+    // Glyph packs are specific to the fontstash backend
+    void loadGlyphPacks(const std::vector<FontSourceHandle>& _packs) {}
+
     /* Synchronized on m_mutex on tile-worker threads
      * Called from alfons when a texture atlas needs to be created
      * Triggered from TextStyleBuilder::prepareLabel
@@ -65,6 +71,12 @@ public:
 
     void bindTexture(RenderState& rs, AtlasID _id, GLuint _unit);
 
+    /* Atlases are cleared when no label uses them, glyphs never move on to a new atlas */
+    bool takeRetiredAtlas() { return false; }
+
+    /* Almost no texture is left for new glyphs; all labels and fonts have to be released */
+    bool atlasExhausted() { return glyphTextureCount() > max_textures - 2; }
+
     float maxStrokeWidth() { return m_sdfRadius; }
 
     bool layoutText(TextStyle::Parameters& _params, const icu::UnicodeString& _text,
@@ -83,8 +95,15 @@ public:
 
     void releaseFonts();
 
+    /* Time tile workers waited for the font and texture locks in layoutText() */
+    const LockStats& layoutLockStats() const { return m_layoutLocks; }
+
 private:
 
+    // Add a cached layout of @_key unless its atlases were cleared; locks m_textureMutex
+    bool addCachedLayout(const TextLayoutCache::Key& _key, std::vector<GlyphQuad>& _quads,
+                         std::bitset<max_textures>& _refs, glm::vec2& _size, TextRange& _textRanges);
+
     static const std::vector<float> s_fontRasterSizes;
 
     float m_sdfRadius;
@@ -93,10 +112,15 @@ private:
 
     std::mutex m_fontMutex;
     std::mutex m_textureMutex;
+    LockStats m_layoutLocks;
 
     std::array<int, max_textures> m_atlasRefCount = {{0}};
+    // Bumped when the glyphs of an atlas are cleared, see TextLayoutCache
+    std::array<uint32_t, max_textures> m_atlasGeneration = {{0}};
     alfons::GlyphAtlas m_atlas;
 
+    TextLayoutCache m_layoutCache;
+
     alfons::FontManager m_alfons;
     std::array<std::shared_ptr<alfons::Font>, 3> m_font;
 
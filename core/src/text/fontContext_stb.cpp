@@ -2,6 +2,8 @@
 
 #include "log.h"
 #include "platform.h"
+#include <atomic>
+#include <fstream>
 #include <memory>
 #ifdef FONS_WPATH
 #include <codecvt>
@@ -28,30 +30,62 @@ FONScontext* userCreateFontstash(FONSparams* params, int atlasFontPx);
 
 constexpr int atlasFontPx = 32;  // should be roughly 2x max font size (em size) used
 
-FontContext::FontContext(Platform& _platform) : m_sdfRadius(SDF_WIDTH), m_platform(_platform) {
+FontContext::FontContext(Platform& _platform, uint32_t _numLayoutContexts)
+    : m_sdfRadius(SDF_WIDTH), m_platform(_platform) {
+
+    size_t numContexts = std::min(std::max(_numLayoutContexts, 1u), uint32_t(max_layout_contexts));
+    m_maxContextPages = std::max<size_t>(max_atlas_pages / numContexts, 2);
+
+    GlyphPack::Params sdfParams = glyphPackParams();
     FONSparams params;
     memset(&params, 0, sizeof(FONSparams));
     params.flags = FONS_SDF | FONS_ZERO_TOPLEFT;  //FONS_DELAY_LOAD;
-    params.sdfPadding = SDF_WIDTH * 2;  // assumes pixel scale = 2
-    params.sdfPixelDist = 128.0f/SDF_WIDTH/2;  // assumes pixel scale = 2
+    params.sdfPadding = sdfParams.sdfPadding;
+    params.sdfPixelDist = sdfParams.sdfPixelDist;
     params.atlasBlockHeight = GlyphTexture::size;
     params.notDefCodePt = 0xFE56;  // small '?' - default notdef glyph is too prominent
+    params.userPtr = this;
+    params.userGlyphSDF = &FontContext::packedGlyphSDF;
+
+    for (size_t i = 0; i < numContexts; i++) {
+        auto ctx = std::make_unique<LayoutContext>();
 #ifdef TANGRAM_USER_FONTSTASH
-    m_fons = userCreateFontstash(&params, atlasFontPx);
+        ctx->fons = userCreateFontstash(&params, atlasFontPx);
 #else
-    m_fons = fonsCreateInternal(&params);
+        ctx->fons = fonsCreateInternal(&params);
 #endif
-    fonsResetAtlas(m_fons, GlyphTexture::size, GlyphTexture::size, atlasFontPx);
-    m_textures.push_back(std::make_unique<GlyphTexture>());
+        fonsResetAtlas(ctx->fons, GlyphTexture::size, GlyphTexture::size, atlasFontPx);
+        ctx->pages.push_back(allocTexture());
+        m_layouts.push_back(std::move(ctx));
+    }
 }
 
 FontContext::~FontContext() {
     //std::lock_guard<std::mutex> lock(m_fontMutex);
-    fonsDeleteInternal(m_fons);
-    m_fons = NULL;
+    for (auto& ctx : m_layouts) {
+        fonsDeleteInternal(ctx->fons);
+        ctx->fons = NULL;
+    }
     m_sources.clear();
 }
 
+GlyphPack::Params FontContext::glyphPackParams() {
+    GlyphPack::Params params;
+    params.atlasFontPx = atlasFontPx;
+    params.sdfPadding = SDF_WIDTH * 2;  // assumes pixel scale = 2
+    params.sdfPixelDist = 128.0f/SDF_WIDTH/2;  // assumes pixel scale = 2
+    return params;
+}
+
+FontContext::LayoutContext& FontContext::layoutContext() {
+    // Each thread sticks to one context, so that workers do not wait on each other and find
+    // the glyphs they rasterized before
+    static std::atomic<uint32_t> s_nextThread{0};
+    thread_local uint32_t t_thread = s_nextThread++;
+
+    return *m_layouts[t_thread % m_layouts.size()];
+}
+
 void FontContext::setPixelScale(float _scale) {
     m_sdfRadius = SDF_WIDTH * _scale;
 }
@@ -69,7 +103,10 @@ void FontContext::loadFonts(const std::vector<FontSourceHandle>& fallbacks) {
         if (fontid < 0) {
             LOGW("Error loading fallback font %s", fallback.fontPath.string().c_str());
         } else {
-            fonsAddFallbackFont(m_fons, -1, fontid);  // add as global fallback
+            for (auto& ctx : m_layouts) {
+                std::lock_guard<std::mutex> lock(ctx->mutex);
+                fonsAddFallbackFont(ctx->fons, -1, fontid);  // add as global fallback
+            }
             ++nadded;
         }
     }
@@ -78,33 +115,82 @@ void FontContext::loadFonts(const std::vector<FontSourceHandle>& fallbacks) {
     }
 }
 
+void FontContext::loadGlyphPacks(const std::vector<FontSourceHandle>& _packs) {
+
+    for (const auto& source : _packs) {
+        std::unique_ptr<GlyphPack> pack;
+        if (source.tag == FontSourceHandle::FontPath) {
+            pack = GlyphPack::open(source.fontPath.string());
+        } else if (source.tag == FontSourceHandle::FontLoader) {
+            pack = GlyphPack::fromData(source.fontLoader());
+        }
+        if (!pack) { continue; }
+
+        if (!(pack->params() == glyphPackParams())) {
+            LOGW("Glyph pack was built for another glyph atlas, size %d", pack->params().atlasFontPx);
+            continue;
+        }
+        LOGD("Loaded glyph pack with %d glyphs", int(pack->glyphCount()));
+
+        std::lock_guard<std::mutex> lock(m_packMutex);
+        m_glyphPacks.push_back(std::move(pack));
+    }
+}
+
+int FontContext::packedGlyphSDF(void* _userPtr, void* _fontImpl, unsigned char* _output,
+                                int _width, int _height, int _stride, int _glyph) {
+
+    auto* self = static_cast<FontContext*>(_userPtr);
+    std::lock_guard<std::mutex> lock(self->m_packMutex);
+    if (self->m_glyphPacks.empty()) { return 0; }
+
+    auto font = self->m_fontNames.find(_fontImpl);
+    if (font == self->m_fontNames.end()) { return 0; }
+
+    for (auto& pack : self->m_glyphPacks) {
+        if (pack->glyph(font->second, _glyph, _width, _height, _output, _stride)) { return 1; }
+    }
+    return 0;
+}
+
 void FontContext::releaseFonts()
 {
   std::lock_guard<std::mutex> fontlock(m_fontMutex);
+  std::vector<std::unique_lock<std::mutex>> ctxlocks;
+  for (auto& ctx : m_layouts) { ctxlocks.emplace_back(ctx->mutex); }
   std::lock_guard<std::mutex> texlock(m_textureMutex);
-  fonsResetAtlas(m_fons, GlyphTexture::size, GlyphTexture::size, atlasFontPx);
+
   m_textures.clear();
-  m_textures.push_back(std::make_unique<GlyphTexture>());
+  for (auto& ctx : m_layouts) {
+    fonsResetAtlas(ctx->fons, GlyphTexture::size, GlyphTexture::size, atlasFontPx);
+    ctx->pages.assign(1, allocTexture());
+  }
+  m_retired.reset();
+  m_atlasRetired = false;
+  m_atlasExhausted = false;
   m_atlasRefCount = {{0}};
+  for (auto& generation : m_atlasGeneration) { generation++; }
+  m_layoutCache.clear();
 }
 
-void FontContext::flushTextTexture() {
+void FontContext::flushTextTexture(LayoutContext& _ctx) {
     if(m_textures.empty()) return;
     int dirty[4];
-    if (!fonsValidateTexture(m_fons, dirty)) return;
+    if (!fonsValidateTexture(_ctx.fons, dirty)) return;
     int iw, ih;
-    auto fonsData = (const unsigned char*)fonsGetTextureData(m_fons, &iw, &ih);
+    auto fonsData = (const unsigned char*)fonsGetTextureData(_ctx.fons, &iw, &ih);
     int y0 = dirty[1], y1 = dirty[3];
     int blockh = GlyphTexture::size;
     int firsttex = y0/blockh, lasttex = (y1 - 1)/blockh;
     for(int texidx = firsttex; texidx <= lasttex; ++texidx) {
         int y0tex = std::max(0, y0 - blockh*texidx);
         int y1tex = std::min(y1 - blockh*texidx, blockh);
-        unsigned char* texData = m_textures[texidx]->buffer();
+        auto& texture = m_textures[_ctx.pages[texidx]];
+        unsigned char* texData = texture->buffer();
         unsigned char* dst = &texData[iw*y0tex];
         const unsigned char* src = &fonsData[iw*y0tex + iw*blockh*texidx];
         std::memcpy(dst, src, iw*(y1tex - y0tex));
-        m_textures[texidx]->setRowsDirty(y0tex, (y1tex - y0tex));
+        texture->setRowsDirty(y0tex, (y1tex - y0tex));
     }
 }
 
@@ -117,39 +203,102 @@ void FontContext::releaseAtlas(std::bitset<max_textures> _refs) {
     }
 }
 
+void FontContext::freeRetiredPages() {
+    for (size_t i = 0; i < m_textures.size(); i++) {
+        if (m_retired[i] && m_atlasRefCount[i] == 0) {
+            m_textures[i].reset();
+            m_retired[i] = false;
+            m_atlasGeneration[i]++;
+        }
+    }
+}
+
+bool FontContext::takeRetiredAtlas() {
+    std::lock_guard<std::mutex> lock(m_textureMutex);
+    bool retired = m_atlasRetired;
+    m_atlasRetired = false;
+    return retired;
+}
+
 // if using multiple mutexs, they must always be locked (and released) in the same order - we choose
-//  fontMutex then textureMutex
+//  fontMutex, then the layout contexts in order, then textureMutex
 void FontContext::updateTextures(RenderState& rs) {
-    std::lock_guard<std::mutex> fontlock(m_fontMutex);  // needed for flushTextTexture()
+    // needed for flushTextTexture()
+    std::vector<std::unique_lock<std::mutex>> ctxlocks;
+    for (auto& ctx : m_layouts) { ctxlocks.emplace_back(ctx->mutex); }
     std::lock_guard<std::mutex> texlock(m_textureMutex);
 
-    flushTextTexture();
-    for (auto& gt : m_textures) { gt->bind(rs, 0); }
+    for (auto& ctx : m_layouts) { flushTextTexture(*ctx); }
+    // Released here on the GL thread, where no layout is in progress
+    if (m_retired.any()) { freeRetiredPages(); }
+
+    for (auto& gt : m_textures) {
+        if (gt) { gt->bind(rs, 0); }
+    }
 }
 
 void FontContext::bindTexture(RenderState& rs, int _id, GLuint _unit) {
     std::lock_guard<std::mutex> lock(m_textureMutex);
 
-    m_textures[_id]->bind(rs, _unit);
+    if (m_textures[_id]) { m_textures[_id]->bind(rs, _unit); }
 }
 
-// Synchronized on m_fontMutex in layoutText(), called on tile-worker threads
-int FontContext::addTexture() {
-    std::lock_guard<std::mutex> lock(m_textureMutex);
-    if (m_textures.size() == max_textures) {
+int FontContext::allocTexture() {
+    size_t slot = 0;
+    while (slot < m_textures.size() && m_textures[slot]) { slot++; }
+
+    if (slot == max_textures) {
         LOGE("Way too many glyph textures!");
+        m_atlasExhausted = true;
         return -1;
     }
+    if (slot == m_textures.size()) { m_textures.emplace_back(); }
+
+    m_textures[slot] = std::make_unique<GlyphTexture>();
+    return int(slot);
+}
+
+void FontContext::retireAtlas(LayoutContext& _ctx) {
+    // Copy the last glyphs before fontstash drops them
+    flushTextTexture(_ctx);
+
+    for (size_t slot : _ctx.pages) {
+        m_retired[slot] = true;
+        // Cached layouts go to the new atlas
+        m_atlasGeneration[slot]++;
+    }
+    _ctx.pages.clear();
+    m_atlasRetired = true;
+
+    fonsResetAtlas(_ctx.fons, GlyphTexture::size, GlyphTexture::size, atlasFontPx);
+}
+
+// Synchronized on the mutex of @_ctx in layoutText(), called on tile-worker threads
+int FontContext::addTexture(LayoutContext& _ctx) {
+    std::lock_guard<std::mutex> lock(m_textureMutex);
+
+    // Instead of growing the atlas until it is exhausted, move on to a new one; the pages of the
+    // old atlas are kept until the labels using them are rebuilt
+    if (_ctx.pages.size() >= m_maxContextPages) {
+        retireAtlas(_ctx);
+
+        int slot = allocTexture();
+        if (slot >= 0) { _ctx.pages.push_back(slot); }
+        return slot;
+    }
+
+    int slot = allocTexture();
+    if (slot < 0) { return -1; }
     //flushTextTexture();  -- not necessary since we are just expanding texture
 
     int iw = GlyphTexture::size, ih = GlyphTexture::size;
-    m_textures.push_back(std::make_unique<GlyphTexture>());
-    fonsGetAtlasSize(m_fons, &iw, &ih, NULL);
-    fonsExpandAtlas(m_fons, iw, ih + GlyphTexture::size);
-    return m_textures.size() - 1;
+    _ctx.pages.push_back(slot);
+    fonsGetAtlasSize(_ctx.fons, &iw, &ih, NULL);
+    fonsExpandAtlas(_ctx.fons, iw, ih + GlyphTexture::size);
+    return slot;
 }
 
-bool FontContext::layoutLine(TextStyle::Parameters& _params, float x, float y,
+bool FontContext::layoutLine(LayoutContext& _ctx, TextStyle::Parameters& _params, float x, float y,
     const char* start, const char* end, std::vector<GlyphQuad>& _quads /*out*/) {
 
     if(start == end) return false;
@@ -159,18 +308,18 @@ bool FontContext::layoutLine(TextStyle::Parameters& _params, float x, float y,
     const float pos_scale = TextVertex::position_scale;
 
     int iw, ih;
-    fonsInitState(m_fons, &state);
+    fonsInitState(_ctx.fons, &state);
     fonsSetFont(&state, _params.font - 1);
     fonsSetSize(&state, fonsEmSizeToSize(&state, _params.fontSize));
     fonsSetBlur(&state, _params.strokeWidth);  // pads quads by strokeWidth
 
-    fonsGetAtlasSize(m_fons, &iw, &ih, NULL);
+    fonsGetAtlasSize(_ctx.fons, &iw, &ih, NULL);
     fonsTextIterInit(&state, &iter, x, y, start, end, FONS_GLYPH_BITMAP_REQUIRED);
     prevIter = iter;
     while (fonsTextIterNext(&state, &iter, &q)) {
         if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
-            if (addTexture() < 0) break;
-            fonsGetAtlasSize(m_fons, &iw, &ih, NULL);
+            if (addTexture(_ctx) < 0) break;
+            fonsGetAtlasSize(_ctx.fons, &iw, &ih, NULL);
             iter = prevIter;
             fonsTextIterNext(&state, &iter, &q); // try again
             if (iter.prevGlyphIndex == -1) break; // still can not find glyph?
@@ -181,9 +330,10 @@ bool FontContext::layoutLine(TextStyle::Parameters& _params, float x, float y,
         int x0 = int(q.x0 * pos_scale + 0.5f), y0 = int(q.y0 * pos_scale + 0.5f);
         int x1 = int(q.x1 * pos_scale + 0.5f), y1 = int(q.y1 * pos_scale + 0.5f);
         int texidx = int(q.t1*(ih/GlyphTexture::size));
+        size_t atlas = _ctx.pages[texidx];
         int s0 = int(q.s0 * iw), t0 = int(q.t0 * ih) - texidx*GlyphTexture::size;
         int s1 = int(q.s1 * iw), t1 = int(q.t1 * ih) - texidx*GlyphTexture::size;
-        _quads.push_back({size_t(texidx),
+        _quads.push_back({atlas,
                 {{{x0, y0}, {s0, t0}},
                  {{x0, y1}, {s0, t1}},
                  {{x1, y0}, {s1, t0}},
@@ -192,14 +342,14 @@ bool FontContext::layoutLine(TextStyle::Parameters& _params, float x, float y,
     return true;
 }
 
-int FontContext::layoutMultiline(TextStyle::Parameters& _params, const std::string& _text,
+int FontContext::layoutMultiline(LayoutContext& _ctx, TextStyle::Parameters& _params, const std::string& _text,
     TextLabelProperty::Align _align, std::vector<GlyphQuad>& _quads /*out*/) {
 
     FONSstate state;
     std::vector<FONStextRow> rows(_params.maxLines > 0 ? _params.maxLines : 10);
     const char* start = _text.c_str();
     const char* end = start + _text.size();
-    fonsInitState(m_fons, &state);
+    fonsInitState(_ctx.fons, &state);
     fonsSetFont(&state, _params.font - 1);
     fonsSetSize(&state, fonsEmSizeToSize(&state, _params.fontSize));
     // pass negative integer for line width to use max chars instead of max width
@@ -228,28 +378,44 @@ int FontContext::layoutMultiline(TextStyle::Parameters& _params, const std::stri
         if (ii == nrows - 1 && rows[ii].end < end) {
             std::string lastRow(rows[ii].start, rows[ii].end);
             lastRow.append("…");
-            layoutLine(_params, x, y, lastRow.c_str(), lastRow.c_str() + lastRow.size(), _quads);
+            layoutLine(_ctx, _params, x, y, lastRow.c_str(), lastRow.c_str() + lastRow.size(), _quads);
             break;
         }
 
-        layoutLine(_params, x, y, rows[ii].start, rows[ii].end, _quads);
+        layoutLine(_ctx, _params, x, y, rows[ii].start, rows[ii].end, _quads);
         // -miny is ascent above baseline; should we also add rows[ii].maxy?
         if (ii < nrows - 1) { y += -rows[ii+1].miny + _params.lineSpacing; }
     }
     return nrows;
 }
 
-bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::string& _text /*in*/,
-                             std::vector<GlyphQuad>& _quads /*out*/, std::bitset<max_textures>& _refs /*out*/,
-                             glm::vec2& _size /*out*/, TextRange& _textRanges /*out*/) {
+bool FontContext::addCachedLayout(const TextLayoutCache::Key& _key, std::vector<GlyphQuad>& _quads,
+                                  std::bitset<max_textures>& _refs, glm::vec2& _size, TextRange& _textRanges) {
 
-    std::lock_guard<std::mutex> fontlock(m_fontMutex);
+    auto layout = m_layoutCache.get(_key);
+    if (!layout) { return false; }
 
-    size_t quadsStart = _quads.size();
+    std::lock_guard<std::mutex> texlock(m_textureMutex);
 
-    if(_params.wordWrap) {
+    for (auto& atlas : layout->atlases) {
+        if (m_atlasGeneration[atlas.first] != atlas.second) { return false; }
+    }
+    for (auto& atlas : layout->atlases) {
+        if (!_refs[atlas.first]) {
+            _refs[atlas.first] = true;
+            m_atlasRefCount[atlas.first] += 1;
+        }
+    }
+    TextLayoutCache::appendLayout(*layout, _quads, _textRanges, _size);
+    return true;
+}
+
+bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::string& _text /*in*/,
+                             std::vector<GlyphQuad>& _quads /*out*/, std::bitset<max_textures>& _refs /*out*/,
+                             glm::vec2& _size /*out*/, TextRange& _textRanges /*out*/) {
 
-        std::array<bool, 3> alignments = {};
+    std::array<bool, 3> alignments = {};
+    if (_params.wordWrap) {
         if (_params.align != TextLabelProperty::Align::none) {
             alignments[int(_params.align)] = true;
         }
@@ -262,6 +428,28 @@ bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::s
                 alignments[int(alignment)] = true;
             }
         }
+    }
+
+    TextLayoutCache::Key key;
+    key.text = _text;
+    key.font = uintptr_t(_params.font);
+    key.fontSize = _params.fontSize;
+    key.strokeWidth = _params.strokeWidth;
+    key.lineSpacing = _params.lineSpacing;
+    key.maxLines = _params.maxLines;
+    key.maxLineWidth = _params.maxLineWidth;
+    key.wordWrap = _params.wordWrap;
+    key.alignments = alignments[0] | alignments[1] << 1 | alignments[2] << 2;
+
+    // Repeated texts skip the layout, without waiting for a layout context
+    if (addCachedLayout(key, _quads, _refs, _size, _textRanges)) { return true; }
+
+    auto& ctx = layoutContext();
+    auto ctxlock = lockTimed(ctx.mutex, m_layoutLocks);
+
+    size_t quadsStart = _quads.size();
+
+    if(_params.wordWrap) {
 
         // draw for each alternative alignment
         for (size_t i = 0; i < 3; i++) {
@@ -270,7 +458,7 @@ bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::s
                 _textRanges[i] = Range(rangeStart, 0);
                 continue;
             }
-            int numLines = layoutMultiline(_params, _text, TextLabelProperty::Align(i), _quads);
+            int numLines = layoutMultiline(ctx, _params, _text, TextLabelProperty::Align(i), _quads);
             int rangeEnd = _quads.size();
             _textRanges[i] = Range(rangeStart, rangeEnd - rangeStart);
             // For single line text alignments are the same
@@ -282,7 +470,7 @@ bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::s
         }
 
     } else {
-        layoutLine(_params, 0, 0, _text.c_str(), NULL, _quads);
+        layoutLine(ctx, _params, 0, 0, _text.c_str(), NULL, _quads);
         int rangeEnd = _quads.size();
         _textRanges[0] = Range(quadsStart, rangeEnd - quadsStart);
         _textRanges[1] = Range(rangeEnd, 0);
@@ -293,7 +481,7 @@ bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::s
         return false;  // no glyphs
 
     {
-        std::lock_guard<std::mutex> texlock(m_textureMutex);
+        auto texlock = lockTimed(m_textureMutex, m_layoutLocks);
 
         isect2d::AABB<glm::vec2> aabb;
         for (auto it = _quads.begin() + quadsStart; it != _quads.end(); ++it) {
@@ -321,6 +509,10 @@ bool FontContext::layoutText(TextStyle::Parameters& _params /*in*/, const std::s
             it->quad[3].pos -= offset;
         }
 
+        auto layout = TextLayoutCache::makeLayout(_quads, quadsStart, _textRanges, _size);
+        for (auto& atlas : layout->atlases) { atlas.second = m_atlasGeneration[atlas.first]; }
+        m_layoutCache.put(key, std::move(layout));
+
         // Clear unused textures
         //for (size_t i = 0; i < m_textures.size(); i++) {
         //    if (m_atlasRefCount[i] == 0) {
@@ -338,10 +530,26 @@ void FontContext::addFont(const FontDescription& _ft, std::vector<char>&& _sourc
     // NB: Synchronize for calls from download thread
     std::lock_guard<std::mutex> lock(m_fontMutex);
 
-    int font = fonsAddFontMem(m_fons, _ft.alias.c_str(), (unsigned char*)_source.data(), _source.size(), 0);
+    int font = addFontData(_ft.alias, std::move(_source));
     if (font < 0) { LOGW("Error adding font %s", _ft.alias.c_str()); }
-    // add _source to some list so it doesn't get freed
-    m_sources.push_back(std::move(_source));
+}
+
+int FontContext::addFontData(const std::string& _name, std::vector<char>&& _data) {
+    if (_data.empty()) { return -1; }
+
+    // Contexts share the data, kept in m_sources so it doesn't get freed; fonts get the same
+    // id in all contexts
+    int font = -1;
+    for (auto& ctx : m_layouts) {
+        std::lock_guard<std::mutex> lock(ctx->mutex);
+        font = fonsAddFontMem(ctx->fons, _name.c_str(), (unsigned char*)_data.data(), _data.size(), 0);
+        if (font >= 0) {
+            std::lock_guard<std::mutex> packLock(m_packMutex);
+            m_fontNames[fonsGetFontImpl(ctx->fons, font)] = _name;
+        }
+    }
+    m_sources.push_back(std::move(_data));
+    return font;
 }
 
 int FontContext::loadFontSource(const std::string& _name, const FontSourceHandle& _source)
@@ -349,18 +557,25 @@ int FontContext::loadFontSource(const std::string& _name, const FontSourceHandle
     if(_source.tag == FontSourceHandle::FontPath) {
 #ifdef FONS_WPATH
         static std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> cv;
-        return fonsAddFont(m_fons, _name.c_str(), (char*)cv.from_bytes(_source.fontPath.string()).data());
+        int font = -1;
+        for (auto& ctx : m_layouts) {
+            std::lock_guard<std::mutex> lock(ctx->mutex);
+            font = fonsAddFont(ctx->fons, _name.c_str(), (char*)cv.from_bytes(_source.fontPath.string()).data());
+            if (font >= 0) {
+                std::lock_guard<std::mutex> packLock(m_packMutex);
+                m_fontNames[fonsGetFontImpl(ctx->fons, font)] = _name;
+            }
+        }
+        return font;
 #else
-        return fonsAddFont(m_fons, _name.c_str(), _source.fontPath.string().c_str());
+        // Read once for all contexts
+        std::ifstream file(_source.fontPath.string(), std::ios::binary);
+        std::vector<char> fontData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return addFontData(_name, std::move(fontData));
 #endif
     }
     if(_source.tag == FontSourceHandle::FontLoader) {
-        auto fontData = _source.fontLoader();
-        if (fontData.size() > 0) {
-            int font = fonsAddFontMem(m_fons, _name.c_str(), (unsigned char*)fontData.data(), fontData.size(), 0);
-            m_sources.push_back(std::move(fontData));
-            return font;
-        }
+        return addFontData(_name, _source.fontLoader());
     }
     // switch to using FontSourceHandle::FontLoader for macOS/iOS - see appleFontFace.mm
     //case FontSourceHandle::FontName:
@@ -373,7 +588,7 @@ int FontContext::getFont(const std::string& _family, const std::string& _style,
         std::lock_guard<std::mutex> lock(m_fontMutex);
 
         std::string alias = FontDescription::Alias(_family, _style, _weight);
-        int font = fonsGetFontByName(m_fons, alias.c_str());
+        int font = fonsGetFontByName(m_layouts.front()->fons, alias.c_str());
         if (font >= 0) return font + 1;
 
         auto systemFontHandle = m_platform.systemFont(_family, _weight, _style);
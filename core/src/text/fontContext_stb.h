@@ -3,10 +3,14 @@
 #include "gl/glyphTexture.h"
 #include "labels/textLabel.h"
 #include "style/textStyle.h"
+#include "text/glyphPack.h"
+#include "text/textLayoutCache.h"
 #include "util/fontDescription.h"
+#include "util/lockStats.h"
 
 #include <bitset>
 #include <mutex>
+#include <unordered_map>
 
 struct FONScontext;
 
@@ -16,11 +20,22 @@ class FontContext {
 
 public:
     static constexpr int max_textures = 64;
+    // Pages of all glyph atlases before their glyphs move on to new atlases
+    static constexpr int max_atlas_pages = max_textures / 4;
+    static constexpr int max_layout_contexts = 4;
 
-    FontContext(Platform& _platform);
+    /* Text is laid out in @_numLayoutContexts fontstash contexts, one per tile worker, which
+     * share the font data and the glyph textures but have atlases of their own */
+    FontContext(Platform& _platform, uint32_t _numLayoutContexts = 1);
     virtual ~FontContext();
 
     void loadFonts(const std::vector<FontSourceHandle>& fallbacks);
+
+    /* Map prebuilt glyph packs, see GlyphPack; glyphs missing from the packs are rendered */
+    void loadGlyphPacks(const std::vector<FontSourceHandle>& _packs);
+
+    /* SDF options of the glyph atlas, which glyph packs must be built with */
+    static GlyphPack::Params glyphPackParams();
     void releaseAtlas(std::bitset<max_textures> _refs);
 
     /* Update all textures batches, uploads the data to the GPU */
@@ -36,6 +51,16 @@ public:
 
     void bindTexture(RenderState& rs, int _id, GLuint _unit);
 
+    /* True once after the glyphs moved on to a new atlas; labels using the pages of the old
+     * atlas should be rebuilt, the pages are released with the last of these labels */
+    bool takeRetiredAtlas();
+
+    /* No texture is left for new glyphs; all labels and fonts have to be released */
+    bool atlasExhausted() {
+        std::lock_guard<std::mutex> lock(m_textureMutex);
+        return m_atlasExhausted;
+    }
+
     float maxStrokeWidth() { return m_sdfRadius; }
 
     bool layoutText(TextStyle::Parameters& _params, const std::string& _text,
@@ -49,23 +74,73 @@ public:
     // called for memory warning or almost out of GlyphTextures; tiles and markers must be rebuilt
     void releaseFonts();
 
+    // time tile workers waited for the context and texture locks in layoutText()
+    const LockStats& layoutLockStats() const { return m_layoutLocks; }
+
 private:
-    int addTexture();
-    void flushTextTexture();
+    // fontstash context with its atlas, locked on its mutex
+    struct LayoutContext {
+        FONScontext* fons = nullptr;
+        std::mutex mutex;
+        // Texture slot of each page of the atlas
+        std::vector<size_t> pages;
+    };
+
+    // Layout context of the calling thread
+    LayoutContext& layoutContext();
+
+    int addTexture(LayoutContext& _ctx);
+    // Texture slot for a new page, -1 when none is left; locked on m_textureMutex
+    int allocTexture();
+    // Keep the pages of the atlas until released, start a new atlas; locked on the context and
+    // m_textureMutex
+    void retireAtlas(LayoutContext& _ctx);
+    // Free retired pages without labels; locked on all contexts and m_textureMutex
+    void freeRetiredPages();
+    void flushTextTexture(LayoutContext& _ctx);
+    // Add font @_data to all contexts; locked on m_fontMutex
+    int addFontData(const std::string& _name, std::vector<char>&& _data);
     int loadFontSource(const std::string& _name, const FontSourceHandle& _source);
-    int layoutMultiline(TextStyle::Parameters& _params, const std::string& _text,
+    int layoutMultiline(LayoutContext& _ctx, TextStyle::Parameters& _params, const std::string& _text,
         TextLabelProperty::Align _align, std::vector<GlyphQuad>& _quads);
-    bool layoutLine(TextStyle::Parameters& _params, float x, float y,
+    bool layoutLine(LayoutContext& _ctx, TextStyle::Parameters& _params, float x, float y,
         const char* start, const char* end, std::vector<GlyphQuad>& _quads);
 
+    // Copy the glyph from a glyph pack into the atlas; called by fontstash with the context locked
+    static int packedGlyphSDF(void* _userPtr, void* _fontImpl, unsigned char* _output,
+        int _width, int _height, int _stride, int _glyph);
+
+    // Add a cached layout of @_key unless its atlases were cleared; locks m_textureMutex
+    bool addCachedLayout(const TextLayoutCache::Key& _key, std::vector<GlyphQuad>& _quads,
+        std::bitset<max_textures>& _refs, glm::vec2& _size, TextRange& _textRanges);
+
+    // Locked before the contexts for adding fonts; contexts are locked in order before
+    // m_textureMutex
     std::mutex m_fontMutex;
     std::mutex m_textureMutex;
+    LockStats m_layoutLocks;
 
     float m_sdfRadius;
-    FONScontext* m_fons;
+    std::vector<std::unique_ptr<LayoutContext>> m_layouts;
+    // Pages of a context's atlas before its glyphs move on to a new atlas
+    size_t m_maxContextPages;
     std::array<int, max_textures> m_atlasRefCount = {{0}};
+    // Bumped when the glyphs of an atlas are cleared, see TextLayoutCache
+    std::array<uint32_t, max_textures> m_atlasGeneration = {{0}};
+    TextLayoutCache m_layoutCache;
     std::vector< std::vector<char> > m_sources;
+
+    // Guards the glyph packs and the font names, locked after the contexts
+    std::mutex m_packMutex;
+    std::vector<std::unique_ptr<GlyphPack>> m_glyphPacks;
+    // Name of the font of each fontstash font implementation
+    std::unordered_map<const void*, std::string> m_fontNames;
+    // Texture slots of the glyph pages, null when free
     std::vector<std::unique_ptr<GlyphTexture>> m_textures;
+    // Slots of the pages of previous atlases
+    std::bitset<max_textures> m_retired;
+    bool m_atlasRetired = false;
+    bool m_atlasExhausted = false;
     Platform& m_platform;
 };
 
@@ -0,0 +1,202 @@
+#include "text/glyphPack.h"
+
+#include "log.h"
+
+#define MINIZ_NO_ZLIB_APIS
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include <miniz.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Tangram {
+
+static const char MAGIC[4] = { 'T', 'G', 'P', 'K' };
+static const size_t HEADER_SIZE = 28;
+static const size_t ENTRY_SIZE = 16;
+
+template<typename T>
+static void write(std::vector<char>& _out, T _value) {
+    const char* bytes = reinterpret_cast<const char*>(&_value);
+    _out.insert(_out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static bool read(const char*& _pos, const char* _end, T& _value) {
+    if (size_t(_end - _pos) < sizeof(T)) { return false; }
+    std::memcpy(&_value, _pos, sizeof(T));
+    _pos += sizeof(T);
+    return true;
+}
+
+std::unique_ptr<GlyphPack> GlyphPack::open(const std::string& _path) {
+    std::unique_ptr<GlyphPack> pack(new GlyphPack());
+    if (!pack->m_file.open(_path)) {
+        LOGW("Cannot open glyph pack %s", _path.c_str());
+        return nullptr;
+    }
+    // Glyphs are read in the order labels need them
+    pack->m_file.adviseRandom();
+
+    if (!pack->parse(pack->m_file.data(), pack->m_file.size())) {
+        LOGW("Invalid glyph pack %s", _path.c_str());
+        return nullptr;
+    }
+    return pack;
+}
+
+std::unique_ptr<GlyphPack> GlyphPack::fromData(std::vector<char>&& _data) {
+    std::unique_ptr<GlyphPack> pack(new GlyphPack());
+    pack->m_data = std::move(_data);
+
+    if (!pack->parse(pack->m_data.data(), pack->m_data.size())) {
+        LOGW("Invalid glyph pack");
+        return nullptr;
+    }
+    return pack;
+}
+
+bool GlyphPack::parse(const char* _data, size_t _size) {
+    const char* pos = _data;
+    const char* end = _data + _size;
+
+    if (_size < HEADER_SIZE || std::memcmp(pos, MAGIC, sizeof(MAGIC)) != 0) { return false; }
+    pos += sizeof(MAGIC);
+
+    uint32_t version = 0, fontCount = 0, glyphCount = 0;
+    read(pos, end, version);
+    if (version != VERSION) { return false; }
+    read(pos, end, m_params.atlasFontPx);
+    read(pos, end, m_params.sdfPadding);
+    read(pos, end, m_params.sdfPixelDist);
+    read(pos, end, fontCount);
+    read(pos, end, glyphCount);
+
+    for (uint32_t i = 0; i < fontCount; i++) {
+        uint16_t length = 0;
+        uint32_t first = 0, count = 0;
+        if (!read(pos, end, length) || size_t(end - pos) < length) { return false; }
+        std::string name(pos, length);
+        pos += length;
+        if (!read(pos, end, first) || !read(pos, end, count)) { return false; }
+        if (uint64_t(first) + count > glyphCount) { return false; }
+        m_fonts[name] = { first, count };
+    }
+
+    if (size_t(end - pos) / ENTRY_SIZE < glyphCount) { return false; }
+    m_entries = pos;
+    m_glyphCount = glyphCount;
+    m_bitmaps = pos + glyphCount * ENTRY_SIZE;
+    m_bitmapsSize = size_t(end - m_bitmaps);
+
+    return true;
+}
+
+GlyphPack::Entry GlyphPack::entry(size_t _index) const {
+    Entry entry;
+    const char* pos = m_entries + _index * ENTRY_SIZE;
+    const char* end = pos + ENTRY_SIZE;
+    read(pos, end, entry.glyph);
+    read(pos, end, entry.width);
+    read(pos, end, entry.height);
+    read(pos, end, entry.offset);
+    read(pos, end, entry.size);
+    return entry;
+}
+
+bool GlyphPack::glyph(const std::string& _font, uint32_t _glyph, int _width, int _height,
+                      uint8_t* _output, int _stride) const {
+
+    auto font = m_fonts.find(_font);
+    if (font == m_fonts.end()) { return false; }
+
+    // Binary search of the sorted entries of the font
+    uint32_t lo = font->second.first, hi = lo + font->second.second;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (entry(mid).glyph < _glyph) { lo = mid + 1; } else { hi = mid; }
+    }
+    if (lo == font->second.first + font->second.second) { return false; }
+
+    Entry e = entry(lo);
+    if (e.glyph != _glyph || e.width != _width || e.height != _height) { return false; }
+    if (uint64_t(e.offset) + e.size > m_bitmapsSize) { return false; }
+
+    std::vector<uint8_t> bitmap(size_t(_width) * _height);
+    size_t size = tinfl_decompress_mem_to_mem(bitmap.data(), bitmap.size(), m_bitmaps + e.offset,
+                                              e.size, 0);
+    if (size != bitmap.size()) { return false; }
+
+    for (int y = 0; y < _height; y++) {
+        std::memcpy(_output + size_t(y) * _stride, bitmap.data() + size_t(y) * _width, _width);
+    }
+    return true;
+}
+
+void GlyphPack::Builder::add(const std::string& _font, uint32_t _glyph, int _width, int _height,
+                             const uint8_t* _bitmap) {
+
+    Glyph glyph{ _font, _glyph, uint16_t(_width), uint16_t(_height), {} };
+
+    size_t size = 0;
+    void* deflated = tdefl_compress_mem_to_heap(_bitmap, size_t(_width) * _height, &size,
+                                                TDEFL_DEFAULT_MAX_PROBES);
+    if (!deflated) { return; }
+    glyph.deflated.assign(static_cast<uint8_t*>(deflated), static_cast<uint8_t*>(deflated) + size);
+    mz_free(deflated);
+
+    m_glyphs.push_back(std::move(glyph));
+}
+
+std::vector<char> GlyphPack::Builder::build() const {
+
+    std::vector<const Glyph*> glyphs;
+    for (auto& glyph : m_glyphs) { glyphs.push_back(&glyph); }
+    std::sort(glyphs.begin(), glyphs.end(), [](const Glyph* a, const Glyph* b) {
+        return a->font != b->font ? a->font < b->font : a->glyph < b->glyph;
+    });
+    // Keep the first of duplicate glyphs
+    glyphs.erase(std::unique(glyphs.begin(), glyphs.end(), [](const Glyph* a, const Glyph* b) {
+        return a->font == b->font && a->glyph == b->glyph;
+    }), glyphs.end());
+
+    std::vector<std::pair<std::string, uint32_t>> fonts;
+    for (uint32_t i = 0; i < glyphs.size(); i++) {
+        if (fonts.empty() || fonts.back().first != glyphs[i]->font) {
+            fonts.emplace_back(glyphs[i]->font, i);
+        }
+    }
+
+    std::vector<char> out(MAGIC, MAGIC + sizeof(MAGIC));
+    write(out, VERSION);
+    write(out, m_params.atlasFontPx);
+    write(out, m_params.sdfPadding);
+    write(out, m_params.sdfPixelDist);
+    write(out, uint32_t(fonts.size()));
+    write(out, uint32_t(glyphs.size()));
+
+    for (size_t i = 0; i < fonts.size(); i++) {
+        uint32_t next = i + 1 < fonts.size() ? fonts[i + 1].second : uint32_t(glyphs.size());
+        write(out, uint16_t(fonts[i].first.size()));
+        out.insert(out.end(), fonts[i].first.begin(), fonts[i].first.end());
+        write(out, fonts[i].second);
+        write(out, next - fonts[i].second);
+    }
+
+    uint32_t offset = 0;
+    for (auto* glyph : glyphs) {
+        write(out, glyph->glyph);
+        write(out, glyph->width);
+        write(out, glyph->height);
+        write(out, offset);
+        write(out, uint32_t(glyph->deflated.size()));
+        offset += uint32_t(glyph->deflated.size());
+    }
+
+    for (auto* glyph : glyphs) {
+        out.insert(out.end(), glyph->deflated.begin(), glyph->deflated.end());
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "util/mappedFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * GlyphPack - Prebuilt SDF bitmaps of the glyphs of fonts, in the cells fontstash would render
+ * them to in the glyph atlas
+ *
+ * Packs are written by the glyph pack tool (platforms/common/glyphPackTool.cpp) for the fonts
+ * and codepoints expected in a scene, and mapped at startup so that FontContext copies their
+ * glyphs instead of rendering them. Glyphs are found by font name, as registered in the
+ * FontContext, and glyph index; each bitmap is deflated on its own, so only the glyphs used
+ * are read and inflated. Glyphs which are not in a pack are rendered as before.
+ *
+ * File layout, little endian:
+ *   Header
+ *   per font: u16 name length, name, u32 first glyph, u32 glyph count
+ *   Glyph entries, sorted by font then glyph index
+ *   deflated bitmaps
+ */
+class GlyphPack {
+
+public:
+
+    static constexpr uint32_t VERSION = 1;
+
+    /* SDF options of the glyphs, must match those of the glyph atlas */
+    struct Params {
+        int32_t atlasFontPx = 0;
+        int32_t sdfPadding = 0;
+        float sdfPixelDist = 0;
+
+        bool operator==(const Params& _other) const {
+            return atlasFontPx == _other.atlasFontPx && sdfPadding == _other.sdfPadding &&
+                sdfPixelDist == _other.sdfPixelDist;
+        }
+    };
+
+    /* Map the pack at @_path; nullptr when it cannot be read or is invalid */
+    static std::unique_ptr<GlyphPack> open(const std::string& _path);
+
+    /* Pack in @_data; nullptr when invalid */
+    static std::unique_ptr<GlyphPack> fromData(std::vector<char>&& _data);
+
+    const Params& params() const { return m_params; }
+
+    size_t glyphCount() const { return m_glyphCount; }
+
+    bool hasFont(const std::string& _font) const { return m_fonts.count(_font) != 0; }
+
+    /* Write the bitmap of glyph @_glyph of @_font to @_output, with rows @_stride bytes apart,
+     * when the pack has it in a cell of @_width x @_height */
+    bool glyph(const std::string& _font, uint32_t _glyph, int _width, int _height,
+               uint8_t* _output, int _stride) const;
+
+    /* Collects glyph bitmaps and writes the pack */
+    class Builder {
+    public:
+        explicit Builder(Params _params) : m_params(_params) {}
+
+        void add(const std::string& _font, uint32_t _glyph, int _width, int _height,
+                 const uint8_t* _bitmap);
+
+        size_t glyphCount() const { return m_glyphs.size(); }
+
+        std::vector<char> build() const;
+
+    private:
+        struct Glyph {
+            std::string font;
+            uint32_t glyph;
+            uint16_t width, height;
+            std::vector<uint8_t> deflated;
+        };
+
+        Params m_params;
+        std::vector<Glyph> m_glyphs;
+    };
+
+private:
+
+    struct Entry {
+        uint32_t glyph;
+        uint16_t width, height;
+        uint32_t offset, size;
+    };
+
+    GlyphPack() = default;
+
+    bool parse(const char* _data, size_t _size);
+
+    Entry entry(size_t _index) const;
+
+    MappedFile m_file;
+    std::vector<char> m_data;
+
+    const char* m_entries = nullptr;
+    const char* m_bitmaps = nullptr;
+    size_t m_bitmapsSize = 0;
+    size_t m_glyphCount = 0;
+
+    Params m_params;
+    // First entry and number of entries of each font
+    std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> m_fonts;
+};
+
+}
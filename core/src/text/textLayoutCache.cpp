@@ -0,0 +1,118 @@
+#include "text/textLayoutCache.h"
+
+#include "util/hash.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+bool TextLayoutCache::Key::operator==(const Key& _other) const {
+    return text == _other.text &&
+        font == _other.font &&
+        fontSize == _other.fontSize &&
+        fontScale == _other.fontScale &&
+        strokeWidth == _other.strokeWidth &&
+        lineSpacing == _other.lineSpacing &&
+        maxLines == _other.maxLines &&
+        maxLineWidth == _other.maxLineWidth &&
+        wordWrap == _other.wordWrap &&
+        alignments == _other.alignments;
+}
+
+size_t TextLayoutCache::KeyHash::operator()(const Key& _key) const {
+    size_t seed = std::hash<std::string>()(_key.text);
+    hash_combine(seed, _key.font);
+    hash_combine(seed, _key.fontSize);
+    hash_combine(seed, _key.fontScale);
+    hash_combine(seed, _key.strokeWidth);
+    hash_combine(seed, _key.lineSpacing);
+    hash_combine(seed, _key.maxLines);
+    hash_combine(seed, _key.maxLineWidth);
+    hash_combine(seed, _key.wordWrap);
+    hash_combine(seed, _key.alignments);
+    return seed;
+}
+
+TextLayoutCache::TextLayoutCache(size_t _maxEntries)
+    : m_maxShardEntries(std::max<size_t>(_maxEntries / SHARDS, 1)) {}
+
+std::shared_ptr<TextLayoutCache::Layout> TextLayoutCache::makeLayout(const std::vector<GlyphQuad>& _quads,
+                                                                    size_t _quadsStart,
+                                                                    const TextRange& _ranges,
+                                                                    glm::vec2 _size) {
+    auto layout = std::make_shared<Layout>();
+    layout->quads.assign(_quads.begin() + _quadsStart, _quads.end());
+    layout->size = _size;
+
+    for (size_t i = 0; i < _ranges.size(); i++) {
+        layout->ranges[i] = Range(_ranges[i].start - int(_quadsStart), _ranges[i].length);
+    }
+
+    for (auto& quad : layout->quads) {
+        auto it = std::find_if(layout->atlases.begin(), layout->atlases.end(),
+                               [&](auto& atlas) { return atlas.first == quad.atlas; });
+        if (it == layout->atlases.end()) { layout->atlases.emplace_back(quad.atlas, 0); }
+    }
+    return layout;
+}
+
+void TextLayoutCache::appendLayout(const Layout& _layout, std::vector<GlyphQuad>& _quads,
+                                   TextRange& _ranges, glm::vec2& _size) {
+    int quadsStart = int(_quads.size());
+    _quads.insert(_quads.end(), _layout.quads.begin(), _layout.quads.end());
+
+    for (size_t i = 0; i < _ranges.size(); i++) {
+        _ranges[i] = Range(_layout.ranges[i].start + quadsStart, _layout.ranges[i].length);
+    }
+    _size = _layout.size;
+}
+
+std::shared_ptr<const TextLayoutCache::Layout> TextLayoutCache::get(const Key& _key) {
+    auto& s = shard(_key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.index.find(_key);
+    if (it == s.index.end()) { return nullptr; }
+
+    s.entries.splice(s.entries.begin(), s.entries, it->second);
+    return it->second->second;
+}
+
+void TextLayoutCache::put(const Key& _key, std::shared_ptr<const Layout> _layout) {
+    auto& s = shard(_key);
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto it = s.index.find(_key);
+    if (it != s.index.end()) {
+        it->second->second = std::move(_layout);
+        s.entries.splice(s.entries.begin(), s.entries, it->second);
+        return;
+    }
+
+    s.entries.emplace_front(_key, std::move(_layout));
+    s.index.emplace(_key, s.entries.begin());
+
+    if (s.entries.size() > m_maxShardEntries) {
+        s.index.erase(s.entries.back().first);
+        s.entries.pop_back();
+    }
+}
+
+size_t TextLayoutCache::size() const {
+    size_t count = 0;
+    for (auto& s : m_shards) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        count += s.entries.size();
+    }
+    return count;
+}
+
+void TextLayoutCache::clear() {
+    for (auto& s : m_shards) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.entries.clear();
+        s.index.clear();
+    }
+}
+
+}
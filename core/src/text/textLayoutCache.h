@@ -0,0 +1,102 @@
+#pragma once
+
+#include "labels/textLabel.h"
+
+#include "glm/vec2.hpp"
+
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * TextLayoutCache - Glyph quads of laid out label texts, kept across tile builds
+ *
+ * Street names, POI categories and house numbers repeat within and between tiles; a text laid
+ * out once with the same font and wrapping parameters skips shaping and line breaking. A Layout
+ * holds the centered glyph quads of each alignment and the glyph atlases they refer to, with
+ * the generation of each atlas when the layout was made: FontContext bumps the generation of an
+ * atlas whose glyphs are cleared, which invalidates the layouts referring to it.
+ *
+ * Entries are spread over SHARDS separately locked LRU lists, so that tile workers rarely wait
+ * on each other; all functions are thread-safe.
+ */
+class TextLayoutCache {
+
+public:
+
+    static constexpr size_t SHARDS = 8;
+
+    struct Key {
+        std::string text;
+        // Font handle of the FontContext
+        uintptr_t font = 0;
+        float fontSize = 0;
+        float fontScale = 0;
+        float strokeWidth = 0;
+        float lineSpacing = 0;
+        uint32_t maxLines = 0;
+        uint32_t maxLineWidth = 0;
+        bool wordWrap = false;
+        // Bit for each TextLabelProperty::Align to lay out
+        uint8_t alignments = 0;
+
+        bool operator==(const Key& _other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& _key) const;
+    };
+
+    struct Layout {
+        // Glyph quads centered around 0/0
+        std::vector<GlyphQuad> quads;
+        // Ranges of the quads of each alignment
+        TextRange ranges;
+        glm::vec2 size;
+        // Atlases of the quads with their generation
+        std::vector<std::pair<size_t, uint32_t>> atlases;
+    };
+
+    explicit TextLayoutCache(size_t _maxEntries = 8192);
+
+    /* Layout of the quads added to @_quads from @_quadsStart, with @_ranges into @_quads; the
+     * generations of its atlases are left to the caller */
+    static std::shared_ptr<Layout> makeLayout(const std::vector<GlyphQuad>& _quads, size_t _quadsStart,
+                                              const TextRange& _ranges, glm::vec2 _size);
+
+    /* Add the quads of @_layout to @_quads, setting @_ranges into @_quads and @_size */
+    static void appendLayout(const Layout& _layout, std::vector<GlyphQuad>& _quads,
+                             TextRange& _ranges, glm::vec2& _size);
+
+    std::shared_ptr<const Layout> get(const Key& _key);
+
+    void put(const Key& _key, std::shared_ptr<const Layout> _layout);
+
+    size_t size() const;
+
+    void clear();
+
+private:
+
+    struct Shard {
+        using EntryList = std::list<std::pair<Key, std::shared_ptr<const Layout>>>;
+
+        mutable std::mutex mutex;
+        // Most recently used first
+        EntryList entries;
+        std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    };
+
+    Shard& shard(const Key& _key) { return m_shards[KeyHash()(_key) % SHARDS]; }
+
+    size_t m_maxShardEntries;
+    std::array<Shard, SHARDS> m_shards;
+};
+
+}
@@ -1,6 +1,9 @@
 #include "tile/tile.h"
 
+#include "debug/trace.h"
+#include "gl/renderState.h"
 #include "labels/labelSet.h"
+#include "selection/pickIndex.h"
 #include "style/style.h"
 #include "tile/tileID.h"
 #include "util/mapProjection.h"
@@ -66,15 +69,19 @@ void Tile::setMesh(const Style& _style, std::unique_ptr<StyledMesh> _mesh) {
     m_geometry[_style.getID()] = std::move(_mesh);
 }
 
-const std::unique_ptr<StyledMesh>& Tile::getMesh(const Style& _style) const {
-    static std::unique_ptr<StyledMesh> NONE = nullptr;
+const std::shared_ptr<StyledMesh>& Tile::getMesh(const Style& _style) const {
+    static std::shared_ptr<StyledMesh> NONE = nullptr;
     if (_style.getID() >= m_geometry.size()) { return NONE; }
 
     return m_geometry[_style.getID()];
 }
 
-void Tile::setSelectionFeatures(const fastmap<uint32_t, std::shared_ptr<Properties>> _selectionFeatures) {
-    m_selectionFeatures = _selectionFeatures;
+void Tile::setSelectionFeatures(fastmap<uint32_t, std::shared_ptr<Properties>>&& _selectionFeatures) {
+    m_selectionFeatures = std::move(_selectionFeatures);
+}
+
+void Tile::setPickIndex(std::unique_ptr<PickIndex> _pickIndex) {
+    m_pickIndex = std::move(_pickIndex);
 }
 
 std::shared_ptr<Properties> Tile::getSelectionFeature(uint32_t _id) const {
@@ -85,6 +92,66 @@ std::shared_ptr<Properties> Tile::getSelectionFeature(uint32_t _id) const {
     return nullptr;
 }
 
+void Tile::takeUnchanged(const Tile& _tile, const std::vector<bool>& _rebuilt) {
+    if (m_geometry.size() < _tile.m_geometry.size()) {
+        m_geometry.resize(_tile.m_geometry.size());
+    }
+    for (size_t id = 0; id < _tile.m_geometry.size(); id++) {
+        if (id < _rebuilt.size() && _rebuilt[id]) { continue; }
+        m_geometry[id] = _tile.m_geometry[id];
+    }
+
+    // selection colors are unique, so features of old and new meshes do not collide
+    for (auto& feature : _tile.m_selectionFeatures) {
+        if (!getSelectionFeature(feature.first)) {
+            m_selectionFeatures[feature.first] = feature.second;
+        }
+    }
+    if (m_pickIndex && _tile.m_pickIndex) { m_pickIndex->merge(*_tile.m_pickIndex); }
+
+    // rasters of a restored tile are set by raster subtasks
+    if (m_rasters.empty()) {
+        for (auto& raster : _tile.m_rasters) { m_rasters.emplace_back(raster.tileID, raster.texture); }
+    }
+    m_buildCost = _tile.m_buildCost;
+    m_uploadCost = _tile.m_uploadCost;
+    m_traceId = _tile.m_traceId;
+    m_memoryUsage = 0;
+}
+
+size_t Tile::upload(RenderState& rs) {
+    TRACE_SCOPE("upload");
+    Trace::flow(m_traceId, Trace::Flow::step);
+    size_t bytes = 0;
+    for (auto& entry : m_geometry) {
+        if (entry) { bytes += entry->uploadPending(rs); }
+    }
+    // Rasters may be shared with other tiles and uploaded already; they are uploaded on the
+    // upload worker when there is one, and the tile is uploaded when all of them are done
+    bool uploading = false;
+    for (auto& raster : m_rasters) {
+        auto& texture = raster.texture;
+        if (!texture) { continue; }
+        if (texture->needsUpload() && !texture->uploadAsync(rs)) {
+            int prevTexUnit = rs.currentTextureUnit();
+            texture->bind(rs, rs.nextAvailableTextureUnit());
+            rs.resetTextureUnit(prevTexUnit);
+            bytes += texture->bufferSize();
+        }
+        uploading |= texture->isUploading();
+    }
+    m_uploaded = !uploading;
+    return bytes;
+}
+
+size_t Tile::getSelectionMemoryUsage() const {
+    size_t bytes = m_selectionFeatures.size() * (sizeof(uint32_t) + sizeof(std::shared_ptr<Properties>));
+    for (const auto& feature : m_selectionFeatures) {
+        if (feature.second) { bytes += sizeof(Properties) + feature.second->memoryUsage(); }
+    }
+    return bytes;
+}
+
 size_t Tile::getMemoryUsage() const {
     if (m_memoryUsage == 0) {
         for (auto& entry : m_geometry) {
@@ -97,9 +164,20 @@ size_t Tile::getMemoryUsage() const {
                 m_memoryUsage += raster.texture->bufferSize();
             }
         }
+        if (m_pickIndex) { m_memoryUsage += m_pickIndex->memoryUsage(); }
     }
 
     return m_memoryUsage;
 }
 
+bool Tile::restorable() const {
+    for (auto& entry : m_geometry) {
+        if (entry && !entry->restorable()) { return false; }
+    }
+    for (auto& raster : m_rasters) {
+        if (raster.texture && !raster.texture->restorable()) { return false; }
+    }
+    return true;
+}
+
 }
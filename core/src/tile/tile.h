@@ -15,10 +15,13 @@
 namespace Tangram {
 
 class MapProjection;
+class PickIndex;
 struct Properties;
+class RenderState;
 class Style;
 class View;
 struct StyledMesh;
+struct TileData;
 
 struct Raster {
     TileID tileID;
@@ -63,16 +66,24 @@ public:
 
     void initGeometry(uint32_t _size);
 
-    const std::unique_ptr<StyledMesh>& getMesh(const Style& _style) const;
+    const std::shared_ptr<StyledMesh>& getMesh(const Style& _style) const;
 
     void setMesh(const Style& _style, std::unique_ptr<StyledMesh> _mesh);
 
-    void setSelectionFeatures(const fastmap<uint32_t, std::shared_ptr<Properties>> _selectionFeatures);
+    // Properties of interactive features by selection color; they are shared, not copied
+    void setSelectionFeatures(fastmap<uint32_t, std::shared_ptr<Properties>>&& _selectionFeatures);
 
     std::shared_ptr<Properties> getSelectionFeature(uint32_t _id) const;
 
     const auto& getSelectionFeatures() const { return m_selectionFeatures; }
 
+    /* Estimated bytes of the selection features */
+    size_t getSelectionMemoryUsage() const;
+
+    // Geometry of the interactive features, null unless picking on the CPU, see PickIndex
+    void setPickIndex(std::unique_ptr<PickIndex> _pickIndex);
+    const PickIndex* pickIndex() const { return m_pickIndex.get(); }
+
     auto& rasters() { return m_rasters; }
     const auto& rasters() const { return m_rasters; }
 
@@ -84,6 +95,10 @@ public:
     /* Get the sum in bytes of static <Mesh>es */
     size_t getMemoryUsage() const;
 
+    /* Whether all meshes and rasters can be uploaded again after the GL context is lost,
+     * see RetainedData */
+    bool restorable() const;
+
     int64_t sourceGeneration() const { return m_sourceGeneration; }
 
     int32_t sourceID() const { return m_sourceId; }
@@ -93,6 +108,43 @@ public:
 
     void setProxyDepth(int8_t _depth) { m_proxyDepth = _depth; }
 
+    /* Cells of the MeshBase::CHUNK_GRID grid over this proxy tile which are covered by drawn tiles
+     * of higher zoom and need not be drawn, see MeshBase::hideCoveredChunks() */
+    uint16_t coveredCells() const { return m_coveredCells; }
+    void setCoveredCells(uint16_t _cells) { m_coveredCells = _cells; }
+
+    /* Set when extrusions were built with less detail for a tile far from the camera, so that
+     * TileManager loads the tile again once it comes near, see TileTask::setCoarse() */
+    bool isCoarse() const { return m_coarse; }
+    void setCoarse(bool _coarse) { m_coarse = _coarse; }
+
+    /* Milliseconds spent to parse, build and upload this tile, i.e. the cost of rebuilding it */
+    float buildCost() const { return m_buildCost + m_uploadCost; }
+    void setBuildCost(float _ms) { m_buildCost = _ms; }
+
+    /* Set once all meshes and rasters of this tile were uploaded, see upload() */
+    bool isUploaded() const { return m_uploaded; }
+    void setUploaded() { m_uploaded = true; }
+    void addUploadCost(float _ms) const { m_uploadCost += _ms; }
+
+    /* Trace id of the TileTask which built this tile, reset when it was first drawn */
+    uint64_t traceId() const { return m_traceId; }
+    void setTraceId(uint64_t _id) const { m_traceId = _id; }
+
+    /* Upload meshes and raster textures that are not uploaded yet and set the tile uploaded
+     * unless rasters are still uploading on Texture::uploadWorker; returns the number of bytes
+     * uploaded on the render thread */
+    size_t upload(RenderState& rs);
+
+    /* TileData this tile was built from; kept when styles may be rebuilt (see Scene::keepTileData()) */
+    const std::shared_ptr<TileData>& tileData() const { return m_tileData; }
+    void setTileData(std::shared_ptr<TileData> _tileData) { m_tileData = std::move(_tileData); }
+
+    /* Share meshes of styles not set in @_rebuilt (by Style ID), rasters, selection features and
+     * build cost of @_tile, of which only the meshes of @_rebuilt styles were built anew; @_tile
+     * keeps them, since it is drawn until this tile replaces it */
+    void takeUnchanged(const Tile& _tile, const std::vector<bool>& _rebuilt);
+
 private:
 
     const TileID m_id;
@@ -107,6 +159,10 @@ private:
 
     int8_t m_proxyDepth = 0;
 
+    uint16_t m_coveredCells = 0;
+
+    bool m_coarse = false;
+
     glm::dvec2 m_tileOrigin; // South-West corner of the tile in 2D projection space in meters (e.g. mercator meters)
 
     glm::mat4 m_modelMatrix; // Matrix relating tile-local coordinates to global projection space coordinates;
@@ -116,14 +172,23 @@ private:
 
     glm::mat4 m_mvp;
 
-    // Map of <Style>s and their associated <Mesh>es
-    std::vector<std::unique_ptr<StyledMesh>> m_geometry;
+    // Map of <Style>s and their associated <Mesh>es, shared with a rebuilt tile, see takeUnchanged()
+    std::vector<std::shared_ptr<StyledMesh>> m_geometry;
     std::vector<Raster> m_rasters;
 
     mutable size_t m_memoryUsage = 0;
 
+    float m_buildCost = 0;
+    mutable float m_uploadCost = 0;
+    bool m_uploaded = false;
+    mutable uint64_t m_traceId = 0;
+
     fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
 
+    std::unique_ptr<PickIndex> m_pickIndex;
+
+    std::shared_ptr<TileData> m_tileData;
+
 };
 
 }
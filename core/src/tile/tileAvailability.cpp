@@ -0,0 +1,119 @@
+#include "tile/tileAvailability.h"
+
+#include "log.h"
+#include "util/mapProjection.h"
+
+// Missing subtrees are forgotten when more nodes would be needed
+#define MAX_AVAILABILITY_NODES (1 << 16)
+
+namespace Tangram {
+
+// Index of the child of the ancestor of @_tileId at @_depth that leads to it, as in TileID::getChild()
+static int childIndex(const TileID& _tileId, int _depth) {
+    int shift = _tileId.z - _depth - 1;
+    return (((_tileId.x >> shift) & 1) << 1) | ((_tileId.y >> shift) & 1);
+}
+
+void TileAvailability::setZoomRange(int _minZoom, int _maxZoom) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_minZoom = _minZoom;
+    m_maxZoom = _maxZoom;
+    m_empty = false;
+}
+
+void TileAvailability::setBounds(LngLat _min, LngLat _max) {
+    auto clampLatitude = [](double _latitude) {
+        return glm::clamp(_latitude, -MapProjection::MAX_LATITUDE_DEGREES, MapProjection::MAX_LATITUDE_DEGREES);
+    };
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bounds.min = MapProjection::lngLatToProjectedMeters({ _min.longitude, clampLatitude(_min.latitude) });
+    m_bounds.max = MapProjection::lngLatToProjectedMeters({ _max.longitude, clampLatitude(_max.latitude) });
+    m_hasBounds = true;
+    m_empty = false;
+}
+
+void TileAvailability::setMissing(const TileID& _tileId) {
+    if (!_tileId.isValid()) { return; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_empty = false;
+    if (_tileId.z == 0) {
+        m_rootMissing = true;
+        return;
+    }
+
+    if (m_nodes.size() + _tileId.z >= MAX_AVAILABILITY_NODES) {
+        LOGD("Forgetting %d nodes of missing tiles", int(m_nodes.size()));
+        m_nodes.clear();
+    }
+    if (m_nodes.empty()) { m_nodes.emplace_back(); }
+
+    uint32_t node = 0;
+    for (int depth = 0; depth < _tileId.z; depth++) {
+        uint32_t& slot = m_nodes[node].children[childIndex(_tileId, depth)];
+        if (slot == MISSING) { return; }
+        if (depth == _tileId.z - 1) {
+            slot = MISSING;
+            return;
+        }
+        if (slot == UNKNOWN) {
+            slot = uint32_t(m_nodes.size());
+            // invalidates @slot
+            m_nodes.emplace_back();
+        }
+        node = m_nodes[node].children[childIndex(_tileId, depth)];
+    }
+}
+
+bool TileAvailability::isMissing(const TileID& _tileId) const {
+    if (m_empty) { return false; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return isMissingLocked(_tileId);
+}
+
+bool TileAvailability::childrenMissing(const TileID& _tileId) const {
+    if (m_empty) { return false; }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (_tileId.z >= m_maxZoom) { return true; }
+
+    TileID dataId(_tileId.x, _tileId.y, _tileId.z);
+    for (int i = 0; i < 4; i++) {
+        if (!isMissingLocked(dataId.getChild(i, 100))) { return false; }
+    }
+    return true;
+}
+
+bool TileAvailability::isMissingLocked(const TileID& _tileId) const {
+    if (_tileId.z < m_minZoom || _tileId.z > m_maxZoom) { return true; }
+
+    if (m_hasBounds) {
+        BoundingBox tile = MapProjection::tileBounds(_tileId);
+        if (tile.max.x <= m_bounds.min.x || tile.min.x >= m_bounds.max.x ||
+            tile.max.y <= m_bounds.min.y || tile.min.y >= m_bounds.max.y) {
+            return true;
+        }
+    }
+
+    if (m_rootMissing) { return true; }
+    if (m_nodes.empty()) { return false; }
+
+    uint32_t node = 0;
+    for (int depth = 0; depth < _tileId.z; depth++) {
+        uint32_t slot = m_nodes[node].children[childIndex(_tileId, depth)];
+        if (slot == MISSING) { return true; }
+        if (slot == UNKNOWN) { return false; }
+        node = slot;
+    }
+    return false;
+}
+
+void TileAvailability::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nodes.clear();
+    m_rootMissing = false;
+    m_empty = !m_hasBounds && m_minZoom == 0 && m_maxZoom == 32;
+}
+
+}
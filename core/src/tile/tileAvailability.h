@@ -0,0 +1,78 @@
+#pragma once
+
+#include "tile/tileID.h"
+#include "util/geom.h"
+#include "util/types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * TileAvailability - Tiles of a TileSource that are known to have no data, so that they are
+ * not requested; TileManager loads the deepest available ancestor of a missing region instead
+ * and overzooms it, see TileManager::updateTileSets()
+ *
+ * Tiles are missing outside of the bounds and the zoom range of the source, e.g. as given by
+ * the scene or by the header of a PMTiles archive, and in subtrees that a DataSource found to
+ * have no data, e.g. for a 404 response or a tile that is not in an archive. The subtrees are
+ * kept in a quadtree of nodes with a slot for each child, which marks the child as missing or
+ * links its node.
+ *
+ * May be used from any thread.
+ */
+class TileAvailability {
+
+public:
+
+    // Tiles below @_minZoom or above @_maxZoom are missing
+    void setZoomRange(int _minZoom, int _maxZoom);
+
+    // Tiles outside of @_min to @_max are missing
+    void setBounds(LngLat _min, LngLat _max);
+
+    // Mark data tile @_tileId (any s) and its descendants as missing
+    void setMissing(const TileID& _tileId);
+
+    bool isMissing(const TileID& _tileId) const;
+
+    // Whether all children of @_tileId are missing, so that it is the deepest tile with data
+    bool childrenMissing(const TileID& _tileId) const;
+
+    // Forget the missing subtrees, e.g. when the data of the source changed; bounds and zoom
+    // range are kept
+    void clear();
+
+private:
+
+    bool isMissingLocked(const TileID& _tileId) const;
+
+    // Child slots: no information, missing subtree, or index of the child node
+    static constexpr uint32_t UNKNOWN = 0;
+    static constexpr uint32_t MISSING = UINT32_MAX;
+
+    struct Node {
+        uint32_t children[4] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+    };
+
+    mutable std::mutex m_mutex;
+
+    // Root node at index 0 once any subtree below it is missing
+    std::vector<Node> m_nodes;
+    bool m_rootMissing = false;
+
+    int m_minZoom = 0;
+    int m_maxZoom = 32;
+
+    // In projected meters
+    BoundingBox m_bounds;
+    bool m_hasBounds = false;
+
+    // Nothing is missing, checked without locking
+    std::atomic<bool> m_empty{true};
+};
+
+}
@@ -8,15 +8,24 @@
 #include "scene/dataLayer.h"
 #include "scene/scene.h"
 #include "selection/featureSelection.h"
+#include "selection/pickIndex.h"
 #include "tile/tile.h"
+#include "tile/tileTask.h"
 #include "util/mapProjection.h"
+#include "util/triangulationCache.h"
 #include "view/view.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 namespace Tangram {
 
-TileBuilder::TileBuilder(const Scene& _scene)
+TileBuilder::TileBuilder(const Scene& _scene, TriangulationCache* _triangulationCache,
+                         CollisionCache* _collisionCache)
     : m_scene(_scene),
-      m_styleContext(std::make_unique<StyleContext>()) {
+      m_triangulationCache(_triangulationCache),
+      m_labelLayout(_collisionCache) {
 }
 
 TileBuilder::TileBuilder(const Scene& _scene, StyleContext* _styleContext)
@@ -24,12 +33,20 @@ TileBuilder::TileBuilder(const Scene& _scene, StyleContext* _styleContext)
       m_styleContext(std::unique_ptr<StyleContext>(_styleContext)) {
 }
 
-void TileBuilder::init() {
+TileBuilder::~TileBuilder() {}
+
+void TileBuilder::init(std::unique_ptr<StyleContext> _styleContext) {
+    if (_styleContext) {
+        m_styleContext = std::move(_styleContext);
+    } else if (!m_styleContext) {
+        m_styleContext = std::make_unique<StyleContext>();
+    }
     m_styleContext->initFunctions(m_scene);
 
     // Initialize StyleBuilders
     for (const auto& style : m_scene.styles()) {
         if (auto builder = style->createBuilder()) {
+            builder->setTriangulationCache(m_triangulationCache);
             m_styleBuilder[style->getName()] = std::move(builder);
         }
     }
@@ -48,6 +65,7 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
     if (!m_ruleSet.match(_feature, _layer, *m_styleContext)) { return; }
 
     uint32_t selectionColor = 0;
+    uint32_t selectionOrder = 0;
     bool added = false;
 
     // For each matched rule, find the style to be used and
@@ -64,6 +82,9 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
         // Apply default draw rules defined for this style
         builder->style().applyDefaultDrawRules(rule);
 
+        // Skip evaluation for styles that are not rebuilt
+        if (!isBuildingFeature(*builder) && !rule.findParameter(StyleParamKey::outline_style)) { continue; }
+
         if (!m_ruleSet.evaluateRuleForContext(rule, *m_styleContext)) {
             continue;
         }
@@ -86,7 +107,7 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
             auto* outlineStyle = getStyleBuilder(styleName);
             if (!outlineStyle) {
                 LOGN("Invalid style %s", styleName.c_str());
-            } else {
+            } else if (isBuildingFeature(*outlineStyle)) {
                 rule.isOutlineOnly = true;
                 outlineStyle->addFeature(_feature, rule);
                 rule.isOutlineOnly = false;
@@ -94,17 +115,59 @@ void TileBuilder::applyStyling(const Feature& _feature, const SceneLayer& _layer
         }
 
         // build feature with style
-        added |= builder->addFeature(_feature, rule);
+        if (isBuildingFeature(*builder) && builder->addFeature(_feature, rule)) {
+            added = true;
+            uint32_t order = 0;
+            if (rule.selectionColor != 0 && rule.get(StyleParamKey::order, order)) {
+                selectionOrder = std::max(selectionOrder, order);
+            }
+        }
     }
 
     if (added && (selectionColor != 0)) {
-        m_selectionFeatures[selectionColor] = std::make_shared<Properties>(_feature.props);
+        if (m_selectionFeature != &_feature) {
+            m_selectionFeature = &_feature;
+            m_selectionProperties = std::make_shared<Properties>(_feature.props);
+        }
+        m_selectionFeatures[selectionColor] = m_selectionProperties;
+        if (m_pickIndex) { m_pickIndex->add(_feature, selectionColor, selectionOrder); }
     }
 }
 
-void TileBuilder::build(Tile& tile, const TileData& _tileData, const TileSource& _source) {
+void TileBuilder::queueStyling(const Feature& _feature, const SceneLayer& _layer) {
+
+    if (!m_ruleSet.match(_feature, _layer, *m_styleContext)) { return; }
+
+    for (auto& rule : m_ruleSet.matchedRules()) {
+
+        StyleBuilder* builder = getStyleBuilder(rule.getStyleName());
+        if (!builder) { continue; }
+
+        builder->style().applyDefaultDrawRules(rule);
+
+        if (!isBuildingFeature(*builder) && !rule.findParameter(StyleParamKey::outline_style)) { continue; }
+
+        m_ruleSet.queueRuleForContext(rule, *m_styleContext);
+    }
+}
+
+// Number of features styled between checks for task cancellation
+#define CANCEL_CHECK_INTERVAL 64
+
+bool TileBuilder::build(Tile& tile, const TileData& _tileData, const TileSource& _source,
+                        const TileTask* _task, const std::vector<bool>* _styles) {
 
     m_selectionFeatures.clear();
+    m_styles = _styles;
+    m_pendingStyles.assign(m_scene.styles().size(), false);
+    m_skippedPendingStyles = false;
+    for (uint32_t id = 0; id < m_pendingStyles.size(); id++) {
+        if (m_scene.isStylePending(id)) {
+            m_pendingStyles[id] = true;
+            m_skippedPendingStyles = true;
+        }
+    }
+    if (m_scene.options().cpuPicking) { m_pickIndex = std::make_unique<PickIndex>(); }
 
     tile.initGeometry(int(m_scene.styles().size()));
 
@@ -115,14 +178,41 @@ void TileBuilder::build(Tile& tile, const TileData& _tileData, const TileSource&
       m_styleContext->setSceneGlobals(m_scene.config()["global"]);
     }
 
+    // Clip margin in pixels at the smallest size the tile is drawn, converted to tile units
+    float clipMargin = _source.clipMargin();
+    if (clipMargin >= 0.f) { clipMargin /= 256.f * std::exp2(float(tile.getID().s - tile.getID().z)); }
+
     for (auto& builder : m_styleBuilder) {
-        if (builder.second) { builder.second->setup(tile); }
+        if (builder.second && isBuilding(*builder.second)) {
+            builder.second->setup(tile);
+            builder.second->setClipMargin(clipMargin);
+            builder.second->setCoarse(_task && _task->isCoarse());
+        }
     }
 
+    if (m_triangulationCache) { prefetchTriangulations(tile, _tileData, _source); }
+
+    using Clock = std::chrono::steady_clock;
+    auto elapsed = [](Clock::time_point& _start) {
+        auto now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - _start).count();
+        _start = now;
+        return ms;
+    };
+    Clock::time_point start;
+    if (m_stats) { start = Clock::now(); }
+
     for (const auto& datalayer : m_scene.layers()) {
 
         if (datalayer.source() != _source.name() || !datalayer.enabled()) { continue; }
 
+        if (m_stats) { start = Clock::now(); }
+
+        float tolerance = simplifyTolerance(datalayer, tile, _source);
+        for (auto& builder : m_styleBuilder) {
+            if (builder.second) { builder.second->setSimplifyTolerance(tolerance); }
+        }
+
         for (const auto& collection : _tileData.layers) {
 
             if (!collection.name.empty()) {
@@ -133,26 +223,139 @@ void TileBuilder::build(Tile& tile, const TileData& _tileData, const TileSource&
                 if (!layerContainsCollection) { continue; }
             }
 
+            // Stop early when the tile is not needed anymore, e.g. scrolled off screen during fling
+            if (_task && _task->isCanceled()) { return abortBuild(); }
+
+            size_t count = 0;
+
+            // Join the fragments of lines to label them as a whole
+            m_mergedLines.clear();
+            bool merge = !datalayer.mergeLineKeys().empty() &&
+                m_lineMerger.merge(collection.features, datalayer.mergeLineKeys(),
+                                   m_mergedLines, m_mergedFragments);
+            auto isFragment = [&](const Feature& _feature) {
+                return merge && m_mergedFragments[&_feature - collection.features.data()];
+            };
+
+            // Evaluate JS functions for all features of the collection at once
+            bool batch = m_styleContext->hasBatchFunctions() && collection.features.size() > 1;
+            if (batch) {
+                m_styleContext->beginBatch(collection.features);
+                for (const auto& feat : collection.features) {
+                    m_mergedFragment = isFragment(feat);
+                    queueStyling(feat, datalayer);
+
+                    if (_task && ++count % CANCEL_CHECK_INTERVAL == 0 && _task->isCanceled()) {
+                        return abortBuild();
+                    }
+                }
+                m_styleContext->evalBatch();
+            }
+
             for (const auto& feat : collection.features) {
+                m_mergedFragment = isFragment(feat);
                 applyStyling(feat, datalayer);
+
+                if (_task && ++count % CANCEL_CHECK_INTERVAL == 0 && _task->isCanceled()) {
+                    return abortBuild();
+                }
             }
+            m_mergedFragment = false;
+
+            if (batch) { m_styleContext->endBatch(); }
+
+            m_mergedLine = true;
+            for (const auto& feat : m_mergedLines) { applyStyling(feat, datalayer); }
+            m_mergedLine = false;
+            // selection properties are shared by feature address, which the next merged lines may reuse
+            if (merge) { m_selectionFeature = nullptr; }
         }
+
+        if (m_stats) { m_stats->layers.emplace_back(datalayer.name(), elapsed(start)); }
     }
 
-    for (auto& builder : m_styleBuilder) {
+    if (_task && _task->isCanceled()) { return abortBuild(); }
 
-        builder.second->addLayoutItems(m_labelLayout);
+    for (auto& builder : m_styleBuilder) {
+        // NB: labels of styles that are not rebuilt keep their previous layout
+        if (isBuilding(*builder.second)) { builder.second->addLayoutItems(m_labelLayout); }
     }
 
     float tileSize = MapProjection::tileSize() * m_scene.pixelScale();
 
     m_labelLayout.process(tile.getID(), tile.getInverseScale(), tileSize);
 
+    if (m_stats) { m_stats->labels += elapsed(start); }
+
     for (auto& builder : m_styleBuilder) {
-        tile.setMesh(builder.second->style(), builder.second->build());
+        if (isBuilding(*builder.second)) {
+            tile.setMesh(builder.second->style(), builder.second->build());
+            if (builder.second->coarseBuilt()) { tile.setCoarse(true); }
+        }
     }
 
-    tile.setSelectionFeatures(m_selectionFeatures);
+    if (m_stats) { m_stats->meshes += elapsed(start); }
+
+    tile.setSelectionFeatures(std::move(m_selectionFeatures));
+    tile.setPickIndex(std::move(m_pickIndex));
+    m_selectionFeatures.clear();
+    m_selectionFeature = nullptr;
+    m_selectionProperties.reset();
+
+    return true;
+}
+
+bool TileBuilder::abortBuild() {
+    m_styleContext->endBatch();
+    m_mergedFragment = false;
+
+    // Discard partial geometry so the StyleBuilders are clean for the next tile
+    for (auto& builder : m_styleBuilder) {
+        builder.second->build();
+    }
+    m_selectionFeatures.clear();
+    m_pickIndex.reset();
+    m_selectionFeature = nullptr;
+    m_selectionProperties.reset();
+    return false;
+}
+
+float TileBuilder::simplifyTolerance(const DataLayer& _layer, const Tile& _tile, const TileSource& _source) const {
+    // Tolerance in pixels at the smallest size the tile is drawn (256px at its styling zoom),
+    // converted to tile units
+    float simplify = _layer.simplify() >= 0.f ? _layer.simplify() : _source.simplify();
+    float tilePixels = 256.f * std::exp2(float(_tile.getID().s - _tile.getID().z));
+    return simplify / tilePixels;
+}
+
+void TileBuilder::prefetchTriangulations(const Tile& _tile, const TileData& _tileData, const TileSource& _source) {
+
+    for (const auto& datalayer : m_scene.layers()) {
+
+        if (datalayer.source() != _source.name() || !datalayer.enabled()) { continue; }
+
+        // Polygons are simplified like by the style builders, so that their keys match
+        m_simplifier.setTolerance(simplifyTolerance(datalayer, _tile, _source));
+
+        for (const auto& collection : _tileData.layers) {
+
+            if (!collection.name.empty()) {
+                const auto& dlc = datalayer.collections();
+                if (std::find(dlc.begin(), dlc.end(), collection.name) == dlc.end()) { continue; }
+            }
+
+            for (const auto& feat : collection.features) {
+                if (feat.geometryType != GeometryType::polygons) { continue; }
+
+                for (auto polygon : feat.polygons()) {
+                    if (TriangulationCache::pointCount(polygon) < TriangulationCache::LARGE_POLYGON_POINTS) {
+                        continue;
+                    }
+                    m_triangulationCache->prefetch(m_simplifier.simplify(polygon));
+                }
+            }
+        }
+    }
 }
 
 }
@@ -5,12 +5,17 @@
 #include "scene/styleContext.h"
 #include "scene/drawRule.h"
 #include "style/style.h"
+#include "util/lineMerger.h"
 
 namespace Tangram {
 
+class CollisionCache;
 class DataLayer;
+class PickIndex;
 class Tile;
 class TileSource;
+class TileTask;
+class TriangulationCache;
 struct Feature;
 struct Properties;
 struct TileData;
@@ -19,28 +24,105 @@ class TileBuilder {
 
 public:
 
-    explicit TileBuilder(const Scene& _scene);
+    /// @_triangulationCache keeps polygon triangulations and @_collisionCache label collision
+    /// results across builds, may be null
+    explicit TileBuilder(const Scene& _scene, TriangulationCache* _triangulationCache = nullptr,
+                         CollisionCache* _collisionCache = nullptr);
+
+    ~TileBuilder();
 
     StyleBuilder* getStyleBuilder(const std::string& _name);
 
-    void build(Tile& tile, const TileData& _tileData, const TileSource& _source);
+    /// StyleContext of this builder, e.g. to evaluate the draw rules of markers built on its thread
+    StyleContext& styleContext() { return *m_styleContext; }
+
+    /// Build geometry for @tile; returns false if @_task got canceled while building.
+    /// If @_styles is set only meshes of the Styles set in it (by Style ID) are built.
+    bool build(Tile& tile, const TileData& _tileData, const TileSource& _source,
+               const TileTask* _task = nullptr, const std::vector<bool>* _styles = nullptr);
 
     const Scene& scene() const { return m_scene; }
 
+    /// Whether the last build() left out styles waiting for resources, see Scene::isStylePending()
+    bool skippedPendingStyles() const { return m_skippedPendingStyles; }
+
+    /// Time spent in the stages of build(), for benchmarks
+    struct BuildStats {
+        /// Milliseconds styling the features of each scene layer, in the order of the layers
+        std::vector<std::pair<std::string, double>> layers;
+        /// Milliseconds placing labels and compiling meshes
+        double labels = 0;
+        double meshes = 0;
+    };
+
+    /// Collect the times of the following builds into @_stats; null stops collecting
+    void setBuildStats(BuildStats* _stats) { m_stats = _stats; }
+
     // For testing
     TileBuilder(const Scene& _scene, StyleContext* _styleContext);
 
-    void init();
+    /// Set up the StyleContext and StyleBuilders for the Scene; @_styleContext of a released
+    /// TileBuilder is reused, which keeps its compiled functions when they are the same
+    void init(std::unique_ptr<StyleContext> _styleContext = nullptr);
+
+    /// Hand over the StyleContext, to reuse it with init() of the next TileBuilder
+    std::unique_ptr<StyleContext> releaseStyleContext() { return std::move(m_styleContext); }
 
 private:
 
     // Determine and apply DrawRules for a @_feature
     void applyStyling(const Feature& _feature, const SceneLayer& _layer);
 
+    // Queue the JS functions of the DrawRules for @_feature for batch evaluation
+    void queueStyling(const Feature& _feature, const SceneLayer& _layer);
+
+    // Reset StyleBuilders after a canceled build
+    bool abortBuild();
+
+    // Simplification tolerance in tile units for features of @_layer in @_tile
+    float simplifyTolerance(const DataLayer& _layer, const Tile& _tile, const TileSource& _source) const;
+
+    // Start triangulating the large polygons of the tile on the helper of m_triangulationCache
+    void prefetchTriangulations(const Tile& _tile, const TileData& _tileData, const TileSource& _source);
+
+    // Is @_builder used by the current build()?
+    bool isBuilding(const StyleBuilder& _builder) const {
+        auto id = _builder.style().getID();
+        if (id < m_pendingStyles.size() && m_pendingStyles[id]) { return false; }
+        return !m_styles || (id < m_styles->size() && (*m_styles)[id]);
+    }
+
+    // Is @_builder used for the current feature? The fragments of merged lines leave their
+    // labels to the merged lines, which are only labeled
+    bool isBuildingFeature(const StyleBuilder& _builder) const {
+        if (!isBuilding(_builder)) { return false; }
+        bool text = _builder.style().type() == StyleType::text;
+        return text ? !m_mergedFragment : !m_mergedLine;
+    }
+
     const Scene& m_scene;
 
+    TriangulationCache* m_triangulationCache = nullptr;
+    GeometrySimplifier m_simplifier;
+
     std::unique_ptr<StyleContext> m_styleContext;
     DrawRuleMergeSet m_ruleSet;
+
+    // Styles to build, all if null
+    const std::vector<bool>* m_styles = nullptr;
+
+    // Styles pending at the start of the current build, so that they are left out entirely
+    std::vector<bool> m_pendingStyles;
+    bool m_skippedPendingStyles = false;
+
+    // Line features of a collection merged for labels, see DataLayer::mergeLineKeys()
+    LineMerger m_lineMerger;
+    std::vector<Feature> m_mergedLines;
+    std::vector<bool> m_mergedFragments;
+    bool m_mergedFragment = false;
+    bool m_mergedLine = false;
+
+    BuildStats* m_stats = nullptr;
     int64_t globalsGeneration = 0;
 
     LabelCollider m_labelLayout;
@@ -48,6 +130,14 @@ private:
     fastmap<std::string, std::unique_ptr<StyleBuilder>> m_styleBuilder;
 
     fastmap<uint32_t, std::shared_ptr<Properties>> m_selectionFeatures;
+
+    // Copy of the properties of the last interactive feature, shared by the selection colors
+    // of all layers that style it
+    const Feature* m_selectionFeature = nullptr;
+    std::shared_ptr<Properties> m_selectionProperties;
+
+    // Geometry of interactive features, when picking on the CPU
+    std::unique_ptr<PickIndex> m_pickIndex;
 };
 
 }
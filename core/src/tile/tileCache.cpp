@@ -0,0 +1,380 @@
+#include "tile/tileCache.h"
+
+#include <algorithm>
+
+// Minimum number of evicted or taken keys remembered by Policy::arc
+#define MIN_HISTORY_ENTRIES 256
+
+namespace Tangram {
+
+constexpr uint32_t TileCache::NIL;
+
+TileCache::TileCache(size_t _cacheSizeBytes, Policy _policy) :
+    m_policy(_policy),
+    m_cacheMaxUsage(_cacheSizeBytes) {}
+
+void TileCache::put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
+    TileCacheKey key(_sourceId, _tile->getID());
+    size_t bytes = _tile->getMemoryUsage();
+
+    ListID target = recent;
+    uint32_t id = m_slots.empty() ? NIL : m_slots[findSlot(key)];
+
+    if (id != NIL) {
+        Entry& entry = m_entries[id];
+        const List& ghostR = m_lists[ghostRecent];
+        const List& ghostF = m_lists[ghostFrequent];
+
+        switch (entry.list) {
+        case recent:
+        case frequent:
+            // replace cached tile
+            m_cacheUsage -= entry.bytes;
+            target = entry.list;
+            break;
+        case ghostRecent: {
+            // recent list was too small - grow its share
+            size_t delta = std::max<size_t>(1, ghostF.bytes / std::max<size_t>(ghostR.bytes, 1)) * entry.bytes;
+            m_recentTarget = std::min(m_cacheMaxUsage, m_recentTarget + delta);
+            target = frequent;
+            break;
+        }
+        case ghostFrequent: {
+            // frequent list was too small - shrink share of recent list
+            size_t delta = std::max<size_t>(1, ghostR.bytes / std::max<size_t>(ghostF.bytes, 1)) * entry.bytes;
+            m_recentTarget = m_recentTarget > delta ? m_recentTarget - delta : 0;
+            target = frequent;
+            break;
+        }
+        case taken:
+            target = frequent;
+            break;
+        default:
+            assert(false);
+            break;
+        }
+        unlink(id);
+    } else {
+        id = allocEntry();
+        m_entries[id].key = key;
+        insertIndex(id);
+    }
+
+    if (m_policy != Policy::arc) { target = recent; }
+
+    Entry& entry = m_entries[id];
+    if (entry.heapPos != NIL) { heapRemove(id); }
+    entry.value = m_inflation + double(_tile->buildCost()) / std::max<size_t>(bytes, 1);
+    entry.tile = std::move(_tile);
+    entry.bytes = bytes;
+    link(id, target);
+    m_cacheUsage += bytes;
+
+    if (m_policy == Policy::cost) { heapPush(id); }
+
+    limitCacheSize(m_cacheMaxUsage);
+}
+
+std::shared_ptr<Tile> TileCache::get(int32_t _sourceId, TileID _tileId) {
+    std::shared_ptr<Tile> tile;
+    if (m_slots.empty()) {
+        m_stats.misses++;
+        return tile;
+    }
+
+    uint32_t id = m_slots[findSlot({_sourceId, _tileId})];
+    if (id == NIL || (m_entries[id].list != recent && m_entries[id].list != frequent)) {
+        m_stats.misses++;
+        return tile;
+    }
+
+    Entry& entry = m_entries[id];
+    std::swap(tile, entry.tile);
+    m_cacheUsage -= entry.bytes;
+    m_stats.hits++;
+
+    if (m_policy == Policy::arc) {
+        // remember key so that the tile goes to frequent list when it is cached again
+        unlink(id);
+        link(id, taken);
+        trimHistory();
+    } else {
+        release(id);
+    }
+    return tile;
+}
+
+std::shared_ptr<Tile> TileCache::contains(int32_t _sourceId, TileID _tileId) const {
+    if (m_slots.empty()) { return nullptr; }
+
+    uint32_t id = m_slots[findSlot({_sourceId, _tileId})];
+    if (id == NIL) { return nullptr; }
+
+    return m_entries[id].tile;
+}
+
+void TileCache::limitCacheSize(size_t _cacheSizeBytes) {
+    m_cacheMaxUsage = _cacheSizeBytes;
+    m_recentTarget = std::min(m_recentTarget, m_cacheMaxUsage);
+
+    while (m_cacheUsage > m_cacheMaxUsage) {
+        const List& r = m_lists[recent];
+        const List& f = m_lists[frequent];
+
+        if (m_policy == Policy::cost && !m_heap.empty()) {
+            uint32_t id = m_heap.front();
+            m_inflation = m_entries[id].value;
+            evict(id);
+            continue;
+        }
+
+        ListID victim = recent;
+        if (r.count == 0 || (m_policy == Policy::arc && r.bytes <= m_recentTarget && f.count > 0)) {
+            victim = frequent;
+        }
+        if (m_lists[victim].tail == NIL) {
+            LOGE("Invalid cache state!");
+            m_cacheUsage = 0;
+            break;
+        }
+        evict(m_lists[victim].tail);
+    }
+    trimHistory();
+}
+
+void TileCache::trim(size_t _bytes) {
+    size_t limit = m_cacheMaxUsage;
+    limitCacheSize(std::min(_bytes, limit));
+    m_cacheMaxUsage = limit;
+}
+
+void TileCache::forEach(const std::function<void(const Tile&)>& _fn) const {
+    for (const auto& entry : m_entries) {
+        if (entry.tile) { _fn(*entry.tile); }
+    }
+}
+
+void TileCache::clear() {
+    m_entries.clear();
+    m_slots.clear();
+    m_numIndexed = 0;
+    for (auto& list : m_lists) { list = List(); }
+    m_heap.clear();
+    m_recentTarget = 0;
+    m_inflation = 0;
+    m_cacheUsage = 0;
+}
+
+void TileCache::setPolicy(Policy _policy) {
+    if (_policy == m_policy) { return; }
+    Policy previous = m_policy;
+    m_policy = _policy;
+
+    if (previous == Policy::arc) {
+        // move reused tiles to the recent end, oldest first to keep their order
+        while (m_lists[frequent].tail != NIL) {
+            uint32_t id = m_lists[frequent].tail;
+            unlink(id);
+            link(id, recent);
+        }
+        for (ListID list : { ghostRecent, ghostFrequent, taken }) {
+            while (m_lists[list].tail != NIL) { release(m_lists[list].tail); }
+        }
+        m_recentTarget = 0;
+    }
+
+    if (m_policy == Policy::cost) {
+        // oldest first, so that ties are evicted in LRU order
+        m_inflation = 0;
+        for (uint32_t id = m_lists[recent].tail; id != NIL; id = m_entries[id].prev) {
+            Entry& entry = m_entries[id];
+            entry.value = double(entry.tile->buildCost()) / std::max<size_t>(entry.bytes, 1);
+            heapPush(id);
+        }
+    } else {
+        for (uint32_t id : m_heap) { m_entries[id].heapPos = NIL; }
+        m_heap.clear();
+    }
+}
+
+size_t TileCache::findSlot(const TileCacheKey& _key) const {
+    size_t mask = m_slots.size() - 1;
+    size_t slot = std::hash<TileCacheKey>()(_key) & mask;
+
+    while (m_slots[slot] != NIL && m_entries[m_slots[slot]].key != _key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void TileCache::insertIndex(uint32_t _entry) {
+    // keep load factor below 1/2
+    if ((m_numIndexed + 1) * 2 > m_slots.size()) {
+        rehash(std::max<size_t>(64, m_slots.size() * 2));
+    }
+    size_t slot = findSlot(m_entries[_entry].key);
+    assert(m_slots[slot] == NIL);
+    m_slots[slot] = _entry;
+    m_numIndexed++;
+}
+
+void TileCache::eraseIndex(const TileCacheKey& _key) {
+    size_t mask = m_slots.size() - 1;
+    size_t slot = findSlot(_key);
+    if (m_slots[slot] == NIL) { return; }
+
+    m_slots[slot] = NIL;
+    m_numIndexed--;
+
+    // backward shift following entries of the probe sequence, so that lookups need no tombstones
+    size_t next = (slot + 1) & mask;
+    while (m_slots[next] != NIL) {
+        size_t home = std::hash<TileCacheKey>()(m_entries[m_slots[next]].key) & mask;
+        // move entry if its home slot is not cyclically within (slot, next]
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            m_slots[slot] = m_slots[next];
+            m_slots[next] = NIL;
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+}
+
+void TileCache::rehash(size_t _numSlots) {
+    m_slots.assign(_numSlots, NIL);
+    size_t mask = _numSlots - 1;
+
+    for (uint32_t id = 0; id < m_entries.size(); id++) {
+        if (m_entries[id].list == unused) { continue; }
+        size_t slot = std::hash<TileCacheKey>()(m_entries[id].key) & mask;
+        while (m_slots[slot] != NIL) { slot = (slot + 1) & mask; }
+        m_slots[slot] = id;
+    }
+}
+
+uint32_t TileCache::allocEntry() {
+    uint32_t id = m_lists[unused].head;
+    if (id != NIL) {
+        unlink(id);
+        return id;
+    }
+    m_entries.emplace_back();
+    return uint32_t(m_entries.size() - 1);
+}
+
+void TileCache::link(uint32_t _entry, ListID _list) {
+    Entry& entry = m_entries[_entry];
+    List& list = m_lists[_list];
+
+    entry.list = _list;
+    entry.prev = NIL;
+    entry.next = list.head;
+    if (list.head != NIL) { m_entries[list.head].prev = _entry; }
+    list.head = _entry;
+    if (list.tail == NIL) { list.tail = _entry; }
+    list.count++;
+    list.bytes += entry.bytes;
+}
+
+void TileCache::unlink(uint32_t _entry) {
+    Entry& entry = m_entries[_entry];
+    List& list = m_lists[entry.list];
+
+    if (entry.prev != NIL) { m_entries[entry.prev].next = entry.next; }
+    else { list.head = entry.next; }
+    if (entry.next != NIL) { m_entries[entry.next].prev = entry.prev; }
+    else { list.tail = entry.prev; }
+
+    list.count--;
+    list.bytes -= entry.bytes;
+    entry.prev = entry.next = NIL;
+}
+
+void TileCache::release(uint32_t _entry) {
+    Entry& entry = m_entries[_entry];
+    if (entry.heapPos != NIL) { heapRemove(_entry); }
+    unlink(_entry);
+    eraseIndex(entry.key);
+    entry.tile.reset();
+    entry.bytes = 0;
+    link(_entry, unused);
+}
+
+void TileCache::evict(uint32_t _entry) {
+    Entry& entry = m_entries[_entry];
+    ListID list = entry.list;
+
+    m_cacheUsage -= entry.bytes;
+    m_stats.evictions++;
+
+    if (m_policy == Policy::arc) {
+        // keep key and size to detect misses on recently evicted tiles
+        unlink(_entry);
+        entry.tile.reset();
+        link(_entry, list == recent ? ghostRecent : ghostFrequent);
+    } else {
+        release(_entry);
+    }
+}
+
+void TileCache::heapPush(uint32_t _entry) {
+    m_heap.push_back(_entry);
+    heapSet(m_heap.size() - 1, _entry);
+    heapSiftUp(m_heap.size() - 1);
+}
+
+void TileCache::heapRemove(uint32_t _entry) {
+    size_t pos = m_entries[_entry].heapPos;
+    m_entries[_entry].heapPos = NIL;
+
+    uint32_t last = m_heap.back();
+    m_heap.pop_back();
+    if (pos == m_heap.size()) { return; }
+
+    heapSet(pos, last);
+    heapSiftUp(pos);
+    heapSiftDown(m_entries[last].heapPos);
+}
+
+void TileCache::heapSiftUp(size_t _pos) {
+    uint32_t id = m_heap[_pos];
+    while (_pos > 0) {
+        size_t parent = (_pos - 1) / 2;
+        if (m_entries[m_heap[parent]].value <= m_entries[id].value) { break; }
+        heapSet(_pos, m_heap[parent]);
+        _pos = parent;
+    }
+    heapSet(_pos, id);
+}
+
+void TileCache::heapSiftDown(size_t _pos) {
+    uint32_t id = m_heap[_pos];
+    size_t size = m_heap.size();
+    while (true) {
+        size_t child = 2 * _pos + 1;
+        if (child >= size) { break; }
+        if (child + 1 < size && m_entries[m_heap[child + 1]].value < m_entries[m_heap[child]].value) { child++; }
+        if (m_entries[id].value <= m_entries[m_heap[child]].value) { break; }
+        heapSet(_pos, m_heap[child]);
+        _pos = child;
+    }
+    heapSet(_pos, id);
+}
+
+void TileCache::heapSet(size_t _pos, uint32_t _entry) {
+    m_heap[_pos] = _entry;
+    m_entries[_entry].heapPos = uint32_t(_pos);
+}
+
+size_t TileCache::historyLimit() const {
+    return std::max<size_t>(getNumEntries(), MIN_HISTORY_ENTRIES);
+}
+
+void TileCache::trimHistory() {
+    size_t limit = historyLimit();
+    for (ListID list : { ghostRecent, ghostFrequent, taken }) {
+        while (m_lists[list].count > limit) { release(m_lists[list].tail); }
+    }
+}
+
+}
@@ -5,9 +5,10 @@
 #include "tile/tileHash.h"
 #include "tile/tileID.h"
 
-#include <list>
+#include <cstdint>
+#include <functional>
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
 namespace Tangram {
 // TileSet serial + TileID
@@ -28,96 +29,150 @@ namespace std {
 
 namespace Tangram {
 
+/* In-memory cache of built Tiles that are currently not in use
+ *
+ * Entries live in a slab with index links, so that put() and get() do not allocate once
+ * the slab and the index have grown to the working set. The byte total is maintained on
+ * put and evict, using the memory usage of a Tile at the time it was cached.
+ *
+ * With Policy::arc, tiles that were taken from the cache and put back again are kept in
+ * a separate 'frequent' list and the share of the budget for once-seen tiles adapts to
+ * misses on recently evicted keys, like in the Adaptive Replacement Cache. This keeps the
+ * tiles of a frequently revisited area cached while panning over a long distance.
+ *
+ * With Policy::cost, eviction follows GreedyDual-Size: a tile is valued by its rebuild cost
+ * (Tile::buildCost()) per byte plus an inflation value that is raised to the value of each
+ * evicted tile, so that cheap tiles go first and expensive tiles age out only slowly.
+ */
 class TileCache {
-    struct CacheEntry {
-        TileCacheKey key;
-        std::shared_ptr<Tile> tile;
+
+public:
+
+    enum class Policy : uint8_t {
+        lru,  // evict least recently cached tile
+        arc,  // adaptive replacement: reused tiles are protected from one-time tiles
+        cost, // GreedyDual-Size: evict tile with least rebuild cost per byte, aged by recency
     };
 
-    using CacheList = std::list<CacheEntry>;
-    using CacheMap = std::unordered_map<TileCacheKey, typename CacheList::iterator>;
+    struct Stats {
+        uint64_t hits = 0;       // get() returned a tile
+        uint64_t misses = 0;     // get() found no tile
+        uint64_t evictions = 0;  // tiles dropped to stay within the size limit
+    };
 
-public:
+    explicit TileCache(size_t _cacheSizeBytes, Policy _policy = Policy::lru);
 
-    TileCache(size_t _cacheSizeMB) :
-        m_cacheUsage(0),
-        m_cacheMaxUsage(_cacheSizeMB) {}
+    void put(int32_t _sourceId, std::shared_ptr<Tile> _tile);
 
-    void put(int32_t _sourceId, std::shared_ptr<Tile> _tile) {
-        TileCacheKey k(_sourceId, _tile->getID());
+    // Remove tile from cache and return it, or nullptr if not cached
+    std::shared_ptr<Tile> get(int32_t _sourceId, TileID _tileId);
 
-        m_cacheList.push_front({k, _tile});
-        m_cacheMap[k] = m_cacheList.begin();
-        m_cacheUsage += _tile->getMemoryUsage();
+    // Return cached tile without removing it
+    std::shared_ptr<Tile> contains(int32_t _sourceId, TileID _tileId) const;
 
-        limitCacheSize(m_cacheMaxUsage);
-    }
+    size_t cacheSizeLimit() const { return m_cacheMaxUsage; }
 
-    std::shared_ptr<Tile> get(int32_t _sourceId, TileID _tileId) {
-        std::shared_ptr<Tile> tile;
-        TileCacheKey k(_sourceId, _tileId);
-
-        auto it = m_cacheMap.find(k);
-        if (it != m_cacheMap.end()) {
-            std::swap(tile, (*(it->second)).tile);
-            m_cacheList.erase(it->second);
-            m_cacheMap.erase(it);
-            m_cacheUsage -= tile->getMemoryUsage();
-        }
-        return tile;
-    }
+    void limitCacheSize(size_t _cacheSizeBytes);
 
-    std::shared_ptr<Tile> contains(int32_t _source, TileID _tileID) {
-        std::shared_ptr<Tile> tile;
-        TileCacheKey k(_source, _tileID);
+    // Evict tiles until at most _bytes are used, keeping the cache size limit
+    void trim(size_t _bytes);
 
-        auto it = m_cacheMap.find(k);
-        if (it != m_cacheMap.end()) {
-            return it->second->tile;
-        }
-        return nullptr;
-    }
+    size_t getMemoryUsage() const { return m_cacheUsage; }
 
-    size_t cacheSizeLimit() const { return m_cacheMaxUsage; }
+    size_t getNumEntries() const { return m_lists[recent].count + m_lists[frequent].count; }
 
-    void limitCacheSize(size_t _cacheSizeBytes) {
-        m_cacheMaxUsage = _cacheSizeBytes;
-
-        while (m_cacheUsage > m_cacheMaxUsage) {
-            if (m_cacheList.empty()) {
-                LOGE("Invalid cache state!");
-                m_cacheUsage = 0;
-                break;
-            }
-            auto& tile = m_cacheList.back().tile;
-            m_cacheUsage -= tile->getMemoryUsage();
-            m_cacheMap.erase(m_cacheList.back().key);
-            m_cacheList.pop_back();
-        }
-    }
+    // Call _fn with each cached tile
+    void forEach(const std::function<void(const Tile&)>& _fn) const;
 
-    size_t getMemoryUsage() const {
-        size_t sum = 0;
-        for (auto& entry : m_cacheList) {
-            sum += entry.tile->getMemoryUsage();
-        }
-        return sum;
-    }
+    void clear();
+
+    // Switching away from Policy::arc treats reused tiles as recently cached and drops eviction history
+    void setPolicy(Policy _policy);
+    Policy policy() const { return m_policy; }
 
-    size_t getNumEntries() const { return m_cacheList.size(); }
+    // Policy::arc: bytes of the size limit targeted for tiles that were cached once
+    size_t recentTarget() const { return m_recentTarget; }
 
-    void clear() {
-        m_cacheMap.clear();
-        m_cacheList.clear();
-        m_cacheUsage = 0;
-    }
+    const Stats& stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
 
 private:
-    CacheMap m_cacheMap;
-    CacheList m_cacheList;
 
-    size_t m_cacheUsage;
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    enum ListID : uint8_t {
+        recent,         // cached once
+        frequent,       // cached again after being taken from the cache (arc)
+        ghostRecent,    // keys evicted from recent (arc)
+        ghostFrequent,  // keys evicted from frequent (arc)
+        taken,          // keys of tiles taken from the cache (arc)
+        unused,         // free slab entries
+        numLists
+    };
+
+    struct Entry {
+        TileCacheKey key{0, TileID(0, 0, 0)};
+        std::shared_ptr<Tile> tile;
+        size_t bytes = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        ListID list = unused;
+        // cost: GreedyDual-Size value and position in m_heap
+        double value = 0;
+        uint32_t heapPos = NIL;
+    };
+
+    // Doubly linked list over slab entries; head is most recent
+    struct List {
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+        size_t count = 0;
+        size_t bytes = 0;
+    };
+
+    // Index slot holding the entry for _key, or the empty slot where it would be inserted
+    size_t findSlot(const TileCacheKey& _key) const;
+    void insertIndex(uint32_t _entry);
+    void eraseIndex(const TileCacheKey& _key);
+    void rehash(size_t _numSlots);
+
+    uint32_t allocEntry();
+    void link(uint32_t _entry, ListID _list);
+    void unlink(uint32_t _entry);
+    // Unlink and remove from index
+    void release(uint32_t _entry);
+
+    void evict(uint32_t _entry);
+
+    // Min-heap of cached entries by value for Policy::cost
+    void heapPush(uint32_t _entry);
+    void heapRemove(uint32_t _entry);
+    void heapSiftUp(size_t _pos);
+    void heapSiftDown(size_t _pos);
+    void heapSet(size_t _pos, uint32_t _entry);
+
+    void trimHistory();
+    size_t historyLimit() const;
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_slots;
+    size_t m_numIndexed = 0;
+
+    List m_lists[numLists];
+
+    Policy m_policy;
+
+    // arc: target bytes for recent list
+    size_t m_recentTarget = 0;
+
+    // cost: inflation value, i.e. value of the last evicted entry
+    double m_inflation = 0;
+    std::vector<uint32_t> m_heap;
+
+    size_t m_cacheUsage = 0;
     size_t m_cacheMaxUsage;
+
+    Stats m_stats;
 };
 
 }
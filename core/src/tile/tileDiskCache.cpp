@@ -0,0 +1,214 @@
+#include "tile/tileDiskCache.h"
+
+#include "data/tileSource.h"
+#include "gl/mesh.h"
+#include "log.h"
+#include "style/style.h"
+#include "tile/tile.h"
+#include "util/util.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#define TILE_DISK_CACHE_MAGIC 0x434d4754 // "TGMC"
+#define TILE_DISK_CACHE_VERSION 3
+
+namespace Tangram {
+
+struct TileDiskCache::Header {
+    uint32_t magic = TILE_DISK_CACHE_MAGIC;
+    uint32_t version = TILE_DISK_CACHE_VERSION;
+    uint64_t sceneKey = 0;
+    uint64_t sourceKey = 0;
+    int64_t sourceGeneration = 0;
+    int32_t x = 0, y = 0, z = 0, s = 0;
+    float pixelScale = 0;
+    float buildCost = 0;
+    int64_t created = 0;
+    uint32_t numMeshes = 0;
+    uint32_t numMissing = 0;
+
+    bool matches(const Header& _other) const {
+        return magic == _other.magic && version == _other.version &&
+            sceneKey == _other.sceneKey && sourceKey == _other.sourceKey &&
+            sourceGeneration == _other.sourceGeneration &&
+            x == _other.x && y == _other.y && z == _other.z && s == _other.s &&
+            pixelScale == _other.pixelScale;
+    }
+};
+
+TileDiskCache::TileDiskCache(std::string _path, uint64_t _sceneKey, int64_t _maxAge) :
+    m_path(std::move(_path)),
+    m_sceneKey(_sceneKey),
+    m_maxAge(_maxAge) {}
+
+uint64_t TileDiskCache::hash(const void* _data, size_t _size, uint64_t _seed) {
+    auto bytes = static_cast<const uint8_t*>(_data);
+    uint64_t h = _seed;
+    for (size_t i = 0; i < _size; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+TileDiskCache::Header TileDiskCache::header(const TileSource& _source, const TileID& _tileID,
+                                            float _pixelScale) const {
+    Header h;
+    h.sceneKey = m_sceneKey;
+    h.sourceKey = hash(_source.name());
+    h.sourceGeneration = _source.generation();
+    h.x = _tileID.x;
+    h.y = _tileID.y;
+    h.z = _tileID.z;
+    h.s = _tileID.s;
+    h.pixelScale = _pixelScale;
+    return h;
+}
+
+std::string TileDiskCache::filename(const Header& _header) const {
+    uint64_t key = hash(&_header.sceneKey, sizeof(_header.sceneKey));
+    key = hash(&_header.sourceKey, sizeof(_header.sourceKey), key);
+    key = hash(&_header.sourceGeneration, sizeof(_header.sourceGeneration), key);
+    int32_t coords[] = { _header.x, _header.y, _header.z, _header.s };
+    key = hash(coords, sizeof(coords), key);
+    key = hash(&_header.pixelScale, sizeof(_header.pixelScale), key);
+
+    char name[32];
+    snprintf(name, sizeof(name), "tilemesh_%016llx.bin", (unsigned long long)key);
+    return m_path + name;
+}
+
+std::unique_ptr<Tile> TileDiskCache::load(const TileSource& _source, const TileID& _tileID, float _pixelScale,
+                                          const std::vector<std::unique_ptr<Style>>& _styles,
+                                          std::vector<bool>& _missing) const {
+
+    Header expected = header(_source, _tileID, _pixelScale);
+
+    std::ifstream file(filename(expected), std::ifstream::ate | std::ifstream::binary);
+    if (!file.is_open()) { return nullptr; }
+
+    std::vector<char> data(size_t(file.tellg()));
+    file.seekg(std::ifstream::beg);
+    file.read(data.data(), data.size());
+    if (!file) { return nullptr; }
+
+    const char* pos = data.data();
+    const char* end = pos + data.size();
+
+    Header stored;
+    if (data.size() < sizeof(Header)) { return nullptr; }
+    std::memcpy(&stored, pos, sizeof(Header));
+    pos += sizeof(Header);
+
+    if (!stored.matches(expected)) { return nullptr; }
+    if (m_maxAge > 0 && int64_t(secSinceEpoch()) - stored.created > m_maxAge) { return nullptr; }
+
+    auto findStyle = [&]() -> const Style* {
+        uint32_t length = 0;
+        if (size_t(end - pos) < sizeof(length)) { return nullptr; }
+        std::memcpy(&length, pos, sizeof(length));
+        pos += sizeof(length);
+        if (size_t(end - pos) < length) { return nullptr; }
+        std::string name(pos, length);
+        pos += length;
+
+        for (const auto& style : _styles) {
+            if (style->getName() == name) { return style.get(); }
+        }
+        return nullptr;
+    };
+
+    auto tile = std::make_unique<Tile>(_tileID, _source.id(), _source.generation());
+    tile->initGeometry(uint32_t(_styles.size()));
+    tile->setBuildCost(stored.buildCost);
+
+    for (uint32_t i = 0; i < stored.numMeshes; i++) {
+        const Style* style = findStyle();
+        if (!style) { return nullptr; }
+
+        // Tiles with selectable features are not stored
+        auto mesh = std::make_unique<CompiledMesh>(style->meshLayout(false), style->drawMode());
+        if (!mesh->deserialize(pos, end)) {
+            LOGW("Invalid mesh for style '%s' in tile disk cache: %s", style->getName().c_str(),
+                 _tileID.toString().c_str());
+            return nullptr;
+        }
+        tile->setMesh(*style, std::move(mesh));
+    }
+
+    _missing.assign(_styles.size(), false);
+    for (uint32_t i = 0; i < stored.numMissing; i++) {
+        const Style* style = findStyle();
+        if (!style) { return nullptr; }
+        _missing[style->getID()] = true;
+    }
+
+    return tile;
+}
+
+bool TileDiskCache::store(const TileSource& _source, const Tile& _tile, float _pixelScale,
+                          const std::vector<std::unique_ptr<Style>>& _styles) const {
+
+    // selection colors baked into the meshes are only valid in this session
+    if (_tile.getSelectionFeatures().size() > 0) { return false; }
+
+    Header h = header(_source, _tile.getID(), _pixelScale);
+    h.buildCost = _tile.buildCost();
+    h.created = int64_t(secSinceEpoch());
+
+    std::vector<char> meshes;
+    std::vector<char> missing;
+
+    auto appendName = [](std::vector<char>& _out, const std::string& _name) {
+        uint32_t length = uint32_t(_name.size());
+        auto bytes = reinterpret_cast<const char*>(&length);
+        _out.insert(_out.end(), bytes, bytes + sizeof(length));
+        _out.insert(_out.end(), _name.begin(), _name.end());
+    };
+
+    for (const auto& style : _styles) {
+        const auto& mesh = _tile.getMesh(*style);
+        if (!mesh) { continue; }
+
+        size_t size = meshes.size();
+        appendName(meshes, style->getName());
+        if (mesh->serialize(meshes)) {
+            h.numMeshes++;
+        } else {
+            meshes.resize(size);
+            appendName(missing, style->getName());
+            h.numMissing++;
+        }
+    }
+
+    if (h.numMeshes == 0) { return false; }
+
+    std::string path = filename(h);
+    std::string tmpPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    std::ofstream file(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    file.write(meshes.data(), meshes.size());
+    file.write(missing.data(), missing.size());
+    file.close();
+
+    if (!file) {
+        LOGW("Cannot write tile disk cache entry: %s", tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // rename does not replace existing files on all platforms
+    std::remove(path.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
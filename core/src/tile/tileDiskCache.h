@@ -0,0 +1,70 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+class Style;
+class Tile;
+class TileSource;
+
+/* Persistent cache of built tile meshes
+ *
+ * Each entry is a file in the cache directory holding the compiled meshes of a Tile,
+ * keyed by Scene content, TileSource name and generation, TileID and pixel scale. Only
+ * static meshes can be stored (see StyledMesh::serialize()): styles with labels are
+ * recorded as missing and have to be built again from the TileData when the entry is
+ * loaded. Tiles with selection features are not stored since selection colors are
+ * assigned per session.
+ *
+ * load() and store() run on TileWorker threads; concurrent stores of the same tile
+ * write to separate temporary files which are renamed when complete.
+ */
+class TileDiskCache {
+
+public:
+
+    TileDiskCache(std::string _path, uint64_t _sceneKey, int64_t _maxAge);
+
+    /* Key of the Scene content; entries stored with another key are not loaded */
+    void setSceneKey(uint64_t _sceneKey) { m_sceneKey = _sceneKey; }
+    uint64_t sceneKey() const { return m_sceneKey; }
+
+    /* Returns Tile with stored meshes, or nullptr if there is no valid entry; @_missing is
+     * set for styles (by Style ID) which had meshes that could not be stored */
+    std::unique_ptr<Tile> load(const TileSource& _source, const TileID& _tileID, float _pixelScale,
+                               const std::vector<std::unique_ptr<Style>>& _styles,
+                               std::vector<bool>& _missing) const;
+
+    /* Store meshes of @_tile; returns false if the tile cannot be stored */
+    bool store(const TileSource& _source, const Tile& _tile, float _pixelScale,
+               const std::vector<std::unique_ptr<Style>>& _styles) const;
+
+    /* Stable 64 bit FNV-1a hash for keys that persist across sessions */
+    static uint64_t hash(const void* _data, size_t _size, uint64_t _seed = 14695981039346656037ULL);
+    static uint64_t hash(const std::string& _data, uint64_t _seed = 14695981039346656037ULL) {
+        return hash(_data.data(), _data.size(), _seed);
+    }
+
+private:
+
+    struct Header;
+
+    Header header(const TileSource& _source, const TileID& _tileID, float _pixelScale) const;
+    std::string filename(const Header& _header) const;
+
+    const std::string m_path;
+
+    std::atomic<uint64_t> m_sceneKey;
+
+    // seconds after which entries are not loaded anymore, 0 for no limit
+    const int64_t m_maxAge;
+};
+
+}
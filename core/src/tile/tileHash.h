@@ -6,12 +6,15 @@
 namespace std {
     template <>
     struct hash<Tangram::TileID> {
+        // Finalizer of MurmurHash3 over the packed key, so that all bits of the key mix
         size_t operator()(const Tangram::TileID& k) const {
-            std::size_t seed = 0;
-            hash_combine(seed, k.x);
-            hash_combine(seed, k.y);
-            hash_combine(seed, k.z);
-            return seed;
+            uint64_t h = k.key();
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ull;
+            h ^= h >> 33;
+            return size_t(h);
         }
     };
 }
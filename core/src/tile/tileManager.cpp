@@ -2,31 +2,76 @@
 
 #include "data/tileSource.h"
 #include "data/rasterSource.h"
+#include "debug/trace.h"
+#include "gl/mesh.h"
 #include "map.h"
 #include "platform.h"
+#include "scene/scene.h"
+#include "selection/pickIndex.h"
 #include "tile/tile.h"
+#include "tile/tileAvailability.h"
 #include "tile/tileCache.h"
 #include "util/mapProjection.h"
+#include "util/objectPool.h"
 #include "view/view.h"
 
 #include "glm/gtx/norm.hpp"
 
 #include <algorithm>
 #include <bitset>
+#include <cfloat>
+#include <iterator>
 
 namespace Tangram {
 
 #define MAX_TILE_SETS 64
 
+// Tiles covering less than this part of their screen area in an untilted view are built coarse,
+// see TileTask::setCoarse(); coarse tiles are loaded again once they cover the larger part
+#define COARSE_TILE_AREA 0.25
+#define DETAILED_TILE_AREA 0.5
+
+// Rebuilds requested with low priority count like tiles this many times farther from the view
+#define LOW_PRIORITY_REBUILD_FACTOR 64.0
+
+// Zooms up from a raster sub-task to look for a loaded ancestor to show until the raster is decoded
+#define MAX_RASTER_FALLBACK_DEPTH 4
+
 struct TileManager::TileEntry {
 
     TileEntry(std::shared_ptr<Tile>& _tile) : tile(_tile) {}
 
-    ~TileEntry() { clearTask(); }
+    ~TileEntry() {
+        clearTask();
+        clearPendingRasters();
+    }
+
+    TileEntry(const TileEntry&) = delete;
+    TileEntry& operator=(const TileEntry&) = delete;
+
+    // moved-from entries hold no task, so their destruction does not cancel it
+    TileEntry(TileEntry&&) = default;
+
+    TileEntry& operator=(TileEntry&& _other) {
+        clearTask();
+        clearPendingRasters();
+        tile = std::move(_other.tile);
+        task = std::move(_other.task);
+        pendingRasters = std::move(_other.pendingRasters);
+        m_proxyCounter = _other.m_proxyCounter;
+        numMissingRasters = _other.numMissingRasters;
+        m_visible = _other.m_visible;
+        m_prefetch = _other.m_prefetch;
+        return *this;
+    }
 
     std::shared_ptr<Tile> tile;
     std::shared_ptr<TileTask> task;
 
+    // Raster sub-tasks still loading when the tile was completed, by index of the ancestor raster shown
+    // in their place in Tile::rasters(); kept when the tile is restyled, which keeps its rasters
+    std::vector<std::pair<size_t, std::shared_ptr<TileTask>>> pendingRasters;
+
     /* A Counter for number of tiles this tile acts a proxy for */
     int32_t m_proxyCounter = 0;
 
@@ -36,6 +81,9 @@ struct TileManager::TileEntry {
     // is tile in TileSet.visibleTiles?
     bool m_visible = false;
 
+    // is tile in TileSet.prefetchTiles?
+    bool m_prefetch = false;
+
     bool isInProgress() {
         return bool(task) && !task->isCanceled();
     }
@@ -44,6 +92,11 @@ struct TileManager::TileEntry {
         return bool(task) && task->isCanceled();
     }
 
+    // tile can be drawn, i.e. it needs no proxy; a tile is not drawn before TileUploader uploaded it
+    bool isDrawable() {
+        return bool(tile) && tile->isUploaded();
+    }
+
     bool needsLoading() {
         if (bool(tile)) { return false; }
         if (!task) { return true; }
@@ -59,20 +112,42 @@ struct TileManager::TileEntry {
     // Complete task only when
     // - task still exists
     // - task has a tile ready
-    // - tile has all rasters set
+    // - tile has all rasters set, or a loaded ancestor of each raster still loading to show meanwhile
     bool completeTileTask() {
         if (bool(task) && task->isReady()) {
 
-            for (auto& subtask : task->subTasks()) {
-                if (!subtask->isReady() && !subtask->isCanceled()) { return false; }
+            auto& subTasks = task->subTasks();
+            std::vector<Raster> fallbacks;
+            for (auto& subtask : subTasks) {
+                if (!subtask->isReady() && !subtask->isCanceled()) {
+                    auto source = static_cast<RasterSource*>(subtask->source());
+                    fallbacks.push_back(source->getAncestorRaster(subtask->tileId(), MAX_RASTER_FALLBACK_DEPTH));
+                    if (!fallbacks.back().isValid()) { return false; }
+                } else {
+                    fallbacks.emplace_back(NOT_A_TILE, nullptr);
+                }
             }
 
             task->complete();
             --task->shareCount;
-            for (auto& subtask : task->subTasks()) {
-              --subtask->shareCount;
-            }
             tile = task->getTile();
+
+            if (!subTasks.empty()) { clearPendingRasters(); }
+            auto& rasters = tile->rasters();
+            size_t offset = rasters.size() - subTasks.size();
+            for (size_t i = 0; i < subTasks.size(); i++) {
+                auto& subtask = subTasks[i];
+                auto& raster = rasters[offset + i];
+                auto source = static_cast<RasterSource*>(subtask->source());
+                // still loading, unless it got ready while completing
+                if (fallbacks[i].isValid() && raster.texture == source->emptyTexture()) {
+                    raster.tileID = fallbacks[i].tileID;
+                    raster.texture = fallbacks[i].texture;
+                    pendingRasters.emplace_back(offset + i, subtask);
+                } else {
+                    --subtask->shareCount;
+                }
+            }
             task.reset();
             numMissingRasters = -1;  // tile for ClientDataSource can be replaced w/o new TileEntry
 
@@ -81,6 +156,44 @@ struct TileManager::TileEntry {
         return false;
     }
 
+    // Swap in the rasters of pending sub-tasks that are ready, retrying to load those that could not
+    // start loading with @_cb; returns true if any raster was replaced
+    bool updatePendingRasters(const TileTaskCb& _cb) {
+        bool changed = false;
+        for (auto it = pendingRasters.begin(); it != pendingRasters.end();) {
+            auto& subtask = it->second;
+            if (!subtask->isReady() && !subtask->isCanceled()) {
+                if (subtask->needsLoading()) { subtask->source()->loadTileData(subtask, _cb); }
+                ++it;
+                continue;
+            }
+
+            auto source = static_cast<RasterSource*>(subtask->source());
+            auto raster = source->takeRaster(*subtask);
+            auto& rasters = tile->rasters();
+            // failed rasters keep showing the ancestor
+            if (raster.isValid() && it->first < rasters.size()) {
+                rasters[it->first].tileID = raster.tileID;
+                rasters[it->first].texture = raster.texture;
+                changed = true;
+            }
+            --subtask->shareCount;
+            it = pendingRasters.erase(it);
+        }
+        return changed;
+    }
+
+    void clearPendingRasters() {
+        for (auto& pending : pendingRasters) {
+            auto& subtask = pending.second;
+            if (--subtask->shareCount <= 0 && !subtask->isCanceled()) {
+                subtask->cancel();
+                subtask->source()->cancelLoadingTile(*subtask);
+            }
+        }
+        pendingRasters.clear();
+    }
+
     void clearTask() {
         if (!task) { return; }
         for (auto& subtask : task->subTasks()) {
@@ -107,6 +220,93 @@ struct TileManager::TileEntry {
     }
 };
 
+TileManager::TileEntries::TileEntries() {}
+
+TileManager::TileEntries::~TileEntries() {}
+
+TileManager::TileEntries::TileEntries(TileEntries&&) = default;
+
+TileManager::TileEntries& TileManager::TileEntries::operator=(TileEntries&&) = default;
+
+bool TileManager::TileEntries::empty() const {
+    return entries.empty() && staged.empty();
+}
+
+size_t TileManager::TileEntries::size() const {
+    return entries.size() + staged.size();
+}
+
+TileManager::TileEntry* TileManager::TileEntries::find(const TileID& _tileID) {
+    uint64_t key = _tileID.key();
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it != keys.end() && *it == key) { return &entries[it - keys.begin()].second; }
+
+    for (auto& e : staged) {
+        if (e.first == _tileID) { return &e.second; }
+    }
+    return nullptr;
+}
+
+std::pair<TileManager::TileEntry*, bool> TileManager::TileEntries::emplace(const TileID& _tileID,
+                                                                         std::shared_ptr<Tile> _tile) {
+    if (TileEntry* entry = find(_tileID)) { return { entry, false }; }
+
+    staged.emplace_back(std::piecewise_construct, std::forward_as_tuple(_tileID), std::forward_as_tuple(_tile));
+    return { &staged.back().second, true };
+}
+
+void TileManager::TileEntries::commit() {
+    if (staged.empty()) { return; }
+
+    std::sort(staged.begin(), staged.end(), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+
+    scratch.reserve(entries.size() + staged.size());
+    scratchKeys.reserve(entries.size() + staged.size());
+
+    size_t i = 0;
+    for (auto& e : staged) {
+        uint64_t key = e.first.key();
+        for (; i < entries.size() && keys[i] < key; i++) {
+            scratch.push_back(std::move(entries[i]));
+            scratchKeys.push_back(keys[i]);
+        }
+        scratch.push_back(std::move(e));
+        scratchKeys.push_back(key);
+    }
+    for (; i < entries.size(); i++) {
+        scratch.push_back(std::move(entries[i]));
+        scratchKeys.push_back(keys[i]);
+    }
+
+    std::swap(entries, scratch);
+    std::swap(keys, scratchKeys);
+    scratch.clear();
+    scratchKeys.clear();
+    staged.clear();
+}
+
+template<typename F>
+void TileManager::TileEntries::removeIf(F _remove) {
+    size_t out = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (_remove(entries[i].first, entries[i].second)) { continue; }
+        // move-assignment releases the task of a removed entry
+        if (out != i) {
+            entries[out] = std::move(entries[i]);
+            keys[out] = keys[i];
+        }
+        ++out;
+    }
+    entries.erase(entries.begin() + out, entries.end());
+    keys.resize(out);
+}
+
+void TileManager::TileEntries::clear() {
+    entries.clear();
+    keys.clear();
+    staged.clear();
+}
+
 TileManager::TileSet::TileSet(std::shared_ptr<TileSource> _source) : source(_source) {}
 
 TileManager::TileSet::~TileSet() {}  //cancelTasks();
@@ -119,8 +319,15 @@ TileManager::TileManager(Platform& platform, TileTaskQueue& _tileWorker, std::we
     // Callback to pass task from Download-Thread to Worker-Queue
     m_dataCallback = TileTaskCb{[&](std::shared_ptr<TileTask> task) {
 
+        TRACE_SCOPE("tileData");
+        Trace::flow(task->traceId(), Trace::Flow::step);
+
         if (task->isReady()) {
-             platform.requestRender();
+            if (auto prana = m_scenePrana.lock()) {
+                prana->m_scene->requestTileRender(*task);
+            } else {
+                platform.requestRender();
+            }
 
         } else if (task->hasData()) {
             m_workers.enqueue(task);
@@ -202,6 +409,16 @@ void TileManager::clearTileSet(int32_t _sourceId) {
     m_tileSetChanged = true;
 }
 
+void TileManager::rebuildStyles(const std::vector<bool>& _styles, bool _lowPriority) {
+    bool pending = std::find(m_rebuildStyles.begin(), m_rebuildStyles.end(), true) != m_rebuildStyles.end();
+    m_rebuildLowPriority = _lowPriority && (!pending || m_rebuildLowPriority);
+
+    if (m_rebuildStyles.size() < _styles.size()) { m_rebuildStyles.resize(_styles.size()); }
+    for (size_t id = 0; id < _styles.size(); id++) {
+        if (_styles[id]) { m_rebuildStyles[id] = true; }
+    }
+}
+
 bool TileManager::updateTileSets(const View& _view) {
 
     m_tiles.clear();
@@ -210,12 +427,12 @@ bool TileManager::updateTileSets(const View& _view) {
 
     if (!getDebugFlag(DebugFlags::freeze_tiles)) {
 
-        float maxEdge = 2 * _view.pixelScale() * float(MapProjection::tileSize());
+        float maxEdge = m_lodScale * _view.pixelScale() * float(MapProjection::tileSize());
         float maxArea = maxEdge*maxEdge;
 
         using TileSetMask = std::bitset<MAX_TILE_SETS>;
         // enable recursion by passing lambda ref to itself; auto type creates a generic (i.e. templated) lambda
-        auto getVisibleTiles = [&](auto&& self, TileID tileId, TileSetMask active){
+        auto getVisibleTiles = [&](auto&& self, const View& _view, bool _prefetch, TileID tileId, TileSetMask active){
             // if pitch == 0, this will only return 0 or FLT_MAX
             float area = _view.getTileScreenArea(tileId);
             if (area <= 0) { return; }  // offscreen
@@ -224,59 +441,101 @@ bool TileManager::updateTileSets(const View& _view) {
             for (size_t ii = 0; ii < m_tileSets.size(); ++ii) {
                 if (!active[ii]) { continue; }
                 auto& tileSet = m_tileSets[ii];
+                auto& availability = tileSet.source->availability();
+                // Tiles without data are not requested
+                if (availability.isMissing(tileId)) {
+                    nextActive.reset(ii);
+                    continue;
+                }
+                // ... and the deepest tile with data is overzoomed like a tile at maxZoom
+                bool deepest = tileId.z >= tileSet.source->maxZoom() || availability.childrenMissing(tileId);
                 int zoomBias = tileSet.source->zoomBias();
                 // substantial redesign needed for something like this to work:
                 //for (auto& rs : tileSet.source->rasterSources()) { maxZoom = std::max(maxZoom, rs->maxZoom()); }
                 int maxZoom = std::min(tileSet.source->maxZoom(), _view.getIntegerZoom() - zoomBias);
-                if (tileId.z >= maxZoom || area < maxArea*std::exp2(2*float(zoomBias))) {
+                if (tileId.z >= maxZoom || deepest || area < maxArea*std::exp2(2*float(zoomBias))) {
                     TileID visId = tileId;
                     // Ensure that s = z + bias (larger s OK if overzoomed) so that proxy tiles can be found
                     // - otherwise, we get frames where tiles disappear due to no proxy for new tile
-                    if (visId.z < tileSet.source->maxZoom()) {
+                    if (!deepest) {
                         visId.s = visId.z + zoomBias;
                     } else {
                         int s = tileId.z + std::max(0, int(std::ceil(std::log2(area/maxArea)/2)));
                         visId.s = std::max(std::min(s, _view.getIntegerZoom()), visId.z + zoomBias);
                     }
-                    tileSet.visibleTiles.insert(visId);
+                    if (_prefetch) {
+                        tileSet.prefetchTiles.push_back(visId);
+                    } else {
+                        tileSet.visibleTiles.push_back(visId);
+                    }
                     nextActive.reset(ii);
                 }
             }
             // subdivide if any active tile sets remaining
             if (nextActive.any()) {
                 for (int i = 0; i < 4; i++) {
-                    self(self, tileId.getChild(i, 100), nextActive);
+                    self(self, _view, _prefetch, tileId.getChild(i, 100), nextActive);
                 }
             }
         };
 
         for (auto& tileSet : m_tileSets) {
             tileSet.visibleTiles.clear();
+            tileSet.prefetchTiles.clear();
         }
 
         TileSetMask allActive = (1 << m_tileSets.size()) - 1;
-        getVisibleTiles(getVisibleTiles, TileID(0,0,0), allActive);
+        getVisibleTiles(getVisibleTiles, _view, false, TileID(0,0,0), allActive);
+
+        for (const auto& view : m_prefetchViews) {
+            getVisibleTiles(getVisibleTiles, view, true, TileID(0,0,0), allActive);
+        }
+
+        auto sortUnique = [](std::vector<TileID>& ids) {
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        };
+        for (auto& tileSet : m_tileSets) {
+            sortUnique(tileSet.visibleTiles);
+            sortUnique(tileSet.prefetchTiles);
+        }
     }
 
     for (auto& tileSet : m_tileSets) {
         // check if tile set is active for zoom (zoom might be below min_zoom)
         if (tileSet.source->isActiveForZoom(_view.getZoom()) && tileSet.source->isVisible()) {
-            updateTileSet(tileSet, _view.state());
+            updateTileSet(tileSet, _view);
         }
     }
 
     for (auto& tileSet : m_auxTileSets) {
-        auto it = tileSet.tiles.begin();
-        while (it != tileSet.tiles.end()) {
-            if (!it->second.task || it->second.task->isReady() || it->second.task->isCanceled()) {
-                it->second.task.reset();  // avoid call to clearTask() in ~TileEntry()
-                it = tileSet.tiles.erase(it);
-            } else {
-                ++it;
+        tileSet.tiles.removeIf([](const TileID&, TileEntry& entry) {
+            if (!entry.task || entry.task->isReady() || entry.task->isCanceled()) {
+                entry.task.reset();  // avoid call to clearTask() when removed
+                return true;
             }
-        }
+            return false;
+        });
+    }
+
+    if (std::find(m_rebuildStyles.begin(), m_rebuildStyles.end(), true) != m_rebuildStyles.end()) {
+        // after updateTileSet() so that only tiles still in use are rebuilt
+        for (auto& tileSet : m_tileSets) { rebuildTiles(tileSet, _view); }
+        m_tileCache->clear();
+    }
+    m_rebuildStyles.clear();
+
+    if (m_reloadLostTiles) {
+        m_reloadLostTiles = false;
+        for (auto& tileSet : m_tileSets) { reloadLostTiles(tileSet, _view); }
+        bool lost = false;
+        m_tileCache->forEach([&](const Tile& _tile) { lost = lost || !_tile.restorable(); });
+        if (lost) { m_tileCache->clear(); }
     }
 
+    // updateTileSet() set the priorities of tasks in progress for this view
+    m_workers.updatePriorities();
+
     loadTiles();
 
     // no longer need to sort or dedup m_tiles since it is populated in order from TileSet.tiles (std::map)
@@ -293,7 +552,7 @@ bool TileManager::updateTileSets(const View& _view) {
     return m_tileSetChanged;
 }
 
-void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
+void TileManager::updateTileSet(TileSet& _tileSet, const View& _view) {
 
     //FrameInfo::scope _trace("updateTileSet " + _tileSet.source->name());
 
@@ -308,8 +567,8 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
     int maxProxyZ = 0, minProxyZ = 0, maxVisS = 0;
     if (!visibleTiles.empty()) {
         int zmax = visibleTiles.begin()->z, zmin = visibleTiles.rbegin()->z;
-        maxProxyZ = zmin != zmax ? zmax + 2 : int(glm::round(_view.zoom + 1.f));
-        minProxyZ = zmin != zmax ? zmin - 3 : int(glm::round(_view.zoom - 2.f));
+        maxProxyZ = zmin != zmax ? zmax + 2 : int(glm::round(_view.getZoom() + 1.f));
+        minProxyZ = zmin != zmax ? zmin - 3 : int(glm::round(_view.getZoom() - 2.f));
         maxVisS = visibleTiles.begin()->s;
     }
 
@@ -332,8 +591,10 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             auto& entry = curTilesIt->second;
             entry.setVisible(true);
 
+            float latency = entry.task ? entry.task->age() : 0.f;
             if (entry.completeTileTask()) {
                 m_tileSetChanged = true;
+                m_tileLatency.add(latency);
             }
 
             if (entry.needsLoading()) {
@@ -348,14 +609,16 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
             // Can be removed once ClientDataSource is immutable
             if (entry.tile) {
                 auto sourceGeneration = entry.tile->sourceGeneration();
-                if ((sourceGeneration < generation) && !entry.isInProgress()) {
+                if ((sourceGeneration < generation) && !entry.isInProgress() &&
+                    sourceGeneration < _tileSet.source->tileGeneration(visTileId)) {
                     // Tile needs update - enqueue for loading
                     entry.task = _tileSet.source->createTask(visTileId);
                     enqueueTask(_tileSet, visTileId, _view);
                 }
             } else if (entry.isCanceled()) {
                 auto sourceGeneration = entry.task->sourceGeneration();
-                if (sourceGeneration < generation) {
+                if (sourceGeneration < generation &&
+                    sourceGeneration < _tileSet.source->tileGeneration(visTileId)) {
                     // Tile needs update - enqueue for loading
                     entry.task = _tileSet.source->createTask(visTileId);
                     enqueueTask(_tileSet, visTileId, _view);
@@ -397,7 +660,14 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
         }
     }
 
-    int minCurS = tiles.rbegin()->first.s; //, maxCurS = tiles.begin()->first.s;
+    // add tiles created while iterating
+    tiles.commit();
+
+    prefetchTiles(_tileSet, _view);
+
+    if (tiles.empty()) { return; }
+
+    int minCurS = (tiles.end() - 1)->first.s; //, maxCurS = tiles.begin()->first.s;
     auto zoomBias = _tileSet.source->zoomBias();
     // find proxy tiles
     for (curTilesIt = tiles.begin(); curTilesIt != tiles.end(); ++curTilesIt) {
@@ -406,29 +676,27 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
         if (!entry.isVisible()) {
             // handle child proxy (i.e. look for visible parents w/o tile)
             for (auto id = tileId.getParent(zoomBias); id.s >= minCurS; id = id.getParent(zoomBias)) {
-                auto it = tiles.find(id);
-                if (it == tiles.end()) { continue; }
+                auto parent = tiles.find(id);
+                if (!parent) { continue; }
                 // visible tile w/ tile (so no proxy needed) or a better proxy found before visible tile?
-                if (it->second.tile) { break; }
+                if (parent->isDrawable()) { break; }
                 // found visible tile (w/o tile) to proxy for?
-                if (it->second.isVisible()) { entry.m_proxyCounter++; break; }
+                if (parent->isVisible()) { entry.m_proxyCounter++; break; }
             }
-        } else if (!entry.tile) {
+        } else if (!entry.isDrawable()) {
             // visible tile w/o tile - look for parents which can be proxy
             for (auto id = tileId.getParent(zoomBias); id.s >= minCurS; id = id.getParent(zoomBias)) {
-                auto it = tiles.find(id);
-                if (it != tiles.end()) {
-                    it->second.m_proxyCounter++;
-                    if (it->second.tile) { break; }
+                auto parent = tiles.find(id);
+                if (parent) {
+                    parent->m_proxyCounter++;
+                    if (parent->isDrawable()) { break; }
                 }
             }
         }
     }
 
     // add ready tiles to m_tiles and remove tiles not in visibleTiles and not being used as proxy
-    for (curTilesIt = tiles.begin(); curTilesIt != tiles.end();) {
-        auto& tileId = curTilesIt->first;
-        auto& entry = curTilesIt->second;
+    tiles.removeIf([&](const TileID& tileId, TileEntry& entry) {
 
 #ifdef TANGRAM_DEBUG_TILESETS //0 && LOG_LEVEL >= 3
         size_t rasterLoading = 0, rasterDone = 0;
@@ -445,10 +713,29 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
 #endif
 
         bool canLoad = entry.isInProgress() && (tileId.z < maxProxyZ && tileId.z > minProxyZ);
+        bool isPrefetch = entry.m_prefetch && !entry.isVisible();
+        entry.m_prefetch = false;  // reset for next update
+
+        if (isPrefetch && entry.isInProgress() && !entry.tile && entry.m_proxyCounter == 0) {
+            // keep loading with low priority - moved to cache when done unless visible by then
+            entry.task->setPriority(loadPriority(_tileSet, tileId, _view));
+            _tileSet.source->updateTaskPriority(*entry.task);
+            return false;
+        }
+
         if (entry.isVisible() || (entry.m_proxyCounter > 0 && (entry.tile || canLoad))) {
             if (entry.tile) {
+                if (entry.tile->isCoarse() && entry.isVisible() && !entry.isInProgress() &&
+                    screenAreaRatio(tileId, _view) >= DETAILED_TILE_AREA) {
+                    // Came near the camera - load again, showing the coarse tile meanwhile
+                    entry.task = _tileSet.source->createTask(tileId);
+                    enqueueTask(_tileSet, tileId, _view);
+                }
                 entry.tile->setProxyDepth(entry.m_proxyCounter > 0 ? std::max(maxVisS - tileId.s, 1) : 0);
                 m_tiles.push_back(entry.tile);
+                if (!entry.pendingRasters.empty() && entry.updatePendingRasters(m_dataCallback)) {
+                    m_tileSetChanged = true;
+                }
                 // check to see if a replacement is now available for missing raster
                 if (entry.numMissingRasters != 0) {
                     // to persist numMissingRasters for cached tiles, we'd need to store in Tile itself, so
@@ -478,37 +765,174 @@ void TileManager::updateTileSet(TileSet& _tileSet, const ViewState& _view) {
                 }
             } else if (entry.isInProgress()) {
                 auto& task = entry.task;
-                // Update tile distance to map center for load priority.
-                auto tileCenter = MapProjection::tileCenter(tileId);
-                double scaleDiv = exp2(tileId.z - _view.zoom);
-                if (scaleDiv < 1) { scaleDiv = 0.1/scaleDiv; } // prefer parent tiles
-                task->setPriority(glm::length2(tileCenter - _view.center) * scaleDiv);
+                // Update load priority for current view; workers pick tasks by the latest priority
+                task->setPriority(loadPriority(_tileSet, tileId, _view));
                 task->setProxyState(entry.m_proxyCounter > 0);
+                task->setPrefetchState(false);
+                if (_tileSet.source->generateGeometry()) {
+                    task->setCoarse(screenAreaRatio(tileId, _view) < COARSE_TILE_AREA);
+                }
+                _tileSet.source->updateTaskPriority(*task);
             }
             entry.m_proxyCounter = 0;  // reset for next update
-            ++curTilesIt;
+            return false;
         } else {
-            // Remove entry and move tile (if present) to cache
-            if (entry.tile) {
+            // Remove entry and move tile (if present) to cache, unless it still shows ancestor rasters
+            if (entry.tile && entry.pendingRasters.empty()) {
                 m_tileCache->put(_tileSet.source->id(), entry.tile);
             }
             // Remove tile from set - this will call clearTask() and thus cancelLoadingTile() as appropriate
-            curTilesIt = tiles.erase(curTilesIt);
+            return true;
+        }
+    });
+
+    updateCoveredCells(_tileSet);
+}
+
+void TileManager::updateCoveredCells(TileSet& _tileSet) {
+
+    auto& tiles = _tileSet.tiles;
+    int maxZoom = _tileSet.source->maxZoom();
+    constexpr int grid = MeshBase::CHUNK_GRID;
+
+    // Cells of the grid over @_id from (_x, _y) of @_size cells, counted from the south-west like
+    // tile units, which are covered by drawable descendants down to @_levels zoom levels below
+    auto coveredCells = [&](auto&& self, const TileID& _id, int _x, int _y, int _size, int _levels) -> uint16_t {
+        uint16_t cells = 0;
+        for (int i = 0; i < 4; i++) {
+            TileID child = _id.getChild(i, maxZoom);
+            // Over-zoomed children cover their whole parent
+            bool split = child.z > _id.z;
+            int size = split ? _size / 2 : _size;
+            // getChild(): i / 2 is the column from the west and i % 2 the row from the north
+            int x = split ? _x + (i / 2) * size : _x;
+            int y = split ? _y + (1 - i % 2) * size : _y;
+
+            auto entry = tiles.find(child);
+            if (entry && entry->isDrawable()) {
+                for (int cy = y; cy < y + size; cy++) {
+                    for (int cx = x; cx < x + size; cx++) { cells |= 1 << (cy * grid + cx); }
+                }
+            } else if (_levels > 1 && size > 1) {
+                cells |= self(self, child, x, y, size, _levels - 1);
+            }
+            if (!split) { break; }
+        }
+        return cells;
+    };
+
+    for (auto& it : tiles) {
+        auto& entry = it.second;
+        if (!entry.tile) { continue; }
+        // Only parent proxies are drawn under other tiles
+        entry.tile->setCoveredCells(entry.tile->isProxy() ? coveredCells(coveredCells, it.first, 0, 0, grid, 2) : 0);
+    }
+}
+
+void TileManager::rebuildTiles(TileSet& _tileSet, const View& _view) {
+
+    for (auto& it : _tileSet.tiles) {
+        const TileID& tileId = it.first;
+        TileEntry& entry = it.second;
+
+        // tasks in progress may have been built with previous globals
+        bool restyle = entry.tile && entry.tile->tileData() && !entry.isInProgress();
+        entry.clearTask();
+
+        if (restyle) {
+            auto task = _tileSet.source->taskPool().make<TileTask>(tileId, _tileSet.source.get());
+            task->setRebuild(entry.tile, m_rebuildStyles);
+            double priority = loadPriority(_tileSet, tileId, _view);
+            if (m_rebuildLowPriority) { priority *= LOW_PRIORITY_REBUILD_FACTOR; }
+            task->setPriority(priority);
+            task->setScenePrana(m_scenePrana);
+            ++task->shareCount;
+            entry.task = task;
+            m_workers.enqueue(std::move(task));
+
+        } else if (entry.tile) {
+            // no TileData to restyle - load again, showing the current tile meanwhile
+            entry.task = _tileSet.source->createTask(tileId);
+            enqueueTask(_tileSet, tileId, _view);
+        }
+        // entries without tile get a new task on next update if still needed
+    }
+}
+
+void TileManager::reloadLostTiles(TileSet& _tileSet, const View& _view) {
+
+    for (auto& it : _tileSet.tiles) {
+        const TileID& tileId = it.first;
+        TileEntry& entry = it.second;
+
+        // tasks in progress replace the tile anyway
+        if (!entry.tile || entry.isInProgress() || entry.tile->restorable()) { continue; }
+
+        // the tile is drawn without its lost meshes meanwhile
+        entry.task = _tileSet.source->createTask(tileId);
+        enqueueTask(_tileSet, tileId, _view);
+    }
+}
+
+void TileManager::prefetchTiles(TileSet& _tileSet, const View& _view) {
+
+    auto& tiles = _tileSet.tiles;
+
+    for (const auto& tileId : _tileSet.prefetchTiles) {
+        if (auto existing = tiles.find(tileId)) {
+            existing->m_prefetch = true;
+            continue;
         }
+        if (m_tileCache->contains(_tileSet.source->id(), tileId)) { continue; }
+
+        auto& entry = *tiles.emplace(tileId, nullptr).first;
+        entry.m_prefetch = true;
+        entry.task = _tileSet.source->createTask(tileId);
+        entry.task->setPrefetchState(true);
+        enqueueTask(_tileSet, tileId, _view);
     }
+    tiles.commit();
+}
+
+double TileManager::loadPriority(const TileSet& _tileSet, const TileID& _tileID, const View& _view) const {
+
+    // squared distance to the view position, i.e. the center of the padded viewport, in tiles of
+    // the view zoom; +1 so that the center tile is also ordered by the factors below
+    double viewTileMeters = MapProjection::EARTH_CIRCUMFERENCE_METERS * exp2(-_view.getZoom());
+    glm::dvec2 offset = (MapProjection::tileCenter(_tileID) - glm::dvec2(_view.getPosition())) / viewTileMeters;
+    double priority = glm::length2(offset) + 1;
+
+    double scaleDiv = exp2(_tileID.z - _view.getZoom());
+    if (scaleDiv < 1) { scaleDiv = 0.1/scaleDiv; } // prefer parent tiles
+    priority *= scaleDiv;
+
+    // in a tilted view prefer tiles covering more of the screen
+    double area = screenAreaRatio(_tileID, _view);
+    if (area < FLT_MAX) { priority /= glm::clamp(area, 1/16., 16.); }
+
+    // base map before overlays: each load order step counts like doubling the distance
+    priority *= exp2(2. * _tileSet.source->loadOrder());
+
+    return priority;
+}
+
+double TileManager::screenAreaRatio(const TileID& _tileID, const View& _view) const {
+    float area = _view.getTileScreenArea(_tileID);
+    if (area <= 0 || area >= FLT_MAX) { return FLT_MAX; }
+
+    double flatSize = _view.pixelScale() * MapProjection::tileSize() * exp2(_view.getZoom() - _tileID.z);
+    return area / (flatSize * flatSize);
 }
 
-void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID,
-                              const ViewState& _view) {
+void TileManager::enqueueTask(TileSet& _tileSet, const TileID& _tileID, const View& _view) {
 
-    // Keep the items sorted by distance
-    auto tileCenter = MapProjection::tileCenter(_tileID);
-    double distance = glm::length2(tileCenter - _view.center);
+    // Keep the items sorted by priority
+    double priority = loadPriority(_tileSet, _tileID, _view);
 
-    auto it = std::upper_bound(m_loadTasks.begin(), m_loadTasks.end(), distance,
-        [](const double& d, const TileLoadTask& other){ return d < other.dist; });
+    auto it = std::upper_bound(m_loadTasks.begin(), m_loadTasks.end(), priority,
+        [](const double& p, const TileLoadTask& other){ return p < other.priority; });
 
-    m_loadTasks.insert(it, {distance, &_tileSet, _tileID});
+    m_loadTasks.insert(it, {priority, &_tileSet, _tileID});
 }
 
 TileManager::TileSet* TileManager::findTileSet(int64_t sourceId) {
@@ -527,8 +951,7 @@ void TileManager::loadTiles() {
 
     for (auto& loadTask : m_loadTasks) {
         TileSet* tileSet = loadTask.tileSet;
-        auto tileIt = tileSet->tiles.find(loadTask.tileID);
-        auto tileTask = tileIt->second.task;
+        auto tileTask = tileSet->tiles.find(loadTask.tileID)->task;
 
         for (auto& subtask : tileTask->subTasks()) {
             // needsLoading() will be false if, e.g., texture was already cached by RasterSource
@@ -536,17 +959,15 @@ void TileManager::loadTiles() {
             TileSet* ts = findTileSet(subtask->sourceId());
             if (!ts) { continue; }  // should never happen
 
-            auto it = ts->tiles.find(subtask->tileId());
-            if (it != ts->tiles.end()) {
-                if (it->second.task && !it->second.task->isReady() && !it->second.task->isCanceled()) {
-                    subtask = it->second.task;
+            if (auto entry = ts->tiles.find(subtask->tileId())) {
+                if (entry->task && !entry->task->isReady() && !entry->task->isCanceled()) {
+                    subtask = entry->task;
                 }
             } else if (!ts->source->generateGeometry()) {
                 // add to aux tile set - this will be the master task for any subsequent duplicates
-                std::shared_ptr<Tile> dummy;
-                auto res = ts->tiles.emplace(subtask->tileId(), dummy);
+                auto res = ts->tiles.emplace(subtask->tileId(), nullptr);
                 if (res.second) {
-                    res.first->second.task = subtask;
+                    res.first->task = subtask;
                 }
             }
             // shareCount > 1 prevents tile cancelation (shareCount decremented by cancel and complete)
@@ -555,11 +976,14 @@ void TileManager::loadTiles() {
         ++tileTask->shareCount;
 
         tileTask->setScenePrana(m_scenePrana);
+        Trace::flow(tileTask->traceId(), Trace::Flow::start);
         tileSet->source->loadTileData(tileTask, m_dataCallback);
 
         LOGTO("Load Tile: %s %s", tileSet->source->name().c_str(), loadTask.tileID.toString().c_str());
     }
 
+    for (auto& tileSet : m_auxTileSets) { tileSet.tiles.commit(); }
+
     m_loadTasks.clear();
 }
 
@@ -568,7 +992,7 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
     auto tile = m_tileCache->get(_tileSet.source->id(), _tileID);
 
     if (tile) {
-        if (tile->sourceGeneration() == _tileSet.source->generation()) {
+        if (tile->sourceGeneration() >= _tileSet.source->tileGeneration(_tileID)) {
             // Reset tile on potential internal dynamic data set
             tile->resetState();
         } else {
@@ -577,22 +1001,24 @@ bool TileManager::addTile(TileSet& _tileSet, const TileID& _tileID) {
         }
     }
 
-    // Add TileEntry to TileSet
-    auto entryit = _tileSet.tiles.emplace(_tileID, tile);
-    TileEntry& entry = entryit.first->second;
-
     if (!tile) {
         // check cache for proxy (proxy already in TileSet will be found by updateTileSet())
-        updateProxyTiles(_tileSet, _tileID, entry);
+        updateProxyTiles(_tileSet, _tileID);
+    }
 
+    // Add TileEntry to TileSet - may already be staged as proxy for another new tile
+    auto res = _tileSet.tiles.emplace(_tileID, tile);
+    TileEntry& entry = *res.first;
+
+    if (!entry.tile && !entry.task) {
         entry.task = _tileSet.source->createTask(_tileID);
     }
     entry.setVisible(true);
 
-    return bool(tile);
+    return bool(entry.tile);
 }
 
-void TileManager::updateProxyTiles(TileSet& _tileSet, const TileID& _tileID, TileEntry& _tile) {
+void TileManager::updateProxyTiles(TileSet& _tileSet, const TileID& _tileID) {
     // should we prefer child over parent as proxy?
 
     auto zoomBias = _tileSet.source->zoomBias();
@@ -625,4 +1051,30 @@ int TileManager::numTotalTiles() const {
     return tot;
 }
 
+std::shared_ptr<Properties> TileManager::pickFeature(View& _view, glm::vec2 _position, float _radius) const {
+    // Position and radius on the ground plane, relative to the view position
+    glm::dvec2 ground = _view.screenToGroundPlane(_position.x, _position.y);
+    double radius = _radius / _view.pixelsPerMeter();
+
+    const Tile* picked = nullptr;
+    PickIndex::Hit best;
+    for (const auto& tile : m_tiles) {
+        auto* index = tile->pickIndex();
+        if (!index || index->empty()) { continue; }
+
+        double scale = tile->getScale();
+        glm::vec2 position((ground - _view.getRelativeMeters(tile->getOrigin())) / scale);
+        PickIndex::Hit hit;
+        if (index->pick(position, float(radius / scale), hit)) {
+            // distances relative to the radius, for tiles of other zooms
+            hit.distance *= float(scale / radius);
+            if (!picked || hit.isAbove(best)) {
+                best = hit;
+                picked = tile.get();
+            }
+        }
+    }
+    return picked ? picked->getSelectionFeature(best.selectionColor) : nullptr;
+}
+
 }
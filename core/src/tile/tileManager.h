@@ -6,12 +6,12 @@
 #include "tile/tileID.h"
 #include "tile/tileTask.h"
 #include "tile/tileWorker.h"
+#include "util/timeHistogram.h"
+#include "view/view.h"
 
-#include <map>
 #include <memory>
 #include <mutex>
 #include <tuple>
-#include <set>
 #include <vector>
 
 namespace Tangram {
@@ -19,7 +19,6 @@ namespace Tangram {
 class Platform;
 class TileSource;
 class TileCache;
-class View;
 struct ViewState;
 
 /* Singleton container of <TileSet>s
@@ -43,13 +42,36 @@ public:
     /* Updates visible tile set and load missing tiles */
     bool updateTileSets(const View& _view);
 
+    /* Views expected to be shown soon, e.g. at the end of a fling or camera ease.
+     * Tiles for these views are loaded with low priority on next updateTileSets() */
+    void setPrefetchViews(std::vector<View> _views) { m_prefetchViews = std::move(_views); }
+
+    /* Largest on-screen edge of a selected tile, in tile sizes; the quadtree is not subdivided
+     * below tiles which project smaller than this. Where the view is tilted, tiles farther from
+     * the camera project smaller, so larger values select lower zoom levels there (default 2) */
+    void setLodScale(float _scale) { m_lodScale = _scale; }
+
     void clearTileSets(bool clearSourceCaches = false);
 
     void clearTileSet(int32_t _sourceId);
 
+    /* Rebuild meshes of @_styles (by Style ID) of all tiles on next updateTileSets(); current tiles
+     * are shown until their rebuilt replacement is ready. Cached tiles are dropped. With
+     * @_lowPriority the rebuilds wait behind loading tiles, e.g. for styles joining late */
+    void rebuildStyles(const std::vector<bool>& _styles, bool _lowPriority = false);
+
+    /* Load tiles whose meshes or rasters cannot be restored after the GL context was lost
+     * again on next updateTileSets(), see Tile::restorable(); these are dropped from the cache */
+    void reloadLostTiles() { m_reloadLostTiles = true; }
+
     /* Returns the set of currently visible tiles */
     const auto& getVisibleTiles() const { return m_tiles; }
 
+    /* Topmost interactive feature of the visible tiles within @_radius density-independent pixels
+     * of the screen position @_position, from the PickIndex of each tile; null if there is none or
+     * the tiles have no index */
+    std::shared_ptr<Properties> pickFeature(View& _view, glm::vec2 _position, float _radius) const;
+
     int numLoadingTiles() const { return m_tilesInProgress; }
     int numTotalTiles() const;
 
@@ -61,16 +83,63 @@ public:
 
     const std::unique_ptr<TileCache>& getTileCache() const { return m_tileCache; }
 
+    /* Time from creating the task of a visible tile to adding the tile */
+    const TimeHistogram& tileLatency() const { return m_tileLatency; }
+
     /* @_cacheSize: Set size of in-memory tile cache in bytes.
      * This cache holds recently used <Tile>s that are ready for rendering.
      */
     void setCacheSize(size_t _cacheSize);
+    size_t getCacheSize() const { return m_maxCacheLimit; }
 
 protected:
 
     enum class ProxyID : uint8_t;
     struct TileEntry;
 
+    /* TileEntries sorted by TileID in a flat vector
+     *
+     * Entries added by emplace() while the sorted range is iterated are staged and
+     * merged by commit(), so iterators into the sorted range stay valid until then.
+     * Lookups search the packed TileID::key() of the entries, kept in a parallel vector.
+     */
+    struct TileEntries {
+        using Entry = std::pair<TileID, TileEntry>;
+        using iterator = std::vector<Entry>::iterator;
+
+        TileEntries();
+        ~TileEntries();
+        TileEntries(TileEntries&&);
+        TileEntries& operator=(TileEntries&&);
+
+        iterator begin() { return entries.begin(); }
+        iterator end() { return entries.end(); }
+        bool empty() const;
+        size_t size() const;
+
+        // returns nullptr if there is no entry for _tileID (staged entries included)
+        TileEntry* find(const TileID& _tileID);
+
+        // add entry unless there is one for _tileID; the returned entry is valid until the next emplace()
+        std::pair<TileEntry*, bool> emplace(const TileID& _tileID, std::shared_ptr<Tile> _tile);
+
+        // merge staged entries into sorted range
+        void commit();
+
+        // remove entries for which _remove(id, entry) returns true, keeping order
+        template<typename F>
+        void removeIf(F _remove);
+
+        void clear();
+
+    private:
+        std::vector<Entry> entries;
+        std::vector<uint64_t> keys;
+        std::vector<Entry> staged;
+        std::vector<Entry> scratch;
+        std::vector<uint64_t> scratchKeys;
+    };
+
     struct TileSet {
         TileSet(std::shared_ptr<TileSource> _source);
         ~TileSet();
@@ -78,8 +147,10 @@ protected:
 
         std::shared_ptr<TileSource> source;
 
-        std::set<TileID> visibleTiles;
-        std::map<TileID, TileEntry> tiles;
+        // sorted and unique after updateTileSets() collected them
+        std::vector<TileID> visibleTiles;
+        std::vector<TileID> prefetchTiles;
+        TileEntries tiles;
 
         int64_t sourceGeneration = 0;
 
@@ -89,9 +160,23 @@ protected:
         TileSet& operator=(TileSet&&) = default;
     };
 
-    void updateTileSet(TileSet& tileSet, const ViewState& _view);
+    void updateTileSet(TileSet& tileSet, const View& _view);
+
+    // set the cells of proxy tiles covered by drawable tiles of higher zoom, see Tile::coveredCells()
+    void updateCoveredCells(TileSet& _tileSet);
+
+    // create tasks for prefetch tiles that are neither in tileSet nor in cache
+    void prefetchTiles(TileSet& _tileSet, const View& _view);
+
+    void enqueueTask(TileSet& _tileSet, const TileID& _tileID, const View& _view);
+
+    // Priority of loading and building tile in @_view, lower first: combines distance to the view
+    // center, screen area when tilted, zoom and TileSource::loadOrder()
+    double loadPriority(const TileSet& _tileSet, const TileID& _tileID, const View& _view) const;
 
-    void enqueueTask(TileSet& _tileSet, const TileID& _tileID, const ViewState& _view);
+    // Screen area of @_tileID in tilted @_view relative to its area in an untilted view at the view
+    // zoom, i.e. smaller for tiles farther from the camera; FLT_MAX when not tilted
+    double screenAreaRatio(const TileID& _tileID, const View& _view) const;
 
     void loadTiles();
 
@@ -99,12 +184,27 @@ protected:
     bool addTile(TileSet& _tileSet, const TileID& _tileID);
 
     // check cache for proxy for new tile
-    void updateProxyTiles(TileSet& _tileSet, const TileID& _tileID, TileEntry& _tile);
+    void updateProxyTiles(TileSet& _tileSet, const TileID& _tileID);
+
+    // create tasks rebuilding m_rebuildStyles of tiles with TileData, reload other tiles
+    void rebuildTiles(TileSet& _tileSet, const View& _view);
+
+    // create tasks loading the tiles that are not restorable, see reloadLostTiles()
+    void reloadLostTiles(TileSet& _tileSet, const View& _view);
 
     TileSet* findTileSet(int64_t sourceId);
 
     int32_t m_tilesInProgress = 0;
 
+    std::vector<View> m_prefetchViews;
+
+    float m_lodScale = 2.f;
+
+    /* Styles to rebuild on next updateTileSets(), set by rebuildStyles() */
+    std::vector<bool> m_rebuildStyles;
+    bool m_rebuildLowPriority = false;
+    bool m_reloadLostTiles = false;
+
     std::vector<TileSet> m_tileSets;
     std::vector<TileSet> m_auxTileSets;
 
@@ -120,13 +220,15 @@ protected:
 
     bool m_tileSetChanged = false;
 
+    TimeHistogram m_tileLatency;
+
     /* Callback for TileSource:
      * Passes TileTask back with data for further processing by <TileWorker>s
      */
     TileTaskCb m_dataCallback;
 
     /* Temporary list of tiles that need to be loaded */
-    struct TileLoadTask { double dist; TileSet* tileSet; TileID tileID; };
+    struct TileLoadTask { double priority; TileSet* tileSet; TileID tileID; };
     std::vector<TileLoadTask> m_loadTasks;
 
 };
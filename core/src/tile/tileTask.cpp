@@ -1,11 +1,16 @@
 #include "tile/tileTask.h"
 
+#include "data/tileData.h"
 #include "data/tileSource.h"
+#include "debug/trace.h"
 #include "scene/scene.h"
 #include "tile/tile.h"
 #include "tile/tileBuilder.h"
+#include "tile/tileDiskCache.h"
 #include "util/mapProjection.h"
 
+#include <algorithm>
+
 namespace Tangram {
 
 TileTask::TileTask(const TileID& _tileId, TileSource* _source) :
@@ -13,11 +18,16 @@ TileTask::TileTask(const TileID& _tileId, TileSource* _source) :
     m_source(_source),
     m_sourceId(_source ? _source->id() : 0),
     m_sourceGeneration(_source ? _source->generation() : 0),
+    m_traceId(Trace::newFlowId()),
+    m_created(std::chrono::steady_clock::now()),
+    m_parsed(false),
     m_ready(false),
     m_canceled(false),
     m_needsLoading(true),
     m_priority(0),
-    m_proxyState(false) {}
+    m_proxyState(false),
+    m_prefetchState(false),
+    m_coarse(false) {}
 
 TileTask::~TileTask() {}
 
@@ -30,17 +40,93 @@ void TileTask::setTile(std::unique_ptr<Tile>&& _tile) {
     m_ready = true;
 }
 
+void TileTask::setRebuild(std::shared_ptr<Tile> _tile, std::vector<bool> _styles) {
+    m_tileData = _tile->tileData();
+    m_rebuildTile = std::move(_tile);
+    m_rebuildStyles = std::move(_styles);
+    m_parsed = true;
+    startedLoading();
+}
+
+void TileTask::setTileData(std::shared_ptr<TileData> _tileData) {
+    m_tileData = std::move(_tileData);
+    m_parsed = true;
+}
+
 void TileTask::process(TileBuilder& _tileBuilder) {
 
-    auto tileData = m_source->parse(*this);
+    if (!m_parsed) { parse(); }
 
-    if (tileData) {
-        m_tile = std::make_unique<Tile>(m_tileId, m_source->id(), m_source->generation());
-        _tileBuilder.build(*m_tile, *tileData, *m_source);
+    if (!isCanceled()) { build(_tileBuilder); }
+}
+
+void TileTask::parse() {
+
+    m_tileData = m_source->parse(*this);
+    m_parsed = true;
+
+    if (!m_tileData) { cancel(); }
+}
+
+bool TileTask::restore(TileBuilder& _tileBuilder) {
+
+    const Scene& scene = _tileBuilder.scene();
+    auto* diskCache = scene.tileDiskCache();
+
+    // raster and client data may change without changing the Scene; tasks w/o source build no tile
+    if (!diskCache || m_rebuildTile || !m_source || m_source->isRaster() || m_source->isClient()) { return false; }
+
+    std::vector<bool> missing;
+    auto tile = diskCache->load(*m_source, m_tileId, scene.pixelScale(), scene.styles(), missing);
+    if (!tile) { return false; }
+
+    if (std::find(missing.begin(), missing.end(), true) == missing.end()) {
+        m_tile = std::move(tile);
+        m_tileData.reset();
         m_ready = true;
-    } else {
+        return true;
+    }
+
+    // build styles with labels from TileData, complete() takes the stored meshes
+    m_rebuildTile = std::move(tile);
+    m_rebuildStyles = std::move(missing);
+    return false;
+}
+
+void TileTask::build(TileBuilder& _tileBuilder) {
+
+    if (!m_tileData) {
         cancel();
+        return;
+    }
+
+    if (m_rebuildTile) {
+        m_tile = std::make_unique<Tile>(m_tileId, m_source->id(), m_rebuildTile->sourceGeneration());
+    } else {
+        m_tile = std::make_unique<Tile>(m_tileId, m_source->id(), m_source->generation());
     }
+    bool done = _tileBuilder.build(*m_tile, *m_tileData, *m_source, this,
+                                   m_rebuildTile ? &m_rebuildStyles : nullptr);
+
+    if (done && _tileBuilder.scene().keepTileData()) {
+        m_tile->setTileData(m_tileData);
+    }
+    m_tileData.reset();
+
+    // store before meshes get uploaded, which releases their data; coarse tiles are loaded again,
+    // as are tiles without styles waiting for resources. Raster tiles are never restored.
+    auto* diskCache = _tileBuilder.scene().tileDiskCache();
+    if (done && diskCache && !m_rebuildTile && !m_tile->isCoarse() && !m_source->isClient() &&
+        !m_source->isRaster() && !_tileBuilder.skippedPendingStyles()) {
+        diskCache->store(*m_source, *m_tile, _tileBuilder.scene().pixelScale(), _tileBuilder.scene().styles());
+    }
+
+    if (!done) {
+        // canceled while building
+        m_tile.reset();
+        return;
+    }
+    m_ready = true;
 }
 
 void TileTask::complete() {
@@ -50,6 +136,12 @@ void TileTask::complete() {
         subTask->complete(*this);
     }
 
+    if (m_rebuildTile && m_tile) {
+        m_tile->takeUnchanged(*m_rebuildTile, m_rebuildStyles);
+        // meshes taken from the tile may be coarse
+        if (m_rebuildTile->isCoarse()) { m_tile->setCoarse(true); }
+        m_rebuildTile.reset();
+    }
 }
 
 // Getting ScenePrana into each TileSource so that it can be set when TileTask is created would be messier
@@ -0,0 +1,64 @@
+#include "tile/tileUploader.h"
+
+#include "tile/tile.h"
+#include "view/view.h"
+
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace Tangram {
+
+bool TileUploader::upload(RenderState& rs, const View& _view,
+                          const std::vector<std::shared_ptr<Tile>>& _tiles) {
+
+    m_stats = Stats();
+
+    m_pending.clear();
+    for (const auto& tile : _tiles) {
+        if (tile->isUploaded()) { continue; }
+        auto center = tile->getOrigin() + glm::dvec2(tile->getScale() / 2);
+        m_pending.push_back({ tile->isProxy(), glm::length(_view.getRelativeMeters(center)), tile.get() });
+    }
+
+    if (m_pending.empty()) { return false; }
+
+    // Visible tiles before proxies, near before far
+    std::sort(m_pending.begin(), m_pending.end(), [](const Pending& a, const Pending& b) {
+        if (a.proxy != b.proxy) { return b.proxy; }
+        return a.distance < b.distance;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    bool uploaded = false;
+
+    for (auto& pending : m_pending) {
+        if (m_stats.tiles > 0 &&
+            ((m_budgetTime > 0 && m_stats.time >= m_budgetTime) ||
+             (m_budgetBytes > 0 && m_stats.bytes >= m_budgetBytes))) {
+            m_stats.pending++;
+            continue;
+        }
+
+        auto tileStart = std::chrono::steady_clock::now();
+        m_stats.bytes += pending.tile->upload(rs);
+        auto end = std::chrono::steady_clock::now();
+
+        // Upload time counts to the cost of rebuilding the tile
+        pending.tile->addUploadCost(std::chrono::duration<float, std::milli>(end - tileStart).count());
+
+        m_stats.time = std::chrono::duration<float, std::milli>(end - start).count();
+        m_stats.tiles++;
+
+        // Rasters of the tile may still be uploading on Texture::uploadWorker
+        if (pending.tile->isUploaded()) {
+            uploaded = true;
+        } else {
+            m_stats.pending++;
+        }
+    }
+
+    return uploaded;
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Tangram {
+
+class RenderState;
+class Tile;
+class View;
+
+/* Uploads the meshes and rasters of newly built tiles within a per frame budget
+ *
+ * Without a budget, a burst of tiles completing together is uploaded in the first frame in
+ * which they are drawn, which can take long enough to drop frames. TileUploader uploads
+ * tiles ahead of drawing, visible tiles before proxies and tiles near the view center
+ * first, and stops once the time or byte budget of the frame is spent. Styles draw only
+ * uploaded tiles (see Tile::isUploaded()), so TileManager keeps proxies for the others.
+ *
+ * At least one tile is uploaded per frame, so that tiles larger than the budget are shown
+ * eventually. A budget of 0 is unlimited.
+ */
+class TileUploader {
+
+public:
+
+    struct Stats {
+        size_t tiles = 0;    // tiles processed in the last frame
+        size_t bytes = 0;    // bytes uploaded in the last frame
+        float time = 0;      // milliseconds spent uploading in the last frame
+        size_t pending = 0;  // tiles left for later frames
+    };
+
+    void setBudget(float _milliseconds, size_t _bytes) {
+        m_budgetTime = _milliseconds;
+        m_budgetBytes = _bytes;
+    }
+
+    /* Upload tiles of @_tiles that are not uploaded yet until the budget is spent;
+     * returns true if any tile became uploaded */
+    bool upload(RenderState& rs, const View& _view, const std::vector<std::shared_ptr<Tile>>& _tiles);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+
+    struct Pending {
+        bool proxy;
+        double distance;
+        Tile* tile;
+    };
+
+    float m_budgetTime = 0;
+    size_t m_budgetBytes = 0;
+
+    std::vector<Pending> m_pending;
+
+    Stats m_stats;
+};
+
+}
@@ -1,21 +1,32 @@
 #include "tile/tileWorker.h"
 
 #include "data/tileSource.h"
+#include "debug/trace.h"
+#include "labels/collisionCache.h"
 #include "log.h"
 #include "map.h"
 #include "platform.h"
 #include "scene/scene.h"
+#include "tile/tile.h"
 #include "tile/tileBuilder.h"
 #include "tile/tileID.h"
 #include "tile/tileTask.h"
+#include "util/threadPlacement.h"
+#include "util/triangulationCache.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 
-#define WORKER_NICENESS 10
+// Limit for tasks parsed ahead of building, to bound memory held by TileData
+#define MAX_PARSED_PER_WORKER 4
 
 namespace Tangram {
 
-TileWorker::TileWorker(Platform& _platform, int _numWorker) : m_platform(_platform) {
+TileWorker::TileWorker(int _numWorker, bool _pinWorkers)
+    : m_pinWorkers(_pinWorkers),
+      m_triangulationCache(std::make_unique<TriangulationCache>()),
+      m_collisionCache(std::make_unique<CollisionCache>()) {
     m_running = true;
 
     for (int i = 0; i < _numWorker; i++) {
@@ -31,103 +42,472 @@ TileWorker::~TileWorker(){
     }
 }
 
+// Name of the TileSource of @_task for logging; e.g. marker tasks have none
+[[maybe_unused]] static const char* sourceName(TileTask& _task) {
+    return _task.source() ? _task.source()->name().c_str() : "-";
+}
+
+TileWorker::TaskKey TileWorker::taskKey(TileTask& _task) {
+    return { _task.isPrefetch(), _task.isProxy(), _task.sourceId(), _task.sourceGeneration(),
+             float(_task.getPriority()) };
+}
+
+// Visible tasks before prefetch tasks, then non-proxy before proxy tasks, then older generations
+// of the same source, then by priority (distance to view center)
+bool TileWorker::compareKeys(const TaskKey& a, const TaskKey& b) {
+    if (a.prefetch != b.prefetch) {
+        return !a.prefetch;
+    }
+    if (a.proxy != b.proxy) {
+        return !a.proxy;
+    }
+    if (a.sourceId == b.sourceId && a.sourceGeneration != b.sourceGeneration) {
+        return a.sourceGeneration < b.sourceGeneration;
+    }
+    return a.priority < b.priority;
+}
+
+uint64_t TileWorker::rank(const TaskKey& _key) {
+    // Class in the high word; bits of a non-negative float order like the float
+    uint64_t taskClass = (_key.prefetch ? 2 : 0) + (_key.proxy ? 1 : 0);
+    float priority = std::max(_key.priority, 0.f);
+    uint32_t bits;
+    std::memcpy(&bits, &priority, sizeof(bits));
+    return (taskClass << 32) | bits;
+}
+
+bool TileWorker::heapOrder(const QueuedTask& a, const QueuedTask& b) {
+    return compareKeys(b.key, a.key);
+}
+
 void TileWorker::run(Worker* instance) {
 
-    setCurrentThreadPriority(WORKER_NICENESS);
+    Trace::setThreadName("TileWorker");
 
-    std::unique_ptr<TileBuilder> builder;
+    ThreadQoS qos = ThreadQoS::interactive;
+    setCurrentThreadQoS(qos);
+    // Prefetch tasks run at a lower priority where threads are allowed to switch back
+    const bool switchQoS = canSwitchThreadQoS();
+
+    if (m_pinWorkers && CpuTopology::get().isHeterogeneous() &&
+        !setCurrentThreadAffinity(CpuTopology::get().workerCpus())) {
+        LOGW("Could not pin tile worker to performance cores");
+    }
+
+    std::vector<std::unique_ptr<TileBuilder>> builders;
+    // StyleContext of the last released TileBuilder, reused for the next Scene of this worker
+    std::unique_ptr<StyleContext> styleContext;
 
     while (true) {
 
-        std::shared_ptr<TileTask> task;
+        uint64_t serial = 0;
+        // Indices of the TileBuilders of complete Scenes, starting with instance->nextBuilder
+        std::vector<size_t> ready;
         {
-            std::unique_lock<std::mutex> lock(m_mutex);
+            auto lock = lockTimed(m_mutex, m_schedulerLocks);
 
+            // NB: tasks can be parsed before the Scene is complete
             m_condition.wait(lock, [&] {
-                return (!m_queue.empty() && m_sceneComplete) || !m_running || instance->tileBuilder;
+                return (m_pending > 0 && instance->idleSerial != m_serial) ||
+                    !m_running || !instance->newBuilders.empty() || !instance->released.empty();
             });
 
-            if (instance->tileBuilder) {
+            bool changed = !instance->released.empty() || !instance->newBuilders.empty();
+
+            if (!instance->released.empty()) {
+                auto& released = instance->released;
+                builders.erase(std::remove_if(builders.begin(), builders.end(), [&](auto& builder) {
+                    if (std::find(released.begin(), released.end(), &builder->scene()) == released.end()) {
+                        return false;
+                    }
+                    styleContext = builder->releaseStyleContext();
+                    return true;
+                }), builders.end());
+                released.clear();
+            }
+
+            for (auto& builder : instance->newBuilders) {
                 LOGTInit();
-                builder = std::move(instance->tileBuilder);
-                builder->init();
+                builder->init(std::move(styleContext));
+                builders.push_back(std::move(builder));
                 LOGT("Took init of TileBuilder");
             }
+            instance->newBuilders.clear();
+
+            if (changed) {
+                instance->scenes.clear();
+                for (auto& builder : builders) { instance->scenes.push_back(&builder->scene()); }
+                // releaseScene() waits for the TileBuilders to be dropped
+                m_condition.notify_all();
+            }
+
             // Check if thread should stop
             if (!m_running) {
+                builders.clear();
+                instance->scenes.clear();
+                m_condition.notify_all();
                 break;
             }
 
-            if (!builder || !m_sceneComplete) {
-                if (builder) LOGTO("Waiting for Scene to become ready");
-                continue;
+            for (size_t i = 0; i < builders.size(); i++) {
+                size_t index = (instance->nextBuilder + i) % builders.size();
+                const Scene* scene = &builders[index]->scene();
+                if (std::find(m_completeScenes.begin(), m_completeScenes.end(), scene) != m_completeScenes.end()) {
+                    ready.push_back(index);
+                }
             }
+            if (!builders.empty() && ready.empty()) LOGTO("Waiting for Scene to become ready");
 
-            // Remove all canceled tasks
-            auto removes = std::remove_if(m_queue.begin(), m_queue.end(),
-                                          [](const auto& a) { return a->isCanceled(); });
+            serial = m_serial;
+        }
 
-            m_queue.erase(removes, m_queue.end());
+        // Holding ScenePrana keeps the Scene (and so the task's TileSource) alive while working on a task
+        std::shared_ptr<ScenePrana> prana;
+        std::shared_ptr<TileTask> task;
+        TileBuilder* builder = nullptr;
+
+        // Take turns between Scenes, so that one Map loading many tiles does not hold up the others
+        for (size_t index : ready) {
+            const Scene* scene = &builders[index]->scene();
+            // Finish tiles which were parsed ahead first
+            task = takeParsedTask(scene, prana);
+            if (!task) { task = dequeue(*instance, scene, prana); }
+            if (task) {
+                builder = builders[index].get();
+                instance->nextBuilder = index + 1;
+                break;
+            }
+        }
 
-            if (m_queue.empty()) {
+        if (!task && m_numParsed < int(MAX_PARSED_PER_WORKER * m_workers.size())) {
+            // Parse ahead for any Scene - TileData does not depend on styling
+            task = dequeue(*instance, nullptr, prana);
+            if (task) {
+                // tasks rebuilding styles of a tile come with TileData
+                if (!task->isParsed()) { parseTask(*task); }
+                if (!task->isCanceled()) { pushParsedTask(std::move(task)); }
                 continue;
             }
+        }
 
-            // Pop highest priority tile from queue
-            auto it = std::min_element(m_queue.begin(), m_queue.end(),
-                [](const auto& a, const auto& b) {
-                    if (a->isProxy() != b->isProxy()) {
-                        return !a->isProxy();
-                    }
-                    if (a->sourceId() == b->sourceId() &&
-                        a->sourceGeneration() != b->sourceGeneration()) {
-                        return a->sourceGeneration() < b->sourceGeneration();
-                    }
-                    return a->getPriority() < b->getPriority();
-                });
+        if (!task) {
+            // Nothing to do - sleep until new tasks are enqueued or state changes
+            auto lock = lockTimed(m_mutex, m_schedulerLocks);
+            instance->idleSerial = serial;
+            continue;
+        }
+
+        ThreadQoS taskQoS = task->isPrefetch() ? ThreadQoS::prefetch : ThreadQoS::interactive;
+        if (switchQoS && taskQoS != qos && setCurrentThreadQoS(taskQoS)) { qos = taskQoS; }
+
+        LOGTInit(">>> process %s %s", sourceName(*task), task->tileId().toString().c_str());
+        if (!task->restore(*builder)) {
+            if (!task->isParsed()) { parseTask(*task); }
+            if (!task->isCanceled()) { buildTask(*task, *builder); }
+        }
+        if (Tile* tile = task->tile()) { tile->setTraceId(task->traceId()); }
+        LOGT("<<< process %s %s", sourceName(*task), task->tileId().toString().c_str());
+
+        // Each Map of a shared pool renders on its own Platform
+        prana->m_scene->requestTileRender(*task);
+    }
+}
+
+// Name the allocation counts of a stage in its trace event
+static void traceAllocs(Trace::Scope& _trace, const AllocCounter::Counts& _allocs) {
+    if (!AllocCounter::enabled()) { return; }
+    _trace.args.names[0] = "allocations";
+    _trace.args.values[0] = _allocs.allocations;
+    _trace.args.names[1] = "allocBytes";
+    _trace.args.values[1] = _allocs.bytes;
+}
+
+void TileWorker::parseTask(TileTask& _task) {
+    Trace::Scope trace("parse");
+    Trace::flow(_task.traceId(), Trace::Flow::step);
+    AllocCounter::Scope allocScope;
+    auto start = std::chrono::steady_clock::now();
+    _task.parse();
+    auto end = std::chrono::steady_clock::now();
+    auto allocs = allocScope.counts();
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    _task.setParseTime(micros / 1000.f);
+    m_parseStats.add(micros, allocs);
+    traceAllocs(trace, allocs);
+}
+
+void TileWorker::buildTask(TileTask& _task, TileBuilder& _builder) {
+    Trace::Scope trace("build");
+    Trace::flow(_task.traceId(), Trace::Flow::step);
+    AllocCounter::Scope allocScope;
+    auto start = std::chrono::steady_clock::now();
+    _task.build(_builder);
+    auto end = std::chrono::steady_clock::now();
+    auto allocs = allocScope.counts();
+    traceAllocs(trace, allocs);
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    if (_task.isCanceled()) {
+        // time spent building a tile that will be discarded
+        m_abortStats.add(micros, allocs);
+    } else {
+        m_buildStats.add(micros, allocs);
+        m_buildTimes.add(micros / 1000.f);
+        if (Tile* tile = _task.tile()) {
+            tile->setBuildCost(_task.parseTime() + micros / 1000.f);
+        }
+    }
+}
+
+void TileWorker::pushParsedTask(std::shared_ptr<TileTask> _task) {
+    {
+        auto lock = lockTimed(m_parsedMutex, m_queueLocks);
+        m_parsedQueue.push_back(std::move(_task));
+        ++m_numParsed;
+    }
+    ++m_pending;
+    {
+        auto lock = lockTimed(m_mutex, m_schedulerLocks);
+        ++m_serial;
+    }
+    m_condition.notify_one();
+}
 
-            task = std::move(*it);
-            m_queue.erase(it);
+std::shared_ptr<TileTask> TileWorker::takeParsedTask(const Scene* _scene, std::shared_ptr<ScenePrana>& _prana) {
+    auto lock = lockTimed(m_parsedMutex, m_queueLocks);
+    auto& queue = m_parsedQueue;
+
+    auto removes = std::remove_if(queue.begin(), queue.end(),
+                                  [](const auto& a) { return a->isCanceled() || !a->prana(); });
+    int removed = int(std::distance(removes, queue.end()));
+    m_pending -= removed;
+    m_numParsed -= removed;
+    queue.erase(removes, queue.end());
+
+    auto best = queue.end();
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        auto prana = (*it)->prana();
+        if (!prana || prana->m_scene != _scene) { continue; }
+
+        if (best == queue.end() || compareKeys(taskKey(**it), taskKey(**best))) {
+            best = it;
+            _prana = std::move(prana);
         }
+    }
+
+    if (best == queue.end()) { return nullptr; }
+
+    std::shared_ptr<TileTask> task = std::move(*best);
+    *best = std::move(queue.back());
+    queue.pop_back();
+    --m_pending;
+    --m_numParsed;
+
+    return task;
+}
+
+TileWorker::Stats TileWorker::stats() const {
+    Stats stats;
+    stats.parsed = m_parseStats.count;
+    stats.built = m_buildStats.count;
+    stats.parseTime = m_parseStats.micros / 1000.f;
+    stats.buildTime = m_buildStats.micros / 1000.f;
+    stats.buildTimeP95 = m_buildTimes.percentile(95);
+    stats.aborted = m_abortStats.count;
+    stats.abortedTime = m_abortStats.micros / 1000.f;
+    stats.queued = std::max(0, int(m_pending) - int(m_numParsed));
+    stats.parsedQueued = std::max(0, int(m_numParsed));
+    stats.schedulerLockWaits = m_schedulerLocks.waits;
+    stats.schedulerLockTime = m_schedulerLocks.waitTime();
+    stats.queueLockWaits = m_queueLocks.waits;
+    stats.queueLockTime = m_queueLocks.waitTime();
+    stats.parseAllocations = m_parseStats.allocations;
+    stats.parseAllocBytes = m_parseStats.allocBytes;
+    stats.buildAllocations = m_buildStats.allocations;
+    stats.buildAllocBytes = m_buildStats.allocBytes;
+    return stats;
+}
+
+void TileWorker::refreshQueue(Worker& _worker) {
+    uint64_t epoch = m_priorityEpoch;
+    if (_worker.queueEpoch == epoch) { return; }
+
+    // Canceled tasks and tasks of destroyed Scenes are only dropped when a worker looks at the queue
+    auto& queue = _worker.queue;
+    auto removes = std::remove_if(queue.begin(), queue.end(), [](const auto& a) {
+        return a.task->isCanceled() || !a.task->prana();
+    });
+    m_pending -= int(std::distance(removes, queue.end()));
+    queue.erase(removes, queue.end());
+
+    for (auto& entry : queue) { entry.key = taskKey(*entry.task); }
+    std::make_heap(queue.begin(), queue.end(), heapOrder);
+    _worker.queueEpoch = epoch;
+}
+
+std::shared_ptr<TileTask> TileWorker::takeTask(Worker& _worker, const Scene* _scene,
+                                               std::shared_ptr<ScenePrana>& _prana) {
+    auto lock = lockTimed(_worker.queueMutex, m_queueLocks);
+    auto& queue = _worker.queue;
+
+    refreshQueue(_worker);
+
+    std::shared_ptr<TileTask> task;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), heapOrder);
+        auto& top = queue.back();
+        auto prana = top.task->prana();
+        if (!top.task->isCanceled() && prana) {
+            // Tasks of another Scene are left for workers with a matching TileBuilder
+            if (_scene && prana->m_scene != _scene) {
+                std::push_heap(queue.begin(), queue.end(), heapOrder);
+                break;
+            }
+            task = std::move(top.task);
+            _prana = std::move(prana);
+        }
+        queue.pop_back();
+        --m_pending;
+        if (task) { break; }
+    }
+
+    if (!task && _scene && !queue.empty()) {
+        // Only with several Scenes sharing the workers: best task of @_scene below the top
+        auto best = queue.end();
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            auto prana = it->task->prana();
+            if (!prana || prana->m_scene != _scene || it->task->isCanceled()) { continue; }
+            if (best == queue.end() || compareKeys(it->key, best->key)) {
+                best = it;
+                _prana = std::move(prana);
+            }
+        }
+        if (best != queue.end()) {
+            task = std::move(best->task);
+            *best = std::move(queue.back());
+            queue.pop_back();
+            --m_pending;
+            std::make_heap(queue.begin(), queue.end(), heapOrder);
+        }
+    }
+
+    _worker.topRank = queue.empty() ? UINT64_MAX : rank(queue.front().key);
+    return task;
+}
 
-        if (task->isCanceled()) { continue; }
+std::shared_ptr<TileTask> TileWorker::dequeue(Worker& _worker, const Scene* _scene,
+                                              std::shared_ptr<ScenePrana>& _prana) {
+    // Published ranks are read without locking, so only a queue worth stealing from gets locked;
+    // steal when the own queue is empty or its top task is of a less urgent class, e.g. a prefetch
+    // task while another queue holds visible tiles
+    Worker* victim = nullptr;
+    uint64_t victimRank = UINT64_MAX;
+    for (auto& worker : m_workers) {
+        uint64_t topRank = worker->topRank;
+        if (worker.get() != &_worker && topRank < victimRank) {
+            victim = worker.get();
+            victimRank = topRank;
+        }
+    }
+    if (victim && (victimRank >> 32) < (_worker.topRank >> 32)) {
+        if (auto task = takeTask(*victim, _scene, _prana)) { return task; }
+    }
 
-        LOGTInit(">>> process %s %s", task->source()->name().c_str(), task->tileId().toString().c_str());
-        task->process(*builder);
-        LOGT("<<< process %s %s", task->source()->name().c_str(), task->tileId().toString().c_str());
+    if (auto task = takeTask(_worker, _scene, _prana)) { return task; }
 
-        m_platform.requestRender();
+    // Nothing for @_scene in the own queue
+    for (auto& worker : m_workers) {
+        if (worker.get() == &_worker || worker->topRank == UINT64_MAX) { continue; }
+        if (auto task = takeTask(*worker, _scene, _prana)) { return task; }
     }
+    return nullptr;
+}
+
+void TileWorker::updatePriorities() {
+    ++m_priorityEpoch;
 }
 
 void TileWorker::setScene(Scene& _scene) {
     {
         std::unique_lock<std::mutex> lock(m_mutex);
         for (auto& worker : m_workers) {
-            worker->tileBuilder = std::make_unique<TileBuilder>(_scene);
+            worker->newBuilders.push_back(std::make_unique<TileBuilder>(_scene, m_triangulationCache.get(),
+                                                                        m_collisionCache.get()));
         }
+        // New TileBuilders must not build tiles before their Scene is complete
+        m_completeScenes.erase(std::remove(m_completeScenes.begin(), m_completeScenes.end(), &_scene),
+                               m_completeScenes.end());
+        ++m_serial;
         m_condition.notify_all();
     }
 }
 
+void TileWorker::releaseScene(const Scene& _scene) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_completeScenes.erase(std::remove(m_completeScenes.begin(), m_completeScenes.end(), &_scene),
+                           m_completeScenes.end());
+
+    for (auto& worker : m_workers) {
+        auto& newBuilders = worker->newBuilders;
+        newBuilders.erase(std::remove_if(newBuilders.begin(), newBuilders.end(), [&](auto& builder) {
+            return &builder->scene() == &_scene;
+        }), newBuilders.end());
+
+        auto& scenes = worker->scenes;
+        if (std::find(scenes.begin(), scenes.end(), &_scene) != scenes.end()) {
+            worker->released.push_back(&_scene);
+        }
+    }
+    m_condition.notify_all();
+
+    // Workers release their TileBuilder after finishing the current task
+    m_condition.wait(lock, [&] {
+        return std::none_of(m_workers.begin(), m_workers.end(), [&](const auto& worker) {
+            auto& scenes = worker->scenes;
+            return std::find(scenes.begin(), scenes.end(), &_scene) != scenes.end();
+        });
+    });
+}
+
 void TileWorker::enqueue(std::shared_ptr<TileTask> task) {
+    if (!m_running || m_workers.empty()) { return; }
+
+    LOGTO("--- %d enqueue %s %s", int(m_pending)+1, sourceName(*task), task->tileId().toString().c_str());
+
+    // Tasks arrive sorted by priority from TileManager::loadTiles(), so distributing them round robin
+    // spreads the most urgent tiles over all worker queues
+    auto& worker = *m_workers[m_nextQueue++ % m_workers.size()];
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        if (!m_running) { return; }
-        LOGTO("--- %d enqueue %s %s", m_queue.size()+1, task->source()->name().c_str(), task->tileId().toString().c_str());
-        m_queue.push_back(std::move(task));
+        auto lock = lockTimed(worker.queueMutex, m_queueLocks);
+        auto& queue = worker.queue;
+        refreshQueue(worker);
+        TaskKey key = taskKey(*task);
+        queue.push_back({ std::move(task), key });
+        std::push_heap(queue.begin(), queue.end(), heapOrder);
+        worker.topRank = rank(queue.front().key);
+    }
+    ++m_pending;
 
-        m_condition.notify_all();
+    // Any idle worker will do - it steals the task if it is more urgent than those of its own queue
+    {
+        auto lock = lockTimed(m_mutex, m_schedulerLocks);
+        ++m_serial;
     }
+    m_condition.notify_one();
 }
 
-void TileWorker::startJobs() {
+void TileWorker::startJobs(const Scene& _scene) {
     {
         std::unique_lock<std::mutex> lock(m_mutex);
-        m_sceneComplete = true;
+        if (std::find(m_completeScenes.begin(), m_completeScenes.end(), &_scene) == m_completeScenes.end()) {
+            m_completeScenes.push_back(&_scene);
+        }
+        ++m_serial;
 
-        LOGTO("Poking TileWorker - enqueued %d", m_queue.size());
-        if (!m_running || m_queue.empty()) { return; }
+        LOGTO("Poking TileWorker - enqueued %d", int(m_pending));
+        if (!m_running || m_pending <= 0) { return; }
 
         m_condition.notify_all();
     }
@@ -144,7 +524,17 @@ void TileWorker::stop() {
         worker->thread.join();
     }
 
-    m_queue.clear();
+    for (auto& worker : m_workers) {
+        std::lock_guard<std::mutex> lock(worker->queueMutex);
+        worker->queue.clear();
+        worker->topRank = UINT64_MAX;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_parsedMutex);
+        m_parsedQueue.clear();
+    }
+    m_pending = 0;
+    m_numParsed = 0;
 }
 
 }
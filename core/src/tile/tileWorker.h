@@ -1,7 +1,10 @@
 #pragma once
 
+#include "debug/allocCounter.h"
 #include "tile/tileTask.h"
 #include "util/jobQueue.h"
+#include "util/lockStats.h"
+#include "util/timeHistogram.h"
 
 #include <atomic>
 #include <condition_variable>
@@ -13,52 +16,211 @@
 namespace Tangram {
 
 class JobQueue;
-class Platform;
 class Scene;
+class ScenePrana;
+class CollisionCache;
 class TileBuilder;
-
+class TriangulationCache;
+
+/* Pool of threads building TileTasks
+ *
+ * A TileWorker is owned by Map, or shared by the Maps of a MapContext, and outlives Scenes:
+ * setScene() hands new TileBuilders to the worker threads, which pick them up after finishing
+ * their current task. Each worker keeps a TileBuilder for every live Scene and takes turns
+ * between the complete Scenes, so that Maps sharing the pool get the same share of builds.
+ *
+ * Processing is split in two stages: TileTask::parse() decodes the raw data and does not depend
+ * on the Scene styles, so idle workers parse ahead (e.g. while the Scene is still loading) and
+ * put the task on the parsed queue; TileTask::build() then needs a TileBuilder for the Scene.
+ */
 class TileWorker : public TileTaskQueue {
 
 public:
 
-    TileWorker(Platform& _platform, int _numWorker);
+    /// @_pinWorkers: keep the workers on the cores given by CpuTopology::workerCpus(), on
+    /// devices with cores of different speeds
+    explicit TileWorker(int _numWorker, bool _pinWorkers = false);
 
     virtual ~TileWorker();
 
     virtual void enqueue(std::shared_ptr<TileTask> task) override;
 
+    /// Order queued tasks by their updated priorities when they are taken next
+    virtual void updatePriorities() override;
+
     void stop();
 
     bool isRunning() const { return m_running; }
 
-    /// Set Scene and initialize TileBuilders
+    size_t numWorkers() const { return m_workers.size(); }
+
+    bool pinsWorkers() const { return m_pinWorkers; }
+
+    /// Add TileBuilders for @_scene; its tiles are built once startJobs() is called for it
     void setScene(Scene& _scene);
 
-    /// Start jobs when scene is complete.
-    void startJobs();
+    /// Start building tiles of @_scene when it is complete.
+    void startJobs(const Scene& _scene);
+
+    /// Drop TileBuilders of @_scene; blocks until no worker is building a tile for it.
+    void releaseScene(const Scene& _scene);
+
+    struct Stats {
+        uint32_t parsed = 0;        // total tasks parsed
+        uint32_t built = 0;         // total tasks built
+        float parseTime = 0;        // total ms spent in parse stage
+        float buildTime = 0;        // total ms spent in build stage
+        float buildTimeP95 = 0;     // 95th percentile of ms per build, see TimeHistogram
+        uint32_t aborted = 0;       // builds stopped because the task got canceled
+        float abortedTime = 0;      // total ms wasted in aborted builds
+        uint32_t queued = 0;        // tasks waiting to be parsed
+        uint32_t parsedQueued = 0;  // tasks parsed ahead, waiting to be built
+        uint32_t schedulerLockWaits = 0; // contended locks of m_mutex
+        float schedulerLockTime = 0;     // total ms waited for m_mutex
+        uint32_t queueLockWaits = 0;     // contended locks of the task queues
+        float queueLockTime = 0;         // total ms waited for the task queues
+        // heap allocations and requested bytes of the parse and build stages, counted in
+        // builds with TANGRAM_ALLOC_PROFILING, see AllocCounter
+        uint64_t parseAllocations = 0;
+        uint64_t parseAllocBytes = 0;
+        uint64_t buildAllocations = 0;
+        uint64_t buildAllocBytes = 0;
+    };
+    Stats stats() const;
 
 private:
 
+    /// Ordering state of a queued task, taken when it is queued and when priorities are updated,
+    /// so that the heap order of a queue only changes while it is locked
+    struct TaskKey {
+        bool prefetch;
+        bool proxy;
+        int64_t sourceId;
+        int64_t sourceGeneration;
+        float priority;
+    };
+
+    struct QueuedTask {
+        std::shared_ptr<TileTask> task;
+        TaskKey key;
+    };
+
+    static TaskKey taskKey(TileTask& _task);
+
+    /// Heap order of a worker queue, with the best task at the front
+    static bool heapOrder(const QueuedTask& _a, const QueuedTask& _b);
+
+    /// True if a task with @_a should run before one with @_b
+    static bool compareKeys(const TaskKey& _a, const TaskKey& _b);
+
+    /// Urgency of a task for choosing a queue to steal from, lower is more urgent
+    static uint64_t rank(const TaskKey& _key);
+
     struct Worker {
         std::thread thread;
-        std::unique_ptr<TileBuilder> tileBuilder;
+
+        /// New TileBuilders handed over by setScene()
+        std::vector<std::unique_ptr<TileBuilder>> newBuilders;
+
+        /// Scenes of the TileBuilders used by this worker
+        std::vector<const Scene*> scenes;
+
+        /// Scenes whose TileBuilders are dropped, set by releaseScene()
+        std::vector<const Scene*> released;
+
+        /// Index of the TileBuilder to try first for the next task; only used by the worker thread
+        size_t nextBuilder = 0;
+
+        /// Value of m_serial when this worker last found no task to process
+        uint64_t idleSerial = 0;
+
+        /// Tasks assigned to this worker as a heap with the best task on top; other workers
+        /// steal from here when their own queue has no task of the same urgency, see dequeue()
+        std::mutex queueMutex;
+        std::vector<QueuedTask> queue;
+
+        /// m_priorityEpoch when the keys of queue were last refreshed
+        uint64_t queueEpoch = 0;
+
+        /// rank() of the top task, or UINT64_MAX when empty; read without the lock
+        std::atomic<uint64_t> topRank{UINT64_MAX};
     };
 
     void run(Worker* instance);
 
-    bool m_running;
+    /// Take highest priority task from own queue, or steal from another worker if the own queue
+    /// is empty or its top task is less urgent than theirs
+    std::shared_ptr<TileTask> dequeue(Worker& _worker, const Scene* _scene,
+                                      std::shared_ptr<ScenePrana>& _prana);
+
+    /// Remove and return highest priority task of @_scene from @_worker queue;
+    /// @_scene null matches any live Scene; canceled tasks and tasks of destroyed Scenes are dropped
+    std::shared_ptr<TileTask> takeTask(Worker& _worker, const Scene* _scene,
+                                       std::shared_ptr<ScenePrana>& _prana);
+
+    /// Refresh the keys of @_worker queue after priorities were updated; queueMutex must be locked
+    void refreshQueue(Worker& _worker);
+
+    void parseTask(TileTask& _task);
+    void buildTask(TileTask& _task, TileBuilder& _builder);
+
+    /// Parsed stage queue
+    void pushParsedTask(std::shared_ptr<TileTask> _task);
+    std::shared_ptr<TileTask> takeParsedTask(const Scene* _scene, std::shared_ptr<ScenePrana>& _prana);
+
+    struct StageStats {
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint64_t> micros{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> allocBytes{0};
+        void add(uint64_t _micros, const AllocCounter::Counts& _allocs) {
+            ++count;
+            micros += _micros;
+            allocations += _allocs.allocations;
+            allocBytes += _allocs.bytes;
+        }
+    };
+    StageStats m_parseStats;
+    StageStats m_buildStats;
+    StageStats m_abortStats;
+    TimeHistogram m_buildTimes;
+
+    /// Time waited for m_mutex and for the worker and parsed queues
+    LockStats m_schedulerLocks;
+    LockStats m_queueLocks;
+
+    std::atomic<bool> m_running;
 
-    /// Set true by startJobs()
-    bool m_sceneComplete = false;
+    const bool m_pinWorkers;
+
+    /// Scenes passed to startJobs() and not released yet
+    std::vector<const Scene*> m_completeScenes;
 
     std::vector<std::unique_ptr<Worker>> m_workers;
 
+    /// Sleeping workers wait on this - only guards m_running, m_completeScenes and TileBuilder handoff
     std::condition_variable m_condition;
-
     std::mutex m_mutex;
-    std::vector<std::shared_ptr<TileTask>> m_queue;
 
-    Platform& m_platform;
+    /// Incremented on every enqueue and state change, so that idle workers only wake up for new work
+    uint64_t m_serial = 0;
+
+    /// Number of tasks in all worker queues (may briefly go negative when a task is taken before enqueue counted it)
+    std::atomic<int> m_pending{0};
+    std::atomic<uint32_t> m_nextQueue{0};
+
+    /// Incremented by updatePriorities()
+    std::atomic<uint64_t> m_priorityEpoch{0};
+
+    std::mutex m_parsedMutex;
+    std::vector<std::shared_ptr<TileTask>> m_parsedQueue;
+    std::atomic<int> m_numParsed{0};
+
+    /// Polygon triangulations shared by the TileBuilders of all Scenes
+    std::unique_ptr<TriangulationCache> m_triangulationCache;
+
+    /// Label collision results shared by the TileBuilders of all Scenes
+    std::unique_ptr<CollisionCache> m_collisionCache;
 };
 
 }
@@ -0,0 +1,90 @@
+#include "util/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Tangram {
+
+// Arena kept for the next TileArena::acquire() on this thread
+static thread_local std::unique_ptr<TileArena> t_spareArena;
+
+TileArena::~TileArena() {}
+
+void TileArena::addBlock(size_t _bytes) {
+
+    size_t size = std::min(std::max(BLOCK_SIZE, 2 * m_lastBlockSize), MAX_BLOCK_SIZE);
+    size = std::max(size, _bytes);
+
+    m_blocks.emplace_back(new char[size]);
+    m_capacity += size;
+    m_lastBlockSize = size;
+
+    m_top = m_blocks.back().get();
+    m_end = m_top + size;
+    m_last = nullptr;
+}
+
+void* TileArena::allocate(size_t _bytes, size_t _alignment) {
+
+    if (_bytes == 0) { _bytes = 1; }
+
+    auto aligned = [&]() {
+        auto top = reinterpret_cast<uintptr_t>(m_top);
+        return reinterpret_cast<char*>((top + _alignment - 1) & ~uintptr_t(_alignment - 1));
+    };
+
+    char* ptr = m_top ? aligned() : nullptr;
+    if (!ptr || ptr + _bytes > m_end) {
+        addBlock(_bytes + _alignment);
+        ptr = aligned();
+    }
+
+    m_last = ptr;
+    m_top = ptr + _bytes;
+    return ptr;
+}
+
+void TileArena::deallocate(void* _ptr, size_t _bytes) {
+
+    if (_ptr && _ptr == m_last && m_last + std::max(_bytes, size_t(1)) == m_top) {
+        m_top = m_last;
+        m_last = nullptr;
+    }
+}
+
+void TileArena::reset() {
+
+    if (m_blocks.size() > 1 || m_capacity > MAX_BLOCK_SIZE) {
+        size_t capacity = std::min(m_capacity, MAX_BLOCK_SIZE);
+        m_blocks.clear();
+        m_blocks.emplace_back(new char[capacity]);
+        m_capacity = capacity;
+        m_lastBlockSize = capacity;
+    }
+
+    if (m_blocks.empty()) {
+        m_top = m_end = nullptr;
+    } else {
+        m_top = m_blocks.front().get();
+        m_end = m_top + m_capacity;
+    }
+    m_last = nullptr;
+}
+
+std::shared_ptr<TileArena> TileArena::acquire() {
+
+    std::unique_ptr<TileArena> arena = std::move(t_spareArena);
+    if (!arena) { arena = std::make_unique<TileArena>(); }
+
+    return std::shared_ptr<TileArena>(arena.release(), [](TileArena* _arena) {
+        // keep the arena for the next tile parsed on the releasing thread
+        _arena->reset();
+        if (!t_spareArena) {
+            t_spareArena.reset(_arena);
+        } else {
+            delete _arena;
+        }
+    });
+}
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+/* Monotonic allocator for the data of one tile
+ *
+ * Memory is handed out from large blocks and only released all at once, when the arena is
+ * destroyed or reset. Freeing the most recent allocation gives its memory back, so that a
+ * growing vector that is the last one allocated is extended in place.
+ *
+ * Arenas from acquire() are reused: when the last reference is released, the arena is reset
+ * and kept for the next acquire() on that thread, usually the worker that parses the next tile.
+ */
+class TileArena {
+
+public:
+
+    // Size of the first block; following blocks double in size up to MAX_BLOCK_SIZE
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+    TileArena() {}
+    ~TileArena();
+
+    TileArena(const TileArena&) = delete;
+    TileArena& operator=(const TileArena&) = delete;
+
+    void* allocate(size_t _bytes, size_t _alignment);
+    void deallocate(void* _ptr, size_t _bytes);
+
+    // Release all allocations; the blocks are replaced by one block of their total size,
+    // up to MAX_BLOCK_SIZE, so that a tile like the last one needs a single block
+    void reset();
+
+    // Bytes of all blocks
+    size_t capacity() const { return m_capacity; }
+
+    // Arena released last on this thread, or a new one
+    static std::shared_ptr<TileArena> acquire();
+
+private:
+
+    void addBlock(size_t _bytes);
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    size_t m_capacity = 0;
+    size_t m_lastBlockSize = 0;
+
+    // free range of the current block
+    char* m_top = nullptr;
+    char* m_end = nullptr;
+    // start of the last allocation, for deallocate()
+    char* m_last = nullptr;
+};
+
+/* STL allocator for containers in a TileArena; without arena it uses the heap
+ *
+ * Containers constructed with the allocator by a container using it (e.g. the Lines of a
+ * Polygon) allocate from the same arena. Copies of containers use the heap, so that they
+ * may outlive the arena.
+ */
+template<typename T>
+struct TileAllocator {
+
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    TileAllocator() {}
+    TileAllocator(TileArena* _arena) : arena(_arena) {}
+
+    template<typename U>
+    TileAllocator(const TileAllocator<U>& _other) : arena(_other.arena) {}
+
+    T* allocate(size_t _n) {
+        if (!arena) { return static_cast<T*>(::operator new(_n * sizeof(T))); }
+        return static_cast<T*>(arena->allocate(_n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* _ptr, size_t _n) {
+        if (!arena) { ::operator delete(_ptr); }
+        else { arena->deallocate(_ptr, _n * sizeof(T)); }
+    }
+
+    TileAllocator select_on_container_copy_construction() const { return {}; }
+
+    template<typename U, typename... Args>
+    void construct(U* _ptr, Args&&... _args) {
+        using UsesAllocator = std::integral_constant<bool,
+            std::uses_allocator<U, TileAllocator>::value &&
+            std::is_constructible<U, Args..., const TileAllocator&>::value>;
+        constructWith(UsesAllocator(), _ptr, std::forward<Args>(_args)...);
+    }
+
+    TileArena* arena = nullptr;
+
+private:
+
+    template<typename U, typename... Args>
+    void constructWith(std::true_type, U* _ptr, Args&&... _args) {
+        ::new (static_cast<void*>(_ptr)) U(std::forward<Args>(_args)..., *this);
+    }
+
+    template<typename U, typename... Args>
+    void constructWith(std::false_type, U* _ptr, Args&&... _args) {
+        ::new (static_cast<void*>(_ptr)) U(std::forward<Args>(_args)...);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const TileAllocator<T>& _a, const TileAllocator<U>& _b) { return _a.arena == _b.arena; }
+
+template<typename T, typename U>
+bool operator!=(const TileAllocator<T>& _a, const TileAllocator<U>& _b) { return _a.arena != _b.arena; }
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <mutex>
@@ -46,6 +48,21 @@ public:
         m_condition.notify_one();
     }
 
+    // Run @_task once @_delay has passed and no earlier task is queued; delayed tasks are run
+    //  immediately on exit if waitForCompletion() was called
+    void enqueueDelayed(std::function<void()> _task, std::chrono::milliseconds _delay) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_running) { return; }
+
+            auto time = std::chrono::steady_clock::now() + _delay;
+            auto it = std::upper_bound(m_delayed.begin(), m_delayed.end(), time,
+                                       [](auto& t, auto& entry) { return t < entry.first; });
+            m_delayed.emplace(it, time, std::move(_task));
+        }
+        m_condition.notify_one();
+    }
+
     void waitForCompletion() {
         m_waitForCompletion = true;
     }
@@ -56,12 +73,24 @@ private:
             std::function<void()> task;
             {
                 std::unique_lock<std::mutex> lock(m_mutex);
-                m_condition.wait(lock, [&]{ return !m_running || !m_queue.empty(); });
+                while (m_running && m_queue.empty()) {
+                    if (m_delayed.empty()) {
+                        m_condition.wait(lock);
+                    } else if (m_delayed.front().first <= std::chrono::steady_clock::now()) {
+                        m_queue.push_back(std::move(m_delayed.front().second));
+                        m_delayed.pop_front();
+                    } else {
+                        m_condition.wait_until(lock, m_delayed.front().first);
+                    }
+                }
 
                 if (!m_running) {
                     if (!m_waitForCompletion) {
                         break;
-                    } else if (m_queue.empty()) {
+                    }
+                    for (auto& delayed : m_delayed) { m_queue.push_back(std::move(delayed.second)); }
+                    m_delayed.clear();
+                    if (m_queue.empty()) {
                         break;
                     }
                 }
@@ -79,6 +108,8 @@ private:
     std::condition_variable m_condition;
     std::mutex m_mutex;
     std::deque<std::function<void()>> m_queue;
+    // sorted by time
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::function<void()>>> m_delayed;
 };
 
 }
@@ -1,20 +1,14 @@
 #include "util/builders.h"
 
 #include "util/geom.h"
+#include "util/triangulationCache.h"
 #include "log.h"
 #include "glm/gtx/rotate_vector.hpp"
 #include "glm/gtx/norm.hpp"
 
-namespace mapbox { namespace util {
-template <>
-struct nth<0, Tangram::Point> {
-    inline static float get(const Tangram::Point &t) { return t.x; };
-};
-template <>
-struct nth<1, Tangram::Point> {
-    inline static float get(const Tangram::Point &t) { return t.y; };
-};
-}}
+#include <algorithm>
+#include <cmath>
+#include <tuple>
 
 namespace {
 // Tests if a line segment (from point A to B) is outside the edge of a tile
@@ -59,7 +53,8 @@ JoinTypes JoinTypeFromString(const std::string& str) {
     return JoinTypes::miter;
 }
 
-void Builders::buildPolygon(const Polygon& _polygon, float _height, PolygonBuilder& _ctx) {
+void Builders::buildPolygon(PolygonView _polygon, float _height, PolygonBuilder& _ctx,
+                            Span<uint16_t> _triangles) {
 
     glm::vec2 min, max;
     if (_ctx.useTexCoords) {
@@ -74,18 +69,28 @@ void Builders::buildPolygon(const Polygon& _polygon, float _height, PolygonBuild
         }
     }
 
-    // Run earcut, triangles are stored in _ctx.earcut.indices
-    _ctx.earcut(_polygon);
+    // Run earcut, or take its triangles from the cache, unless they are given
+    std::shared_ptr<const TriangulationCache::Indices> cached;
+    Span<uint16_t> triangles = _triangles;
+    if (triangles.empty()) {
+        if (_ctx.triangulationCache) {
+            cached = _ctx.triangulationCache->get(_polygon, _ctx.earcut);
+        }
+        if (!cached) {
+            _ctx.earcut(_polygon);
+        }
+        triangles = cached ? *cached : _ctx.earcut.indices;
+    }
 
     size_t sumPoints = 0;
-    for (auto& line : _polygon) {
+    for (auto line : _polygon) {
         sumPoints += line.size();
     }
 
     // Mark the points that are referenced by indices as used.
     size_t sumVertices = 0;
     _ctx.used.assign(sumPoints, 0);
-    for (auto i : _ctx.earcut.indices) {
+    for (auto i : triangles) {
         if (_ctx.used[i] == 0) {
             _ctx.used[i] = 1;
             sumVertices++;
@@ -96,6 +101,7 @@ void Builders::buildPolygon(const Polygon& _polygon, float _height, PolygonBuild
 
     uint16_t vertexDataOffset = _ctx.numVertices;
     _ctx.numVertices += sumVertices;
+    _ctx.vertices.reserve(_ctx.vertices.size() + sumVertices);
 
     size_t ring = 0;
     size_t offset = 0;
@@ -121,25 +127,33 @@ void Builders::buildPolygon(const Polygon& _polygon, float _height, PolygonBuild
         if (_ctx.useTexCoords) {
             glm::vec2 uv(mapRange01(coord.x, min.x, max.x), mapRange01(coord.y, max.y, min.y));
 
-            _ctx.addVertex(coord, glm::vec3(0.0, 0.0, 1.0), uv);
+            _ctx.vertices.push_back({ coord, glm::vec3(0.0, 0.0, 1.0), uv });
         } else {
-            _ctx.addVertex(coord, glm::vec3(0.0, 0.0, 1.0), glm::vec2(0));
+            _ctx.vertices.push_back({ coord, glm::vec3(0.0, 0.0, 1.0), glm::vec2(0) });
         }
     }
 
-    for (auto i : _ctx.earcut.indices) {
+    for (auto i : triangles) {
         _ctx.indices.push_back(vertexDataOffset + _ctx.used[i]);
     }
 }
 
-void Builders::buildPolygonExtrusion(const Polygon& _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx) {
+void Builders::buildPolygonExtrusion(PolygonView _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx) {
 
     auto vertexDataOffset = _ctx.numVertices;
 
+    // Four vertices and six indices per edge at most
+    size_t numEdges = 0;
+    for (auto line : _polygon) {
+        if (line.size() > 1) { numEdges += line.size() - 1; }
+    }
+    _ctx.vertices.reserve(_ctx.vertices.size() + numEdges * 4);
+    _ctx.indices.reserve(_ctx.indices.size() + numEdges * 6);
+
     static const glm::vec3 upVector(0.0f, 0.0f, 1.0f);
     glm::vec3 normalVector;
 
-    for (auto& line : _polygon) {
+    for (auto line : _polygon) {
 
         size_t lineSize = line.size();
 
@@ -162,19 +176,19 @@ void Builders::buildPolygonExtrusion(const Polygon& _polygon, float _minHeight,
 
             // 1st vertex top
             a.z = _maxHeight;
-            _ctx.addVertex(a, normalVector, glm::vec2(1.,1.));
+            _ctx.vertices.push_back({ a, normalVector, glm::vec2(1.,1.) });
 
             // 2nd vertex top
             b.z = _maxHeight;
-            _ctx.addVertex(b, normalVector, glm::vec2(0.,1.));
+            _ctx.vertices.push_back({ b, normalVector, glm::vec2(0.,1.) });
 
             // 1st vertex bottom
             a.z = _minHeight;
-            _ctx.addVertex(a, normalVector, glm::vec2(1.,0.));
+            _ctx.vertices.push_back({ a, normalVector, glm::vec2(1.,0.) });
 
             // 2nd vertex bottom
             b.z = _minHeight;
-            _ctx.addVertex(b, normalVector, glm::vec2(0.,0.));
+            _ctx.vertices.push_back({ b, normalVector, glm::vec2(0.,0.) });
 
             // Start the index from the previous state of the vertex Data
             _ctx.indices.push_back(vertexDataOffset);
@@ -192,6 +206,125 @@ void Builders::buildPolygonExtrusion(const Polygon& _polygon, float _minHeight,
     }
 }
 
+void Builders::addExtrusionWalls(PolygonView _polygon, float _minHeight, float _maxHeight, uint32_t _index,
+                                 bool _keepTileEdges, ExtrusionWalls& _walls) {
+
+    for (auto line : _polygon) {
+        for (size_t i = 0; i + 1 < line.size(); i++) {
+            const glm::vec2& a = line[i];
+            const glm::vec2& b = line[i+1];
+
+            // Degenerate edges have no normal
+            if (a == b) { continue; }
+            if (!_keepTileEdges && isOutsideTile(a, b)) { continue; }
+
+            _walls.walls.push_back({ a, b, _minHeight, _maxHeight, _index });
+        }
+    }
+}
+
+// Vertex precision of tile coordinates, as in PolygonStyle
+static constexpr float WALL_POSITION_SCALE = 8192.f;
+
+// End points of an edge at vertex precision
+struct EdgeKey {
+    int32_t ax, ay, bx, by;
+
+    EdgeKey(const glm::vec2& _a, const glm::vec2& _b)
+        : ax(std::lround(_a.x * WALL_POSITION_SCALE)), ay(std::lround(_a.y * WALL_POSITION_SCALE)),
+          bx(std::lround(_b.x * WALL_POSITION_SCALE)), by(std::lround(_b.y * WALL_POSITION_SCALE)) {}
+
+    bool operator<(const EdgeKey& _other) const {
+        return std::tie(ax, ay, bx, by) < std::tie(_other.ax, _other.ay, _other.bx, _other.by);
+    }
+    bool operator==(const EdgeKey& _other) const {
+        return ax == _other.ax && ay == _other.ay && bx == _other.bx && by == _other.by;
+    }
+};
+
+void Builders::cullExtrusionWalls(ExtrusionWalls& _walls) {
+
+    auto& walls = _walls.walls;
+
+    std::vector<std::pair<EdgeKey, uint32_t>> edges;
+    edges.reserve(walls.size());
+    for (uint32_t i = 0; i < walls.size(); i++) {
+        edges.emplace_back(EdgeKey(walls[i].a, walls[i].b), i);
+    }
+    std::sort(edges.begin(), edges.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // Compare with the heights of the other walls before any is raised
+    std::vector<float> minHeights(walls.size());
+
+    for (uint32_t i = 0; i < walls.size(); i++) {
+        auto& wall = walls[i];
+        minHeights[i] = wall.minHeight;
+
+        // Adjacent polygons share the edge in opposite direction
+        EdgeKey reverse(wall.b, wall.a);
+        auto it = std::lower_bound(edges.begin(), edges.end(), reverse,
+                                   [](const auto& edge, const EdgeKey& key) { return edge.first < key; });
+
+        for (; it != edges.end() && it->first == reverse; ++it) {
+            const auto& other = walls[it->second];
+            if (other.polygon == wall.polygon || other.minHeight > wall.minHeight) { continue; }
+
+            if (other.maxHeight >= wall.maxHeight) {
+                wall.hidden = true;
+                break;
+            }
+            // Covered from the bottom up to the top of the other wall
+            minHeights[i] = std::max(minHeights[i], other.maxHeight);
+        }
+    }
+
+    for (uint32_t i = 0; i < walls.size(); i++) {
+        walls[i].minHeight = minHeights[i];
+    }
+}
+
+bool Builders::buildExtrusionWall(const ExtrusionWalls::Wall& _wall, bool _extend, PolygonBuilder& _ctx) {
+
+    static const glm::vec3 upVector(0.0f, 0.0f, 1.0f);
+    glm::vec3 normalVector = glm::normalize(glm::cross(upVector, glm::vec3(_wall.b - _wall.a, 0.f)));
+
+    if (_extend && _ctx.vertices.size() >= 4) {
+        // Top and bottom vertices of the start and end of the last wall
+        auto* last = &_ctx.vertices[_ctx.vertices.size() - 4];
+        glm::vec2 start(last[0].coord.x, last[0].coord.y);
+        glm::vec2 end(last[1].coord.x, last[1].coord.y);
+
+        float tolerance = 0.5f / WALL_POSITION_SCALE;
+
+        if (end == _wall.a && last[1].coord.z == _wall.maxHeight && last[3].coord.z == _wall.minHeight &&
+            glm::dot(last[0].normal, normalVector) > 0.f &&
+            pointSegmentDistanceSq(_wall.a, start, _wall.b) < tolerance * tolerance) {
+
+            last[1].coord = glm::vec3(_wall.b, _wall.maxHeight);
+            last[3].coord = glm::vec3(_wall.b, _wall.minHeight);
+            return false;
+        }
+    }
+
+    auto vertexDataOffset = _ctx.numVertices;
+
+    _ctx.vertices.push_back({ glm::vec3(_wall.a, _wall.maxHeight), normalVector, glm::vec2(1.,1.) });
+    _ctx.vertices.push_back({ glm::vec3(_wall.b, _wall.maxHeight), normalVector, glm::vec2(0.,1.) });
+    _ctx.vertices.push_back({ glm::vec3(_wall.a, _wall.minHeight), normalVector, glm::vec2(1.,0.) });
+    _ctx.vertices.push_back({ glm::vec3(_wall.b, _wall.minHeight), normalVector, glm::vec2(0.,0.) });
+
+    _ctx.indices.push_back(vertexDataOffset);
+    _ctx.indices.push_back(vertexDataOffset + 1);
+    _ctx.indices.push_back(vertexDataOffset + 2);
+
+    _ctx.indices.push_back(vertexDataOffset + 1);
+    _ctx.indices.push_back(vertexDataOffset + 3);
+    _ctx.indices.push_back(vertexDataOffset + 2);
+
+    _ctx.numVertices += 4;
+    return true;
+}
+
 // Get 2D perpendicular of two points
 static glm::vec2 perp2d(const glm::vec2& _v1, const glm::vec2& _v2 ){
     return glm::vec2(_v2.y - _v1.y, _v1.x - _v2.x);
@@ -201,7 +334,7 @@ static glm::vec2 perp2d(const glm::vec2& _v1, const glm::vec2& _v2 ){
 static inline void addPolyLineVertex(const glm::vec2& _coord, const glm::vec2& _normal,
                                      const glm::vec2& _uv, PolyLineBuilder& _ctx) {
     _ctx.numVertices++;
-    _ctx.addVertex(_coord, _normal, _uv);
+    _ctx.vertices.push_back({ _coord, _normal, _uv });
 }
 
 // Helper function for polyline tesselation; adds indices for pairs of vertices arranged like a line strip
@@ -290,7 +423,36 @@ static void addCap(const glm::vec2& _coord, const glm::vec2& _normal, int _numCo
     addFan(_coord, nA, nB, nC, uA, uB, uC, _numCorners, _ctx);
 }
 
-static void buildPolyLineSegment(const Line& _line, PolyLineBuilder& _ctx, size_t _startIndex,
+// Function to add the segments of a run of the line with their neighbors, see PolyLineBuilder::segmentsOnly
+static void addPolyLineSegments(LineView _line, PolyLineBuilder& _ctx, size_t _startIndex,
+                                int _lineSize, bool _startCap, bool _endCap) {
+
+    size_t origLineSize = _line.size();
+    size_t first = _ctx.segments.size();
+
+    glm::vec2 coordCurr(_line[_startIndex]);
+
+    for (int i = 1; i < _lineSize; i++) {
+        glm::vec2 coordNext(_line[(_startIndex + i) % origLineSize]);
+        if (coordNext == coordCurr) { continue; }
+
+        if (_ctx.segments.size() > first) {
+            auto& last = _ctx.segments.back();
+            last.next = coordNext;
+            _ctx.segments.push_back({ last.start, coordCurr, coordNext, coordNext });
+        } else {
+            _ctx.segments.push_back({ coordCurr, coordCurr, coordNext, coordNext });
+        }
+        coordCurr = coordNext;
+    }
+
+    if (_ctx.segments.size() == first) { return; }
+
+    _ctx.segments[first].startCap = _startCap;
+    _ctx.segments.back().endCap = _endCap;
+}
+
+static void buildPolyLineSegment(LineView _line, PolyLineBuilder& _ctx, size_t _startIndex,
                           size_t _endIndex, bool startCap = true, bool endCap = true) {
 
     float distance = 0; // Cumulative distance along the polyline.
@@ -303,6 +465,11 @@ static void buildPolyLineSegment(const Line& _line, PolyLineBuilder& _ctx, size_
                    (origLineSize - _startIndex + _endIndex));
     if (lineSize < 2) { return; }
 
+    if (_ctx.segmentsOnly) {
+        addPolyLineSegments(_line, _ctx, _startIndex, lineSize, startCap, endCap);
+        return;
+    }
+
     glm::vec2 coordCurr(_line[_startIndex]);
     // get the Point using wrapped index in the original line geometry
     glm::vec2 coordNext(_line[(_startIndex + 1) % origLineSize]);
@@ -411,10 +578,41 @@ static void buildPolyLineSegment(const Line& _line, PolyLineBuilder& _ctx, size_
 
 }
 
-void Builders::buildPolyLine(const Line& _line, PolyLineBuilder& _ctx) {
+void Builders::estimatePolyLine(LineView _line, const PolyLineBuilder& _ctx,
+                                size_t& _numVertices, size_t& _numIndices) {
+
+    size_t lineSize = _line.size() + (_ctx.closedPolygon ? 2 : 0);
+    if (lineSize < 2) {
+        _numVertices = _numIndices = 0;
+        return;
+    }
+
+    // Joins longer than the miter limit fall back to a bevel
+    size_t joinTriangles = std::max(size_t(_ctx.join), size_t(1));
+    size_t capCorners = size_t(_ctx.cap);
+
+    // Two corners per point, plus four corners and a fan for each join
+    size_t joinVertices = 4 + 2 + joinTriangles;
+    // Caps add their corners, round caps a center and a first vertex
+    size_t capVertices = capCorners == 0 ? 0 : capCorners == 2 ? 2 : capCorners + 2;
+
+    _numVertices = 4 + (lineSize - 2) * joinVertices + 2 * capVertices;
+    // One quad per segment, a fan of triangles per join and per cap
+    _numIndices = (lineSize - 1) * 6 + (lineSize - 2) * joinTriangles * 3 +
+        2 * std::max(capCorners, size_t(2)) * 3;
+}
+
+void Builders::buildPolyLine(LineView _line, PolyLineBuilder& _ctx) {
 
     size_t lineSize = _line.size();
 
+    if (!_ctx.segmentsOnly) {
+        size_t numVertices = 0, numIndices = 0;
+        estimatePolyLine(_line, _ctx, numVertices, numIndices);
+        _ctx.vertices.reserve(_ctx.vertices.size() + numVertices);
+        _ctx.indices.reserve(_ctx.indices.size() + numIndices);
+    }
+
     if (_ctx.keepTileEdges) {
 
         buildPolyLineSegment(_line, _ctx, 0, lineSize);
@@ -443,9 +641,9 @@ void Builders::buildPolyLine(const Line& _line, PolyLineBuilder& _ctx) {
                     if (!currOutside) {
                         buildPolyLineSegment(_line, _ctx, cut, i + 1, true, false);
                     }
-                    glm::vec2 a = coordCurr, b = coordNext;
-                    if (clipLine(a, b, {0, 0}, {1, 1})) {
-                        buildPolyLineSegment({ a, b }, _ctx, 0, 2,
+                    Point segment[2] = { coordCurr, coordNext };
+                    if (clipLine(segment[0], segment[1], {0, 0}, {1, 1})) {
+                        buildPolyLineSegment({ segment, segment + 2 }, _ctx, 0, 2,
                                              !currOutside && i == 0, !nextOutside && i+1 == lineSize-1);
                     }
                     cut = i + 1;
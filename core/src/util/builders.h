@@ -7,9 +7,22 @@
 #include <functional>
 #include <vector>
 
+// Coordinates of tile points for earcut
+namespace mapbox { namespace util {
+template <>
+struct nth<0, Tangram::Point> {
+    inline static float get(const Tangram::Point &t) { return t.x; };
+};
+template <>
+struct nth<1, Tangram::Point> {
+    inline static float get(const Tangram::Point &t) { return t.y; };
+};
+}}
 
 namespace Tangram {
 
+class TriangulationCache;
+
 enum class CapTypes {
     butt = 0, // No points added to end of line
     square = 2, // Two points added to make a square extension
@@ -26,53 +39,102 @@ enum class JoinTypes {
 
 JoinTypes JoinTypeFromString(const std::string& str);
 
-/* Callback function for PolygonBuilder:
+/* Output vertex of PolygonBuilder:
  *
  * @coord  tesselated output coordinate
  * @normal triangle plane normal
  * @uv     texture coordinate of the output coordinate
  */
-typedef std::function<void(const glm::vec3& coord, const glm::vec3& normal, const glm::vec2& uv)> PolygonVertexFn;
+struct PolygonBuilderVertex {
+    glm::vec3 coord;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
 
 /* PolygonBuilder context,
  * see Builders::buildPolygon() and Builders::buildPolygonExtrusion()
+ *
+ * Vertices are written to a plain vector which keeps its capacity between features;
+ * styles convert them to their vertex type in one loop after building.
  */
 struct PolygonBuilder {
     std::vector<uint16_t> indices; // indices for drawing the polyon as triangles are added to this vector
+    std::vector<PolygonBuilderVertex> vertices;
     std::vector<int> used;
 
-    PolygonVertexFn addVertex;
     size_t numVertices = 0;
     bool keepTileEdges;
     bool useTexCoords;
 
     mapbox::detail::Earcut<uint16_t> earcut;
 
-    PolygonBuilder(PolygonVertexFn _addVertex = [](auto&,auto&,auto&){},
-                   bool _kte = true, bool _useTexCoords = true)
-        : addVertex(_addVertex), keepTileEdges(_kte), useTexCoords(_useTexCoords){}
+    // Triangulations of large polygons kept across builds, may be null
+    TriangulationCache* triangulationCache = nullptr;
+
+    PolygonBuilder(bool _kte = true, bool _useTexCoords = true)
+        : keepTileEdges(_kte), useTexCoords(_useTexCoords){}
 
     void clear() {
         numVertices = 0;
         indices.clear();
+        vertices.clear();
     }
 };
 
 
-/* Callback function for PolyLineBuilder:
+/* Walls of extruded polygons collected over a tile, so that walls hidden by an adjacent wall of
+ * another polygon can be skipped; see Builders::addExtrusionWalls() and following
+ */
+struct ExtrusionWalls {
+    struct Wall {
+        glm::vec2 a, b;
+        float minHeight;
+        float maxHeight;
+        uint32_t polygon;   // index of the polygon, e.g. into per polygon style parameters
+        bool hidden = false;
+    };
+
+    std::vector<Wall> walls;
+
+    void clear() { walls.clear(); }
+};
+
+/* Output vertex of PolyLineBuilder:
  *
  * @coord   tesselated output coordinate
  * @enormal extrusion vector of the output coordinate
  * @uv      texture coordinate of the output coordinate
  */
-typedef std::function<void(const glm::vec2& coord, const glm::vec2& enormal, const glm::vec2& uv)> PolyLineVertexFn;
+struct PolyLineBuilderVertex {
+    glm::vec2 coord;
+    glm::vec2 enormal;
+    glm::vec2 uv;
+};
+
+/* Output segment of PolyLineBuilder, from @start to @end:
+ *
+ * @prev     point before the segment, @start at the beginning of a run of segments
+ * @next     point after the segment, @end at the end of a run of segments
+ * @startCap whether the line has a cap at @start
+ * @endCap   whether the line has a cap at @end
+ */
+struct PolyLineBuilderSegment {
+    glm::vec2 prev, start, end, next;
+    bool startCap = false;
+    bool endCap = false;
+};
 
 /* PolyLineBuilder context,
  * see Builders::buildPolyLine()
+ *
+ * Vertices are written to a plain vector like for PolygonBuilder. With @segmentsOnly the
+ * segments between distinct points are written instead, for lines which are extruded with
+ * their joins and caps by the vertex shader.
  */
 struct PolyLineBuilder {
     std::vector<uint16_t> indices; // indices for drawing the polyline as triangles are added to this vector
-    PolyLineVertexFn addVertex;
+    std::vector<PolyLineBuilderVertex> vertices;
+    std::vector<PolyLineBuilderSegment> segments;
     size_t numVertices = 0;
     float miterLimit = 3.f;
     CapTypes cap;
@@ -80,16 +142,18 @@ struct PolyLineBuilder {
     bool keepTileEdges;
     bool closedPolygon;
     bool useTexCoords = false;
+    bool segmentsOnly = false;
 
-    PolyLineBuilder(PolyLineVertexFn _addVertex = [](auto&,auto&,auto&){},
-                    CapTypes _cap = CapTypes::butt,
+    PolyLineBuilder(CapTypes _cap = CapTypes::butt,
                     JoinTypes _join = JoinTypes::bevel,
                     bool _kte = true, bool _closedPoly = false)
-        : addVertex(_addVertex), cap(_cap), join(_join), keepTileEdges(_kte), closedPolygon(_closedPoly) {}
+        : cap(_cap), join(_join), keepTileEdges(_kte), closedPolygon(_closedPoly) {}
 
     void clear() {
         numVertices = 0;
         indices.clear();
+        vertices.clear();
+        segments.clear();
     }
 };
 
@@ -117,22 +181,50 @@ public:
     /* Build a tesselated polygon
      * @_polygon input coordinates describing the polygon
      * @_ctx output vectors, see <PolygonBuilder>
+     * @_triangles indices into the points of @_polygon, e.g. Feature::polygonTriangles();
+     *   the polygon is triangulated when there are none
      */
-    static void buildPolygon(const Polygon& _polygon, float _height, PolygonBuilder& _ctx);
+    static void buildPolygon(PolygonView _polygon, float _height, PolygonBuilder& _ctx,
+                             Span<uint16_t> _triangles = {});
 
     /* Build extruded 'walls' from a polygon
      * @_polygon input coordinates describing the polygon
      * @_minHeight the extrusion will extend from this z coordinate to the z of the polygon points
      * @_ctx output vectors, see <PolygonBuilder>
      */
-    static void buildPolygonExtrusion(const Polygon& _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx);
+    static void buildPolygonExtrusion(PolygonView _polygon, float _minHeight, float _maxHeight, PolygonBuilder& _ctx);
+
+    /* Collect the walls that buildPolygonExtrusion() would build for @_polygon
+     * @_index identifies the polygon of the walls in @_walls
+     */
+    static void addExtrusionWalls(PolygonView _polygon, float _minHeight, float _maxHeight, uint32_t _index,
+                                  bool _keepTileEdges, ExtrusionWalls& _walls);
+
+    /* Hide walls which coincide with an opposite wall of another polygon that covers them, and
+     * raise the bottom of walls covered up to some height. Edges match when their end points are
+     * equal at vertex precision.
+     */
+    static void cullExtrusionWalls(ExtrusionWalls& _walls);
+
+    /* Build a wall collected by addExtrusionWalls()
+     * @_extend extend the last wall built into @_ctx instead, when it ends where @_wall starts
+     *  and both lie on one line; the texture coordinates of the last wall are stretched
+     * Returns true when a new wall was added
+     */
+    static bool buildExtrusionWall(const ExtrusionWalls::Wall& _wall, bool _extend, PolygonBuilder& _ctx);
 
     /* Build a tesselated polygon line of fixed width from line coordinates
      * @_line input coordinates describing the line
      * @_options parameters for polyline construction
      * @_ctx output vectors, see <PolyLineBuilder>
      */
-    static void buildPolyLine(const Line& _line, PolyLineBuilder& _ctx);
+    static void buildPolyLine(LineView _line, PolyLineBuilder& _ctx);
+
+    /* Upper bound of the vertices and indices which buildPolyLine() adds for @_line without
+     * cuts at tile edges; used to reserve the output vectors of @_ctx before building
+     */
+    static void estimatePolyLine(LineView _line, const PolyLineBuilder& _ctx,
+                                 size_t& _numVertices, size_t& _numIndices);
 
     /* Build a tesselated quad centered on _screenOrigin
      * @_screenOrigin the sprite origin in screen space
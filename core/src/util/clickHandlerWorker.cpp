@@ -2,7 +2,6 @@
 #include "util/touchHandler.h"
 
 #include <cmath>
-#include <thread>
 
 namespace Tangram {
 
@@ -90,6 +89,8 @@ void ClickHandlerWorker::pointer1Down(const ScreenPos& screenPos) {
     _pointer1Down = screenPos;
     _pointer1Moved = _pointer1Down;
     _pointer1MovedSum = 0;
+
+    _condition.notify_one();
 }
 
 void ClickHandlerWorker::pointer1Moved(const ScreenPos& screenPos) {
@@ -113,6 +114,8 @@ void ClickHandlerWorker::pointer1Moved(const ScreenPos& screenPos) {
             _canceled = true;
         }
     }
+
+    _condition.notify_one();
 }
 
 void ClickHandlerWorker::pointer1Up() {
@@ -134,6 +137,8 @@ void ClickHandlerWorker::pointer1Up() {
             _chosen = true;
         }
     }
+
+    _condition.notify_one();
 }
 
 void ClickHandlerWorker::pointer2Down(const ScreenPos& screenPos) {
@@ -154,6 +159,8 @@ void ClickHandlerWorker::pointer2Down(const ScreenPos& screenPos) {
         _chosen = true;
         _canceled = true;
     }
+
+    _condition.notify_one();
 }
 
 void ClickHandlerWorker::pointer2Moved(const ScreenPos& screenPos) {
@@ -172,6 +179,8 @@ void ClickHandlerWorker::pointer2Moved(const ScreenPos& screenPos) {
             _canceled = true;
         }
     }
+
+    _condition.notify_one();
 }
 
 void ClickHandlerWorker::pointer2Up() {
@@ -191,6 +200,8 @@ void ClickHandlerWorker::cancel() {
 
     _clickMode = NO_CLICK;
     _chosen = true;
+
+    _condition.notify_one();
 }
 
 void ClickHandlerWorker::operator()() {
@@ -200,21 +211,14 @@ void ClickHandlerWorker::operator()() {
 
 void ClickHandlerWorker::run() {
     while (true) {
+        ClickMode clickMode = NO_CLICK;
         {
             std::unique_lock<std::mutex> lock(_mutex);
-            if (_stop) {
-                return;
-            }
-            if (!_running) {
-                _condition.wait(lock);
-            }
-        }
-
-        ClickMode clickMode = NO_CLICK;
-        while (true) {
-            {
-                std::lock_guard<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _running || _stop; });
 
+            // Wait for the pointer methods to choose the click mode or for the timeout of the
+            // current mode; they notify when they change the mode
+            while (true) {
                 if (_stop) {
                     return;
                 }
@@ -223,36 +227,38 @@ void ClickHandlerWorker::run() {
                     break;
                 }
 
-                auto deltaTime = std::chrono::steady_clock::now() - _startTime;
                 auto longClickDuration = std::chrono::milliseconds(
                     static_cast<int>(_longClickDurationSeconds * 1000.0f));
                 auto doubleClickMaxDuration = std::chrono::milliseconds(
                     static_cast<int>(_doubleClickMaxDurationSeconds * 1000.0f));
 
+                std::chrono::steady_clock::time_point deadline;
                 switch (_clickMode) {
                 case NO_CLICK:
                     _chosen = true;
-                    break;
+                    continue;
                 case LONG_CLICK:
-                    if (_clickTypeDetection && deltaTime >= longClickDuration) {
-                        _chosen = true;
-                    }
+                    deadline = _startTime + longClickDuration;
                     break;
                 case DOUBLE_CLICK:
-                    if (_clickTypeDetection && deltaTime >= doubleClickMaxDuration) {
-                        _chosen = true;
-                        _canceled = true;
-                    }
+                    deadline = _startTime + doubleClickMaxDuration;
                     break;
                 case DUAL_CLICK:
-                    if (_clickTypeDetection && deltaTime >= DUAL_CLICK_END_DURATION) {
-                        _chosen = true;
+                    deadline = _startTime + DUAL_CLICK_END_DURATION;
+                    break;
+                }
+
+                if (!_clickTypeDetection) {
+                    _condition.wait(lock);
+                } else if (std::chrono::steady_clock::now() >= deadline) {
+                    _chosen = true;
+                    if (_clickMode != LONG_CLICK) {
                         _canceled = true;
                     }
-                    break;
+                } else {
+                    _condition.wait_until(lock, deadline);
                 }
             }
-            std::this_thread::yield();
         }
 
         switch (clickMode) {
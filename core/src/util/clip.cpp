@@ -0,0 +1,171 @@
+#include "util/clip.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+bool GeometryClipper::inside(LineView _points, float _min, float _max) const {
+    for (const auto& p : _points) {
+        if (p.x < _min || p.x > _max || p.y < _min || p.y > _max) { return false; }
+    }
+    return true;
+}
+
+bool GeometryClipper::outside(LineView _points, float _min, float _max) const {
+    glm::vec2 min(_points.front()), max(_points.front());
+    for (const auto& p : _points) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    return max.x < _min || min.x > _max || max.y < _min || min.y > _max;
+}
+
+LinesView GeometryClipper::clip(LineView _line, float _extraMargin) {
+
+    m_points.clear();
+    m_ends.clear();
+
+    float lo = -m_margin - _extraMargin;
+    float hi = 1.f + m_margin + _extraMargin;
+
+    if (!enabled() || _line.size() < 2 || inside(_line, lo, hi)) {
+        m_ends.push_back(uint32_t(_line.size()));
+        return { _line.data(), m_ends.data(), 1, 0 };
+    }
+    if (outside(_line, lo, hi)) { return {}; }
+
+    // End the current piece, dropping it when it is only a point
+    auto endPiece = [&]() {
+        uint32_t start = m_ends.empty() ? 0 : m_ends.back();
+        if (m_points.size() - start >= 2) {
+            m_ends.push_back(uint32_t(m_points.size()));
+        } else {
+            m_points.resize(start);
+        }
+    };
+
+    bool open = false;
+    for (size_t i = 0; i + 1 < _line.size(); i++) {
+        const Point& a = _line[i];
+        glm::vec2 d = _line[i + 1] - a;
+
+        // Liang-Barsky: range of the segment within each pair of edges
+        float t0 = 0.f, t1 = 1.f;
+        bool visible = true;
+        const float p[4] = { -d.x, d.x, -d.y, d.y };
+        const float q[4] = { a.x - lo, hi - a.x, a.y - lo, hi - a.y };
+        for (int edge = 0; edge < 4 && visible; edge++) {
+            if (p[edge] == 0.f) {
+                visible = q[edge] >= 0.f;
+            } else {
+                float t = q[edge] / p[edge];
+                if (p[edge] < 0.f) { t0 = std::max(t0, t); } else { t1 = std::min(t1, t); }
+                visible = t0 <= t1;
+            }
+        }
+
+        if (!visible) {
+            if (open) { endPiece(); }
+            open = false;
+            continue;
+        }
+
+        if (!open || t0 > 0.f) {
+            if (open) { endPiece(); }
+            m_points.push_back(a + d * t0);
+            open = true;
+        }
+        m_points.push_back(t1 < 1.f ? a + d * t1 : _line[i + 1]);
+
+        if (t1 < 1.f) {
+            endPiece();
+            open = false;
+        }
+    }
+    if (open) { endPiece(); }
+
+    return { m_points.data(), m_ends.data(), m_ends.size(), 0 };
+}
+
+size_t GeometryClipper::clipRing(LineView _ring, float _min, float _max) {
+
+    bool closed = _ring.size() > 1 && _ring.front() == _ring.back();
+    m_ring.assign(_ring.begin(), closed ? _ring.end() - 1 : _ring.end());
+
+    // Left, right, bottom and top edge
+    for (int edge = 0; edge < 4; edge++) {
+        int axis = edge / 2;
+        float bound = (edge % 2) ? _max : _min;
+        auto isInside = [&](const Point& _p) {
+            return (edge % 2) ? _p[axis] <= bound : _p[axis] >= bound;
+        };
+
+        m_clipped.clear();
+        size_t count = m_ring.size();
+        for (size_t i = 0; i < count; i++) {
+            const Point& prev = m_ring[(i + count - 1) % count];
+            const Point& curr = m_ring[i];
+            bool prevInside = isInside(prev);
+            bool currInside = isInside(curr);
+
+            if (prevInside != currInside) {
+                float t = (bound - prev[axis]) / (curr[axis] - prev[axis]);
+                Point intersection = prev + (curr - prev) * t;
+                intersection[axis] = bound;
+                m_clipped.push_back(intersection);
+            }
+            if (currInside) { m_clipped.push_back(curr); }
+        }
+        std::swap(m_ring, m_clipped);
+
+        if (m_ring.size() < 3) { return 0; }
+    }
+
+    m_points.insert(m_points.end(), m_ring.begin(), m_ring.end());
+    if (closed) { m_points.push_back(m_ring.front()); }
+    return m_ring.size() + (closed ? 1 : 0);
+}
+
+PolygonView GeometryClipper::clip(PolygonView _polygon) {
+
+    if (!enabled() || _polygon.empty()) { return _polygon; }
+
+    float lo = -m_margin;
+    float hi = 1.f + m_margin;
+
+    bool clipped = false;
+    for (auto ring : _polygon) {
+        if (!inside(ring, lo, hi)) {
+            clipped = true;
+            break;
+        }
+    }
+    if (!clipped) { return _polygon; }
+
+    m_points.clear();
+    m_ends.clear();
+
+    for (size_t i = 0; i < _polygon.size(); i++) {
+        auto ring = _polygon[i];
+        if (ring.empty()) { continue; }
+
+        size_t count = 0;
+        if (inside(ring, lo, hi)) {
+            m_points.insert(m_points.end(), ring.begin(), ring.end());
+            count = ring.size();
+        } else if (!outside(ring, lo, hi)) {
+            count = clipRing(ring, lo, hi);
+        }
+
+        if (count > 0) {
+            m_ends.push_back(uint32_t(m_points.size()));
+        } else if (i == 0) {
+            // Holes are not kept without their exterior
+            return {};
+        }
+    }
+
+    return { m_points.data(), m_ends.data(), m_ends.size(), 0 };
+}
+
+}
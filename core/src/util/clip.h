@@ -0,0 +1,51 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * GeometryClipper - Clips lines and polygon rings to the bounds of a tile, extended by a margin,
+ * so that geometry in the buffer of a tile is not built and drawn by both neighboring tiles
+ *
+ * Results are written to buffers owned by the clipper and returned as views, which stay valid
+ * until the next call; the input view is returned when it lies within the bounds. Lines are
+ * split into the pieces within the bounds. Rings are clipped one by one (Sutherland-Hodgman)
+ * and keep their winding and closing point; a polygon whose exterior is clipped away is empty.
+ */
+class GeometryClipper {
+
+public:
+
+    /* Margin beyond the tile edges in tile units; negative returns all geometry as it is */
+    void setMargin(float _margin) { m_margin = _margin; }
+    float margin() const { return m_margin; }
+
+    bool enabled() const { return m_margin >= 0.f; }
+
+    /* Pieces of @_line within the bounds extended by @_extraMargin, e.g. by the width of a line */
+    LinesView clip(LineView _line, float _extraMargin = 0.f);
+
+    PolygonView clip(PolygonView _polygon);
+
+private:
+
+    // Whether all of @_points are within the bounds, or all are outside one edge of them
+    bool inside(LineView _points, float _min, float _max) const;
+    bool outside(LineView _points, float _min, float _max) const;
+
+    // Append @_ring clipped to @_min and @_max to m_points, returns the count of points added
+    size_t clipRing(LineView _ring, float _min, float _max);
+
+    float m_margin = -1.f;
+
+    std::vector<Point> m_points;
+    std::vector<uint32_t> m_ends;
+
+    std::vector<Point> m_ring;
+    std::vector<Point> m_clipped;
+};
+
+}
@@ -0,0 +1,169 @@
+#include "util/contourLines.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_CONTOUR_NEON
+#endif
+
+namespace Tangram {
+
+// floor(v * invStep) for all values; INT_MIN for NaN and values out of int range
+static void elevationBands(const float* _grid, size_t _count, float _invStep, int32_t* _bands) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 inv = _mm_set1_ps(_invStep);
+    for (; i + 4 <= _count; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(_grid + i), inv);
+        __m128i b = _mm_cvttps_epi32(v);
+        // floor: subtract 1 (add the -1 mask) where truncation rounded up
+        __m128i up = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(b), v));
+        _mm_storeu_si128((__m128i*)(_bands + i), _mm_add_epi32(b, up));
+    }
+#elif defined(TANGRAM_CONTOUR_NEON)
+    float32x4_t inv = vdupq_n_f32(_invStep);
+    for (; i + 4 <= _count; i += 4) {
+        vst1q_s32(_bands + i, vcvtmq_s32_f32(vmulq_f32(vld1q_f32(_grid + i), inv)));
+    }
+#endif
+    for (; i < _count; i++) {
+        float v = _grid[i] * _invStep;
+        _bands[i] = (v >= -2147483648.f && v < 2147483648.f) ? int32_t(std::floor(v)) : INT_MIN;
+    }
+}
+
+std::vector<ContourLine> extractContourLines(const float* _grid, int _width, int _height,
+                                             float _step, float _minLevel) {
+
+    std::vector<ContourLine> lines;
+    if (_width < 2 || _height < 2 || !(_step > 0)) { return lines; }
+
+    const int w = _width, h = _height;
+    std::vector<int32_t> bands(size_t(w) * h);
+    elevationBands(_grid, bands.size(), 1.f / _step, bands.data());
+
+    const int32_t minBand = int32_t(std::ceil(_minLevel / _step));
+
+    // Edges between pixel centers: horizontal from (x, y) to (x+1, y), vertical from (x, y) to (x, y+1)
+    auto hEdge = [&](int x, int y) { return uint32_t(y * w + x) * 2; };
+    auto vEdge = [&](int x, int y) { return uint32_t(y * w + x) * 2 + 1; };
+
+    struct Segment { int32_t band; uint32_t edges[2]; };
+    std::vector<Segment> segments;
+
+    for (int y = 0; y < h - 1; y++) {
+        const int32_t* row0 = &bands[size_t(y) * w];
+        const int32_t* row1 = row0 + w;
+        for (int x = 0; x < w - 1; x++) {
+            // Corners clockwise from top left
+            int32_t b[4] = { row0[x], row0[x + 1], row1[x + 1], row1[x] };
+            int32_t lo = std::min(std::min(b[0], b[1]), std::min(b[2], b[3]));
+            int32_t hi = std::max(std::max(b[0], b[1]), std::max(b[2], b[3]));
+            if (lo == hi || hi < minBand) { continue; }
+
+            // Top, right, bottom, left
+            uint32_t e[4] = { hEdge(x, y), vEdge(x + 1, y), hEdge(x, y + 1), vEdge(x, y) };
+
+            for (int32_t k = std::max(lo + 1, minBand); k <= hi; k++) {
+                int c = (b[0] >= k) | (b[1] >= k) << 1 | (b[2] >= k) << 2 | (b[3] >= k) << 3;
+
+                if (c == 5 || c == 10) {
+                    // Saddle: decide from the mean of the corners whether the high corners connect
+                    const float* g0 = _grid + size_t(y) * w + x;
+                    float center = 0.25f * (g0[0] + g0[1] + g0[w] + g0[w + 1]);
+                    bool highCenter = center >= k * _step;
+                    if ((c == 5) == highCenter) {
+                        segments.push_back({ k, { e[0], e[1] } });
+                        segments.push_back({ k, { e[2], e[3] } });
+                    } else {
+                        segments.push_back({ k, { e[3], e[0] } });
+                        segments.push_back({ k, { e[1], e[2] } });
+                    }
+                    continue;
+                }
+
+                // The two edges whose corners are on different sides of the level
+                bool crossed[4] = { bool((c ^ (c >> 1)) & 1), bool(((c >> 1) ^ (c >> 2)) & 1),
+                                    bool(((c >> 2) ^ (c >> 3)) & 1), bool((c ^ (c >> 3)) & 1) };
+                Segment segment{ k, { 0, 0 } };
+                int n = 0;
+                for (int i = 0; i < 4; i++) {
+                    if (crossed[i]) { segment.edges[n++] = e[i]; }
+                }
+                segments.push_back(segment);
+            }
+        }
+    }
+
+    // Each edge of a level is shared by at most two segments
+    auto key = [](int32_t _band, uint32_t _edge) { return uint64_t(uint32_t(_band)) << 32 | _edge; };
+    std::unordered_map<uint64_t, std::array<int32_t, 2>> edgeSegments;
+    edgeSegments.reserve(segments.size() * 2);
+    for (size_t i = 0; i < segments.size(); i++) {
+        for (uint32_t edge : segments[i].edges) {
+            auto it = edgeSegments.emplace(key(segments[i].band, edge), std::array<int32_t, 2>{{ -1, -1 }}).first;
+            it->second[it->second[0] < 0 ? 0 : 1] = int32_t(i);
+        }
+    }
+
+    auto edgePoint = [&](uint32_t _edge, float _level) {
+        uint32_t idx = _edge >> 1;
+        int x = int(idx % w), y = int(idx / w);
+        float v0 = _grid[idx];
+        float v1 = (_edge & 1) ? _grid[idx + w] : _grid[idx + 1];
+        float t = (_level - v0) / (v1 - v0);
+        t = (t >= 0.f) ? std::min(t, 1.f) : 0.f;
+        glm::vec2 p = (_edge & 1) ? glm::vec2(x, y + t) : glm::vec2(x + t, y);
+        return Point((p.x + 0.5f) / w, (p.y + 0.5f) / h);
+    };
+
+    std::vector<uint8_t> used(segments.size(), 0);
+    std::vector<uint32_t> chain;
+
+    // Append the edges of connected unused segments to the chain
+    auto extend = [&](int32_t _band) {
+        while (true) {
+            auto& ends = edgeSegments[key(_band, chain.back())];
+            int32_t next = -1;
+            for (int32_t s : ends) {
+                if (s >= 0 && !used[s]) { next = s; }
+            }
+            if (next < 0) { return false; }
+            used[next] = 1;
+            auto& edges = segments[next].edges;
+            chain.push_back(edges[0] == chain.back() ? edges[1] : edges[0]);
+            if (chain.back() == chain.front()) { return true; }
+        }
+    };
+
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (used[i]) { continue; }
+        used[i] = 1;
+        int32_t band = segments[i].band;
+
+        chain.assign(segments[i].edges, segments[i].edges + 2);
+        if (!extend(band)) {
+            std::reverse(chain.begin(), chain.end());
+            extend(band);
+        }
+
+        lines.emplace_back();
+        auto& line = lines.back();
+        line.level = band * _step;
+        line.points.reserve(chain.size());
+        for (uint32_t edge : chain) { line.points.push_back(edgePoint(edge, line.level)); }
+    }
+
+    std::stable_sort(lines.begin(), lines.end(),
+                     [](const ContourLine& a, const ContourLine& b) { return a.level < b.level; });
+    return lines;
+}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include <vector>
+
+namespace Tangram {
+
+struct ContourLine {
+    float level = 0;
+    // closed lines end with their first point
+    std::vector<Point> points;
+};
+
+/*
+ * Contour lines at the multiples of @_step from @_minLevel up in an elevation grid of
+ * @_width x @_height, traced with marching squares between the pixel centers.
+ *
+ * Points are in tile coordinates, with the center of pixel (x, y) at ((x + 0.5)/width,
+ * (y + 0.5)/height), as sampled by ElevationManager::elevationLerp(). Lines are ordered by
+ * level. The elevation band of each pixel is computed four at a time with SSE2 or NEON, so
+ * that only the cells crossed by a contour are visited.
+ */
+std::vector<ContourLine> extractContourLines(const float* _grid, int _width, int _height,
+                                             float _step, float _minLevel);
+
+}
@@ -0,0 +1,61 @@
+#include "util/dashAtlas.h"
+
+#include "gl/texture.h"
+#include "util/dashArray.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+DashAtlas::Row DashAtlas::add(const std::vector<float>& _pattern) {
+    auto pixels = DashArray::render(_pattern, m_dashScale);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Row row;
+    row.length = uint32_t(pixels.size());
+
+    auto it = std::find(m_patterns.begin(), m_patterns.end(), pixels);
+    row.index = uint32_t(it - m_patterns.begin());
+
+    if (it == m_patterns.end()) {
+        m_width = std::max(m_width, row.length);
+        m_patterns.push_back(std::move(pixels));
+        m_dirty = true;
+    }
+    return row;
+}
+
+std::shared_ptr<Texture> DashAtlas::texture() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_dirty) { return m_texture; }
+    m_dirty = false;
+
+    std::vector<unsigned int> pixels(m_width * m_patterns.size(), 0);
+    for (size_t i = 0; i < m_patterns.size(); i++) {
+        std::copy(m_patterns[i].begin(), m_patterns[i].end(), pixels.begin() + i * m_width);
+    }
+
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::NEAREST;
+    options.magFilter = TextureMagFilter::NEAREST;
+
+    m_texture = std::make_shared<Texture>(options);
+    m_texture->setPixelData(m_width, m_patterns.size(), sizeof(GLuint),
+                            reinterpret_cast<GLubyte*>(pixels.data()),
+                            pixels.size() * sizeof(GLuint));
+    return m_texture;
+}
+
+uint32_t DashAtlas::width() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_width;
+}
+
+uint32_t DashAtlas::rows() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return uint32_t(m_patterns.size());
+}
+
+}
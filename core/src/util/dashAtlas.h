@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+class Texture;
+
+/*
+ * DashAtlas - Dash patterns of the line styles of a scene, rendered by DashArray into the rows
+ * of one texture
+ *
+ * Styles with the same pattern share a row. Rows are as wide as the longest pattern, shorter
+ * patterns are addressed by their own length, see PolylineStyle. The texture is created on its
+ * first use after patterns were added.
+ */
+class DashAtlas {
+
+public:
+
+    struct Row {
+        uint32_t index = 0;
+        uint32_t length = 0;    // in pixels
+    };
+
+    // Pixels per line width; provides precision for dash patterns that are a fraction of line width
+    explicit DashAtlas(float _dashScale = 20.f) : m_dashScale(_dashScale) {}
+
+    /* Add @_pattern of dash and gap lengths in line widths, unless it was added already */
+    Row add(const std::vector<float>& _pattern);
+
+    std::shared_ptr<Texture> texture();
+
+    float dashScale() const { return m_dashScale; }
+    uint32_t width() const;
+    uint32_t rows() const;
+
+private:
+
+    const float m_dashScale;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::vector<unsigned int>> m_patterns;
+    uint32_t m_width = 0;
+
+    std::shared_ptr<Texture> m_texture;
+    bool m_dirty = false;
+};
+
+}
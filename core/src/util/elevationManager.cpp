@@ -2,9 +2,12 @@
 
 #include "scene/scene.h"
 #include "util/asyncWorker.h"
+#include "util/halfFloat.h"
 #include "data/rasterSource.h"
 #include "style/rasterStyle.h"
 #include "gl/framebuffer.h"
+#include "gl/hardware.h"
+#include "gl/pixelReadback.h"
 #include "gl/renderState.h"
 #include "gl/shaderProgram.h"
 #include "gl/primitives.h"
@@ -14,6 +17,18 @@
 
 #include "../../platforms/common/platform_gl.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_ELEVATION_NEON
+#endif
+
 // with depth test enabled and no blending, final value of output should be correct depth (if larger depth
 //  written first, will be overwritten; if smaller depth written first, depth test will discard larger depth)
 const static char* terrain_depth_fs = R"RAW_GLSL(#version 300 es
@@ -44,6 +59,7 @@ public:
 
   void build(const Scene& _scene) override {
       RasterStyle::build(_scene);
+      buildProgram();
       m_shaderProgram = std::make_shared<ShaderProgram>(
           m_shaderProgram->vertexShaderSource(), terrain_depth_fs, vertexLayout().get());
   }
@@ -58,7 +74,7 @@ public:
       setupTileShaderUniforms(rs, _tile, *m_shaderProgram, m_mainUniforms);
       m_shaderProgram->setUniformf(rs, m_uOrder, 0.f);
 
-      bool styleMeshDrawn = rasterMesh()->draw(rs, *m_shaderProgram);
+      bool styleMeshDrawn = terrainMesh(rs, _tile)->draw(rs, *m_shaderProgram);
       if (!styleMeshDrawn) {
           LOGN("Mesh built by style %s cannot be drawn", m_name.c_str());
       }
@@ -68,18 +84,109 @@ public:
   }
 };
 
-static double readElevTex(const Texture& tex, int x, int y)
+struct ElevationData {
+  // decoded elevation; empty for FLOAT and HALF_FLOAT textures, which are used directly
+  std::vector<float> elevation;
+  float min = FLT_MAX, max = -FLT_MAX;
+  // contour lines by elevation step, see contourLines(); tiles are built on several worker threads
+  std::mutex contourMutex;
+  std::vector<std::pair<float, std::shared_ptr<const std::vector<ContourLine>>>> contours;
+};
+
+void ElevationManager::decodeElevation(Texture& tex)
+{
+  auto data = std::make_shared<ElevationData>();
+  size_t npix = tex.width()*tex.height();
+  if(tex.getOptions().pixelFormat == PixelFormat::FLOAT) {
+    float* texbuff = (float*)tex.bufferData();
+    for(size_t ii = 0; ii < npix; ++ii) {
+      data->min = std::min(texbuff[ii], data->min);
+      data->max = std::max(texbuff[ii], data->max);
+    }
+  }
+  else if(tex.getOptions().pixelFormat == PixelFormat::HALF_FLOAT && tex.bufferData()) {
+    const uint16_t* texbuff = (const uint16_t*)tex.bufferData();
+    for(size_t ii = 0; ii < npix; ++ii) {
+      float elev = halfToFloat(texbuff[ii]);
+      data->min = std::min(elev, data->min);
+      data->max = std::max(elev, data->max);
+    }
+  }
+  else if(tex.bufferData() && tex.compressedFormat() == 0 && tex.getOptions().bytesPerPixel() == 4) {
+    // see getElevation() in hillshade.yaml and https://github.com/tilezen/joerd
+    // (red * 256 + green + blue / 256) - 32768 is exact in float: 16 integer bits + 8 fraction bits
+    uint8_t* texbuff = tex.bufferData();
+    data->elevation.resize(npix);
+    for(size_t ii = 0; ii < npix; ++ii) {
+      uint8_t* p = &texbuff[ii*4];
+      float elev = (p[0]*256 + p[1] + p[2]/256.0f) - 32768;
+      data->elevation[ii] = elev;
+      data->min = std::min(elev, data->min);
+      data->max = std::max(elev, data->max);
+    }
+    // only the decoded grid is sampled on the CPU, so the encoded pixels can be released after upload
+    tex.setDisposeBuffer(true);
+  }
+  tex.userData = data;
+}
+
+// decoded elevation grid of tex, or null if not available
+static const float* decodedGrid(const Texture& tex)
 {
-  // see getElevation() in hillshade.yaml and https://github.com/tilezen/joerd
   if(tex.getOptions().pixelFormat == PixelFormat::FLOAT)
-    return ((float*)tex.bufferData())[y*tex.width() + x];
+    return (const float*)tex.bufferData();
+  auto* data = static_cast<ElevationData*>(tex.userData.get());
+  return data && !data->elevation.empty() ? data->elevation.data() : nullptr;
+}
+
+// half float elevation of tex, or null if not HALF_FLOAT
+static const uint16_t* halfElevationGrid(const Texture& tex)
+{
+  if(tex.getOptions().pixelFormat == PixelFormat::HALF_FLOAT)
+    return (const uint16_t*)tex.bufferData();
+  return nullptr;
+}
+
+const float* ElevationManager::elevationGrid(const Texture& tex, std::vector<float>& buffer)
+{
+  if(const float* grid = decodedGrid(tex)) { return grid; }
+  const uint16_t* half = halfElevationGrid(tex);
+  if(!half) { return nullptr; }
+  buffer.resize(size_t(tex.width())*tex.height());
+  halfsToFloats(half, buffer.data(), buffer.size());
+  return buffer.data();
+}
+
+std::shared_ptr<const std::vector<ContourLine>> ElevationManager::contourLines(const Texture& tex, float elevStep)
+{
+  auto* data = static_cast<ElevationData*>(tex.userData.get());
+  if(!data || (!decodedGrid(tex) && !halfElevationGrid(tex))) { return nullptr; }
+
+  std::lock_guard<std::mutex> lock(data->contourMutex);
+  for(auto& contours : data->contours) {
+    if(contours.first == elevStep) { return contours.second; }
+  }
+  std::vector<float> buffer;
+  const float* grid = elevationGrid(tex, buffer);
+  auto lines = std::make_shared<const std::vector<ContourLine>>(
+      extractContourLines(grid, tex.width(), tex.height(), elevStep, elevStep));
+  data->contours.emplace_back(elevStep, lines);
+  return lines;
+}
+
+static double readElevTex(const Texture& tex, const float* grid, int x, int y)
+{
+  if(grid)
+    return grid[y*tex.width() + x];
+  if(tex.getOptions().pixelFormat == PixelFormat::HALF_FLOAT)
+    return halfToFloat(((const uint16_t*)tex.bufferData())[y*tex.width() + x]);
   GLubyte* p = tex.bufferData() + y*tex.width()*4 + x*4;
-  //(red * 256 + green + blue / 256) - 32768
   return (p[0]*256 + p[1] + p[2]/256.0) - 32768;
 }
 
 double ElevationManager::elevationLerp(const Texture& tex, glm::vec2 pos, glm::vec2* gradOut)
 {
+  const float* grid = decodedGrid(tex);
   double x0 = pos.x*tex.width() - 0.5, y0 = pos.y*tex.height() - 0.5;  // -0.5 to adjust for pixel centers
   // we should extrapolate at edges instead of clamping - see shader in raster_contour.yaml
   int ix0 = std::max(0, int(std::floor(x0)));
@@ -87,10 +194,10 @@ double ElevationManager::elevationLerp(const Texture& tex, glm::vec2 pos, glm::v
   int ix1 = std::min(int(std::ceil(x0)), tex.width()-1);
   int iy1 = std::min(int(std::ceil(y0)), tex.height()-1);
   double fx = x0 - ix0, fy = y0 - iy0;
-  double t00 = readElevTex(tex, ix0, iy0);
-  double t01 = readElevTex(tex, ix0, iy1);
-  double t10 = readElevTex(tex, ix1, iy0);
-  double t11 = readElevTex(tex, ix1, iy1);
+  double t00 = readElevTex(tex, grid, ix0, iy0);
+  double t01 = readElevTex(tex, grid, ix0, iy1);
+  double t10 = readElevTex(tex, grid, ix1, iy0);
+  double t11 = readElevTex(tex, grid, ix1, iy1);
 
   if(gradOut) {
     double dx0 = t10 - t00, dx1 = t11 - t01;
@@ -104,6 +211,115 @@ double ElevationManager::elevationLerp(const Texture& tex, glm::vec2 pos, glm::v
   return t0 + fy*(t1 - t0);
 }
 
+void ElevationManager::elevationLerp(const Texture& tex, const glm::vec2* pos, size_t count, float* out)
+{
+  const float* grid = decodedGrid(tex);
+  const uint16_t* half = halfElevationGrid(tex);
+  if(!grid && !half) {
+    for(size_t ii = 0; ii < count; ++ii) { out[ii] = elevationLerp(tex, pos[ii]); }
+    return;
+  }
+
+  // same sampling as above, except that floor + 1 replaces ceil (equal where the weight is not 0)
+  const int w = tex.width(), h = tex.height();
+  alignas(16) int32_t idx[4][4];  // row major corners: 00, 10, 01, 11
+  alignas(16) float fx[4], fy[4], t[4][4], res[4];
+
+  for(size_t ii = 0; ii < count; ii += 4) {
+    size_t n = std::min(count - ii, size_t(4));
+    const glm::vec2* p = pos + ii;
+    // repeat the last position to fill the block
+    glm::vec2 q[4] = {p[0], p[std::min<size_t>(1, n-1)], p[std::min<size_t>(2, n-1)], p[n-1]};
+
+#if defined(__SSE2__)
+    __m128 x0 = _mm_sub_ps(_mm_mul_ps(_mm_setr_ps(q[0].x, q[1].x, q[2].x, q[3].x), _mm_set1_ps(float(w))),
+                           _mm_set1_ps(0.5f));
+    __m128 y0 = _mm_sub_ps(_mm_mul_ps(_mm_setr_ps(q[0].y, q[1].y, q[2].y, q[3].y), _mm_set1_ps(float(h))),
+                           _mm_set1_ps(0.5f));
+    // floor: truncate, then subtract 1 where truncation rounded up
+    __m128 tx = _mm_cvtepi32_ps(_mm_cvttps_epi32(x0));
+    __m128 ty = _mm_cvtepi32_ps(_mm_cvttps_epi32(y0));
+    tx = _mm_sub_ps(tx, _mm_and_ps(_mm_cmpgt_ps(tx, x0), _mm_set1_ps(1.0f)));
+    ty = _mm_sub_ps(ty, _mm_and_ps(_mm_cmpgt_ps(ty, y0), _mm_set1_ps(1.0f)));
+    __m128 maxx = _mm_set1_ps(float(w-1)), maxy = _mm_set1_ps(float(h-1)), one = _mm_set1_ps(1.0f);
+    __m128 ix0 = _mm_min_ps(_mm_max_ps(tx, _mm_setzero_ps()), maxx);
+    __m128 iy0 = _mm_min_ps(_mm_max_ps(ty, _mm_setzero_ps()), maxy);
+    __m128 ix1 = _mm_min_ps(_mm_max_ps(_mm_add_ps(tx, one), _mm_setzero_ps()), maxx);
+    __m128 iy1 = _mm_min_ps(_mm_max_ps(_mm_add_ps(ty, one), _mm_setzero_ps()), maxy);
+    _mm_store_ps(fx, _mm_sub_ps(x0, ix0));
+    _mm_store_ps(fy, _mm_sub_ps(y0, iy0));
+    // indices are exact in float for any texture size we load
+    __m128 row0 = _mm_mul_ps(iy0, _mm_set1_ps(float(w))), row1 = _mm_mul_ps(iy1, _mm_set1_ps(float(w)));
+    _mm_store_si128((__m128i*)idx[0], _mm_cvttps_epi32(_mm_add_ps(row0, ix0)));
+    _mm_store_si128((__m128i*)idx[1], _mm_cvttps_epi32(_mm_add_ps(row0, ix1)));
+    _mm_store_si128((__m128i*)idx[2], _mm_cvttps_epi32(_mm_add_ps(row1, ix0)));
+    _mm_store_si128((__m128i*)idx[3], _mm_cvttps_epi32(_mm_add_ps(row1, ix1)));
+#elif defined(TANGRAM_ELEVATION_NEON)
+    float32x4_t x0 = vsubq_f32(vmulq_n_f32((float32x4_t){q[0].x, q[1].x, q[2].x, q[3].x}, float(w)),
+                               vdupq_n_f32(0.5f));
+    float32x4_t y0 = vsubq_f32(vmulq_n_f32((float32x4_t){q[0].y, q[1].y, q[2].y, q[3].y}, float(h)),
+                               vdupq_n_f32(0.5f));
+    float32x4_t tx = vrndmq_f32(x0), ty = vrndmq_f32(y0);
+    float32x4_t maxx = vdupq_n_f32(float(w-1)), maxy = vdupq_n_f32(float(h-1)), one = vdupq_n_f32(1.0f);
+    float32x4_t ix0 = vminq_f32(vmaxq_f32(tx, vdupq_n_f32(0)), maxx);
+    float32x4_t iy0 = vminq_f32(vmaxq_f32(ty, vdupq_n_f32(0)), maxy);
+    float32x4_t ix1 = vminq_f32(vmaxq_f32(vaddq_f32(tx, one), vdupq_n_f32(0)), maxx);
+    float32x4_t iy1 = vminq_f32(vmaxq_f32(vaddq_f32(ty, one), vdupq_n_f32(0)), maxy);
+    vst1q_f32(fx, vsubq_f32(x0, ix0));
+    vst1q_f32(fy, vsubq_f32(y0, iy0));
+    float32x4_t row0 = vmulq_n_f32(iy0, float(w)), row1 = vmulq_n_f32(iy1, float(w));
+    vst1q_s32(idx[0], vcvtq_s32_f32(vaddq_f32(row0, ix0)));
+    vst1q_s32(idx[1], vcvtq_s32_f32(vaddq_f32(row0, ix1)));
+    vst1q_s32(idx[2], vcvtq_s32_f32(vaddq_f32(row1, ix0)));
+    vst1q_s32(idx[3], vcvtq_s32_f32(vaddq_f32(row1, ix1)));
+#else
+    for(int jj = 0; jj < 4; ++jj) {
+      float x0 = q[jj].x*w - 0.5f, y0 = q[jj].y*h - 0.5f;
+      int tx = int(std::floor(x0)), ty = int(std::floor(y0));
+      int ix0 = std::min(std::max(tx, 0), w-1), iy0 = std::min(std::max(ty, 0), h-1);
+      int ix1 = std::min(std::max(tx+1, 0), w-1), iy1 = std::min(std::max(ty+1, 0), h-1);
+      fx[jj] = x0 - ix0;
+      fy[jj] = y0 - iy0;
+      idx[0][jj] = iy0*w + ix0;
+      idx[1][jj] = iy0*w + ix1;
+      idx[2][jj] = iy1*w + ix0;
+      idx[3][jj] = iy1*w + ix1;
+    }
+#endif
+
+    if(grid) {
+      for(int cc = 0; cc < 4; ++cc) {
+        for(int jj = 0; jj < 4; ++jj) { t[cc][jj] = grid[idx[cc][jj]]; }
+      }
+    } else {
+      for(int cc = 0; cc < 4; ++cc) {
+        for(int jj = 0; jj < 4; ++jj) { t[cc][jj] = halfToFloat(half[idx[cc][jj]]); }
+      }
+    }
+
+#if defined(__SSE2__)
+    __m128 wx = _mm_load_ps(fx), wy = _mm_load_ps(fy);
+    __m128 t00 = _mm_load_ps(t[0]), t10 = _mm_load_ps(t[1]), t01 = _mm_load_ps(t[2]), t11 = _mm_load_ps(t[3]);
+    __m128 t0 = _mm_add_ps(t00, _mm_mul_ps(wx, _mm_sub_ps(t10, t00)));
+    __m128 t1 = _mm_add_ps(t01, _mm_mul_ps(wx, _mm_sub_ps(t11, t01)));
+    _mm_store_ps(res, _mm_add_ps(t0, _mm_mul_ps(wy, _mm_sub_ps(t1, t0))));
+#elif defined(TANGRAM_ELEVATION_NEON)
+    float32x4_t wx = vld1q_f32(fx), wy = vld1q_f32(fy);
+    float32x4_t t00 = vld1q_f32(t[0]), t10 = vld1q_f32(t[1]), t01 = vld1q_f32(t[2]), t11 = vld1q_f32(t[3]);
+    float32x4_t t0 = vmlaq_f32(t00, wx, vsubq_f32(t10, t00));
+    float32x4_t t1 = vmlaq_f32(t01, wx, vsubq_f32(t11, t01));
+    vst1q_f32(res, vmlaq_f32(t0, wy, vsubq_f32(t1, t0)));
+#else
+    for(int jj = 0; jj < 4; ++jj) {
+      float t0 = t[0][jj] + fx[jj]*(t[1][jj] - t[0][jj]);
+      float t1 = t[2][jj] + fx[jj]*(t[3][jj] - t[2][jj]);
+      res[jj] = t0 + fy[jj]*(t1 - t0);
+    }
+#endif
+    std::copy(res, res + n, out + ii);
+  }
+}
+
 double ElevationManager::elevationLerp(const Texture& tex, TileID tileId, ProjectedMeters meters)
 {
   double scale = MapProjection::metersPerTileAtZoom(tileId.z);
@@ -142,6 +358,82 @@ double ElevationManager::getElevation(ProjectedMeters pos, bool& ok)
   return 0;
 }
 
+ElevationManager::ElevationBatch ElevationManager::prepareElevations(std::vector<ProjectedMeters> positions,
+                                                                    int zoom)
+{
+  ElevationBatch batch;
+  batch.positions = std::move(positions);
+  if(batch.positions.empty()) { return batch; }
+
+  int maxZoom = m_elevationSource->zoomOptions().maxZoom;
+  // highest zoom of loaded textures by default, as for getElevation()
+  if(zoom < 0) { zoom = m_elevationSource->maxCachedZoom(); }
+  zoom = std::max(0, std::min(zoom, maxZoom));
+
+  // tracks and marker sets are mostly spatially coherent, so check the previous tile first
+  std::map<TileID, uint32_t> groupIds;
+  TileID prevTileId = NOT_A_TILE;
+  uint32_t prevGroup = 0;
+  for(uint32_t ii = 0; ii < batch.positions.size(); ++ii) {
+    TileID tileId = MapProjection::projectedMetersTile(batch.positions[ii], zoom);
+    if(tileId != prevTileId) {
+      auto it = groupIds.emplace(tileId, uint32_t(batch.groups.size())).first;
+      if(it->second == batch.groups.size()) {
+        batch.groups.emplace_back();
+        batch.groups.back().tileId = tileId;
+      }
+      prevTileId = tileId;
+      prevGroup = it->second;
+    }
+    batch.groups[prevGroup].indices.push_back(ii);
+  }
+
+  // textures are looked up once per group
+  for(auto& group : batch.groups) {
+    TileID tileId = group.tileId;
+    while(!(group.texture = m_elevationSource->getTexture(tileId)) && tileId.z > 0) {
+      tileId = tileId.getParent();
+    }
+    group.tileId = group.texture ? tileId : NOT_A_TILE;
+  }
+  return batch;
+}
+
+void ElevationManager::ElevationBatch::sample(double* out, uint8_t* ok) const
+{
+  std::vector<glm::vec2> tilePos;
+  std::vector<float> elev;
+  for(auto& group : groups) {
+    if(!group.texture) {
+      for(uint32_t idx : group.indices) {
+        out[idx] = 0;
+        if(ok) { ok[idx] = 0; }
+      }
+      continue;
+    }
+
+    double scale = MapProjection::metersPerTileAtZoom(group.tileId.z);
+    ProjectedMeters tileOrigin = MapProjection::tileSouthWestCorner(group.tileId);
+    tilePos.resize(group.indices.size());
+    for(size_t ii = 0; ii < group.indices.size(); ++ii) {
+      ProjectedMeters offset = (positions[group.indices[ii]] - tileOrigin)/scale;
+      tilePos[ii] = glm::clamp(glm::vec2(offset), glm::vec2(0.f), glm::vec2(1.f));
+    }
+    elev.resize(tilePos.size());
+    elevationLerp(*group.texture, tilePos.data(), tilePos.size(), elev.data());
+    for(size_t ii = 0; ii < group.indices.size(); ++ii) {
+      out[group.indices[ii]] = elev[ii];
+      if(ok) { ok[group.indices[ii]] = 1; }
+    }
+  }
+}
+
+void ElevationManager::getElevations(const ProjectedMeters* pos, size_t count, double* out, uint8_t* ok,
+                                     int zoom)
+{
+  prepareElevations(std::vector<ProjectedMeters>(pos, pos + count), zoom).sample(out, ok);
+}
+
 bool ElevationManager::hasTile(TileID tileId)
 {
   bool ok = false;
@@ -151,41 +443,11 @@ bool ElevationManager::hasTile(TileID tileId)
 
 glm::vec2 ElevationManager::getMinMaxElev(TileID tileId, int ancestors)
 {
-  struct ElevTexInfo {
-    float min, max;
-  };
-
-  while(tileId.z > m_elevationSource->zoomOptions().maxZoom) { tileId = tileId.getParent(); }
-  auto tex = m_elevationSource->getTexture(tileId);
-  while(!tex && (tileId.z > 14 || (ancestors-- > 0 && tileId.z > 1))) {
-    tileId = tileId.getParent();
-    tex = m_elevationSource->getTexture(tileId);
-  }
-  if(!tex) { return {0, 9000}; }
-
-  if(!tex->userData) {
-    ElevTexInfo info = {FLT_MAX, -FLT_MAX};
-    size_t npix = tex->width()*tex->height();
-    if(tex->getOptions().pixelFormat == PixelFormat::FLOAT) {
-      float* texbuff = (float*)tex->bufferData();
-      for(size_t ii = 0; ii < npix; ++ii) {
-        info.min = std::min(texbuff[ii], info.min);
-        info.max = std::max(texbuff[ii], info.max);
-      }
-    }
-    else {
-      uint8_t* texbuff = tex->bufferData();
-      for(size_t ii = 0; ii < npix; ++ii) {
-        uint8_t* p = &texbuff[ii*4];
-        float elev = (p[0]*256 + p[1] + p[2]/256.0f) - 32768;
-        info.min = std::min(elev, info.min);
-        info.max = std::max(elev, info.max);
-      }
-    }
-    tex->userData = std::make_shared<ElevTexInfo>(info);
-  }
-  auto* info = static_cast<ElevTexInfo*>(tex->userData.get());
-  return {info->min, info->max};
+  // same ancestors as before the pyramid: any above zoom 14, then up to ancestors more
+  glm::vec2 minMax;
+  int minZoom = std::max(1, std::min(int(tileId.z), 14) - ancestors);
+  if(!m_pyramid.bounds(tileId, minMax, std::min(minZoom, int(tileId.z)))) { return {0, 9000}; }
+  return minMax;
 }
 
 void ElevationManager::renderTerrainDepth(RenderState& _rs, const View& _view,
@@ -194,6 +456,12 @@ void ElevationManager::renderTerrainDepth(RenderState& _rs, const View& _view,
   static std::atomic_bool isRunning{false};
   FrameInfo::scope _trace("renderTerrainDepth");
 
+  // with pixel buffer objects glReadPixels() doesn't block, so no offscreen worker is needed
+  if(Hardware::supportsAsyncReadback) {
+    renderTerrainDepthAsync(_rs, _view, _tiles);
+    return;
+  }
+
   //offscreenWorker.reset();
   if(!offscreenWorker) {
     LOGE("Offscreen worker has not been created!");
@@ -272,11 +540,89 @@ void ElevationManager::renderTerrainDepth(RenderState& _rs, const View& _view,
   drawCond.wait(mainLock, [&]{ return drawFinished; });
 }
 
+void ElevationManager::renderTerrainDepthAsync(RenderState& _rs, const View& _view,
+                                               const std::vector<std::shared_ptr<Tile>>& _tiles)
+{
+  GpuTimer::Scope gpuTime(_rs.gpuTimer, "terrainDepth");
+  if(!m_depthReadback)
+    m_depthReadback = std::make_unique<PixelReadback>();
+
+  // reads finish in the order started; the most recent finished one replaces the depth data
+  FrameBuffer::PixelRect rect;
+  while(!m_pendingDepth.empty() && m_depthReadback->poll(m_pendingDepth.front().first, rect)) {
+    DepthData view = std::move(m_pendingDepth.front().second);
+    m_pendingDepth.erase(m_pendingDepth.begin());
+    if(rect.pixels.empty()) { continue; }
+
+    auto& d = m_depthData[0];
+    view.depth = std::move(d.depth);
+    d = std::move(view);
+    d.depth.assign(size_t(d.w)*d.h, 0.0f);
+    for(int row = 0; row < rect.height; row++) {
+      std::memcpy(&d.depth[size_t(rect.bottom + row)*d.w + rect.left],
+                  &rect.pixels[size_t(row)*rect.width], rect.width*sizeof(float));
+    }
+  }
+
+  // don't delay frame to wait for terrain depth
+  if(m_depthReadback->inFlight() >= PixelReadback::SLOTS) { return; }
+
+  int w = _view.getWidth()/bufferScale, h = _view.getHeight()/bufferScale;
+  FrameBuffer::PixelRect readRect;
+  readRect.width = w;
+  readRect.height = h;
+  if(m_readQueriedDepthOnly) {
+    // blocks of the buffer containing all points queried since the last read
+    const int block = 16;
+    auto& b = m_depthQueryBounds;
+    if(b.x > b.z) { return; }
+    int x0 = glm::clamp(b.x, 0, w - 1)/block*block;
+    int x1 = std::min(w, (glm::clamp(b.z, 0, w - 1)/block + 1)*block);
+    int y0 = glm::clamp(b.y, 0, h - 1)/block*block;
+    int y1 = std::min(h, (glm::clamp(b.w, 0, h - 1)/block + 1)*block);
+    // screen y is down, GL rows are up
+    readRect.left = x0;
+    readRect.bottom = h - y1;
+    readRect.width = x1 - x0;
+    readRect.height = y1 - y0;
+    b = glm::ivec4(INT_MAX, INT_MAX, INT_MIN, INT_MIN);
+  }
+
+  if (!m_frameBuffer || m_frameBuffer->getWidth() != w || m_frameBuffer->getHeight() != h)
+    m_frameBuffer = std::make_unique<FrameBuffer>(w, h, false, GL_R32UI);
+
+  _rs.cacheDefaultFramebuffer();
+  m_frameBuffer->applyAsRenderTarget(_rs);
+  m_style->draw(_rs, _view, _tiles, {});
+
+  int slot = m_depthReadback->start(readRect, GL_RED_INTEGER, GL_UNSIGNED_INT);
+  _rs.framebuffer(_rs.defaultFrameBuffer());
+
+  DepthData view;
+  view.w = w;
+  view.h = h;
+  view.zoom = _view.getBaseZoom();
+  view.viewPos = _view.getPosition();
+  view.viewProj = _view.getViewProjectionMatrix();
+  m_pendingDepth.emplace_back(slot, std::move(view));
+}
+
+void ElevationManager::invalidateDepthReadback()
+{
+  if(m_depthReadback) { m_depthReadback->invalidate(); }
+  m_pendingDepth.clear();
+}
+
 float ElevationManager::getDepth(glm::vec2 screenpos)
 {
   auto& d = m_depthData[0];
-  if(d.depth.empty()) { return 0; }
   glm::vec2 pos = glm::floor(screenpos/bufferScale);
+  if(m_readQueriedDepthOnly) {
+    auto& b = m_depthQueryBounds;
+    b = glm::ivec4(std::min(b.x, int(pos.x)), std::min(b.y, int(pos.y)),
+                   std::max(b.z, int(pos.x)), std::max(b.w, int(pos.y)));
+  }
+  if(d.depth.empty()) { return 0; }
   if(pos.x < 0 || pos.y < 0 || pos.x >= d.w || pos.y >= d.h) { return 0; }
   //return 2*depth[int(pos.x) + int(h - pos.y - 1)*w] - 1;  // convert from 0..1 (glDepthRange) to -1..1 (NDC)
   return m_depthData[0].depth[int(pos.x) + int(d.h - pos.y - 1)*d.w];
@@ -314,11 +660,20 @@ ElevationManager::ElevationManager(std::shared_ptr<RasterSource> src, Style& sty
   }
   m_style->setID(style.getID());  // use same mesh
   m_style->setRasterType(RasterType::custom);
+
+  // textures are decoded by RasterSource::createTexture(), see decodeElevation()
+  m_elevationSource->m_onTextureCached = [this](const TileID& tileId, const Texture& tex) {
+    if(auto* data = static_cast<ElevationData*>(tex.userData.get())) {
+      m_pyramid.add(tileId, {data->min, data->max});
+    }
+  };
 }
 
 ElevationManager::~ElevationManager()
 {
-  if(!offscreenWorker) { return; }
+  m_elevationSource->m_onTextureCached = nullptr;
+  // with async readback, GL objects were created on this context
+  if(!offscreenWorker || m_depthReadback) { return; }
   offscreenWorker->enqueue([_style=m_style.release(), _fb=m_frameBuffer.release()](){
     // make sure RenderState doesn't cache handle of deleted framebuffer
     if(m_renderState) { m_renderState->framebuffer(0); }
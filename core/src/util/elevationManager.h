@@ -3,6 +3,10 @@
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <climits>
+#include <vector>
+#include "util/contourLines.h"
+#include "util/elevationPyramid.h"
 #include "util/mapProjection.h"
 
 namespace Tangram {
@@ -15,6 +19,7 @@ class View;
 class Tile;
 class AsyncWorker;
 class Texture;
+class PixelReadback;
 
 class ElevationManager
 {
@@ -27,10 +32,33 @@ public:
     glm::mat4 viewProj;
   };
 
+  // positions grouped by the elevation tile sampled for them, see prepareElevations()
+  struct ElevationBatch {
+    struct Group {
+      TileID tileId = NOT_A_TILE;
+      std::shared_ptr<Texture> texture;
+      std::vector<uint32_t> indices;
+    };
+    std::vector<ProjectedMeters> positions;
+    std::vector<Group> groups;
+
+    // write elevation of all positions to @out and whether a tile was found to @ok (optional);
+    //  holds its own references to the textures, so it can run on any thread
+    void sample(double* out, uint8_t* ok = nullptr) const;
+  };
+
   ElevationManager(std::shared_ptr<RasterSource> src, Style& style);
   ~ElevationManager();
   double getElevation(ProjectedMeters pos, bool& ok);
+  // group @positions by loaded elevation tile at @zoom, or at the highest loaded zoom if @zoom < 0,
+  //  using ancestors where the tile is missing; call on the main thread (the texture cache isn't locked)
+  ElevationBatch prepareElevations(std::vector<ProjectedMeters> positions, int zoom = -1);
+  // elevation at @count positions, see prepareElevations() and ElevationBatch::sample()
+  void getElevations(const ProjectedMeters* pos, size_t count, double* out, uint8_t* ok = nullptr,
+                     int zoom = -1);
   glm::vec2 getMinMaxElev(TileID tileId, int ancestors = 0);
+  // min and max elevation within tileId from the elevation pyramid, including all ancestors; false if unknown
+  bool getElevationBounds(TileID tileId, glm::vec2& minMax) const { return m_pyramid.bounds(tileId, minMax); }
   float getDepth(glm::vec2 screenpos);
   DepthData& getDepthData() { return m_depthData[0]; }
   bool hasTile(TileID tileId);
@@ -38,21 +66,54 @@ public:
 
   void renderTerrainDepth(RenderState& _rs, const View& _view,
                           const std::vector<std::shared_ptr<Tile>>& _tiles);
+  // with async readback, only read the blocks of the depth buffer around the points passed to getDepth()
+  //  since the previous read; depth elsewhere is 0 (unknown)
+  void setReadQueriedDepthOnly(bool enable) { m_readQueriedDepthOnly = enable; }
+  // drop depth reads in flight, e.g. after GL context loss
+  void invalidateDepthReadback();
 
   static double elevationLerp(const Texture& tex, glm::vec2 pos, glm::vec2* gradOut = nullptr);
   static double elevationLerp(const Texture& tex, TileID tileId, ProjectedMeters meters);
+  // sample @count positions in tile coordinates at once, four at a time with SSE2 or NEON
+  static void elevationLerp(const Texture& tex, const glm::vec2* pos, size_t count, float* out);
+
+  // decode Terrarium RGB elevation of a texture with kept data into a float grid (and min, max)
+  //  stored in tex.userData, after which the texture data is released on upload; called by RasterSource
+  //  on the worker thread creating the texture
+  static void decodeElevation(Texture& tex);
+
+  // elevation of all pixels of a decoded texture; HALF_FLOAT data is converted into buffer; null if not
+  //  available
+  static const float* elevationGrid(const Texture& tex, std::vector<float>& buffer);
+
+  // contour lines at the positive multiples of elevStep in the decoded elevation of tex, extracted on first
+  //  use and kept with it; null if tex has no decoded elevation
+  static std::shared_ptr<const std::vector<ContourLine>> contourLines(const Texture& tex, float elevStep);
 
   void drawDepthDebug(RenderState& _rs, const View& _view);
 
   std::shared_ptr<RasterSource> m_elevationSource;
+  // bounds of loaded elevation tiles, updated as the textures are cached
+  ElevationPyramid m_pyramid;
   std::unique_ptr<Style> m_style;
   std::unique_ptr<FrameBuffer> m_frameBuffer;
   DepthData m_depthData[2];
+  // reads of terrain depth in flight on the GL thread, in order started, with the view they were rendered
+  //  for; used instead of offscreenWorker when Hardware::supportsAsyncReadback
+  std::unique_ptr<PixelReadback> m_depthReadback;
+  std::vector<std::pair<int, DepthData>> m_pendingDepth;
+  // min x, y, max x, y of depth buffer pixels queried since the last read
+  glm::ivec4 m_depthQueryBounds{INT_MAX, INT_MAX, INT_MIN, INT_MIN};
+  bool m_readQueriedDepthOnly = false;
   int m_minZoom = 0;
   float m_terrainScale = 1.0f;
 
   static std::unique_ptr<RenderState> m_renderState;
   static std::unique_ptr<AsyncWorker> offscreenWorker;
+
+private:
+  void renderTerrainDepthAsync(RenderState& _rs, const View& _view,
+                               const std::vector<std::shared_ptr<Tile>>& _tiles);
 };
 
 }
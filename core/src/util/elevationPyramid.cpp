@@ -0,0 +1,63 @@
+#include "util/elevationPyramid.h"
+
+#include "glm/common.hpp"
+
+#include <cfloat>
+
+namespace Tangram {
+
+void ElevationPyramid::add(TileID _tileId, glm::vec2 _minMax) {
+    TileID tileId(_tileId.x, _tileId.y, _tileId.z);
+
+    auto& bounds = m_tiles[tileId];
+    bounds.own = _minMax;
+    bounds.hasOwn = true;
+    propagate(tileId);
+
+    // Ancestors keep the bounds derived from dropped tiles
+    auto it = m_tiles.begin();
+    while (m_tiles.size() > m_maxTiles && it != m_tiles.end()) {
+        if (it->first == tileId) {
+            ++it;
+        } else {
+            it = m_tiles.erase(it);
+        }
+    }
+}
+
+void ElevationPyramid::propagate(TileID _tileId) {
+    TileID tileId = _tileId;
+    while (tileId.z > 0) {
+        TileID parent = tileId.getParent();
+
+        glm::vec2 children(FLT_MAX, -FLT_MAX);
+        for (int i = 0; i < 4; i++) {
+            auto it = m_tiles.find(TileID(parent.x * 2 + (i & 1), parent.y * 2 + (i >> 1), tileId.z));
+            if (it == m_tiles.end()) { return; }
+            glm::vec2 child = it->second.get();
+            children = glm::vec2(glm::min(children.x, child.x), glm::max(children.y, child.y));
+        }
+
+        auto& bounds = m_tiles[parent];
+        if (bounds.hasChildren && bounds.children == children) { return; }
+        bounds.children = children;
+        bounds.hasChildren = true;
+        tileId = parent;
+    }
+}
+
+bool ElevationPyramid::bounds(TileID _tileId, glm::vec2& _minMax, int _minZoom) const {
+    TileID tileId(_tileId.x, _tileId.y, _tileId.z);
+    while (tileId.z >= _minZoom) {
+        auto it = m_tiles.find(tileId);
+        if (it != m_tiles.end()) {
+            _minMax = it->second.get();
+            return true;
+        }
+        if (tileId.z == 0) { break; }
+        tileId = tileId.getParent();
+    }
+    return false;
+}
+
+}
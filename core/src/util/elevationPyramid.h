@@ -0,0 +1,58 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include "glm/vec2.hpp"
+
+#include <cstddef>
+#include <map>
+
+namespace Tangram {
+
+/*
+ * ElevationPyramid - Quadtree of the min and max elevation of elevation tiles
+ *
+ * Tiles are added as their textures are loaded and stay after the textures are released. The
+ * bounds of a tile are the union of the bounds of its children once all four are known, which
+ * catches peaks that are smoothed away in the coarser data of the tile itself, and otherwise
+ * those of its own data. Tiles without bounds take those of their nearest ancestor.
+ *
+ * Not thread-safe; used on the main thread.
+ */
+class ElevationPyramid {
+
+public:
+
+    explicit ElevationPyramid(size_t _maxTiles = 1 << 16) : m_maxTiles(_maxTiles) {}
+
+    /* Add the min and max elevation in the data of tile @_tileId */
+    void add(TileID _tileId, glm::vec2 _minMax);
+
+    /* Bounds of the elevation within @_tileId from the tile or its ancestors down to zoom
+     * @_minZoom; returns false when none are known */
+    bool bounds(TileID _tileId, glm::vec2& _minMax, int _minZoom = 0) const;
+
+    size_t size() const { return m_tiles.size(); }
+
+    void clear() { m_tiles.clear(); }
+
+private:
+
+    struct Bounds {
+        glm::vec2 own{0.f};
+        glm::vec2 children{0.f};
+        bool hasOwn = false;
+        bool hasChildren = false;
+
+        glm::vec2 get() const { return hasChildren ? children : own; }
+    };
+
+    // Update the bounds of the ancestors of @_tileId from their children
+    void propagate(TileID _tileId);
+
+    // Ordered from the highest zoom, so that the most detailed tiles are dropped first
+    std::map<TileID, Bounds> m_tiles;
+    size_t m_maxTiles;
+};
+
+}
@@ -0,0 +1,832 @@
+#include "util/geoTiff.h"
+
+#include "log.h"
+#include "util/imageLoader.h"
+#include "util/pixelBufferPool.h"
+#include "util/zlibHelper.h"
+
+#include "Lerc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace Tangram {
+
+// TIFF tags
+enum : uint16_t {
+    TAG_NEW_SUBFILE_TYPE = 254,
+    TAG_IMAGE_WIDTH = 256,
+    TAG_IMAGE_LENGTH = 257,
+    TAG_BITS_PER_SAMPLE = 258,
+    TAG_COMPRESSION = 259,
+    TAG_PHOTOMETRIC = 262,
+    TAG_STRIP_OFFSETS = 273,
+    TAG_SAMPLES_PER_PIXEL = 277,
+    TAG_ROWS_PER_STRIP = 278,
+    TAG_STRIP_BYTE_COUNTS = 279,
+    TAG_PLANAR_CONFIGURATION = 284,
+    TAG_PREDICTOR = 317,
+    TAG_TILE_WIDTH = 322,
+    TAG_TILE_LENGTH = 323,
+    TAG_TILE_OFFSETS = 324,
+    TAG_TILE_BYTE_COUNTS = 325,
+    TAG_EXTRA_SAMPLES = 338,
+    TAG_SAMPLE_FORMAT = 339,
+    TAG_JPEG_TABLES = 347,
+    TAG_MODEL_PIXEL_SCALE = 33550,
+    TAG_MODEL_TIEPOINT = 33922,
+    TAG_MODEL_TRANSFORMATION = 34264,
+    TAG_GEO_KEY_DIRECTORY = 34735,
+    TAG_GDAL_NODATA = 42113,
+    TAG_LERC_PARAMETERS = 50674,
+};
+
+// GeoTIFF keys
+enum : uint16_t {
+    KEY_MODEL_TYPE = 1024,
+    KEY_RASTER_TYPE = 1025,
+    KEY_GEOGRAPHIC_TYPE = 2048,
+    KEY_PROJECTED_TYPE = 3072,
+};
+
+enum : uint16_t {
+    COMPRESSION_NONE = 1,
+    COMPRESSION_LZW = 5,
+    COMPRESSION_JPEG = 7,
+    COMPRESSION_DEFLATE = 8,
+    COMPRESSION_ADOBE_DEFLATE = 32946,
+    COMPRESSION_LERC = 34887,
+};
+
+// Most images in a file: the full resolution image, overviews and masks
+static constexpr int MAX_IFDS = 64;
+
+// Largest value array of a tag, e.g. the block offsets of a large image
+static constexpr uint64_t MAX_TAG_BYTES = 64 * 1024 * 1024;
+
+// Largest block width and height, COGs use 256 to 1024
+static constexpr uint32_t MAX_BLOCK_SIZE = 4096;
+
+namespace {
+
+struct TiffReader {
+    const uint8_t* data;
+    size_t size;
+    bool bigEndian = false;
+    bool bigTiff = false;
+    // End of the furthest range that was beyond @size
+    uint64_t needed = 0;
+
+    bool has(uint64_t _offset, uint64_t _length) {
+        if (_offset <= size && _length <= size - _offset) { return true; }
+        // A range that overflows cannot be read with more data either
+        if (_length <= UINT64_MAX - _offset) { needed = std::max(needed, _offset + _length); }
+        return false;
+    }
+
+    // Unsigned integer of @_bytes at @_offset, which must be within @size
+    uint64_t read(uint64_t _offset, int _bytes) const {
+        uint64_t value = 0;
+        for (int i = 0; i < _bytes; i++) {
+            uint64_t byte = data[_offset + i];
+            value |= byte << (8 * (bigEndian ? _bytes - 1 - i : i));
+        }
+        return value;
+    }
+
+    int offsetBytes() const { return bigTiff ? 8 : 4; }
+};
+
+struct TiffEntry {
+    uint16_t tag = 0;
+    uint16_t type = 0;
+    uint64_t count = 0;
+    // Of the values, inline in the entry when they fit
+    uint64_t offset = 0;
+};
+
+int typeBytes(uint16_t _type) {
+    switch (_type) {
+    case 1: case 2: case 6: case 7: return 1;
+    case 3: case 8: return 2;
+    case 4: case 9: case 11: case 13: return 4;
+    case 5: case 10: case 12: case 16: case 17: case 18: return 8;
+    default: return 0;
+    }
+}
+
+// Value @_index of @_entry, which must be within the data read
+double readValue(const TiffReader& _reader, const TiffEntry& _entry, uint64_t _index) {
+    int bytes = typeBytes(_entry.type);
+    uint64_t offset = _entry.offset + _index * bytes;
+    switch (_entry.type) {
+    case 5: case 10: {
+        uint64_t num = _reader.read(offset, 4), den = _reader.read(offset + 4, 4);
+        if (_entry.type == 10) { return den ? double(int32_t(num)) / int32_t(den) : 0; }
+        return den ? double(num) / den : 0;
+    }
+    case 6: return int8_t(_reader.read(offset, 1));
+    case 8: return int16_t(_reader.read(offset, 2));
+    case 9: return int32_t(_reader.read(offset, 4));
+    case 17: return double(int64_t(_reader.read(offset, 8)));
+    case 11: {
+        uint32_t bits = uint32_t(_reader.read(offset, 4));
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    case 12: {
+        uint64_t bits = _reader.read(offset, 8);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    default: return double(_reader.read(offset, bytes));
+    }
+}
+
+// Values of @_entry; false if they are beyond the data read or invalid
+template<class T>
+bool readValues(TiffReader& _reader, const TiffEntry& _entry, std::vector<T>& _values) {
+    uint64_t valueBytes = typeBytes(_entry.type);
+    if (valueBytes == 0 || _entry.count == 0 || _entry.count > MAX_TAG_BYTES / valueBytes) { return false; }
+    if (!_reader.has(_entry.offset, valueBytes * _entry.count)) { return false; }
+    _values.resize(_entry.count);
+    for (uint64_t i = 0; i < _entry.count; i++) {
+        if (_entry.type == 16 || _entry.type == 18 || _entry.type == 4 || _entry.type == 13) {
+            // Offsets are not rounded through doubles
+            _values[i] = T(_reader.read(_entry.offset + i * typeBytes(_entry.type), typeBytes(_entry.type)));
+        } else {
+            _values[i] = T(readValue(_reader, _entry, i));
+        }
+    }
+    return true;
+}
+
+const TiffEntry* findEntry(const std::vector<TiffEntry>& _entries, uint16_t _tag) {
+    for (const auto& entry : _entries) {
+        if (entry.tag == _tag) { return &entry; }
+    }
+    return nullptr;
+}
+
+// First value of @_tag into @_value, which is kept if there is no such tag; false if the value
+// is beyond the data read
+template<class T>
+bool readScalar(TiffReader& _reader, const std::vector<TiffEntry>& _entries, uint16_t _tag, T& _value) {
+    const TiffEntry* entry = findEntry(_entries, _tag);
+    if (!entry || entry->count == 0) { return true; }
+    if (!_reader.has(entry->offset, typeBytes(entry->type))) { return false; }
+    _value = T(readValue(_reader, *entry, 0));
+    return true;
+}
+
+bool isSupported(const GeoTiffImage& _image) {
+    if (_image.width == 0 || _image.height == 0 || _image.blockWidth == 0 || _image.blockHeight == 0 ||
+        _image.blockWidth > MAX_BLOCK_SIZE || _image.blockHeight > MAX_BLOCK_SIZE) {
+        return false;
+    }
+    switch (_image.compression) {
+    case COMPRESSION_NONE: case COMPRESSION_LZW: case COMPRESSION_DEFLATE:
+    case COMPRESSION_ADOBE_DEFLATE: case COMPRESSION_LERC:
+        break;
+    case COMPRESSION_JPEG:
+        if (_image.bitsPerSample != 8 || (_image.samples != 1 && _image.samples != 3)) { return false; }
+        break;
+    default:
+        return false;
+    }
+    if (_image.predictor < 1 || _image.predictor > 3) { return false; }
+    if (_image.predictor == 3 && _image.sampleFormat != 3) { return false; }
+
+    if (_image.bitsPerSample == 8) {
+        return _image.sampleFormat == 1 && _image.samples != 2 && _image.samples <= 4;
+    }
+    if (_image.samples != 1) { return false; }
+    if (_image.sampleFormat == 3) { return _image.bitsPerSample == 32 || _image.bitsPerSample == 64; }
+    return (_image.sampleFormat == 1 || _image.sampleFormat == 2) &&
+        (_image.bitsPerSample == 16 || _image.bitsPerSample == 32);
+}
+
+bool sameSamples(const GeoTiffImage& _a, const GeoTiffImage& _b) {
+    return _a.samples == _b.samples && _a.bitsPerSample == _b.bitsPerSample &&
+        _a.sampleFormat == _b.sampleFormat;
+}
+
+// Georeferencing of the full resolution image from its tags
+GeoTiffResult parseGeoKeys(TiffReader& _reader, const std::vector<TiffEntry>& _entries, GeoTiff& _tiff) {
+
+    const TiffEntry* keysEntry = findEntry(_entries, TAG_GEO_KEY_DIRECTORY);
+    if (!keysEntry) {
+        LOGE("GeoTIFF: No GeoKeyDirectory, image is not georeferenced");
+        return GeoTiffResult::invalid;
+    }
+    std::vector<uint16_t> keys;
+    if (!readValues(_reader, *keysEntry, keys)) {
+        return _reader.needed ? GeoTiffResult::needMoreData : GeoTiffResult::invalid;
+    }
+
+    int modelType = 0, rasterType = 1, geographicType = 0, projectedType = 0;
+    size_t numKeys = keys.size() >= 4 ? keys[3] : 0;
+    for (size_t i = 0; i < numKeys && 4 * (i + 2) <= keys.size(); i++) {
+        const uint16_t* key = &keys[4 * (i + 1)];
+        // Keys with values in other tags are not needed here
+        if (key[1] != 0) { continue; }
+        switch (key[0]) {
+        case KEY_MODEL_TYPE: modelType = key[3]; break;
+        case KEY_RASTER_TYPE: rasterType = key[3]; break;
+        case KEY_GEOGRAPHIC_TYPE: geographicType = key[3]; break;
+        case KEY_PROJECTED_TYPE: projectedType = key[3]; break;
+        }
+    }
+
+    // Web Mercator under its current and former codes
+    if (projectedType == 3857 || projectedType == 3785 || projectedType == 900913 ||
+        projectedType == 102100 || projectedType == 102113) {
+        _tiff.crs = GeoTiffCRS::webMercator;
+    } else if (modelType == 2 && (geographicType == 4326 || geographicType == 0) && projectedType == 0) {
+        _tiff.crs = GeoTiffCRS::lngLat;
+    } else {
+        LOGE("GeoTIFF: Unsupported CRS (model %d, geographic %d, projected %d), only EPSG:3857 and EPSG:4326 are read",
+             modelType, geographicType, projectedType);
+        return GeoTiffResult::invalid;
+    }
+
+    if (const TiffEntry* entry = findEntry(_entries, TAG_MODEL_TRANSFORMATION)) {
+        std::vector<double> m;
+        if (!readValues(_reader, *entry, m) || m.size() < 16) {
+            return _reader.needed ? GeoTiffResult::needMoreData : GeoTiffResult::invalid;
+        }
+        if (m[1] != 0 || m[4] != 0) {
+            LOGE("GeoTIFF: Rotated images are not supported");
+            return GeoTiffResult::invalid;
+        }
+        _tiff.pixelWidth = m[0];
+        _tiff.pixelHeight = -m[5];
+        _tiff.originX = m[3];
+        _tiff.originY = m[7];
+    } else {
+        const TiffEntry* scaleEntry = findEntry(_entries, TAG_MODEL_PIXEL_SCALE);
+        const TiffEntry* tiepointEntry = findEntry(_entries, TAG_MODEL_TIEPOINT);
+        std::vector<double> scale, tiepoint;
+        if (!scaleEntry || !tiepointEntry) {
+            LOGE("GeoTIFF: No pixel scale and tiepoint");
+            return GeoTiffResult::invalid;
+        }
+        if (!readValues(_reader, *scaleEntry, scale) || !readValues(_reader, *tiepointEntry, tiepoint) ||
+            scale.size() < 2 || tiepoint.size() < 6) {
+            return _reader.needed ? GeoTiffResult::needMoreData : GeoTiffResult::invalid;
+        }
+        _tiff.pixelWidth = scale[0];
+        _tiff.pixelHeight = scale[1];
+        _tiff.originX = tiepoint[3] - tiepoint[0] * scale[0];
+        _tiff.originY = tiepoint[4] + tiepoint[1] * scale[1];
+    }
+
+    if (!(_tiff.pixelWidth > 0) || !(_tiff.pixelHeight > 0)) {
+        LOGE("GeoTIFF: Invalid pixel size %f x %f", _tiff.pixelWidth, _tiff.pixelHeight);
+        return GeoTiffResult::invalid;
+    }
+
+    // Coordinates of PixelIsPoint rasters are of the pixel centers
+    if (rasterType == 2) {
+        _tiff.originX -= 0.5 * _tiff.pixelWidth;
+        _tiff.originY += 0.5 * _tiff.pixelHeight;
+    }
+
+    if (const TiffEntry* entry = findEntry(_entries, TAG_GDAL_NODATA)) {
+        if (!_reader.has(entry->offset, entry->count)) { return GeoTiffResult::needMoreData; }
+        std::string value(reinterpret_cast<const char*>(_reader.data + entry->offset), entry->count);
+        char* end = nullptr;
+        double noData = std::strtod(value.c_str(), &end);
+        if (end != value.c_str()) {
+            _tiff.hasNoData = true;
+            _tiff.noData = noData;
+        }
+    }
+    return GeoTiffResult::ok;
+}
+
+}
+
+GeoTiffResult parseGeoTiff(const char* _data, size_t _size, GeoTiff& _tiff, uint64_t& _needed) {
+
+    TiffReader reader{ reinterpret_cast<const uint8_t*>(_data), _size };
+    _tiff = GeoTiff();
+
+    auto needMore = [&]() {
+        _needed = reader.needed;
+        return GeoTiffResult::needMoreData;
+    };
+
+    if (!reader.has(0, 16)) { return needMore(); }
+    if (_data[0] == 'M' && _data[1] == 'M') {
+        reader.bigEndian = true;
+    } else if (_data[0] != 'I' || _data[1] != 'I') {
+        LOGE("GeoTIFF: Not a TIFF file");
+        return GeoTiffResult::invalid;
+    }
+    uint64_t version = reader.read(2, 2);
+    if (version == 43) {
+        reader.bigTiff = true;
+        if (reader.read(4, 2) != 8) { return GeoTiffResult::invalid; }
+    } else if (version != 42) {
+        LOGE("GeoTIFF: Not a TIFF file");
+        return GeoTiffResult::invalid;
+    }
+    _tiff.bigEndian = reader.bigEndian;
+
+    int ob = reader.offsetBytes();
+    int countBytes = reader.bigTiff ? 8 : 2;
+    int entryBytes = reader.bigTiff ? 20 : 12;
+    uint64_t ifdOffset = reader.read(reader.bigTiff ? 8 : 4, ob);
+
+    for (int ifd = 0; ifdOffset != 0 && ifd < MAX_IFDS; ifd++) {
+        if (!reader.has(ifdOffset, countBytes)) { return needMore(); }
+        uint64_t numEntries = reader.read(ifdOffset, countBytes);
+        if (numEntries > 4096) { return GeoTiffResult::invalid; }
+        uint64_t entriesOffset = ifdOffset + countBytes;
+        if (!reader.has(entriesOffset, numEntries * entryBytes + ob)) { return needMore(); }
+
+        std::vector<TiffEntry> entries(numEntries);
+        for (uint64_t i = 0; i < numEntries; i++) {
+            uint64_t offset = entriesOffset + i * entryBytes;
+            auto& entry = entries[i];
+            entry.tag = uint16_t(reader.read(offset, 2));
+            entry.type = uint16_t(reader.read(offset + 2, 2));
+            entry.count = reader.read(offset + 4, ob);
+            uint64_t valueOffset = offset + 4 + ob;
+            entry.offset = typeBytes(entry.type) * entry.count <= uint64_t(ob) ?
+                valueOffset : reader.read(valueOffset, ob);
+        }
+        ifdOffset = reader.read(entriesOffset + numEntries * entryBytes, ob);
+
+        uint32_t subfileType = 0;
+        if (!readScalar(reader, entries, TAG_NEW_SUBFILE_TYPE, subfileType)) { return needMore(); }
+        // Transparency masks are not used
+        if (subfileType & 4) { continue; }
+
+        GeoTiffImage image;
+        uint16_t planar = 1;
+        if (!readScalar(reader, entries, TAG_IMAGE_WIDTH, image.width) ||
+            !readScalar(reader, entries, TAG_IMAGE_LENGTH, image.height) ||
+            !readScalar(reader, entries, TAG_TILE_WIDTH, image.blockWidth) ||
+            !readScalar(reader, entries, TAG_TILE_LENGTH, image.blockHeight) ||
+            !readScalar(reader, entries, TAG_SAMPLES_PER_PIXEL, image.samples) ||
+            !readScalar(reader, entries, TAG_BITS_PER_SAMPLE, image.bitsPerSample) ||
+            !readScalar(reader, entries, TAG_SAMPLE_FORMAT, image.sampleFormat) ||
+            !readScalar(reader, entries, TAG_COMPRESSION, image.compression) ||
+            !readScalar(reader, entries, TAG_PREDICTOR, image.predictor) ||
+            !readScalar(reader, entries, TAG_PLANAR_CONFIGURATION, planar)) {
+            return needMore();
+        }
+
+        const TiffEntry* offsets = findEntry(entries, TAG_TILE_OFFSETS);
+        const TiffEntry* sizes = findEntry(entries, TAG_TILE_BYTE_COUNTS);
+        if (!offsets || !sizes || image.blockWidth == 0) {
+            if (_tiff.images.empty()) {
+                LOGE("GeoTIFF: Image is not tiled, convert it to a Cloud-Optimized GeoTIFF");
+                return GeoTiffResult::invalid;
+            }
+            continue;
+        }
+
+        if (planar != 1 && image.samples != 1) {
+            LOGE("GeoTIFF: Separate planes are not supported");
+            return GeoTiffResult::invalid;
+        }
+        if (!isSupported(image)) {
+            if (_tiff.images.empty()) {
+                LOGE("GeoTIFF: Unsupported image: %d samples of %d bits, format %d, compression %d, predictor %d",
+                     image.samples, image.bitsPerSample, image.sampleFormat, image.compression, image.predictor);
+                return GeoTiffResult::invalid;
+            }
+            continue;
+        }
+        if (!_tiff.images.empty() && !sameSamples(image, _tiff.images[0])) { continue; }
+
+        if (!readValues(reader, *offsets, image.blockOffsets) ||
+            !readValues(reader, *sizes, image.blockSizes)) {
+            if (reader.needed) { return needMore(); }
+            return GeoTiffResult::invalid;
+        }
+        size_t numBlocks = size_t(image.blocksAcross()) * image.blocksDown();
+        if (image.blockOffsets.size() < numBlocks || image.blockSizes.size() < numBlocks) {
+            LOGE("GeoTIFF: Missing block offsets");
+            return GeoTiffResult::invalid;
+        }
+
+        if (const TiffEntry* tables = findEntry(entries, TAG_JPEG_TABLES)) {
+            if (!reader.has(tables->offset, tables->count)) { return needMore(); }
+            image.jpegTables.assign(_data + tables->offset, tables->count);
+        }
+        if (const TiffEntry* entry = findEntry(entries, TAG_LERC_PARAMETERS)) {
+            std::vector<uint32_t> params;
+            if (!readValues(reader, *entry, params)) { return needMore(); }
+            if (params.size() > 1) { image.lercCompression = uint16_t(params[1]); }
+        }
+
+        if (_tiff.images.empty()) {
+            GeoTiffResult result = parseGeoKeys(reader, entries, _tiff);
+            if (result == GeoTiffResult::needMoreData) { return needMore(); }
+            if (result != GeoTiffResult::ok) { return result; }
+        }
+        _tiff.images.push_back(std::move(image));
+    }
+
+    if (_tiff.images.empty()) {
+        LOGE("GeoTIFF: No image");
+        return GeoTiffResult::invalid;
+    }
+
+    // COGs list overviews by decreasing size, but be sure of it
+    std::stable_sort(_tiff.images.begin() + 1, _tiff.images.end(),
+                     [](const GeoTiffImage& a, const GeoTiffImage& b) { return a.width > b.width; });
+    return GeoTiffResult::ok;
+}
+
+// TIFF variant of LZW: codes of 9 to 12 bits from the most significant bit on, widened one code early
+static bool decodeLzw(const uint8_t* _data, size_t _size, size_t _expected, std::vector<uint8_t>& _out) {
+
+    constexpr int CLEAR = 256, END = 257, FIRST = 258, MAX_CODES = 4096;
+
+    struct Code { uint16_t prefix; uint16_t length; uint8_t first; uint8_t last; };
+    std::vector<Code> table(MAX_CODES);
+    for (int i = 0; i < 256; i++) { table[i] = { 0, 1, uint8_t(i), uint8_t(i) }; }
+
+    _out.clear();
+    _out.reserve(_expected);
+
+    size_t pos = 0;
+    uint32_t bitBuffer = 0;
+    int bits = 0, width = 9, next = FIRST, prev = -1;
+
+    auto emit = [&](int _code) {
+        size_t length = table[_code].length;
+        size_t start = _out.size();
+        _out.resize(start + length);
+        for (size_t i = length; i > 0; i--) {
+            _out[start + i - 1] = table[_code].last;
+            _code = table[_code].prefix;
+        }
+    };
+
+    while (_out.size() < _expected) {
+        while (bits < width) {
+            if (pos >= _size) { return _out.size() >= _expected; }
+            bitBuffer = (bitBuffer << 8) | _data[pos++];
+            bits += 8;
+        }
+        int code = int(bitBuffer >> (bits - width)) & ((1 << width) - 1);
+        bits -= width;
+
+        if (code == END) { break; }
+        if (code == CLEAR) {
+            width = 9;
+            next = FIRST;
+            prev = -1;
+            continue;
+        }
+        if (prev < 0) {
+            if (code > 255) { return false; }
+            emit(code);
+            prev = code;
+            continue;
+        }
+        if (code > next) { return false; }
+
+        if (next < MAX_CODES) {
+            // The new code is the previous string and the first byte of this one, which is the
+            // first byte of the previous string for the code being defined
+            uint8_t first = code < next ? table[code].first : table[prev].first;
+            table[next] = { uint16_t(prev), uint16_t(table[prev].length + 1), table[prev].first, first };
+            next++;
+        }
+        emit(code);
+        prev = code;
+
+        if (next + 1 >= (1 << width) && width < 12) { width++; }
+    }
+    return _out.size() >= _expected;
+}
+
+// Undo horizontal differencing of samples of type T in rows of @_rowSamples
+template<class T>
+static void undoHorizontalPredictor(uint8_t* _data, size_t _rows, size_t _rowSamples, int _samples) {
+    for (size_t row = 0; row < _rows; row++) {
+        T* p = reinterpret_cast<T*>(_data) + row * _rowSamples;
+        for (size_t i = _samples; i < _rowSamples; i++) { p[i] = T(p[i] + p[i - _samples]); }
+    }
+}
+
+// Undo the floating point predictor: bytes of each row are differenced and grouped by significance
+static void undoFloatPredictor(uint8_t* _data, size_t _rows, size_t _rowSamples, int _samples, int _bytes) {
+    size_t rowBytes = _rowSamples * _bytes;
+    std::vector<uint8_t> row(rowBytes);
+    for (size_t r = 0; r < _rows; r++) {
+        uint8_t* p = _data + r * rowBytes;
+        for (size_t i = _samples; i < rowBytes; i++) { p[i] = uint8_t(p[i] + p[i - _samples]); }
+        std::memcpy(row.data(), p, rowBytes);
+        for (size_t i = 0; i < _rowSamples; i++) {
+            for (int b = 0; b < _bytes; b++) {
+                // Most significant bytes come first, samples are little endian
+                p[i * _bytes + b] = row[(_bytes - b - 1) * _rowSamples + i];
+            }
+        }
+    }
+}
+
+template<class T>
+static void samplesToFloats(const uint8_t* _data, size_t _count, const GeoTiff& _tiff, std::vector<float>& _floats) {
+    const T* samples = reinterpret_cast<const T*>(_data);
+    _floats.resize(_count);
+    for (size_t i = 0; i < _count; i++) {
+        bool noData = _tiff.hasNoData && double(samples[i]) == _tiff.noData;
+        _floats[i] = noData ? std::numeric_limits<float>::quiet_NaN() : float(samples[i]);
+    }
+}
+
+static void toFloats(const GeoTiff& _tiff, const GeoTiffImage& _image, const uint8_t* _data, size_t _count,
+                     std::vector<float>& _floats) {
+    if (_image.sampleFormat == 3) {
+        if (_image.bitsPerSample == 64) { samplesToFloats<double>(_data, _count, _tiff, _floats); }
+        else { samplesToFloats<float>(_data, _count, _tiff, _floats); }
+    } else if (_image.sampleFormat == 2) {
+        if (_image.bitsPerSample == 16) { samplesToFloats<int16_t>(_data, _count, _tiff, _floats); }
+        else { samplesToFloats<int32_t>(_data, _count, _tiff, _floats); }
+    } else {
+        if (_image.bitsPerSample == 16) { samplesToFloats<uint16_t>(_data, _count, _tiff, _floats); }
+        else { samplesToFloats<uint32_t>(_data, _count, _tiff, _floats); }
+    }
+}
+
+static bool decodeJpeg(const GeoTiffImage& _image, const char* _data, size_t _size, GeoTiffBlock& _block) {
+    // Blocks are abbreviated streams which use the tables of the image: splice them in between
+    // the start of image marker of the block and its frame
+    std::string stream;
+    if (_image.jpegTables.size() > 4 && _size > 2) {
+        stream.reserve(_image.jpegTables.size() + _size);
+        stream.append(_image.jpegTables, 0, _image.jpegTables.size() - 2);
+        stream.append(_data + 2, _size - 2);
+    } else {
+        stream.assign(_data, _size);
+    }
+
+    int width = 0, height = 0;
+    GLint format = 0;
+    uint8_t* pixels = loadImage(reinterpret_cast<const uint8_t*>(stream.data()), stream.size(),
+                                &width, &height, &format, _image.samples);
+    if (!pixels) { return false; }
+    bool ok = uint32_t(width) == _block.width && uint32_t(height) == _block.height;
+    if (ok) {
+        // loadImage() flips rows for GL
+        size_t rowBytes = size_t(width) * _image.samples;
+        _block.bytes.resize(rowBytes * height);
+        for (int y = 0; y < height; y++) {
+            std::memcpy(&_block.bytes[y * rowBytes], &pixels[(height - y - 1) * rowBytes], rowBytes);
+        }
+    }
+    PixelBufferPool::release(pixels);
+    return ok;
+}
+
+USING_NAMESPACE_LERC
+
+template<class T>
+static bool decodeLercAs(const Byte* _data, size_t _size, const Lerc::LercInfo& _info, std::vector<T>& _out,
+                         std::vector<Byte>& _masks) {
+    _out.assign(size_t(_info.nCols) * _info.nRows * _info.nDepth, T(0));
+    _masks.assign(size_t(_info.nMasks) * _info.nCols * _info.nRows, 0);
+    ErrCode err = Lerc::DecodeTempl(_out.data(), _data, _size, _info.nDepth, _info.nCols, _info.nRows,
+                                    _info.nBands, _info.nMasks, _info.nMasks > 0 ? _masks.data() : nullptr,
+                                    nullptr, nullptr);
+    if (err != ErrCode::Ok) {
+        LOGE("GeoTIFF: Lerc::Decode() failed with error %d", err);
+        return false;
+    }
+    return true;
+}
+
+static bool decodeLerc(const GeoTiff& _tiff, const GeoTiffImage& _image, const char* _data, size_t _size,
+                       GeoTiffBlock& _block) {
+    std::vector<char> inflated;
+    if (_image.lercCompression != 0) {
+        Codec codec = _image.lercCompression == 2 ? Codec::zstd : Codec::gzip;
+        if (_image.lercCompression > 2 || !hasDecompressor(codec) ||
+            decompress(codec, _data, _size, inflated) != 0) {
+            LOGE("GeoTIFF: Cannot decompress LERC block with compression %d", _image.lercCompression);
+            return false;
+        }
+        _data = inflated.data();
+        _size = inflated.size();
+    }
+
+    auto* data = reinterpret_cast<const Byte*>(_data);
+    Lerc::LercInfo info;
+    if (Lerc::GetLercInfo(data, _size, info) != ErrCode::Ok || info.nBands != 1 ||
+        uint32_t(info.nCols) != _block.width || uint32_t(info.nRows) != _block.height ||
+        info.nDepth != _image.samples) {
+        LOGE("GeoTIFF: Invalid LERC block");
+        return false;
+    }
+
+    std::vector<Byte> masks;
+    size_t count = size_t(_block.width) * _block.height * _block.samples;
+    if (!_image.isFloat()) { return decodeLercAs(data, _size, info, _block.bytes, masks); }
+
+    std::vector<uint8_t> samples;
+    bool ok = false;
+    if (_image.sampleFormat == 3) {
+        std::vector<float> values;
+        if (_image.bitsPerSample == 32) {
+            ok = decodeLercAs(data, _size, info, values, masks);
+        } else {
+            std::vector<double> doubles;
+            ok = decodeLercAs(data, _size, info, doubles, masks);
+            values.assign(doubles.begin(), doubles.end());
+        }
+        if (ok) { samplesToFloats<float>(reinterpret_cast<const uint8_t*>(values.data()), count, _tiff, _block.floats); }
+    } else if (_image.bitsPerSample == 16) {
+        std::vector<int32_t> values;
+        if (_image.sampleFormat == 2) {
+            std::vector<int16_t> shorts;
+            ok = decodeLercAs(data, _size, info, shorts, masks);
+            values.assign(shorts.begin(), shorts.end());
+        } else {
+            std::vector<uint16_t> shorts;
+            ok = decodeLercAs(data, _size, info, shorts, masks);
+            values.assign(shorts.begin(), shorts.end());
+        }
+        if (ok) { samplesToFloats<int32_t>(reinterpret_cast<const uint8_t*>(values.data()), count, _tiff, _block.floats); }
+    } else if (_image.sampleFormat == 2) {
+        std::vector<int32_t> values;
+        ok = decodeLercAs(data, _size, info, values, masks);
+        if (ok) { samplesToFloats<int32_t>(reinterpret_cast<const uint8_t*>(values.data()), count, _tiff, _block.floats); }
+    } else {
+        std::vector<uint32_t> values;
+        ok = decodeLercAs(data, _size, info, values, masks);
+        if (ok) { samplesToFloats<uint32_t>(reinterpret_cast<const uint8_t*>(values.data()), count, _tiff, _block.floats); }
+    }
+    if (!ok) { return false; }
+
+    // Pixels outside of the mask have no data
+    if (!masks.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            if (!masks[i]) { _block.floats[i] = std::numeric_limits<float>::quiet_NaN(); }
+        }
+    }
+    return true;
+}
+
+bool decodeGeoTiffBlock(const GeoTiff& _tiff, const GeoTiffImage& _image, const char* _data, size_t _size,
+                        GeoTiffBlock& _block) {
+
+    _block.width = _image.blockWidth;
+    _block.height = _image.blockHeight;
+    _block.samples = _image.samples;
+    _block.bytes.clear();
+    _block.floats.clear();
+
+    if (_image.compression == COMPRESSION_JPEG) { return decodeJpeg(_image, _data, _size, _block); }
+    if (_image.compression == COMPRESSION_LERC) { return decodeLerc(_tiff, _image, _data, _size, _block); }
+
+    int sampleBytes = _image.bitsPerSample / 8;
+    if (_block.width == 0 || _block.height == 0 || _block.width > MAX_BLOCK_SIZE ||
+        _block.height > MAX_BLOCK_SIZE || _block.samples == 0 || sampleBytes == 0) {
+        return false;
+    }
+    size_t rowSamples = size_t(_block.width) * _block.samples;
+    if (rowSamples > SIZE_MAX / _block.height) { return false; }
+    size_t count = rowSamples * _block.height;
+    if (count > SIZE_MAX / sampleBytes) { return false; }
+    size_t expected = count * sampleBytes;
+
+    std::vector<uint8_t> raw;
+    switch (_image.compression) {
+    case COMPRESSION_NONE:
+        if (_size < expected) { return false; }
+        raw.assign(_data, _data + expected);
+        break;
+    case COMPRESSION_DEFLATE:
+    case COMPRESSION_ADOBE_DEFLATE: {
+        std::vector<char> inflated;
+        inflated.reserve(expected);
+        if (decompress(Codec::gzip, _data, _size, inflated) != 0 || inflated.size() < expected) {
+            LOGE("GeoTIFF: Cannot inflate block");
+            return false;
+        }
+        raw.assign(inflated.begin(), inflated.begin() + expected);
+        break;
+    }
+    case COMPRESSION_LZW:
+        if (!decodeLzw(reinterpret_cast<const uint8_t*>(_data), _size, expected, raw)) {
+            LOGE("GeoTIFF: Cannot decode LZW block");
+            return false;
+        }
+        raw.resize(expected);
+        break;
+    default:
+        return false;
+    }
+
+    if (_tiff.bigEndian && sampleBytes > 1 && _image.predictor != 3) {
+        for (size_t i = 0; i < count; i++) {
+            std::reverse(&raw[i * sampleBytes], &raw[(i + 1) * sampleBytes]);
+        }
+    }
+
+    if (_image.predictor == 2) {
+        switch (sampleBytes) {
+        case 1: undoHorizontalPredictor<uint8_t>(raw.data(), _block.height, rowSamples, _block.samples); break;
+        case 2: undoHorizontalPredictor<uint16_t>(raw.data(), _block.height, rowSamples, _block.samples); break;
+        case 4: undoHorizontalPredictor<uint32_t>(raw.data(), _block.height, rowSamples, _block.samples); break;
+        case 8: undoHorizontalPredictor<uint64_t>(raw.data(), _block.height, rowSamples, _block.samples); break;
+        }
+    } else if (_image.predictor == 3) {
+        undoFloatPredictor(raw.data(), _block.height, rowSamples, _block.samples, sampleBytes);
+    }
+
+    if (_image.isFloat()) {
+        toFloats(_tiff, _image, raw.data(), count, _block.floats);
+    } else {
+        _block.bytes = std::move(raw);
+    }
+    return true;
+}
+
+void encodeTiff(uint32_t _width, uint32_t _height, uint16_t _samples, bool _floats, const void* _pixels,
+                std::vector<char>& _out) {
+
+    struct Entry { uint16_t tag, type; uint32_t count, value; };
+
+    uint16_t bits = _floats ? 32 : 8;
+    uint32_t dataBytes = _width * _height * _samples * (bits / 8);
+
+    std::vector<Entry> entries = {
+        { TAG_IMAGE_WIDTH, 4, 1, _width },
+        { TAG_IMAGE_LENGTH, 4, 1, _height },
+        { TAG_BITS_PER_SAMPLE, 3, _samples, bits },
+        { TAG_COMPRESSION, 3, 1, COMPRESSION_NONE },
+        // BlackIsZero or RGB
+        { TAG_PHOTOMETRIC, 3, 1, _samples >= 3 ? 2u : 1u },
+        { TAG_STRIP_OFFSETS, 4, 1, 0 },
+        { TAG_SAMPLES_PER_PIXEL, 3, 1, _samples },
+        { TAG_ROWS_PER_STRIP, 4, 1, _height },
+        { TAG_STRIP_BYTE_COUNTS, 4, 1, dataBytes },
+        { TAG_PLANAR_CONFIGURATION, 3, 1, 1 },
+    };
+    // Unassociated alpha
+    if (_samples == 4) { entries.push_back({ TAG_EXTRA_SAMPLES, 3, 1, 2 }); }
+    entries.push_back({ TAG_SAMPLE_FORMAT, 3, 1, _floats ? 3u : 1u });
+
+    // Header, directory, then the bits of each sample when they don't fit in their entry
+    uint32_t ifdBytes = 2 + uint32_t(entries.size()) * 12 + 4;
+    uint32_t bitsOffset = 8 + ifdBytes;
+    uint32_t dataOffset = bitsOffset + (_samples > 2 ? 2 * _samples : 0);
+
+    _out.resize(dataOffset + dataBytes);
+    char* p = _out.data();
+    auto put16 = [&](uint32_t _offset, uint32_t _value) {
+        p[_offset] = char(_value & 0xff);
+        p[_offset + 1] = char((_value >> 8) & 0xff);
+    };
+    auto put32 = [&](uint32_t _offset, uint32_t _value) {
+        put16(_offset, _value & 0xffff);
+        put16(_offset + 2, _value >> 16);
+    };
+
+    p[0] = p[1] = 'I';
+    put16(2, 42);
+    put32(4, 8);
+
+    uint32_t offset = 8;
+    put16(offset, uint32_t(entries.size()));
+    offset += 2;
+    for (auto& entry : entries) {
+        if (entry.tag == TAG_STRIP_OFFSETS) { entry.value = dataOffset; }
+        put16(offset, entry.tag);
+        put16(offset + 2, entry.type);
+        put32(offset + 4, entry.count);
+        if (entry.type == 4) {
+            put32(offset + 8, entry.value);
+        } else if (entry.count > 2) {
+            put32(offset + 8, bitsOffset);
+        } else {
+            // Short values are left aligned in the entry
+            put16(offset + 8, entry.value);
+            put16(offset + 10, entry.count == 2 ? entry.value : 0);
+        }
+        offset += 12;
+    }
+    put32(offset, 0);
+
+    for (uint32_t i = 0; _samples > 2 && i < _samples; i++) { put16(bitsOffset + 2 * i, bits); }
+
+    std::memcpy(p + dataOffset, _pixels, dataBytes);
+}
+
+}
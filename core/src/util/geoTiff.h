@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * Reading of tiled GeoTIFFs, e.g. Cloud-Optimized GeoTIFFs (COG), in parts
+ *
+ * parseGeoTiff() reads the image file directories (IFDs) of the full resolution image and of its
+ * overviews from the start of a file, where COGs keep them ahead of the image data; the blocks of
+ * each image can then be read by their offsets and decoded by decodeGeoTiffBlock(). Classic TIFF
+ * and BigTIFF in either byte order are read. Blocks may be uncompressed or compressed with deflate,
+ * LZW, JPEG or LERC, with horizontal or floating point predictors.
+ *
+ * Supported are images of 8 bit samples with 1, 3 or 4 samples per pixel (imagery), decoded to
+ * bytes, and of one integer or floating point sample per pixel (elevation), decoded to floats.
+ * Georeferencing must be in Web Mercator (EPSG:3857) or longitude and latitude (EPSG:4326).
+ */
+
+enum class GeoTiffCRS : uint8_t {
+    webMercator,
+    lngLat,
+};
+
+struct GeoTiffImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t blockWidth = 0;
+    uint32_t blockHeight = 0;
+
+    uint16_t samples = 1;
+    uint16_t bitsPerSample = 8;
+    // 1 unsigned or 2 signed integers, 3 floating point
+    uint16_t sampleFormat = 1;
+    uint16_t compression = 1;
+    uint16_t predictor = 1;
+    // Compression of LERC blobs: 0 none, 1 deflate, 2 zstd
+    uint16_t lercCompression = 0;
+
+    // Of the blocks in rows from the top left; blocks of size 0 have no data
+    std::vector<uint64_t> blockOffsets;
+    std::vector<uint64_t> blockSizes;
+
+    // Quantization and Huffman tables shared by the JPEG blocks
+    std::string jpegTables;
+
+    uint32_t blocksAcross() const { return (width + blockWidth - 1) / blockWidth; }
+    uint32_t blocksDown() const { return (height + blockHeight - 1) / blockHeight; }
+
+    // Whether blocks decode to floats rather than bytes
+    bool isFloat() const { return bitsPerSample != 8; }
+};
+
+struct GeoTiff {
+    // Full resolution image first, then the overviews by decreasing size
+    std::vector<GeoTiffImage> images;
+
+    GeoTiffCRS crs = GeoTiffCRS::webMercator;
+
+    // Coordinates of the upper left corner of the full resolution image and size of its pixels,
+    // in meters or degrees of the CRS
+    double originX = 0;
+    double originY = 0;
+    double pixelWidth = 0;
+    double pixelHeight = 0;
+
+    bool bigEndian = false;
+
+    // Samples of this value, e.g. of no data areas of elevation, decode to NaN
+    bool hasNoData = false;
+    double noData = 0;
+
+    // Size of the pixels of @_image in units of the CRS
+    double pixelWidthOf(const GeoTiffImage& _image) const {
+        return pixelWidth * images[0].width / _image.width;
+    }
+    double pixelHeightOf(const GeoTiffImage& _image) const {
+        return pixelHeight * images[0].height / _image.height;
+    }
+};
+
+struct GeoTiffBlock {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint16_t samples = 0;
+    // Samples in rows from the top left: bytes of 8 bit images, floats of other images with
+    // NaN for no data
+    std::vector<uint8_t> bytes;
+    std::vector<float> floats;
+
+    size_t memoryUsage() const { return bytes.capacity() + floats.capacity() * sizeof(float); }
+};
+
+enum class GeoTiffResult {
+    ok,
+    // More of the file is needed, up to the returned size
+    needMoreData,
+    invalid,
+};
+
+/* Parse the directories in the first @_size bytes @_data of a GeoTIFF into @_tiff; when they
+ * reach beyond @_size, returns needMoreData with the part of the file to read next in @_needed */
+GeoTiffResult parseGeoTiff(const char* _data, size_t _size, GeoTiff& _tiff, uint64_t& _needed);
+
+/* Decode the data @_data of a block of @_image into @_block; returns false on failure */
+bool decodeGeoTiffBlock(const GeoTiff& _tiff, const GeoTiffImage& _image, const char* _data,
+                        size_t _size, GeoTiffBlock& _block);
+
+/* Write an uncompressed TIFF of @_width x @_height pixels to @_out, as read by loadImage(): 1 or 4
+ * bytes per pixel, or 1 float if @_floats; @_pixels are in rows from the top left */
+void encodeTiff(uint32_t _width, uint32_t _height, uint16_t _samples, bool _floats,
+                const void* _pixels, std::vector<char>& _out);
+
+}
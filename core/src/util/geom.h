@@ -4,6 +4,8 @@
 #include "glm/vec4.hpp"
 #include "glm/mat4x4.hpp"
 
+#include <iterator>
+
 namespace Tangram {
 
 constexpr double PI = 3.14159265358979323846;
@@ -94,7 +96,7 @@ float signedArea(InputIt begin, InputIt end) {
 
 /// Calculate the area centroid of a closed polygon given as a sequence of vectors.
 /// If the polygon has no area, the coordinates returned are NaN.
-template<class InputIt, class Vector = typename InputIt::value_type>
+template<class InputIt, class Vector = typename std::iterator_traits<InputIt>::value_type>
 Vector centroid(InputIt begin, InputIt end) {
     Vector centroid{};
     float area = 0.f;
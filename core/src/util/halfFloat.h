@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_HALF_FLOAT_NEON
+#endif
+
+namespace Tangram {
+
+/// IEEE 754 half precision (GL_HALF_FLOAT) of a float, rounded to nearest even
+inline uint16_t floatToHalf(float _value) {
+    uint32_t bits;
+    std::memcpy(&bits, &_value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t abs = bits & 0x7FFFFFFF;
+
+    if (abs >= 0x47800000) {
+        // NaN, or infinity for values of 65536 and above
+        return sign | (abs > 0x7F800000 ? 0x7E00 : 0x7C00);
+    }
+    if (abs < 0x38800000) {
+        // Subnormal below 2^-14, in units of 2^-24
+        float a;
+        std::memcpy(&a, &abs, sizeof(a));
+        return sign | uint16_t(std::lrint(a * 16777216.f));
+    }
+    // Rebias the exponent and round the mantissa; a carry moves to the exponent, up to infinity
+    uint32_t half = (abs - 0x38000000) >> 13;
+    uint32_t rest = abs & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) { half++; }
+    return sign | uint16_t(half);
+}
+
+/// Float of an IEEE 754 half precision value
+inline float halfToFloat(uint16_t _value) {
+    uint32_t sign = uint32_t(_value & 0x8000) << 16;
+    uint32_t exponent = (_value >> 10) & 0x1F;
+    uint32_t mantissa = _value & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0) {
+        float f = mantissa * (1.f / 16777216.f);
+        std::memcpy(&bits, &f, sizeof(bits));
+        bits |= sign;
+    } else if (exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/// Convert @_count floats to half floats, eight at a time with NEON
+inline void floatsToHalfs(const float* _src, uint16_t* _dst, size_t _count) {
+    size_t i = 0;
+#ifdef TANGRAM_HALF_FLOAT_NEON
+    for (; i + 8 <= _count; i += 8) {
+        float16x8_t h = vcombine_f16(vcvt_f16_f32(vld1q_f32(_src + i)), vcvt_f16_f32(vld1q_f32(_src + i + 4)));
+        vst1q_u16(_dst + i, vreinterpretq_u16_f16(h));
+    }
+#endif
+    for (; i < _count; i++) { _dst[i] = floatToHalf(_src[i]); }
+}
+
+/// Convert @_count half floats to floats, eight at a time with NEON
+inline void halfsToFloats(const uint16_t* _src, float* _dst, size_t _count) {
+    size_t i = 0;
+#ifdef TANGRAM_HALF_FLOAT_NEON
+    for (; i + 8 <= _count; i += 8) {
+        float16x8_t h = vreinterpretq_f16_u16(vld1q_u16(_src + i));
+        vst1q_f32(_dst + i, vcvt_f32_f16(vget_low_f16(h)));
+        vst1q_f32(_dst + i + 4, vcvt_f32_f16(vget_high_f16(h)));
+    }
+#endif
+    for (; i < _count; i++) { _dst[i] = halfToFloat(_src[i]); }
+}
+
+}
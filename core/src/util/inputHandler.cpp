@@ -45,6 +45,25 @@ bool InputHandler::update(float _dt) {
     return isFlinging;
 }
 
+bool InputHandler::predictView(View& _view, float _seconds) const {
+
+    auto velocityPanPixels = m_view.pixelsPerMeter() / m_view.pixelScale() * m_velocityPan;
+
+    bool isFlinging = glm::length(velocityPanPixels) > THRESHOLD_STOP_PAN ||
+                      std::abs(m_velocityZoom) > THRESHOLD_STOP_ZOOM;
+
+    if (!isFlinging || _seconds <= 0.f) { return false; }
+
+    // integral of exponentially decaying velocity v*exp(-d*t) over [0, _seconds]
+    float panScale = (1.f - std::exp(-DAMPING_PAN * _seconds)) / DAMPING_PAN;
+    float zoomScale = (1.f - std::exp(-DAMPING_ZOOM * _seconds)) / DAMPING_ZOOM;
+
+    _view.translate(panScale * m_velocityPan.x, panScale * m_velocityPan.y);
+    _view.zoom(zoomScale * m_velocityZoom);
+
+    return true;
+}
+
 void InputHandler::handleTapGesture(float _posX, float _posY) {
     cancelFling();
 
@@ -25,6 +25,10 @@ public:
 
     void cancelFling();
 
+    // Apply to @_view the motion of the current fling over the next @_seconds;
+    // returns false if not flinging
+    bool predictView(View& _view, float _seconds) const;
+
     void setView(View& _view) { m_view = _view; }
 
 private:
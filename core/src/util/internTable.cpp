@@ -0,0 +1,67 @@
+#include "util/internTable.h"
+
+#include <cassert>
+#include <mutex>
+#include <unordered_map>
+
+namespace Tangram {
+
+namespace {
+
+struct Table {
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> atoms;
+    // strings by atom - 1, the keys of atoms
+    std::vector<const std::string*> strings;
+};
+
+Table& table() {
+    // never destroyed, atoms may be used by static objects
+    static Table* s_table = new Table();
+    return *s_table;
+}
+
+}
+
+uint32_t InternTable::intern(const std::string& _string) {
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    auto it = t.atoms.emplace(_string, uint32_t(t.strings.size() + 1));
+    if (it.second) { t.strings.push_back(&it.first->first); }
+    return it.first->second;
+}
+
+uint32_t InternTable::find(const std::string& _string) {
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    auto it = t.atoms.find(_string);
+    return it == t.atoms.end() ? NONE : it->second;
+}
+
+void InternTable::find(const std::vector<const std::string*>& _strings, std::vector<uint32_t>& _atoms) {
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    _atoms.clear();
+    _atoms.reserve(_strings.size());
+    for (const auto* string : _strings) {
+        if (!string) {
+            _atoms.push_back(NONE);
+            continue;
+        }
+        auto it = t.atoms.find(*string);
+        _atoms.push_back(it == t.atoms.end() ? NONE : it->second);
+    }
+}
+
+const std::string& InternTable::string(uint32_t _atom) {
+    Table& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    assert(_atom != NONE && _atom <= t.strings.size());
+    return *t.strings[_atom - 1];
+}
+
+}
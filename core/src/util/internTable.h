@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+/* Process-wide table of interned strings, shared by all threads
+ *
+ * An atom identifies an interned string: two strings are equal when their atoms are. Strings
+ * that are looked up repeatedly, e.g. the keys and values compared by scene filters, are
+ * interned once. Tile data only looks up its strings with find(), so that the table does not
+ * grow with the data that is loaded.
+ */
+class InternTable {
+
+public:
+
+    // Atom of no string
+    static constexpr uint32_t NONE = 0;
+
+    // Atom of @_string, interning it if it is not yet
+    static uint32_t intern(const std::string& _string);
+
+    // Atom of @_string if it is interned, else NONE
+    static uint32_t find(const std::string& _string);
+
+    // find() for each of @_strings, null strings give NONE; takes the lock once
+    static void find(const std::vector<const std::string*>& _strings, std::vector<uint32_t>& _atoms);
+
+    // String of an atom other than NONE
+    static const std::string& string(uint32_t _atom);
+};
+
+}
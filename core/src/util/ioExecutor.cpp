@@ -0,0 +1,268 @@
+#include "util/ioExecutor.h"
+
+#include "debug/trace.h"
+#include "platform.h"
+#include "tile/tileTask.h"
+
+#include <algorithm>
+
+#define IO_EXECUTOR_MAX_THREADS 4
+
+namespace Tangram {
+
+IOExecutor& IOExecutor::shared() {
+    static IOExecutor s_executor(std::max<size_t>(2, std::min<size_t>(IO_EXECUTOR_MAX_THREADS,
+                                                                       std::thread::hardware_concurrency())));
+    return s_executor;
+}
+
+IOExecutor::IOExecutor(size_t _numThreads) {
+    for (size_t i = 0; i < std::max<size_t>(_numThreads, 1); i++) {
+        m_threads.emplace_back(&IOExecutor::run, this);
+    }
+}
+
+IOExecutor::~IOExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_all();
+    for (auto& thread : m_threads) { thread.join(); }
+}
+
+// true if the task for @_a should run before the one for @_b
+static bool compareTasks(const TileTask& _a, uint64_t _seqA, const TileTask& _b, uint64_t _seqB) {
+    if (_a.isPrefetch() != _b.isPrefetch()) {
+        return !_a.isPrefetch();
+    }
+    if (_a.isProxy() != _b.isProxy()) {
+        return !_a.isProxy();
+    }
+    if (_a.getPriority() != _b.getPriority()) {
+        return _a.getPriority() < _b.getPriority();
+    }
+    return _seqA < _seqB;
+}
+
+IOExecutor::Queue* IOExecutor::takeTask(Task& _task, Clock::time_point& _wakeup, std::vector<Task>& _dropped) {
+
+    auto now = Clock::now();
+    _wakeup = Clock::time_point::max();
+
+    // plain tasks first, the earliest submitted at the front of an idle queue
+    Queue* bestQueue = nullptr;
+    for (Queue* queue : m_queues) {
+        if (queue->running) { continue; }
+
+        auto& delayed = queue->delayed;
+        while (!delayed.empty() && delayed.front().time <= now) {
+            std::pop_heap(delayed.begin(), delayed.end());
+            queue->ready.push_back({ std::move(delayed.back().func), nullptr, m_sequence++ });
+            delayed.pop_back();
+        }
+        if (!delayed.empty()) { _wakeup = std::min(_wakeup, delayed.front().time); }
+
+        if (!queue->ready.empty() &&
+            (!bestQueue || queue->ready.front().sequence < bestQueue->ready.front().sequence)) {
+            bestQueue = queue;
+        }
+    }
+
+    if (bestQueue) {
+        _task = std::move(bestQueue->ready.front());
+        bestQueue->ready.pop_front();
+        bestQueue->running = true;
+        return bestQueue;
+    }
+
+    size_t best = 0;
+    for (Queue* queue : m_queues) {
+        if (queue->running) { continue; }
+
+        auto& tasks = queue->tileTasks;
+        for (size_t i = 0; i < tasks.size();) {
+            if (tasks[i].tileTask->isCanceled()) {
+                _dropped.push_back(std::move(tasks[i]));
+                tasks[i] = std::move(tasks.back());
+                tasks.pop_back();
+                continue;
+            }
+            if (!bestQueue || compareTasks(*tasks[i].tileTask, tasks[i].sequence,
+                                           *bestQueue->tileTasks[best].tileTask,
+                                           bestQueue->tileTasks[best].sequence)) {
+                bestQueue = queue;
+                best = i;
+            }
+            i++;
+        }
+    }
+
+    if (bestQueue) {
+        auto& tasks = bestQueue->tileTasks;
+        _task = std::move(tasks[best]);
+        tasks[best] = std::move(tasks.back());
+        tasks.pop_back();
+        bestQueue->running = true;
+    }
+    return bestQueue;
+}
+
+void IOExecutor::run() {
+
+    Trace::setThreadName("IO");
+    ThreadQoS qos = ThreadQoS::interactive;
+    setCurrentThreadQoS(qos);
+    const bool switchQoS = canSwitchThreadQoS();
+
+    std::vector<Task> dropped;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        Task task;
+        Clock::time_point wakeup;
+        Queue* queue = takeTask(task, wakeup, dropped);
+
+        if (!queue && !dropped.empty()) {
+            // release captured state outside of the lock, then look again
+            lock.unlock();
+            dropped.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (!queue) {
+            if (wakeup == Clock::time_point::max()) {
+                m_condition.wait(lock);
+            } else {
+                m_condition.wait_until(lock, wakeup);
+            }
+            continue;
+        }
+
+        ThreadQoS taskQoS = queue->qos;
+        if (task.tileTask && taskQoS == ThreadQoS::interactive && task.tileTask->isPrefetch()) {
+            taskQoS = ThreadQoS::prefetch;
+        }
+
+        lock.unlock();
+        dropped.clear();
+        if (switchQoS && taskQoS != qos && setCurrentThreadQoS(taskQoS)) { qos = taskQoS; }
+        {
+            TRACE_SCOPE("io");
+            task.func();
+        }
+        task = Task();
+        lock.lock();
+
+        queue->running = false;
+        m_taskDone.notify_all();
+        // queue may have more tasks for another thread
+        m_condition.notify_one();
+    }
+}
+
+void IOExecutor::add(Queue* _queue) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queues.push_back(_queue);
+}
+
+void IOExecutor::remove(Queue* _queue) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true) {
+        if (_queue->running) {
+            m_taskDone.wait(lock);
+            continue;
+        }
+        if (!_queue->drain) { break; }
+
+        // run remaining tasks on this thread, which may itself be a pool thread, in the order
+        //  they were submitted and delayed tasks by their time
+        auto& delayed = _queue->delayed;
+        std::sort_heap(delayed.begin(), delayed.end());
+        for (auto it = delayed.rbegin(); it != delayed.rend(); ++it) {
+            _queue->ready.push_back({ std::move(it->func), nullptr, m_sequence++ });
+        }
+        delayed.clear();
+
+        auto& tasks = _queue->tileTasks;
+        auto first = std::min_element(tasks.begin(), tasks.end(),
+                                      [](auto& a, auto& b) { return a.sequence < b.sequence; });
+        Task task;
+        if (!_queue->ready.empty() &&
+            (first == tasks.end() || _queue->ready.front().sequence < first->sequence)) {
+            task = std::move(_queue->ready.front());
+            _queue->ready.pop_front();
+        } else if (first != tasks.end()) {
+            task = std::move(*first);
+            tasks.erase(first);
+        } else {
+            break;
+        }
+        _queue->running = true;
+
+        lock.unlock();
+        task.func();
+        task = Task();
+        lock.lock();
+
+        _queue->running = false;
+    }
+
+    _queue->ready.clear();
+    _queue->tileTasks.clear();
+    _queue->delayed.clear();
+    m_queues.erase(std::find(m_queues.begin(), m_queues.end(), _queue));
+}
+
+IOQueue::IOQueue(IOExecutor& _executor) : m_executor(_executor) {
+    m_executor.add(&m_queue);
+}
+
+IOQueue::~IOQueue() {
+    m_executor.remove(&m_queue);
+}
+
+void IOQueue::enqueue(std::function<void()> _task) {
+    push(std::move(_task), nullptr);
+}
+
+void IOQueue::enqueue(std::shared_ptr<TileTask> _tileTask, std::function<void()> _task) {
+    push(std::move(_task), std::move(_tileTask));
+}
+
+void IOQueue::push(std::function<void()>&& _task, std::shared_ptr<TileTask>&& _tileTask) {
+    {
+        std::lock_guard<std::mutex> lock(m_executor.m_mutex);
+        IOExecutor::Task task{ std::move(_task), std::move(_tileTask), m_executor.m_sequence++ };
+        if (task.tileTask) {
+            m_queue.tileTasks.push_back(std::move(task));
+        } else {
+            m_queue.ready.push_back(std::move(task));
+        }
+    }
+    m_executor.m_condition.notify_one();
+}
+
+void IOQueue::enqueueDelayed(std::function<void()> _task, std::chrono::milliseconds _delay) {
+    {
+        std::lock_guard<std::mutex> lock(m_executor.m_mutex);
+        auto& delayed = m_queue.delayed;
+        delayed.push_back({ IOExecutor::Clock::now() + _delay, std::move(_task) });
+        std::push_heap(delayed.begin(), delayed.end());
+    }
+    // a waiting thread may need to wake up earlier
+    m_executor.m_condition.notify_all();
+}
+
+void IOQueue::setQoS(ThreadQoS _qos) {
+    std::lock_guard<std::mutex> lock(m_executor.m_mutex);
+    m_queue.qos = _qos;
+}
+
+void IOQueue::waitForCompletion() {
+    std::lock_guard<std::mutex> lock(m_executor.m_mutex);
+    m_queue.drain = true;
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "util/threadPlacement.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tangram {
+
+class TileTask;
+
+/* Thread pool for blocking I/O shared by DataSources and other helpers
+ *
+ * Work is submitted through IOQueues: tasks of one queue run one at a time, so that a queue can
+ * own state like a database connection, while different queues run in parallel on the pool
+ * threads. An idle thread takes the best ready task of all idle queues: plain tasks first, in
+ * submission order, then tasks for TileTasks ordered like TileWorker orders them (visible before
+ * prefetch, non-proxy before proxy, then by TileTask::getPriority()). Priorities are read when a
+ * task is picked, so that updated priorities take effect for queued tasks, and tasks of canceled
+ * TileTasks are dropped without running. Delayed tasks become plain tasks once their time passed.
+ */
+class IOExecutor {
+
+public:
+
+    // Executor used by IOQueues by default, with at most four threads
+    static IOExecutor& shared();
+
+    explicit IOExecutor(size_t _numThreads);
+    ~IOExecutor();
+
+    size_t numThreads() const { return m_threads.size(); }
+
+private:
+
+    friend class IOQueue;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        std::function<void()> func;
+        std::shared_ptr<TileTask> tileTask;
+        uint64_t sequence;
+    };
+
+    struct Delayed {
+        Clock::time_point time;
+        std::function<void()> func;
+        // heap order, earliest time on top
+        bool operator<(const Delayed& _other) const { return time > _other.time; }
+    };
+
+    struct Queue {
+        // plain tasks in submission order
+        std::deque<Task> ready;
+        // tasks for TileTasks, unordered since their priorities change while queued
+        std::vector<Task> tileTasks;
+        // heap of delayed tasks
+        std::vector<Delayed> delayed;
+        bool running = false;
+        bool drain = false;
+        // Class of plain tasks; tasks for TileTasks are interactive or prefetch
+        ThreadQoS qos = ThreadQoS::interactive;
+    };
+
+    void run();
+
+    // Remove best ready task of an idle queue into @_task and tasks of canceled TileTasks into
+    //  @_dropped; m_mutex must be locked. Returns the queue, or nullptr with @_wakeup set to the
+    //  time of the next delayed task if any. Tasks for TileTasks are only looked at when no
+    //  plain task is ready
+    Queue* takeTask(Task& _task, Clock::time_point& _wakeup, std::vector<Task>& _dropped);
+
+    void add(Queue* _queue);
+    void remove(Queue* _queue);
+
+    std::vector<std::thread> m_threads;
+    std::vector<Queue*> m_queues;
+    uint64_t m_sequence = 0;
+    bool m_running = true;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    // notified when a queue finished running a task
+    std::condition_variable m_taskDone;
+};
+
+/* Serial task queue on an IOExecutor, used like AsyncWorker */
+class IOQueue {
+
+public:
+
+    explicit IOQueue(IOExecutor& _executor = IOExecutor::shared());
+
+    // Drops pending tasks - or runs them if waitForCompletion() was called - and waits for a
+    //  running task to finish, so that tasks never run after the queue is gone
+    ~IOQueue();
+
+    void enqueue(std::function<void()> _task);
+
+    // Run @_task in the order of @_tileTask; it is dropped if @_tileTask is canceled before it runs
+    void enqueue(std::shared_ptr<TileTask> _tileTask, std::function<void()> _task);
+
+    // Run @_task like a plain task enqueued once @_delay has passed; delayed tasks are run
+    //  immediately on exit if waitForCompletion() was called
+    void enqueueDelayed(std::function<void()> _task, std::chrono::milliseconds _delay);
+
+    void waitForCompletion();
+
+    // Run tasks of this queue at the priority of @_qos, e.g. background for offline downloads
+    void setQoS(ThreadQoS _qos);
+
+private:
+
+    void push(std::function<void()>&& _task, std::shared_ptr<TileTask>&& _tileTask);
+
+    IOExecutor& m_executor;
+    IOExecutor::Queue m_queue;
+};
+
+}
@@ -0,0 +1,140 @@
+#include "util/lineMerger.h"
+
+#include "data/propertyItem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace Tangram {
+
+static const uint32_t NO_END = UINT32_MAX;
+
+static uint64_t pointKey(const Point& _point) {
+    uint32_t x, y;
+    std::memcpy(&x, &_point.x, sizeof(x));
+    std::memcpy(&y, &_point.y, sizeof(y));
+    return (uint64_t(x) << 32) | y;
+}
+
+bool LineMerger::merge(Span<Feature> _features, const std::vector<std::string>& _keys,
+                       std::vector<Feature>& _merged, std::vector<bool>& _fragments) {
+
+    _fragments.assign(_features.size(), false);
+    if (_keys.empty()) { return false; }
+
+    for (auto& group : m_groups) { group.second.clear(); }
+
+    std::string values;
+    for (size_t i = 0; i < _features.size(); i++) {
+        const auto& feature = _features[i];
+        if (feature.geometryType != GeometryType::lines || feature.ringEnds.empty()) { continue; }
+
+        values.clear();
+        bool empty = true;
+        for (const auto& key : _keys) {
+            std::string value = feature.props.getAsString(key);
+            empty &= value.empty();
+            values += value;
+            values += '\0';
+        }
+        if (!empty) { m_groups[values].push_back(uint32_t(i)); }
+    }
+
+    // in the order of the features, so that the order of labels does not change between builds
+    m_order.clear();
+    for (auto& group : m_groups) {
+        if (group.second.size() >= 2) { m_order.push_back(&group.second); }
+    }
+    std::sort(m_order.begin(), m_order.end(), [](auto* a, auto* b) { return a->front() < b->front(); });
+
+    bool merged = false;
+    for (auto* group : m_order) {
+        m_lines.clear();
+        for (uint32_t index : *group) {
+            for (auto line : _features[index].lines()) {
+                if (line.size() >= 2) { m_lines.push_back(line); }
+            }
+        }
+
+        Feature feature(_features[group->front()].props.sourceId);
+        if (!joinLines(feature)) { continue; }
+
+        feature.geometryType = GeometryType::lines;
+        feature.props = _features[group->front()].props;
+        _merged.push_back(std::move(feature));
+
+        for (uint32_t index : *group) { _fragments[index] = true; }
+        merged = true;
+    }
+
+    // Keep the groups of a large tile from growing the map for the next one
+    if (m_groups.size() > 1024) { m_groups.clear(); }
+
+    return merged;
+}
+
+bool LineMerger::joinLines(Feature& _feature) {
+
+    m_nodes.clear();
+    for (uint32_t line = 0; line < m_lines.size(); line++) {
+        for (uint32_t end : { 2 * line, 2 * line + 1 }) {
+            const Point& point = (end & 1) ? m_lines[line].back() : m_lines[line].front();
+            auto& node = m_nodes[pointKey(point)];
+            if (node.count < 2) { node.ends[node.count] = end; }
+            node.count++;
+        }
+    }
+
+    // The end that meets @_end, if no other does
+    auto partner = [&](uint32_t _end) {
+        const auto& line = m_lines[_end >> 1];
+        const auto& node = m_nodes[pointKey((_end & 1) ? line.back() : line.front())];
+        if (node.count != 2) { return NO_END; }
+        uint32_t other = node.ends[0] == _end ? node.ends[1] : node.ends[0];
+        // closed lines are not joined to themselves
+        return (other >> 1) == (_end >> 1) ? NO_END : other;
+    };
+
+    bool joined = false;
+    m_visited.assign(m_lines.size(), 0);
+
+    for (uint32_t line = 0; line < m_lines.size(); line++) {
+        if (m_visited[line]) { continue; }
+
+        // Walk back to the first line of the chain; its start is the end that the chain starts at
+        uint32_t start = 2 * line;
+        for (size_t steps = 0; steps < m_lines.size(); steps++) {
+            uint32_t other = partner(start);
+            if (other == NO_END || m_visited[other >> 1] || (other >> 1) == line) { break; }
+            start = other ^ 1;
+        }
+
+        // Follow the chain, reversing the lines that it runs through backwards
+        bool first = true;
+        while (true) {
+            uint32_t index = start >> 1;
+            const auto& points = m_lines[index];
+            m_visited[index] = 1;
+
+            size_t skip = first ? 0 : 1;
+            if (start & 1) {
+                std::reverse_iterator<const Point*> begin(points.end()), end(points.begin());
+                _feature.coordinates.insert(_feature.coordinates.end(), begin + skip, end);
+            } else {
+                _feature.coordinates.insert(_feature.coordinates.end(), points.begin() + skip, points.end());
+            }
+            first = false;
+
+            uint32_t next = partner(start ^ 1);
+            if (next == NO_END || m_visited[next >> 1]) { break; }
+            start = next;
+            joined = true;
+        }
+        _feature.endLine();
+    }
+
+    return joined;
+}
+
+}
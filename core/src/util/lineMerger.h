@@ -0,0 +1,55 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * LineMerger - Joins the line features of a tile that belong together, e.g. the fragments of a
+ * road with the same name and kind, where their ends meet, so that labels are placed on the
+ * whole road instead of on each fragment
+ *
+ * Lines are only joined at points where exactly two of them end, so that branches are not
+ * followed; a merged line may reverse the direction of some fragments. A merged feature has
+ * the properties of its first fragment.
+ */
+class LineMerger {
+
+public:
+
+    /* Merge the line features of @_features that have the same values of @_keys, not all
+     * empty, into one feature each in @_merged. Sets @_fragments for the features that are
+     * part of a merged feature; features with no line to join are not merged. Returns whether
+     * any feature was. */
+    bool merge(Span<Feature> _features, const std::vector<std::string>& _keys,
+               std::vector<Feature>& _merged, std::vector<bool>& _fragments);
+
+private:
+
+    // Join the lines of m_lines into @_feature; false if none meet
+    bool joinLines(Feature& _feature);
+
+    // Features of each group, by the values of the keys
+    std::unordered_map<std::string, std::vector<uint32_t>> m_groups;
+    // Groups of more than one feature, by their first feature
+    std::vector<std::vector<uint32_t>*> m_order;
+
+    // Lines of the current group; their ends are numbered 2 * line (start) and 2 * line + 1
+    std::vector<LineView> m_lines;
+
+    // The ends that meet at a point, if only two do
+    struct Node {
+        uint32_t ends[2];
+        uint32_t count = 0;
+    };
+    std::unordered_map<uint64_t, Node> m_nodes;
+
+    std::vector<uint8_t> m_visited;
+};
+
+}
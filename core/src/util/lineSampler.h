@@ -7,8 +7,8 @@ namespace Tangram {
 template<typename Points>
 struct LineSampler {
 
-    template<typename T>
-    void set(std::vector<T> _points) {
+    template<typename Line>
+    void set(const Line& _points) {
         m_points.clear();
 
         if (_points.empty()) { return; }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace Tangram {
+
+/* Time threads spent waiting for a mutex held by another thread
+ *
+ * Locks taken with lockTimed() only read the clock when the mutex is contended, so the counters
+ * can stay on in release builds; they are reported e.g. by TileWorker::stats().
+ */
+struct LockStats {
+    std::atomic<uint32_t> waits{0};
+    std::atomic<uint64_t> micros{0};
+
+    float waitTime() const { return micros / 1000.f; }
+
+    void reset() { waits = 0; micros = 0; }
+};
+
+/* Lock @_mutex, adding the time waited to @_stats when it is held by another thread */
+template<class Mutex>
+std::unique_lock<Mutex> lockTimed(Mutex& _mutex, LockStats& _stats) {
+    std::unique_lock<Mutex> lock(_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        auto end = std::chrono::steady_clock::now();
+        ++_stats.waits;
+        _stats.micros += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+    return lock;
+}
+
+}
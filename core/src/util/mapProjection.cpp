@@ -1,5 +1,16 @@
 #include "mapProjection.h"
 
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TANGRAM_PROJECTION_SIMD
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TANGRAM_PROJECTION_SIMD
+#define TANGRAM_PROJECTION_NEON
+#endif
+
 namespace Tangram {
 
 ProjectedMeters MapProjection::lngLatToProjectedMeters(LngLat lngLat) {
@@ -16,6 +27,184 @@ LngLat MapProjection::projectedMetersToLngLat(ProjectedMeters meters) {
     return lngLat;
 }
 
+#ifdef TANGRAM_PROJECTION_SIMD
+namespace {
+
+static_assert(sizeof(LngLat) == 2 * sizeof(double) && sizeof(ProjectedMeters) == 2 * sizeof(double),
+              "Points are loaded as pairs of doubles");
+
+// The coordinates of two points
+struct Lanes {
+#ifdef TANGRAM_PROJECTION_NEON
+    float64x2_t v;
+#else
+    __m128d v;
+#endif
+};
+
+#ifdef TANGRAM_PROJECTION_NEON
+inline Lanes splat(double _d) { return { vdupq_n_f64(_d) }; }
+inline Lanes operator+(Lanes _a, Lanes _b) { return { vaddq_f64(_a.v, _b.v) }; }
+inline Lanes operator-(Lanes _a, Lanes _b) { return { vsubq_f64(_a.v, _b.v) }; }
+inline Lanes operator*(Lanes _a, Lanes _b) { return { vmulq_f64(_a.v, _b.v) }; }
+inline Lanes operator/(Lanes _a, Lanes _b) { return { vdivq_f64(_a.v, _b.v) }; }
+inline Lanes vsqrt(Lanes _a) { return { vsqrtq_f64(_a.v) }; }
+inline Lanes vround(Lanes _a) { return { vrndnq_f64(_a.v) }; }
+// Unbiased exponents of positive normal numbers
+inline Lanes exponent(Lanes _a) {
+    int64x2_t bits = vreinterpretq_s64_u64(vshrq_n_u64(vreinterpretq_u64_f64(_a.v), 52));
+    return { vsubq_f64(vcvtq_f64_s64(bits), vdupq_n_f64(1023)) };
+}
+// 2^n of small integers
+inline Lanes pow2(Lanes _n) {
+    int64x2_t bits = vaddq_s64(vcvtq_s64_f64(_n.v), vdupq_n_s64(1023));
+    return { vreinterpretq_f64_s64(vshlq_n_s64(bits, 52)) };
+}
+// Split the x and y of two points
+inline void load(const double* _points, Lanes& _x, Lanes& _y) {
+    float64x2x2_t xy = vld2q_f64(_points);
+    _x = { xy.val[0] };
+    _y = { xy.val[1] };
+}
+inline void store(double* _points, Lanes _x, Lanes _y) {
+    float64x2x2_t xy = {{ _x.v, _y.v }};
+    vst2q_f64(_points, xy);
+}
+#else
+inline Lanes splat(double _d) { return { _mm_set1_pd(_d) }; }
+inline Lanes operator+(Lanes _a, Lanes _b) { return { _mm_add_pd(_a.v, _b.v) }; }
+inline Lanes operator-(Lanes _a, Lanes _b) { return { _mm_sub_pd(_a.v, _b.v) }; }
+inline Lanes operator*(Lanes _a, Lanes _b) { return { _mm_mul_pd(_a.v, _b.v) }; }
+inline Lanes operator/(Lanes _a, Lanes _b) { return { _mm_div_pd(_a.v, _b.v) }; }
+inline Lanes vsqrt(Lanes _a) { return { _mm_sqrt_pd(_a.v) }; }
+inline Lanes vround(Lanes _a) { return { _mm_cvtepi32_pd(_mm_cvtpd_epi32(_a.v)) }; }
+inline Lanes exponent(Lanes _a) {
+    __m128i bits = _mm_srli_epi64(_mm_castpd_si128(_a.v), 52);
+    __m128i exponents = _mm_shuffle_epi32(bits, _MM_SHUFFLE(3, 1, 2, 0));
+    return { _mm_sub_pd(_mm_cvtepi32_pd(exponents), _mm_set1_pd(1023)) };
+}
+inline Lanes pow2(Lanes _n) {
+    __m128i bits = _mm_add_epi32(_mm_cvtpd_epi32(_n.v), _mm_set1_epi32(1023));
+    bits = _mm_unpacklo_epi32(bits, _mm_setzero_si128());
+    return { _mm_castsi128_pd(_mm_slli_epi64(bits, 52)) };
+}
+inline void load(const double* _points, Lanes& _x, Lanes& _y) {
+    __m128d a = _mm_loadu_pd(_points);
+    __m128d b = _mm_loadu_pd(_points + 2);
+    _x = { _mm_unpacklo_pd(a, b) };
+    _y = { _mm_unpackhi_pd(a, b) };
+}
+inline void store(double* _points, Lanes _x, Lanes _y) {
+    _mm_storeu_pd(_points, _mm_unpacklo_pd(_x.v, _y.v));
+    _mm_storeu_pd(_points + 2, _mm_unpackhi_pd(_x.v, _y.v));
+}
+#endif
+
+// Polynomial with @_coefficients from the highest power down
+template<size_t N>
+inline Lanes horner(Lanes _x, const double (&_coefficients)[N]) {
+    Lanes p = splat(_coefficients[0]);
+    for (size_t i = 1; i < N; i++) { p = p * _x + splat(_coefficients[i]); }
+    return p;
+}
+
+constexpr double SQRT2 = 1.41421356237309504880;
+constexpr double LN2 = 0.693147180559945309417;
+// LN2 split so that n * LN2_HI is exact for small n
+constexpr double LN2_HI = 6.93147180369123816490e-01;
+constexpr double LN2_LO = 1.90821492927058770002e-10;
+
+// Taylor series of sin(x)/x in x^2, below 1e-14 off for |x| within MAX_LATITUDE_DEGREES
+constexpr double SIN[] = { 1.0 / 355687428096000.0, -1.0 / 1307674368000.0, 1.0 / 6227020800.0,
+                           -1.0 / 39916800.0, 1.0 / 362880.0, -1.0 / 5040.0, 1.0 / 120.0,
+                           -1.0 / 6.0, 1.0 };
+// atanh(t)/t in t^2, for |t| < 3 - 2 sqrt(2)
+constexpr double ATANH[] = { 1.0 / 15.0, 1.0 / 13.0, 1.0 / 11.0, 1.0 / 9.0, 1.0 / 7.0, 1.0 / 5.0,
+                             1.0 / 3.0, 1.0 };
+// atan(t)/t in t^2, below 1e-12 off for |t| < 0.39
+constexpr double ATAN[] = { 1.0 / 25.0, -1.0 / 23.0, 1.0 / 21.0, -1.0 / 19.0, 1.0 / 17.0, -1.0 / 15.0,
+                            1.0 / 13.0, -1.0 / 11.0, 1.0 / 9.0, -1.0 / 7.0, 1.0 / 5.0, -1.0 / 3.0, 1.0 };
+// exp(r) for |r| < LN2 / 2
+constexpr double EXP[] = { 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0, 1.0 / 362880.0,
+                           1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0, 1.0 / 24.0,
+                           1.0 / 6.0, 0.5, 1.0, 1.0 };
+
+// Mercator y of latitudes within MAX_LATITUDE_DEGREES: R/2 * log((1 + sin(lat)) / (1 - sin(lat)))
+Lanes mercatorY(Lanes _latitude) {
+    Lanes x = _latitude * splat(PI / 180.0);
+    Lanes sine = x * horner(x * x, SIN);
+    Lanes q = (splat(1.0) + sine) / (splat(1.0) - sine);
+
+    // q = m * 2^e with m in [sqrt(1/2), sqrt(2)), log(m) = 2 atanh((m - 1) / (m + 1))
+    Lanes e = exponent(q * splat(SQRT2));
+    Lanes m = q * pow2(splat(0.0) - e);
+    Lanes t = (m - splat(1.0)) / (m + splat(1.0));
+    Lanes logQ = e * splat(LN2) + splat(2.0) * t * horner(t * t, ATANH);
+
+    return logQ * splat(MapProjection::EARTH_RADIUS_METERS * 0.5);
+}
+
+// Latitudes of Mercator y within EARTH_HALF_CIRCUMFERENCE_METERS: 2 atan(tanh(y / 2R))
+Lanes mercatorLatitude(Lanes _y) {
+    Lanes u = _y * splat(1.0 / MapProjection::EARTH_RADIUS_METERS);
+
+    // exp(u) = 2^n * exp(r) with |r| < LN2 / 2
+    Lanes n = vround(u * splat(1.0 / LN2));
+    Lanes r = u - n * splat(LN2_HI) - n * splat(LN2_LO);
+    Lanes w = pow2(n) * horner(r, EXP);
+
+    // The latitude is 2 atan(t) with t = (w - 1) / (w + 1); halving the angle, it is 4 atan(h)
+    // with h = t / (1 + sqrt(1 + t^2)), i.e. |h| < tan(MAX_LATITUDE_DEGREES / 4)
+    Lanes h = (w - splat(1.0)) / (w + splat(1.0) + vsqrt(splat(2.0) * (w * w + splat(1.0))));
+    Lanes latitude = splat(4.0) * h * horner(h * h, ATAN);
+
+    return latitude * splat(180.0 / PI);
+}
+
+}
+#endif
+
+void MapProjection::lngLatToProjectedMeters(const LngLat* _lngLats, ProjectedMeters* _meters, size_t _count) {
+    size_t i = 0;
+#ifdef TANGRAM_PROJECTION_SIMD
+    for (; i + 2 <= _count; i += 2) {
+        // Points beyond the latitudes of the map are projected as before, e.g. to infinity at the poles
+        if (!(std::abs(_lngLats[i].latitude) <= MAX_LATITUDE_DEGREES &&
+              std::abs(_lngLats[i + 1].latitude) <= MAX_LATITUDE_DEGREES)) {
+            _meters[i] = lngLatToProjectedMeters(_lngLats[i]);
+            _meters[i + 1] = lngLatToProjectedMeters(_lngLats[i + 1]);
+            continue;
+        }
+        Lanes longitude, latitude;
+        load(&_lngLats[i].longitude, longitude, latitude);
+        store(&_meters[i].x, longitude * splat(EARTH_HALF_CIRCUMFERENCE_METERS / 180.0), mercatorY(latitude));
+    }
+#endif
+    for (; i < _count; i++) {
+        _meters[i] = lngLatToProjectedMeters(_lngLats[i]);
+    }
+}
+
+void MapProjection::projectedMetersToLngLat(const ProjectedMeters* _meters, LngLat* _lngLats, size_t _count) {
+    size_t i = 0;
+#ifdef TANGRAM_PROJECTION_SIMD
+    for (; i + 2 <= _count; i += 2) {
+        if (!(std::abs(_meters[i].y) <= EARTH_HALF_CIRCUMFERENCE_METERS &&
+              std::abs(_meters[i + 1].y) <= EARTH_HALF_CIRCUMFERENCE_METERS)) {
+            _lngLats[i] = projectedMetersToLngLat(_meters[i]);
+            _lngLats[i + 1] = projectedMetersToLngLat(_meters[i + 1]);
+            continue;
+        }
+        Lanes x, y;
+        load(&_meters[i].x, x, y);
+        store(&_lngLats[i].longitude, x * splat(180.0 / EARTH_HALF_CIRCUMFERENCE_METERS), mercatorLatitude(y));
+    }
+#endif
+    for (; i < _count; i++) {
+        _lngLats[i] = projectedMetersToLngLat(_meters[i]);
+    }
+}
+
 ProjectedMeters MapProjection::tileCoordinatesToProjectedMeters(TileCoordinates tileCoordinates) {
     double metersPerTile = metersPerTileAtZoom(tileCoordinates.z);
     ProjectedMeters projectedMeters;
@@ -67,6 +67,13 @@ public:
 
     static LngLat projectedMetersToLngLat(ProjectedMeters meters);
 
+    // Project @_count points of @_lngLats into @_meters, with SIMD where available; within 1 cm of
+    // lngLatToProjectedMeters() for each point, or equal to it beyond MAX_LATITUDE_DEGREES
+    static void lngLatToProjectedMeters(const LngLat* _lngLats, ProjectedMeters* _meters, size_t _count);
+
+    // Inverse of the above, within 1e-9 degrees of projectedMetersToLngLat() for each point
+    static void projectedMetersToLngLat(const ProjectedMeters* _meters, LngLat* _lngLats, size_t _count);
+
     static ProjectedMeters tileCoordinatesToProjectedMeters(TileCoordinates tileCoordinates);
 
     static ProjectedMeters tileSouthWestCorner(TileID tile);
@@ -0,0 +1,108 @@
+#include "util/mappedFile.h"
+
+#include "log.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Tangram {
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& _path) {
+    close();
+
+    HANDLE file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        uint64_t(size.QuadPart) > uint64_t(SIZE_MAX)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        LOGW("Cannot map file: %s", _path.c_str());
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) { UnmapViewOfFile(m_data); }
+    if (m_mapping) { CloseHandle(m_mapping); }
+    if (m_file) { CloseHandle(m_file); }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::adviseRandom() const {}
+
+#else
+
+bool MappedFile::open(const std::string& _path) {
+    close();
+
+    int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || uint64_t(st.st_size) > uint64_t(SIZE_MAX)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        LOGW("Cannot map file: %s", _path.c_str());
+        return false;
+    }
+
+    m_data = static_cast<const char*>(data);
+    m_size = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) { munmap(const_cast<char*>(m_data), m_size); }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::adviseRandom() const {
+    if (m_data) { madvise(const_cast<char*>(m_data), m_size, MADV_RANDOM); }
+}
+
+#endif
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Tangram {
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+
+public:
+
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map file at @_path; returns false if the file cannot be opened or mapped (e.g. when
+    //  it is larger than the address space)
+    bool open(const std::string& _path);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    // Hint that the range will be read randomly, so that the OS does not read ahead
+    void adviseRandom() const;
+
+private:
+
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,200 @@
+#include "util/memoryGovernor.h"
+
+#include "data/rasterSource.h"
+#include "data/tileData.h"
+#include "data/tileDataCache.h"
+#include "data/tileSource.h"
+#include "gl/glyphTexture.h"
+#include "js/JavaScript.h"
+#include "marker/marker.h"
+#include "marker/markerManager.h"
+#include "mapContext.h"
+#include "scene/scene.h"
+#include "style/style.h"
+#include "text/fontContext.h"
+#include "tile/tileCache.h"
+#include "tile/tileManager.h"
+#include "util/pixelBufferPool.h"
+
+#include <numeric>
+#include <unordered_set>
+
+namespace Tangram {
+
+static TileDataCache* parsedTileCache(Scene& _scene) {
+    return _scene.mapContext() ? _scene.mapContext()->tileDataCache().get() : nullptr;
+}
+
+MemoryGovernor::~MemoryGovernor() {
+    releaseShare();
+}
+
+void MemoryGovernor::releaseShare() {
+    if (auto cache = m_sharedCache.lock()) { cache->removeShare(this); }
+    m_sharedCache.reset();
+}
+
+size_t MemoryGovernor::Usage::total() const {
+    return std::accumulate(bytes.begin(), bytes.end(), size_t(0));
+}
+
+void MemoryGovernor::setWeight(Subsystem _cache, float _weight) {
+    if (_cache != tileCache && _cache != dataCache && _cache != tileDataCache) { return; }
+    m_weights[_cache] = std::max(_weight, 0.f);
+}
+
+MemoryGovernor::Usage MemoryGovernor::measure(Scene& _scene) const {
+    Usage usage;
+
+    // TileData is shared by tiles of one data tile and by the overzoom cache
+    std::unordered_set<const TileData*> counted;
+    auto addTileData = [&](const TileData& _tileData) {
+        if (counted.insert(&_tileData).second) { usage.bytes[tileData] += _tileData.memoryUsage(); }
+    };
+    auto addTile = [&](const Tile& _tile) {
+        if (_tile.tileData()) { addTileData(*_tile.tileData()); }
+        usage.bytes[selection] += _tile.getSelectionMemoryUsage();
+    };
+
+    auto& tileManager = *_scene.tileManager();
+    for (const auto& tile : tileManager.getVisibleTiles()) {
+        usage.bytes[tiles] += tile->getMemoryUsage();
+        addTile(*tile);
+    }
+    usage.bytes[tileCache] = tileManager.getTileCache()->getMemoryUsage();
+    tileManager.getTileCache()->forEach(addTile);
+
+    for (const auto& source : _scene.tileSources()) {
+        usage.bytes[dataCache] += source->dataCacheUsage();
+        source->forEachTileData(addTileData);
+        if (source->isRaster()) {
+            auto& rasterSource = static_cast<RasterSource&>(*source);
+            usage.bytes[rasters] += rasterSource.textureMemoryUsage();
+            usage.bytes[rasterBuffers] += rasterSource.textureBufferUsage();
+        }
+    }
+    usage.bytes[rasterBuffers] += PixelBufferPool::pooledBytes();
+
+    // only what is not held by the tiles and sources above
+    if (auto* cache = parsedTileCache(_scene)) {
+        cache->forEach([&](const TileData& _tileData) {
+            if (counted.insert(&_tileData).second) {
+                usage.bytes[tileDataCache] += _tileData.memoryUsage();
+            }
+        });
+    }
+
+    if (_scene.fontContext()) {
+        // CPU buffer and GPU texture
+        size_t textureBytes = 2 * GlyphTexture::size * GlyphTexture::size;
+        usage.bytes[glyphs] = _scene.fontContext()->glyphTextureCount() * textureBytes;
+    }
+
+    for (const auto& marker : _scene.markerManager()->markers()) {
+        if (marker->mesh()) { usage.bytes[markers] += marker->mesh()->bufferSize(); }
+    }
+
+    usage.bytes[js] = JSContext::heapBytes();
+    usage.bytes[sceneConfig] = _scene.configMemoryUsage();
+    return usage;
+}
+
+const MemoryGovernor::Usage& MemoryGovernor::update(Scene& _scene) {
+
+    m_usage = measure(_scene);
+
+    if (m_budget == 0) {
+        // the shared cache returns to the size configured for the MapContext
+        releaseShare();
+        restoreCacheSizes(_scene);
+        return m_usage;
+    }
+
+    size_t inUse = m_usage.total() - m_usage.bytes[tileCache] - m_usage.bytes[dataCache] -
+        m_usage.bytes[tileDataCache];
+    size_t available = m_budget > inUse ? m_budget - inUse : 0;
+
+    float weights = m_weights[tileCache] + m_weights[dataCache] + m_weights[tileDataCache];
+    if (weights <= 0.f) { return m_usage; }
+
+    auto* tileManager = _scene.tileManager();
+    if (tileManager != m_tileManager) {
+        m_tileManager = tileManager;
+        m_tileCacheSize = tileManager->getCacheSize();
+    }
+    auto tileCacheSize = size_t(available * (m_weights[tileCache] / weights));
+    tileManager->setCacheSize(tileCacheSize);
+
+    // the share of this Map, added up with those of the other Maps sharing the cache
+    auto cache = _scene.mapContext() ? _scene.mapContext()->tileDataCache() : nullptr;
+    if (cache != m_sharedCache.lock()) { releaseShare(); }
+    if (cache) {
+        cache->setShare(this, size_t(available * (m_weights[tileDataCache] / weights)));
+        m_sharedCache = cache;
+    }
+
+    auto& sources = _scene.tileSources();
+    if (!sources.empty()) {
+        // sources of previous Scenes are gone
+        for (auto it = m_dataCacheSizes.begin(); it != m_dataCacheSizes.end();) {
+            if (it->first.expired()) { it = m_dataCacheSizes.erase(it); } else { ++it; }
+        }
+        auto dataCacheSize = size_t(available * (m_weights[dataCache] / weights)) / sources.size();
+        for (const auto& source : sources) {
+            m_dataCacheSizes.emplace(source, source->dataCacheSize());
+            source->setDataCacheSize(dataCacheSize);
+        }
+    }
+    return m_usage;
+}
+
+void MemoryGovernor::restoreCacheSizes(Scene& _scene) {
+    if (m_tileManager && m_tileManager == _scene.tileManager()) {
+        m_tileManager->setCacheSize(m_tileCacheSize);
+    }
+    m_tileManager = nullptr;
+
+    for (const auto& source : _scene.tileSources()) {
+        auto it = m_dataCacheSizes.find(source);
+        if (it != m_dataCacheSizes.end()) { source->setDataCacheSize(it->second); }
+    }
+    m_dataCacheSizes.clear();
+}
+
+void MemoryGovernor::trim(Scene& _scene, MemoryWarningLevel _level) {
+
+    auto& tileManager = *_scene.tileManager();
+    auto& cache = *tileManager.getTileCache();
+    auto* parsedCache = parsedTileCache(_scene);
+
+    switch (_level) {
+    case MemoryWarningLevel::moderate:
+        cache.trim(cache.getMemoryUsage() / 2);
+        if (parsedCache) { parsedCache->trim(parsedCache->memoryUsage() / 2); }
+        for (const auto& source : _scene.tileSources()) {
+            source->trimDataCache(source->dataCacheUsage() / 2);
+            if (source->isRaster()) {
+                auto& rasterSource = static_cast<RasterSource&>(*source);
+                rasterSource.trimTextureCache(rasterSource.textureCache().maxUnusedBytes() / 2);
+            }
+        }
+        break;
+    case MemoryWarningLevel::critical:
+        cache.trim(0);
+        if (parsedCache) { parsedCache->trim(0); }
+        for (const auto& source : _scene.tileSources()) {
+            source->trimDataCache(0);
+            if (source->isRaster()) { static_cast<RasterSource&>(*source).trimTextureCache(0); }
+        }
+        PixelBufferPool::clear();
+        break;
+    case MemoryWarningLevel::complete:
+        tileManager.clearTileSets(true);
+        if (_scene.fontContext()) { _scene.fontContext()->releaseFonts(); }
+        break;
+    }
+
+    m_usage = measure(_scene);
+}
+
+}
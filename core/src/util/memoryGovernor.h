@@ -0,0 +1,101 @@
+#pragma once
+
+#include "map.h"
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <memory>
+
+namespace Tangram {
+
+class Scene;
+class TileDataCache;
+class TileManager;
+class TileSource;
+
+/* Single memory budget across the memory consumers of a Scene
+ *
+ * Memory held by visible content - tiles in use, their parsed data and selection properties,
+ * raster textures, glyph textures, marker meshes, JS heaps and the scene configuration - counts
+ * against the budget but is not limited. The rest of the budget is split between the caches
+ * (built tiles, raw tile data and parsed tile data) by their weights.
+ *
+ * Sizes are reported by the owners of the memory; parsed data and properties are estimates.
+ *
+ * The parsed tile cache is shared by the Maps of a MapContext: it keeps the sum of the shares
+ * of their governors, or the size configured for the MapContext while no budget is set. The
+ * other caches get back the sizes they had before the budget when it is set back to 0.
+ */
+class MemoryGovernor {
+
+public:
+
+    MemoryGovernor() = default;
+    ~MemoryGovernor();
+
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    enum Subsystem {
+        tiles,          // built tiles in use
+        tileCache,      // built tiles cached by TileManager
+        dataCache,      // raw tile data cached by MemoryCacheDataSources
+        tileDataCache,  // parsed TileData cached by the MapContext and not counted in tileData
+        tileData,       // parsed TileData of built tiles and of TileSources for overzooming
+        selection,      // selection properties of built tiles
+        rasters,        // GPU textures of RasterSources
+        rasterBuffers,  // pixel data of raster textures on the CPU and pooled pixel buffers
+        glyphs,         // glyph textures of FontContext
+        markers,        // marker meshes
+        js,             // heaps of the JS contexts of all Scenes
+        sceneConfig,    // YAML scene configuration
+        numSubsystems
+    };
+
+    struct Usage {
+        std::array<size_t, numSubsystems> bytes{};
+        size_t total() const;
+    };
+
+    /* @_bytes: budget for all subsystems; 0 disables limiting of caches */
+    void setBudget(size_t _bytes) { m_budget = _bytes; }
+    size_t budget() const { return m_budget; }
+
+    /* Relative share of cache budget for tileCache, dataCache or tileDataCache */
+    void setWeight(Subsystem _cache, float _weight);
+
+    /* Measure memory usage of @_scene and, if a budget is set, apply the cache limits */
+    const Usage& update(Scene& _scene);
+
+    /* Free memory in response to a platform memory warning */
+    void trim(Scene& _scene, MemoryWarningLevel _level);
+
+    const Usage& usage() const { return m_usage; }
+
+private:
+
+    Usage measure(Scene& _scene) const;
+
+    // Withdraw the share of the budget given to m_sharedCache
+    void releaseShare();
+
+    // Give the caches of @_scene back the sizes they had before the budget
+    void restoreCacheSizes(Scene& _scene);
+
+    size_t m_budget = 0;
+
+    // Parsed tile cache holding a share of the budget
+    std::weak_ptr<TileDataCache> m_sharedCache;
+
+    // Sizes of the caches from before the budget
+    TileManager* m_tileManager = nullptr;
+    size_t m_tileCacheSize = 0;
+    std::map<std::weak_ptr<TileSource>, size_t, std::owner_less<std::weak_ptr<TileSource>>> m_dataCacheSizes;
+
+    std::array<float, numSubsystems> m_weights{{ 0.f, 2.f, 1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f }};
+
+    Usage m_usage;
+};
+
+}
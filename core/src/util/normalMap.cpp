@@ -0,0 +1,116 @@
+#include "util/normalMap.h"
+
+#include "util/mapProjection.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+ElevationEdges::ElevationEdges(const float* _grid, int _width, int _height)
+    : width(_width), height(_height) {
+    south.assign(_grid, _grid + _width);
+    north.assign(_grid + size_t(_height - 1) * _width, _grid + size_t(_height) * _width);
+    west.resize(_height);
+    east.resize(_height);
+    for (int y = 0; y < _height; y++) {
+        west[y] = _grid[size_t(y) * _width];
+        east[y] = _grid[size_t(y) * _width + _width - 1];
+    }
+}
+
+NeighborEdges ElevationEdgeCache::add(TileID _tileId, std::shared_ptr<const ElevationEdges> _edges) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    TileID id(_tileId.x, _tileId.y, _tileId.z);
+    m_edges[id] = _edges;
+
+    if (m_edges.size() > m_pruneSize) {
+        for (auto it = m_edges.begin(); it != m_edges.end();) {
+            if (it->second.expired()) { it = m_edges.erase(it); }
+            else { ++it; }
+        }
+        m_pruneSize = std::max(size_t(64), m_edges.size() * 2);
+    }
+
+    auto find = [&](int32_t _x, int32_t _y) -> std::shared_ptr<const ElevationEdges> {
+        int32_t tiles = 1 << id.z;
+        if (_y < 0 || _y >= tiles) { return nullptr; }
+        // Wrap around the antimeridian
+        auto it = m_edges.find(TileID((_x + tiles) % tiles, _y, id.z));
+        return it != m_edges.end() ? it->second.lock() : nullptr;
+    };
+
+    // Tile rows count from the north
+    return { find(id.x, id.y - 1), find(id.x, id.y + 1), find(id.x - 1, id.y), find(id.x + 1, id.y) };
+}
+
+void ElevationEdgeCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_edges.clear();
+}
+
+// Elevation just outside one side of the grid: the facing edge of the neighbor if it matches in size,
+// otherwise extrapolated linearly from the two outermost lines of the grid
+static void outerLine(const ElevationEdges* _neighbor, const std::vector<float> ElevationEdges::* _facing,
+                      const float* _edge, const float* _inner, int _count, int _stride, float* _out) {
+    if (_neighbor && int((_neighbor->*_facing).size()) == _count) {
+        std::copy_n((_neighbor->*_facing).begin(), _count, _out);
+        return;
+    }
+    for (int i = 0; i < _count; i++) {
+        _out[i] = 2.f * _edge[i * _stride] - _inner[i * _stride];
+    }
+}
+
+void computeNormalMap(const float* _grid, int _width, int _height, TileID _tileId,
+                      const NeighborEdges& _neighbors, uint8_t* _normals) {
+
+    const int w = _width, h = _height;
+    if (w < 2 || h < 2) {
+        for (size_t i = 0; i < size_t(w) * h; i++) {
+            uint8_t* p = &_normals[i * 4];
+            p[0] = 128; p[1] = 128; p[2] = 255; p[3] = 255;
+        }
+        return;
+    }
+
+    // Neighbors must agree in size along the shared edge
+    std::vector<float> south(w), north(w), west(h), east(h);
+    outerLine(_neighbors.south.get(), &ElevationEdges::north, _grid, _grid + w, w, 1, south.data());
+    outerLine(_neighbors.north.get(), &ElevationEdges::south, _grid + size_t(h - 1) * w,
+              _grid + size_t(h - 2) * w, w, 1, north.data());
+    outerLine(_neighbors.west.get(), &ElevationEdges::east, _grid, _grid + 1, h, w, west.data());
+    outerLine(_neighbors.east.get(), &ElevationEdges::west, _grid + w - 1, _grid + w - 2, h, w, east.data());
+
+    double tileMeters = MapProjection::metersPerTileAtZoom(_tileId.z);
+    double southMeters = MapProjection::tileSouthWestCorner(_tileId).y;
+    double pixelX = tileMeters / w, pixelY = tileMeters / h;
+
+    for (int y = 0; y < h; y++) {
+        // Mercator scale: ground meters are projected meters times cos(latitude) = 1/cosh(y/R)
+        double scale = std::cosh((southMeters + (y + 0.5) * pixelY) / MapProjection::EARTH_RADIUS_METERS);
+        float sx = float(scale / (2 * pixelX)), sy = float(scale / (2 * pixelY));
+
+        const float* row = _grid + size_t(y) * w;
+        const float* below = y > 0 ? row - w : south.data();
+        const float* above = y < h - 1 ? row + w : north.data();
+        uint8_t* out = _normals + size_t(y) * w * 4;
+
+        for (int x = 0; x < w; x++) {
+            float left = x > 0 ? row[x - 1] : west[y];
+            float right = x < w - 1 ? row[x + 1] : east[y];
+            float dx = (right - left) * sx;
+            float dy = (above[x] - below[x]) * sy;
+            float len = std::sqrt(dx * dx + dy * dy + 1.f);
+            if (!std::isfinite(len)) { dx = dy = 0.f; len = 1.f; }
+            float inv = 0.5f / len;
+            out[x * 4 + 0] = uint8_t(std::lround((0.5f - dx * inv) * 255.f));
+            out[x * 4 + 1] = uint8_t(std::lround((0.5f - dy * inv) * 255.f));
+            out[x * 4 + 2] = uint8_t(std::lround((0.5f + inv) * 255.f));
+            out[x * 4 + 3] = 255;
+        }
+    }
+}
+
+}
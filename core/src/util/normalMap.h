@@ -0,0 +1,62 @@
+#pragma once
+
+#include "tile/tileID.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * Elevation along the borders of a tile, in texture order: rows from west to east, with row 0
+ * in the south, and columns from south to north
+ */
+struct ElevationEdges {
+    int width = 0, height = 0;
+    std::vector<float> south, north, west, east;
+
+    ElevationEdges(const float* _grid, int _width, int _height);
+};
+
+/* Edges of the neighbors of a tile; null where the neighbor is not loaded */
+struct NeighborEdges {
+    std::shared_ptr<const ElevationEdges> north, south, west, east;
+};
+
+/*
+ * ElevationEdgeCache - Edges of the loaded elevation tiles, for the normal maps of their neighbors
+ *
+ * Entries are weak: the normal map texture of a tile holds its edges. Thread-safe; normal maps
+ * are built on the tile workers.
+ */
+class ElevationEdgeCache {
+
+public:
+
+    /* Add the edges of @_tileId and return those of its neighbors that are loaded */
+    NeighborEdges add(TileID _tileId, std::shared_ptr<const ElevationEdges> _edges);
+
+    void clear();
+
+private:
+    std::mutex m_mutex;
+    std::map<TileID, std::weak_ptr<const ElevationEdges>> m_edges;
+    // Expired entries are dropped when the map grows past this size
+    size_t m_pruneSize = 64;
+};
+
+/*
+ * Normals of the elevation @_grid of @_width x @_height pixels covering @_tileId, packed into RGBA8
+ * @_normals as xyz * 0.5 + 0.5 with alpha 255, like the normal tiles of tilezen/joerd.
+ *
+ * Slopes are in ground meters, i.e. the Mercator pixel size is scaled by cos(latitude) per row.
+ * Differences across the tile borders use the elevation of @_neighbors where available and are
+ * extrapolated from the tile itself otherwise.
+ */
+void computeNormalMap(const float* _grid, int _width, int _height, TileID _tileId,
+                      const NeighborEdges& _neighbors, uint8_t* _normals);
+
+}
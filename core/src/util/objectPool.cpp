@@ -0,0 +1,48 @@
+#include "util/objectPool.h"
+
+#include <new>
+
+namespace Tangram {
+
+ObjectPool::~ObjectPool() {
+    for (auto& block : m_blocks) { ::operator delete(block.second); }
+}
+
+void* ObjectPool::allocate(size_t _size) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Few sizes are pooled, one per type of object
+        for (auto it = m_blocks.rbegin(); it != m_blocks.rend(); ++it) {
+            if (it->first != _size) { continue; }
+            void* block = it->second;
+            m_blocks.erase(std::next(it).base());
+            return block;
+        }
+        m_allocated++;
+    }
+    return ::operator new(_size);
+}
+
+void ObjectPool::deallocate(void* _block, size_t _size) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_blocks.size() < m_maxBlocks) {
+            if (m_blocks.capacity() == 0) { m_blocks.reserve(m_maxBlocks); }
+            m_blocks.emplace_back(_size, _block);
+            return;
+        }
+    }
+    ::operator delete(_block);
+}
+
+size_t ObjectPool::pooledBlocks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_blocks.size();
+}
+
+size_t ObjectPool::allocatedBlocks() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocated;
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * ObjectPool - Recycles the memory of short-lived shared objects, e.g. the TileTasks of a TileSource
+ *
+ * make() creates objects with their reference counts in one block like std::make_shared, which is
+ * taken from the blocks of released objects of the same size when there is one. While panning,
+ * thousands of tasks per second are created and released, mostly with a few hundred alive at once;
+ * up to @_maxBlocks released blocks are kept for them instead of going through the allocator.
+ *
+ * Objects keep their pool alive, so it must be owned by a shared_ptr. Thread-safe; tasks are
+ * created on the main thread and released on the workers.
+ */
+class ObjectPool : public std::enable_shared_from_this<ObjectPool> {
+
+public:
+
+    static constexpr size_t DEFAULT_MAX_BLOCKS = 256;
+
+    explicit ObjectPool(size_t _maxBlocks = DEFAULT_MAX_BLOCKS) : m_maxBlocks(_maxBlocks) {}
+    ~ObjectPool();
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template<class T, class... Args>
+    std::shared_ptr<T> make(Args&&... _args) {
+        return std::allocate_shared<T>(Allocator<T>(shared_from_this()), std::forward<Args>(_args)...);
+    }
+
+    /* Released blocks kept for new objects */
+    size_t pooledBlocks() const;
+
+    /* Blocks allocated since the pool was created, i.e. not taken from released objects */
+    size_t allocatedBlocks() const;
+
+    template<class T>
+    struct Allocator {
+        using value_type = T;
+
+        explicit Allocator(std::shared_ptr<ObjectPool> _pool) : pool(std::move(_pool)) {}
+        template<class U>
+        Allocator(const Allocator<U>& _other) : pool(_other.pool) {}
+
+        T* allocate(size_t _n) { return static_cast<T*>(pool->allocate(_n * sizeof(T))); }
+        void deallocate(T* _block, size_t _n) { pool->deallocate(_block, _n * sizeof(T)); }
+
+        template<class U>
+        bool operator==(const Allocator<U>& _other) const { return pool == _other.pool; }
+        template<class U>
+        bool operator!=(const Allocator<U>& _other) const { return pool != _other.pool; }
+
+        std::shared_ptr<ObjectPool> pool;
+    };
+
+private:
+
+    void* allocate(size_t _size);
+    void deallocate(void* _block, size_t _size);
+
+    mutable std::mutex m_mutex;
+    // Released blocks and their sizes
+    std::vector<std::pair<size_t, void*>> m_blocks;
+    size_t m_maxBlocks;
+    size_t m_allocated = 0;
+};
+
+}
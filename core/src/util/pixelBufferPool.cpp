@@ -0,0 +1,112 @@
+#include "util/pixelBufferPool.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Tangram {
+namespace PixelBufferPool {
+
+static constexpr size_t minPooledSize = 64 * 1024;
+
+struct Pool {
+    std::mutex mutex;
+    // Size of the pooled buffers that are in use
+    std::unordered_map<void*, size_t> used;
+    // Released buffers by size
+    std::unordered_map<size_t, std::vector<void*>> released;
+    size_t releasedBytes = 0;
+    size_t maxBytes = 16 * 1024 * 1024;
+};
+
+static Pool& pool() {
+    // Not destroyed, for textures released during static destruction
+    static Pool* instance = new Pool();
+    return *instance;
+}
+
+uint8_t* allocate(size_t _size) {
+    if (_size < minPooledSize) { return static_cast<uint8_t*>(std::malloc(_size)); }
+
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    void* buffer = nullptr;
+    auto it = p.released.find(_size);
+    if (it != p.released.end() && !it->second.empty()) {
+        buffer = it->second.back();
+        it->second.pop_back();
+        p.releasedBytes -= _size;
+    } else {
+        buffer = std::malloc(_size);
+        if (!buffer) { return nullptr; }
+    }
+    p.used.emplace(buffer, _size);
+    return static_cast<uint8_t*>(buffer);
+}
+
+void adopt(void* _buffer, size_t _size) {
+    if (!_buffer || _size < minPooledSize) { return; }
+
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    p.used[_buffer] = _size;
+}
+
+void release(void* _buffer) {
+    if (!_buffer) { return; }
+
+    auto& p = pool();
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+        auto it = p.used.find(_buffer);
+        if (it != p.used.end()) {
+            size_t size = it->second;
+            p.used.erase(it);
+            if (p.releasedBytes + size <= p.maxBytes) {
+                p.released[size].push_back(_buffer);
+                p.releasedBytes += size;
+                return;
+            }
+        }
+    }
+    std::free(_buffer);
+}
+
+size_t pooledBytes() {
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    return p.releasedBytes;
+}
+
+size_t maxBytes() {
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    return p.maxBytes;
+}
+
+void setMaxBytes(size_t _bytes) {
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    p.maxBytes = _bytes;
+    for (auto it = p.released.begin(); p.releasedBytes > p.maxBytes && it != p.released.end(); ++it) {
+        while (p.releasedBytes > p.maxBytes && !it->second.empty()) {
+            std::free(it->second.back());
+            it->second.pop_back();
+            p.releasedBytes -= it->first;
+        }
+    }
+}
+
+void clear() {
+    auto& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    for (auto& sized : p.released) {
+        for (void* buffer : sized.second) { std::free(buffer); }
+    }
+    p.released.clear();
+    p.releasedBytes = 0;
+}
+
+}
+}
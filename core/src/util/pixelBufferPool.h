@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tangram {
+
+/*
+ * PixelBufferPool - Reuses the pixel buffers of released textures for newly decoded ones
+ *
+ * Raster tiles come in a few sizes (256 or 512 pixels square, 1 to 4 bytes per pixel), so released
+ * buffers are kept by exact size, up to maxBytes() in total, and handed out again by allocate(),
+ * instead of going back and forth through the allocator for each tile while panning. Buffers are
+ * plain malloc() memory; buffers not from allocate() or adopt() are freed by release(). Buffers
+ * under 64KB are not pooled.
+ *
+ * Thread-safe; images are decoded on the tile workers and textures released on any thread.
+ */
+namespace PixelBufferPool {
+
+/* Buffer of @_size bytes, reused if a buffer of that size was released */
+uint8_t* allocate(size_t _size);
+
+/* Pool the buffer of @_size bytes from malloc(), e.g. of an image decoder, once it is released */
+void adopt(void* _buffer, size_t _size);
+
+/* Keep the buffer for allocate() or free it */
+void release(void* _buffer);
+
+/* Bytes of released buffers that are kept */
+size_t pooledBytes();
+
+size_t maxBytes();
+void setMaxBytes(size_t _bytes);
+
+/* Free all released buffers */
+void clear();
+
+}
+}
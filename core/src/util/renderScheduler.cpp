@@ -0,0 +1,52 @@
+#include "util/renderScheduler.h"
+
+#include "util/asyncWorker.h"
+#include "platform.h"
+
+#include <algorithm>
+
+namespace Tangram {
+
+RenderScheduler::RenderScheduler(Platform& _platform) : m_platform(_platform) {}
+
+RenderScheduler::~RenderScheduler() {
+    // Joins the worker; a pending request is dropped
+    m_worker.reset();
+}
+
+void RenderScheduler::setInterval(float _seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_interval = std::max(_seconds, 0.f);
+}
+
+void RenderScheduler::requestRender() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_pending) { return; }
+
+    auto now = Clock::now();
+    auto interval = std::chrono::duration<float>(m_interval);
+    auto elapsed = now - m_lastRequest;
+
+    if (elapsed >= interval) {
+        m_lastRequest = now;
+        lock.unlock();
+        m_platform.requestRender();
+        return;
+    }
+
+    if (!m_worker) { m_worker = std::make_unique<AsyncWorker>("RenderScheduler"); }
+
+    m_pending = true;
+    auto delay = std::chrono::ceil<std::chrono::milliseconds>(interval - elapsed);
+    m_worker->enqueueDelayed([this]() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending = false;
+            m_lastRequest = Clock::now();
+        }
+        m_platform.requestRender();
+    }, delay);
+}
+
+}
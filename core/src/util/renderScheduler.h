@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace Tangram {
+
+class AsyncWorker;
+class Platform;
+
+/* Limits the frames requested for tiles that finished loading to one per interval
+ *
+ * Requests within the interval after the last frame requested are merged into one request at the
+ * end of the interval, so that a burst of tiles is drawn with a few frames rather than one frame
+ * per tile. The delayed requests run on a thread started with the first one.
+ */
+class RenderScheduler {
+
+public:
+
+    explicit RenderScheduler(Platform& _platform);
+    ~RenderScheduler();
+
+    /* Minimum seconds between requested frames, 0 passes requests through */
+    void setInterval(float _seconds);
+    float interval() const { return m_interval; }
+
+    void requestRender();
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    Platform& m_platform;
+
+    std::mutex m_mutex;
+    std::unique_ptr<AsyncWorker> m_worker;
+    Clock::time_point m_lastRequest;
+    bool m_pending = false;
+    float m_interval = 0.f;
+};
+
+}
@@ -0,0 +1,63 @@
+#include "util/resolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Tangram {
+
+// Weight of a new frame time in the average
+static const float AVERAGE_WEIGHT = 0.25f;
+// Frames to measure after a change of scale before it is changed again
+static const int SETTLE_FRAMES = 4;
+// Frames within the budget before the scale is raised by one step
+static const int RAISE_FRAMES = 30;
+// The scale is lowered above this ratio of the budget, and raised below the lower one
+static const float OVER_BUDGET = 1.15f;
+static const float WITHIN_BUDGET = 1.05f;
+// Longer intervals are pauses between frames rather than the time of a frame
+static const float MAX_FRAME_TIME = 4.f;
+
+void ResolutionScaler::setBudget(float _frameTime, float _minScale) {
+    m_budget = std::max(_frameTime, 0.f);
+    m_minScale = std::clamp(_minScale, SCALE_STEP, 1.f);
+    reset();
+}
+
+void ResolutionScaler::reset() {
+    m_scale = 1.f;
+    m_average = 0.f;
+    m_samples = 0;
+    m_framesWithinBudget = 0;
+}
+
+float ResolutionScaler::update(float _frameTime, bool _viewMoving) {
+    if (!enabled() || !_viewMoving) {
+        reset();
+        return m_scale;
+    }
+    if (_frameTime <= 0.f || _frameTime > m_budget * MAX_FRAME_TIME) { return m_scale; }
+
+    m_average = m_samples == 0 ? _frameTime : m_average + (_frameTime - m_average) * AVERAGE_WEIGHT;
+    if (++m_samples < SETTLE_FRAMES) { return m_scale; }
+
+    if (m_average > m_budget * OVER_BUDGET) {
+        m_framesWithinBudget = 0;
+        float scale = std::floor(m_scale * std::sqrt(m_budget / m_average) / SCALE_STEP) * SCALE_STEP;
+        scale = std::max(scale, m_minScale);
+        if (scale < m_scale) {
+            m_scale = scale;
+            m_samples = 0;
+        }
+    } else if (m_average <= m_budget * WITHIN_BUDGET) {
+        if (++m_framesWithinBudget >= RAISE_FRAMES && m_scale < 1.f) {
+            m_scale = std::min(std::round(m_scale / SCALE_STEP + 1.f) * SCALE_STEP, 1.f);
+            m_samples = 0;
+            m_framesWithinBudget = 0;
+        }
+    } else {
+        m_framesWithinBudget = 0;
+    }
+    return m_scale;
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+namespace Tangram {
+
+/* Scale of the offscreen target the scene is drawn into while the view moves, adapted to keep
+ * frame times within a budget
+ *
+ * Frame times are the intervals between frames drawn in a row while the view moves. Frames bound
+ * by fill rate take time in proportion to the area of the target, so when the average frame time
+ * goes over the budget the scale is lowered at once by the square root of their ratio; it is
+ * raised again in small steps after a number of frames within the budget. Scales are multiples
+ * of SCALE_STEP, so that the target is not resized for each frame, and 1 while the view is idle.
+ */
+class ResolutionScaler {
+
+public:
+
+    static constexpr float SCALE_STEP = 0.05f;
+
+    /* @_frameTime: budget in seconds, 0 disables scaling; @_minScale: lowest scale */
+    void setBudget(float _frameTime, float _minScale);
+
+    bool enabled() const { return m_budget > 0.f; }
+
+    /* Scale for the next frame, with @_frameTime the seconds since the last frame */
+    float update(float _frameTime, bool _viewMoving);
+
+    float scale() const { return m_scale; }
+
+private:
+
+    void reset();
+
+    float m_budget = 0.f;
+    float m_minScale = 0.5f;
+    float m_scale = 1.f;
+    // Moving average of the frame times since the scale was last changed
+    float m_average = 0.f;
+    int m_samples = 0;
+    int m_framesWithinBudget = 0;
+};
+
+}
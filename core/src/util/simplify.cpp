@@ -0,0 +1,104 @@
+#include "util/simplify.h"
+
+#include "util/geom.h"
+
+namespace Tangram {
+
+size_t GeometrySimplifier::simplifyPoints(LineView _line) {
+
+    uint32_t size = uint32_t(_line.size());
+    float toleranceSq = m_tolerance * m_tolerance;
+
+    m_keep.assign(size, 0);
+    m_keep[0] = m_keep[size - 1] = 1;
+
+    m_ranges.clear();
+    m_ranges.emplace_back(0, size - 1);
+
+    while (!m_ranges.empty()) {
+        auto range = m_ranges.back();
+        m_ranges.pop_back();
+
+        const Point& a = _line[range.first];
+        const Point& b = _line[range.second];
+
+        // Find the point farthest from the segment between the ends of the range
+        float maxDistanceSq = 0.f;
+        uint32_t farthest = 0;
+        for (uint32_t i = range.first + 1; i < range.second; i++) {
+            float distanceSq = pointSegmentDistanceSq(_line[i], a, b);
+            if (distanceSq > maxDistanceSq) {
+                maxDistanceSq = distanceSq;
+                farthest = i;
+            }
+        }
+
+        if (maxDistanceSq > toleranceSq) {
+            m_keep[farthest] = 1;
+            m_ranges.emplace_back(range.first, farthest);
+            m_ranges.emplace_back(farthest, range.second);
+        }
+    }
+
+    size_t count = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (m_keep[i]) {
+            m_points.push_back(_line[i]);
+            count++;
+        }
+    }
+    return count;
+}
+
+LineView GeometrySimplifier::simplify(LineView _line) {
+
+    if (m_tolerance <= 0.f || _line.size() <= 2) { return _line; }
+
+    m_points.clear();
+    if (simplifyPoints(_line) == _line.size()) { return _line; }
+
+    return { m_points.data(), m_points.data() + m_points.size() };
+}
+
+PolygonView GeometrySimplifier::simplify(PolygonView _polygon) {
+
+    if (m_tolerance <= 0.f) { return _polygon; }
+
+    m_points.clear();
+    m_ringEnds.clear();
+
+    bool simplified = false;
+
+    for (auto ring : _polygon) {
+        size_t start = m_points.size();
+
+        // Closed rings need at least four points, the last repeating the first
+        if (ring.size() > 4) {
+            size_t count = simplifyPoints(ring);
+
+            auto begin = m_points.begin() + start;
+            float area = signedArea(ring.begin(), ring.end());
+            float simplifiedArea = signedArea(begin, m_points.end());
+
+            if (count == ring.size()) {
+                // Nothing removed
+            } else if (count >= 4 && (area > 0) == (simplifiedArea > 0) && simplifiedArea != 0) {
+                simplified = true;
+            } else {
+                // Keep the ring when it would collapse or flip
+                m_points.resize(start);
+                m_points.insert(m_points.end(), ring.begin(), ring.end());
+            }
+        } else {
+            m_points.insert(m_points.end(), ring.begin(), ring.end());
+        }
+
+        m_ringEnds.push_back(uint32_t(m_points.size()));
+    }
+
+    if (!simplified) { return _polygon; }
+
+    return { m_points.data(), m_ringEnds.data(), m_ringEnds.size(), 0 };
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "data/tileData.h"
+
+#include <utility>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * GeometrySimplifier - Removes points of lines and polygon rings which lie within a tolerance
+ * of the simplified shape (Douglas-Peucker)
+ *
+ * Results are written to buffers owned by the simplifier and returned as views, which stay
+ * valid until the next call; the input view is returned when no point is removed. Lines keep
+ * their end points. Rings keep their first point, at least four points and their winding;
+ * rings which would collapse or flip are kept as they are, so that small polygons and holes
+ * do not vanish or turn inside out.
+ */
+class GeometrySimplifier {
+
+public:
+
+    /* Tolerance in tile units; 0 returns all geometry as it is */
+    void setTolerance(float _tolerance) { m_tolerance = _tolerance; }
+    float tolerance() const { return m_tolerance; }
+
+    LineView simplify(LineView _line);
+
+    PolygonView simplify(PolygonView _polygon);
+
+private:
+
+    // Append the points of @_line that are kept to m_points, returns their count
+    size_t simplifyPoints(LineView _line);
+
+    float m_tolerance = 0.f;
+
+    std::vector<Point> m_points;
+    std::vector<uint32_t> m_ringEnds;
+
+    std::vector<uint8_t> m_keep;
+    std::vector<std::pair<uint32_t, uint32_t>> m_ranges;
+};
+
+}
@@ -124,6 +124,7 @@ void SkyManager::draw(RenderState& rs, View& _view)
 {
     float horizon = _view.horizonScreenPosition()/_view.getHeight();
     if(horizon < 0 || horizon > 1) { return; }
+    GpuTimer::Scope gpuTime(rs.gpuTimer, "sky");
     if (!m_shaderProgram) { buildProgram(); }
     if (!m_mesh) { buildMesh(); }
 
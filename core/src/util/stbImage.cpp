@@ -1,6 +1,9 @@
 #include "imageLoader.h"
 #include "log.h"
+#include "util/halfFloat.h"
+#include "util/pixelBufferPool.h"
 #include <memory>
+#include <vector>
 
 #ifndef TANGRAM_NO_WUFFS
 #include "wuffs.h"
@@ -42,7 +45,8 @@ static uint8_t* flipImage(const uint8_t* data, int width, int height, int bpp) {
     // need to flip image vertically for OpenGL coordinate system
     // stbi_set_flip_vertically_on_load flips image in place, requiring 3x memcpy per row; we'd also need to
     //  switch to stbi_set_flip_vertically_on_load_thread to avoid conflict w/ other users of stb_image
-    uint8_t* flipped = reinterpret_cast<uint8_t*>(std::malloc(width*height*bpp));
+    uint8_t* flipped = PixelBufferPool::allocate(width*height*bpp);
+    if (!flipped) { return nullptr; }
     int rowSize = width*bpp;
     for (int y = 0; y < height; ++y) {
         const uint8_t* src = &data[y*rowSize];
@@ -52,7 +56,37 @@ static uint8_t* flipImage(const uint8_t* data, int width, int height, int bpp) {
     return flipped;
 }
 
+// Flip single channel float data, converting it to half floats (GL_R16F) if requested with
+//  channels == 2, i.e. bytes per pixel of PixelFormat::HALF_FLOAT
+static uint8_t* flipFloatImage(const float* data, int width, int height, GLint* pixelfmt, int channels) {
+    if (channels != 2) {
+        *pixelfmt = GL_R32F;
+        return flipImage(reinterpret_cast<const uint8_t*>(data), width, height, sizeof(float));
+    }
+    uint16_t* flipped = reinterpret_cast<uint16_t*>(PixelBufferPool::allocate(width*height*sizeof(uint16_t)));
+    if (!flipped) { return nullptr; }
+    for (int y = 0; y < height; ++y) {
+        floatsToHalfs(&data[y*width], &flipped[(height - y - 1)*width], width);
+    }
+    *pixelfmt = GL_R16F;
+    return reinterpret_cast<uint8_t*>(flipped);
+}
+
+// Flip image data in its own buffer, so that the buffer of the decoder becomes the texture data
+static void flipImageInPlace(uint8_t* data, int width, int height, int bpp) {
+    size_t rowSize = size_t(width)*bpp;
+    std::vector<uint8_t> row(rowSize);
+    for (int y = 0; y < height/2; ++y) {
+        uint8_t* top = &data[y*rowSize];
+        uint8_t* bottom = &data[(height - y - 1)*rowSize];
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+}
+
 struct malloc_deleter { void operator()(void* x) { std::free(x); } };
+struct pool_deleter { void operator()(uint8_t* x) { PixelBufferPool::release(x); } };
 
 uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height, GLint* pixelfmt, int channels) {
     if (length < 2) return nullptr;
@@ -73,7 +107,9 @@ uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height,
         GLint fmt = 0;
         if (image.sample_format == tinydng::SAMPLEFORMAT_IEEEFP) {
             if (image.samples_per_pixel == 1 && image.bits_per_sample == 32) {
-                fmt = GL_R32F;
+                *width = image.width;
+                *height = image.height;
+                return flipFloatImage((const float*)image.data.data(), image.width, image.height, pixelfmt, channels);
             }
         } else if (image.sample_format != tinydng::SAMPLEFORMAT_INT &&
                    image.sample_format != tinydng::SAMPLEFORMAT_UINT) {
@@ -94,8 +130,7 @@ uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height,
             }
             *width = image.width;
             *height = image.height;
-            *pixelfmt = GL_R32F;
-            return flipImage((uint8_t*)fdata.data(), image.width, image.height, 4);
+            return flipFloatImage(fdata.data(), image.width, image.height, pixelfmt, channels);
         }
         if (!fmt) {
             LOGE("Unsupported TIFF: %d bits per sample, %d samples per pixel",
@@ -160,15 +195,17 @@ uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height,
         }
 
         int w = info.nCols, h = info.nRows;
-        //std::unique_ptr<uint8_t, malloc_deleter> pixels((uint8_t*)std::malloc(w * h * bpp));
-        std::vector<uint8_t> pixels(w * h * bpp, 0);
+        // Decode into a pooled buffer, which becomes the texture data unless converted to half floats
+        std::unique_ptr<uint8_t, pool_deleter> pixels(PixelBufferPool::allocate(size_t(w) * h * bpp));
+        if (!pixels) { return nullptr; }
+        std::memset(pixels.get(), 0, size_t(w) * h * bpp);
 
         // Lerc::Decode requires mask output if masks present, but we ignore for now
         std::vector<Byte> masks(info.nMasks * w * h, 0);
         Byte* pMasks = info.nMasks > 0 ? masks.data() : nullptr;
 
         if (info.dt == Lerc::DT_Float) {
-            float* fp = (float*)pixels.data();
+            float* fp = (float*)pixels.get();
             err = Lerc::DecodeTempl(fp, data, length, info.nDepth, w, h,
                                     info.nBands, info.nMasks, pMasks, nullptr, nullptr);
             // Tile of all zeros (very small compressed) may be returned instead of 404 - which is actually
@@ -178,7 +215,7 @@ uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height,
                 return nullptr;
             }
         } else {
-            err = Lerc::DecodeTempl(pixels.data(), data, length, info.nDepth, w, h,
+            err = Lerc::DecodeTempl(pixels.get(), data, length, info.nDepth, w, h,
                               info.nBands, info.nMasks, pMasks, nullptr, nullptr);
         }
 
@@ -189,14 +226,21 @@ uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height,
 
         *width = w;
         *height = h;
+        if (info.dt == Lerc::DT_Float && channels == 2) {
+            return flipFloatImage((const float*)pixels.get(), w, h, pixelfmt, channels);
+        }
         *pixelfmt = fmt;
-        return flipImage(pixels.data(), w, h, bpp);
+        flipImageInPlace(pixels.get(), w, h, bpp);
+        return pixels.release();
 #else
         LOGE("LERC support disabled - recompile with TANGRAM_LERC_SUPPORT defined.");
         return nullptr;
 #endif
     }
 
+    // 8 bit images in place of half float elevation, e.g. terrarium encoded
+    if (channels == 2) { channels = 4; }
+
     int channelsInFile = 0;
     std::unique_ptr<uint8_t, malloc_deleter> pixels(
         stbi_load_from_memory(data, int(length), width, height, &channelsInFile, channels));
@@ -210,7 +254,10 @@ uint8_t* loadImage(const uint8_t* data, size_t length, int* width, int* height,
     else if (channels == 3) *pixelfmt = GL_RGB8;
     else if (channels == 4) *pixelfmt = GL_RGBA8;
 
-    return flipImage(pixels.get(), *width, *height, channels);
+    // The decoded buffer becomes the texture data and goes to the pool when released
+    flipImageInPlace(pixels.get(), *width, *height, channels);
+    PixelBufferPool::adopt(pixels.get(), size_t(*width) * *height * channels);
+    return pixels.release();
 }
 
 }
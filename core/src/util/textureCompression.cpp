@@ -0,0 +1,301 @@
+#include "util/textureCompression.h"
+
+#include "gl/hardware.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace Tangram {
+
+static const uint8_t KTX1_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// Sizes of the fixed parts of the headers, including the identifier
+static const size_t KTX1_HEADER_SIZE = 64;
+static const size_t KTX2_HEADER_SIZE = 80;
+static const size_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+static const uint32_t KTX1_ENDIANNESS = 0x04030201;
+
+// VkFormat values of KTX 2 files for the formats in compressedImageSize()
+enum VkFormat : uint32_t {
+    VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+    VK_FORMAT_BC3_UNORM_BLOCK = 137,
+    VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147,
+    VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK = 151,
+    VK_FORMAT_ASTC_4x4_UNORM_BLOCK = 157,
+};
+
+template<typename T>
+static T read(const uint8_t* _data, size_t _offset) {
+    T value;
+    std::memcpy(&value, _data + _offset, sizeof(T));
+    return value;
+}
+
+size_t compressedImageSize(GLenum _format, int _width, int _height) {
+    if (_width <= 0 || _height <= 0) { return 0; }
+
+    // All formats have 4x4 pixel blocks
+    size_t blocks = size_t((_width + 3) / 4) * size_t((_height + 3) / 4);
+
+    switch (_format) {
+    case GL_ETC1_RGB8_OES:
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        return blocks * 8;
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:
+        return blocks * 16;
+    default:
+        return 0;
+    }
+}
+
+bool isCompressedFormatSupported(GLenum _format) {
+    switch (_format) {
+    case GL_ETC1_RGB8_OES:
+        return Hardware::supportsETC1;
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        return Hardware::supportsETC2;
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return Hardware::supportsS3TC;
+    case GL_COMPRESSED_RGBA_ASTC_4x4_KHR:
+        return Hardware::supportsASTC;
+    default:
+        return false;
+    }
+}
+
+bool isKTX(const uint8_t* _data, size_t _length) {
+    return _length >= sizeof(KTX1_IDENTIFIER) &&
+        (std::memcmp(_data, KTX1_IDENTIFIER, sizeof(KTX1_IDENTIFIER)) == 0 ||
+         std::memcmp(_data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0);
+}
+
+static bool loadKTX1(const uint8_t* _data, size_t _length, CompressedImage& _image) {
+    if (_length < KTX1_HEADER_SIZE) { return false; }
+
+    if (read<uint32_t>(_data, 12) != KTX1_ENDIANNESS) {
+        LOGW("KTX: byte order not supported");
+        return false;
+    }
+    uint32_t glType = read<uint32_t>(_data, 16);
+    uint32_t depth = read<uint32_t>(_data, 44);
+    uint32_t arrayElements = read<uint32_t>(_data, 48);
+    uint32_t faces = read<uint32_t>(_data, 52);
+    if (glType != 0 || depth > 1 || arrayElements > 1 || faces != 1) {
+        LOGW("KTX: only compressed 2D textures are supported");
+        return false;
+    }
+
+    _image.format = read<uint32_t>(_data, 28);
+    _image.width = int(read<uint32_t>(_data, 36));
+    _image.height = int(read<uint32_t>(_data, 40));
+
+    size_t offset = KTX1_HEADER_SIZE + size_t(read<uint32_t>(_data, 60));
+    if (offset > _length || _length - offset < sizeof(uint32_t)) { return false; }
+
+    _image.size = read<uint32_t>(_data, offset);
+    offset += sizeof(uint32_t);
+    if (_length - offset < _image.size) { return false; }
+
+    _image.data = _data + offset;
+    return true;
+}
+
+static bool loadKTX2(const uint8_t* _data, size_t _length, CompressedImage& _image) {
+    if (_length < KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_SIZE) { return false; }
+
+    uint32_t vkFormat = read<uint32_t>(_data, 12);
+    uint32_t depth = read<uint32_t>(_data, 28);
+    uint32_t layers = read<uint32_t>(_data, 32);
+    uint32_t faces = read<uint32_t>(_data, 36);
+    uint32_t supercompression = read<uint32_t>(_data, 44);
+
+    if (supercompression != 0) {
+        LOGW("KTX2: supercompression scheme %d is not supported", supercompression);
+        return false;
+    }
+    if (depth > 1 || layers > 1 || faces != 1) {
+        LOGW("KTX2: only 2D textures are supported");
+        return false;
+    }
+
+    switch (vkFormat) {
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK: _image.format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+    case VK_FORMAT_BC3_UNORM_BLOCK: _image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK: _image.format = GL_COMPRESSED_RGB8_ETC2; break;
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: _image.format = GL_COMPRESSED_RGBA8_ETC2_EAC; break;
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK: _image.format = GL_COMPRESSED_RGBA_ASTC_4x4_KHR; break;
+    default:
+        LOGW("KTX2: format %d is not supported", vkFormat);
+        return false;
+    }
+
+    _image.width = int(read<uint32_t>(_data, 20));
+    _image.height = int(read<uint32_t>(_data, 24));
+
+    // The level index starts with the base level
+    uint64_t offset = read<uint64_t>(_data, KTX2_HEADER_SIZE);
+    uint64_t size = read<uint64_t>(_data, KTX2_HEADER_SIZE + 8);
+    if (offset > _length || _length - offset < size) { return false; }
+
+    _image.data = _data + offset;
+    _image.size = size_t(size);
+    return true;
+}
+
+bool loadKTX(const uint8_t* _data, size_t _length, CompressedImage& _image) {
+    if (!isKTX(_data, _length)) { return false; }
+
+    bool ok = _data[5] == '1'
+        ? loadKTX1(_data, _length, _image)
+        : loadKTX2(_data, _length, _image);
+
+    if (ok && (_image.width > std::numeric_limits<uint16_t>::max() ||
+               _image.height > std::numeric_limits<uint16_t>::max() ||
+               _image.size != compressedImageSize(_image.format, _image.width, _image.height))) {
+        LOGW("KTX: invalid image size %dx%d for format 0x%x", _image.width, _image.height, _image.format);
+        ok = false;
+    }
+    return ok;
+}
+
+GLenum etc1Format() {
+    if (Hardware::supportsETC2) { return GL_COMPRESSED_RGB8_ETC2; }
+    if (Hardware::supportsETC1) { return GL_ETC1_RGB8_OES; }
+    return 0;
+}
+
+// ETC1 intensity modifier tables; modifiers are +a, +b, -a and -b for pixel indices 0 to 3
+static const int ETC1_MODIFIERS[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static inline int clampByte(int _value) {
+    return _value < 0 ? 0 : (_value > 255 ? 255 : _value);
+}
+
+// Encode a block of 4x4 RGB pixels, stored column by column as ETC1 indexes them, in
+//  individual mode: each half of the block has its own 4 bit per channel base color and
+//  modifier table. The halves are tried side by side and on top of each other.
+static void encodeETC1Block(const uint8_t _block[16][3], uint8_t* _out) {
+
+    uint64_t bestBits = 0;
+    uint64_t bestError = std::numeric_limits<uint64_t>::max();
+
+    for (int flip = 0; flip < 2; flip++) {
+        uint64_t bits = uint64_t(flip) << 32;
+        uint64_t error = 0;
+
+        for (int half = 0; half < 2; half++) {
+            int pixels[8];
+            int n = 0;
+            for (int p = 0; p < 16; p++) {
+                int x = p / 4, y = p % 4;
+                if ((flip ? y / 2 : x / 2) == half) { pixels[n++] = p; }
+            }
+
+            // Average color quantized to 4 bits per channel
+            int base[3], color[3];
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int i = 0; i < 8; i++) { sum += _block[pixels[i]][c]; }
+                base[c] = (sum * 15 + 1020) / 2040;
+                color[c] = base[c] << 4 | base[c];
+            }
+
+            uint32_t bestHalfError = std::numeric_limits<uint32_t>::max();
+            uint32_t bestIndices = 0;
+            int bestTable = 0;
+
+            for (int table = 0; table < 8; table++) {
+                uint32_t halfError = 0;
+                uint32_t indices = 0;
+
+                for (int i = 0; i < 8; i++) {
+                    const uint8_t* pixel = _block[pixels[i]];
+                    uint32_t pixelError = std::numeric_limits<uint32_t>::max();
+                    int pixelIndex = 0;
+
+                    for (int index = 0; index < 4; index++) {
+                        int modifier = ETC1_MODIFIERS[table][index & 1];
+                        if (index & 2) { modifier = -modifier; }
+                        uint32_t e = 0;
+                        for (int c = 0; c < 3; c++) {
+                            int d = clampByte(color[c] + modifier) - pixel[c];
+                            e += d * d;
+                        }
+                        if (e < pixelError) {
+                            pixelError = e;
+                            pixelIndex = index;
+                        }
+                    }
+                    halfError += pixelError;
+                    // Most significant index bits are in the upper 16 bits
+                    indices |= uint32_t(pixelIndex >> 1) << (16 + pixels[i]);
+                    indices |= uint32_t(pixelIndex & 1) << pixels[i];
+                }
+                if (halfError < bestHalfError) {
+                    bestHalfError = halfError;
+                    bestIndices = indices;
+                    bestTable = table;
+                }
+            }
+
+            error += bestHalfError;
+            bits |= bestIndices;
+            bits |= uint64_t(bestTable) << (half ? 34 : 37);
+            for (int c = 0; c < 3; c++) {
+                bits |= uint64_t(base[c]) << ((half ? 56 : 60) - 8 * c);
+            }
+        }
+
+        if (error < bestError) {
+            bestError = error;
+            bestBits = bits;
+        }
+    }
+
+    // Blocks are big endian
+    for (int i = 0; i < 8; i++) {
+        _out[i] = uint8_t(bestBits >> (56 - 8 * i));
+    }
+}
+
+uint8_t* encodeETC1(const uint8_t* _pixels, int _width, int _height, int _bpp) {
+    size_t size = compressedImageSize(GL_ETC1_RGB8_OES, _width, _height);
+    if (size == 0 || (_bpp != 3 && _bpp != 4)) { return nullptr; }
+
+    auto* out = reinterpret_cast<uint8_t*>(std::malloc(size));
+    if (!out) { return nullptr; }
+
+    uint8_t block[16][3];
+    uint8_t* dst = out;
+
+    for (int by = 0; by < _height; by += 4) {
+        for (int bx = 0; bx < _width; bx += 4) {
+            // Pixels outside of the image repeat the last row and column
+            for (int p = 0; p < 16; p++) {
+                int x = std::min(bx + p / 4, _width - 1);
+                int y = std::min(by + p % 4, _height - 1);
+                const uint8_t* src = _pixels + (size_t(y) * _width + x) * _bpp;
+                block[p][0] = src[0];
+                block[p][1] = src[1];
+                block[p][2] = src[2];
+            }
+            encodeETC1Block(block, dst);
+            dst += 8;
+        }
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "gl.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Tangram {
+
+// Block compressed image data, e.g. the base level of a KTX file
+struct CompressedImage {
+    GLenum format = 0;
+    int width = 0;
+    int height = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Bytes of an image of @_format with the given size; 0 for formats which are not known
+size_t compressedImageSize(GLenum _format, int _width, int _height);
+
+// Whether the driver can sample textures of compressed @_format (see Hardware)
+bool isCompressedFormatSupported(GLenum _format);
+
+// Whether @_data starts with the identifier of a KTX 1 or KTX 2 file
+bool isKTX(const uint8_t* _data, size_t _length);
+
+// Read the base level of a KTX 1 or KTX 2 file into @_image, which points into @_data.
+//  Supercompressed KTX 2 files (Basis Universal, Zstandard) are not supported.
+bool loadKTX(const uint8_t* _data, size_t _length, CompressedImage& _image);
+
+// Format of encodeETC1() data for this driver: ETC2 RGB, of which ETC1 is a subset, or ETC1;
+//  0 if the driver supports neither
+GLenum etc1Format();
+
+// Encode @_pixels with @_bpp 3 (RGB) or 4 (RGBA, alpha is ignored) bytes per pixel to ETC1
+//  blocks; returns malloc'ed data of compressedImageSize(GL_ETC1_RGB8_OES, @_width, @_height)
+uint8_t* encodeETC1(const uint8_t* _pixels, int _width, int _height, int _bpp);
+
+}
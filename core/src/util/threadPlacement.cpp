@@ -0,0 +1,167 @@
+#include "util/threadPlacement.h"
+
+#include "log.h"
+#include "platform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#include <sys/sysctl.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace Tangram {
+
+// Niceness of each ThreadQoS; the render class matches THREAD_PRIORITY_DISPLAY on Android and
+// the others keep tile work below the UI threads of apps
+[[maybe_unused]] static int qosNiceness(ThreadQoS _qos) {
+    switch (_qos) {
+    case ThreadQoS::render: return -4;
+    case ThreadQoS::interactive: return 10;
+    case ThreadQoS::prefetch: return 14;
+    case ThreadQoS::background: return 19;
+    }
+    return 10;
+}
+
+bool setCurrentThreadQoS(ThreadQoS _qos) {
+#if defined(__APPLE__)
+    qos_class_t qos = QOS_CLASS_DEFAULT;
+    switch (_qos) {
+    case ThreadQoS::render: qos = QOS_CLASS_USER_INTERACTIVE; break;
+    case ThreadQoS::interactive: qos = QOS_CLASS_USER_INITIATED; break;
+    case ThreadQoS::prefetch: qos = QOS_CLASS_UTILITY; break;
+    case ThreadQoS::background: qos = QOS_CLASS_BACKGROUND; break;
+    }
+    return pthread_set_qos_class_self_np(qos, 0) == 0;
+#elif defined(__linux__)
+    int niceness = qosNiceness(_qos);
+    setCurrentThreadPriority(niceness);
+    return getpriority(PRIO_PROCESS, 0) == niceness;
+#else
+    setCurrentThreadPriority(qosNiceness(_qos));
+    return true;
+#endif
+}
+
+bool canSwitchThreadQoS() {
+#if defined(__linux__)
+    static const bool canSwitch = [] {
+        if (geteuid() == 0) { return true; }
+        // The niceness of a thread can be lowered down to 20 - RLIMIT_NICE
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NICE, &limit) != 0) { return false; }
+        return limit.rlim_cur == RLIM_INFINITY ||
+            20 - int(limit.rlim_cur) <= qosNiceness(ThreadQoS::interactive);
+    }();
+    return canSwitch;
+#else
+    return true;
+#endif
+}
+
+bool setCurrentThreadAffinity(const std::vector<int>& _cpus) {
+#if defined(__linux__)
+    if (_cpus.empty()) { return false; }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : _cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// Maximum frequency of each CPU; all zero when unknown
+static std::vector<uint32_t> readMaxFrequencies() {
+    std::vector<uint32_t> frequencies;
+#if defined(__APPLE__)
+    // Performance levels from fastest to slowest; CPU numbers are only used for counting here
+    int levels = 0;
+    size_t size = sizeof(levels);
+    if (sysctlbyname("hw.nperflevels", &levels, &size, nullptr, 0) == 0) {
+        for (int level = 0; level < levels; level++) {
+            int cpus = 0;
+            size = sizeof(cpus);
+            std::string name = "hw.perflevel" + std::to_string(level) + ".logicalcpu";
+            if (sysctlbyname(name.c_str(), &cpus, &size, nullptr, 0) != 0) { break; }
+            frequencies.insert(frequencies.end(), cpus, uint32_t(levels - level));
+        }
+    }
+#elif defined(__linux__)
+    long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+    for (long cpu = 0; cpu < numCpus; cpu++) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq", cpu);
+        unsigned int frequency = 0;
+        if (FILE* file = fopen(path, "r")) {
+            if (fscanf(file, "%u", &frequency) != 1) { frequency = 0; }
+            fclose(file);
+        }
+        frequencies.push_back(frequency);
+    }
+#endif
+    if (frequencies.empty()) {
+        frequencies.resize(std::max(std::thread::hardware_concurrency(), 1u), 0);
+    }
+    return frequencies;
+}
+
+const CpuTopology& CpuTopology::get() {
+    static const CpuTopology topology = [] {
+        CpuTopology t(readMaxFrequencies());
+        LOG("CPU clusters: %d, tile worker CPUs: %d of %d", int(t.clusters().size()),
+            int(t.workerCpus().size()), int(t.numCpus()));
+        return t;
+    }();
+    return topology;
+}
+
+CpuTopology::CpuTopology(const std::vector<uint32_t>& _maxFrequencies) {
+    m_numCpus = std::max<size_t>(_maxFrequencies.size(), 1);
+
+    for (size_t cpu = 0; cpu < _maxFrequencies.size(); cpu++) {
+        uint32_t frequency = _maxFrequencies[cpu];
+        auto it = std::find_if(m_clusters.begin(), m_clusters.end(),
+                               [&](auto& c) { return c.maxFrequency == frequency; });
+        if (it == m_clusters.end()) {
+            it = m_clusters.insert(m_clusters.end(), Cluster{frequency, {}});
+        }
+        it->cpus.push_back(int(cpu));
+    }
+    if (m_clusters.empty()) { m_clusters.push_back(Cluster{0, {0}}); }
+    std::sort(m_clusters.begin(), m_clusters.end(),
+              [](auto& a, auto& b) { return a.maxFrequency > b.maxFrequency; });
+
+    // All but the slowest cluster, or all CPUs when they are the same
+    size_t first = 0;
+    size_t last = isHeterogeneous() ? m_clusters.size() - 1 : m_clusters.size();
+    size_t fastCpus = 0;
+    for (size_t i = first; i < last; i++) { fastCpus += m_clusters[i].cpus.size(); }
+
+    // Leave prime cores to the render thread
+    bool primeCores = last - first > 1 && m_clusters[0].cpus.size() <= 2 &&
+        fastCpus - m_clusters[0].cpus.size() >= 2;
+    if (primeCores) { first = 1; }
+
+    for (size_t i = first; i < last; i++) {
+        auto& cpus = m_clusters[i].cpus;
+        m_workerCpus.insert(m_workerCpus.end(), cpus.begin(), cpus.end());
+    }
+    std::sort(m_workerCpus.begin(), m_workerCpus.end());
+
+    uint32_t available = uint32_t(m_workerCpus.size());
+    uint32_t workers = primeCores ? available : available - 1;
+    m_numTileWorkers = std::clamp(workers, std::min(available, 2u), 4u);
+}
+
+}
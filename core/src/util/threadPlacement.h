@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+/* Quality-of-service classes of work on core threads, mapped to platform thread priorities:
+ * QoS classes on Apple platforms, niceness elsewhere (which are the thread priorities on Android)
+ */
+enum class ThreadQoS {
+    render,      // drawing frames
+    interactive, // tiles of the visible view
+    prefetch,    // tiles around or ahead of the view
+    background,  // offline downloads and other work nobody waits for
+};
+
+// Set the QoS class of the current thread; returns false when the platform does not allow it
+bool setCurrentThreadQoS(ThreadQoS _qos);
+
+// Whether a thread can go back to a higher class after a lower one, so that threads running
+// tasks of different classes can switch per task. Not the case e.g. on Linux without
+// permission to lower the niceness of threads again.
+bool canSwitchThreadQoS();
+
+// Restrict the current thread to the CPUs @_cpus; only supported on Linux and Android
+bool setCurrentThreadAffinity(const std::vector<int>& _cpus);
+
+/* Layout of the CPU cores in clusters of the same maximum frequency, e.g. the performance and
+ * efficiency cores of big.LITTLE phones
+ *
+ * Tile workers on efficiency cores take several times longer per tile, so on devices with cores
+ * of different speeds workers are placed on the cores of all but the slowest cluster. When the
+ * fastest cluster only has one or two 'prime' cores and there are other fast cores, these are
+ * left to the render thread.
+ */
+class CpuTopology {
+
+public:
+
+    struct Cluster {
+        // Maximum frequency in kHz, 0 if unknown
+        uint32_t maxFrequency = 0;
+        std::vector<int> cpus;
+    };
+
+    // Topology of this device, read once
+    static const CpuTopology& get();
+
+    // From the maximum frequency of each CPU, indexed by CPU number
+    explicit CpuTopology(const std::vector<uint32_t>& _maxFrequencies);
+
+    // Clusters from fastest to slowest
+    const std::vector<Cluster>& clusters() const { return m_clusters; }
+
+    size_t numCpus() const { return m_numCpus; }
+
+    bool isHeterogeneous() const { return m_clusters.size() > 1; }
+
+    // CPUs on which tile workers run best
+    const std::vector<int>& workerCpus() const { return m_workerCpus; }
+
+    // Number of tile workers for this device: one per worker CPU, less one for the render
+    // thread unless it has cores of its own, at least two if there are, and at most four
+    uint32_t numTileWorkers() const { return m_numTileWorkers; }
+
+private:
+
+    size_t m_numCpus = 0;
+    std::vector<Cluster> m_clusters;
+    std::vector<int> m_workerCpus;
+    uint32_t m_numTileWorkers = 0;
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace Tangram {
+
+/* Counts of durations in fixed buckets, from 1ms to more than 250ms
+ *
+ * Threads add to atomic counters without locking, so histograms can stay on in release builds;
+ * percentiles are approximated by the upper bound of the bucket they fall in.
+ */
+class TimeHistogram {
+
+public:
+
+    static constexpr size_t numBuckets = 12;
+
+    /* Upper bound in ms of @_bucket; the last bucket is unbounded */
+    static float bound(size_t _bucket) {
+        static const float bounds[numBuckets] = { 1, 2, 4, 8, 12, 16, 24, 33, 50, 100, 250, INFINITY };
+        return bounds[std::min(_bucket, numBuckets - 1)];
+    }
+
+    void add(float _ms) {
+        size_t bucket = 0;
+        while (bucket < numBuckets - 1 && _ms > bound(bucket)) { bucket++; }
+        ++m_counts[bucket];
+        ++m_total;
+        m_micros += uint64_t(std::max(_ms, 0.f) * 1000);
+    }
+
+    uint32_t count(size_t _bucket) const { return m_counts[_bucket]; }
+    uint32_t total() const { return m_total; }
+
+    /* Mean duration in ms */
+    float average() const { return m_total ? m_micros / 1000.f / m_total : 0.f; }
+
+    /* Upper bound in ms of the bucket holding the @_p percentile, the bound of the last
+     * bounded bucket when it lies beyond */
+    float percentile(float _p) const {
+        uint32_t total = m_total;
+        if (total == 0) { return 0.f; }
+        auto rank = uint32_t(std::ceil(_p / 100.f * total));
+        uint32_t sum = 0;
+        for (size_t bucket = 0; bucket < numBuckets - 1; bucket++) {
+            sum += m_counts[bucket];
+            if (sum >= rank) { return bound(bucket); }
+        }
+        return bound(numBuckets - 2);
+    }
+
+    void reset() {
+        for (auto& count : m_counts) { count = 0; }
+        m_total = 0;
+        m_micros = 0;
+    }
+
+private:
+
+    std::array<std::atomic<uint32_t>, numBuckets> m_counts{};
+    std::atomic<uint32_t> m_total{0};
+    std::atomic<uint64_t> m_micros{0};
+};
+
+}
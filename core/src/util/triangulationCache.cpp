@@ -0,0 +1,172 @@
+#include "util/triangulationCache.h"
+
+#include "util/builders.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+
+namespace Tangram {
+
+struct TriangulationCache::Entry {
+    // Set by whichever of the helper and a TileBuilder triangulates the polygon first
+    std::atomic<bool> claimed{false};
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool ready = false;
+    std::shared_ptr<const Indices> indices;
+
+    // Copy of a prefetched polygon for the helper, released once triangulated
+    Polygon polygon;
+
+    // Accounted size, 0 until ready; guarded by the cache mutex
+    size_t bytes = 0;
+};
+
+// 64 bit FNV-1a over the ring sizes and the coordinate bits
+static uint64_t hashPolygon(PolygonView _polygon) {
+    const uint64_t prime = 0x100000001b3ull;
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (auto ring : _polygon) {
+        hash = (hash ^ ring.size()) * prime;
+        for (const auto& p : ring) {
+            uint32_t x, y;
+            std::memcpy(&x, &p.x, sizeof(x));
+            std::memcpy(&y, &p.y, sizeof(y));
+            hash = (hash ^ ((uint64_t(x) << 32) | y)) * prime;
+            hash ^= hash >> 32;
+        }
+    }
+    return hash;
+}
+
+template<class P>
+static void triangulate(const P& _polygon, mapbox::detail::Earcut<uint16_t>& _earcut,
+                        std::shared_ptr<const TriangulationCache::Indices>& _indices) {
+    _earcut(_polygon);
+    _indices = std::make_shared<const TriangulationCache::Indices>(_earcut.indices);
+}
+
+TriangulationCache::TriangulationCache(size_t _maxBytes)
+    : m_maxBytes(_maxBytes),
+      m_helperEarcut(std::make_unique<mapbox::detail::Earcut<uint16_t>>()),
+      m_helper("TangramTriangulation") {}
+
+TriangulationCache::~TriangulationCache() = default;
+
+size_t TriangulationCache::pointCount(PolygonView _polygon) {
+    size_t count = 0;
+    for (auto ring : _polygon) { count += ring.size(); }
+    return count;
+}
+
+std::shared_ptr<const TriangulationCache::Indices> TriangulationCache::get(PolygonView _polygon,
+                                                                           mapbox::detail::Earcut<uint16_t>& _earcut) {
+
+    if (pointCount(_polygon) < MIN_POINTS) { return nullptr; }
+
+    uint64_t key = hashPolygon(_polygon);
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            entry = it->second->second;
+        } else {
+            entry = std::make_shared<Entry>();
+            m_entries.emplace_front(key, entry);
+            m_index.emplace(key, m_entries.begin());
+        }
+    }
+
+    // Triangulate here unless the helper already started
+    if (!entry->claimed.exchange(true)) {
+        std::shared_ptr<const Indices> indices;
+        triangulate(_polygon, _earcut, indices);
+        {
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            entry->indices = indices;
+            entry->polygon = Polygon();
+            entry->ready = true;
+        }
+        entry->condition.notify_all();
+        account(key, *entry);
+        return indices;
+    }
+
+    std::unique_lock<std::mutex> lock(entry->mutex);
+    entry->condition.wait(lock, [&]{ return entry->ready; });
+    return entry->indices;
+}
+
+void TriangulationCache::prefetch(PolygonView _polygon) {
+
+    if (pointCount(_polygon) < LARGE_POLYGON_POINTS) { return; }
+
+    uint64_t key = hashPolygon(_polygon);
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_index.find(key) != m_index.end()) { return; }
+
+        entry = std::make_shared<Entry>();
+        for (auto ring : _polygon) { entry->polygon.emplace_back(ring.begin(), ring.end()); }
+
+        m_entries.emplace_front(key, entry);
+        m_index.emplace(key, m_entries.begin());
+    }
+
+    m_helper.enqueue([this, key, entry]() {
+        if (entry->claimed.exchange(true)) { return; }
+
+        std::shared_ptr<const Indices> indices;
+        triangulate(entry->polygon, *m_helperEarcut, indices);
+        {
+            std::lock_guard<std::mutex> lock(entry->mutex);
+            entry->indices = indices;
+            entry->polygon = Polygon();
+            entry->ready = true;
+        }
+        entry->condition.notify_all();
+        account(key, *entry);
+    });
+}
+
+void TriangulationCache::account(uint64_t _key, Entry& _entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The entry may have been dropped by clear()
+    auto it = m_index.find(_key);
+    if (it == m_index.end() || it->second->second.get() != &_entry) { return; }
+
+    _entry.bytes = sizeof(Entry) + _entry.indices->size() * sizeof(uint16_t);
+    m_bytes += _entry.bytes;
+
+    // Drop least recently used entries which are ready
+    for (auto lru = m_entries.end(); m_bytes > m_maxBytes && lru != m_entries.begin();) {
+        --lru;
+        if (lru->second->bytes == 0) { continue; }
+
+        m_bytes -= lru->second->bytes;
+        m_index.erase(lru->first);
+        lru = m_entries.erase(lru);
+    }
+}
+
+size_t TriangulationCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+void TriangulationCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Pending entries stay valid for their waiters, which hold a reference
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "data/tileData.h"
+#include "util/asyncWorker.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mapbox { namespace detail {
+template <typename N> class Earcut;
+}}
+
+namespace Tangram {
+
+/*
+ * TriangulationCache - Earcut triangle indices of polygons, kept across tile builds
+ *
+ * Entries are keyed by a hash of the polygon coordinates, so that tiles rebuilt after a scene
+ * update or cache eviction, and overzoomed tiles sharing their TileData, find the indices of the
+ * same polygons. Only polygons with at least MIN_POINTS points are cached; smaller ones are
+ * cheaper to triangulate again. Large polygons can be triangulated on a helper thread ahead of
+ * their use, see prefetch(). The least recently used entries are dropped above the size limit.
+ *
+ * Shared by the TileBuilders of a TileWorker; all functions are thread-safe.
+ */
+class TriangulationCache {
+
+public:
+
+    using Indices = std::vector<uint16_t>;
+
+    static constexpr size_t MIN_POINTS = 64;
+    static constexpr size_t LARGE_POLYGON_POINTS = 1024;
+
+    explicit TriangulationCache(size_t _maxBytes = 8 * 1024 * 1024);
+    ~TriangulationCache();
+
+    /* Triangle indices into the points of @_polygon, from the cache, from the helper thread or
+     * triangulated with @_earcut; nullptr when @_polygon is too small to be cached */
+    std::shared_ptr<const Indices> get(PolygonView _polygon, mapbox::detail::Earcut<uint16_t>& _earcut);
+
+    /* Start triangulating @_polygon on the helper thread when it has at least
+     * LARGE_POLYGON_POINTS points and is not cached */
+    void prefetch(PolygonView _polygon);
+
+    /* Size of the cached indices in bytes */
+    size_t size() const;
+
+    void clear();
+
+    static size_t pointCount(PolygonView _polygon);
+
+private:
+
+    struct Entry;
+
+    using EntryList = std::list<std::pair<uint64_t, std::shared_ptr<Entry>>>;
+
+    // Add the size of the indices of @_entry and drop old entries above the limit
+    void account(uint64_t _key, Entry& _entry);
+
+    size_t m_maxBytes;
+    size_t m_bytes = 0;
+
+    mutable std::mutex m_mutex;
+
+    // Most recently used first
+    EntryList m_entries;
+    std::unordered_map<uint64_t, EntryList::iterator> m_index;
+
+    // Used on the helper thread only
+    std::unique_ptr<mapbox::detail::Earcut<uint16_t>> m_helperEarcut;
+
+    // Declared last to be joined before the other members are released
+    AsyncWorker m_helper;
+};
+
+}
@@ -0,0 +1,227 @@
+#include "util/vertexCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Tangram {
+
+// Size of the simulated cache and scoring parameters, see
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+static constexpr int CACHE_SIZE = 32;
+static constexpr int MAX_VALENCE = 32;
+
+struct ScoreTables {
+    float cache[CACHE_SIZE];
+    float valence[MAX_VALENCE + 1];
+
+    ScoreTables() {
+        for (int i = 0; i < CACHE_SIZE; i++) {
+            if (i < 3) {
+                // Vertices of the last triangle, scored lower to not repeat it
+                cache[i] = 0.75f;
+            } else {
+                cache[i] = std::pow(1.f - float(i - 3) / (CACHE_SIZE - 3), 1.5f);
+            }
+        }
+        valence[0] = 0.f;
+        for (int i = 1; i <= MAX_VALENCE; i++) {
+            valence[i] = 2.f / std::sqrt(float(i));
+        }
+    }
+};
+
+static float vertexScore(int _cachePosition, uint32_t _remaining) {
+    static const ScoreTables tables;
+
+    // No triangles left to draw with this vertex
+    if (_remaining == 0) { return -1.f; }
+
+    float score = _cachePosition < 0 ? 0.f : tables.cache[_cachePosition];
+
+    // Boost vertices with few triangles left, to not leave single triangles behind
+    score += _remaining <= MAX_VALENCE ? tables.valence[_remaining] : 2.f / std::sqrt(float(_remaining));
+    return score;
+}
+
+bool VertexCacheOptimizer::optimizeTriangles(uint16_t* _indices, size_t _nIndices, size_t _nVertices) {
+
+    const size_t nTriangles = _nIndices / 3;
+    for (size_t i = 0; i < nTriangles * 3; i++) {
+        if (_indices[i] >= _nVertices) { return false; }
+    }
+    if (nTriangles < 2) { return true; }
+
+    const uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    // Triangles of each vertex, with the ones not yet emitted at the start of each list
+    m_triangleStart.assign(_nVertices + 1, 0);
+    for (size_t i = 0; i < nTriangles * 3; i++) { m_triangleStart[_indices[i] + 1]++; }
+    for (size_t v = 0; v < _nVertices; v++) { m_triangleStart[v + 1] += m_triangleStart[v]; }
+
+    m_remaining.assign(_nVertices, 0);
+    m_vertexTriangles.resize(nTriangles * 3);
+    for (uint32_t t = 0; t < nTriangles; t++) {
+        for (size_t k = 0; k < 3; k++) {
+            uint16_t v = _indices[t * 3 + k];
+            m_vertexTriangles[m_triangleStart[v] + m_remaining[v]++] = t;
+        }
+    }
+
+    m_cachePosition.assign(_nVertices, -1);
+    m_vertexScores.resize(_nVertices);
+    for (size_t v = 0; v < _nVertices; v++) {
+        m_vertexScores[v] = vertexScore(-1, m_remaining[v]);
+    }
+
+    uint32_t best = none;
+    float bestScore = -1.f;
+
+    m_triangleScores.resize(nTriangles);
+    for (uint32_t t = 0; t < nTriangles; t++) {
+        const uint16_t* tri = &_indices[t * 3];
+        float score = m_vertexScores[tri[0]] + m_vertexScores[tri[1]] + m_vertexScores[tri[2]];
+        m_triangleScores[t] = score;
+        if (score > bestScore) {
+            bestScore = score;
+            best = t;
+        }
+    }
+
+    m_emitted.assign(nTriangles, 0);
+    m_output.clear();
+    m_output.reserve(nTriangles * 3);
+
+    uint16_t cache[CACHE_SIZE + 3];
+    size_t cacheCount = 0;
+    size_t cursor = 0;
+
+    while (true) {
+        if (best == none) {
+            // None of the cached vertices has triangles left, continue with the next one
+            while (cursor < nTriangles && m_emitted[cursor]) { cursor++; }
+            if (cursor == nTriangles) { break; }
+            best = uint32_t(cursor);
+        }
+
+        const uint16_t* tri = &_indices[best * 3];
+        m_emitted[best] = 1;
+        m_output.insert(m_output.end(), tri, tri + 3);
+
+        for (size_t k = 0; k < 3; k++) {
+            uint16_t v = tri[k];
+            uint32_t* list = &m_vertexTriangles[m_triangleStart[v]];
+            uint32_t* end = list + m_remaining[v];
+            auto it = std::find(list, end, best);
+            if (it != end) {
+                std::swap(*it, *(end - 1));
+                m_remaining[v]--;
+            }
+        }
+
+        // Put the vertices of the triangle in front of the cache
+        uint16_t newCache[CACHE_SIZE + 3];
+        size_t newCount = 0;
+        for (size_t k = 0; k < 3; k++) {
+            if (std::find(newCache, newCache + newCount, tri[k]) == newCache + newCount) {
+                newCache[newCount++] = tri[k];
+            }
+        }
+        for (size_t i = 0; i < cacheCount; i++) {
+            uint16_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Update the scores of the vertices in the cache and of those dropped from it
+        for (size_t i = 0; i < newCount; i++) {
+            uint16_t v = newCache[i];
+            int position = i < CACHE_SIZE ? int(i) : -1;
+            m_cachePosition[v] = position;
+
+            float score = vertexScore(position, m_remaining[v]);
+            float delta = score - m_vertexScores[v];
+            m_vertexScores[v] = score;
+
+            const uint32_t* list = &m_vertexTriangles[m_triangleStart[v]];
+            for (uint32_t j = 0; j < m_remaining[v]; j++) {
+                m_triangleScores[list[j]] += delta;
+            }
+        }
+
+        cacheCount = std::min<size_t>(newCount, CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        // Continue with the best triangle of the cached vertices
+        best = none;
+        bestScore = -1.f;
+        for (size_t i = 0; i < cacheCount; i++) {
+            uint16_t v = cache[i];
+            const uint32_t* list = &m_vertexTriangles[m_triangleStart[v]];
+            for (uint32_t j = 0; j < m_remaining[v]; j++) {
+                if (m_triangleScores[list[j]] > bestScore) {
+                    bestScore = m_triangleScores[list[j]];
+                    best = list[j];
+                }
+            }
+        }
+    }
+
+    std::copy(m_output.begin(), m_output.end(), _indices);
+    return true;
+}
+
+void VertexCacheOptimizer::optimizeFetch(uint16_t* _indices, size_t _nIndices, void* _vertices,
+                                         size_t _nVertices, size_t _stride) {
+
+    m_remap.assign(_nVertices, -1);
+    int32_t next = 0;
+    bool reordered = false;
+
+    for (size_t i = 0; i < _nIndices; i++) {
+        uint16_t v = _indices[i];
+        if (m_remap[v] < 0) {
+            reordered |= (next != v);
+            m_remap[v] = next++;
+        }
+        _indices[i] = uint16_t(m_remap[v]);
+    }
+    for (size_t v = 0; v < _nVertices; v++) {
+        if (m_remap[v] < 0) {
+            reordered |= (next != int32_t(v));
+            m_remap[v] = next++;
+        }
+    }
+
+    if (!reordered) { return; }
+
+    auto* vertices = static_cast<char*>(_vertices);
+    m_vertexCopy.assign(vertices, vertices + _nVertices * _stride);
+
+    for (size_t v = 0; v < _nVertices; v++) {
+        std::memcpy(vertices + m_remap[v] * _stride, m_vertexCopy.data() + v * _stride, _stride);
+    }
+}
+
+size_t VertexCacheOptimizer::vertexInvocations(const uint16_t* _indices, size_t _nIndices, size_t _nVertices,
+                                               size_t _cacheSize) {
+
+    // A vertex is in the cache while less than _cacheSize vertices were added after it
+    std::vector<size_t> added(_nVertices, 0);
+    size_t invocations = 0;
+
+    for (size_t i = 0; i < _nIndices; i++) {
+        uint16_t v = _indices[i];
+        if (v >= _nVertices) {
+            invocations++;
+        } else if (added[v] == 0 || invocations - added[v] >= _cacheSize) {
+            invocations++;
+            added[v] = invocations;
+        }
+    }
+    return invocations;
+}
+
+}
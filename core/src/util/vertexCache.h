@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * VertexCacheOptimizer - Reorders indexed triangles for the post-transform vertex cache of the
+ * GPU and vertices for fetch locality
+ *
+ * Triangles are ordered with the linear-speed algorithm of Tom Forsyth, which does not depend on
+ * the exact cache size of the hardware. Vertices are then renumbered in the order of their first
+ * use. The buffers used while optimizing are kept between calls.
+ */
+class VertexCacheOptimizer {
+
+public:
+
+    /* Reorder the triangles of @_indices, which refer to @_nVertices vertices; returns false
+     * and leaves @_indices unchanged when they refer to other vertices */
+    bool optimizeTriangles(uint16_t* _indices, size_t _nIndices, size_t _nVertices);
+
+    /* Reorder the @_nVertices vertices of @_stride bytes in @_vertices in the order of their first
+     * use in @_indices and update @_indices; unused vertices are moved to the end */
+    void optimizeFetch(uint16_t* _indices, size_t _nIndices, void* _vertices, size_t _nVertices, size_t _stride);
+
+    /* Number of vertex shader invocations to draw @_indices with a FIFO cache of @_cacheSize
+     * vertices, as a measure of the cache efficiency of the triangle order */
+    static size_t vertexInvocations(const uint16_t* _indices, size_t _nIndices, size_t _nVertices,
+                                    size_t _cacheSize = 16);
+
+private:
+
+    std::vector<uint32_t> m_triangleStart;
+    std::vector<uint32_t> m_remaining;
+    std::vector<uint32_t> m_vertexTriangles;
+    std::vector<int8_t> m_cachePosition;
+    std::vector<float> m_vertexScores;
+    std::vector<float> m_triangleScores;
+    std::vector<uint8_t> m_emitted;
+    std::vector<uint16_t> m_output;
+
+    std::vector<int32_t> m_remap;
+    std::vector<char> m_vertexCopy;
+};
+
+}
@@ -0,0 +1,75 @@
+#include "util/workerPool.h"
+
+namespace Tangram {
+
+WorkerPool::WorkerPool(size_t _numThreads) {
+    for (size_t i = 0; i < _numThreads; i++) {
+        m_threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_start.notify_all();
+    for (auto& thread : m_threads) { thread.join(); }
+}
+
+void WorkerPool::work(const std::function<void(size_t)>& _task, size_t _count) {
+    for (size_t i = m_next++; i < _count; i = m_next++) { _task(i); }
+}
+
+void WorkerPool::parallelFor(size_t _count, const std::function<void(size_t)>& _task) {
+
+    if (m_threads.empty() || _count < 2) {
+        for (size_t i = 0; i < _count; i++) { _task(i); }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &_task;
+        m_count = _count;
+        m_next = 0;
+        m_active = m_threads.size();
+        m_loop++;
+    }
+    m_start.notify_all();
+
+    work(_task, _count);
+
+    // Every thread takes part in each loop, so none can miss the next one
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&]{ return m_active == 0; });
+    m_task = nullptr;
+}
+
+void WorkerPool::run() {
+    uint64_t loop = 0;
+
+    while (true) {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [&]{ return !m_running || m_loop != loop; });
+            if (!m_running) { return; }
+
+            loop = m_loop;
+            task = m_task;
+            count = m_count;
+        }
+
+        work(*task, count);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_active > 0) { continue; }
+        }
+        m_done.notify_one();
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Tangram {
+
+/*
+ * WorkerPool - Threads which run the iterations of a loop together with the calling thread
+ *
+ * For short parallel loops on the render thread: the threads wait for the next loop instead
+ * of being started for each one. One loop runs at a time.
+ */
+class WorkerPool {
+
+public:
+
+    explicit WorkerPool(size_t _numThreads);
+    ~WorkerPool();
+
+    size_t numThreads() const { return m_threads.size(); }
+
+    /* Run @_task for each index from 0 to @_count - 1, in any order; returns when all ran */
+    void parallelFor(size_t _count, const std::function<void(size_t)>& _task);
+
+private:
+
+    void run();
+    void work(const std::function<void(size_t)>& _task, size_t _count);
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+
+    // The current loop, guarded by m_mutex
+    const std::function<void(size_t)>* m_task = nullptr;
+    size_t m_count = 0;
+    uint64_t m_loop = 0;
+    // Threads still working on the current loop
+    size_t m_active = 0;
+    bool m_running = true;
+
+    std::atomic<size_t> m_next{0};
+};
+
+}
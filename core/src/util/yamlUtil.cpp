@@ -98,6 +98,22 @@ bool getBoolOrDefault(const YAML::Node& node, bool defaultValue) {
     return defaultValue;
 }
 
+size_t memoryUsage(const YAML::Node& node) {
+    auto stringBytes = [](const std::string& s) { return s.capacity() > 15 ? s.capacity() + 1 : 0; };
+
+    size_t bytes = stringBytes(node.Scalar());
+    if (node.IsMap()) {
+        for (const auto& entry : node.pairs()) {
+            bytes += sizeof(YAML::ListNode) + memoryUsage(entry.first) + memoryUsage(entry.second);
+        }
+    } else if (node.IsSequence()) {
+        for (const auto& child : node) {
+            bytes += sizeof(YAML::ListNode) + memoryUsage(child);
+        }
+    }
+    return bytes;
+}
+
 void mergeMapFields(YAML::Node& target, YAML::Node&& import) {
     if (!target.IsMap() || !import.IsMap()) {
 
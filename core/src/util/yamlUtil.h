@@ -28,6 +28,9 @@ bool getBoolOrDefault(const YAML::Node& node, bool defaultValue);
 
 void mergeMapFields(YAML::Node& target, YAML::Node&& import);
 
+// Estimated bytes of the nodes and strings of node and its children
+size_t memoryUsage(const YAML::Node& node);
+
 JSValue toJSValue(JSScope& jsScope, const YAML::Node& node);
 
 template<typename T>
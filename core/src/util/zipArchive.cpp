@@ -1,7 +1,15 @@
 #include "zipArchive.h"
 
+#include "platform.h"
+
+#include <cstring>
+
 namespace Tangram {
 
+// Size of the fixed part of a local file header.
+static const size_t LOCAL_HEADER_SIZE = 30;
+static const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+
 ZipArchive::ZipArchive() {
     mz_zip_zero_struct(&minizData);
 }
@@ -15,18 +23,56 @@ bool ZipArchive::loadFromMemory(std::vector<char>&& compressedArchiveData) {
     reset();
     // Initialize the buffer and archive with the input data.
     buffer = std::move(compressedArchiveData);
-    if (!mz_zip_reader_init_mem(&minizData, buffer.data(), buffer.size(), 0)) {
+    data = buffer.data();
+    size = buffer.size();
+    return loadEntries();
+}
+
+bool ZipArchive::loadFromFile(const std::string& path) {
+    // Reset to an empty state.
+    reset();
+    if (!mappedFile.open(path)) {
+        return false;
+    }
+    // Entries are accessed in no particular order.
+    mappedFile.adviseRandom();
+    data = mappedFile.data();
+    size = mappedFile.size();
+    return loadEntries();
+}
+
+bool ZipArchive::loadFromMapping(std::shared_ptr<MappedResource> mapping) {
+    // Reset to an empty state.
+    reset();
+    if (!mapping) {
+        return false;
+    }
+    mappedResource = std::move(mapping);
+    data = mappedResource->data();
+    size = mappedResource->size();
+    return loadEntries();
+}
+
+bool ZipArchive::loadEntries() {
+    if (!mz_zip_reader_init_mem(&minizData, data, size, 0)) {
         return false;
     }
     // Scan the archive entries into a list.
     auto numberOfFiles = mz_zip_reader_get_num_files(&minizData);
     entryList.reserve(numberOfFiles);
+    entryIndex.reserve(numberOfFiles);
     for (size_t i = 0; i < numberOfFiles; i++) {
         Entry entry;
         mz_zip_archive_file_stat stats;
         if (mz_zip_reader_file_stat(&minizData, i, &stats)) {
             entry.path = stats.m_filename;
             entry.uncompressedSize = stats.m_uncomp_size;
+            entry.compressedSize = stats.m_comp_size;
+            entry.headerOffset = stats.m_local_header_ofs;
+            entry.crc32 = stats.m_crc32;
+            entry.stored = stats.m_method == 0 && !stats.m_is_encrypted;
+            // The first entry for a path is found, as with a linear search.
+            entryIndex.emplace(entry.path, i);
         }
         entryList.push_back(entry);
     }
@@ -34,10 +80,9 @@ bool ZipArchive::loadFromMemory(std::vector<char>&& compressedArchiveData) {
 }
 
 const ZipArchive::Entry* ZipArchive::findEntry(const std::string& path) const {
-    for (const auto& entry : entryList) {
-        if (entry.path == path) {
-            return &entry;
-        }
+    auto it = entryIndex.find(path);
+    if (it != entryIndex.end()) {
+        return &entryList[it->second];
     }
     return nullptr;
 }
@@ -47,19 +92,55 @@ bool ZipArchive::decompressEntry(const Entry* entry, char* output) {
     if (entry == nullptr || entry < entryList.data() || entry >= entryList.data() + entryList.size()) {
         return false;
     }
+    // Stored entries are copied without going through miniz.
+    if (const char* stored = entryData(entry)) {
+        std::memcpy(output, stored, entry->uncompressedSize);
+        return true;
+    }
     // Get the index of the entry (this arithmetic is only legal in an array).
     size_t index = entry - entryList.data();
     size_t size = entry->uncompressedSize;
     return mz_zip_reader_extract_to_mem(&minizData, index, output, size, 0);
 }
 
+const char* ZipArchive::entryData(const Entry* entry) const {
+    // Check that the given pointer refers to a stored entry in our list.
+    if (entry == nullptr || entry < entryList.data() || entry >= entryList.data() + entryList.size() ||
+        !entry->stored || entry->compressedSize != entry->uncompressedSize) {
+        return nullptr;
+    }
+    // The data follows the local header, which has its own name and extra
+    // field lengths.
+    size_t offset = entry->headerOffset;
+    if (offset > size || size - offset < LOCAL_HEADER_SIZE) {
+        return nullptr;
+    }
+    const auto* header = reinterpret_cast<const unsigned char*>(data + offset);
+    uint32_t signature = header[0] | header[1] << 8 | header[2] << 16 | uint32_t(header[3]) << 24;
+    if (signature != LOCAL_HEADER_SIGNATURE) {
+        return nullptr;
+    }
+    size_t nameLength = header[26] | header[27] << 8;
+    size_t extraLength = header[28] | header[29] << 8;
+    offset += LOCAL_HEADER_SIZE + nameLength + extraLength;
+    if (offset > size || size - offset < entry->uncompressedSize) {
+        return nullptr;
+    }
+    return data + offset;
+}
+
 void ZipArchive::reset() {
     // Close and free the miniz archive (if null, this is a no-op).
     mz_zip_reader_end(&minizData);
     mz_zip_zero_struct(&minizData);
-    // Empty the buffer and entry list.
+    // Empty the buffer, mapping and entry list.
     buffer.clear();
+    mappedFile.close();
+    mappedResource.reset();
+    data = nullptr;
+    size = 0;
     entryList.clear();
+    entryIndex.clear();
 }
 
 }
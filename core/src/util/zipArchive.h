@@ -4,11 +4,17 @@
 #define MINIZ_NO_ZLIB_COMPATIBLE_NAMES // Disable zlib names, to prevent conflicts against stock zlib.
 #include <miniz.h>
 
+#include "util/mappedFile.h"
+
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Tangram {
 
+class MappedResource;
+
 class ZipArchive {
 
 public:
@@ -17,6 +23,12 @@ public:
     struct Entry {
         std::string path;
         size_t uncompressedSize = 0;
+        size_t compressedSize = 0;
+        // Offset of the local header in the archive.
+        size_t headerOffset = 0;
+        uint32_t crc32 = 0;
+        // True if the entry is stored without compression.
+        bool stored = false;
     };
 
     // Create an empty archive.
@@ -35,6 +47,17 @@ public:
     // data is loaded or the archive is destroyed.
     bool loadFromMemory(std::vector<char>&& compressedArchiveData);
 
+    // Load a zip archive from a file by mapping it into memory. Only the
+    // central directory is read; entry data is paged in when it is accessed.
+    // The mapping is kept until other data is loaded or the archive is
+    // destroyed.
+    bool loadFromFile(const std::string& path);
+
+    // Load a zip archive from a resource mapped by Platform::mapResource(),
+    // like loadFromFile(). The mapping is kept until other data is loaded or
+    // the archive is destroyed.
+    bool loadFromMapping(std::shared_ptr<MappedResource> mapping);
+
     // Empty the archive.
     void reset();
 
@@ -51,13 +74,32 @@ public:
     // from this archive or it can't be decompressed, otherwise returns true.
     bool decompressEntry(const Entry* entry, char* output);
 
+    // Return a pointer to the data of the given entry if it is stored without
+    // compression, otherwise null. The data is a view into the archive and is
+    // valid until other data is loaded or the archive is destroyed.
+    const char* entryData(const Entry* entry) const;
+
 protected:
+    // Initialize miniz and the entry list from the archive data.
+    bool loadEntries();
+
     // Buffer of compressed zip archive data.
     std::vector<char> buffer;
 
+    // Mapped zip archive file or resource, used instead of the buffer.
+    MappedFile mappedFile;
+    std::shared_ptr<MappedResource> mappedResource;
+
+    // Archive data from either the buffer or the mapped file.
+    const char* data = nullptr;
+    size_t size = 0;
+
     // List of file entries in the archive.
     std::vector<Entry> entryList;
 
+    // Index of each entry in the list by path.
+    std::unordered_map<std::string, size_t> entryIndex;
+
     // Archive data used by miniz.
     mz_zip_archive minizData;
 };
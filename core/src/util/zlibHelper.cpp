@@ -1,11 +1,25 @@
 #include "util/zlibHelper.h"
 
+#include "miniz.h"
 #ifndef TANGRAM_NO_WUFFS
 #include "wuffs.h"
-#include "log.h"
-#else
-#include "miniz.h"
 #endif
+#ifdef TANGRAM_USE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef TANGRAM_USE_BROTLI
+#include <brotli/decode.h>
+#endif
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+// Number of idle buffers kept by pooledBuffer()
+#define BUFFER_POOL_SIZE 32
+// Buffers with larger capacity are freed instead of pooled
+#define BUFFER_POOL_MAX_CAPACITY (4*1024*1024)
 
 namespace Tangram {
 
@@ -35,7 +49,9 @@ int zlib_inflate(const char* _data, size_t _size, std::vector<char>& dst) {
 //#endif
 
 #ifndef TANGRAM_NO_WUFFS
-    auto dec = wuffs_deflate__decoder::alloc();
+    // decoder is reused for all payloads inflated on a thread
+    thread_local auto dec = wuffs_deflate__decoder::alloc();
+    if (!dec) { return -1; }
     auto status = wuffs_deflate__decoder__initialize(dec.get(), sizeof__wuffs_deflate__decoder(), WUFFS_VERSION, 0);
     if (!wuffs_base__status__is_ok(&status)) { return -1; }
 
@@ -87,4 +103,285 @@ int zlib_inflate(const char* _data, size_t _size, std::vector<char>& dst) {
 #endif
 }
 
+int zlib_deflate(const char* _data, size_t _size, std::vector<char>& dst, int _level) {
+
+    mz_ulong length = mz_compressBound(_size);
+    dst.resize(length);
+
+    int ret = mz_compress2((unsigned char*)dst.data(), &length, (const unsigned char*)_data, _size, _level);
+    dst.resize(ret == MZ_OK ? length : 0);
+
+    return ret;
+}
+
+int gzip_deflate(const char* _data, size_t _size, std::vector<char>& dst, int _level) {
+
+    std::vector<char> zlib;
+    int ret = zlib_deflate(_data, _size, zlib, _level);
+    if (ret != MZ_OK) {
+        dst.clear();
+        return ret;
+    }
+
+    // same deflate stream, with gzip header and trailer (CRC-32 and size) instead of zlib ones
+    static const char header[10] = { 0x1F, char(0x8B), 8, 0, 0, 0, 0, 0, 0, char(0xFF) };
+    uint32_t crc = uint32_t(mz_crc32(MZ_CRC32_INIT, (const unsigned char*)_data, _size));
+    uint32_t size = uint32_t(_size);
+
+    dst.assign(header, header + sizeof(header));
+    dst.insert(dst.end(), zlib.begin() + 2, zlib.end() - 4);
+    for (int i = 0; i < 4; i++) { dst.push_back(char(crc >> (8 * i))); }
+    for (int i = 0; i < 4; i++) { dst.push_back(char(size >> (8 * i))); }
+
+    return MZ_OK;
+}
+
+// Output reserved per call of mz_inflate() by ZlibInflater
+#define INFLATE_CHUNK_SIZE (16*1024)
+
+ZlibInflater::ZlibInflater() = default;
+
+ZlibInflater::~ZlibInflater() {
+    if (m_stream) { mz_inflateEnd(m_stream.get()); }
+}
+
+bool ZlibInflater::write(const char* _data, size_t _size, std::vector<char>& _dst) {
+
+    if (m_state == State::body) { return inflateChunk(_data, _size, _dst); }
+    if (m_state != State::header) { return m_state == State::done; }
+
+    m_header.insert(m_header.end(), _data, _data + _size);
+    const auto* header = reinterpret_cast<const uint8_t*>(m_header.data());
+    size_t size = m_header.size();
+    if (size < 2) { return true; }
+
+    size_t start = 0;
+    int windowBits = MZ_DEFAULT_WINDOW_BITS;
+    if (isGzip(m_header.data(), size)) {
+        // fixed header, then optional extra field, file name, comment and header CRC
+        if (size < 10) { return true; }
+        uint8_t flags = header[3];
+        size_t pos = 10;
+        if (flags & 0x04) {
+            if (size < pos + 2) { return true; }
+            pos += 2 + (header[pos] | (header[pos + 1] << 8));
+        }
+        for (uint8_t field : { 0x08, 0x10 }) {
+            if (!(flags & field)) { continue; }
+            while (pos < size && header[pos] != 0) { pos++; }
+            pos++;
+        }
+        if (flags & 0x02) { pos += 2; }
+        if (pos > size) { return true; }
+        start = pos;
+        // raw deflate stream, the trailer is not checked
+        windowBits = -MZ_DEFAULT_WINDOW_BITS;
+    } else if (header[0] != 0x78 || ((header[0] << 8) | header[1]) % 31 != 0) {
+        m_state = State::error;
+        return false;
+    }
+
+    m_stream = std::make_unique<mz_stream>();
+    memset(m_stream.get(), 0, sizeof(mz_stream));
+    if (mz_inflateInit2(m_stream.get(), windowBits) != MZ_OK) {
+        m_stream.reset();
+        m_state = State::error;
+        return false;
+    }
+    m_state = State::body;
+
+    std::vector<char> rest(m_header.begin() + start, m_header.end());
+    m_header.clear();
+    m_header.shrink_to_fit();
+    return inflateChunk(rest.data(), rest.size(), _dst);
+}
+
+bool ZlibInflater::inflateChunk(const char* _data, size_t _size, std::vector<char>& _dst) {
+
+    auto& strm = *m_stream;
+    strm.next_in = reinterpret_cast<const unsigned char*>(_data);
+    strm.avail_in = unsigned(_size);
+
+    while (true) {
+        size_t used = _dst.size();
+        size_t room = std::max<size_t>(4 * strm.avail_in, INFLATE_CHUNK_SIZE);
+        _dst.resize(used + room);
+        strm.next_out = reinterpret_cast<unsigned char*>(_dst.data() + used);
+        strm.avail_out = unsigned(room);
+
+        int ret = mz_inflate(&strm, MZ_NO_FLUSH);
+        _dst.resize(used + room - strm.avail_out);
+
+        if (ret == MZ_STREAM_END) {
+            m_state = State::done;
+            return true;
+        }
+        if (ret != MZ_OK && ret != MZ_BUF_ERROR) {
+            LOGE("Inflate error: %d", ret);
+            m_state = State::error;
+            return false;
+        }
+        // all input consumed and room left, i.e. the next chunk is needed
+        if (strm.avail_in == 0 && strm.avail_out > 0) { return true; }
+    }
+}
+
+#ifdef TANGRAM_USE_ZSTD
+static int zstd_decompress(const char* _data, size_t _size, std::vector<char>& dst) {
+
+    // decoder context is reused for all payloads decoded on a thread
+    thread_local std::unique_ptr<ZSTD_DCtx, size_t(*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    if (!dctx) { return -1; }
+    ZSTD_DCtx_reset(dctx.get(), ZSTD_reset_session_only);
+
+    unsigned long long contentSize = ZSTD_getFrameContentSize(_data, _size);
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR) { return -1; }
+    if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize > BUFFER_POOL_MAX_CAPACITY) {
+        contentSize = _size*4;
+    }
+    // one spare byte, so that a fully decoded frame is not mistaken for a full output buffer
+    dst.resize(std::max<size_t>(size_t(contentSize) + 1, 64));
+
+    ZSTD_inBuffer in = { _data, _size, 0 };
+    size_t written = 0;
+    while (true) {
+        ZSTD_outBuffer out = { dst.data() + written, dst.size() - written, 0 };
+        size_t ret = ZSTD_decompressStream(dctx.get(), &out, &in);
+        written += out.pos;
+        if (ZSTD_isError(ret)) {
+            LOGE("zstd error: %s", ZSTD_getErrorName(ret));
+            dst.clear();
+            return -1;
+        }
+        if (in.pos == in.size && out.pos < out.size) {
+            // all input consumed and decoder did not run out of space
+            if (ret != 0) {
+                LOGE("zstd error: truncated input");
+                dst.clear();
+                return -1;
+            }
+            break;
+        }
+        if (written == dst.size()) { dst.resize(2*dst.size()); }
+    }
+    dst.resize(written);
+    return 0;
+}
+#endif
+
+#ifdef TANGRAM_USE_BROTLI
+static int brotli_decompress(const char* _data, size_t _size, std::vector<char>& dst) {
+
+    BrotliDecoderState* state = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+    if (!state) { return -1; }
+
+    size_t availIn = _size;
+    const uint8_t* nextIn = reinterpret_cast<const uint8_t*>(_data);
+    size_t written = 0;
+    dst.resize(std::max<size_t>(_size*4, 64));
+
+    BrotliDecoderResult result;
+    while (true) {
+        size_t availOut = dst.size() - written;
+        uint8_t* nextOut = reinterpret_cast<uint8_t*>(dst.data()) + written;
+        result = BrotliDecoderDecompressStream(state, &availIn, &nextIn, &availOut, &nextOut, nullptr);
+        written = dst.size() - availOut;
+        if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) { break; }
+        dst.resize(2*dst.size());
+    }
+
+    if (result != BROTLI_DECODER_RESULT_SUCCESS) {
+        LOGE("brotli error: %s", result == BROTLI_DECODER_RESULT_ERROR ?
+             BrotliDecoderErrorString(BrotliDecoderGetErrorCode(state)) : "truncated input");
+    }
+    BrotliDecoderDestroyInstance(state);
+
+    dst.resize(result == BROTLI_DECODER_RESULT_SUCCESS ? written : 0);
+    return result == BROTLI_DECODER_RESULT_SUCCESS ? 0 : -1;
+}
+#endif
+
+static std::atomic<Decompressor>* decompressors() {
+    static std::atomic<Decompressor> s_decompressors[size_t(Codec::numCodecs)] = {
+        { nullptr },
+        { &zlib_inflate },
+#ifdef TANGRAM_USE_ZSTD
+        { &zstd_decompress },
+#else
+        { nullptr },
+#endif
+#ifdef TANGRAM_USE_BROTLI
+        { &brotli_decompress },
+#else
+        { nullptr },
+#endif
+    };
+    return s_decompressors;
+}
+
+void setDecompressor(Codec _codec, Decompressor _decompressor) {
+    if (_codec == Codec::none || _codec >= Codec::numCodecs) { return; }
+    decompressors()[size_t(_codec)] = _decompressor;
+}
+
+bool hasDecompressor(Codec _codec) {
+    if (_codec == Codec::none) { return true; }
+    if (_codec >= Codec::numCodecs) { return false; }
+    return decompressors()[size_t(_codec)] != nullptr;
+}
+
+int decompress(Codec _codec, const char* _data, size_t _size, std::vector<char>& dst) {
+    if (_codec == Codec::none) {
+        dst.assign(_data, _data + _size);
+        return 0;
+    }
+    if (_codec >= Codec::numCodecs) { return -1; }
+
+    Decompressor decoder = decompressors()[size_t(_codec)];
+    if (!decoder) { return -1; }
+
+    return decoder(_data, _size, dst) == 0 ? 0 : -1;
+}
+
+struct BufferPool {
+    std::mutex mutex;
+    std::vector<std::vector<char>*> buffers;
+};
+
+std::shared_ptr<std::vector<char>> pooledBuffer() {
+
+    // never destroyed, so that buffers released during static destruction can still be returned
+    static BufferPool* s_pool = new BufferPool();
+
+    std::vector<char>* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(s_pool->mutex);
+        if (!s_pool->buffers.empty()) {
+            buffer = s_pool->buffers.back();
+            s_pool->buffers.pop_back();
+        }
+    }
+    if (!buffer) { buffer = new std::vector<char>(); }
+
+    return std::shared_ptr<std::vector<char>>(buffer, [](std::vector<char>* _buffer) {
+        if (_buffer->capacity() <= BUFFER_POOL_MAX_CAPACITY) {
+            _buffer->clear();
+            std::lock_guard<std::mutex> lock(s_pool->mutex);
+            if (s_pool->buffers.size() < BUFFER_POOL_SIZE) {
+                s_pool->buffers.push_back(_buffer);
+                return;
+            }
+        }
+        delete _buffer;
+    });
+}
+
+std::shared_ptr<std::vector<char>> pooledBuffer(std::vector<char>&& _data) {
+    auto buffer = pooledBuffer();
+    // The capacity of the pooled buffer goes with @_data, the storage of @_data is pooled instead
+    buffer->swap(_data);
+    return buffer;
 }
+
+}
+
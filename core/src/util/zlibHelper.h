@@ -1,10 +1,76 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string.h>
 
+struct mz_stream_s;
+
 namespace Tangram {
 
 int zlib_inflate(const char* _data, size_t _size, std::vector<char>& dst);
 
+// compress to zlib format readable by zlib_inflate(); @_level: 1 (fastest) to 9 (smallest)
+int zlib_deflate(const char* _data, size_t _size, std::vector<char>& dst, int _level = 1);
+
+// compress to gzip format, e.g. for tiles of archives read by other software
+int gzip_deflate(const char* _data, size_t _size, std::vector<char>& dst, int _level = 6);
+
+// Incremental inflate of a gzip or zlib stream, e.g. of a response body as its chunks are received,
+//  so that the compressed data does not have to be buffered as a whole
+class ZlibInflater {
+public:
+    ZlibInflater();
+    ~ZlibInflater();
+
+    // Inflate the next chunk of the stream, appending the output to @_dst; returns false on error.
+    //  Data after the end of the compressed stream is ignored.
+    bool write(const char* _data, size_t _size, std::vector<char>& _dst);
+
+    // Whether the end of the compressed stream was reached
+    bool finished() const { return m_state == State::done; }
+
+    // Whether @_data starts with a gzip header
+    static bool isGzip(const char* _data, size_t _size) {
+        return _size >= 2 && uint8_t(_data[0]) == 0x1F && uint8_t(_data[1]) == 0x8B;
+    }
+
+private:
+    bool inflateChunk(const char* _data, size_t _size, std::vector<char>& _dst);
+
+    enum class State : uint8_t { header, body, done, error };
+    State m_state = State::header;
+    // header bytes received so far, until the header is complete
+    std::vector<char> m_header;
+    std::unique_ptr<mz_stream_s> m_stream;
+};
+
+// Compression of tile payloads, as declared by archive headers or metadata
+enum class Codec : uint8_t {
+    none,
+    gzip,    // gzip or zlib stream
+    zstd,    // built with TANGRAM_USE_ZSTD
+    brotli,  // built with TANGRAM_USE_BROTLI
+    numCodecs
+};
+
+// Decoder writing decompressed @_data to @dst; returns 0 on success
+using Decompressor = int (*)(const char* _data, size_t _size, std::vector<char>& dst);
+
+// Set decoder for @_codec, e.g. to use a platform library; nullptr removes support for @_codec
+void setDecompressor(Codec _codec, Decompressor _decompressor);
+bool hasDecompressor(Codec _codec);
+
+// Decompress @_data with the decoder for @_codec into @dst, reusing its capacity; Codec::none copies.
+//  Returns 0 on success, -1 if @_codec is not supported
+int decompress(Codec _codec, const char* _data, size_t _size, std::vector<char>& dst);
+
+// Empty buffer from a shared pool; its capacity is recycled when the last reference is released,
+//  so that decoding tiles into pooled buffers does not allocate once the pool is warm
+std::shared_ptr<std::vector<char>> pooledBuffer();
+
+// Pooled buffer taking the storage of @_data without copying, e.g. of a UrlResponse
+std::shared_ptr<std::vector<char>> pooledBuffer(std::vector<char>&& _data);
+
 }
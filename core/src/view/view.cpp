@@ -622,14 +622,19 @@ float View::getTileScreenArea(TileID tile) const {
     if (dx > hc) { tc.x -= 1 << tc.z; }
     else if (dx < -hc) { tc.x += 1 << tc.z; }
 
-    // doesn't seem to significantly reduce number of tiles visible, so hold off for now (also need to do memcheck!)
-    //glm::vec2 elevlims = m_elevationManager && tile.z + 4 > int(m_zoom) ?
-    //    m_elevationManager->getMinMaxElev(tile, 3) : glm::vec2(0, 9000);
+    // min and max elevation of the tile or its ancestors from the elevation pyramid, if loaded
+    glm::vec2 elevBounds;
+    bool hasBounds = m_elevationManager && m_elevationManager->getElevationBounds(tile, elevBounds);
 
     // use elevation at center of screen (used to calc m_zoom) for tile bottom
     // 1 - 2^(base_z - z) gives normalized distance along pos -> eye vector of terrain intersection, so
     //  multiplying by eye elev gives terrain elev (similar triangles)
     float elev0 = m_elevationManager ? m_eye.z * (1 - std::exp2(m_baseZoom - m_zoom)) : 0;
+    if (hasBounds) {
+        // screen area of the tile at its mean elevation
+        elevBounds *= m_elevationManager->m_terrainScale;
+        elev0 = 0.5f*(elevBounds.x + elevBounds.y);
+    }
     auto a00 = tileCoordsToClipSpace(tc, elev0);
     auto a01 = tileCoordsToClipSpace({tc.x, tc.y + 1, tc.z}, elev0);
     auto a10 = tileCoordsToClipSpace({tc.x + 1, tc.y, tc.z}, elev0);
@@ -637,7 +642,24 @@ float View::getTileScreenArea(TileID tile) const {
     auto a = glm::transpose(glm::mat4(a00, a01, a10, a11));
     auto wa = glm::abs(a[3]);
 
-    if (m_elevationManager) {  //&& m_pitch != 0) {
+    if (hasBounds) {
+        // cull the 3D bounding box of the tile
+        auto c = glm::transpose(glm::mat4(tileCoordsToClipSpace(tc, elevBounds.x),
+                                          tileCoordsToClipSpace({tc.x, tc.y + 1, tc.z}, elevBounds.x),
+                                          tileCoordsToClipSpace({tc.x + 1, tc.y, tc.z}, elevBounds.x),
+                                          tileCoordsToClipSpace({tc.x + 1, tc.y + 1, tc.z}, elevBounds.x)));
+        auto b = glm::transpose(glm::mat4(tileCoordsToClipSpace(tc, elevBounds.y),
+                                          tileCoordsToClipSpace({tc.x, tc.y + 1, tc.z}, elevBounds.y),
+                                          tileCoordsToClipSpace({tc.x + 1, tc.y, tc.z}, elevBounds.y),
+                                          tileCoordsToClipSpace({tc.x + 1, tc.y + 1, tc.z}, elevBounds.y)));
+        auto wc = glm::abs(c[3]);
+        auto wb = glm::abs(b[3]);
+
+        for (int i = 0; i < 3; i++) {
+            if (allLess(c[i], -wc) && allLess(b[i], -wb))     { return 0; }
+            if (allGreater(c[i], wc) && allGreater(b[i], wb)) { return 0; }
+        }
+    } else if (m_elevationManager) {  //&& m_pitch != 0) {
         glm::dvec3 eye(m_pos.x + m_eye.x, m_pos.y + m_eye.y, m_eye.z);
         double dist = glm::distance(eye, glm::dvec3(MapProjection::tileCenter(tile), 0.));
         //if(dist - std::abs(bounds.max.x - bounds.min.x)/M_SQRT2 > maxTileDistance) { return; } ... only covers ~30% of tiles
@@ -162,6 +162,9 @@ public:
     // Get the current pitch angle in radians.
     float getPitch() const { return m_pitch; }
 
+    // Terrain elevation of the scene, null without 3D terrain
+    ElevationManager* elevationManager() const { return m_elevationManager; }
+
     // Update the view and projection matrices if properties have changed; returns true if view changed
     //  since last update
     bool update();
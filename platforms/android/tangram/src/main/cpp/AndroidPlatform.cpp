@@ -28,6 +28,26 @@
 PFNGLBINDVERTEXARRAYOESPROC glBindVertexArrayOESEXT = 0;
 PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
 PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT = 0;
+PFNGLTEXIMAGE3DOESPROC glTexImage3DEXT = 0;
+PFNGLTEXSUBIMAGE3DOESPROC glTexSubImage3DEXT = 0;
+PFNGLCOMPRESSEDTEXIMAGE3DOESPROC glCompressedTexImage3DEXT = 0;
+PFNGLCOMPRESSEDTEXSUBIMAGE3DOESPROC glCompressedTexSubImage3DEXT = 0;
+PFNGLVERTEXATTRIBDIVISOREXTPROC glVertexAttribDivisorES3 = 0;
+PFNGLDRAWELEMENTSINSTANCEDEXTPROC glDrawElementsInstancedES3 = 0;
+PFNGLBINDBUFFERBASEES3PROC glBindBufferBaseES3 = 0;
+PFNGLGETUNIFORMBLOCKINDEXES3PROC glGetUniformBlockIndexES3 = 0;
+PFNGLUNIFORMBLOCKBINDINGES3PROC glUniformBlockBindingES3 = 0;
+PFNGLMAPBUFFERRANGEEXTPROC glMapBufferRangeES3 = 0;
+PFNGLFENCESYNCAPPLEPROC glFenceSyncES3 = 0;
+PFNGLCLIENTWAITSYNCAPPLEPROC glClientWaitSyncES3 = 0;
+PFNGLDELETESYNCAPPLEPROC glDeleteSyncES3 = 0;
+PFNGLBLITFRAMEBUFFERANGLEPROC glBlitFramebufferES3 = 0;
+PFNGLGENQUERIESEXTPROC glGenQueriesTimerEXT = 0;
+PFNGLDELETEQUERIESEXTPROC glDeleteQueriesTimerEXT = 0;
+PFNGLBEGINQUERYEXTPROC glBeginQueryTimerEXT = 0;
+PFNGLENDQUERYEXTPROC glEndQueryTimerEXT = 0;
+PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivTimerEXT = 0;
+PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vTimerEXT = 0;
 
 namespace Tangram {
 
@@ -141,9 +161,8 @@ FontSourceHandle AndroidPlatform::systemFont(const std::string& name, const std:
 
     if (path.empty()) { return {}; }
 
-    auto data = bytesFromFile(Url(path.c_str()));
-
-    return FontSourceHandle([data]() { return data; });
+    // Read when the font is first used rather than for each lookup; bundled CJK fonts are large
+    return FontSourceHandle([this, url = Url(path)]() { return bytesFromFile(url); });
 }
 
 #ifdef TANGRAM_ANDROID_MAIN
@@ -164,6 +183,50 @@ void AndroidPlatform::setContinuousRendering(bool isContinuous) {
     jniEnv->CallVoidMethod(m_mapController, setRenderModeMethodID, isContinuous ? 1 : 0);
 }
 
+namespace {
+
+// Asset memory from AAsset_getBuffer: a mapping of the APK for assets stored without compression,
+// otherwise the inflated asset held by the AAsset
+class MappedAsset : public MappedResource {
+public:
+    explicit MappedAsset(AAsset* asset) : m_asset(asset) {
+        m_data = static_cast<const char*>(AAsset_getBuffer(asset));
+        m_size = m_data ? size_t(AAsset_getLength64(asset)) : 0;
+    }
+    ~MappedAsset() override { AAsset_close(m_asset); }
+
+private:
+    AAsset* m_asset;
+};
+
+}
+
+std::shared_ptr<MappedResource> AndroidPlatform::mapResource(const Url& url) const {
+    if (url.scheme() != "asset") { return Platform::mapResource(url); }
+
+    // The asset manager doesn't like paths starting with '/'.
+    auto path = url.path();
+    if (!path.empty() && path.front() == '/') {
+        path = path.substr(1);
+    }
+
+    AAsset* asset = AAssetManager_open(m_assetManager, path.c_str(), AASSET_MODE_BUFFER);
+    if (asset == nullptr) {
+        LOGW("Failed to open asset at path: %s", path.c_str());
+        return nullptr;
+    }
+    if (!AAsset_isAllocated(asset)) {
+        LOGD("Asset %s is compressed and is inflated into memory", path.c_str());
+    }
+
+    auto mapped = std::make_shared<MappedAsset>(asset);
+    if (!mapped->data()) {
+        LOGW("Failed to map asset at path: %s", path.c_str());
+        return nullptr;
+    }
+    return mapped;
+}
+
 bool AndroidPlatform::bytesFromAssetManager(const char* path, std::function<char*(size_t)> allocator) const {
 
     AAsset* asset = AAssetManager_open(m_assetManager, path, AASSET_MODE_UNKNOWN);
@@ -299,6 +362,28 @@ void initGLExtensions() {
     glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC) dlsym(libhandle, "glDeleteVertexArraysOES");
     glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC) dlsym(libhandle, "glGenVertexArraysOES");
 
+    // Exported by libGLESv2 on devices with GLES 3
+    glTexImage3DEXT = (PFNGLTEXIMAGE3DOESPROC) dlsym(libhandle, "glTexImage3D");
+    glTexSubImage3DEXT = (PFNGLTEXSUBIMAGE3DOESPROC) dlsym(libhandle, "glTexSubImage3D");
+    glCompressedTexImage3DEXT = (PFNGLCOMPRESSEDTEXIMAGE3DOESPROC) dlsym(libhandle, "glCompressedTexImage3D");
+    glCompressedTexSubImage3DEXT = (PFNGLCOMPRESSEDTEXSUBIMAGE3DOESPROC) dlsym(libhandle, "glCompressedTexSubImage3D");
+    glVertexAttribDivisorES3 = (PFNGLVERTEXATTRIBDIVISOREXTPROC) dlsym(libhandle, "glVertexAttribDivisor");
+    glDrawElementsInstancedES3 = (PFNGLDRAWELEMENTSINSTANCEDEXTPROC) dlsym(libhandle, "glDrawElementsInstanced");
+    glBindBufferBaseES3 = (PFNGLBINDBUFFERBASEES3PROC) dlsym(libhandle, "glBindBufferBase");
+    glGetUniformBlockIndexES3 = (PFNGLGETUNIFORMBLOCKINDEXES3PROC) dlsym(libhandle, "glGetUniformBlockIndex");
+    glUniformBlockBindingES3 = (PFNGLUNIFORMBLOCKBINDINGES3PROC) dlsym(libhandle, "glUniformBlockBinding");
+    glMapBufferRangeES3 = (PFNGLMAPBUFFERRANGEEXTPROC) dlsym(libhandle, "glMapBufferRange");
+    glFenceSyncES3 = (PFNGLFENCESYNCAPPLEPROC) dlsym(libhandle, "glFenceSync");
+    glClientWaitSyncES3 = (PFNGLCLIENTWAITSYNCAPPLEPROC) dlsym(libhandle, "glClientWaitSync");
+    glDeleteSyncES3 = (PFNGLDELETESYNCAPPLEPROC) dlsym(libhandle, "glDeleteSync");
+    glBlitFramebufferES3 = (PFNGLBLITFRAMEBUFFERANGLEPROC) dlsym(libhandle, "glBlitFramebuffer");
+    glGenQueriesTimerEXT = (PFNGLGENQUERIESEXTPROC) dlsym(libhandle, "glGenQueriesEXT");
+    glDeleteQueriesTimerEXT = (PFNGLDELETEQUERIESEXTPROC) dlsym(libhandle, "glDeleteQueriesEXT");
+    glBeginQueryTimerEXT = (PFNGLBEGINQUERYEXTPROC) dlsym(libhandle, "glBeginQueryEXT");
+    glEndQueryTimerEXT = (PFNGLENDQUERYEXTPROC) dlsym(libhandle, "glEndQueryEXT");
+    glGetQueryObjectuivTimerEXT = (PFNGLGETQUERYOBJECTUIVEXTPROC) dlsym(libhandle, "glGetQueryObjectuivEXT");
+    glGetQueryObjectui64vTimerEXT = (PFNGLGETQUERYOBJECTUI64VEXTPROC) dlsym(libhandle, "glGetQueryObjectui64vEXT");
+
     glExtensionsLoaded = true;
 }
 
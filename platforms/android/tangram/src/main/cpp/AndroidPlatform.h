@@ -35,6 +35,7 @@ public:
     void setContinuousRendering(bool isContinuous) override;
     FontSourceHandle systemFont(const std::string& name, const std::string& weight, const std::string& face) const override;
     std::vector<FontSourceHandle> systemFontFallbacksHandle() const override;
+    std::shared_ptr<MappedResource> mapResource(const Url& url) const override;
     bool startUrlRequestImpl(const Url& url, const HttpOptions& options, const UrlRequestHandle request, UrlRequestId& id) override;
     void cancelUrlRequestImpl(const UrlRequestId id) override;
 
@@ -5,6 +5,8 @@
 #include <android/bitmap.h>
 #include <tangram.h>
 
+#include <cstring>
+
 namespace Tangram {
 
 AndroidMap* androidMapFromJava(JNIEnv* env, jobject nativeMapObject) {
@@ -29,6 +31,114 @@ std::vector<Tangram::SceneUpdate> unpackSceneUpdates(JNIEnv* jniEnv, jobjectArra
     return sceneUpdates;
 }
 
+// Reads the flat feature layout written by FeatureBuffer.java from the memory of a direct
+// ByteBuffer, in native byte order:
+//   int32 feature count, then for each feature
+//   int32 point count, int32 ring count, int32 property count,
+//   int32 point count of each ring,
+//   int32 byte length and UTF-8 bytes of the key and of the value of each property,
+//   float64 longitude and latitude of each point
+// Features with rings are polygons, others with more than one point polylines.
+struct BufferReader {
+    const char* pos = nullptr;
+    const char* end = nullptr;
+
+    BufferReader(JNIEnv* env, jobject buffer, jint length) {
+        auto* data = static_cast<const char*>(env->GetDirectBufferAddress(buffer));
+        jlong capacity = env->GetDirectBufferCapacity(buffer);
+        if (data && capacity >= 0) {
+            pos = data;
+            end = data + std::min(static_cast<jlong>(length), capacity);
+        }
+    }
+
+    template<typename T>
+    bool read(T& value) {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) { return false; }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        int32_t length = 0;
+        if (!read(length) || length < 0 || end - pos < length) { return false; }
+        value.assign(pos, static_cast<size_t>(length));
+        pos += length;
+        return true;
+    }
+
+    bool readLngLat(LngLat& point) { return read(point.longitude) && read(point.latitude); }
+};
+
+// Add the next feature of @reader to @source, false when the layout is broken
+bool readClientDataFeature(BufferReader& reader, ClientDataSource& source) {
+    int32_t nPoints = 0, nRings = 0, nProperties = 0;
+    if (!reader.read(nPoints) || !reader.read(nRings) || !reader.read(nProperties) ||
+        nPoints <= 0 || nRings < 0 || nProperties < 0) {
+        return false;
+    }
+
+    std::vector<int32_t> rings(static_cast<size_t>(nRings));
+    int32_t nRingPoints = 0;
+    for (auto& ring : rings) {
+        if (!reader.read(ring) || ring < 0) { return false; }
+        nRingPoints += ring;
+    }
+    if (nRings > 0 && nRingPoints != nPoints) { return false; }
+
+    Properties properties;
+    std::string key, value;
+    for (int32_t i = 0; i < nProperties; i++) {
+        if (!reader.readString(key) || !reader.readString(value)) { return false; }
+        properties.set(key, value);
+    }
+
+    LngLat point;
+    if (nRings > 0) {
+        ClientDataSource::PolygonBuilder builder;
+        builder.beginPolygon(static_cast<size_t>(nRings));
+        for (int32_t ring : rings) {
+            builder.beginRing(static_cast<size_t>(ring));
+            for (int32_t i = 0; i < ring; i++) {
+                if (!reader.readLngLat(point)) { return false; }
+                builder.addPoint(point);
+            }
+        }
+        source.addPolygonFeature(std::move(properties), std::move(builder));
+    } else if (nPoints > 1) {
+        ClientDataSource::PolylineBuilder builder;
+        builder.beginPolyline(static_cast<size_t>(nPoints));
+        for (int32_t i = 0; i < nPoints; i++) {
+            if (!reader.readLngLat(point)) { return false; }
+            builder.addPoint(point);
+        }
+        source.addPolylineFeature(std::move(properties), std::move(builder));
+    } else {
+        if (!reader.readLngLat(point)) { return false; }
+        source.addPointFeature(std::move(properties), point);
+    }
+    return true;
+}
+
+// Points of a direct ByteBuffer of interleaved float64 longitudes and latitudes in native byte
+// order; the buffer memory is used in place when aligned, otherwise copied to @copy.
+// Returns nullptr when the buffer is not direct or holds less than @count points.
+const LngLat* lngLatsFromBuffer(JNIEnv* env, jobject buffer, jint count, std::vector<LngLat>& copy) {
+    static_assert(sizeof(LngLat) == 2 * sizeof(double), "LngLat must be two packed doubles");
+
+    auto* data = static_cast<const char*>(env->GetDirectBufferAddress(buffer));
+    if (!data || count <= 0 || env->GetDirectBufferCapacity(buffer) < jlong(count) * jlong(sizeof(LngLat))) {
+        return nullptr;
+    }
+    if (reinterpret_cast<uintptr_t>(data) % alignof(LngLat) == 0) {
+        return reinterpret_cast<const LngLat*>(data);
+    }
+    copy.resize(static_cast<size_t>(count));
+    std::memcpy(copy.data(), data, copy.size() * sizeof(LngLat));
+    return copy.data();
+}
+
 // JNI wrapper for MapClickListener
 class JniMapClickListener : public MapClickListener {
 public:
@@ -511,6 +621,91 @@ jboolean NATIVE_METHOD(markerSetPointEased)(JNIEnv* env, jobject obj, jlong mark
     return static_cast<jboolean>(result);
 }
 
+jlongArray NATIVE_METHOD(markerAddPoints)(JNIEnv* env, jobject obj, jstring styling, jboolean isPath,
+                                          jdoubleArray jcoordinates, jint count) {
+    auto* map = androidMapFromJava(env, obj);
+
+    if (!jcoordinates || count <= 0) { return env->NewLongArray(0); }
+
+    auto stylingString = JniHelpers::stringFromJavaString(env, styling);
+    auto* coordinates = env->GetDoubleArrayElements(jcoordinates, nullptr);
+    std::vector<Tangram::LngLat> points;
+    points.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        points.emplace_back(coordinates[2 * i], coordinates[2 * i + 1]);
+    }
+    env->ReleaseDoubleArrayElements(jcoordinates, coordinates, JNI_ABORT);
+
+    std::vector<Tangram::MarkerID> markerIDs(static_cast<size_t>(count));
+    map->markerAddPoints(stylingString.c_str(), isPath, points.data(), nullptr, count, markerIDs.data());
+
+    std::vector<jlong> ids(markerIDs.begin(), markerIDs.end());
+    jlongArray jids = env->NewLongArray(count);
+    env->SetLongArrayRegion(jids, 0, count, ids.data());
+    return jids;
+}
+
+jlongArray NATIVE_METHOD(markerAddPointsBuffer)(JNIEnv* env, jobject obj, jstring styling, jboolean isPath,
+                                                jobject jcoordinates, jint count) {
+    auto* map = androidMapFromJava(env, obj);
+
+    std::vector<Tangram::LngLat> copy;
+    auto* points = lngLatsFromBuffer(env, jcoordinates, count, copy);
+    if (!points) { return env->NewLongArray(0); }
+
+    auto stylingString = JniHelpers::stringFromJavaString(env, styling);
+    std::vector<Tangram::MarkerID> markerIDs(static_cast<size_t>(count));
+    map->markerAddPoints(stylingString.c_str(), isPath, points, nullptr, count, markerIDs.data());
+
+    std::vector<jlong> ids(markerIDs.begin(), markerIDs.end());
+    jlongArray jids = env->NewLongArray(count);
+    env->SetLongArrayRegion(jids, 0, count, ids.data());
+    return jids;
+}
+
+jint NATIVE_METHOD(markerSetPoints)(JNIEnv* env, jobject obj, jlongArray jmarkerIDs,
+                                    jdoubleArray jcoordinates, jint count) {
+    auto* map = androidMapFromJava(env, obj);
+
+    if (!jmarkerIDs || !jcoordinates || count <= 0) { return 0; }
+
+    std::vector<jlong> ids(static_cast<size_t>(count));
+    env->GetLongArrayRegion(jmarkerIDs, 0, count, ids.data());
+    std::vector<Tangram::MarkerID> markerIDs(ids.begin(), ids.end());
+
+    auto* coordinates = env->GetDoubleArrayElements(jcoordinates, nullptr);
+    std::vector<Tangram::LngLat> points;
+    points.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        points.emplace_back(coordinates[2 * i], coordinates[2 * i + 1]);
+    }
+    env->ReleaseDoubleArrayElements(jcoordinates, coordinates, JNI_ABORT);
+
+    return map->markerSetPoints(markerIDs.data(), points.data(), nullptr, count);
+}
+
+jint NATIVE_METHOD(markerSetPointsBuffer)(JNIEnv* env, jobject obj, jobject jmarkerIDs,
+                                          jobject jcoordinates, jint count) {
+    auto* map = androidMapFromJava(env, obj);
+
+    std::vector<Tangram::LngLat> copy;
+    auto* points = lngLatsFromBuffer(env, jcoordinates, count, copy);
+    auto* ids = static_cast<const char*>(env->GetDirectBufferAddress(jmarkerIDs));
+    if (!points || !ids || env->GetDirectBufferCapacity(jmarkerIDs) < jlong(count) * jlong(sizeof(jlong))) {
+        return 0;
+    }
+
+    // Marker IDs are int64 in Java and uint32 in Map
+    std::vector<Tangram::MarkerID> markerIDs(static_cast<size_t>(count));
+    for (size_t i = 0; i < markerIDs.size(); i++) {
+        jlong id;
+        std::memcpy(&id, ids + i * sizeof(jlong), sizeof(jlong));
+        markerIDs[i] = static_cast<Tangram::MarkerID>(id);
+    }
+
+    return map->markerSetPoints(markerIDs.data(), points, nullptr, count);
+}
+
 jboolean NATIVE_METHOD(markerSetPolyline)(JNIEnv* env, jobject obj, jlong markerID,
                                           jdoubleArray jcoordinates, jint count) {
     auto* map = androidMapFromJava(env, obj);
@@ -529,6 +724,26 @@ jboolean NATIVE_METHOD(markerSetPolyline)(JNIEnv* env, jobject obj, jlong marker
     return static_cast<jboolean>(result);
 }
 
+jboolean NATIVE_METHOD(markerSetPolylineBuffer)(JNIEnv* env, jobject obj, jlong markerID,
+                                                jobject jcoordinates, jint count) {
+    auto* map = androidMapFromJava(env, obj);
+
+    std::vector<Tangram::LngLat> copy;
+    auto* polyline = lngLatsFromBuffer(env, jcoordinates, count, copy);
+    if (!polyline) { return static_cast<jboolean>(false); }
+
+    auto result = map->markerSetPolyline(static_cast<unsigned int>(markerID), polyline, count);
+    return static_cast<jboolean>(result);
+}
+
+jboolean NATIVE_METHOD(markerSetPolylineTrim)(JNIEnv* env, jobject obj, jlong markerID,
+                                              jint index, jfloat fraction) {
+    auto* map = androidMapFromJava(env, obj);
+
+    auto result = map->markerSetPolylineTrim(static_cast<unsigned int>(markerID), index, fraction);
+    return static_cast<jboolean>(result);
+}
+
 jboolean NATIVE_METHOD(markerSetPolygon)(JNIEnv* env, jobject obj, jlong markerID,
                                          jdoubleArray jcoordinates, jintArray jcounts, jint rings) {
     auto* map = androidMapFromJava(env, obj);
@@ -587,6 +802,11 @@ void NATIVE_METHOD(useCachedGlState)(JNIEnv* env, jobject obj, jboolean use) {
     map->useCachedGlState(use);
 }
 
+void NATIVE_METHOD(setRetainedDataBudget)(JNIEnv* env, jobject obj, jlong bytes) {
+    auto* map = androidMapFromJava(env, obj);
+    map->setRetainedDataBudget(bytes > 0 ? size_t(bytes) : 0);
+}
+
 void NATIVE_METHOD(setDefaultBackgroundColor)(JNIEnv* env, jobject obj,
                                               jfloat r, jfloat g, jfloat b) {
     auto* map = androidMapFromJava(env, obj);
@@ -667,6 +887,21 @@ void NATIVE_METHOD(addClientDataFeature)(JNIEnv* env, jobject obj, jlong javaSou
     env->ReleaseDoubleArrayElements(javaCoordinates, coordinates, JNI_ABORT);
 }
 
+jint NATIVE_METHOD(addClientDataFeatures)(JNIEnv* env, jobject obj, jlong javaSourcePtr,
+                                          jobject buffer, jint length) {
+    auto* source = reinterpret_cast<ClientDataSource*>(javaSourcePtr);
+
+    BufferReader reader(env, buffer, length);
+    int32_t nFeatures = 0;
+    if (!reader.read(nFeatures) || nFeatures < 0) { return -1; }
+
+    for (int32_t i = 0; i < nFeatures; i++) {
+        // Features read before a broken one are kept
+        if (!readClientDataFeature(reader, *source)) { return -1; }
+    }
+    return nFeatures;
+}
+
 void NATIVE_METHOD(addClientDataGeoJson)(JNIEnv* env, jobject obj, jlong javaSourcePtr, jstring javaGeoJson) {
     auto* source = reinterpret_cast<ClientDataSource*>(javaSourcePtr);
     auto data = JniHelpers::stringFromJavaString(env, javaGeoJson);
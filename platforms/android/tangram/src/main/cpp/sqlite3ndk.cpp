@@ -421,6 +421,55 @@ static int ndkFileDeviceCharacteristics(sqlite3_file *)
 	return 0;
 }
 
+/*
+ * sqlite3_file.xShmMap - shared memory is only needed for WAL databases, which can't be written here
+ */
+static int ndkFileShmMap(sqlite3_file *, int, int, int, void volatile **)
+{
+	return SQLITE_IOERR_SHMMAP;
+}
+
+static int ndkFileShmLock(sqlite3_file *, int, int, int)
+{
+	return SQLITE_OK;
+}
+
+static void ndkFileShmBarrier(sqlite3_file *)
+{
+}
+
+static int ndkFileShmUnmap(sqlite3_file *, int)
+{
+	return SQLITE_OK;
+}
+
+/*
+ * sqlite3_file.xFetch - return pages directly from the asset buffer (see AAsset_getBuffer in
+ * ndkOpen), so that databases read with PRAGMA mmap_size skip the copy of ndkFileRead
+ */
+static int ndkFileFetch(sqlite3_file *pFile, sqlite3_int64 offset, int amt, void **pp)
+{
+	ndk_file *file = (ndk_file*) pFile;
+
+	if (offset >= 0 && offset + amt <= file->len)
+	{
+		*pp = (void*) ((const char*) file->buf + offset);
+	}
+	else
+	{
+		*pp = 0;
+	}
+	return SQLITE_OK;
+}
+
+/*
+ * sqlite3_file.xUnfetch - nothing to release, the buffer lives as long as the file
+ */
+static int ndkFileUnfetch(sqlite3_file *, sqlite3_int64, void *)
+{
+	return SQLITE_OK;
+}
+
 /*
  * Register into SQLite. For more information see sqlite3ndk.h
  */
@@ -460,7 +509,7 @@ int sqlite3_ndk_init(AAssetManager* assetMgr, const char* vfsName,
 	// vfsFile
 	static const sqlite3_io_methods ndkFileMethods =
 	{
-		1,
+		3,
 		ndkFileClose,
 		ndkFileRead,
 		ndkFileWrite,
@@ -472,7 +521,13 @@ int sqlite3_ndk_init(AAssetManager* assetMgr, const char* vfsName,
 		ndkFileCheckReservedLock,
 		ndkFileControl,
 		ndkFileSectorSize,
-		ndkFileDeviceCharacteristics
+		ndkFileDeviceCharacteristics,
+		ndkFileShmMap,
+		ndkFileShmLock,
+		ndkFileShmBarrier,
+		ndkFileShmUnmap,
+		ndkFileFetch,
+		ndkFileUnfetch
 	};
 
 	// pMethods will be used in ndkOpen
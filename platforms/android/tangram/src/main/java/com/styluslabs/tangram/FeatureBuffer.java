@@ -0,0 +1,180 @@
+package com.styluslabs.tangram;
+
+import com.styluslabs.tangram.geometry.Geometry;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.util.Map;
+
+import androidx.annotation.NonNull;
+import androidx.annotation.Nullable;
+
+/**
+ * {@code FeatureBuffer} collects features for a {@link MapData} in native memory, so that they
+ * are passed to the map with one call and read without copies or string conversions.
+ * <p>
+ * Features are written to a direct {@link ByteBuffer} in native byte order: the number of
+ * features, then for each feature the number of points, rings and properties, the number of
+ * points of each ring, the UTF-8 bytes of each property key and value with their lengths, and
+ * the longitude and latitude of each point. Features with rings are polygons, other features
+ * with more than one point polylines.
+ */
+public class FeatureBuffer {
+
+    private static final int HEADER_SIZE = 4;
+
+    private ByteBuffer buffer;
+    private int featureCount;
+
+    /**
+     * Create an empty {@code FeatureBuffer}
+     * @param capacity Initial capacity in bytes; the buffer grows as features are added
+     */
+    public FeatureBuffer(final int capacity) {
+        buffer = allocate(Math.max(capacity, HEADER_SIZE));
+        clear();
+    }
+
+    public FeatureBuffer() {
+        this(64 * 1024);
+    }
+
+    /**
+     * Remove all features, keeping the allocated memory
+     */
+    public void clear() {
+        buffer.clear();
+        buffer.putInt(0);
+        featureCount = 0;
+    }
+
+    /**
+     * @return The number of features added since the buffer was created or cleared
+     */
+    public int getFeatureCount() {
+        return featureCount;
+    }
+
+    /**
+     * Add a feature of a {@link Geometry}
+     * @param geometry The geometry and properties of the feature
+     * @return This buffer
+     */
+    @NonNull
+    public FeatureBuffer add(@NonNull final Geometry geometry) {
+        return add(geometry.getCoordinateArray(), geometry.getRingArray(), geometry.getPropertyArray());
+    }
+
+    /**
+     * Add a point feature
+     * @param point The position of the feature
+     * @param properties The properties of the feature; may be null
+     * @return This buffer
+     */
+    @NonNull
+    public FeatureBuffer addPoint(@NonNull final LngLat point, @Nullable final Map<String, String> properties) {
+        return add(new double[] { point.longitude, point.latitude }, null, toArray(properties));
+    }
+
+    /**
+     * Add a polyline feature
+     * @param coordinates Longitude and latitude of each point, interleaved
+     * @param properties The properties of the feature; may be null
+     * @return This buffer
+     */
+    @NonNull
+    public FeatureBuffer addPolyline(@NonNull final double[] coordinates, @Nullable final Map<String, String> properties) {
+        return add(coordinates, null, toArray(properties));
+    }
+
+    /**
+     * Add a polygon feature
+     * @param coordinates Longitude and latitude of each point of all rings, interleaved
+     * @param rings Number of points of each ring; the first ring is the exterior
+     * @param properties The properties of the feature; may be null
+     * @return This buffer
+     */
+    @NonNull
+    public FeatureBuffer addPolygon(@NonNull final double[] coordinates, @NonNull final int[] rings,
+                                    @Nullable final Map<String, String> properties) {
+        return add(coordinates, rings, toArray(properties));
+    }
+
+    /**
+     * For package-internal use only; the buffer with the features, valid until more are added
+     */
+    @NonNull
+    ByteBuffer getBuffer() {
+        buffer.putInt(0, featureCount);
+        return buffer;
+    }
+
+    /**
+     * For package-internal use only; the number of bytes written to the buffer
+     */
+    int getLength() {
+        return buffer.position();
+    }
+
+    @NonNull
+    private FeatureBuffer add(@NonNull final double[] coordinates, @Nullable final int[] rings,
+                              @Nullable final String[] properties) {
+        final int points = coordinates.length / 2;
+        final int ringCount = rings == null ? 0 : rings.length;
+        final int propertyCount = properties == null ? 0 : properties.length / 2;
+
+        final byte[][] strings = new byte[propertyCount * 2][];
+        int size = 4 * (3 + ringCount) + 16 * points;
+        for (int i = 0; i < strings.length; i++) {
+            strings[i] = properties[i].getBytes(StandardCharsets.UTF_8);
+            size += 4 + strings[i].length;
+        }
+        reserve(size);
+
+        buffer.putInt(points);
+        buffer.putInt(ringCount);
+        buffer.putInt(propertyCount);
+        for (int i = 0; i < ringCount; i++) {
+            buffer.putInt(rings[i]);
+        }
+        for (final byte[] string : strings) {
+            buffer.putInt(string.length);
+            buffer.put(string);
+        }
+        for (int i = 0; i < 2 * points; i++) {
+            buffer.putDouble(coordinates[i]);
+        }
+        featureCount++;
+        return this;
+    }
+
+    private void reserve(final int size) {
+        if (buffer.remaining() >= size) {
+            return;
+        }
+        final ByteBuffer grown = allocate(Math.max(buffer.capacity() * 2, buffer.position() + size));
+        buffer.flip();
+        grown.put(buffer);
+        buffer = grown;
+    }
+
+    @NonNull
+    private static ByteBuffer allocate(final int capacity) {
+        return ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder());
+    }
+
+    @Nullable
+    private static String[] toArray(@Nullable final Map<String, String> properties) {
+        if (properties == null) {
+            return null;
+        }
+        final String[] out = new String[properties.size() * 2];
+        int i = 0;
+        for (final Map.Entry<String, String> entry : properties.entrySet()) {
+            out[i++] = entry.getKey();
+            out[i++] = entry.getValue();
+        }
+        return out;
+    }
+}
@@ -19,6 +19,8 @@ import com.styluslabs.tangram.networking.DefaultHttpHandler;
 import com.styluslabs.tangram.networking.HttpHandler;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
 import java.util.Collections;
 import java.util.HashMap;
 import java.util.List;
@@ -837,6 +839,80 @@ public class MapController {
         return marker;
     }
 
+    /**
+     * Adds point {@link Marker}s at many positions at once, all with the same styling; much faster than
+     * adding and styling each marker on its own, e.g. for thousands of vehicles.
+     * @param styling YAML draw rule, or path to a draw rule in the scene if isPath is set
+     * @param isPath Whether styling is a path
+     * @param coordinates Longitude and latitude of each marker, interleaved
+     * @return Newly created {@link Marker} objects, in the order of the coordinates.
+     */
+    @NonNull
+    public List<Marker> addPointMarkers(@NonNull final String styling, final boolean isPath,
+                                        @NonNull final double[] coordinates) {
+        final long[] markerIds = nativeMap.markerAddPoints(styling, isPath, coordinates, coordinates.length / 2);
+
+        final Context context = viewHolder.getView().getContext();
+        final List<Marker> added = new ArrayList<>(markerIds.length);
+        for (final long markerId : markerIds) {
+            final Marker marker = new Marker(context, markerId, this);
+            markers.put(markerId, marker);
+            added.add(marker);
+        }
+        return added;
+    }
+
+    /**
+     * Adds point {@link Marker}s at many positions at once, like
+     * {@link #addPointMarkers(String, boolean, double[])}, with the coordinates read in place
+     * from native memory.
+     * @param styling YAML draw rule, or path to a draw rule in the scene if isPath is set
+     * @param isPath Whether styling is a path
+     * @param coordinates Direct buffer in native byte order with the longitude and latitude of
+     * each marker as interleaved doubles
+     * @param count Number of markers
+     * @return Newly created {@link Marker} objects, in the order of the coordinates.
+     */
+    @NonNull
+    public List<Marker> addPointMarkers(@NonNull final String styling, final boolean isPath,
+                                        @NonNull final ByteBuffer coordinates, final int count) {
+        final long[] markerIds = nativeMap.markerAddPointsBuffer(styling, isPath, coordinates, count);
+
+        final Context context = viewHolder.getView().getContext();
+        final List<Marker> added = new ArrayList<>(markerIds.length);
+        for (final long markerId : markerIds) {
+            final Marker marker = new Marker(context, markerId, this);
+            markers.put(markerId, marker);
+            added.add(marker);
+        }
+        return added;
+    }
+
+    /**
+     * Moves many point {@link Marker}s at once.
+     * @param markerIds Ids of the markers to move
+     * @param coordinates Longitude and latitude of each marker, interleaved
+     * @return Number of markers that were found and moved
+     */
+    public int setMarkerPoints(@NonNull final long[] markerIds, @NonNull final double[] coordinates) {
+        final int count = Math.min(markerIds.length, coordinates.length / 2);
+        return nativeMap.markerSetPoints(markerIds, coordinates, count);
+    }
+
+    /**
+     * Moves many point {@link Marker}s at once, with ids and coordinates read in place from
+     * native memory, e.g. for positions updated in a direct buffer every frame.
+     * @param markerIds Direct buffer in native byte order with the id of each marker as a long
+     * @param coordinates Direct buffer in native byte order with the longitude and latitude of
+     * each marker as interleaved doubles
+     * @param count Number of markers
+     * @return Number of markers moved
+     */
+    public int setMarkerPoints(@NonNull final ByteBuffer markerIds, @NonNull final ByteBuffer coordinates,
+                               final int count) {
+        return nativeMap.markerSetPointsBuffer(markerIds, coordinates, count);
+    }
+
     /**
      * Removes the passed in {@link Marker} from the map.
      * Alias of Marker{@link #removeMarker(long)}
@@ -984,6 +1060,15 @@ public class MapController {
         nativeMap.useCachedGlState(use);
     }
 
+    /**
+     * Keep compressed copies of uploaded tile geometry and textures in memory, so that the map
+     * is restored from them after the OpenGL context was lost instead of loading its tiles again.
+     * @param bytes Memory for the copies, shared by all maps; 0 disables them (default)
+     */
+    public void setRetainedDataBudget(final long bytes) {
+        nativeMap.setRetainedDataBudget(bytes);
+    }
+
     /**
      * Sets an opaque background color used as default color when a scene is being loaded
      * @param red red component of the background color
@@ -1056,6 +1141,16 @@ public class MapController {
         return nativeMap.markerSetPolyline(markerId, coordinates, count);
     }
 
+    boolean setMarkerPolyline(final long markerId, final ByteBuffer coordinates, final int count) {
+        checkId(markerId);
+        return nativeMap.markerSetPolylineBuffer(markerId, coordinates, count);
+    }
+
+    boolean setMarkerPolylineTrim(final long markerId, final int index, final float fraction) {
+        checkId(markerId);
+        return nativeMap.markerSetPolylineTrim(markerId, index, fraction);
+    }
+
     boolean setMarkerPolygon(final long markerId, final double[] coordinates, final int[] rings, final int count) {
         checkId(markerId);
         return nativeMap.markerSetPolygon(markerId, coordinates, rings, count);
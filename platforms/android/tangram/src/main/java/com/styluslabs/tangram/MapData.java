@@ -35,14 +35,27 @@ public class MapData {
     public void setFeatures(@NonNull final List<Geometry> features) {
         checkPointer(pointer);
         final NativeMap nativeMap = mapController.nativeMap;
-        nativeMap.clearClientDataFeatures(pointer);
+        final FeatureBuffer buffer = new FeatureBuffer();
         for (Geometry feature : features) {
-            nativeMap.addClientDataFeature(pointer,
-                    feature.getCoordinateArray(),
-                    feature.getRingArray(),
-                    feature.getPropertyArray());
+            buffer.add(feature);
         }
+        setFeatures(buffer);
+    }
+
+    /**
+     * Assign the features of a {@link FeatureBuffer} to this data collection, passed to the map
+     * with one call. This replaces any previously assigned feature lists or GeoJSON data.
+     * @param features The features to assign; the buffer may be cleared and reused afterwards
+     */
+    public void setFeatures(@NonNull final FeatureBuffer features) {
+        checkPointer(pointer);
+        final NativeMap nativeMap = mapController.nativeMap;
+        nativeMap.clearClientDataFeatures(pointer);
+        final int added = nativeMap.addClientDataFeatures(pointer, features.getBuffer(), features.getLength());
         nativeMap.generateClientDataTiles(pointer);
+        if (added < 0) {
+            throw new IllegalArgumentException("Invalid feature in FeatureBuffer");
+        }
     }
 
     /**
@@ -9,6 +9,8 @@ import android.graphics.drawable.Drawable;
 import com.styluslabs.tangram.geometry.Polygon;
 import com.styluslabs.tangram.geometry.Polyline;
 
+import java.nio.ByteBuffer;
+
 import androidx.annotation.Keep;
 import androidx.annotation.NonNull;
 import androidx.annotation.Nullable;
@@ -166,6 +168,30 @@ public class Marker {
                 polyline.getCoordinateArray().length/2);
     }
 
+    /**
+     * Sets the polyline to be displayed, read in place from native memory. When using this
+     * method, a 'polyline' style must also be set. See {@link Marker#setStylingFromString(String)}.
+     * @param coordinates Direct buffer in native byte order with the longitude and latitude of
+     * each point as interleaved doubles
+     * @param count Number of points
+     * @return whether the polyline was successfully set
+     */
+    public boolean setPolyline(@NonNull final ByteBuffer coordinates, final int count) {
+        return map.setMarkerPolyline(markerId, coordinates, count);
+    }
+
+    /**
+     * Hides the start of the polyline up to a fraction of the way from one of its points to the
+     * next, e.g. the part of a route already traveled, without rebuilding the marker. Only applies
+     * to styles with texture coordinates ('texcoords: true').
+     * @param index Index of the point in the polyline, or -1 to show the whole polyline
+     * @param fraction Fraction of the segment after the point to hide
+     * @return whether the trim was successfully set
+     */
+    public boolean setPolylineTrim(final int index, final float fraction) {
+        return map.setMarkerPolylineTrim(markerId, index, fraction);
+    }
+
     /**
      * Sets the polygon to be displayed. When using this method, a 'polygon' style must also be
      * set. See {@link Marker#setStylingFromString(String)}.
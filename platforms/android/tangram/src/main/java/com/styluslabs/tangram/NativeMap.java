@@ -5,6 +5,8 @@ import android.graphics.Bitmap;
 import android.graphics.PointF;
 import android.graphics.Rect;
 
+import java.nio.ByteBuffer;
+
 class NativeMap {
 
     NativeMap(MapController mapController, AssetManager assetManager) {
@@ -70,12 +72,20 @@ class NativeMap {
     native synchronized boolean markerSetBitmap(long markerID, Bitmap bitmap, float density);
     native synchronized boolean markerSetPoint(long markerID, double lng, double lat);
     native synchronized boolean markerSetPointEased(long markerID, double lng, double lat, float duration, int ease);
+    native synchronized long[] markerAddPoints(String styling, boolean isPath, double[] coordinates, int count);
+    native synchronized int markerSetPoints(long[] markerIDs, double[] coordinates, int count);
     native synchronized boolean markerSetPolyline(long markerID, double[] coordinates, int count);
+    // Direct buffers in native byte order, read in place, see FeatureBuffer
+    native synchronized long[] markerAddPointsBuffer(String styling, boolean isPath, ByteBuffer coordinates, int count);
+    native synchronized int markerSetPointsBuffer(ByteBuffer markerIDs, ByteBuffer coordinates, int count);
+    native synchronized boolean markerSetPolylineBuffer(long markerID, ByteBuffer coordinates, int count);
+    native synchronized boolean markerSetPolylineTrim(long markerID, int index, float fraction);
     native synchronized boolean markerSetPolygon(long markerID, double[] coordinates, int[] rings, int count);
     native synchronized boolean markerSetVisible(long markerID, boolean visible);
     native synchronized boolean markerSetDrawOrder(long markerID, int drawOrder);
     native synchronized void markerRemoveAll();
     native synchronized void useCachedGlState(boolean use);
+    native synchronized void setRetainedDataBudget(long bytes);
     native synchronized void setDefaultBackgroundColor(float r, float g, float b);
 
     native synchronized void setDpi(float dpi);
@@ -88,6 +98,7 @@ class NativeMap {
     native synchronized long addClientDataSource(String name, boolean generateCentroid);
     native synchronized void removeClientDataSource(long sourcePtr);
     native synchronized void addClientDataFeature(long sourcePtr, double[] coordinates, int[] rings, String[] properties);
+    native synchronized int addClientDataFeatures(long sourcePtr, ByteBuffer features, int length);
     native synchronized void addClientDataGeoJson(long sourcePtr, String geoJson);
     native synchronized void generateClientDataTiles(long sourcePtr);
     native synchronized void clearClientDataFeatures(long sourcePtr);
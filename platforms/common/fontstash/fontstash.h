@@ -59,6 +59,9 @@ struct FONSparams {
   void (*userSDFRender)(void* uptr, void* fontimpl, unsigned char* output,
       int outWidth, int outHeight, int outStride, float scale, int padding, int glyph);
   void (*userDelete)(void* uptr);
+  // prebuilt SDF bitmap of glyph, written like userSDFRender; return 0 to have the glyph rendered
+  int (*userGlyphSDF)(void* uptr, void* fontimpl, unsigned char* output,
+      int outWidth, int outHeight, int outStride, int glyph);
 };
 typedef struct FONSparams FONSparams;
 
@@ -161,6 +164,11 @@ int fonsBreakLines(FONSstate* state, const char* string, const char* end, float
 const void* fonsGetTextureData(FONScontext* stash, int* width, int* height);
 int fonsValidateTexture(FONScontext* s, int* dirty);
 
+// SDF bitmap of codepoint in font (not its fallbacks), laid out as the atlas cell of the glyph; NULL if
+//  the font has no such glyph or it is empty.  Caller must free() the bitmap
+unsigned char* fonsRenderGlyphSDF(FONScontext* stash, int font, unsigned int codepoint,
+    int* glyph, int* width, int* height);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1011,7 +1019,10 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, int fontid, unsigned int co
         fons__tt_renderGlyphBitmapSummed(&font->font, dst, cellw - pad, cellh - pad, stash->atlas->width, scale, g);
       } else if (stash->params.flags & FONS_SDF) {
         FONStexelU8* dst = (FONStexelU8*)stash->texData + (gx + gy*stash->atlas->width);
-        if (stash->params.userSDFRender)
+        if (stash->params.userGlyphSDF && stash->params.userGlyphSDF(stash->params.userPtr,
+              &font->font, dst, cellw, cellh, stash->atlas->width, g))
+          ;  // prebuilt
+        else if (stash->params.userSDFRender)
           stash->params.userSDFRender(stash->params.userPtr,
               &font->font, dst, cellw, cellh, stash->atlas->width, scale, pad, g);
         else
@@ -1277,6 +1288,45 @@ int fonsValidateTexture(FONScontext* stash, int* dirty)
   return 0;
 }
 
+unsigned char* fonsRenderGlyphSDF(FONScontext* stash, int fontid, unsigned int codepoint,
+    int* glyph, int* width, int* height)
+{
+  int g, advance, lsb, x0, y0, x1, y1, cellw, cellh;
+  float scale;
+  FONSfont* font;
+  unsigned char* bitmap;
+  float size = stash->atlasFontPx > 0 ? stash->atlasFontPx : FONS_DEFAULT_PX;
+  int pad = stash->params.sdfPadding + 1;
+
+  if (!(stash->params.flags & FONS_SDF) || fontid < 0 || fontid >= stash->nfonts) return NULL;
+  font = stash->fonts[fontid];
+  if (font->data && !font->dataSize)
+    fons__loadFont(stash, fontid);
+  if (!font->data) return NULL;
+  stash->nscratch = 0;
+
+  g = fons__tt_getGlyphIndex(&font->font, codepoint);
+  if (g == 0) return NULL;
+  // same cell as fons__getGlyph
+  scale = fons__tt_getPixelHeightScale(&font->font, size);
+  fons__tt_buildGlyphBitmap(&font->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
+  if (x1 <= x0 || y1 <= y0) return NULL;
+  cellw = x1-x0 + 2*pad;
+  cellh = y1-y0 + 2*pad;
+
+  bitmap = (unsigned char*)calloc(cellw*cellh, 1);
+  if (bitmap == NULL) return NULL;
+  if (stash->params.userSDFRender)
+    stash->params.userSDFRender(stash->params.userPtr, &font->font, bitmap, cellw, cellh, cellw, scale, pad, g);
+  else
+    fons__tt_renderGlyphBitmapSDF(&font->font, bitmap, cellw, cellh, cellw, scale, pad, stash->params.sdfPixelDist, g);
+
+  *glyph = g;
+  *width = cellw;
+  *height = cellh;
+  return bitmap;
+}
+
 void fonsDeleteInternal(FONScontext* stash)
 {
   int i;
@@ -14,8 +14,10 @@
 #include <GLFW/glfw3.h>
 #include <cstdlib>
 #include <atomic>
+#include <fstream>
 #include "gl.h"
 
+#include "gl/texture.h"
 #include "util/elevationManager.h"
 #include "util/asyncWorker.h"
 
@@ -86,6 +88,7 @@ double last_y_velocity = 0.0;
 bool wireframe_mode = false;
 bool show_gui = true;
 bool load_async = true;
+bool recording_session = false;
 bool add_point_marker_on_click = false;
 bool add_polyline_marker_on_click = false;
 bool point_markers_position_clipped = false;
@@ -201,6 +204,13 @@ void create(std::unique_ptr<Platform> p, int w, int h) {
     offscreenWorker->enqueue([=](){ glfwMakeContextCurrent(glfwOffscreen); });
     ElevationManager::offscreenWorker = std::move(offscreenWorker);
 
+    // Raster tile textures are uploaded on a context of their own, so that they do not wait
+    //  for terrain depth rendering on the offscreen worker
+    GLFWwindow* glfwUpload = glfwCreateWindow(1, 1, "Upload", NULL, main_window);
+    auto uploadWorker = std::make_unique<AsyncWorker>("Texture upload GL worker");
+    uploadWorker->enqueue([=](){ glfwMakeContextCurrent(glfwUpload); });
+    Texture::uploadWorker = std::move(uploadWorker);
+
     // Make the main_window's context current
     glfwMakeContextCurrent(main_window);
     glfwSwapInterval(1); // Enable vsync
@@ -616,6 +626,17 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
             case GLFW_KEY_W:
                 map->onMemoryWarning();
                 break;
+            case GLFW_KEY_C:
+                // Record a session for tangram-replay
+                if (!recording_session) {
+                    map->startRecording();
+                    LOG("Recording session");
+                } else {
+                    std::ofstream("session.tgrec", std::ios::binary) << map->stopRecording();
+                    LOG("Wrote session.tgrec");
+                }
+                recording_session = !recording_session;
+                break;
             default:
                 break;
         }
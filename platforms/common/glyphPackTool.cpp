@@ -0,0 +1,158 @@
+// Builds glyph packs for FontContext, see core/src/text/glyphPack.h
+//
+// tangram-glyphpack [-s set,...] [-r first-last] -o out.tgpk name=font.ttf [name=font.ttf ...]
+//
+// Fonts are named as they are loaded in the FontContext, i.e. by their scene font alias
+// (family_weight_style) or "default_400_regular", "default-1", ... for fallback fonts.
+
+#include "text/glyphPack.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// fontstash relies on the C headers above
+#define FONTSTASH_IMPLEMENTATION
+#include "fontstash/fontstash.h"
+
+using namespace Tangram;
+
+using Range = std::pair<unsigned int, unsigned int>;
+
+// Must match FontContext::glyphPackParams(); FontContext ignores packs built with other options
+static const int SDF_WIDTH = 6;
+static const int ATLAS_FONT_PX = 32;
+
+static bool codepointSet(const std::string& _name, std::vector<Range>& _ranges) {
+    if (_name == "latin") {
+        _ranges.push_back({ 0x20, 0x7E });
+        _ranges.push_back({ 0xA0, 0x24F });
+    } else if (_name == "greek") {
+        _ranges.push_back({ 0x370, 0x3FF });
+    } else if (_name == "cyrillic") {
+        _ranges.push_back({ 0x400, 0x4FF });
+    } else if (_name == "kana") {
+        _ranges.push_back({ 0x3000, 0x30FF });
+    } else if (_name == "cjk") {
+        _ranges.push_back({ 0x3000, 0x30FF });
+        _ranges.push_back({ 0x4E00, 0x9FFF });
+        _ranges.push_back({ 0xFF00, 0xFFEF });
+    } else if (_name == "hangul") {
+        _ranges.push_back({ 0xAC00, 0xD7A3 });
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: tangram-glyphpack [-s set,...] [-r first-last] -o out.tgpk name=font.ttf ...\n"
+                    "  sets: latin, greek, cyrillic, kana, cjk, hangul (default latin,cyrillic)\n"
+                    "  ranges are hexadecimal codepoints, e.g. -r 4E00-4FFF\n");
+}
+
+int main(int argc, char* argv[]) {
+
+    std::vector<Range> ranges;
+    std::vector<std::pair<std::string, std::string>> fonts;
+    std::string output;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-s" || arg == "-r" || arg == "-o") && i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "-s") {
+            std::string sets = argv[++i];
+            size_t start = 0;
+            while (start <= sets.size()) {
+                size_t end = std::min(sets.find(',', start), sets.size());
+                if (!codepointSet(sets.substr(start, end - start), ranges)) {
+                    fprintf(stderr, "Unknown codepoint set in %s\n", sets.c_str());
+                    return 1;
+                }
+                start = end + 1;
+            }
+        } else if (arg == "-r") {
+            unsigned int first = 0, last = 0;
+            if (sscanf(argv[++i], "%x-%x", &first, &last) != 2 || last < first) {
+                usage();
+                return 1;
+            }
+            ranges.push_back({ first, last });
+        } else if (arg == "-o") {
+            output = argv[++i];
+        } else {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos || eq == 0) {
+                usage();
+                return 1;
+            }
+            fonts.push_back({ arg.substr(0, eq), arg.substr(eq + 1) });
+        }
+    }
+    if (output.empty() || fonts.empty()) {
+        usage();
+        return 1;
+    }
+    if (ranges.empty()) {
+        codepointSet("latin", ranges);
+        codepointSet("cyrillic", ranges);
+    }
+
+    GlyphPack::Params packParams;
+    packParams.atlasFontPx = ATLAS_FONT_PX;
+    packParams.sdfPadding = SDF_WIDTH * 2;
+    packParams.sdfPixelDist = 128.0f/SDF_WIDTH/2;
+
+    FONSparams params;
+    memset(&params, 0, sizeof(FONSparams));
+    params.flags = FONS_SDF | FONS_ZERO_TOPLEFT;
+    params.sdfPadding = packParams.sdfPadding;
+    params.sdfPixelDist = packParams.sdfPixelDist;
+
+    GlyphPack::Builder builder(packParams);
+
+    for (auto& font : fonts) {
+        FONScontext* fons = fonsCreateInternal(&params);
+        fonsResetAtlas(fons, 512, 512, ATLAS_FONT_PX);
+
+        int id = fonsAddFont(fons, font.first.c_str(), font.second.c_str());
+        if (id < 0) {
+            fprintf(stderr, "Cannot load font %s\n", font.second.c_str());
+            fonsDeleteInternal(fons);
+            return 1;
+        }
+
+        size_t count = builder.glyphCount();
+        for (auto& range : ranges) {
+            for (unsigned int cp = range.first; cp <= range.second; cp++) {
+                int glyph = 0, width = 0, height = 0;
+                unsigned char* bitmap = fonsRenderGlyphSDF(fons, id, cp, &glyph, &width, &height);
+                if (!bitmap) { continue; }
+                builder.add(font.first, uint32_t(glyph), width, height, bitmap);
+                free(bitmap);
+            }
+        }
+        fprintf(stderr, "%s: %d glyphs\n", font.first.c_str(), int(builder.glyphCount() - count));
+        fonsDeleteInternal(fons);
+    }
+
+    std::vector<char> pack = builder.build();
+    std::ofstream file(output, std::ios::binary);
+    file.write(pack.data(), pack.size());
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", output.c_str());
+        return 1;
+    }
+    fprintf(stderr, "Wrote %s, %d bytes\n", output.c_str(), int(pack.size()));
+    return 0;
+}
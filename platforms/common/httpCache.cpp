@@ -0,0 +1,338 @@
+#include "httpCache.h"
+
+#include "log.h"
+#include "platform.h" // HttpOptions
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(_WIN32)
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#define HTTP_CACHE_MAGIC 0x48434754 // "TGCH"
+#define HTTP_CACHE_VERSION 1
+#define HTTP_CACHE_SUFFIX ".http"
+
+namespace Tangram {
+
+struct HttpCache::Header {
+    uint32_t magic = HTTP_CACHE_MAGIC;
+    uint32_t version = HTTP_CACHE_VERSION;
+    int64_t stored = 0;
+    int64_t expires = 0;
+    uint32_t keyLength = 0;
+    uint32_t etagLength = 0;
+    uint32_t lastModifiedLength = 0;
+    uint32_t reserved = 0;
+    uint64_t contentLength = 0;
+};
+
+HttpCache::HttpCache(std::string _path, size_t _maxBytes) :
+    m_path(std::move(_path)),
+    m_maxBytes(_maxBytes) {
+
+    if (!m_path.empty() && m_path.back() != '/') { m_path += '/'; }
+
+#if defined(_WIN32)
+    _mkdir(m_path.c_str());
+#else
+    mkdir(m_path.c_str(), 0755);
+#endif
+}
+
+bool HttpCache::isCacheable(const HttpOptions& _options) {
+    return _options.payload.empty();
+}
+
+bool HttpCache::ResponseHeaders::parse(const std::string& _name, const std::string& _value) {
+    if (_name == "cache-control") {
+        std::string value = _value;
+        std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+        size_t pos = value.find("max-age=");
+        if (pos != std::string::npos) {
+            maxAge = strtol(&value[pos+8], NULL, 10);
+        }
+        if (value.find("no-store") != std::string::npos) { noStore = true; }
+        if (value.find("no-cache") != std::string::npos) { noCache = true; }
+    } else if (_name == "expires") {
+        // invalid dates mean 'already expired'
+        expires = std::max<int64_t>(parseDate(_value), 0);
+    } else if (_name == "date") {
+        date = parseDate(_value);
+    } else if (_name == "age") {
+        age = strtol(_value.c_str(), NULL, 10);
+    } else if (_name == "etag") {
+        etag = _value;
+    } else if (_name == "last-modified") {
+        lastModified = _value;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int64_t HttpCache::parseDate(const std::string& _date) {
+    static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    char monthName[4] = {};
+    int day = 0, year = 0, hour = 0, minute = 0, second = 0;
+
+    const char* comma = strchr(_date.c_str(), ',');
+    bool parsed = false;
+    if (comma) {
+        // Sun, 06 Nov 1994 08:49:37 GMT or Sunday, 06-Nov-94 08:49:37 GMT
+        parsed = sscanf(comma + 1, " %d %3s %d %d:%d:%d", &day, monthName, &year, &hour, &minute, &second) == 6 ||
+            sscanf(comma + 1, " %d-%3s-%d %d:%d:%d", &day, monthName, &year, &hour, &minute, &second) == 6;
+    } else {
+        // Sun Nov  6 08:49:37 1994
+        parsed = sscanf(_date.c_str(), "%*s %3s %d %d:%d:%d %d", monthName, &day, &hour, &minute, &second, &year) == 6;
+    }
+    if (!parsed) { return -1; }
+
+    int month = 0;
+    while (month < 12 && strcmp(monthName, months[month]) != 0) { month++; }
+    if (month == 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60 || year < 0) { return -1; }
+    if (year < 100) { year += year < 70 ? 2000 : 1900; }
+
+    // days since epoch of the civil date, see http://howardhinnant.github.io/date_algorithms.html
+    int64_t y = year - (month < 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month < 2 ? month + 10 : month - 2) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = era * 146097 + dayOfEra - 719468;
+
+    return days * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+bool HttpCache::isCacheableStatus(long _status) {
+    return _status == 200 || _status == 203 || _status == 206;
+}
+
+bool HttpCache::updateEntry(Entry& _entry, const ResponseHeaders& _headers, int64_t _now) {
+    if (_headers.noStore) { return false; }
+
+    _entry.stored = _now;
+    if (!_headers.etag.empty()) { _entry.etag = _headers.etag; }
+    if (!_headers.lastModified.empty()) { _entry.lastModified = _headers.lastModified; }
+
+    if (_headers.noCache) {
+        _entry.expires = 0;
+    } else if (_headers.maxAge >= 0) {
+        _entry.expires = _now + std::max<int64_t>(_headers.maxAge - _headers.age, 0);
+    } else if (_headers.expires >= 0) {
+        // relative to the server clock
+        int64_t date = _headers.date >= 0 ? _headers.date : _now;
+        _entry.expires = _now + std::max<int64_t>(_headers.expires - date, 0);
+    } else {
+        // heuristic freshness: 10% of the time since last modification, up to a day (RFC 7234)
+        int64_t modified = _entry.lastModified.empty() ? -1 : parseDate(_entry.lastModified);
+        int64_t date = _headers.date >= 0 ? _headers.date : _now;
+        _entry.expires = 0;
+        if (modified >= 0) {
+            _entry.expires = _now + std::min<int64_t>(std::max<int64_t>(date - modified, 0) / 10, 24 * 3600);
+        }
+    }
+
+    // no use in storing entries that can neither be reused nor revalidated
+    return _entry.expires > _now || _entry.canRevalidate();
+}
+
+std::vector<std::string> HttpCache::revalidationHeaders(const Entry& _entry) {
+    std::vector<std::string> headers;
+    if (!_entry.etag.empty()) { headers.push_back("If-None-Match: " + _entry.etag); }
+    if (!_entry.lastModified.empty()) { headers.push_back("If-Modified-Since: " + _entry.lastModified); }
+    return headers;
+}
+
+std::string HttpCache::key(const std::string& _url, const HttpOptions& _options) {
+    return _options.headers.empty() ? _url : _url + '\n' + _options.headers;
+}
+
+std::string HttpCache::filename(const std::string& _key) const {
+    // 64 bit FNV-1a, stable across sessions unlike std::hash
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : _key) {
+        h ^= uint8_t(c);
+        h *= 1099511628211ULL;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx" HTTP_CACHE_SUFFIX, (unsigned long long)h);
+    return m_path + name;
+}
+
+bool HttpCache::load(const std::string& _url, const HttpOptions& _options, Entry& _entry) const {
+
+    std::string requestKey = key(_url, _options);
+
+    std::string path = filename(requestKey);
+    std::ifstream file(path, std::ifstream::binary | std::ifstream::ate);
+    if (!file.is_open()) { return false; }
+
+    uint64_t fileSize = uint64_t(file.tellg());
+    file.seekg(0);
+
+    Header header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != HTTP_CACHE_MAGIC || header.version != HTTP_CACHE_VERSION) {
+        return false;
+    }
+
+    // check for hash collision
+    if (header.keyLength != requestKey.size()) { return false; }
+    std::string storedKey(header.keyLength, '\0');
+    file.read(&storedKey[0], storedKey.size());
+    if (!file || storedKey != requestKey) { return false; }
+
+    // a truncated or corrupt entry must not allocate more than the file holds
+    uint64_t remaining = fileSize - sizeof(header) - header.keyLength;
+    if (header.etagLength > remaining ||
+        header.lastModifiedLength > remaining - header.etagLength ||
+        header.contentLength > remaining - header.etagLength - header.lastModifiedLength) {
+        LOGW("Invalid HTTP cache entry for url: %s", _url.c_str());
+        file.close();
+        std::remove(path.c_str());
+        return false;
+    }
+
+    _entry.stored = header.stored;
+    _entry.expires = header.expires;
+    _entry.etag.resize(header.etagLength);
+    file.read(&_entry.etag[0], _entry.etag.size());
+    _entry.lastModified.resize(header.lastModifiedLength);
+    file.read(&_entry.lastModified[0], _entry.lastModified.size());
+    _entry.content.resize(header.contentLength);
+    file.read(_entry.content.data(), _entry.content.size());
+
+    if (!file) {
+        LOGW("Invalid HTTP cache entry for url: %s", _url.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool HttpCache::store(const std::string& _url, const HttpOptions& _options, const Entry& _entry) {
+
+    std::string requestKey = key(_url, _options);
+
+    Header header;
+    header.stored = _entry.stored;
+    header.expires = _entry.expires;
+    header.keyLength = uint32_t(requestKey.size());
+    header.etagLength = uint32_t(_entry.etag.size());
+    header.lastModifiedLength = uint32_t(_entry.lastModified.size());
+    header.contentLength = _entry.content.size();
+
+    std::string path = filename(requestKey);
+    std::string tmpPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+    std::ofstream file(tmpPath, std::ofstream::binary | std::ofstream::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(requestKey.data(), requestKey.size());
+    file.write(_entry.etag.data(), _entry.etag.size());
+    file.write(_entry.lastModified.data(), _entry.lastModified.size());
+    file.write(_entry.content.data(), _entry.content.size());
+    file.close();
+
+    if (!file) {
+        LOGW("Cannot write HTTP cache entry: %s", tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    // rename does not replace existing files on all platforms
+    std::remove(path.c_str());
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    if (m_maxBytes > 0) {
+        bool overLimit = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_usage += sizeof(header) + requestKey.size() + _entry.etag.size() +
+                _entry.lastModified.size() + _entry.content.size();
+            overLimit = m_usage > m_maxBytes;
+        }
+        // trim below the limit, so that the directory is not scanned again for every store
+        if (overLimit) { trim(m_maxBytes / 4 * 3); }
+    }
+    return true;
+}
+
+void HttpCache::remove(const std::string& _url, const HttpOptions& _options) {
+    std::remove(filename(key(_url, _options)).c_str());
+}
+
+void HttpCache::trim(size_t _bytes) {
+
+    struct File {
+        std::string name;
+        int64_t time;
+        size_t size;
+    };
+    std::vector<File> files;
+
+    auto isEntry = [](const std::string& _name) {
+        size_t suffix = strlen(HTTP_CACHE_SUFFIX);
+        return _name.size() > suffix &&
+            _name.compare(_name.size() - suffix, suffix, HTTP_CACHE_SUFFIX) == 0;
+    };
+
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((m_path + "*" HTTP_CACHE_SUFFIX).c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            std::string name = data.cFileName;
+            if (!isEntry(name)) { continue; }
+            int64_t time = (int64_t(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+            size_t size = (size_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            files.push_back({ m_path + name, time, size });
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+    }
+#else
+    DIR* dir = opendir(m_path.c_str());
+    if (dir) {
+        while (struct dirent* dirEntry = readdir(dir)) {
+            std::string name = dirEntry->d_name;
+            if (!isEntry(name)) { continue; }
+            struct stat st;
+            std::string path = m_path + name;
+            if (stat(path.c_str(), &st) != 0) { continue; }
+            files.push_back({ path, int64_t(st.st_mtime), size_t(st.st_size) });
+        }
+        closedir(dir);
+    }
+#endif
+
+    size_t usage = 0;
+    for (const auto& file : files) { usage += file.size; }
+
+    if (usage > _bytes) {
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+        for (const auto& file : files) {
+            if (usage <= _bytes) { break; }
+            if (std::remove(file.name.c_str()) == 0) { usage -= file.size; }
+        }
+        LOGD("Trimmed HTTP cache to %u bytes", unsigned(usage));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_usage = usage;
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Tangram {
+
+struct HttpOptions;
+
+/* Persistent cache of HTTP responses for UrlClient
+ *
+ * Each entry is a file in the cache directory holding the response body together with
+ * the time until which it is fresh and the validators (ETag, Last-Modified) to revalidate
+ * it once it is stale. Entries are keyed by URL and request headers, so that range requests
+ * for different parts of the same resource are stored separately. Requests with a payload
+ * are not cached.
+ *
+ * When the files exceed the size limit, the entries stored longest ago are removed.
+ * load() and store() do file I/O and should not be called from the curl thread.
+ */
+class HttpCache {
+
+public:
+
+    struct Entry {
+        int64_t stored = 0;   // seconds since epoch
+        int64_t expires = 0;  // fresh until, seconds since epoch
+        std::string etag;
+        std::string lastModified;
+        std::vector<char> content;
+
+        bool isFresh(int64_t _now) const { return _now < expires; }
+        bool canRevalidate() const { return !etag.empty() || !lastModified.empty(); }
+    };
+
+    /* Caching related fields of response headers; dates in seconds since epoch, -1 if not given */
+    struct ResponseHeaders {
+        long maxAge = -1;
+        long age = 0;
+        bool noStore = false;
+        bool noCache = false;
+        int64_t date = -1;
+        int64_t expires = -1;
+        std::string etag;
+        std::string lastModified;
+
+        /* Take header @_name, in lower case, with @_value; returns false if it is not about caching */
+        bool parse(const std::string& _name, const std::string& _value);
+    };
+
+    /* Seconds since epoch of an HTTP date in IMF-fixdate, RFC 850 or asctime format; -1 if invalid */
+    static int64_t parseDate(const std::string& _date);
+
+    /* True for status codes of responses that can be stored */
+    static bool isCacheableStatus(long _status);
+
+    /* Update @_entry at time @_now from the headers of its response, or of a 304 response which
+     * revalidated it; returns false if the entry must not be stored */
+    static bool updateEntry(Entry& _entry, const ResponseHeaders& _headers, int64_t _now);
+
+    /* Conditional request headers to revalidate stale @_entry */
+    static std::vector<std::string> revalidationHeaders(const Entry& _entry);
+
+    /* @_path: cache directory, created if it does not exist; @_maxBytes: size limit, 0 for no limit */
+    HttpCache(std::string _path, size_t _maxBytes);
+
+    static bool isCacheable(const HttpOptions& _options);
+
+    /* Returns false if there is no entry for the request */
+    bool load(const std::string& _url, const HttpOptions& _options, Entry& _entry) const;
+
+    bool store(const std::string& _url, const HttpOptions& _options, const Entry& _entry);
+
+    void remove(const std::string& _url, const HttpOptions& _options);
+
+    /* Remove oldest entries until the files use at most @_bytes */
+    void trim(size_t _bytes);
+
+    size_t maxBytes() const { return m_maxBytes; }
+
+private:
+
+    struct Header;
+
+    static std::string key(const std::string& _url, const HttpOptions& _options);
+    std::string filename(const std::string& _key) const;
+
+    std::string m_path;
+    const size_t m_maxBytes;
+
+    // bytes used by entries as of the last trim() plus bytes stored since
+    size_t m_usage = 0;
+    std::mutex m_mutex;
+};
+
+}
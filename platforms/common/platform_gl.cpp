@@ -141,6 +141,24 @@ void GL::getProgramiv(GLuint program, GLenum pname, GLint *params) {
 void GL::getShaderiv(GLuint shader, GLenum pname, GLint *params) {
     GL_CHECK(glGetShaderiv(shader,pname, params));
 }
+#if defined(TANGRAM_IOS) || defined(TANGRAM_OSX) || defined(TANGRAM_WINDOWS)
+// Program binaries are not used on these platforms: nothing is returned and
+// programs from binaries fail to link.
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+    if (length) { *length = 0; }
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+}
+#else
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+    GL_CHECK(glGetProgramBinary(program, bufSize, length, binaryFormat, binary));
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+    GL_CHECK(glProgramBinary(program, binaryFormat, binary, length));
+}
+#endif
 
 // Buffers
 void GL::bindBuffer(GLenum target, GLuint buffer) {
@@ -158,6 +176,28 @@ void GL::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usa
 void GL::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
     GL_CHECK(glBufferSubData(target, offset, size, data));
 }
+#if defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+// Uniform buffers are not used on these platforms, see Hardware::supportsUniformBuffers
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    return GL_INVALID_INDEX;
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+}
+#else
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    GL_CHECK(glBindBufferBase(target, index, buffer));
+}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    auto result = glGetUniformBlockIndex(program, uniformBlockName);
+    GL_CHECK({});
+    return result;
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+    GL_CHECK(glUniformBlockBinding(program, uniformBlockIndex, uniformBlockBinding));
+}
+#endif
 void GL::readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                     GLenum format, GLenum type, GLvoid* pixels) {
     GL_CHECK(glReadPixels(x, y, width, height, format, type, pixels));
@@ -179,10 +219,17 @@ void GL::deleteTextures(GLsizei n, const GLuint *textures) {
 void GL::texParameteri(GLenum target, GLenum pname, GLint param ) {
     GL_CHECK(glTexParameteri(target, pname, param ));
 }
+void GL::pixelStorei(GLenum pname, GLint param) {
+    GL_CHECK(glPixelStorei(pname, param));
+}
 void GL::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
                     GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
     GL_CHECK(glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels)); }
 
+void GL::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                              GLint border, GLsizei imageSize, const GLvoid *data) {
+    GL_CHECK(glCompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data)); }
+
 void GL::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                        GLenum format, GLenum type, const GLvoid *pixels) {
     GL_CHECK(glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels)); }
@@ -191,6 +238,46 @@ void GL::generateMipmap(GLenum target) {
     GL_CHECK(glGenerateMipmap(target));
 }
 
+#if defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+// Texture arrays are not used on these platforms, see Hardware::supportsTextureArrays
+void GL::texImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                    GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
+}
+void GL::texSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                       GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+                       const GLvoid *pixels) {
+}
+void GL::compressedTexImage3D(GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+                              GLsizei height, GLsizei depth, GLint border, GLsizei imageSize,
+                              const GLvoid *data) {
+}
+void GL::compressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                 GLsizei width, GLsizei height, GLsizei depth, GLenum format,
+                                 GLsizei imageSize, const GLvoid *data) {
+}
+#else
+void GL::texImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                    GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
+    GL_CHECK(glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels));
+}
+void GL::texSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                       GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+                       const GLvoid *pixels) {
+    GL_CHECK(glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels));
+}
+void GL::compressedTexImage3D(GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+                              GLsizei height, GLsizei depth, GLint border, GLsizei imageSize,
+                              const GLvoid *data) {
+    GL_CHECK(glCompressedTexImage3D(target, level, internalFormat, width, height, depth, border, imageSize, data));
+}
+void GL::compressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                 GLsizei width, GLsizei height, GLsizei depth, GLenum format,
+                                 GLsizei imageSize, const GLvoid *data) {
+    GL_CHECK(glCompressedTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth,
+                                       format, imageSize, data));
+}
+#endif
+
 void GL::enableVertexAttribArray(GLuint index) {
     GL_CHECK(glEnableVertexAttribArray(index));
 }
@@ -209,6 +296,23 @@ void GL::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *ind
     GL_CHECK(glDrawElements(mode, count, type, indices ));
 }
 
+#if defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+// Instancing is not used on these platforms, see Hardware::supportsInstancing
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {
+}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices,
+                               GLsizei instancecount) {
+}
+#else
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    GL_CHECK(glVertexAttribDivisor(index, divisor));
+}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices,
+                               GLsizei instancecount) {
+    GL_CHECK(glDrawElementsInstanced(mode, count, type, indices, instancecount));
+}
+#endif
+
 void GL::uniform1f(GLint location, GLfloat v0) {
     GL_CHECK(glUniform1f(location, v0));
 }
@@ -281,6 +385,85 @@ GLboolean GL::unmapBuffer(GLenum target) {
     GL_CHECK({});
     return result;
 }
+#if defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+// Asynchronous reads are not used on these platforms, see Hardware::supportsAsyncReadback
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return nullptr;
+}
+GLsync GL::fenceSync(GLenum condition, GLbitfield flags) {
+    return nullptr;
+}
+GLenum GL::clientWaitSync(GLsync sync, GLbitfield flags, unsigned long long timeout) {
+    return GL_WAIT_FAILED;
+}
+void GL::deleteSync(GLsync sync) {
+}
+void GL::blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                         GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                         GLbitfield mask, GLenum filter) {
+}
+#else
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    auto result = glMapBufferRange(target, offset, length, access);
+    GL_CHECK({});
+    return result;
+}
+GLsync GL::fenceSync(GLenum condition, GLbitfield flags) {
+    auto result = glFenceSync(condition, flags);
+    GL_CHECK({});
+    return result;
+}
+GLenum GL::clientWaitSync(GLsync sync, GLbitfield flags, unsigned long long timeout) {
+    auto result = glClientWaitSync(sync, flags, timeout);
+    GL_CHECK({});
+    return result;
+}
+void GL::deleteSync(GLsync sync) {
+    GL_CHECK(glDeleteSync(sync));
+}
+void GL::blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                         GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                         GLbitfield mask, GLenum filter) {
+    GL_CHECK(glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter));
+}
+#endif
+
+#if defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+// Timer queries are not used on these platforms, see Hardware::supportsTimerQuery
+void GL::genQueries(GLsizei n, GLuint *ids) {
+}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {
+}
+void GL::beginQuery(GLenum target, GLuint id) {
+}
+void GL::endQuery(GLenum target) {
+}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, unsigned long long *params) {
+}
+#else
+void GL::genQueries(GLsizei n, GLuint *ids) {
+    GL_CHECK(glGenQueries(n, ids));
+}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {
+    GL_CHECK(glDeleteQueries(n, ids));
+}
+void GL::beginQuery(GLenum target, GLuint id) {
+    GL_CHECK(glBeginQuery(target, id));
+}
+void GL::endQuery(GLenum target) {
+    GL_CHECK(glEndQuery(target));
+}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+    GL_CHECK(glGetQueryObjectuiv(id, pname, params));
+}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, unsigned long long *params) {
+    GLuint64 result = 0;
+    GL_CHECK(glGetQueryObjectui64v(id, pname, &result));
+    *params = result;
+}
+#endif
 
 void GL::finish(void) {
     GL_CHECK(glFinish());
@@ -17,6 +17,66 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysOESEXT
 #define glGenVertexArrays glGenVertexArraysOESEXT
 #define glBindVertexArray glBindVertexArrayOESEXT
+
+// GLES 3 functions, which have the signatures of their OES_texture_3D counterparts
+extern PFNGLTEXIMAGE3DOESPROC glTexImage3DEXT;
+extern PFNGLTEXSUBIMAGE3DOESPROC glTexSubImage3DEXT;
+extern PFNGLCOMPRESSEDTEXIMAGE3DOESPROC glCompressedTexImage3DEXT;
+extern PFNGLCOMPRESSEDTEXSUBIMAGE3DOESPROC glCompressedTexSubImage3DEXT;
+
+#define glTexImage3D glTexImage3DEXT
+#define glTexSubImage3D glTexSubImage3DEXT
+#define glCompressedTexImage3D glCompressedTexImage3DEXT
+#define glCompressedTexSubImage3D glCompressedTexSubImage3DEXT
+
+// GLES 3 instancing; named apart from the EXT_instanced_arrays prototypes of gl2ext.h
+extern PFNGLVERTEXATTRIBDIVISOREXTPROC glVertexAttribDivisorES3;
+extern PFNGLDRAWELEMENTSINSTANCEDEXTPROC glDrawElementsInstancedES3;
+
+#define glVertexAttribDivisor glVertexAttribDivisorES3
+#define glDrawElementsInstanced glDrawElementsInstancedES3
+
+// GLES 3 uniform buffers, which gl2ext.h does not declare
+typedef void (GL_APIENTRYP PFNGLBINDBUFFERBASEES3PROC) (GLenum target, GLuint index, GLuint buffer);
+typedef GLuint (GL_APIENTRYP PFNGLGETUNIFORMBLOCKINDEXES3PROC) (GLuint program, const GLchar *uniformBlockName);
+typedef void (GL_APIENTRYP PFNGLUNIFORMBLOCKBINDINGES3PROC) (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+extern PFNGLBINDBUFFERBASEES3PROC glBindBufferBaseES3;
+extern PFNGLGETUNIFORMBLOCKINDEXES3PROC glGetUniformBlockIndexES3;
+extern PFNGLUNIFORMBLOCKBINDINGES3PROC glUniformBlockBindingES3;
+
+#define glBindBufferBase glBindBufferBaseES3
+#define glGetUniformBlockIndex glGetUniformBlockIndexES3
+#define glUniformBlockBinding glUniformBlockBindingES3
+
+// GLES 3 buffer ranges and sync objects, which have the signatures of their
+// EXT_map_buffer_range and APPLE_sync counterparts
+extern PFNGLMAPBUFFERRANGEEXTPROC glMapBufferRangeES3;
+extern PFNGLFENCESYNCAPPLEPROC glFenceSyncES3;
+extern PFNGLCLIENTWAITSYNCAPPLEPROC glClientWaitSyncES3;
+extern PFNGLDELETESYNCAPPLEPROC glDeleteSyncES3;
+// GLES 3 blits, with the signature of ANGLE_framebuffer_blit
+extern PFNGLBLITFRAMEBUFFERANGLEPROC glBlitFramebufferES3;
+
+#define glMapBufferRange glMapBufferRangeES3
+#define glFenceSync glFenceSyncES3
+#define glClientWaitSync glClientWaitSyncES3
+#define glDeleteSync glDeleteSyncES3
+#define glBlitFramebuffer glBlitFramebufferES3
+
+// EXT_disjoint_timer_query, loaded when the driver has it
+extern PFNGLGENQUERIESEXTPROC glGenQueriesTimerEXT;
+extern PFNGLDELETEQUERIESEXTPROC glDeleteQueriesTimerEXT;
+extern PFNGLBEGINQUERYEXTPROC glBeginQueryTimerEXT;
+extern PFNGLENDQUERYEXTPROC glEndQueryTimerEXT;
+extern PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivTimerEXT;
+extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vTimerEXT;
+
+#define glGenQueries glGenQueriesTimerEXT
+#define glDeleteQueries glDeleteQueriesTimerEXT
+#define glBeginQuery glBeginQueryTimerEXT
+#define glEndQuery glEndQueryTimerEXT
+#define glGetQueryObjectuiv glGetQueryObjectuivTimerEXT
+#define glGetQueryObjectui64v glGetQueryObjectui64vTimerEXT
 #endif // TANGRAM_ANDROID
 
 #ifdef TANGRAM_IOS
@@ -38,6 +98,9 @@ extern PFNGLGENVERTEXARRAYSOESPROC glGenVertexArraysOESEXT;
 #define glDeleteVertexArrays glDeleteVertexArraysAPPLE
 #define glGenVertexArrays glGenVertexArraysAPPLE
 #define glBindVertexArray glBindVertexArrayAPPLE
+#define glVertexAttribDivisor glVertexAttribDivisorARB
+#define glDrawElementsInstanced glDrawElementsInstancedARB
+#define glGetQueryObjectui64v glGetQueryObjectui64vEXT
 #endif // TANGRAM_OSX
 
 #ifdef TANGRAM_LINUX
@@ -76,3 +139,8 @@ static void glGenVertexArrays(GLsizei n, GLuint *arrays) {}
     #define glMapBuffer glMapBufferOES
     #define glUnmapBuffer glUnmapBufferOES
 #endif // defined(TANGRAM_ANDROID) || defined(TANGRAM_IOS) || defined(TANGRAM_RPI)
+
+#if defined(TANGRAM_ANDROID) || defined(TANGRAM_RPI)
+    #define glGetProgramBinary glGetProgramBinaryOES
+    #define glProgramBinary glProgramBinaryOES
+#endif // defined(TANGRAM_ANDROID) || defined(TANGRAM_RPI)
@@ -1,5 +1,7 @@
 #include "urlClient.h"
 #include "log.h"
+#include "debug/trace.h"
+#include "util/zlibHelper.h"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -108,6 +110,17 @@ UrlClient::SelfPipe::Socket UrlClient::SelfPipe::getReadFd() {
     return pipeFds[0];
 }
 
+// HTTP/2 stream weight (1 - 256, curl default 16) for request priority
+#if LIBCURL_VERSION_NUM >= 0x072e00
+static long streamWeight(HttpOptions::Priority _priority) {
+    switch (_priority) {
+    case HttpOptions::Priority::low: return 1;
+    case HttpOptions::Priority::high: return 128;
+    default: return 16;
+    }
+}
+#endif
+
 struct UrlClient::Task {
     // Reduce Task content capacity when it's more than 128kb and last
     // content size was less then half limit_capacity.
@@ -115,6 +128,10 @@ struct UrlClient::Task {
 
     Request request;
     std::vector<char> content;
+    // inflates a gzip body into content as it is received, see HttpOptions::inflateGzip
+    std::unique_ptr<ZlibInflater> inflater;
+    // whether the start of the body is still to be checked for a gzip header
+    bool detectGzip = false;
     CURL *handle = nullptr;
     curl_slist* slist = nullptr;
     char curlErrorString[CURL_ERROR_SIZE] = {0};
@@ -128,35 +145,72 @@ struct UrlClient::Task {
 
         auto& buffer = task->content;
         auto addedSize = size * n;
+
+        if (task->inflater) {
+            return task->inflater->write(ptr, addedSize, buffer) ? addedSize : 0;
+        }
+
         auto oldSize = buffer.size();
         buffer.resize(oldSize + addedSize);
         std::memcpy(buffer.data() + oldSize, ptr, addedSize);
+
+        // the header may arrive in more than one chunk
+        if (task->detectGzip && buffer.size() >= 2) {
+            task->detectGzip = false;
+            // partial responses may hold several streams, e.g. merged ranges of an archive,
+            // which their reader decompresses
+            long status = 0;
+            curl_easy_getinfo(task->handle, CURLINFO_RESPONSE_CODE, &status);
+            if (status != 206 && ZlibInflater::isGzip(buffer.data(), buffer.size())) {
+                std::vector<char> compressed;
+                compressed.swap(buffer);
+                task->inflater = std::make_unique<ZlibInflater>();
+                return task->inflater->write(compressed.data(), compressed.size(), buffer) ? addedSize : 0;
+            }
+        }
         return addedSize;
     }
 
-    /*static size_t curlHeaderCallback(char* ptr, size_t size, size_t n, void* user) {
+    // Caching related fields of the response headers
+    HttpCache::ResponseHeaders cacheHeaders;
+
+    static size_t curlHeaderCallback(char* ptr, size_t size, size_t n, void* user) {
         auto* task = reinterpret_cast<Task*>(user);
         if (task->canceled) { return 0; }
 
         size_t nbytes = size * n;
-        std::string header(nbytes, '\0');
-        std::transform(ptr, ptr + nbytes, header.begin(), ::tolower);
-        if(header.compare(0, 14, "cache-control:") == 0) {
-          size_t pos = header.find("max-age=", 14);
-          if(pos != std::string::npos) {
-            task->cacheMaxAge = strtol(&header[pos+8], NULL, 10);
-          }
+        std::string header(ptr, nbytes);
+        while (!header.empty() && isspace(uint8_t(header.back()))) { header.pop_back(); }
+
+        size_t colon = header.find(':');
+        if (colon == std::string::npos) {
+            // status line of the next response after a redirect
+            if (header.compare(0, 5, "HTTP/") == 0) { task->cacheHeaders = HttpCache::ResponseHeaders(); }
+            return nbytes;
+        }
+
+        std::string name(header, 0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        size_t start = header.find_first_not_of(" \t", colon + 1);
+        std::string value = start == std::string::npos ? std::string() : header.substr(start);
+
+        if (name == "content-length") {
+            // grow the content buffer once; the length of an encoded body is only a lower bound
+            size_t length = strtoul(value.c_str(), NULL, 10);
+            if (length <= 64 * 1024 * 1024) { task->content.reserve(length); }
+        } else {
+            task->cacheHeaders.parse(name, value);
         }
         return nbytes;
-    }*/
+    }
 
     Task(const UrlClient& _parent, const Options& _options) {
         // Set up an easy handle for reuse.
         handle = curl_easy_init();
         curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, &curlWriteCallback);
         curl_easy_setopt(handle, CURLOPT_WRITEDATA, this);
-        //curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, &curlHeaderCallback);
-        //curl_easy_setopt(handle, CURLOPT_HEADERDATA, this);
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, &curlHeaderCallback);
+        curl_easy_setopt(handle, CURLOPT_HEADERDATA, this);
         curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 1L);
         curl_easy_setopt(handle, CURLOPT_HEADER, 0L);
         curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
@@ -171,11 +225,19 @@ struct UrlClient::Task {
         curl_easy_setopt(handle, CURLOPT_USERAGENT, _options.userAgentString);
         curl_easy_setopt(handle, CURLOPT_COOKIEFILE, "");  // in-memory cookie store only
         curl_easy_setopt(handle, CURLOPT_SHARE, _parent.m_curlShare);
+        if (_options.http2) {
+#if LIBCURL_VERSION_NUM >= 0x072f00
+            curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#endif
+            // wait for a connection that can be multiplexed instead of opening another one
+            curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+        }
     }
 
     void setup() {
         canceled = false;
         active = true;
+        cacheHeaders = HttpCache::ResponseHeaders();
     }
 
     void clear() {
@@ -188,6 +250,7 @@ struct UrlClient::Task {
             content.shrink_to_fit();
         }
         content.clear();
+        inflater.reset();
 
         active = false;
     }
@@ -216,9 +279,24 @@ UrlClient::UrlClient(Options options) : m_options(options) {
     curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_COOKIE);
     curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
     curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(m_curlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    if (m_options.http2) {
+        curl_multi_setopt(m_curlHandle, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+    curl_multi_setopt(m_curlHandle, CURLMOPT_MAX_HOST_CONNECTIONS, long(m_options.maxHostConnections));
     m_curlRunning = true;
     m_curlWorker = std::make_unique<std::thread>(&UrlClient::curlLoop, this);
 
+    if (!m_options.cachePath.empty()) {
+        m_cache = std::make_unique<HttpCache>(m_options.cachePath, m_options.cacheMaxBytes);
+        m_cacheWorker = std::make_unique<AsyncWorker>("UrlClient cache");
+        if (m_options.cacheMaxBytes > 0) {
+            m_cacheWorker->enqueue([this]() { m_cache->trim(m_cache->maxBytes()); });
+        }
+    }
+
     // Init at least one task to avoid checking whether m_tasks is empty in
     // startPendingRequests()
     m_tasks.emplace_back(*this, m_options);
@@ -233,6 +311,12 @@ UrlClient::~UrlClient() {
 
     m_curlWorker->join();
 
+    // Finish pending cache writes
+    if (m_cacheWorker) {
+        m_cacheWorker->waitForCompletion();
+        m_cacheWorker.reset();
+    }
+
     // 1 - curl_multi_remove_handle before any easy handles are cleaned up
     // 2 - curl_easy_cleanup can now be called independently since the easy handle
     //     is no longer connected to the multi handle
@@ -264,6 +348,7 @@ UrlClient::RequestId UrlClient::addRequest(const std::string& _url, const HttpOp
 
     auto id = ++m_requestCount;
     Request request = {_url, _options, _onComplete, id};
+    request.lookup = m_cache && HttpCache::isCacheable(_options);
 
     // Add the request to our list.
     {
@@ -272,11 +357,53 @@ UrlClient::RequestId UrlClient::addRequest(const std::string& _url, const HttpOp
         std::lock_guard<std::mutex> lock(m_requestMutex);
         m_requests.push_back(request);
     }
-    curlWakeUp();
+
+    if (request.lookup) {
+        // The request stays pending until the cache lookup is done, so that it can be canceled
+        m_cacheWorker->enqueue([this, id, _url, _options]() { lookupCache(id, _url, _options); });
+    } else {
+        curlWakeUp();
+    }
 
     return id;
 }
 
+void UrlClient::lookupCache(RequestId _id, const std::string& _url, const HttpOptions& _options) {
+
+    auto entry = std::make_shared<HttpCache::Entry>();
+    bool found = m_cache->load(_url, _options, *entry);
+
+    UrlCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_requestMutex);
+        auto it = std::find_if(m_requests.begin(), m_requests.end(),
+                               [&](auto& r) { return r.id == _id; });
+        // canceled meanwhile
+        if (it == m_requests.end()) { return; }
+
+        if (found && entry->isFresh(time(nullptr))) {
+            callback = std::move(it->callback);
+            m_requests.erase(it);
+        } else {
+            it->lookup = false;
+            if (found) { it->cached = entry; }
+        }
+    }
+
+    if (!callback) {
+        curlWakeUp();
+        return;
+    }
+
+    LOGD("Cached response for url: %s", _url.c_str());
+    UrlResponse response;
+    response.content = std::move(entry->content);
+    m_dispatcher.enqueue([callback = std::move(callback),
+                          response = std::move(response)]() mutable {
+                             callback(std::move(response));
+                         });
+}
+
 void UrlClient::cancelRequest(RequestId _id) {
     UrlCallback callback;
     // First check the pending request list.
@@ -336,7 +463,16 @@ void UrlClient::startPendingRequests() {
 
     while (m_activeTasks < m_options.maxActiveTasks) {
 
-        if (m_requests.empty()) { break; }
+        // first request of highest priority, skipping requests waiting for cache lookup
+        auto next = m_requests.end();
+        for (auto it = m_requests.begin(); it != m_requests.end(); ++it) {
+            if (it->lookup) { continue; }
+            if (next == m_requests.end() || it->options.priority > next->options.priority) {
+                next = it;
+                if (next->options.priority == HttpOptions::Priority::high) { break; }
+            }
+        }
+        if (next == m_requests.end()) { break; }
 
         if (m_tasks.front().active) {
             m_tasks.emplace_front(*this, m_options);
@@ -351,8 +487,9 @@ void UrlClient::startPendingRequests() {
 
         task.setup();
 
-        task.request = std::move(m_requests.front());
-        m_requests.erase(m_requests.begin());
+        task.request = std::move(*next);
+        m_requests.erase(next);
+        task.detectGzip = task.request.options.inflateGzip;
 
         // Configure the easy handle.
         const char* url = task.request.url.c_str();
@@ -373,7 +510,17 @@ void UrlClient::startPendingRequests() {
             if (start < hdrs.size())
                 task.slist = curl_slist_append(task.slist, hdrs.substr(start).c_str());
         }
+        // revalidate stale cache entry
+        if (auto& cached = task.request.cached) {
+            for (auto& header : HttpCache::revalidationHeaders(*cached)) {
+                task.slist = curl_slist_append(task.slist, header.c_str());
+            }
+        }
         curl_easy_setopt(task.handle, CURLOPT_HTTPHEADER, task.slist);
+#if LIBCURL_VERSION_NUM >= 0x072e00
+        curl_easy_setopt(task.handle, CURLOPT_STREAM_WEIGHT, streamWeight(task.request.options.priority));
+#endif
+
         // HTTP POST implied if payload not empty
         if (!task.request.options.payload.empty()) {
             curl_easy_setopt(task.handle, CURLOPT_POSTFIELDS, task.request.options.payload.c_str());
@@ -387,9 +534,40 @@ void UrlClient::startPendingRequests() {
     }
 }
 
+void UrlClient::updateCache(Task& _task, UrlResponse& _response) {
+    long status = 0;
+    curl_easy_getinfo(_task.handle, CURLINFO_RESPONSE_CODE, &status);
+
+    auto& request = _task.request;
+    std::shared_ptr<HttpCache::Entry> entry;
+
+    if (status == 304 && request.cached) {
+        // not modified - respond with cached content and store new expiry
+        entry = std::move(request.cached);
+        _response.content = entry->content;
+    } else if (HttpCache::isCacheableStatus(status)) {
+        entry = std::make_shared<HttpCache::Entry>();
+        entry->content = _response.content;
+    } else {
+        return;
+    }
+
+    if (HttpCache::updateEntry(*entry, _task.cacheHeaders, time(nullptr))) {
+        m_cacheWorker->enqueue([this, entry, url = request.url, options = request.options]() {
+            m_cache->store(url, options, *entry);
+        });
+    } else {
+        m_cacheWorker->enqueue([this, url = request.url, options = request.options]() {
+            m_cache->remove(url, options);
+        });
+    }
+}
+
 void UrlClient::curlLoop() {
     // Based on: https://curl.haxx.se/libcurl/c/multi-app.html
 
+    Trace::setThreadName("Network");
+
     // Loop until the session is destroyed.
     while (m_curlRunning) {
 
@@ -458,6 +636,7 @@ void UrlClient::curlLoop() {
             startPendingRequests();
 
             //
+            TRACE_SCOPE("curl");
             int activeRequests = 0;
             curl_multi_perform(m_curlHandle, &activeRequests);
         }
@@ -497,26 +676,52 @@ void UrlClient::curlLoop() {
                 // Move task to front - for quick reuse
                 m_tasks.splice(m_tasks.begin(), m_tasks, it);
 
-                // Get Response content and Request callback
+                // Get Response content and Request callback; large buffers are released by clear()
+                //  anyway, so they are handed over instead of copied
                 callback = std::move(task.request.callback);
-                response.content = task.content;
+                if (task.content.size() > Task::limit_capacity) {
+                    response.content = std::move(task.content);
+                } else {
+                    response.content = task.content;
+                }
+                if (resultCode == CURLE_OK && task.inflater && !task.inflater->finished()) {
+                    LOGW("Truncated gzip body for url: %s", task.request.url.c_str());
+                    resultCode = CURLE_PARTIAL_FILE;
+                    strncpy(task.curlErrorString, "Truncated gzip body", CURL_ERROR_SIZE - 1);
+                }
 
                 const char* url = task.request.url.c_str();
+                if (resultCode == CURLE_OK || resultCode == CURLE_HTTP_RETURNED_ERROR) {
+                    long status = 0;
+                    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+                    response.status = int(status);
+                }
                 if (resultCode == CURLE_OK) {
                     LOGD("Succeeded for url (%.0f ms): %s", [=](){
                           double t = 0; curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &t); return t*1000;
                         }(), url);
                     response.error = nullptr;
 
+                    if (m_cache && HttpCache::isCacheable(task.request.options)) {
+                        updateCache(task, response);
+                    }
+
                 } else if (task.canceled) {
                     LOGD("Aborted request for url: %s", url);
                     response.error = Platform::cancel_message;
 
+                } else if (task.request.cached && resultCode != CURLE_HTTP_RETURNED_ERROR) {
+                    // server not reachable - better stale content than none
+                    LOGD("Failed with error %s, using stale cache for url: %s", task.curlErrorString, url);
+                    response.content = std::move(task.request.cached->content);
+                    response.error = nullptr;
+
                 } else {
                     // LOGD, with the assumption LOGW is used in NetworkDataSource
                     LOGD("Failed with error %s for url: %s", task.curlErrorString, url);
                     response.error = task.curlErrorString;
                 }
+                task.request.cached.reset();
 
                 // Unset task state, clear content
                 task.clear();
@@ -526,6 +731,8 @@ void UrlClient::curlLoop() {
             if (callback) {
                 m_dispatcher.enqueue([callback = std::move(callback),
                                       response = std::move(response)]() mutable {
+                                         Trace::setThreadName("UrlCallback");
+                                         TRACE_SCOPE("urlResponse");
                                          callback(std::move(response));
                                      });
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "httpCache.h"
 #include "platform.h" // UrlResponse
 #include "util/asyncWorker.h"
 
@@ -7,6 +8,7 @@
 #include <condition_variable>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <deque>
 #include <string>
@@ -25,9 +27,16 @@ public:
 
     struct Options {
         uint32_t maxActiveTasks = 20;
+        // Connections per host, 0 for no limit; with HTTP/2 requests share a connection
+        uint32_t maxHostConnections = 6;
+        // Negotiate HTTP/2 for https and multiplex requests to the same host
+        bool http2 = true;
         uint32_t connectionTimeoutMs = 3000;
         uint32_t requestTimeoutMs = 30000;
         const char* userAgentString = "tangram";
+        // Directory for the persistent HTTP cache, empty to disable caching
+        std::string cachePath;
+        size_t cacheMaxBytes = 256 * 1024 * 1024;
     };
 
     UrlClient(Options options);
@@ -47,6 +56,10 @@ private:
         HttpOptions options;
         UrlCallback callback;
         RequestId id;
+        // waiting for HTTP cache lookup
+        bool lookup = false;
+        // stale cache entry, to be revalidated or used when the request fails
+        std::shared_ptr<HttpCache::Entry> cached;
     };
 
     class SelfPipe {
@@ -74,14 +87,20 @@ private:
 
     void startPendingRequests();
 
+    // Serve @_id from the HTTP cache if there is a fresh entry, otherwise let it start
+    void lookupCache(RequestId _id, const std::string& _url, const HttpOptions& _options);
+
+    // Store or refresh cache entry for the completed request of @_task
+    void updateCache(Task& _task, UrlResponse& _response);
+
     Options m_options;
 
     // Curl multi handle
     void *m_curlHandle = nullptr;
     void* m_curlShare = nullptr;
 
-    bool m_curlRunning = false;
-    bool m_curlNotified = false;
+    std::atomic<bool> m_curlRunning{false};
+    std::atomic<bool> m_curlNotified{false};
 
     std::unique_ptr<std::thread> m_curlWorker;
     AsyncWorker m_dispatcher = {"UrlClient dispatcher"};
@@ -99,6 +118,11 @@ private:
 
     // File descriptors to break waiting select.
     SelfPipe m_requestNotify;
+
+    std::unique_ptr<HttpCache> m_cache;
+
+    // Runs HTTP cache file I/O
+    std::unique_ptr<AsyncWorker> m_cacheWorker;
 };
 
 } // namespace Tangram
@@ -27,6 +27,7 @@
 #include <OpenGLES/ES3/gl.h>
 #include <OpenGLES/ES3/glext.h>
 
+#include "gl/texture.h"
 #include "util/elevationManager.h"
 #include "util/asyncWorker.h"
 #include "data/clientDataSource.h"
@@ -244,6 +245,7 @@ typedef NS_ENUM(NSInteger, TGMapRegionChangeState) {
 
 @property (nullable, strong, nonatomic) EAGLContext *context;
 @property (nullable, strong, nonatomic) EAGLContext *context2;
+@property (nullable, strong, nonatomic) EAGLContext *uploadContext;
 @property (strong, nonatomic) GLKView *glView;
 @property (strong, nonatomic) CADisplayLink *displayLink;
 @property (strong, nonatomic) NSMutableDictionary<NSString *, TGMarker *> *markersById;
@@ -414,6 +416,14 @@ static const CGFloat kPanZoomSensitivity = 0.005f; // zoom units per screen poin
   }
 }
 
+// this should be called from a thread
+- (void)setUploadContextCurrent
+{
+  if (!_uploadContext || ![EAGLContext setCurrentContext:_uploadContext]) {
+      NSLog(@"setCurrentContext failed for texture upload OpenGL context");
+  }
+}
+
 - (void)setupGL
 {
     _context = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES3];
@@ -424,6 +434,7 @@ static const CGFloat kPanZoomSensitivity = 0.005f; // zoom units per screen poin
     }
     
     _context2 = [[EAGLContext alloc] initWithAPI:[_context API] sharegroup:[_context sharegroup]];
+    _uploadContext = [[EAGLContext alloc] initWithAPI:[_context API] sharegroup:[_context sharegroup]];
       if (![EAGLContext setCurrentContext:_context]) {
           _context = nil;
           NSLog(@"Failed to set current OpenGL context");
@@ -439,6 +450,10 @@ static const CGFloat kPanZoomSensitivity = 0.005f; // zoom units per screen poin
     auto offscreenWorker = std::make_unique<Tangram::AsyncWorker>("Offscreen GL worker");
     offscreenWorker->enqueue([&self](){ [self createSharedContext]; });
     Tangram::ElevationManager::offscreenWorker = std::move(offscreenWorker);
+
+    auto uploadWorker = std::make_unique<Tangram::AsyncWorker>("Texture upload GL worker");
+    uploadWorker->enqueue([self](){ [self setUploadContextCurrent]; });
+    Tangram::Texture::uploadWorker = std::move(uploadWorker);
     
     glGenRenderbuffers(1, &_colorRenderBuffer);
     glGenRenderbuffers(1, &_depthRenderBuffer);
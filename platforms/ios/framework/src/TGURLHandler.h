@@ -40,6 +40,29 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)cancelDownloadRequestAsync:(NSUInteger)taskIdentifier;
 
+@optional
+
+/**
+ Create an asynchronous download request with a priority.
+
+ @param url The URL to download.
+ @param priority The priority of the request in [0, 1] like `NSURLSessionTask.priority`: requests for visible tiles
+ are higher, requests for prefetched tiles and offline downloads lower.
+ @param completionHandler A handler to be called once the URL request completed.
+ @return A task identifier that uniquely identifies the URL request within this handler.
+
+ @note When implemented, this method is called by the map view instead of `downloadRequestAsync:headers:payload:completionHandler:`.
+ */
+- (NSUInteger)downloadRequestAsync:(NSURL *)url headers:(NSString*)headers payload:(NSData*)payload priority:(float)priority completionHandler:(TGDownloadCompletionHandler)completionHandler;
+
+/**
+ Change the priority of a running download request, e.g. when the view moved.
+
+ @param priority The new priority in [0, 1].
+ @param taskIdentifier The task identifier of the request.
+ */
+- (void)setPriority:(float)priority forDownloadRequest:(NSUInteger)taskIdentifier;
+
 @end // protocol TGURLHandler
 
 /**
@@ -66,8 +89,9 @@ TG_EXPORT
 /**
  Get the default configuration object for this URL handler type.
 
- This configuration has a modified request timeout and a URL cache in memory and on disk. You can use this object as a
- base for further configuration modifications.
+ This configuration has a modified request timeout, a limit of connections per host and a URL cache on disk only, as
+ the map keeps loaded tiles in memory itself. Requests to servers supporting HTTP/2 share one connection per host.
+ You can use this object as a base for further configuration modifications.
  */
 + (NSURLSessionConfiguration*)defaultConfiguration;
 
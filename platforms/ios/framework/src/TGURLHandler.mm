@@ -12,6 +12,8 @@
 @interface TGDefaultURLHandler()
 
 @property (strong, nonatomic) NSURLSession* session;
+// Running tasks by identifier, to update their priority and cancel them
+@property (strong, nonatomic) NSMutableDictionary<NSNumber*, NSURLSessionTask*>* tasks;
 
 @end
 
@@ -43,6 +45,7 @@
 
 - (void)setupWithConfiguration:(NSURLSessionConfiguration *)configuration {
     self.session = [NSURLSession sessionWithConfiguration:configuration];
+    self.tasks = [NSMutableDictionary dictionary];
 }
 
 #pragma mark - Class Methods
@@ -52,8 +55,13 @@
     NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
 
     configuration.timeoutIntervalForRequest = 30;
-    configuration.URLCache = [[NSURLCache alloc] initWithMemoryCapacity:4*1024*1024
-                                                           diskCapacity:30*1024*1024
+    // HTTP/2 servers multiplex all requests over one connection; this only bounds HTTP/1.1 hosts,
+    // so that prefetch requests do not take all connections from requests for visible tiles
+    configuration.HTTPMaximumConnectionsPerHost = 6;
+    configuration.networkServiceType = NSURLNetworkServiceTypeResponsiveData;
+    // Loaded tiles are held in memory by the map's tile caches, keep only a disk cache here
+    configuration.URLCache = [[NSURLCache alloc] initWithMemoryCapacity:0
+                                                           diskCapacity:50*1024*1024
                                                                diskPath:@"/tangram_cache"];
 
     return configuration;
@@ -62,6 +70,11 @@
 #pragma mark - Instance Methods
 
 - (NSUInteger)downloadRequestAsync:(NSURL *)url headers:(NSString*)headers payload:(NSData*)payload completionHandler:(TGDownloadCompletionHandler)completionHandler
+{
+    return [self downloadRequestAsync:url headers:headers payload:payload priority:NSURLSessionTaskPriorityDefault completionHandler:completionHandler];
+}
+
+- (NSUInteger)downloadRequestAsync:(NSURL *)url headers:(NSString*)headers payload:(NSData*)payload priority:(float)priority completionHandler:(TGDownloadCompletionHandler)completionHandler
 {
     NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:url];
     if([payload length] > 0) {
@@ -79,24 +92,49 @@
         }
     }
 
+    __block NSNumber* identifier = nil;
+    NSMutableDictionary* tasks = self.tasks;
     NSURLSessionDataTask* dataTask = [self.session dataTaskWithRequest:request
-                                                 completionHandler:completionHandler];
+                                                     completionHandler:^(NSData* data, NSURLResponse* response, NSError* error) {
+        @synchronized (tasks) {
+            if (identifier) { [tasks removeObjectForKey:identifier]; }
+        }
+        completionHandler(data, response, error);
+    }];
+    dataTask.priority = priority;
 
+    @synchronized (tasks) {
+        identifier = @([dataTask taskIdentifier]);
+        tasks[identifier] = dataTask;
+    }
     [dataTask resume];
 
     return [dataTask taskIdentifier];
 }
 
+- (void)setPriority:(float)priority forDownloadRequest:(NSUInteger)taskIdentifier
+{
+    @synchronized (self.tasks) {
+        self.tasks[@(taskIdentifier)].priority = priority;
+    }
+}
+
 - (void)cancelDownloadRequestAsync:(NSUInteger)taskIdentifier
 {
-    [self.session getTasksWithCompletionHandler:^(NSArray* dataTasks, NSArray* uploadTasks, NSArray* downloadTasks) {
-        for (NSURLSessionTask* task in dataTasks) {
-            if ([task taskIdentifier] == taskIdentifier || taskIdentifier == (NSUInteger)-1) {
-                [task cancel];
-                break;
-            }
+    NSArray<NSURLSessionTask*>* canceled;
+    @synchronized (self.tasks) {
+        if (taskIdentifier == (NSUInteger)-1) {
+            canceled = [self.tasks allValues];
+            [self.tasks removeAllObjects];
+        } else {
+            NSURLSessionTask* task = self.tasks[@(taskIdentifier)];
+            canceled = task ? @[task] : @[];
+            [self.tasks removeObjectForKey:@(taskIdentifier)];
         }
-    }];
+    }
+    for (NSURLSessionTask* task in canceled) {
+        [task cancel];
+    }
 }
 
 @end
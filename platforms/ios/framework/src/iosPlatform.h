@@ -21,6 +21,7 @@ public:
     FontSourceHandle systemFont(const std::string& _name, const std::string& _weight, const std::string& _face) const override;
     bool startUrlRequestImpl(const Url& _url, const HttpOptions& _options, const UrlRequestHandle _request, UrlRequestId& _id) override;
     void cancelUrlRequestImpl(const UrlRequestId _id) override;
+    void updateUrlRequestPriorityImpl(const UrlRequestId _id, float _relativePriority) override;
 
 private:
 
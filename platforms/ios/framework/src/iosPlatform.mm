@@ -166,6 +166,7 @@ bool iOSPlatform::startUrlRequestImpl(const Url& _url, const HttpOptions& _optio
 
             NSHTTPURLResponse* httpResponse = (NSHTTPURLResponse*)response;
             long statusCode = [httpResponse statusCode];
+            urlResponse.status = int(statusCode);
             if (statusCode < 200 || statusCode >= 300) {
                 urlResponse.error = [[NSHTTPURLResponse localizedStringForStatusCode: statusCode] UTF8String];
             }
@@ -189,7 +190,12 @@ bool iOSPlatform::startUrlRequestImpl(const Url& _url, const HttpOptions& _optio
     NSData* payload = [NSData dataWithBytes:_options.payload.data() length:_options.payload.size()];
     NSString* hdrs = [NSString stringWithUTF8String:_options.headers.c_str()];
 
-    _id = [urlHandler downloadRequestAsync:url headers:hdrs payload:payload completionHandler:handler];
+    if ([urlHandler respondsToSelector:@selector(downloadRequestAsync:headers:payload:priority:completionHandler:)]) {
+        _id = [urlHandler downloadRequestAsync:url headers:hdrs payload:payload
+                                      priority:_options.relativePriority() completionHandler:handler];
+    } else {
+        _id = [urlHandler downloadRequestAsync:url headers:hdrs payload:payload completionHandler:handler];
+    }
 
     return true;
 }
@@ -203,4 +209,12 @@ void iOSPlatform::cancelUrlRequestImpl(const UrlRequestId _id) {
     [urlHandler cancelDownloadRequestAsync:_id];
 }
 
+void iOSPlatform::updateUrlRequestPriorityImpl(const UrlRequestId _id, float _relativePriority) {
+    __strong TGMapView* mapView = m_mapView;
+    id<TGURLHandler> urlHandler = mapView && mapView.urlHandler ? mapView.urlHandler : m_urlHandler;
+    if ([urlHandler respondsToSelector:@selector(setPriority:forDownloadRequest:)]) {
+        [urlHandler setPriority:_relativePriority forDownloadRequest:_id];
+    }
+}
+
 } // namespace Tangram
@@ -39,6 +39,7 @@ add_executable(tangram
   platforms/common/imgui_impl_glfw.cpp
   platforms/common/imgui_impl_opengl3.cpp
   platforms/common/urlClient.cpp
+  platforms/common/httpCache.cpp
   platforms/common/linuxSystemFontHelper.cpp
   platforms/common/glfwApp.cpp
   platforms/common/user_fns.cpp
@@ -83,6 +84,93 @@ target_compile_options(tangram
   -Wmissing-field-initializers
 )
 
+# glyph pack builder, see core/src/text/glyphPack.h
+add_executable(tangram-glyphpack
+  platforms/common/glyphPackTool.cpp
+)
+
+target_include_directories(tangram-glyphpack
+  PRIVATE
+  platforms/common
+  platforms/common/imgui
+  core/src
+)
+
+target_link_libraries(tangram-glyphpack
+  PRIVATE
+  tangram-core
+)
+
+target_compile_definitions(tangram-glyphpack PRIVATE GLM_FORCE_CTOR_INIT)
+
+# offscreen image renderer, see Map::renderToImage()
+if(TANGRAM_BUILD_HEADLESS)
+  find_package(OpenGL REQUIRED COMPONENTS EGL)
+
+  add_executable(tangram-render
+    platforms/linux/src/linuxPlatform.cpp
+    platforms/common/platform_gl.cpp
+    platforms/common/urlClient.cpp
+    platforms/common/httpCache.cpp
+    platforms/common/linuxSystemFontHelper.cpp
+    platforms/linux/src/eglContext.cpp
+    platforms/linux/src/headless.cpp
+  )
+
+  target_include_directories(tangram-render
+    PRIVATE
+    platforms/common
+    core/deps/glm
+    ${FONTCONFIG_INCLUDE_DIRS}
+  )
+
+  target_link_libraries(tangram-render
+    PRIVATE
+    tangram-core
+    miniz
+    OpenGL::EGL
+    ${OPENGL_LIBRARIES}
+    ${FONTCONFIG_LDFLAGS}
+    ${CURL_LIBRARIES}
+    -pthread
+    -ldl
+  )
+
+  target_compile_definitions(tangram-render PRIVATE GLM_FORCE_CTOR_INIT)
+
+  # replays sessions recorded with Map::startRecording()
+  add_executable(tangram-replay
+    platforms/linux/src/linuxPlatform.cpp
+    platforms/common/platform_gl.cpp
+    platforms/common/urlClient.cpp
+    platforms/common/httpCache.cpp
+    platforms/common/linuxSystemFontHelper.cpp
+    platforms/linux/src/eglContext.cpp
+    platforms/linux/src/replay.cpp
+  )
+
+  target_include_directories(tangram-replay
+    PRIVATE
+    platforms/common
+    core/src
+    core/deps/glm
+    ${FONTCONFIG_INCLUDE_DIRS}
+  )
+
+  target_link_libraries(tangram-replay
+    PRIVATE
+    tangram-core
+    OpenGL::EGL
+    ${OPENGL_LIBRARIES}
+    ${FONTCONFIG_LDFLAGS}
+    ${CURL_LIBRARIES}
+    -pthread
+    -ldl
+  )
+
+  target_compile_definitions(tangram-replay PRIVATE GLM_FORCE_CTOR_INIT)
+endif()
+
 # tracing
 if(CMAKE_BUILD_TYPE MATCHES RelWithDebInfo)
   target_compile_definitions(tangram-core PRIVATE TANGRAM_TRACING=1)
@@ -0,0 +1,49 @@
+#include "eglContext.h"
+
+#include "log.h"
+
+namespace Tangram {
+
+bool createEglContext(int _width, int _height, EGLDisplay& _display, EGLContext& _context, EGLSurface& _surface) {
+    _display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, nullptr, nullptr)) {
+        LOGE("Could not initialize EGL display");
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(_display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        LOGE("No EGL config for offscreen rendering");
+        return false;
+    }
+
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, _width, EGL_HEIGHT, _height, EGL_NONE };
+    _surface = eglCreatePbufferSurface(_display, config, surfaceAttribs);
+
+    eglBindAPI(EGL_OPENGL_API);
+    _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, nullptr);
+
+    if (_surface == EGL_NO_SURFACE || _context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(_display, _surface, _surface, _context)) {
+        LOGE("Could not create EGL context: 0x%x", eglGetError());
+        return false;
+    }
+    return true;
+}
+
+void destroyEglContext(EGLDisplay _display, EGLContext _context, EGLSurface _surface) {
+    eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(_display, _context);
+    eglDestroySurface(_display, _surface);
+    eglTerminate(_display);
+}
+
+} // namespace Tangram
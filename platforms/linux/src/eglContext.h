@@ -0,0 +1,13 @@
+#pragma once
+
+#include <EGL/egl.h>
+
+namespace Tangram {
+
+// Offscreen desktop GL context on a pbuffer surface of @_width x @_height, made current;
+// surfaceless contexts are not supported by all drivers
+bool createEglContext(int _width, int _height, EGLDisplay& _display, EGLContext& _context, EGLSurface& _surface);
+
+void destroyEglContext(EGLDisplay _display, EGLContext _context, EGLSurface _surface);
+
+} // namespace Tangram
@@ -0,0 +1,162 @@
+// Renders static map images without a display, e.g. on a server
+//
+// tangram-render [-f scene.yaml] [-w width] [-h height] [-d density] lng,lat,zoom[,rotation,tilt]=out.png ...
+//
+// All images are queued with Map::renderToImage() against one offscreen EGL context and
+// rendered as soon as their tiles are loaded and labels have settled, without frame pacing.
+
+#include "eglContext.h"
+#include "linuxPlatform.h"
+#include "log.h"
+#include "map.h"
+#include "sceneOptions.h"
+
+#include "miniz.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace Tangram;
+
+// Seconds passed to Map::update() per iteration, long enough for label fades to finish at once
+static const float UPDATE_STEP = 1.f;
+// Give up on images whose tiles did not load in this many seconds
+static const int TIMEOUT_SECONDS = 60;
+
+struct Job {
+    CameraPosition camera;
+    std::string output;
+};
+
+static void usage() {
+    fprintf(stderr, "usage: tangram-render [-f scene.yaml] [-w width] [-h height] [-d density] "
+                    "lng,lat,zoom[,rotation,tilt]=out.png ...\n");
+}
+
+static bool parseJob(const char* _arg, Job& _job) {
+    const char* eq = strchr(_arg, '=');
+    if (!eq || !eq[1]) { return false; }
+
+    double values[5] = { 0, 0, 0, 0, 0 };
+    int count = 0;
+    const char* p = _arg;
+    while (p < eq && count < 5) {
+        char* end = nullptr;
+        values[count++] = strtod(p, &end);
+        if (end == p) { return false; }
+        p = (*end == ',') ? end + 1 : end;
+    }
+    if (count < 3 || p != eq) { return false; }
+
+    _job.camera.longitude = values[0];
+    _job.camera.latitude = values[1];
+    _job.camera.zoom = float(values[2]);
+    _job.camera.rotation = float(values[3]);
+    _job.camera.tilt = float(values[4]);
+    _job.output = std::string(eq + 1);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    std::string sceneFile = "res/scene.yaml";
+    int width = 512, height = 512;
+    float density = 1.f;
+    std::vector<Job> jobs;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-f") == 0 && hasValue) {
+            sceneFile = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && hasValue) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-h") == 0 && hasValue) {
+            height = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0 && hasValue) {
+            density = float(atof(argv[++i]));
+        } else {
+            Job job;
+            if (!parseJob(argv[i], job)) {
+                usage();
+                return 1;
+            }
+            jobs.push_back(job);
+        }
+    }
+    if (jobs.empty() || width <= 0 || height <= 0 || density <= 0.f) {
+        usage();
+        return 1;
+    }
+
+    EGLDisplay display;
+    EGLContext context;
+    EGLSurface surface;
+    // Images are rendered into their own framebuffers, the pbuffer only makes the context current
+    if (!createEglContext(1, 1, display, context, surface)) { return 1; }
+
+    // Resolve the scene path against the current directory
+    Url baseUrl("file:///");
+    char pathBuffer[PATH_MAX] = {0};
+    if (getcwd(pathBuffer, PATH_MAX) != nullptr) {
+        baseUrl = baseUrl.resolve(Url(std::string(pathBuffer) + "/"));
+    }
+
+    auto map = std::make_unique<Map>(std::make_unique<LinuxPlatform>());
+    map->setPixelScale(density);
+    map->setupGL();
+    map->resize(width, height);
+    map->loadScene(SceneOptions{baseUrl.resolve(Url(sceneFile))}, false);
+
+    int remaining = int(jobs.size());
+    int failed = 0;
+    for (auto& job : jobs) {
+        std::string output = job.output;
+        map->renderToImage(job.camera, width, height,
+                           [&, output](const unsigned int* _pixels, int _width, int _height) {
+            remaining--;
+            size_t length = 0;
+            void* png = nullptr;
+            if (_pixels) {
+                // Rows are read from bottom to top
+                png = tdefl_write_image_to_png_file_in_memory_ex(_pixels, _width, _height, 4,
+                                                                 &length, 6, MZ_TRUE);
+            }
+            FILE* file = png ? fopen(output.c_str(), "wb") : nullptr;
+            if (!file || fwrite(png, 1, length, file) != length) {
+                LOGE("Could not write %s", output.c_str());
+                failed++;
+            } else {
+                LOG("Wrote %s", output.c_str());
+            }
+            if (file) { fclose(file); }
+            mz_free(png);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (remaining > 0) {
+        map->update(UPDATE_STEP);
+        map->render();
+
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(TIMEOUT_SECONDS)) {
+            LOGE("Timed out with %d images left", remaining);
+            failed += remaining;
+            break;
+        }
+        // Let tile workers and downloads progress while nothing is ready
+        usleep(1000);
+    }
+
+    map.reset();
+
+    destroyEglContext(display, context, surface);
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+// Replays a session recorded with Map::startRecording() without a display, for comparing the
+// frame times and tile latencies of builds on the same interaction
+//
+// tangram-replay [-t step] [-w] [-o] session.tgrec
+//
+// The recorded calls are made before the same updates as when recording, with the recorded time
+// steps or a fixed step (-t, in seconds); URLs are served from the recorded responses. -w waits
+// for the tiles and scene to load after each frame, so that every replay draws the same frames;
+// -o fails URLs that were not recorded instead of loading them.
+
+#include "debug/sessionRecording.h"
+#include "eglContext.h"
+#include "linuxPlatform.h"
+#include "log.h"
+#include "map.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace Tangram;
+
+// Give up waiting for the tiles of a frame after this many seconds
+static const int TIMEOUT_SECONDS = 60;
+
+static const char* NOT_RECORDED = "Not recorded";
+
+class ReplayPlatform : public LinuxPlatform {
+public:
+    ReplayPlatform(SessionPlayer& _player, bool _offline) : m_player(_player), m_offline(_offline) {}
+
+    bool startUrlRequestImpl(const Url& _url, const HttpOptions& _options,
+                             const UrlRequestHandle _request, UrlRequestId& _id) override {
+        UrlResponse response;
+        if (m_player.response(_url.string(), response)) {
+            // Respond at once, like on a cache hit, so that no timing of the network remains
+            onUrlResponse(_request, std::move(response));
+            return false;
+        }
+        misses++;
+        if (m_offline) {
+            response.error = NOT_RECORDED;
+            onUrlResponse(_request, std::move(response));
+            return false;
+        }
+        return LinuxPlatform::startUrlRequestImpl(_url, _options, _request, _id);
+    }
+
+    std::atomic<int> misses{0};
+
+private:
+    SessionPlayer& m_player;
+    bool m_offline;
+};
+
+static void usage() {
+    fprintf(stderr, "usage: tangram-replay [-t step] [-w] [-o] session.tgrec\n");
+}
+
+static float percentile(const std::vector<float>& _sorted, float _p) {
+    if (_sorted.empty()) { return 0.f; }
+    size_t rank = size_t(std::ceil(_p / 100.f * _sorted.size()));
+    return _sorted[std::min(std::max(rank, size_t(1)), _sorted.size()) - 1];
+}
+
+int main(int argc, char* argv[]) {
+
+    float fixedStep = 0.f;
+    bool waitForTiles = false;
+    bool offline = false;
+    const char* input = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-t") == 0 && hasValue) {
+            fixedStep = float(atof(argv[++i]));
+        } else if (strcmp(argv[i], "-w") == 0) {
+            waitForTiles = true;
+        } else if (strcmp(argv[i], "-o") == 0) {
+            offline = true;
+        } else if (!input && argv[i][0] != '-') {
+            input = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!input || fixedStep < 0.f) {
+        usage();
+        return 1;
+    }
+
+    std::ifstream file(input, std::ios::binary);
+    std::stringstream data;
+    data << file.rdbuf();
+
+    SessionRecording recording;
+    if (!file || !recording.load(data.str())) {
+        LOGE("Could not read the session %s", input);
+        return 1;
+    }
+    if (recording.calls.empty() || recording.calls[0].name != "setViewport" ||
+        recording.calls[0].numbers.size() < 4) {
+        LOGE("The session %s does not start with the viewport", input);
+        return 1;
+    }
+    int width = std::max(1, int(recording.calls[0].numbers[2]));
+    int height = std::max(1, int(recording.calls[0].numbers[3]));
+
+    EGLDisplay display;
+    EGLContext context;
+    EGLSurface surface;
+    if (!createEglContext(width, height, display, context, surface)) { return 1; }
+
+    SessionPlayer player(recording);
+    auto platform = std::make_unique<ReplayPlatform>(player, offline);
+    auto& replayPlatform = *platform;
+
+    auto map = std::make_unique<Map>(std::move(platform));
+    map->setupGL();
+
+    size_t frames = recording.frames.size();
+    std::vector<float> frameTimes;
+    frameTimes.reserve(frames);
+    bool timedOut = false;
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        player.applyCalls(*map, frame);
+
+        float dt = fixedStep > 0.f ? fixedStep : recording.frames[frame];
+        auto start = std::chrono::steady_clock::now();
+        MapState state = map->update(dt);
+        map->render();
+        frameTimes.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        if (!waitForTiles || timedOut) { continue; }
+
+        auto waitStart = std::chrono::steady_clock::now();
+        while (state.tilesLoading() || state.sceneLoading()) {
+            if (std::chrono::steady_clock::now() - waitStart > std::chrono::seconds(TIMEOUT_SECONDS)) {
+                LOGE("Timed out waiting for the tiles of frame %u, not waiting any longer", frame);
+                timedOut = true;
+                break;
+            }
+            usleep(1000);
+            state = map->update(0.f);
+        }
+    }
+    player.applyCalls(*map, uint32_t(frames));
+
+    auto stats = map->getPerformanceStats();
+
+    std::vector<float> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    float total = 0.f;
+    for (float time : frameTimes) { total += time; }
+
+    printf("frames:             %zu\n", frameTimes.size());
+    printf("frame ms (update and render): average %.2f, p50 %.2f, p90 %.2f, p95 %.2f, p99 %.2f, max %.2f\n",
+           frameTimes.empty() ? 0.f : total / frameTimes.size(), percentile(sorted, 50),
+           percentile(sorted, 90), percentile(sorted, 95), percentile(sorted, 99),
+           sorted.empty() ? 0.f : sorted.back());
+    printf("render ms:          average %.2f, p95 <= %.0f\n", stats.frameTimeAverage, stats.frameTimeP95);
+    for (size_t i = 0; i < stats.frameTimeCounts.size(); i++) {
+        if (i + 1 < stats.frameTimeCounts.size()) {
+            printf("  <= %5.0f ms: %u\n", stats.frameTimeBounds[i], stats.frameTimeCounts[i]);
+        } else if (i > 0) {
+            printf("   > %5.0f ms: %u\n", stats.frameTimeBounds[i - 1], stats.frameTimeCounts[i]);
+        }
+    }
+    printf("tiles completed:    %u\n", stats.tilesCompleted);
+    printf("tile latency ms:    average %.1f, p50 <= %.0f, p95 <= %.0f\n",
+           stats.tileLatencyAverage, stats.tileLatencyP50, stats.tileLatencyP95);
+    printf("tiles built:        %u, parse ms %.2f, build ms %.2f\n",
+           stats.tilesBuilt, stats.parseTimeAverage, stats.buildTimeAverage);
+    if (stats.allocProfiling) {
+        printf("allocations/tile:   parse %.0f (%.0f bytes), build %.0f (%.0f bytes)\n",
+               stats.parseAllocations, stats.parseAllocBytes, stats.buildAllocations, stats.buildAllocBytes);
+    }
+    printf("URLs not recorded:  %d\n", replayPlatform.misses.load());
+
+    map.reset();
+
+    destroyEglContext(display, context, surface);
+
+    return timedOut ? 1 : 0;
+}
@@ -36,11 +36,14 @@ void OSXPlatform::requestRender() const {
 OSXPlatform::OSXPlatform() {
     NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
     NSString *cachePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"/tile_cache"];
-    NSURLCache *tileCache = [[NSURLCache alloc] initWithMemoryCapacity: 4 * 1024 * 1024 diskCapacity: 30 * 1024 * 1024 diskPath: cachePath];
+    // Loaded tiles are held in memory by the tile caches of the map, keep only a disk cache here
+    NSURLCache *tileCache = [[NSURLCache alloc] initWithMemoryCapacity: 0 diskCapacity: 50 * 1024 * 1024 diskPath: cachePath];
     configuration.URLCache = tileCache;
     configuration.requestCachePolicy = NSURLRequestUseProtocolCachePolicy;
     configuration.timeoutIntervalForRequest = 30;
     configuration.timeoutIntervalForResource = 60;
+    // HTTP/2 servers multiplex all requests over one connection; this only bounds HTTP/1.1 hosts
+    configuration.HTTPMaximumConnectionsPerHost = 6;
 
     m_urlSession = [NSURLSession sessionWithConfiguration: configuration];
 }
@@ -138,7 +141,7 @@ FontSourceHandle OSXPlatform::systemFont(const std::string& _name, const std::st
     return FontSourceHandle(std::string(font.fontName.UTF8String));
 }
 
-bool OSXPlatform::startUrlRequestImpl(const Url& _url, const UrlRequestHandle _request, UrlRequestId& _id) {
+bool OSXPlatform::startUrlRequestImpl(const Url& _url, const HttpOptions& _options, const UrlRequestHandle _request, UrlRequestId& _id) {
 
     void (^handler)(NSData*, NSURLResponse*, NSError*) = ^void (NSData* data, NSURLResponse* response, NSError* error) {
 
@@ -154,6 +157,7 @@ bool OSXPlatform::startUrlRequestImpl(const Url& _url, const UrlRequestHandle _r
 
             NSHTTPURLResponse* httpResponse = (NSHTTPURLResponse*)response;
             int statusCode = [httpResponse statusCode];
+            urlResponse.status = statusCode;
             if (statusCode >= 400) {
                 urlResponse.error = [[NSHTTPURLResponse localizedStringForStatusCode: statusCode] UTF8String];
             }
@@ -174,6 +178,7 @@ bool OSXPlatform::startUrlRequestImpl(const Url& _url, const UrlRequestHandle _r
 
     NSURL* nsUrl = [NSURL URLWithString:[NSString stringWithUTF8String:_url.string().c_str()]];
     NSURLSessionDataTask* dataTask = [m_urlSession dataTaskWithURL:nsUrl completionHandler:handler];
+    dataTask.priority = _options.relativePriority();
 
     [dataTask resume];
 
@@ -195,4 +200,16 @@ void OSXPlatform::cancelUrlRequestImpl(const UrlRequestId _id) {
     }];
 }
 
+void OSXPlatform::updateUrlRequestPriorityImpl(const UrlRequestId _id, float _relativePriority) {
+
+    [m_urlSession getTasksWithCompletionHandler:^(NSArray* dataTasks, NSArray* uploadTasks, NSArray* downloadTasks) {
+        for (NSURLSessionTask* task in dataTasks) {
+            if ([task taskIdentifier] == _id) {
+                task.priority = _relativePriority;
+                break;
+            }
+        }
+    }];
+}
+
 } // namespace Tangram
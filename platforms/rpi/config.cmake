@@ -14,6 +14,7 @@ add_executable(tangram
   platforms/rpi/src/main.cpp
   platforms/rpi/src/rpiPlatform.cpp
   platforms/common/urlClient.cpp
+  platforms/common/httpCache.cpp
   platforms/common/linuxSystemFontHelper.cpp
   platforms/common/platform_gl.cpp
 )
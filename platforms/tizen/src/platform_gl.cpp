@@ -120,6 +120,13 @@ void GL::getProgramiv(GLuint program, GLenum pname, GLint *params) {
 void GL::getShaderiv(GLuint shader, GLenum pname, GLint *params) {
     __evas_gl_glapi->glGetShaderiv(shader,pname, params);
 }
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+    __evas_gl_glapi->glGetProgramBinaryOES(program, bufSize, length, binaryFormat, binary);
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+    __evas_gl_glapi->glProgramBinaryOES(program, binaryFormat, binary, length);
+}
 
 // Buffers
 void GL::bindBuffer(GLenum target, GLuint buffer) {
@@ -137,6 +144,15 @@ void GL::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usa
 void GL::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
     __evas_gl_glapi->glBufferSubData(target, offset, size, data);
 }
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    __evas_gl_glapi->glBindBufferBase(target, index, buffer);
+}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    return __evas_gl_glapi->glGetUniformBlockIndex(program, uniformBlockName);
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+    __evas_gl_glapi->glUniformBlockBinding(program, uniformBlockIndex, uniformBlockBinding);
+}
 void GL::readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                     GLenum format, GLenum type, GLvoid* pixels) {
     __evas_gl_glapi->glReadPixels(x, y, width, height, format, type, pixels);
@@ -158,10 +174,17 @@ void GL::deleteTextures(GLsizei n, const GLuint *textures) {
 void GL::texParameteri(GLenum target, GLenum pname, GLint param ) {
     __evas_gl_glapi->glTexParameteri(target, pname, param );
 }
+void GL::pixelStorei(GLenum pname, GLint param) {
+    __evas_gl_glapi->glPixelStorei(pname, param);
+}
 void GL::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
                     GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
     __evas_gl_glapi->glTexImage2D(target, level, internalFormat, width, height, border, format, type, pixels); }
 
+void GL::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                              GLint border, GLsizei imageSize, const GLvoid *data) {
+    __evas_gl_glapi->glCompressedTexImage2D(target, level, internalFormat, width, height, border, imageSize, data); }
+
 void GL::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                        GLenum format, GLenum type, const GLvoid *pixels) {
     __evas_gl_glapi->glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels); }
@@ -170,6 +193,27 @@ void GL::generateMipmap(GLenum target) {
     __evas_gl_glapi->glGenerateMipmap(target);
 }
 
+void GL::texImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                    GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
+    __evas_gl_glapi->glTexImage3D(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+}
+void GL::texSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                       GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+                       const GLvoid *pixels) {
+    __evas_gl_glapi->glTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+}
+void GL::compressedTexImage3D(GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+                              GLsizei height, GLsizei depth, GLint border, GLsizei imageSize,
+                              const GLvoid *data) {
+    __evas_gl_glapi->glCompressedTexImage3D(target, level, internalFormat, width, height, depth, border, imageSize, data);
+}
+void GL::compressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                 GLsizei width, GLsizei height, GLsizei depth, GLenum format,
+                                 GLsizei imageSize, const GLvoid *data) {
+    __evas_gl_glapi->glCompressedTexSubImage3D(target, level, xoffset, yoffset, zoffset, width, height, depth,
+                                               format, imageSize, data);
+}
+
 void GL::enableVertexAttribArray(GLuint index) {
     __evas_gl_glapi->glEnableVertexAttribArray(index);
 }
@@ -187,6 +231,13 @@ void GL::drawArrays(GLenum mode, GLint first, GLsizei count ) {
 void GL::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
     __evas_gl_glapi->glDrawElements(mode, count, type, indices );
 }
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    __evas_gl_glapi->glVertexAttribDivisor(index, divisor);
+}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices,
+                               GLsizei instancecount) {
+    __evas_gl_glapi->glDrawElementsInstanced(mode, count, type, indices, instancecount);
+}
 
 void GL::uniform1f(GLint location, GLfloat v0) {
     __evas_gl_glapi->glUniform1f(location, v0);
@@ -256,6 +307,37 @@ void* GL::mapBuffer(GLenum target, GLenum access) {
 GLboolean GL::unmapBuffer(GLenum target) {
     return __evas_gl_glapi->glUnmapBufferOES(target);
 }
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return __evas_gl_glapi->glMapBufferRange(target, offset, length, access);
+}
+GLsync GL::fenceSync(GLenum condition, GLbitfield flags) {
+    return __evas_gl_glapi->glFenceSync(condition, flags);
+}
+GLenum GL::clientWaitSync(GLsync sync, GLbitfield flags, unsigned long long timeout) {
+    return __evas_gl_glapi->glClientWaitSync(sync, flags, timeout);
+}
+void GL::deleteSync(GLsync sync) {
+    __evas_gl_glapi->glDeleteSync(sync);
+}
+void GL::blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                         GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                         GLbitfield mask, GLenum filter) {
+    __evas_gl_glapi->glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+// Timer queries are not used on Tizen, see Hardware::supportsTimerQuery
+void GL::genQueries(GLsizei n, GLuint *ids) {
+}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {
+}
+void GL::beginQuery(GLenum target, GLuint id) {
+}
+void GL::endQuery(GLenum target) {
+}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, unsigned long long *params) {
+}
 
 void GL::finish(void) {
     __evas_gl_glapi->glFinish();
@@ -16,6 +16,7 @@ add_executable(tangram
   platforms/windows/src/main.cpp
   platforms/common/platform_gl.cpp
   platforms/common/urlClient.cpp
+  platforms/common/httpCache.cpp
   platforms/common/glfwApp.cpp
   platforms/common/imgui_impl_glfw.cpp
   platforms/common/imgui_impl_opengl3.cpp
@@ -6,33 +6,80 @@ MODULE_BASE = $(MAKE_BASE)
 
 # unit tests
 MODULE_SOURCES = \
+  unit/clientDataSourceTests.cpp \
+  unit/clipTests.cpp \
+  unit/clusterSourceTests.cpp \
+  unit/collisionCacheTests.cpp \
+  unit/collisionGridTests.cpp \
+  unit/contourLineTests.cpp \
   unit/curlTests.cpp \
+  unit/curvedLayoutTests.cpp \
+  unit/dashAtlasTests.cpp \
   unit/drawRuleTests.cpp \
   unit/dukTests.cpp \
+  unit/elevationPyramidTests.cpp \
+  unit/elevationTests.cpp \
+  unit/extrusionWallTests.cpp \
+  unit/featureTableTests.cpp \
   unit/fileTests.cpp \
   unit/flyToTest.cpp \
+  unit/geoJsonStreamTests.cpp \
+  unit/geoJsonTests.cpp \
+  unit/geoTiffTests.cpp \
+  unit/glyphPackTests.cpp \
+  unit/ioExecutorTests.cpp \
   unit/jobQueueTests.cpp \
   unit/labelsTests.cpp \
   unit/labelTests.cpp \
   unit/layerTests.cpp \
+  unit/lineMergerTests.cpp \
   unit/lngLatTests.cpp \
+  unit/mapContextTests.cpp \
   unit/mapProjectionTests.cpp \
+  unit/markerAtlasTests.cpp \
+  unit/markerTests.cpp \
+  unit/memoryCacheDataSourceTests.cpp \
   unit/meshTests.cpp \
+  unit/mltTests.cpp \
+  unit/mvtTests.cpp \
   unit/networkDataSourceTests.cpp \
+  unit/normalMapTests.cpp \
+  unit/objectPoolTests.cpp \
+  unit/offlineRegionTests.cpp \
+  unit/pickIndexTests.cpp \
+  unit/platformTests.cpp \
+  unit/rasterCacheTests.cpp \
+  unit/renderSchedulerTests.cpp \
+  unit/requestLimiterTests.cpp \
+  unit/resolutionScalerTests.cpp \
+  unit/retainedDataTests.cpp \
   unit/sceneImportTests.cpp \
   unit/sceneLoaderTests.cpp \
   unit/sceneUpdateTests.cpp \
+  unit/sessionRecordingTests.cpp \
+  unit/simplifyTests.cpp \
   unit/stopsTests.cpp \
+  unit/styleExpressionTests.cpp \
   unit/styleMixerTests.cpp \
   unit/styleParamTests.cpp \
   unit/styleSortingTests.cpp \
   unit/styleUniformsTests.cpp \
+  unit/textLayoutCacheTests.cpp \
   unit/textureTests.cpp \
+  unit/threadPlacementTests.cpp \
+  unit/tileAvailabilityTests.cpp \
   unit/tileIDTests.cpp \
   unit/tileManagerTests.cpp \
+  unit/timeHistogramTests.cpp \
+  unit/topoJsonTests.cpp \
+  unit/traceTests.cpp \
+  unit/triangulationCacheTests.cpp \
   unit/urlTests.cpp \
+  unit/vertexCacheTests.cpp \
+  unit/workerPoolTests.cpp \
   unit/yamlFilterTests.cpp \
-  unit/yamlUtilTests.cpp
+  unit/yamlUtilTests.cpp \
+  unit/zlibHelperTests.cpp
 
 # mock platform
 MODULE_SOURCES += \
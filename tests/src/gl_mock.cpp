@@ -87,6 +87,11 @@ void GL::getProgramiv(GLuint program, GLenum pname, GLint *params) {
 }
 void GL::getShaderiv(GLuint shader, GLenum pname, GLint *params) {
 }
+void GL::getProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length,
+                          GLenum *binaryFormat, void *binary) {
+}
+void GL::programBinary(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) {
+}
 
 // Buffers
 void GL::bindBuffer(GLenum target, GLuint buffer) {
@@ -99,6 +104,13 @@ void GL::bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usa
 }
 void GL::bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
 }
+void GL::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+}
+GLuint GL::getUniformBlockIndex(GLuint program, const GLchar *uniformBlockName) {
+    return GL_INVALID_INDEX;
+}
+void GL::uniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) {
+}
 void GL::readPixels(GLint x, GLint y, GLsizei width, GLsizei height,
                     GLenum format, GLenum type, GLvoid* pixels) {
 }
@@ -114,14 +126,34 @@ void GL::deleteTextures(GLsizei n, const GLuint *textures) {
 }
 void GL::texParameteri(GLenum target, GLenum pname, GLint param ) {
 }
+void GL::pixelStorei(GLenum pname, GLint param) {
+}
 void GL::texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
                     GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
 }
+void GL::compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height,
+                              GLint border, GLsizei imageSize, const GLvoid *data) {
+}
 void GL::texSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
                        GLenum format, GLenum type, const GLvoid *pixels) {
 }
 void GL::generateMipmap(GLenum target) {
 }
+void GL::texImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+                    GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid *pixels) {
+}
+void GL::texSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                       GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type,
+                       const GLvoid *pixels) {
+}
+void GL::compressedTexImage3D(GLenum target, GLint level, GLenum internalFormat, GLsizei width,
+                              GLsizei height, GLsizei depth, GLint border, GLsizei imageSize,
+                              const GLvoid *data) {
+}
+void GL::compressedTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                 GLsizei width, GLsizei height, GLsizei depth, GLenum format,
+                                 GLsizei imageSize, const GLvoid *data) {
+}
 
 void GL::enableVertexAttribArray(GLuint index) {
 }
@@ -137,6 +169,11 @@ void GL::drawArrays(GLenum mode, GLint first, GLsizei count ) {
 }
 void GL::drawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices ) {
 }
+void GL::vertexAttribDivisor(GLuint index, GLuint divisor) {
+}
+void GL::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices,
+                               GLsizei instancecount) {
+}
 
 void GL::uniform1f(GLint location, GLfloat v0) {
 }
@@ -187,6 +224,34 @@ void* GL::mapBuffer(GLenum target, GLenum access) {
 GLboolean GL::unmapBuffer(GLenum target) {
     return true;
 }
+void* GL::mapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    return nullptr;
+}
+GLsync GL::fenceSync(GLenum condition, GLbitfield flags) {
+    return nullptr;
+}
+GLenum GL::clientWaitSync(GLsync sync, GLbitfield flags, unsigned long long timeout) {
+    return GL_WAIT_FAILED;
+}
+void GL::deleteSync(GLsync sync) {
+}
+void GL::blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                         GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                         GLbitfield mask, GLenum filter) {
+}
+
+void GL::genQueries(GLsizei n, GLuint *ids) {
+}
+void GL::deleteQueries(GLsizei n, const GLuint *ids) {
+}
+void GL::beginQuery(GLenum target, GLuint id) {
+}
+void GL::endQuery(GLenum target) {
+}
+void GL::getQueryObjectuiv(GLuint id, GLenum pname, GLuint *params) {
+}
+void GL::getQueryObjectui64v(GLuint id, GLenum pname, unsigned long long *params) {
+}
 
 void GL::finish(void) {
 }
@@ -0,0 +1,175 @@
+#include "catch.hpp"
+
+#include "data/clientDataSource.h"
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "mockPlatform.h"
+#include "tile/tileTask.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace Tangram;
+
+#define TAGS "[ClientDataSource]"
+
+struct TestClientDataSource : ClientDataSource {
+    using ClientDataSource::ClientDataSource;
+
+    std::vector<Feature> features(TileID _tileId) {
+        TileTask task(_tileId, this);
+        std::vector<Feature> result;
+        if (auto data = parse(task)) {
+            for (auto& layer : data->layers) {
+                result.insert(result.end(), layer.features.begin(), layer.features.end());
+            }
+        }
+        return result;
+    }
+};
+
+TEST_CASE("Changed features only advance generation of tiles covering them", TAGS) {
+    MockPlatform platform;
+    ClientDataSource source(platform, "client", "");
+
+    // tile 10/511/511 is north-west of (0, 0), 10/800/200 is far away
+    TileID near(511, 511, 10);
+    TileID far(800, 200, 10);
+
+    source.addPointFeature(Properties(), LngLat(-0.1, 0.1));
+    uint64_t moved = source.addPointFeature(Properties(), LngLat(-0.1, 0.2));
+    source.generateTiles();
+
+    int64_t initial = source.tileGeneration(far);
+    CHECK(source.tileGeneration(near) == initial);
+
+    Properties props;
+    props.set("name", "updated");
+    source.setProperties(moved, std::move(props));
+    source.generateTiles();
+
+    CHECK(source.tileGeneration(near) > initial);
+    CHECK(source.tileGeneration(far) == initial);
+    // parent tiles contain the change
+    CHECK(source.tileGeneration(near.getParent()) > initial);
+    CHECK(source.tileGeneration(TileID(0, 0, 0)) > initial);
+
+    int64_t updated = source.tileGeneration(near);
+    source.removeFeature(moved);
+    source.generateTiles();
+    CHECK(source.tileGeneration(near) > updated);
+    CHECK(source.tileGeneration(far) == initial);
+
+    // generation of all tiles advances when features are cleared
+    source.clearFeatures();
+    source.generateTiles();
+    CHECK(source.tileGeneration(far) > initial);
+}
+
+TEST_CASE("Features are added from flat arrays", TAGS) {
+    MockPlatform platform;
+    TestClientDataSource source(platform, "client", "");
+
+    // two lines north-west of (0, 0), one line with two parts east of it
+    std::vector<double> coordinates = { -0.3, 0.1, -0.2, 0.1,  -0.3, 0.2, -0.2, 0.2,
+                                        0.2, 0.1, 0.3, 0.1,  0.2, 0.2, 0.3, 0.2, 0.4, 0.25 };
+    std::vector<uint32_t> featureOffsets = { 0, 1, 2, 4 };
+    std::vector<uint32_t> partOffsets = { 0, 2, 4, 6, 9 };
+    std::vector<double> ranks = { 1, NAN, 3 };
+    std::vector<const char*> names = { "a", "b", nullptr };
+
+    ClientDataSource::FeatureBatch batch;
+    batch.type = ClientDataSource::FeatureBatch::Type::polylines;
+    batch.featureCount = 3;
+    batch.coordinates = coordinates.data();
+    batch.pointCount = coordinates.size() / 2;
+    batch.featureOffsets = featureOffsets.data();
+    batch.partOffsets = partOffsets.data();
+    batch.partCount = partOffsets.size() - 1;
+    batch.keys = { "rank", "name" };
+    batch.columns = { { ranks.data(), nullptr }, { nullptr, names.data() } };
+
+    CHECK(source.addPointFeature(Properties(), LngLat(-0.1, 0.1)) == 0);
+    CHECK(source.addFeatures(batch) == 1);
+    source.generateTiles();
+
+    auto west = source.features(TileID(511, 511, 10));
+    REQUIRE(west.size() == 3);
+    auto east = source.features(TileID(512, 511, 10));
+    REQUIRE(east.size() == 1);
+    CHECK(east[0].lines().size() == 2);
+    CHECK(east[0].lines()[1].size() == 3);
+    CHECK(east[0].props.getNumber("rank") == 3);
+    CHECK_FALSE(east[0].props.contains("name"));
+
+    size_t named = 0;
+    for (auto& feature : west) {
+        if (feature.props.getString("name") == "b") {
+            named++;
+            CHECK_FALSE(feature.props.contains("rank"));
+        }
+    }
+    CHECK(named == 1);
+
+    // offsets out of range
+    partOffsets.back() = 10;
+    CHECK(source.addFeatures(batch) == uint64_t(-1));
+}
+
+TEST_CASE("Features are opened from a saved index", TAGS) {
+    MockPlatform platform;
+    TestClientDataSource source(platform, "client", "", true);
+
+    Properties props;
+    props.set("name", "park");
+    ClientDataSource::PolygonBuilder polygon;
+    polygon.beginPolygon(1);
+    polygon.beginRing(4);
+    for (auto point : { LngLat(-0.3, 0.1), LngLat(-0.2, 0.1), LngLat(-0.2, 0.2), LngLat(-0.3, 0.1) }) {
+        polygon.addPoint(point);
+    }
+    source.addPolygonFeature(std::move(props), std::move(polygon));
+    uint64_t removed = source.addPointFeature(Properties(), LngLat(-0.1, 0.1));
+    source.removeFeature(removed);
+    props.set("rank", 2);
+    uint64_t point = source.addPointFeature(std::move(props), LngLat(0.1, 0.1));
+    source.generateTiles();
+
+    std::string path = "client_index_test.bin";
+    REQUIRE(source.saveIndex(path, 42));
+
+    TestClientDataSource opened(platform, "client", "", true);
+    CHECK_FALSE(opened.openIndex(path, 43));
+    CHECK_FALSE(TestClientDataSource(platform, "client", "").openIndex(path, 42));
+    REQUIRE(opened.openIndex(path, 42));
+
+    // polygon and its centroid
+    auto west = opened.features(TileID(511, 511, 10));
+    REQUIRE(west.size() == 2);
+    REQUIRE(west[0].geometryType == GeometryType::polygons);
+    CHECK(west[0].coordinates == source.features(TileID(511, 511, 10))[0].coordinates);
+    CHECK(west[0].props.getString("name") == "park");
+    CHECK(west[1].props.getNumber("label_placement") == 1);
+
+    auto east = opened.features(TileID(512, 511, 10));
+    REQUIRE(east.size() == 1);
+    CHECK(east[0].props.getNumber("rank") == 2);
+
+    // opened features are changed as others
+    Properties changed;
+    changed.set("rank", 3);
+    int64_t generation = opened.tileGeneration(TileID(512, 511, 10));
+    opened.setProperties(point, std::move(changed));
+    opened.generateTiles();
+    CHECK(opened.tileGeneration(TileID(512, 511, 10)) > generation);
+    east = opened.features(TileID(512, 511, 10));
+    REQUIRE(east.size() == 1);
+    CHECK(east[0].props.getNumber("rank") == 3);
+
+    opened.removeFeature(point);
+    opened.generateTiles();
+    CHECK(opened.features(TileID(512, 511, 10)).empty());
+
+    std::remove(path.c_str());
+}
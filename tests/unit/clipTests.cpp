@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "util/clip.h"
+
+using namespace Tangram;
+
+TEST_CASE("Clip a line to the tile and its margin", "[Core][Clip]") {
+
+    GeometryClipper clipper;
+    std::vector<Point> line = { {-0.5f, 0.5f}, {0.5f, 0.5f}, {0.5f, 1.5f}, {0.6f, 1.5f}, {0.6f, 0.5f} };
+
+    // Disabled by default
+    auto pieces = clipper.clip(LineView(line));
+    REQUIRE(pieces.size() == 1);
+    REQUIRE(pieces[0].data() == line.data());
+    REQUIRE(pieces[0].size() == 5);
+
+    clipper.setMargin(0.1f);
+    pieces = clipper.clip(LineView(line));
+
+    // Leaves the tile at the top and enters it again
+    REQUIRE(pieces.size() == 2);
+    REQUIRE(pieces[0].size() == 3);
+    REQUIRE(pieces[0][0].x == Approx(-0.1f));
+    REQUIRE(pieces[0][1] == Point(0.5f, 0.5f));
+    REQUIRE(pieces[0][2].y == Approx(1.1f));
+    REQUIRE(pieces[1].size() == 2);
+    REQUIRE(pieces[1][0].y == Approx(1.1f));
+    REQUIRE(pieces[1][1] == Point(0.6f, 0.5f));
+
+    // Within a larger margin
+    pieces = clipper.clip(LineView(line), 0.5f);
+    REQUIRE(pieces.size() == 1);
+    REQUIRE(pieces[0].data() == line.data());
+}
+
+TEST_CASE("Clip polygon rings to the tile and its margin", "[Core][Clip]") {
+
+    GeometryClipper clipper;
+    clipper.setMargin(0.f);
+
+    Feature feature;
+    feature.addPolygon({
+        // Square over the right edge
+        { {0.5f, 0.f}, {1.5f, 0.f}, {1.5f, 1.f}, {0.5f, 1.f}, {0.5f, 0.f} },
+        // Hole outside of the tile
+        { {1.2f, 0.4f}, {1.2f, 0.6f}, {1.4f, 0.6f}, {1.4f, 0.4f}, {1.2f, 0.4f} },
+        // Hole within it
+        { {0.6f, 0.4f}, {0.6f, 0.6f}, {0.8f, 0.6f}, {0.8f, 0.4f}, {0.6f, 0.4f} },
+    });
+
+    auto polygon = clipper.clip(feature.polygons()[0]);
+
+    REQUIRE(polygon.size() == 2);
+    REQUIRE(polygon[0].size() == 5);
+    REQUIRE(polygon[0].front() == polygon[0].back());
+    for (const auto& p : polygon[0]) {
+        REQUIRE(p.x >= 0.5f);
+        REQUIRE(p.x <= 1.f);
+    }
+    REQUIRE(polygon[1][0] == Point(0.6f, 0.4f));
+
+    // Outside of the tile
+    Feature outside;
+    outside.addPolygon({ { {2.f, 0.f}, {3.f, 0.f}, {3.f, 1.f}, {2.f, 0.f} } });
+    REQUIRE(clipper.clip(outside.polygons()[0]).empty());
+
+    // Within the tile
+    Feature inside;
+    inside.addPolygon({ { {0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 0.f} } });
+    REQUIRE(clipper.clip(inside.polygons()[0]).front().data() == inside.polygons()[0].front().data());
+}
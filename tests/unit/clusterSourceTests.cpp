@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include "data/clusterSource.h"
+#include "data/properties.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "tile/tileTask.h"
+
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[ClusterSource]"
+
+struct TestClusterSource : ClusterSource {
+    using ClusterSource::ClusterSource;
+
+    std::vector<Feature> features(TileID _tileId) {
+        TileTask task(_tileId, this);
+        std::vector<Feature> result;
+        if (auto data = parse(task)) {
+            for (auto& layer : data->layers) {
+                result.insert(result.end(), layer.features.begin(), layer.features.end());
+            }
+        }
+        return result;
+    }
+};
+
+static double pointCount(const std::vector<Feature>& _features) {
+    double count = 0;
+    for (auto& feature : _features) {
+        auto& value = feature.props.get("point_count");
+        count += value.is<double>() ? value.get<double>() : 1;
+    }
+    return count;
+}
+
+TEST_CASE("Points are clustered by zoom", TAGS) {
+    TestClusterSource source("cluster");
+
+    // three points about 10m apart, one far away
+    std::vector<double> coordinates = { 10.0, 50.0, 10.0001, 50.0, 10.0, 50.0001 };
+    uint64_t first = source.addPoints(coordinates.data(), 3);
+    CHECK(first == 0);
+    Properties props;
+    props.set("name", "far");
+    CHECK(source.addPoint(std::move(props), LngLat(-60.0, -30.0)) == 3);
+
+    // nothing before clusters are generated
+    CHECK(source.features(TileID(0, 0, 0)).empty());
+    source.generateClusters();
+
+    auto world = source.features(TileID(0, 0, 0));
+    REQUIRE(world.size() == 2);
+    CHECK(pointCount(world) == 4);
+    uint64_t clusterId = 0;
+    for (auto& feature : world) {
+        REQUIRE(feature.geometryType == GeometryType::points);
+        auto& p = feature.coordinates[0];
+        CHECK((p.x >= 0 && p.x < 1 && p.y > 0 && p.y <= 1));
+        if (feature.props.contains("point_count")) {
+            CHECK(feature.props.getNumber("point_count") == 3);
+            clusterId = uint64_t(feature.props.getNumber("cluster_id"));
+            CHECK(source.clusterPointCount(clusterId) == 3);
+        } else {
+            CHECK(feature.props.getString("name") == "far");
+        }
+    }
+
+    // not clustered above maxZoom; the tile of 10, 50 at z17 has all three
+    TileID tile(69176, 44452, 17);
+    auto points = source.features(tile);
+    CHECK(points.size() == 3);
+    CHECK(pointCount(points) == 3);
+    CHECK(source.features(TileID(0, 0, 17)).empty());
+
+    // clusters of z0 are no longer kept after two other zooms
+    source.features(TileID(1, 1, 2));
+    CHECK(source.clusterPointCount(clusterId) == 0);
+}
+
+TEST_CASE("Clusters change with generated points only", TAGS) {
+    TestClusterSource source("cluster", { 40.f, 16, 3 });
+
+    std::vector<double> coordinates = { 10.0, 50.0, 10.001, 50.0 };
+    source.addPoints(coordinates.data(), 2);
+    source.generateClusters();
+    int64_t generation = source.generation();
+
+    // two points are less than minPoints
+    CHECK(source.features(TileID(0, 0, 0)).size() == 2);
+
+    source.addPoint(Properties(), LngLat(10.0, 50.001));
+    CHECK(source.features(TileID(0, 0, 0)).size() == 2);
+
+    source.generateClusters();
+    CHECK(source.generation() > generation);
+    auto features = source.features(TileID(0, 0, 0));
+    REQUIRE(features.size() == 1);
+    CHECK(features[0].props.getNumber("point_count") == 3);
+
+    source.clearPoints();
+    source.generateClusters();
+    CHECK(source.features(TileID(0, 0, 0)).empty());
+}
+
+TEST_CASE("Clusters of a zoom have all points once", TAGS) {
+    TestClusterSource source("cluster");
+
+    std::vector<double> coordinates;
+    uint32_t seed = 1;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        coordinates.push_back(-20.0 + 40.0 * (seed >> 8) / double(1 << 24));
+        seed = seed * 1103515245 + 12345;
+        coordinates.push_back(-20.0 + 40.0 * (seed >> 8) / double(1 << 24));
+    }
+    source.addPoints(coordinates.data(), 2000);
+    source.generateClusters();
+
+    for (int z : { 2, 4, 6 }) {
+        size_t features = 0;
+        double count = 0;
+        int n = 1 << z;
+        for (int x = 0; x < n; x++) {
+            for (int y = 0; y < n; y++) {
+                auto tile = source.features(TileID(x, y, z));
+                features += tile.size();
+                count += pointCount(tile);
+            }
+        }
+        CHECK(count == 2000);
+        CHECK(features < 2000);
+    }
+}
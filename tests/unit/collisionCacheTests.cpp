@@ -0,0 +1,47 @@
+#include "catch.hpp"
+
+#include "labels/collisionCache.h"
+
+#include <vector>
+
+using namespace Tangram;
+
+TEST_CASE("Collision results are cached by label set", "[Labels][CollisionCache]") {
+
+    CollisionCache cache;
+    std::vector<bool> occluded;
+
+    REQUIRE(!cache.get(1, 3, occluded));
+
+    cache.put(1, { true, false, true });
+    REQUIRE(cache.get(1, 3, occluded));
+    REQUIRE(occluded == std::vector<bool>({ true, false, true }));
+
+    // Same key for a label set of another size
+    REQUIRE(!cache.get(1, 2, occluded));
+
+    cache.put(1, { false, false, true });
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.get(1, 3, occluded));
+    REQUIRE(occluded == std::vector<bool>({ false, false, true }));
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(!cache.get(1, 3, occluded));
+}
+
+TEST_CASE("Least recently used collision results are dropped", "[Labels][CollisionCache]") {
+
+    CollisionCache cache(2);
+    std::vector<bool> occluded;
+
+    cache.put(1, { true });
+    cache.put(2, { false });
+    REQUIRE(cache.get(1, 1, occluded));
+
+    cache.put(3, { true });
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.get(1, 1, occluded));
+    REQUIRE(!cache.get(2, 1, occluded));
+    REQUIRE(cache.get(3, 1, occluded));
+}
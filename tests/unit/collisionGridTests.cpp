@@ -0,0 +1,76 @@
+#include "catch.hpp"
+
+#include "labels/collisionGrid.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Tangram;
+
+static CollisionGrid::AABB box(float _x, float _y, float _w, float _h, size_t _id) {
+    CollisionGrid::AABB aabb(_x, _y, _x + _w, _y + _h);
+    aabb.m_userData = reinterpret_cast<void*>(_id);
+    return aabb;
+}
+
+static std::vector<size_t> query(CollisionGrid& _grid, const CollisionGrid::AABB& _aabb) {
+    std::vector<size_t> ids;
+    _grid.query(_aabb, [&](auto& b) {
+        ids.push_back(reinterpret_cast<size_t>(b.m_userData));
+        return true;
+    });
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+TEST_CASE("Boxes in the collision grid are found once by intersecting queries", "[Labels][CollisionGrid]") {
+
+    CollisionGrid grid;
+    grid.reset({0, 0}, {256, 256}, 32);
+    REQUIRE(grid.cells() == glm::ivec2(8, 8));
+
+    // Spans many cells
+    grid.insert(box(10, 10, 200, 20, 1));
+    grid.insert(box(100, 100, 10, 10, 2));
+    // Beyond the covered area
+    grid.insert(box(300, 300, 10, 10, 3));
+
+    REQUIRE(grid.size() == 3);
+    REQUIRE(query(grid, box(0, 0, 256, 256, 0)) == std::vector<size_t>({ 1, 2 }));
+    REQUIRE(query(grid, box(105, 105, 50, 50, 0)) == std::vector<size_t>({ 2 }));
+    REQUIRE(query(grid, box(290, 290, 20, 20, 0)) == std::vector<size_t>({ 3 }));
+    REQUIRE(query(grid, box(50, 50, 10, 10, 0)).empty());
+
+    // Stops at the first box
+    size_t found = 0;
+    grid.query(box(0, 0, 256, 256, 0), [&](auto&) { found++; return false; });
+    REQUIRE(found == 1);
+
+    REQUIRE(grid.stats().inserts == 3);
+    REQUIRE(grid.stats().queries == 5);
+}
+
+TEST_CASE("Boxes can be removed from the collision grid", "[Labels][CollisionGrid]") {
+
+    CollisionGrid grid;
+    grid.reset({0, 0}, {256, 256}, 64);
+
+    uint32_t a = grid.insert(box(10, 10, 100, 100, 1));
+    grid.insert(box(50, 50, 10, 10, 2));
+
+    grid.remove(a);
+    REQUIRE(grid.size() == 1);
+    REQUIRE(grid.stats().removals == 1);
+    REQUIRE(query(grid, box(0, 0, 256, 256, 0)) == std::vector<size_t>({ 2 }));
+
+    // Removing again does nothing
+    grid.remove(a);
+    REQUIRE(grid.size() == 1);
+
+    // Cells are emptied on reset, with another cell size
+    grid.reset({0, 0}, {256, 256}, 128);
+    REQUIRE(grid.size() == 0);
+    REQUIRE(grid.cells() == glm::ivec2(2, 2));
+    REQUIRE(query(grid, box(0, 0, 256, 256, 0)).empty());
+    REQUIRE(grid.stats().inserts == 0);
+}
@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include "util/contourLines.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Tangram;
+
+// Bilinear elevation of @_grid at @_pos in tile coordinates, between pixel centers
+static float lerpGrid(const std::vector<float>& _grid, int _size, Point _pos) {
+    float x = _pos.x * _size - 0.5f, y = _pos.y * _size - 0.5f;
+    int ix = std::min(int(x), _size - 2), iy = std::min(int(y), _size - 2);
+    float fx = x - ix, fy = y - iy;
+    const float* g = &_grid[iy * _size + ix];
+    float t0 = g[0] + fx * (g[1] - g[0]);
+    float t1 = g[_size] + fx * (g[_size + 1] - g[_size]);
+    return t0 + fy * (t1 - t0);
+}
+
+TEST_CASE("Contour lines of a cone are closed rings at each level", "[Core][Contours]") {
+
+    const int size = 37;
+    std::vector<float> grid(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            grid[y * size + x] = 1030.f - 60.f * std::hypot(x - 18.f, y - 18.f);
+        }
+    }
+
+    auto lines = extractContourLines(grid.data(), size, size, 100.f, 100.f);
+
+    // Levels 100 to 1000
+    REQUIRE(lines.size() == 10);
+    for (size_t i = 0; i < lines.size(); i++) {
+        auto& line = lines[i];
+        REQUIRE(line.level == Approx(100.f * (i + 1)));
+        REQUIRE(line.points.size() > 4);
+        REQUIRE(line.points.front() == line.points.back());
+        for (auto& p : line.points) {
+            REQUIRE(lerpGrid(grid, size, p) == Approx(line.level).margin(0.05));
+        }
+    }
+}
+
+TEST_CASE("Contour lines of a slope cross the grid", "[Core][Contours]") {
+
+    const int size = 19;
+    std::vector<float> grid(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            grid[y * size + x] = -205.f + 50.f * x + 3.f * y;
+        }
+    }
+
+    // Only levels from 200 up
+    auto lines = extractContourLines(grid.data(), size, size, 100.f, 200.f);
+
+    float level = 200.f;
+    for (auto& line : lines) {
+        REQUIRE(line.level == level);
+        level += 100.f;
+        // Open lines from border to border of the pixel centers
+        REQUIRE(line.points.size() > 2);
+        REQUIRE(line.points.front() != line.points.back());
+        float lo = 0.5f / size, hi = 1.f - 0.5f / size;
+        for (auto& p : { line.points.front(), line.points.back() }) {
+            bool border = p.x == Approx(lo) || p.x == Approx(hi) || p.y == Approx(lo) || p.y == Approx(hi);
+            REQUIRE(border);
+        }
+        for (auto& p : line.points) {
+            REQUIRE(lerpGrid(grid, size, p) == Approx(line.level).margin(0.05));
+        }
+    }
+    REQUIRE(level == 800.f);
+}
+
+// Corner of the 2x2 grid nearest to the middle of the segment of @_line
+static int nearestCorner(const ContourLine& _line) {
+    Point mid = 0.5f * (_line.points.front() + _line.points.back());
+    return (mid.x < 0.5f ? 0 : 1) + (mid.y < 0.5f ? 0 : 2);
+}
+
+TEST_CASE("Contour lines at saddles follow the mean of the corners", "[Core][Contours]") {
+
+    // Low center: the high corners are separate peaks
+    std::vector<float> grid = { 10.f, 0.f,
+                                0.f, 10.f };
+    auto lines = extractContourLines(grid.data(), 2, 2, 6.f, 6.f);
+    REQUIRE(lines.size() == 2);
+    for (auto& line : lines) {
+        REQUIRE(line.points.size() == 2);
+        int corner = nearestCorner(line);
+        REQUIRE((corner == 0 || corner == 3));
+    }
+    REQUIRE(nearestCorner(lines[0]) != nearestCorner(lines[1]));
+
+    // High center: the low corners are separate pits
+    grid = { 10.f, 2.f,
+             2.f, 10.f };
+    lines = extractContourLines(grid.data(), 2, 2, 6.f, 6.f);
+    REQUIRE(lines.size() == 2);
+    for (auto& line : lines) {
+        REQUIRE(line.points.size() == 2);
+        int corner = nearestCorner(line);
+        REQUIRE((corner == 1 || corner == 2));
+    }
+    REQUIRE(nearestCorner(lines[0]) != nearestCorner(lines[1]));
+
+    REQUIRE(extractContourLines(grid.data(), 2, 2, 100.f, 100.f).empty());
+    REQUIRE(extractContourLines(grid.data(), 1, 4, 4.f, 4.f).empty());
+}
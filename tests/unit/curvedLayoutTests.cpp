@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include "labels/curvedLayout.h"
+#include "labels/textLabel.h"
+#include "util/geom.h"
+#include "util/lineSampler.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Tangram;
+
+// Screen space line along an arc, with cumulative lengths in z
+static std::vector<glm::vec3> arc(size_t _points, float _radius) {
+    LineSampler<std::vector<glm::vec3>> sampler;
+    for (size_t i = 0; i < _points; i++) {
+        float a = 0.8f * i / _points;
+        sampler.add(glm::vec2(300.f + _radius * std::sin(a), 300.f - _radius * std::cos(a)));
+    }
+    std::vector<glm::vec3> line;
+    for (size_t i = 0; i < sampler.numPoints(); i++) { line.push_back(sampler.point(i)); }
+    return line;
+}
+
+// Glyphs of @_count characters of 9px advance, centered on the origin
+static std::vector<GlyphQuad> glyphs(int _count) {
+    std::vector<GlyphQuad> quads(_count);
+    float start = -_count * 9.f * 0.5f;
+    for (int i = 0; i < _count; i++) {
+        float x0 = (start + i * 9.f + 1.f) * TextVertex::position_scale;
+        float x1 = x0 + 7.f * TextVertex::position_scale;
+        float y0 = -10.f * TextVertex::position_scale, y1 = 3.f * TextVertex::position_scale;
+        quads[i].atlas = 0;
+        quads[i].quad[0].pos = glm::i16vec2(x0, y0);
+        quads[i].quad[1].pos = glm::i16vec2(x0, y1);
+        quads[i].quad[2].pos = glm::i16vec2(x1, y0);
+        quads[i].quad[3].pos = glm::i16vec2(x1, y1);
+    }
+    return quads;
+}
+
+// Corners of the glyphs as placed with a LineSampler per glyph
+static std::vector<std::vector<glm::i16vec2>> reference(std::vector<glm::vec3> _line, float _center,
+                                                        const std::vector<GlyphQuad>& _quads) {
+    std::vector<std::vector<glm::i16vec2>> result;
+    LineSampler<std::vector<glm::vec3>> sampler(_line);
+
+    for (auto& quad : _quads) {
+        glm::vec2 origin = {(quad.quad[0].pos.x + quad.quad[2].pos.x) * 0.5f, 0 };
+        glm::vec2 point, rotation, p1, p2, r1, r2;
+
+        if (!sampler.sample(_center + origin.x * TextVertex::position_inv_scale, point, rotation)) {
+            result.emplace_back();
+            continue;
+        }
+        bool ok1 = sampler.sample(_center + quad.quad[0].pos.x * TextVertex::position_inv_scale, p1, r1);
+        bool ok2 = sampler.sample(_center + quad.quad[2].pos.x * TextVertex::position_inv_scale, p2, r2);
+        if (ok1 && ok2) {
+            rotation = (r1 == r2) ? r1 : glm::normalize(p2 - p1);
+            point = point * 0.5f + (p1 + p2) * 0.25f;
+        }
+        glm::i16vec2 p(point * TextVertex::position_scale);
+        rotation = {rotation.x, -rotation.y};
+
+        std::vector<glm::i16vec2> corners;
+        for (int i = 0; i < 4; i++) {
+            corners.push_back(p + glm::i16vec2{rotate2d(glm::vec2(quad.quad[i].pos) - origin, rotation)});
+        }
+        result.push_back(corners);
+    }
+    return result;
+}
+
+TEST_CASE("Curved glyphs are placed as with a LineSampler", "[Core][CurvedLayout]") {
+
+    auto line = arc(24, 400.f);
+    auto quads = glyphs(20);
+    CurvedLayout layout;
+
+    for (float center : { 100.f, 160.f, 250.f }) {
+        auto expected = reference(line, center, quads);
+        layout.place(line.data(), line.size(), center, quads.data(), quads.size());
+
+        size_t placed = 0;
+        for (size_t i = 0; i < expected.size(); i++) {
+            if (expected[i].empty()) { continue; }
+            REQUIRE(placed < layout.size());
+            REQUIRE(layout.glyph(placed) == i);
+            for (int c = 0; c < 4; c++) {
+                // Same up to rounding of the rotation
+                REQUIRE(std::abs(layout.corners(placed)[c].x - expected[i][c].x) <= 1);
+                REQUIRE(std::abs(layout.corners(placed)[c].y - expected[i][c].y) <= 1);
+            }
+            placed++;
+        }
+        REQUIRE(placed == layout.size());
+    }
+}
+
+TEST_CASE("Curved glyphs beyond the line are dropped", "[Core][CurvedLayout]") {
+
+    auto line = arc(8, 200.f);
+    float length = line.back().z;
+    auto quads = glyphs(40);
+    CurvedLayout layout;
+
+    // The label is much longer than the line
+    size_t placed = layout.place(line.data(), line.size(), length * 0.5f, quads.data(), quads.size());
+    REQUIRE(placed > 0);
+    REQUIRE(placed < quads.size());
+
+    REQUIRE(layout.place(line.data(), 1, 0.f, quads.data(), quads.size()) == 0);
+}
@@ -0,0 +1,26 @@
+#include "catch.hpp"
+
+#include "util/dashAtlas.h"
+
+using namespace Tangram;
+
+TEST_CASE("Styles with the same dash pattern share a row", "[Core][DashAtlas]") {
+
+    DashAtlas atlas(10.f);
+
+    auto a = atlas.add({ 1.f, 1.f });
+    REQUIRE(a.index == 0);
+    REQUIRE(a.length == 20);
+
+    // Odd patterns are repeated
+    auto b = atlas.add({ 2.f, 1.f, 1.f });
+    REQUIRE(b.index == 1);
+    REQUIRE(b.length == 80);
+
+    auto c = atlas.add({ 1.f, 1.f });
+    REQUIRE(c.index == a.index);
+    REQUIRE(c.length == a.length);
+
+    REQUIRE(atlas.rows() == 2);
+    REQUIRE(atlas.width() == 80);
+}
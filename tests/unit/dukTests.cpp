@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include "js/JavaScript.h"
 #include "scene/filters.h"
 #include "scene/sceneLoader.h"
 #include "scene/styleContext.h"
@@ -372,3 +373,83 @@ TEST_CASE( "Test evalFunction explicit", "[Duktape][evalFunction]") {
     }
 
 }
+
+TEST_CASE( "Test batch evaluation of JS functions", "[Duktape]") {
+    std::vector<Feature> features(4);
+    features[0].props.set("name", "Main St");
+    features[0].geometryType = GeometryType::lines;
+    features[1].props.set("name", "Park");
+    features[1].geometryType = GeometryType::polygons;
+    features[2].geometryType = GeometryType::lines;
+    features[3].props.set("name", "Lake");
+    features[3].geometryType = GeometryType::polygons;
+
+    StyleContext ctx;
+    // Neither compiled natively nor memoized, as they read a global or a property by variable
+    REQUIRE(ctx.setFunctions({
+        R"(function() { var key = 'name'; return feature[key].length + ($geometry == 'line' ? 100 : 0); })",
+        R"(function() { var key = 'name'; return feature[key] !== undefined; })",
+    }));
+    REQUIRE(ctx.hasBatchFunctions());
+
+    ctx.beginBatch(features);
+    for (const auto& feature : features) {
+        ctx.setFeature(feature);
+        REQUIRE(ctx.evalFilter(1) == (&feature != &features[2]));
+        ctx.queueBatch(0, StyleParamKey::priority);
+    }
+    ctx.evalBatch();
+
+    for (const auto& feature : features) {
+        ctx.setFeature(feature);
+        StyleParam::Value value;
+        if (&feature == &features[2]) {
+            // Throws for a missing name
+            REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == false);
+        } else {
+            REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == true);
+            float length = feature.props.getString("name").size();
+            REQUIRE(value.get<float>() == length + (feature.geometryType == GeometryType::lines ? 100 : 0));
+        }
+    }
+    ctx.endBatch();
+
+    // The same results without batch
+    ctx.setFeature(features[1]);
+    StyleParam::Value value;
+    REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value) == true);
+    REQUIRE(value.get<float>() == 4);
+}
+
+TEST_CASE( "Heap bytes of JS contexts are counted", "[Duktape]") {
+    size_t before = DuktapeContext::heapBytes();
+    {
+        StyleContext ctx;
+        REQUIRE(ctx.setFunctions({ R"(function() { return new Array(1000).join('x'); })" }));
+        CHECK(DuktapeContext::heapBytes() > before);
+    }
+    CHECK(DuktapeContext::heapBytes() == before);
+}
+
+TEST_CASE( "Functions compiled by one context are loaded into another", "[Duktape]") {
+    Feature feature;
+    feature.props.set("n", 42);
+    const std::string function = R"(function() { var f = function(x) { return x + 1; }; return f(feature.n) === 43 && $zoom === 5; })";
+
+    StyleContext first;
+    first.setFeature(feature);
+    first.setTileID(TileID(1, 1, 5));
+    REQUIRE(first.setFunctions({ function }));
+    REQUIRE(first.evalFilter(0) == true);
+
+    // the bytecode of the function is bound to the globals of the second context
+    StyleContext second;
+    second.setFeature(feature);
+    second.setTileID(TileID(1, 1, 5));
+    REQUIRE(second.setFunctions({ function }));
+    REQUIRE(second.evalFilter(0) == true);
+
+    second.setTileID(TileID(1, 1, 4));
+    REQUIRE(second.evalFilter(0) == false);
+    REQUIRE(first.evalFilter(0) == true);
+}
@@ -0,0 +1,85 @@
+#include "catch.hpp"
+
+#include "util/elevationPyramid.h"
+
+using namespace Tangram;
+
+TEST_CASE("Elevation bounds come from the tile or its nearest ancestor", "[Core][Elevation]") {
+
+    ElevationPyramid pyramid;
+    glm::vec2 minMax;
+
+    REQUIRE(!pyramid.bounds(TileID(10, 12, 5), minMax));
+
+    pyramid.add(TileID(5, 6, 4), {100.f, 800.f});
+    REQUIRE(pyramid.bounds(TileID(5, 6, 4), minMax));
+    REQUIRE(minMax == glm::vec2(100.f, 800.f));
+
+    // Descendants fall back to the ancestor
+    REQUIRE(pyramid.bounds(TileID(21, 25, 6), minMax));
+    REQUIRE(minMax == glm::vec2(100.f, 800.f));
+
+    // ... unless it is below the minimum zoom
+    REQUIRE(!pyramid.bounds(TileID(21, 25, 6), minMax, 5));
+
+    // Unrelated tiles have no bounds
+    REQUIRE(!pyramid.bounds(TileID(4, 6, 4), minMax));
+}
+
+TEST_CASE("Elevation bounds of a tile are the union of its children", "[Core][Elevation]") {
+
+    ElevationPyramid pyramid;
+    glm::vec2 minMax;
+
+    pyramid.add(TileID(5, 6, 4), {100.f, 800.f});
+    pyramid.add(TileID(10, 12, 5), {50.f, 300.f});
+    pyramid.add(TileID(11, 12, 5), {200.f, 900.f});
+    pyramid.add(TileID(10, 13, 5), {150.f, 400.f});
+
+    // Not all children known yet
+    REQUIRE(pyramid.bounds(TileID(5, 6, 4), minMax));
+    REQUIRE(minMax == glm::vec2(100.f, 800.f));
+
+    pyramid.add(TileID(11, 13, 5), {120.f, 600.f});
+    REQUIRE(pyramid.bounds(TileID(5, 6, 4), minMax));
+    REQUIRE(minMax == glm::vec2(50.f, 900.f));
+
+    // Propagated up to ancestors without data of their own
+    REQUIRE(!pyramid.bounds(TileID(2, 3, 3), minMax));
+    for (auto tile : { TileID(4, 6, 4), TileID(5, 7, 4), TileID(4, 7, 4) }) {
+        pyramid.add(tile, {0.f, 10.f});
+    }
+    REQUIRE(pyramid.bounds(TileID(2, 3, 3), minMax));
+    REQUIRE(minMax == glm::vec2(0.f, 900.f));
+
+    // ... but not past a tile with unknown siblings
+    REQUIRE(!pyramid.bounds(TileID(1, 1, 2), minMax));
+}
+
+TEST_CASE("Elevation pyramid drops the most detailed tiles first", "[Core][Elevation]") {
+
+    ElevationPyramid pyramid(6);
+    glm::vec2 minMax;
+
+    pyramid.add(TileID(5, 6, 4), {100.f, 800.f});
+    pyramid.add(TileID(10, 12, 5), {50.f, 300.f});
+    pyramid.add(TileID(11, 12, 5), {200.f, 900.f});
+    pyramid.add(TileID(10, 13, 5), {150.f, 400.f});
+    pyramid.add(TileID(11, 13, 5), {120.f, 600.f});
+    REQUIRE(pyramid.size() == 5);
+
+    pyramid.add(TileID(40, 50, 7), {10.f, 20.f});
+    pyramid.add(TileID(41, 50, 7), {10.f, 20.f});
+    REQUIRE(pyramid.size() == 6);
+
+    // The tile just added stays
+    REQUIRE(pyramid.bounds(TileID(41, 50, 7), minMax, 7));
+    REQUIRE(!pyramid.bounds(TileID(40, 50, 7), minMax, 7));
+
+    // Ancestors keep the union of the dropped children
+    pyramid.add(TileID(60, 60, 6), {0.f, 1.f});
+    REQUIRE(pyramid.size() == 6);
+    REQUIRE(!pyramid.bounds(TileID(41, 50, 7), minMax, 7));
+    REQUIRE(pyramid.bounds(TileID(5, 6, 4), minMax));
+    REQUIRE(minMax == glm::vec2(50.f, 900.f));
+}
@@ -0,0 +1,217 @@
+#include "catch.hpp"
+
+#include "gl/texture.h"
+#include "util/elevationManager.h"
+#include "util/halfFloat.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Tangram;
+
+// Terrarium encoded elevation tile of @_size x @_size pixels
+static std::unique_ptr<Texture> terrariumTexture(int _size) {
+    std::vector<uint8_t> data(_size * _size * 4);
+    for (int y = 0; y < _size; y++) {
+        for (int x = 0; x < _size; x++) {
+            double elev = 1500.0 + 900.0 * std::sin(x * 0.37) * std::cos(y * 0.23) - 40.0 * x + 0.3 * y;
+            uint32_t v = uint32_t((elev + 32768.0) * 256.0);
+            uint8_t* p = &data[(y * _size + x) * 4];
+            p[0] = v >> 16;
+            p[1] = (v >> 8) & 0xFF;
+            p[2] = v & 0xFF;
+            p[3] = 0xFF;
+        }
+    }
+    auto tex = std::make_unique<Texture>(TextureOptions(), false);
+    tex->setPixelData(_size, _size, 4, data.data(), data.size());
+    return tex;
+}
+
+static std::vector<glm::vec2> samplePositions() {
+    std::vector<glm::vec2> pos;
+    for (int i = 0; i <= 50; i++) {
+        pos.push_back({ i / 50.f, std::fmod(i * 0.618f, 1.f) });
+    }
+    // Edges and pixel centers
+    pos.push_back({ 0.f, 0.f });
+    pos.push_back({ 1.f, 1.f });
+    pos.push_back({ 0.5f / 32, 1.5f / 32 });
+    return pos;
+}
+
+TEST_CASE("Decoded elevation samples like the encoded texture", "[Core][Elevation]") {
+
+    auto tex = terrariumTexture(32);
+    auto pos = samplePositions();
+
+    std::vector<double> encoded;
+    std::vector<glm::vec2> encodedGrad;
+    for (auto& p : pos) {
+        glm::vec2 grad;
+        encoded.push_back(ElevationManager::elevationLerp(*tex, p, &grad));
+        encodedGrad.push_back(grad);
+    }
+
+    ElevationManager::decodeElevation(*tex);
+    REQUIRE(tex->userData);
+
+    for (size_t i = 0; i < pos.size(); i++) {
+        glm::vec2 grad;
+        REQUIRE(ElevationManager::elevationLerp(*tex, pos[i], &grad) == Approx(encoded[i]).margin(1e-3));
+        REQUIRE(grad.x == Approx(encodedGrad[i].x).margin(1e-2));
+        REQUIRE(grad.y == Approx(encodedGrad[i].y).margin(1e-2));
+    }
+}
+
+TEST_CASE("Batched elevation sampling matches single samples", "[Core][Elevation]") {
+
+    auto tex = terrariumTexture(32);
+    ElevationManager::decodeElevation(*tex);
+    auto pos = samplePositions();
+
+    // All block sizes, including a partial last block
+    for (size_t count : { pos.size(), size_t(3), size_t(1), size_t(0) }) {
+        std::vector<float> out(count, NAN);
+        ElevationManager::elevationLerp(*tex, pos.data(), count, out.data());
+        for (size_t i = 0; i < count; i++) {
+            REQUIRE(out[i] == Approx(ElevationManager::elevationLerp(*tex, pos[i])).margin(1e-2));
+        }
+    }
+}
+
+TEST_CASE("Elevation batches sample each position from its group tile", "[Core][Elevation]") {
+
+    std::shared_ptr<Texture> tex = terrariumTexture(32);
+    ElevationManager::decodeElevation(*tex);
+
+    TileID tileId(4823, 6160, 14);
+    ProjectedMeters origin = MapProjection::tileSouthWestCorner(tileId);
+    double size = MapProjection::metersPerTileAtZoom(tileId.z);
+
+    ElevationManager::ElevationBatch batch;
+    batch.groups.resize(2);
+    batch.groups[0].tileId = tileId;
+    batch.groups[0].texture = tex;
+    for (uint32_t i = 0; i < 40; i++) {
+        // a track through the tile, with every 5th point outside of it
+        if (i % 5 == 4) {
+            batch.positions.push_back(origin - size);
+            batch.groups[1].indices.push_back(i);
+        } else {
+            batch.positions.push_back(origin + size * glm::dvec2(i / 40.0, std::fmod(i * 0.37, 1.0)));
+            batch.groups[0].indices.push_back(i);
+        }
+    }
+
+    std::vector<double> elevations(batch.positions.size(), NAN);
+    std::vector<uint8_t> ok(batch.positions.size(), 2);
+    batch.sample(elevations.data(), ok.data());
+
+    for (uint32_t i : batch.groups[0].indices) {
+        REQUIRE(ok[i] == 1);
+        double expected = ElevationManager::elevationLerp(*tex, tileId, batch.positions[i]);
+        REQUIRE(elevations[i] == Approx(expected).margin(1e-2));
+    }
+    for (uint32_t i : batch.groups[1].indices) {
+        REQUIRE(ok[i] == 0);
+        REQUIRE(elevations[i] == 0);
+    }
+}
+
+TEST_CASE("Contour lines are extracted once per elevation tile and step", "[Core][Elevation]") {
+
+    std::shared_ptr<Texture> tex = terrariumTexture(32);
+    REQUIRE(!ElevationManager::contourLines(*tex, 100.f));
+
+    ElevationManager::decodeElevation(*tex);
+    auto lines = ElevationManager::contourLines(*tex, 100.f);
+    REQUIRE(lines);
+    REQUIRE(!lines->empty());
+    REQUIRE(ElevationManager::contourLines(*tex, 100.f) == lines);
+
+    auto coarse = ElevationManager::contourLines(*tex, 500.f);
+    REQUIRE(coarse != lines);
+    REQUIRE(coarse->size() < lines->size());
+
+    for (auto& line : *lines) {
+        REQUIRE(line.level > 0);
+        for (auto& p : line.points) {
+            REQUIRE(ElevationManager::elevationLerp(*tex, p) == Approx(line.level).margin(0.1));
+        }
+    }
+}
+
+TEST_CASE("Half floats round to nearest and convert back exactly", "[Core][Elevation]") {
+
+    REQUIRE(floatToHalf(1.f) == 0x3C00);
+    REQUIRE(floatToHalf(-2.f) == 0xC000);
+    REQUIRE(floatToHalf(65504.f) == 0x7BFF);
+    REQUIRE(floatToHalf(70000.f) == 0x7C00);
+    REQUIRE(floatToHalf(5.96046448e-8f) == 0x0001);
+    REQUIRE(std::isnan(halfToFloat(floatToHalf(NAN))));
+    // Ties to even: 2049 is halfway between 2048 and 2050
+    REQUIRE(halfToFloat(floatToHalf(2049.f)) == 2048.f);
+    REQUIRE(halfToFloat(floatToHalf(2051.f)) == 2052.f);
+
+    // All finite halfs convert back to themselves
+    for (uint32_t h = 0; h < 0x10000; h++) {
+        if ((h & 0x7C00) == 0x7C00) { continue; }
+        REQUIRE(floatToHalf(halfToFloat(uint16_t(h))) == h);
+    }
+
+    // Bulk conversion matches, including the tail
+    std::vector<float> elev;
+    for (int i = 0; i < 21; i++) { elev.push_back(-420.5f + 437.3f * i); }
+    std::vector<uint16_t> halfs(elev.size());
+    std::vector<float> back(elev.size());
+    floatsToHalfs(elev.data(), halfs.data(), elev.size());
+    halfsToFloats(halfs.data(), back.data(), back.size());
+    for (size_t i = 0; i < elev.size(); i++) {
+        REQUIRE(halfs[i] == floatToHalf(elev[i]));
+        REQUIRE(back[i] == halfToFloat(halfs[i]));
+        // 11 significant bits: at most 4m off below 8192m
+        REQUIRE(back[i] == Approx(elev[i]).margin(4.f));
+    }
+}
+
+TEST_CASE("Half float elevation samples like the decoded texture", "[Core][Elevation]") {
+
+    const int size = 33;  // odd width: rows not aligned to 4 bytes
+    auto tex = terrariumTexture(size);
+    ElevationManager::decodeElevation(*tex);
+
+    std::vector<float> elev(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            elev[y * size + x] = ElevationManager::elevationLerp(*tex, glm::vec2((x + 0.5f) / size, (y + 0.5f) / size));
+        }
+    }
+    std::vector<uint16_t> halfs(elev.size());
+    floatsToHalfs(elev.data(), halfs.data(), elev.size());
+
+    TextureOptions options;
+    options.pixelFormat = PixelFormat::HALF_FLOAT;
+    auto halfTex = std::make_unique<Texture>(options, false);
+    REQUIRE(halfTex->setPixelData(size, size, 2, (const GLubyte*)halfs.data(), halfs.size() * 2));
+    ElevationManager::decodeElevation(*halfTex);
+
+    auto pos = samplePositions();
+    std::vector<float> batch(pos.size());
+    ElevationManager::elevationLerp(*halfTex, pos.data(), pos.size(), batch.data());
+    for (size_t i = 0; i < pos.size(); i++) {
+        double expected = ElevationManager::elevationLerp(*tex, pos[i]);
+        double sampled = ElevationManager::elevationLerp(*halfTex, pos[i]);
+        REQUIRE(sampled == Approx(expected).margin(1.f));
+        REQUIRE(batch[i] == Approx(sampled).margin(1e-2));
+    }
+
+    auto lines = ElevationManager::contourLines(*halfTex, 100.f);
+    REQUIRE(lines);
+    REQUIRE(!lines->empty());
+    for (auto& line : *lines) {
+        for (auto& p : line.points) {
+            REQUIRE(ElevationManager::elevationLerp(*halfTex, p) == Approx(line.level).margin(0.1));
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "util/builders.h"
+
+using namespace Tangram;
+
+// Closed square ring with its lower left corner at (@_x, @_y)
+static Feature square(float _x, float _y, float _size) {
+    Feature feature;
+    feature.addPolygon({{ {_x, _y}, {_x + _size, _y}, {_x + _size, _y + _size},
+                          {_x, _y + _size}, {_x, _y} }});
+    return feature;
+}
+
+TEST_CASE("Walls between adjacent extrusions are culled", "[Core][Builders]") {
+
+    auto a = square(0.25f, 0.25f, 0.25f);
+    auto b = square(0.5f, 0.25f, 0.25f);
+
+    ExtrusionWalls walls;
+    Builders::addExtrusionWalls(a.polygons()[0], 0.f, 1.f, 0, true, walls);
+    Builders::addExtrusionWalls(b.polygons()[0], 0.f, 2.f, 1, true, walls);
+    REQUIRE(walls.walls.size() == 8);
+
+    Builders::cullExtrusionWalls(walls);
+
+    // Right wall of the lower polygon is hidden by the higher one
+    auto& right = walls.walls[1];
+    REQUIRE(right.polygon == 0);
+    REQUIRE(right.hidden);
+
+    // Left wall of the higher polygon is only seen above the lower one
+    auto& left = walls.walls[7];
+    REQUIRE(left.polygon == 1);
+    REQUIRE(!left.hidden);
+    REQUIRE(left.minHeight == 1.f);
+
+    size_t hidden = 0;
+    for (auto& wall : walls.walls) { hidden += wall.hidden; }
+    REQUIRE(hidden == 1);
+}
+
+TEST_CASE("Collinear walls of a polygon are merged", "[Core][Builders]") {
+
+    Feature feature;
+    feature.addPolygon({{ {0.25f, 0.25f}, {0.5f, 0.25f}, {0.75f, 0.25f}, {0.75f, 0.75f},
+                          {0.25f, 0.75f}, {0.25f, 0.25f} }});
+
+    ExtrusionWalls walls;
+    Builders::addExtrusionWalls(feature.polygons()[0], 0.f, 1.f, 0, true, walls);
+    REQUIRE(walls.walls.size() == 5);
+
+    PolygonBuilder builder(true, false);
+    size_t built = 0;
+    for (auto& wall : walls.walls) {
+        built += Builders::buildExtrusionWall(wall, true, builder);
+    }
+
+    REQUIRE(built == 4);
+    REQUIRE(builder.vertices.size() == 16);
+    REQUIRE(builder.indices.size() == 24);
+    REQUIRE(builder.vertices[1].coord == glm::vec3(0.75f, 0.25f, 1.f));
+}
+
+TEST_CASE("Polylines are built as segments with their neighbors", "[Core][Builders]") {
+
+    // Repeated point is skipped
+    std::vector<glm::vec2> points = { {0.2f, 0.2f}, {0.4f, 0.2f}, {0.4f, 0.2f}, {0.4f, 0.4f},
+                                      {0.6f, 0.4f} };
+
+    PolyLineBuilder builder;
+    builder.segmentsOnly = true;
+    builder.keepTileEdges = true;
+    Builders::buildPolyLine({ points.data(), points.data() + points.size() }, builder);
+
+    CHECK(builder.vertices.empty());
+    REQUIRE(builder.segments.size() == 3);
+
+    auto& first = builder.segments[0];
+    CHECK(first.prev == points[0]);
+    CHECK(first.start == points[0]);
+    CHECK(first.end == points[1]);
+    CHECK(first.next == points[3]);
+    CHECK(first.startCap);
+    CHECK_FALSE(first.endCap);
+
+    auto& middle = builder.segments[1];
+    CHECK(middle.prev == points[0]);
+    CHECK(middle.next == points[4]);
+    CHECK_FALSE(middle.startCap);
+    CHECK_FALSE(middle.endCap);
+
+    auto& last = builder.segments[2];
+    CHECK(last.prev == points[1]);
+    CHECK(last.next == points[4]);
+    CHECK(last.endCap);
+}
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include "scene/featureStates.h"
+#include "style/featureTable.h"
+
+using namespace Tangram;
+
+TEST_CASE("Features with the same colors share a table entry", "[Core][FeatureTable]") {
+
+    FeatureTable table;
+
+    REQUIRE(table.add(0xff0000ff, 0) == 0);
+    REQUIRE(table.add(0xff00ff00, 0) == 1);
+    REQUIRE(table.add(0xff0000ff, 0) == 0);
+    REQUIRE(table.size() == 2);
+    REQUIRE_FALSE(table.selectable());
+
+    // Another selection color makes another entry
+    REQUIRE(table.add(0xff0000ff, 7) == 2);
+    REQUIRE(table.selectionColor(2) == 7);
+    REQUIRE(table.selectable());
+}
+
+TEST_CASE("Colors are changed by selection color", "[Core][FeatureTable]") {
+
+    FeatureTable table;
+    table.add(0xff0000ff, 7);
+    table.add(0xff00ff00, 7);
+    table.add(0xffff0000, 8);
+
+    REQUIRE_FALSE(table.setColor(0, 0xffffffff));
+    REQUIRE_FALSE(table.setColor(9, 0xffffffff));
+
+    REQUIRE(table.setColor(7, 0xffffffff));
+    REQUIRE(table.color(0) == 0xffffffff);
+    REQUIRE(table.color(1) == 0xffffffff);
+    REQUIRE(table.color(2) == 0xffff0000);
+}
+
+TEST_CASE("Table texture has rows of selection colors and states for each row of colors", "[Core][FeatureTable]") {
+
+    FeatureTable table;
+    REQUIRE(table.textureSize() == glm::vec3(1, 1, 3));
+
+    for (uint32_t i = 0; i < FeatureTable::WIDTH + 1; i++) { table.add(i, 0); }
+
+    REQUIRE(table.textureSize() == glm::vec3(FeatureTable::WIDTH, 2, 6));
+    REQUIRE(table.bufferSize() == FeatureTable::WIDTH * 6 * sizeof(uint32_t));
+}
+
+TEST_CASE("Features with an id get their own table entries", "[Core][FeatureTable]") {
+
+    FeatureTable table;
+
+    REQUIRE(table.add(0xff0000ff, 0) == 0);
+    REQUIRE(table.add(0xff0000ff, 0, "a") == 1);
+    REQUIRE(table.add(0xff0000ff, 0, "b") == 2);
+    REQUIRE(table.add(0xff0000ff, 0, "a") == 1);
+    REQUIRE(table.size() == 3);
+}
+
+TEST_CASE("Feature states are parsed by key", "[Core][FeatureStates]") {
+
+    FeatureStates states;
+    REQUIRE(states.generation() == 0);
+
+    REQUIRE(states.set(1, "a", "color", "#ff0000"));
+    REQUIRE(states.get(1, "a").color == 0xff0000ff);
+    REQUIRE(states.get(2, "a").color == 0);
+
+    REQUIRE(states.set(1, "a", "visible", "false"));
+    REQUIRE_FALSE(states.get(1, "a").visible);
+    REQUIRE(states.get(1, "a").color == 0xff0000ff);
+
+    REQUIRE(states.set(1, "a", "width", "2"));
+    REQUIRE(states.get(1, "a").widthScale == 2.f);
+
+    REQUIRE_FALSE(states.set(1, "a", "width", "wide"));
+    REQUIRE_FALSE(states.set(1, "a", "visible", "no"));
+    REQUIRE_FALSE(states.set(1, "a", "size", "1"));
+    REQUIRE(states.generation() == 3);
+
+    states.clear();
+    REQUIRE(states.get(1, "a") == FeatureState{});
+    REQUIRE(states.generation() == 4);
+}
+
+TEST_CASE("Feature states are applied to the entries of the feature", "[Core][FeatureTable]") {
+
+    FeatureTable table;
+    FeatureStates states;
+    table.add(0xff0000ff, 0, "a");
+    table.add(0xff00ff00, 0, "b");
+
+    REQUIRE_FALSE(table.syncStates(states, 1));
+
+    states.set(1, "a", "visible", "false");
+    REQUIRE_FALSE(table.syncStates(states, 2));
+
+    states.set(2, "a", "visible", "false");
+    REQUIRE(table.syncStates(states, 2));
+    // Unchanged since the last sync
+    REQUIRE_FALSE(table.syncStates(states, 2));
+
+    // New entries get the current state
+    table.add(0xffff0000, 0, "a");
+    REQUIRE(table.syncStates(states, 2));
+}
@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include "data/formats/geoJsonStream.h"
+#include "data/propertyItem.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+using namespace mapbox;
+
+#define TAGS "[GeoJsonStream]"
+
+struct Result {
+    std::vector<Properties> properties;
+    std::vector<GeoJsonStream::Geometry> geometries;
+};
+
+static bool parse(const std::string& _data, Result& _result, size_t _chunkSize) {
+    GeoJsonStream stream([&](Properties&& _properties, GeoJsonStream::Geometry&& _geometry) {
+        _result.properties.push_back(std::move(_properties));
+        _result.geometries.push_back(std::move(_geometry));
+    });
+    for (size_t i = 0; i < _data.size(); i += _chunkSize) {
+        stream.write(_data.data() + i, std::min(_chunkSize, _data.size() - i));
+    }
+    return stream.finish();
+}
+
+static const std::string collection = R"({
+  "type": "FeatureCollection",
+  "features": [
+    { "type": "Feature", "properties": { "name": "a \"point\" [1]", "rank": 3, "nested": { "x": [1] } },
+      "geometry": { "type": "Point", "coordinates": [1.5, 2.5, 100] } },
+    { "geometry": { "coordinates": [[[0, 0], [1, 0], [1, 1], [0, 0]], [[0.2, 0.2], [0.4, 0.2], [0.2, 0.4], [0.2, 0.2]]],
+                    "type": "Polygon" },
+      "type": "Feature", "properties": null },
+    { "type": "Feature", "properties": {}, "geometry": null },
+    { "type": "Feature", "properties": { "visible": true },
+      "geometry": { "type": "MultiPolygon", "coordinates": [[[[0, 0], [1, 0], [0, 1], [0, 0]]], [[[2, 2], [3, 2], [2, 3], [2, 2]]]] } }
+  ],
+  "bbox": [0, 0, 3, 3]
+})";
+
+TEST_CASE("Features are read from a FeatureCollection in chunks", TAGS) {
+    for (size_t chunkSize : { size_t(1), size_t(7), size_t(64), collection.size() }) {
+        Result result;
+        REQUIRE(parse(collection, result, chunkSize));
+        REQUIRE(result.geometries.size() == 3);
+
+        CHECK(result.properties[0].getString("name") == "a \"point\" [1]");
+        CHECK(result.properties[0].getNumber("rank") == 3);
+        CHECK_FALSE(result.properties[0].contains("nested"));
+        REQUIRE(result.geometries[0].is<geometry::point<double>>());
+        CHECK(result.geometries[0].get<geometry::point<double>>() == geometry::point<double>(1.5, 2.5));
+
+        REQUIRE(result.geometries[1].is<geometry::polygon<double>>());
+        auto& polygon = result.geometries[1].get<geometry::polygon<double>>();
+        REQUIRE(polygon.size() == 2);
+        CHECK(polygon[0].size() == 4);
+        CHECK(polygon[1][1] == geometry::point<double>(0.4, 0.2));
+
+        CHECK(result.properties[2].getNumber("visible") == 1);
+        REQUIRE(result.geometries[2].is<geometry::multi_polygon<double>>());
+        auto& polygons = result.geometries[2].get<geometry::multi_polygon<double>>();
+        REQUIRE(polygons.size() == 2);
+        CHECK(polygons[1][0][0] == geometry::point<double>(2, 2));
+    }
+}
+
+TEST_CASE("Single Feature or geometry is read at the end of the document", TAGS) {
+    Result result;
+    REQUIRE(parse(R"({ "type": "GeometryCollection", "geometries": [
+                        { "type": "LineString", "coordinates": [[0, 0], [1, 1]] },
+                        { "type": "MultiLineString", "coordinates": [[[0, 0], [1, 1]], [[2, 2], [3, 3], [4, 4]]] }]})",
+                  result, 3));
+    REQUIRE(result.geometries.size() == 1);
+    REQUIRE(result.geometries[0].is<geometry::geometry_collection<double>>());
+    auto& geometries = result.geometries[0].get<geometry::geometry_collection<double>>();
+    REQUIRE(geometries.size() == 2);
+    CHECK(geometries[0].get<geometry::line_string<double>>().size() == 2);
+    CHECK(geometries[1].get<geometry::multi_line_string<double>>()[1].size() == 3);
+
+    Result feature;
+    REQUIRE(parse(R"({ "type": "Feature", "properties": { "id": 1 },
+                       "geometry": { "type": "MultiPoint", "coordinates": [[0, 0], [1, 1]] } })", feature, 5));
+    REQUIRE(feature.geometries.size() == 1);
+    CHECK(feature.properties[0].getNumber("id") == 1);
+    CHECK(feature.geometries[0].get<geometry::multi_point<double>>().size() == 2);
+}
+
+TEST_CASE("Invalid features are skipped", TAGS) {
+    Result result;
+    CHECK_FALSE(parse(R"({ "type": "FeatureCollection", "features": [
+                           { "type": "Feature", "geometry": { "type": "Point", "coordinates": [[0, 0]] } },
+                           { "type": "Feature", "geometry": { "type": "Point", "coordinates": ["x"] } },
+                           { "type": "Feature", "geometry": { "type": "Point", "coordinates": [1, 2] } }]})",
+                      result, 16));
+    REQUIRE(result.geometries.size() == 1);
+    CHECK(result.geometries[0].get<geometry::point<double>>() == geometry::point<double>(1, 2));
+
+    Result incomplete;
+    CHECK_FALSE(parse(R"({ "type": "FeatureCollection", "features": [
+                           { "type": "Feature", "geometry": { "type": "Point", "coordinates": [1, 2] } })",
+                      incomplete, 16));
+    CHECK(incomplete.geometries.size() == 1);
+}
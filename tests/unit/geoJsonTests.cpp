@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include "data/formats/geoJson.h"
+#include "data/propertyItem.h"
+#include "tile/tileTask.h"
+
+#include <memory>
+#include <string>
+
+using namespace Tangram;
+
+#define TAGS "[GeoJson]"
+
+static std::shared_ptr<TileData> parse(const std::string& _json, const PropertyKeys* _propertyKeys = nullptr) {
+    BinaryTileTask task(TileID(0, 0, 0), nullptr);
+    task.rawTileData = std::make_shared<std::vector<char>>(_json.begin(), _json.end());
+    return GeoJson::parseTile(task, 7, _propertyKeys);
+}
+
+static const std::string collection = R"({
+  "features": [
+    { "type": "Feature", "properties": { "name": "a", "rank": 3, "visible": true, "none": null, "nested": { "x": [1] } },
+      "geometry": { "type": "Point", "coordinates": [0, 0, 100] } },
+    { "geometry": { "coordinates": [[[-180, 0], [0, 0], [0, 45], [-180, 0]], [[-90, 10], [-45, 10], [-90, 20], [-90, 10]]],
+                    "type": "Polygon" },
+      "type": "Feature", "properties": null },
+    { "type": "Feature", "properties": { "kind": "multi" },
+      "geometry": { "type": "MultiPolygon", "coordinates": [[[[0, 0], [1, 0], [0, 1], [0, 0]]], [[[2, 2], [3, 2], [2, 3], [2, 2]]]] } },
+    { "type": "Feature", "geometry": { "type": "MultiLineString", "coordinates": [[[0, 0], [1, 1]], [[2, 2], [3, 3], [4, 4]]] } },
+    { "type": "Feature", "geometry": { "type": "GeometryCollection", "geometries": [{ "type": "Point", "coordinates": [0, 0] }] } }
+  ],
+  "crs": { "type": "name", "properties": { "name": "urn:ogc:def:crs:OGC:1.3:CRS84" } },
+  "type": "FeatureCollection"
+})";
+
+TEST_CASE("Features of a FeatureCollection are read in any member order", TAGS) {
+    auto data = parse(collection);
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+    CHECK(data->layers[0].name.empty());
+
+    auto& features = data->layers[0].features;
+    REQUIRE(features.size() == 5);
+
+    CHECK(features[0].geometryType == GeometryType::points);
+    REQUIRE(features[0].points().size() == 1);
+    CHECK(features[0].points()[0].x == Approx(0.5));
+    CHECK(features[0].props.sourceId == 7);
+    CHECK(features[0].props.getString("name") == "a");
+    CHECK(features[0].props.getNumber("rank") == 3);
+    CHECK(features[0].props.getNumber("visible") == 1);
+    CHECK_FALSE(features[0].props.contains("none"));
+    CHECK_FALSE(features[0].props.contains("nested"));
+
+    CHECK(features[1].geometryType == GeometryType::polygons);
+    REQUIRE(features[1].polygons().size() == 1);
+    REQUIRE(features[1].polygons()[0].size() == 2);
+    CHECK(features[1].polygons()[0][0].size() == 4);
+    CHECK(features[1].polygons()[0][0][0].x == Approx(0));
+    CHECK(features[1].props.items().empty());
+
+    REQUIRE(features[2].polygons().size() == 2);
+    CHECK(features[2].polygons()[1].size() == 1);
+    CHECK(features[2].polygons()[1][0].size() == 4);
+
+    CHECK(features[3].geometryType == GeometryType::lines);
+    REQUIRE(features[3].lines().size() == 2);
+    CHECK(features[3].lines()[1].size() == 3);
+
+    // not handled
+    CHECK(features[4].coordinates.empty());
+}
+
+TEST_CASE("Named FeatureCollections are read as layers", TAGS) {
+    auto data = parse(R"({
+      "roads": { "type": "FeatureCollection", "features": [
+        { "type": "Feature", "properties": { "kind": "major", "name": "A1" },
+          "geometry": { "type": "LineString", "coordinates": [[0, 0], [1, 1]] } } ] },
+      "meta": { "type": "Metadata", "features": [] },
+      "pois": { "features": [
+        { "type": "Feature", "properties": { "kind": "cafe", "name": "B" },
+          "geometry": { "type": "MultiPoint", "coordinates": [[0, 0], [1, 1]] } } ], "type": "FeatureCollection" }
+    })");
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 2);
+    CHECK(data->layers[0].name == "roads");
+    CHECK(data->layers[1].name == "pois");
+    REQUIRE(data->layers[1].features.size() == 1);
+    CHECK(data->layers[1].features[0].points().size() == 2);
+}
+
+TEST_CASE("GeoJson properties that the scene does not read are dropped", TAGS) {
+    PropertyKeys propertyKeys;
+    propertyKeys.add("", { "kind" }, false);
+
+    auto data = parse(collection, &propertyKeys);
+    REQUIRE(data);
+    auto& features = data->layers[0].features;
+    REQUIRE(features.size() == 5);
+    CHECK(features[0].props.items().empty());
+    CHECK(features[2].props.getString("kind") == "multi");
+}
+
+TEST_CASE("Invalid GeoJson gives no layers", TAGS) {
+    auto data = parse(R"({ "type": "FeatureCollection", "features": [ { "type": )");
+    REQUIRE(data);
+    CHECK(data->layers.empty());
+}
@@ -0,0 +1,350 @@
+#include "catch.hpp"
+
+#include "util/geoTiff.h"
+#include "util/imageLoader.h"
+#include "util/pixelBufferPool.h"
+#include "util/zlibHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[GeoTiff]"
+
+// Little endian TIFF of tiled images, each with its tags and blocks
+class TiffBuilder {
+public:
+    struct Entry {
+        uint16_t tag;
+        uint16_t type;  // 2 ascii, 3 short, 4 long, 12 double
+        std::vector<double> values;
+        std::string text;
+    };
+    struct Image {
+        std::vector<Entry> entries;
+        std::vector<std::vector<char>> blocks;
+    };
+
+    std::vector<char> build(std::vector<Image> _images) {
+        uint32_t offset = 8;
+        std::vector<uint32_t> ifdOffsets;
+        for (auto& image : _images) {
+            // Block offsets and sizes are set once the blocks are placed
+            image.entries.push_back({ 324, 4, std::vector<double>(image.blocks.size()), "" });
+            image.entries.push_back({ 325, 4, std::vector<double>(image.blocks.size()), "" });
+            std::sort(image.entries.begin(), image.entries.end(),
+                      [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+            ifdOffsets.push_back(offset);
+            offset += 2 + 12 * image.entries.size() + 4;
+        }
+        std::map<const Entry*, uint32_t> valueOffsets;
+        for (auto& image : _images) {
+            for (auto& entry : image.entries) {
+                if (bytes(entry) > 4) {
+                    valueOffsets[&entry] = offset;
+                    offset += bytes(entry);
+                }
+            }
+        }
+        for (auto& image : _images) {
+            for (size_t i = 0; i < image.blocks.size(); i++) {
+                image.entries[index(image, 324)].values[i] = offset;
+                image.entries[index(image, 325)].values[i] = image.blocks[i].size();
+                offset += image.blocks[i].size();
+            }
+        }
+
+        m_out.assign(offset, 0);
+        m_out[0] = m_out[1] = 'I';
+        put(2, 42, 2);
+        put(4, ifdOffsets[0], 4);
+        for (size_t i = 0; i < _images.size(); i++) {
+            auto& image = _images[i];
+            uint32_t pos = ifdOffsets[i];
+            put(pos, image.entries.size(), 2);
+            pos += 2;
+            for (auto& entry : image.entries) {
+                put(pos, entry.tag, 2);
+                put(pos + 2, entry.type, 2);
+                put(pos + 4, entry.type == 2 ? entry.text.size() : entry.values.size(), 4);
+                uint32_t valueOffset = bytes(entry) > 4 ? valueOffsets[&entry] : pos + 8;
+                if (bytes(entry) > 4) { put(pos + 8, valueOffset, 4); }
+                writeValues(entry, valueOffset);
+                pos += 12;
+            }
+            put(pos, i + 1 < _images.size() ? ifdOffsets[i + 1] : 0, 4);
+            for (size_t b = 0; b < image.blocks.size(); b++) {
+                uint32_t blockOffset = uint32_t(image.entries[index(image, 324)].values[b]);
+                std::memcpy(&m_out[blockOffset], image.blocks[b].data(), image.blocks[b].size());
+            }
+        }
+        return m_out;
+    }
+
+private:
+    static uint32_t typeBytes(uint16_t _type) { return _type == 2 ? 1 : _type == 3 ? 2 : _type == 4 ? 4 : 8; }
+    static uint32_t bytes(const Entry& _entry) {
+        return typeBytes(_entry.type) * (_entry.type == 2 ? _entry.text.size() : _entry.values.size());
+    }
+    static size_t index(const Image& _image, uint16_t _tag) {
+        for (size_t i = 0; i < _image.entries.size(); i++) {
+            if (_image.entries[i].tag == _tag) { return i; }
+        }
+        return 0;
+    }
+    void put(uint32_t _offset, uint64_t _value, int _bytes) {
+        for (int i = 0; i < _bytes; i++) { m_out[_offset + i] = char((_value >> (8 * i)) & 0xff); }
+    }
+    void writeValues(const Entry& _entry, uint32_t _offset) {
+        if (_entry.type == 2) {
+            std::memcpy(&m_out[_offset], _entry.text.data(), _entry.text.size());
+            return;
+        }
+        for (size_t i = 0; i < _entry.values.size(); i++) {
+            if (_entry.type == 12) {
+                uint64_t bits;
+                std::memcpy(&bits, &_entry.values[i], sizeof(bits));
+                put(_offset + 8 * i, bits, 8);
+            } else {
+                put(_offset + typeBytes(_entry.type) * i, uint64_t(_entry.values[i]), typeBytes(_entry.type));
+            }
+        }
+    }
+    std::vector<char> m_out;
+};
+
+static std::vector<TiffBuilder::Entry> imageTags(uint32_t _size, uint32_t _blockSize, uint16_t _samples,
+                                                 uint16_t _bits, uint16_t _format, uint16_t _compression,
+                                                 uint16_t _predictor, bool _overview) {
+    return {
+        { 254, 4, { _overview ? 1.0 : 0.0 }, "" },
+        { 256, 4, { double(_size) }, "" },
+        { 257, 4, { double(_size) }, "" },
+        { 258, 3, std::vector<double>(_samples, _bits), "" },
+        { 259, 3, { double(_compression) }, "" },
+        { 277, 3, { double(_samples) }, "" },
+        { 317, 3, { double(_predictor) }, "" },
+        { 322, 4, { double(_blockSize) }, "" },
+        { 323, 4, { double(_blockSize) }, "" },
+        { 339, 3, std::vector<double>(_samples, _format), "" },
+    };
+}
+
+// Deflated floats with the floating point predictor
+static std::vector<char> floatBlock(const std::vector<float>& _values, uint32_t _width) {
+    std::vector<uint8_t> bytes(_values.size() * 4);
+    size_t rows = _values.size() / _width;
+    for (size_t r = 0; r < rows; r++) {
+        uint8_t* row = &bytes[r * _width * 4];
+        for (size_t i = 0; i < _width; i++) {
+            uint8_t sample[4];
+            std::memcpy(sample, &_values[r * _width + i], 4);
+            for (int b = 0; b < 4; b++) { row[(4 - b - 1) * _width + i] = sample[b]; }
+        }
+        for (size_t i = _width * 4 - 1; i > 0; i--) { row[i] = uint8_t(row[i] - row[i - 1]); }
+    }
+    std::vector<char> compressed;
+    zlib_deflate(reinterpret_cast<const char*>(bytes.data()), bytes.size(), compressed);
+    return compressed;
+}
+
+// TIFF LZW of data that needs less than 9 bit codes
+static std::vector<char> lzwBlock(const std::vector<uint8_t>& _data) {
+    std::map<std::string, int> table;
+    for (int i = 0; i < 256; i++) { table[std::string(1, char(i))] = i; }
+    int next = 258;
+    uint32_t buffer = 0;
+    int bits = 0;
+    std::vector<char> out;
+    auto put = [&](int _code) {
+        buffer = (buffer << 9) | uint32_t(_code);
+        bits += 9;
+        while (bits >= 8) {
+            out.push_back(char((buffer >> (bits - 8)) & 0xff));
+            bits -= 8;
+        }
+    };
+    put(256);
+    std::string prefix;
+    for (uint8_t c : _data) {
+        std::string extended = prefix + char(c);
+        if (table.count(extended)) {
+            prefix = extended;
+            continue;
+        }
+        put(table[prefix]);
+        table[extended] = next++;
+        prefix = std::string(1, char(c));
+    }
+    put(table[prefix]);
+    put(257);
+    if (bits > 0) { out.push_back(char((buffer << (8 - bits)) & 0xff)); }
+    REQUIRE(next < 500);
+    return out;
+}
+
+static uint64_t parse(const std::vector<char>& _file, size_t _size, GeoTiff& _tiff, GeoTiffResult& _result) {
+    uint64_t needed = 0;
+    _result = parseGeoTiff(_file.data(), _size, _tiff, needed);
+    return needed;
+}
+
+TEST_CASE("GeoTIFF directories, overviews and georeferencing are parsed", TAGS) {
+
+    // 32x32 elevation in Web Mercator with a 16x16 overview, in blocks of 16x16
+    std::vector<float> full(32 * 32), overview(16 * 16);
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 32; x++) { full[y * 32 + x] = 100.f * y + x + 0.5f; }
+    }
+    for (int i = 0; i < 16 * 16; i++) { overview[i] = float(i); }
+    full[5] = -9999.f;
+
+    TiffBuilder::Image image;
+    image.entries = imageTags(32, 16, 1, 32, 3, 8, 3, false);
+    image.entries.push_back({ 33550, 12, { 10.0, 20.0, 0.0 }, "" });
+    image.entries.push_back({ 33922, 12, { 0.0, 0.0, 0.0, 1000.0, 5000.0, 0.0 }, "" });
+    image.entries.push_back({ 34735, 3, { 1, 1, 0, 2, 1024, 0, 1, 1, 3072, 0, 1, 3857 }, "" });
+    image.entries.push_back({ 42113, 2, {}, std::string("-9999") + '\0' });
+    for (int by = 0; by < 2; by++) {
+        for (int bx = 0; bx < 2; bx++) {
+            std::vector<float> block;
+            for (int y = 0; y < 16; y++) {
+                for (int x = 0; x < 16; x++) { block.push_back(full[(by * 16 + y) * 32 + bx * 16 + x]); }
+            }
+            image.blocks.push_back(floatBlock(block, 16));
+        }
+    }
+    TiffBuilder::Image reduced;
+    reduced.entries = imageTags(16, 16, 1, 32, 3, 8, 3, true);
+    reduced.blocks.push_back(floatBlock(overview, 16));
+
+    auto file = TiffBuilder().build({ image, reduced });
+
+    GeoTiff tiff;
+    GeoTiffResult result;
+
+    // Directories beyond the data read are reported
+    uint64_t needed = parse(file, 64, tiff, result);
+    CHECK(result == GeoTiffResult::needMoreData);
+    CHECK(needed > 64);
+
+    parse(file, file.size(), tiff, result);
+    REQUIRE(result == GeoTiffResult::ok);
+    REQUIRE(tiff.images.size() == 2);
+    CHECK(tiff.crs == GeoTiffCRS::webMercator);
+    CHECK(tiff.originX == 1000.0);
+    CHECK(tiff.originY == 5000.0);
+    CHECK(tiff.pixelWidth == 10.0);
+    CHECK(tiff.pixelHeightOf(tiff.images[1]) == 40.0);
+    CHECK(tiff.hasNoData);
+
+    const GeoTiffImage& first = tiff.images[0];
+    CHECK(first.isFloat());
+    CHECK(first.blocksAcross() == 2);
+    CHECK(first.blocksDown() == 2);
+
+    GeoTiffBlock block;
+    REQUIRE(decodeGeoTiffBlock(tiff, first, &file[first.blockOffsets[0]], first.blockSizes[0], block));
+    REQUIRE(block.floats.size() == 16 * 16);
+    CHECK(block.floats[0] == 0.5f);
+    CHECK(std::isnan(block.floats[5]));
+    CHECK(block.floats[15 * 16 + 3] == 1503.5f);
+
+    REQUIRE(decodeGeoTiffBlock(tiff, first, &file[first.blockOffsets[3]], first.blockSizes[3], block));
+    CHECK(block.floats[0] == 1616.5f);
+
+    const GeoTiffImage& second = tiff.images[1];
+    REQUIRE(decodeGeoTiffBlock(tiff, second, &file[second.blockOffsets[0]], second.blockSizes[0], block));
+    CHECK(block.floats[255] == 255.f);
+}
+
+TEST_CASE("GeoTIFF blocks compressed with LZW and the horizontal predictor are decoded", TAGS) {
+
+    // RGB gradient in longitude and latitude
+    std::vector<uint8_t> pixels(16 * 16 * 3), differenced(16 * 16 * 3);
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 16; x++) {
+            uint8_t* p = &pixels[(y * 16 + x) * 3];
+            p[0] = uint8_t(2 * x);
+            p[1] = uint8_t(3 * y);
+            p[2] = 200;
+        }
+        for (int i = 0; i < 16 * 3; i++) {
+            size_t offset = y * 16 * 3 + i;
+            differenced[offset] = uint8_t(pixels[offset] - (i >= 3 ? pixels[offset - 3] : 0));
+        }
+    }
+
+    TiffBuilder::Image image;
+    image.entries = imageTags(16, 16, 3, 8, 1, 5, 2, false);
+    image.entries.push_back({ 33550, 12, { 0.5, 0.25, 0.0 }, "" });
+    image.entries.push_back({ 33922, 12, { 0.0, 0.0, 0.0, -10.0, 50.0, 0.0 }, "" });
+    image.entries.push_back({ 34735, 3, { 1, 1, 0, 2, 1024, 0, 1, 2, 2048, 0, 1, 4326 }, "" });
+    image.blocks.push_back(lzwBlock(differenced));
+
+    auto file = TiffBuilder().build({ image });
+
+    GeoTiff tiff;
+    GeoTiffResult result;
+    parse(file, file.size(), tiff, result);
+    REQUIRE(result == GeoTiffResult::ok);
+    CHECK(tiff.crs == GeoTiffCRS::lngLat);
+    CHECK(tiff.originX == -10.0);
+    CHECK(tiff.pixelHeight == 0.25);
+
+    const GeoTiffImage& first = tiff.images[0];
+    CHECK(!first.isFloat());
+
+    GeoTiffBlock block;
+    REQUIRE(decodeGeoTiffBlock(tiff, first, &file[first.blockOffsets[0]], first.blockSizes[0], block));
+    CHECK(block.samples == 3);
+    CHECK(block.bytes == pixels);
+}
+
+TEST_CASE("GeoTIFFs without georeferencing or tiles are rejected", TAGS) {
+
+    TiffBuilder::Image image;
+    image.entries = imageTags(16, 16, 1, 8, 1, 1, 1, false);
+    image.blocks.push_back(std::vector<char>(16 * 16));
+
+    auto file = TiffBuilder().build({ image });
+
+    GeoTiff tiff;
+    GeoTiffResult result;
+    parse(file, file.size(), tiff, result);
+    CHECK(result == GeoTiffResult::invalid);
+}
+
+TEST_CASE("Encoded tiles load as images", TAGS) {
+
+    // Rows from the top, i.e. flipped by loadImage() for GL
+    std::vector<float> elevation = { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f };
+    std::vector<char> tiff;
+    encodeTiff(4, 2, 1, true, elevation.data(), tiff);
+
+    int width = 0, height = 0;
+    GLint format = 0;
+    uint8_t* pixels = loadImage(reinterpret_cast<const uint8_t*>(tiff.data()), tiff.size(), &width, &height, &format, 4);
+    REQUIRE(pixels);
+    CHECK(width == 4);
+    CHECK(height == 2);
+    CHECK(format == GL_R32F);
+    const float* values = reinterpret_cast<const float*>(pixels);
+    CHECK(values[0] == 5.f);
+    CHECK(values[7] == 4.f);
+    PixelBufferPool::release(pixels);
+
+    std::vector<uint8_t> rgba = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    encodeTiff(2, 2, 4, false, rgba.data(), tiff);
+    pixels = loadImage(reinterpret_cast<const uint8_t*>(tiff.data()), tiff.size(), &width, &height, &format, 4);
+    REQUIRE(pixels);
+    CHECK(format == GL_RGBA8);
+    CHECK(pixels[0] == 9);
+    CHECK(pixels[15] == 8);
+    PixelBufferPool::release(pixels);
+}
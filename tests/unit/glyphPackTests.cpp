@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include "text/glyphPack.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace Tangram;
+
+static GlyphPack::Params params() {
+    GlyphPack::Params params;
+    params.atlasFontPx = 32;
+    params.sdfPadding = 12;
+    params.sdfPixelDist = 10.5f;
+    return params;
+}
+
+// Bitmap of @_width x @_height with values depending on @_seed
+static std::vector<uint8_t> bitmap(int _width, int _height, int _seed) {
+    std::vector<uint8_t> data(_width * _height);
+    for (size_t i = 0; i < data.size(); i++) { data[i] = uint8_t(i * 7 + _seed); }
+    return data;
+}
+
+TEST_CASE("Glyph packs return the bitmaps they were built with", "[Core][GlyphPack]") {
+
+    GlyphPack::Builder builder(params());
+    auto a = bitmap(20, 30, 1);
+    auto b = bitmap(16, 16, 2);
+    auto c = bitmap(24, 28, 3);
+    builder.add("sans", 40, 20, 30, a.data());
+    builder.add("sans", 12, 16, 16, b.data());
+    builder.add("serif", 40, 24, 28, c.data());
+
+    auto pack = GlyphPack::fromData(builder.build());
+    REQUIRE(pack);
+    REQUIRE(pack->params() == params());
+    REQUIRE(pack->glyphCount() == 3);
+    REQUIRE(pack->hasFont("sans"));
+    REQUIRE(!pack->hasFont("mono"));
+
+    std::vector<uint8_t> out(20 * 30);
+    REQUIRE(pack->glyph("sans", 40, 20, 30, out.data(), 20));
+    REQUIRE(out == a);
+
+    // Written with the stride of the atlas
+    std::vector<uint8_t> atlas(64 * 28, 0);
+    REQUIRE(pack->glyph("serif", 40, 24, 28, atlas.data(), 64));
+    for (int y = 0; y < 28; y++) {
+        REQUIRE(std::equal(c.begin() + y * 24, c.begin() + (y + 1) * 24, atlas.begin() + y * 64));
+        REQUIRE(atlas[y * 64 + 24] == 0);
+    }
+
+    // Missing glyphs, fonts and cells of another size
+    REQUIRE(!pack->glyph("sans", 41, 20, 30, out.data(), 20));
+    REQUIRE(!pack->glyph("mono", 40, 20, 30, out.data(), 20));
+    REQUIRE(!pack->glyph("sans", 40, 20, 29, out.data(), 20));
+}
+
+TEST_CASE("Invalid glyph packs are rejected", "[Core][GlyphPack]") {
+
+    GlyphPack::Builder builder(params());
+    auto a = bitmap(8, 8, 1);
+    builder.add("sans", 1, 8, 8, a.data());
+    auto data = builder.build();
+
+    auto badMagic = data;
+    badMagic[0] = 'X';
+    REQUIRE(!GlyphPack::fromData(std::move(badMagic)));
+
+    auto truncated = data;
+    truncated.resize(32);
+    REQUIRE(!GlyphPack::fromData(std::move(truncated)));
+
+    REQUIRE(!GlyphPack::fromData({}));
+
+    // Truncated bitmaps are not returned
+    auto noBitmaps = data;
+    noBitmaps.resize(noBitmaps.size() - 4);
+    auto pack = GlyphPack::fromData(std::move(noBitmaps));
+    REQUIRE(pack);
+    std::vector<uint8_t> out(64);
+    REQUIRE(!pack->glyph("sans", 1, 8, 8, out.data(), 8));
+}
@@ -0,0 +1,143 @@
+#include "catch.hpp"
+
+#include "httpCache.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[HttpCache]"
+
+static HttpCache::ResponseHeaders parseHeaders(const std::vector<std::pair<std::string, std::string>>& _headers) {
+    HttpCache::ResponseHeaders headers;
+    for (auto& header : _headers) { headers.parse(header.first, header.second); }
+    return headers;
+}
+
+TEST_CASE("HTTP dates are parsed in all formats", TAGS) {
+    const int64_t date = 784111777;
+    CHECK(HttpCache::parseDate("Sun, 06 Nov 1994 08:49:37 GMT") == date);
+    CHECK(HttpCache::parseDate("Sunday, 06-Nov-94 08:49:37 GMT") == date);
+    CHECK(HttpCache::parseDate("Sun Nov  6 08:49:37 1994") == date);
+
+    CHECK(HttpCache::parseDate("Thu, 01 Jan 1970 00:00:00 GMT") == 0);
+    CHECK(HttpCache::parseDate("Tue, 29 Feb 2000 12:00:00 GMT") == 951825600);
+    CHECK(HttpCache::parseDate("Wed, 01 Mar 2000 00:00:00 GMT") == 951868800);
+
+    CHECK(HttpCache::parseDate("") == -1);
+    CHECK(HttpCache::parseDate("0") == -1);
+    CHECK(HttpCache::parseDate("Sun, 06 Foo 1994 08:49:37 GMT") == -1);
+}
+
+TEST_CASE("Freshness follows max-age and Age, or Expires relative to Date", TAGS) {
+    const int64_t now = 1700000000;
+    HttpCache::Entry entry;
+
+    SECTION("max-age minus age") {
+        auto headers = parseHeaders({ { "cache-control", "public, Max-Age=600" }, { "age", "100" } });
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK(entry.stored == now);
+        CHECK(entry.expires == now + 500);
+        CHECK(entry.isFresh(now + 499));
+        CHECK_FALSE(entry.isFresh(now + 500));
+    }
+
+    SECTION("max-age takes precedence over Expires") {
+        auto headers = parseHeaders({ { "cache-control", "max-age=60" },
+                                      { "expires", "Thu, 01 Jan 2099 00:00:00 GMT" } });
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK(entry.expires == now + 60);
+    }
+
+    SECTION("Expires relative to the Date of the server clock") {
+        auto headers = parseHeaders({ { "date", "Sun, 06 Nov 1994 08:49:37 GMT" },
+                                      { "expires", "Sun, 06 Nov 1994 09:49:37 GMT" } });
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK(entry.expires == now + 3600);
+    }
+
+    SECTION("Expires without Date is relative to the local clock") {
+        HttpCache::ResponseHeaders headers;
+        headers.expires = now + 120;
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK(entry.expires == now + 120);
+    }
+
+    SECTION("invalid Expires means already expired") {
+        auto headers = parseHeaders({ { "expires", "0" }, { "etag", "\"v1\"" } });
+        CHECK(headers.expires == 0);
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK_FALSE(entry.isFresh(now));
+    }
+
+    SECTION("heuristic freshness from Last-Modified, up to a day") {
+        auto headers = parseHeaders({ { "date", "Sun, 16 Nov 1994 08:49:37 GMT" },
+                                      { "last-modified", "Sun, 06 Nov 1994 08:49:37 GMT" } });
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK(entry.expires == now + 24 * 3600);
+
+        headers = parseHeaders({ { "date", "Mon, 07 Nov 1994 08:49:37 GMT" },
+                                 { "last-modified", "Sun, 06 Nov 1994 08:49:37 GMT" } });
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK(entry.expires == now + 24 * 360);
+    }
+
+    SECTION("no-cache entries are stored only for revalidation") {
+        auto headers = parseHeaders({ { "cache-control", "no-cache" } });
+        CHECK_FALSE(HttpCache::updateEntry(entry, headers, now));
+
+        headers = parseHeaders({ { "cache-control", "no-cache, max-age=600" }, { "etag", "\"v1\"" } });
+        CHECK(HttpCache::updateEntry(entry, headers, now));
+        CHECK_FALSE(entry.isFresh(now));
+        CHECK(entry.canRevalidate());
+    }
+
+    SECTION("without freshness nor validators nothing is stored") {
+        CHECK_FALSE(HttpCache::updateEntry(entry, HttpCache::ResponseHeaders(), now));
+    }
+}
+
+TEST_CASE("No-store responses are not stored", TAGS) {
+    auto headers = parseHeaders({ { "cache-control", "private, No-Store, max-age=600" }, { "etag", "\"v1\"" } });
+    CHECK(headers.noStore);
+
+    HttpCache::Entry entry;
+    CHECK_FALSE(HttpCache::updateEntry(entry, headers, 1000));
+    CHECK(entry.etag.empty());
+
+    // unrelated headers are left to the caller
+    HttpCache::ResponseHeaders other;
+    CHECK_FALSE(other.parse("content-type", "application/x-protobuf"));
+    CHECK(other.parse("etag", "\"v2\""));
+}
+
+TEST_CASE("Stale entries are revalidated with their validators", TAGS) {
+    const int64_t now = 1700000000;
+
+    HttpCache::Entry entry;
+    auto response = parseHeaders({ { "cache-control", "max-age=60" }, { "etag", "\"v1\"" },
+                                   { "last-modified", "Sun, 06 Nov 1994 08:49:37 GMT" } });
+    entry.content = { 't', 'i', 'l', 'e' };
+    REQUIRE(HttpCache::updateEntry(entry, response, now));
+    CHECK(HttpCache::revalidationHeaders(entry) ==
+          std::vector<std::string>{ "If-None-Match: \"v1\"",
+                                    "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT" });
+
+    CHECK(HttpCache::isCacheableStatus(200));
+    CHECK(HttpCache::isCacheableStatus(206));
+    CHECK_FALSE(HttpCache::isCacheableStatus(304));
+    CHECK_FALSE(HttpCache::isCacheableStatus(404));
+
+    // a 304 response refreshes the entry, keeping content and validators it does not replace
+    auto notModified = parseHeaders({ { "cache-control", "max-age=120" }, { "etag", "\"v2\"" } });
+    REQUIRE(HttpCache::updateEntry(entry, notModified, now + 100));
+    CHECK(entry.stored == now + 100);
+    CHECK(entry.expires == now + 220);
+    CHECK(entry.etag == "\"v2\"");
+    CHECK(entry.lastModified == "Sun, 06 Nov 1994 08:49:37 GMT");
+    CHECK(entry.content == std::vector<char>{ 't', 'i', 'l', 'e' });
+
+    // entries without validators cannot be revalidated
+    CHECK(HttpCache::revalidationHeaders(HttpCache::Entry()).empty());
+}
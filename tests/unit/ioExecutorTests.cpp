@@ -0,0 +1,129 @@
+#include "catch.hpp"
+
+#include "tile/tileTask.h"
+#include "util/ioExecutor.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[IOExecutor]"
+
+static std::shared_ptr<TileTask> tileTask(double _priority) {
+    auto task = std::make_shared<TileTask>(TileID(0, 0, 0), nullptr);
+    task->setPriority(_priority);
+    return task;
+}
+
+TEST_CASE("Queued tasks run by priority and canceled tasks are dropped", TAGS) {
+    IOExecutor executor(1);
+    std::mutex mutex;
+    std::vector<int> order;
+    auto record = [&](int _id) {
+        return [&, _id]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(_id);
+        };
+    };
+
+    {
+        IOQueue queue(executor);
+        std::atomic<bool> blocked{true};
+        queue.enqueue([&]() { while (blocked) { std::this_thread::yield(); } });
+
+        auto low = tileTask(5);
+        auto high = tileTask(1);
+        auto canceled = tileTask(0);
+        queue.enqueue(low, record(1));
+        queue.enqueue(high, record(2));
+        queue.enqueue(canceled, record(3));
+        queue.enqueue(record(0));
+
+        // updated priority takes effect for queued tasks
+        low->setPriority(0.5);
+        canceled->cancel();
+        blocked = false;
+
+        queue.waitForCompletion();
+    }
+
+    REQUIRE(order == std::vector<int>({ 0, 1, 2 }));
+}
+
+TEST_CASE("Delayed tasks are dropped with their queue unless waiting for completion", TAGS) {
+    IOExecutor executor(1);
+    int count = 0;
+
+    {
+        IOQueue queue(executor);
+        queue.enqueueDelayed([&]() { count++; }, std::chrono::seconds(60));
+    }
+    REQUIRE(count == 0);
+
+    {
+        IOQueue queue(executor);
+        queue.enqueueDelayed([&]() { count++; }, std::chrono::seconds(60));
+        queue.waitForCompletion();
+    }
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("Delayed tasks run once their time passed although other tasks are ready", TAGS) {
+    IOExecutor executor(1);
+    std::mutex mutex;
+    std::vector<int> order;
+    auto record = [&](int _id) {
+        return [&, _id]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(_id);
+        };
+    };
+
+    {
+        IOQueue queue(executor);
+        std::atomic<bool> blocked{true};
+        queue.enqueue([&]() { while (blocked) { std::this_thread::yield(); } });
+        queue.enqueueDelayed(record(0), std::chrono::milliseconds(1));
+        queue.enqueue(tileTask(1), record(1));
+        queue.enqueue(tileTask(2), record(2));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        blocked = false;
+
+        queue.waitForCompletion();
+    }
+
+    REQUIRE(order == std::vector<int>({ 0, 1, 2 }));
+}
+
+TEST_CASE("Tasks of one queue run serially while queues share the threads", TAGS) {
+    IOExecutor executor(3);
+    std::atomic<int> total{0};
+    std::atomic<int> overlaps{0};
+
+    {
+        std::vector<std::unique_ptr<IOQueue>> queues;
+        std::vector<std::unique_ptr<std::atomic<int>>> running;
+        for (int i = 0; i < 4; i++) {
+            queues.push_back(std::make_unique<IOQueue>(executor));
+            running.push_back(std::make_unique<std::atomic<int>>(0));
+        }
+        for (int i = 0; i < 400; i++) {
+            auto& active = *running[i % 4];
+            queues[i % 4]->enqueue([&]() {
+                if (active++ > 0) { overlaps++; }
+                total++;
+                active--;
+            });
+        }
+        for (auto& queue : queues) { queue->waitForCompletion(); }
+        queues.clear();
+    }
+
+    REQUIRE(total == 400);
+    REQUIRE(overlaps == 0);
+}
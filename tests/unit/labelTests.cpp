@@ -1,6 +1,7 @@
 #include "catch.hpp"
 #include "labels/label.h"
 #include "labels/screenTransform.h"
+#include "labels/spriteLabel.h"
 #include "labels/textLabel.h"
 #include "labels/textLabels.h"
 #include "map.h"
@@ -214,3 +215,28 @@ TEST_CASE( "Sine interpolation", "[Core][Label][Fade]" ) {
 
     REQUIRE(fadeIn.isFinished());
 }
+
+TEST_CASE( "Sprite instance reproduces the corners of a projected quad", "[Core][Label]" ) {
+    glm::mat4 mvp = glm::perspective(1.f, 1.f, 0.1f, 100.f) *
+        glm::lookAt(glm::vec3(0.f, -5.f, 5.f), glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f));
+
+    // Rotated quad on the ground plane; top-left, top-right, bottom-left, bottom-right
+    glm::vec2 axisX(1.f, 0.5f), axisY(-0.5f, 1.f);
+    glm::vec2 corners[] = { -axisX + axisY, axisX + axisY, -axisX - axisY, axisX - axisY };
+
+    glm::vec4 projected[4];
+    for (int i = 0; i < 4; i++) {
+        projected[i] = mvp * glm::vec4(corners[i], 0.f, 1.f);
+    }
+
+    SpriteInstance instance;
+    instance.setCorners(projected[0], projected[1], projected[2]);
+
+    glm::vec2 unitCorners[] = { {-1.f, 1.f}, {1.f, 1.f}, {-1.f, -1.f}, {1.f, -1.f} };
+    for (int i = 0; i < 4; i++) {
+        glm::vec4 p = instance.corner(unitCorners[i]);
+        for (int c = 0; c < 4; c++) {
+            REQUIRE(std::fabs(p[c] - projected[i][c]) < 1e-4);
+        }
+    }
+}
@@ -120,7 +120,7 @@ TEST_CASE( "Test anchor fallback behavior", "[Labels][AnchorFallback]" ) {
     class TestLabels : public LabelManager {
     public:
         TestLabels(View& _v) {
-            m_isect2d.resize({1, 1}, {_v.getWidth(), _v.getHeight()});
+            m_collisionCellSize = std::max(_v.getWidth(), _v.getHeight());
         }
 
         ScreenTransform& addLabel(Label* _l, Tile* _t) {
@@ -216,4 +216,92 @@ TEST_CASE( "Test anchor fallback behavior", "[Labels][AnchorFallback]" ) {
     }
 
 }
+
+TEST_CASE("Labels are sorted starting from the order of the last update", "[Labels][Sort]") {
+
+    Tile tile({0,0,0});
+
+    class TestLabels : public LabelManager {
+    public:
+        void add(Label* _l, Tile* _t, float _priority) {
+            m_labels.push_back({_l, nullptr, _t, nullptr, false, {}});
+            m_labels.back().priority = _priority;
+        }
+        // Whether sortLabels() sorts the labels
+        bool sort() {
+            std::vector<Label*> labels;
+            for (auto& entry : m_labels) { labels.push_back(entry.label); }
+
+            sortLabels(&Label::m_priorityRank, m_lastLabelCount, priorityComparator);
+            m_sortUpdate++;
+            for (auto& entry : m_labels) { entry.label->m_sortUpdate = m_sortUpdate; }
+            m_lastLabelCount = m_labels.size();
+
+            bool sorted = std::is_sorted(m_labels.begin(), m_labels.end(), priorityComparator);
+            std::vector<Label*> result;
+            for (auto& entry : m_labels) { result.push_back(entry.label); }
+            m_labels.clear();
+
+            return sorted && std::is_permutation(labels.begin(), labels.end(), result.begin(), result.end());
+        }
+    };
+
+    std::vector<std::unique_ptr<TextLabel>> labels;
+    for (int i = 0; i < 40; i++) {
+        labels.push_back(makeLabel(glm::vec2{0.5,0.5}, Label::Type::point, ""));
+    }
+
+    TestLabels manager;
+    for (int i = 0; i < 30; i++) { manager.add(labels[i].get(), &tile, float((i * 7) % 30)); }
+    REQUIRE(manager.sort());
+
+    // Drop some labels, change the priority of others and add new ones
+    for (int i = 5; i < 40; i++) {
+        float priority = float((i * 7) % 30);
+        if (i % 6 == 0) { priority = 30 - priority; }
+        manager.add(labels[i].get(), &tile, priority);
+    }
+    REQUIRE(manager.sort());
+
+    // Same labels in another collection order
+    for (int i = 39; i >= 5; i--) { manager.add(labels[i].get(), &tile, float(i % 4)); }
+    REQUIRE(manager.sort());
+}
+
+TEST_CASE("Many labels are sorted by priority keys", "[Labels][Sort]") {
+
+    Tile tiles[] = { Tile({0,0,10}), Tile({0,0,12}), Tile({0,0,12}) };
+    tiles[2].setProxyDepth(1);
+
+    class TestLabels : public LabelManager {
+    public:
+        void add(Label* _l, Tile* _t, float _priority, bool _proxy) {
+            m_labels.push_back({_l, nullptr, _t, nullptr, _proxy, {}});
+            m_labels.back().priority = _priority;
+        }
+        bool sort() {
+            auto labels = m_labels;
+            sortRange(m_labels.begin(), m_labels.end(), priorityComparator);
+
+            for (size_t i = 1; i < m_labels.size(); i++) {
+                // Keys are in the order of the comparator
+                if (priorityKey(m_labels[i]) < priorityKey(m_labels[i - 1])) { return false; }
+            }
+            return std::is_sorted(m_labels.begin(), m_labels.end(), priorityComparator) &&
+                std::is_permutation(labels.begin(), labels.end(), m_labels.begin(), m_labels.end(),
+                                    [](auto& a, auto& b) { return a.label == b.label; });
+        }
+    };
+
+    std::vector<std::unique_ptr<TextLabel>> labels;
+    TestLabels manager;
+    for (int i = 0; i < 1000; i++) {
+        labels.push_back(makeLabel(glm::vec2{0.5,0.5}, Label::Type::point, ""));
+        float priority = float((i * 37) % 101) / 4.f - 10.f;
+        Tile* tile = (i % 7 == 0) ? nullptr : &tiles[i % 3];
+        manager.add(labels.back().get(), tile, priority, tile && tile->isProxy());
+    }
+    REQUIRE(manager.sort());
+}
+
 }
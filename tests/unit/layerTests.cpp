@@ -144,4 +144,66 @@ TEST_CASE("SceneLayer exclusive and priority", TAGS) {
     }
 }
 
+TEST_CASE("SceneLayer matches share rule sets", TAGS) {
+    // layer:
+    //   draw_group_0:
+    //     order: order_layer
+    //   layer_a:
+    //     filter: { kind: a }
+    //     draw_group_0:
+    //       order: order_a
+    //   layer_b:
+    //     filter: { kind: b }
+    //     enabled: false
+    //     draw_group_0:
+    //       order: order_b
+
+    const DrawRuleData ruleA = {"draw_group_0", 0, {{StyleParamKey::order, "order_a"}}};
+    const SceneLayer layerA = {"layer_a", Filter::MatchEquality("kind", {Value(std::string("a"))}), {ruleA}, {}, SceneLayer::Options()};
+
+    SceneLayer::Options optionsB;
+    optionsB.enabled = false;
+    const DrawRuleData ruleB = {"draw_group_0", 0, {{StyleParamKey::order, "order_b"}}};
+    const SceneLayer layerB = {"layer_b", Filter::MatchEquality("kind", {Value(std::string("b"))}), {ruleB}, {}, optionsB};
+
+    const DrawRuleData rule = {"draw_group_0", 0, {{StyleParamKey::order, "order_layer"}}};
+    const SceneLayer layer = {"layer", Filter(), {rule}, {layerA, layerB}, SceneLayer::Options()};
+
+    // disabled sublayers are not part of the match plan
+    REQUIRE(layer.matchPlan().size() == 2);
+
+    Feature a0, a1, b, c;
+    a0.props.set("kind", "a");
+    a1.props.set("kind", "a");
+    b.props.set("kind", "b");
+
+    StyleContext context;
+    DrawRuleMergeSet ruleSet;
+
+    auto matchOrder = [&](const Feature& feature) {
+        REQUIRE(ruleSet.match(feature, layer, context));
+        REQUIRE(ruleSet.matchedRules().size() == 1);
+        return ruleSet.matchedRules()[0].findParameter(StyleParamKey::order).value.get<std::string>();
+    };
+
+    REQUIRE(matchOrder(a0) == "order_a");
+    auto idA = ruleSet.matchedRuleSetId();
+
+    REQUIRE(matchOrder(b) == "order_layer");
+    auto idB = ruleSet.matchedRuleSetId();
+
+    REQUIRE(matchOrder(a1) == "order_a");
+    REQUIRE(ruleSet.matchedRuleSetId() == idA);
+
+    REQUIRE(matchOrder(c) == "order_layer");
+    REQUIRE(ruleSet.matchedRuleSetId() == idB);
+    REQUIRE(idA != idB);
+
+    // a copy has its own plan
+    const SceneLayer copy = layer;
+    REQUIRE(ruleSet.match(a0, copy, context));
+    REQUIRE(ruleSet.matchedRuleSetId() != idA);
+    REQUIRE(ruleSet.matchedRules()[0].findParameter(StyleParamKey::order).value.get<std::string>() == "order_a");
+}
+
 } // namespace
@@ -0,0 +1,80 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "util/lineMerger.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[LineMerger]"
+
+static Feature line(const std::string& _name, std::vector<Point> _points) {
+    Feature feature;
+    feature.geometryType = GeometryType::lines;
+    feature.addLine(_points.begin(), _points.end());
+    if (!_name.empty()) { feature.props.set("name", _name); }
+    return feature;
+}
+
+static std::vector<Point> linePoints(const LineView& _line) {
+    return std::vector<Point>(_line.begin(), _line.end());
+}
+
+TEST_CASE("Fragments of a line are joined end to end", TAGS) {
+    std::vector<Feature> features;
+    features.push_back(line("main", { {1, 0}, {2, 0} }));
+    // reversed
+    features.push_back(line("main", { {3, 0}, {2, 0} }));
+    features.push_back(line("main", { {0, 0}, {1, 0} }));
+
+    LineMerger merger;
+    std::vector<Feature> merged;
+    std::vector<bool> fragments;
+    REQUIRE(merger.merge(features, { "name" }, merged, fragments));
+
+    CHECK(fragments == std::vector<bool>{ true, true, true });
+    REQUIRE(merged.size() == 1);
+    CHECK(merged[0].geometryType == GeometryType::lines);
+    CHECK(merged[0].props.getString("name") == "main");
+
+    auto lines = merged[0].lines();
+    REQUIRE(lines.size() == 1);
+    CHECK(linePoints(lines[0]) == std::vector<Point>{ {0, 0}, {1, 0}, {2, 0}, {3, 0} });
+}
+
+TEST_CASE("Lines are not joined at branches", TAGS) {
+    std::vector<Feature> features;
+    features.push_back(line("main", { {0, 0}, {1, 0} }));
+    features.push_back(line("main", { {1, 0}, {2, 0} }));
+    features.push_back(line("main", { {1, 0}, {1, 1} }));
+    features.push_back(line("main", { {2, 0}, {3, 0} }));
+
+    LineMerger merger;
+    std::vector<Feature> merged;
+    std::vector<bool> fragments;
+    REQUIRE(merger.merge(features, { "name" }, merged, fragments));
+    REQUIRE(merged.size() == 1);
+
+    auto lines = merged[0].lines();
+    REQUIRE(lines.size() == 3);
+    CHECK(linePoints(lines[0]) == std::vector<Point>{ {0, 0}, {1, 0} });
+    CHECK(linePoints(lines[1]) == std::vector<Point>{ {1, 0}, {2, 0}, {3, 0} });
+    CHECK(linePoints(lines[2]) == std::vector<Point>{ {1, 0}, {1, 1} });
+}
+
+TEST_CASE("Lines with other or no names are not merged", TAGS) {
+    std::vector<Feature> features;
+    features.push_back(line("main", { {0, 0}, {1, 0} }));
+    features.push_back(line("side", { {1, 0}, {2, 0} }));
+    features.push_back(line("", { {2, 0}, {3, 0} }));
+    features.push_back(line("", { {3, 0}, {4, 0} }));
+
+    LineMerger merger;
+    std::vector<Feature> merged;
+    std::vector<bool> fragments;
+    CHECK_FALSE(merger.merge(features, { "name" }, merged, fragments));
+    CHECK(merged.empty());
+    CHECK(fragments == std::vector<bool>(4, false));
+}
@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include "data/memoryCacheDataSource.h"
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "data/tileDataCache.h"
+#include "mapContext.h"
+#include "tile/tileTask.h"
+
+#include <string>
+
+using namespace Tangram;
+
+#define TAGS "[MapContext]"
+
+struct CountingDataSource : TileSource::DataSource {
+    int loadCount = 0;
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        std::string data = "tile " + _task->tileId().toString();
+        task.rawTileData = std::make_shared<std::vector<char>>(data.begin(), data.end());
+        loadCount++;
+        _cb.func(_task);
+        return true;
+    }
+};
+
+static void loadTile(TileSource::DataSource& _source, TileID _tileId) {
+    auto task = std::make_shared<BinaryTileTask>(_tileId, nullptr);
+    _source.loadTileData(task, {[](std::shared_ptr<TileTask>) {}});
+}
+
+TEST_CASE("Sources of the same url share raw tiles", TAGS) {
+    MapContext context;
+
+    auto cache = context.rawCache("https://tiles/{z}/{x}/{y}.mvt", false);
+    CHECK(context.rawCache("https://tiles/{z}/{x}/{y}.mvt", false) == cache);
+    CHECK(context.rawCache("https://tiles/{z}/{x}/{y}.mvt", true) != cache);
+    CHECK(context.rawCache("https://other/{z}/{x}/{y}.mvt", false) != cache);
+
+    MemoryCacheDataSource first(cache);
+    first.setNext(std::make_unique<CountingDataSource>());
+    first.setCacheSize(1024 * 1024);
+    MemoryCacheDataSource second(cache);
+    second.setNext(std::make_unique<CountingDataSource>());
+
+    loadTile(first, TileID(1, 2, 3));
+    loadTile(second, TileID(1, 2, 3));
+    CHECK(static_cast<CountingDataSource&>(*first.next).loadCount == 1);
+    CHECK(static_cast<CountingDataSource&>(*second.next).loadCount == 0);
+}
+
+TEST_CASE("Raw caches are kept for the sources of the next Scene", TAGS) {
+    MapContext context;
+
+    std::weak_ptr<RawCache> weak;
+    {
+        auto cache = context.rawCache("https://tiles/{z}/{x}/{y}.mvt|", false);
+        weak = cache;
+    }
+    // the previous Scene was released before the next one created its sources
+    auto cache = context.rawCache("https://tiles/{z}/{x}/{y}.mvt|", false);
+    CHECK(cache == weak.lock());
+
+    // other request options are loaded on their own
+    CHECK(context.rawCache("https://tiles/{z}/{x}/{y}.mvt|Authorization: token", false) != cache);
+
+    context.releaseUnusedCaches();
+    CHECK(context.rawCache("https://tiles/{z}/{x}/{y}.mvt|", false) == cache);
+
+    cache.reset();
+    context.releaseUnusedCaches();
+    CHECK(weak.expired());
+}
+
+TEST_CASE("Parsed tiles are shared by key and evicted least recently used first", TAGS) {
+    TileDataCache cache(2);
+
+    auto a = std::make_shared<TileData>();
+    auto b = std::make_shared<TileData>();
+    auto c = std::make_shared<TileData>();
+
+    cache.put("source|2", TileID(0, 0, 1), a);
+    cache.put("source|2", TileID(1, 0, 1), b);
+    CHECK(cache.get("source|2", TileID(0, 0, 1)) == a);
+    // other layers or properties are parsed again
+    CHECK(cache.get("source|2|roads", TileID(0, 0, 1)) == nullptr);
+
+    // b was used least recently
+    cache.put("source|2", TileID(1, 1, 1), c);
+    CHECK(cache.size() == 2);
+    CHECK(cache.get("source|2", TileID(1, 0, 1)) == nullptr);
+    CHECK(cache.get("source|2", TileID(0, 0, 1)) == a);
+
+    cache.clear("source|2");
+    CHECK(cache.size() == 0);
+
+    cache.setMaxEntries(0);
+    cache.put("source|2", TileID(0, 0, 1), a);
+    CHECK(cache.get("source|2", TileID(0, 0, 1)) == nullptr);
+}
+
+TEST_CASE("Parsed tiles are limited by their estimated bytes", TAGS) {
+    TileDataCache cache(16);
+
+    auto a = std::make_shared<TileData>();
+    auto b = std::make_shared<TileData>();
+    a->layers.emplace_back("roads");
+    b->layers.emplace_back("water");
+    size_t bytes = a->memoryUsage();
+    REQUIRE(b->memoryUsage() == bytes);
+
+    cache.setMaxBytes(bytes * 3 / 2);
+    cache.put("source|2", TileID(0, 0, 1), a);
+    CHECK(cache.memoryUsage() == bytes);
+
+    // a was used least recently
+    cache.put("source|2", TileID(1, 0, 1), b);
+    CHECK(cache.size() == 1);
+    CHECK(cache.memoryUsage() == bytes);
+    CHECK(cache.get("source|2", TileID(0, 0, 1)) == nullptr);
+    CHECK(cache.get("source|2", TileID(1, 0, 1)) == b);
+
+    // trimming keeps the limit for later tiles
+    cache.trim(0);
+    CHECK(cache.memoryUsage() == 0);
+    cache.put("source|2", TileID(0, 0, 1), a);
+    CHECK(cache.get("source|2", TileID(0, 0, 1)) == a);
+
+    cache.erase("source|2", TileID(0, 0, 1));
+    CHECK(cache.size() == 0);
+    CHECK(cache.memoryUsage() == 0);
+}
+
+TEST_CASE("Parsed tiles are limited by the shares of all Maps while any is set", TAGS) {
+    TileDataCache cache(16);
+
+    auto a = std::make_shared<TileData>();
+    auto b = std::make_shared<TileData>();
+    a->layers.emplace_back("roads");
+    b->layers.emplace_back("water");
+    size_t bytes = a->memoryUsage();
+
+    int mapA, mapB;
+    cache.setMaxBytes(bytes * 4);
+    cache.setShare(&mapA, bytes - 1);
+    cache.put("source|2", TileID(0, 0, 1), a);
+    CHECK(cache.size() == 0);
+
+    // the shares add up
+    cache.setShare(&mapB, bytes + 1);
+    cache.put("source|2", TileID(0, 0, 1), a);
+    cache.put("source|2", TileID(1, 0, 1), b);
+    CHECK(cache.size() == 2);
+
+    cache.removeShare(&mapB);
+    CHECK(cache.size() == 0);
+
+    // without shares the configured size applies again
+    cache.removeShare(&mapA);
+    cache.put("source|2", TileID(0, 0, 1), a);
+    cache.put("source|2", TileID(1, 0, 1), b);
+    CHECK(cache.size() == 2);
+}
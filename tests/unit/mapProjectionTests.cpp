@@ -2,6 +2,9 @@
 #include "glm/glm.hpp"
 #include "util/mapProjection.h"
 
+#include <cmath>
+#include <vector>
+
 using namespace Tangram;
 
 TEST_CASE("MapProjection correctly converts between LngLat and ProjectedMeters", "[projection]") {
@@ -56,3 +59,36 @@ TEST_CASE("MapProjection correctly converts between zoom and metersPerPixel", "[
     }
 
 }
+
+TEST_CASE("MapProjection converts points in batches as one by one", "[projection]") {
+
+    // Spread over the map, an odd count and points beyond the latitudes of the map
+    std::vector<LngLat> lngLats;
+    for (int i = 0; i < 2001; i++) {
+        double lng = -180.0 + 360.0 * std::fmod(i * 0.618033988749895, 1.0);
+        double lat = -MapProjection::MAX_LATITUDE_DEGREES + 2 * MapProjection::MAX_LATITUDE_DEGREES * i / 2000.0;
+        lngLats.emplace_back(lng, lat);
+    }
+    lngLats.emplace_back(12.5, 89.0);
+    lngLats.emplace_back(-70.25, -87.5);
+    lngLats.emplace_back(0.0, 1e-12);
+
+    std::vector<ProjectedMeters> meters(lngLats.size());
+    MapProjection::lngLatToProjectedMeters(lngLats.data(), meters.data(), lngLats.size());
+
+    for (size_t i = 0; i < lngLats.size(); i++) {
+        auto expected = MapProjection::lngLatToProjectedMeters(lngLats[i]);
+        CHECK_THAT(meters[i].x, Catch::WithinAbs(expected.x, 0.01));
+        CHECK_THAT(meters[i].y, Catch::WithinAbs(expected.y, 0.01));
+    }
+
+    std::vector<LngLat> converted(meters.size());
+    MapProjection::projectedMetersToLngLat(meters.data(), converted.data(), meters.size());
+
+    for (size_t i = 0; i < meters.size(); i++) {
+        auto expected = MapProjection::projectedMetersToLngLat(meters[i]);
+        CHECK_THAT(converted[i].longitude, Catch::WithinAbs(expected.longitude, 1e-9));
+        CHECK_THAT(converted[i].latitude, Catch::WithinAbs(expected.latitude, 1e-9));
+        CHECK_THAT(converted[i].latitude, Catch::WithinAbs(lngLats[i].latitude, 1e-9));
+    }
+}
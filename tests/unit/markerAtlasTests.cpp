@@ -0,0 +1,105 @@
+#include "catch.hpp"
+
+#include "gl/texture.h"
+#include "marker/markerAtlas.h"
+
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[MarkerAtlas]"
+
+static std::vector<unsigned int> bitmap(int width, int height, unsigned int color) {
+    return std::vector<unsigned int>(width * height, color);
+}
+
+TEST_CASE("Bitmaps share regions of one texture", TAGS) {
+    MarkerAtlas atlas;
+
+    auto red = bitmap(32, 32, 0xff0000ff);
+    auto blue = bitmap(32, 32, 0xffff0000);
+
+    uint32_t a = atlas.add(32, 32, 2.f, red.data());
+    uint32_t b = atlas.add(32, 32, 2.f, blue.data());
+    uint32_t c = atlas.add(32, 32, 2.f, red.data());
+
+    REQUIRE(a != 0);
+    REQUIRE(b != 0);
+    CHECK(a != b);
+    // the same bitmap shares its region
+    CHECK(c == a);
+    CHECK(atlas.regionCount() == 2);
+
+    SpriteNode spriteA, spriteB;
+    REQUIRE(atlas.getSprite(a, spriteA));
+    REQUIRE(atlas.getSprite(b, spriteB));
+    CHECK(spriteA.m_size == glm::vec2(16.f, 16.f));
+    CHECK(spriteA.m_uvBL != spriteB.m_uvBL);
+    CHECK(spriteA.m_uvTR.x - spriteA.m_uvBL.x == Approx(32.f / atlas.width()));
+    CHECK(spriteA.m_uvBL.y - spriteA.m_uvTR.y == Approx(32.f / atlas.height()));
+
+    // pixels are copied to the texture once
+    CHECK(!atlas.flush());
+    auto& texture = *atlas.texture();
+    CHECK(texture.width() == atlas.width());
+    CHECK(texture.needsUpload());
+    auto* pixels = reinterpret_cast<const unsigned int*>(texture.bufferData());
+    int x = int(spriteB.m_origin.x), y = int(spriteB.m_origin.y);
+    CHECK(pixels[y * atlas.width() + x] == 0xffff0000);
+    CHECK(!atlas.flush());
+}
+
+TEST_CASE("Unreferenced regions are evicted for new bitmaps", TAGS) {
+    MarkerAtlas atlas;
+
+    // fills the initial atlas
+    auto first = bitmap(200, 200, 1);
+    uint32_t a = atlas.add(200, 200, 1.f, first.data());
+    REQUIRE(a != 0);
+    atlas.flush();
+    int size = atlas.width();
+
+    // kept while unreferenced, until its space is needed
+    atlas.release(a);
+    CHECK(atlas.regionCount() == 1);
+    CHECK(atlas.add(200, 200, 1.f, first.data()) == a);
+    atlas.release(a);
+
+    auto second = bitmap(200, 200, 2);
+    uint32_t b = atlas.add(200, 200, 1.f, second.data());
+    REQUIRE(b != 0);
+    CHECK(atlas.regionCount() == 1);
+    CHECK(atlas.width() == size);
+    CHECK(!atlas.flush());
+}
+
+TEST_CASE("Atlas grows for referenced regions", TAGS) {
+    MarkerAtlas atlas;
+
+    std::vector<uint32_t> ids;
+    for (unsigned int i = 0; i < 20; i++) {
+        auto pixels = bitmap(64, 48, i + 1);
+        ids.push_back(atlas.add(64, 48, 1.f, pixels.data()));
+        REQUIRE(ids.back() != 0);
+    }
+    CHECK(atlas.regionCount() == 20);
+    CHECK(atlas.width() > 256);
+    CHECK(atlas.flush());
+
+    // regions do not overlap
+    for (size_t i = 0; i < ids.size(); i++) {
+        SpriteNode a;
+        REQUIRE(atlas.getSprite(ids[i], a));
+        for (size_t j = i + 1; j < ids.size(); j++) {
+            SpriteNode b;
+            REQUIRE(atlas.getSprite(ids[j], b));
+            bool separate = a.m_origin.x + 64 <= b.m_origin.x || b.m_origin.x + 64 <= a.m_origin.x ||
+                            a.m_origin.y + 48 <= b.m_origin.y || b.m_origin.y + 48 <= a.m_origin.y;
+            CHECK(separate);
+        }
+    }
+
+    // too large for any atlas
+    auto large = bitmap(8192, 1, 0);
+    CHECK(atlas.add(8192, 1, 1.f, large.data()) == 0);
+}
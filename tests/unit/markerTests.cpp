@@ -0,0 +1,114 @@
+#include "catch.hpp"
+
+#include "data/tileData.h"
+#include "gl/texture.h"
+#include "marker/marker.h"
+#include "scene/drawRule.h"
+#include "view/view.h"
+
+using namespace Tangram;
+
+static std::unique_ptr<Feature> pointFeature() {
+    auto feature = std::make_unique<Feature>();
+    feature->geometryType = GeometryType::points;
+    feature->addPoint({});
+    feature->props.set("name", "bus");
+    return feature;
+}
+
+TEST_CASE("Marker copies for building on another thread are independent", "[Marker]") {
+
+    Marker marker(7);
+    REQUIRE(!marker.copyForBuild());
+
+    marker.setFeature(pointFeature());
+    marker.setDrawRuleData(std::make_unique<DrawRuleData>("", 0, std::vector<StyleParam>{
+                { StyleParamKey::style, "points" },
+                { StyleParamKey::color, "red" } }));
+    marker.setBounds({ glm::dvec2(10, 20), glm::dvec2(10, 20) });
+
+    auto copy = marker.copyForBuild();
+    REQUIRE(copy);
+    REQUIRE(copy->id() == 7);
+    REQUIRE(copy->origin() == marker.origin());
+    REQUIRE(copy->feature() != marker.feature());
+    REQUIRE(copy->feature()->props.getString("name") == "bus");
+    REQUIRE(copy->drawRule()->getStyleName() == "points");
+
+    // Params are owned by the copy
+    auto* param = &copy->drawRule()->findParameter(StyleParamKey::color);
+    REQUIRE(param != &marker.drawRule()->findParameter(StyleParamKey::color));
+    marker.setDrawRuleData(std::make_unique<DrawRuleData>("", 0, std::vector<StyleParam>{
+                { StyleParamKey::style, "lines" } }));
+    REQUIRE(copy->drawRule()->getStyleName() == "points");
+    REQUIRE(copy->drawRule()->findParameter(StyleParamKey::color).value.get<std::string>() == "red");
+}
+
+TEST_CASE("Marker revision changes with its geometry, styling and bitmap", "[Marker]") {
+
+    Marker marker(1);
+    auto revision = marker.revision();
+
+    marker.setFeature(pointFeature());
+    REQUIRE(marker.revision() != revision);
+    revision = marker.revision();
+
+    // Moving and sorting does not change the mesh
+    marker.setBounds({ glm::dvec2(1, 1), glm::dvec2(1, 1) });
+    marker.setDrawOrder(3);
+    REQUIRE(marker.revision() == revision);
+
+    marker.setStyling("{ style: points }", false);
+    REQUIRE(marker.revision() != revision);
+    revision = marker.revision();
+
+    marker.clearMesh();
+    REQUIRE(marker.revision() != revision);
+    revision = marker.revision();
+
+    marker.setTexture(std::make_unique<Texture>(TextureOptions()));
+    REQUIRE(marker.revision() != revision);
+    // Bitmaps are not copied for other threads
+    marker.setDrawRuleData(std::make_unique<DrawRuleData>("", 0, std::vector<StyleParam>{
+                { StyleParamKey::style, "points" } }));
+    REQUIRE(!marker.copyForBuild());
+}
+
+TEST_CASE("Marker eases are evaluated for the time of the update", "[Marker]") {
+
+    View view(256, 256);
+    view.update();
+
+    Marker marker(1);
+    marker.setFeature(pointFeature());
+    marker.setBounds({ glm::dvec2(0, 0), glm::dvec2(0, 0) });
+    marker.update(0.f, view);
+    REQUIRE(!marker.needsUpdate());
+
+    marker.setEase(glm::dvec2(100, 0), 2.f, EaseType::linear, 10.f);
+    REQUIRE(marker.needsUpdate());
+
+    // Frames may be skipped
+    marker.update(11.f, view);
+    REQUIRE(marker.origin().x == Approx(50));
+    REQUIRE(marker.isEasing());
+
+    // Restarting from the current origin
+    marker.setEase(glm::dvec2(50, 100), 1.f, EaseType::linear, 11.f);
+    marker.update(11.5f, view);
+    REQUIRE(marker.origin().x == Approx(50));
+    REQUIRE(marker.origin().y == Approx(50));
+
+    marker.update(20.f, view);
+    REQUIRE(marker.origin().y == Approx(100));
+    REQUIRE(!marker.isEasing());
+    REQUIRE(!marker.needsUpdate());
+
+    // Setting the point ends the ease
+    marker.setEase(glm::dvec2(0, 0), 1.f, EaseType::cubic, 20.f);
+    marker.setBounds({ glm::dvec2(5, 5), glm::dvec2(5, 5) });
+    REQUIRE(!marker.isEasing());
+    REQUIRE(marker.needsUpdate());
+    marker.update(20.5f, view);
+    REQUIRE(marker.origin() == glm::dvec2(5, 5));
+}
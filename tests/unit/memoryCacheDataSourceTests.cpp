@@ -0,0 +1,251 @@
+#include "catch.hpp"
+
+#include "data/memoryCacheDataSource.h"
+#include "data/tileSource.h"
+#include "tile/tileTask.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[MemoryCacheDataSource]"
+
+struct TestDataSource : TileSource::DataSource {
+    int loadCount = 0;
+    std::shared_ptr<std::vector<char>> compressed;
+    bool sameData = false;
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        auto& task = static_cast<BinaryTileTask&>(*_task);
+        std::string data = "tile " + (sameData ? "" : _task->tileId().toString()) + std::string(4096, 'x');
+        task.rawTileData = std::make_shared<std::vector<char>>(data.begin(), data.end());
+        task.compressedTileData = compressed;
+        loadCount++;
+        _cb.func(_task);
+        return true;
+    }
+};
+
+static std::shared_ptr<BinaryTileTask> loadTile(TileSource::DataSource& _source, TileID _tileId) {
+    auto task = std::make_shared<BinaryTileTask>(_tileId, nullptr);
+    _source.loadTileData(task, {[](std::shared_ptr<TileTask>) {}});
+    return task;
+}
+
+static std::string tileString(const BinaryTileTask& _task) {
+    return std::string(_task.rawTileData->begin(), _task.rawTileData->end());
+}
+
+TEST_CASE("Cached tile data is returned without loading from next source", TAGS) {
+
+    for (bool compress : { false, true }) {
+        MemoryCacheDataSource cache(compress);
+        cache.setNext(std::make_unique<TestDataSource>());
+        cache.setCacheSize(1024 * 1024);
+        auto& next = static_cast<TestDataSource&>(*cache.next);
+
+        std::string expected[16];
+        for (int i = 0; i < 16; i++) {
+            expected[i] = tileString(*loadTile(cache, TileID(i, i, 5)));
+        }
+        REQUIRE(next.loadCount == 16);
+
+        for (int i = 0; i < 16; i++) {
+            CHECK(tileString(*loadTile(cache, TileID(i, i, 5))) == expected[i]);
+        }
+        CHECK(next.loadCount == 16);
+
+        if (compress) {
+            CHECK(cache.cacheUsage() < 16 * 4096 / 4);
+        } else {
+            CHECK(cache.cacheUsage() >= 16 * 4096);
+        }
+    }
+}
+
+TEST_CASE("Compressed cache keeps tile data in its received form", TAGS) {
+
+    MemoryCacheDataSource cache(true);
+    cache.setNext(std::make_unique<TestDataSource>());
+    cache.setCacheSize(1024 * 1024);
+    auto& next = static_cast<TestDataSource&>(*cache.next);
+
+    // zlib stream of "wire", as received from e.g. MBTiles
+    next.compressed = std::make_shared<std::vector<char>>(std::vector<char>{
+        0x78, char(0x9c), 0x2b, char(0xcf), 0x2c, 0x4a, 0x05, 0x00, 0x04, 0x64, 0x01, char(0xb8) });
+
+    loadTile(cache, TileID(1, 2, 3));
+    CHECK(cache.cacheUsage() == next.compressed->size());
+    CHECK(tileString(*loadTile(cache, TileID(1, 2, 3))) == "wire");
+    CHECK(next.loadCount == 1);
+}
+
+TEST_CASE("Tiles with identical data share one buffer", TAGS) {
+
+    MemoryCacheDataSource cache;
+    cache.setNext(std::make_unique<TestDataSource>());
+    cache.setCacheSize(1024 * 1024);
+    auto& next = static_cast<TestDataSource&>(*cache.next);
+    next.sameData = true;
+
+    loadTile(cache, TileID(0, 0, 4));
+    loadTile(cache, TileID(1, 0, 4));
+    REQUIRE(next.loadCount == 2);
+
+    auto a = loadTile(cache, TileID(0, 0, 4));
+    auto b = loadTile(cache, TileID(1, 0, 4));
+    CHECK(next.loadCount == 2);
+    CHECK(a->rawTileData == b->rawTileData);
+}
+
+TEST_CASE("Trimmed and cleared cache loads from next source again", TAGS) {
+
+    MemoryCacheDataSource cache;
+    cache.setNext(std::make_unique<TestDataSource>());
+    cache.setCacheSize(1024 * 1024);
+    auto& next = static_cast<TestDataSource&>(*cache.next);
+
+    for (int i = 0; i < 8; i++) { loadTile(cache, TileID(i, 0, 4)); }
+    REQUIRE(cache.cacheUsage() > 0);
+
+    cache.trimCache(0);
+    CHECK(cache.cacheUsage() == 0);
+
+    loadTile(cache, TileID(0, 0, 4));
+    CHECK(next.loadCount == 9);
+    CHECK(cache.cacheUsage() > 0);
+
+    cache.clear();
+    CHECK(cache.cacheUsage() == 0);
+}
+
+TEST_CASE("Cache size limits all tiles together rather than each part of the cache", TAGS) {
+
+    MemoryCacheDataSource cache;
+    cache.setNext(std::make_unique<TestDataSource>());
+    auto& next = static_cast<TestDataSource&>(*cache.next);
+
+    // room for three tiles of about 4kB, each larger than an equal part of the cache per lock
+    cache.setCacheSize(3 * 4200);
+    for (int i = 0; i < 3; i++) { loadTile(cache, TileID(i, 0, 4)); }
+    for (int i = 0; i < 3; i++) { loadTile(cache, TileID(i, 0, 4)); }
+    CHECK(next.loadCount == 3);
+
+    for (int i = 3; i < 16; i++) { loadTile(cache, TileID(i, 0, 4)); }
+    CHECK(cache.cacheUsage() <= 3 * 4200);
+    CHECK(cache.cacheUsage() > 0);
+
+    // a tile larger than the whole cache is not kept
+    cache.clear();
+    cache.setCacheSize(4096);
+    loadTile(cache, TileID(0, 0, 4));
+    CHECK(cache.cacheUsage() == 0);
+}
+
+TEST_CASE("Invalidated tile is dropped from cache and only its generation changes", TAGS) {
+
+    auto cache = std::make_unique<MemoryCacheDataSource>();
+    cache->setNext(std::make_unique<TestDataSource>());
+    cache->setCacheSize(1024 * 1024);
+    auto& next = static_cast<TestDataSource&>(*cache->next);
+    auto& raw = *cache;
+
+    TileSource source("test", std::move(cache));
+    TileID stale(1, 0, 4), other(2, 0, 4);
+    loadTile(raw, stale);
+    loadTile(raw, other);
+    REQUIRE(next.loadCount == 2);
+
+    int64_t initial = source.generation();
+    CHECK(source.tileGeneration(stale) == initial);
+
+    source.invalidateTile(TileID(stale.x, stale.y, stale.z, 6));
+    CHECK(source.generation() > initial);
+    CHECK(source.tileGeneration(stale) == source.generation());
+    CHECK(source.tileGeneration(TileID(stale.x, stale.y, stale.z, 5)) == source.generation());
+    CHECK(source.tileGeneration(other) == initial);
+
+    loadTile(raw, stale);
+    loadTile(raw, other);
+    CHECK(next.loadCount == 3);
+
+    // other updates affect all tiles
+    source.clearData();
+    CHECK(source.tileGeneration(other) == source.generation());
+}
+
+// Keeps callbacks to call, or drop, them later like NetworkDataSource
+struct DeferredDataSource : TileSource::DataSource {
+    std::vector<std::pair<std::shared_ptr<TileTask>, TileTaskCb>> pending;
+    bool start = true;
+
+    bool loadTileData(std::shared_ptr<TileTask> _task, TileTaskCb _cb) override {
+        if (!start) { return false; }
+        pending.emplace_back(std::move(_task), std::move(_cb));
+        return true;
+    }
+
+    void finish(size_t _index) {
+        auto& task = static_cast<BinaryTileTask&>(*pending[_index].first);
+        std::string data = "tile " + task.tileId().toString();
+        task.rawTileData = std::make_shared<std::vector<char>>(data.begin(), data.end());
+        pending[_index].second.func(pending[_index].first);
+    }
+};
+
+TEST_CASE("Tile data loaded later by next source is cached on its way back", TAGS) {
+
+    MemoryCacheDataSource cache;
+    cache.setNext(std::make_unique<DeferredDataSource>());
+    cache.setCacheSize(1024 * 1024);
+    auto& next = static_cast<DeferredDataSource&>(*cache.next);
+
+    int called = 0;
+    TileTaskCb cb{[&](std::shared_ptr<TileTask>) { called++; }};
+
+    auto task = std::make_shared<BinaryTileTask>(TileID(1, 2, 3), nullptr);
+    CHECK(cache.loadTileData(task, cb));
+    REQUIRE(next.pending.size() == 1);
+    CHECK(called == 0);
+    CHECK(cache.cacheUsage() == 0);
+
+    next.finish(0);
+    CHECK(called == 1);
+    CHECK(cache.cacheUsage() > 0);
+    next.pending.clear();
+
+    // Served from the cache now
+    auto cached = std::make_shared<BinaryTileTask>(TileID(1, 2, 3), nullptr);
+    CHECK(cache.loadTileData(cached, cb));
+    CHECK(called == 2);
+    CHECK(next.pending.empty());
+    CHECK(tileString(*cached) == "tile " + TileID(1, 2, 3).toString());
+
+    // Not started by next source
+    next.start = false;
+    auto other = std::make_shared<BinaryTileTask>(TileID(2, 2, 3), nullptr);
+    CHECK_FALSE(cache.loadTileData(other, cb));
+    CHECK(called == 2);
+}
+
+TEST_CASE("Callbacks dropped by next source release their tile task", TAGS) {
+
+    MemoryCacheDataSource cache;
+    cache.setNext(std::make_unique<DeferredDataSource>());
+    auto& next = static_cast<DeferredDataSource&>(*cache.next);
+
+    std::weak_ptr<TileTask> weak;
+    {
+        auto task = std::make_shared<BinaryTileTask>(TileID(1, 2, 3), nullptr);
+        weak = task;
+        CHECK(cache.loadTileData(task, {[](std::shared_ptr<TileTask>) {}}));
+    }
+    REQUIRE(next.pending.size() == 1);
+    next.pending[0].first.reset();
+    CHECK_FALSE(weak.expired());
+
+    // e.g. canceled
+    next.pending.clear();
+    CHECK(weak.expired());
+}
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include "gl/mesh.h"
+#include "gl/renderState.h"
 
 using namespace Tangram;
 
@@ -170,3 +171,215 @@ TEST_CASE( "Check overflow", "[Core][TypedMesh]" ) {
 
     checkBounds(mesh);
 }
+
+TEST_CASE( "Buffer pool reuses released ranges", "[Core][BufferPool]" ) {
+    RenderState rs;
+    BufferPool pool;
+    char data[100] = { 0 };
+
+    auto a = pool.allocate(rs, GL_ARRAY_BUFFER, 100, data);
+    auto b = pool.allocate(rs, GL_ARRAY_BUFFER, 10, data);
+    auto c = pool.allocate(rs, GL_ARRAY_BUFFER, 10, data);
+
+    REQUIRE(a.offset == 0);
+    REQUIRE(a.size == 112);
+    REQUIRE(b.offset == 112);
+    REQUIRE(c.offset == 128);
+    REQUIRE(pool.stats().pages == 1);
+    REQUIRE(pool.stats().ranges == 3);
+
+    // Adjacent free blocks are merged and taken first fit
+    pool.release(a);
+    pool.release(b);
+    auto d = pool.allocate(rs, GL_ARRAY_BUFFER, 120, data);
+    REQUIRE(d.offset == 0);
+    REQUIRE(d.page == a.page);
+    REQUIRE(pool.stats().ranges == 2);
+    REQUIRE(pool.stats().bytesUsed == 128 + 16);
+
+    // Index ranges are taken from their own page
+    auto e = pool.allocate(rs, GL_ELEMENT_ARRAY_BUFFER, 10, data);
+    REQUIRE(e.offset == 0);
+    REQUIRE(e.page != a.page);
+    REQUIRE(pool.stats().pages == 2);
+}
+
+TEST_CASE( "Buffer pool does not take large or empty ranges", "[Core][BufferPool]" ) {
+    RenderState rs;
+    BufferPool pool;
+    std::vector<char> data(BufferPool::MAX_RANGE_SIZE + 1);
+
+    REQUIRE(!pool.allocate(rs, GL_ARRAY_BUFFER, data.size(), data.data()));
+    REQUIRE(!pool.allocate(rs, GL_ARRAY_BUFFER, 0, data.data()));
+    REQUIRE(pool.stats().pages == 0);
+}
+
+TEST_CASE( "Buffer pool deletes empty pages but one", "[Core][BufferPool]" ) {
+    RenderState rs;
+    BufferPool pool;
+    std::vector<char> data(BufferPool::MAX_RANGE_SIZE);
+
+    std::vector<BufferPool::Range> ranges;
+    for (int i = 0; i < 5; i++) {
+        ranges.push_back(pool.allocate(rs, GL_ARRAY_BUFFER, data.size(), data.data()));
+    }
+    REQUIRE(pool.stats().pages == 2);
+
+    for (auto& range : ranges) { pool.release(range); }
+    pool.collect(rs);
+    REQUIRE(pool.stats().pages == 1);
+    REQUIRE(pool.stats().ranges == 0);
+
+    // Ranges taken before invalidate() are ignored
+    auto range = pool.allocate(rs, GL_ARRAY_BUFFER, 10, data.data());
+    pool.invalidate();
+    pool.release(range);
+    pool.collect(rs);
+    REQUIRE(pool.stats().pages == 0);
+}
+
+TEST_CASE( "Pending upload of a mesh happens once", "[Core][TypedMesh]" ) {
+    RenderState rs;
+    auto mesh = newMesh(10);
+
+    REQUIRE(mesh->uploadPending(rs) == mesh->bufferSize());
+    REQUIRE(mesh->uploadPending(rs) == 0);
+    REQUIRE(rs.bufferPool.stats().ranges == 1);
+}
+
+struct ShortVertex {
+    int16_t x, y, z, w;
+};
+
+struct ChunkedMesh : public Mesh<ShortVertex> {
+    using Base = Mesh<ShortVertex>;
+    using Base::Base;
+
+    const std::vector<Chunk>& chunks() const { return m_chunks; }
+    const std::vector<uint16_t>& chunkMasks() const { return m_chunkMasks; }
+    const GLushort* indices() const { return m_glIndexData; }
+};
+
+TEST_CASE( "Triangles of a chunked mesh are grouped and culled by chunk", "[Core][TypedMesh]" ) {
+    auto shortLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"a_position", 4, GL_SHORT, false, 0},
+    }));
+    ChunkedMesh mesh(shortLayout, GL_TRIANGLES);
+
+    // A triangle at the upper right corner of the tile, then one at the lower left
+    MeshData<ShortVertex> meshData;
+    meshData.vertices = { {7000, 7000, 0, 0}, {8000, 7000, 0, 0}, {8000, 8000, 0, 0},
+                          {0, 0, 0, 0}, {1000, 0, 0, 0}, {1000, 1000, 0, 0} };
+    meshData.indices = { 0, 1, 2, 3, 4, 5 };
+    meshData.offsets.emplace_back(6, 6);
+
+    mesh.setChunking(8192.f, 0.f);
+    mesh.compile(meshData);
+
+    auto& chunks = mesh.chunks();
+    REQUIRE(chunks.size() == MeshBase::CHUNKS);
+    REQUIRE(chunks[0].nIndices == 3);
+    REQUIRE(chunks[MeshBase::CHUNKS - 1].nIndices == 3);
+    REQUIRE(chunks[0].firstIndex == 0);
+    REQUIRE(chunks[MeshBase::CHUNKS - 1].firstIndex == 3);
+
+    // Lower left triangle first
+    REQUIRE(mesh.indices()[0] < 3);
+    REQUIRE(chunks[0].max.x == Approx(1000.f / 8192.f));
+
+    // Tile units to clip space, showing the left half of the tile
+    glm::mat4 mvp(1.f);
+    mvp[0][0] = 4.f;
+    mvp[1][1] = 2.f;
+    mvp[3][0] = -1.f;
+    mvp[3][1] = -1.f;
+
+    mesh.cullChunks(mvp, glm::vec2(0.f));
+    REQUIRE(mesh.chunkMasks().size() == 1);
+    REQUIRE(mesh.chunkMasks()[0] == 1);
+
+    mesh.showAllChunks();
+    REQUIRE(mesh.chunkMasks().empty());
+}
+
+TEST_CASE( "Chunks within covered cells are hidden", "[Core][TypedMesh]" ) {
+    auto shortLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"a_position", 4, GL_SHORT, false, 0},
+    }));
+    ChunkedMesh mesh(shortLayout, GL_TRIANGLES);
+
+    // A triangle within the lower left cell, then one from it reaching into the next cell
+    MeshData<ShortVertex> meshData;
+    meshData.vertices = { {0, 0, 0, 0}, {1000, 0, 0, 0}, {1000, 1000, 0, 0},
+                          {0, 0, 0, 0}, {3000, 0, 0, 0}, {0, 1000, 0, 0} };
+    meshData.indices = { 0, 1, 2, 3, 4, 5 };
+    meshData.offsets.emplace_back(6, 6);
+
+    mesh.setChunking(8192.f, 0.f);
+    mesh.compile(meshData);
+
+    // Both triangles have their centroid in the first cell
+    REQUIRE(mesh.chunks()[0].nIndices == 6);
+
+    mesh.hideCoveredChunks(1);
+    REQUIRE(mesh.chunkMasks().size() == 1);
+    REQUIRE(mesh.chunkMasks()[0] == 0xffff);
+
+    mesh.showAllChunks();
+    mesh.hideCoveredChunks(0x3);
+    REQUIRE(mesh.chunkMasks()[0] == 0xfffe);
+
+    mesh.showAllChunks();
+    mesh.hideCoveredChunks(0);
+    REQUIRE(mesh.chunkMasks().empty());
+}
+
+struct PackedVertex {
+    int16_t x, y, z, w;
+    int8_t normal[4];
+    uint32_t color;
+    uint32_t selection;
+};
+
+TEST_CASE( "Vertices are packed into the compiled layout", "[Core][TypedMesh]" ) {
+    auto fullLayout = std::shared_ptr<VertexLayout>(new VertexLayout({
+        {"a_position", 4, GL_SHORT, false, 0},
+        {"a_normal", 4, GL_BYTE, true, 0},
+        {"a_color", 4, GL_UNSIGNED_BYTE, true, 0},
+        {"a_selection_color", 4, GL_UNSIGNED_BYTE, true, 0},
+    }));
+
+    REQUIRE(VertexLayout::without(fullLayout, { "a_texcoord" }) == fullLayout);
+
+    auto packedLayout = VertexLayout::without(fullLayout, { "a_normal", "a_selection_color" });
+    REQUIRE(packedLayout->getStride() == 12);
+    REQUIRE(packedLayout->getOffset("a_color") == 8);
+    REQUIRE_FALSE(packedLayout->hasAttrib("a_normal"));
+
+    Mesh<PackedVertex> mesh(fullLayout, GL_TRIANGLES);
+    MeshData<PackedVertex> meshData;
+    meshData.vertices = { {1, 2, 3, 4, {0, 0, 127, 0}, 0xff0000ff, 0},
+                          {5, 6, 7, 8, {0, 0, 127, 0}, 0xff00ff00, 0},
+                          {9, 10, 11, 12, {0, 0, 127, 0}, 0xffff0000, 0} };
+    meshData.indices = { 0, 1, 2 };
+    meshData.offsets.emplace_back(3, 3);
+
+    mesh.setCompiledLayout(packedLayout);
+    mesh.compile(meshData);
+
+    REQUIRE_FALSE(mesh.selectable());
+    REQUIRE(mesh.bufferSize() == 3 * 12 + 3 * sizeof(GLushort));
+
+    // Header of 5 values and one batch, then the vertices
+    std::vector<char> data;
+    REQUIRE(mesh.serialize(data));
+    const char* vertices = data.data() + 7 * sizeof(uint32_t);
+
+    int16_t position[4];
+    uint32_t color;
+    std::memcpy(position, vertices + 12, sizeof(position));
+    std::memcpy(&color, vertices + 12 + 8, sizeof(color));
+    REQUIRE(position[0] == 5);
+    REQUIRE(position[3] == 8);
+    REQUIRE(color == 0xff00ff00);
+}
@@ -0,0 +1,316 @@
+#include "catch.hpp"
+
+#include "data/formats/mlt.h"
+#include "data/propertyItem.h"
+#include "tile/tileTask.h"
+#include "util/builders.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[Mlt]"
+
+enum { PRESENT = 0, DATA = 1, OFFSET = 2, LENGTH = 3 };
+enum { PLAIN = 0, FAST_PFOR = 1, VARINT = 2 };
+enum { DELTA = 1, COMPONENTWISE_DELTA = 2, RLE = 3 };
+
+static void writeVarint(std::string& _out, uint64_t _value) {
+    while (_value >= 0x80) {
+        _out += char((_value & 0x7f) | 0x80);
+        _value >>= 7;
+    }
+    _out += char(_value);
+}
+
+static void writeString(std::string& _out, const std::string& _value) {
+    writeVarint(_out, _value.size());
+    _out += _value;
+}
+
+static uint64_t zigzag(int64_t _value) {
+    return (uint64_t(_value) << 1) ^ uint64_t(_value >> 63);
+}
+
+static std::string varints(const std::vector<uint64_t>& _values) {
+    std::string out;
+    for (auto value : _values) { writeVarint(out, value); }
+    return out;
+}
+
+// Stream with @_numValues encoded in @_data, and for RLE the number of runs and of decoded values
+static void writeStream(std::string& _out, int _type, int _subtype, int _technique1, int _technique2,
+                        int _encoding, size_t _numValues, const std::string& _data,
+                        std::vector<uint64_t> _rle = {}) {
+    _out += char((_type << 4) | _subtype);
+    _out += char((_technique1 << 5) | (_technique2 << 2) | _encoding);
+    writeVarint(_out, _numValues);
+    writeVarint(_out, _data.size());
+    for (auto value : _rle) { writeVarint(_out, value); }
+    _out += _data;
+}
+
+static void writeInts(std::string& _out, int _type, int _subtype, const std::vector<uint64_t>& _values) {
+    writeStream(_out, _type, _subtype, 0, 0, VARINT, _values.size(), varints(_values));
+}
+
+// Byte RLE encoded bits, as literals
+static void writeBits(std::string& _out, int _type, const std::vector<bool>& _bits) {
+    std::string bytes((_bits.size() + 7) / 8, '\0');
+    for (size_t i = 0; i < _bits.size(); i++) {
+        if (_bits[i]) { bytes[i / 8] |= char(1 << (i % 8)); }
+    }
+    writeStream(_out, _type, 0, 0, 0, PLAIN, _bits.size(), char(0x100 - bytes.size()) + bytes);
+}
+
+static std::string layer(const std::string& _name, const std::string& _body) {
+    std::string layer, out;
+    writeVarint(layer, 1);
+    writeString(layer, _name);
+    layer += _body;
+    writeVarint(out, layer.size());
+    return out + layer;
+}
+
+// Two polygon features with triangles and a point, with properties of each type
+static std::string buildings(bool _fastPfor = false) {
+    std::string body;
+    writeVarint(body, 4096);
+
+    // columns: id, geometry, height, name (nullable), open, area (nullable)
+    writeVarint(body, 6);
+    writeVarint(body, 0);
+    writeVarint(body, 4);
+    writeVarint(body, 16);
+    writeString(body, "height");
+    writeVarint(body, 29);
+    writeString(body, "name");
+    writeVarint(body, 10);
+    writeString(body, "open");
+    writeVarint(body, 27);
+    writeString(body, "area");
+
+    writeInts(body, DATA, 0, { 1, 2, 3 });
+
+    // polygon with a hole, multipolygon of two squares, point
+    writeVarint(body, 7);
+    writeInts(body, DATA, 0, { 2, 5, 0 });
+    writeInts(body, LENGTH, 1, { 2 });
+    writeInts(body, LENGTH, 2, { 2, 1, 1 });
+    writeInts(body, LENGTH, 3, { 4, 4, 4, 4 });
+    writeInts(body, LENGTH, 4, { 2, 4 });
+    writeInts(body, OFFSET, 1, { 0, 1, 4, 1, 2, 7,
+                                 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 });
+    std::vector<int> points = { 0, 0, 10, 0, 10, 10, 0, 10,  2, 2, 2, 8, 8, 8, 8, 2,
+                                20, 0, 30, 0, 30, 10, 20, 10,  40, 0, 50, 0, 50, 10, 40, 10,
+                                5, 5 };
+    std::vector<uint64_t> deltas;
+    for (size_t i = 0; i < points.size(); i++) {
+        deltas.push_back(zigzag(points[i] - (i < 2 ? 0 : points[i - 2])));
+    }
+    writeStream(body, DATA, 3, COMPONENTWISE_DELTA, 0, VARINT, deltas.size(), varints(deltas));
+
+    // height: 10, 10, 20 as runs
+    writeStream(body, DATA, 0, RLE, 0, _fastPfor ? FAST_PFOR : VARINT, 4,
+                varints({ 2, 1, zigzag(10), zigzag(20) }), { 2, 3 });
+
+    // name: "tower", none, "hall" from a dictionary
+    writeVarint(body, 4);
+    writeBits(body, PRESENT, { true, false, true });
+    writeInts(body, OFFSET, 2, { 1, 0 });
+    writeInts(body, LENGTH, 6, { 4, 5 });
+    writeStream(body, DATA, 1, 0, 0, PLAIN, 2, "halltower");
+
+    writeBits(body, DATA, { true, false, true });
+
+    writeBits(body, PRESENT, { false, true, false });
+    double area = 12.5;
+    std::string bytes(sizeof(area), '\0');
+    std::memcpy(&bytes[0], &area, sizeof(area));
+    writeStream(body, DATA, 0, 0, 0, PLAIN, 1, bytes);
+
+    return layer("buildings", body);
+}
+
+// One point feature with a plain string "kind": @_name
+static std::string pois(const std::string& _name) {
+    std::string body;
+    writeVarint(body, 4096);
+    writeVarint(body, 2);
+    writeVarint(body, 4);
+    writeVarint(body, 28);
+    writeString(body, "kind");
+
+    writeVarint(body, 2);
+    writeInts(body, DATA, 0, { 0 });
+    writeStream(body, DATA, 3, COMPONENTWISE_DELTA, 0, VARINT, 2, varints({ zigzag(10), zigzag(20) }));
+
+    writeVarint(body, 2);
+    writeInts(body, LENGTH, 0, { _name.size() });
+    writeStream(body, DATA, 0, 0, 0, PLAIN, 1, _name);
+
+    return layer(_name, body);
+}
+
+static std::shared_ptr<TileData> parse(const std::string& _tile, const std::vector<std::string>& _layers = {},
+                                       const PropertyKeys* _propertyKeys = nullptr) {
+    BinaryTileTask task(TileID(0, 0, 0), nullptr);
+    task.rawTileData = std::make_shared<std::vector<char>>(_tile.begin(), _tile.end());
+    return Mlt::parseTile(task, 0, _layers, _propertyKeys);
+}
+
+TEST_CASE("Features are read from the columns of a layer", TAGS) {
+    auto data = parse(buildings());
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+    CHECK(data->layers[0].name == "buildings");
+
+    auto& features = data->layers[0].features;
+    REQUIRE(features.size() == 3);
+    CHECK(features[0].coordinates.get_allocator().arena == data->arena.get());
+
+    REQUIRE(features[0].geometryType == GeometryType::polygons);
+    auto polygon = features[0].polygons();
+    REQUIRE(polygon.size() == 1);
+    REQUIRE(polygon[0].size() == 2);
+    // rings are closed
+    CHECK(polygon[0][0].size() == 5);
+    CHECK(polygon[0][1].front() == polygon[0][1].back());
+    CHECK(features[1].polygons().size() == 2);
+
+    REQUIRE(features[2].geometryType == GeometryType::points);
+    REQUIRE(features[2].points().size() == 1);
+    CHECK(features[2].points()[0].x == Approx(5 / 4095.));
+    CHECK(features[2].points()[0].y == Approx((4096 - 5) / 4095.));
+
+    CHECK(features[0].props.getNumber("height") == 10);
+    CHECK(features[1].props.getNumber("height") == 10);
+    CHECK(features[2].props.getNumber("height") == 20);
+
+    CHECK(features[0].props.getString("name") == "tower");
+    CHECK_FALSE(features[1].props.contains("name"));
+    CHECK(features[2].props.getString("name") == "hall");
+
+    CHECK(features[0].props.getNumber("open") == 1);
+    CHECK(features[1].props.getNumber("open") == 0);
+
+    CHECK_FALSE(features[0].props.contains("area"));
+    CHECK(features[1].props.getNumber("area") == 12.5);
+
+    // values are shared in the table of the layer
+    REQUIRE(features[0].props.table());
+    CHECK(features[0].props.table() == features[2].props.table());
+    CHECK(features[0].props.table()->values.size() == 7);
+}
+
+TEST_CASE("Pre-tessellated polygons keep their triangles", TAGS) {
+    auto data = parse(buildings());
+    REQUIRE(data);
+    auto& features = data->layers[0].features;
+
+    // indices of the hole count the closing point of the exterior ring
+    REQUIRE(features[0].triangleEnds.size() == 1);
+    auto triangles = features[0].polygonTriangles(0);
+    CHECK(std::vector<uint16_t>(triangles.begin(), triangles.end()) == std::vector<uint16_t>{ 0, 1, 5, 1, 2, 8 });
+
+    // the triangles of each polygon are relative to its first point
+    REQUIRE(features[1].triangleEnds.size() == 2);
+    triangles = features[1].polygonTriangles(1);
+    CHECK(std::vector<uint16_t>(triangles.begin(), triangles.end()) == std::vector<uint16_t>{ 0, 1, 2, 0, 2, 3 });
+
+    CHECK(features[2].triangles.empty());
+
+    PolygonBuilder builder;
+    Builders::buildPolygon(features[1].polygons()[1], 0.f, builder, features[1].polygonTriangles(1));
+    CHECK(builder.vertices.size() == 4);
+    CHECK(builder.indices == std::vector<uint16_t>{ 0, 1, 2, 0, 2, 3 });
+}
+
+TEST_CASE("Layers that are not used or not supported are skipped", TAGS) {
+    std::string tile = pois("cafe") + buildings(true) + pois("bar");
+
+    auto data = parse(tile);
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 2);
+    CHECK(data->layers[0].features[0].props.getString("kind") == "cafe");
+    CHECK(data->layers[1].features[0].props.getString("kind") == "bar");
+
+    data = parse(tile, { "bar" });
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+    CHECK(data->layers[0].name == "bar");
+
+    // broken tiles are not
+    CHECK_FALSE(parse(tile.substr(0, tile.size() - 2)));
+}
+
+TEST_CASE("Property columns that the scene does not read are dropped", TAGS) {
+    PropertyKeys propertyKeys;
+    propertyKeys.add("buildings", { "name" }, false);
+
+    auto data = parse(buildings(true), {}, &propertyKeys);
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+
+    auto& props = data->layers[0].features[0].props;
+    CHECK(props.getString("name") == "tower");
+    CHECK_FALSE(props.contains("height"));
+    CHECK(props.items().size() == 1);
+}
+
+// Layer "roads" as laid out by the reference encoder, with the encodings it picks for small
+// layers that the helpers above do not write: delta-RLE ids, RLE geometry types, vertex counts
+// of lines as parts, one vertex buffer across features and RLE dictionary offsets.
+// Features: ids 1 to 3; lines (0 0, 100 0), (100 100, 200 100, 200 200), (4095 0, 4095 4095);
+// class "primary", "primary", "service"; lanes 2, none, 1
+static const char roadsTile[] =
+    "\x7a\x01\x05\x72\x6f\x61\x64\x73\x80\x20\x04\x00\x04\x1c\x05\x63"
+    "\x6c\x61\x73\x73\x11\x05\x6c\x61\x6e\x65\x73\x10\x2e\x02\x02\x01"
+    "\x03\x03\x02\x03\x10\x62\x02\x02\x01\x03\x03\x01\x32\x02\x03\x03"
+    "\x02\x03\x02\x13\x42\x0e\x15\x00\x00\xc8\x01\x00\x00\xc8\x01\xc8"
+    "\x01\x00\x00\xc8\x01\xee\x3c\x8f\x03\x00\xfe\x3f\x03\x22\x62\x04"
+    "\x04\x02\x03\x02\x01\x00\x01\x36\x02\x02\x02\x07\x07\x11\x00\x02"
+    "\x0e\x70\x72\x69\x6d\x61\x72\x79\x73\x65\x72\x76\x69\x63\x65\x00"
+    "\x00\x03\x02\xff\x05\x10\x02\x02\x02\x04\x02";
+
+TEST_CASE("Tiles with the encodings of the reference encoder are read", TAGS) {
+    auto data = parse(std::string(roadsTile, sizeof(roadsTile) - 1));
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+    CHECK(data->layers[0].name == "roads");
+
+    auto& features = data->layers[0].features;
+    REQUIRE(features.size() == 3);
+    for (auto& feature : features) { REQUIRE(feature.geometryType == GeometryType::lines); }
+
+    auto line = features[0].lines();
+    REQUIRE(line.size() == 1);
+    REQUIRE(line[0].size() == 2);
+    CHECK(line[0][0].x == Approx(0));
+    CHECK(line[0][0].y == Approx(4096 / 4095.));
+    CHECK(line[0][1].x == Approx(100 / 4095.));
+
+    // vertex deltas continue across features
+    line = features[1].lines();
+    REQUIRE(line.size() == 1);
+    REQUIRE(line[0].size() == 3);
+    CHECK(line[0][2].x == Approx(200 / 4095.));
+    CHECK(line[0][2].y == Approx((4096 - 200) / 4095.));
+
+    line = features[2].lines();
+    REQUIRE(line.size() == 1);
+    REQUIRE(line[0].size() == 2);
+    CHECK(line[0][0].x == Approx(1));
+    CHECK(line[0][1].y == Approx(1 / 4095.));
+
+    CHECK(features[0].props.getString("class") == "primary");
+    CHECK(features[1].props.getString("class") == "primary");
+    CHECK(features[2].props.getString("class") == "service");
+
+    CHECK(features[0].props.getNumber("lanes") == 2);
+    CHECK_FALSE(features[1].props.contains("lanes"));
+    CHECK(features[2].props.getNumber("lanes") == 1);
+}
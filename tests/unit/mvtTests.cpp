@@ -0,0 +1,223 @@
+#include "catch.hpp"
+
+#include "data/formats/mvt.h"
+#include "data/propertyItem.h"
+#include "tile/tileTask.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[Mvt]"
+
+static void writeVarint(std::string& _out, uint64_t _value) {
+    while (_value >= 0x80) {
+        _out += char((_value & 0x7f) | 0x80);
+        _value >>= 7;
+    }
+    _out += char(_value);
+}
+
+static void writeField(std::string& _out, uint32_t _tag, uint64_t _value) {
+    writeVarint(_out, _tag << 3);
+    writeVarint(_out, _value);
+}
+
+static void writeField(std::string& _out, uint32_t _tag, const std::string& _bytes) {
+    writeVarint(_out, (_tag << 3) | 2);
+    writeVarint(_out, _bytes.size());
+    _out += _bytes;
+}
+
+// Layer with one point feature with property "kind": @_name
+static std::string layer(const std::string& _name) {
+    std::string tags, geometry, feature, value, layer;
+
+    writeVarint(tags, 0);
+    writeVarint(tags, 0);
+    // moveTo(10, 20), zigzag encoded
+    writeVarint(geometry, (1 << 3) | 1);
+    writeVarint(geometry, 20);
+    writeVarint(geometry, 40);
+
+    writeField(feature, 2, tags);
+    writeField(feature, 3, 1);
+    writeField(feature, 4, geometry);
+
+    writeField(value, 1, _name);
+
+    // version before name, as some encoders write it
+    writeField(layer, 15, 2);
+    writeField(layer, 1, _name);
+    writeField(layer, 2, feature);
+    writeField(layer, 3, std::string("kind"));
+    writeField(layer, 4, value);
+    writeField(layer, 5, 4096);
+    return layer;
+}
+
+// Closed ring from @_points, relative to the cursor @_x, @_y
+static void writeRing(std::string& _out, int& _x, int& _y, const std::vector<std::pair<int, int>>& _points) {
+    auto zigzag = [](int _value) { return uint32_t((_value << 1) ^ (_value >> 31)); };
+    for (size_t i = 0; i < _points.size(); i++) {
+        if (i == 0) { writeVarint(_out, (1 << 3) | 1); }
+        if (i == 1) { writeVarint(_out, ((_points.size() - 1) << 3) | 2); }
+        writeVarint(_out, zigzag(_points[i].first - _x));
+        writeVarint(_out, zigzag(_points[i].second - _y));
+        _x = _points[i].first;
+        _y = _points[i].second;
+    }
+    writeVarint(_out, (1 << 3) | 7);
+}
+
+static std::shared_ptr<TileData> parse(const std::vector<std::string>& _layers,
+                                       const PropertyKeys* _propertyKeys = nullptr) {
+    std::string tile;
+    for (auto& name : { "roads", "water", "pois" }) {
+        writeField(tile, 3, layer(name));
+    }
+    BinaryTileTask task(TileID(0, 0, 0), nullptr);
+    task.rawTileData = std::make_shared<std::vector<char>>(tile.begin(), tile.end());
+    return Mvt::parseTile(task, 0, _layers, _propertyKeys);
+}
+
+TEST_CASE("Layers that are not used are skipped", TAGS) {
+    auto all = parse({});
+    REQUIRE(all);
+    REQUIRE(all->layers.size() == 3);
+
+    auto used = parse({ "pois", "water", "landuse" });
+    REQUIRE(used);
+    REQUIRE(used->layers.size() == 2);
+    CHECK(used->layers[0].name == "water");
+    CHECK(used->layers[1].name == "pois");
+    REQUIRE(used->layers[1].features.size() == 1);
+    CHECK(used->layers[1].features[0].props.getString("kind") == "pois");
+    CHECK(used->layers[1].features[0].points().size() == 1);
+
+    auto none = parse({ "landuse" });
+    REQUIRE(none);
+    CHECK(none->layers.empty());
+}
+
+TEST_CASE("Feature properties are read from the layer table until copied", TAGS) {
+    auto data = parse({});
+    REQUIRE(data);
+    auto& props = data->layers[0].features[0].props;
+
+    CHECK(props.getString("kind") == "roads");
+    CHECK(props.contains("kind"));
+    CHECK_FALSE(props.contains("class"));
+
+    Properties copy = props;
+    REQUIRE(copy.items().size() == 1);
+    CHECK(copy.items()[0].key == "kind");
+
+    copy.set("class", "minor");
+    CHECK(copy.getString("class") == "minor");
+    CHECK(copy.getString("kind") == "roads");
+    CHECK_FALSE(props.contains("class"));
+    CHECK(props.toJson() == "{\"kind\":\"roads\"}");
+}
+
+TEST_CASE("Memory usage of tile data counts the arena and each property table once", TAGS) {
+    auto data = parse({});
+    REQUIRE(data);
+    REQUIRE(data->arena);
+
+    size_t bytes = data->memoryUsage();
+    CHECK(bytes > data->arena->capacity());
+    CHECK(data->memoryUsage() == bytes);
+
+    auto& props = data->layers[0].features[0].props;
+    REQUIRE(props.table());
+    CHECK(props.memoryUsage() < props.table()->memoryUsage());
+
+    Properties copy = props;
+    CHECK(copy.table() == nullptr);
+    CHECK(copy.memoryUsage() >= sizeof(Properties::Item));
+}
+
+TEST_CASE("Properties that the scene does not read are dropped", TAGS) {
+    PropertyKeys propertyKeys;
+    propertyKeys.add("roads", { "name" }, false);
+    propertyKeys.add("water", { "name" }, false);
+    propertyKeys.add("water", {}, true);
+
+    auto data = parse({}, &propertyKeys);
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 3);
+
+    CHECK_FALSE(data->layers[0].features[0].props.contains("kind"));
+    CHECK(data->layers[0].features[0].props.items().empty());
+    // all properties are kept for layers with JS functions and for layers without keys
+    CHECK(data->layers[1].features[0].props.getString("kind") == "water");
+    CHECK(data->layers[2].features[0].props.getString("kind") == "pois");
+}
+
+TEST_CASE("Feature geometry is allocated in the arena of the tile", TAGS) {
+    auto data = parse({});
+    REQUIRE(data);
+    REQUIRE(data->arena);
+    TileArena* arena = data->arena.get();
+
+    {
+        auto& feature = data->layers[0].features[0];
+        CHECK(feature.coordinates.get_allocator().arena == arena);
+
+        // copies may outlive the tile
+        Feature copy = feature;
+        CHECK(copy.coordinates.get_allocator().arena == nullptr);
+        CHECK(copy.coordinates == feature.coordinates);
+    }
+
+    // the arena is reused for the next tile on this thread
+    data.reset();
+    auto next = parse({});
+    REQUIRE(next);
+    CHECK(next->arena.get() == arena);
+}
+
+TEST_CASE("Polygon features are read into flat geometry", TAGS) {
+    std::string geometry, feature, layer, tile;
+    int x = 0, y = 0;
+    // square with a hole, and a second square
+    writeRing(geometry, x, y, { {0, 0}, {10, 0}, {10, 10}, {0, 10} });
+    writeRing(geometry, x, y, { {2, 2}, {2, 8}, {8, 8}, {8, 2} });
+    writeRing(geometry, x, y, { {20, 0}, {30, 0}, {30, 10}, {20, 10} });
+
+    writeField(feature, 3, 3);
+    writeField(feature, 4, geometry);
+    writeField(layer, 1, std::string("buildings"));
+    writeField(layer, 2, feature);
+    writeField(layer, 5, 4096);
+    writeField(tile, 3, layer);
+
+    BinaryTileTask task(TileID(0, 0, 0), nullptr);
+    task.rawTileData = std::make_shared<std::vector<char>>(tile.begin(), tile.end());
+    auto data = Mvt::parseTile(task, 0);
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+    REQUIRE(data->layers[0].features.size() == 1);
+
+    const Feature& polygons = data->layers[0].features[0];
+    CHECK(polygons.coordinates.size() == 15);
+
+    auto view = polygons.polygons();
+    REQUIRE(view.size() == 2);
+    REQUIRE(view[0].size() == 2);
+    REQUIRE(view[1].size() == 1);
+
+    // rings are closed
+    CHECK(view[0][1].size() == 5);
+    CHECK(view[0][1].front() == view[0][1].back());
+    CHECK(view[1][0].front() == polygons.coordinates[10]);
+
+    size_t rings = 0;
+    for (auto polygon : view) {
+        for (auto ring : polygon) { rings += ring.size() == 5; }
+    }
+    CHECK(rings == 3);
+}
@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include "util/mapProjection.h"
+#include "util/normalMap.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace Tangram;
+
+static glm::vec3 unpackNormal(const std::vector<uint8_t>& _normals, int _width, int _x, int _y) {
+    const uint8_t* p = &_normals[(_y * _width + _x) * 4];
+    return glm::vec3(p[0], p[1], p[2]) / 255.f * 2.f - 1.f;
+}
+
+TEST_CASE("Normals of a slope are scaled to ground meters per row", "[Core][NormalMap]") {
+
+    const int size = 16;
+    TileID tile(300, 200, 9);
+    // Rising by 30m per pixel to the east and 10m to the north
+    std::vector<float> grid(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) { grid[y * size + x] = 30.f * x + 10.f * y; }
+    }
+
+    std::vector<uint8_t> normals(size * size * 4);
+    computeNormalMap(grid.data(), size, size, tile, {}, normals.data());
+
+    double pixel = MapProjection::metersPerTileAtZoom(tile.z) / size;
+    double south = MapProjection::tileSouthWestCorner(tile).y;
+    for (int y = 0; y < size; y++) {
+        double ground = pixel / std::cosh((south + (y + 0.5) * pixel) / MapProjection::EARTH_RADIUS_METERS);
+        glm::vec3 expected = glm::normalize(glm::vec3(-30.f / ground, -10.f / ground, 1.f));
+        // Borders are extrapolated, which is exact for a plane
+        for (int x = 0; x < size; x++) {
+            glm::vec3 n = unpackNormal(normals, size, x, y);
+            REQUIRE(n.x == Approx(expected.x).margin(1.f / 127));
+            REQUIRE(n.y == Approx(expected.y).margin(1.f / 127));
+            REQUIRE(n.z == Approx(expected.z).margin(1.f / 127));
+            REQUIRE(normals[(y * size + x) * 4 + 3] == 255);
+        }
+    }
+}
+
+TEST_CASE("Normals across tile borders use the edges of loaded neighbors", "[Core][NormalMap]") {
+
+    const int size = 8;
+    TileID west(20000, 30000, 16), east(20001, 30000, 16);
+    std::vector<float> low(size * size, 0.f), high(size * size, 500.f);
+    std::vector<uint8_t> normals(size * size * 4);
+
+    ElevationEdgeCache cache;
+    auto lowEdges = std::make_shared<const ElevationEdges>(low.data(), size, size);
+    auto neighbors = cache.add(west, lowEdges);
+    REQUIRE(!neighbors.east);
+
+    // Without neighbors the tile is flat up to its border
+    computeNormalMap(low.data(), size, size, west, neighbors, normals.data());
+    REQUIRE(unpackNormal(normals, size, size - 1, 3).z == Approx(1.f).margin(1.f / 127));
+
+    auto highEdges = std::make_shared<const ElevationEdges>(high.data(), size, size);
+    neighbors = cache.add(east, highEdges);
+    REQUIRE(neighbors.west == lowEdges);
+    REQUIRE(!neighbors.east);
+    REQUIRE(!neighbors.north);
+    REQUIRE(!neighbors.south);
+
+    // The cliff up from the western tile tilts the western column of the eastern tile
+    computeNormalMap(high.data(), size, size, east, neighbors, normals.data());
+    for (int y = 0; y < size; y++) {
+        REQUIRE(unpackNormal(normals, size, 0, y).x < -0.5f);
+        REQUIRE(unpackNormal(normals, size, 1, y).z == Approx(1.f).margin(1.f / 127));
+    }
+
+    // ... and the other way round
+    neighbors = cache.add(west, lowEdges);
+    REQUIRE(neighbors.east == highEdges);
+    computeNormalMap(low.data(), size, size, west, neighbors, normals.data());
+    REQUIRE(unpackNormal(normals, size, size - 1, 3).x < -0.5f);
+
+    // Edges are only available while held by their tile
+    highEdges.reset();
+    neighbors = {};
+    REQUIRE(!cache.add(west, lowEdges).east);
+}
+
+TEST_CASE("Neighbor edges wrap around the antimeridian", "[Core][NormalMap]") {
+
+    std::vector<float> grid(4, 1.f);
+    auto edges = std::make_shared<const ElevationEdges>(grid.data(), 2, 2);
+
+    ElevationEdgeCache cache;
+    cache.add(TileID(0, 1, 2), edges);
+    auto neighbors = cache.add(TileID(3, 1, 2), edges);
+    REQUIRE(neighbors.east == edges);
+    REQUIRE(!neighbors.west);
+
+    // No neighbors beyond the poles
+    neighbors = cache.add(TileID(0, 0, 2), edges);
+    REQUIRE(!neighbors.north);
+    REQUIRE(neighbors.south == edges);
+}
@@ -0,0 +1,59 @@
+#include "catch.hpp"
+
+#include "util/objectPool.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+struct PooledObject {
+    PooledObject(int _value, std::string _name) : value(_value), name(std::move(_name)) {}
+    int value;
+    std::string name;
+};
+
+TEST_CASE("Released objects give their blocks to new objects", "[Core][ObjectPool]") {
+
+    auto pool = std::make_shared<ObjectPool>();
+
+    auto first = pool->make<PooledObject>(1, "first");
+    REQUIRE(first->value == 1);
+    REQUIRE(first->name == "first");
+    REQUIRE(pool->allocatedBlocks() == 1);
+
+    const void* block = first.get();
+    first.reset();
+    REQUIRE(pool->pooledBlocks() == 1);
+
+    auto second = pool->make<PooledObject>(2, "second");
+    REQUIRE(second.get() == block);
+    REQUIRE(second->value == 2);
+    REQUIRE(pool->allocatedBlocks() == 1);
+    REQUIRE(pool->pooledBlocks() == 0);
+
+    // Blocks of other sizes are not taken
+    auto number = pool->make<int>(3);
+    REQUIRE(*number == 3);
+    REQUIRE(pool->allocatedBlocks() == 2);
+}
+
+TEST_CASE("Objects keep their pool alive and at most the maximum blocks are kept", "[Core][ObjectPool]") {
+
+    std::vector<std::shared_ptr<PooledObject>> objects;
+    std::weak_ptr<ObjectPool> weakPool;
+    {
+        auto pool = std::make_shared<ObjectPool>(2);
+        weakPool = pool;
+        for (int i = 0; i < 4; i++) { objects.push_back(pool->make<PooledObject>(i, "")); }
+        REQUIRE(pool->allocatedBlocks() == 4);
+    }
+    REQUIRE(!weakPool.expired());
+
+    objects.resize(1);
+    REQUIRE(weakPool.lock()->pooledBlocks() == 2);
+
+    objects.clear();
+    REQUIRE(weakPool.expired());
+}
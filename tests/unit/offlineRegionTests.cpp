@@ -0,0 +1,58 @@
+#include "catch.hpp"
+
+#include "data/offlineDownloader.h"
+
+#include <set>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[OfflineRegion]"
+
+static std::vector<TileID> allTiles(OfflineRegion& _region) {
+    std::vector<TileID> tiles;
+    TileID tile(0, 0, 0);
+    while (_region.next(tile)) { tiles.push_back(tile); }
+    return tiles;
+}
+
+TEST_CASE("Tiles of bounds are enumerated by zoom", TAGS) {
+    OfflineRegion region(OfflineRegion::boundsPolygon({ 1, 1 }, { 2, 2 }), 0, 4);
+    auto tiles = allTiles(region);
+
+    // north-east of longitude and latitude zero
+    std::vector<TileID> expected = { { 0, 0, 0 }, { 1, 0, 1 }, { 2, 1, 2 }, { 4, 3, 3 }, { 8, 7, 4 } };
+    CHECK(tiles == expected);
+    CHECK(region.count() == tiles.size());
+
+    // enumeration is repeatable
+    region.reset();
+    CHECK(allTiles(region) == tiles);
+}
+
+TEST_CASE("Tiles outside of polygon are skipped", TAGS) {
+    std::vector<LngLat> box = OfflineRegion::boundsPolygon({ -10, -10 }, { 10, 10 });
+    std::vector<LngLat> triangle = { { -10, -10 }, { 10, -10 }, { -10, 10 } };
+
+    OfflineRegion boxRegion(box, 8, 8);
+    OfflineRegion triangleRegion(triangle, 8, 8);
+
+    auto triangleTiles = allTiles(triangleRegion);
+    CHECK(triangleTiles.size() < boxRegion.count());
+
+    std::set<TileID> boxTiles;
+    for (auto& tile : allTiles(boxRegion)) { boxTiles.insert(tile); }
+    for (auto& tile : triangleTiles) { CHECK(boxTiles.count(tile) == 1); }
+
+    // north-east corner of the box is outside of the triangle
+    TileID corner(135, 120, 8);
+    CHECK(boxRegion.intersects(corner));
+    CHECK_FALSE(triangleRegion.intersects(corner));
+}
+
+TEST_CASE("Region hash identifies polygon and zoom range", TAGS) {
+    auto box = OfflineRegion::boundsPolygon({ 1, 1 }, { 2, 2 });
+    CHECK(OfflineRegion(box, 0, 4).hash() == OfflineRegion(box, 0, 4).hash());
+    CHECK(OfflineRegion(box, 0, 4).hash() != OfflineRegion(box, 0, 5).hash());
+    CHECK(OfflineRegion(box, 0, 4).hash() != OfflineRegion(OfflineRegion::boundsPolygon({ 1, 1 }, { 3, 2 }), 0, 4).hash());
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "selection/pickIndex.h"
+
+using namespace Tangram;
+
+#define TAGS "[PickIndex]"
+
+static Feature square(float _x, float _y, float _size) {
+    Feature feature;
+    feature.geometryType = GeometryType::polygons;
+    feature.beginPolygon();
+    feature.addLine(std::vector<Point>{ {_x, _y}, {_x + _size, _y}, {_x + _size, _y + _size},
+                                        {_x, _y + _size}, {_x, _y} });
+    return feature;
+}
+
+TEST_CASE("Features are picked by their geometry", TAGS) {
+    PickIndex index;
+    PickIndex::Hit hit;
+
+    Feature point;
+    point.geometryType = GeometryType::points;
+    point.addPoint({0.5f, 0.5f});
+
+    Feature line;
+    line.geometryType = GeometryType::lines;
+    line.addLine(std::vector<Point>{ {0.1f, 0.9f}, {0.9f, 0.9f} });
+
+    index.add(square(0.f, 0.f, 1.f), 1, 0);
+    index.add(square(0.2f, 0.2f, 0.2f), 2, 1);
+    index.add(point, 3, 0);
+    index.add(line, 4, 0);
+
+    // polygons contain the position, the higher order above
+    REQUIRE(index.pick({0.8f, 0.3f}, 0.01f, hit));
+    CHECK(hit.selectionColor == 1);
+    REQUIRE(index.pick({0.3f, 0.3f}, 0.01f, hit));
+    CHECK(hit.selectionColor == 2);
+
+    // points and lines within the radius, above polygons
+    REQUIRE(index.pick({0.51f, 0.5f}, 0.02f, hit));
+    CHECK(hit.selectionColor == 3);
+    CHECK(hit.distance == Approx(0.01f));
+    REQUIRE(index.pick({0.5f, 0.89f}, 0.02f, hit));
+    CHECK(hit.selectionColor == 4);
+    REQUIRE(index.pick({0.5f, 0.85f}, 0.02f, hit));
+    CHECK(hit.selectionColor == 1);
+
+    CHECK(!index.pick({1.5f, 0.5f}, 0.02f, hit));
+}
+
+TEST_CASE("Merged indices keep their geometry", TAGS) {
+    PickIndex a, b;
+    PickIndex::Hit hit;
+
+    Feature line;
+    line.geometryType = GeometryType::lines;
+    line.addLine(std::vector<Point>{ {0.f, 0.5f}, {1.f, 0.5f} });
+    a.add(line, 1, 0);
+    b.add(square(0.2f, 0.2f, 0.1f), 2, 0);
+    b.add(line, 3, 0);
+
+    a.merge(b);
+    REQUIRE(a.pick({0.25f, 0.25f}, 0.01f, hit));
+    CHECK(hit.selectionColor == 2);
+    REQUIRE(a.pick({0.5f, 0.5f}, 0.01f, hit));
+    CHECK(hit.selectionColor == 3);
+    CHECK(a.memoryUsage() > 0);
+}
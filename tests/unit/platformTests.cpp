@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include "platform.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[Platform]"
+
+// Platform that keeps requests running until respond() is called
+class DeferredPlatform : public Platform {
+public:
+    struct Transfer {
+        Url url;
+        UrlRequestHandle handle;
+        bool canceled = false;
+        float priority = 0.f;
+        int priorityUpdates = 0;
+    };
+    std::vector<Transfer> transfers;
+
+    bool startUrlRequestImpl(const Url& _url, const HttpOptions& _options,
+                             const UrlRequestHandle _request, UrlRequestId& _id) override {
+        _id = transfers.size();
+        transfers.push_back({ _url, _request, false, _options.relativePriority() });
+        return true;
+    }
+
+    void updateUrlRequestPriorityImpl(const UrlRequestId _id, float _relativePriority) override {
+        transfers[_id].priority = _relativePriority;
+        transfers[_id].priorityUpdates++;
+    }
+
+    void cancelUrlRequestImpl(const UrlRequestId _id) override {
+        transfers[_id].canceled = true;
+    }
+
+    void respond(size_t _transfer, const std::string& _content, int _status = 200) {
+        UrlResponse response;
+        response.content.assign(_content.begin(), _content.end());
+        response.status = _status;
+        onUrlResponse(transfers[_transfer].handle, std::move(response));
+    }
+};
+
+TEST_CASE("Requests for the same URL share one transfer", TAGS) {
+    DeferredPlatform platform;
+    std::vector<std::string> results;
+    auto record = [&](UrlResponse&& response) {
+        results.push_back(response.error ? response.error : std::string(response.content.begin(), response.content.end()));
+    };
+
+    auto a = platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), record);
+    auto b = platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), record);
+    platform.startUrlRequest(Url("https://some.domain/other.mvt"), HttpOptions(), record);
+    platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions("", "payload"), record);
+
+    CHECK(a != b);
+    REQUIRE(platform.transfers.size() == 3);
+    CHECK(platform.activeUrlRequests() == 3);
+
+    platform.respond(0, "tile");
+    CHECK(results == std::vector<std::string>{ "tile", "tile" });
+
+    // finished transfers are not joined
+    platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), record);
+    CHECK(platform.transfers.size() == 4);
+}
+
+TEST_CASE("Requests sharing a transfer all get its status", TAGS) {
+    DeferredPlatform platform;
+    std::vector<int> statuses;
+    auto record = [&](UrlResponse&& response) { statuses.push_back(response.status); };
+
+    platform.startUrlRequest(Url("https://some.domain/missing.mvt"), HttpOptions(), record);
+    platform.startUrlRequest(Url("https://some.domain/missing.mvt"), HttpOptions(), record);
+    REQUIRE(platform.transfers.size() == 1);
+
+    platform.respond(0, "", 404);
+    CHECK(statuses == std::vector<int>{ 404, 404 });
+}
+
+TEST_CASE("Shared transfer is canceled when all of its requests are canceled", TAGS) {
+    DeferredPlatform platform;
+    std::vector<std::string> results;
+    auto record = [&](UrlResponse&& response) {
+        results.push_back(response.error ? response.error : std::string(response.content.begin(), response.content.end()));
+    };
+
+    auto a = platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), record);
+    auto b = platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), record);
+    REQUIRE(platform.transfers.size() == 1);
+
+    platform.cancelUrlRequest(a);
+    CHECK(results == std::vector<std::string>{ Platform::cancel_message });
+    CHECK_FALSE(platform.transfers[0].canceled);
+
+    platform.cancelUrlRequest(b);
+    CHECK(results.size() == 2);
+    CHECK(platform.transfers[0].canceled);
+
+    // late response of canceled transfer is ignored
+    platform.respond(0, "tile");
+    CHECK(results.size() == 2);
+    CHECK(platform.activeUrlRequests() == 0);
+}
+
+TEST_CASE("Priority updates are passed on when they change", TAGS) {
+    DeferredPlatform platform;
+    auto ignore = [](UrlResponse&&) {};
+
+    HttpOptions low;
+    low.priority = HttpOptions::Priority::low;
+    HttpOptions high;
+    high.priority = HttpOptions::Priority::high;
+    high.weight = 1.f;
+    CHECK(low.relativePriority() < HttpOptions().relativePriority());
+    CHECK(high.relativePriority() == 1.f);
+
+    auto a = platform.startUrlRequest(Url("https://some.domain/tile.mvt"), low, ignore);
+    REQUIRE(platform.transfers.size() == 1);
+    CHECK(platform.transfers[0].priority == low.relativePriority());
+
+    platform.updateUrlRequestPriority(a, low);
+    CHECK(platform.transfers[0].priorityUpdates == 0);
+
+    platform.updateUrlRequestPriority(a, high);
+    CHECK(platform.transfers[0].priorityUpdates == 1);
+    CHECK(platform.transfers[0].priority == 1.f);
+
+    // finished requests are not updated
+    platform.respond(0, "tile");
+    platform.updateUrlRequestPriority(a, low);
+    CHECK(platform.transfers[0].priorityUpdates == 1);
+}
+
+TEST_CASE("Response observer sees the URL and response of each transfer once", TAGS) {
+    DeferredPlatform platform;
+    std::vector<std::string> observed;
+    auto ignore = [](UrlResponse&&) {};
+
+    platform.startUrlRequest(Url("https://some.domain/before.mvt"), HttpOptions(), ignore);
+    platform.setUrlResponseObserver([&](const std::string& _url, const UrlResponse& _response) {
+        observed.push_back(_url + " " + std::string(_response.content.begin(), _response.content.end()));
+    });
+    platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), ignore);
+    platform.startUrlRequest(Url("https://some.domain/tile.mvt"), HttpOptions(), ignore);
+    REQUIRE(platform.transfers.size() == 2);
+
+    // URLs are only kept for transfers started while observed
+    platform.respond(0, "before");
+    platform.respond(1, "tile");
+    CHECK(observed == std::vector<std::string>{ "https://some.domain/tile.mvt tile" });
+
+    platform.setUrlResponseObserver(nullptr);
+    platform.startUrlRequest(Url("https://some.domain/after.mvt"), HttpOptions(), ignore);
+    platform.respond(2, "after");
+    CHECK(observed.size() == 1);
+}
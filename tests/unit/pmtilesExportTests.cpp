@@ -0,0 +1,102 @@
+#include "catch.hpp"
+
+#include "data/mbtilesDataSource.h"
+#include "data/pmtilesDataSource.h"
+#include "mockPlatform.h"
+#include "scene/scene.h"
+#include "tile/tileTask.h"
+
+#include "pmtiles/pmtiles.hpp"
+#include "rapidjson/document.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[PMTilesExport]"
+
+static const char* cachePath = "pmtilesExportTest.mbtiles";
+static const char* archivePath = "pmtilesExportTest.pmtiles";
+
+static void storeTile(MBTilesDataSource& _cache, TileID _tileId, const std::string& _data) {
+    _cache.storeOfflineTile(_tileId, std::make_shared<std::vector<char>>(_data.begin(), _data.end()), 1);
+}
+
+static std::string loadTile(PMTilesDataSource& _source, const std::shared_ptr<ScenePrana>& _prana, TileID _tileId) {
+    auto task = std::make_shared<BinaryTileTask>(_tileId, nullptr);
+    task->setScenePrana(_prana);
+    std::promise<void> loaded;
+    auto done = loaded.get_future();
+    _source.loadTileData(task, {[&](std::shared_ptr<TileTask>) { loaded.set_value(); }});
+    REQUIRE(done.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+    if (!task->rawTileData) { return ""; }
+    return std::string(task->rawTileData->begin(), task->rawTileData->end());
+}
+
+TEST_CASE("Exported PMTiles archive holds tiles and metadata of the cache", TAGS) {
+    std::remove(cachePath);
+    std::remove(archivePath);
+
+    MockPlatform platform;
+    {
+        MBTilesDataSource cache(platform, "cache", cachePath, "pbf", 3600);
+        REQUIRE(cache.isCache());
+
+        storeTile(cache, TileID(1, 2, 3), "tile 1/2/3");
+        storeTile(cache, TileID(2, 4, 4), "tile 2/4/4");
+        storeTile(cache, TileID(3, 5, 4), "tile 3/5/4");
+        // same data as 2/4/4, stored once in the archive
+        storeTile(cache, TileID(2, 5, 4), "tile 2/4/4");
+        REQUIRE(cache.flushTiles());
+
+        cache.setMetadata("name", "export test");
+        cache.setMetadata("json", R"({"vector_layers":[{"id":"roads","fields":{}}]})");
+
+        REQUIRE(cache.exportPMTiles(archivePath));
+    }
+
+    std::ifstream file(archivePath, std::ifstream::binary);
+    std::string archive((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    REQUIRE(archive.size() > 127);
+
+    auto header = pmtiles::deserialize_header(archive.substr(0, 127));
+    CHECK(int(header.min_zoom) == 3);
+    CHECK(int(header.max_zoom) == 4);
+    CHECK(header.addressed_tiles_count == 4);
+    CHECK(header.tile_contents_count == 3);
+    // tiles x 2..3, y 4..5 at zoom 4
+    CHECK(header.min_lon_e7 / 1e7 == Approx(-135.0));
+    CHECK(header.max_lon_e7 / 1e7 == Approx(-90.0));
+    CHECK(header.max_lat_e7 / 1e7 == Approx(66.5133).epsilon(1e-4));
+    CHECK(header.min_lat_e7 / 1e7 == Approx(40.9799).epsilon(1e-4));
+
+    rapidjson::Document metadata;
+    metadata.Parse(archive.data() + header.json_metadata_offset, header.json_metadata_bytes);
+    REQUIRE(metadata.IsObject());
+    CHECK(std::string(metadata["name"].GetString()) == "export test");
+    // the MBTiles json row is merged into the root object
+    CHECK_FALSE(metadata.HasMember("json"));
+    REQUIRE(metadata.HasMember("vector_layers"));
+    REQUIRE(metadata["vector_layers"].IsArray());
+    CHECK(std::string(metadata["vector_layers"][0]["id"].GetString()) == "roads");
+    CHECK_FALSE(metadata.HasMember("compression"));
+
+    {
+        PMTilesDataSource source(platform, archivePath);
+        auto prana = std::make_shared<ScenePrana>(nullptr);
+        CHECK(loadTile(source, prana, TileID(1, 2, 3)) == "tile 1/2/3");
+        CHECK(loadTile(source, prana, TileID(2, 4, 4)) == "tile 2/4/4");
+        CHECK(loadTile(source, prana, TileID(3, 5, 4)) == "tile 3/5/4");
+        CHECK(loadTile(source, prana, TileID(2, 5, 4)) == "tile 2/4/4");
+        CHECK(loadTile(source, prana, TileID(0, 0, 4)) == "");
+    }
+
+    std::remove(cachePath);
+    std::remove(archivePath);
+}
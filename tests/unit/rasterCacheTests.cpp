@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include "data/rasterCache.h"
+#include "gl/texture.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+// RGBA texture of @_size x @_size pixels, i.e. 4 * size * size bytes
+static std::unique_ptr<Texture> makeTexture(int _size) {
+    std::vector<uint8_t> data(_size * _size * 4, 0);
+    auto tex = std::make_unique<Texture>(TextureOptions(), false);
+    tex->setPixelData(_size, _size, 4, data.data(), data.size());
+    return tex;
+}
+
+TEST_CASE("Raster cache keeps textures in use and the most recent unused ones", "[Core][RasterCache]") {
+
+    RasterCache cache(2 * 1024);
+
+    auto a = cache.put(TileID(1, 1, 5), makeTexture(16));
+    auto b = cache.put(TileID(2, 1, 5), makeTexture(16));
+    REQUIRE(cache.bytes() == 2 * 1024);
+    // Keyed without the styling zoom
+    REQUIRE(cache.get(TileID(1, 1, 5, 7)) == a);
+
+    // Only unused textures count against the budget
+    auto c = cache.put(TileID(3, 1, 5), makeTexture(16));
+    REQUIRE(cache.size() == 3);
+
+    a.reset();
+    b.reset();
+    c.reset();
+    REQUIRE(cache.get(TileID(1, 1, 5)));
+    cache.put(TileID(4, 1, 5), makeTexture(16));
+
+    // (2, 1) was least recently used
+    REQUIRE(cache.size() == 3);
+    REQUIRE(!cache.get(TileID(2, 1, 5)));
+    REQUIRE(cache.bytes() == 3 * 1024);
+
+    int minZoom = 0, maxZoom = 0;
+    auto d = cache.put(TileID(8, 2, 6), makeTexture(16));
+    REQUIRE(cache.zoomRange(minZoom, maxZoom));
+    REQUIRE(minZoom == 5);
+    REQUIRE(maxZoom == 6);
+
+    // ... then (3, 1)
+    REQUIRE(cache.size() == 3);
+    REQUIRE(!cache.get(TileID(3, 1, 5)));
+
+    cache.trim(0);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.get(TileID(8, 2, 6)) == d);
+}
+
+TEST_CASE("Raster cache keeps the first texture added for a tile", "[Core][RasterCache]") {
+
+    RasterCache cache;
+    bool added = false;
+    auto first = cache.put(TileID(1, 1, 5), makeTexture(4), &added);
+    REQUIRE(added);
+    auto second = cache.put(TileID(1, 1, 5), makeTexture(4), &added);
+    REQUIRE(!added);
+    REQUIRE(second == first);
+    REQUIRE(cache.bytes() == 64);
+}
+
+TEST_CASE("Raster cache decodes a tile once for concurrent requests", "[Core][RasterCache]") {
+
+    RasterCache cache;
+    TileID tile(10, 20, 8);
+
+    bool claimed = false;
+    REQUIRE(!cache.acquire(tile, claimed));
+    REQUIRE(claimed);
+    // Not available until decoded
+    REQUIRE(!cache.get(tile));
+
+    std::atomic<int> claims{0};
+    std::vector<std::shared_ptr<Texture>> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); i++) {
+        threads.emplace_back([&, i]() {
+            bool c = false;
+            results[i] = cache.acquire(tile, c);
+            if (c) { claims++; }
+        });
+    }
+
+    auto texture = cache.put(tile, makeTexture(4));
+    for (auto& thread : threads) { thread.join(); }
+
+    REQUIRE(claims == 0);
+    for (auto& result : results) { REQUIRE(result == texture); }
+
+    // Waiting threads get nothing when decoding fails
+    TileID other(11, 20, 8);
+    REQUIRE(!cache.acquire(other, claimed));
+    REQUIRE(claimed);
+    std::shared_ptr<Texture> result = texture;
+    std::thread waiting([&]() {
+        bool c = false;
+        result = cache.acquire(other, c);
+    });
+    // The waiting thread may also come after the claim is dropped and claim the tile itself
+    cache.cancel(other);
+    waiting.join();
+    REQUIRE(!result);
+}
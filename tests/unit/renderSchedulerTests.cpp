@@ -0,0 +1,45 @@
+#include "catch.hpp"
+
+#include "mockPlatform.h"
+#include "util/renderScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace Tangram;
+
+#define TAGS "[RenderScheduler]"
+
+class CountingPlatform : public MockPlatform {
+public:
+    void requestRender() const override { requests++; }
+    mutable std::atomic<int> requests{0};
+};
+
+TEST_CASE("Requests pass through without interval", TAGS) {
+    CountingPlatform platform;
+    RenderScheduler scheduler(platform);
+
+    for (int i = 0; i < 5; i++) { scheduler.requestRender(); }
+    CHECK(platform.requests == 5);
+}
+
+TEST_CASE("Requests within the interval are merged into one at its end", TAGS) {
+    CountingPlatform platform;
+    RenderScheduler scheduler(platform);
+    scheduler.setInterval(0.05f);
+
+    scheduler.requestRender();
+    CHECK(platform.requests == 1);
+
+    for (int i = 0; i < 10; i++) { scheduler.requestRender(); }
+    CHECK(platform.requests == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    CHECK(platform.requests == 2);
+
+    // Passed through again once the interval is over
+    scheduler.requestRender();
+    CHECK(platform.requests == 3);
+}
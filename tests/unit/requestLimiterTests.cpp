@@ -0,0 +1,131 @@
+#include "catch.hpp"
+
+#include "data/requestLimiter.h"
+#include "tile/tileTask.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[RequestLimiter]"
+
+using Clock = RequestLimiter::Clock;
+
+static std::shared_ptr<TileTask> tileTask(double _priority, bool _prefetch = false) {
+    auto task = std::make_shared<TileTask>(TileID(0, 0, 0), nullptr);
+    task->setPriority(_priority);
+    task->setPrefetchState(_prefetch);
+    return task;
+}
+
+TEST_CASE("Requests over the limit are started by priority", TAGS) {
+    RequestLimiter limiter("test.host");
+    std::vector<int> started;
+    auto start = [&](int _id) {
+        return [&, _id]() { started.push_back(_id); return true; };
+    };
+
+    int limit = int(limiter.stats().limit);
+    for (int i = 0; i < limit; i++) {
+        limiter.request(nullptr, tileTask(0), start(i));
+    }
+    CHECK(started.size() == size_t(limit));
+
+    auto prefetch = tileTask(0, true);
+    auto low = tileTask(5);
+    auto high = tileTask(1);
+    auto canceled = tileTask(0);
+    auto removed = tileTask(0);
+    limiter.request(nullptr, prefetch, start(100));
+    limiter.request(nullptr, low, start(101));
+    limiter.request(nullptr, high, start(102));
+    limiter.request(nullptr, canceled, start(103));
+    limiter.request(nullptr, removed, start(104));
+    canceled->cancel();
+
+    CHECK(limiter.stats().queued == 5);
+    CHECK(limiter.cancel(*removed));
+    CHECK_FALSE(limiter.cancel(*removed));
+
+    auto now = Clock::now();
+    for (int i = 0; i < 3; i++) {
+        limiter.finish(now, 0, false);
+    }
+
+    REQUIRE(started.size() == size_t(limit + 3));
+    CHECK(started[limit] == 102);
+    CHECK(started[limit + 1] == 101);
+    CHECK(started[limit + 2] == 100);
+
+    auto stats = limiter.stats();
+    CHECK(stats.active == limit);
+    CHECK(stats.queued == 0);
+}
+
+TEST_CASE("Canceling the requests of an owner waits for those being started", TAGS) {
+    RequestLimiter limiter("test.host");
+    int owner = 0;
+
+    int limit = int(limiter.stats().limit);
+    for (int i = 0; i < limit; i++) {
+        limiter.request(nullptr, tileTask(0), []() { return true; });
+    }
+
+    std::atomic<bool> starting{false};
+    std::atomic<bool> release{false};
+    std::atomic<bool> startDone{false};
+    limiter.request(&owner, tileTask(0), [&]() {
+        starting = true;
+        while (!release) { std::this_thread::yield(); }
+        startDone = true;
+        return true;
+    });
+
+    std::thread finisher([&]() { limiter.finish(Clock::now(), 0, false); });
+    while (!starting) { std::this_thread::yield(); }
+
+    std::atomic<bool> canceled{false};
+    bool doneWhenCanceled = false;
+    std::thread canceler([&]() {
+        limiter.cancel(&owner);
+        doneWhenCanceled = startDone;
+        canceled = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    CHECK_FALSE(canceled);
+    release = true;
+
+    finisher.join();
+    canceler.join();
+    CHECK(doneWhenCanceled);
+}
+
+TEST_CASE("Limit grows with fast responses and shrinks when responses are delayed", TAGS) {
+    RequestLimiter limiter("test.host");
+    auto start = []() { return true; };
+
+    float initial = limiter.stats().limit;
+    int queued = 4;
+    for (int i = 0; i < int(initial) + queued; i++) {
+        limiter.request(nullptr, tileTask(0), start);
+    }
+    auto t0 = Clock::now();
+
+    // limit reached, responses in 100ms
+    for (int i = 0; i < 2; i++) {
+        limiter.finish(t0 + std::chrono::milliseconds(200), 10000, true,
+                       t0 + std::chrono::milliseconds(300));
+    }
+    CHECK(limiter.stats().limit == initial + 1);
+
+    // responses take ten times longer at lower throughput
+    for (int i = 0; i < 2; i++) {
+        limiter.finish(t0 + std::chrono::milliseconds(500), 10000, true,
+                       t0 + std::chrono::milliseconds(1500));
+    }
+    CHECK(limiter.stats().limit < initial);
+}
@@ -0,0 +1,69 @@
+#include "catch.hpp"
+
+#include "util/resolutionScaler.h"
+
+using namespace Tangram;
+
+#define TAGS "[ResolutionScaler]"
+
+static const float BUDGET = 1.f / 60.f;
+
+static float run(ResolutionScaler& scaler, int frames, float frameTime, bool moving = true) {
+    float scale = scaler.scale();
+    for (int i = 0; i < frames; i++) { scale = scaler.update(frameTime, moving); }
+    return scale;
+}
+
+TEST_CASE("Scale stays at 1 when disabled or within budget", TAGS) {
+    ResolutionScaler scaler;
+    CHECK(!scaler.enabled());
+    CHECK(run(scaler, 20, 0.1f) == 1.f);
+
+    scaler.setBudget(BUDGET, 0.5f);
+    CHECK(scaler.enabled());
+    CHECK(run(scaler, 100, BUDGET) == 1.f);
+}
+
+TEST_CASE("Scale is lowered by the ratio of frame time and budget", TAGS) {
+    ResolutionScaler scaler;
+    scaler.setBudget(BUDGET, 0.25f);
+
+    // twice the budget halves the area
+    CHECK(run(scaler, 4, 2.f * BUDGET) == Approx(0.7f));
+
+    // frames bound by fill rate settle within the budget
+    scaler.setBudget(BUDGET, 0.25f);
+    for (int i = 0; i < 200; i++) {
+        float scale = scaler.scale();
+        scaler.update(2.f * BUDGET * scale * scale, true);
+    }
+    CHECK(scaler.scale() >= 0.7f);
+    CHECK(scaler.scale() <= 0.75f);
+
+    // not below the minimum
+    scaler.setBudget(BUDGET, 0.5f);
+    CHECK(run(scaler, 100, 3.5f * BUDGET) == Approx(0.5f));
+}
+
+TEST_CASE("Scale returns to 1 when the view is idle", TAGS) {
+    ResolutionScaler scaler;
+    scaler.setBudget(BUDGET, 0.5f);
+
+    REQUIRE(run(scaler, 10, 2.f * BUDGET) < 1.f);
+    CHECK(scaler.update(2.f * BUDGET, false) == 1.f);
+}
+
+TEST_CASE("Scale is raised in steps within budget", TAGS) {
+    ResolutionScaler scaler;
+    scaler.setBudget(BUDGET, 0.5f);
+
+    float low = run(scaler, 10, 2.f * BUDGET);
+    REQUIRE(low < 1.f);
+
+    // pauses between frames are not frame times
+    CHECK(run(scaler, 100, 1.f) == low);
+
+    float raised = run(scaler, 40, BUDGET);
+    CHECK(raised == Approx(low + ResolutionScaler::SCALE_STEP));
+    CHECK(run(scaler, 1000, BUDGET) == 1.f);
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "gl/retainedData.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[RetainedData]"
+
+static std::vector<uint16_t> testData(size_t _count) {
+    std::vector<uint16_t> data(_count);
+    for (size_t i = 0; i < _count; i++) { data[i] = uint16_t(i * 7 % 1000); }
+    return data;
+}
+
+TEST_CASE("Retained data is restored as it was stored", TAGS) {
+    RetainedData::setBudget(1 << 20);
+    auto data = testData(4096);
+
+    RetainedData retained;
+    REQUIRE(retained.store(data.data(), data.size() * sizeof(uint16_t)));
+    CHECK(bool(retained));
+    CHECK(retained.size() == data.size() * sizeof(uint16_t));
+    CHECK(RetainedData::usage() > 0);
+    CHECK(RetainedData::usage() < retained.size());
+
+    std::vector<uint16_t> restored(data.size());
+    REQUIRE(retained.restore(restored.data()));
+    CHECK(restored == data);
+
+    retained.clear();
+    CHECK_FALSE(bool(retained));
+    CHECK(RetainedData::usage() == 0);
+
+    RetainedData::setBudget(0);
+}
+
+TEST_CASE("Retained data stays within the budget", TAGS) {
+    auto data = testData(4096);
+    size_t size = data.size() * sizeof(uint16_t);
+
+    // Disabled without a budget
+    RetainedData::setBudget(0);
+    RetainedData disabled;
+    CHECK_FALSE(disabled.store(data.data(), size));
+    CHECK_FALSE(bool(disabled));
+
+    RetainedData::setBudget(1 << 20);
+    RetainedData first;
+    REQUIRE(first.store(data.data(), size));
+    size_t compressed = RetainedData::usage();
+
+    // Room for one copy only
+    RetainedData::setBudget(compressed + compressed / 2);
+    RetainedData second;
+    CHECK_FALSE(second.store(data.data(), size));
+    CHECK(RetainedData::usage() == compressed);
+
+    {
+        RetainedData::setBudget(2 * compressed);
+        RetainedData third;
+        CHECK(third.store(data.data(), size));
+        CHECK(RetainedData::usage() == 2 * compressed);
+    }
+    // Released with the copy
+    CHECK(RetainedData::usage() == compressed);
+
+    first.clear();
+    RetainedData::setBudget(0);
+}
@@ -2,8 +2,11 @@
 
 #include "mockPlatform.h"
 #include "scene/importer.h"
+#include "scene/sceneSnapshot.h"
 #include "scene/scene.h"
+#include "util/zipArchive.h"
 
+#include <cstdio>
 #include <iostream>
 #include <vector>
 
@@ -315,3 +318,117 @@ TEST_CASE("Scenes imported more than once are not mutated", "[import][core]") {
 
     CHECK(root["key"].Scalar() == "value_a");
 }
+
+TEST_CASE("Font and texture URLs are requested while importing", "[import][core]") {
+    ImportMockPlatform platform;
+    platform.putMockUrlContents(Url("/root/path/to/texture.png"), "texture");
+    platform.putMockUrlContents(Url("/root/imports/fonts/0.ttf"), "font");
+
+    Importer importer;
+    auto root = importer.loadSceneData(platform, Url("/root/urls.yaml"));
+
+    // Mock contents are changed after import: prefetched resources keep the earlier contents.
+    platform.putMockUrlContents(Url("/root/path/to/texture.png"), "changed");
+    platform.putMockUrlContents(Url("/root/imports/fonts/0.ttf"), "changed");
+
+    auto readResource = [&](const std::string& url) {
+        std::string content;
+        importer.readResource(Url(url), [&](UrlResponse&& response) {
+            if (!response.error) { content.assign(response.content.begin(), response.content.end()); }
+        });
+        return content;
+    };
+
+    CHECK(readResource(root["textures"]["tex1"]["url"].Scalar()) == "texture");
+    CHECK(readResource(root["fonts"]["fontB"][0]["url"].Scalar()) == "font");
+
+    // A prefetched response is handed out once, later requests go to the platform.
+    CHECK(readResource("/root/path/to/texture.png") == "changed");
+}
+
+TEST_CASE("Scene snapshots encode the merged config", "[import][core]") {
+    ImportMockPlatform platform;
+    Importer importer;
+    auto root = importer.loadSceneData(platform, Url("/root/urls.yaml"));
+
+    std::vector<char> data;
+    SceneSnapshot::encode(root, data);
+
+    YAML::Node decoded;
+    const char* pos = data.data();
+    REQUIRE(SceneSnapshot::decode(pos, data.data() + data.size(), decoded));
+    CHECK(pos == data.data() + data.size());
+    CHECK(YAML::Dump(decoded) == YAML::Dump(root));
+
+    // Truncated data is rejected
+    pos = data.data();
+    CHECK_FALSE(SceneSnapshot::decode(pos, data.data() + data.size() - 1, decoded));
+}
+
+TEST_CASE("Scene snapshots are used while their scene files are unchanged", "[import][core]") {
+    ImportMockPlatform platform;
+    std::vector<SceneSnapshot::Source> sources;
+    {
+        Importer importer;
+        importer.loadSceneData(platform, Url("/root/c.yaml"));
+        REQUIRE(importer.getSceneSources(sources));
+        CHECK(sources.size() == 3);
+    }
+    {
+        Importer importer;
+        CHECK(importer.checkSceneSources(platform, sources));
+    }
+
+    platform.putMockUrlContents(Url("/root/b.yaml"), "value: changed");
+    {
+        Importer importer;
+        CHECK_FALSE(importer.checkSceneSources(platform, sources));
+    }
+
+    // Scenes with files that could not be read are not snapshot
+    {
+        Importer importer;
+        platform.putMockUrlContents(Url("/root/missing.yaml"), "import: not_there.yaml");
+        importer.loadSceneData(platform, Url("/root/missing.yaml"));
+        CHECK_FALSE(importer.getSceneSources(sources));
+    }
+}
+
+TEST_CASE("Zip archives are mapped from files and serve stored entries in place", "[import][core]") {
+    std::string path = "scene_bundle_test.zip";
+    std::string yaml = "value: zipped\n";
+    std::string sprite(4096, 's');
+    {
+        mz_zip_archive writer;
+        mz_zip_zero_struct(&writer);
+        REQUIRE(mz_zip_writer_init_file(&writer, path.c_str(), 0));
+        REQUIRE(mz_zip_writer_add_mem(&writer, "scene.yaml", yaml.data(), yaml.size(), MZ_NO_COMPRESSION));
+        REQUIRE(mz_zip_writer_add_mem(&writer, "img/sprite.png", sprite.data(), sprite.size(), MZ_BEST_COMPRESSION));
+        REQUIRE(mz_zip_writer_finalize_archive(&writer));
+        mz_zip_writer_end(&writer);
+    }
+
+    ZipArchive archive;
+    REQUIRE(archive.loadFromFile(path));
+    REQUIRE(archive.entries().size() == 2);
+
+    auto stored = archive.findEntry("scene.yaml");
+    REQUIRE(stored);
+    CHECK(stored->stored);
+    const char* data = archive.entryData(stored);
+    REQUIRE(data);
+    CHECK(std::string(data, stored->uncompressedSize) == yaml);
+
+    auto deflated = archive.findEntry("img/sprite.png");
+    REQUIRE(deflated);
+    CHECK_FALSE(deflated->stored);
+    CHECK(archive.entryData(deflated) == nullptr);
+    std::vector<char> inflated(deflated->uncompressedSize);
+    REQUIRE(archive.decompressEntry(deflated, inflated.data()));
+    CHECK(std::string(inflated.begin(), inflated.end()) == sprite);
+
+    CHECK(archive.findEntry("missing.png") == nullptr);
+
+    archive.reset();
+    std::remove(path.c_str());
+}
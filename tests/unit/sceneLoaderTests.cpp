@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include "mockPlatform.h"
+#include "gl/shaderSource.h"
 #include "scene/pointLight.h"
 #include "scene/scene.h"
 #include "scene/sceneLoader.h"
@@ -49,6 +50,46 @@ TEST_CASE("Correctly instantiate a style from a YAML configuration") {
     REQUIRE(styles[2]->getMaterial().hasSpecular() == false);
 }
 
+TEST_CASE("Materials without textures are folded into the shader") {
+
+    YAML::Node node = YAML::Load(R"END(
+        base: polygons
+        material:
+            diffuse: .5
+            specular: 1
+            shininess: 2
+        )END");
+
+    SceneTextures textures;
+    auto style = SceneLoader::loadStyle("buildings", node);
+    SceneLoader::loadStyleProps(node, *style, textures);
+
+    ShaderSource source;
+    REQUIRE(style->getMaterial().injectOnProgram(source) == nullptr);
+
+    auto& blocks = source.getSourceBlocks();
+    REQUIRE(blocks.at("defines").back() == "#define TANGRAM_MATERIAL_CONSTANT\n");
+    REQUIRE(blocks.at("setup").size() == 1);
+    CHECK(blocks.at("setup")[0] ==
+          "material = Material(vec4(0.5,0.5,0.5,1.0), vec4(1.0,1.0,1.0,1.0), 2.0);");
+}
+
+TEST_CASE("Parse the depth pre-pass style parameter") {
+
+    YAML::Node node = YAML::Load(R"END(
+        base: polygons
+        depth_prepass: true
+        )END");
+
+    SceneTextures textures;
+    auto style = SceneLoader::loadStyle("buildings", node);
+    REQUIRE(style != nullptr);
+    REQUIRE(style->depthPrepass() == false);
+
+    SceneLoader::loadStyleProps(node, *style, textures);
+    REQUIRE(style->depthPrepass() == true);
+}
+
 TEST_CASE("Test light parameter parsing") {
     YAML::Node node = YAML::Load("position: [100px, 0, 20m]");
 
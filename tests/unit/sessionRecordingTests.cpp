@@ -0,0 +1,93 @@
+#include "catch.hpp"
+
+#include "debug/sessionRecording.h"
+#include "platform.h"
+
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[SessionRecording]"
+
+static UrlResponse response(const std::string& _content, const char* _error = nullptr) {
+    UrlResponse result;
+    result.content.assign(_content.begin(), _content.end());
+    result.error = _error;
+    return result;
+}
+
+static std::string content(const UrlResponse& _response) {
+    return std::string(_response.content.begin(), _response.content.end());
+}
+
+TEST_CASE("Session recording reads back what it wrote", TAGS) {
+    SessionRecording recording;
+
+    // nothing is added before start()
+    recording.addFrame(1.f);
+    recording.addCall("setZoom", { 2 });
+    CHECK(recording.frames.empty());
+    CHECK(recording.calls.empty());
+
+    recording.start();
+    recording.addCall("loadScene", { 0, 1 }, { "file:///scene.yaml", "", "global.a", "line\nbreak" });
+    recording.addFrame(0.016f);
+    recording.addCall("setCameraPosition", { -74.00976419448854, 40.70532700869127, 16.5, 0.25, 0.5 });
+    recording.addResponse("https://tiles/0/0/0.mvt", response(std::string("\0binary\n\0", 9)));
+    recording.addResponse("https://tiles/1/0/0.mvt", response("", "Not found"));
+    recording.addResponse("https://tiles/1/1/0.mvt", response("", Platform::cancel_message));
+    recording.addFrame(0.033f);
+
+    std::string data = recording.stop();
+    recording.addFrame(1.f);
+
+    SessionRecording loaded;
+    REQUIRE(loaded.load(data));
+
+    CHECK(loaded.frames == std::vector<float>{ 0.016f, 0.033f });
+
+    REQUIRE(loaded.calls.size() == 2);
+    CHECK(loaded.calls[0].frame == 0);
+    CHECK(loaded.calls[0].name == "loadScene");
+    CHECK(loaded.calls[0].numbers == std::vector<double>{ 0, 1 });
+    CHECK(loaded.calls[0].strings == std::vector<std::string>{ "file:///scene.yaml", "", "global.a", "line\nbreak" });
+    CHECK(loaded.calls[1].frame == 1);
+    CHECK(loaded.calls[1].numbers[0] == -74.00976419448854);
+    CHECK(loaded.calls[1].numbers[1] == 40.70532700869127);
+
+    // canceled requests are not recorded
+    REQUIRE(loaded.responses.size() == 2);
+    CHECK(loaded.responses[0].url == "https://tiles/0/0/0.mvt");
+    CHECK(loaded.responses[0].content == std::vector<char>{ '\0', 'b', 'i', 'n', 'a', 'r', 'y', '\n', '\0' });
+    CHECK(loaded.responses[0].error.empty());
+    CHECK(loaded.responses[1].error == "Not found");
+
+    CHECK_FALSE(loaded.load("not a session"));
+    CHECK_FALSE(loaded.load(data.substr(0, data.size() - 4)));
+}
+
+TEST_CASE("Session player serves the responses of a URL in order and repeats the last", TAGS) {
+    SessionRecording recording;
+    recording.start();
+    recording.addResponse("https://style/scene.yaml", response("first"));
+    recording.addResponse("https://tiles/0/0/0.mvt", response("", "Not found"));
+    recording.addResponse("https://style/scene.yaml", response("second"));
+
+    SessionPlayer player(recording);
+    UrlResponse result;
+
+    REQUIRE(player.response("https://style/scene.yaml", result));
+    CHECK(content(result) == "first");
+    CHECK(result.error == nullptr);
+    REQUIRE(player.response("https://style/scene.yaml", result));
+    CHECK(content(result) == "second");
+    REQUIRE(player.response("https://style/scene.yaml", result));
+    CHECK(content(result) == "second");
+
+    REQUIRE(player.response("https://tiles/0/0/0.mvt", result));
+    CHECK(result.content.empty());
+    CHECK(std::string(result.error) == "Not found");
+
+    CHECK_FALSE(player.response("https://tiles/1/0/0.mvt", result));
+}
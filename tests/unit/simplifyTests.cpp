@@ -0,0 +1,54 @@
+#include "catch.hpp"
+
+#include "util/simplify.h"
+
+using namespace Tangram;
+
+TEST_CASE("Simplify a line within the tolerance", "[Core][Simplify]") {
+
+    GeometrySimplifier simplifier;
+    std::vector<Point> line = { {0.f, 0.f}, {0.25f, 0.001f}, {0.5f, 0.f}, {0.75f, 0.2f}, {1.f, 0.f} };
+
+    // Disabled by default
+    auto view = simplifier.simplify(LineView(line));
+    REQUIRE(view.data() == line.data());
+    REQUIRE(view.size() == 5);
+
+    simplifier.setTolerance(0.01f);
+    view = simplifier.simplify(LineView(line));
+
+    REQUIRE(view.size() == 4);
+    REQUIRE(view[0] == line[0]);
+    REQUIRE(view[1] == line[2]);
+    REQUIRE(view[2] == line[3]);
+    REQUIRE(view[3] == line[4]);
+
+    // Nothing to remove
+    simplifier.setTolerance(0.0001f);
+    view = simplifier.simplify(LineView(line));
+    REQUIRE(view.data() == line.data());
+}
+
+TEST_CASE("Simplify polygon rings without collapsing them", "[Core][Simplify]") {
+
+    GeometrySimplifier simplifier;
+    simplifier.setTolerance(0.01f);
+
+    Feature feature;
+    feature.addPolygon({
+        // Square with a point close to its bottom edge
+        { {0.f, 0.f}, {0.5f, 0.001f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}, {0.f, 0.f} },
+        // Hole smaller than the tolerance
+        { {0.5f, 0.5f}, {0.5f, 0.505f}, {0.505f, 0.505f}, {0.505f, 0.5f}, {0.5f, 0.5f} },
+    });
+
+    auto polygon = simplifier.simplify(feature.polygons()[0]);
+
+    REQUIRE(polygon.size() == 2);
+    REQUIRE(polygon[0].size() == 5);
+    REQUIRE(polygon[0][1] == Point(1.f, 0.f));
+
+    // The hole would collapse and is kept as is
+    REQUIRE(polygon[1].size() == 5);
+    REQUIRE(polygon[1][1] == Point(0.5f, 0.505f));
+}
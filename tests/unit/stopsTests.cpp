@@ -323,3 +323,31 @@ TEST_CASE("Stops using `%` and auto for StyleParam::size", "[Stops][YAML]") {
     val = stops.evalSize(18, CSS_SIZE);
     REQUIRE(glm::all(glm::epsilonEqual(val, glm::vec2(40.f, 20.f), EPSILON)));
 }
+
+TEST_CASE("StopsCache keeps values of stops for one zoom", "[Stops]") {
+
+    Stops a({ Stops::Frame(0, 0.f), Stops::Frame(10, 10.f) });
+    a.index = 0;
+    Stops b({ Stops::Frame(0, 5.f), Stops::Frame(10, 15.f) });
+    b.index = 1;
+    // stops of another list in the same slot
+    Stops c({ Stops::Frame(0, 1.f) });
+    c.index = 1;
+
+    StopsCache<float> cache;
+    cache.setZoom(4);
+
+    REQUIRE(cache.find(a) == nullptr);
+    cache.insert(a, a.evalFloat(4));
+    cache.insert(b, b.evalFloat(4));
+    REQUIRE(*cache.find(a) == 4.f);
+    REQUIRE(*cache.find(b) == 9.f);
+    REQUIRE(cache.find(c) == nullptr);
+
+    cache.setZoom(4);
+    REQUIRE(*cache.find(a) == 4.f);
+
+    cache.setZoom(5);
+    REQUIRE(cache.find(a) == nullptr);
+    REQUIRE(cache.find(b) == nullptr);
+}
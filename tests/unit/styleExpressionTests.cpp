@@ -0,0 +1,221 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "data/tileData.h"
+#include "js/JavaScript.h"
+#include "scene/filters.h"
+#include "scene/styleContext.h"
+#include "scene/styleExpression.h"
+
+#include <cmath>
+
+using namespace Tangram;
+
+using Result = StyleExpression::Result;
+
+TEST_CASE("Style expressions compile common forms of JS functions", "[StyleExpression]") {
+    std::vector<std::string> compiled = {
+        "function() { return feature.height * 2 || 10; }",
+        "function() { return feature['name:en'] + ' (' + feature.kind + ')'; }",
+        "function() { return $zoom > 10 && feature.scalerank < 5; }",
+        "function() { if (feature.kind === 'road') { return 1; } else if (feature.kind == 'path') return 2; return 3; }",
+        "function () {\n    return (feature.scalerank * .5) <= ($zoom - 4); // comment\n}",
+        "function() { return Math.min(feature.height, Math.pow(2, $zoom)); }",
+        "function() { }",
+    };
+    for (const auto& source : compiled) {
+        INFO(source);
+        REQUIRE(StyleExpression::compile(source));
+    }
+
+    std::vector<std::string> rejected = {
+        "function() { return global.x; }",
+        "function() { var a = 1; return a; }",
+        "function() { return feature.name.length; }",
+        "function() { return feature['name:' + language]; }",
+        "function() { return [1, 2]; }",
+        "function() { return feature.a = 1; }",
+        "function() { return 010; }",
+        "function() { return Math.log(2); }",
+        "function() { return 1 & 2; }",
+        "function foo() { return 1; }",
+    };
+    for (const auto& source : rejected) {
+        INFO(source);
+        REQUIRE(!StyleExpression::compile(source));
+    }
+}
+
+TEST_CASE("Style expressions evaluate like the JS engine", "[StyleExpression]") {
+    std::vector<std::string> functions = {
+        "function() { return feature.height * 2 || 10; }",
+        "function() { return feature.name + ' (' + feature.kind + ')'; }",
+        "function() { return 'h' + feature.height + feature.missing; }",
+        "function() { return feature.n + 1; }",
+        "function() { return feature.n - 1; }",
+        "function() { return feature.n == 3 || feature.n === 3; }",
+        "function() { return feature.missing == null && feature.missing !== null; }",
+        "function() { return feature.kind === 'road' ? 'red' : 'blue'; }",
+        "function() { if (feature.kind === 'road') { return 1; } else if (feature.kind == 'path') return 2; }",
+        "function() { return $zoom > 10 && feature.scalerank < 5; }",
+        "function() { return Math.round(-2.5) + Math.floor(feature.height) + Math.max(); }",
+        "function() { return !feature.e && !!feature.name; }",
+        "function() { return feature.name < feature.kind; }",
+        "function() { return 0.1 + 0.2 + ':' + 1e21 + ':' + 1.5e-7 + ':' + 1 / 0; }",
+        "function() { return '' == 0 && '0' == false && true + 1; }",
+    };
+
+    Feature road, path, other;
+    road.props.set("name", "Main St");
+    road.props.set("kind", "road");
+    road.props.set("height", 20);
+    road.props.set("n", "3");
+    road.props.set("e", "");
+    path.props.set("name", "x");
+    path.props.set("kind", "path");
+    path.props.set("height", 0.1);
+    path.props.set("scalerank", 4);
+    path.props.set("n", " 12 ");
+    other.props.set("height", -1.5e-7);
+    other.props.set("n", "abc");
+
+    JSContext js;
+    for (size_t i = 0; i < functions.size(); i++) {
+        REQUIRE(js.setFunction(i, functions[i]));
+    }
+
+    StyleContext ctx;
+    for (int zoom : { 4, 12 }) {
+        ctx.setTileID(TileID(0, 0, zoom));
+        {
+            JSScope jsScope(js);
+            js.setGlobalValue("$zoom", jsScope.newNumber(zoom));
+        }
+        for (const auto* feature : { &road, &path, &other }) {
+            ctx.setFeature(*feature);
+            js.setCurrentFeature(feature);
+
+            for (size_t i = 0; i < functions.size(); i++) {
+                INFO(functions[i] << " at zoom " << zoom);
+                auto expression = StyleExpression::compile(functions[i]);
+                REQUIRE(expression);
+
+                Result result;
+                expression->eval(ctx, feature, result);
+
+                JSScope jsScope(js);
+                auto value = jsScope.getFunctionResult(i);
+                REQUIRE(value);
+
+                if (value.isUndefined()) {
+                    REQUIRE(result.type == Result::undefined);
+                } else if (value.isBoolean()) {
+                    REQUIRE(result.type == Result::boolean);
+                    REQUIRE(result.booleanValue == value.toBool());
+                } else if (value.isNumber()) {
+                    REQUIRE(result.type == Result::number);
+                    if (std::isnan(value.toDouble())) {
+                        REQUIRE(std::isnan(result.numberValue));
+                    } else {
+                        REQUIRE(result.numberValue == value.toDouble());
+                    }
+                } else {
+                    REQUIRE(value.isString());
+                    REQUIRE(result.type == Result::string);
+                    REQUIRE(*result.str == value.toString());
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("StyleContext evaluates compiled functions natively", "[StyleExpression]") {
+    Feature feature;
+    feature.props.set("height", 20);
+    feature.props.set("kind", "road");
+
+    StyleContext ctx;
+    ctx.setFeature(feature);
+    ctx.setTileID(TileID(0, 0, 12));
+
+    REQUIRE(ctx.setFunctions({
+        "function() { return feature.kind === 'road' && $zoom >= 12; }",
+        "function() { return feature.height / 4; }",
+        "function() { return feature.kind + '-' + $zoom; }",
+        "function() { if (feature.height > 100) { return true; } }",
+    }));
+
+    REQUIRE(ctx.evalFilter(0));
+
+    StyleParam::Value value;
+    REQUIRE(ctx.evalStyle(1, StyleParamKey::width, value));
+    REQUIRE(value.is<StyleParam::Width>());
+    REQUIRE(value.get<StyleParam::Width>().value == 5);
+
+    REQUIRE(ctx.evalStyle(2, StyleParamKey::text_source, value));
+    REQUIRE(value.get<std::string>() == "road-12");
+
+    REQUIRE(ctx.evalStyle(3, StyleParamKey::visible, value));
+    REQUIRE(value.is<Undefined>());
+}
+
+TEST_CASE("Style expressions find the inputs of JS functions", "[StyleExpression]") {
+    StyleExpression::Inputs inputs;
+    REQUIRE(StyleExpression::scanInputs("function() { var k = feature.kind; "
+                                        "return k.indexOf('road') >= 0 ? feature['name:en'] : $geometry + $zoom; }",
+                                        inputs));
+    REQUIRE(inputs.keys == std::vector<std::string>({ "kind", "name:en" }));
+    REQUIRE(inputs.keywords == ((1u << uint8_t(FilterKeyword::geometry)) | (1u << uint8_t(FilterKeyword::zoom))));
+
+    std::vector<std::string> rejected = {
+        "function() { return global.sizes[feature.kind]; }",
+        "function() { return Math.random() * feature.height; }",
+        "function() { return feature[key]; }",
+        "function() { for (var k in feature) { return k; } }",
+        "function() { feature.height = 1; return feature.height; }",
+        "function() { return feature.n++; }",
+        "function() { return counter; }",
+        "function() { return /'/.test(feature.name); }",
+        "function() { return `${feature.name}`; }",
+        "function() { return $unknown; }",
+    };
+    for (const auto& source : rejected) {
+        INFO(source);
+        StyleExpression::Inputs unused;
+        REQUIRE(!StyleExpression::scanInputs(source, unused));
+    }
+}
+
+TEST_CASE("StyleContext gives memoized results of JS functions per inputs", "[StyleExpression]") {
+    Feature major, minor, other;
+    major.props.set("kind", "major_road");
+    major.props.set("id", 1);
+    minor.props.set("kind", "minor_road");
+    minor.props.set("id", 2);
+    other.props.set("kind", "major_road");
+    other.props.set("id", 3);
+
+    StyleContext ctx;
+    REQUIRE(ctx.setFunctions({
+        // not compiled natively, but memoized by 'kind' and $zoom
+        "function() { var kind = feature.kind; return kind.indexOf('major') == 0 ? 6 + $zoom : 3; }",
+        "function() { var kind = feature.kind; return kind.charAt(1) == 'i'; }",
+    }));
+
+    for (int zoom : { 10, 14 }) {
+        ctx.setTileID(TileID(0, 0, zoom));
+        for (const auto* feature : { &major, &minor, &other, &major }) {
+            ctx.setFeature(*feature);
+            bool isMajor = feature->props.getString("kind") == "major_road";
+
+            StyleParam::Value value;
+            REQUIRE(ctx.evalStyle(0, StyleParamKey::width, value));
+            REQUIRE(value.get<StyleParam::Width>().value == (isMajor ? 6 + zoom : 3));
+
+            REQUIRE(ctx.evalStyle(0, StyleParamKey::priority, value));
+            REQUIRE(value.get<float>() == (isMajor ? 6 + zoom : 3));
+
+            REQUIRE(ctx.evalFilter(1) == !isMajor);
+        }
+    }
+}
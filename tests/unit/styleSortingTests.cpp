@@ -6,6 +6,7 @@
 
 #include "gaml/src/yaml.h"
 #include "scene/filters.h"
+#include "scene/renderQueue.h"
 #include "scene/sceneLoader.h"
 #include "style/polygonStyle.h"
 
@@ -58,3 +59,33 @@ TEST_CASE( "Style Sorting Test", "[styleSorting][core][yaml]") {
     REQUIRE(styles[6]->getName() == "a-add-10");
     REQUIRE(styles[7]->getName() == "s2-multiply-10");
 }
+
+TEST_CASE( "Render queue sorts items by key and keeps the order of equal keys", "[styleSorting][core]") {
+
+    std::vector<RenderQueue::Item> items;
+    std::vector<RenderQueue::Item> scratch;
+
+    uint64_t keys[] = { uint64_t(1) << 63, 0x300, 7, uint64_t(1) << 40, 7, 0x300, 0 };
+    for (size_t i = 0; i < 7; i++) {
+        RenderQueue::Item item;
+        item.key = keys[i];
+        item.textures = uint16_t(i);
+        items.push_back(item);
+    }
+
+    RenderQueue::radixSort(items, scratch);
+
+    REQUIRE(items.size() == 7);
+    for (size_t i = 1; i < items.size(); i++) {
+        REQUIRE(items[i - 1].key <= items[i].key);
+    }
+    // Equal keys keep their order
+    REQUIRE(items[1].key == 7);
+    REQUIRE(items[1].textures == 2);
+    REQUIRE(items[2].textures == 4);
+    REQUIRE(items[3].textures == 1);
+    REQUIRE(items[4].textures == 5);
+    REQUIRE(items[6].textures == 0);
+
+    REQUIRE(RenderQueue::countStateChanges(items) == 6);
+}
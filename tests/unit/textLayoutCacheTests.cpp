@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "text/textLayoutCache.h"
+
+#include <vector>
+
+using namespace Tangram;
+
+static GlyphQuad quad(size_t _atlas, int16_t _x) {
+    GlyphQuad q{};
+    q.atlas = _atlas;
+    for (auto& v : q.quad) { v.pos = { _x, 0 }; }
+    return q;
+}
+
+static TextLayoutCache::Key key(const std::string& _text, float _fontSize = 12) {
+    TextLayoutCache::Key k;
+    k.text = _text;
+    k.font = 1;
+    k.fontSize = _fontSize;
+    k.wordWrap = true;
+    k.alignments = 1;
+    return k;
+}
+
+TEST_CASE("Text layouts are cached by text and parameters", "[Text][TextLayoutCache]") {
+
+    TextLayoutCache cache;
+
+    // Quads of another label before the text
+    std::vector<GlyphQuad> quads = { quad(0, 1), quad(0, 2), quad(1, 3) };
+    TextRange ranges = {{ Range(1, 2), Range(3, 0), Range(3, 0) }};
+
+    auto layout = TextLayoutCache::makeLayout(quads, 1, ranges, { 10, 5 });
+    REQUIRE(layout->quads.size() == 2);
+    REQUIRE(layout->ranges[0].start == 0);
+    REQUIRE(layout->ranges[0].length == 2);
+    REQUIRE(layout->atlases.size() == 2);
+
+    cache.put(key("Main Street"), layout);
+    REQUIRE(cache.get(key("Main Street")) == layout);
+    REQUIRE(cache.get(key("Main Street", 14)) == nullptr);
+    REQUIRE(cache.get(key("Elm Street")) == nullptr);
+
+    std::vector<GlyphQuad> other = { quad(2, 0) };
+    TextRange otherRanges;
+    glm::vec2 size;
+    TextLayoutCache::appendLayout(*cache.get(key("Main Street")), other, otherRanges, size);
+
+    REQUIRE(other.size() == 3);
+    REQUIRE(other[1].quad[0].pos.x == 2);
+    REQUIRE(otherRanges[0].start == 1);
+    REQUIRE(otherRanges[0].length == 2);
+    REQUIRE(otherRanges[1].start == 3);
+    REQUIRE(size == glm::vec2(10, 5));
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("Least recently used text layouts are dropped", "[Text][TextLayoutCache]") {
+
+    TextLayoutCache cache(TextLayoutCache::SHARDS * 4);
+    auto layout = std::make_shared<TextLayoutCache::Layout>();
+
+    for (int i = 0; i < 1000; i++) {
+        cache.put(key(std::to_string(i)), layout);
+    }
+    REQUIRE(cache.size() <= TextLayoutCache::SHARDS * 4);
+    REQUIRE(cache.get(key("999")) == layout);
+    REQUIRE(cache.get(key("0")) == nullptr);
+}
@@ -2,6 +2,13 @@
 
 #include "gl/texture.h"
 #include "gl/glyphTexture.h"
+#include "gl/hardware.h"
+#include "gl/renderState.h"
+#include "util/asyncWorker.h"
+#include "util/pixelBufferPool.h"
+
+#include <cstring>
+#include <thread>
 
 using namespace Tangram;
 
@@ -113,3 +120,236 @@ TEST_CASE("Merging of dirty Regions - Merge three regions, when 3rd region is ad
     }
 
 }
+
+TEST_CASE("Texture is uploaded on the upload worker", "[Texture]") {
+    RenderState rs;
+    Texture texture(TextureOptions{});
+    GLubyte pixels[4 * 4 * 4] = { 0 };
+    REQUIRE(texture.setPixelData(4, 4, 4, pixels, sizeof(pixels)));
+
+    // Without upload worker the texture is uploaded on bind()
+    REQUIRE(!texture.uploadAsync(rs));
+    REQUIRE(texture.needsUpload());
+
+    Texture::uploadWorker = std::make_unique<AsyncWorker>("Test upload worker");
+    REQUIRE(texture.uploadAsync(rs));
+    REQUIRE(!texture.needsUpload());
+    REQUIRE(texture.bufferData() == nullptr);
+
+    while (texture.isUploading()) { std::this_thread::yield(); }
+    Texture::uploadWorker.reset();
+}
+
+TEST_CASE("Opaque texture is compressed to ETC1", "[Texture]") {
+    Texture texture(TextureOptions{});
+    GLubyte pixels[6 * 6 * 4];
+    std::memset(pixels, 255, sizeof(pixels));
+    REQUIRE(texture.setPixelData(6, 6, 4, pixels, sizeof(pixels)));
+
+    // Not supported by the driver
+    Hardware::supportsETC1 = false;
+    Hardware::supportsETC2 = false;
+    REQUIRE(!texture.compress());
+
+    Hardware::supportsETC2 = true;
+    REQUIRE(texture.compress());
+    REQUIRE(texture.compressedFormat() == GL_COMPRESSED_RGB8_ETC2);
+    // 2x2 blocks of 8 bytes
+    REQUIRE(texture.bufferSize() == 32);
+    REQUIRE(texture.needsUpload());
+
+    // Alpha would be lost
+    pixels[3] = 0;
+    REQUIRE(texture.setPixelData(6, 6, 4, pixels, sizeof(pixels)));
+    REQUIRE(texture.compressedFormat() == 0);
+    REQUIRE(!texture.compress());
+
+    Hardware::supportsETC2 = false;
+}
+
+TEST_CASE("Compressed texture is read from a KTX file", "[Texture]") {
+    // KTX 1 header of an 8x4 ETC2 RGB texture followed by its size and two blocks
+    uint32_t header[16] = { 0x58544BAB, 0xBB313120, 0x0A1A0A0D, 0x04030201,
+                            0, 1, 0, GL_COMPRESSED_RGB8_ETC2, GL_RGB, 8, 4, 0, 0, 1, 1, 0 };
+    std::vector<uint8_t> ktx(sizeof(header));
+    std::memcpy(ktx.data(), header, sizeof(header));
+    uint32_t size = 16;
+    ktx.insert(ktx.end(), reinterpret_cast<uint8_t*>(&size), reinterpret_cast<uint8_t*>(&size) + 4);
+    ktx.insert(ktx.end(), 16, 0);
+
+    TextureOptions options;
+    options.minFilter = TextureMinFilter::LINEAR_MIPMAP_LINEAR;
+    Texture texture(options);
+
+    Hardware::supportsETC2 = false;
+    REQUIRE(!texture.loadImageFromMemory(ktx.data(), ktx.size()));
+
+    Hardware::supportsETC2 = true;
+    REQUIRE(texture.loadImageFromMemory(ktx.data(), ktx.size()));
+    REQUIRE(texture.compressedFormat() == GL_COMPRESSED_RGB8_ETC2);
+    REQUIRE(texture.width() == 8);
+    REQUIRE(texture.height() == 4);
+    REQUIRE(texture.bufferSize() == 16);
+    // The file has no mipmaps
+    REQUIRE(texture.getOptions().minFilter == TextureMinFilter::LINEAR);
+
+    // Truncated
+    REQUIRE(!texture.loadImageFromMemory(ktx.data(), ktx.size() - 1));
+
+    Hardware::supportsETC2 = false;
+}
+
+TEST_CASE("Texture array pool reuses released layers", "[Texture]") {
+    RenderState rs;
+    TextureArrayPool pool;
+    TextureOptions options;
+
+    std::vector<TextureArrayPool::Layer> layers;
+    for (int i = 0; i < TextureArrayPool::PAGE_LAYERS + 1; i++) {
+        layers.push_back(pool.allocate(rs, 1, options, 0, 256, 256, 256 * 256 * 4));
+    }
+    REQUIRE(layers[0].layer == 0);
+    REQUIRE(layers[1].layer == 1);
+    REQUIRE(layers.back().layer == 0);
+    REQUIRE(layers.back().page != layers[0].page);
+    REQUIRE(pool.stats().pages == 2);
+    REQUIRE(pool.stats().layers == TextureArrayPool::PAGE_LAYERS + 1);
+
+    // Textures of another size or with other sampling options take other pages
+    auto other = pool.allocate(rs, 1, options, 0, 512, 512, 512 * 512 * 4);
+    REQUIRE(other.page != layers[0].page);
+    options.minFilter = TextureMinFilter::NEAREST;
+    auto nearest = pool.allocate(rs, 1, options, 0, 256, 256, 256 * 256 * 4);
+    REQUIRE(nearest.page != layers.back().page);
+    REQUIRE(pool.stats().pages == 4);
+
+    pool.release(layers[1]);
+    options.minFilter = TextureMinFilter::LINEAR;
+    auto reused = pool.allocate(rs, 1, options, 0, 256, 256, 256 * 256 * 4);
+    REQUIRE(reused.page == layers[1].page);
+    REQUIRE(reused.layer == 1);
+
+    // Empty pages are deleted but one of each kind
+    for (auto& layer : layers) {
+        if (layer.page == reused.page && layer.layer == reused.layer) { continue; }
+        pool.release(layer);
+    }
+    pool.release(reused);
+    pool.collect(rs);
+    REQUIRE(pool.stats().pages == 3);
+    REQUIRE(pool.stats().layers == 2);
+}
+
+TEST_CASE("Texture with array layer option is uploaded to a texture array", "[Texture]") {
+    RenderState rs;
+    TextureOptions options;
+    options.arrayLayer = true;
+    GLubyte pixels[4 * 4 * 4] = { 0 };
+
+    {
+        Texture texture(options);
+        REQUIRE(texture.setPixelData(4, 4, 4, pixels, sizeof(pixels)));
+
+        // Without driver support the texture has its own texture object
+        Hardware::supportsTextureArrays = false;
+        REQUIRE(texture.bind(rs, 1));
+        REQUIRE(texture.arrayLayer() == -1);
+        REQUIRE(rs.textureArrayPool.stats().layers == 0);
+    }
+
+    Hardware::supportsTextureArrays = true;
+    {
+        Texture a(options), b(options);
+        REQUIRE(a.setPixelData(4, 4, 4, pixels, sizeof(pixels)));
+        REQUIRE(b.setPixelData(4, 4, 4, pixels, sizeof(pixels)));
+        REQUIRE(a.bind(rs, 1));
+        REQUIRE(b.bind(rs, 1));
+        REQUIRE(a.arrayLayer() == 0);
+        REQUIRE(b.arrayLayer() == 1);
+        REQUIRE(rs.textureArrayPool.stats().pages == 1);
+        REQUIRE(rs.textureArrayPool.stats().bytesUsed == 2 * sizeof(pixels));
+    }
+    rs.flushResourceDeletion();
+    REQUIRE(rs.textureArrayPool.stats().layers == 0);
+
+    Hardware::supportsTextureArrays = false;
+}
+
+TEST_CASE("Pixel buffers of released textures are reused", "[Texture]") {
+
+    PixelBufferPool::clear();
+    const int size = 256;
+    std::vector<GLubyte> pixels(size * size * 4, 0x80);
+
+    auto texture = std::make_unique<Texture>(TextureOptions());
+    REQUIRE(texture->setPixelData(size, size, 4, pixels.data(), pixels.size()));
+    GLubyte* buffer = texture->bufferData();
+    texture.reset();
+    REQUIRE(PixelBufferPool::pooledBytes() == pixels.size());
+
+    // Same size: the same buffer
+    texture = std::make_unique<Texture>(TextureOptions());
+    REQUIRE(texture->setPixelData(size, size, 4, pixels.data(), pixels.size()));
+    REQUIRE(texture->bufferData() == buffer);
+    REQUIRE(PixelBufferPool::pooledBytes() == 0);
+
+    // Other sizes get a buffer of their own
+    uint8_t* other = PixelBufferPool::allocate(size * size * 3);
+    REQUIRE(other != buffer);
+
+    // Buffers of decoders are pooled once adopted; small buffers are not pooled
+    auto* decoded = static_cast<uint8_t*>(std::malloc(size * size));
+    PixelBufferPool::adopt(decoded, size * size);
+    PixelBufferPool::release(decoded);
+    PixelBufferPool::release(other);
+    PixelBufferPool::release(PixelBufferPool::allocate(100));
+    REQUIRE(PixelBufferPool::pooledBytes() == size * size * 4);
+    REQUIRE(PixelBufferPool::allocate(size * size) == decoded);
+
+    // Buffers beyond the limit are freed
+    size_t maxBytes = PixelBufferPool::maxBytes();
+    PixelBufferPool::setMaxBytes(0);
+    REQUIRE(PixelBufferPool::pooledBytes() == 0);
+    texture.reset();
+    REQUIRE(PixelBufferPool::pooledBytes() == 0);
+    PixelBufferPool::setMaxBytes(maxBytes);
+    PixelBufferPool::release(decoded);
+    PixelBufferPool::clear();
+}
+
+TEST_CASE("Texture with sdf radius turns images into distance fields", "[Texture]") {
+    const int size = 32;
+    TextureOptions options;
+    options.sdfRadius = 4.f;
+
+    // White square of 16 pixels on transparent pixels
+    std::vector<GLubyte> pixels(size * size * 4, 0);
+    for (int y = 8; y < 24; y++) {
+        for (int x = 8; x < 24; x++) {
+            GLubyte* p = &pixels[(y * size + x) * 4];
+            p[0] = p[1] = p[2] = p[3] = 255;
+        }
+    }
+
+    Texture texture(options);
+    REQUIRE(texture.isSdf());
+    REQUIRE(texture.setPixelData(size, size, 4, pixels.data(), pixels.size()));
+    REQUIRE(texture.getOptions().pixelFormat == PixelFormat::ALPHA);
+    REQUIRE(texture.bufferSize() == size * size);
+
+    auto distance = [&](int x, int y) { return texture.bufferData()[y * size + x] / 255.f; };
+    // 1 / (2 * radius) per pixel from 0.5 on the edge, within the radius
+    CHECK(distance(16, 16) == 1.f);
+    CHECK(distance(2, 2) == 0.f);
+    CHECK(distance(10, 16) == Approx(0.5f + 2.5f / 8.f).margin(0.02f));
+    CHECK(distance(6, 16) == Approx(0.5f - 1.5f / 8.f).margin(0.02f));
+
+    // Opaque images are distance fields already
+    std::vector<GLubyte> field(size * size * 4, 255);
+    field[0] = 0x40;
+    Texture prebuilt(options);
+    REQUIRE(prebuilt.setPixelData(size, size, 4, field.data(), field.size()));
+    REQUIRE(prebuilt.bufferSize() == size * size);
+    CHECK(prebuilt.bufferData()[0] == 0x40);
+    CHECK(prebuilt.bufferData()[1] == 255);
+}
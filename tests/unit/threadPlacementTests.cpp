@@ -0,0 +1,42 @@
+#include "catch.hpp"
+
+#include "util/threadPlacement.h"
+
+using namespace Tangram;
+
+#define TAGS "[ThreadPlacement]"
+
+TEST_CASE("Cores of the same speed are all used for workers", TAGS) {
+    CpuTopology topology({ 2000, 2000, 2000, 2000 });
+    CHECK(!topology.isHeterogeneous());
+    CHECK(topology.workerCpus() == std::vector<int>({ 0, 1, 2, 3 }));
+    CHECK(topology.numTileWorkers() == 3);
+
+    CHECK(CpuTopology({ 0, 0 }).numTileWorkers() == 2);
+    CHECK(CpuTopology({ 0 }).numTileWorkers() == 1);
+    CHECK(CpuTopology(std::vector<uint32_t>(16, 0)).numTileWorkers() == 4);
+}
+
+TEST_CASE("Workers are placed on the performance cores", TAGS) {
+    // big.LITTLE with efficiency cores first
+    CpuTopology topology({ 1800, 1800, 1800, 1800, 2800, 2800, 2800, 2800 });
+    REQUIRE(topology.clusters().size() == 2);
+    CHECK(topology.clusters()[0].maxFrequency == 2800);
+    CHECK(topology.workerCpus() == std::vector<int>({ 4, 5, 6, 7 }));
+    CHECK(topology.numTileWorkers() == 3);
+
+    // two performance cores
+    CHECK(CpuTopology({ 1800, 1800, 1800, 1800, 1800, 1800, 2600, 2600 }).numTileWorkers() == 2);
+}
+
+TEST_CASE("Prime cores are left to the render thread", TAGS) {
+    CpuTopology topology({ 1800, 1800, 1800, 1800, 2400, 2400, 2400, 3000 });
+    REQUIRE(topology.clusters().size() == 3);
+    CHECK(topology.workerCpus() == std::vector<int>({ 4, 5, 6 }));
+    CHECK(topology.numTileWorkers() == 3);
+
+    // not when there is only one other fast core
+    CpuTopology small({ 1800, 1800, 1800, 1800, 2400, 3000 });
+    CHECK(small.workerCpus() == std::vector<int>({ 4, 5 }));
+    CHECK(small.numTileWorkers() == 2);
+}
@@ -0,0 +1,53 @@
+#include "catch.hpp"
+
+#include "tile/tileAvailability.h"
+
+using namespace Tangram;
+
+#define TAGS "[TileAvailability]"
+
+TEST_CASE("Missing tiles mark their subtree", TAGS) {
+    TileAvailability availability;
+    CHECK_FALSE(availability.isMissing(TileID(1, 2, 3)));
+
+    availability.setMissing(TileID(1, 2, 3));
+    CHECK(availability.isMissing(TileID(1, 2, 3)));
+    CHECK(availability.isMissing(TileID(1, 2, 3, 5)));
+    CHECK(availability.isMissing(TileID(2, 5, 4)));
+    CHECK(availability.isMissing(TileID(17, 37, 7)));
+
+    CHECK_FALSE(availability.isMissing(TileID(0, 1, 2)));
+    CHECK_FALSE(availability.isMissing(TileID(1, 3, 3)));
+    CHECK_FALSE(availability.isMissing(TileID(4, 5, 4)));
+
+    availability.clear();
+    CHECK_FALSE(availability.isMissing(TileID(2, 5, 4)));
+}
+
+TEST_CASE("A tile whose children are all missing is the deepest with data", TAGS) {
+    TileAvailability availability;
+    TileID parent(3, 5, 4);
+    for (int i = 0; i < 3; i++) { availability.setMissing(parent.getChild(i, 100)); }
+    CHECK_FALSE(availability.childrenMissing(parent));
+
+    availability.setMissing(parent.getChild(3, 100));
+    CHECK(availability.childrenMissing(parent));
+    CHECK_FALSE(availability.isMissing(parent));
+    CHECK_FALSE(availability.childrenMissing(parent.getParent()));
+}
+
+TEST_CASE("Tiles outside of bounds and zoom range are missing", TAGS) {
+    TileAvailability availability;
+    // north-east quarter of the world
+    availability.setBounds({ 1, 1 }, { 180, 85 });
+    availability.setZoomRange(1, 5);
+
+    CHECK(availability.isMissing(TileID(0, 0, 0)));
+    CHECK_FALSE(availability.isMissing(TileID(1, 0, 1)));
+    CHECK(availability.isMissing(TileID(0, 0, 1)));
+    CHECK(availability.isMissing(TileID(1, 1, 1)));
+    CHECK(availability.isMissing(TileID(31, 0, 6)));
+
+    CHECK_FALSE(availability.childrenMissing(TileID(1, 0, 1)));
+    CHECK(availability.childrenMissing(TileID(16, 0, 5)));
+}
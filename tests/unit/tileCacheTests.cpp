@@ -0,0 +1,245 @@
+#include "catch.hpp"
+
+#include "style/polygonStyle.h"
+#include "tile/tile.h"
+#include "tile/tileCache.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[TileCache]"
+
+// Mesh standing in for the geometry of a tile, to give it a memory usage
+struct SizedMesh : StyledMesh {
+    size_t size;
+    explicit SizedMesh(size_t _size) : size(_size) {}
+    bool draw(RenderState&, ShaderProgram&, bool) override { return true; }
+    size_t bufferSize() const override { return size; }
+};
+
+static std::shared_ptr<Tile> makeTile(TileID _tileId, size_t _bytes, float _buildCost = 0) {
+    static PolygonStyle style("polygons");
+    auto tile = std::make_shared<Tile>(_tileId);
+    tile->setMesh(style, std::make_unique<SizedMesh>(_bytes));
+    tile->setBuildCost(_buildCost);
+    return tile;
+}
+
+static bool cached(const TileCache& _cache, TileID _tileId) {
+    return _cache.contains(0, _tileId) != nullptr;
+}
+
+TEST_CASE("Cached tiles are found until they are taken", TAGS) {
+    TileCache cache(1000);
+
+    auto tile = makeTile(TileID(1, 2, 3), 100);
+    cache.put(0, tile);
+    cache.put(1, makeTile(TileID(1, 2, 3), 50));
+    CHECK(cache.getNumEntries() == 2);
+    CHECK(cache.getMemoryUsage() == 150);
+
+    // contains() leaves the tile in the cache
+    CHECK(cache.contains(0, TileID(1, 2, 3)) == tile);
+    CHECK(cache.contains(0, TileID(1, 2, 4)) == nullptr);
+    CHECK(cache.contains(2, TileID(1, 2, 3)) == nullptr);
+    CHECK(cache.getNumEntries() == 2);
+
+    CHECK(cache.get(0, TileID(1, 2, 3)) == tile);
+    CHECK(cache.get(0, TileID(1, 2, 3)) == nullptr);
+    CHECK(cache.contains(0, TileID(1, 2, 3)) == nullptr);
+    CHECK(cached(cache, TileID(1, 2, 3)) == false);
+    CHECK(cache.contains(1, TileID(1, 2, 3)) != nullptr);
+    CHECK(cache.getNumEntries() == 1);
+    CHECK(cache.getMemoryUsage() == 50);
+
+    CHECK(cache.stats().hits == 1);
+    CHECK(cache.stats().misses == 1);
+
+    // putting a tile again replaces it
+    auto replacement = makeTile(TileID(1, 2, 3), 80);
+    cache.put(1, replacement);
+    CHECK(cache.getNumEntries() == 1);
+    CHECK(cache.getMemoryUsage() == 80);
+    CHECK(cache.contains(1, TileID(1, 2, 3)) == replacement);
+
+    cache.clear();
+    CHECK(cache.getNumEntries() == 0);
+    CHECK(cache.getMemoryUsage() == 0);
+    CHECK(cache.contains(1, TileID(1, 2, 3)) == nullptr);
+}
+
+TEST_CASE("Least recently cached tiles are evicted first", TAGS) {
+    TileCache cache(300);
+
+    for (int x = 0; x < 4; x++) { cache.put(0, makeTile(TileID(x, 0, 5), 100)); }
+    CHECK_FALSE(cached(cache, TileID(0, 0, 5)));
+    CHECK(cached(cache, TileID(1, 0, 5)));
+    CHECK(cache.getMemoryUsage() == 300);
+    CHECK(cache.stats().evictions == 1);
+
+    // a tile put back is the most recent one
+    cache.put(0, cache.get(0, TileID(1, 0, 5)));
+    cache.put(0, makeTile(TileID(4, 0, 5), 100));
+    CHECK(cached(cache, TileID(1, 0, 5)));
+    CHECK_FALSE(cached(cache, TileID(2, 0, 5)));
+    CHECK(cached(cache, TileID(3, 0, 5)));
+    CHECK(cached(cache, TileID(4, 0, 5)));
+
+    // shrinking the limit evicts in the same order
+    cache.limitCacheSize(150);
+    CHECK_FALSE(cached(cache, TileID(3, 0, 5)));
+    CHECK_FALSE(cached(cache, TileID(1, 0, 5)));
+    CHECK(cached(cache, TileID(4, 0, 5)));
+    CHECK(cache.getMemoryUsage() == 100);
+    CHECK(cache.stats().evictions == 4);
+}
+
+TEST_CASE("Erasing from a collision chain keeps the other keys reachable", TAGS) {
+    // the index starts with 64 slots, which holds up to 32 entries
+    const size_t mask = 63;
+    auto home = [&](TileID _tileId) { return std::hash<TileCacheKey>()({ 0, _tileId }) & mask; };
+
+    // keys by home slot, to find one slot with a chain of colliding keys followed by keys
+    //  whose home is the next slot, so that they are placed behind the chain
+    std::map<size_t, std::vector<TileID>> keys;
+    size_t chain = mask + 1;
+    for (int x = 0; x < 4096 && chain > mask; x++) {
+        TileID tileId(x, 0, 12);
+        keys[home(tileId)].push_back(tileId);
+        for (auto& slot : keys) {
+            auto next = keys.find((slot.first + 1) & mask);
+            if (slot.second.size() >= 4 && next != keys.end() && next->second.size() >= 2) {
+                chain = slot.first;
+                break;
+            }
+        }
+    }
+    REQUIRE(chain <= mask);
+    auto& colliding = keys[chain];
+    auto& following = keys[(chain + 1) & mask];
+
+    TileCache cache(1 << 20);
+    std::vector<TileID> all = { colliding[0], colliding[1], colliding[2], following[0], colliding[3], following[1] };
+    for (auto& tileId : all) { cache.put(0, makeTile(tileId, 10)); }
+    for (auto& tileId : all) { CHECK(cached(cache, tileId)); }
+
+    // middle of the chain: later keys of the chain and those displaced by it shift back
+    REQUIRE(cache.get(0, colliding[1]) != nullptr);
+    CHECK_FALSE(cached(cache, colliding[1]));
+    for (auto& tileId : all) {
+        if (tileId != colliding[1]) { CHECK(cached(cache, tileId)); }
+    }
+
+    // head of the chain
+    REQUIRE(cache.get(0, colliding[0]) != nullptr);
+    for (auto& tileId : { colliding[2], colliding[3], following[0], following[1] }) {
+        CHECK(cache.get(0, tileId) != nullptr);
+        CHECK_FALSE(cached(cache, tileId));
+    }
+    CHECK(cache.getNumEntries() == 0);
+
+    // erased keys can be cached again
+    cache.put(0, makeTile(colliding[1], 10));
+    cache.put(0, makeTile(colliding[3], 10));
+    CHECK(cached(cache, colliding[1]));
+    CHECK(cached(cache, colliding[3]));
+    CHECK_FALSE(cached(cache, colliding[0]));
+}
+
+TEST_CASE("ARC target follows hits on evicted tiles", TAGS) {
+    TileCache cache(400, TileCache::Policy::arc);
+
+    for (int x = 0; x < 4; x++) { cache.put(0, makeTile(TileID(x, 0, 5), 100)); }
+    // tile 0 is reused
+    cache.put(0, cache.get(0, TileID(0, 0, 5)));
+    CHECK(cache.recentTarget() == 0);
+
+    // tiles cached once are evicted first
+    cache.put(0, makeTile(TileID(4, 0, 5), 100));
+    cache.put(0, makeTile(TileID(5, 0, 5), 100));
+    CHECK_FALSE(cached(cache, TileID(1, 0, 5)));
+    CHECK_FALSE(cached(cache, TileID(2, 0, 5)));
+    CHECK(cached(cache, TileID(0, 0, 5)));
+
+    // hits on evicted once-cached tiles grow their share
+    cache.put(0, makeTile(TileID(1, 0, 5), 100));
+    CHECK(cache.recentTarget() == 100);
+    cache.put(0, makeTile(TileID(2, 0, 5), 100));
+    CHECK(cache.recentTarget() == 200);
+
+    // at its target the recent list is kept and reused tiles are evicted
+    CHECK_FALSE(cached(cache, TileID(0, 0, 5)));
+    CHECK(cached(cache, TileID(4, 0, 5)));
+    CHECK(cached(cache, TileID(5, 0, 5)));
+
+    // a hit on an evicted reused tile shrinks the share again
+    cache.put(0, makeTile(TileID(0, 0, 5), 100));
+    CHECK(cache.recentTarget() == 100);
+    CHECK_FALSE(cached(cache, TileID(4, 0, 5)));
+    CHECK(cache.getMemoryUsage() == 400);
+}
+
+TEST_CASE("Cost policy evicts tiles cheapest to rebuild first", TAGS) {
+    TileCache cache(300, TileCache::Policy::cost);
+
+    cache.put(0, makeTile(TileID(0, 0, 5), 100, 5));
+    cache.put(0, makeTile(TileID(1, 0, 5), 100, 1));
+    cache.put(0, makeTile(TileID(2, 0, 5), 100, 3));
+
+    cache.put(0, makeTile(TileID(3, 0, 5), 100, 4));
+    CHECK_FALSE(cached(cache, TileID(1, 0, 5)));
+
+    cache.put(0, makeTile(TileID(4, 0, 5), 100, 10));
+    CHECK_FALSE(cached(cache, TileID(2, 0, 5)));
+    CHECK(cached(cache, TileID(0, 0, 5)));
+    CHECK(cached(cache, TileID(3, 0, 5)));
+
+    // cost is per byte: a large tile goes before small ones of the same cost
+    TileCache sized(300, TileCache::Policy::cost);
+    sized.put(0, makeTile(TileID(0, 0, 5), 200, 10));
+    sized.put(0, makeTile(TileID(1, 0, 5), 100, 10));
+    sized.put(0, makeTile(TileID(2, 0, 5), 100, 10));
+    CHECK_FALSE(cached(sized, TileID(0, 0, 5)));
+    CHECK(cached(sized, TileID(1, 0, 5)));
+    CHECK(cached(sized, TileID(2, 0, 5)));
+    CHECK(sized.getMemoryUsage() == 200);
+}
+
+TEST_CASE("Switching policy keeps the cached tiles within the limit", TAGS) {
+    TileCache cache(500, TileCache::Policy::arc);
+
+    for (int x = 0; x < 5; x++) { cache.put(0, makeTile(TileID(x, 0, 5), 100, float(x))); }
+    cache.put(0, cache.get(0, TileID(0, 0, 5)));
+    cache.put(0, cache.get(0, TileID(1, 0, 5)));
+    cache.put(0, makeTile(TileID(5, 0, 5), 100));
+    cache.put(0, makeTile(TileID(6, 0, 5), 100));
+
+    std::vector<TileID> tiles = { TileID(0, 0, 5), TileID(1, 0, 5), TileID(4, 0, 5),
+                                  TileID(5, 0, 5), TileID(6, 0, 5) };
+    for (auto& tileId : tiles) { REQUIRE(cached(cache, tileId)); }
+
+    int x = 7;
+    for (auto policy : { TileCache::Policy::cost, TileCache::Policy::lru, TileCache::Policy::arc,
+                         TileCache::Policy::lru, TileCache::Policy::cost, TileCache::Policy::arc }) {
+        size_t entries = cache.getNumEntries();
+        size_t usage = cache.getMemoryUsage();
+        cache.setPolicy(policy);
+        CHECK(cache.policy() == policy);
+        CHECK(cache.getNumEntries() == entries);
+        CHECK(cache.getMemoryUsage() == usage);
+        for (auto& tileId : tiles) { CHECK(cached(cache, tileId)); }
+        if (policy != TileCache::Policy::arc) { CHECK(cache.recentTarget() == 0); }
+
+        // each policy keeps the limit with the entries it took over
+        for (int i = 0; i < 3; i++, x++) { cache.put(0, makeTile(TileID(x, 0, 5), 100, float(x % 4))); }
+        CHECK(cache.getMemoryUsage() <= cache.cacheSizeLimit());
+        CHECK(cache.getNumEntries() == 5);
+
+        tiles.clear();
+        cache.forEach([&](const Tile& _tile) { tiles.push_back(_tile.getID()); });
+        CHECK(tiles.size() == 5);
+    }
+}
@@ -1,7 +1,11 @@
 #include "catch.hpp"
 
 #include "tile/tileID.h"
+#include "tile/tileHash.h"
+#include <algorithm>
 #include <set>
+#include <tuple>
+#include <vector>
 
 using namespace Tangram;
 
@@ -144,3 +148,54 @@ TEST_CASE("TileID correctly applies source zoom limits for scaled tiles", "[Core
     REQUIRE(g == TileID(8, 4, 6, 10));
 
 }
+
+TEST_CASE( "Packed TileID keys follow the TileID order", "[Core][TileID]" ) {
+
+    std::vector<TileID> ids = {
+        TileID(0, 0, 0), TileID(1, 0, 1), TileID(0, 1, 1), TileID(1, 1, 1),
+        TileID(3, 5, 3), TileID(5, 3, 3), TileID(2, 1, 2, 4), TileID(2, 1, 2, 3),
+        TileID(12345, 23456, 16), TileID(23456, 12345, 16), TileID((1 << 25) - 1, 0, 25),
+    };
+
+    // Styling zoom and zoom descending, then x and y ascending
+    auto lexicographic = [](const TileID& a, const TileID& b) {
+        return std::make_tuple(-a.s, -a.z, a.x, a.y) < std::make_tuple(-b.s, -b.z, b.x, b.y);
+    };
+
+    for (auto& a : ids) {
+        for (auto& b : ids) {
+            REQUIRE((a.key() < b.key()) == lexicographic(a, b));
+            REQUIRE((a < b) == lexicographic(a, b));
+            REQUIRE((a == b) == (a.key() == b.key()));
+        }
+    }
+
+    auto sorted = ids;
+    std::sort(sorted.begin(), sorted.end(), [](auto& a, auto& b) { return a.key() < b.key(); });
+    REQUIRE(std::is_sorted(sorted.begin(), sorted.end(), lexicographic));
+    REQUIRE(sorted.front() == TileID((1 << 25) - 1, 0, 25));
+    REQUIRE(sorted[1] == TileID(12345, 23456, 16));
+    REQUIRE(sorted[2] == TileID(23456, 12345, 16));
+
+    // Keys hold all tiles up to zoom 25 without x, y and zoom overlapping
+    REQUIRE(int(TileID::MAX_KEY_ZOOM) == 25);
+    const int32_t last = (1 << 25) - 1;
+    TileID corner(last, last, 25);
+    REQUIRE(((corner.key() >> 50) & 0x7F) == uint64_t(126 - 25));
+    REQUIRE(TileID(last, last - 1, 25).key() < corner.key());
+    REQUIRE(TileID(last - 1, last, 25).key() < TileID(last, 0, 25).key());
+    REQUIRE(corner.key() < TileID(0, 0, 24).key());
+    REQUIRE(corner.key() != TileID(0, 0, 25).key());
+
+    // Tiles of higher styling zoom and zoom come first
+    REQUIRE(TileID(0, 0, 2, 4) < TileID(0, 0, 2, 3));
+    REQUIRE(TileID(0, 0, 3) < TileID(7, 7, 2));
+
+    // NOT_A_TILE ends sorted ranges of tiles
+    for (auto& a : ids) { REQUIRE(a < NOT_A_TILE); }
+
+    // Equal ids hash equally, the styling zoom is part of the hash
+    std::hash<TileID> hash;
+    REQUIRE(hash(TileID(3, 5, 3)) == hash(TileID(3, 5, 3)));
+    REQUIRE(hash(TileID(2, 1, 2, 4)) != hash(TileID(2, 1, 2, 3)));
+}
@@ -2,17 +2,30 @@
 
 #include "data/tileSource.h"
 #include "mockPlatform.h"
+#include "tile/tileAvailability.h"
 #include "tile/tileManager.h"
 #include "tile/tileWorker.h"
 #include "util/mapProjection.h"
 #include "util/fastmap.h"
 #include "view/view.h"
 
+#include <bitset>
 #include <deque>
+#include <set>
 
 using namespace Tangram;
 
-ViewState viewState { glm::vec2(0), 1, 0, 1.f, glm::vec2(0), 256.f };
+// View at zoom 1 over the origin; TileManager reads its zoom, position and matrices
+static View makeView() {
+    View view(256, 256);
+    // a 256px view is wider than the world at zoom 1, which would raise the zoom
+    view.setConstrainToWorldBounds(false);
+    view.setZoom(1);
+    view.update();
+    return view;
+}
+
+View view = makeView();
 
 struct TestTileWorker : TileTaskQueue {
     int processedCount = 0;
@@ -114,7 +127,7 @@ public:
     //using Base::Base;
     TestTileManager(Platform& platform, TileTaskQueue& _tileWorker) : TileManager(platform, _tileWorker, {}) {}
 
-    void updateTiles(const ViewState& _view, std::set<TileID> _visibleTiles) {
+    void updateTiles(const View& _view, std::set<TileID> _visibleTiles) {
         // Mimic TileManager::updateTileSets(View& _view)
         m_tiles.clear();
         m_tilesInProgress = 0;
@@ -122,7 +135,7 @@ public:
 
         TileSet& tileSet = m_tileSets[0];
 
-        tileSet.visibleTiles = _visibleTiles;
+        tileSet.visibleTiles.assign(_visibleTiles.begin(), _visibleTiles.end());
 
         TileManager::updateTileSet(tileSet, _view);
 
@@ -136,7 +149,12 @@ public:
         // Remove duplicates: Proxy tiles could have been added more than once
         m_tiles.erase(std::unique(m_tiles.begin(), m_tiles.end()), m_tiles.end());
 
+        // Mimic TileUploader without budget: new tiles replace their proxies on the next update
+        for (auto& tile : m_tiles) { tile->setUploaded(); }
+
     }
+
+    const std::vector<TileID>& selectedTiles() { return m_tileSets[0].visibleTiles; }
 };
 
 TEST_CASE( "Use proxy Tile - Dont remove proxy if it is now visible", "[TileManager][updateTileSets]" ) {
@@ -150,7 +168,7 @@ TEST_CASE( "Use proxy Tile - Dont remove proxy if it is now visible", "[TileMana
 
     /// Start loading tile 0/0/0
     std::set<TileID> visibleTiles_1 = {TileID{0,0,0}};
-    tileManager.updateTiles(viewState, visibleTiles_1);
+    tileManager.updateTiles(view, visibleTiles_1);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
     REQUIRE(source->tileTaskCount == 1);
@@ -159,7 +177,7 @@ TEST_CASE( "Use proxy Tile - Dont remove proxy if it is now visible", "[TileMana
     /// Start loading tile 0/0/1 - uses 0/0/0 as proxy
     std::set<TileID> visibleTiles_2 = {TileID{0,0,1}};
 
-    tileManager.updateTiles(viewState, visibleTiles_2);
+    tileManager.updateTiles(view, visibleTiles_2);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
     REQUIRE(source->tileTaskCount == 2);
@@ -169,7 +187,7 @@ TEST_CASE( "Use proxy Tile - Dont remove proxy if it is now visible", "[TileMana
     worker.processTask(1);
 
     /// Go back to tile 0/0/0 - uses 0/0/1 as proxy
-    tileManager.updateTiles(viewState, visibleTiles_1);
+    tileManager.updateTiles(view, visibleTiles_1);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 1);
     REQUIRE(source->tileTaskCount == 2);
@@ -177,9 +195,12 @@ TEST_CASE( "Use proxy Tile - Dont remove proxy if it is now visible", "[TileMana
     REQUIRE(tileManager.getVisibleTiles()[0]->isProxy() == true);
     REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,1));
 
-    // Process tile task 0/0/0
+    // Process tile task 0/0/0 - proxy is kept until 0/0/0 is uploaded
     worker.processTask(0);
-    tileManager.updateTiles(viewState, visibleTiles_1);
+    tileManager.updateTiles(view, visibleTiles_1);
+    REQUIRE(tileManager.getVisibleTiles().size() == 2);
+
+    tileManager.updateTiles(view, visibleTiles_1);
     REQUIRE(tileManager.getVisibleTiles().size() == 1);
     REQUIRE(tileManager.getVisibleTiles()[0]->isProxy() == false);
     REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,0));
@@ -194,7 +215,7 @@ TEST_CASE( "Mock TileWorker Initialization", "[TileManager][Constructor]" ) {
 
 TEST_CASE( "Real TileWorker Initialization", "[TileManager][Constructor]" ) {
     MockPlatform platform;
-    TileWorker worker(platform, 1);
+    TileWorker worker(1);
     TileManager tileManager(platform, worker, {});
 }
 
@@ -208,14 +229,14 @@ TEST_CASE( "Load visible Tile", "[TileManager][updateTileSets]" ) {
     tileManager.setTileSources(sources);
 
     std::set<TileID> visibleTiles = {TileID{0,0,0}};
-    tileManager.updateTiles(viewState, visibleTiles);
+    tileManager.updateTiles(view, visibleTiles);
     worker.processTask();
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
     REQUIRE(source->tileTaskCount == 1);
     REQUIRE(worker.processedCount == 1);
 
-    tileManager.updateTiles(viewState, visibleTiles);
+    tileManager.updateTiles(view, visibleTiles);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 1);
     REQUIRE(source->tileTaskCount == 1);
@@ -234,7 +255,7 @@ TEST_CASE( "Use proxy Tile", "[TileManager][updateTileSets]" ) {
     tileManager.setTileSources(sources);
 
     std::set<TileID> visibleTiles = {TileID{0,0,0}};
-    tileManager.updateTiles(viewState, visibleTiles);
+    tileManager.updateTiles(view, visibleTiles);
     worker.processTask();
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
@@ -242,7 +263,7 @@ TEST_CASE( "Use proxy Tile", "[TileManager][updateTileSets]" ) {
     REQUIRE(worker.processedCount == 1);
 
     std::set<TileID> visibleTiles2 = {TileID{0,0,1}};
-    tileManager.updateTiles(viewState, visibleTiles2);
+    tileManager.updateTiles(view, visibleTiles2);
     worker.processTask();
 
     REQUIRE(tileManager.getVisibleTiles().size() == 1);
@@ -251,9 +272,14 @@ TEST_CASE( "Use proxy Tile", "[TileManager][updateTileSets]" ) {
     REQUIRE(source->tileTaskCount == 2);
     REQUIRE(worker.processedCount == 2);
 
-    tileManager.updateTiles(viewState, visibleTiles2);
+    tileManager.updateTiles(view, visibleTiles2);
     worker.processTask();
 
+    // proxy is kept until 0/0/1 is uploaded
+    REQUIRE(tileManager.getVisibleTiles().size() == 2);
+
+    tileManager.updateTiles(view, visibleTiles2);
+
     REQUIRE(tileManager.getVisibleTiles().size() == 1);
     REQUIRE(tileManager.getVisibleTiles()[0]->isProxy() == false);
     REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,1));
@@ -274,7 +300,7 @@ TEST_CASE( "Use proxy Tile - circular proxies", "[TileManager][updateTileSets]"
 
     /// Start loading tile 0/0/0
     std::set<TileID> visibleTiles_1 = {TileID{0,0,0}};
-    tileManager.updateTiles(viewState, visibleTiles_1);
+    tileManager.updateTiles(view, visibleTiles_1);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
     REQUIRE(source->tileTaskCount == 1);
@@ -282,7 +308,7 @@ TEST_CASE( "Use proxy Tile - circular proxies", "[TileManager][updateTileSets]"
 
     /// Start loading tile 0/0/1 - add 0/0/0 as proxy
     std::set<TileID> visibleTiles_2 = {TileID{0,0,1}};
-    tileManager.updateTiles(viewState, visibleTiles_2);
+    tileManager.updateTiles(view, visibleTiles_2);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
     REQUIRE(source->tileTaskCount == 2);
@@ -290,7 +316,7 @@ TEST_CASE( "Use proxy Tile - circular proxies", "[TileManager][updateTileSets]"
 
     /// Go back to tile 0/0/0
     /// NB: does not add 0/0/1 as proxy, since no newTiles were loaded
-    tileManager.updateTiles(viewState, visibleTiles_1);
+    tileManager.updateTiles(view, visibleTiles_1);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 0);
     REQUIRE(source->tileTaskCount == 2);
@@ -303,10 +329,114 @@ TEST_CASE( "Use proxy Tile - circular proxies", "[TileManager][updateTileSets]"
     //REQUIRE(worker.tasks[1]->isCanceled() == true);
 
     worker.processTask();
-    tileManager.updateTiles(viewState, visibleTiles_1);
+    tileManager.updateTiles(view, visibleTiles_1);
 
     REQUIRE(tileManager.getVisibleTiles().size() == 1);
     REQUIRE(tileManager.getVisibleTiles()[0]->isProxy() == false);
     REQUIRE(tileManager.getVisibleTiles()[0]->getID() == TileID(0,0,0));
 
 }
+
+TEST_CASE( "Select fewer tiles in a tilted view with a larger LOD scale", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    View tilted(1024, 1024);
+    tilted.setZoom(10);
+    tilted.setPitch(1.f);
+    tilted.update();
+
+    tileManager.updateTileSets(tilted);
+    auto fine = tileManager.selectedTiles();
+
+    tileManager.setLodScale(4.f);
+    tileManager.updateTileSets(tilted);
+    auto coarse = tileManager.selectedTiles();
+
+    REQUIRE(coarse.size() < fine.size());
+    for (auto& id : coarse) { REQUIRE(id.z <= 10); }
+}
+
+TEST_CASE( "Missing tiles are not selected and their ancestor is overzoomed", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    View view3(256, 256);
+    view3.setZoom(3);
+    view3.update();
+
+    // no data below 1/1/2, and none at 4/4/3
+    TileID parent(1, 1, 2);
+    for (int i = 0; i < 4; i++) { source->availability().setMissing(parent.getChild(i, 100)); }
+    source->availability().setMissing(TileID(4, 4, 3));
+
+    tileManager.updateTileSets(view3);
+    auto& selected = tileManager.selectedTiles();
+
+    REQUIRE(std::find(selected.begin(), selected.end(), TileID(1, 1, 2, 3)) != selected.end());
+    REQUIRE(std::find(selected.begin(), selected.end(), TileID(4, 3, 3)) != selected.end());
+    for (auto& id : selected) {
+        REQUIRE(id != TileID(3, 3, 3));
+        REQUIRE(id != TileID(4, 4, 3));
+    }
+}
+
+TEST_CASE( "Proxy tiles skip the cells covered by loaded children", "[TileManager][updateTileSets]" ) {
+    TestTileWorker worker;
+    MockPlatform platform;
+    TestTileManager tileManager(platform, worker);
+
+    auto source = std::make_shared<TestTileSource>();
+    std::vector<std::shared_ptr<TileSource>> sources = { source };
+    tileManager.setTileSources(sources);
+
+    std::set<TileID> parent = {TileID{0,0,0}};
+    tileManager.updateTiles(view, parent);
+    worker.processTask();
+    tileManager.updateTiles(view, parent);
+
+    /// Zoom in: 0/0/0 is the proxy for its children, three of which load
+    std::set<TileID> children = {TileID{0,0,1}, TileID{1,0,1}, TileID{0,1,1}, TileID{1,1,1}};
+    tileManager.updateTiles(view, children);
+    for (int i = 0; i < 3; i++) { worker.processTask(); }
+    tileManager.updateTiles(view, children);
+    tileManager.updateTiles(view, children);
+
+    auto& tiles = tileManager.getVisibleTiles();
+    REQUIRE(tiles.size() == 4);
+
+    // Cells of the 4x4 grid over 0/0/0 under each drawn child, rows counted from the south
+    uint16_t expected = 0;
+    const Tile* proxy = nullptr;
+    for (auto& tile : tiles) {
+        auto id = tile->getID();
+        if (id.z == 0) {
+            proxy = tile.get();
+            continue;
+        }
+        REQUIRE(tile->coveredCells() == 0);
+        int x = id.x * 2, y = (1 - id.y) * 2;
+        expected |= (0x3 << (y * 4 + x)) | (0x3 << ((y + 1) * 4 + x));
+    }
+    REQUIRE(proxy != nullptr);
+    REQUIRE(proxy->isProxy());
+    REQUIRE(proxy->coveredCells() == expected);
+    REQUIRE(std::bitset<16>(expected).count() == 12);
+
+    /// All children loaded: the proxy is dropped
+    worker.processTask();
+    tileManager.updateTiles(view, children);
+    tileManager.updateTiles(view, children);
+    REQUIRE(tileManager.getVisibleTiles().size() == 4);
+    for (auto& tile : tileManager.getVisibleTiles()) { REQUIRE(tile->getID().z == 1); }
+}
@@ -0,0 +1,30 @@
+#include "catch.hpp"
+
+#include "util/timeHistogram.h"
+
+using namespace Tangram;
+
+TEST_CASE("TimeHistogram counts durations by bucket", "[TimeHistogram]") {
+    TimeHistogram histogram;
+    REQUIRE(histogram.percentile(95) == 0.f);
+
+    histogram.add(0.5f);  // bucket 0: up to 1ms
+    histogram.add(1.f);   // still bucket 0
+    histogram.add(3.f);   // bucket 2: up to 4ms
+    histogram.add(1000.f);
+
+    REQUIRE(histogram.total() == 4);
+    REQUIRE(histogram.count(0) == 2);
+    REQUIRE(histogram.count(2) == 1);
+    REQUIRE(histogram.count(TimeHistogram::numBuckets - 1) == 1);
+    REQUIRE(histogram.average() == Approx(251.125f));
+
+    REQUIRE(histogram.percentile(50) == 1.f);
+    REQUIRE(histogram.percentile(75) == 4.f);
+    // beyond the bounded buckets
+    REQUIRE(histogram.percentile(100) == TimeHistogram::bound(TimeHistogram::numBuckets - 2));
+
+    histogram.reset();
+    REQUIRE(histogram.total() == 0);
+    REQUIRE(histogram.count(0) == 0);
+}
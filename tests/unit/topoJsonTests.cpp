@@ -0,0 +1,68 @@
+#include "catch.hpp"
+
+#include "data/formats/topoJson.h"
+#include "tile/tileTask.h"
+
+#include <memory>
+#include <string>
+
+using namespace Tangram;
+
+#define TAGS "[TopoJson]"
+
+// Two squares that share the arc 1 between them, and an arc that is not used
+static const std::string topology = R"({
+  "type": "Topology",
+  "objects": {
+    "land": { "type": "GeometryCollection", "geometries": [
+      { "type": "Polygon", "arcs": [[0, -2]], "properties": { "name": "west" } },
+      { "type": "Polygon", "arcs": [[2, 1]], "properties": { "name": "east" } } ] }
+  },
+  "arcs": [
+    [[10, 10], [-10, 0], [0, -10], [10, 0]],
+    [[10, 10], [0, -10]],
+    [[10, 0], [10, 0], [0, 10], [-10, 0]],
+    [[0, 0], [1, 1]]
+  ]
+})";
+
+TEST_CASE("TopoJson features share the arcs of the topology", TAGS) {
+    BinaryTileTask task(TileID(0, 0, 0), nullptr);
+    task.rawTileData = std::make_shared<std::vector<char>>(topology.begin(), topology.end());
+
+    auto data = TopoJson::parseTile(task, 0);
+    REQUIRE(data);
+    REQUIRE(data->layers.size() == 1);
+    CHECK(data->layers[0].name == "land");
+
+    auto& features = data->layers[0].features;
+    REQUIRE(features.size() == 2);
+    CHECK(features[0].props.getString("name") == "west");
+
+    auto west = features[0].polygons()[0][0];
+    auto east = features[1].polygons()[0][0];
+    REQUIRE(west.size() == 5);
+    REQUIRE(east.size() == 5);
+
+    // the shared arc, reversed for the west square
+    CHECK(west[3] == east[0]);
+    CHECK(west[4] == east[3]);
+    CHECK(west[0] == west[4]);
+    CHECK(east[0] == east[4]);
+}
+
+TEST_CASE("TopoJson arcs are decoded when used", TAGS) {
+    JsonDocument document;
+    document.Parse(topology.c_str());
+
+    auto topo = TopoJson::getTopology(document, [](LngLat _lngLat) {
+        return Point(_lngLat.longitude, _lngLat.latitude);
+    });
+    REQUIRE(topo.arcCount() == 4);
+
+    auto& arc = topo.arc(1);
+    REQUIRE(arc.size() == 2);
+    CHECK(arc[0] == Point(10, 10));
+    CHECK(arc[1] == Point(10, 0));
+    CHECK(&topo.arc(1) == &arc);
+}
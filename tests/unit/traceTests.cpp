@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include "debug/trace.h"
+
+#include <string>
+#include <thread>
+
+using namespace Tangram;
+
+static size_t count(const std::string& _json, const std::string& _pattern) {
+    size_t n = 0;
+    for (size_t pos = _json.find(_pattern); pos != std::string::npos; pos = _json.find(_pattern, pos + 1)) {
+        n++;
+    }
+    return n;
+}
+
+TEST_CASE("Trace records nothing unless started", "[Trace]") {
+    REQUIRE(Trace::newFlowId() == 0);
+    { TRACE_SCOPE("ignored"); }
+
+    Trace::start();
+    std::string json = Trace::stop();
+    REQUIRE(json.find("ignored") == std::string::npos);
+}
+
+TEST_CASE("Trace exports scopes and flows of all threads", "[Trace]") {
+    Trace::start();
+    uint64_t id = Trace::newFlowId();
+    REQUIRE(id != 0);
+    {
+        TRACE_SCOPE("request");
+        Trace::flow(id, Trace::Flow::start);
+    }
+    std::thread worker([&] {
+        Trace::setThreadName("TestWorker");
+        TRACE_SCOPE("build");
+        Trace::flow(id, Trace::Flow::step);
+    });
+    worker.join();
+    {
+        TRACE_SCOPE("draw");
+        Trace::flow(id, Trace::Flow::end);
+    }
+    std::string json = Trace::stop();
+
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(count(json, "\"ph\":\"X\"") == 3);
+    REQUIRE(count(json, "\"name\":\"build\"") == 1);
+    REQUIRE(count(json, "\"id\":" + std::to_string(id)) == 3);
+    REQUIRE(json.find("\"ph\":\"s\"") < json.find("\"ph\":\"f\""));
+    REQUIRE(json.find("\"args\":{\"name\":\"TestWorker\"}") != std::string::npos);
+
+    // events are cleared by the export
+    Trace::start();
+    REQUIRE(Trace::stop().find("\"name\":\"draw\"") == std::string::npos);
+}
+
+TEST_CASE("Trace keeps the last events of a thread", "[Trace]") {
+    Trace::start(4);
+    for (int i = 0; i < 10; i++) { TRACE_SCOPE("event"); }
+    std::string json = Trace::stop();
+    REQUIRE(count(json, "\"name\":\"event\"") == 4);
+}
+
+TEST_CASE("Trace exports the args of a scope", "[Trace]") {
+    Trace::start();
+    {
+        Trace::Scope scope("parse");
+        scope.args.names[0] = "allocations";
+        scope.args.values[0] = 12;
+        scope.args.names[1] = "allocBytes";
+        scope.args.values[1] = 3456;
+    }
+    { TRACE_SCOPE("build"); }
+    std::string json = Trace::stop();
+
+    REQUIRE(json.find(R"("name":"parse","ph":"X")") != std::string::npos);
+    REQUIRE(json.find(R"(,"args":{"allocations":12,"allocBytes":3456}})") != std::string::npos);
+    REQUIRE(count(json, "\"args\"") == 1);
+}
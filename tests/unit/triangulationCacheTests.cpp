@@ -0,0 +1,82 @@
+#include "catch.hpp"
+
+#include "data/propertyItem.h"
+#include "util/builders.h"
+#include "util/triangulationCache.h"
+
+#include <cmath>
+
+using namespace Tangram;
+
+// Closed ring of @_points points around (0.5, 0.5)
+static Feature circle(size_t _points, float _radius) {
+    Line ring;
+    for (size_t i = 0; i < _points; i++) {
+        float a = 2.f * 3.14159265f * i / _points;
+        ring.push_back({ 0.5f + _radius * std::cos(a), 0.5f + _radius * std::sin(a) });
+    }
+    ring.push_back(ring.front());
+
+    Feature feature;
+    feature.addPolygon({ ring });
+    return feature;
+}
+
+TEST_CASE("Triangulations are cached by polygon coordinates", "[Core][TriangulationCache]") {
+
+    TriangulationCache cache;
+    mapbox::detail::Earcut<uint16_t> earcut;
+
+    // Too small to be cached
+    auto small = circle(8, 0.25f);
+    REQUIRE(cache.get(small.polygons()[0], earcut) == nullptr);
+
+    auto a = circle(100, 0.25f);
+    auto indices = cache.get(a.polygons()[0], earcut);
+    REQUIRE(indices);
+
+    earcut(a.polygons()[0]);
+    REQUIRE(*indices == earcut.indices);
+
+    // Same coordinates in another feature
+    auto b = circle(100, 0.25f);
+    REQUIRE(cache.get(b.polygons()[0], earcut) == indices);
+
+    auto c = circle(100, 0.3f);
+    REQUIRE(cache.get(c.polygons()[0], earcut) != indices);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.get(a.polygons()[0], earcut) != indices);
+}
+
+TEST_CASE("Prefetched triangulations match those built in place", "[Core][TriangulationCache]") {
+
+    TriangulationCache cache;
+    mapbox::detail::Earcut<uint16_t> earcut;
+
+    auto polygon = circle(TriangulationCache::LARGE_POLYGON_POINTS, 0.4f);
+    cache.prefetch(polygon.polygons()[0]);
+
+    auto indices = cache.get(polygon.polygons()[0], earcut);
+    REQUIRE(indices);
+
+    earcut(polygon.polygons()[0]);
+    REQUIRE(*indices == earcut.indices);
+}
+
+TEST_CASE("Old triangulations are dropped above the size limit", "[Core][TriangulationCache]") {
+
+    // Room for about one polygon of 100 points
+    TriangulationCache cache(1024);
+    mapbox::detail::Earcut<uint16_t> earcut;
+
+    auto a = circle(100, 0.25f);
+    auto b = circle(100, 0.3f);
+
+    auto indices = cache.get(a.polygons()[0], earcut);
+    cache.get(b.polygons()[0], earcut);
+
+    REQUIRE(cache.size() <= 1024);
+    REQUIRE(cache.get(a.polygons()[0], earcut) != indices);
+}
@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include "util/vertexCache.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using namespace Tangram;
+
+// Triangles of a grid of @_size x @_size quads, in column order
+static std::vector<uint16_t> gridIndices(uint16_t _size) {
+    std::vector<uint16_t> indices;
+    uint16_t row = _size + 1;
+    for (uint16_t x = 0; x < _size; x++) {
+        for (uint16_t y = 0; y < _size; y++) {
+            uint16_t v = y * row + x;
+            indices.insert(indices.end(), { v, uint16_t(v + 1), uint16_t(v + row),
+                                            uint16_t(v + 1), uint16_t(v + row + 1), uint16_t(v + row) });
+        }
+    }
+    return indices;
+}
+
+static std::vector<std::array<uint16_t, 3>> sortedTriangles(const std::vector<uint16_t>& _indices,
+                                                            const std::vector<uint16_t>& _vertices) {
+    std::vector<std::array<uint16_t, 3>> triangles;
+    for (size_t i = 0; i < _indices.size(); i += 3) {
+        std::array<uint16_t, 3> t = {{ _vertices[_indices[i]], _vertices[_indices[i+1]], _vertices[_indices[i+2]] }};
+        // Rotate to the smallest vertex first, keeping the winding
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST_CASE("Optimized triangles use the vertex cache better", "[Core][VertexCache]") {
+
+    const uint16_t size = 40;
+    const size_t nVertices = (size + 1) * (size + 1);
+
+    auto indices = gridIndices(size);
+    std::vector<uint16_t> vertices(nVertices);
+    for (size_t i = 0; i < nVertices; i++) { vertices[i] = uint16_t(i); }
+
+    auto original = sortedTriangles(indices, vertices);
+    size_t before = VertexCacheOptimizer::vertexInvocations(indices.data(), indices.size(), nVertices);
+
+    VertexCacheOptimizer optimizer;
+    REQUIRE(optimizer.optimizeTriangles(indices.data(), indices.size(), nVertices));
+    size_t after = VertexCacheOptimizer::vertexInvocations(indices.data(), indices.size(), nVertices);
+
+    REQUIRE(after < before);
+    REQUIRE(sortedTriangles(indices, vertices) == original);
+
+    optimizer.optimizeFetch(indices.data(), indices.size(), vertices.data(), nVertices, sizeof(uint16_t));
+
+    // Vertices are numbered in the order of their first use
+    uint16_t next = 0;
+    bool ordered = true;
+    for (auto i : indices) {
+        ordered &= (i <= next);
+        if (i == next) { next++; }
+    }
+    REQUIRE(ordered);
+    REQUIRE(sortedTriangles(indices, vertices) == original);
+    REQUIRE(VertexCacheOptimizer::vertexInvocations(indices.data(), indices.size(), nVertices) == after);
+}
+
+TEST_CASE("Indices out of range are left unchanged", "[Core][VertexCache]") {
+
+    std::vector<uint16_t> indices = { 0, 1, 2, 2, 1, 3 };
+    auto copy = indices;
+
+    VertexCacheOptimizer optimizer;
+    REQUIRE(!optimizer.optimizeTriangles(indices.data(), indices.size(), 3));
+    REQUIRE(indices == copy);
+}
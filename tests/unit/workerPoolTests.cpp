@@ -0,0 +1,57 @@
+#include "catch.hpp"
+
+#include "util/workerPool.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace Tangram;
+
+TEST_CASE("Each index of a parallel loop runs once", "[Core][WorkerPool]") {
+
+    WorkerPool pool(3);
+    REQUIRE(pool.numThreads() == 3);
+
+    for (size_t count : {0, 1, 2, 100, 1000}) {
+        std::vector<std::atomic<int>> runs(count);
+        for (auto& run : runs) { run = 0; }
+
+        pool.parallelFor(count, [&](size_t i) { runs[i]++; });
+
+        for (auto& run : runs) { REQUIRE(run == 1); }
+    }
+}
+
+TEST_CASE("Parallel loops run on the pool threads", "[Core][WorkerPool]") {
+
+    WorkerPool pool(2);
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> waiting{3};
+
+    // Each iteration waits for the others, so that each thread takes one
+    pool.parallelFor(3, [&](size_t) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+        waiting--;
+        while (waiting > 0) { std::this_thread::yield(); }
+    });
+
+    REQUIRE(threads.size() == 3);
+    REQUIRE(threads.count(std::this_thread::get_id()) == 1);
+}
+
+TEST_CASE("Loops without pool threads run on the calling thread", "[Core][WorkerPool]") {
+
+    WorkerPool pool(0);
+
+    std::vector<size_t> order;
+    pool.parallelFor(4, [&](size_t i) { order.push_back(i); });
+
+    REQUIRE(order == std::vector<size_t>{0, 1, 2, 3});
+}
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include "data/propertyItem.h"
 #include "data/tileData.h"
 #include "mockPlatform.h"
 #include "scene/filters.h"
@@ -238,3 +239,74 @@ TEST_CASE("Sequences in filters implicitly create an 'any' filter", "[filters][c
     REQUIRE(filter.eval(bmw1, ctx));
     REQUIRE(!filter.eval(bike, ctx));
 }
+
+TEST_CASE("Filters compare interned keys and values of a PropertyTable", "[filters][core][yaml]") {
+    init();
+    Filter equality = load("filter: { brand: honda }");
+    Filter set = load("filter: { drive: [fwd, rwd] }");
+    Filter range = load("filter: { wheel: { min: 3 } }");
+    Filter existence = load("filter: { check: true }");
+
+    // as read from a vector tile layer, after the filters are loaded
+    auto table = std::make_shared<PropertyTable>();
+    table->addKey("brand");
+    table->addKey("drive");
+    table->addKey("wheel");
+    table->addKey("check");
+    table->values = { Value(std::string("honda")), Value(std::string("fwd")), Value(4.),
+                     Value(std::string("bmw")), Value(std::string("not interned")) };
+    table->findAtoms();
+
+    REQUIRE(table->keyAtoms[0] == InternTable::find("brand"));
+    REQUIRE(table->valueAtoms[4] == uint32_t(InternTable::NONE));
+
+    Feature car, other;
+    car.props.setTable(table, { { 0, 0 }, { 1, 1 }, { 2, 2 } });
+    other.props.setTable(table, { { 0, 3 }, { 1, 4 }, { 3, 4 } });
+
+    REQUIRE(equality.eval(car, ctx));
+    REQUIRE(!equality.eval(other, ctx));
+    REQUIRE(set.eval(car, ctx));
+    REQUIRE(!set.eval(other, ctx));
+    REQUIRE(range.eval(car, ctx));
+    REQUIRE(!range.eval(other, ctx));
+    REQUIRE(!existence.eval(car, ctx));
+    REQUIRE(existence.eval(other, ctx));
+
+    // copies hold items and compare the strings
+    Feature copy;
+    copy.props = car.props;
+    REQUIRE(equality.eval(copy, ctx));
+    REQUIRE(set.eval(copy, ctx));
+}
+
+TEST_CASE("Compiled filters evaluate like filters", "[filters][core][yaml]") {
+    init();
+    std::vector<std::string> filters = {
+        "filter: { series: '3' }",
+        "filter: { any: [ { brand: bmw }, { wheel: 2 } ] }",
+        "filter: { all: [ { type: car }, { none: [ { drive: fwd } ] } ] }",
+        "filter: { none: [ { any: [ { brand: honda }, { check: true } ] }, { wheel: { max: 3 } } ] }",
+        "filter: { not: { all: [ { type: car }, { $zoom: { min: 5 } } ] } }",
+        "filter: { name: [a, b, c, d, e, f, g, cb1100] }",
+        "filter: { name: [a, b, c, d, e, f, g, 4] }",
+        "filter: { all: [] }",
+        "filter: { any: [] }",
+        "filter: { none: [] }",
+        "filter: 'function() { return feature.brand === \"bmw\"; }'",
+    };
+
+    for (const auto& yaml : filters) {
+        Filter filter = load(yaml);
+        FilterProgram program(filter);
+        for (const auto* feature : { &civic, &bmw1, &bike }) {
+            INFO(yaml << " " << feature->props.getString("name"));
+            REQUIRE(program.eval(*feature, ctx) == filter.eval(*feature, ctx));
+        }
+    }
+
+    Filter set = load("filter: { name: [a, b, c, d, e, f, g, cb1100] }");
+    FilterProgram program(set);
+    REQUIRE(program.eval(bike, ctx));
+    REQUIRE(!program.eval(civic, ctx));
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+
+#include "util/zlibHelper.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace Tangram;
+
+#define TAGS "[ZlibHelper]"
+
+static std::vector<char> inflateChunked(const std::vector<char>& _data, size_t _chunkSize, bool& _ok) {
+    ZlibInflater inflater;
+    std::vector<char> result;
+    _ok = true;
+    for (size_t pos = 0; pos < _data.size() && _ok; pos += _chunkSize) {
+        _ok = inflater.write(_data.data() + pos, std::min(_chunkSize, _data.size() - pos), result);
+    }
+    _ok = _ok && inflater.finished();
+    return result;
+}
+
+TEST_CASE("Gzip data is inflated in chunks of any size", TAGS) {
+    std::string text;
+    for (int i = 0; i < 10000; i++) { text += std::to_string(i * 7919 % 1000) + ","; }
+
+    std::vector<char> compressed;
+    REQUIRE(gzip_deflate(text.data(), text.size(), compressed) == 0);
+    REQUIRE(ZlibInflater::isGzip(compressed.data(), compressed.size()));
+
+    for (size_t chunkSize : { 1, 3, 11, 4096, 1 << 20 }) {
+        bool ok = false;
+        auto result = inflateChunked(compressed, chunkSize, ok);
+        CHECK(ok);
+        CHECK(std::string(result.begin(), result.end()) == text);
+    }
+}
+
+TEST_CASE("Optional gzip header fields are skipped", TAGS) {
+    std::string text = "streamed";
+    std::vector<char> compressed;
+    REQUIRE(gzip_deflate(text.data(), text.size(), compressed) == 0);
+
+    // set FEXTRA and FNAME, insert the fields after the fixed header
+    std::vector<char> withFields(compressed.begin(), compressed.begin() + 10);
+    withFields[3] |= 0x04 | 0x08;
+    withFields.insert(withFields.end(), { 3, 0, 'a', 'b', 'c' });
+    for (char c : std::string("name.json")) { withFields.push_back(c); }
+    withFields.push_back(0);
+    withFields.insert(withFields.end(), compressed.begin() + 10, compressed.end());
+
+    bool ok = false;
+    auto result = inflateChunked(withFields, 2, ok);
+    CHECK(ok);
+    CHECK(std::string(result.begin(), result.end()) == text);
+}
+
+TEST_CASE("Truncated or invalid data is not inflated", TAGS) {
+    std::string text(1000, 'x');
+    std::vector<char> compressed;
+    REQUIRE(gzip_deflate(text.data(), text.size(), compressed) == 0);
+
+    bool ok = true;
+    compressed.resize(compressed.size() / 2);
+    inflateChunked(compressed, 5, ok);
+    CHECK_FALSE(ok);
+
+    std::vector<char> invalid = { 'n', 'o', 't', ' ', 'z', 'l', 'i', 'b' };
+    inflateChunked(invalid, 5, ok);
+    CHECK_FALSE(ok);
+}